@@ -0,0 +1,113 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "polyscope/point_cloud.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/surface_mesh.h"
+#include "polyscope/volume_mesh.h"
+
+// Which polyscope backend to benchmark
+extern std::string benchBackend;
+
+// Initialize polyscope the first time it is needed
+inline void ensurePolyscopeInitialized() {
+  if (polyscope::isInitialized()) return;
+  polyscope::init(benchBackend);
+  polyscope::options::enableRenderErrorChecks = false;
+}
+
+// The element counts most benchmarks are run at
+inline void benchSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMillisecond);
+}
+
+// (volume meshes have about six times as many cells as vertices, so they stop sooner)
+inline void volumeBenchSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(1 << 9, 1 << 18)->Unit(benchmark::kMillisecond);
+}
+
+// == Generated inputs, so sizes can be chosen freely
+
+// n random points in the unit cube
+inline std::vector<glm::vec3> randomPoints(size_t n) {
+  std::mt19937 gen(77);
+  std::uniform_real_distribution<float> dist(0., 1.);
+  std::vector<glm::vec3> points(n);
+  for (glm::vec3& p : points) {
+    p = glm::vec3{dist(gen), dist(gen), dist(gen)};
+  }
+  return points;
+}
+
+// A triangulated square grid with about nVerts vertices, gently curved so the normals vary
+inline std::tuple<std::vector<glm::vec3>, std::vector<std::array<size_t, 3>>> gridTriangleMesh(size_t nVerts) {
+  size_t n = std::max<size_t>(2, static_cast<size_t>(std::sqrt(static_cast<double>(nVerts))));
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  points.reserve(n * n);
+  faces.reserve(2 * (n - 1) * (n - 1));
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      float x = static_cast<float>(i) / (n - 1);
+      float y = static_cast<float>(j) / (n - 1);
+      points.push_back(glm::vec3{x, y, 0.1f * std::sin(6.f * x) * std::cos(6.f * y)});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      size_t v00 = i * n + j;
+      size_t v10 = v00 + n;
+      faces.push_back({v00, v10, v00 + 1});
+      faces.push_back({v00 + 1, v10, v10 + 1});
+    }
+  }
+  return std::make_tuple(points, faces);
+}
+
+// A cube of tetrahedra with about nVerts vertices, six tets per grid cell
+inline std::tuple<std::vector<glm::vec3>, std::vector<std::array<size_t, 4>>> gridTetMesh(size_t nVerts) {
+  size_t n = std::max<size_t>(2, static_cast<size_t>(std::cbrt(static_cast<double>(nVerts))));
+  auto ind = [&](size_t i, size_t j, size_t k) { return (i * n + j) * n + k; };
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> tets;
+  points.reserve(n * n * n);
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      for (size_t k = 0; k < n; k++) {
+        points.push_back(glm::vec3{i, j, k} / static_cast<float>(n - 1));
+      }
+    }
+  }
+
+  // each cell is split along its main diagonal, one tet per ordering of the axes
+  const std::array<std::array<int, 3>, 6> axisOrders{
+      {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}}};
+  tets.reserve(6 * (n - 1) * (n - 1) * (n - 1));
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      for (size_t k = 0; k + 1 < n; k++) {
+        for (const std::array<int, 3>& order : axisOrders) {
+          std::array<size_t, 3> c{i, j, k};
+          std::array<size_t, 4> tet;
+          tet[0] = ind(c[0], c[1], c[2]);
+          for (int s = 0; s < 3; s++) {
+            c[order[s]]++;
+            tet[s + 1] = ind(c[0], c[1], c[2]);
+          }
+          tets.push_back(tet);
+        }
+      }
+    }
+  }
+  return std::make_tuple(points, tets);
+}
@@ -0,0 +1,43 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+// Performance benchmarks for the hot paths of registering, updating, and drawing structures. Run on the mock backend by
+// default, which measures the CPU side of uploads and draws; pass `backend=openGL3_glfw` to time a real GL context.
+//
+// Google benchmark's own flags all work as usual. To track regressions between versions, write machine-readable
+// results and compare them with the tools that come with google benchmark, e.g.
+//   ./bin/polyscope-bench --benchmark_out=results.json --benchmark_out_format=json
+//   ./bin/polyscope-bench --benchmark_filter=SurfaceMesh
+
+#include "polyscope_bench.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// The global polyscope backend setting for benchmarks
+std::string benchBackend = "openGL_mock";
+
+int main(int argc, char** argv) {
+  // (consumes the --benchmark_* arguments)
+  benchmark::Initialize(&argc, argv);
+
+  // Process custom benchmark args
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+
+    { // look for a backend setting
+      std::string prefix = "backend=";
+      auto p = arg.rfind(prefix, 0);
+      if (p == 0) {
+        benchBackend = arg.substr(prefix.size(), std::string::npos);
+        continue;
+      }
+    }
+
+    throw std::runtime_error("unrecognized argument " + arg);
+  }
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
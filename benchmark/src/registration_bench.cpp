@@ -0,0 +1,134 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope_bench.h"
+
+// ============================================================
+// =============== Registration benchmarks
+// ============================================================
+
+namespace {
+
+// (each iteration registers a fresh structure; removing the previous one is not timed)
+void removeUntimed(benchmark::State& state) {
+  state.PauseTiming();
+  polyscope::removeAllStructures();
+  state.ResumeTiming();
+}
+
+// Draw one frame, which is when buffers are first uploaded
+void drawFrame() {
+  polyscope::requestRedraw();
+  polyscope::frameTick();
+}
+
+void BM_RegisterPointCloud(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points = randomPoints(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(polyscope::registerPointCloud("bench", points));
+    removeUntimed(state);
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_RegisterPointCloud)->Apply(benchSizes);
+
+void BM_RegisterSurfaceMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(polyscope::registerSurfaceMesh("bench", points, faces));
+    removeUntimed(state);
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_RegisterSurfaceMesh)->Apply(benchSizes);
+
+void BM_RegisterVolumeMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> tets;
+  std::tie(points, tets) = gridTetMesh(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(polyscope::registerTetMesh("bench", points, tets));
+    removeUntimed(state);
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_RegisterVolumeMesh)->Apply(volumeBenchSizes);
+
+// Registering, and then the first frame which populates and uploads the render buffers
+void BM_RegisterAndDrawSurfaceMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  for (auto _ : state) {
+    polyscope::registerSurfaceMesh("bench", points, faces);
+    drawFrame();
+    removeUntimed(state);
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_RegisterAndDrawSurfaceMesh)->Apply(benchSizes);
+
+void BM_RegisterAndDrawVolumeMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> tets;
+  std::tie(points, tets) = gridTetMesh(state.range(0));
+  for (auto _ : state) {
+    polyscope::registerTetMesh("bench", points, tets);
+    drawFrame();
+    removeUntimed(state);
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_RegisterAndDrawVolumeMesh)->Apply(volumeBenchSizes);
+
+// == Connectivity processing on its own
+
+void BM_SurfaceMeshComputeConnectivityData(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  polyscope::SurfaceMesh* mesh = polyscope::registerSurfaceMesh("bench", points, faces);
+  for (auto _ : state) {
+    mesh->computeConnectivityData();
+  }
+  state.SetItemsProcessed(state.iterations() * faces.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_SurfaceMeshComputeConnectivityData)->Apply(benchSizes);
+
+void BM_VolumeMeshComputeCounts(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> tets;
+  std::tie(points, tets) = gridTetMesh(state.range(0));
+  polyscope::VolumeMesh* mesh = polyscope::registerTetMesh("bench", points, tets);
+  for (auto _ : state) {
+    mesh->computeCounts();
+  }
+  state.SetItemsProcessed(state.iterations() * tets.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_VolumeMeshComputeCounts)->Apply(volumeBenchSizes);
+
+void BM_VolumeMeshComputeConnectivityData(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> tets;
+  std::tie(points, tets) = gridTetMesh(state.range(0));
+  polyscope::VolumeMesh* mesh = polyscope::registerTetMesh("bench", points, tets);
+  for (auto _ : state) {
+    mesh->computeConnectivityData();
+  }
+  state.SetItemsProcessed(state.iterations() * tets.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_VolumeMeshComputeConnectivityData)->Apply(volumeBenchSizes);
+
+} // namespace
@@ -0,0 +1,133 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope_bench.h"
+
+#include "polyscope/pick.h"
+#include "polyscope/view.h"
+
+// ============================================================
+// =============== Draw and pick benchmarks
+// ============================================================
+
+namespace {
+
+// Time whole frames of a static scene, with redraws forced so every frame does the full work
+void drawFrames(benchmark::State& state) {
+  polyscope::view::resetCameraToHomeView();
+  polyscope::frameTick();
+  polyscope::options::alwaysRedraw = true;
+  for (auto _ : state) {
+    polyscope::frameTick();
+  }
+  polyscope::options::alwaysRedraw = false;
+}
+
+void BM_DrawPointCloud(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  polyscope::registerPointCloud("bench", randomPoints(state.range(0)));
+  drawFrames(state);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_DrawPointCloud)->Apply(benchSizes);
+
+void BM_DrawSurfaceMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  polyscope::registerSurfaceMesh("bench", points, faces);
+  drawFrames(state);
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_DrawSurfaceMesh)->Apply(benchSizes);
+
+void BM_DrawSurfaceMeshWithScalar(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  polyscope::SurfaceMesh* mesh = polyscope::registerSurfaceMesh("bench", points, faces);
+  std::vector<double> vals(points.size());
+  for (size_t i = 0; i < vals.size(); i++) vals[i] = points[i].z;
+  mesh->addVertexScalarQuantity("vals", vals)->setEnabled(true);
+  drawFrames(state);
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_DrawSurfaceMeshWithScalar)->Apply(benchSizes);
+
+void BM_DrawVolumeMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> tets;
+  std::tie(points, tets) = gridTetMesh(state.range(0));
+  polyscope::registerTetMesh("bench", points, tets);
+  drawFrames(state);
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_DrawVolumeMesh)->Apply(volumeBenchSizes);
+
+// == Picking
+
+// A click in the middle of the view, with the pick buffer re-rendered every time (as after the camera moves)
+void BM_PickQuerySurfaceMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  polyscope::registerSurfaceMesh("bench", points, faces);
+  polyscope::view::resetCameraToHomeView();
+  polyscope::frameTick();
+  for (auto _ : state) {
+    polyscope::pick::invalidatePickBuffer();
+    benchmark::DoNotOptimize(
+        polyscope::pick::evaluatePickQuery(polyscope::view::bufferWidth / 2, polyscope::view::bufferHeight / 2));
+  }
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_PickQuerySurfaceMesh)->Apply(benchSizes);
+
+// Rays through the view, intersected on the CPU (the first query also builds the acceleration structure)
+void BM_RayPickSurfaceMesh(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  polyscope::registerSurfaceMesh("bench", points, faces);
+  polyscope::view::resetCameraToHomeView();
+  polyscope::frameTick();
+
+  std::mt19937 gen(77);
+  std::uniform_real_distribution<float> dist(0.25, 0.75);
+  glm::vec3 rayStart = polyscope::view::getCameraWorldPosition();
+  for (auto _ : state) {
+    glm::vec2 screenCoords{dist(gen) * polyscope::view::windowWidth, dist(gen) * polyscope::view::windowHeight};
+    glm::vec3 rayDir = polyscope::view::screenCoordsToWorldRay(screenCoords);
+    benchmark::DoNotOptimize(polyscope::pick::evaluateRayPickQuery(rayStart, rayDir));
+  }
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_RayPickSurfaceMesh)->Apply(benchSizes);
+
+void BM_RayPickPointCloud(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  polyscope::registerPointCloud("bench", randomPoints(state.range(0)));
+  polyscope::view::resetCameraToHomeView();
+  polyscope::frameTick();
+
+  std::mt19937 gen(77);
+  std::uniform_real_distribution<float> dist(0.25, 0.75);
+  glm::vec3 rayStart = polyscope::view::getCameraWorldPosition();
+  for (auto _ : state) {
+    glm::vec2 screenCoords{dist(gen) * polyscope::view::windowWidth, dist(gen) * polyscope::view::windowHeight};
+    glm::vec3 rayDir = polyscope::view::screenCoordsToWorldRay(screenCoords);
+    benchmark::DoNotOptimize(polyscope::pick::evaluateRayPickQuery(rayStart, rayDir));
+  }
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_RayPickPointCloud)->Apply(benchSizes);
+
+} // namespace
@@ -0,0 +1,291 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+// Scripted scene replay, for catching frame-time regressions on real datasets, and checking that a performance change
+// leaves the rendered output alone. Loads a scene file (see polyscope::saveScene()), draws a fixed number of frames
+// along a fixed camera path, and writes the per-frame CPU and GPU timings as JSON. Optionally saves reference
+// screenshots along the way, or compares against ones saved by an earlier run.
+//
+// Arguments, all of the form key=value:
+//   scene=FILE          scene file to load (required)
+//   frames=N            number of timed frames (default 240)
+//   warmup=N            frames drawn before timing starts, so first uploads are excluded (default 10)
+//   camera=orbit|FILE   one orbit around the scene from its home view (default), or a JSON array of cameras as written
+//                       by polyscope::view::getCameraJson(), spread evenly over the frames
+//   width=W height=H    window size (default 1280x720)
+//   out=FILE            where to write the timings (default replay.json)
+//   screenshots=DIR     save a reference screenshot to DIR every `screenshotEvery` frames
+//   reference=DIR       instead, compare against the screenshots in DIR; exits with 1 if any differ by more than
+//                       `tolerance` (max per-channel difference, default 2)
+//   screenshotEvery=N   (default 60)
+//   backend=NAME        polyscope backend (default openGL3_glfw)
+//
+// Example:
+//   ./bin/polyscope-replay scene=bunny.psscene screenshots=ref out=before.json
+//   ... make a change, rebuild ...
+//   ./bin/polyscope-replay scene=bunny.psscene reference=ref out=after.json
+
+#include "polyscope/polyscope.h"
+#include "polyscope/profiling.h"
+#include "polyscope/scene_file.h"
+#include "polyscope/screenshot.h"
+#include "polyscope/view.h"
+
+#include "glm/gtc/constants.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "json/json.hpp"
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct ReplayArgs {
+  std::string scene;
+  size_t frames = 240;
+  size_t warmup = 10;
+  std::string camera = "orbit";
+  int width = 1280;
+  int height = 720;
+  std::string out = "replay.json";
+  std::string screenshotDir;
+  std::string referenceDir;
+  size_t screenshotEvery = 60;
+  int tolerance = 2;
+  std::string backend = "openGL3_glfw";
+};
+
+ReplayArgs parseArgs(int argc, char** argv) {
+  std::map<std::string, std::string> vals;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos) throw std::runtime_error("arguments should be key=value, got " + arg);
+    vals[arg.substr(0, eq)] = arg.substr(eq + 1);
+  }
+
+  ReplayArgs args;
+  auto take = [&](const std::string& key, std::string& target) {
+    auto it = vals.find(key);
+    if (it == vals.end()) return false;
+    target = it->second;
+    vals.erase(it);
+    return true;
+  };
+  std::string s;
+  take("scene", args.scene);
+  if (take("frames", s)) args.frames = std::stoul(s);
+  if (take("warmup", s)) args.warmup = std::stoul(s);
+  take("camera", args.camera);
+  if (take("width", s)) args.width = std::stoi(s);
+  if (take("height", s)) args.height = std::stoi(s);
+  take("out", args.out);
+  take("screenshots", args.screenshotDir);
+  take("reference", args.referenceDir);
+  if (take("screenshotEvery", s)) args.screenshotEvery = std::max<size_t>(1, std::stoul(s));
+  if (take("tolerance", s)) args.tolerance = std::stoi(s);
+  take("backend", args.backend);
+
+  if (!vals.empty()) throw std::runtime_error("unrecognized argument " + vals.begin()->first);
+  if (args.scene.empty()) throw std::runtime_error("a scene=FILE argument is required");
+  if (args.frames == 0) throw std::runtime_error("frames must be positive");
+  if (!args.screenshotDir.empty() && !args.referenceDir.empty()) {
+    throw std::runtime_error("give either screenshots= or reference=, not both");
+  }
+  return args;
+}
+
+// One camera per frame, as JSON strings for view::setCameraFromJson()
+std::vector<std::string> buildCameraPath(const ReplayArgs& args) {
+  std::vector<std::string> path;
+
+  if (args.camera == "orbit") {
+    polyscope::view::resetCameraToHomeView();
+    glm::vec3 center = polyscope::state::center();
+    glm::vec3 up = polyscope::view::getUpVec();
+    glm::vec3 offset = polyscope::view::getCameraWorldPosition() - center;
+    for (size_t i = 0; i < args.frames; i++) {
+      float angle = 2.f * glm::pi<float>() * i / args.frames;
+      glm::vec3 eye = center + glm::vec3(glm::rotate(glm::mat4(1.f), angle, up) * glm::vec4(offset, 0.f));
+      polyscope::view::lookAt(eye, center, up, false);
+      path.push_back(polyscope::view::getCameraJson());
+    }
+    return path;
+  }
+
+  std::ifstream inFile(args.camera);
+  if (!inFile) throw std::runtime_error("could not open camera path " + args.camera);
+  json cameras = json::parse(inFile);
+  if (!cameras.is_array() || cameras.empty()) {
+    throw std::runtime_error("camera path " + args.camera + " should be a non-empty JSON array of cameras");
+  }
+  for (size_t i = 0; i < args.frames; i++) {
+    const json& cam = cameras[i * cameras.size() / args.frames];
+    path.push_back(cam.is_string() ? cam.get<std::string>() : cam.dump());
+  }
+  return path;
+}
+
+json summarize(std::vector<double> vals) {
+  json result;
+  if (vals.empty()) return result;
+  std::sort(vals.begin(), vals.end());
+  double sum = 0.;
+  for (double v : vals) sum += v;
+  result["mean"] = sum / vals.size();
+  result["median"] = vals[vals.size() / 2];
+  result["p95"] = vals[std::min(vals.size() - 1, static_cast<size_t>(0.95 * vals.size()))];
+  result["max"] = vals.back();
+  return result;
+}
+
+// Render the current view (without the UI), top row first
+std::vector<unsigned char> renderColor() {
+  std::vector<unsigned char> pixels(4 * polyscope::view::bufferWidth * polyscope::view::bufferHeight);
+  polyscope::RenderBufferTargets targets;
+  targets.color = pixels.data();
+  polyscope::renderToBuffers(targets, false);
+  return pixels;
+}
+
+// Compare with a reference image, returning the max per-channel difference (or -1 if it can't be compared)
+int compareToReference(const std::vector<unsigned char>& pixels, const std::string& filename, double& rmse) {
+  int w, h, comp;
+  unsigned char* ref = stbi_load(filename.c_str(), &w, &h, &comp, 4);
+  rmse = 0.;
+  if (!ref) return -1;
+  if (w != polyscope::view::bufferWidth || h != polyscope::view::bufferHeight) {
+    stbi_image_free(ref);
+    return -1;
+  }
+  int maxDiff = 0;
+  double sumSq = 0.;
+  for (size_t i = 0; i < pixels.size(); i++) {
+    int d = std::abs(static_cast<int>(pixels[i]) - static_cast<int>(ref[i]));
+    maxDiff = std::max(maxDiff, d);
+    sumSq += static_cast<double>(d) * d;
+  }
+  rmse = std::sqrt(sumSq / pixels.size());
+  stbi_image_free(ref);
+  return maxDiff;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  ReplayArgs args = parseArgs(argc, argv);
+
+  polyscope::options::usePrefsFile = false;
+  polyscope::options::enableProfiling = true;
+  polyscope::options::alwaysRedraw = true; // every frame does the full work, as when the camera moves
+  polyscope::init(args.backend);
+  polyscope::view::setWindowSize(args.width, args.height);
+  polyscope::loadScene(args.scene);
+
+  std::vector<std::string> cameraPath = buildCameraPath(args);
+
+  // Warm up on the first camera, so lazily-populated buffers and programs aren't counted
+  polyscope::view::setCameraFromJson(cameraPath.front(), false);
+  for (size_t i = 0; i < args.warmup; i++) {
+    polyscope::frameTick();
+  }
+
+  // Timed frames
+  std::vector<double> wallMs(args.frames);
+  std::vector<size_t> screenshotFrames;
+  polyscope::profiling::beginFrameCapture();
+  for (size_t i = 0; i < args.frames; i++) {
+    polyscope::view::setCameraFromJson(cameraPath[i], false);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    polyscope::frameTick();
+    wallMs[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (i % args.screenshotEvery == 0) screenshotFrames.push_back(i);
+  }
+
+  // A few more frames so the GPU timings of the last timed ones come in
+  for (size_t i = 0; i < 8; i++) {
+    polyscope::frameTick();
+  }
+  std::vector<polyscope::profiling::FrameTimings> timings = polyscope::profiling::endFrameCapture();
+
+  json result;
+  result["scene"] = args.scene;
+  result["backend"] = args.backend;
+  result["width"] = polyscope::view::bufferWidth;
+  result["height"] = polyscope::view::bufferHeight;
+  result["warmup"] = args.warmup;
+
+  std::vector<double> drawCpuMs, drawGpuMs;
+  json frames = json::array();
+  for (size_t i = 0; i < args.frames && i < timings.size(); i++) {
+    const polyscope::profiling::FrameTimings& t = timings[i];
+    json frame;
+    frame["frame"] = i;
+    frame["wallMs"] = wallMs[i];
+    frame["cpuMs"] = t.cpuMs;
+    frame["gpuMs"] = t.gpuMs;
+    if (polyscope::profiling::heapAllocationTrackingEnabled()) frame["heapAllocations"] = t.heapAllocations;
+    frames.push_back(frame);
+    if (t.cpuMs.count("draw")) drawCpuMs.push_back(t.cpuMs.at("draw"));
+    if (t.gpuMs.count("draw")) drawGpuMs.push_back(t.gpuMs.at("draw"));
+  }
+  result["frames"] = frames;
+  result["summary"]["wallMs"] = summarize(wallMs);
+  result["summary"]["drawCpuMs"] = summarize(drawCpuMs);
+  result["summary"]["drawGpuMs"] = summarize(drawGpuMs);
+
+  // Screenshots, re-rendered afterward from the same cameras so capturing them doesn't disturb the timings
+  bool allMatch = true;
+  json screenshots = json::array();
+  if (!args.screenshotDir.empty() || !args.referenceDir.empty()) {
+    for (size_t i : screenshotFrames) {
+      polyscope::view::setCameraFromJson(cameraPath[i], false);
+      std::vector<unsigned char> pixels = renderColor();
+      std::string name = "frame_" + std::to_string(i) + ".png";
+      json shot;
+      shot["frame"] = i;
+      shot["file"] = name;
+      if (!args.screenshotDir.empty()) {
+        std::string filename = args.screenshotDir + "/" + name;
+        int w = polyscope::view::bufferWidth;
+        int h = polyscope::view::bufferHeight;
+        if (!stbi_write_png(filename.c_str(), w, h, 4, pixels.data(), 4 * w)) {
+          throw std::runtime_error("could not write screenshot " + filename);
+        }
+      } else {
+        double rmse;
+        int maxDiff = compareToReference(pixels, args.referenceDir + "/" + name, rmse);
+        bool match = maxDiff >= 0 && maxDiff <= args.tolerance;
+        allMatch = allMatch && match;
+        shot["maxDiff"] = maxDiff;
+        shot["rmse"] = rmse;
+        shot["match"] = match;
+        if (!match) std::cout << "screenshot " << name << " differs from the reference (max diff " << maxDiff << ")\n";
+      }
+      screenshots.push_back(shot);
+    }
+  }
+  result["screenshots"] = screenshots;
+  if (!args.referenceDir.empty()) result["matchesReference"] = allMatch;
+
+  std::ofstream outFile(args.out);
+  if (!outFile) throw std::runtime_error("could not write " + args.out);
+  outFile << result.dump(2) << std::endl;
+
+  std::cout << "wall ms per frame, mean " << result["summary"]["wallMs"]["mean"] << "  p95 "
+            << result["summary"]["wallMs"]["p95"] << "  (" << args.frames << " frames, written to " << args.out
+            << ")" << std::endl;
+
+  return allMatch ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope_bench.h"
+
+// ============================================================
+// =============== Quantity and update benchmarks
+// ============================================================
+
+namespace {
+
+void drawFrame() {
+  polyscope::requestRedraw();
+  polyscope::frameTick();
+}
+
+std::vector<double> rampValues(size_t n) {
+  std::vector<double> vals(n);
+  for (size_t i = 0; i < n; i++) {
+    vals[i] = static_cast<double>(i) / n;
+  }
+  return vals;
+}
+
+// == Adding quantities (re-adding replaces the previous one of the same name)
+
+void BM_PointCloudAddScalarQuantity(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points = randomPoints(state.range(0));
+  std::vector<double> vals = rampValues(points.size());
+  polyscope::PointCloud* cloud = polyscope::registerPointCloud("bench", points);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cloud->addScalarQuantity("vals", vals));
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_PointCloudAddScalarQuantity)->Apply(benchSizes);
+
+void BM_SurfaceMeshAddVertexScalarQuantity(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  std::vector<double> vals = rampValues(points.size());
+  polyscope::SurfaceMesh* mesh = polyscope::registerSurfaceMesh("bench", points, faces);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mesh->addVertexScalarQuantity("vals", vals));
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_SurfaceMeshAddVertexScalarQuantity)->Apply(benchSizes);
+
+void BM_SurfaceMeshAddVertexVectorQuantity(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  polyscope::SurfaceMesh* mesh = polyscope::registerSurfaceMesh("bench", points, faces);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mesh->addVertexVectorQuantity("vecs", points));
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_SurfaceMeshAddVertexVectorQuantity)->Apply(benchSizes);
+
+// An enabled quantity, added and then drawn, so the upload is included
+void BM_SurfaceMeshAddAndDrawVertexScalarQuantity(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  std::vector<double> vals = rampValues(points.size());
+  polyscope::SurfaceMesh* mesh = polyscope::registerSurfaceMesh("bench", points, faces);
+  drawFrame();
+  for (auto _ : state) {
+    mesh->addVertexScalarQuantity("vals", vals)->setEnabled(true);
+    drawFrame();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_SurfaceMeshAddAndDrawVertexScalarQuantity)->Apply(benchSizes);
+
+// == Updating positions, then drawing the frame which uploads them
+
+void BM_PointCloudUpdatePositions(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points = randomPoints(state.range(0));
+  polyscope::PointCloud* cloud = polyscope::registerPointCloud("bench", points);
+  drawFrame();
+  for (auto _ : state) {
+    cloud->updatePointPositions(points);
+    drawFrame();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_PointCloudUpdatePositions)->Apply(benchSizes);
+
+void BM_SurfaceMeshUpdateVertexPositions(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  std::tie(points, faces) = gridTriangleMesh(state.range(0));
+  polyscope::SurfaceMesh* mesh = polyscope::registerSurfaceMesh("bench", points, faces);
+  drawFrame();
+  for (auto _ : state) {
+    mesh->updateVertexPositions(points);
+    drawFrame();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_SurfaceMeshUpdateVertexPositions)->Apply(benchSizes);
+
+void BM_VolumeMeshUpdateVertexPositions(benchmark::State& state) {
+  ensurePolyscopeInitialized();
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> tets;
+  std::tie(points, tets) = gridTetMesh(state.range(0));
+  polyscope::VolumeMesh* mesh = polyscope::registerTetMesh("bench", points, tets);
+  drawFrame();
+  for (auto _ : state) {
+    mesh->updateVertexPositions(points);
+    drawFrame();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  polyscope::removeAllStructures();
+}
+BENCHMARK(BM_VolumeMeshUpdateVertexPositions)->Apply(volumeBenchSizes);
+
+} // namespace
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "polyscope/parallel.h"
 #include "polyscope/render/color_maps.h"
 #include "polyscope/types.h"
 #include "polyscope/utilities.h"
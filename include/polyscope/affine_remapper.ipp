@@ -64,28 +64,48 @@ std::pair<typename FIELD_MAG<T>::type, typename FIELD_MAG<T>::type> robustMinMax
     return std::make_pair(-1.0, 1.0);
   }
 
-  // Compute max and min of data for mapping
-  typename FIELD_MAG<T>::type minVal = std::numeric_limits<typename FIELD_MAG<T>::type>::infinity();
-  typename FIELD_MAG<T>::type maxVal = -std::numeric_limits<typename FIELD_MAG<T>::type>::infinity();
-  bool anyFinite = false;
-  for (const T& x : data) {
-    if (std::isfinite(FIELD_BIGNESS(x))) {
-      minVal = std::min(minVal, FIELD_BIGNESS(x));
-      maxVal = std::max(maxVal, FIELD_BIGNESS(x));
-      anyFinite = true;
-    }
-  }
+  // Compute max and min of data for mapping. The data is scanned in fixed-size chunks in parallel, and the per-chunk
+  // results are combined afterwards.
+  typedef typename FIELD_MAG<T>::type MagT;
+  const MagT inf = std::numeric_limits<MagT>::infinity();
+  const size_t chunkSize = 1 << 16;
+  size_t nChunks = (data.size() + chunkSize - 1) / chunkSize;
+  std::vector<MagT> chunkMin(nChunks, inf);
+  std::vector<MagT> chunkMax(nChunks, -inf);
+  parallelFor(
+      0, nChunks,
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          MagT cMin = inf;
+          MagT cMax = -inf;
+          size_t iEnd = std::min(data.size(), (iC + 1) * chunkSize);
+          for (size_t i = iC * chunkSize; i < iEnd; i++) {
+            MagT x = FIELD_BIGNESS(data[i]);
+            if (std::isfinite(x)) {
+              cMin = std::min(cMin, x);
+              cMax = std::max(cMax, x);
+            }
+          }
+          chunkMin[iC] = cMin;
+          chunkMax[iC] = cMax;
+        }
+      },
+      1);
+
+  MagT minVal = *std::min_element(chunkMin.begin(), chunkMin.end());
+  MagT maxVal = *std::max_element(chunkMax.begin(), chunkMax.end());
+  bool anyFinite = minVal <= maxVal;
   if (!anyFinite) {
     return std::make_pair(-1.0, 1.0);
   }
-  typename FIELD_MAG<T>::type maxMag = std::max(std::abs(minVal), std::abs(maxVal));
+  MagT maxMag = std::max(std::abs(minVal), std::abs(maxVal));
 
   // Hack to do less ugly things when constants (or near-constant) are passed in
   if (maxMag < rangeEPS) {
     maxVal = rangeEPS;
     minVal = -rangeEPS;
   } else if ((maxVal - minVal) / maxMag < rangeEPS) {
-    typename FIELD_MAG<T>::type mid = (minVal + maxVal) / 2.0;
+    MagT mid = (minVal + maxVal) / 2.0;
     maxVal = mid + maxMag * rangeEPS;
     minVal = mid - maxMag * rangeEPS;
   }
@@ -0,0 +1,65 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "polyscope/utilities.h"
+
+namespace polyscope {
+
+// The result of intersecting a ray with a structure on the CPU (see Structure::rayPick())
+struct RayPickResult {
+  bool isHit = false;
+  float depth = std::numeric_limits<float>::infinity(); // distance along the world-space ray
+  glm::vec3 position{0., 0., 0.};                       // world-space hit location
+  size_t elementInd = INVALID_IND; // face (surface mesh), point (point cloud), or edge (curve network) which was hit
+};
+
+// A simple bounding volume hierarchy over axis-aligned boxes, used for CPU-side ray queries such as picking without a
+// GPU pick pass. The tree only stores boxes; the caller supplies the exact primitive test when querying.
+class BVH {
+public:
+  BVH();
+
+  // Build the tree over the given per-primitive bounding boxes, discarding any previous contents
+  void build(const std::vector<glm::vec3>& primMin, const std::vector<glm::vec3>& primMax);
+  void clear();
+  bool isBuilt() const { return built; }
+
+  // Find the closest primitive along the ray rayStart + t * rayDir. intersectPrimitive(i) should return the t value at
+  // which the ray hits primitive i, or infinity if it misses. Returns {primitive index, t}, with INVALID_IND if nothing
+  // was hit. Queries do not modify the tree, so they may be issued concurrently once it is built.
+  std::pair<size_t, float> intersectRay(glm::vec3 rayStart, glm::vec3 rayDir,
+                                        const std::function<float(size_t)>& intersectPrimitive) const;
+
+private:
+  struct Node {
+    glm::vec3 bboxMin;
+    glm::vec3 bboxMax;
+    uint32_t start; // leaves: first entry in primInds; interior: index of the second child (first is always next)
+    uint32_t count; // number of primitives in a leaf, 0 for interior nodes
+  };
+
+  bool built = false;
+  std::vector<Node> nodes;
+  std::vector<uint32_t> primInds;
+
+  uint32_t buildRecursive(const std::vector<glm::vec3>& primMin, const std::vector<glm::vec3>& primMax,
+                          const std::vector<glm::vec3>& centroids, uint32_t start, uint32_t end);
+};
+
+// == Ray-primitive intersection helpers
+// All return the ray parameter t of the first hit with t >= 0, or infinity if there is none.
+float rayTriangleIntersection(glm::vec3 rayStart, glm::vec3 rayDir, glm::vec3 pA, glm::vec3 pB, glm::vec3 pC);
+float raySphereIntersection(glm::vec3 rayStart, glm::vec3 rayDir, glm::vec3 center, float radius);
+float rayCapsuleIntersection(glm::vec3 rayStart, glm::vec3 rayDir, glm::vec3 pA, glm::vec3 pB, float radius);
+float rayBoxIntersection(glm::vec3 rayStart, glm::vec3 rayDirInv, glm::vec3 bboxMin, glm::vec3 bboxMax);
+
+} // namespace polyscope
@@ -0,0 +1,63 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/camera_parameters.h"
+#include "polyscope/depth_render_image_quantity.h"
+#include "polyscope/implicit_helpers.h"
+
+#include <functional>
+#include <vector>
+
+namespace polyscope {
+
+// A render image of an implicit surface (see renderImplicitSurfaceCached()) which keeps itself up to date: whenever it
+// is drawn and the view or resolution have changed, or markParametersChanged() was called, it re-renders. After a view
+// change, rays start just short of the surface seen along them in the previous render, rather than at the camera, so
+// small camera moves take far fewer function evaluations. (Surface newly revealed in front of an earlier one can be
+// missed at a pixel or two along silhouettes; call markParametersChanged() to force a full render.)
+class CachedImplicitSurfaceQuantity : public DepthRenderImageQuantity {
+
+public:
+  typedef std::function<void(const float*, float*, size_t)> BatchFunction;
+
+  CachedImplicitSurfaceQuantity(Structure& parent_, std::string name, BatchFunction func, ImplicitRenderMode mode,
+                                ImplicitRenderOpts opts);
+
+  virtual void drawDelayed() override;
+
+  // Re-render if anything changed as above, returning true if it did. Called automatically when drawn.
+  bool update();
+
+  // Call after changing anything the implicit function depends on, so the next update re-renders from scratch
+  void markParametersChanged();
+
+  // Whether to start rays from the previous render's surface after a view change (default true)
+  CachedImplicitSurfaceQuantity* setReprojection(bool newVal);
+  bool getReprojection();
+
+  // The number of implicit function evaluations in the latest render, and the number of renders so far
+  size_t getLastEvaluationCount();
+  size_t getRenderCount();
+
+  // Rays start this fraction of the way to the reprojected surface, leaving slack for the change of view
+  static constexpr float reprojectionStartFactor = 0.9f;
+
+protected:
+  BatchFunction func;
+  const ImplicitRenderMode mode;
+  const ImplicitRenderOpts opts; // as given, resolved again for each render
+  bool parametersChanged = true;
+  bool reprojection = true;
+  size_t lastEvaluationCount = 0;
+  size_t renderCount = 0;
+
+  // World-space hit points of the previous render
+  std::vector<glm::vec3> lastHitPositions;
+
+  // Starting depth of each ray from the previous hits, or 0 where there is no estimate
+  std::vector<float> reprojectStartDepths(const CameraParameters& params, size_t newDimX, size_t newDimY);
+};
+
+
+} // namespace polyscope
@@ -10,6 +10,8 @@
 #include "polyscope/standardize_data_array.h"
 #include "polyscope/structure.h"
 
+#include <array>
+#include <memory>
 #include <vector>
 
 namespace polyscope {
@@ -31,6 +33,7 @@ public:
 
   // Construct a new point cloud structure
   CameraView(std::string name, const CameraParameters& params);
+  ~CameraView();
 
   // === Overrides
 
@@ -113,10 +116,25 @@ private:
   // Do setup work related to drawing, including allocating openGL data
   void prepare();
   void preparePick();
+  void ensurePickRange();
   void geometryChanged();
   void fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, render::ShaderProgram* edgeProgram,
                                 render::ShaderProgram* pickFrameProgram);
 
+  // The nodes of the widget, in the order of the widgetEdges and widgetPickTriangles indices: the root, the upper left,
+  // upper right, lower left, and lower right frame corners, and the top, left, and right corners of the 'up' triangle
+  std::array<glm::vec3, 8> computeWidgetNodes();
+  static const std::array<std::array<size_t, 2>, 11> widgetEdges;
+  static const std::array<std::array<size_t, 3>, 7> widgetPickTriangles;
+
+  // With options::batchCameraViews, the widgets of the camera views which draw the same way are all drawn by the first
+  // of them to be drawn in each pass (see camera_view.cpp). All camera views share one.
+  struct Batch;
+  static std::weak_ptr<Batch> sharedBatch;
+  std::shared_ptr<Batch> batch;
+  bool batchEligible();
+  bool inBatch = false;
+
   float widgetFocalLengthUpper = -777;
   size_t pickStart = INVALID_IND;
   glm::vec3 pickColor;
@@ -26,6 +26,8 @@ public:
 
   virtual ColorImageQuantity* setEnabled(bool newEnabled) override;
 
+  virtual void releaseTextures() override;
+
 
 protected:
   // rendering internals
@@ -33,7 +35,9 @@ protected:
   std::shared_ptr<render::ShaderProgram> fullscreenProgram, billboardProgram;
   void prepareFullscreen();
   void prepareBillboard();
-  void ensureRawTexturePopulated();
+  bool ensureRawTexturePopulated(); // false if the upload was deferred
+
+  virtual bool textureFormatSupported(TextureFormat format) override;
 
   virtual void showFullscreen() override;
   virtual void showInImGuiWindow() override;
@@ -5,6 +5,7 @@
 #include "polyscope/utilities.h"
 
 #include <array>
+#include <cstdint>
 #include <iomanip>
 #include <map>
 #include <sstream>
@@ -19,7 +20,19 @@ namespace polyscope {
 glm::vec3 RGBtoHSV(glm::vec3 rgb);
 glm::vec3 HSVtoRGB(glm::vec3 hsv);
 
+// Compact 8-bit colors, as used by the packed color quantities: red in the lowest byte, then green, blue, and alpha
+// (so an array of RGBA bytes can be reinterpreted directly on little-endian machines). The alpha byte is ignored.
+inline uint32_t packColorRGBA8(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+  return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) | (static_cast<uint32_t>(b) << 16) |
+         (static_cast<uint32_t>(a) << 24);
+}
+uint32_t packColorRGBA8(glm::vec3 color); // (clamped to [0,1] and rounded)
+glm::vec3 unpackColorRGBA8(uint32_t packed);
+
 // Stateful helper to color things uniquely
 glm::vec3 getNextUniqueColor();
 
+// A distinct color for each category index, the same every time for a given index (unlike getNextUniqueColor())
+glm::vec3 getIndexedDistinctColor(int index);
+
 } // namespace polyscope
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "polyscope/color_management.h"
 #include "polyscope/persistent_value.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
@@ -15,7 +16,11 @@ namespace polyscope {
 template <typename QuantityT>
 class ColorQuantity {
 public:
-  ColorQuantity(QuantityT& parent, const std::vector<glm::vec3>& colors);
+  ColorQuantity(QuantityT& parent, std::vector<glm::vec3> colors);
+
+  // Packed storage: the colors are held as 4 bytes each (see packColorRGBA8()) rather than 3 floats, both on the host
+  // and on the GPU, and decoded in the shader. colors is then empty, and colorsPacked holds the data.
+  ColorQuantity(QuantityT& parent, std::vector<uint32_t> packedColors);
 
   // Build the ImGUI UIs for scalars
   void buildColorUI();
@@ -28,10 +33,23 @@ public:
 
   template <class V>
   void updateData(const V& newColors);
+  template <class V>
+  void updateDataPacked(const V& newPackedColors);
+
+  // Regardless of the storage
+  bool isPacked() const;
+  size_t nColors();
+  glm::vec3 getColor(size_t ind);
+
+  // The name of the shader rule which propagates the colors, picking the packed variant of baseRule if needed, and the
+  // matching attribute
+  std::string colorRule(std::string baseRule) const;
+  std::string colorAttributeName() const;
 
   // === Members
   QuantityT& quantity;
   render::ManagedBuffer<glm::vec3> colors;
+  render::ManagedBuffer<uint32_t> colorsPacked;
 
   // === Get/set visualization parameters
 
@@ -39,6 +57,8 @@ public:
 
 protected:
   std::vector<glm::vec3> colorsData;
+  std::vector<uint32_t> colorsPackedData;
+  const bool packed;
 
   // === Visualization parameters
 
@@ -3,8 +3,16 @@
 namespace polyscope {
 
 template <typename QuantityT>
-ColorQuantity<QuantityT>::ColorQuantity(QuantityT& quantity_, const std::vector<glm::vec3>& colors_)
-    : quantity(quantity_), colors(quantity.uniquePrefix() + "#colors", colorsData), colorsData(colors_) {}
+ColorQuantity<QuantityT>::ColorQuantity(QuantityT& quantity_, std::vector<glm::vec3> colors_)
+    : quantity(quantity_), colors(quantity.uniquePrefix() + "#colors", colorsData),
+      colorsPacked(quantity.uniquePrefix() + "#colorsPacked", colorsPackedData), colorsData(std::move(colors_)),
+      packed(false) {}
+
+template <typename QuantityT>
+ColorQuantity<QuantityT>::ColorQuantity(QuantityT& quantity_, std::vector<uint32_t> packedColors_)
+    : quantity(quantity_), colors(quantity.uniquePrefix() + "#colors", colorsData),
+      colorsPacked(quantity.uniquePrefix() + "#colorsPacked", colorsPackedData),
+      colorsPackedData(std::move(packedColors_)), packed(true) {}
 
 template <typename QuantityT>
 void ColorQuantity<QuantityT>::buildColorUI() {}
@@ -21,10 +29,56 @@ std::vector<std::string> ColorQuantity<QuantityT>::addColorRules(std::vector<std
 template <typename QuantityT>
 template <class V>
 void ColorQuantity<QuantityT>::updateData(const V& newColors) {
-  validateSize(newColors, colors.size(), "color quantity");
+  validateSize(newColors, nColors(), "color quantity");
+  if (packed) {
+    std::vector<glm::vec3> newColorsFloat = standardizeVectorArray<glm::vec3, 3>(newColors);
+    colorsPacked.data.resize(newColorsFloat.size());
+    for (size_t i = 0; i < newColorsFloat.size(); i++) {
+      colorsPacked.data[i] = packColorRGBA8(newColorsFloat[i]);
+    }
+    colorsPacked.markHostBufferUpdated();
+    return;
+  }
   colors.data = standardizeVectorArray<glm::vec3, 3>(newColors);
   colors.markHostBufferUpdated();
 }
 
+template <typename QuantityT>
+template <class V>
+void ColorQuantity<QuantityT>::updateDataPacked(const V& newPackedColors) {
+  if (!packed) {
+    exception("color quantity " + quantity.name + " does not use packed storage, use updateData()");
+    return;
+  }
+  validateSize(newPackedColors, nColors(), "color quantity");
+  colorsPacked.data = standardizeArray<uint32_t>(newPackedColors);
+  colorsPacked.markHostBufferUpdated();
+}
+
+template <typename QuantityT>
+bool ColorQuantity<QuantityT>::isPacked() const {
+  return packed;
+}
+
+template <typename QuantityT>
+size_t ColorQuantity<QuantityT>::nColors() {
+  return packed ? colorsPacked.size() : colors.size();
+}
+
+template <typename QuantityT>
+glm::vec3 ColorQuantity<QuantityT>::getColor(size_t ind) {
+  return packed ? unpackColorRGBA8(colorsPacked.getValue(ind)) : colors.getValue(ind);
+}
+
+template <typename QuantityT>
+std::string ColorQuantity<QuantityT>::colorRule(std::string baseRule) const {
+  return packed ? baseRule + "_PACKED" : baseRule;
+}
+
+template <typename QuantityT>
+std::string ColorQuantity<QuantityT>::colorAttributeName() const {
+  return packed ? "a_colorPacked" : "a_color";
+}
+
 
 } // namespace polyscope
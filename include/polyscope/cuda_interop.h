@@ -0,0 +1,102 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+// Write the values of a structure or quantity directly from CUDA kernels, so data which is computed on the GPU can be
+// shown without a round trip through host memory. This header is not included by polyscope.h, since Polyscope itself
+// does not depend on CUDA: include it in a translation unit which is compiled against the CUDA runtime, and link
+// cudart. Requires the OpenGL backend, with CUDA running on the same device.
+//
+// Example, animating a point cloud from a simulation:
+//
+//   polyscope::CUDAInteropBuffer<glm::vec3> positions(cloud->points); // keep this around, registering is expensive
+//   ...
+//   glm::vec3* ptr = positions.map(nPoints); // a device pointer, valid until unmap()
+//   simulationStep<<<nBlocks, nThreads>>>(ptr, nPoints);
+//   positions.unmap(); // Polyscope takes the new values from here, and updates its indexed views on the device
+//
+// Any ManagedBuffer other than double-valued ones can be mapped, e.g. `cloud->points`, `mesh->vertexPositions`, or the
+// `values` of a scalar quantity. See ManagedBuffer::getRenderAttributeBufferForDeviceWrite() for the caveats.
+
+#include "polyscope/messages.h"
+#include "polyscope/render/managed_buffer.h"
+
+#include <cuda_gl_interop.h>
+#include <cuda_runtime.h>
+
+#include <string>
+#include <type_traits>
+
+namespace polyscope {
+
+template <typename T>
+class CUDAInteropBuffer {
+  static_assert(!std::is_same<T, double>::value, "the render buffers hold double data as floats, it cannot be mapped");
+
+public:
+  // The buffer must outlive this object. Work is ordered on `stream`.
+  CUDAInteropBuffer(render::ManagedBuffer<T>& buffer_, cudaStream_t stream_ = 0) : buffer(buffer_), stream(stream_) {}
+  ~CUDAInteropBuffer() {
+    // (no exceptions from here; the values of a buffer which is still mapped are left as they are)
+    if (mapped) cudaGraphicsUnmapResources(1, &resource, stream);
+    if (resource) cudaGraphicsUnregisterResource(resource);
+  }
+
+  // No copy constructor/assignment
+  CUDAInteropBuffer(const CUDAInteropBuffer&) = delete;
+  CUDAInteropBuffer& operator=(const CUDAInteropBuffer&) = delete;
+
+  // Resize the buffer to `n` entries, and get a device pointer to write them through. Entries which are not written
+  // keep their old values. Polyscope must not touch the buffer until unmap(), so do not draw frames in between.
+  T* map(size_t n) {
+    if (mapped) exception("CUDAInteropBuffer for " + buffer.name + " is already mapped");
+
+    // Re-register when the GL storage may have been re-allocated since: a resize, or an update from the host (which
+    // orphans the storage of streaming buffers).
+    bool reRegister = !resource || !buffer.dataIsDeviceOnly() || buffer.size() != n;
+    std::shared_ptr<render::AttributeBuffer> renderBuffer = buffer.getRenderAttributeBufferForDeviceWrite(n);
+    if (reRegister || renderBuffer->getNativeBufferID() != registeredBufferID) {
+      if (resource) check(cudaGraphicsUnregisterResource(resource), "unregister");
+      resource = nullptr;
+      registeredBufferID = renderBuffer->getNativeBufferID();
+      check(cudaGraphicsGLRegisterBuffer(&resource, registeredBufferID, cudaGraphicsRegisterFlagsNone), "register");
+    }
+
+    check(cudaGraphicsMapResources(1, &resource, stream), "map");
+    mapped = true;
+    void* ptr = nullptr;
+    size_t nBytes = 0;
+    check(cudaGraphicsResourceGetMappedPointer(&ptr, &nBytes, resource), "get the pointer of");
+    if (nBytes < n * sizeof(T)) {
+      unmap();
+      exception("CUDAInteropBuffer for " + buffer.name + " mapped " + std::to_string(nBytes) + " bytes, but " +
+                std::to_string(n) + " entries need " + std::to_string(n * sizeof(T)));
+    }
+    return static_cast<T*>(ptr);
+  }
+
+  // Finish writing, after the kernels which write the buffer have been issued on the stream
+  void unmap() {
+    if (!mapped) exception("CUDAInteropBuffer for " + buffer.name + " is not mapped");
+    mapped = false;
+    check(cudaGraphicsUnmapResources(1, &resource, stream), "unmap");
+    buffer.markRenderAttributeBufferUpdated();
+  }
+
+  bool isMapped() const { return mapped; }
+
+private:
+  render::ManagedBuffer<T>& buffer;
+  cudaStream_t stream;
+  cudaGraphicsResource_t resource = nullptr;
+  uint32_t registeredBufferID = 0;
+  bool mapped = false;
+
+  void check(cudaError_t err, const std::string& what) {
+    if (err != cudaSuccess) {
+      exception("CUDA failed to " + what + " the render buffer of " + buffer.name + ": " + cudaGetErrorString(err));
+    }
+  }
+};
+
+} // namespace polyscope
@@ -42,6 +42,11 @@ public:
   // Construct a new curve network structure
   CurveNetwork(std::string name, std::vector<glm::vec3> nodes, std::vector<std::array<size_t, 2>> edges);
 
+  // Construct a curve network made of polyline strips: strip i is the run of nodes [stripOffsets[i],
+  // stripOffsets[i+1]), and its edges connect consecutive nodes. Edges are numbered strip by strip. Strips are drawn
+  // as continuous tubes rather than as a cylinder per edge and a sphere per node.
+  CurveNetwork(std::string name, std::vector<glm::vec3> nodes, std::vector<size_t> stripOffsets);
+
   // === Overloads
 
   // Build the imgui display
@@ -55,9 +60,13 @@ public:
 
   virtual void updateObjectSpaceBounds() override;
   virtual std::string typeName() override;
+  virtual std::string drawSortKey() override; // the material
 
   virtual void refresh() override;
 
+  virtual RayPickResult rayPick(glm::vec3 rayStart, glm::vec3 rayDir) override; // elementInd is the edge index
+  virtual size_t nSubsetElements() override; // the edges
+
   // === Geometry members
 
   // node positions
@@ -69,8 +78,14 @@ public:
 
   // internally-computed geometry
   render::ManagedBuffer<glm::vec3> edgeCenters;
+  render::ManagedBuffer<uint32_t> stripNodeEdgeInds; // (strips only) N, the edge leaving each node along its strip
+  render::ManagedBuffer<uint32_t> edgeNodeInds;      // (non-strips only) 2E, interleaved tail/tip, the line index
+  render::ManagedBuffer<uint32_t> stripDrawInds;     // (strips only) the line strip index, see setLODEnabled()
 
   // === Quantities
+  //
+  // As for point clouds, an rvalue of the exact type stored (std::vector<float> or std::vector<glm::vec3>) is moved in
+  // rather than copied.
 
   // Scalars
   template <class T>
@@ -79,12 +94,18 @@ public:
   template <class T>
   CurveNetworkEdgeScalarQuantity* addEdgeScalarQuantity(std::string name, const T& values,
                                                         DataType type = DataType::STANDARD);
+  CurveNetworkNodeScalarQuantity* addNodeScalarQuantity(std::string name, std::vector<float>&& values,
+                                                        DataType type = DataType::STANDARD);
+  CurveNetworkEdgeScalarQuantity* addEdgeScalarQuantity(std::string name, std::vector<float>&& values,
+                                                        DataType type = DataType::STANDARD);
 
   // Colors
   template <class T>
   CurveNetworkNodeColorQuantity* addNodeColorQuantity(std::string name, const T& values);
   template <class T>
   CurveNetworkEdgeColorQuantity* addEdgeColorQuantity(std::string name, const T& values);
+  CurveNetworkNodeColorQuantity* addNodeColorQuantity(std::string name, std::vector<glm::vec3>&& values);
+  CurveNetworkEdgeColorQuantity* addEdgeColorQuantity(std::string name, std::vector<glm::vec3>&& values);
 
   // Vectors
   template <class T>
@@ -93,6 +114,10 @@ public:
   template <class T>
   CurveNetworkEdgeVectorQuantity* addEdgeVectorQuantity(std::string name, const T& vectors,
                                                         VectorType vectorType = VectorType::STANDARD);
+  CurveNetworkNodeVectorQuantity* addNodeVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                        VectorType vectorType = VectorType::STANDARD);
+  CurveNetworkEdgeVectorQuantity* addEdgeVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                        VectorType vectorType = VectorType::STANDARD);
   template <class T>
   CurveNetworkNodeVectorQuantity* addNodeVectorQuantity2D(std::string name, const T& vectors,
                                                           VectorType vectorType = VectorType::STANDARD);
@@ -108,6 +133,10 @@ public:
   size_t nNodes() { return nodePositions.size(); }
   size_t nEdges() { return edgeTailInds.size(); }
 
+  // Strips, if this network was constructed from polyline strips (see constructor)
+  bool isPolylineStrips() { return !stripOffsets.empty(); }
+  size_t nStrips() { return isPolylineStrips() ? stripOffsets.size() - 1 : 0; }
+
 
   // Misc data
   static const std::string structureTypeName;
@@ -115,17 +144,41 @@ public:
   // Small utilities
   void setCurveNetworkNodeUniforms(render::ShaderProgram& p);
   void setCurveNetworkEdgeUniforms(render::ShaderProgram& p);
-  void fillEdgeGeometryBuffers(render::ShaderProgram& program);
+  std::string nodeProgramName();
   void fillNodeGeometryBuffers(render::ShaderProgram& program);
   std::vector<std::string> addCurveNetworkNodeRules(std::vector<std::string> initRules);
+
+  // Edge programs come in two flavors. The default (RAYCAST_CYLINDER_INDEXED) draws indexed lines which read the node
+  // buffers directly. Programs with per-edge data (RAYCAST_CYLINDER) instead use one point per edge, with node data
+  // expanded out to each edge's tail and tip. For polyline strips, the default is instead RIBBON_TUBE, which draws
+  // each strip as an indexed line strip over the node buffers; per-edge data is gathered to the edges' tail nodes via
+  // stripNodeEdgeInds, and the expanded flavor is not used.
+  // With instanced drawing (see setInstancedDrawing()), both flavors are RAYCAST_CYLINDER_INSTANCED, one instance per
+  // edge, and node data is always expanded out to the tail and tip; setEdgeNodeAttribute() sets node data for either.
+  std::string edgeProgramName();
+  void fillEdgeGeometryBuffers(render::ShaderProgram& program);
   std::vector<std::string> addCurveNetworkEdgeRules(std::vector<std::string> initRules);
+  std::string expandedEdgeProgramName();
+  void fillExpandedEdgeGeometryBuffers(render::ShaderProgram& program);
+  std::vector<std::string> addCurveNetworkExpandedEdgeRules(std::vector<std::string> initRules);
+  template <typename T>
+  void setEdgeNodeAttribute(render::ShaderProgram& program, std::string name, render::ManagedBuffer<T>& nodeValues);
 
   // === Mutate
   template <class V>
   void updateNodePositions(const V& newPositions);
+  void updateNodePositions(std::vector<glm::vec3>&& newPositions); // moves the positions in, without copying
   template <class V>
   void updateNodePositions2D(const V& newPositions);
 
+  // Add nodes, and edges between any of the old or new nodes, to the end of the network. Only the new elements are
+  // uploaded, and render buffers grow geometrically, so appending repeatedly (e.g. to a growing trajectory) is
+  // amortized O(new elements). The bounds grow to fit the new nodes, with the length scale approximated by the diagonal
+  // of the bounding box. Node and edge quantities must be extended to match before the next draw, with appendData() on
+  // their buffers, or removed. Not supported for networks made of polyline strips.
+  template <class P, class E>
+  void appendNodesAndEdges(const P& newNodes, const E& newEdges);
+
   // === Get/set visualization parameters
 
   // set the base color of the points
@@ -149,6 +202,31 @@ public:
   CurveNetwork* setMaterial(std::string name);
   std::string getMaterial();
 
+  // Draw nodes and edges as instanced quads and boxes, rather than expanding points and lines in a geometry shader,
+  // which is slow on some hardware for large networks. The picture is the same either way. Networks made of polyline
+  // strips are always drawn as tubes. (default: false)
+  CurveNetwork* setInstancedDrawing(bool newVal);
+  bool getInstancedDrawing();
+
+  // Draw the depth of the nodes and edges in a pass of their own before shading them, so that the (costly) ray
+  // intersection and lighting only run once per pixel rather than for every overlapping tube. Helps dense networks
+  // with much overdraw; has no effect with transparency. (default: false)
+  CurveNetwork* setDepthPrepass(bool newVal);
+  bool getDepthPrepass();
+
+  // Level of detail, for networks made of polyline strips. If enabled, the strips are split in to chunks of up to
+  // lodChunkEdges edges, and each chunk is drawn simplified (Douglas-Peucker) to the coarsest of a few precomputed
+  // levels which stays within `pixelTolerance` pixels of the full curve on the screen, so distant strips draw far fewer
+  // segments. Simplified segments pick (and take edge quantity values from) the first original edge they cover. The
+  // levels are built when first drawn, and again after the positions are updated. Has no effect on other networks.
+  // (default: disabled)
+  CurveNetwork* setLODEnabled(bool newVal);
+  bool getLODEnabled();
+  CurveNetwork* setLODPixelTolerance(float newVal);
+  float getLODPixelTolerance();
+  size_t getLODDrawSegmentCount(); // number of segments drawn in the most recent frame (all edges if LOD is disabled)
+  static const size_t lodChunkEdges = 1024;
+
 
 private:
   // Storage for the managed buffers above. You should generally interact with these through the managed buffers, not
@@ -157,13 +235,55 @@ private:
   std::vector<uint32_t> edgeTailIndsData;
   std::vector<uint32_t> edgeTipIndsData;
   std::vector<glm::vec3> edgeCentersData;
+  std::vector<uint32_t> stripNodeEdgeIndsData;
+  std::vector<uint32_t> edgeNodeIndsData;
+  std::vector<uint32_t> stripDrawIndsData;
+
+  // (strips only) nStrips+1 offsets in to the nodes, empty otherwise
+  std::vector<size_t> stripOffsets;
+
+  // (strips only) Level of detail, see setLODEnabled(). A chunk's nodes at each level exclude its last node, which is
+  // the first of the next chunk (or the end of the strip).
+  bool lodBuilt = false;
+  std::vector<size_t> lodStripChunks;                 // nStrips+1 offsets in to the chunks
+  std::vector<std::array<uint32_t, 2>> lodChunkNodes; // first and last node of each chunk
+  std::vector<glm::vec4> lodChunkBounds;              // bounding sphere of each chunk, as center and radius
+  std::vector<float> lodLevelTolerances;              // object-space, coarse to fine
+  std::vector<size_t> lodLevelOffsets;                // nLevels * (nChunks+1) offsets in to lodLevelNodes
+  std::vector<uint32_t> lodLevelNodes;                // the nodes each chunk keeps at each level
+  std::vector<uint8_t> lodChunkLevels;                // level drawn by each chunk (nLevels for all nodes), or empty
+  size_t lodDrawSegmentCount = 0;
+  uint64_t lodLastUpdate = INVALID_IND_64; // value of internal::renderSceneCount when the levels were last chosen
+  void ensureHaveLOD();
+  void updateLOD();
+  void clearLOD();
+
+  // CPU ray picking acceleration, built lazily and cleared when the geometry changes
+  BVH rayPickBVH;
+  float rayPickBVHRadius = -1.; // object-space edge radius which the BVH bounds were built with
+
+  // The subset masks of the nodes, derived from those of the edges (see setVisibleSubset())
+  std::vector<uint32_t> nodeVisibleSubsetMaskData;
+  std::vector<uint32_t> nodeHighlightedSubsetMaskData;
+  render::ManagedBuffer<uint32_t> nodeVisibleSubsetMask;
+  render::ManagedBuffer<uint32_t> nodeHighlightedSubsetMask;
+  virtual void subsetMasksChanged() override;
 
   void computeEdgeCenters();
+  void computeStripNodeEdgeInds();
+  void computeEdgeNodeInds();
+  void computeStripDrawInds();
+  void appendNodesAndEdgesImpl(const std::vector<glm::vec3>& newNodes,
+                               const std::vector<std::array<size_t, 2>>& newEdges);
 
   // === Visualization parameters
   PersistentValue<glm::vec3> color;
   PersistentValue<ScaledValue<float>> radius;
   PersistentValue<std::string> material;
+  PersistentValue<bool> instancedDrawing;
+  PersistentValue<bool> depthPrepass;
+  PersistentValue<bool> lodEnabled;
+  PersistentValue<float> lodPixelTolerance;
 
   // Drawing related things
   // if nullptr, prepare() (resp. preparePick()) needs to be called
@@ -177,9 +297,12 @@ private:
   // Do setup work related to drawing, including allocating openGL data
   void prepare();
   void preparePick();
+  void drawPickPrograms(); // (also the depth pre-pass, see setDepthPrepass())
 
   void recomputeGeometryIfPopulated();
   float computeRadiusMultiplierUniform();
+  bool drawsInstanced() { return getInstancedDrawing() && !isPolylineStrips(); }
+  std::vector<std::string> toInstancedRules(std::vector<std::string> rules);
 
   // Pick helpers
   void buildNodePickUI(size_t nodeInd);
@@ -187,12 +310,12 @@ private:
 
   // === Quantity adder implementations
   // clang-format off
-  CurveNetworkNodeScalarQuantity* addNodeScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  CurveNetworkEdgeScalarQuantity* addEdgeScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  CurveNetworkNodeColorQuantity* addNodeColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
-  CurveNetworkEdgeColorQuantity* addEdgeColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
-  CurveNetworkNodeVectorQuantity* addNodeVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
-  CurveNetworkEdgeVectorQuantity* addEdgeVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
+  CurveNetworkNodeScalarQuantity* addNodeScalarQuantityImpl(std::string name, std::vector<float> data, DataType type);
+  CurveNetworkEdgeScalarQuantity* addEdgeScalarQuantityImpl(std::string name, std::vector<float> data, DataType type);
+  CurveNetworkNodeColorQuantity* addNodeColorQuantityImpl(std::string name, std::vector<glm::vec3> colors);
+  CurveNetworkEdgeColorQuantity* addEdgeColorQuantityImpl(std::string name, std::vector<glm::vec3> colors);
+  CurveNetworkNodeVectorQuantity* addNodeVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors, VectorType vectorType);
+  CurveNetworkEdgeVectorQuantity* addEdgeVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors, VectorType vectorType);
   // clang-format on
 
   // Manage varying node, edge size
@@ -205,6 +328,8 @@ private:
 // Shorthand to add a curve network to polyscope
 template <class P, class E>
 CurveNetwork* registerCurveNetwork(std::string name, const P& points, const E& edges);
+template <class E>
+CurveNetwork* registerCurveNetwork(std::string name, std::vector<glm::vec3>&& points, const E& edges); // moves points
 template <class P, class E>
 CurveNetwork* registerCurveNetwork2D(std::string name, const P& points, const E& edges);
 
@@ -212,6 +337,7 @@ CurveNetwork* registerCurveNetwork2D(std::string name, const P& points, const E&
 // Shorthand to add a curve network, automatically constructing the connectivity of a line
 template <class P>
 CurveNetwork* registerCurveNetworkLine(std::string name, const P& points);
+CurveNetwork* registerCurveNetworkLine(std::string name, std::vector<glm::vec3>&& points); // moves points
 template <class P>
 CurveNetwork* registerCurveNetworkLine2D(std::string name, const P& points);
 
@@ -228,6 +354,13 @@ CurveNetwork* registerCurveNetworkLoop(std::string name, const P& points);
 template <class P>
 CurveNetwork* registerCurveNetworkLoop2D(std::string name, const P& points);
 
+// Shorthand to add a curve network made of polyline strips: strip i is the nodes [stripOffsets[i], stripOffsets[i+1]).
+// Suited to many long curves such as streamlines, which are drawn as continuous tubes.
+template <class P, class O>
+CurveNetwork* registerCurveNetworkStrips(std::string name, const P& nodes, const O& stripOffsets);
+template <class P, class O>
+CurveNetwork* registerCurveNetworkStrips2D(std::string name, const P& nodes, const O& stripOffsets);
+
 // Shorthand to get a curve network from polyscope
 inline CurveNetwork* getCurveNetwork(std::string name = "");
 inline bool hasCurveNetwork(std::string name = "");
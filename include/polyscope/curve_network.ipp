@@ -18,6 +18,17 @@ CurveNetwork* registerCurveNetwork(std::string name, const P& nodes, const E& ed
   }
   return s;
 }
+template <class E>
+CurveNetwork* registerCurveNetwork(std::string name, std::vector<glm::vec3>&& nodes, const E& edges) {
+  checkInitialized();
+
+  CurveNetwork* s = new CurveNetwork(name, std::move(nodes), standardizeVectorArray<std::array<size_t, 2>, 2>(edges));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
 template <class P, class E>
 CurveNetwork* registerCurveNetwork2D(std::string name, const P& nodes, const E& edges) {
   checkInitialized();
@@ -26,7 +37,8 @@ CurveNetwork* registerCurveNetwork2D(std::string name, const P& nodes, const E&
   for (auto& v : points3D) {
     v.z = 0.;
   }
-  CurveNetwork* s = new CurveNetwork(name, points3D, standardizeVectorArray<std::array<size_t, 2>, 2>(edges));
+  CurveNetwork* s =
+      new CurveNetwork(name, std::move(points3D), standardizeVectorArray<std::array<size_t, 2>, 2>(edges));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -46,7 +58,7 @@ CurveNetwork* registerCurveNetworkLine(std::string name, const P& nodes) {
     edges.push_back({iE - 1, iE});
   }
 
-  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes), edges);
+  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes), std::move(edges));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -67,7 +79,7 @@ CurveNetwork* registerCurveNetworkLine2D(std::string name, const P& nodes) {
     v.z = 0.;
   }
 
-  CurveNetwork* s = new CurveNetwork(name, points3D, edges);
+  CurveNetwork* s = new CurveNetwork(name, std::move(points3D), std::move(edges));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -91,7 +103,7 @@ CurveNetwork* registerCurveNetworkSegments(std::string name, const P& nodes) {
     edges.push_back({iE, iE + 1});
   }
 
-  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes), edges);
+  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes), std::move(edges));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -118,7 +130,7 @@ CurveNetwork* registerCurveNetworkSegments2D(std::string name, const P& nodes) {
     v.z = 0.;
   }
 
-  CurveNetwork* s = new CurveNetwork(name, points3D, edges);
+  CurveNetwork* s = new CurveNetwork(name, std::move(points3D), std::move(edges));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -137,7 +149,7 @@ CurveNetwork* registerCurveNetworkLoop(std::string name, const P& nodes) {
     edges.push_back({iE, (iE + 1) % N});
   }
 
-  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes), edges);
+  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes), std::move(edges));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -158,24 +170,57 @@ CurveNetwork* registerCurveNetworkLoop2D(std::string name, const P& nodes) {
     v.z = 0.;
   }
 
-  CurveNetwork* s = new CurveNetwork(name, points3D, edges);
+  CurveNetwork* s = new CurveNetwork(name, std::move(points3D), std::move(edges));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+
+// Shorthand to add a curve network from polyline strips
+template <class P, class O>
+CurveNetwork* registerCurveNetworkStrips(std::string name, const P& nodes, const O& stripOffsets) {
+  checkInitialized();
+
+  CurveNetwork* s = new CurveNetwork(name, standardizeVectorArray<glm::vec3, 3>(nodes),
+                                     standardizeArray<size_t, O>(stripOffsets));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
   }
   return s;
 }
+template <class P, class O>
+CurveNetwork* registerCurveNetworkStrips2D(std::string name, const P& nodes, const O& stripOffsets) {
+  checkInitialized();
 
+  std::vector<glm::vec3> points3D(standardizeVectorArray<glm::vec3, 2>(nodes));
+  for (auto& v : points3D) {
+    v.z = 0.;
+  }
+
+  CurveNetwork* s = new CurveNetwork(name, std::move(points3D), standardizeArray<size_t, O>(stripOffsets));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
 
 template <class V>
 void CurveNetwork::updateNodePositions(const V& newPositions) {
-  validateSize(newPositions, nNodes(), "newPositions");
-  nodePositions.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
-  nodePositions.markHostBufferUpdated();
-  recomputeGeometryIfPopulated();
+  updateNodePositions(standardizeVectorArray<glm::vec3, 3>(newPositions));
 }
 
 
+template <class P, class E>
+void CurveNetwork::appendNodesAndEdges(const P& newNodes, const E& newEdges) {
+  appendNodesAndEdgesImpl(standardizeVectorArray<glm::vec3, 3>(newNodes),
+                          standardizeVectorArray<std::array<size_t, 2>, 2>(newEdges));
+}
+
 template <class V>
 void CurveNetwork::updateNodePositions2D(const V& newPositions2D) {
   validateSize(newPositions2D, nNodes(), "newPositions2D");
@@ -185,7 +230,7 @@ void CurveNetwork::updateNodePositions2D(const V& newPositions2D) {
   }
 
   // Call the main version
-  updateNodePositions(positions3D);
+  updateNodePositions(std::move(positions3D));
 }
 
 // Shorthand to get a curve network from polyscope
@@ -218,13 +263,13 @@ CurveNetworkEdgeColorQuantity* CurveNetwork::addEdgeColorQuantity(std::string na
 template <class T>
 CurveNetworkNodeScalarQuantity* CurveNetwork::addNodeScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, nNodes(), "curve network node scalar quantity " + name);
-  return addNodeScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addNodeScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 template <class T>
 CurveNetworkEdgeScalarQuantity* CurveNetwork::addEdgeScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, nEdges(), "curve network edge scalar quantity " + name);
-  return addEdgeScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addEdgeScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 
@@ -244,7 +289,7 @@ CurveNetworkNodeVectorQuantity* CurveNetwork::addNodeVectorQuantity2D(std::strin
   for (auto& v : vectors3D) {
     v.z = 0.;
   }
-  return addNodeVectorQuantityImpl(name, vectors3D, vectorType);
+  return addNodeVectorQuantityImpl(name, std::move(vectors3D), vectorType);
 }
 
 
@@ -264,7 +309,19 @@ CurveNetworkEdgeVectorQuantity* CurveNetwork::addEdgeVectorQuantity2D(std::strin
   for (auto& v : vectors3D) {
     v.z = 0.;
   }
-  return addEdgeVectorQuantityImpl(name, vectors3D, vectorType);
+  return addEdgeVectorQuantityImpl(name, std::move(vectors3D), vectorType);
+}
+
+
+template <typename T>
+void CurveNetwork::setEdgeNodeAttribute(render::ShaderProgram& program, std::string name,
+                                        render::ManagedBuffer<T>& nodeValues) {
+  if (drawsInstanced()) {
+    program.setAttribute(name + "_tail", nodeValues.getIndexedRenderAttributeBuffer(edgeTailInds));
+    program.setAttribute(name + "_tip", nodeValues.getIndexedRenderAttributeBuffer(edgeTipInds));
+  } else {
+    program.setAttribute(name, nodeValues.getRenderAttributeBuffer());
+  }
 }
 
 
@@ -14,12 +14,13 @@ class CurveNetwork;
 class CurveNetworkColorQuantity : public CurveNetworkQuantity, public ColorQuantity<CurveNetworkColorQuantity> {
 public:
   CurveNetworkColorQuantity(std::string name, CurveNetwork& network_, std::string definedOn,
-                            const std::vector<glm::vec3>& colorValues);
+                            std::vector<glm::vec3> colorValues);
 
   virtual void draw() override;
   virtual std::string niceName() override;
 
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
 protected:
   // UI internals
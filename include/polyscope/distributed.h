@@ -0,0 +1,67 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// Sort-last rendering of a scene which is partitioned across processes (e.g. MPI ranks), each running its own
+// (typically headless) Polyscope with the structures of one partition. Every rank renders color and depth with the same
+// camera, and the images are composited by depth with binary swap, ending up on rank 0.
+//
+// Polyscope does not depend on MPI; the communication goes through the Communicator callbacks. With MPI, for instance:
+//
+//   distributed::Communicator comm;
+//   MPI_Comm_rank(MPI_COMM_WORLD, &comm.rank);
+//   MPI_Comm_size(MPI_COMM_WORLD, &comm.size);
+//   comm.send = [](int peer, const void* data, size_t bytes) {
+//     MPI_Send(data, bytes, MPI_BYTE, peer, 0, MPI_COMM_WORLD);
+//   };
+//   comm.recv = [](int peer, void* data, size_t bytes) {
+//     MPI_Recv(data, bytes, MPI_BYTE, peer, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+//   };
+//   comm.exchange = [](int peer, const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes) {
+//     MPI_Sendrecv(sendData, sendBytes, MPI_BYTE, peer, 0, recvData, recvBytes, MPI_BYTE, peer, 0, MPI_COMM_WORLD,
+//                  MPI_STATUS_IGNORE);
+//   };
+//
+// All of the functions below are collective: every rank must call them, in the same order. Compositing takes the
+// nearest surface at each pixel, so transparency is not composited correctly across ranks.
+namespace distributed {
+
+struct Communicator {
+  int rank = 0;
+  int size = 1;
+
+  // Blocking point-to-point messages of a known size
+  std::function<void(int peer, const void* data, size_t bytes)> send;
+  std::function<void(int peer, void* data, size_t bytes)> recv;
+
+  // Send to and receive from the same peer, which must not deadlock when the peer does the same (like MPI_Sendrecv)
+  std::function<void(int peer, const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes)> exchange;
+};
+
+// Send a string from rank 0 to all other ranks
+void broadcast(const Communicator& comm, std::string& data);
+
+// Make every rank draw the same picture as rank 0: the view and window size (see view::getViewAsJson()) and the enabled
+// state of structures are copied from rank 0, and the scene extents (state::boundingBox and state::lengthScale, which
+// set the ground plane and relative sizes) become those of the whole distributed scene.
+void synchronizeState(const Communicator& comm);
+
+// Composite the RGBA color (4 bytes per pixel) and depth (1 float per pixel, smaller is nearer) images of all ranks,
+// which must all be w x h. On return, rank 0 holds the composited image in color and depth; the contents on the other
+// ranks are unspecified.
+void compositeImages(const Communicator& comm, std::vector<unsigned char>& color, std::vector<float>& depth, int w,
+                     int h);
+
+// Synchronize the state, render this rank's structures with renderToBuffers() and composite the results. Returns the
+// RGBA image of the whole scene, top row first, on rank 0 (view::bufferWidth x view::bufferHeight), empty elsewhere.
+std::vector<unsigned char> renderComposited(const Communicator& comm, bool transparentBG = true);
+
+} // namespace distributed
+} // namespace polyscope
@@ -6,6 +6,8 @@
 
 #include "polyscope/polyscope.h"
 
+#include "polyscope/cached_implicit_surface_quantity.h"
 #include "polyscope/floating_quantity.h"
 #include "polyscope/floating_quantity_structure.h"
 #include "polyscope/image_quantity.h"
+#include "polyscope/implicit_surface_glsl_quantity.h"
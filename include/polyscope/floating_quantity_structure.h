@@ -81,6 +81,12 @@ template <class T>
 ColorImageQuantity* addColorAlphaImageQuantity(std::string name, size_t dimX, size_t dimY, const T& values_rgba,
                                                ImageOrigin imageOrigin);
 
+template <class T>
+TiledColorImageQuantity* addTiledColorImageQuantity(std::string name, size_t dimX, size_t dimY, const T& values_rgb,
+                                                    ImageOrigin imageOrigin);
+
+TiledColorImageQuantity* addTiledColorImageQuantityFromLoader(std::string name, size_t dimX, size_t dimY,
+                                                              ImageTileLoader loader, ImageOrigin imageOrigin);
 
 template <class T1, class T2>
 DepthRenderImageQuantity* addDepthRenderImageQuantity(std::string name, size_t dimX, size_t dimY, const T1& depthData,
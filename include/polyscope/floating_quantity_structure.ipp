@@ -28,6 +28,12 @@ ColorImageQuantity* addColorAlphaImageQuantity(std::string name, size_t dimX, si
   return q->addColorImageQuantity(name, dimX, dimY, values_rgba, imageOrigin);
 }
 
+template <class T>
+TiledColorImageQuantity* addTiledColorImageQuantity(std::string name, size_t dimX, size_t dimY, const T& values_rgb,
+                                                    ImageOrigin imageOrigin) {
+  FloatingQuantityStructure* q = getGlobalFloatingQuantityStructure();
+  return q->addTiledColorImageQuantity(name, dimX, dimY, values_rgb, imageOrigin);
+}
 
 template <class T1, class T2>
 DepthRenderImageQuantity* addDepthRenderImageQuantity(std::string name, size_t dimX, size_t dimY, const T1& depthData,
@@ -0,0 +1,79 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// A monotonic allocator for temporaries which live no longer than one frame, such as UI labels and scratch arrays
+// built while drawing. Allocating bumps a pointer within a block, nothing is freed individually, and the whole arena
+// is reset when the next frame starts drawing. Blocks are kept across resets, so once the arena has grown to fit a
+// typical frame, steady-state frames make no heap allocations for these temporaries. Main thread only.
+class FrameArena {
+public:
+  FrameArena(size_t blockSize = 1 << 16);
+
+  // No copy constructor/assignment
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  void* allocate(size_t nBytes, size_t alignment = alignof(std::max_align_t));
+  void reset(); // invalidates everything allocated so far
+
+  size_t bytesUsed() const; // since the last reset
+  size_t capacity() const;  // total size of the blocks held
+
+private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+  std::vector<Block> blocks;
+  size_t blockSize;
+  size_t currBlock = 0;
+  size_t currOffset = 0;
+  size_t usedInEarlierBlocks = 0;
+};
+
+// The arena for the frame being drawn, reset at the start of each top-level draw()
+FrameArena& frameArena();
+
+// A standard allocator on top of the frame arena, see FrameVector and FrameString below
+template <typename T>
+class FrameArenaAllocator {
+public:
+  typedef T value_type;
+
+  FrameArenaAllocator() : arena(&frameArena()) {}
+  FrameArenaAllocator(FrameArena& arena_) : arena(&arena_) {}
+  template <typename U>
+  FrameArenaAllocator(const FrameArenaAllocator<U>& other) : arena(other.arena) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T*, size_t) {} // (released all at once, by the reset)
+
+  template <typename U>
+  bool operator==(const FrameArenaAllocator<U>& other) const {
+    return arena == other.arena;
+  }
+  template <typename U>
+  bool operator!=(const FrameArenaAllocator<U>& other) const {
+    return arena != other.arena;
+  }
+
+  FrameArena* arena;
+};
+
+// Containers for per-frame temporaries. They must not be kept past the end of the frame.
+template <typename T>
+using FrameVector = std::vector<T, FrameArenaAllocator<T>>;
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameArenaAllocator<char>>;
+
+// printf-style formatting in to the frame arena, e.g. for ImGui labels. The result is valid until the end of the frame.
+const char* frameFormat(const char* format, ...);
+
+} // namespace polyscope
@@ -0,0 +1,46 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace polyscope {
+
+struct IsosurfaceMesh {
+  std::vector<glm::vec3> vertices; // in grid index coordinates
+  std::vector<glm::vec3> normals;  // unit, along the field gradient (towards larger values) in index coordinates
+  std::vector<uint32_t> indices;   // triangles
+};
+
+// Marching cubes on a regular grid. The grid is split into slabs along the first axis, which are extracted in
+// parallel; vertices on the planes between slabs are shared, so the output is a single welded mesh. A min/max summary
+// of the field over small blocks of cells is built once up front, and lets each extraction skip blocks which cannot
+// contain the level, so repeated extractions at different levels (e.g. dragging an isovalue slider) only pay for the
+// part of the grid near the surface.
+class GridIsosurfaceExtractor {
+public:
+  // values[(iX * nY + iY) * nZ + iZ] is the value at node (iX, iY, iZ), as in VolumeGrid. The values are referenced,
+  // not copied, and must outlive the extractor.
+  GridIsosurfaceExtractor(const double* values, std::array<size_t, 3> steps);
+
+  // A vertex is placed on each grid edge whose endpoints fall on either side of the level (one value < level, the
+  // other >= level). NaN values mark missing data: no vertex is placed on their edges, and cells touching them are
+  // skipped.
+  IsosurfaceMesh extract(double level) const;
+
+private:
+  const double* values;
+  std::array<size_t, 3> steps;
+
+  // min/max of the values at the nodes of each block of cells, indexed like the nodes
+  std::array<size_t, 3> blockSteps;
+  std::vector<double> blockMin;
+  std::vector<double> blockMax;
+};
+
+} // namespace polyscope
@@ -4,8 +4,10 @@
 
 #include "polyscope/structure.h"
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace polyscope {
 
@@ -28,6 +30,20 @@ public:
   int isEnabled();
   Group* setEnabled(bool newEnabled);
 
+  // == Batched operations
+  // These act on every structure in this group and its descendant groups, once each even if a structure is in several
+  // of them. The scene extents are recomputed once at the end, rather than after every structure.
+
+  void setTransform(glm::mat4x4 transform);
+  void translate(glm::vec3 vec);
+  void resetTransform();
+
+  // Call func on each structure; any extents updates it triggers are likewise batched
+  void forEachStructure(const std::function<void(Structure&)>& func);
+
+  // All structures in this group and its descendants, without duplicates
+  std::vector<Structure*> getDescendantStructures();
+
   void addChildGroup(std::weak_ptr<Group> newChild);
   void addChildStructure(std::weak_ptr<Structure> newChild);
   void removeChildGroup(Group* child);
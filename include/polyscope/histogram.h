@@ -5,6 +5,7 @@
 #include "polyscope/render/color_maps.h"
 #include "polyscope/render/engine.h"
 
+#include <memory>
 #include <vector>
 
 
@@ -17,19 +18,37 @@ public:
   Histogram(std::vector<double>& values); // internally calls buildHistogram()
 
   ~Histogram();
+  Histogram(const Histogram&) = delete; // (it owns a cell of an atlas page)
+  Histogram& operator=(const Histogram&) = delete;
 
   void buildHistogram(const std::vector<double>& values);
+  void buildHistogram(const std::vector<float>& values);
+
+  // Same as above, but binning over a range which the caller has already computed with robustMinMax()
+  void buildHistogram(const std::vector<double>& values, std::pair<double, double> valueRange);
+  void buildHistogram(const std::vector<float>& values, std::pair<double, double> valueRange);
+
+  // Same as above, but counting float values which are already in a GPU attribute buffer, without copying them back
+  void buildHistogram(std::shared_ptr<render::AttributeBuffer> values, std::pair<double, double> valueRange);
   void updateColormap(const std::string& newColormap);
 
-  // Width = -1 means set automatically
+  // Width = -1 means set automatically. The image is only re-rendered when the histogram, colormap, or colormapRange
+  // have changed since it was last drawn.
   void buildUI(float width = -1.0);
 
   std::pair<double, double> colormapRange; // in DATA values, not [0,1]
 
+  // How many times the image has been rendered, and how many shared atlas textures all histograms' images live in
+  size_t getTextureRenderCount() const { return textureRenderCount; }
+  static size_t getAtlasPageCount();
+
 private:
   // = Helpers
 
   // Manage the actual histogram
+  template <typename T>
+  void buildHistogramFromValues(const std::vector<T>& values, std::pair<double, double> valueRange);
+  void buildCurvesFromCounts(const std::vector<double>& binCounts);
   void fillBuffers();
   size_t rawHistBinCount = 51;
 
@@ -37,14 +56,25 @@ private:
   std::vector<std::array<float, 2>> rawHistCurveX;
   std::pair<double, double> dataRange;
 
-  // Render to texture
+  // Render to texture. Each histogram's image is one cell of an atlas page, a texture shared by several histograms and
+  // drawn to through one framebuffer.
+  struct AtlasPage;
+  static std::vector<std::weak_ptr<AtlasPage>> atlasPages; // held by the histograms with a cell in them
   void renderToTexture();
   void prepare();
+  void acquireAtlasCell();
 
-  unsigned int texDim = 600;
-  std::shared_ptr<render::TextureBuffer> texture = nullptr;
-  std::shared_ptr<render::FrameBuffer> framebuffer = nullptr;
+  std::shared_ptr<AtlasPage> atlasPage = nullptr;
+  size_t atlasCell = 0;
   std::shared_ptr<render::ShaderProgram> program = nullptr;
+  bool textureValid = false;
+  std::pair<double, double> renderedColormapRange;
+  size_t textureRenderCount = 0;
+
+  // Counting values on the GPU, only created if used
+  std::shared_ptr<render::TextureBuffer> binTexture = nullptr;
+  std::shared_ptr<render::FrameBuffer> binFramebuffer = nullptr;
+  std::shared_ptr<render::ShaderProgram> binProgram = nullptr;
   std::string colormap = "viridis";
 
   // A few parameters which control appearance
@@ -12,3 +12,4 @@
 #include "polyscope/depth_render_image_quantity.h"
 #include "polyscope/scalar_image_quantity.h"
 #include "polyscope/scalar_render_image_quantity.h"
+#include "polyscope/tiled_image_quantity.h"
@@ -6,6 +6,7 @@
 
 #include "polyscope/floating_quantity.h"
 #include "polyscope/fullscreen_artist.h"
+#include "polyscope/render/engine.h"
 
 #include <vector>
 
@@ -14,10 +15,18 @@ namespace polyscope {
 // forward declaration since it appears as a class member below
 class CameraView;
 
+namespace internal {
+// Called once for each rendered frame. Releases the textures of image quantities which were not shown since the last
+// call, when options::imageTexturePaging is set.
+void pageImageTextures();
+} // namespace internal
+
 class ImageQuantity : public FloatingQuantity, public FullscreenArtist {
 
 public:
-  ImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY, ImageOrigin imageOrigin);
+  ImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY, ImageOrigin imageOrigin,
+                TextureFormat defaultTextureFormat);
+  virtual ~ImageQuantity();
 
 
   virtual void draw() override;
@@ -42,6 +51,15 @@ public:
   void setTransparency(float newVal);
   float getTransparency();
 
+  // The format in which the image is stored on the GPU. Color images support RGBA8, RGBA16F, and RGBA32F (the
+  // default); scalar images support R16F and R32F (the default). Smaller formats trade precision for memory and
+  // upload bandwidth.
+  void setTextureFormat(TextureFormat newFormat);
+  TextureFormat getTextureFormat();
+
+  // Drop the GPU copy of the image (and anything drawn from it); it is re-uploaded when next shown
+  virtual void releaseTextures() = 0;
+
 protected:
   // === Visualization parameters
   const size_t dimX, dimY;
@@ -49,6 +67,17 @@ protected:
   PersistentValue<float> transparency;
   PersistentValue<bool> isShowingFullscreen, isShowingImGuiWindow, isShowingCameraBillboard;
   CameraView* parentStructureCameraView = nullptr; // a ptr to the parent structure ONLY if it is a CameraView
+  TextureFormat textureFormat;
+
+  // used by options::imageTexturePaging
+  bool shownSinceLastPaging = false;
+  friend void internal::pageImageTextures();
+
+  virtual bool textureFormatSupported(TextureFormat format) = 0;
+
+  // Subclasses call this before uploading their texture. Returns false if the upload should be deferred to a later
+  // frame (only when paging image textures).
+  bool acquireTextureUpload();
 
   // render the image fullscreen
   virtual void showFullscreen() = 0;
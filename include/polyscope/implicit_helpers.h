@@ -13,11 +13,15 @@
 #include "polyscope/structure.h"
 #include "polyscope/utilities.h"
 
+#include <functional>
 #include <string>
 #include <vector>
 
 namespace polyscope {
 
+class CachedImplicitSurfaceQuantity;
+class ImplicitSurfaceGLSLQuantity;
+
 // A collection of helper functions for generating visualizations of implicitly-defined data (that is, where you have a
 // function that you can evaluate at f(x,y,z) to get back a scalar, color, etc.
 
@@ -72,12 +76,33 @@ struct ImplicitRenderOpts {
 
   // The maximum number of steps to take
   size_t nMaxSteps = 1024;
+
+  // = Options for how the computation is scheduled
+
+  // The image is traced in square tiles of this many pixels on a side. Each tile keeps its own working set of rays,
+  // and the batch function is called with just the tile's still-active rays.
+  size_t tileSize = 64;
+
+  // If true, tiles are traced on several threads at once (see options::maxWorkerThreads). Your implicit function(s)
+  // will then be called concurrently, so they must be thread-safe.
+  bool parallel = false;
+
+  // If > 1, render progressively: whenever the camera or resolution differs from the last render of the same image,
+  // render a preview subsampled by this additional factor instead, and render at full resolution on the next call with
+  // an unchanged camera. Useful when re-rendering every frame from the current view.
+  int previewSubsampleFactor = 1;
 };
 
 // Populate the custom-filled entries of opts according to the policy above.
 template <class S>
 void resolveImplicitRenderOpts(QuantityStructure<S>* parent, ImplicitRenderOpts& opts);
 
+namespace internal {
+// Records the camera & resolution of the latest render of the image with the given key, returning true if they differ
+// from the previous one (used for opts.previewSubsampleFactor).
+bool implicitRenderViewChanged(std::string key, const CameraParameters& params, int32_t dimX, int32_t dimY);
+} // namespace internal
+
 // === Depth/geometry/shape only render functions
 
 // Renders an implicit surface by shooting a ray for each pixel and querying the implicit function along the ray.
@@ -162,6 +187,30 @@ ScalarRenderImageQuantity* renderImplicitSurfaceScalarBatch(std::string name, Fu
                                                             DataType dataType = DataType::STANDARD);
 
 
+// === Auto-updating render functions
+
+// Like renderImplicitSurface(), but the resulting quantity keeps a copy of your function and re-renders itself whenever
+// it is drawn after the view changes, so there is no need to call this again on camera moves. Call
+// markParametersChanged() on the quantity if the function itself changes. See CachedImplicitSurfaceQuantity. Always
+// adds to the global floating structure.
+template <class Func>
+CachedImplicitSurfaceQuantity* renderImplicitSurfaceCached(std::string name, Func&& func, ImplicitRenderMode mode,
+                                                           ImplicitRenderOpts opts = ImplicitRenderOpts());
+CachedImplicitSurfaceQuantity* renderImplicitSurfaceCachedBatch(std::string name,
+                                                                std::function<void(const float*, float*, size_t)> func,
+                                                                ImplicitRenderMode mode,
+                                                                ImplicitRenderOpts opts = ImplicitRenderOpts());
+
+// === GPU render functions
+
+// Like renderImplicitSurface(), but the implicit function is a snippet of GLSL, which is compiled in to a fullscreen
+// ray marching shader and re-rendered every frame from the current view. `functionBody` is the body of
+// `float implicitFunction(vec3 p)`, where p is a world-space position, e.g. "return length(p) - 1.;". Always adds to
+// the global floating structure. Of the opts, only those for the rendering computation itself are used.
+ImplicitSurfaceGLSLQuantity* renderImplicitSurfaceGLSL(std::string name, std::string functionBody,
+                                                       ImplicitRenderMode mode,
+                                                       ImplicitRenderOpts opts = ImplicitRenderOpts());
+
 } // namespace polyscope
 
 #include "polyscope/implicit_helpers.ipp"
@@ -7,9 +7,14 @@
 #include "polyscope/floating_quantity_structure.h"
 #include "polyscope/implicit_helpers.h"
 #include "polyscope/messages.h"
+#include "polyscope/parallel.h"
 #include "polyscope/view.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
 namespace polyscope {
@@ -63,9 +68,24 @@ void resolveImplicitRenderOpts(QuantityStructure<S>* parent, ImplicitRenderOpts&
             "global floating structure to use the current view");
 }
 
+template <class S>
+void applyImplicitRenderPreview(QuantityStructure<S>* parent, std::string name, ImplicitRenderOpts& opts) {
+  if (opts.previewSubsampleFactor <= 1) return;
+
+  bool viewChanged =
+      internal::implicitRenderViewChanged(parent->uniquePrefix() + name, opts.cameraParameters, opts.dimX, opts.dimY);
+  if (viewChanged) {
+    opts.dimX = std::max(1, opts.dimX / opts.previewSubsampleFactor);
+    opts.dimY = std::max(1, opts.dimY / opts.previewSubsampleFactor);
+  }
+}
+
+// If startDepths is given, each ray starts that far from the camera instead of at it (one entry per pixel, in the same
+// order as the output). Used to skip the empty space in front of a surface seen in an earlier render.
 template <class Func>
 std::tuple<std::vector<float>, std::vector<glm::vec3>, std::vector<glm::vec3>>
-renderImplicitSurfaceTracer(Func&& func, ImplicitRenderMode mode, ImplicitRenderOpts opts) {
+renderImplicitSurfaceTracer(Func&& func, ImplicitRenderMode mode, ImplicitRenderOpts opts,
+                            const std::vector<float>* startDepths) {
 
   // Read out option values
   const float missDist = opts.missDist.asAbsolute();
@@ -74,145 +94,181 @@ renderImplicitSurfaceTracer(Func&& func, ImplicitRenderMode mode, ImplicitRender
   const float stepSize = opts.stepSize.asAbsolute(); // used for fixed step only
   const size_t nMaxSteps = opts.nMaxSteps;
   const float normalSampleEps = opts.normalSampleEps;
-  const int subsampleFactor = opts.subsampleFactor;
+  const size_t tileSize = std::max<size_t>(1, opts.tileSize);
 
 
   CameraParameters& params = opts.cameraParameters;
-  glm::vec3 cameraLoc = params.getPosition();
+  const glm::vec3 cameraLoc = params.getPosition();
   glm::mat4x4 viewMat = params.getViewMat();
   size_t dimX = opts.dimX;
   size_t dimY = opts.dimY;
   size_t nPix = dimX * dimY;
 
-  // Generate rays corresponding to each pixel
-  // (this is a working set which will be shrunk as computation proceeds)
-  std::vector<glm::vec3> rayRoots(nPix);
-  std::vector<size_t> rayInds(nPix); // index of the ray
-  for (size_t iY = 0; iY < dimY; iY++) {
-    for (size_t iX = 0; iX < dimX; iX++) {
-      size_t ind = iY * dimX + iX;
-      rayRoots[ind] = cameraLoc;
-      rayInds[ind] = ind;
-    }
-  }
-  std::vector<glm::vec3> rayDirs = params.generateCameraRays(dimX, dimY, ImageOrigin::UpperLeft);
-
-  // Sample the first value at each ray (to check for sign changes)
-  std::vector<float> currVals(nPix);
-  func(&rayRoots.front().x, &currVals.front(), rayRoots.size());
-
-  std::vector<bool> initSigns(nPix);
-  for (size_t iP = 0; iP < nPix; iP++) {
-    initSigns[iP] = std::signbit(currVals[iP]);
-  }
+  std::vector<glm::vec3> pixelRayDirs = params.generateCameraRays(dimX, dimY, ImageOrigin::UpperLeft);
 
   // Write output data here
-
-  // March along the ray to compute depth
-  std::vector<float> rayDepth(nPix, 0.); // working data, gets shrunk and repacked
-  std::vector<glm::vec3> currPos(nPix);
   std::vector<float> rayDepthOut(nPix, -1.);                        // output values
   std::vector<glm::vec3> rayPosOut(nPix, glm::vec3{0.f, 0.f, 0.f}); // output values
-  size_t iFinished = 0;
-  for (size_t iStep = 0; (iStep < nMaxSteps) && (iFinished < nPix); iStep++) {
-
-    // Check for convergence & write/compact
-    size_t iPack = 0;
-    for (size_t iP = 0; iP < rayDepth.size(); iP++) {
-
-      // Check for termination
-      bool missTerminated = rayDepth[iP] > missDist;
-      bool terminated =
-          missTerminated || (std::abs(currVals[iP]) < hitDist) || (std::signbit(currVals[iP]) != initSigns[iP]);
-
-      if (terminated) {
-        // Write to the output buffer
-        size_t outInd = rayInds[iP];
-        glm::vec3 finalPos = rayRoots[iP] + rayDepth[iP] * rayDirs[iP];
-        float outDepth = missTerminated ? -1.f : rayDepth[iP];
-        rayDepthOut[outInd] = outDepth;
-        rayPosOut[outInd] = finalPos;
-
-        iFinished++;
-
-      } else {
-        // Take a step
-        float rayStepSize = -1.;
-        if (mode == ImplicitRenderMode::SphereMarch) {
-          rayStepSize = std::abs(currVals[iP]) * stepFactor;
-        } else if (mode == ImplicitRenderMode::FixedStep) {
-          rayStepSize = stepSize;
-        }
+  std::vector<glm::vec3> normalOut(nPix, glm::vec3{0.f, 0.f, 0.f}); // output values
 
-        float newDepth = rayDepth[iP] + rayStepSize;
-        glm::vec3 newPos = rayRoots[iP] + newDepth * rayDirs[iP];
+  // Vertices of a tetrahedron, used to estimate normals with finite differences
+  // (see https://iquilezles.org/articles/normalsSDF/)
+  const std::array<glm::vec3, 4> tetVerts({
+      glm::vec3{1.f, -1.f, -1.f},
+      glm::vec3{-1.f, -1.f, 1.f},
+      glm::vec3{-1.f, 1.f, -1.f},
+      glm::vec3{1.f, 1.f, 1.f},
+  });
 
-        // Write to the compacted array
-        rayRoots[iPack] = rayRoots[iP];
-        rayDirs[iPack] = rayDirs[iP];
-        rayInds[iPack] = rayInds[iP];
-        rayDepth[iPack] = newDepth;
-        currPos[iPack] = newPos;
-        iPack++;
+  // Trace all of the rays in one tile of the image. Each tile only ever touches the output entries for its own pixels.
+  size_t nTilesX = (dimX + tileSize - 1) / tileSize;
+  size_t nTilesY = (dimY + tileSize - 1) / tileSize;
+  size_t nTiles = nTilesX * nTilesY;
+  auto traceTile = [&](size_t iTile) {
+    size_t xStart = (iTile % nTilesX) * tileSize;
+    size_t yStart = (iTile / nTilesX) * tileSize;
+    size_t xEnd = std::min(dimX, xStart + tileSize);
+    size_t yEnd = std::min(dimY, yStart + tileSize);
+
+    // Generate rays corresponding to each pixel in the tile
+    // (this is a working set which will be shrunk as computation proceeds)
+    std::vector<glm::vec3> rayDirs;
+    std::vector<size_t> rayInds; // index of the ray
+    for (size_t iY = yStart; iY < yEnd; iY++) {
+      for (size_t iX = xStart; iX < xEnd; iX++) {
+        size_t ind = iY * dimX + iX;
+        rayDirs.push_back(pixelRayDirs[ind]);
+        rayInds.push_back(ind);
+      }
+    }
+    size_t nTilePix = rayInds.size();
+
+    // Starting depth of each ray
+    std::vector<float> rayDepth(nTilePix, 0.); // working data, gets shrunk and repacked
+    std::vector<glm::vec3> currPos(nTilePix, cameraLoc);
+    if (startDepths) {
+      for (size_t iP = 0; iP < nTilePix; iP++) {
+        rayDepth[iP] = (*startDepths)[rayInds[iP]];
+        currPos[iP] = cameraLoc + rayDepth[iP] * rayDirs[iP];
       }
     }
 
-    // "Trim" the working arrays to size
-    rayRoots.resize(iPack);
-    rayDirs.resize(iPack);
-    rayInds.resize(iPack);
-    rayDepth.resize(iPack);
-    currPos.resize(iPack);
-    currVals.resize(iPack);
+    // Sample the first value at each ray (to check for sign changes)
+    std::vector<float> currVals(nTilePix);
+    func(&currPos.front().x, &currVals.front(), currPos.size());
 
-    // Evaluate the remaining rays
-    if (iPack > 0) {
-      func(&currPos.front().x, &currVals.front(), currPos.size());
+    std::vector<bool> initSigns(nTilePix);
+    for (size_t iP = 0; iP < nTilePix; iP++) {
+      initSigns[iP] = std::signbit(currVals[iP]);
     }
-  }
 
-  // == Compute normals
-  // Uses finite differences on the vertices of a tetrahedron
-  // (see https://iquilezles.org/articles/normalsSDF/)
+    // March along the ray to compute depth
+    std::vector<size_t> hitInds; // rays which converged to a hit
+    for (size_t iStep = 0; (iStep < nMaxSteps) && !rayInds.empty(); iStep++) {
+
+      // Check for convergence & write/compact
+      size_t iPack = 0;
+      for (size_t iP = 0; iP < rayDepth.size(); iP++) {
+
+        // Check for termination
+        bool missTerminated = rayDepth[iP] > missDist;
+        bool terminated =
+            missTerminated || (std::abs(currVals[iP]) < hitDist) || (std::signbit(currVals[iP]) != initSigns[iP]);
+
+        if (terminated) {
+          // Write to the output buffer
+          size_t outInd = rayInds[iP];
+          rayPosOut[outInd] = cameraLoc + rayDepth[iP] * rayDirs[iP];
+          if (!missTerminated) {
+            rayDepthOut[outInd] = rayDepth[iP];
+            hitInds.push_back(outInd);
+          }
+
+        } else {
+          // Take a step
+          float rayStepSize = -1.;
+          if (mode == ImplicitRenderMode::SphereMarch) {
+            rayStepSize = std::abs(currVals[iP]) * stepFactor;
+          } else if (mode == ImplicitRenderMode::FixedStep) {
+            rayStepSize = stepSize;
+          }
+
+          float newDepth = rayDepth[iP] + rayStepSize;
+
+          // Write to the compacted array
+          rayDirs[iPack] = rayDirs[iP];
+          rayInds[iPack] = rayInds[iP];
+          rayDepth[iPack] = newDepth;
+          currPos[iPack] = cameraLoc + newDepth * rayDirs[iP];
+          initSigns[iPack] = initSigns[iP];
+          iPack++;
+        }
+      }
 
-  std::vector<glm::vec3> normalOut(nPix, glm::vec3{0.f, 0.f, 0.f}); // output values
-  std::array<glm::vec3, 4> tetVerts({
-      glm::vec3{1.f, -1.f, -1.f},
-      glm::vec3{-1.f, -1.f, 1.f},
-      glm::vec3{-1.f, 1.f, -1.f},
-      glm::vec3{1.f, 1.f, 1.f},
-  });
+      // "Trim" the working arrays to size
+      rayDirs.resize(iPack);
+      rayInds.resize(iPack);
+      rayDepth.resize(iPack);
+      currPos.resize(iPack);
+      currVals.resize(iPack);
+      initSigns.resize(iPack);
+
+      // Evaluate the remaining rays
+      if (iPack > 0) {
+        func(&currPos.front().x, &currVals.front(), currPos.size());
+      }
+    }
 
-  currPos.resize(nPix);
-  currVals.resize(nPix);
-  for (size_t iV = 0; iV < 4; iV++) {
-    glm::vec3 vertVec = tetVerts[iV];
+    // == Compute normals, only at the hits
+    size_t nHits = hitInds.size();
+    if (nHits == 0) return;
+    currPos.resize(nHits);
+    currVals.resize(nHits);
+    for (size_t iV = 0; iV < 4; iV++) {
+      glm::vec3 vertVec = tetVerts[iV];
+
+      // Set up the evaluation points for each pixel
+      for (size_t iH = 0; iH < nHits; iH++) {
+        size_t ind = hitInds[iH];
+        float f = rayDepthOut[ind] * normalSampleEps;
+        currPos[iH] = rayPosOut[ind] + f * vertVec;
+      }
 
-    // Set up the evaluation points for each pixel
-    for (size_t iP = 0; iP < nPix; iP++) {
-      float f = rayDepthOut[iP] * normalSampleEps;
-      currPos[iP] = rayPosOut[iP] + f * vertVec;
-    }
+      // Evaluate the function at each sample point
+      func(&currPos.front().x, &currVals.front(), currPos.size());
 
-    // Evaluate the function at each sample point
-    func(&currPos.front().x, &currVals.front(), currPos.size());
+      // Accumulate the result
+      for (size_t iH = 0; iH < nHits; iH++) {
+        normalOut[hitInds[iH]] += vertVec * currVals[iH];
+      }
+    }
+  };
 
-    // Accumulate the result
-    for (size_t iP = 0; iP < nPix; iP++) {
-      normalOut[iP] += vertVec * currVals[iP];
+  if (opts.parallel) {
+    // hand out tiles one at a time, since their cost varies a lot
+    std::atomic<size_t> nextTile(0);
+    parallelFor(
+        0, nTiles,
+        [&](size_t, size_t) {
+          for (size_t iTile = nextTile++; iTile < nTiles; iTile = nextTile++) {
+            traceTile(iTile);
+          }
+        },
+        1);
+  } else {
+    for (size_t iTile = 0; iTile < nTiles; iTile++) {
+      traceTile(iTile);
     }
   }
 
   // Normalize the normal vectors and transform to view space
   glm::mat3x3 viewMat3(viewMat);
-  for (size_t iP = 0; iP < nPix; iP++) {
-    normalOut[iP] = viewMat3 * glm::normalize(normalOut[iP]);
-  }
-
-  // Handle not-converged rays
   for (size_t iP = 0; iP < nPix; iP++) {
     bool didConverge = rayDepthOut[iP] >= 0.;
-    if (!didConverge) {
+    if (didConverge) {
+      normalOut[iP] = viewMat3 * glm::normalize(normalOut[iP]);
+    } else {
+      // Handle not-converged rays
       rayDepthOut[iP] = std::numeric_limits<float>::infinity();
       normalOut[iP] = glm::vec3{0.f, 0.f, 0.f};
     }
@@ -265,12 +321,13 @@ DepthRenderImageQuantity* renderImplicitSurfaceBatch(QuantityStructure<S>* paren
                                                      ImplicitRenderMode mode, ImplicitRenderOpts opts) {
 
   resolveImplicitRenderOpts(parent, opts);
+  applyImplicitRenderPreview(parent, name, opts);
 
   // Call the function which does all the hard work
   std::vector<float> rayDepthOut;
   std::vector<glm::vec3> rayPosOut;
   std::vector<glm::vec3> normalOut;
-  std::tie(rayDepthOut, rayPosOut, normalOut) = renderImplicitSurfaceTracer(func, mode, opts);
+  std::tie(rayDepthOut, rayPosOut, normalOut) = renderImplicitSurfaceTracer(func, mode, opts, nullptr);
 
   // TODO check if there is an existing quantity of the same type/size to replace, and if so re-fill its buffers
   // rather than creating a whole new one
@@ -280,6 +337,30 @@ DepthRenderImageQuantity* renderImplicitSurfaceBatch(QuantityStructure<S>* paren
                                                  ImageOrigin::UpperLeft);
 }
 
+// =======================================================
+// === Auto-updating render functions
+// =======================================================
+
+template <class Func>
+CachedImplicitSurfaceQuantity* renderImplicitSurfaceCached(std::string name, Func&& func, ImplicitRenderMode mode,
+                                                           ImplicitRenderOpts opts) {
+
+  // Bootstrap on the batch version, keeping a copy of the function since it is called again later
+  typename std::decay<Func>::type funcCopy = func;
+  auto batchFunc = [funcCopy](const float* pos_ptr, float* result_ptr, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      glm::vec3 pos{
+          pos_ptr[3 * i + 0],
+          pos_ptr[3 * i + 1],
+          pos_ptr[3 * i + 2],
+      };
+      result_ptr[i] = static_cast<float>(funcCopy(pos));
+    }
+  };
+
+  return renderImplicitSurfaceCachedBatch(name, batchFunc, mode, opts);
+}
+
 // =======================================================
 // === Colored surface render functions
 // =======================================================
@@ -341,12 +422,13 @@ ColorRenderImageQuantity* renderImplicitSurfaceColorBatch(QuantityStructure<S>*
                                                           ImplicitRenderOpts opts) {
 
   resolveImplicitRenderOpts(parent, opts);
+  applyImplicitRenderPreview(parent, name, opts);
 
   // Call the function which does all the hard work
   std::vector<float> rayDepthOut;
   std::vector<glm::vec3> rayPosOut;
   std::vector<glm::vec3> normalOut;
-  std::tie(rayDepthOut, rayPosOut, normalOut) = renderImplicitSurfaceTracer(func, mode, opts);
+  std::tie(rayDepthOut, rayPosOut, normalOut) = renderImplicitSurfaceTracer(func, mode, opts, nullptr);
 
   // Batch evaluate the color function
   std::vector<glm::vec3> colorOut(rayPosOut.size());
@@ -427,12 +509,13 @@ ScalarRenderImageQuantity* renderImplicitSurfaceScalarBatch(QuantityStructure<S>
                                                             ImplicitRenderOpts opts, DataType dataType) {
 
   resolveImplicitRenderOpts(parent, opts);
+  applyImplicitRenderPreview(parent, name, opts);
 
   // Call the function which does all the hard work
   std::vector<float> rayDepthOut;
   std::vector<glm::vec3> rayPosOut;
   std::vector<glm::vec3> normalOut;
-  std::tie(rayDepthOut, rayPosOut, normalOut) = renderImplicitSurfaceTracer(func, mode, opts);
+  std::tie(rayDepthOut, rayPosOut, normalOut) = renderImplicitSurfaceTracer(func, mode, opts, nullptr);
 
   // Batch evaluate the color function
   std::vector<float> scalarOut(rayPosOut.size());
@@ -451,11 +534,7 @@ ScalarRenderImageQuantity* renderImplicitSurfaceScalarBatch(QuantityStructure<S>
   // rather than creating a whole new one
 
   // here, we bypass the conversion adaptor since we have explicitly filled matching types
-  std::vector<double> scalarOutD(rayPosOut.size());
-  for (size_t i = 0; i < scalarOut.size(); i++) {
-    scalarOutD[i] = scalarOut[i];
-  }
-  return parent->addScalarRenderImageQuantityImpl(name, opts.dimX, opts.dimY, rayDepthOut, normalOut, scalarOutD,
+  return parent->addScalarRenderImageQuantityImpl(name, opts.dimX, opts.dimY, rayDepthOut, normalOut, scalarOut,
                                                   ImageOrigin::UpperLeft, dataType);
 }
 
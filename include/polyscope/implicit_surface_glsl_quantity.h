@@ -0,0 +1,70 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/floating_quantity.h"
+#include "polyscope/implicit_helpers.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/render/engine.h"
+
+#include <string>
+
+namespace polyscope {
+
+// An implicit surface which is ray marched on the GPU every frame, from the current view, with the implicit function
+// given as GLSL source (see renderImplicitSurfaceGLSL()). Unlike the render images from renderImplicitSurface(), it
+// follows the camera with no work on the CPU, and composites with the rest of the scene by depth.
+class ImplicitSurfaceGLSLQuantity : public FloatingQuantity {
+
+public:
+  ImplicitSurfaceGLSLQuantity(Structure& parent_, std::string name, std::string functionBody, ImplicitRenderMode mode,
+                              ImplicitRenderOpts opts);
+
+  virtual void draw() override;
+  virtual void drawDelayed() override;
+  virtual void buildCustomUI() override;
+
+  virtual void refresh() override;
+  virtual ImplicitSurfaceGLSLQuantity* setEnabled(bool newEnabled) override;
+
+  virtual std::string niceName() override;
+
+  // == Setters and getters
+
+  // The body of `float implicitFunction(vec3 p)`, which takes a world-space position. Setting it recompiles.
+  ImplicitSurfaceGLSLQuantity* setFunction(std::string newBody);
+  std::string getFunction();
+
+  // set the base color of the rendered geometry
+  ImplicitSurfaceGLSLQuantity* setColor(glm::vec3 newVal);
+  glm::vec3 getColor();
+
+  ImplicitSurfaceGLSLQuantity* setMaterial(std::string name);
+  std::string getMaterial();
+
+  ImplicitSurfaceGLSLQuantity* setTransparency(float newVal);
+  float getTransparency();
+
+
+protected:
+  std::string functionBody;
+  std::string functionRuleName; // registered anew for each function, since programs are cached by rule name
+  uint64_t functionRevision = 0;
+  const ImplicitRenderMode mode;
+  const ImplicitRenderOpts opts;
+
+  // === Visualization parameters
+  PersistentValue<glm::vec3> color;
+  PersistentValue<std::string> material;
+  PersistentValue<float> transparency;
+
+  // === Render data
+  std::shared_ptr<render::ShaderProgram> program;
+
+  // === Helpers
+  void registerFunctionRule();
+  void prepare();
+};
+
+
+} // namespace polyscope
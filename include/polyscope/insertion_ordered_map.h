@@ -0,0 +1,129 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace polyscope {
+
+// A map which finds entries by hashing, and iterates over them in the order they were inserted (rather than walking a
+// tree of nodes, like std::map). Used for the registries of structures and quantities, which are looked up by name but
+// iterated every frame.
+//
+// Iteration yields std::pair<const K, V>&, like std::map. Entries stay at the same address until they are erased.
+// Unlike std::map, inserting or erasing invalidates iterators to other entries, so do not modify the map while
+// iterating over it. Erasing is linear in the size of the map.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class InsertionOrderedMap {
+  typedef std::vector<std::unique_ptr<std::pair<const K, V>>> EntryList;
+
+  template <typename T, typename BaseIter>
+  class Iter {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* pointer;
+    typedef T& reference;
+
+    Iter() {}
+    Iter(BaseIter it_) : it(it_) {}
+    template <typename T2, typename BaseIter2>
+    Iter(const Iter<T2, BaseIter2>& other) : it(other.it) {}
+
+    T& operator*() const { return **it; }
+    T* operator->() const { return it->get(); }
+    Iter& operator++() {
+      ++it;
+      return *this;
+    }
+    Iter operator++(int) {
+      Iter prev = *this;
+      ++it;
+      return prev;
+    }
+    bool operator==(const Iter& other) const { return it == other.it; }
+    bool operator!=(const Iter& other) const { return it != other.it; }
+
+    BaseIter it;
+  };
+
+public:
+  typedef K key_type;
+  typedef V mapped_type;
+  typedef std::pair<const K, V> value_type;
+  typedef Iter<value_type, typename EntryList::iterator> iterator;
+  typedef Iter<const value_type, typename EntryList::const_iterator> const_iterator;
+
+  InsertionOrderedMap() {}
+  InsertionOrderedMap(const InsertionOrderedMap&) = delete;
+  InsertionOrderedMap& operator=(const InsertionOrderedMap&) = delete;
+  InsertionOrderedMap(InsertionOrderedMap&&) = default;
+  InsertionOrderedMap& operator=(InsertionOrderedMap&&) = default;
+
+  iterator begin() { return iterator(entries.begin()); }
+  iterator end() { return iterator(entries.end()); }
+  const_iterator begin() const { return const_iterator(entries.begin()); }
+  const_iterator end() const { return const_iterator(entries.end()); }
+
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  iterator find(const K& key) {
+    auto it = indices.find(key);
+    if (it == indices.end()) return end();
+    return iterator(entries.begin() + it->second);
+  }
+  const_iterator find(const K& key) const {
+    auto it = indices.find(key);
+    if (it == indices.end()) return end();
+    return const_iterator(entries.begin() + it->second);
+  }
+  size_t count(const K& key) const { return indices.count(key); }
+
+  // The i'th entry, in insertion order
+  value_type& entryAt(size_t i) { return *entries[i]; }
+  const value_type& entryAt(size_t i) const { return *entries[i]; }
+
+  // Inserts a default-constructed value at the end if the key is not present
+  V& operator[](const K& key) {
+    auto it = indices.find(key);
+    if (it != indices.end()) return entries[it->second]->second;
+    indices[key] = entries.size();
+    entries.emplace_back(new value_type(key, V()));
+    return entries.back()->second;
+  }
+
+  size_t erase(const K& key) {
+    iterator it = find(key);
+    if (it == end()) return 0;
+    erase(it);
+    return 1;
+  }
+
+  iterator erase(iterator pos) {
+    size_t ind = pos.it - entries.begin();
+    indices.erase(entries[ind]->first);
+    typename EntryList::iterator next = entries.erase(entries.begin() + ind);
+    for (size_t i = ind; i < entries.size(); i++) {
+      indices[entries[i]->first] = i;
+    }
+    return iterator(next);
+  }
+
+  void clear() {
+    entries.clear();
+    indices.clear();
+  }
+
+private:
+  EntryList entries;
+  std::unordered_map<K, size_t, Hash> indices;
+};
+
+} // namespace polyscope
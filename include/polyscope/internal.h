@@ -20,8 +20,42 @@ uint64_t getNextUniqueID();
 
 extern bool pointCloudEfficiencyWarningReported;
 
+// Incremented each time the scene is rendered, so per-frame state can be updated once even though structures may be
+// drawn several times per frame (reflections, transparency passes, etc)
+extern uint64_t renderSceneCount;
+
+// Incremented each time the structures are drawn or pick-drawn (which may happen several times per rendered scene), so
+// work shared between structures can be done once per pass
+extern uint64_t structureDrawPassCount;
+
+// True while the scene is being rendered at reduced quality because the camera is moving (see
+// options::adaptiveQuality). Updated once per main loop iteration.
+extern bool interactiveQualityActive;
+
+// True while the scene buffers are scaled to hold the frame time budget because the camera is moving (see
+// options::dynamicResolution). Updated once per main loop iteration.
+extern bool dynamicResolutionActive;
+
+// Incremented by requestRedraw(). Changes which only move the camera use requestViewRedraw() instead, so effects which
+// don't depend on the view (like the ground plane shadow) can tell when the scene itself may have changed.
+extern uint64_t sceneContentVersion;
+void requestViewRedraw();
+
+// The part of sceneContentVersion due to changes to dynamic structures (see Structure::setStatic()), so the static
+// layer only needs to be re-rendered when sceneContentVersion - dynamicContentChanges changes.
+extern uint64_t dynamicContentChanges;
+
+// requestRedraw() for a change to whichever structure's uniquePrefix() begins `prefixedName` (such as the name of one
+// of its buffers), counting it as a dynamic change unless that structure is static
+void requestRedrawForStructure(const std::string& prefixedName);
+
 extern FloatingQuantityStructure* globalFloatingQuantityStructure;
 
+// While a batch is open, updateStructureExtents() only notes that the extents are out of date, and they are recomputed
+// once when the outermost batch ends. For operations which change many structures at once (see Group).
+void beginStructureExtentsBatch();
+void endStructureExtentsBatch();
+
 
 } // namespace internal
 } // namespace polyscope
@@ -0,0 +1,28 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace polyscope {
+
+// Reordering triangle lists for drawing. When indexed triangles are drawn, the GPU keeps a small cache of recently
+// transformed vertices, so a triangle which shares vertices with the last few drawn is cheap; and vertex data fetched
+// in memory order loads faster. Meshes straight from scanners or marching cubes are often far from either.
+
+// An order of the triangles (as indices in to the list, triVertexInds holding 3 vertices per triangle) which improves
+// reuse of transformed vertices, from Forsyth's linear-speed vertex cache optimization. Degenerate triangles are fine.
+std::vector<uint32_t> optimizeTriangleOrderForVertexCache(const std::vector<uint32_t>& triVertexInds,
+                                                          size_t nVertices);
+
+// An order of the vertices (as original indices) in which the triangles first use them. Vertices which no triangle
+// uses come last, in their original order.
+std::vector<uint32_t> vertexOrderOfFirstUse(const std::vector<uint32_t>& triVertexInds, size_t nVertices);
+
+// The average number of vertices transformed per triangle (the ACMR) when drawing the list through a FIFO vertex cache
+// of the given size. Between 0.5 and 1 is good for closed meshes, 3 is the worst possible.
+double averageCacheMissRatio(const std::vector<uint32_t>& triVertexInds, size_t cacheSize = 16);
+
+} // namespace polyscope
@@ -0,0 +1,35 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+
+#include "glm/glm.hpp"
+
+namespace polyscope {
+namespace occlusion {
+
+// Occlusion culling against the depth of an earlier frame (see options::occlusionCulling). After the opaque structures
+// of a frame are drawn, the scene depth is read back asynchronously and reduced on the host to a hierarchical-Z
+// pyramid holding the farthest depth of each tile. Bounding boxes are projected with the camera of that frame and
+// compared against the coarsest level where they cover a few texels.
+//
+// Only the main camera is tested (not reflection or shadow views), only with TransparencyMode::None, and only while
+// the camera is close to where the depth was captured; during fast moves everything may be visible. Since the depth
+// lags, a structure coming out from behind another can appear a frame late. A redraw is requested whenever something
+// was culled against the depth of a different view or scene.
+
+// Called by renderScene() at the start of a frame, once the camera is set, and after drawing the opaque structures
+void beginFrame();
+void captureSceneDepth();
+
+// Conservatively test whether a world space box may be visible from the current camera. Called for many boxes at once
+// on worker threads. Always true if culling is not active for the frame, or viewProjMat is not the frame's camera.
+bool boxMayBeVisible(glm::vec3 worldMin, glm::vec3 worldMax, const glm::mat4& viewProjMat);
+
+// Whether boxes are being tested this frame, and how many were culled so far
+bool isActive();
+size_t getCulledCount();
+
+} // namespace occlusion
+} // namespace polyscope
@@ -31,12 +31,40 @@ extern bool errorsThrowExceptions;
 // Don't let the main loop run at more than this speed. (-1 disables) (default: 60)
 extern int maxFPS;
 
+// The number of vertical blanks to wait for between presented frames: 1 syncs to the display, 0 doesn't wait at all,
+// and -1 (adaptive sync) waits unless the frame is already late, in which case it tears rather than stalling a whole
+// refresh. Where adaptive sync is not supported, -1 acts as 1. Can be changed at any time. (default: 1)
+extern int swapInterval;
+
+// If true, camera drags are brought up to date with the mouse position sampled right before the scene is rendered,
+// rather than only the position from the start of the frame (before the UI and the user callback), and the CPU waits
+// for each frame to be presented rather than queueing more frames ahead. Costs some throughput for less lag between
+// input and display. The time from sampling input to presenting the frame is recorded by the profiler as "input to
+// present". (default: false)
+extern bool lowLatencyInteraction;
+
 // Read preferences (window size, etc) from startup file, write to same file on exit (default: true)
 extern bool usePrefsFile;
 
 // Should we redraw every frame, even if not requested? (default: false)
 extern bool alwaysRedraw;
 
+// Sleep in the main loop of show() while nothing is happening, rather than building and drawing frames at maxFPS.
+// Frames are drawn on input, requestRedraw(), camera flights, and recording. A user callback is only invoked on those
+// frames, so one which animates or polls for something must call requestRedraw() (or set alwaysRedraw). Does not
+// affect show(nFrames) or frameTick(). (default: false)
+extern bool sleepWhenIdle;
+
+// While sleeping, wake at least this often (in seconds) to re-check for work. (default: 0.5)
+extern double idleWakeInterval;
+
+// Reuse the previous frame's UI while it is idle, rather than building it again every frame: if no input arrived, the
+// mouse is not over a UI window, and nothing requested a redraw for a few frames, the UI panels (and the user
+// callback) are not built, and the last frame's ImGui draw data is drawn over the scene again. As with sleepWhenIdle,
+// a user callback which animates or polls for something must call requestRedraw() (or set alwaysRedraw) to keep
+// being invoked. (default: false)
+extern bool reuseIdleUI;
+
 // Should we center/scale every structure after it is loaded up (default: false)
 extern bool autocenterStructures;
 extern bool autoscaleStructures;
@@ -59,6 +87,10 @@ extern bool giveFocusOnShow;
 extern GroundPlaneMode groundPlaneMode;
 extern bool groundPlaneEnabled; // deprecated, but kept and respected for compatability. use groundPlaneMode.
 extern ScaledValue<float> groundPlaneHeightFactor;
+extern bool groundPlaneHeightLocked;    // keep the ground where it was first placed, rather than following the
+                                        // bottom of the scene as it animates (default: false)
+extern float groundReflectionScale;     // resolution of the mirrored scene drawn for the reflection, relative to the
+                                        // view; it's blurry anyway (default: 0.5)
 extern int shadowBlurIters;
 extern float shadowDarkness;
 
@@ -66,16 +98,145 @@ extern bool screenshotTransparency;     // controls whether screenshots taken by
                                         // transparent background
 extern std::string screenshotExtension; // sets the extension used for automatically-numbered screenshots (e.g. by
                                         // clicking the GUI button)
+extern bool screenshotEncodeInBackground; // encode and write screenshot files on worker threads, so taking a screenshot
+                                          // returns right after readback. see flushScreenshots()
+extern int screenshotPNGCompressionLevel; // zlib level for png screenshots; the default 0 is the fastest, higher values
+                                          // give smaller files
+extern std::string ffmpegExecutable;      // used by startRecording(filename)
+extern std::string recordingEncoderArgs;  // ffmpeg output options used by startRecording(filename)
 
 // === Rendering parameters
 
 // SSAA scaling in pixel multiples
 extern int ssaaFactor;
 
+// Render the scene at this fraction (in (0, 1]) of the display's framebuffer resolution, upscaling it for display,
+// while the UI is still drawn at full resolution. A value <= 0 renders at the window's logical resolution, e.g. half
+// the framebuffer size on a 2x HiDPI display. Dynamic resolution scales down from here. Only has an effect while
+// ssaaFactor is 1. (default: 1)
+extern float renderScale;
+
+// Temporal antialiasing. While nothing changes, each frame renders the scene again with a sub-pixel camera jitter and
+// averages it with the previous ones, so a still view converges to a smooth image at the cost of one render per frame
+// (rather than the ssaaFactor^2 cost of SSAA). Any change to the scene or view starts over. (default: false, 16)
+extern bool temporalAntialiasing;
+extern int temporalAntialiasingSamples;
+
+// Screen-space ambient occlusion, which darkens creases and contacts using only the scene depth buffer, as a fixed
+// per-pixel cost rather than extra passes over the geometry. It is estimated at half the scene resolution unless
+// ambientOcclusionFullResolution is set. Only applies when transparency is off. The radius is relative to the scene
+// length scale. (default: false, 0.03, 1.0, false)
+extern bool ambientOcclusion;
+extern float ambientOcclusionRadius;
+extern float ambientOcclusionStrength;
+extern bool ambientOcclusionFullResolution;
+
 // Transparency settings for the renderer
 extern TransparencyMode transparencyMode;
 extern int transparencyRenderPasses;
 
+// If true, depth peeling stops after the first pass which draws nothing, so transparencyRenderPasses is only an upper
+// bound. Each pass is measured with an occlusion query that is read back on a later frame, so after the view changes
+// the pass count may lag by a frame. (default: true)
+extern bool adaptiveTransparencyRenderPasses;
+
+// If true, the scene is rendered at reduced quality while the camera is moving (lower SSAA, fewer depth peeling passes,
+// coarser level of detail), and at full quality again once it comes to rest. (default: false)
+extern bool adaptiveQuality;
+extern int adaptiveQualitySSAAFactor;               // SSAA factor used while moving (default: 1)
+extern int adaptiveQualityTransparencyRenderPasses; // depth peeling passes used while moving (default: 2)
+
+// If true, the scene buffers are scaled down while the camera is moving (to as little as dynamicResolutionMinScale of
+// the display resolution, and without SSAA) to keep rendering the scene within dynamicResolutionTargetMs, and the
+// result is upscaled for display. The scene renders at full resolution again once the camera comes to rest. Timings
+// come from the profiling timers, which this turns on. (default: false, 16.7, 0.5)
+extern bool dynamicResolution;
+extern float dynamicResolutionTargetMs;
+extern float dynamicResolutionMinScale;
+
+// Whether to keep host-side copies of buffers once they have been uploaded to the GPU. With ReleaseAfterUpload,
+// uploaded data is freed on the host and read back from the GPU if it is needed again (which is slow, but saves
+// memory for large datasets). Double-valued buffers are always kept, since the GPU only stores floats.
+// (default: KeepHostCopy)
+extern HostMemoryPolicy hostMemoryPolicy;
+
+// If true, structures whose bounding box lies entirely outside the view frustum are skipped when drawing the scene and
+// the pick buffer. (default: true)
+extern bool enableFrustumCulling;
+
+// If true, opaque structures (and surface mesh draw clusters) hidden behind others are also skipped, by testing their
+// bounding boxes against the depth of an earlier frame; see occlusion_culling.h. Only used with TransparencyMode::None,
+// and structures are only tested when enableFrustumCulling is set. (default: false)
+extern bool occlusionCulling;
+
+// If true, the structures are drawn grouped by type and material (see Structure::drawSortKey()) and front-to-back
+// within a group, rather than in the order they were registered, which saves rebinding programs and textures between
+// draws and lets the depth test reject hidden fragments early. With TransparencyMode::Simple they are instead drawn
+// back-to-front, which blends more correctly. Also applies to the pick buffer. (default: true)
+extern bool sortDrawsByMaterial;
+
+// Maximum number of threads used for parallel work such as geometry preprocessing. Values <= 0 use all hardware
+// threads, and 1 runs everything on the calling thread. (default: -1)
+extern int maxWorkerThreads;
+
+// The settings of structures and quantities (their persistent values, see persistent_value.h) are remembered by name,
+// so a structure registered again under the same name picks them up. If retainRemovedStructureSettings is false, the
+// settings of a structure are forgotten when it is removed, except when it is replaced by registering another with the
+// same name, or under a prefix passed to pinPersistentValues(). At most maxRetainedPersistentValues names which no
+// live structure or quantity uses are remembered, evicting the least recently used (-1 for no limit).
+// (defaults: false, 100000)
+extern bool retainRemovedStructureSettings;
+extern int maxRetainedPersistentValues;
+
+// If non-negative, a budget in megabytes for GPU memory (including Polyscope's own render targets). When it is
+// exceeded, the buffers and programs of structures which were not drawn in the most recent frame are released, least
+// recently drawn first, and rebuilt from their host-side data when next drawn. (default: -1, no budget)
+extern int gpuMemoryBudgetMB;
+
+// If true, the host data of quantities is compressed in memory (losslessly) while they are disabled, and their GPU
+// buffers and programs are released. Enabling a quantity decompresses it again (timed by the profiler as "enable
+// compressed quantity"), and the GPU buffers are re-uploaded when it is next drawn. (default: false)
+extern bool compressDisabledQuantities;
+
+// If true, image quantities only keep textures on the GPU while they are shown (in a window, fullscreen, or on a camera
+// billboard); the textures of hidden images are released at the end of each rendered frame and re-uploaded from the
+// host data when the image is shown again. At most imageTextureUploadsPerFrame such uploads happen per frame, so that
+// many images becoming visible at once are streamed in over several frames rather than stalling one.
+// (defaults: false, 4)
+extern bool imageTexturePaging;
+extern int imageTextureUploadsPerFrame;
+
+// If true, the expensive CPU-side preparation of large structures (e.g. triangulating a big surface mesh) runs on a
+// worker thread after registration, rather than blocking the caller. Such structures show as loading in the UI, and
+// are not drawn until they are ready. Anything which needs the data before then waits for it. (default: false)
+extern bool prepareStructuresInBackground;
+
+// If true, surface meshes registered afterwards reorder their triangles for the GPU's post-transform vertex cache, and
+// their vertices for fetch locality, when drawing. Helps meshes whose faces are stored in a poor order (from scanners,
+// marching cubes, ...). Indices passed to and from polyscope (quantities, picking, updateVertexPositions()) stay in the
+// user's order. Costs some time at registration, and a reordered copy of per-vertex data on the GPU. (default: false)
+extern bool optimizeMeshDrawOrder;
+
+// If true, point clouds registered afterwards are drawn in a spatial (Morton) order, see
+// PointCloud::setSpatialOrderEnabled(). (default: false)
+extern bool spatiallyOrderPointClouds;
+
+// Spheres and cylinders (points and edges of point clouds and curve networks, etc.) which are drawn smaller than this
+// many pixels across are rasterized as flat pixel-sized points and lines, rather than raycast impostors. They look the
+// same at that size, and are much cheaper to draw in zoomed-out views of large datasets. Set to 0 to always raycast.
+// (default: 1)
+extern float impostorFallbackPixelSize;
+
+// If true, and there are many camera views, the widgets of all the camera views which are drawn the same way (opaque,
+// not static, and not ignoring slice planes) are drawn together in a few instanced draws, rather than a few draws
+// each. Their image quantities are still drawn by each camera view. (default: true)
+extern bool batchCameraViews;
+
+// If non-empty, an existing directory where linked shader programs are stored, so later runs can load them instead of
+// compiling. Entries are specific to the GPU and driver which created them, and are ignored otherwise. Only supported
+// by the OpenGL backend, when the driver supports program binaries. (default: "", no cache)
+extern std::string shaderCacheDirectory;
+
 // === Advanced ImGui configuration
 
 // If false, Polyscope will not create any ImGui UIs at all, but will still set up ImGui and invoke its render steps
@@ -106,5 +267,9 @@ extern bool enableRenderErrorChecks;
 // Render the pick buffer to screen rather than the regular scene
 extern bool debugDrawPickBuffer;
 
+// Record CPU and GPU timings for the stages of each frame, see profiling.h. Also on while dynamicResolution is.
+// (default: false)
+extern bool enableProfiling;
+
 } // namespace options
 } // namespace polyscope
@@ -0,0 +1,61 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace polyscope {
+
+// All of Polyscope's CPU-side parallel work runs on one shared pool of worker threads, created on first use and sized
+// by options::maxWorkerThreads (the calling thread counts as one of them). Idle threads steal queued tasks from the
+// others, and a thread waiting on parallel work runs queued tasks in the meantime, so parallel work may be nested
+// (e.g. a parallelFor() inside a TaskGroup task) without deadlocking or starting more threads.
+
+// Call func(blockStart, blockEnd) on disjoint blocks which together cover [start, end), spreading the blocks across
+// up to options::maxWorkerThreads threads. Ranges with fewer than minBlockSize entries per thread use fewer threads,
+// down to running serially on the calling thread. Returns once all blocks are done.
+//
+// func must be safe to call concurrently on disjoint blocks, and should only touch the data for its own block. If it
+// throws, the first exception is rethrown on the calling thread after all blocks have finished. Don't call
+// polyscope::exception() or other UI-facing functions from func; validate inputs before the parallel loop instead.
+void parallelFor(size_t start, size_t end, const std::function<void(size_t, size_t)>& func,
+                 size_t minBlockSize = 16384);
+
+// A set of independent tasks which may run concurrently. wait() returns once all of the tasks which were run() have
+// finished, rethrowing the first exception any of them threw; the destructor waits too (but swallows exceptions).
+// The same rules as for parallelFor() apply to the tasks.
+class TaskGroup {
+public:
+  TaskGroup();
+  ~TaskGroup();
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  void run(std::function<void()> task);
+  void wait();
+
+  struct State;
+
+private:
+  std::shared_ptr<State> state;
+};
+
+// The number of threads which parallel work is spread across, from options::maxWorkerThreads
+size_t workerThreadCount();
+
+// Hand Polyscope's parallel work to the application's own scheduler (e.g. TBB or OpenMP) instead of the internal
+// pool, so the two do not compete for cores. The backend must call job(i) for every i in [0, nJobs), possibly
+// concurrently, and return once all have finished; job() does not throw. For instance, with TBB:
+//
+//   polyscope::setParallelBackend([](size_t nJobs, const std::function<void(size_t)>& job) {
+//     tbb::parallel_for(size_t(0), nJobs, job);
+//   });
+//
+// Tasks of a TaskGroup are collected and handed over together when it waits. Pass an empty function to return to
+// the internal pool. Set the backend while no parallel work is running.
+using ParallelBackend = std::function<void(size_t nJobs, const std::function<void(size_t)>& job)>;
+void setParallelBackend(ParallelBackend backend);
+
+} // namespace polyscope
@@ -71,6 +71,7 @@ public:
 protected:
   // Raw storage for the data. You should only interact with this via the managed buffer above
   std::vector<glm::vec2> coordsData;
+  uint64_t coordsRevision = 0; // bumped by updateCoords(), for caches derived from the coordinates
 
   // === Visualization parameters
 
@@ -180,6 +180,7 @@ void ParameterizationQuantity<QuantityT>::setParameterizationUniforms(render::Sh
   case ParamVizStyle::LOCAL_RAD:
     p.setUniform("u_angle", localRot);
     p.setUniform("u_modDarkness", getAltDarkness());
+    p.setTextureFromColormap("t_colormap", cMap.get(), true); // no-op unless the colormap changed
     break;
   }
 }
@@ -190,6 +191,7 @@ void ParameterizationQuantity<QuantityT>::updateCoords(const V& newCoords) {
   validateSize(newCoords, coords.size(), "parameterization quantity " + quantity.name);
   coords.data = standardizeVectorArray<glm::vec2, 2>(newCoords);
   coords.markHostBufferUpdated();
+  coordsRevision++;
 }
 
 
@@ -247,7 +249,6 @@ double ParameterizationQuantity<QuantityT>::getCheckerSize() {
 template <typename QuantityT>
 QuantityT* ParameterizationQuantity<QuantityT>::setColorMap(std::string name) {
   cMap = name;
-  quantity.refresh();
   requestRedraw();
   return &quantity;
 }
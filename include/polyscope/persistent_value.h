@@ -10,9 +10,11 @@
 #include "polyscope/render/color_maps.h"
 #include "polyscope/render/materials.h"
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace polyscope {
 
@@ -25,14 +27,107 @@ namespace polyscope {
 
 // Note that PersistentValue<T> can only be instantiated if T is one of the types for which the global table is declared
 // below and instantiated in persistent_value.cpp.
+//
+// Entries which no live variable holds are still remembered, but not forever: those belonging to a removed structure
+// are dropped along with it (see options::retainRemovedStructureSettings), and beyond
+// options::maxRetainedPersistentValues the least recently released ones are evicted. Names under a pinned prefix are
+// exempt from both.
+
+// Keep the cached values of all names beginning with the prefix (such as a structure's uniquePrefix()), even after the
+// variables holding them are gone.
+void pinPersistentValues(const std::string& namePrefix);
+void unpinPersistentValues(const std::string& namePrefix);
 
 
 namespace detail {
-// Simple wrapper class holding the cache for persistent values
+
+// The names of persistent values are interned once, to a small integer key shared by the caches of all types. After
+// construction, a value reads and writes its cache entry directly, without hashing or comparing strings. Keys of names
+// which are dropped (see dropPersistentValues()) are reused for new names.
+typedef uint32_t PersistentKey;
+const PersistentKey INVALID_PERSISTENT_KEY = static_cast<PersistentKey>(-1);
+PersistentKey internPersistentName(const std::string& name);
+const std::string& persistentName(PersistentKey key);
+
+// Reserve space for this many more names, ahead of registering a large number of structures or quantities
+void reservePersistentNames(size_t count);
+
+// Track the live variables using each name. A name which none use is queued for eviction (unless pinned).
+void acquirePersistentName(PersistentKey key);
+void releasePersistentName(PersistentKey key);
+
+// Drop the entries (of all types) of the names beginning with the prefix which no live variable uses, unless pinned
+void dropPersistentValues(const std::string& namePrefix);
+
+// The number of names which no live variable uses, but which are kept for their cached values
+size_t retainedPersistentNameCount();
+
+// Type-erased access to the caches, to drop entries from all of them
+class PersistentCacheBase {
+public:
+  PersistentCacheBase();
+  virtual ~PersistentCacheBase();
+  virtual void erase(PersistentKey key) = 0;
+};
+
+// The cache for persistent values of one type. Entries are stored in a flat list, and each persistent value remembers
+// the index of its entry. The slots of erased entries are marked with INVALID_PERSISTENT_KEY and reused, so the indices
+// of the others never change.
 template <typename T>
-class PersistentCache {
+class PersistentCache : public PersistentCacheBase {
 public:
-  std::unordered_map<std::string, T> cache;
+  // Index of the entry for the key, or -1 if there is none
+  int64_t find(PersistentKey key) const {
+    auto it = entryInds.find(key);
+    if (it == entryInds.end()) return -1;
+    return it->second;
+  }
+
+  // Index of the entry for the key, adding one holding the value if there is none
+  size_t findOrInsert(PersistentKey key, const T& value) {
+    auto it = entryInds.find(key);
+    if (it != entryInds.end()) return it->second;
+    size_t ind;
+    if (freeSlots.empty()) {
+      ind = values.size();
+      keys.push_back(key);
+      values.push_back(value);
+    } else {
+      ind = freeSlots.back();
+      freeSlots.pop_back();
+      keys[ind] = key;
+      values[ind] = value;
+    }
+    entryInds[key] = ind;
+    return ind;
+  }
+
+  void set(PersistentKey key, const T& value) { values[findOrInsert(key, value)] = value; }
+  void set(const std::string& name, const T& value) { set(internPersistentName(name), value); }
+
+  virtual void erase(PersistentKey key) override {
+    auto it = entryInds.find(key);
+    if (it == entryInds.end()) return;
+    keys[it->second] = INVALID_PERSISTENT_KEY;
+    values[it->second] = T();
+    freeSlots.push_back(it->second);
+    entryInds.erase(it);
+  }
+
+  size_t size() const { return entryInds.size(); }
+  void reserve(size_t count) {
+    entryInds.reserve(entryInds.size() + count);
+    keys.reserve(values.size() + count);
+    values.reserve(values.size() + count);
+  }
+
+  // Parallel lists of the cached entries; slots whose key is INVALID_PERSISTENT_KEY are unused
+  std::vector<PersistentKey> keys;
+  std::vector<T> values;
+
+private:
+  std::unordered_map<PersistentKey, size_t> entryInds;
+  std::vector<size_t> freeSlots;
 };
 // Helper to get the global cache for a particular type of persistent value
 template <typename T>
@@ -43,18 +138,29 @@ template <typename T>
 class PersistentValue {
 public:
   // Basic constructor, used on initial creation
-  PersistentValue(const std::string& name_, T value_) : name(name_), value(value_) {
-    if (detail::getPersistentCacheRef<T>().cache.find(name) != detail::getPersistentCacheRef<T>().cache.end()) {
-      value = detail::getPersistentCacheRef<T>().cache[name];
+  PersistentValue(const std::string& name_, T value_)
+      : PersistentValue(detail::internPersistentName(name_), std::move(value_)) {}
+
+  // Construct from a name which has already been interned, skipping the string lookup
+  PersistentValue(detail::PersistentKey key_, T value_) : key(key_), value(std::move(value_)) {
+    detail::acquirePersistentName(key);
+    detail::PersistentCache<T>& cache = detail::getPersistentCacheRef<T>();
+    int64_t existing = cache.find(key);
+    if (existing >= 0) {
+      value = cache.values[existing];
+      entryInd = existing;
       holdsDefaultValue = false;
     } else {
       // Update cache value
-      detail::getPersistentCacheRef<T>().cache[name] = value;
+      entryInd = cache.findOrInsert(key, value);
     }
   }
 
   // Ensure in cache on deletion (see not above reference conversion)
-  ~PersistentValue() { set(value); }
+  ~PersistentValue() {
+    set(value);
+    detail::releasePersistentName(key);
+  }
 
   // Don't want copy or move constructors, only operators
   PersistentValue(const PersistentValue&) = delete;
@@ -90,7 +196,7 @@ public:
   // Explicit setter, which takes care of storing in cache
   void set(T value_) {
     value = value_;
-    detail::getPersistentCacheRef<T>().cache[name] = value;
+    detail::getPersistentCacheRef<T>().values[entryInd] = value;
     holdsDefaultValue = false;
   }
 
@@ -99,16 +205,19 @@ public:
   void setPassive(T value_) {
     if (holdsDefaultValue) {
       value = value_;
-      detail::getPersistentCacheRef<T>().cache[name] = value;
+      detail::getPersistentCacheRef<T>().values[entryInd] = value;
     }
   }
 
+  const std::string& getName() const { return detail::persistentName(key); }
+
   // Make all template variants friends, so conversion can access private members
   template <typename>
   friend class PersistentValue;
 
 private:
-  const std::string name;
+  const detail::PersistentKey key;
+  size_t entryInd; // index of this value's entry in the cache
   T value;
   bool holdsDefaultValue = true; // True if the value was set on construction and never changed. False if it was pulled
                                  // from cache or has ever been explicitly set
@@ -5,7 +5,10 @@
 #include "polyscope/structure.h"
 
 #include <cstdint>
+#include <functional>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace polyscope {
 namespace pick {
@@ -13,15 +16,43 @@ namespace pick {
 
 // == Set up picking
 // Called by a structure to figure out what data it should render to the pick buffer.
-// Request 'count' contiguous indices for drawing a pick buffer. The return value is the start of the range.
+// Request 'count' contiguous indices for drawing a pick buffer. The return value is the start of the range. Each
+// structure has one range; requesting again replaces it (keeping the same start, if the old range is big enough).
+// Released ranges are reused, lowest first. Indices are 64-bit, and are packed in to pick colors exactly (see
+// indToVec()).
 size_t requestPickBufferRange(Structure* requestingStructure, size_t count);
 
+// Mark the cached pick buffer as stale, so it will be re-rendered on the next query. This gets called automatically by
+// requestRedraw(), so it generally only needs to be called directly if the pick render changes without a redraw.
+void invalidatePickBuffer();
+
+// Render the pick buffer for the current view, if the cached contents are stale. Returns false if the buffer could not
+// be rendered. The queries below call this as needed.
+bool renderPickBuffer();
+
+// Forget the range allocated to a structure, so pick queries can no longer resolve to it and its indices can be given
+// to another structure (used when it is removed)
+void releasePickBufferRange(Structure* s);
+
 
 // == Main query
 // Get the structure which was clicked on (nullptr if none), and the pick ID in local indices for that structure (such
 // that 0 is the first index as returned from requestPickBufferRange())
 std::pair<Structure*, size_t> evaluatePickQuery(int xPos, int yPos);
 
+// Same as above, but the pick buffer is read back asynchronously to avoid stalling the pipeline. The callback is
+// invoked with the result once it is available, typically during the next frame.
+void evaluatePickQueryAsync(int xPos, int yPos, std::function<void(std::pair<Structure*, size_t>)> callback);
+
+// Get every element visible inside the screen-space rectangle with corners (xStart, yStart) and (xEnd, yEnd), inclusive.
+// The pick buffer is rendered (at most) once and the whole region is read back in one pass. The result maps each
+// structure appearing in the region to the sorted list of its local pick indices.
+std::unordered_map<Structure*, std::vector<size_t>> evaluatePickRegionQuery(int xStart, int yStart, int xEnd, int yEnd);
+
+// Intersect a world-space ray (e.g. from view::screenCoordsToWorldRay()) with all enabled structures on the CPU, via
+// Structure::rayPick(). Does not use the render engine. Returns the closest hit, with a null structure if none.
+std::pair<Structure*, RayPickResult> evaluateRayPickQuery(glm::vec3 rayStart, glm::vec3 rayDir);
+
 
 // == Stateful picking: track and update a current selection
 
@@ -45,6 +76,10 @@ size_t localIndexToGlobal(std::pair<Structure*, size_t> localPick);
 inline glm::vec3 indToVec(uint64_t globalInd);
 inline uint64_t vecToInd(glm::vec3 vec);
 
+// The three integer digits which indToVec() packs in to the channels. Shaders which compute pick colors themselves
+// take the start of their range in this form (as a `u_pickStart` uniform), and offset it by element index.
+inline glm::uvec3 indToDigits(uint64_t globalInd);
+
 } // namespace pick
 } // namespace polyscope
 
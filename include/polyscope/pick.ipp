@@ -27,6 +27,13 @@ inline glm::vec3 indToVec(size_t globalInd) {
   return glm::vec3{static_cast<double>(low) / factorF, static_cast<double>(med) / factorF,
                    static_cast<double>(high) / factorF};
 }
+inline glm::uvec3 indToDigits(uint64_t globalInd) {
+  uint64_t mask = (1 << bitsForPickPacking) - 1;
+  return glm::uvec3{static_cast<uint32_t>(globalInd & mask),
+                    static_cast<uint32_t>((globalInd >> bitsForPickPacking) & mask),
+                    static_cast<uint32_t>(globalInd >> (2 * bitsForPickPacking))};
+}
+
 inline uint64_t vecToInd(glm::vec3 vec) {
 
   uint64_t factor = 1 << bitsForPickPacking;
@@ -0,0 +1,32 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace polyscope {
+
+class PointCloud;
+class SurfaceMesh;
+
+// Out-of-core loading of PLY files (ascii or binary). The file is read on a background thread in fixed-size chunks,
+// straight in to the structure's own buffers, so peak memory is the structure itself plus one chunk rather than a
+// whole in-memory copy of the file. Results are handed to the main thread through postToMainThread(), so loading only
+// makes progress while the main loop runs (or processPostedUpdates() is called). The header is read immediately, and
+// a malformed header is an error; errors later in the file stop the load with a warning.
+
+// Register a point cloud from the vertex positions of a PLY file. It is registered right away with all of its points,
+// but only the points read so far are valid (see PointCloud::getValidPointCount()), so the cloud fills in on screen as
+// it loads. Each chunk of chunkSize points is uploaded to the GPU as it arrives. Removing the point cloud cancels the
+// load.
+PointCloud* registerPointCloudPLYStreaming(std::string name, std::string filename, size_t chunkSize = 1 << 18);
+
+// Register a surface mesh from the vertices and faces of a PLY file. Faces may refer to any vertex, so a partial mesh
+// cannot be drawn; instead the mesh is registered once the whole file has been read, and then passed to onLoaded (if
+// given).
+void registerSurfaceMeshPLYStreaming(std::string name, std::string filename,
+                                     std::function<void(SurfaceMesh*)> onLoaded = nullptr);
+
+} // namespace polyscope
@@ -14,10 +14,13 @@
 #include "polyscope/structure.h"
 
 #include "polyscope/point_cloud_color_quantity.h"
+#include "polyscope/point_cloud_label_quantity.h"
 #include "polyscope/point_cloud_parameterization_quantity.h"
 #include "polyscope/point_cloud_scalar_quantity.h"
 #include "polyscope/point_cloud_vector_quantity.h"
 
+#include <algorithm>
+#include <map>
 #include <vector>
 
 namespace polyscope {
@@ -27,7 +30,9 @@ class PointCloud;
 
 // Forward declare quantity types
 class PointCloudColorQuantity;
+class PointCloudLabelQuantity;
 class PointCloudScalarQuantity;
+class PointCloudTimeSeriesScalarQuantity;
 class PointCloudParameterizationQuantity;
 class PointCloudVectorQuantity;
 
@@ -56,17 +61,33 @@ public:
   virtual void drawDelayed() override;
   virtual void drawPick() override;
   virtual void updateObjectSpaceBounds() override;
+  virtual bool hasExtents() override;
   virtual std::string typeName() override;
+  virtual std::string drawSortKey() override; // the material
   virtual void refresh() override;
+  virtual RayPickResult rayPick(glm::vec3 rayStart, glm::vec3 rayDir) override; // elementInd is the point index
+  virtual size_t nSubsetElements() override; // the points
 
   // === Geometry members
   render::ManagedBuffer<glm::vec3> points;
 
   // === Quantities
+  //
+  // The adders standardize their inputs into a fresh copy. Passing an rvalue of the exact type stored instead (e.g.
+  // `addScalarQuantity("x", std::move(values))` with a std::vector<float>) moves it in without copying.
 
   // Scalars
   template <class T>
   PointCloudScalarQuantity* addScalarQuantity(std::string name, const T& values, DataType type = DataType::STANDARD);
+  PointCloudScalarQuantity* addScalarQuantity(std::string name, std::vector<float>&& values,
+                                              DataType type = DataType::STANDARD);
+
+  // A scalar per point for each of a sequence of frames, e.g. the timesteps of a simulation, with a timeline to step
+  // through them (see PointCloudTimeSeriesScalarQuantity). Storing the frames at half precision halves their memory.
+  template <class T>
+  PointCloudTimeSeriesScalarQuantity* addTimeSeriesScalarQuantity(std::string name, const std::vector<T>& frames,
+                                                                  DataType type = DataType::STANDARD,
+                                                                  bool halfPrecision = false);
 
   // Parameterization
   template <class T>
@@ -79,11 +100,24 @@ public:
   // Colors
   template <class T>
   PointCloudColorQuantity* addColorQuantity(std::string name, const T& values);
+  PointCloudColorQuantity* addColorQuantity(std::string name, std::vector<glm::vec3>&& values);
+
+  // Colors stored as 4 bytes per point rather than 3 floats, each an RGBA8 value as from packColorRGBA8() (red in the
+  // low byte, alpha ignored). Uses a third of the memory and bandwidth, for large colored scans.
+  template <class T>
+  PointCloudColorQuantity* addPackedColorQuantity(std::string name, const T& packedValues);
+
+  // Integer labels, e.g. a segmentation, each drawn in its own color and individually hideable (see
+  // PointCloudLabelQuantity)
+  template <class T>
+  PointCloudLabelQuantity* addLabelQuantity(std::string name, const T& labels);
 
   // Vectors
   template <class T>
   PointCloudVectorQuantity* addVectorQuantity(std::string name, const T& vectors,
                                               VectorType vectorType = VectorType::STANDARD);
+  PointCloudVectorQuantity* addVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                              VectorType vectorType = VectorType::STANDARD);
   template <class T>
   PointCloudVectorQuantity* addVectorQuantity2D(std::string name, const T& vectors,
                                                 VectorType vectorType = VectorType::STANDARD);
@@ -91,9 +125,33 @@ public:
   // === Mutate
   template <class V>
   void updatePointPositions(const V& newPositions);
+  void updatePointPositions(std::vector<glm::vec3>&& newPositions); // moves the positions in, without copying
   template <class V>
   void updatePointPositions2D(const V& newPositions);
 
+  // Add points to the end of the cloud. Only the new points are uploaded, and render buffers grow geometrically, so
+  // appending repeatedly (e.g. every frame) is amortized O(new points). The bounds grow to fit the new points, with the
+  // length scale approximated by the diagonal of the bounding box. Past getMaxPointCount(), the oldest points are
+  // overwritten instead. Per-point quantities must be extended to match before the next draw, either by passing their
+  // values to the second version, or with appendPointValues(), or removed.
+  template <class V>
+  void appendPoints(const V& newPoints);
+  // Also append values to per-point scalar and color quantities, by quantity name
+  template <class V>
+  void appendPoints(const V& newPoints, const std::map<std::string, std::vector<float>>& scalarValues,
+                    const std::map<std::string, std::vector<glm::vec3>>& colorValues = {});
+
+  // Write a per-point buffer's values for the points added by the most recent appendPoints(), to the same slots (e.g.
+  // `cloud->appendPointValues(q->values, newValues)`).
+  template <typename T>
+  void appendPointValues(render::ManagedBuffer<T>& buffer, const std::vector<T>& newValues);
+
+  // Keep at most this many points. Once the cloud is full, appendPoints() overwrites the oldest points in place, like
+  // a ring buffer, so e.g. a live sensor feed can be shown over a sliding window. The bounds only ever grow. Must be at
+  // least nPoints(). (default: no limit)
+  void setMaxPointCount(size_t n);
+  size_t getMaxPointCount();
+
   // === Set point size from a scalar quantity
   // effect is multiplicative with pointRadius
   // negative values are always clamped to 0
@@ -102,6 +160,15 @@ public:
   void setPointRadiusQuantity(std::string name, bool autoScale = true);
   void clearPointRadiusQuantity();
 
+  // === Threshold the points by a scalar quantity
+  // points whose value is outside [low, high] are discarded in the shaders, for drawing and picking alike, so changing
+  // the range only sets uniforms and stays interactive for any number of points
+  void setThresholdQuantity(PointCloudScalarQuantity* quantity, double low, double high);
+  void setThresholdQuantity(std::string name, double low, double high);
+  void setThresholdRange(double low, double high);
+  std::pair<double, double> getThresholdRange();
+  void clearThresholdQuantity();
+
   // The points that make up this point cloud
   // Normally, the values are stored here. But if the render buffer
   // is being manually updated, they will live only in the render buffer
@@ -133,9 +200,62 @@ public:
   PointCloud* setMaterial(std::string name);
   std::string getMaterial();
 
+  // Draw each point as an instance of a two-triangle quad, rather than expanding points to quads in a geometry shader.
+  // Looks the same; geometry shaders are slow on some hardware, so this can be much faster for very large clouds.
+  // (default: false)
+  PointCloud* setInstancedDrawing(bool newVal);
+  bool getInstancedDrawing();
+
+  // Draw the depth of the spheres in a pass of their own before shading them, so that the (costly) ray intersection
+  // and lighting only run once per pixel rather than for every overlapping sphere. Helps dense clouds with much
+  // overdraw; has no effect in quad mode or with transparency. (default: false)
+  PointCloud* setDepthPrepass(bool newVal);
+  bool getDepthPrepass();
+
+  // Level of detail. If enabled, the points are drawn in a stratified order (coarse to fine over the bounding box,
+  // random within each level), and only enough of them are drawn to give about `pointsPerPixel` points per pixel of
+  // the cloud's footprint on the screen. While the camera moves a coarser subset is drawn, which is refined over the
+  // following frames once the camera stops. Quantities and picking are drawn through the same order. The order is
+  // built when LOD is first enabled. (default: disabled)
+  PointCloud* setLODEnabled(bool newVal);
+  bool getLODEnabled();
+  PointCloud* setLODPointsPerPixel(float newVal);
+  float getLODPointsPerPixel();
+  size_t getLODDrawCount(); // number of points drawn in the most recent frame (all points if LOD is disabled)
+
+  // Spatial draw order. If enabled, the points are drawn in Morton (Z-curve) order over the bounding box rather than in
+  // the order they were given, so that consecutive points are near each other, both on the screen and in the GPU-side
+  // copies of their data. Point indices, quantities (added or updated) and picking stay in the given order. The order
+  // is built from the positions when first needed, and kept as they are updated. It is not used with LOD (which has
+  // its own order), while points are loading, or once the cloud has been appended to.
+  // (default: options::spatiallyOrderPointClouds when the cloud is registered)
+  PointCloud* setSpatialOrderEnabled(bool newVal);
+  bool getSpatialOrderEnabled();
+
+  // Incremental loading, for point clouds whose positions are filled in over time (e.g. by
+  // registerPointCloudPLYStreaming()). Only the first getValidPointCount() points are drawn, picked, and counted in the
+  // bounds; LOD is ignored until all points are valid. After writing more of points.data, call setValidPointCount() to
+  // upload just the new range. (default: all points are valid)
+  void setValidPointCount(size_t n);
+  size_t getValidPointCount();
+
+  // With TransparencyMode::Sorted, a transparent point cloud is drawn back to front in a single pass, its points sorted
+  // by view depth once per frame: on the device where the backend supports it (see Engine::sortPointsByDepth()), and
+  // otherwise on the host, where the previous order is kept if it is still sorted (e.g. after a small camera move). Not
+  // used with instanced drawing. The order of the most recent frame, as indices into the drawn points (which are in
+  // the LOD or spatial order, if one is used), or empty if it is not depth sorted:
+  std::vector<uint32_t> getDepthSortOrder();
+
+  // Keeps a background loader which is filling in the points alive for as long as the point cloud; destroying it
+  // cancels the load
+  std::shared_ptr<void> backgroundLoader;
+
   // Rendering helpers used by quantities
-  void setPointCloudUniforms(render::ShaderProgram& p);
+  void setPointCloudUniforms(render::ShaderProgram& p); // also applies the LOD draw range
+  void setPointCloudUniforms(render::ShaderProgram& p, render::UniformHandle pointRadiusHandle);
   void setPointProgramGeometryAttributes(render::ShaderProgram& p);
+  template <typename T> // per-point data to draw, in the LOD or spatial order if one is used
+  std::shared_ptr<render::AttributeBuffer> getPointAttributeBuffer(render::ManagedBuffer<T>& buffer);
   std::vector<std::string> addPointCloudRules(std::vector<std::string> initRules, bool withPointCloud = true);
   std::string getShaderNameForRenderMode();
 
@@ -151,11 +271,77 @@ private:
   PersistentValue<glm::vec3> pointColor;
   PersistentValue<ScaledValue<float>> pointRadius;
   PersistentValue<std::string> material;
+  PersistentValue<bool> lodEnabled;
+  PersistentValue<float> lodPointsPerPixel;
+  PersistentValue<bool> instancedDrawing;
+  PersistentValue<bool> depthPrepass;
+  PersistentValue<bool> spatialOrderEnabled;
 
   // Drawing related things
   // if nullptr, prepare() (resp. preparePick()) needs to be called
   std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::ShaderProgram> pickProgram;
+  render::UniformHandle programPointRadius; // resolved along with program, used on every draw
+  render::UniformHandle programBaseColor;
+  void refreshPrograms(); // drop all programs (including quantities'), but keep the ray pick BVH and LOD state
+
+  // CPU ray picking acceleration, built lazily and cleared when the geometry changes
+  BVH rayPickBVH;
+  float rayPickBVHRadius = -1.; // object-space point radius which the BVH bounds were built with
+
+  // Level of detail: a permutation of the points such that every prefix is a well spread subset, and the length of the
+  // prefix which is currently drawn
+  std::vector<uint32_t> lodOrderData;
+  render::ManagedBuffer<uint32_t> lodOrder;
+  size_t lodDrawCount = 0;
+  size_t validPointCount = INVALID_IND; // INVALID_IND means all
+  uint64_t lodLastUpdate = INVALID_IND_64; // value of internal::renderSceneCount when lodDrawCount was last updated
+  glm::mat4 lodLastViewProjMat{0.f};       // camera when lodDrawCount was last updated
+  void ensureHaveLODOrder();
+  void updateLODDrawCount();
+
+  // Whether draw() lays down the sphere depth first, see setDepthPrepass()
+  bool usesDepthPrepass();
+
+  // Spatial order, a permutation of the points sorted by Morton code
+  std::vector<uint32_t> spatialOrderData;
+  render::ManagedBuffer<uint32_t> spatialOrder;
+  bool usesSpatialOrder();
+  void ensureHaveSpatialOrder();
+
+  // The permutation which the points are drawn through (building it if needed), or null to draw them in order
+  render::ManagedBuffer<uint32_t>* ensureDrawOrder();
+  size_t drawnPointCount(); // the prefix of the drawn points which is drawn, while loading or with LOD
+
+  // Depth sorted drawing (see getDepthSortOrder()). The programs index the drawn points through depthOrder.
+  std::vector<uint32_t> depthOrderData;
+  render::ManagedBuffer<uint32_t> depthOrder;
+  bool programsDepthSorted = false;
+  uint64_t depthOrderLastUpdate = INVALID_IND_64; // value of internal::renderSceneCount when last sorted
+  bool usesDepthSort();
+  void updateDepthOrder();
+
+  void growObjectSpaceBounds(const glm::vec3* pos, size_t count); // grow the bounding box to fit these points
+
+  // Appending (see appendPoints()). The values of the most recent append go to slots [oldSize, oldSize + nGrow) at the
+  // end of the buffers, then the rest (skipping the first `skip`, which would be overwritten anyway) overwrite the
+  // oldest points, starting at slot overwriteStart and wrapping around.
+  struct AppendLayout {
+    size_t oldSize = INVALID_IND;
+    size_t count = 0;
+    size_t skip = 0;
+    size_t nGrow = 0;
+    size_t overwriteStart = 0;
+  };
+  AppendLayout lastAppend;
+  size_t maxPointCount = INVALID_IND; // INVALID_IND means no limit
+  size_t ringHead = 0;                // slot of the oldest point, once the cloud is full
+  size_t pickRangeCount = 0;          // points the pick range has space for, with headroom once appended to
+  bool appendedTo = false;
+  void appendPointsImpl(const std::vector<glm::vec3>& newPoints);
+  void appendPointsImpl(const std::vector<glm::vec3>& newPoints,
+                        const std::map<std::string, std::vector<float>>& scalarValues,
+                        const std::map<std::string, std::vector<glm::vec3>>& colorValues);
 
   // === Helpers
   // Do setup work related to drawing, including allocating openGL data
@@ -163,13 +349,19 @@ private:
   void ensurePickProgramPrepared();
 
   // === Quantity adder implementations
-  PointCloudScalarQuantity* addScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
+  PointCloudScalarQuantity* addScalarQuantityImpl(std::string name, std::vector<float> data, DataType type);
+  PointCloudTimeSeriesScalarQuantity* addTimeSeriesScalarQuantityImpl(std::string name,
+                                                                      const std::vector<float>& frameValues,
+                                                                      size_t nFrames, DataType type,
+                                                                      bool halfPrecision);
   PointCloudParameterizationQuantity*
   addParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& param, ParamCoordsType type);
   PointCloudParameterizationQuantity*
   addLocalParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& param, ParamCoordsType type);
-  PointCloudColorQuantity* addColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
-  PointCloudVectorQuantity* addVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors,
+  PointCloudColorQuantity* addColorQuantityImpl(std::string name, std::vector<glm::vec3> colors);
+  PointCloudColorQuantity* addPackedColorQuantityImpl(std::string name, std::vector<uint32_t> packedColors);
+  PointCloudLabelQuantity* addLabelQuantityImpl(std::string name, const std::vector<uint32_t>& labels);
+  PointCloudVectorQuantity* addVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors,
                                                   VectorType vectorType);
 
   // Manage varying point size
@@ -177,15 +369,27 @@ private:
   std::string pointRadiusQuantityName = ""; // empty string means none
   bool pointRadiusQuantityAutoscale = true;
   PointCloudScalarQuantity& resolvePointRadiusQuantity(); // helper
+
+  // Threshold filtering, see setThresholdQuantity()
+  std::string thresholdQuantityName = ""; // empty string means none
+  std::pair<double, double> thresholdRange{0., 1.};
+  PointCloudScalarQuantity& resolveThresholdQuantity(); // helper
 };
 
 
 // Shorthand to add a point cloud to polyscope
 template <class T>
 PointCloud* registerPointCloud(std::string name, const T& points);
+PointCloud* registerPointCloud(std::string name, std::vector<glm::vec3>&& points); // moves the points in
 template <class T>
 PointCloud* registerPointCloud2D(std::string name, const T& points);
 
+// Add a point cloud which references nPoints positions in user-owned memory directly, rather than copying them. The
+// memory must remain valid and unchanged while the point cloud uses it (pass an `owner` to keep it alive). After
+// modifying it in-place, call `points.markHostBufferUpdated()` on the point cloud.
+PointCloud* registerPointCloud(std::string name, const glm::vec3* points, size_t nPoints,
+                               std::shared_ptr<const void> owner = nullptr);
+
 // Shorthand to get a point cloud from polyscope
 inline PointCloud* getPointCloud(std::string name = "");
 inline bool hasPointCloud(std::string name = "");
@@ -25,7 +25,7 @@ PointCloud* registerPointCloud2D(std::string name, const T& points) {
   for (auto& v : points3D) {
     v.z = 0.;
   }
-  PointCloud* s = new PointCloud(name, points3D);
+  PointCloud* s = new PointCloud(name, std::move(points3D));
   bool success = registerStructure(s);
   if (!success) {
     safeDelete(s);
@@ -35,9 +35,53 @@ PointCloud* registerPointCloud2D(std::string name, const T& points) {
 
 template <class V>
 void PointCloud::updatePointPositions(const V& newPositions) {
-  validateSize(newPositions, nPoints(), "point cloud updated positions " + name);
-  points.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
-  points.markHostBufferUpdated();
+  updatePointPositions(standardizeVectorArray<glm::vec3, 3>(newPositions));
+}
+
+template <class V>
+void PointCloud::appendPoints(const V& newPoints) {
+  appendPointsImpl(standardizeVectorArray<glm::vec3, 3>(newPoints));
+}
+
+template <class V>
+void PointCloud::appendPoints(const V& newPoints, const std::map<std::string, std::vector<float>>& scalarValues,
+                              const std::map<std::string, std::vector<glm::vec3>>& colorValues) {
+  appendPointsImpl(standardizeVectorArray<glm::vec3, 3>(newPoints), scalarValues, colorValues);
+}
+
+template <typename T>
+void PointCloud::appendPointValues(render::ManagedBuffer<T>& buffer, const std::vector<T>& newValues) {
+  if (buffer.size() != lastAppend.oldSize || newValues.size() != lastAppend.count) {
+    exception("PointCloud [" + name + "] appendPointValues() to " + buffer.name + " must be given one value for each " +
+              "of the " + std::to_string(lastAppend.count) + " points of the most recent appendPoints(), once");
+  }
+
+  // First fill the empty slots at the end...
+  size_t iVal = lastAppend.skip;
+  if (lastAppend.nGrow > 0) {
+    buffer.appendData(std::vector<T>(newValues.begin() + iVal, newValues.begin() + iVal + lastAppend.nGrow));
+    iVal += lastAppend.nGrow;
+  }
+  if (iVal == newValues.size()) return;
+
+  // ...then overwrite the oldest values, in at most two ranges since the ring may wrap around. (The host data is
+  // fetched again for each range, since marking one updated may release it.)
+  size_t slot = lastAppend.overwriteStart;
+  while (iVal < newValues.size()) {
+    std::vector<T>& data = buffer.getPopulatedHostBufferRef();
+    size_t rangeCount = std::min(newValues.size() - iVal, data.size() - slot);
+    std::copy(newValues.begin() + iVal, newValues.begin() + iVal + rangeCount, data.begin() + slot);
+    buffer.markHostBufferRangeUpdated(slot, slot + rangeCount);
+    iVal += rangeCount;
+    slot = 0;
+  }
+}
+
+template <typename T>
+std::shared_ptr<render::AttributeBuffer> PointCloud::getPointAttributeBuffer(render::ManagedBuffer<T>& buffer) {
+  render::ManagedBuffer<uint32_t>* order = ensureDrawOrder();
+  if (order) return buffer.getIndexedRenderAttributeBuffer(*order);
+  return buffer.getRenderAttributeBuffer();
 }
 
 template <class V>
@@ -49,7 +93,7 @@ void PointCloud::updatePointPositions2D(const V& newPositions2D) {
   }
 
   // Call the main version
-  updatePointPositions(positions3D);
+  updatePointPositions(std::move(positions3D));
 }
 
 
@@ -74,10 +118,36 @@ PointCloudColorQuantity* PointCloud::addColorQuantity(std::string name, const T&
   return addColorQuantityImpl(name, standardizeVectorArray<glm::vec3, 3>(colors));
 }
 
+template <class T>
+PointCloudColorQuantity* PointCloud::addPackedColorQuantity(std::string name, const T& packedColors) {
+  validateSize(packedColors, nPoints(), "point cloud packed color quantity " + name);
+  return addPackedColorQuantityImpl(name, standardizeArray<uint32_t>(packedColors));
+}
+
+template <class T>
+PointCloudLabelQuantity* PointCloud::addLabelQuantity(std::string name, const T& labels) {
+  validateSize(labels, nPoints(), "point cloud label quantity " + name);
+  return addLabelQuantityImpl(name, standardizeArray<uint32_t, T>(labels));
+}
+
 template <class T>
 PointCloudScalarQuantity* PointCloud::addScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, nPoints(), "point cloud scalar quantity " + name);
-  return addScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
+}
+
+template <class T>
+PointCloudTimeSeriesScalarQuantity* PointCloud::addTimeSeriesScalarQuantity(std::string name,
+                                                                            const std::vector<T>& frames, DataType type,
+                                                                            bool halfPrecision) {
+  std::vector<float> frameValues;
+  frameValues.reserve(frames.size() * nPoints());
+  for (const T& frame : frames) {
+    validateSize(frame, nPoints(), "point cloud time series scalar quantity " + name);
+    std::vector<float> frameData = standardizeArray<float, T>(frame);
+    frameValues.insert(frameValues.end(), frameData.begin(), frameData.end());
+  }
+  return addTimeSeriesScalarQuantityImpl(name, frameValues, frames.size(), type, halfPrecision);
 }
 
 
@@ -109,7 +179,7 @@ PointCloudVectorQuantity* PointCloud::addVectorQuantity2D(std::string name, cons
     v.z = 0.;
   }
 
-  return addVectorQuantityImpl(name, vectors3D, vectorType);
+  return addVectorQuantityImpl(name, std::move(vectors3D), vectorType);
 }
 
 
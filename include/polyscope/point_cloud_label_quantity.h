@@ -0,0 +1,68 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/point_cloud.h"
+#include "polyscope/point_cloud_quantity.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/render/managed_buffer.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace polyscope {
+
+// An integer label per point, such as a segmentation. Each distinct label gets a color and a shown/hidden flag in a
+// small lookup table which lives on the GPU, so recoloring or hiding labels only rewrites entries of the table, never
+// the per-point data. The points store the index of their label among the distinct labels, so the labels themselves
+// may be sparse. (Hidden points are still pickable.)
+class PointCloudLabelQuantity : public PointCloudQuantity {
+public:
+  PointCloudLabelQuantity(std::string name, const std::vector<uint32_t>& labels, PointCloud& pointCloud_);
+
+  virtual void draw() override;
+  virtual void buildCustomUI() override;
+
+  virtual void buildPickUI(size_t ind) override;
+  virtual void refresh() override;
+  virtual void refreshMaterial() override;
+
+  virtual std::string niceName() override;
+
+  // === Members
+  render::ManagedBuffer<uint32_t> labelIndices; // for each point, the index of its label in getLabels()
+
+  // === Get/set
+
+  // The distinct labels, in increasing order, and how many points have each
+  const std::vector<uint32_t>& getLabels() const;
+  size_t getLabelCount(uint32_t label) const;
+  uint32_t getLabel(size_t pointInd);
+
+  PointCloudLabelQuantity* setLabelColor(uint32_t label, glm::vec3 color);
+  glm::vec3 getLabelColor(uint32_t label) const;
+
+  PointCloudLabelQuantity* setLabelVisible(uint32_t label, bool visible);
+  bool getLabelVisible(uint32_t label) const;
+  PointCloudLabelQuantity* setAllLabelsVisible(bool visible);
+
+  // The lookup table texture wraps to a new row after this many labels
+  static const uint32_t labelTableWidth = 1024;
+
+protected:
+  std::vector<uint32_t> labelIndicesData;
+  std::vector<uint32_t> labels;      // distinct, sorted
+  std::vector<size_t> labelCounts;   // points per label
+  std::vector<glm::vec4> labelTable; // color per label, with alpha 0 if hidden
+  size_t labelTableIndex(uint32_t label) const; // errors if the label is not present
+
+  void createProgram();
+  void ensureLabelTableTexture();
+  void updateLabelTableEntry(size_t iLabel);
+
+  std::shared_ptr<render::ShaderProgram> pointProgram;
+  std::shared_ptr<render::TextureBuffer> labelTableTexture;
+};
+
+
+} // namespace polyscope
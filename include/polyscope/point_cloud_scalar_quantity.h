@@ -15,7 +15,7 @@ namespace polyscope {
 class PointCloudScalarQuantity : public PointCloudQuantity, public ScalarQuantity<PointCloudScalarQuantity> {
 
 public:
-  PointCloudScalarQuantity(std::string name, const std::vector<double>& values, PointCloud& pointCloud_,
+  PointCloudScalarQuantity(std::string name, std::vector<float> values, PointCloud& pointCloud_,
                            DataType dataType);
 
   virtual void draw() override;
@@ -23,6 +23,7 @@ public:
 
   virtual void buildPickUI(size_t ind) override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
   virtual std::string niceName() override;
 
@@ -34,3 +35,6 @@ protected:
 
 
 } // namespace polyscope
+
+// (after the class above, since the time series quantity derives from it, whichever of the headers comes first)
+#include "polyscope/point_cloud_time_series_scalar_quantity.h"
@@ -0,0 +1,83 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/point_cloud_scalar_quantity.h"
+#include "polyscope/render/managed_buffer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace polyscope {
+
+// A scalar quantity with a value per point for each of a sequence of frames (e.g. the timesteps of a simulation), one
+// of which is shown at a time. All frames are kept on the host in one compact array, optionally at half precision. A
+// small ring of the frames is resident on the GPU: showing a resident frame only switches which buffer is drawn, and
+// after each draw one more frame near the current one is uploaded ahead of time, so scrubbing and playback rarely wait
+// on an upload. The colormap range covers all frames; the histogram shows the first frame.
+class PointCloudTimeSeriesScalarQuantity : public PointCloudScalarQuantity {
+
+public:
+  // `frameValues` holds nFrames * nPoints values, frame by frame
+  PointCloudTimeSeriesScalarQuantity(std::string name, const std::vector<float>& frameValues, size_t nFrames,
+                                     PointCloud& pointCloud_, DataType dataType, bool halfPrecision);
+
+  virtual void draw() override;
+  virtual void buildCustomUI() override;
+  virtual void buildPickUI(size_t ind) override;
+  virtual void refresh() override;
+
+  virtual std::string niceName() override;
+
+  // === Frames
+  size_t nFrames();
+  PointCloudTimeSeriesScalarQuantity* setFrame(size_t newFrame);
+  size_t getFrame();
+  std::vector<float> getFrameValues(size_t frame); // (at the stored precision)
+
+  // Play through the frames, looping at the end (default: false)
+  PointCloudTimeSeriesScalarQuantity* setPlaying(bool newVal);
+  bool isPlaying();
+  PointCloudTimeSeriesScalarQuantity* setPlaybackFPS(float newVal); // frames shown per second (default: 30)
+  float getPlaybackFPS();
+
+  // === GPU residency
+  // How many frames are kept on the GPU at once (default: 8)
+  PointCloudTimeSeriesScalarQuantity* setResidentFrameCount(size_t newVal);
+  size_t getResidentFrameCount();
+  bool isFrameResident(size_t frame);
+  uint64_t frameUploadCount = 0; // total frames uploaded so far
+
+protected:
+  const size_t nFramesStored;
+  const size_t frameSize;
+  std::vector<float> frameData;      // (if stored at full precision)
+  std::vector<uint16_t> frameData16; // (if stored at half precision, see glm::packHalf1x16())
+  size_t currentFrame = 0;
+
+  bool playing = false;
+  float playbackFPS = 30.;
+  std::chrono::steady_clock::time_point playStartTime;
+  size_t playStartFrame = 0;
+
+  // The resident frames. (the buffers refer to `data`, so the slots are not moved once created)
+  struct ResidentFrame {
+    size_t frame;
+    std::vector<float> data;
+    std::unique_ptr<render::ManagedBuffer<float>> buffer;
+  };
+  std::vector<std::unique_ptr<ResidentFrame>> residentFrames;
+  size_t residentFrameCount = 8;
+  render::ManagedBuffer<float>* drawnFrameBuffer = nullptr; // the frame the program is currently drawing
+
+  float frameValue(size_t frame, size_t ind);
+  size_t frameDistance(size_t frameA, size_t frameB); // (cyclic, since playback loops)
+  ResidentFrame* findResidentFrame(size_t frame);
+  ResidentFrame& ensureResident(size_t frame); // replaces the frame least likely to be needed soon, if needed
+  std::vector<size_t> prefetchOrder();         // frames to keep resident next to the current one, nearest first
+  void prefetchNextFrame();                    // upload one of them which is not resident yet
+};
+
+} // namespace polyscope
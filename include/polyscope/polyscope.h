@@ -10,15 +10,20 @@
 
 #include "imgui.h"
 
+#include "polyscope/frame_arena.h"
 #include "polyscope/group.h"
+#include "polyscope/insertion_ordered_map.h"
 #include "polyscope/internal.h"
 #include "polyscope/messages.h"
 #include "polyscope/options.h"
+#include "polyscope/recording.h"
+#include "polyscope/remote.h"
 #include "polyscope/screenshot.h"
 #include "polyscope/slice_plane.h"
 #include "polyscope/structure.h"
 #include "polyscope/transformation_gizmo.h"
 #include "polyscope/utilities.h"
+#include "polyscope/viewport.h"
 #include "polyscope/widget.h"
 
 
@@ -50,6 +55,25 @@ void show(size_t forFrames = std::numeric_limits<size_t>::max());
 // in the user program's loop.
 void frameTick();
 
+// Run the main loop on an internal render thread instead, and return immediately, so the application keeps its own
+// thread. The viewer behaves as in show() until the window is closed or stopAsync() is called. While it runs, the
+// Polyscope API (including state::userCallback) belongs to the render thread: other threads should only make changes
+// through postToMainThread(), which then runs them on the render thread. The graphics context moves to the render
+// thread, and back when it stops. Note that GLFW only supports windows on the process's main thread on some platforms
+// (notably macOS); headless backends have no such restriction.
+void showAsync();
+bool isShowingAsync();
+
+// Ask the render thread to exit after its current frame, wait until it has, and take the graphics context back. Also
+// call it after the window has been closed, before using Polyscope on this thread again. Called by shutdown().
+void stopAsync();
+
+// Frame sync for showAsync(), called from other threads. waitForNextFrame() blocks until a frame which began after the
+// call has been drawn, so everything posted before it is on screen. waitForPostedUpdates() blocks until everything
+// posted so far has run (without the async render thread, it runs them on the calling thread).
+void waitForNextFrame();
+void waitForPostedUpdates();
+
 // Do shutdown work and de-initialize Polyscope
 void shutdown();
 
@@ -62,8 +86,8 @@ extern bool initialized;
 // what backend was set on initialization
 extern std::string backend;
 
-// lists of all structures in Polyscope, by category
-extern std::map<std::string, std::map<std::string, std::shared_ptr<Structure>>> structures;
+// lists of all structures in Polyscope, by category, in the order they were registered
+extern InsertionOrderedMap<std::string, InsertionOrderedMap<std::string, std::shared_ptr<Structure>>> structures;
 
 // lists of all groups in Polyscope
 extern std::map<std::string, std::shared_ptr<Group>> groups;
@@ -77,6 +101,7 @@ extern std::tuple<glm::vec3, glm::vec3> boundingBox;
 // a list of widgets and other more specific doodads in the scene
 extern std::set<Widget*> widgets;
 extern std::vector<SlicePlane*> slicePlanes;
+extern std::vector<Viewport*> viewports;
 
 // should we allow default trackball mouse camera interaction?
 // Needs more interactions on when to turn this on/off
@@ -98,6 +123,10 @@ glm::vec3 center();
 // only using a single structure.
 Structure* getStructure(std::string type, std::string name = "");
 
+// Get a structure from the handle it was given when registered (see Structure::getHandle()), without any string
+// lookups. Returns nullptr if that structure has since been removed.
+Structure* getStructureByHandle(StructureHandle handle);
+
 // True if such a structure exists
 bool hasStructure(std::string type, std::string name = "");
 
@@ -138,6 +167,18 @@ void requestRedraw();
 // Has a redraw been requested for the next frame?
 bool redrawRequested();
 
+// Queue a function to run on the main thread at the start of the next main loop iteration (or the next call to
+// processPostedUpdates()). Unlike the rest of the API, this may be called from any thread, so producer threads can use
+// it to register structures or update their data. Posted functions run in the order they were posted, each batch
+// taken from the queue at once. For data updates, move the arrays in to the function rather than copying them, e.g.
+//   auto update = [](std::vector<glm::vec3>& p) { polyscope::getPointCloud("points")->updatePointPositions(p); };
+//   postToMainThread(std::bind(update, std::move(pts)));
+void postToMainThread(std::function<void()> func);
+
+// Run everything posted with postToMainThread() so far. Called automatically by the main loop; must be called from
+// the main thread.
+void processPostedUpdates();
+
 // Managed a stack of of contexts to draw the UI. Usually contains one entry, which causes the main GUI to be drawn, but
 // in general the top callback will be called instead. Primarily exists to manage the ImGUI context, so callbacks can
 // create other contexts and circumvent the main draw loop. This is used internally to implement messages, element
@@ -168,6 +209,22 @@ void initializeImGUIContext();
 void drawStructures();
 void drawStructuresDelayed();
 
+// The structures a render pass draws, gathered from all types for the current camera (view::viewMat, so the
+// reflection and shadow passes see their own view). Enabled structures outside the view frustum are left out.
+//  - Registration: in the order of state::structures
+//  - StateSorted: grouped by type and then material (Structure::drawSortKey()) to save state changes, front-to-back
+//    within a group so near geometry fills the depth buffer first
+//  - BackToFront: farthest first, for blending without an order-independent transparency scheme
+// Sorting is by bounding box center, and happens per structure, since each structure issues its own draw calls.
+enum class RenderQueueOrder { Registration = 0, StateSorted, BackToFront };
+struct RenderQueueItem {
+  const std::string* typeName;
+  Structure* structure;
+  size_t typeIndex;
+  float depth; // of the bounding box center in front of the camera, only set for sorted orders
+};
+FrameVector<RenderQueueItem> buildRenderQueue(RenderQueueOrder order);
+
 // Called to check any options that might have been changed and perform appropriate updates. Users generally should not
 // need to call this directly.
 void processLazyProperties();
@@ -0,0 +1,152 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+namespace profiling {
+
+// Frame timing instrumentation. When options::enableProfiling is set, Polyscope times the main stages of each frame
+// (building the UI, rendering the scene, each structure's draw, each shader program draw, ...) and keeps rolling
+// statistics over the last few seconds of frames, which are shown in the Debug section of the UI and can be queried
+// below. Timers are identified by name; all calls with the same name within a frame are summed in to one sample.
+//
+// GPU timings come from timestamp queries which are read back a few frames later when the GPU has finished, so they
+// never stall rendering. Timers may nest.
+//
+// When Polyscope is built with the CMake option POLYSCOPE_ENABLE_TRACY, every timer is also a Tracy zone (and each
+// frame a Tracy frame mark), whether or not profiling is enabled. Only CPU zones are sent to Tracy.
+
+struct RollingTime {
+  double lastMs = 0.; // most recent frame
+  double meanMs = 0.; // over the rolling window
+  double maxMs = 0.;  // over the rolling window
+};
+
+struct TimerStats {
+  RollingTime cpu;
+  RollingTime gpu;     // only meaningful if hasGPU
+  bool hasGPU = false; // whether any GPU timings have been recorded for this timer
+  size_t callsPerFrame = 0;
+};
+
+// Times the enclosing scope. If withGPU is true, also times the GPU work issued within the scope. Does nothing if
+// profiling is disabled when the timer is created.
+class ScopedTimer {
+public:
+  ScopedTimer(const char* name, bool withGPU = false);
+  ScopedTimer(const std::string& name, bool withGPU = false);
+  // Named "category name", joined only if profiling is enabled
+  ScopedTimer(const std::string& category, const std::string& name, bool withGPU);
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+  void begin(size_t timerID, bool withGPU);
+
+  bool active = false;
+  bool withGPU = false;
+  size_t timerID = 0;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Record a span which does not fit in a scope (such as the latency from sampling input to presenting the frame) as a
+// call of the named timer, CPU only. Does nothing if profiling is disabled.
+void recordTime(const std::string& name, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+
+// == Startup
+// The time taken by each phase of polyscope::init(), in the order they finished. These are always recorded, since
+// init() usually runs before profiling is turned on. Setup which init() defers to the first frame or first use (the
+// general-use programs, built-in materials, pick buffers, ground plane) is timed by the ordinary timers instead.
+
+struct InitPhaseTime {
+  std::string name;
+  double ms = 0.;
+};
+
+std::vector<InitPhaseTime> getInitPhaseTimes();
+
+// Times the enclosing scope as a phase of init()
+class InitPhaseTimer {
+public:
+  InitPhaseTimer(const char* name);
+  ~InitPhaseTimer();
+
+  InitPhaseTimer(const InitPhaseTimer&) = delete;
+  InitPhaseTimer& operator=(const InitPhaseTimer&) = delete;
+
+private:
+  const char* name;
+  std::chrono::steady_clock::time_point start;
+};
+
+// Stats for all timers which have recorded anything since the last reset, by name
+std::map<std::string, TimerStats> getTimerStats();
+
+// Stats for a single timer (all zero if it has not recorded anything)
+TimerStats getTimerStats(const std::string& name);
+
+// Clear all recorded timings
+void resetTimers();
+
+// Close out the current frame: completed samples are added to the rolling statistics, and any GPU timings which have
+// finished are collected. Called once per main loop iteration.
+void endFrame();
+
+// Build the ImGui table of timers
+void buildProfilingGui();
+
+// == Frame capture
+// The complete timings of every frame, rather than rolling statistics, for tools such as a scripted replay which
+// writes out a trace. Requires options::enableProfiling.
+
+struct FrameTimings {
+  uint64_t frame = 0;
+  std::map<std::string, double> cpuMs; // by timer name, summed over the frame
+  std::map<std::string, double> gpuMs; // (filled in a few frames later, once the GPU has finished the frame)
+  uint64_t heapAllocations = 0;        // (only if heapAllocationTrackingEnabled())
+};
+
+// Start keeping the timings of every frame from the next one on, discarding any previous capture
+void beginFrameCapture();
+
+// Stop capturing, and get the captured frames in order. The GPU timings of the last few frames may still have been in
+// flight; draw a few more frames before stopping if they are needed.
+std::vector<FrameTimings> endFrameCapture();
+
+// The index of the frame currently being drawn (counted by endFrame())
+uint64_t getFrameIndex();
+
+// == Trace export
+// Record every timer scope as an event on a timeline, to view Polyscope's frames in chrome://tracing or Perfetto, next
+// to the application's own trace. Timers run while a trace is being recorded, even if options::enableProfiling is
+// off. Timestamps are microseconds of std::chrono::steady_clock, so application events recorded with the same clock
+// line up. Frame ends are marked with instant events, and GPU timings (which arrive a few frames late) are recorded as
+// counters at the end of the frame they belong to.
+
+void beginTrace();
+bool isTracing();
+
+// Stop recording, and write the events to filename in the Chrome trace event JSON format
+void endTrace(std::string filename);
+
+// == Heap allocation tracking
+// When Polyscope is built with the CMake option POLYSCOPE_TRACK_HEAP_ALLOCATIONS, the global operator new is replaced
+// with one which counts calls, from every thread, so tests and tools can check that steady-state frames do not touch
+// the heap. Otherwise nothing is counted. Per-frame temporaries should come from the frame arena (see frame_arena.h).
+
+bool heapAllocationTrackingEnabled();
+uint64_t getHeapAllocationCount();      // since startup
+uint64_t getLastFrameHeapAllocations(); // during the last whole frame (counted by endFrame())
+
+} // namespace profiling
+} // namespace polyscope
@@ -43,17 +43,32 @@ public:
   // Re-perform any setup work for the quantity, including regenerating shader programs.
   virtual void refresh();
 
+  // Re-apply the parent structure's material to the quantity's existing shader programs, rather than regenerating them.
+  // Overridden by quantities which draw with the parent's material.
+  virtual void refreshMaterial();
+
+  // Request a redraw because this quantity changed (see Structure::requestRedraw())
+  void requestRedraw();
+
+  // With options::compressDisabledQuantities, compress the host data of the quantity and release its GPU resources if
+  // it is disabled, or decompress the data if it was compressed and the quantity is enabled. Called by setEnabled().
+  void updateDataCompression();
+
   // A decorated name for the quantity that will be used in headers. For instance, for surface scalar named "value" we
   // return "value (scalar)"
   virtual std::string niceName();
-  std::string uniquePrefix();
+  const std::string& uniquePrefix() { return uniquePrefixStr; }
 
   // === Member variables ===
   Structure& parent;      // the parent structure with which this quantity is associated
   const std::string name; // a name for this quantity, which must be unique amongst quantities on `parent`
+  const std::string uniquePrefixStr; // "[parent prefix][name]#", built once on construction
 
   // Is this quantity currently being displayed?
   PersistentValue<bool> enabled; // should be set by setEnabled()
+
+protected:
+  bool dataCompressed = false; // see updateDataCompression()
 };
 
 // === Structure-specific Quantities
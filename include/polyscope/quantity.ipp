@@ -43,6 +43,11 @@ QuantityS<S>* QuantityS<S>::setEnabled(bool newEnabled) {
     }
   }
 
+  // (not while constructing, which toggles the quantity before it replaces any existing one of the same name)
+  if (parent.getQuantity(name) == this) {
+    updateDataCompression();
+  }
+
   if (isEnabled()) {
     requestRedraw();
   }
@@ -0,0 +1,38 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// Record the main loop's frames to a video. Frames are read back from the display buffer asynchronously and streamed
+// to the encoder on a worker thread, so recording costs little more than the readback itself. Frames are emitted at a
+// fixed rate of fps in wall-clock time: if the main loop runs faster some frames are skipped, and if it runs slower
+// frames are repeated, so playback speed matches the session. If withUI is false, frames are captured before the UI is
+// drawn on top of the scene. The display size must stay fixed while recording; frames of any other size are dropped.
+
+// Pipe raw frames to an ffmpeg process (options::ffmpegExecutable) which writes the video to filename, encoded with
+// options::recordingEncoderArgs.
+void startRecording(std::string filename, int fps = 30, bool withUI = false);
+
+// Pass each frame's RGBA pixels (bottom row first, as with saveImage()) to frameCallback(pixels, w, h) instead. The
+// callback runs on a worker thread, in frame order, and is called once per emitted frame (so possibly several times with
+// the same pixels).
+void startRecording(std::function<void(const std::vector<unsigned char>&, int, int)> frameCallback, int fps = 30,
+                    bool withUI = false);
+
+// Finish writing any outstanding frames and close the encoder
+void stopRecording();
+
+bool isRecording();
+
+namespace internal {
+// Called by the draw loop once the scene (uiDrawn = false) and then the UI (uiDrawn = true) have been drawn to the
+// display buffer
+void captureRecordingFrame(bool uiDrawn);
+} // namespace internal
+
+} // namespace polyscope
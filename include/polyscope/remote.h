@@ -0,0 +1,27 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+namespace polyscope {
+
+// Serve the main loop to a thin client in a web browser, for running Polyscope on a remote (typically headless) GPU
+// machine. Browsing to http://<host>:<port>/ loads a small client page, which connects back over a WebSocket. Each
+// frame, including the UI, is read back from the display buffer asynchronously, JPEG-encoded on a worker thread, and
+// sent at up to fps frames per second; if the connection falls behind, only the newest frame is sent. Mouse, wheel,
+// key, and resize events from the client are fed to ImGui before the main loop processes input, so they drive the UI
+// and the camera just like local input. One client is served at a time, and a new connection replaces the old one.
+// Only available on POSIX platforms.
+void startRemoteServer(int port = 8765, int fps = 30, int jpegQuality = 80);
+void stopRemoteServer();
+
+bool isRemoteServerRunning();
+bool hasRemoteClient();
+
+namespace internal {
+// Called by the main loop: feed the events which arrived from the client to ImGui (before input is processed), and
+// send the display buffer once the UI has been drawn
+void processRemoteInput();
+void captureRemoteFrame();
+} // namespace internal
+
+} // namespace polyscope
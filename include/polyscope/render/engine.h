@@ -4,12 +4,18 @@
 
 #include <array>
 #include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "polyscope/parallel.h"
 #include "polyscope/render/color_maps.h"
 #include "polyscope/render/ground_plane.h"
 #include "polyscope/render/materials.h"
+#include "polyscope/render/render_graph.h"
 #include "polyscope/types.h"
 #include "polyscope/view.h"
 
@@ -31,7 +37,9 @@ enum class DrawMode {
   IndexedLines,
   IndexedLineStrip,
   IndexedLinesAdjacency,
-  IndexedLineStripAdjacency
+  IndexedLineStripAdjacency,
+  IndexedPoints,
+  Compute // compute programs, which are run with ShaderProgram::dispatch() rather than drawn
 };
 
 enum class FilterMode { Nearest = 0, Linear };
@@ -56,11 +64,15 @@ enum class RenderDataType {
 int dimension(const TextureFormat& x);
 std::string modeName(const TransparencyMode& m);
 std::string renderDataTypeName(const RenderDataType& r);
+size_t renderDataTypeSizeInBytes(const RenderDataType& r);
 int renderDataTypeCountCompatbility(const RenderDataType r1, const RenderDataType r2);
 std::string getImageOriginRule(ImageOrigin imageOrigin);
 
 namespace render {
 
+// Slice planes are passed to the shaders as arrays of this fixed size (see Engine::updateFrameUniforms())
+const size_t maxSlicePlanes = 16;
+
 class AttributeBuffer {
 public:
   AttributeBuffer(RenderDataType dataType_, int arrayCount);
@@ -85,6 +97,36 @@ public:
   virtual void setData(const std::vector<std::array<glm::vec3, 3>>& data) = 0;
   virtual void setData(const std::vector<std::array<glm::vec3, 4>>& data) = 0;
 
+  // Set the data from nElements entries of contiguous memory which is already laid out exactly as the buffer stores it
+  // (tightly-packed values of the buffer's type, times the array count). Used to upload externally-owned data without
+  // an intermediate copy.
+  virtual void setDataRaw(const void* data, size_t nElements) = 0;
+
+  // Update a subrange of an already-set buffer, writing data[dataStart, dataEnd) to the entries starting at
+  // bufferStart. Avoids re-uploading the whole buffer when only some entries changed.
+  virtual void setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<float>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<double>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+  virtual void setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) = 0;
+
+  // Change the number of entries of an already-set, resizable buffer, keeping the contents of the entries which remain.
+  // Any new entries are uninitialized. Capacity grows geometrically (see setResizable()).
+  virtual void resize(size_t newNElements) = 0;
+
+  // Append data[dataStart, dataEnd) after the current entries of a resizable buffer (or set it, if it has not been set
+  // yet). Only the new entries are uploaded, so appending repeatedly costs amortized O(new entries).
+  template <typename T>
+  void appendData(const std::vector<T>& data, size_t dataStart, size_t dataEnd);
+
   virtual uint32_t getNativeBufferID() = 0; // used to interop with external things, e.g. ImGui
 
   // == Getters
@@ -94,6 +136,22 @@ public:
   uint64_t getUniqueID() const { return uniqueID; }
   bool isSet() const { return dataSize > 0; }
 
+  // Hint that the contents will be replaced frequently (e.g. every frame for animated geometry). Backends may then use
+  // an update strategy which does not wait on draws that are still reading the old contents.
+  void setStreaming(bool newVal) { streaming = newVal; }
+  bool getStreaming() const { return streaming; }
+
+  // Allow setData() to change the number of entries, rather than requiring updates to be the same size. Backends keep
+  // spare capacity and grow it geometrically, so a buffer which is resized repeatedly is only occasionally
+  // reallocated.
+  void setResizable(bool newVal) { resizable = newVal; }
+  bool getResizable() const { return resizable; }
+
+  // Memory accounting (see getGPUMemoryUsage())
+  void setMemoryOwner(const std::string& owner) { memoryOwner = owner; }
+  const std::string& getMemoryOwner() const { return memoryOwner; }
+  size_t getSizeInBytes() const; // estimated device memory held by the buffer
+
   // get data at a single index from the buffer
   virtual float getData_float(size_t ind) = 0;
   virtual double getData_double(size_t ind) = 0;
@@ -118,17 +176,28 @@ public:
   virtual std::vector<glm::uvec3> getDataRange_uvec3(size_t ind, size_t count) = 0;
   virtual std::vector<glm::uvec4> getDataRange_uvec4(size_t ind, size_t count) = 0;
 
+  // Asynchronous version of the range reads above: returns immediately, and the callback is invoked with the `count`
+  // entries (tightly packed, as the buffer stores them) from a later Engine::processPendingReadbacks(), after the GPU
+  // has finished writing them. Backends which do not support async reads read synchronously and invoke the callback
+  // immediately, like the FrameBuffer async reads.
+  virtual void getDataRangeRawAsync(size_t ind, size_t count, std::function<void(const void*)> callback);
+
 protected:
   RenderDataType dataType;
   int arrayCount;
   int64_t dataSize = -1; // the size of the data currently stored in this attribute (-1 if nothing)
+  bool streaming = false;
+  bool resizable = false;
+  void setUpdatedDataSize(int64_t newDataSize); // for updates of a set buffer; throws if resizing is not allowed
   uint64_t uniqueID;
+  std::string memoryOwner;
 };
 
 class TextureBuffer {
 public:
   // abstract class: use the factory methods from the Engine class
-  TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_ = -1);
+  TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_ = -1,
+                unsigned int sizeZ_ = -1);
 
   virtual ~TextureBuffer();
 
@@ -138,10 +207,19 @@ public:
 
   unsigned int getSizeX() const { return sizeX; }
   unsigned int getSizeY() const { return sizeY; }
+  unsigned int getSizeZ() const { return sizeZ; }
   int getDimension() const { return dim; }
   unsigned int getTotalSize() const; // product of dimensions
+  void checkRegionInBounds(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h) const;
+  void checkRegionInBounds3D(unsigned int xStart, unsigned int yStart, unsigned int zStart, unsigned int w,
+                             unsigned int h, unsigned int d) const;
   uint64_t getUniqueID() const { return uniqueID; }
 
+  // Memory accounting (see getGPUMemoryUsage())
+  void setMemoryOwner(const std::string& owner) { memoryOwner = owner; }
+  const std::string& getMemoryOwner() const { return memoryOwner; }
+  size_t getSizeInBytes() const; // estimated device memory held by the texture
+
   virtual void setFilterMode(FilterMode newMode);
 
   // Get texture data CPU-side
@@ -151,6 +229,17 @@ public:
   virtual std::vector<glm::vec2> getDataVector2() = 0;
   virtual std::vector<glm::vec3> getDataVector3() = 0;
 
+  // Overwrite a rectangle of a 2D texture with tightly-packed rows of data, leaving the rest untouched. The half-float
+  // version takes IEEE 754 half-precision values (as produced by glm::packHalf1x16()).
+  virtual void setDataRegion(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                             const float* data) = 0;
+  virtual void setDataRegionHalfFloat(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                                      const uint16_t* data) = 0;
+
+  // The same for a box of a 3D texture, with x fastest-varying in the data
+  virtual void setDataRegion3D(unsigned int xStart, unsigned int yStart, unsigned int zStart, unsigned int w,
+                               unsigned int h, unsigned int d, const float* data) = 0;
+
   // Set texture data
   // void fillTextureData1D(std::string name, unsigned char* texData, unsigned int length);
   // void fillTextureData2D(std::string name, unsigned char* texData, unsigned int width, unsigned int height,
@@ -161,15 +250,16 @@ public:
 protected:
   int dim;
   TextureFormat format;
-  unsigned int sizeX, sizeY;
+  unsigned int sizeX, sizeY, sizeZ;
   uint64_t uniqueID;
+  std::string memoryOwner;
 };
 
 class RenderBuffer {
 public:
   // abstract class: use the factory methods from the Engine class
   RenderBuffer(RenderBufferType type_, unsigned int sizeX_, unsigned int sizeY_);
-  virtual ~RenderBuffer(){};
+  virtual ~RenderBuffer();
 
   virtual void resize(unsigned int newX, unsigned int newY);
 
@@ -178,10 +268,16 @@ public:
   unsigned int getSizeY() const { return sizeY; }
   uint64_t getUniqueID() const { return uniqueID; }
 
+  // Memory accounting (see getGPUMemoryUsage())
+  void setMemoryOwner(const std::string& owner) { memoryOwner = owner; }
+  const std::string& getMemoryOwner() const { return memoryOwner; }
+  size_t getSizeInBytes() const; // estimated device memory held by the buffer
+
 protected:
   RenderBufferType type;
-  unsigned int sizeX, sizeY;
+  unsigned int sizeX, sizeY, sizeZ;
   uint64_t uniqueID;
+  std::string memoryOwner;
 };
 
 
@@ -199,6 +295,7 @@ public:
 
   // Clear to redraw
   virtual void clear() = 0;
+  virtual void clearRegion(int startX, int startY, unsigned int sizeX, unsigned int sizeY) = 0; // just these pixels
   glm::vec3 clearColor{1.0, 1.0, 1.0};
   float clearAlpha = 0.0;
   float clearDepth = 1.0;
@@ -225,14 +322,24 @@ public:
 
   // Query pixel
   virtual std::array<float, 4> readFloat4(int xPos, int yPos) = 0;
+  virtual std::vector<float> readFloat4Region(int xPos, int yPos, int sizeX, int sizeY) = 0; // 4 floats per pixel
   virtual float readDepth(int xPos, int yPos) = 0;
+  virtual std::vector<float> readDepthRegion(int xPos, int yPos, int sizeX, int sizeY) = 0; // 1 float per pixel
   virtual void blitTo(FrameBuffer* other) = 0;
   virtual std::vector<unsigned char> readBuffer() = 0;
 
+  // Asynchronous queries: these return immediately, and the callback is invoked with the result from a later call to
+  // Engine::processPendingReadbacks() (which happens once per frame), after the GPU has finished. Backends which do not
+  // support async reads fall back on the synchronous versions above and invoke the callback immediately.
+  virtual void readFloat4Async(int xPos, int yPos, std::function<void(std::array<float, 4>)> callback);
+  virtual void readBufferAsync(std::function<void(std::vector<unsigned char>)> callback);
+  virtual void readDepthRegionAsync(int xPos, int yPos, int sizeX, int sizeY,
+                                    std::function<void(std::vector<float>)> callback);
+
   uint64_t getUniqueID() const { return uniqueID; }
 
 protected:
-  unsigned int sizeX, sizeY;
+  unsigned int sizeX, sizeY, sizeZ;
   uint64_t uniqueID;
 
   // Viewport
@@ -264,16 +371,21 @@ struct ShaderSpecTexture {
   const std::string name;
   const int dim;
 };
+struct ShaderSpecStorageBuffer {
+  const std::string name; // of the shader storage block
+  const RenderDataType type;
+};
 
 
 // Types which represents shaders and the values they require
-enum class ShaderStageType { Vertex, Geometry, /* Compute,*/ Fragment };
+enum class ShaderStageType { Vertex, Geometry, Compute, Fragment };
 struct ShaderStageSpecification {
   const ShaderStageType stage;
   const std::vector<ShaderSpecUniform> uniforms;
   const std::vector<ShaderSpecAttribute> attributes;
   const std::vector<ShaderSpecTexture> textures;
   const std::string src;
+  const std::vector<ShaderSpecStorageBuffer> storageBuffers; // (after src, so stages without any can omit it)
 };
 
 // A simple interface for replacement rules to customize shaders
@@ -299,9 +411,25 @@ enum class ShaderReplacementDefaults {
   SceneObject, // an object in the scene, which gets lit via matcap (etc)
   Pick,        // rendering to a pick buffer
   Process,     // postprocessing effects, etc
+  Compute,     // compute programs, which need a newer GLSL version
   None         // no defaults applied
 };
 
+// Which uses of the data written by compute dispatches must wait for them, see Engine::memoryBarrier()
+enum class MemoryBarrierType {
+  StorageBuffer,   // read or written by later dispatches
+  VertexAttribute, // drawn as attributes
+  Index,           // drawn as an index buffer
+  Texture,         // sampled from textures
+  HostRead,        // read back to the host, e.g. AttributeBuffer::getDataRange_float()
+  All
+};
+
+// A uniform of a particular shader program, see ShaderProgram::getUniformHandle()
+struct UniformHandle {
+  int32_t index = -1;
+};
+
 // Encapsulate a shader program
 class ShaderProgram {
 
@@ -329,6 +457,32 @@ public:
   virtual void setUniform(std::string name, glm::uvec3 val) = 0;
   virtual void setUniform(std::string name, glm::uvec4 val) = 0;
 
+  // The same, with the uniform resolved once up front rather than searched for by name on each call. Handles are
+  // only valid for the program they came from, and must be re-resolved if the program is recreated. Throws if the
+  // program has no uniform with that name.
+  virtual UniformHandle getUniformHandle(const std::string& name) = 0;
+  virtual UniformHandle getUniformHandle(const char* name) = 0;
+  virtual bool hasUniform(UniformHandle handle) = 0;
+  virtual void setUniform(UniformHandle handle, int val) = 0;
+  virtual void setUniform(UniformHandle handle, unsigned int val) = 0;
+  virtual void setUniform(UniformHandle handle, float val) = 0;
+  virtual void setUniform(UniformHandle handle, double val) = 0; // WARNING casts down to float
+  virtual void setUniform(UniformHandle handle, float* val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::vec2 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::vec3 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::vec4 val) = 0;
+  virtual void setUniform(UniformHandle handle, std::array<float, 3> val) = 0;
+  virtual void setUniform(UniformHandle handle, float x, float y, float z, float w) = 0;
+  virtual void setUniform(UniformHandle handle, glm::uvec2 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::uvec3 val) = 0;
+  virtual void setUniform(UniformHandle handle, glm::uvec4 val) = 0;
+
+  // Setting a uniform named by a string literal goes through its handle, so that no std::string is built per call
+  template <typename... Args>
+  void setUniform(const char* name, Args... args) {
+    setUniform(getUniformHandle(name), args...);
+  }
+
   // = Attributes
   // clang-format off
   virtual bool hasAttribute(std::string name) = 0;
@@ -350,6 +504,15 @@ public:
   void setAttribute(std::string name, const std::vector<std::array<T, C>>& data);
 
 
+  // Storage buffers. Binds a buffer to the shader storage block of that name, which the shader reads or writes in
+  // place. The block sees the raw contents of the buffer, tightly packed, so vec3 data must be declared as a float
+  // array (std430 pads the entries of vec3 arrays to 16 bytes). The buffer must be allocated (e.g. with setData())
+  // before dispatching or drawing, even if the shader only writes to it. Any stage may declare storage buffers, but
+  // they need the same OpenGL 4.3 support as compute programs (see Engine::supportsComputeShaders()).
+  virtual bool hasStorageBuffer(std::string name) = 0;
+  virtual bool storageBufferIsSet(std::string name) = 0;
+  virtual void setStorageBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) = 0;
+
   // Textures
   virtual bool hasTexture(std::string name) = 0;
   virtual bool textureIsSet(std::string name) = 0;
@@ -358,12 +521,21 @@ public:
                             bool withAlpha = true, bool useMipMap = false, bool repeat = false) = 0;
   virtual void setTextureFromColormap(std::string name, const std::string& colorMap, bool allowUpdate = false) = 0;
   virtual void setTextureFromBuffer(std::string name, TextureBuffer* textureBuffer) = 0;
+  // Read an attribute buffer in place through a buffer texture, e.g. to index per-element data which is not laid out
+  // along the vertices of the draw, without copying it (unlike ManagedBuffer::getTextureViewBuffer()). The texture
+  // is declared with dimension 1 and as a samplerBuffer in the shader (usamplerBuffer / isamplerBuffer for integer
+  // data). Each component is one texel, so component c of entry i is texelFetch(t, i * C + c).r for C components
+  // per entry; see the fetchBuffer*() helpers in the common shader source. Matrix data is not supported.
+  virtual void setTextureFromAttributeBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) = 0;
 
 
   // Indices
   virtual void setIndex(std::vector<std::array<unsigned int, 3>>& indices) = 0;
   virtual void setIndex(std::vector<unsigned int>& indices) = 0;
   virtual void setIndex(std::vector<glm::uvec3>& indices) = 0;
+  // Draw from the current contents of a buffer of UInt indices, rather than a copy. Later updates to the buffer
+  // (including appends) apply without calling setIndex() again.
+  virtual void setIndex(std::shared_ptr<AttributeBuffer> indices) = 0;
   virtual void setPrimitiveRestartIndex(unsigned int restartIndex) = 0;
 
   // Call once to initialize GLSL code used by multiple shaders
@@ -372,9 +544,37 @@ public:
   // Draw!
   virtual void draw() = 0;
 
+  // Run a compute program (one built from a single ShaderStageType::Compute stage, with DrawMode::Compute) over
+  // groupsX x groupsY x groupsZ work groups. The results are not guaranteed to be visible to later commands until
+  // Engine::memoryBarrier() is called for the way they will be used.
+  virtual void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) = 0;
+  bool isCompute() const { return drawMode == DrawMode::Compute; }
+
+  // Restrict draw() to a subset of the data, given as (first element, element count) ranges in the units of the draw
+  // mode (e.g. vertices for DrawMode::Triangles, or indices for DrawMode::IndexedTriangles). Passing an empty list
+  // draws nothing; clearDrawRanges() returns to drawing all of the data.
+  void setDrawRanges(const std::vector<std::array<size_t, 2>>& ranges);
+  void clearDrawRanges();
+
+  // Draw instanceCount copies of the data in a single instanced draw. Attributes marked with setAttributePerInstance()
+  // advance once per instance rather than once per element, and must have at least instanceCount entries (only the
+  // first instanceCount are drawn). Not compatible with draw ranges. clearInstanceCount() returns to ordinary drawing.
+  void setInstanceCount(uint32_t count);
+  void clearInstanceCount();
+  virtual void setAttributePerInstance(std::string name) = 0;
+
+  // Number of elements to draw, for programs which compute their data from gl_VertexID rather than reading it from
+  // attributes. Any (per-element) attributes must have this size as well.
+  void setVertexCount(size_t count);
+
   virtual void validateData() = 0;
 
   uint64_t getUniqueID() const { return uniqueID; }
+  bool usesIndexedDrawing() const { return useIndex; }
+
+  // Buffers which the program allocates itself (e.g. from setAttribute() with a vector of data) are attributed to this
+  // owner for memory accounting. Only affects buffers allocated after it is set.
+  void setMemoryOwner(const std::string& owner) { memoryOwner = owner; }
 
 protected:
   // What mode does this program draw in?
@@ -386,16 +586,74 @@ protected:
   // Does this program use indexed drawing?
   bool useIndex = false;
   long int indexSize = -1;
+  std::shared_ptr<AttributeBuffer> indexBuffer; // if set, the index is drawn from this buffer
   bool usePrimitiveRestart = false;
   bool primitiveRestartIndexSet = false;
   unsigned int restartIndex = -1;
   uint64_t uniqueID;
+
+  // Subset of the data to draw, if set via setDrawRanges()
+  bool useDrawRanges = false;
+  std::vector<int> drawRangeFirsts;
+  std::vector<int> drawRangeCounts;
+
+  // Number of instances to draw, if set via setInstanceCount()
+  bool useInstancing = false;
+  uint32_t instanceCount = 1;
+
+  // Number of elements to draw, if set via setVertexCount()
+  int64_t vertexCount = -1;
+
+  std::string memoryOwner;
+};
+
+
+// Estimated device memory held by live render buffers, in bytes. Framebuffers hold no memory of their own; their
+// attachments are counted as render buffers or textures.
+struct GPUMemoryUsage {
+  size_t attributeBytes = 0;
+  size_t textureBytes = 0;
+  size_t renderBufferBytes = 0;
+  size_t totalBytes() const { return attributeBytes + textureBytes + renderBufferBytes; }
+};
+
+// Sum over all live buffers, or only those whose memory owner starts with ownerPrefix. Structures and quantities tag
+// their buffers with names beginning with their uniquePrefix(), so passing that gives the memory used by the
+// structure/quantity (and, for a structure, all of its quantities).
+GPUMemoryUsage getGPUMemoryUsage();
+GPUMemoryUsage getGPUMemoryUsage(const std::string& ownerPrefix);
+
+// Thrown by Engine::requestShader() when deferShaderCompiles is set and the program is still being compiled
+class ShaderProgramNotReady : public std::runtime_error {
+public:
+  ShaderProgramNotReady(const std::string& programName)
+      : std::runtime_error("shader program " + programName + " is still compiling") {}
 };
 
+// The result of a finished GPU timer, see Engine::beginGPUTimer()
+struct GPUTimerResult {
+  size_t timerID;
+  uint64_t frame;
+  double ms;
+};
+
+// Counts of the work done through the engine, so tests can assert on the cost of an operation. Only the mock backend
+// records them; the others leave them at zero. See Engine::getCostCounters().
+struct EngineCostCounters {
+  size_t bytesUploaded = 0;                             // attribute and texture data sent to the device
+  std::map<std::string, size_t> bytesUploadedPerBuffer; // by memory owner (see AttributeBuffer::setMemoryOwner())
+  size_t drawCalls = 0;
+  size_t computeDispatches = 0;
+  size_t shaderCompilations = 0;
+  size_t stateChanges = 0;      // depth, blend, color mask, culling, and front face settings
+  size_t bufferAllocations = 0; // attribute buffers, textures, render buffers, and framebuffers created
+};
 
 class Engine {
 
 public:
+  Engine();
+
   // Options
 
   // High-level control
@@ -410,6 +668,73 @@ public:
   void popBindFramebufferForRendering(); // pop the old framebuffer off the stack and bind to it
   virtual std::vector<unsigned char> readDisplayBuffer() = 0;
 
+  // Deliver the results of any asynchronous framebuffer reads which have completed. If blockUntilDone is true, waits
+  // for all outstanding reads to finish first.
+  virtual void processPendingReadbacks(bool blockUntilDone = false);
+  virtual bool hasPendingReadbacks();
+
+  // Set target[i] = source[indices[i]] for every entry of indices, entirely on the device, resizing target to match.
+  // source and target must have the same type and array count, and indices holds uint32 values. Out-of-range indices
+  // give zeros. Returns false (changing nothing) if the backend cannot, in which case the caller gathers on the host.
+  virtual bool supportsAttributeBufferGather();
+  virtual bool gatherAttributeBuffer(AttributeBuffer& source, AttributeBuffer& indices, AttributeBuffer& target);
+
+  // Set target[i] = mix(a[i], b[i], t) for vec3 buffers of the same size (normalized, if `normalize`), entirely on the
+  // device, resizing target to match. Returns false (changing nothing) if the backend cannot, in which case the caller
+  // blends on the host.
+  virtual bool supportsAttributeBufferBlend();
+  virtual bool blendAttributeBuffers(AttributeBuffer& a, AttributeBuffer& b, float t, bool normalize,
+                                     AttributeBuffer& target);
+
+  // Compute the normals and centers of the faces of a polygon mesh, and its area-weighted vertex normals, from the
+  // vertex positions (a vec3 buffer), entirely on the device and as SurfaceMesh does on the host. The faces are given
+  // in UInt buffers as in SurfaceMesh, the vertices of face i being faceIndsEntries[faceIndsStart[i]...
+  // faceIndsStart[i+1]), and the faces incident on each vertex likewise by vertexFaceAdjStart and
+  // vertexFaceAdjEntries. Each output which is not null is a vec3 buffer, resized to match. Returns false (changing
+  // nothing) if the backend cannot, in which case the caller computes on the host.
+  virtual bool supportsMeshGeometryCompute();
+  virtual bool computeMeshGeometry(AttributeBuffer& positions, AttributeBuffer& faceIndsStart,
+                                   AttributeBuffer& faceIndsEntries, AttributeBuffer& vertexFaceAdjStart,
+                                   AttributeBuffer& vertexFaceAdjEntries, AttributeBuffer* faceNormals,
+                                   AttributeBuffer* faceCenters, AttributeBuffer* vertexNormals);
+
+  // Set order[0, count) to the indices of the first `count` entries of a vec3 buffer of positions, sorted back to front
+  // along the view: by increasing z = dot(depthRow.xyz, p) + depthRow.w (the third row of a modelview matrix), with
+  // ties in index order. Radix sorts on the device with compute programs; order is a UInt buffer of at least count
+  // entries. Returns false (changing nothing) if the backend cannot, in which case the caller sorts on the host.
+  virtual bool supportsPointDepthSort();
+  virtual bool sortPointsByDepth(std::shared_ptr<AttributeBuffer> positions, size_t count, glm::vec4 depthRow,
+                                 std::shared_ptr<AttributeBuffer> order);
+
+  // GPU timers, used by profiling::ScopedTimer. Timers may nest. collectGPUTimers() appends the results of the timers
+  // which the GPU has finished, and returns the oldest frame which still has timers in flight (or UINT64_MAX if there
+  // are none); it never waits for the GPU. Backends without timer queries record nothing.
+  virtual void beginGPUTimer(size_t timerID, uint64_t frame);
+  virtual void endGPUTimer();
+  virtual uint64_t collectGPUTimers(std::vector<GPUTimerResult>& results);
+
+  // Occlusion queries, which record whether any samples passed the depth test between begin and end; used to stop depth
+  // peeling once a pass draws nothing. Queries are identified by small integers chosen by the caller, and may be begun
+  // again once their result has been read. getOcclusionQueryResult() never waits for the GPU, it returns false if the
+  // result is not ready yet.
+  virtual bool supportsOcclusionQueries();
+  virtual void beginOcclusionQuery(size_t queryID);
+  virtual void endOcclusionQuery();
+  virtual bool getOcclusionQueryResult(size_t queryID, bool& anySamplesPassed);
+
+  // Compute programs, requested like any other program (with ShaderReplacementDefaults::Compute) and run with
+  // ShaderProgram::dispatch(). They need OpenGL 4.3; where supportsComputeShaders() is false, requesting one throws,
+  // and callers should use a draw-based or host fallback instead. memoryBarrier() makes the writes of earlier
+  // dispatches visible to the given kind of later use.
+  virtual bool supportsComputeShaders();
+  virtual void memoryBarrier(MemoryBarrierType type = MemoryBarrierType::All);
+
+  // Cost accounting. getCostCounters() sums everything since the last resetCostCounters(); getLastFrameCostCounters()
+  // holds the work between the two most recent swapDisplayBuffers(), i.e. of the last whole frame.
+  const EngineCostCounters& getCostCounters() const { return costCounters; }
+  const EngineCostCounters& getLastFrameCostCounters() const { return lastFrameCostCounters; }
+  void resetCostCounters();
+
   virtual void clearSceneBuffer();
   virtual bool bindSceneBuffer();
   virtual void resizeScreenBuffers(); // applies to all buffers tied to display size
@@ -427,11 +752,22 @@ public:
 
   void setCurrentViewport(glm::vec4 viewport);
   glm::vec4 getCurrentViewport();
+
+  // Frame-global uniforms (u_projMatrix, u_invProjMatrix, u_viewport, u_viewportDim, the view-space slice planes, and
+  // options::impostorFallbackPixelSize) are shared by all shader programs through a single uniform block, rather than
+  // being set on each program. All but the viewport are captured by updateFrameUniforms(), called once before rendering
+  // the scene or pick buffer; the viewport always follows setCurrentViewport(). The version increments whenever any of
+  // them change, so backends only re-upload when needed.
+  void updateFrameUniforms();
+  const glm::mat4& getFrameProjMatrix();
+  const glm::mat4& getFrameInvProjMatrix();
+  uint64_t getFrameUniformsVersion();
   void setCurrentPixelScaling(float scale);
   float getCurrentPixelScaling();
 
   // Helpers
   void allocateGlobalBuffersAndPrograms(); // called once during startup
+  void prepareGlobalPrograms(); // the general-use programs below; deferred from startup to the first frame
 
   // Small options
   void setBackgroundColor(glm::vec3 newColor);
@@ -443,8 +779,13 @@ public:
   // === Scene data and niceties
   GroundPlane groundPlane;
 
+  // The passes of renderScene() are run through this graph each time the scene is rendered, which also owns the
+  // transient targets of those passes (the G-buffer and the ambient occlusion estimate)
+  RenderGraph frameGraph;
+
   // === Windowing and framework things
   virtual void makeContextCurrent() = 0;
+  virtual void releaseContext(); // detach the context from this thread, so another thread can make it current
   virtual void focusWindow() = 0;
   virtual void showWindow() = 0;
   virtual void hideWindow() = 0;
@@ -455,7 +796,18 @@ public:
   virtual std::tuple<int, int> getWindowPos() = 0;
   virtual bool windowRequestsClose() = 0;
   virtual void pollEvents() = 0;
+  // Like pollEvents(), but first sleep until an event arrives (returning true) or the timeout passes (returning false).
+  // wakeEventWait() ends a wait early, and may be called from any thread. By default there is no waiting, and every
+  // call reports events.
+  virtual bool waitEvents(double timeoutSeconds);
+  virtual void wakeEventWait();
   virtual bool isKeyPressed(char c) = 0; // for lowercase a-z and 0-9 only
+  // The mouse position in window coordinates as of now, rather than as of the last pollEvents(). Returns false if the
+  // backend cannot sample it (by default, or without a window).
+  virtual bool sampleCursorPosition(glm::vec2& pos);
+  // Counts the input events (mouse, keyboard, focus, resizes) which the window has received. Always 0 by default, or
+  // without a window.
+  virtual uint64_t getInputEventCount();
   virtual std::string getClipboardText() = 0;
   virtual void setClipboardText(std::string text) = 0;
 
@@ -466,6 +818,7 @@ public:
   ImFontAtlas* getImGuiGlobalFontAtlas();
   virtual void ImGuiNewFrame() = 0;
   virtual void ImGuiRender() = 0;
+  virtual void ImGuiRenderLast() = 0; // draw the last frame's ImGui draw data again, without a new frame (may be empty)
   virtual void showTextureInImGuiWindow(std::string windowName, TextureBuffer* buffer);
 
 
@@ -486,6 +839,9 @@ public:
   virtual std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
                                                                unsigned int sizeY_,
                                                                const float* data) = 0; // 2d
+  virtual std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
+                                                               unsigned int sizeY_, unsigned int sizeZ_,
+                                                               const float* data) = 0; // 3d
 
   // create render buffers
   virtual std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -498,29 +854,47 @@ public:
   requestShader(const std::string& programName, const std::vector<std::string>& customRules,
                 ShaderReplacementDefaults defaults = ShaderReplacementDefaults::SceneObject) = 0;
 
+  // Make a replacement rule available to requestShader() by name, e.g. one generated at runtime from user-supplied
+  // shader code. Programs are cached by their rule names, so a rule with different contents needs a new name.
+  virtual void registerShaderRule(const std::string& name, const ShaderReplacementRule& rule) = 0;
+
+  // Likewise for a whole program. A compute program is a single ShaderStageType::Compute stage, with DrawMode::Compute.
+  virtual void registerShaderProgram(const std::string& name, const std::vector<ShaderStageSpecification>& spec,
+                                     const DrawMode& dm) = 0;
+
+  // Backends may compile programs in the background. While this is set, requestShader() throws ShaderProgramNotReady
+  // instead of waiting for a program which is still compiling; a later request returns it once it is done. Set while
+  // drawing the scene, so it can appear before every program is ready.
+  bool deferShaderCompiles = false;
+
   // === The frame buffers used in the rendering pipeline
-  // The size of these buffers is always kept in sync with the screen size
+  // The size of these buffers is always kept in sync with the screen size, except for those of features which aren't
+  // in use: the depth peeling and weighted blended targets are only full size in their transparency mode (1x1
+  // otherwise), and the pick buffer is allocated by the first pick render (see allocatePickBuffer()).
   std::shared_ptr<FrameBuffer> displayBuffer, displayBufferAlt;
   std::shared_ptr<FrameBuffer> sceneBuffer, sceneBufferFinal;
   std::shared_ptr<FrameBuffer> pickFramebuffer;
   std::shared_ptr<FrameBuffer> sceneDepthMinFrame;
+  std::shared_ptr<FrameBuffer> sceneBufferWeightedBlended; // sceneColor + sceneRevealage, shares the scene depth
+  void allocatePickBuffer(); // does nothing if it already exists
 
   // Main buffers for rendering
   // sceneDepthMin is an optional texture copy of the depth buffe used for some effects
   std::shared_ptr<TextureBuffer> sceneColor, sceneColorFinal, sceneDepth, sceneDepthMin;
+  std::shared_ptr<TextureBuffer> sceneRevealage; // accumulated -log(1 - alpha) for weighted blended transparency
   std::shared_ptr<RenderBuffer> pickColorBuffer, pickDepthBuffer;
 
   // General-use programs used by the engine
   std::shared_ptr<ShaderProgram> renderTexturePlain, renderTextureDot3, renderTextureMap3, renderTextureSphereBG;
-  std::shared_ptr<ShaderProgram> compositePeel, mapLight, copyDepth;
+  std::shared_ptr<ShaderProgram> compositePeel, compositeWeightedBlended, mapLight, copyDepth;
 
   // Manage transparency and culling
   void setTransparencyMode(TransparencyMode newMode);
   TransparencyMode getTransparencyMode();
   bool transparencyEnabled();
   virtual void applyTransparencySettings() = 0;
-  void addSlicePlane(std::string uniquePostfix);
-  void removeSlicePlane(std::string uniquePostfix);
+  void addSlicePlane(); // throws if there would be more than maxSlicePlanes
+  void removeSlicePlane();
   bool slicePlanesEnabled();                     // true if there is at least one slice plane in the scene
   virtual void setFrontFaceCCW(bool newVal) = 0; // true if CCW triangles are considered front-facing; false otherwise
   bool getFrontFaceCCW();
@@ -535,12 +909,52 @@ public:
   void setSSAAFactor(int newVal);
   int getSSAAFactor();
 
+  // Render the scene at a fraction of the display resolution (in (0, 1]), upscaling it for display. Only has an effect
+  // while the SSAA factor is 1. getSceneBufferScale() is the resulting size of the scene buffers relative to the
+  // display, from either one.
+  void setResolutionScale(float newVal);
+  float getResolutionScale();
+  float getSceneBufferScale();
+
+  // Temporal antialiasing (see options::temporalAntialiasing). accumulateTemporalSample() averages the latest render in
+  // sceneColorFinal in to a history buffer, which getTemporalResult() returns for display.
+  void resetTemporalAccumulation();
+  void accumulateTemporalSample();
+  int getTemporalSampleCount();
+  bool temporalAccumulationConverged(); // true if temporal antialiasing is off, or has all of its samples
+  std::shared_ptr<TextureBuffer>& getTemporalResult();
+
+  // Screen-space ambient occlusion (see options::ambientOcclusion). Resolves sceneBuffer in to sceneBufferFinal like a
+  // blit, but darkened by the occlusion estimated from sceneDepth in to aoTexture, an RG16F texture of
+  // getAmbientOcclusionSize().
+  std::array<unsigned int, 2> getAmbientOcclusionSize();
+  void resolveSceneWithAmbientOcclusion(std::shared_ptr<TextureBuffer> aoTexture);
+
+  // Deferred shading. While on (and there is no transparency), scene objects write their unlit color, shading normal,
+  // and material to a G-buffer, and are lit afterward by one fullscreen pass per material, so the lighting cost no
+  // longer grows with overdraw. bindGBuffer() clears and binds it for drawing the structures, with the given RGBA16F
+  // targets of the scene buffer size, and resolveDeferredShading() lights it in to sceneBuffer. (The ground reflection
+  // shows the unlit colors.)
+  void setDeferredShading(bool newVal);
+  bool getDeferredShading();
+  bool deferredShadingActive(); // on, and not overridden by a transparency mode
+  bool bindGBuffer(std::shared_ptr<TextureBuffer> albedo, std::shared_ptr<TextureBuffer> normal);
+  void resolveDeferredShading();
+
+  // Static layer: the static structures (see Structure::setStatic()), cached with their depth at the scene buffer size.
+  // bindStaticLayer() clears and binds it for drawing them, and compositeStaticLayer() copies it in to the (just
+  // cleared) scene buffer, so the dynamic structures can be drawn over it.
+  bool bindStaticLayer();
+  void compositeStaticLayer();
+  void releaseStaticLayer();
+  bool hasStaticLayer();
+
 
   // == Cached data
 
   // Materials
   std::vector<std::unique_ptr<Material>> materials;
-  Material& getMaterial(const std::string& name);
+  Material& getMaterial(const std::string& name); // loads the textures of a built-in material on first use
   void loadBlendableMaterial(std::string matName, std::array<std::string, 4> filenames);
   void loadBlendableMaterial(std::string matName, std::string filenameBase, std::string filenameExt);
   void loadStaticMaterial(std::string matName, std::string filename);
@@ -549,6 +963,8 @@ public:
   std::vector<std::unique_ptr<ValueColorMap>> colorMaps;
   const ValueColorMap& getColorMap(const std::string& name);
   void loadColorMap(std::string cmapName, std::string filename);
+  // A 1D texture of the color map, created on first use and shared by every program which samples it
+  std::shared_ptr<TextureBuffer> getColorMapTexture(const std::string& name);
 
   // Helpers
   std::vector<glm::vec3> screenTrianglesCoords(); // two triangles which cover the screen
@@ -573,15 +989,62 @@ protected:
 
   // Render state
   int ssaaFactor = 1;
+  float resolutionScale = 1.;
   bool enableFXAA = true;
-  glm::vec4 currViewport; // TODO remove global viewport size. There is no reason for this, and stops us from doing
-                          // screenshot renders while minimized.
+  glm::vec4 currViewport{0., 0., 0., 0.}; // TODO remove global viewport size. There is no reason for this, and stops
+                                          // us from doing screenshot renders while minimized.
   float currPixelScale;
+  glm::mat4 frameProjMatrix{1.};
+
+  // Temporal antialiasing history, allocated on first use. The average of the samples so far is in
+  // temporalHistoryColor[temporalHistoryInd], and the other buffer is the target for the next sample.
+  std::array<std::shared_ptr<TextureBuffer>, 2> temporalHistoryColor;
+  std::array<std::shared_ptr<FrameBuffer>, 2> temporalHistoryBuffer;
+  std::shared_ptr<ShaderProgram> temporalAccumulate;
+  int temporalHistoryInd = 0;
+  int temporalSampleCount = 0;
+
+  // Ambient occlusion programs, created on first use. The estimate goes to a transient texture from frameGraph, so the
+  // frame buffer around it only lives for the pass.
+  std::shared_ptr<ShaderProgram> ambientOcclusionEstimate, ambientOcclusionComposite;
+
+  // Deferred shading G-buffer. Its targets are transient textures from frameGraph, and the frame buffer (which shares
+  // the scene depth) is only held from bindGBuffer() to resolveDeferredShading(). The albedo alpha holds -(1 + the
+  // index of the material in `materials`), so pixels drawn without LIGHT_DEFERRED (alpha >= 0) are copied as-is.
+  bool deferredShading = false;
+  bool gBufferPassActive = false; // blending stays off while drawing in to the G-buffer
+  std::shared_ptr<FrameBuffer> gBuffer;
+  std::shared_ptr<ShaderProgram> deferredLighting;
+
+  std::vector<bool> deferredMaterialsInUse; // by material index, set by setMaterial()
+  void updateSceneObjectLightingRule();
+  // Static layer, allocated on first use
+  std::shared_ptr<FrameBuffer> staticLayerBuffer;
+  std::shared_ptr<FrameBuffer> staticLayerDepthTarget; // the scene depth alone, to copy the layer depth in to
+  std::shared_ptr<TextureBuffer> staticLayerColor, staticLayerDepth;
+  std::shared_ptr<ShaderProgram> copyStaticLayerDepth;
+
+  // Point depth sorting programs and scratch space, created on first use (see sortPointsByDepth())
+  std::shared_ptr<ShaderProgram> depthSortKeys, radixSortCount, radixSortScan, radixSortScatter;
+  std::shared_ptr<AttributeBuffer> depthSortKeysBuffer[2], depthSortValuesScratch, depthSortHistogram;
+
+  glm::mat4 frameInvProjMatrix{1.};
+  std::array<glm::vec4, maxSlicePlanes> frameSlicePlaneCenters;
+  std::array<glm::vec4, maxSlicePlanes> frameSlicePlaneNormals;
+  int frameSlicePlaneCount = 0;
+  float frameImpostorFallbackPixelSize = 0.;
+  uint64_t frameUniformsVersion = 1;
   TransparencyMode transparencyMode = TransparencyMode::None;
   int slicePlaneCount = 0;
   bool frontFaceCCW = true;
   std::vector<FrameBuffer*> renderFramebufferStack; // supports push/popBindFramebufferForRendering
 
+  // Cost accounting, filled in by backends which record it. frameCostCounters accumulates the frame in progress.
+  EngineCostCounters costCounters, frameCostCounters, lastFrameCostCounters;
+
+  // Shared color map textures, by name (see getColorMapTexture())
+  std::map<std::string, std::shared_ptr<TextureBuffer>> colorMapTextures;
+
   // Cached lazy seettings for the resolve and relight program
   int currLightingSampleLevel = -1;
   TransparencyMode currLightingTransparencyMode = TransparencyMode::None;
@@ -589,11 +1052,26 @@ protected:
   // Helpers
   void configureImGui();
   void loadDefaultMaterials();
-  void loadDefaultMaterial(std::string name);
+  void loadDefaultMaterial(Material& material);
+
+  // Built-in material images decoded on worker threads ahead of their first use (see prefetchDefaultMaterial()). The
+  // tasks write to the entries of the map, so they are declared after it and finish before it is destroyed.
+  struct DecodedMaterialImage {
+    std::vector<uint16_t> data; // RGB half floats
+    int width = 0, height = 0;
+  };
+  struct DecodedMaterial {
+    std::array<DecodedMaterialImage, 4> images;
+    std::array<int, 4> source{{0, 1, 2, 3}}; // the channel whose image each channel uses
+  };
+  std::map<std::string, DecodedMaterial> prefetchedMaterials;
+  std::unique_ptr<TaskGroup> materialPrefetchTasks;
+  void prefetchDefaultMaterial(const std::string& name);
+  static void decodeDefaultMaterial(const std::string& name, DecodedMaterial& out); // (CPU only, thread-safe)
   std::shared_ptr<TextureBuffer> loadMaterialTexture(float* data, int width, int height);
+  std::shared_ptr<TextureBuffer> loadMaterialTextureHalfFloat(const uint16_t* data, int width, int height);
   void loadDefaultColorMap(std::string name);
   void loadDefaultColorMaps();
-  virtual void createSlicePlaneFliterRule(std::string name) = 0;
 
   // Manage a unique ID, incremented on lots of operations. Used to distinguish updates to buffers/shaders/etc
   uint64_t uniqueID = 500;
@@ -602,6 +1080,7 @@ protected:
   std::vector<std::string> defaultRules_sceneObject{"GLSL_VERSION", "GLOBAL_FRAGMENT_FILTER", "LIGHT_MATCAP"};
   std::vector<std::string> defaultRules_pick{"GLSL_VERSION", "GLOBAL_FRAGMENT_FILTER", "SHADE_COLOR", "LIGHT_PASSTHRU"};
   std::vector<std::string> defaultRules_process{"GLSL_VERSION"};
+  std::vector<std::string> defaultRules_compute{"GLSL_VERSION_COMPUTE"};
 };
 
 
@@ -6,6 +6,7 @@
 #include "polyscope/view.h"
 
 #include <memory>
+#include <vector>
 
 namespace polyscope {
 namespace render {
@@ -58,6 +59,25 @@ private:
   std::array<std::shared_ptr<render::FrameBuffer>, 2> blurFrameBuffers;
   std::shared_ptr<render::ShaderProgram> blurProgram, copyTexProgram;
 
+  // the shadow map covers the scene footprint in ground plane coordinates, these map world positions to its texture
+  // coordinates
+  const unsigned int shadowMapResolution = 1024;
+  glm::vec3 shadowMapBasisU{0., 0., 0.};
+  glm::vec3 shadowMapBasisV{0., 0., 0.};
+  glm::vec2 shadowMapOffset{0., 0.};
+
+  // the shadow is re-rendered only when this changes
+  std::vector<double> shadowSignature;
+  std::vector<double> computeShadowSignature(double groundHeight);
+
+  // likewise the reflection, which also depends on the camera
+  std::vector<double> reflectionSignature;
+  std::vector<double> computeReflectionSignature(double groundHeight, unsigned int altWidth, unsigned int altHeight);
+
+  // the bottom of the scene where the ground was first placed, for options::groundPlaneHeightLocked
+  bool lockedSceneBottomValid = false;
+  double lockedSceneBottom = 0.;
+
   void populateGroundPlaneGeometry();
   bool groundPlanePrepared = false;
   // which direction the ground plane faces
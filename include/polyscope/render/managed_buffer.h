@@ -3,6 +3,9 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "polyscope/render/engine.h"
@@ -36,6 +39,8 @@ public:
   // Manage a buffer of data which gets computed lazily
   ManagedBuffer(const std::string& name, std::vector<T>& data, std::function<void()> computeFunc);
 
+  ~ManagedBuffer();
+
   // === Core members
 
   // A meaningful name for the buffer
@@ -43,8 +48,8 @@ public:
   const uint64_t uniqueID;
 
   // The raw underlying buffer which this class wraps that holds the data.
-  // It is assumed that it never changes length.
-  // External users can write directly for this buffer, but must call markHostBufferUpdated() afterward.
+  // External users can write directly for this buffer, but must call markHostBufferUpdated() afterward. It may change
+  // length (e.g. when a mesh's connectivity changes), the render buffers and views are resized to match.
   // data.size() == 0 if the data is lazily computed and has not been computed yet, or if this host-side buffer is
   // invalidated because it is being updated externally directly on the render device.
   std::vector<T>& data;
@@ -65,6 +70,20 @@ public:
 
   // == Basic interactions
 
+  // Use `n` values in externally-owned contiguous memory as the data, rather than a copy held in `data`. The memory is
+  // uploaded directly to the render buffer, and the `data` vector is left empty. The memory must stay valid and
+  // unchanged until this buffer is destroyed or its data is replaced; passing an `owner` keeps it alive for that long.
+  // If the memory is modified in-place, call markHostBufferUpdated() as usual.
+  //
+  // Anything which needs the `data` vector itself (ensureHostBufferPopulated(), building indexed views, ...) makes
+  // a copy of the external values and stops referencing the external memory. Use getPopulatedHostDataPtr() to read
+  // the values without forcing that copy.
+  void setExternalData(const T* ptr, size_t n, std::shared_ptr<const void> owner = nullptr);
+  bool hasExternalData() const;
+
+  // Like getPopulatedHostBufferRef(), but returns a pointer to the size() values, which may be external memory.
+  const T* getPopulatedHostDataPtr();
+
   // Ensure that the `data` member vector reference is populated with the current values. In the common-case where the
   // user sets data and it never changes, then this function will do nothing. However, if e.g. the value is being
   // updated directly from GPU memory, this will mirror the updates to the cpu-side vector. Also, if the value is lazily
@@ -78,18 +97,56 @@ public:
   // updates to the render buffer.
   void markHostBufferUpdated();
 
+  // Like markHostBufferUpdated(), but only the entries data[rangeStart, rangeEnd) have changed. Just that range is
+  // re-uploaded to the render buffer, along with the affected entries of any indexed views. May be called several
+  // times, once for each modified range.
+  void markHostBufferRangeUpdated(size_t rangeStart, size_t rangeEnd);
+
+  // (both of the above are deferred while an update batch is open, see beginManagedBufferUpdateBatch())
+
+  // Append values to the end of the data. Only the new values are uploaded to the render buffer (and, if this buffer
+  // holds the indices of other buffers' indexed views, only the new entries of those views are gathered), so appending
+  // repeatedly is amortized O(new values).
+  void appendData(const std::vector<T>& newValues);
+
   // Get the value at index `i`. It may be dynamically fetched from either the cpu-side `data` member or the render
   // buffer, depending on where the data currently lives.
   // If the data lives only on the device-side render buffer, this function is expensive, so don't call it in a loop.
   T getValue(size_t ind);
 
+  // Non-blocking variants of the accessors above, for data which lives only on the device-side render buffer (e.g.
+  // after markRenderAttributeBufferUpdated()). The readback is issued asynchronously, and the callback is invoked from
+  // a later render::Engine::processPendingReadbacks() (once per frame) when the GPU has finished; if the data lives
+  // in `data` the callback is invoked immediately. A few recently read values are cached until the render buffer is
+  // next updated, so repeated requests for them (and getValue()) are answered on the spot. Callbacks for reads which
+  // finish after this buffer has been destroyed are dropped.
+  void getValueAsync(size_t ind, std::function<void(T)> callback);
+  void ensureHostBufferPopulatedAsync(std::function<void()> callback);
+
+  // For UIs which are rebuilt every frame, like pick panels: if the value is available without waiting on the device,
+  // sets `val` and returns true. Otherwise requests it (see getValueAsync()) and returns false, and it will be
+  // available on a later frame.
+  bool tryGetValue(size_t ind, T& val);
+
   // If computeFunc() has already been called to populate the stored data, call it again to recompute the data, and
   // re-fill the buffer if necessary. This function is only meaningful in the case where `dataGetsComputed = true`.
   void recomputeIfPopulated();
 
   bool hasData(); // true if there is valid data on either the host or device
+
+  // True if the render buffer holds the only up-to-date copy of the data, so reading it on the host means a readback
+  bool dataIsDeviceOnly();
   size_t size();  // size of the data (number of entries)
 
+  // Bytes currently held in the host-side `data` vector, or in its compressed form (externally-owned data is not
+  // counted)
+  size_t hostSizeInBytes() const;
+
+  // Hint that the data gets updated frequently (e.g. animated geometry), so the render buffers (including indexed
+  // views) should be set up for streaming updates. Structures set this when their positions are updated.
+  void setStreaming(bool newVal);
+  bool getStreaming();
+
   // == Direct access to the GPU (device-side) render buffer
 
   // NOTE: This class follows the policy that once the render buffer is allocated, it is always immediately kept updated
@@ -104,6 +161,31 @@ public:
   // the buffer from getRenderBuffer() above.
   void markRenderAttributeBufferUpdated();
 
+  // Prepare the render buffer to be written by another API which shares the device, such as CUDA (see
+  // polyscope/cuda_interop.h), rather than uploading values from the host. The buffer is resized to hold `n` entries,
+  // tightly packed like setDataRaw(), and becomes the only copy of the data. Existing entries keep their values.
+  // Call markRenderAttributeBufferUpdated() once the writes are done; the indexed views are then re-gathered on the
+  // device. Values which are derived on the host (e.g. a mesh's normals) are not recomputed. Not available for double
+  // data, which the render buffer stores as floats.
+  std::shared_ptr<render::AttributeBuffer> getRenderAttributeBufferForDeviceWrite(size_t n);
+
+  // Drop the render buffer and any indexed views, first copying the data back to the host if that is the only copy.
+  // They are re-created on the next request. Anything else holding the buffers (such as a shader program) keeps them
+  // alive, so release those first.
+  void releaseRenderBuffers();
+
+  // Discard the data, the render buffer, and any views, as if this buffer had just been constructed. Computed data gets
+  // computed again the next time it is needed. Anything else holding the old render buffers keeps them alive.
+  void reset();
+
+  // Release the render buffers (as in releaseRenderBuffers()) and compress the host data in memory, losslessly, while
+  // it is not in use. Any access to the data decompresses it again, or decompressHostData() does so up front. Buffers
+  // holding external data or with updates deferred by an update batch are left as they are, and so is data which does
+  // not compress.
+  void compressHostData();
+  void decompressHostData();
+  bool hostDataIsCompressed() const;
+
   // == Indexed views
 
   // For some data (e.g. values a vertices of a mesh), we store the data in a canonical ordering (one value per vertex),
@@ -116,39 +198,128 @@ public:
   // handle expanding out the indexed data to populate the returned buffer. External callers can still update the data
   // directly on the host, and this class will handle updating an indexed version of the data for drawing.
   //
+  // When the `indices` buffer itself is updated, all of the views which were gathered through it are re-gathered.
+  //
   // In internally, these indexed views are cached. It is safe to call this function many times, after the first the
   // same view will be returned repeatedly at no additional cost.
   std::shared_ptr<render::AttributeBuffer> getIndexedRenderAttributeBuffer(ManagedBuffer<uint32_t>& indices);
 
+  // == Texture views
+
+  // Data which shaders look up by some element other than the vertices of the draw (e.g. per-face values fetched by
+  // primitive ID) can be read from a 2D texture instead, with entry i at texel (i % textureViewRowLength, i /
+  // textureViewRowLength). Like the render buffer, the texture is kept updated to reflect changes to the data. Only
+  // float, uint32_t (stored as floats, so exact below 2^24), and glm::vec3 data can be viewed as a texture. When the
+  // render buffer exists anyway, binding it as a buffer texture (ShaderProgram::setTextureFromAttributeBuffer())
+  // reads the same memory without this copy.
+  static const unsigned int textureViewRowLength = 2048;
+  std::shared_ptr<render::TextureBuffer> getTextureViewBuffer();
+
+  // == Sharing
+
+  // Make this buffer an alias of `source`, which must wrap the same `data` vector (e.g. when several structures share
+  // one copy of some geometry). All interactions are forwarded to the source, so the render buffer, indexed views, and
+  // texture view are the source's, and indexed views gathered through an alias are those gathered through its source.
+  // releaseRenderBuffers() and reset() on an alias leave the source alone, and its host memory is counted only for the
+  // source. The source must outlive the alias.
+  void shareFrom(ManagedBuffer<T>& source);
+  bool isShared() const;
+  ManagedBuffer<T>& canonical(); // the buffer which holds the data: the source if shared, this buffer otherwise
+
 protected:
   // == Internal members
 
-  bool hostBufferIsPopulated; // true if the host buffer contains currently-valid data
+  ManagedBuffer<T>* sharedSource = nullptr; // set by shareFrom()
+  bool hostBufferIsPopulated;               // true if the host buffer contains currently-valid data
+  bool streaming = false;
+
+  // Externally-owned data (see setExternalData()), which takes the place of `data` when set
+  const T* externalData = nullptr;
+  size_t externalDataSize = 0;
+  std::shared_ptr<const void> externalDataOwner;
+  void copyExternalDataToHost(); // copy the external values into `data`, and stop referencing the external memory
+
+  // Free the host-side data if options::hostMemoryPolicy allows it and the render buffer holds a copy. It gets read
+  // back from the render buffer if needed.
+  void releaseHostBufferIfAllowed();
+
+  // The host data while compressed (see compressHostData()), in which case `data` is empty and hostBufferIsPopulated
+  // is false
+  std::vector<uint8_t> compressedData;
+  size_t compressedDataSize = 0; // (number of entries)
+  bool hostDataCompressed = false;
+  void discardCompressedData();
 
   // A mirror of the
   std::shared_ptr<render::AttributeBuffer> renderAttributeBuffer;
 
+  // Values read back asynchronously from the render buffer, valid while it is the canonical copy (see
+  // getValueAsync()). Shared with the in-flight reads, which check `version` so they don't cache stale values, and
+  // skip caching entirely if this buffer has been destroyed.
+  struct ReadbackCache {
+    uint64_t version = 0;
+    std::unordered_map<size_t, T> values;
+    std::unordered_set<size_t> pending;
+  };
+  static const size_t maxCachedReadbackValues = 64;
+  std::shared_ptr<ReadbackCache> readbackCache;
+  void discardReadbackCache(); // the render buffer contents changed (or stopped being canonical)
+
   // == Internal representation of indexed views
   // NOTE: this seems like a problem, we are storing pointers as keys in a cache. Here, it works out because if the key
   // ptr becomes invalid, the value weak_ptr must also be invalid, and we check that before dereferencing the key.
   std::vector<std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>>
       existingIndexedViews;
   void updateIndexedViews();
+  void updateIndexedViewsRange(size_t rangeStart, size_t rangeEnd); // only entries which index in to the range
+  void updateIndexedViewsOf(uint64_t indicesID, size_t firstChanged); // only views gathered by these indices
   void removeDeletedIndexedViews();
 
+  // == Internal representation of the texture view
+  std::shared_ptr<render::TextureBuffer> textureView;
+  void updateTextureView();
+
   // == Internal helper functions
 
   void invalidateHostBuffer();
 
-  enum class CanonicalDataSource { HostData = 0, NeedsCompute, RenderBuffer };
+  // Update deferred by an update batch, flushed at the end of the batch. Covers host entries [start, end), or all of
+  // them if deferredFullUpdate.
+  bool updateDeferred = false;
+  bool deferredFullUpdate = false;
+  size_t deferredRangeStart = 0;
+  size_t deferredRangeEnd = 0;
+  bool deferUpdate(bool fullUpdate, size_t rangeStart, size_t rangeEnd); // returns true if the update was deferred
+  void flushDeferredUpdate();
+
+  enum class CanonicalDataSource { HostData = 0, Compressed, NeedsCompute, RenderBuffer };
   CanonicalDataSource currentCanonicalDataSource();
 
-  // Manage the program which copies indexed data from the renderBuffer to the indexed views
-  void ensureHaveBufferIndexCopyProgram();
-  void invokeBufferIndexCopyProgram();
-  std::shared_ptr<render::ShaderProgram> bufferIndexCopyProgram;
+  // Fill an indexed view by gathering from the render buffer on the device, if the backend supports it. The compact
+  // values are then the only thing uploaded when they change. Returns false if the view should be gathered on the host.
+  bool gatherIndexedViewOnDevice(ManagedBuffer<uint32_t>& indices, render::AttributeBuffer& view);
 };
 
 
+// Total host memory held by all live ManagedBuffers whose name starts with namePrefix, in bytes. Structures and
+// quantities name their buffers starting with their uniquePrefix(), so this gives host memory per structure/quantity.
+// The device-side counterpart is getGPUMemoryUsage().
+size_t getManagedBufferHostBytes(const std::string& namePrefix = "");
+
+// Call releaseRenderBuffers() on all live ManagedBuffers whose name starts with namePrefix
+void releaseManagedBufferRenderBuffers(const std::string& namePrefix);
+
+// Call compressHostData() or decompressHostData() on all live ManagedBuffers whose name starts with namePrefix. The
+// decompressing version returns the number of buffers which were compressed.
+void compressManagedBufferHostData(const std::string& namePrefix);
+size_t decompressManagedBufferHostData(const std::string& namePrefix);
+
+// Between these calls, markHostBufferUpdated() and markHostBufferRangeUpdated() only record that a buffer changed.
+// When the outermost batch ends, each changed buffer is uploaded (and its views re-gathered) once, however many times
+// it was updated. The render buffers are out of date in between, so do not draw or read them. Batches nest.
+// See also Structure::beginUpdate().
+void beginManagedBufferUpdateBatch();
+void endManagedBufferUpdateBatch();
+
 } // namespace render
 } // namespace polyscope
@@ -31,6 +31,10 @@ struct Material {
   std::string name;
   bool supportsRGB = false;
   std::array<std::shared_ptr<TextureBuffer>, 4> textureBuffers;
+
+  // The built-in materials are only decoded and uploaded when first used (see Engine::getMaterial())
+  bool isBuiltIn = false;
+  bool isLoaded() const { return textureBuffers[0] != nullptr; }
 };
 
 // Build an ImGui option picker in a dropdown ui
@@ -38,6 +38,22 @@ public:
   void setData(const std::vector<std::array<glm::vec3, 2>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 3>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 4>>& data) override;
+  void setDataRaw(const void* data, size_t nElements) override;
+
+  // Update a subrange of the buffer
+  void setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<float>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<double>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
 
   // get data at a single index from the buffer
   float getData_float(size_t ind) override;
@@ -63,12 +79,15 @@ public:
   std::vector<glm::uvec3> getDataRange_uvec3(size_t ind, size_t count) override;
   std::vector<glm::uvec4> getDataRange_uvec4(size_t ind, size_t count) override;
 
+  void resize(size_t newNElements) override;
+
   uint32_t getNativeBufferID() override;
 
 protected:
 private:
   void checkType(RenderDataType targetType);
   void checkArray(int arrayCount);
+  void checkRange(size_t inputSize, size_t dataStart, size_t dataEnd, size_t bufferStart);
 };
 
 class GLTextureBuffer : public TextureBuffer {
@@ -81,6 +100,10 @@ public:
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, const unsigned char* data = nullptr);
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, const float* data);
 
+  // create a 3D texture from data
+  GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
+                  const float* data);
+
   ~GLTextureBuffer() override;
 
 
@@ -95,6 +118,13 @@ public:
   std::vector<glm::vec2> getDataVector2() override;
   std::vector<glm::vec3> getDataVector3() override;
 
+  void setDataRegion(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                     const float* data) override;
+  void setDataRegionHalfFloat(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                              const uint16_t* data) override;
+  void setDataRegion3D(unsigned int xStart, unsigned int yStart, unsigned int zStart, unsigned int w, unsigned int h,
+                       unsigned int d, const float* data) override;
+
   void bind();
 
 protected:
@@ -127,6 +157,7 @@ public:
 
   // Clear to redraw
   void clear() override;
+  void clearRegion(int startX, int startY, unsigned int sizeX, unsigned int sizeY) override;
 
   // Bind to textures/renderbuffers for output
   void addColorBuffer(std::shared_ptr<RenderBuffer> renderBuffer) override;
@@ -139,7 +170,9 @@ public:
   // Query pixels
   std::vector<unsigned char> readBuffer() override;
   std::array<float, 4> readFloat4(int xPos, int yPos) override;
+  std::vector<float> readFloat4Region(int xPos, int yPos, int sizeX, int sizeY) override;
   float readDepth(int xPos, int yPos) override;
+  std::vector<float> readDepthRegion(int xPos, int yPos, int sizeX, int sizeY) override;
   void blitTo(FrameBuffer* other) override;
 
   // Getters
@@ -159,6 +192,7 @@ struct GLShaderAttribute {
   RenderDataType type;
   int arrayCount;
   std::shared_ptr<GLAttributeBuffer> buff; // the buffer that we will actually use
+  bool perInstance;                        // advance once per instance, see setAttributePerInstance()
 };
 
 struct GLShaderTexture {
@@ -168,6 +202,14 @@ struct GLShaderTexture {
   bool isSet;
   GLTextureBuffer* textureBuffer;
   std::shared_ptr<GLTextureBuffer> textureBufferOwned; // might be empty, if texture isn't owned
+  std::string colormapName;                            // if set from a colormap, which one (else empty)
+  std::shared_ptr<GLAttributeBuffer> attributeBuffer;  // if read as a buffer texture, the buffer (else null)
+};
+
+struct GLShaderStorageBuffer {
+  std::string name;
+  RenderDataType type;
+  std::shared_ptr<GLAttributeBuffer> buff; // null until set
 };
 
 // A thin wrapper around a program handle.
@@ -181,12 +223,14 @@ public:
   std::vector<GLShaderUniform> getUniforms() const { return uniforms; }
   std::vector<GLShaderAttribute> getAttributes() const { return attributes; }
   std::vector<GLShaderTexture> getTextures() const { return textures; }
+  std::vector<GLShaderStorageBuffer> getStorageBuffers() const { return storageBuffers; }
 
 private:
   DrawMode drawMode;
   std::vector<GLShaderUniform> uniforms;
   std::vector<GLShaderAttribute> attributes;
   std::vector<GLShaderTexture> textures;
+  std::vector<GLShaderStorageBuffer> storageBuffers;
 
   void compileGLProgram(const std::vector<ShaderStageSpecification>& stages);
   void setDataLocations();
@@ -194,6 +238,7 @@ private:
   void addUniqueAttribute(ShaderSpecAttribute attribute);
   void addUniqueUniform(ShaderSpecUniform uniform);
   void addUniqueTexture(ShaderSpecTexture texture);
+  void addUniqueStorageBuffer(ShaderSpecStorageBuffer storageBuffer);
 };
 
 class GLShaderProgram : public ShaderProgram {
@@ -206,6 +251,7 @@ public:
   // If update is set to "true", data is updated rather than allocated (must be allocated first)
 
   // Uniforms
+  using ShaderProgram::setUniform;
   bool hasUniform(std::string name) override;
   void setUniform(std::string name, int val) override;
   void setUniform(std::string name, unsigned int val) override;
@@ -220,6 +266,22 @@ public:
   void setUniform(std::string name, glm::uvec2 val) override;
   void setUniform(std::string name, glm::uvec3 val) override;
   void setUniform(std::string name, glm::uvec4 val) override;
+  UniformHandle getUniformHandle(const std::string& name) override;
+  UniformHandle getUniformHandle(const char* name) override;
+  bool hasUniform(UniformHandle handle) override;
+  void setUniform(UniformHandle handle, int val) override;
+  void setUniform(UniformHandle handle, unsigned int val) override;
+  void setUniform(UniformHandle handle, float val) override;
+  void setUniform(UniformHandle handle, double val) override; // WARNING casts down to float
+  void setUniform(UniformHandle handle, float* val) override;
+  void setUniform(UniformHandle handle, glm::vec2 val) override;
+  void setUniform(UniformHandle handle, glm::vec3 val) override;
+  void setUniform(UniformHandle handle, glm::vec4 val) override;
+  void setUniform(UniformHandle handle, std::array<float, 3> val) override;
+  void setUniform(UniformHandle handle, float x, float y, float z, float w) override;
+  void setUniform(UniformHandle handle, glm::uvec2 val) override;
+  void setUniform(UniformHandle handle, glm::uvec3 val) override;
+  void setUniform(UniformHandle handle, glm::uvec4 val) override;
 
   // = Attributes
   // clang-format off
@@ -227,6 +289,7 @@ public:
   bool attributeIsSet(std::string name) override;
   std::shared_ptr<AttributeBuffer> getAttributeBuffer(std::string name) override;
   void setAttribute(std::string name, std::shared_ptr<AttributeBuffer> externalBuffer) override; 
+  void setAttributePerInstance(std::string name) override;
   void setAttribute(std::string name, const std::vector<glm::vec2>& data) override;
   void setAttribute(std::string name, const std::vector<glm::vec3>& data) override;
   void setAttribute(std::string name, const std::vector<glm::vec4>& data) override;
@@ -247,6 +310,7 @@ public:
   void setIndex(std::vector<std::array<unsigned int, 3>>& indices) override;
   void setIndex(std::vector<unsigned int>& indices) override;
   void setIndex(std::vector<glm::uvec3>& indices) override;
+  void setIndex(std::shared_ptr<AttributeBuffer> indices) override;
   void setPrimitiveRestartIndex(unsigned int restartIndex) override;
 
   // Textures
@@ -257,9 +321,16 @@ public:
                     bool withAlpha = true, bool useMipMap = false, bool repeat = false) override;
   void setTextureFromColormap(std::string name, const std::string& colorMap, bool allowUpdate = false) override;
   void setTextureFromBuffer(std::string name, TextureBuffer* textureBuffer) override;
+  void setTextureFromAttributeBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) override;
+
+  // Storage buffers
+  bool hasStorageBuffer(std::string name) override;
+  bool storageBufferIsSet(std::string name) override;
+  void setStorageBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) override;
 
   // Draw!
   void draw() override;
+  void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
   void validateData() override;
 
 protected:
@@ -267,6 +338,7 @@ protected:
   std::vector<GLShaderUniform> uniforms;
   std::vector<GLShaderAttribute> attributes;
   std::vector<GLShaderTexture> textures;
+  std::vector<GLShaderStorageBuffer> storageBuffers;
 
 private:
   // Setup routines
@@ -277,6 +349,10 @@ private:
   void ensureBufferExists(GLShaderAttribute& a);
   void createBuffer(GLShaderAttribute& a);
   void assignBufferToVAO(GLShaderAttribute& a);
+  GLShaderUniform& getUniform(UniformHandle handle); // throws if invalid
+
+  // Largest entry of the index buffer set with setIndex(), checked against the attribute sizes when drawing
+  int64_t maxIndex = -1;
 
   // Drawing related
   void activateTextures();
@@ -323,6 +399,7 @@ public:
   void shutdownImGui() override;
   void ImGuiNewFrame() override;
   void ImGuiRender() override;
+  void ImGuiRenderLast() override;
 
   // === Factory methods
 
@@ -338,6 +415,8 @@ public:
                                                        const unsigned char* data = nullptr) override; // 2d
   std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
                                                        const float* data) override; // 2d
+  std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
+                                                       unsigned int sizeZ_, const float* data) override; // 3d
 
   // create render buffers
   std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -354,17 +433,24 @@ public:
 
   // Add a shader programs/rules so that they can be requested above
   void registerShaderProgram(const std::string& name, const std::vector<ShaderStageSpecification>& spec,
-                             const DrawMode& dm);
-  void registerShaderRule(const std::string& name, const ShaderReplacementRule& rule);
+                             const DrawMode& dm) override;
+  void registerShaderRule(const std::string& name, const ShaderReplacementRule& rule) override;
 
   // Transparency
   virtual void applyTransparencySettings() override;
 
   virtual void setFrontFaceCCW(bool newVal) override;
 
+  // Cost accounting (see Engine::getCostCounters())
+  void countUpload(const std::string& owner, size_t nBytes);
+  void countDrawCall();
+  void countComputeDispatch();
+  void countShaderCompilation();
+  void countStateChange();
+  void countAllocation();
+
 protected:
   // Helpers
-  virtual void createSlicePlaneFliterRule(std::string name) override;
 
   // Shader program & rule caches
   std::unordered_map<std::string, std::pair<std::vector<ShaderStageSpecification>, DrawMode>> registeredShaderPrograms;
@@ -372,6 +458,9 @@ protected:
   void populateDefaultShadersAndRules();
 
   std::unordered_map<std::string, std::shared_ptr<GLCompiledProgram>> compiledProgamCache;
+  // Second-level cache keyed on the final stages (see programKeyFromStages()), so that different rule lists which
+  // produce the same source share one compiled program
+  std::unordered_map<std::string, std::shared_ptr<GLCompiledProgram>> compiledProgramSourceCache;
   std::string programKeyFromRules(const std::string& programName, const std::vector<std::string>& rules,
                                   ShaderReplacementDefaults defaults);
   std::shared_ptr<GLCompiledProgram> getCompiledProgram(const std::string& programName,
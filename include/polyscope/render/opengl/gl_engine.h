@@ -22,11 +22,17 @@
 #include <GLFW/glfw3native.h>
 #endif
 
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 #include "imgui.h"
 #define IMGUI_IMPL_OPENGL_LOADER_GLAD
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
+#include <deque>
 #include <unordered_map>
 
 // Note: DO NOT include this header throughout polyscope, and do not directly make openGL calls. This header should only
@@ -75,6 +81,22 @@ public:
   void setData(const std::vector<std::array<glm::vec3, 2>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 3>>& data) override;
   void setData(const std::vector<std::array<glm::vec3, 4>>& data) override;
+  void setDataRaw(const void* data, size_t nElements) override;
+
+  // Update a subrange of the buffer
+  void setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<float>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<double>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
+  void setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t dataEnd, size_t bufferStart) override;
 
   // get data at a single index from the buffer
   float getData_float(size_t ind) override;
@@ -100,6 +122,11 @@ public:
   std::vector<glm::uvec3> getDataRange_uvec3(size_t ind, size_t count) override;
   std::vector<glm::uvec4> getDataRange_uvec4(size_t ind, size_t count) override;
 
+  // Copies the range on the device in to a fresh buffer, which gets mapped once the copy has finished
+  void getDataRangeRawAsync(size_t ind, size_t count, std::function<void(const void*)> callback) override;
+
+  void resize(size_t newNElements) override;
+
   uint32_t getNativeBufferID() override;
 
 protected:
@@ -109,6 +136,13 @@ private:
   void checkType(RenderDataType targetType);
   void checkArray(int arrayCount);
   GLenum getTarget();
+  GLenum getUsage();
+  void allocateFullBuffer(size_t nBytes, const void* dataPtr); // allocate exactly nBytes, and fill them
+  void updateFullBuffer(size_t nBytes, const void* dataPtr);   // replace the contents, growing if needed
+  size_t capacityBytes = 0;
+
+  template <typename T>
+  void setDataRangeHelper(const std::vector<T>& data, size_t dataStart, size_t dataEnd, size_t bufferStart);
 };
 
 class GLTextureBuffer : public TextureBuffer {
@@ -121,6 +155,10 @@ public:
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, const unsigned char* data = nullptr);
   GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, const float* data);
 
+  // create a 3D texture from data
+  GLTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
+                  const float* data);
+
   ~GLTextureBuffer() override;
 
 
@@ -135,6 +173,13 @@ public:
   std::vector<glm::vec2> getDataVector2() override;
   std::vector<glm::vec3> getDataVector3() override;
 
+  void setDataRegion(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                     const float* data) override;
+  void setDataRegionHalfFloat(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                              const uint16_t* data) override;
+  void setDataRegion3D(unsigned int xStart, unsigned int yStart, unsigned int zStart, unsigned int w, unsigned int h,
+                       unsigned int d, const float* data) override;
+
   void bind();
   GLenum textureType();
   TextureBufferHandle getHandle() const { return handle; }
@@ -172,6 +217,7 @@ public:
 
   // Clear to redraw
   void clear() override;
+  void clearRegion(int startX, int startY, unsigned int sizeX, unsigned int sizeY) override;
 
   // Bind to textures/renderbuffers for output
   void addColorBuffer(std::shared_ptr<RenderBuffer> renderBuffer) override;
@@ -184,8 +230,14 @@ public:
   // Query pixels
   std::vector<unsigned char> readBuffer() override;
   std::array<float, 4> readFloat4(int xPos, int yPos) override;
+  std::vector<float> readFloat4Region(int xPos, int yPos, int sizeX, int sizeY) override;
   float readDepth(int xPos, int yPos) override;
+  std::vector<float> readDepthRegion(int xPos, int yPos, int sizeX, int sizeY) override;
   void blitTo(FrameBuffer* other) override;
+  void readFloat4Async(int xPos, int yPos, std::function<void(std::array<float, 4>)> callback) override;
+  void readBufferAsync(std::function<void(std::vector<unsigned char>)> callback) override;
+  void readDepthRegionAsync(int xPos, int yPos, int sizeX, int sizeY,
+                            std::function<void(std::vector<float>)> callback) override;
 
   // Getters
   FrameBufferHandle getHandle() const { return handle; }
@@ -207,6 +259,7 @@ struct GLShaderAttribute {
   int arrayCount;
   AttributeLocation location;              // -1 means "no location", usually because it was optimized out
   std::shared_ptr<GLAttributeBuffer> buff; // the buffer that we will actually use
+  bool perInstance;                        // advance once per instance, see setAttributePerInstance()
 };
 
 struct GLShaderTexture {
@@ -217,6 +270,18 @@ struct GLShaderTexture {
   GLTextureBuffer* textureBuffer;
   std::shared_ptr<GLTextureBuffer> textureBufferOwned; // might be empty, if texture isn't owned
   TextureLocation location;                            // -1 means "no location", usually because it was optimized out
+  std::string colormapName;                            // if set from a colormap, which one (else empty)
+  std::shared_ptr<GLAttributeBuffer> attributeBuffer;  // if read as a buffer texture, the buffer (else null)
+  TextureBufferHandle bufferTextureHandle;             // the buffer texture over it, owned by the program (or 0)
+  VertexBufferHandle bufferTextureSource;              // the buffer handle the texture was last attached to
+};
+
+struct GLShaderStorageBuffer {
+  std::string name;
+  RenderDataType type;
+  uint32_t binding;                        // the indexed GL_SHADER_STORAGE_BUFFER binding point
+  bool active;                             // false if the block was optimized out
+  std::shared_ptr<GLAttributeBuffer> buff; // null until set
 };
 
 // A thin wrapper around a program handle.
@@ -226,11 +291,18 @@ public:
   GLCompiledProgram(const std::vector<ShaderStageSpecification>& stages, DrawMode dm);
   ~GLCompiledProgram();
 
+  // The constructor only issues the compile. If the driver supports KHR_parallel_shader_compile it proceeds in the
+  // background, and isCompileComplete() polls it without blocking. finishCompile() waits for it, checks for errors
+  // and looks up the data locations; it must be called before the program is used.
+  bool isCompileComplete();
+  void finishCompile();
+
   ProgramHandle getHandle() const { return programHandle; }
   DrawMode getDrawMode() const { return drawMode; }
   std::vector<GLShaderUniform> getUniforms() const { return uniforms; }
   std::vector<GLShaderAttribute> getAttributes() const { return attributes; }
   std::vector<GLShaderTexture> getTextures() const { return textures; }
+  std::vector<GLShaderStorageBuffer> getStorageBuffers() const { return storageBuffers; }
 
 private:
   ProgramHandle programHandle;
@@ -238,6 +310,11 @@ private:
   std::vector<GLShaderUniform> uniforms;
   std::vector<GLShaderAttribute> attributes;
   std::vector<GLShaderTexture> textures;
+  std::vector<GLShaderStorageBuffer> storageBuffers;
+
+  bool compileFinished = false;
+  std::vector<std::pair<ShaderHandle, std::string>> pendingShaders; // (handle, source) until finishCompile()
+  std::string binaryCacheKey; // set if the linked program should be saved to the on-disk cache
 
   void compileGLProgram(const std::vector<ShaderStageSpecification>& stages);
   void setDataLocations();
@@ -245,6 +322,7 @@ private:
   void addUniqueAttribute(ShaderSpecAttribute attribute);
   void addUniqueUniform(ShaderSpecUniform uniform);
   void addUniqueTexture(ShaderSpecTexture texture);
+  void addUniqueStorageBuffer(ShaderSpecStorageBuffer storageBuffer);
 };
 
 class GLShaderProgram : public ShaderProgram {
@@ -257,6 +335,7 @@ public:
   // If update is set to "true", data is updated rather than allocated (must be allocated first)
 
   // Uniforms
+  using ShaderProgram::setUniform;
   bool hasUniform(std::string name) override;
   void setUniform(std::string name, int val) override;
   void setUniform(std::string name, unsigned int val) override;
@@ -271,6 +350,22 @@ public:
   void setUniform(std::string name, glm::uvec2 val) override;
   void setUniform(std::string name, glm::uvec3 val) override;
   void setUniform(std::string name, glm::uvec4 val) override;
+  UniformHandle getUniformHandle(const std::string& name) override;
+  UniformHandle getUniformHandle(const char* name) override;
+  bool hasUniform(UniformHandle handle) override;
+  void setUniform(UniformHandle handle, int val) override;
+  void setUniform(UniformHandle handle, unsigned int val) override;
+  void setUniform(UniformHandle handle, float val) override;
+  void setUniform(UniformHandle handle, double val) override; // WARNING casts down to float
+  void setUniform(UniformHandle handle, float* val) override;
+  void setUniform(UniformHandle handle, glm::vec2 val) override;
+  void setUniform(UniformHandle handle, glm::vec3 val) override;
+  void setUniform(UniformHandle handle, glm::vec4 val) override;
+  void setUniform(UniformHandle handle, std::array<float, 3> val) override;
+  void setUniform(UniformHandle handle, float x, float y, float z, float w) override;
+  void setUniform(UniformHandle handle, glm::uvec2 val) override;
+  void setUniform(UniformHandle handle, glm::uvec3 val) override;
+  void setUniform(UniformHandle handle, glm::uvec4 val) override;
 
   // = Attributes
   // clang-format off
@@ -278,6 +373,7 @@ public:
   bool attributeIsSet(std::string name) override;
   std::shared_ptr<AttributeBuffer> getAttributeBuffer(std::string name) override;
   void setAttribute(std::string name, std::shared_ptr<AttributeBuffer> externalBuffer) override; 
+  void setAttributePerInstance(std::string name) override;
   void setAttribute(std::string name, const std::vector<glm::vec2>& data) override;
   void setAttribute(std::string name, const std::vector<glm::vec3>& data) override;
   void setAttribute(std::string name, const std::vector<glm::vec4>& data) override;
@@ -298,6 +394,7 @@ public:
   void setIndex(std::vector<std::array<unsigned int, 3>>& indices) override;
   void setIndex(std::vector<unsigned int>& indices) override;
   void setIndex(std::vector<glm::uvec3>& indices) override;
+  void setIndex(std::shared_ptr<AttributeBuffer> indices) override;
   void setPrimitiveRestartIndex(unsigned int restartIndex) override;
 
   // Textures
@@ -308,16 +405,27 @@ public:
                     bool withAlpha = true, bool useMipMap = false, bool repeat = false) override;
   void setTextureFromColormap(std::string name, const std::string& colorMap, bool allowUpdate = false) override;
   void setTextureFromBuffer(std::string name, TextureBuffer* textureBuffer) override;
+  void setTextureFromAttributeBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) override;
+
+  // Storage buffers
+  bool hasStorageBuffer(std::string name) override;
+  bool storageBufferIsSet(std::string name) override;
+  void setStorageBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) override;
 
   // Draw!
   void draw() override;
+  void dispatch(uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1) override;
   void validateData() override;
 
+  // Name used to profile this program's draws, set by GLEngine::requestShader()
+  std::string timerName = "shader";
+
 protected:
   // Lists of attributes and uniforms that need to be set
   std::vector<GLShaderUniform> uniforms;
   std::vector<GLShaderAttribute> attributes;
   std::vector<GLShaderTexture> textures;
+  std::vector<GLShaderStorageBuffer> storageBuffers;
 
 private:
   // Setup routines
@@ -328,9 +436,11 @@ private:
   void ensureBufferExists(GLShaderAttribute& a);
   void createBuffer(GLShaderAttribute& a);
   void assignBufferToVAO(GLShaderAttribute& a);
+  GLShaderUniform& getUniform(UniformHandle handle); // throws if invalid
 
   // Drawing related
   void activateTextures();
+  void bindStorageBuffers();
 
   // GL pointers for various useful things
   std::shared_ptr<GLCompiledProgram> compiledProgram;
@@ -339,16 +449,55 @@ private:
 };
 
 
+// An in-flight asynchronous read from a framebuffer or attribute buffer in to a pixel buffer object
+struct GLPendingReadback {
+  unsigned int pboHandle;
+  GLsync fence;
+  size_t nBytes;
+  std::function<void(const void*)> deliver; // called with the mapped buffer contents once the read has finished
+};
+
+// A pair of timestamp queries bracketing some GPU work, see Engine::beginGPUTimer()
+struct GLGPUTimer {
+  size_t timerID;
+  uint64_t frame;
+  unsigned int startQuery;
+  unsigned int endQuery;
+};
+
 class GLEngine : public Engine {
 public:
-  GLEngine();
+  // A headless engine renders with an EGL context and no window (see initializeRenderEngineHeadlessEGL())
+  GLEngine(bool headless = false);
 
   // High-level control
   void initialize();
+  bool isHeadless() const { return headless; }
   void checkError(bool fatal = false) override;
 
   void swapDisplayBuffers() override;
   std::vector<unsigned char> readDisplayBuffer() override;
+  void processPendingReadbacks(bool blockUntilDone = false) override;
+  bool hasPendingReadbacks() override;
+  bool supportsAttributeBufferGather() override;
+  bool gatherAttributeBuffer(AttributeBuffer& source, AttributeBuffer& indices, AttributeBuffer& target) override;
+  bool supportsAttributeBufferBlend() override;
+  bool blendAttributeBuffers(AttributeBuffer& a, AttributeBuffer& b, float t, bool normalize,
+                             AttributeBuffer& target) override;
+  bool supportsMeshGeometryCompute() override;
+  bool computeMeshGeometry(AttributeBuffer& positions, AttributeBuffer& faceIndsStart, AttributeBuffer& faceIndsEntries,
+                           AttributeBuffer& vertexFaceAdjStart, AttributeBuffer& vertexFaceAdjEntries,
+                           AttributeBuffer* faceNormals, AttributeBuffer* faceCenters,
+                           AttributeBuffer* vertexNormals) override;
+  void beginGPUTimer(size_t timerID, uint64_t frame) override;
+  void endGPUTimer() override;
+  uint64_t collectGPUTimers(std::vector<GPUTimerResult>& results) override;
+  bool supportsOcclusionQueries() override;
+  void beginOcclusionQuery(size_t queryID) override;
+  void endOcclusionQuery() override;
+  bool getOcclusionQueryResult(size_t queryID, bool& anySamplesPassed) override;
+  bool supportsComputeShaders() override;
+  void memoryBarrier(MemoryBarrierType type = MemoryBarrierType::All) override;
 
   // Manage render state
   void setDepthMode(DepthMode newMode = DepthMode::Less) override;
@@ -358,6 +507,7 @@ public:
 
   // === Windowing and framework things
   void makeContextCurrent() override;
+  void releaseContext() override;
   void focusWindow() override;
   void showWindow() override;
   void hideWindow() override;
@@ -368,6 +518,10 @@ public:
   std::tuple<int, int> getWindowPos() override;
   bool windowRequestsClose() override;
   void pollEvents() override;
+  bool waitEvents(double timeoutSeconds) override;
+  void wakeEventWait() override;
+  bool sampleCursorPosition(glm::vec2& pos) override;
+  uint64_t getInputEventCount() override;
   bool isKeyPressed(char c) override; // for lowercase a-z and 0-9 only
   std::string getClipboardText() override;
   void setClipboardText(std::string text) override;
@@ -377,6 +531,7 @@ public:
   void shutdownImGui() override;
   void ImGuiNewFrame() override;
   void ImGuiRender() override;
+  void ImGuiRenderLast() override;
 
   // === Factory methods
 
@@ -392,6 +547,8 @@ public:
                                                        const unsigned char* data = nullptr) override; // 2d
   std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
                                                        const float* data) override; // 2d
+  std::shared_ptr<TextureBuffer> generateTextureBuffer(TextureFormat format, unsigned int sizeX_, unsigned int sizeY_,
+                                                       unsigned int sizeZ_, const float* data) override; // 3d
 
   // create render buffers
   std::shared_ptr<RenderBuffer> generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
@@ -408,8 +565,14 @@ public:
 
   // Add a shader programs/rules so that they can be requested above
   void registerShaderProgram(const std::string& name, const std::vector<ShaderStageSpecification>& spec,
-                             const DrawMode& dm);
-  void registerShaderRule(const std::string& name, const ShaderReplacementRule& rule);
+                             const DrawMode& dm) override;
+  void registerShaderRule(const std::string& name, const ShaderReplacementRule& rule) override;
+
+  // Async readbacks issued by framebuffers, delivered in processPendingReadbacks()
+  void addPendingReadback(GLPendingReadback readback);
+
+  // Upload the frame-global uniforms to the shared uniform block, if they changed since the last upload
+  void uploadFrameUniforms();
 
   // Transparency
   virtual void applyTransparencySettings() override;
@@ -418,10 +581,18 @@ public:
 
 protected:
   // Helpers
-  virtual void createSlicePlaneFliterRule(std::string name) override;
 
   // Internal windowing and engine details
-  GLFWwindow* mainWindow = nullptr;
+  const bool headless;
+  GLFWwindow* mainWindow = nullptr; // null if headless
+  void initializeGLFWContext();
+  void initializeEGLContext();
+  int appliedSwapInterval = 1; // options::swapInterval, as last applied
+  void applySwapInterval();
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+  EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+  EGLContext eglContext = EGL_NO_CONTEXT;
+#endif
 
   // Shader program & rule caches
   std::unordered_map<std::string, std::pair<std::vector<ShaderStageSpecification>, DrawMode>> registeredShaderPrograms;
@@ -429,11 +600,51 @@ protected:
   void populateDefaultShadersAndRules();
 
   std::unordered_map<std::string, std::shared_ptr<GLCompiledProgram>> compiledProgamCache;
+  // Second-level cache keyed on the final stages (see programKeyFromStages()), so that different rule lists which
+  // produce the same source share one compiled program
+  std::unordered_map<std::string, std::shared_ptr<GLCompiledProgram>> compiledProgramSourceCache;
   std::string programKeyFromRules(const std::string& programName, const std::vector<std::string>& rules,
                                   ShaderReplacementDefaults defaults);
   std::shared_ptr<GLCompiledProgram> getCompiledProgram(const std::string& programName,
                                                         const std::vector<std::string>& customRules,
                                                         ShaderReplacementDefaults defaults);
+
+  std::vector<GLPendingReadback> pendingReadbacks;
+
+  unsigned int frameUniformBuffer = 0;
+  uint64_t uploadedFrameUniformsVersion = 0;
+
+  // GPU timers. Timestamp queries (rather than GL_TIME_ELAPSED) are used since they may nest, and finished queries are
+  // recycled so none are created in the steady state.
+  std::vector<unsigned int> freeTimerQueries;
+  std::vector<GLGPUTimer> openGPUTimers;    // started but not yet ended, innermost last
+  std::deque<GLGPUTimer> pendingGPUTimers; // ended, in the order they were issued
+  unsigned int getTimerQuery();
+
+  std::vector<unsigned int> occlusionQueries; // by query ID, created on first use
+
+  // Transform feedback programs for gatherAttributeBuffer(), by the number of 32-bit words per element. The source is
+  // read through a buffer texture, since vertex attributes can't be fetched at arbitrary indices.
+  std::unordered_map<size_t, unsigned int> gatherPrograms;
+  unsigned int gatherVAO = 0;
+  unsigned int gatherSourceTexture = 0;
+  bool gatherFailed = false; // a gather program failed to build, always gather on the host
+  unsigned int getGatherProgram(size_t nWords);
+
+  // Transform feedback program for blendAttributeBuffers()
+  unsigned int blendProgram = 0;
+  unsigned int blendVAO = 0;
+  bool blendFailed = false;
+
+  // Transform feedback programs for computeMeshGeometry(), one over the faces and one over the vertices. The mesh data
+  // is read through buffer textures; the face areas (and any face outputs which weren't asked for) go to scratch
+  // buffers.
+  unsigned int meshFaceGeometryProgram = 0;
+  unsigned int meshVertexNormalProgram = 0;
+  unsigned int meshGeometryVAO = 0;
+  std::array<unsigned int, 4> meshGeometryTextures{};
+  std::shared_ptr<AttributeBuffer> meshGeometryScratchNormals, meshGeometryScratchCenters, meshGeometryAreas;
+  bool meshGeometryFailed = false;
 };
 
 } // namespace backend_openGL3_glfw
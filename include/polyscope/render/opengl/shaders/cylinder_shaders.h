@@ -12,6 +12,9 @@ namespace backend_openGL3_glfw {
 extern const ShaderStageSpecification FLEX_CYLINDER_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_CYLINDER_GEOM_SHADER;
 extern const ShaderStageSpecification FLEX_CYLINDER_FRAG_SHADER;
+extern const ShaderStageSpecification FLEX_CYLINDER_INDEXED_VERT_SHADER;
+extern const ShaderStageSpecification FLEX_CYLINDER_INDEXED_GEOM_SHADER;
+extern const ShaderStageSpecification FLEX_CYLINDER_INSTANCED_VERT_SHADER; // (no geometry shader, see source)
 
 // Rules specific to cylinders
 extern const ShaderReplacementRule CYLINDER_PROPAGATE_VALUE;
@@ -19,8 +22,21 @@ extern const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_VALUE;
 extern const ShaderReplacementRule CYLINDER_PROPAGATE_COLOR;
 extern const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_COLOR;
 extern const ShaderReplacementRule CYLINDER_PROPAGATE_PICK;
+extern const ShaderReplacementRule CYLINDER_PROPAGATE_SUBSET_INDEX;
 extern const ShaderReplacementRule CYLINDER_CULLPOS_FROM_MID;
 extern const ShaderReplacementRule CYLINDER_VARIABLE_SIZE;
+extern const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE;
+extern const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR;
+extern const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_PICK;
+extern const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX;
+extern const ShaderReplacementRule CYLINDER_INDEXED_VARIABLE_SIZE;
+extern const ShaderReplacementRule CYLINDER_PROPAGATE_VALUE_INSTANCED;
+extern const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_VALUE_INSTANCED;
+extern const ShaderReplacementRule CYLINDER_PROPAGATE_COLOR_INSTANCED;
+extern const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_COLOR_INSTANCED;
+extern const ShaderReplacementRule CYLINDER_PROPAGATE_PICK_INSTANCED;
+extern const ShaderReplacementRule CYLINDER_PROPAGATE_SUBSET_INDEX_INSTANCED;
+extern const ShaderReplacementRule CYLINDER_VARIABLE_SIZE_INSTANCED;
 
 
 } // namespace backend_openGL3_glfw
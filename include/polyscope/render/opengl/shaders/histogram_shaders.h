@@ -12,6 +12,10 @@ namespace backend_openGL3_glfw {
 extern const ShaderStageSpecification HISTOGRAM_VERT_SHADER;
 extern const ShaderStageSpecification HISTOGRAM_FRAG_SHADER;
 
+// Counts values in to bins on the GPU, one pixel per bin
+extern const ShaderStageSpecification HISTOGRAM_BIN_VERT_SHADER;
+extern const ShaderStageSpecification HISTOGRAM_BIN_FRAG_SHADER;
+
 // Rules
 // extern const ShaderReplacementRule RULE_NAME;
 
@@ -20,6 +20,7 @@ extern const ShaderReplacementRule DOWNSAMPLE_RESOLVE_4;
 extern const ShaderReplacementRule TRANSPARENCY_RESOLVE_SIMPLE;
 extern const ShaderReplacementRule TRANSPARENCY_STRUCTURE;
 extern const ShaderReplacementRule TRANSPARENCY_PEEL_STRUCTURE;
+extern const ShaderReplacementRule TRANSPARENCY_WEIGHTED_STRUCTURE;
 extern const ShaderReplacementRule TRANSPARENCY_PEEL_GROUND;
 
 } // namespace backend_openGL3_glfw
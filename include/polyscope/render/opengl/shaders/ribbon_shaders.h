@@ -12,9 +12,19 @@ namespace backend_openGL3_glfw {
 extern const ShaderStageSpecification RIBBON_VERT_SHADER;
 extern const ShaderStageSpecification RIBBON_GEOM_SHADER;
 extern const ShaderStageSpecification RIBBON_FRAG_SHADER;
+extern const ShaderStageSpecification RIBBON_TUBE_VERT_SHADER;
+extern const ShaderStageSpecification RIBBON_TUBE_GEOM_SHADER;
+extern const ShaderStageSpecification RIBBON_TUBE_FRAG_SHADER;
 
 // Rules
-// extern const ShaderReplacementRule RULE_NAME;
+extern const ShaderReplacementRule TUBE_PROPAGATE_BLEND_VALUE;
+extern const ShaderReplacementRule TUBE_PROPAGATE_VALUE;
+extern const ShaderReplacementRule TUBE_PROPAGATE_BLEND_COLOR;
+extern const ShaderReplacementRule TUBE_PROPAGATE_COLOR;
+extern const ShaderReplacementRule TUBE_PROPAGATE_PICK;
+extern const ShaderReplacementRule TUBE_PROPAGATE_SUBSET_INDEX;
+extern const ShaderReplacementRule TUBE_CULLPOS_FROM_MID;
+extern const ShaderReplacementRule TUBE_VARIABLE_SIZE;
 
 } // namespace backend_openGL3_glfw
 } // namespace render
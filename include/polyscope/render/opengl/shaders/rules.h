@@ -11,8 +11,10 @@ namespace render {
 namespace backend_openGL3_glfw {
 
 extern const ShaderReplacementRule GLSL_VERSION;
+extern const ShaderReplacementRule GLSL_VERSION_COMPUTE;
 extern const ShaderReplacementRule GLOBAL_FRAGMENT_FILTER;
 extern const ShaderReplacementRule LIGHT_MATCAP;
+extern const ShaderReplacementRule LIGHT_DEFERRED;
 extern const ShaderReplacementRule LIGHT_PASSTHRU;
 
 
@@ -22,6 +24,7 @@ extern const ShaderReplacementRule SHADE_BASECOLOR;             // constant from
 extern const ShaderReplacementRule SHADE_COLOR;                 // from shadeColor
 extern const ShaderReplacementRule SHADE_COLORMAP_VALUE;        // colormapped from shadeValue
 extern const ShaderReplacementRule SHADE_COLORMAP_ANGULAR2;     // colormapped from angle of shadeValue2
+extern const ShaderReplacementRule SHADE_LABEL_TABLE;           // looked up from shadeLabelIndex, hidden ones discarded
 extern const ShaderReplacementRule SHADE_GRID_VALUE2;           // generate a two-color grid with lines from shadeValue2
 extern const ShaderReplacementRule SHADE_CHECKER_VALUE2;        // generate a two-color checker from shadeValue2
 extern const ShaderReplacementRule SHADEVALUE_MAG_VALUE2;       // generate a shadeValue from the magnitude of shadeValue2
@@ -32,7 +35,10 @@ extern const ShaderReplacementRule CHECKER_VALUE2COLOR;         // modulate albe
 extern const ShaderReplacementRule GENERATE_VIEW_POS;          // computes viewPos, position in viewspace for fragment
 extern const ShaderReplacementRule CULL_POS_FROM_VIEW;
 
-ShaderReplacementRule generateSlicePlaneRule(std::string uniquePostfix);
+extern const ShaderReplacementRule SLICE_PLANE_CULL;
+extern const ShaderReplacementRule THRESHOLD_CULL;      // discards where thresholdValue is outside the threshold range
+extern const ShaderReplacementRule SUBSET_VISIBLE_CULL; // discards where subsetIndex is not in the visible subset
+extern const ShaderReplacementRule SUBSET_HIGHLIGHT;    // tints where subsetIndex is in the highlighted subset
 
 // clang-format on
 
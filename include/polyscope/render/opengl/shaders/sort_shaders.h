@@ -0,0 +1,20 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/render/opengl/gl_shaders.h"
+
+namespace polyscope {
+namespace render {
+namespace backend_openGL3_glfw {
+
+// Compute programs for Engine::sortPointsByDepth(): view depth keys for the points, then the count, scan and scatter
+// steps of each pass of a radix sort over them
+extern const ShaderStageSpecification DEPTH_SORT_KEYS_COMPUTE_SHADER;
+extern const ShaderStageSpecification RADIX_SORT_COUNT_COMPUTE_SHADER;
+extern const ShaderStageSpecification RADIX_SORT_SCAN_COMPUTE_SHADER;
+extern const ShaderStageSpecification RADIX_SORT_SCATTER_COMPUTE_SHADER;
+
+} // namespace backend_openGL3_glfw
+} // namespace render
+} // namespace polyscope
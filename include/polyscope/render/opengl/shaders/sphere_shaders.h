@@ -17,14 +17,39 @@ extern const ShaderStageSpecification FLEX_POINTQUAD_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_POINTQUAD_GEOM_SHADER;
 extern const ShaderStageSpecification FLEX_POINTQUAD_FRAG_SHADER;
 
+// Instanced versions without a geometry shader, which use the fragment shaders above
+extern const ShaderStageSpecification FLEX_SPHERE_INSTANCED_VERT_SHADER;
+extern const ShaderStageSpecification FLEX_POINTQUAD_INSTANCED_VERT_SHADER;
+
 // Rules specific to spheres
 extern const ShaderReplacementRule SPHERE_PROPAGATE_VALUE;
 extern const ShaderReplacementRule SPHERE_PROPAGATE_VALUE2;
 extern const ShaderReplacementRule SPHERE_PROPAGATE_COLOR;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_COLOR_PACKED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_LABEL;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_THRESHOLD;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_PICK;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_PICK_INDEXED;
 extern const ShaderReplacementRule SPHERE_VARIABLE_SIZE;
 extern const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER;
 extern const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER_QUAD;
 
+// Versions of the rules above for the instanced pipeline (SPHERE_CULLPOS_FROM_CENTER works as-is)
+extern const ShaderReplacementRule SPHERE_PROPAGATE_VALUE_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_VALUE2_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_COLOR_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_COLOR_PACKED_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_LABEL_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_THRESHOLD_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_PICK_INSTANCED;
+extern const ShaderReplacementRule SPHERE_PROPAGATE_PICK_INDEXED_INSTANCED;
+extern const ShaderReplacementRule SPHERE_VARIABLE_SIZE_INSTANCED;
+extern const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER_QUAD_INSTANCED;
+
 
 } // namespace backend_openGL3_glfw
 } // namespace render
@@ -10,6 +10,7 @@ namespace backend_openGL3_glfw {
 
 // High level pipeline
 extern const ShaderStageSpecification FLEX_MESH_VERT_SHADER;
+extern const ShaderStageSpecification FLEX_MESH_COMPRESSED_VERT_SHADER;
 extern const ShaderStageSpecification FLEX_MESH_FRAG_SHADER;
 
 // Rules specific to meshes
@@ -22,11 +23,28 @@ extern const ShaderReplacementRule MESH_BACKFACE_DARKEN;
 extern const ShaderReplacementRule MESH_PROPAGATE_VALUE;
 extern const ShaderReplacementRule MESH_PROPAGATE_VALUE2;
 extern const ShaderReplacementRule MESH_PROPAGATE_COLOR;
+extern const ShaderReplacementRule MESH_PROPAGATE_COLOR_PACKED;
 extern const ShaderReplacementRule MESH_PROPAGATE_HALFEDGE_VALUE;
+extern const ShaderReplacementRule MESH_FACE_INDEX_FROM_PRIMITIVE_ID;
+extern const ShaderReplacementRule MESH_FACE_INDEX_FROM_TRIANGLE_MAP;
+extern const ShaderReplacementRule MESH_FETCH_FACE_VALUE;
+extern const ShaderReplacementRule MESH_FETCH_FACE_COLOR;
+extern const ShaderReplacementRule MESH_FETCH_FACE_CULLPOS;
 extern const ShaderReplacementRule MESH_PROPAGATE_CULLPOS;
+extern const ShaderReplacementRule MESH_PROPAGATE_SUBSET_INDEX;
+extern const ShaderReplacementRule MESH_PROPAGATE_THRESHOLD;
+extern const ShaderReplacementRule MESH_PROPAGATE_VECTOR;
+extern const ShaderReplacementRule MESH_PROPAGATE_TANGENT_VECTOR;
+extern const ShaderReplacementRule MESH_SHADE_LIC;
 extern const ShaderReplacementRule MESH_PROPAGATE_PICK;
 extern const ShaderReplacementRule MESH_PROPAGATE_PICK_SIMPLE;
+extern const ShaderReplacementRule MESH_PICK_FROM_INDICES;
+extern const ShaderReplacementRule MESH_PICK_CORNERS_FROM_INDICES;
+extern const ShaderReplacementRule MESH_PICK_HALFEDGES_FROM_INDICES;
 extern const ShaderReplacementRule MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE;
+extern const ShaderReplacementRule MESH_INSTANCED;
+extern const ShaderReplacementRule MESH_INSTANCE_COLOR;
+extern const ShaderReplacementRule MESH_INSTANCED_PICK;
 
 
 } // namespace backend_openGL3_glfw
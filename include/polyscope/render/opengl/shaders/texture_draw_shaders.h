@@ -14,11 +14,17 @@ extern const ShaderStageSpecification SPHEREBG_DRAW_VERT_SHADER;
 extern const ShaderStageSpecification SPHEREBG_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification PLAIN_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification PLAIN_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER;
+extern const ShaderStageSpecification IMPLICIT_SURFACE_MARCH_FRAG_SHADER;
 extern const ShaderStageSpecification DOT3_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification MAP3_TEXTURE_DRAW_FRAG_SHADER;
 extern const ShaderStageSpecification COMPOSITE_PEEL;
+extern const ShaderStageSpecification COMPOSITE_WEIGHTED_BLENDED;
+extern const ShaderStageSpecification TEMPORAL_ACCUMULATE;
 extern const ShaderStageSpecification DEPTH_COPY;
 extern const ShaderStageSpecification DEPTH_TO_MASK;
+extern const ShaderStageSpecification AMBIENT_OCCLUSION_ESTIMATE;
+extern const ShaderStageSpecification AMBIENT_OCCLUSION_COMPOSITE;
+extern const ShaderStageSpecification DEFERRED_LIGHTING;
 extern const ShaderStageSpecification BLUR_RGB;
 
 extern const ShaderStageSpecification SCALAR_TEXTURE_COLORMAP;
@@ -35,6 +41,7 @@ extern const ShaderReplacementRule TEXTURE_SHADE_COLOR;      // sample a color f
 extern const ShaderReplacementRule TEXTURE_PROPAGATE_VALUE;  // sample a scalar from a texture and use it for shading
 extern const ShaderReplacementRule
     TEXTURE_BILLBOARD_FROM_UNIFORMS; // adjust a texture's billboard position via uniforms
+extern const ShaderReplacementRule TEXTURE_RECT_FROM_UNIFORMS; // draw a sub-rectangle of a texture
 
 
 // Shaders (which are used elsewhere)
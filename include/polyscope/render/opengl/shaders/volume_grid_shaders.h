@@ -0,0 +1,26 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/render/opengl/gl_shaders.h"
+
+namespace polyscope {
+namespace render {
+namespace backend_openGL3_glfw {
+
+// High level pipeline
+extern const ShaderStageSpecification GRID_RAYMARCH_VERT_SHADER;
+extern const ShaderStageSpecification GRID_RAYMARCH_VOLUME_FRAG_SHADER;
+extern const ShaderStageSpecification GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER;
+extern const ShaderStageSpecification SPARSE_GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER;
+extern const ShaderStageSpecification GRID_NODE_SPHERE_VERT_SHADER;
+extern const ShaderStageSpecification GRID_NODE_VECTOR_VERT_SHADER;
+
+// Rules
+extern const ShaderReplacementRule GRID_SAMPLE_DENSE;
+extern const ShaderReplacementRule GRID_SAMPLE_STREAMED;
+
+
+} // namespace backend_openGL3_glfw
+} // namespace render
+} // namespace polyscope
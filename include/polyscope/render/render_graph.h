@@ -0,0 +1,133 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace polyscope {
+
+// Forward declare necessary types
+enum class TextureFormat;
+
+namespace render {
+
+class TextureBuffer;
+
+// A resource of a RenderGraph, valid for the frame it was declared in
+typedef size_t RenderResource;
+
+// A small frame graph. Each frame, the rendering is declared as a sequence of passes which list the resources they read
+// and write, and execute() then runs them in order, except that:
+//
+//   - Passes which contribute nothing to the outputs (markOutput()) are culled.
+//
+//   - A pass with a nonzero skip key is skipped if it was in the previous execute() with the same key, and nothing
+//     has changed its resources since; its outputs keep what that frame left in them. (Earlier passes are made to run
+//     again where needed for that to hold, e.g. when a later pass drawing over the same target runs.) The key should
+//     capture everything outside the graph which the pass depends on.
+//
+//   - Transient textures are backed by a pool which persists across frames, and resources whose lifetimes within the
+//     frame don't overlap share a texture when their format and size match. A resource's lifetime spans the passes
+//     which use it, so its contents are only defined from its first write to its last read. Pooled textures which go
+//     unused for transientRetainFrames frames are freed, so targets of features which are turned off don't linger.
+//
+// Imported resources are owned elsewhere (e.g. the engine's scene buffers). Their contents are tracked by version, so
+// anything which changes them outside of the graph (such as a resize) must call invalidate().
+class RenderGraph {
+public:
+  // Start declaring a frame, discarding the passes and resources of the previous one
+  void beginFrame();
+
+  RenderResource importResource(const std::string& name);
+  RenderResource createTransientTexture(const std::string& name, TextureFormat format, unsigned int sizeX,
+                                        unsigned int sizeY);
+
+  // Passes are identified by name from frame to frame, for skipping
+  void addPass(const std::string& name, const std::vector<RenderResource>& reads,
+               const std::vector<RenderResource>& writes, std::function<void()> execute, uint64_t skipKey = 0);
+  void markOutput(RenderResource resource);
+
+  void execute();
+
+  // The texture backing a transient resource, while executing the passes which use it
+  std::shared_ptr<TextureBuffer> getTexture(RenderResource resource);
+
+  // The imported resources changed outside of the graph, so no pass can be skipped on account of them
+  void invalidate();
+
+  // Free all pooled textures (they are recreated as needed)
+  void releaseTransientTextures();
+
+  int transientRetainFrames = 3;
+
+  // What the last execute() did
+  struct Stats {
+    size_t passesRun = 0;
+    size_t passesSkipped = 0;
+    size_t passesCulled = 0;
+    size_t transientResources = 0;
+    size_t transientTextures = 0; // distinct pooled textures which backed them
+  };
+  const Stats& getStats() const { return stats; }
+  size_t getPooledTextureBytes() const;
+
+private:
+  struct Resource {
+    std::string name;
+    bool transient;
+    TextureFormat format;
+    unsigned int sizeX, sizeY;
+    size_t slot; // index in pool, for transients used this frame
+  };
+
+  struct Pass {
+    std::string name;
+    std::vector<RenderResource> reads, writes;
+    std::function<void()> execute;
+    uint64_t skipKey;
+  };
+
+  // The versions of the imported resources of a pass at the end of the last frame it was in
+  struct PassRecord {
+    uint64_t skipKey;
+    std::vector<std::pair<std::string, uint64_t>> versions;
+  };
+
+  struct PoolSlot {
+    TextureFormat format;
+    unsigned int sizeX, sizeY;
+    std::shared_ptr<TextureBuffer> texture;
+    std::string lastResourceName; // so a resource keeps the same texture from frame to frame
+    uint64_t lastUsedFrame;
+    size_t busyUntil; // last pass (+1) of the current occupant this frame
+  };
+
+  uint64_t resourceVersion(const std::string& name);
+  std::vector<std::pair<std::string, uint64_t>> importedVersions(const Pass& pass);
+  bool writes(const Pass& pass, RenderResource resource);
+  bool canSkip(const Pass& pass, const std::vector<char>& modified);
+  void allocateTransients(const std::vector<char>& runs);
+
+  std::vector<Resource> resources;
+  std::vector<Pass> passes;
+  std::vector<RenderResource> outputs;
+
+  std::map<std::string, uint64_t> versions; // of the imported resources, by name
+  uint64_t nextVersion = 1;
+  std::map<std::string, PassRecord> records;
+
+  std::vector<PoolSlot> pool;
+  uint64_t frameIndex = 0;
+  bool executing = false;
+
+  Stats stats;
+};
+
+} // namespace render
+} // namespace polyscope
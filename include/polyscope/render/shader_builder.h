@@ -11,5 +11,18 @@ std::vector<ShaderStageSpecification>
 applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
                         const std::vector<ShaderReplacementRule>& replacementRules);
 
+// A key which identifies a program by its final (post-replacement) stages: two sets of stages with the same key compile
+// to the same program, even if they were built from different rules
+std::string programKeyFromStages(const std::vector<ShaderStageSpecification>& stages, DrawMode dm);
+
+// The frame-global uniforms (see Engine::updateFrameUniforms()) live in one std140 uniform block shared by all
+// programs. This removes them from the stages' uniform lists, and replaces their declarations in the source with the
+// block declaration. Applied to the final (post-replacement) stages.
+extern const char* frameUniformBlockName;
+const unsigned int frameUniformBlockBinding = 0;
+// std140: 2 x mat4, vec4, vec2 (padded), 2 x vec4[maxSlicePlanes], int and float (padded)
+const size_t frameUniformBlockSizeInBytes = 160 + 2 * 16 * maxSlicePlanes + 16;
+std::vector<ShaderStageSpecification> useFrameUniformBlock(const std::vector<ShaderStageSpecification>& stages);
+
 }
 } // namespace polyscope
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <functional>
 #include <vector>
 
 #include "polyscope/polyscope.h"
@@ -25,5 +26,11 @@ T getAttributeBufferData(AttributeBuffer& buff, size_t ind);
 template <typename T>
 std::vector<T> getAttributeBufferDataRange(AttributeBuffer& buff, size_t ind, size_t count);
 
+// Asynchronously get a range of data values, see AttributeBuffer::getDataRangeRawAsync()
+// (use std::array<T>s to get arraycount repeated attributes)
+template <typename T>
+void getAttributeBufferDataRangeAsync(AttributeBuffer& buff, size_t ind, size_t count,
+                                      std::function<void(std::vector<T>)> callback);
+
 } // namespace render
 } // namespace polyscope
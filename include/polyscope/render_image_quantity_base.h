@@ -32,6 +32,16 @@ public:
 
   void updateGeometryBuffers(const std::vector<float>& newDepthData, const std::vector<glm::vec3>& newNormalData);
 
+  // Update only the w x h rectangle of pixels starting at (xStart, yStart), e.g. for renderers which refine the image
+  // tile by tile. The region is given in the same row order as the original data, and the new data holds just the
+  // region's pixels, row by row. Only that rectangle of the textures is re-uploaded. The HalfNormals version takes
+  // normals as 3 half-float values per pixel (see glm::packHalf1x16()), halving the size of their upload.
+  void updateGeometryBuffersRegion(size_t xStart, size_t yStart, size_t w, size_t h,
+                                   const std::vector<float>& newDepthData, const std::vector<glm::vec3>& newNormalData);
+  void updateGeometryBuffersRegionHalfNormals(size_t xStart, size_t yStart, size_t w, size_t h,
+                                              const std::vector<float>& newDepthData,
+                                              const std::vector<uint16_t>& newNormalDataHalf);
+
   // == Setters and getters
 
   // Material
@@ -44,7 +54,7 @@ public:
 
 
 protected:
-  const size_t dimX, dimY;
+  size_t dimX, dimY;
   ImageOrigin imageOrigin;
 
   // Store the raw data
@@ -59,6 +69,11 @@ protected:
 
   // Helpers
   void prepareGeometryBuffers();
+  // Replace the whole image with one of a new size, reallocating the textures on the next draw. (Subclasses with other
+  // per-pixel data would need to resize it too.)
+  void resizeGeometryBuffers(size_t newDimX, size_t newDimY, const std::vector<float>& newDepthData,
+                             const std::vector<glm::vec3>& newNormalData);
+  void copyDepthRegion(size_t xStart, size_t yStart, size_t w, size_t h, const std::vector<float>& newDepthData);
   void addOptionsPopupEntries();
 };
 
@@ -14,7 +14,7 @@ namespace polyscope {
 class ScalarImageQuantity : public ImageQuantity, public ScalarQuantity<ScalarImageQuantity> {
 
 public:
-  ScalarImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY, const std::vector<double>& data,
+  ScalarImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY, const std::vector<float>& data,
                       ImageOrigin imageOrigin, DataType dataType);
 
   virtual void buildCustomUI() override;
@@ -27,6 +27,8 @@ public:
 
   virtual ScalarImageQuantity* setEnabled(bool newEnabled) override;
 
+  virtual void releaseTextures() override;
+
 protected:
   // rendering internals
   std::shared_ptr<render::TextureBuffer> textureRaw, textureIntermediateRendered;
@@ -36,7 +38,9 @@ protected:
   void prepareFullscreen();
   void prepareIntermediateRender();
   void prepareBillboard();
-  void ensureRawTexturePopulated();
+  bool ensureRawTexturePopulated(); // false if the upload was deferred
+
+  virtual bool textureFormatSupported(TextureFormat format) override;
 
   virtual void showFullscreen() override;
   virtual void showInImGuiWindow() override;
@@ -15,10 +15,17 @@ namespace polyscope {
 
 // Encapsulates logic which is common to all scalar quantities
 
+// The range of scalar values which colormaps cover by default
+inline std::pair<double, double> scalarDataRange(const std::vector<float>& values) {
+  return robustMinMax(values, 1e-5);
+}
+
 template <typename QuantityT>
 class ScalarQuantity {
 public:
-  ScalarQuantity(QuantityT& quantity, const std::vector<double>& values, DataType dataType);
+  // If given, dataRange is the scalarDataRange() of the values, already computed (e.g. in parallel with other fields)
+  ScalarQuantity(QuantityT& quantity, std::vector<float> values, DataType dataType,
+                 const std::pair<double, double>* dataRange = nullptr);
 
   // Build the ImGUI UIs for scalars
   void buildScalarUI();
@@ -38,7 +45,7 @@ public:
 
   // Wrapper around the actual buffer of scalar data stored in the class.
   // Interaction with the data (updating it on CPU or GPU side, accessing it, etc) happens through this wrapper.
-  render::ManagedBuffer<double> values;
+  render::ManagedBuffer<float> values;
 
   // === Get/set visualization parameters
 
@@ -60,8 +67,10 @@ public:
   QuantityT* setIsolineDarkness(double val);
   double getIsolineDarkness();
 
+  DataType getDataType() const { return dataType; }
+
 protected:
-  std::vector<double> valuesData;
+  std::vector<float> valuesData;
   const DataType dataType;
 
   // === Visualization parameters
@@ -70,6 +79,8 @@ protected:
   std::pair<float, float> vizRange; // TODO make these persistent
   std::pair<double, double> dataRange;
   Histogram hist;
+  bool histBuilt = false;    // the histogram is built lazily, when the UI is shown
+  uint64_t dataRevision = 0; // bumped by updateData(), for caches derived from the values
 
   // Parameters
   PersistentValue<std::string> cMap;
@@ -5,9 +5,10 @@
 namespace polyscope {
 
 template <typename QuantityT>
-ScalarQuantity<QuantityT>::ScalarQuantity(QuantityT& quantity_, const std::vector<double>& values_, DataType dataType_)
-    : quantity(quantity_), values(quantity.uniquePrefix() + "#values", valuesData), valuesData(values_),
-      dataType(dataType_), dataRange(robustMinMax(values.data, 1e-5)),
+ScalarQuantity<QuantityT>::ScalarQuantity(QuantityT& quantity_, std::vector<float> values_, DataType dataType_,
+                                          const std::pair<double, double>* dataRange_)
+    : quantity(quantity_), values(quantity.uniquePrefix() + "#values", valuesData), valuesData(std::move(values_)),
+      dataType(dataType_), dataRange(dataRange_ ? *dataRange_ : scalarDataRange(values.data)),
       cMap(quantity.uniquePrefix() + "#cmap", defaultColorMap(dataType)),
       isolinesEnabled(quantity.uniquePrefix() + "#isolinesEnabled", false),
       isolineWidth(quantity.uniquePrefix() + "#isolineWidth",
@@ -16,7 +17,7 @@ ScalarQuantity<QuantityT>::ScalarQuantity(QuantityT& quantity_, const std::vecto
 
 {
   hist.updateColormap(cMap.get());
-  hist.buildHistogram(values.data);
+  hist.colormapRange = dataRange;
   resetMapRange();
 }
 
@@ -24,8 +25,6 @@ template <typename QuantityT>
 void ScalarQuantity<QuantityT>::buildScalarUI() {
 
   if (render::buildColormapSelector(cMap.get())) {
-    quantity.refresh();
-    hist.updateColormap(cMap.get());
     setColorMap(getColorMap());
   }
 
@@ -61,7 +60,17 @@ void ScalarQuantity<QuantityT>::buildScalarUI() {
                         .c_str());
 
 
-  // Draw the histogram of values
+  // Draw the histogram of values. It is only built when the UI is shown, and is counted on the GPU if the values
+  // only live there.
+  if (!histBuilt) {
+    if (values.dataIsDeviceOnly()) {
+      hist.buildHistogram(values.getRenderAttributeBuffer(), dataRange);
+    } else {
+      values.ensureHostBufferPopulated();
+      hist.buildHistogram(values.data, dataRange);
+    }
+    histBuilt = true;
+  }
   hist.colormapRange = vizRange;
   float windowWidth = ImGui::GetWindowWidth();
   float histWidth = 0.75 * windowWidth;
@@ -162,10 +171,17 @@ std::vector<std::string> ScalarQuantity<QuantityT>::addScalarRules(std::vector<s
 
 template <typename QuantityT>
 void ScalarQuantity<QuantityT>::setScalarUniforms(render::ShaderProgram& p) {
+  // the colormap is only a texture, so changing it swaps the texture here rather than regenerating the program (this
+  // does nothing if the program already has it)
+  if (p.hasTexture("t_colormap")) {
+    p.setTextureFromColormap("t_colormap", cMap.get(), true);
+  }
+
   p.setUniform("u_rangeLow", vizRange.first);
   p.setUniform("u_rangeHigh", vizRange.second);
 
-  if (isolinesEnabled.get()) {
+  // (programs which draw the isolines some other way don't have the stripe uniforms)
+  if (isolinesEnabled.get() && p.hasUniform("u_modLen")) {
     p.setUniform("u_modLen", getIsolineWidth());
     p.setUniform("u_modDarkness", getIsolineDarkness());
   }
@@ -194,8 +210,10 @@ template <typename QuantityT>
 template <class V>
 void ScalarQuantity<QuantityT>::updateData(const V& newValues) {
   validateSize(newValues, values.size(), "scalar quantity " + quantity.name);
-  values.data = standardizeArray<double, V>(newValues);
+  values.data = standardizeArray<float, V>(newValues);
   values.markHostBufferUpdated();
+  histBuilt = false;
+  dataRevision++;
 }
 
 
@@ -203,7 +221,6 @@ template <typename QuantityT>
 QuantityT* ScalarQuantity<QuantityT>::setColorMap(std::string val) {
   cMap = val;
   hist.updateColormap(cMap.get());
-  quantity.refresh();
   requestRedraw();
   return &quantity;
 }
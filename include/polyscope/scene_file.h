@@ -0,0 +1,24 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <string>
+
+namespace polyscope {
+
+// A native binary snapshot of the scene, for quickly re-opening a scene which is expensive to build. The file holds the
+// geometry of each point cloud and surface mesh, their scalar and color quantities, all persistent options (colors,
+// materials, enabled states, transforms, ...), and the derived surface mesh buffers (the triangulation, barycentric
+// coordinates and real-edge flags), so none of that is recomputed on load.
+//
+// Loading memory-maps the file and points the structures' ManagedBuffers straight at it (see
+// ManagedBuffer::setExternalData()), so nothing is parsed or copied up front; the mapping stays open until the last
+// structure using it is removed. Quantity values are copied, since quantities always own their data. Other structure
+// and quantity types are skipped with a warning. Files are written in native byte order.
+
+void saveScene(std::string filename);
+
+// Register the structures from a scene file. Existing structures with the same names are replaced.
+void loadScene(std::string filename);
+
+} // namespace polyscope
@@ -2,17 +2,84 @@
 
 #pragma once
 
+#include "polyscope/camera_parameters.h"
 #include "polyscope/polyscope.h"
 
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
 namespace polyscope {
 
 
 // Take screenshots of the current view
 void screenshot(std::string filename, bool transparentBG = true);
 void screenshot(bool transparentBG = true);
+
+// Like screenshot(), but the pixels are read back from the GPU asynchronously, and the file is written once they arrive
+// (during a later frame or screenshot, or at shutdown). Avoids stalling the pipeline when taking many screenshots.
+void screenshotAsync(std::string filename, bool transparentBG = true);
+
+// When options::screenshotEncodeInBackground is set (the default), screenshot files are written by worker threads and
+// may not be on disk yet when the screenshot functions return. This blocks until all outstanding screenshots
+// (including async readbacks) have been written.
+void flushScreenshots();
+
+// Write a buffer to an image file, on the calling thread. The format is chosen by the extension: .png, .jpg, or .raw
+// (uncompressed pixels, top row first, no header), falling back on png.
 void saveImage(std::string name, unsigned char* buffer, int w, int h, int channels);
+
+// Render the scene from each of the cameras in turn, without the UI, and write frame i to filenames[i]. Frames are
+// rendered at width x height, independent of the window (or at the current size, if either is 0). The GPU readbacks
+// are pipelined and the images are encoded on worker threads, so this is much faster than looping over screenshot().
+// The view is restored afterwards.
+void screenshotSequence(const std::vector<CameraParameters>& cameras, const std::vector<std::string>& filenames,
+                        int width = 0, int height = 0, bool transparentBG = true);
+
+// Like screenshotSequence(), but each frame's RGBA pixels (bottom row first, as with saveImage()) are passed to
+// frameCallback(frameInd, pixels, w, h) instead of being written out. The callback is invoked on the calling thread,
+// possibly a few frames after the frame was rendered, and may take the pixels with std::move().
+void renderSequence(const std::vector<CameraParameters>& cameras,
+                    std::function<void(size_t, std::vector<unsigned char>&, int, int)> frameCallback, int width = 0,
+                    int height = 0, bool transparentBG = true);
+
+// Render an image of width x height, which may be larger than the GPU buffers allow or than fits in memory at once, in
+// tiles of at most tileSize pixels on a side. Each tile goes through the full pipeline with an off-center projection
+// (see view::projectionTileOffset). The image is handed to stripCallback(rowStart, pixels, w, h) one row of tiles at a
+// time, from the top, as RGBA pixels with the top row first, so only one strip is held in memory. Effects computed in
+// screen space (like ambient occlusion and the ground plane blur) run per tile, and may show faint seams.
+void renderTiled(int width, int height,
+                 std::function<void(int, std::vector<unsigned char>&, int, int)> stripCallback, int tileSize = 2048,
+                 bool transparentBG = true);
+
+// Like renderTiled(), streaming the image in to a .png or .raw file. The png is written without compression, since the
+// encoder cannot compress a stream.
+void screenshotTiled(std::string filename, int width, int height, int tileSize = 2048, bool transparentBG = true);
+
+// Caller-provided memory for renderToBuffers(). Any target may be null to skip it; the others must hold
+// view::bufferWidth * view::bufferHeight pixels. Unlike saveImage(), all targets are stored top row first.
+struct RenderBufferTargets {
+  unsigned char* color = nullptr; // RGBA8, 4 per pixel, as in a screenshot
+  float* depth = nullptr;         // linear view-space depth, 1 per pixel; infinity where nothing was drawn
+  float* normal = nullptr;        // view-space unit normal facing the camera, 3 per pixel; zero where nothing was drawn
+  uint64_t* pickID = nullptr;     // global pick index (see pick::globalIndexToLocal()), 1 per pixel; 0 where nothing
+};
+
+// Render the current view and read back whole buffers of color, depth, normals and pick IDs at once. The color comes
+// from a screenshot render (without the UI); depth and pick IDs come from a single pick buffer render, and normals are
+// reconstructed from the depth.
+void renderToBuffers(const RenderBufferTargets& targets, bool transparentBG = true);
+
 void resetScreenshotIndex();
 
+namespace internal {
+// Encode RGBA pixels (bottom row first, as read from a framebuffer) as a JPEG in memory. Safe to call from worker
+// threads once prepareImageEncoding() has been called on the main thread.
+void prepareImageEncoding();
+std::vector<unsigned char> encodeJPEG(const unsigned char* pixels, int w, int h, int quality);
+} // namespace internal
+
 
 namespace state {
 
@@ -11,6 +11,8 @@
 
 namespace polyscope {
 
+class Structure;
+class VolumeMesh;
 
 class SlicePlane {
 
@@ -28,14 +30,20 @@ public:
   void buildGUI();
   void draw();
   void drawGeometry();
-  void resetVolumeSliceProgram();
+  void resetVolumeSliceProgram();                   // (of every inspected mesh)
+  void resetVolumeSliceProgram(VolumeMesh& mesh);   // (of just this one)
+  void refreshVolumeSliceMaterial(VolumeMesh& mesh); // re-apply the mesh's material, without rebuilding the program
   void ensureVolumeInspectValid();
 
-  void setSceneObjectUniforms(render::ShaderProgram& p,
-                              bool alwaysPass = false); // if alwaysPass, fake values are given so the plane does
-                                                        // nothing (regardless of this plane's active setting)
+  // The planes themselves are frame uniforms; this sets the culling mask for a program drawn from the structure, but
+  // with this plane always passing (as for the slice of an inspected volume mesh)
+  void setSceneObjectUniformsIgnoringThis(render::ShaderProgram& p, Structure& structure);
   void setSliceGeomUniforms(render::ShaderProgram& p);
 
+  // Restrict a program over an inspected mesh's tets (see VolumeMesh::fillSliceGeometryBuffers()) to the ones this
+  // plane actually cuts
+  void setSliceDrawRanges(render::ShaderProgram& p, VolumeMesh& mesh);
+
   const std::string name;
   const std::string postfix;
   std::string uniquePrefix();
@@ -58,6 +66,11 @@ public:
   void setDrawWidget(bool newVal);
 
   glm::mat4 getTransform();
+
+  // World space center and normal of the plane; points on the negative side are culled
+  glm::vec3 getCenter();
+  glm::vec3 getNormal();
+
   void setTransform(glm::mat4 newTransform);
 
   void setColor(glm::vec3 newVal);
@@ -69,8 +82,17 @@ public:
   void setTransparency(double newVal);
   double getTransparency();
 
-  void setVolumeMeshToInspect(std::string meshName);
-  std::string getVolumeMeshToInspect();
+  // Draw the interior of volume meshes where the plane cuts them. Any number of meshes may be inspected at once (e.g.
+  // the blocks of a multi-block mesh); the plane's uniforms are computed once per frame for all of them, and each
+  // mesh's cut tets are only re-extracted when the plane moves.
+  void setVolumeMeshToInspect(std::string meshName); // inspect exactly this mesh, or none for ""
+  std::string getVolumeMeshToInspect();              // the first inspected mesh, or "" if there are none
+  void setVolumeMeshesToInspect(const std::vector<std::string>& meshNames);
+  std::vector<std::string> getVolumeMeshesToInspect();
+  void addVolumeMeshToInspect(std::string meshName);
+  void removeVolumeMeshToInspect(std::string meshName);
+  bool isInspectingVolumeMesh(std::string meshName);
+  void setGroupToInspect(std::string groupName); // the volume meshes in the group and its descendants, as of now
 
 protected:
   // = State
@@ -84,26 +106,28 @@ protected:
 
   // DON'T make these persistent, because it is unintitive to re-add a scene slice plane and have it immediately start
   // slicing
-  bool shouldInspectMesh;
-  std::string inspectedMeshName;
-
-  std::shared_ptr<render::ShaderProgram> volumeInspectProgram;
+  struct InspectedVolumeMesh {
+    std::string name;
+    std::shared_ptr<render::ShaderProgram> program; // if null, created at the next draw
+
+    // The tets which the plane cuts. Only these are sent through the slicing shader, and they are only re-extracted
+    // when the plane moves or the inspection is reset.
+    std::vector<std::array<size_t, 2>> slicedTetRanges;
+    glm::vec4 slicedTetRangesPlane; // the (sliceVector, slicePoint) they were extracted for
+    bool slicedTetRangesValid;
+  };
+  std::vector<InspectedVolumeMesh> inspectedMeshes;
 
   // Widget that wraps the transform
   TransformationGizmo transformGizmo;
 
-  // these are optionally filled when slice-visualizing into a volume mesh
-  std::array<std::vector<uint32_t>, 4> sliceBufferDataArr;
-  std::array<render::ManagedBuffer<uint32_t>, 4> sliceBufferArr;
-
   std::shared_ptr<render::ShaderProgram> planeProgram;
 
   // Helpers
-  void setSliceAttributes(render::ShaderProgram& p);
-  void createVolumeSliceProgram();
+  InspectedVolumeMesh* findInspectedMesh(const std::string& meshName);
+  void createVolumeSliceProgram(InspectedVolumeMesh& inspected, VolumeMesh& mesh);
+  void ensureSlicedTetRangesCurrent(InspectedVolumeMesh& inspected, VolumeMesh& mesh, glm::vec4 plane);
   void prepare();
-  glm::vec3 getCenter();
-  glm::vec3 getNormal();
   void updateWidgetEnabled();
 };
 
@@ -0,0 +1,149 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/affine_remapper.h"
+#include "polyscope/color_management.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/standardize_data_array.h"
+#include "polyscope/structure.h"
+
+#include "polyscope/sparse_volume_grid_quantity.h"
+#include "polyscope/sparse_volume_grid_scalar_quantity.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace polyscope {
+
+class SparseVolumeGrid;
+class SparseVolumeGridScalarQuantity;
+
+template <> // Specialize the quantity type
+struct QuantityTypeHelper<SparseVolumeGrid> {
+  typedef SparseVolumeGridQuantity type;
+};
+
+
+// A regular grid of nodes at origin + (i, j, k) * spacing, of which only a sparse set is active, as for narrow-band
+// level sets. The index space is split into bricks of brickSize^3 nodes, and only the bricks containing an active node
+// are allocated; a hash map from brick coordinates to bricks is the block index. Quantities store a value for every
+// node of every allocated brick, so memory scales with the number of active bricks rather than the extent of the grid.
+// Nodes of allocated bricks with no value hold NaN, which the visualizations treat as missing.
+class SparseVolumeGrid : public QuantityStructure<SparseVolumeGrid> {
+public:
+  // Construct a new sparse volume grid structure. activeNodes are integer node coordinates (which may be negative),
+  // duplicates are ignored.
+  SparseVolumeGrid(std::string name, glm::vec3 origin_, glm::vec3 spacing_,
+                   const std::vector<glm::ivec3>& activeNodes_);
+
+  // === Overloads
+
+  // Standard structure overrides
+  virtual void draw() override;
+  virtual void drawDelayed() override;
+  virtual void drawPick() override;
+  virtual void updateObjectSpaceBounds() override;
+  virtual std::string typeName() override;
+  virtual std::string drawSortKey() override; // the material
+  virtual void refresh() override;
+
+  // Build the imgui display
+  virtual void buildCustomUI() override;
+  virtual void buildPickUI(size_t localPickID) override;
+
+  // Field data
+  glm::vec3 origin, spacing;
+
+  // Misc data
+  static const std::string structureTypeName;
+  static const int32_t brickSize = 8; // nodes per side of a brick
+
+  // === Quantity-related
+  // clang-format off
+
+  // One value per active node, in the order they were given to the constructor
+  template <class T>
+  SparseVolumeGridScalarQuantity* addScalarQuantity(std::string name, const T& values, DataType dataType_ = DataType::STANDARD);
+
+  // Sampled at every node of the allocated bricks, including inactive ones
+  template <class Func>
+  SparseVolumeGridScalarQuantity* addScalarQuantityFromCallable(std::string name, Func&& func, DataType dataType_ = DataType::STANDARD);
+
+  // clang-format on
+
+  // === Get/set visualization parameters
+
+  // Material
+  SparseVolumeGrid* setMaterial(std::string name);
+  std::string getMaterial();
+
+  // === The block index
+
+  size_t nActiveNodes() const;
+  size_t nBricks() const;
+  size_t nValues() const; // values stored per quantity, brickSize^3 for each brick
+  const std::vector<glm::ivec3>& getActiveNodes() const;
+  const std::vector<glm::ivec3>& getBrickCoords() const;
+
+  // Values of a brick are stored contiguously, brick after brick, with the last node coordinate fastest-varying
+  // within a brick. These return -1 if the brick (containing the node) is not allocated.
+  int64_t brickIndex(glm::ivec3 brickCoord) const;
+  int64_t valueIndexOfNode(glm::ivec3 node) const;
+  glm::ivec3 nodeOfValueIndex(size_t i) const;
+  glm::ivec3 brickOfNode(glm::ivec3 node) const;
+  glm::vec3 positionOfNode(glm::ivec3 node) const;
+  float minGridSpacing() const;
+
+  // The values at the active nodes, from values laid out as above
+  std::vector<float> gatherActiveValues(const std::vector<float>& values) const;
+
+  // The (brickSize+1)^3 values covering the cells which have their min corner in a brick, taking the last layer from
+  // the neighboring bricks (or NaN where they are not allocated). Laid out like the values of a brick.
+  void gatherPaddedBrick(const std::vector<float>& values, size_t iBrick, double* out) const;
+
+  // Rendering helpers used by quantities
+  std::vector<glm::vec3> activeNodePositions; // only populated by populateGeometry(), on demand
+  void populateGeometry();
+  void setSparseVolumeGridPointUniforms(render::ShaderProgram& p);
+  void setSparseVolumeGridRaymarchUniforms(render::ShaderProgram& p);
+  std::vector<std::string> addSparseVolumeGridPointRules(std::vector<std::string> initRules);
+  std::vector<glm::vec3> boundingBoxTriangles() const; // 12 triangles covering the allocated bricks
+
+  // Raymarching looks up the brick under each sample in a 3D texture over the range of allocated bricks, which holds
+  // the brick's slot in an atlas texture of padded bricks, or -1 for an empty brick, which is skipped in one step.
+  std::shared_ptr<render::TextureBuffer> getBrickIndexTexture();
+  std::shared_ptr<render::TextureBuffer> generateBrickAtlasTexture(const std::vector<float>& values) const;
+
+private:
+  std::vector<glm::ivec3> activeNodes;
+  std::vector<size_t> activeNodeValueInds; // for each active node, the index of its value
+  std::vector<glm::ivec3> brickCoords;
+  std::unordered_map<uint64_t, uint32_t> brickLookup; // packed brick coordinates --> index in brickCoords
+  glm::ivec3 brickRangeMin, brickRangeMax;            // allocated brick coordinates are in [min, max)
+  glm::ivec3 atlasBricks;                             // bricks per side of the atlas texture
+
+  std::shared_ptr<render::TextureBuffer> brickIndexTexture;
+
+  // === Visualization parameters
+  PersistentValue<std::string> material;
+
+  // === Quantity adder implementations
+  SparseVolumeGridScalarQuantity* addScalarQuantityImpl(std::string name, std::vector<float>&& values,
+                                                        DataType dataType_);
+};
+
+
+SparseVolumeGrid* registerSparseVolumeGrid(std::string name, glm::vec3 origin, glm::vec3 spacing,
+                                           const std::vector<glm::ivec3>& activeNodes);
+
+// Shorthand to get a sparse volume grid from polyscope
+inline SparseVolumeGrid* getSparseVolumeGrid(std::string name = "");
+inline bool hasSparseVolumeGrid(std::string name = "");
+inline void removeSparseVolumeGrid(std::string name = "", bool errorIfAbsent = false);
+
+} // namespace polyscope
+
+#include "polyscope/sparse_volume_grid.ipp"
@@ -0,0 +1,84 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+namespace polyscope {
+
+inline size_t SparseVolumeGrid::nActiveNodes() const { return activeNodes.size(); }
+inline size_t SparseVolumeGrid::nBricks() const { return brickCoords.size(); }
+inline size_t SparseVolumeGrid::nValues() const { return nBricks() * brickSize * brickSize * brickSize; }
+inline const std::vector<glm::ivec3>& SparseVolumeGrid::getActiveNodes() const { return activeNodes; }
+inline const std::vector<glm::ivec3>& SparseVolumeGrid::getBrickCoords() const { return brickCoords; }
+
+inline glm::ivec3 SparseVolumeGrid::brickOfNode(glm::ivec3 node) const {
+  // round towards -inf, so negative coordinates land in the right brick
+  glm::ivec3 b;
+  for (int d = 0; d < 3; d++) {
+    b[d] = node[d] >= 0 ? node[d] / brickSize : -((-node[d] - 1) / brickSize) - 1;
+  }
+  return b;
+}
+
+inline glm::ivec3 SparseVolumeGrid::nodeOfValueIndex(size_t i) const {
+  const size_t brickValues = brickSize * brickSize * brickSize;
+  glm::ivec3 brick = brickCoords[i / brickValues];
+  int32_t local = static_cast<int32_t>(i % brickValues);
+  glm::ivec3 offset{local / (brickSize * brickSize), (local / brickSize) % brickSize, local % brickSize};
+  return brick * brickSize + offset;
+}
+
+inline glm::vec3 SparseVolumeGrid::positionOfNode(glm::ivec3 node) const {
+  return origin + glm::vec3(node) * spacing;
+}
+
+inline float SparseVolumeGrid::minGridSpacing() const {
+  return std::fmin(std::fmin(spacing[0], spacing[1]), spacing[2]);
+}
+
+// Shorthand to get a sparse volume grid from polyscope
+inline SparseVolumeGrid* getSparseVolumeGrid(std::string name) {
+  return dynamic_cast<SparseVolumeGrid*>(getStructure(SparseVolumeGrid::structureTypeName, name));
+}
+inline bool hasSparseVolumeGrid(std::string name) { return hasStructure(SparseVolumeGrid::structureTypeName, name); }
+inline void removeSparseVolumeGrid(std::string name, bool errorIfAbsent) {
+  removeStructure(SparseVolumeGrid::structureTypeName, name, errorIfAbsent);
+}
+
+
+// =====================================================
+// ============== Quantities
+// =====================================================
+
+template <class T>
+SparseVolumeGridScalarQuantity* SparseVolumeGrid::addScalarQuantity(std::string name, const T& values,
+                                                                    DataType dataType_) {
+  validateSize(values, nActiveNodes(), "sparse grid scalar quantity " + name);
+  std::vector<double> activeValues = standardizeArray<double, T>(values);
+
+  // Scatter to the bricks, the other nodes are missing
+  std::vector<float> brickValues(nValues(), std::numeric_limits<float>::quiet_NaN());
+  for (size_t i = 0; i < activeValues.size(); i++) {
+    brickValues[activeNodeValueInds[i]] = static_cast<float>(activeValues[i]);
+  }
+
+  return addScalarQuantityImpl(name, std::move(brickValues), dataType_);
+}
+
+template <class Func>
+SparseVolumeGridScalarQuantity* SparseVolumeGrid::addScalarQuantityFromCallable(std::string name, Func&& func,
+                                                                                DataType dataType_) {
+
+  // Sample to the bricks
+  std::vector<float> brickValues(nValues());
+  for (size_t i = 0; i < brickValues.size(); i++) {
+    glm::vec3 pos = positionOfNode(nodeOfValueIndex(i));
+    brickValues[i] = static_cast<float>(func(pos.x, pos.y, pos.z));
+  }
+
+  return addScalarQuantityImpl(name, std::move(brickValues), dataType_);
+}
+
+} // namespace polyscope
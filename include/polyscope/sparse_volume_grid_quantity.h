@@ -0,0 +1,21 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/quantity.h"
+#include "polyscope/structure.h"
+
+
+namespace polyscope {
+
+// Forward declare structure
+class SparseVolumeGrid;
+
+// Extend Quantity<SparseVolumeGrid> to add a few extra functions
+class SparseVolumeGridQuantity : public QuantityS<SparseVolumeGrid> {
+public:
+  SparseVolumeGridQuantity(std::string name, SparseVolumeGrid& parentStructure, bool dominates = false);
+  ~SparseVolumeGridQuantity(){};
+};
+
+} // namespace polyscope
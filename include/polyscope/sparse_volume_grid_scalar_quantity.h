@@ -0,0 +1,86 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/polyscope.h"
+
+#include "polyscope/affine_remapper.h"
+#include "polyscope/grid_isosurface.h"
+#include "polyscope/histogram.h"
+#include "polyscope/render/color_maps.h"
+#include "polyscope/scalar_quantity.h"
+#include "polyscope/sparse_volume_grid.h"
+
+namespace polyscope {
+
+class SparseVolumeGridScalarQuantity : public SparseVolumeGridQuantity,
+                                       public ScalarQuantity<SparseVolumeGridScalarQuantity> {
+
+public:
+  // brickValues_ holds a value for each node of each allocated brick, as laid out by the grid, with NaN for missing
+  // values. The colormapped data is the values at the active nodes.
+  SparseVolumeGridScalarQuantity(std::string name, SparseVolumeGrid& grid_, std::vector<float>&& brickValues_,
+                                 DataType dataType_);
+
+  virtual void draw() override;
+  virtual void buildCustomUI() override;
+  virtual void refresh() override;
+  virtual void refreshMaterial() override;
+
+  virtual std::string niceName() override;
+
+  // The value at every node of the allocated bricks
+  const std::vector<float>& getBrickValues() const;
+
+  // == Getters and setters
+
+  // Point viz, one sphere per active node
+
+  SparseVolumeGridScalarQuantity* setPointVizEnabled(bool val);
+  bool getPointVizEnabled();
+
+
+  // Isosurface viz
+
+  SparseVolumeGridScalarQuantity* setIsosurfaceVizEnabled(bool val);
+  bool getIsosurfaceVizEnabled();
+
+  SparseVolumeGridScalarQuantity* setIsosurfaceLevel(float value);
+  float getIsosurfaceLevel();
+
+  SparseVolumeGridScalarQuantity* setIsosurfaceColor(glm::vec3 val);
+  glm::vec3 getIsosurfaceColor();
+
+  // Raymarch the isosurface through an atlas texture of the bricks, skipping empty bricks, rather than extracting a
+  // mesh. The level can then be changed interactively, at a per-pixel cost each frame.
+  SparseVolumeGridScalarQuantity* setIsosurfaceRaymarch(bool val);
+  bool getIsosurfaceRaymarch();
+
+  // Extract the isosurface mesh at the current level, in world-space positions (the mesh viz uses the same)
+  IsosurfaceMesh extractIsosurface();
+
+
+protected:
+  const DataType dataType;
+  std::vector<float> brickValues;
+
+  // Visualize as points
+  PersistentValue<bool> pointVizEnabled;
+  std::shared_ptr<render::ShaderProgram> pointProgram;
+  void createPointProgram();
+
+  // Visualize as isosurface
+  PersistentValue<bool> isosurfaceVizEnabled;
+  PersistentValue<float> isosurfaceLevel;
+  PersistentValue<glm::vec3> isosurfaceColor;
+  std::shared_ptr<render::ShaderProgram> isosurfaceProgram;
+  void createIsosurfaceProgram();
+
+  // Raymarched isosurface
+  PersistentValue<bool> isosurfaceRaymarch;
+  std::shared_ptr<render::ShaderProgram> isosurfaceRaymarchProgram;
+  std::shared_ptr<render::TextureBuffer> atlasTexture; // only created if raymarching is used
+  void createIsosurfaceRaymarchProgram();
+};
+
+} // namespace polyscope
@@ -3,8 +3,11 @@
 #pragma once
 
 #include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+#include "polyscope/profiling.h"
 #include "polyscope/utilities.h"
 
+#include <cstring>
 #include <type_traits>
 #include <vector>
 
@@ -213,6 +216,133 @@ size_t adaptorF_size(const T& inputData) {
 }
 
 
+// =================================================
+// ============ bulk conversion helpers
+// =================================================
+
+// The adaptors below use these for input whose entries sit at regular strides in memory (std::vector<>, Eigen
+// matrices, raw pointers...), rather than going element-by-element through the generic accessors. Same-type
+// contiguous input is a memcpy, other contiguous input is a flat loop the compiler can vectorize (e.g. double to
+// float), and large inputs are split in to chunks which are converted in parallel.
+
+// Inputs with fewer scalars than this (per thread) are converted on the calling thread
+const size_t standardizeParallelMinBlockSize = 1 << 18;
+
+// The type pointed to by T.data(), if there is such a function (an alias, so a failure to substitute is SFINAE)
+template <class T>
+using DataPointeeT =
+    typename std::remove_cv<typename std::remove_pointer<decltype(std::declval<T>().data())>::type>::type;
+
+// Whether O is laid out as exactly D packed scalars of type R, like glm::vec3 or std::array<float,3>, so that a
+// std::vector<O> can be written as one flat array of R
+template <class O, unsigned int D, class R>
+struct IsPackedVectorT
+    : std::integral_constant<bool, std::is_trivially_copyable<O>::value && std::is_standard_layout<O>::value &&
+                                       sizeof(O) == D * sizeof(R)> {};
+
+// Write dst[i] = src[i * stride] for n scalars
+template <class R, class S>
+void convertStridedScalars(const S* src, size_t n, size_t stride, R* dst) {
+  parallelFor(0, n, [&](size_t start, size_t end) {
+    if (stride == 1 && std::is_same<R, S>::value) {
+      std::memcpy(dst + start, src + start, (end - start) * sizeof(R));
+    } else if (stride == 1) {
+      for (size_t i = start; i < end; i++) {
+        dst[i] = static_cast<R>(src[i]);
+      }
+    } else {
+      for (size_t i = start; i < end; i++) {
+        dst[i] = static_cast<R>(src[i * stride]);
+      }
+    }
+  }, standardizeParallelMinBlockSize);
+}
+
+// Convert n vectors, where entry j of vector i is src[i * rowStride + j * colStride]
+// (version for an output type which is not packed, written entry-by-entry)
+template <class O, unsigned int D, class S>
+void convertStridedVectorsImpl(std::false_type, const S* src, size_t n, size_t rowStride, size_t colStride,
+                               std::vector<O>& out) {
+  typedef typename InnerType<O>::type R;
+  parallelFor(0, n, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      for (size_t j = 0; j < D; j++) {
+        out[i][j] = static_cast<R>(src[i * rowStride + j * colStride]);
+      }
+    }
+  }, standardizeParallelMinBlockSize / D);
+}
+
+// (version for a packed output type, written as a flat array of scalars)
+template <class O, unsigned int D, class S>
+void convertStridedVectorsImpl(std::true_type, const S* src, size_t n, size_t rowStride, size_t colStride,
+                               std::vector<O>& out) {
+  typedef typename InnerType<O>::type R;
+  R* dst = reinterpret_cast<R*>(out.data());
+  if (rowStride == D && colStride == 1) {
+    convertStridedScalars<R, S>(src, n * D, 1, dst);
+    return;
+  }
+  parallelFor(0, n, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      for (size_t j = 0; j < D; j++) {
+        dst[D * i + j] = static_cast<R>(src[i * rowStride + j * colStride]);
+      }
+    }
+  }, standardizeParallelMinBlockSize / D);
+}
+
+template <class O, unsigned int D, class S>
+std::vector<O> convertStridedVectors(const S* src, size_t n, size_t rowStride, size_t colStride) {
+  std::vector<O> out(n);
+  if (n > 0) {
+    typedef typename InnerType<O>::type R;
+    convertStridedVectorsImpl<O, D, S>(IsPackedVectorT<O, D, R>{}, src, n, rowStride, colStride, out);
+  }
+  return out;
+}
+
+
+// =================================================
+// ============ data spans
+// =================================================
+
+// A lightweight view of packed data already in memory, which the standardize functions below (and so every
+// register*() and add*Quantity() function) convert directly with the bulk helpers above, without resolving any of the
+// adaptors. size() is the number of entries: scalars, or for the vector-array functions vectors, given either as
+// packed vector types (like glm::vec3) or as a flat row-major array of D scalars each.
+template <class S>
+struct DataSpan {
+  const S* ptr;
+  size_t count;
+  const S* data() const { return ptr; }
+  size_t size() const { return count; }
+};
+
+template <class S>
+DataSpan<S> dataSpan(const S* data, size_t size) {
+  return DataSpan<S>{data, size};
+}
+template <class S>
+DataSpan<S> dataSpan(const std::vector<S>& data) {
+  return DataSpan<S>{data.data(), data.size()};
+}
+
+template <class T>
+struct IsDataSpanT : std::false_type {};
+template <class S>
+struct IsDataSpanT<DataSpan<S>> : std::true_type {};
+
+// The scalars of a span's entries: the entries themselves, or the entries of packed vectors
+template <class S, bool = std::is_arithmetic<S>::value>
+struct DataSpanScalarT {
+  typedef S type;
+};
+template <class S>
+struct DataSpanScalarT<S, false> {
+  typedef typename std::remove_cv<typename InnerType<S>::type>::type type;
+};
+
 // =================================================
 // ============ array access adapator
 // =================================================
@@ -231,6 +361,8 @@ size_t adaptorF_size(const T& inputData) {
 //
 // The following hierarchy of strategies will be attempted, with decreasing precedence:
 // - user-defined adaptorF_custom_convertToStdVector()
+// - strided arithmetic data, via .data() and .innerStride() (like Eigen vectors)
+// - contiguous arithmetic data, via .data() (like std::vector<>)
 // - bracket access
 // - callable (parenthesis) access
 // - iterable (begin() and end())
@@ -247,7 +379,7 @@ template <class T, class S,
   /* condition: user defined function exists and returns something that can be bracket-indexed to get an S */
   typename C1 = typename std::enable_if< std::is_same<decltype((S)adaptorF_custom_convertToStdVector(std::declval<T>())[0]), S>::value>::type>
 
-void adaptorF_convertToStdVectorImpl(PreferenceT<4>, const T& inputData, std::vector<S>& out) {
+void adaptorF_convertToStdVectorImpl(PreferenceT<6>, const T& inputData, std::vector<S>& out) {
   auto userVec = adaptorF_custom_convertToStdVector(inputData);
 
   // If the user-provided function returns something else, try to convert it to a std::vector<S>.
@@ -263,6 +395,37 @@ void adaptorF_convertToStdVectorImpl(PreferenceT<4>, const T& inputData, std::ve
 }
 
 
+// Next: strided data
+template <class T, class S,
+  /* helper type: the scalar type the data pointer points to */
+  typename C_DATA = DataPointeeT<T>,
+  /* condition: input data and output are both arithmetic */
+  typename C1 = typename std::enable_if<std::is_arithmetic<C_DATA>::value && std::is_arithmetic<S>::value>::type,
+  /* condition: input has an .innerStride() */
+  typename C_STRIDE = decltype(static_cast<size_t>(std::declval<T>().innerStride()))>
+
+void adaptorF_convertToStdVectorImpl(PreferenceT<5>, const T& inputData, std::vector<S>& dataOut) {
+  size_t dataSize = adaptorF_size(inputData);
+  dataOut.resize(dataSize);
+  convertStridedScalars<S, C_DATA>(inputData.data(), dataSize, static_cast<size_t>(inputData.innerStride()),
+                                   dataOut.data());
+}
+
+
+// Next: contiguous data
+template <class T, class S,
+  /* helper type: the scalar type the data pointer points to */
+  typename C_DATA = DataPointeeT<T>,
+  /* condition: input data and output are both arithmetic */
+  typename C1 = typename std::enable_if<std::is_arithmetic<C_DATA>::value && std::is_arithmetic<S>::value>::type>
+
+void adaptorF_convertToStdVectorImpl(PreferenceT<4>, const T& inputData, std::vector<S>& dataOut) {
+  size_t dataSize = adaptorF_size(inputData);
+  dataOut.resize(dataSize);
+  convertStridedScalars<S, C_DATA>(inputData.data(), dataSize, 1, dataOut.data());
+}
+
+
 // Next: any bracket access operator
 template <class T, class S,
   /* condition: input can be bracket-indexed to get an S */
@@ -322,7 +485,7 @@ void adaptorF_convertToStdVectorImpl(PreferenceT<0>, const T& inputData, std::ve
 // General version, which will attempt to substitute in to the variants above
 template <class S, class T>
 void adaptorF_convertToStdVector(const T& inputData, std::vector<S>& dataOut) {
-  adaptorF_convertToStdVectorImpl<T, S>(PreferenceT<4>{}, inputData, dataOut);
+  adaptorF_convertToStdVectorImpl<T, S>(PreferenceT<6>{}, inputData, dataOut);
 }
 
 
@@ -552,6 +715,9 @@ S adaptorF_accessVector3Value(const T& inVal) {
 // The following hierarchy of strategies will be attempted, with decreasing precedence:
 //   - any user defined function
 //          std::vector<std::array<F, D>> adaptorF_custom_convertArrayOfVectorToStdVector(const YOUR_TYPE& inputData);
+//   - strided matrix data, via .data(), .innerStride(), .outerStride(), and ::IsRowMajor (like Eigen matrices)
+//   - contiguous array of packed vectors, via .data() (like std::vector<glm::vec3> or std::vector<std::array<S,D>>)
+//   - tuple {data_ptr, size}
 //   - dense callable (parenthesis) access (like T(i,j))
 //   - double bracket access (like T[i][j])
 //   - outer type bracket accessbile, inner anything convertible to Vector2/3
@@ -573,7 +739,7 @@ template <
     typename C1 = typename std::enable_if<std::is_same< 
                                           decltype((typename InnerType<O>::type)(adaptorF_custom_convertArrayOfVectorToStdVector(std::declval<T>()))[0][0]), 
                                           typename InnerType<O>::type>::value>::type>
-std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<9>, const T& inputData) {
+std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<11>, const T& inputData) {
 
   // should be std::vector<std::array<SCALAR,D>>
   auto userArr = adaptorF_custom_convertArrayOfVectorToStdVector(inputData);
@@ -590,6 +756,49 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<9>, cons
   return dataOut;
 }
 
+// Next: strided matrix data, in either storage order
+template <class O, unsigned int D, class T,
+    /* helper type: the scalar type the data pointer points to */
+    typename C_DATA = DataPointeeT<T>,
+    /* condition: input data is arithmetic */
+    typename C1 = typename std::enable_if<std::is_arithmetic<C_DATA>::value>::type,
+    /* condition: input has row count, strides, and a storage order */
+    typename C_ROWS = decltype(static_cast<size_t>(std::declval<T>().rows())),
+    typename C_INNER_STRIDE = decltype(static_cast<size_t>(std::declval<T>().innerStride())),
+    typename C_OUTER_STRIDE = decltype(static_cast<size_t>(std::declval<T>().outerStride())),
+    typename C_ORDER = decltype(static_cast<bool>(T::IsRowMajor))
+  >
+
+std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<10>, const T& inputData) {
+  size_t innerStride = static_cast<size_t>(inputData.innerStride());
+  size_t outerStride = static_cast<size_t>(inputData.outerStride());
+  bool rowMajor = static_cast<bool>(T::IsRowMajor);
+  size_t rowStride = rowMajor ? outerStride : innerStride;
+  size_t colStride = rowMajor ? innerStride : outerStride;
+  return convertStridedVectors<O, D, C_DATA>(inputData.data(), static_cast<size_t>(inputData.rows()), rowStride,
+                                             colStride);
+}
+
+
+// Next: contiguous array of packed vectors
+template <class O, unsigned int D, class T,
+    /* helper type: the vector type the data pointer points to */
+    typename C_VEC = DataPointeeT<T>,
+    /* helper type: the scalar type, from bracket-indexing the vector type (which must give a reference in to it) */
+    typename C_VEC_REF = decltype(std::declval<const C_VEC&>()[0]),
+    typename C_SCALAR = typename std::remove_cv<typename std::remove_reference<C_VEC_REF>::type>::type,
+    /* condition: the vectors are exactly D packed arithmetic scalars */
+    typename C1 = typename std::enable_if<std::is_lvalue_reference<C_VEC_REF>::value &&
+                                          std::is_arithmetic<C_SCALAR>::value &&
+                                          IsPackedVectorT<C_VEC, D, C_SCALAR>::value>::type
+  >
+
+std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<9>, const T& inputData) {
+  size_t dataSize = adaptorF_size(inputData);
+  return convertStridedVectors<O, D, C_SCALAR>(reinterpret_cast<const C_SCALAR*>(inputData.data()), dataSize, D, 1);
+}
+
+
 // Next: tuple {data_ptr, size} (size is number of vector entries, so ptr should point to D*size valid entries)
 template <class O, unsigned int D, class T,
     /* condition: first entry of input can be dereferenced to get a type castable to the scalar type O */
@@ -602,16 +811,7 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<8>, cons
 
   size_t dataSize = static_cast<size_t>(std::get<1>(inputData));
   auto* dataPtr = std::get<0>(inputData);
-
-  std::vector<O> dataOut(dataSize);
-
-  for (size_t i = 0; i < dataSize; i++) {
-    for (size_t j = 0; j < D; j++) {
-      dataOut[i][j] = dataPtr[D * i + j];
-    }
-  }
-
-  return dataOut;
+  return convertStridedVectors<O, D>(dataPtr, dataSize, D, 1);
 }
 
 
@@ -797,7 +997,7 @@ std::vector<O> adaptorF_convertArrayOfVectorToStdVectorImpl(PreferenceT<0>, cons
 // General version, which will attempt to substitute in to the variants above
 template <class O, unsigned int D, class T>
 std::vector<O> adaptorF_convertArrayOfVectorToStdVector(const T& inputData) {
-  return adaptorF_convertArrayOfVectorToStdVectorImpl<O, D, T>(PreferenceT<9>{}, inputData);
+  return adaptorF_convertArrayOfVectorToStdVectorImpl<O, D, T>(PreferenceT<11>{}, inputData);
 }
 
 
@@ -1134,11 +1334,22 @@ O standardizeVector3D(const T& inputVec) {
 // class D: scalar data type
 // class T: input array type
 template <class D, class T>
-std::vector<D> standardizeArray(const T& inputData) {
+std::vector<D> standardizeArrayImpl(std::false_type, const T& inputData) {
   std::vector<D> out;
   adaptorF_convertToStdVector<D, T>(inputData, out);
   return out;
 }
+template <class D, class S>
+std::vector<D> standardizeArrayImpl(std::true_type, const DataSpan<S>& span) {
+  std::vector<D> out(span.size());
+  convertStridedScalars<D, S>(span.data(), span.size(), 1, out.data());
+  return out;
+}
+template <class D, class T>
+std::vector<D> standardizeArray(const T& inputData) {
+  profiling::ScopedTimer timer("standardizeArray");
+  return standardizeArrayImpl<D>(IsDataSpanT<T>{}, inputData);
+}
 
 // Convert an array of vector types
 // class O: output inner vector type to put the result in. Will be bracket-indexed.
@@ -1146,15 +1357,28 @@ std::vector<D> standardizeArray(const T& inputData) {
 // unsigned int D: dimension of inner vector type
 // class T: input array type
 template <class O, unsigned int D, class T>
-std::vector<O> standardizeVectorArray(const T& inputData) {
+std::vector<O> standardizeVectorArrayImpl(std::false_type, const T& inputData) {
   return adaptorF_convertArrayOfVectorToStdVector<O, D, T>(inputData);
 }
+template <class O, unsigned int D, class S>
+std::vector<O> standardizeVectorArrayImpl(std::true_type, const DataSpan<S>& span) {
+  typedef typename DataSpanScalarT<S>::type R;
+  static_assert(std::is_arithmetic<S>::value || IsPackedVectorT<S, D, R>::value,
+                "the entries of a DataSpan<> of vectors must be D packed scalars");
+  return convertStridedVectors<O, D, R>(reinterpret_cast<const R*>(span.data()), span.size(), D, 1);
+}
+template <class O, unsigned int D, class T>
+std::vector<O> standardizeVectorArray(const T& inputData) {
+  profiling::ScopedTimer timer("standardizeVectorArray");
+  return standardizeVectorArrayImpl<O, D>(IsDataSpanT<T>{}, inputData);
+}
 
 // Convert a nested array where the inner types have variable length.
 // class S: innermost scalar type for output
 // class T: input nested array type
 template <class S, class I, class T>
 std::tuple<std::vector<S>, std::vector<I>> standardizeNestedList(const T& inputData) {
+  profiling::ScopedTimer timer("standardizeNestedList");
   return adaptorF_convertNestedArrayToStdVector<S, I>(inputData);
 }
 
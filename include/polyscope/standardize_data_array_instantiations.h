@@ -0,0 +1,110 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+// Opt-in: declares the standardize functions for common input types as instantiated in the library, so that
+// translation units which include this header don't instantiate the adaptors in standardize_data_array.h for them.
+// Include it before calling any register*() or add*Quantity() function.
+//
+// Other types (e.g. Eigen matrices) can be handled the same way in your own code: write the explicit instantiations
+// for them with `extern` in a header which your translation units include, and without it in one source file.
+//
+//   extern template std::vector<glm::vec3>
+//   polyscope::standardizeVectorArray<glm::vec3, 3, Eigen::MatrixXd>(const Eigen::MatrixXd&);
+//   extern template void polyscope::validateSize<Eigen::MatrixXd>(const Eigen::MatrixXd&, size_t, std::string);
+//
+// For data which is already packed in memory, passing a DataSpan<> (see dataSpan()) skips the adaptors for any type.
+
+#include "polyscope/standardize_data_array.h"
+
+#include <array>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// clang-format off
+
+// The size checks, for each input type (variadic, since the type may contain commas)
+#define POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, ...)                                                               \
+  PREFIX template void validateSize<__VA_ARGS__>(const __VA_ARGS__&, std::vector<size_t>, std::string);               \
+  PREFIX template void validateSize<__VA_ARGS__>(const __VA_ARGS__&, size_t, std::string);
+
+// (PREFIX is `extern` for the declarations, and empty for the definitions compiled in to the library)
+#define POLYSCOPE_STANDARDIZE_INSTANTIATIONS(PREFIX)                                                                   \
+                                                                                                                       \
+  /* scalar arrays */                                                                                                  \
+  PREFIX template std::vector<float> standardizeArray<float, std::vector<float>>(const std::vector<float>&);          \
+  PREFIX template std::vector<float> standardizeArray<float, std::vector<double>>(const std::vector<double>&);        \
+  PREFIX template std::vector<float> standardizeArray<float, std::vector<int>>(const std::vector<int>&);              \
+  PREFIX template std::vector<double> standardizeArray<double, std::vector<float>>(const std::vector<float>&);        \
+  PREFIX template std::vector<double> standardizeArray<double, std::vector<double>>(const std::vector<double>&);      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<float>)                                                      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<double>)                                                     \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<int>)                                                        \
+                                                                                                                       \
+  /* positions and vectors */                                                                                          \
+  PREFIX template std::vector<glm::vec3>                                                                               \
+  standardizeVectorArray<glm::vec3, 3, std::vector<glm::vec3>>(const std::vector<glm::vec3>&);                         \
+  PREFIX template std::vector<glm::vec3>                                                                               \
+  standardizeVectorArray<glm::vec3, 3, std::vector<std::array<float, 3>>>(const std::vector<std::array<float, 3>>&);  \
+  PREFIX template std::vector<glm::vec3>                                                                               \
+  standardizeVectorArray<glm::vec3, 3, std::vector<std::array<double, 3>>>(const std::vector<std::array<double, 3>>&);\
+  PREFIX template std::vector<glm::vec3>                                                                               \
+  standardizeVectorArray<glm::vec3, 2, std::vector<glm::vec2>>(const std::vector<glm::vec2>&);                         \
+  PREFIX template std::vector<glm::vec3>                                                                               \
+  standardizeVectorArray<glm::vec3, 2, std::vector<std::array<double, 2>>>(const std::vector<std::array<double, 2>>&);\
+  PREFIX template std::vector<glm::vec2>                                                                               \
+  standardizeVectorArray<glm::vec2, 2, std::vector<glm::vec2>>(const std::vector<glm::vec2>&);                         \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<glm::vec2>)                                                  \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<glm::vec3>)                                                  \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<float, 3>>)                                       \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<double, 3>>)                                      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<double, 2>>)                                      \
+                                                                                                                       \
+  /* colors */                                                                                                         \
+  PREFIX template std::vector<glm::vec4>                                                                               \
+  standardizeVectorArray<glm::vec4, 3, std::vector<glm::vec3>>(const std::vector<glm::vec3>&);                         \
+  PREFIX template std::vector<glm::vec4>                                                                               \
+  standardizeVectorArray<glm::vec4, 4, std::vector<glm::vec4>>(const std::vector<glm::vec4>&);                         \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<glm::vec4>)                                                  \
+                                                                                                                       \
+  /* connectivity */                                                                                                   \
+  PREFIX template std::vector<std::array<size_t, 2>>                                                                   \
+  standardizeVectorArray<std::array<size_t, 2>, 2, std::vector<std::array<size_t, 2>>>(                                \
+      const std::vector<std::array<size_t, 2>>&);                                                                      \
+  PREFIX template std::vector<std::array<size_t, 2>>                                                                   \
+  standardizeVectorArray<std::array<size_t, 2>, 2, std::vector<std::array<int, 2>>>(                                   \
+      const std::vector<std::array<int, 2>>&);                                                                         \
+  PREFIX template std::vector<std::array<uint32_t, 4>>                                                                 \
+  standardizeVectorArray<std::array<uint32_t, 4>, 4, std::vector<std::array<size_t, 4>>>(                              \
+      const std::vector<std::array<size_t, 4>>&);                                                                      \
+  PREFIX template std::vector<std::array<uint32_t, 8>>                                                                 \
+  standardizeVectorArray<std::array<uint32_t, 8>, 8, std::vector<std::array<int, 8>>>(                                 \
+      const std::vector<std::array<int, 8>>&);                                                                         \
+  PREFIX template std::vector<std::array<uint32_t, 8>>                                                                 \
+  standardizeVectorArray<std::array<uint32_t, 8>, 8, std::vector<std::array<size_t, 8>>>(                              \
+      const std::vector<std::array<size_t, 8>>&);                                                                      \
+  PREFIX template std::tuple<std::vector<uint32_t>, std::vector<uint32_t>>                                             \
+  standardizeNestedList<uint32_t, uint32_t, std::vector<std::vector<size_t>>>(const std::vector<std::vector<size_t>>&);\
+  PREFIX template std::tuple<std::vector<uint32_t>, std::vector<uint32_t>>                                             \
+  standardizeNestedList<uint32_t, uint32_t, std::vector<std::vector<uint32_t>>>(                                       \
+      const std::vector<std::vector<uint32_t>>&);                                                                      \
+  PREFIX template std::tuple<std::vector<uint32_t>, std::vector<uint32_t>>                                             \
+  standardizeNestedList<uint32_t, uint32_t, std::vector<std::array<size_t, 3>>>(                                       \
+      const std::vector<std::array<size_t, 3>>&);                                                                      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<size_t, 2>>)                                      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<int, 2>>)                                         \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<size_t, 4>>)                                      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<int, 8>>)                                         \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<size_t, 8>>)                                      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::vector<size_t>>)                                        \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::vector<uint32_t>>)                                      \
+  POLYSCOPE_STANDARDIZE_VALIDATE_SIZE(PREFIX, std::vector<std::array<size_t, 3>>)
+
+// clang-format on
+
+namespace polyscope {
+POLYSCOPE_STANDARDIZE_INSTANTIATIONS(extern)
+} // namespace polyscope
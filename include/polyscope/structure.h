@@ -5,17 +5,24 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <cstdint>
 #include <string>
 
 #include "glm/glm.hpp"
 
+#include "polyscope/bvh.h"
+#include "polyscope/insertion_ordered_map.h"
 #include "polyscope/persistent_value.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/render/managed_buffer.h"
 #include "polyscope/transformation_gizmo.h"
 
 
 namespace polyscope {
 
+// Identifies a registered structure for the lifetime of the program. Never reused, and 0 is never a valid handle.
+typedef uint64_t StructureHandle;
+
 
 // A 'structure' in Polyscope terms, is an object with which we can associate data in the UI, such as a point cloud,
 // or a mesh. This in contrast to 'quantities', which we associate with the structures. For instance, a surface mesh
@@ -38,6 +45,15 @@ public:
   virtual void drawDelayed() = 0;
   virtual void drawPick() = 0;
 
+  // True while preparation work is still running in the background (see options::prepareStructuresInBackground).
+  // Loading structures are skipped when drawing and picking.
+  virtual bool isLoading();
+
+  // Structures of the same type are drawn in order of this key when the order does not change the image (see
+  // options::sortDrawsByMaterial), so that consecutive draws reuse the same programs and material textures. Structures
+  // with a material return its name; the default is empty.
+  virtual std::string drawSortKey();
+
   // == Add rendering rules
   std::vector<std::string> addStructureRules(std::vector<std::string> initRules);
 
@@ -50,18 +66,50 @@ public:
   virtual void buildSharedStructureUI();  // Draw any UI elements shared between all instances of the structure
   virtual void buildPickUI(size_t localPickID) = 0; // Draw pick UI elements when index localPickID is selected
 
+  // == CPU-side ray picking
+  // Intersect a world-space ray with the structure without touching the render engine, using acceleration data which
+  // is lazily built on the first query. Structures which support it override this; the default never hits.
+  virtual RayPickResult rayPick(glm::vec3 rayStart, glm::vec3 rayDir);
+
   // = Identifying data
   const std::string name; // should be unique amongst registered structures with this type
-  std::string uniquePrefix();
+  const std::string& uniquePrefix() { return uniquePrefixStr; }
 
   std::string getName() { return name; }; // used by pybind to access the name property
 
+  // A handle assigned when the structure is registered, which can be passed to getStructureByHandle() to find it again
+  // without going through string lookups (0 if the structure has not been registered)
+  StructureHandle getHandle() { return handle; }
+  StructureHandle handle = 0; // set by registerStructure()
+
+  // = Memory usage
+  // (estimated bytes held by the structure and all of its quantities)
+  render::GPUMemoryUsage getGPUMemoryUsage();
+  size_t getHostMemoryUsage(); // host-side copies of buffer data
+
+  // Free the render buffers and programs of the structure and its quantities. They are rebuilt from the host-side data
+  // when the structure is next drawn. Called automatically to stay within options::gpuMemoryBudgetMB.
+  void releaseGPUResources();
+  uint64_t lastDrawnSceneCount = 0; // internal::renderSceneCount when the structure was last drawn while enabled
+
+  // = Batched updates
+  // Coalesce the updates between these calls (e.g. updating the positions and several quantities for the next frame of
+  // an animation), so each modified buffer is uploaded once at commitUpdate(), rather than once per update. Quantity
+  // histograms are rebuilt once, when next drawn. Do not draw frames in between.
+  void beginUpdate();
+  void commitUpdate();
+
   // = Length and bounding box
   // (returned in world coordinates, after the object transform is applied)
   std::tuple<glm::vec3, glm::vec3> boundingBox(); // get axis-aligned bounding box
   float lengthScale();                            // get characteristic length
   virtual bool hasExtents();                      // bounding box and length scale are only meaningful if true
 
+  // Conservatively test whether the structure may be visible under the given projection * view matrix. False only if
+  // the (object space) bounding box lies entirely outside the frustum. Always true for structures without extents.
+  // Called for many structures at once on worker threads, so it (and hasExtents()) must only read structure state.
+  bool mayBeInViewFrustum(const glm::mat4& viewProjMat);
+
   // = Basic state
   virtual std::string typeName() = 0;
 
@@ -100,8 +148,39 @@ public:
 
   Structure* setIgnoreSlicePlane(std::string name, bool newValue);
   bool getIgnoreSlicePlane(std::string name);
+  uint32_t getSlicePlaneIgnoreMask(); // bit i is set if this structure ignores state::slicePlanes[i]
+
+  // Static structures are drawn in to a cached layer, which is only re-rendered when the camera or a static structure
+  // changes, and the other (dynamic) structures are drawn over it each frame. Meant for large context geometry which
+  // stays put while something small moves. Only applies without transparency or deferred shading.
+  Structure* setStatic(bool newVal);
+  bool isStatic();
+
+  // = Element subsets
+  // The elements are the points of a point cloud, the faces of a surface mesh, the edges of a curve network (whose
+  // nodes are shown with their edges), or the cells of a volume mesh. setVisibleSubset() hides all but the given
+  // elements, including from picking (but not from rayPick()), and setHighlightedSubset() tints the given ones with
+  // the highlight color. Each subset is kept as a bitmask on the device, one bit per element, which the shaders read,
+  // so changing a subset only uploads the mask; setting or clearing one rebuilds the programs. Elements added after a
+  // subset was set (e.g. appended points) are not in it.
+  Structure* setVisibleSubset(const std::vector<size_t>& indices);
+  Structure* clearVisibleSubset();
+  bool hasVisibleSubset();
+  bool isVisibleInSubset(size_t ind); // (true for every element if there is no visible subset)
+  Structure* setHighlightedSubset(const std::vector<size_t>& indices);
+  Structure* clearHighlightedSubset();
+  bool hasHighlightedSubset();
+  bool isHighlightedInSubset(size_t ind);
+  Structure* setSubsetHighlightColor(glm::vec3 newVal);
+  glm::vec3 getSubsetHighlightColor();
+
+  // Request a redraw because this structure changed. Hides polyscope::requestRedraw() in member functions, so that
+  // changes to a dynamic structure leave the static layer valid.
+  void requestRedraw();
 
 protected:
+  const std::string uniquePrefixStr; // "[type]#[name]#", built once on construction and prepended to all names
+
   // = State
   PersistentValue<bool> enabled;
   PersistentValue<glm::mat4> objectTransform; // rigid transform
@@ -114,8 +193,28 @@ protected:
 
   PersistentValue<bool> cullWholeElements;
 
+  PersistentValue<bool> staticStructure;
+
   PersistentValue<std::vector<std::string>> ignoredSlicePlaneNames;
 
+  int openUpdates = 0; // beginUpdate() calls without a commitUpdate() yet
+
+  // Element subsets, see setVisibleSubset(). Bit i % 32 of word i / 32 of a mask is set for element i.
+  virtual size_t nSubsetElements(); // structures which support subsets override this
+  virtual void subsetMasksChanged(); // for structures which derive data from the masks
+  bool hasSubsetMasks() { return visibleSubsetIsSet || highlightedSubsetIsSet; }
+  // Adds indexRule, which provides the element index, and the rules which apply the masks (if there are any)
+  std::vector<std::string> addSubsetRules(std::vector<std::string> initRules, const std::string& indexRule);
+  // (the tint would change the pick colors)
+  std::vector<std::string> removeSubsetHighlightRules(std::vector<std::string> pickRules);
+  std::vector<uint32_t> visibleSubsetMaskData;
+  std::vector<uint32_t> highlightedSubsetMaskData;
+  render::ManagedBuffer<uint32_t> visibleSubsetMask;
+  render::ManagedBuffer<uint32_t> highlightedSubsetMask;
+  bool visibleSubsetIsSet = false;
+  bool highlightedSubsetIsSet = false;
+  PersistentValue<glm::vec3> subsetHighlightColor;
+
   // Manage the bounding box & length scale
   // (this is defined _before_ the object transform is applied. To get the scale/bounding box after transforms, use the
   // boundingBox() and lengthScale() member function)
@@ -123,6 +222,15 @@ protected:
   std::tuple<glm::vec3, glm::vec3> objectSpaceBoundingBox;
   float objectSpaceLengthScale;
   virtual void updateObjectSpaceBounds() = 0;
+
+  // Transform a world-space ray in to object space for ray queries. rayDir should be unit length; the returned
+  // direction is not normalized, so ray parameters agree between world and object space.
+  std::tuple<glm::vec3, glm::vec3> rayToObjectSpace(glm::vec3 rayStart, glm::vec3 rayDir);
+
+  // Conservatively test whether an object space box may be visible, as in mayBeInViewFrustum(). If testSlicePlanes is
+  // set, boxes lying entirely on the culled side of an active slice plane are also rejected.
+  bool objectSpaceBoxMayBeVisible(glm::vec3 bboxMin, glm::vec3 bboxMax, const glm::mat4& viewProjMat,
+                                  bool testSlicePlanes);
 };
 
 
@@ -145,6 +253,13 @@ class ColorImageQuantity;
 class DepthRenderImageQuantity;
 class ColorRenderImageQuantity;
 class ScalarRenderImageQuantity;
+class TiledColorImageQuantity;
+
+// Fills `pixels` (row-major, w*h entries, rows in the order of the image's data) with the region [x0, x0+w) x [y0,
+// y0+h) of the given level of an image pyramid. Level 0 is the full image, and each level halves the one before it,
+// with dimensions rounded up. See TiledColorImageQuantity.
+using ImageTileLoader =
+    std::function<void(int level, size_t x0, size_t y0, size_t w, size_t h, std::vector<glm::vec4>& pixels)>;
 
 // Helper used to define quantity types
 template <typename T>
@@ -170,6 +285,10 @@ public:
   // Re-perform any setup work, including refreshing all quantities
   virtual void refresh() override;
 
+  // Re-apply this structure's material to all quantities' programs, e.g. after it changes (see
+  // Quantity::refreshMaterial())
+  void refreshQuantityMaterials();
+
   // = Manage quantities
 
   // Note: takes ownership of pointer after it is passed in
@@ -188,13 +307,13 @@ public:
   void setAllQuantitiesEnabled(bool newEnabled);
 
   // = Quantities
-  std::map<std::string, std::unique_ptr<QuantityType>> quantities;
+  InsertionOrderedMap<std::string, std::unique_ptr<QuantityType>> quantities;
   QuantityS<S>* dominantQuantity = nullptr; // If non-null, a special quantity of which only one can be drawn for
                                             // the structure. Handles common case of a surface color, e.g. color of
                                             // a mesh or point cloud. The dominant quantity must always be enabled.
 
   // floating quantities are tracked separately from normal quantities, though names should still be unique etc
-  std::map<std::string, std::unique_ptr<FloatingQuantity>> floatingQuantities;
+  InsertionOrderedMap<std::string, std::unique_ptr<FloatingQuantity>> floatingQuantities;
 
   // === Floating Quantities
   template <class T>
@@ -210,6 +329,16 @@ public:
   ColorImageQuantity* addColorAlphaImageQuantity(std::string name, size_t dimX, size_t dimY, const T& values_rgba,
                                                  ImageOrigin imageOrigin = ImageOrigin::UpperLeft);
 
+  // Tiled images are drawn from an image pyramid, for images too large to show as a single texture. The first
+  // version builds the pyramid from data in memory, the second fetches tiles on demand (e.g. from disk).
+  template <class T>
+  TiledColorImageQuantity* addTiledColorImageQuantity(std::string name, size_t dimX, size_t dimY, const T& values_rgb,
+                                                      ImageOrigin imageOrigin = ImageOrigin::UpperLeft);
+
+  TiledColorImageQuantity* addTiledColorImageQuantityFromLoader(std::string name, size_t dimX, size_t dimY,
+                                                                ImageTileLoader loader,
+                                                                ImageOrigin imageOrigin = ImageOrigin::UpperLeft);
+
   template <class T1, class T2>
   DepthRenderImageQuantity* addDepthRenderImageQuantity(std::string name, size_t dimX, size_t dimY, const T1& depthData,
                                                         const T2& normalData,
@@ -230,7 +359,7 @@ public:
 
   // === Floating Quantity impls
   ScalarImageQuantity* addScalarImageQuantityImpl(std::string name, size_t dimX, size_t dimY,
-                                                  const std::vector<double>& values, ImageOrigin imageOrigin,
+                                                  const std::vector<float>& values, ImageOrigin imageOrigin,
                                                   DataType type);
 
   ColorImageQuantity* addColorImageQuantityImpl(std::string name, size_t dimX, size_t dimY,
@@ -250,7 +379,7 @@ public:
   ScalarRenderImageQuantity* addScalarRenderImageQuantityImpl(std::string name, size_t dimX, size_t dimY,
                                                               const std::vector<float>& depthData,
                                                               const std::vector<glm::vec3>& normalData,
-                                                              const std::vector<double>& scalarData,
+                                                              const std::vector<float>& scalarData,
                                                               ImageOrigin imageOrigin, DataType type);
 
 protected:
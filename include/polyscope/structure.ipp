@@ -108,6 +108,14 @@ void QuantityStructure<S>::refresh() {
   requestRedraw();
 }
 
+template <typename S>
+void QuantityStructure<S>::refreshQuantityMaterials() {
+  for (auto& qp : quantities) {
+    qp.second->refreshMaterial();
+  }
+  requestRedraw();
+}
+
 template <typename S>
 void QuantityStructure<S>::removeQuantity(std::string name, bool errorIfAbsent) {
 
@@ -213,7 +221,7 @@ ScalarImageQuantity* QuantityStructure<S>::addScalarImageQuantity(std::string na
                                                                   const T& values, ImageOrigin imageOrigin,
                                                                   DataType type) {
   validateSize(values, dimX * dimY, "floating scalar image " + name);
-  return this->addScalarImageQuantityImpl(name, dimX, dimY, standardizeArray<double, T>(values), imageOrigin, type);
+  return this->addScalarImageQuantityImpl(name, dimX, dimY, standardizeArray<float, T>(values), imageOrigin, type);
 }
 
 
@@ -245,6 +253,26 @@ ColorImageQuantity* QuantityStructure<S>::addColorAlphaImageQuantity(std::string
   return this->addColorImageQuantityImpl(name, dimX, dimY, standardVals, imageOrigin);
 }
 
+// (defined in tiled_image_quantity.cpp)
+ImageTileLoader createImagePyramidTileLoader(size_t dimX, size_t dimY, const std::vector<glm::vec4>& data);
+
+template <typename S>
+template <class T>
+TiledColorImageQuantity* QuantityStructure<S>::addTiledColorImageQuantity(std::string name, size_t dimX, size_t dimY,
+                                                                          const T& values_rgb,
+                                                                          ImageOrigin imageOrigin) {
+  validateSize(values_rgb, dimX * dimY, "floating tiled color image " + name);
+
+  // standardize and pad out the alpha component
+  std::vector<glm::vec4> standardVals(standardizeVectorArray<glm::vec4, 3>(values_rgb));
+  for (auto& v : standardVals) {
+    v.a = 1.;
+  }
+
+  return this->addTiledColorImageQuantityFromLoader(name, dimX, dimY,
+                                                    createImagePyramidTileLoader(dimX, dimY, standardVals), imageOrigin);
+}
+
 template <typename S>
 template <class T1, class T2>
 DepthRenderImageQuantity* QuantityStructure<S>::addDepthRenderImageQuantity(std::string name, size_t dimX, size_t dimY,
@@ -294,7 +322,7 @@ QuantityStructure<S>::addScalarRenderImageQuantity(std::string name, size_t dimX
   // standardize
   std::vector<float> standardDepth(standardizeArray<float>(depthData));
   std::vector<glm::vec3> standardNormal(standardizeVectorArray<glm::vec3, 3>(normalData));
-  std::vector<double> standardScalar(standardizeArray<double>(scalarData));
+  std::vector<float> standardScalar(standardizeArray<float>(scalarData));
 
   return this->addScalarRenderImageQuantityImpl(name, dimX, dimY, standardDepth, standardNormal, standardScalar,
                                                 imageOrigin, type);
@@ -306,10 +334,12 @@ QuantityStructure<S>::addScalarRenderImageQuantity(std::string name, size_t dimX
 // Otherwise, we would have to include their respective headers here, and create some really gnarly header dependency
 // chains.
 ScalarImageQuantity* createScalarImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
-                                               const std::vector<double>& data, ImageOrigin imageOrigin,
+                                               const std::vector<float>& data, ImageOrigin imageOrigin,
                                                DataType dataType);
 ColorImageQuantity* createColorImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
                                              const std::vector<glm::vec4>& data, ImageOrigin imageOrigin);
+TiledColorImageQuantity* createTiledColorImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
+                                                       ImageTileLoader loader, ImageOrigin imageOrigin);
 DepthRenderImageQuantity* createDepthRenderImage(Structure& parent, std::string name, size_t dimX, size_t dimY,
                                                  const std::vector<float>& depthData,
                                                  const std::vector<glm::vec3>& normalData, ImageOrigin imageOrigin);
@@ -323,12 +353,12 @@ ColorRenderImageQuantity* createColorRenderImage(Structure& parent, std::string
 ScalarRenderImageQuantity* createScalarRenderImage(Structure& parent, std::string name, size_t dimX, size_t dimY,
                                                    const std::vector<float>& depthData,
                                                    const std::vector<glm::vec3>& normalData,
-                                                   const std::vector<double>& scalarData, ImageOrigin imageOrigin,
+                                                   const std::vector<float>& scalarData, ImageOrigin imageOrigin,
                                                    DataType type);
 
 template <typename S>
 ScalarImageQuantity* QuantityStructure<S>::addScalarImageQuantityImpl(std::string name, size_t dimX, size_t dimY,
-                                                                      const std::vector<double>& values,
+                                                                      const std::vector<float>& values,
                                                                       ImageOrigin imageOrigin, DataType type) {
   ScalarImageQuantity* q = createScalarImageQuantity(*this, name, dimX, dimY, values, imageOrigin, type);
   addQuantity(q);
@@ -344,6 +374,15 @@ ColorImageQuantity* QuantityStructure<S>::addColorImageQuantityImpl(std::string
   return q;
 }
 
+template <typename S>
+TiledColorImageQuantity* QuantityStructure<S>::addTiledColorImageQuantityFromLoader(std::string name, size_t dimX,
+                                                                                    size_t dimY, ImageTileLoader loader,
+                                                                                    ImageOrigin imageOrigin) {
+  TiledColorImageQuantity* q = createTiledColorImageQuantity(*this, name, dimX, dimY, loader, imageOrigin);
+  addQuantity(q);
+  return q;
+}
+
 template <typename S>
 DepthRenderImageQuantity* QuantityStructure<S>::addDepthRenderImageQuantityImpl(
     std::string name, size_t dimX, size_t dimY, const std::vector<float>& depthData,
@@ -366,7 +405,7 @@ ColorRenderImageQuantity* QuantityStructure<S>::addColorRenderImageQuantityImpl(
 template <typename S>
 ScalarRenderImageQuantity* QuantityStructure<S>::addScalarRenderImageQuantityImpl(
     std::string name, size_t dimX, size_t dimY, const std::vector<float>& depthData,
-    const std::vector<glm::vec3>& normalData, const std::vector<double>& scalarData, ImageOrigin imageOrigin,
+    const std::vector<glm::vec3>& normalData, const std::vector<float>& scalarData, ImageOrigin imageOrigin,
     DataType type) {
   ScalarRenderImageQuantity* q =
       createScalarRenderImage(*this, name, dimX, dimY, depthData, normalData, scalarData, imageOrigin, type);
@@ -16,10 +16,13 @@ class SurfaceColorQuantity : public SurfaceMeshQuantity, public ColorQuantity<Su
 public:
   SurfaceColorQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn,
                        const std::vector<glm::vec3>& colorValues);
+  SurfaceColorQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn,
+                       const std::vector<uint32_t>& packedColorValues);
 
   virtual void draw() override;
   virtual std::string niceName() override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
 protected:
   // UI internals
@@ -37,10 +40,12 @@ protected:
 class SurfaceVertexColorQuantity : public SurfaceColorQuantity {
 public:
   SurfaceVertexColorQuantity(std::string name, SurfaceMesh& mesh_, std::vector<glm::vec3> values_);
+  SurfaceVertexColorQuantity(std::string name, SurfaceMesh& mesh_, std::vector<uint32_t> packedValues_);
 
   virtual void createProgram() override;
 
   void buildVertexInfoGUI(size_t vInd) override;
+  virtual bool fitsMeshTopology() override;
 };
 
 // ========================================================
@@ -54,6 +59,7 @@ public:
   virtual void createProgram() override;
 
   void buildFaceInfoGUI(size_t fInd) override;
+  virtual bool fitsMeshTopology() override;
 };
 
 } // namespace polyscope
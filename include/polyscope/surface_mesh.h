@@ -2,11 +2,13 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
 #include <vector>
 
 #include "polyscope/affine_remapper.h"
 #include "polyscope/color_management.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/render/managed_buffer.h"
@@ -59,14 +61,19 @@ public:
   // initializes members
   SurfaceMesh(std::string name);
 
-  // From flattened list
-  SurfaceMesh(std::string name, const std::vector<glm::vec3>& vertexPositions,
-              const std::vector<uint32_t>& faceIndsEntries, const std::vector<uint32_t>& faceIndsStart);
+  // From flattened list (taken by value, so callers can move their arrays in rather than copying them)
+  SurfaceMesh(std::string name, std::vector<glm::vec3> vertexPositions, std::vector<uint32_t> faceIndsEntries,
+              std::vector<uint32_t> faceIndsStart);
 
   // Construct from a nested face list
   SurfaceMesh(std::string name, const std::vector<glm::vec3>& vertexPositions,
               const std::vector<std::vector<size_t>>& faceIndices);
 
+  // A view of the geometry of another mesh, see isGeometryView()
+  SurfaceMesh(std::string name, SurfaceMesh& geometrySource);
+
+  ~SurfaceMesh();
+
 
   // Build the imgui display
   virtual void buildCustomUI() override;
@@ -77,9 +84,13 @@ public:
   virtual void draw() override;
   virtual void drawDelayed() override;
   virtual void drawPick() override;
+  virtual bool isLoading() override;
   virtual void updateObjectSpaceBounds() override;
   virtual std::string typeName() override;
+  virtual std::string drawSortKey() override; // the material
   virtual void refresh() override;
+  virtual RayPickResult rayPick(glm::vec3 rayStart, glm::vec3 rayDir) override; // elementInd is the face index
+  virtual size_t nSubsetElements() override; // the faces
 
   // Mesh connectivity
   // (end users probably should not mess with theses)
@@ -101,10 +112,13 @@ public:
   render::ManagedBuffer<uint32_t> triangleAllEdgeInds;     // on triangulated mesh, all 3 [3 * 3 * nTriFace]
   render::ManagedBuffer<uint32_t> triangleAllHalfedgeInds; // on triangulated mesh, all 3 [3 * 3 * nTriFace]
   render::ManagedBuffer<uint32_t> triangleAllCornerInds;   // on triangulated mesh, all 3 [3 * 3 * nTriFace]
+  render::ManagedBuffer<uint32_t> triangleAllVertexInds;   // on triangulated mesh, all 3 [3 * 3 * nTriFace]
+  render::ManagedBuffer<uint32_t> triangleFaces;           // on triangulated mesh, once per triangle [nTriFace]
 
   // internal triangle data for rendering
   render::ManagedBuffer<glm::vec3> baryCoord;  // on the split, triangulated mesh [3 * nTriFace]
   render::ManagedBuffer<glm::vec3> edgeIsReal; // on the split, triangulated mesh [3 * nTriFace]
+  render::ManagedBuffer<glm::uvec3> compressedVertexAttributes; // packed positions and normals [nVert], see below
 
   // other internally-computed geometry
   render::ManagedBuffer<glm::vec3> faceNormals;
@@ -129,12 +143,18 @@ public:
   template <class T> SurfaceHalfedgeScalarQuantity* addHalfedgeScalarQuantity(std::string name, const T& data, DataType type = DataType::STANDARD);
   template <class T> SurfaceCornerScalarQuantity* addCornerScalarQuantity(std::string name, const T& data, DataType type = DataType::STANDARD);
 
+  // = Many scalars at once, e.g. all the fields of a mesh as it is loaded. The fields are standardized, and their
+  //   ranges computed, in parallel across fields, then added in order. Give one name per field.
+  template <class T> std::vector<SurfaceVertexScalarQuantity*> addVertexScalarQuantities(const std::vector<std::string>& names, const std::vector<T>& data, DataType type = DataType::STANDARD);
+  template <class T> std::vector<SurfaceFaceScalarQuantity*> addFaceScalarQuantities(const std::vector<std::string>& names, const std::vector<T>& data, DataType type = DataType::STANDARD);
+
   // = Distance (expect scalar array)
   template <class T> SurfaceVertexScalarQuantity* addVertexDistanceQuantity(std::string name, const T& data);
   template <class T> SurfaceVertexScalarQuantity* addVertexSignedDistanceQuantity(std::string name, const T& data);
 
   // = Colors (expect vec3 array)
   template <class T> SurfaceVertexColorQuantity* addVertexColorQuantity(std::string name, const T& data);
+  template <class T> SurfaceVertexColorQuantity* addPackedVertexColorQuantity(std::string name, const T& data); // RGBA8
   template <class T> SurfaceFaceColorQuantity* addFaceColorQuantity(std::string name, const T& data);
   
 	// = Parameterizations (expect vec2 array)
@@ -147,6 +167,7 @@ public:
 	template <class T> SurfaceVertexVectorQuantity* addVertexVectorQuantity2D(std::string name, const T& vectors, VectorType vectorType = VectorType::STANDARD); 
 	template <class T> SurfaceFaceVectorQuantity* addFaceVectorQuantity(std::string name, const T& vectors, VectorType vectorType = VectorType::STANDARD); 
 	template <class T> SurfaceFaceVectorQuantity* addFaceVectorQuantity2D(std::string name, const T& vectors, VectorType vectorType = VectorType::STANDARD); 
+  template <class T> std::vector<SurfaceVertexVectorQuantity*> addVertexVectorQuantities(const std::vector<std::string>& names, const std::vector<T>& vectors, VectorType vectorType = VectorType::STANDARD); // as for scalars above
   template <class T, class BX, class BY> SurfaceFaceTangentVectorQuantity* addFaceTangentVectorQuantity(std::string name, const T& vectors, const BX& basisX, const BY& basisY, int nSym = 1, VectorType vectorType = VectorType::STANDARD); 
 	template <class T, class BX, class BY> SurfaceVertexTangentVectorQuantity* addVertexTangentVectorQuantity(std::string name, const T& vectors, const BX& basisX, const BY& basisY, int nSym = 1, VectorType vectorType = VectorType::STANDARD);
 	template <class T, class O> SurfaceOneFormTangentVectorQuantity* addOneFormTangentVectorQuantity(std::string name, const T& data, const O& orientations);
@@ -166,13 +187,54 @@ public:
   template <class V>
   void updateVertexPositions2D(const V& newPositions2D);
 
+  // Update the positions of only some of the vertices, for local edits to large meshes: either the vertices
+  // [rangeStart, rangeStart + newPositions.size()), or the vertices in `indices` (newPositions[i] going to
+  // indices[i]). Just the changed entries are uploaded, and the normals, areas, and face centers which have been
+  // computed are updated only on the faces around the changed vertices and on those faces' vertices.
+  template <class V>
+  void updateVertexPositionsRange(size_t rangeStart, const V& newPositions);
+  template <class V>
+  void updateVertexPositionsAt(const std::vector<size_t>& indices, const V& newPositions);
+
+  // Replace the faces of the mesh (and optionally the vertices), keeping the mesh's settings. The existing buffers are
+  // recomputed in place, with their render buffers resized rather than re-created, and the mesh's program is kept if
+  // it still applies. Quantities which still hold one value per element are kept if `keepMatchingQuantities` is true,
+  // and all others are removed. Edge, halfedge, and corner permutations are cleared, since they refer to the old
+  // connectivity.
+  template <class F>
+  void updateTopology(const F& newFaces, bool keepMatchingQuantities = true);
+  template <class V, class F>
+  void updateVertexPositionsAndTopology(const V& newPositions, const F& newFaces, bool keepMatchingQuantities = true);
+
+  // Keyframed animation of the vertex positions, e.g. a deforming mesh. The keyframes (each holding one position per
+  // vertex) are uploaded once, along with normals computed from each of them. setKeyframeTime() then blends the
+  // surrounding pair of keyframes on the GPU, without touching the vertex data on the host. Face centers, areas, and
+  // other values derived from the positions on the host are not updated by it, and the bounds cover all keyframes.
+  // Cleared by updateTopology(). Not available with compressed vertex attributes.
+  template <class V>
+  void setVertexPositionKeyframes(const std::vector<V>& keyframes);
+  void clearVertexPositionKeyframes();
+  size_t nVertexPositionKeyframes();
+  void setKeyframeTime(double t); // in [0, nVertexPositionKeyframes() - 1], fractional times blend linearly
+  double getKeyframeTime();
+
+  // Geometry views. A view (see registerSurfaceMeshView()) is drawn from the geometry buffers of its source mesh: the
+  // positions, triangulation, computed normals and other geometry, pick indices, and their render buffers are all held
+  // once, by the source. Only the face lists are copied. Each view has its own quantities, transform, and settings.
+  // The geometry is updated through the source, and its views follow vertex position updates; the topology,
+  // permutations, and keyframes can't be changed on a mesh which shares its geometry. A source which is removed stays
+  // alive (but is not drawn) as long as it has views.
+  bool isGeometryView() const { return geometrySource != nullptr; }
+  SurfaceMesh* getGeometrySource() { return geometrySource; } // nullptr if this is not a view
+
 
   // === Indexing conventions
 
-  // Permutation arrays. Empty == default ordering
-  std::vector<size_t> edgePerm;
-  std::vector<size_t> halfedgePerm;
-  std::vector<size_t> cornerPerm;
+  // Permutation arrays. Empty == default ordering. Stored in 32 bits like the other indices, so the permuted indices
+  // must be less than 2^32 - 1.
+  std::vector<uint32_t> edgePerm;
+  std::vector<uint32_t> halfedgePerm;
+  std::vector<uint32_t> cornerPerm;
 
   // Set permutations
   template <class T>
@@ -206,6 +268,10 @@ public:
   size_t nFacesTriangulationCount = 0;
   size_t nFacesTriangulation() const { return nFacesTriangulationCount; }
 
+  // Bumped whenever the vertex positions / the faces change, so host-side caches derived from them know to rebuild
+  uint64_t geometryRevision = 0;
+  uint64_t topologyRevision = 0;
+
   size_t nEdgesCount = INVALID_IND; // populating this is expensive...
   size_t nEdges();                  // NOTE causes population of nEdgesCount
 
@@ -216,6 +282,7 @@ public:
   // = Mesh helpers
   void nestedFacesToFlat(const std::vector<std::vector<size_t>>& nestedInds);
   void computeConnectivityData(); // call to populate counts and indices
+  void validateConnectivity(const std::vector<uint32_t>& entries, const std::vector<uint32_t>& start, size_t nVerts);
   void checkTriangular();         // check if the mesh is triangular, print a helpful error if not
 
   // Force the mesh to act as if the specified elements are in use (aka enable them for picking, etc)
@@ -229,7 +296,7 @@ public:
   void ensureHaveManifoldConnectivity();
   // Halfedges are implicitly indexed in order on the triangulated face list
   // (note that this may not match the halfedge perm that the user specifies)
-  std::vector<size_t> twinHalfedge; // for halfedge i, the index of a twin halfedge
+  std::vector<uint32_t> twinHalfedge; // for halfedge i, the index of a twin halfedge (INVALID_IND_32 if none)
 
   static const std::string structureTypeName;
 
@@ -264,6 +331,70 @@ public:
   SurfaceMesh* setShadeStyle(MeshShadeStyle newStyle);
   MeshShadeStyle getShadeStyle();
 
+  // Chunked drawing. If enabled, the triangulation is split in to chunks of consecutive triangles, each with its own
+  // bounding box, and chunks which are outside the view frustum or entirely removed by a slice plane are skipped when
+  // drawing. Chunks follow the order of the faces, so this only helps if nearby faces are stored near each other (as
+  // they are for most scanned or generated meshes). Useful for very large meshes. (default: false)
+  SurfaceMesh* setChunkedDrawing(bool newVal);
+  bool getChunkedDrawing();
+
+  // Meshlet drawing. Like chunked drawing, but the triangulation is split in to small clusters (meshlets) of at most
+  // meshletMaxVertices distinct vertices and meshletMaxTriangles triangles, each with a bounding box and a cone
+  // bounding its face normals. Clusters are culled against the view frustum and slice planes, and when back faces are
+  // culled, clusters which entirely face away from the camera are skipped too. Clusters are runs of consecutive
+  // triangles, so the mesh buffers and pick indices are unchanged. The clusters are built when this is enabled, and
+  // again after the geometry changes. (default: false)
+  static const size_t meshletMaxVertices = 64;
+  static const size_t meshletMaxTriangles = 124;
+  SurfaceMesh* setMeshletDrawing(bool newVal);
+  bool getMeshletDrawing();
+  size_t nDrawClusters(); // the chunks or meshlets, building them if needed
+
+  // Optimized draw order, set at registration by options::optimizeMeshDrawOrder. Each face's run of triangles is moved
+  // so that the triangulation is ordered for the GPU's post-transform vertex cache, and programs which draw indexed
+  // read the vertex data through a gathered copy, in the order the triangles first use the vertices. Only the order of
+  // the triangle buffers changes (see faceTriangleStart()): vertex, face and other element indices stay the user's.
+  bool optimizeDrawOrder = options::optimizeMeshDrawOrder;
+  size_t faceTriangleStart(size_t iF) const; // first triangle of face iF in the triangle buffers
+  std::vector<uint32_t> triangleStartOfFace; // [nFaces] if the order is optimized, set with the triangulation
+  std::vector<uint32_t>& getDrawTriangleVertexInds(); // the index buffer of indexed programs
+  render::ManagedBuffer<uint32_t> drawVertexOrder; // the vertex at each position of the indexed draw order [nVert]
+
+  // Compressed vertex attributes. If enabled, programs which draw indexed (see canDrawIndexed()) read each vertex from
+  // 12 packed bytes rather than 24 bytes of positions and normals: positions quantized to 16 bits per axis over the
+  // mesh's bounding box, and normals octahedral-encoded in 2x16 bits, both decoded in the vertex shader. Positions are
+  // accurate to 1/65535 of the bounding box. Useful for very large meshes, where vertex fetch bandwidth is the limit.
+  // (default: false)
+  SurfaceMesh* setCompressedVertexAttributes(bool newVal);
+  bool getCompressedVertexAttributes();
+
+  // Device geometry compute. If enabled, and the engine supports it (see Engine::supportsMeshGeometryCompute()),
+  // updating the vertex positions recomputes the face normals, face centers, and vertex normals on the GPU from the
+  // uploaded positions, rather than on the host. Those buffers then hold their only copy on the device, which is read
+  // back if something on the host asks for the values. Useful for meshes which deform every frame, e.g. simulation
+  // playback. Face and vertex areas, if in use, are still computed on the host, and this does not apply while using
+  // compressed vertex attributes. (default: false)
+  SurfaceMesh* setDeviceGeometryCompute(bool newVal);
+  bool getDeviceGeometryCompute();
+
+  // Instanced drawing. If instance transforms are set, the mesh is drawn once per transform in a single instanced draw
+  // call, rather than once; each transform is applied before the structure transform. Quantities are drawn on every
+  // instance, except for vector quantities. Instance colors, if given, replace the surface color of each instance.
+  // Picking reports the instance along with the element. Chunked drawing is not used for instanced meshes.
+  SurfaceMesh* setInstanceTransforms(const std::vector<glm::mat4>& transforms);
+  SurfaceMesh* setInstanceColors(const std::vector<glm::vec3>& colors);
+  SurfaceMesh* clearInstances();
+  size_t nInstances() const { return instanceTransformColumnsData.size() / 4; }
+
+  // Thresholding by a vertex or face scalar quantity. Fragments whose value is outside [low, high] are discarded in the
+  // shaders, for drawing and picking alike: whole faces for a face quantity, and the part of each face beyond the
+  // threshold (interpolating along it) for a vertex quantity. Changing the range only sets uniforms, so it stays
+  // interactive for any size of mesh. Meshes with a threshold don't draw indexed.
+  SurfaceMesh* setThresholdQuantity(std::string name, double low, double high);
+  SurfaceMesh* setThresholdRange(double low, double high);
+  std::pair<double, double> getThresholdRange();
+  SurfaceMesh* clearThresholdQuantity();
+
   // == Rendering helpers used by quantities
 
   // void fillGeometryBuffers(render::ShaderProgram& p);
@@ -271,7 +402,30 @@ public:
                                                bool withSurfaceShade = true);
   void setMeshGeometryAttributes(render::ShaderProgram& p);
   void setMeshPickAttributes(render::ShaderProgram& p);
-  void setSurfaceMeshUniforms(render::ShaderProgram& p);
+
+  // Indexed drawing. Programs whose data is all per-vertex can draw the shared per-vertex buffers through an index
+  // buffer, rather than buffers expanded out to every triangle corner. This is possible unless something in the shading
+  // needs per-corner data: the wireframe (barycentric coordinates), flat shading of polygons (face normals), culling
+  // whole elements (face centers), a threshold, or element subsets (face indices). Picking always uses the expanded
+  // buffers.
+  bool canDrawIndexed();
+  std::string getMeshProgramName(bool perVertexData); // "INDEXED_MESH" if the data is per-vertex and canDrawIndexed()
+
+  // The render buffer for per-vertex data, as expected by the program: shared for indexed programs (gathered in to the
+  // draw order, if it is optimized), or expanded to triangle corners otherwise
+  template <typename T>
+  std::shared_ptr<render::AttributeBuffer> getVertexAttributeBuffer(render::ShaderProgram& p,
+                                                                   render::ManagedBuffer<T>& vertexData);
+  void setSurfaceMeshUniforms(render::ShaderProgram& p); // also applies chunked drawing ranges
+
+  // Face data fetch. Rather than expanding per-face data out to triangle corners, programs can look it up in the
+  // fragment shader from a texture view of the face buffer (see ManagedBuffer::getTextureViewBuffer()), by the primitive
+  // ID of the triangle. On meshes with polygons, the triangle's face comes from a per-triangle texture. This is not
+  // possible with chunked drawing (the primitive ID restarts with each range drawn), or if face indices can't be stored
+  // exactly as floats. Programs fetching face data need no per-corner data of their own, so they can be drawn indexed.
+  bool canFetchFaceData();
+  std::vector<std::string> addFaceFetchRules(std::vector<std::string> initRules); // adds MESH_FACE_INDEX_*
+  void setFaceFetchTextures(render::ShaderProgram& p);
 
 
   // === ~DANGER~ experimental/unsupported functions
@@ -284,6 +438,19 @@ public:
 
 
 private:
+  // Initializes members. For a view, the buffers wrap the data of the source mesh.
+  SurfaceMesh(std::string name, SurfaceMesh* geometrySource);
+
+  // == Geometry views
+  SurfaceMesh* geometrySource = nullptr;        // if this is a view, the mesh holding the geometry (never a view)
+  std::shared_ptr<Structure> geometrySourceRef; // keeps the source alive, if it is registered
+  std::vector<SurfaceMesh*> geometryViews;      // the views of this mesh's geometry
+  SurfaceMesh& geometryDataOwner(SurfaceMesh* source); // whose data vectors the buffers wrap (used in construction)
+  SurfaceMesh& geometryOwner() { return geometrySource ? *geometrySource : *this; }
+  void checkNotGeometryView(std::string operation);
+  void checkGeometryNotShared(std::string operation); // neither a view nor the source of one
+  void markGeometryViewsUpdated();                    // after the source's vertex positions change
+
   // == Mesh geometry buffers
   // Storage for the managed buffers above. You should generally interact with these through the managed buffers, not
   // these members.
@@ -291,6 +458,43 @@ private:
   // = positions
   std::vector<glm::vec3> vertexPositionsData;
 
+  // CPU ray picking acceleration over the faces, built lazily and cleared when the geometry changes
+  BVH rayPickBVH;
+
+  // Chunked and meshlet drawing: object space bounds of each cluster of triangles (built lazily, cleared when the
+  // geometry changes), and the ranges of triangle corners which are visible in the current draw
+  static const size_t drawChunkSize = 16384; // in triangles
+  bool chunkedDrawing = false;
+  bool meshletDrawing = false;
+  struct DrawCluster {
+    size_t triangleStart;
+    size_t triangleCount;
+    glm::vec3 boundMin;
+    glm::vec3 boundMax;
+    glm::vec3 sphereCenter; // bounding sphere, for the cone test
+    float sphereRadius;
+    glm::vec3 coneAxis;
+    float coneCutoff; // sine of the cone's half-angle; 1 if the cluster can never be back-face culled
+  };
+  std::vector<DrawCluster> drawClusters;
+  std::vector<std::array<size_t, 2>> visibleDrawRanges;
+  bool usesDrawClusters() const { return chunkedDrawing || meshletDrawing; }
+  void computeDrawClusters();
+  void updateVisibleDrawRanges();
+  void applyDrawRanges(render::ShaderProgram& p); // also sets the instance count, if instanced
+
+  // Instanced drawing. The instance count can change, so rather than ManagedBuffers (whose render buffers have a fixed
+  // size) these are uploaded to each program when it is created, and programs are rebuilt when they change.
+  std::vector<glm::vec4> instanceTransformColumnsData; // columns of each instance transform [4 * nInstances]
+  std::vector<glm::vec3> instanceColorsData;           // empty, or [nInstances]
+
+  // Threshold filtering, see setThresholdQuantity()
+  std::string thresholdQuantityName = ""; // empty string means none
+  std::pair<double, double> thresholdRange{0., 1.};
+  void setThresholdAttribute(render::ShaderProgram& p);
+  void setThresholdUniforms(render::ShaderProgram& p);
+  size_t instancePickStride = 0; // number of pick indices used by each instance
+
   // = connectivity / indices
 
   // other derived indices, all defined per corner of the triangulated mesh
@@ -300,11 +504,61 @@ private:
   std::vector<uint32_t> triangleAllEdgeIndsData;     // index of the corresponding original edge
   std::vector<uint32_t> triangleAllHalfedgeIndsData; // index of the corresponding original halfedge
   std::vector<uint32_t> triangleAllCornerIndsData;   // index of the corresponding original corner
+  std::vector<uint32_t> triangleAllVertexIndsData;   // index of the corresponding vertex
+  std::vector<uint32_t> triangleFacesData;           // index of the original face, once per triangle
 
   // internal triangle data for rendering, defined per corner of the triangulated mesh
   std::vector<glm::vec3> baryCoordData;  // always triangulated
   std::vector<glm::vec3> edgeIsRealData; // always triangulated
 
+  // with an optimized draw order, the indexed draw order
+  std::vector<uint32_t> drawVertexOrderData;
+  std::vector<uint32_t> drawTriangleVertexIndsData; // triangleVertexInds, renumbered by the draw vertex order
+
+  // Keyframes from setVertexPositionKeyframes(). Held in device buffers if the engine can blend them there, on the
+  // host otherwise.
+  struct PositionKeyframe {
+    std::shared_ptr<render::AttributeBuffer> positions;
+    std::shared_ptr<render::AttributeBuffer> vertexNormals;
+    std::shared_ptr<render::AttributeBuffer> faceNormals;
+    std::vector<glm::vec3> positionsData;
+    std::vector<glm::vec3> vertexNormalsData;
+    std::vector<glm::vec3> faceNormalsData;
+  };
+  std::vector<PositionKeyframe> positionKeyframes;
+  double keyframeTime = 0.;
+  void setVertexPositionKeyframesImpl(std::vector<std::vector<glm::vec3>> keyframes);
+
+  // compressed vertex attributes, and the box the positions are quantized over
+  bool compressedVertexAttributesEnabled = false;
+  std::vector<glm::uvec3> compressedVertexAttributesData;
+  glm::vec3 compressedPositionMin{0., 0., 0.};
+  glm::vec3 compressedPositionScale{0., 0., 0.}; // per quantization step
+
+  // device geometry compute: the face indices and vertex-face adjacency the GPU computes from, uploaded on first use
+  // (in the order faceIndsStart, faceIndsEntries, vertexFaceAdjStart, vertexFaceAdjEntries)
+  bool deviceGeometryCompute = false;
+  std::vector<std::shared_ptr<render::AttributeBuffer>> deviceGeometryConnectivity;
+  bool recomputeGeometryOnDevice(); // false if it could not, in which case the caller recomputes on the host
+
+  // The triangulation (the four arrays above which come from it) is the computeFunc of its buffers, so that it can
+  // run on a worker thread after registration; see options::prepareStructuresInBackground
+  struct TriangulationData {
+    std::vector<uint32_t> vertexInds;
+    std::vector<uint32_t> faceInds;
+    std::vector<glm::vec3> baryCoords;
+    std::vector<glm::vec3> edgeIsReal;
+    std::vector<uint32_t> triangleStartOfFace; // the rest are only set for an optimized draw order
+    std::vector<uint32_t> drawVertexOrder;
+    std::vector<uint32_t> drawTriangleVertexInds;
+  };
+  std::future<TriangulationData> triangulationTask; // valid while a background triangulation is pending
+  TriangulationData computeTriangulation() const;   // safe to call from a worker thread
+  void ensureTriangulationComputed();
+  void ensureFaceTriangleStarts(); // with an optimized draw order, these come from the triangulation
+  void optimizeTriangulationDrawOrder(TriangulationData& triangulation) const;
+  void computeDrawVertexOrder();
+
   // other internally-computed geometry
   std::vector<glm::vec3> faceNormalsData;
   std::vector<glm::vec3> faceCentersData;
@@ -325,6 +579,12 @@ private:
   std::vector<uint32_t>
       halfedgeEdgeCorrespondence; // ugly hack used to save a pick buffer attr, filled out lazily w/ edge indices
 
+  // The faces incident on each vertex, in face order, as vertexFaceAdjEntries[vertexFaceAdjStart[iV]...]. Filled out
+  // lazily, lets per-vertex values be accumulated in parallel without write races.
+  std::vector<uint32_t> vertexFaceAdjStart;
+  std::vector<uint32_t> vertexFaceAdjEntries;
+  void ensureHaveVertexFaceAdjacency();
+
 
   // Visualization settings
   PersistentValue<glm::vec3> surfaceColor;
@@ -345,11 +605,27 @@ private:
   void computeTriangleAllEdgeInds();
   void computeTriangleAllHalfedgeInds();
   void computeTriangleAllCornerInds();
+  void computeTriangleAllVertexInds();
+  void computeTriangleFaces();
   void computeFaceNormals();
   void computeFaceCenters();
   void computeFaceAreas();
   void computeVertexNormals();
+  // (the same, from the given inputs rather than the mesh's buffers)
+  void computeFaceNormalsOf(const std::vector<glm::vec3>& pos, std::vector<glm::vec3>& normals);
+  void computeFaceAreasOf(const std::vector<glm::vec3>& pos, std::vector<double>& areas);
+  void computeVertexNormalsOf(const std::vector<glm::vec3>& fNormals, const std::vector<double>& fAreas,
+                              std::vector<glm::vec3>& vNormals);
   void computeVertexAreas();
+  void computeCompressedVertexAttributes();
+  // (the values of single elements, as the above compute them)
+  glm::vec3 faceNormalOf(const std::vector<glm::vec3>& pos, size_t iF);
+  glm::vec3 faceCenterOf(const std::vector<glm::vec3>& pos, size_t iF);
+  double faceAreaOf(const std::vector<glm::vec3>& pos, size_t iF);
+  glm::vec3 vertexNormalOf(const std::vector<glm::vec3>& fNormals, const std::vector<double>& fAreas, size_t iV);
+  double vertexAreaOf(const std::vector<double>& fAreas, size_t iV);
+  glm::vec3 compressedPositionCoord(glm::vec3 p); // in [0,1]^3 within the quantization box
+  glm::uvec3 compressVertexAttributes(glm::vec3 p, glm::vec3 n);
   void computeEdgeLengths();
   void computeDefaultFaceTangentBasisX();
   void computeDefaultFaceTangentBasisY();
@@ -371,11 +647,21 @@ private:
   std::shared_ptr<render::ShaderProgram> program;
   std::shared_ptr<render::ShaderProgram> pickProgram;
 
+  // Drop the surface programs (including quantities') after a change to the shading rules, keeping the pick program,
+  // computed geometry, and acceleration structures
+  void refreshShadePrograms();
+
 
   // === Helper functions
 
   void initializeMeshTriangulation();
+  std::vector<uint32_t> narrowPermutation(const std::vector<size_t>& perm, std::string what); // range-checked
   void recomputeGeometryIfPopulated();
+  // After changing the entries changedVertices of the host vertex positions, upload them and update everything which
+  // depends on them
+  void vertexPositionsPartiallyUpdated(std::vector<uint32_t> changedVertices);
+  void updateTopologyImpl(std::vector<glm::vec3>* newPositions, std::vector<uint32_t> newFaceIndsEntries,
+                          std::vector<uint32_t> newFaceIndsStart, bool keepMatchingQuantities);
 
   glm::vec2 projectToScreenSpace(glm::vec3 coord);
 
@@ -385,19 +671,24 @@ private:
   // === Quantity adders
 
   SurfaceVertexColorQuantity* addVertexColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
+  SurfaceVertexColorQuantity* addPackedVertexColorQuantityImpl(std::string name,
+                                                               const std::vector<uint32_t>& packedColors);
   SurfaceFaceColorQuantity* addFaceColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
-  SurfaceVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  SurfaceFaceScalarQuantity* addFaceScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  SurfaceEdgeScalarQuantity* addEdgeScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  SurfaceHalfedgeScalarQuantity* addHalfedgeScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  SurfaceCornerScalarQuantity* addCornerScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  SurfaceVertexScalarQuantity* addVertexDistanceQuantityImpl(std::string name, const std::vector<double>& data);
-  SurfaceVertexScalarQuantity* addVertexSignedDistanceQuantityImpl(std::string name, const std::vector<double>& data);
+  SurfaceVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  SurfaceFaceScalarQuantity* addFaceScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  std::vector<SurfaceVertexScalarQuantity*> addVertexScalarQuantitiesImpl(const std::vector<std::string>& names, std::vector<std::vector<float>>& data, const std::vector<std::pair<double, double>>& dataRanges, DataType type);
+  std::vector<SurfaceFaceScalarQuantity*> addFaceScalarQuantitiesImpl(const std::vector<std::string>& names, std::vector<std::vector<float>>& data, const std::vector<std::pair<double, double>>& dataRanges, DataType type);
+  SurfaceEdgeScalarQuantity* addEdgeScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  SurfaceHalfedgeScalarQuantity* addHalfedgeScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  SurfaceCornerScalarQuantity* addCornerScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  SurfaceVertexScalarQuantity* addVertexDistanceQuantityImpl(std::string name, const std::vector<float>& data);
+  SurfaceVertexScalarQuantity* addVertexSignedDistanceQuantityImpl(std::string name, const std::vector<float>& data);
   SurfaceCornerParameterizationQuantity* addParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& coords, ParamCoordsType type);
   SurfaceVertexParameterizationQuantity* addVertexParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& coords, ParamCoordsType type);
   SurfaceVertexParameterizationQuantity* addLocalParameterizationQuantityImpl(std::string name, const std::vector<glm::vec2>& coords, ParamCoordsType type);
   SurfaceVertexVectorQuantity* addVertexVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
   SurfaceFaceVectorQuantity* addFaceVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
+  std::vector<SurfaceVertexVectorQuantity*> addVertexVectorQuantitiesImpl(const std::vector<std::string>& names, std::vector<std::vector<glm::vec3>>& vectors, VectorType vectorType);
   SurfaceFaceTangentVectorQuantity* addFaceTangentVectorQuantityImpl(std::string name, const std::vector<glm::vec2>& vectors, const std::vector<glm::vec3>& basisX, const std::vector<glm::vec3>& basisY, int nSym, VectorType vectorType);
   SurfaceVertexTangentVectorQuantity* addVertexTangentVectorQuantityImpl(std::string name, const std::vector<glm::vec2>& vectors, const std::vector<glm::vec3>& basisX, const std::vector<glm::vec3>& basisY, int nSym, VectorType vectorType);
   SurfaceOneFormTangentVectorQuantity* addOneFormTangentVectorQuantityImpl(std::string name, const std::vector<double>& data, const std::vector<char>& orientations);
@@ -416,6 +707,17 @@ template <class V, class F, class P>
 SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, const F& faceIndices,
                                  const std::array<std::pair<P, size_t>, 5>& perms);
 
+// Register from faces which are already flat: the vertices of face i are faceIndsEntries[faceIndsStart[i]] through
+// faceIndsEntries[faceIndsStart[i+1]-1], and faceIndsStart has nFaces+1 entries. The arrays are used directly, rather
+// than converted from a nested list (pass them with std::move() to avoid any copy).
+template <class V>
+SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, std::vector<uint32_t> faceIndsEntries,
+                                 std::vector<uint32_t> faceIndsStart);
+
+// Register a mesh which shares the geometry of `source` rather than copying it, e.g. for side-by-side comparisons of
+// different quantities on the same mesh. See SurfaceMesh::isGeometryView().
+SurfaceMesh* registerSurfaceMeshView(std::string name, SurfaceMesh* source);
+
 
 // Shorthand to get a mesh from polyscope
 inline SurfaceMesh* getSurfaceMesh(std::string name = "");
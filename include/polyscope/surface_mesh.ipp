@@ -5,6 +5,16 @@
 #include <stdexcept>
 namespace polyscope {
 
+template <typename T>
+std::shared_ptr<render::AttributeBuffer> SurfaceMesh::getVertexAttributeBuffer(render::ShaderProgram& p,
+                                                                              render::ManagedBuffer<T>& vertexData) {
+  if (p.usesIndexedDrawing()) {
+    if (optimizeDrawOrder) return vertexData.getIndexedRenderAttributeBuffer(drawVertexOrder);
+    return vertexData.getRenderAttributeBuffer();
+  }
+  return vertexData.getIndexedRenderAttributeBuffer(triangleVertexInds);
+}
+
 // Shorthand to add a mesh to polyscope
 template <class V, class F>
 SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, const F& faceIndices) {
@@ -16,8 +26,16 @@ SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, con
   std::vector<uint32_t>& faceIndsEntries = std::get<0>(nestedListTup);
   std::vector<uint32_t>& faceIndsStart = std::get<1>(nestedListTup);
 
-  SurfaceMesh* s =
-      new SurfaceMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions), faceIndsEntries, faceIndsStart);
+  return registerSurfaceMesh(name, vertexPositions, std::move(faceIndsEntries), std::move(faceIndsStart));
+}
+
+template <class V>
+SurfaceMesh* registerSurfaceMesh(std::string name, const V& vertexPositions, std::vector<uint32_t> faceIndsEntries,
+                                 std::vector<uint32_t> faceIndsStart) {
+  checkInitialized();
+
+  SurfaceMesh* s = new SurfaceMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                   std::move(faceIndsEntries), std::move(faceIndsStart));
 
   bool success = registerStructure(s);
   if (!success) {
@@ -40,12 +58,83 @@ SurfaceMesh* registerSurfaceMesh2D(std::string name, const V& vertexPositions, c
 
 template <class V>
 void SurfaceMesh::updateVertexPositions(const V& newPositions) {
+  checkNotGeometryView("updating the vertex positions");
   validateSize(newPositions, vertexDataSize, "newPositions");
   vertexPositions.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
+  vertexPositions.setStreaming(true); // positions which get updated are likely to be updated again, e.g. every frame
   vertexPositions.markHostBufferUpdated();
+  rayPickBVH.clear();
+  drawClusters.clear();
+  geometryRevision++;
+  markGeometryViewsUpdated();
   recomputeGeometryIfPopulated();
 }
 
+template <class V>
+void SurfaceMesh::updateVertexPositionsRange(size_t rangeStart, const V& newPositions) {
+  checkNotGeometryView("updating the vertex positions");
+  std::vector<glm::vec3> positions = standardizeVectorArray<glm::vec3, 3>(newPositions);
+  if (rangeStart > vertexDataSize || positions.size() > vertexDataSize - rangeStart) {
+    exception("updated vertex position range [" + std::to_string(rangeStart) + "," +
+              std::to_string(rangeStart + positions.size()) + ") is out of bounds for " + name);
+  }
+  vertexPositions.ensureHostBufferPopulated();
+  std::copy(positions.begin(), positions.end(), vertexPositions.data.begin() + rangeStart);
+
+  std::vector<uint32_t> changed(positions.size());
+  for (size_t i = 0; i < changed.size(); i++) changed[i] = static_cast<uint32_t>(rangeStart + i);
+  vertexPositionsPartiallyUpdated(std::move(changed));
+}
+
+template <class V>
+void SurfaceMesh::updateVertexPositionsAt(const std::vector<size_t>& indices, const V& newPositions) {
+  checkNotGeometryView("updating the vertex positions");
+  std::vector<glm::vec3> positions = standardizeVectorArray<glm::vec3, 3>(newPositions);
+  if (positions.size() != indices.size()) {
+    exception("updated vertex positions for " + name + " have " + std::to_string(positions.size()) +
+              " entries, but there are " + std::to_string(indices.size()) + " indices");
+  }
+  std::vector<uint32_t> changed(indices.size());
+  for (size_t i = 0; i < indices.size(); i++) {
+    if (indices[i] >= vertexDataSize) {
+      exception("updated vertex index " + std::to_string(indices[i]) + " is out of bounds for " + name);
+    }
+    changed[i] = static_cast<uint32_t>(indices[i]);
+  }
+
+  vertexPositions.ensureHostBufferPopulated();
+  for (size_t i = 0; i < indices.size(); i++) vertexPositions.data[indices[i]] = positions[i];
+  vertexPositionsPartiallyUpdated(std::move(changed));
+}
+
+
+template <class F>
+void SurfaceMesh::updateTopology(const F& newFaces, bool keepMatchingQuantities) {
+  std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> nestedListTup =
+      standardizeNestedList<uint32_t, uint32_t, F>(newFaces);
+  updateTopologyImpl(nullptr, std::move(std::get<0>(nestedListTup)), std::move(std::get<1>(nestedListTup)),
+                     keepMatchingQuantities);
+}
+
+template <class V, class F>
+void SurfaceMesh::updateVertexPositionsAndTopology(const V& newPositions, const F& newFaces,
+                                                   bool keepMatchingQuantities) {
+  std::vector<glm::vec3> positions = standardizeVectorArray<glm::vec3, 3>(newPositions);
+  std::tuple<std::vector<uint32_t>, std::vector<uint32_t>> nestedListTup =
+      standardizeNestedList<uint32_t, uint32_t, F>(newFaces);
+  updateTopologyImpl(&positions, std::move(std::get<0>(nestedListTup)), std::move(std::get<1>(nestedListTup)),
+                     keepMatchingQuantities);
+}
+
+template <class V>
+void SurfaceMesh::setVertexPositionKeyframes(const std::vector<V>& keyframes) {
+  std::vector<std::vector<glm::vec3>> frames;
+  for (const V& keyframe : keyframes) {
+    validateSize(keyframe, vertexDataSize, "vertex position keyframe");
+    frames.push_back(standardizeVectorArray<glm::vec3, 3>(keyframe));
+  }
+  setVertexPositionKeyframesImpl(std::move(frames));
+}
 
 template <class V>
 void SurfaceMesh::updateVertexPositions2D(const V& newPositions2D) {
@@ -93,6 +182,7 @@ inline std::ostream& operator<<(std::ostream& out, const MeshElement value) {
 
 template <class T>
 void SurfaceMesh::setEdgePermutation(const T& perm, size_t expectedSize) {
+  checkGeometryNotShared("setting an edge permutation");
 
   // try to catch cases where it is set twice
   if (triangleAllEdgeInds.size() > 0) {
@@ -102,7 +192,7 @@ void SurfaceMesh::setEdgePermutation(const T& perm, size_t expectedSize) {
   }
 
   validateSize(perm, nEdges(), "edge permutation for " + name);
-  edgePerm = standardizeArray<size_t, T>(perm);
+  edgePerm = narrowPermutation(standardizeArray<size_t, T>(perm), "edge permutation");
 
   edgeDataSize = expectedSize;
   if (edgeDataSize == 0) {
@@ -118,6 +208,7 @@ void SurfaceMesh::setEdgePermutation(const T& perm, size_t expectedSize) {
 
 template <class T>
 void SurfaceMesh::setHalfedgePermutation(const T& perm, size_t expectedSize) {
+  checkGeometryNotShared("setting a halfedge permutation");
 
   // attempt to catch cases where the user sets a permutation after already adding quantities which would use the
   // permutation (this is unsupported and will cause bad things)
@@ -130,7 +221,7 @@ void SurfaceMesh::setHalfedgePermutation(const T& perm, size_t expectedSize) {
   }
 
   validateSize(perm, nHalfedges(), "halfedge permutation for " + name);
-  halfedgePerm = standardizeArray<size_t, T>(perm);
+  halfedgePerm = narrowPermutation(standardizeArray<size_t, T>(perm), "halfedge permutation");
 
   halfedgeDataSize = expectedSize;
   if (halfedgeDataSize == 0) {
@@ -145,6 +236,7 @@ void SurfaceMesh::setHalfedgePermutation(const T& perm, size_t expectedSize) {
 
 template <class T>
 void SurfaceMesh::setCornerPermutation(const T& perm, size_t expectedSize) {
+  checkGeometryNotShared("setting a corner permutation");
 
   // attempt to catch cases where the user sets a permutation after already adding quantities which would use the
   // permutation (this is unsupported and will cause bad things)
@@ -157,7 +249,7 @@ void SurfaceMesh::setCornerPermutation(const T& perm, size_t expectedSize) {
   }
 
   validateSize(perm, nCorners(), "corner permutation for " + name);
-  cornerPerm = standardizeArray<size_t, T>(perm);
+  cornerPerm = narrowPermutation(standardizeArray<size_t, T>(perm), "corner permutation");
 
   cornerDataSize = expectedSize;
   if (cornerDataSize == 0) {
@@ -203,6 +295,12 @@ SurfaceVertexColorQuantity* SurfaceMesh::addVertexColorQuantity(std::string name
   return addVertexColorQuantityImpl(name, standardizeVectorArray<glm::vec3, 3>(colors));
 }
 
+template <class T>
+SurfaceVertexColorQuantity* SurfaceMesh::addPackedVertexColorQuantity(std::string name, const T& packedColors) {
+  validateSize<T>(packedColors, vertexDataSize, "vertex packed color quantity " + name);
+  return addPackedVertexColorQuantityImpl(name, standardizeArray<uint32_t>(packedColors));
+}
+
 
 template <class T>
 SurfaceFaceColorQuantity* SurfaceMesh::addFaceColorQuantity(std::string name, const T& colors) {
@@ -213,13 +311,13 @@ SurfaceFaceColorQuantity* SurfaceMesh::addFaceColorQuantity(std::string name, co
 template <class T>
 SurfaceVertexScalarQuantity* SurfaceMesh::addVertexDistanceQuantity(std::string name, const T& distances) {
   validateSize(distances, vertexDataSize, "distance quantity " + name);
-  return addVertexDistanceQuantityImpl(name, standardizeArray<double>(distances));
+  return addVertexDistanceQuantityImpl(name, standardizeArray<float>(distances));
 }
 
 template <class T>
 SurfaceVertexScalarQuantity* SurfaceMesh::addVertexSignedDistanceQuantity(std::string name, const T& distances) {
   validateSize(distances, vertexDataSize, "signed distance quantity " + name);
-  return addVertexSignedDistanceQuantityImpl(name, standardizeArray<double>(distances));
+  return addVertexSignedDistanceQuantityImpl(name, standardizeArray<float>(distances));
 }
 
 // Standard a parameterization, defined at corners
@@ -249,13 +347,13 @@ SurfaceVertexParameterizationQuantity* SurfaceMesh::addLocalParameterizationQuan
 template <class T>
 SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, vertexDataSize, "vertex scalar quantity " + name);
-  return addVertexScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addVertexScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 template <class T>
 SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, faceDataSize, "face scalar quantity " + name);
-  return addFaceScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addFaceScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 
@@ -266,19 +364,65 @@ SurfaceEdgeScalarQuantity* SurfaceMesh::addEdgeScalarQuantity(std::string name,
               " attempted to set edge-valued data, but this requires an edge ordering. Call setEdgePermutation().");
   }
   validateSize(data, edgeDataSize, "edge scalar quantity " + name);
-  return addEdgeScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addEdgeScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 template <class T>
 SurfaceHalfedgeScalarQuantity* SurfaceMesh::addHalfedgeScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, halfedgeDataSize, "halfedge scalar quantity " + name);
-  return addHalfedgeScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addHalfedgeScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 template <class T>
 SurfaceCornerScalarQuantity* SurfaceMesh::addCornerScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, cornerDataSize, "corner scalar quantity " + name);
-  return addCornerScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addCornerScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
+}
+
+template <class T>
+std::vector<SurfaceVertexScalarQuantity*>
+SurfaceMesh::addVertexScalarQuantities(const std::vector<std::string>& names, const std::vector<T>& data,
+                                       DataType type) {
+  if (names.size() != data.size()) exception("addVertexScalarQuantities() needs one name per field");
+  for (size_t i = 0; i < data.size(); i++) {
+    validateSize(data[i], vertexDataSize, "vertex scalar quantity " + names[i]);
+  }
+
+  std::vector<std::vector<float>> values(data.size());
+  std::vector<std::pair<double, double>> dataRanges(data.size());
+  TaskGroup group;
+  for (size_t i = 0; i < data.size(); i++) {
+    group.run([&, i]() {
+      values[i] = standardizeArray<float, T>(data[i]);
+      dataRanges[i] = scalarDataRange(values[i]);
+    });
+  }
+  group.wait();
+
+  return addVertexScalarQuantitiesImpl(names, values, dataRanges, type);
+}
+
+template <class T>
+std::vector<SurfaceFaceScalarQuantity*>
+SurfaceMesh::addFaceScalarQuantities(const std::vector<std::string>& names, const std::vector<T>& data,
+                                     DataType type) {
+  if (names.size() != data.size()) exception("addFaceScalarQuantities() needs one name per field");
+  for (size_t i = 0; i < data.size(); i++) {
+    validateSize(data[i], faceDataSize, "face scalar quantity " + names[i]);
+  }
+
+  std::vector<std::vector<float>> values(data.size());
+  std::vector<std::pair<double, double>> dataRanges(data.size());
+  TaskGroup group;
+  for (size_t i = 0; i < data.size(); i++) {
+    group.run([&, i]() {
+      values[i] = standardizeArray<float, T>(data[i]);
+      dataRanges[i] = scalarDataRange(values[i]);
+    });
+  }
+  group.wait();
+
+  return addFaceScalarQuantitiesImpl(names, values, dataRanges, type);
 }
 
 
@@ -299,6 +443,25 @@ SurfaceVertexVectorQuantity* SurfaceMesh::addVertexVectorQuantity2D(std::string
   return addVertexVectorQuantityImpl(name, vectors3D, vectorType);
 }
 
+template <class T>
+std::vector<SurfaceVertexVectorQuantity*>
+SurfaceMesh::addVertexVectorQuantities(const std::vector<std::string>& names, const std::vector<T>& vectors,
+                                       VectorType vectorType) {
+  if (names.size() != vectors.size()) exception("addVertexVectorQuantities() needs one name per field");
+  for (size_t i = 0; i < vectors.size(); i++) {
+    validateSize(vectors[i], vertexDataSize, "vertex vector quantity " + names[i]);
+  }
+
+  std::vector<std::vector<glm::vec3>> vectors3D(vectors.size());
+  TaskGroup group;
+  for (size_t i = 0; i < vectors.size(); i++) {
+    group.run([&, i]() { vectors3D[i] = standardizeVectorArray<glm::vec3, 3>(vectors[i]); });
+  }
+  group.wait();
+
+  return addVertexVectorQuantitiesImpl(names, vectors3D, vectorType);
+}
+
 template <class T>
 SurfaceFaceVectorQuantity* SurfaceMesh::addFaceVectorQuantity(std::string name, const T& vectors,
                                                               VectorType vectorType) {
@@ -24,6 +24,10 @@ public:
   virtual void buildEdgeInfoGUI(size_t eInd);
   virtual void buildHalfedgeInfoGUI(size_t heInd);
   virtual void buildCornerInfoGUI(size_t heInd);
+
+  // True if the quantity holds one value for each element it is defined on, after the mesh's connectivity changes (see
+  // SurfaceMesh::updateTopology()). Quantities which don't say are assumed not to fit, and get removed.
+  virtual bool fitsMeshTopology();
 };
 
 } // namespace polyscope
@@ -9,6 +9,9 @@
 #include "polyscope/render/engine.h"
 #include "polyscope/surface_mesh.h"
 
+#include <array>
+#include <cstdint>
+
 
 namespace polyscope {
 
@@ -27,15 +30,47 @@ public:
 
   virtual void draw() override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
   virtual void buildCustomUI() override;
+  virtual void buildParameterizationOptionsUI() override;
+
+  // === UV islands
+
+  // The islands are the connected components of the faces, where two faces sharing an edge are connected unless the
+  // edge is a seam, with different coordinates at its endpoints on either side. They are extracted on first use and
+  // cached until the coordinates change; the edge adjacency they're built from is only recomputed when the faces do.
+  size_t nIslands();
+  const std::vector<uint32_t>& getFaceIslands(); // the island of each face, in [0, nIslands())
 
+  // Color each island distinctly, darkened under the checker, instead of the style's own coloring
+  SurfaceParameterizationQuantity* setIslandColoring(bool newVal);
+  bool getIslandColoring();
 
 protected:
   std::shared_ptr<render::ShaderProgram> program;
 
+  PersistentValue<bool> islandColoring;
+
+  // Island caches. Each adjacency is a pair of faces sharing an edge, with the corners at the edge's endpoints on each
+  // side: {cornerA0, cornerA1, cornerB0, cornerB1}, where cornerA0 and cornerB0 are at the same vertex.
+  std::vector<std::array<uint32_t, 4>> edgeAdjacentCorners;
+  std::vector<std::array<uint32_t, 2>> edgeAdjacentFaces;
+  bool edgeAdjacencyValid = false;
+  uint64_t edgeAdjacencyTopologyRevision = 0;
+  std::vector<uint32_t> faceIslands;
+  size_t nIslandsCount = 0;
+  bool islandsValid = false;
+  uint64_t islandsCoordsRevision = 0;
+  uint64_t islandsTopologyRevision = 0;
+
   // Helpers
   void createProgram();
   virtual void fillCoordBuffers(render::ShaderProgram& p) = 0;
+  virtual bool coordsArePerVertex() = 0; // per-vertex coordinates can be drawn indexed
+  virtual size_t coordIndexOfCorner(size_t iCorner) = 0;
+  void ensureEdgeAdjacencyComputed();
+  void ensureIslandsComputed();
+  void fillIslandColorBuffers(render::ShaderProgram& p);
 };
 
 
@@ -50,10 +85,13 @@ public:
                                         ParamCoordsType type_, ParamVizStyle style);
 
   virtual void buildCornerInfoGUI(size_t cInd) override;
+  virtual bool fitsMeshTopology() override;
   virtual std::string niceName() override;
 
 protected:
   virtual void fillCoordBuffers(render::ShaderProgram& p) override;
+  virtual bool coordsArePerVertex() override { return false; }
+  virtual size_t coordIndexOfCorner(size_t iCorner) override { return iCorner; }
 };
 
 
@@ -67,11 +105,14 @@ public:
                                         ParamCoordsType type_, ParamVizStyle style);
 
   virtual void buildVertexInfoGUI(size_t vInd) override;
+  virtual bool fitsMeshTopology() override;
   virtual std::string niceName() override;
 
 
 protected:
   virtual void fillCoordBuffers(render::ShaderProgram& p) override;
+  virtual bool coordsArePerVertex() override { return true; }
+  virtual size_t coordIndexOfCorner(size_t iCorner) override;
 };
 
 } // namespace polyscope
@@ -15,13 +15,14 @@ namespace polyscope {
 
 class SurfaceScalarQuantity : public SurfaceMeshQuantity, public ScalarQuantity<SurfaceScalarQuantity> {
 public:
-  SurfaceScalarQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn, const std::vector<double>& values_,
-                        DataType dataType);
+  SurfaceScalarQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn, std::vector<float> values_,
+                        DataType dataType, const std::pair<double, double>* dataRange = nullptr);
 
   virtual void draw() override;
   virtual void buildCustomUI() override;
   virtual std::string niceName() override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
 protected:
   const std::string definedOn;
@@ -37,12 +38,43 @@ protected:
 
 class SurfaceVertexScalarQuantity : public SurfaceScalarQuantity {
 public:
-  SurfaceVertexScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
-                              DataType dataType_ = DataType::STANDARD);
+  SurfaceVertexScalarQuantity(std::string name, std::vector<float> values_, SurfaceMesh& mesh_,
+                              DataType dataType_ = DataType::STANDARD,
+                              const std::pair<double, double>* dataRange = nullptr);
 
+  virtual void draw() override;
   virtual void createProgram() override;
+  virtual void refresh() override;
+  virtual void buildScalarOptionsUI() override;
 
   void buildVertexInfoGUI(size_t vInd) override;
+  virtual bool fitsMeshTopology() override;
+
+  // Draw the isolines as curves extracted from the mesh, rather than as stripes in the shader. The curves have a
+  // constant width on screen however large the mesh triangles, but are re-extracted on the host (in parallel) whenever
+  // the values, the vertex positions, or the isoline spacing change, so this suits static data best.
+  SurfaceVertexScalarQuantity* setIsolinesExtracted(bool newVal);
+  bool getIsolinesExtracted();
+
+  // The number of segments in the extracted isolines (extracting them if needed)
+  size_t nExtractedIsolineSegments();
+
+  // Isolines closer together than this are not extracted, as there would be too many to be useful
+  static const size_t maxExtractedIsolines = 4096;
+
+protected:
+  PersistentValue<bool> isolinesExtracted;
+
+  // The extracted segments, and what they were extracted from
+  std::vector<glm::vec3> isolineTails, isolineTips;
+  bool isolineSegmentsValid = false;
+  float isolineSegmentsPeriod = 0.;
+  uint64_t isolineSegmentsDataRevision = 0;
+  uint64_t isolineSegmentsGeometryRevision = 0;
+  std::shared_ptr<render::ShaderProgram> isolineProgram;
+
+  void ensureIsolinesExtracted();
+  void drawExtractedIsolines();
 };
 
 
@@ -52,12 +84,14 @@ public:
 
 class SurfaceFaceScalarQuantity : public SurfaceScalarQuantity {
 public:
-  SurfaceFaceScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
-                            DataType dataType_ = DataType::STANDARD);
+  SurfaceFaceScalarQuantity(std::string name, std::vector<float> values_, SurfaceMesh& mesh_,
+                            DataType dataType_ = DataType::STANDARD,
+                            const std::pair<double, double>* dataRange = nullptr);
 
   virtual void createProgram() override;
 
   void buildFaceInfoGUI(size_t fInd) override;
+  virtual bool fitsMeshTopology() override;
 };
 
 
@@ -67,12 +101,13 @@ public:
 
 class SurfaceEdgeScalarQuantity : public SurfaceScalarQuantity {
 public:
-  SurfaceEdgeScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
+  SurfaceEdgeScalarQuantity(std::string name, const std::vector<float>& values_, SurfaceMesh& mesh_,
                             DataType dataType_ = DataType::STANDARD);
 
   virtual void createProgram() override;
 
   void buildEdgeInfoGUI(size_t edgeInd) override;
+  virtual bool fitsMeshTopology() override;
 };
 
 // ========================================================
@@ -81,12 +116,13 @@ public:
 
 class SurfaceHalfedgeScalarQuantity : public SurfaceScalarQuantity {
 public:
-  SurfaceHalfedgeScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
+  SurfaceHalfedgeScalarQuantity(std::string name, const std::vector<float>& values_, SurfaceMesh& mesh_,
                                 DataType dataType_ = DataType::STANDARD);
 
   virtual void createProgram() override;
 
   void buildHalfedgeInfoGUI(size_t heInd) override;
+  virtual bool fitsMeshTopology() override;
 };
 
 // ========================================================
@@ -95,12 +131,13 @@ public:
 
 class SurfaceCornerScalarQuantity : public SurfaceScalarQuantity {
 public:
-  SurfaceCornerScalarQuantity(std::string name, const std::vector<double>& values_, SurfaceMesh& mesh_,
+  SurfaceCornerScalarQuantity(std::string name, const std::vector<float>& values_, SurfaceMesh& mesh_,
                               DataType dataType_ = DataType::STANDARD);
 
   virtual void createProgram() override;
 
   void buildCornerInfoGUI(size_t heInd) override;
+  virtual bool fitsMeshTopology() override;
 };
 
 
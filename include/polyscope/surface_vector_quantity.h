@@ -21,12 +21,42 @@ class SurfaceVectorQuantity : public SurfaceMeshQuantity {
 public:
   SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh_, MeshElement definedOn_);
 
+  virtual void refresh() override;
+  virtual void refreshMaterial() override;
+
   // === Members
 
   // === Option accessors
 
+  // Draw the field as a line integral convolution texture on the surface, rather than as glyphs. Noise on the surface
+  // is smeared along the vector direction at each pixel, so the cost depends on the pixels covered, not the number of
+  // vectors. Symmetric fields (nSym > 1) are convolved along their representative direction.
+  SurfaceVectorQuantity* setLICEnabled(bool newVal);
+  bool getLICEnabled();
+
+  // The size of the noise features in the LIC texture
+  SurfaceVectorQuantity* setLICNoiseScale(double newVal, bool isRelative = true);
+  double getLICNoiseScale();
+
+  // The length of the streaks in the LIC texture, as a multiple of the noise scale
+  SurfaceVectorQuantity* setLICLength(double newVal);
+  double getLICLength();
+
 protected:
   MeshElement definedOn;
+
+  // === LIC drawing
+  PersistentValue<bool> licEnabled;
+  PersistentValue<ScaledValue<float>> licNoiseScale;
+  PersistentValue<float> licLength;
+  std::shared_ptr<render::ShaderProgram> licProgram;
+
+  void drawLIC(glm::vec3 color);
+  void buildLICUI();
+
+  // Concrete quantities create licProgram with the helper below, then set their vector attributes
+  virtual void createLICProgram() = 0;
+  std::shared_ptr<render::ShaderProgram> requestLICProgram(std::string vectorRule);
 };
 
 
@@ -42,6 +72,10 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   virtual void buildVertexInfoGUI(size_t vInd) override;
+  virtual bool fitsMeshTopology() override;
+
+protected:
+  virtual void createLICProgram() override;
 };
 
 
@@ -57,6 +91,10 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   virtual void buildFaceInfoGUI(size_t fInd) override;
+  virtual bool fitsMeshTopology() override;
+
+protected:
+  virtual void createLICProgram() override;
 };
 
 // ==== Tangent vectors at faces
@@ -73,6 +111,10 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   void buildFaceInfoGUI(size_t fInd) override;
+  virtual bool fitsMeshTopology() override;
+
+protected:
+  virtual void createLICProgram() override;
 };
 
 
@@ -91,6 +133,10 @@ public:
   virtual void refresh() override;
   virtual std::string niceName() override;
   void buildVertexInfoGUI(size_t vInd) override;
+  virtual bool fitsMeshTopology() override;
+
+protected:
+  virtual void createLICProgram() override;
 };
 
 
@@ -111,6 +157,10 @@ public:
   std::vector<char> canonicalOrientation;
 
   void buildEdgeInfoGUI(size_t eInd) override;
+  virtual bool fitsMeshTopology() override;
+
+protected:
+  virtual void createLICProgram() override;
 };
 
 } // namespace polyscope
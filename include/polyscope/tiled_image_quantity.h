@@ -0,0 +1,102 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/image_quantity_base.h"
+
+#include <array>
+#include <map>
+#include <vector>
+
+namespace polyscope {
+
+// A color image which may be far larger than a single texture, drawn from a pyramid of tiles. Level 0 of the pyramid is
+// the full image, and each level halves the one before it (rounding up), down to a level which fits in one tile. Only
+// the tiles needed at the current zoom level are fetched from the loader and uploaded; tiles which are not resident
+// yet are stood in for by coarser ones.
+class TiledColorImageQuantity : public ImageQuantity {
+
+public:
+  TiledColorImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY, ImageTileLoader loader,
+                          ImageOrigin imageOrigin);
+
+  virtual void draw() override;
+  virtual void buildCustomUI() override;
+  virtual void refresh() override;
+  virtual std::string niceName() override;
+  virtual void releaseTextures() override;
+
+  // == Setters and getters
+
+  virtual TiledColorImageQuantity* setEnabled(bool newEnabled) override;
+
+  // The width and height of the (square) tiles, in pixels. (default: 512)
+  void setTileSize(size_t newVal);
+  size_t getTileSize();
+
+  // Least-recently-used tiles are released beyond this many. (default: 256)
+  void setMaxResidentTiles(size_t newVal);
+  size_t getMaxResidentTiles();
+
+  // At most this many tiles are fetched and uploaded per frame. (default: 8)
+  void setTileUploadsPerFrame(size_t newVal);
+  size_t getTileUploadsPerFrame();
+
+  // The region shown in the ImGui window. The center is in [0,1]^2 over the image as displayed (x right, y down), and a
+  // zoom of 1 fits the whole image in the window.
+  void setWindowView(glm::vec2 center, float zoom);
+  glm::vec2 getWindowViewCenter();
+  float getWindowViewZoom();
+
+  int nLevels();
+  size_t levelDimX(int level);
+  size_t levelDimY(int level);
+  size_t nResidentTiles();
+
+protected:
+  ImageTileLoader loader;
+  size_t tileSize = 512;
+  size_t maxResidentTiles = 256;
+  size_t tileUploadsPerFrame = 8;
+  size_t uploadsThisFrame = 0;
+
+  glm::vec2 windowViewCenter{0.5, 0.5};
+  float windowViewZoom = 1.;
+
+  struct Tile {
+    std::shared_ptr<render::TextureBuffer> texture;
+    uint64_t lastUsed;
+  };
+  std::map<std::array<size_t, 3>, Tile> tiles; // keyed by {level, tileX, tileY}
+  uint64_t tileUseCount = 0;
+
+  std::shared_ptr<render::ShaderProgram> fullscreenProgram, billboardProgram;
+
+  // A tile (or coarser stand-in) covering a rectangle of the image, in level-0 pixels and data row order
+  struct TileDraw {
+    render::TextureBuffer* texture;
+    glm::vec2 rectMin, rectMax; // level-0 pixel coordinates
+    glm::vec2 uvMin, uvMax;     // texture coordinates of the rectangle's corners
+  };
+
+  // All of the tiles needed to draw the data-space rectangle [regionMin, regionMax] at the given scale (screen pixels
+  // per level-0 pixel).
+  std::vector<TileDraw> gatherTiles(glm::vec2 regionMin, glm::vec2 regionMax, float scale);
+  int levelForScale(float scale);
+  render::TextureBuffer* getTile(int level, size_t tileX, size_t tileY);
+  void evictTiles();
+
+  void drawTilesWithProgram(render::ShaderProgram& program, const std::vector<TileDraw>& draws);
+
+  virtual bool textureFormatSupported(TextureFormat format) override;
+
+  virtual void showFullscreen() override;
+  virtual void showInImGuiWindow() override;
+  virtual void showInBillboard(glm::vec3 center, glm::vec3 upVec, glm::vec3 rightVec) override;
+};
+
+// A tile loader serving tiles from an image held in memory, building the coarser levels of the pyramid from it the
+// first time they are requested.
+ImageTileLoader createImagePyramidTileLoader(size_t dimX, size_t dimY, const std::vector<glm::vec4>& data);
+
+} // namespace polyscope
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "polyscope/persistent_value.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/utilities.h"
@@ -32,6 +34,10 @@ public:
   glm::mat4& T;
   PersistentValue<glm::mat4>* Tpers; // optional, a persistent value defined elsewhere that goes with T
 
+  // optional, called in place of polyscope::requestRedraw() when a drag changes T (e.g. to credit the change to the
+  // structure it moves)
+  std::function<void()> requestRedrawCallback;
+
   // == Member functions
 
   void prepare();
@@ -60,6 +66,7 @@ protected:
                                        glm::vec3{95 / 255., 175 / 255., 35 / 255.}}};
 
   void markUpdated();
+  void requestRedraw();
 
   // Render stuff
   std::shared_ptr<render::ShaderProgram> ringProgram;
@@ -69,6 +69,14 @@ inline glm::vec3 componentwiseMin(const glm::vec3& vA, const glm::vec3& vB) {
 inline glm::vec3 componentwiseMax(const glm::vec3& vA, const glm::vec3& vB) {
   return glm::vec3{std::max(vA.x, vB.x), std::max(vA.y, vB.y), std::max(vA.z, vB.z)};
 }
+
+// The bounding box of n points, and the length scale structures derive from it: twice the largest distance from the
+// center of the box to any point. The points are scanned on the worker threads (see parallel.h), in loops which the
+// compiler vectorizes. NaN coordinates are skipped. With no points, the box is empty (min = +inf, max = -inf) and the
+// length scale is 0.
+void computeBoundsAndLengthScale(const glm::vec3* points, size_t n, glm::vec3& min, glm::vec3& max,
+                                 float& lengthScale);
+
 inline glm::vec3 circularPermuteEntries(const glm::vec3& v) {
   // (could be prettier with swizzel)
   return glm::vec3{v.z, v.x, v.y};
@@ -59,6 +59,11 @@ public:
   QuantityT* setMaterial(std::string name);
   std::string getMaterial();
 
+  // Draw at most this many vectors, evenly subsampled from all of them. Only the sampled elements are read by the
+  // draw. 0 (the default) draws every vector.
+  QuantityT* setMaxDrawnVectors(size_t n);
+  size_t getMaxDrawnVectors();
+
 
 protected:
   const VectorType vectorType;
@@ -71,8 +76,14 @@ protected:
 
   float vectorLengthRange = -1.;
   bool vectorLengthRangeManuallySet = false;
+  size_t maxDrawnVectors = 0;
 
   std::shared_ptr<render::ShaderProgram> vectorProgram;
+
+  // Subsampling helpers. If subsampled, the program should be the _INDEXED variant, and gets its index from
+  // setSubsampleIndex().
+  bool isSubsampled(size_t nVectors);
+  void setSubsampleIndex(size_t nVectors);
 };
 
 // ================================================
@@ -84,7 +95,7 @@ protected:
 template <typename QuantityT>
 class VectorQuantity : public VectorQuantityBase<QuantityT> {
 public:
-  VectorQuantity(QuantityT& parent, const std::vector<glm::vec3>& vectors,
+  VectorQuantity(QuantityT& parent, std::vector<glm::vec3> vectors,
                  render::ManagedBuffer<glm::vec3>& vectorRoots, VectorType vectorType);
 
   void drawVectors();
@@ -132,6 +143,12 @@ public:
                         const std::vector<glm::vec3>& tangentBasisX, const std::vector<glm::vec3>& tangentBasisY,
                         render::ManagedBuffer<glm::vec3>& vectorRoots, int nSym, VectorType vectorType);
 
+  // As above, but draws with an existing tangent basis (such as a default basis owned by the structure) rather than
+  // a copy of it. The tangentBasisX/Y members are left empty.
+  TangentVectorQuantity(QuantityT& parent, const std::vector<glm::vec2>& tangentVectors,
+                        render::ManagedBuffer<glm::vec3>& sharedBasisX, render::ManagedBuffer<glm::vec3>& sharedBasisY,
+                        render::ManagedBuffer<glm::vec3>& vectorRoots, int nSym, VectorType vectorType);
+
   void drawVectors();
   void refreshVectors();
 
@@ -162,6 +179,10 @@ protected:
   std::vector<glm::vec3> tangentBasisXData;
   std::vector<glm::vec3> tangentBasisYData;
   int nSym;
+
+  // The basis which is actually drawn; either the buffers above, or shared ones
+  render::ManagedBuffer<glm::vec3>& drawBasisX;
+  render::ManagedBuffer<glm::vec3>& drawBasisY;
 };
 
 } // namespace polyscope
@@ -115,15 +115,42 @@ std::string VectorQuantityBase<QuantityT>::getMaterial() {
   return material.get();
 }
 
+template <typename QuantityT>
+QuantityT* VectorQuantityBase<QuantityT>::setMaxDrawnVectors(size_t n) {
+  maxDrawnVectors = n;
+  vectorProgram.reset();
+  requestRedraw();
+  return &quantity;
+}
+template <typename QuantityT>
+size_t VectorQuantityBase<QuantityT>::getMaxDrawnVectors() {
+  return maxDrawnVectors;
+}
+
+template <typename QuantityT>
+bool VectorQuantityBase<QuantityT>::isSubsampled(size_t nVectors) {
+  return maxDrawnVectors > 0 && maxDrawnVectors < nVectors;
+}
+
+template <typename QuantityT>
+void VectorQuantityBase<QuantityT>::setSubsampleIndex(size_t nVectors) {
+  // evenly spaced over the element order, which for most data is spatially coherent
+  std::vector<unsigned int> inds(maxDrawnVectors);
+  for (size_t i = 0; i < maxDrawnVectors; i++) {
+    inds[i] = static_cast<unsigned int>((static_cast<uint64_t>(i) * nVectors) / maxDrawnVectors);
+  }
+  vectorProgram->setIndex(inds);
+}
+
 // ================================================
 // === (3D) Vector Quantity
 // ================================================
 
 template <typename QuantityT>
-VectorQuantity<QuantityT>::VectorQuantity(QuantityT& quantity_, const std::vector<glm::vec3>& vectors_,
+VectorQuantity<QuantityT>::VectorQuantity(QuantityT& quantity_, std::vector<glm::vec3> vectors_,
                                           render::ManagedBuffer<glm::vec3>& vectorRoots_, VectorType vectorType_)
     : VectorQuantityBase<QuantityT>(quantity_, vectorType_), vectors(quantity_.uniquePrefix() + "#values", vectorsData),
-      vectorRoots(vectorRoots_), vectorsData(vectors_) {
+      vectorRoots(vectorRoots_), vectorsData(std::move(vectors_)) {
   this->updateMaxLength();
 }
 
@@ -145,11 +172,6 @@ void VectorQuantity<QuantityT>::drawVectors() {
                                     this->vectorLengthMult.get().asAbsolute() / this->vectorLengthRange);
   }
 
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  this->vectorProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  this->vectorProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
-
   this->vectorProgram->draw();
 }
 
@@ -163,15 +185,19 @@ void VectorQuantity<QuantityT>::createProgram() {
 
 
   // Create the vectorProgram to draw this quantity
+  bool subsampled = this->isSubsampled(vectors.size());
   // clang-format off
   this->vectorProgram = render::engine->requestShader(
-      "RAYCAST_VECTOR",
+      subsampled ? "RAYCAST_VECTOR_INDEXED" : "RAYCAST_VECTOR",
       rules
   );
   // clang-format on
 
   this->vectorProgram->setAttribute("a_vector", vectors.getRenderAttributeBuffer());
   this->vectorProgram->setAttribute("a_position", vectorRoots.getRenderAttributeBuffer());
+  if (subsampled) {
+    this->setSubsampleIndex(vectors.size());
+  }
 
   render::engine->setMaterial(*(this->vectorProgram), this->material.get());
 }
@@ -180,11 +206,25 @@ template <typename QuantityT>
 void VectorQuantity<QuantityT>::updateMaxLength() {
   if (this->vectorLengthRangeManuallySet) return; // do nothing if it has already been set manually
 
+  // Scanned in fixed-size chunks in parallel, like robustMinMax()
   vectors.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& data = vectors.data;
+  const size_t chunkSize = 1 << 16;
+  size_t nChunks = (data.size() + chunkSize - 1) / chunkSize;
+  std::vector<float> chunkMax(nChunks, 0.);
+  parallelFor(
+      0, nChunks,
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          size_t iEnd = std::min(data.size(), (iC + 1) * chunkSize);
+          for (size_t i = iC * chunkSize; i < iEnd; i++) {
+            chunkMax[iC] = std::max(chunkMax[iC], glm::length(data[i]));
+          }
+        }
+      },
+      1);
   float maxLength = 0.;
-  for (const glm::vec3& vec : vectors.data) {
-    maxLength = std::max(maxLength, glm::length(vec));
-  }
+  for (float m : chunkMax) maxLength = std::max(maxLength, m);
   this->vectorLengthRange = maxLength;
 }
 
@@ -231,7 +271,23 @@ TangentVectorQuantity<QuantityT>::TangentVectorQuantity(QuantityT& quantity_,
       tangentBasisX(quantity_.uniquePrefix() + "#basisX", tangentBasisXData),
       tangentBasisY(quantity_.uniquePrefix() + "#basisY", tangentBasisYData), vectorRoots(vectorRoots_),
       tangentVectorsData(tangentVectors_), tangentBasisXData(tangentBasisX_), tangentBasisYData(tangentBasisY_),
-      nSym(nSym_) {
+      nSym(nSym_), drawBasisX(tangentBasisX), drawBasisY(tangentBasisY) {
+  this->updateMaxLength();
+}
+
+template <typename QuantityT>
+TangentVectorQuantity<QuantityT>::TangentVectorQuantity(QuantityT& quantity_,
+                                                        const std::vector<glm::vec2>& tangentVectors_,
+                                                        render::ManagedBuffer<glm::vec3>& sharedBasisX_,
+                                                        render::ManagedBuffer<glm::vec3>& sharedBasisY_,
+                                                        render::ManagedBuffer<glm::vec3>& vectorRoots_, int nSym_,
+                                                        VectorType vectorType_)
+
+    : VectorQuantityBase<QuantityT>(quantity_, vectorType_),
+      tangentVectors(quantity_.uniquePrefix() + "#values", tangentVectorsData),
+      tangentBasisX(quantity_.uniquePrefix() + "#basisX", tangentBasisXData),
+      tangentBasisY(quantity_.uniquePrefix() + "#basisY", tangentBasisYData), vectorRoots(vectorRoots_),
+      tangentVectorsData(tangentVectors_), nSym(nSym_), drawBasisX(sharedBasisX_), drawBasisY(sharedBasisY_) {
   this->updateMaxLength();
 }
 
@@ -258,11 +314,6 @@ void TangentVectorQuantity<QuantityT>::drawVectors() {
                                       this->vectorLengthMult.get().asAbsolute() / this->vectorLengthRange);
     }
 
-    glm::mat4 P = view::getCameraPerspectiveMatrix();
-    glm::mat4 Pinv = glm::inverse(P);
-    this->vectorProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-    this->vectorProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
-
     this->vectorProgram->draw();
   }
 }
@@ -276,17 +327,21 @@ void TangentVectorQuantity<QuantityT>::createProgram() {
   }
 
   // Create the vectorProgram to draw this quantity
+  bool subsampled = this->isSubsampled(tangentVectors.size());
   // clang-format off
   this->vectorProgram = render::engine->requestShader(
-      "RAYCAST_TANGENT_VECTOR",
+      subsampled ? "RAYCAST_TANGENT_VECTOR_INDEXED" : "RAYCAST_TANGENT_VECTOR",
       rules
   );
   // clang-format on
 
   this->vectorProgram->setAttribute("a_tangentVector", tangentVectors.getRenderAttributeBuffer());
-  this->vectorProgram->setAttribute("a_basisVectorX", tangentBasisX.getRenderAttributeBuffer());
-  this->vectorProgram->setAttribute("a_basisVectorY", tangentBasisY.getRenderAttributeBuffer());
+  this->vectorProgram->setAttribute("a_basisVectorX", drawBasisX.getRenderAttributeBuffer());
+  this->vectorProgram->setAttribute("a_basisVectorY", drawBasisY.getRenderAttributeBuffer());
   this->vectorProgram->setAttribute("a_position", vectorRoots.getRenderAttributeBuffer());
+  if (subsampled) {
+    this->setSubsampleIndex(tangentVectors.size());
+  }
 
   render::engine->setMaterial(*(this->vectorProgram), this->material.get());
 }
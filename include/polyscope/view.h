@@ -52,6 +52,16 @@ extern glm::mat4x4 viewMat;
 extern double fov; // in the y direction
 extern ProjectionMode projectionMode;
 
+// Offset applied to the projection, in normalized device coordinates. Set while rendering for temporal antialiasing,
+// and otherwise zero.
+extern glm::vec2 projectionJitter;
+
+// Restricts the projection to one tile of a larger image, for tiled rendering (see renderTiled()): the buffer shows the
+// pixels starting at projectionTileOffset (from the lower left) of an image of projectionTileImageSize pixels, and the
+// aspect ratio is that of the whole image. A size of zero (the default) means the buffer is the whole image.
+extern glm::ivec2 projectionTileOffset;
+extern glm::ivec2 projectionTileImageSize;
+
 // "Flying" view
 extern bool midflight;
 extern float flightStartTime;
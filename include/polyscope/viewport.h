@@ -0,0 +1,89 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/camera_parameters.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/types.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace polyscope {
+
+// An additional view of the scene, rendered from its own camera in to its own framebuffer and shown in the
+// "Viewports" window (e.g. top/front/side views next to the main perspective view). All viewports draw the same
+// structures, sharing their GPU buffers, with the main view's render settings; culling and level of detail come from
+// each viewport's own camera. A viewport is only rendered again when the scene content, its camera, or the size of the
+// main view changes, so viewports which are not changing cost nothing per frame.
+class Viewport {
+
+public:
+  Viewport(std::string name, const CameraParameters& camera, ProjectionMode projectionMode);
+
+  // No copy constructor/assignment
+  Viewport(const Viewport&) = delete;
+  Viewport& operator=(const Viewport&) = delete;
+
+  const std::string name;
+
+  void buildGUI(float width);
+
+  // == Setters and getters
+
+  void setCamera(const CameraParameters& newCamera);
+  CameraParameters getCamera();
+
+  void setProjectionMode(ProjectionMode newMode);
+  ProjectionMode getProjectionMode();
+
+  // Disabled viewports are neither rendered nor shown. (default: true)
+  void setEnabled(bool newVal);
+  bool isEnabled();
+
+  // The rendered image, the same size as the main view's buffer. Null until the viewport is first rendered.
+  render::TextureBuffer* getColorTexture();
+
+  // == Rendering, driven by draw()
+
+  // True if the image is out of date
+  bool needsRender();
+
+  // Set the global view to this viewport's camera, restored by endRender(). The scene should be rendered in between.
+  void beginRender();
+
+  // Resolve the rendered scene buffers in to this viewport's image, and restore the view
+  void endRender();
+
+  uint64_t renderCount = 0; // number of times the viewport has been rendered
+
+protected:
+  CameraParameters camera;
+  ProjectionMode projectionMode;
+  bool enabled = true;
+
+  bool cameraChanged = true;
+  uint64_t lastSceneContentVersion = 0;
+
+  std::shared_ptr<render::TextureBuffer> colorTexture;
+  std::shared_ptr<render::FrameBuffer> framebuffer;
+
+  // the main view, saved by beginRender()
+  glm::mat4 savedViewMat;
+  double savedFov;
+  ProjectionMode savedProjectionMode;
+};
+
+// Add a viewport with a unique name, looking at the scene from the given camera
+Viewport* addViewport(std::string name, const CameraParameters& camera,
+                      ProjectionMode projectionMode = ProjectionMode::Perspective);
+Viewport* getViewport(std::string name);
+bool hasViewport(std::string name);
+void removeViewport(std::string name, bool errorIfAbsent = false);
+void removeAllViewports();
+
+// Shows the enabled viewports, if there are any
+void buildViewportsGui();
+
+} // namespace polyscope
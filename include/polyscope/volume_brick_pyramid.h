@@ -0,0 +1,58 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace polyscope {
+
+// A scalar volume too large for memory, read from a memory-mapped raw file of 32-bit floats laid out as in VolumeGrid
+// (the last index fastest-varying), after an optional header. Coarser levels of detail are each half the resolution of
+// the last, filtered with a [1/4, 1/2, 1/4] tent so the nodes of level L sit on every 2^L-th node of the full grid.
+// They are built on first use and stored beside the raw file (see pyramidFilename()), and rebuilt if the raw file
+// changes. The levels are read out in bricks, the unit of streaming to the GPU.
+class VolumeBrickPyramid {
+public:
+  VolumeBrickPyramid(std::string filename, std::array<size_t, 3> steps, size_t headerBytes = 0);
+  ~VolumeBrickPyramid();
+
+  static const size_t brickSize = 32; // cells per side of a brick; a brick holds brickSize+1 nodes per side
+
+  // Level 0 is the full-resolution data, the last level fits in a single brick
+  size_t nLevels() const;
+  std::array<size_t, 3> levelSteps(size_t level) const;
+  std::array<size_t, 3> levelBricks(size_t level) const;
+  const float* levelData(size_t level) const; // points in to a mapped file
+
+  // The (brickSize+1)^3 values of a brick, with the first index fastest-varying as for a 3D texture. Nodes past the
+  // end of the level repeat the last node.
+  void readBrick(size_t level, std::array<size_t, 3> brick, float* out) const;
+
+  std::pair<float, float> getDataRange() const; // finite min/max of the full-resolution data
+  bool pyramidWasBuilt() const;                 // false if an existing pyramid file was reused
+  static std::string pyramidFilename(const std::string& rawFilename);
+
+private:
+  class MappedFile;
+
+  std::string filename;
+  std::vector<std::array<size_t, 3>> steps; // per level
+  size_t headerBytes;
+  std::pair<float, float> dataRange;
+  bool built = false;
+
+  std::unique_ptr<MappedFile> rawFile;
+  std::unique_ptr<MappedFile> pyramidFile;
+  std::vector<const float*> levels;
+
+  bool loadPyramid();
+  void buildPyramid();
+};
+
+} // namespace polyscope
@@ -11,6 +11,7 @@
 
 #include "polyscope/volume_grid_quantity.h"
 #include "polyscope/volume_grid_scalar_quantity.h"
+#include "polyscope/volume_grid_streamed_scalar_quantity.h"
 #include "polyscope/volume_grid_vector_quantity.h"
 
 #include <vector>
@@ -22,6 +23,7 @@ namespace polyscope {
 class VolumeGrid;
 class VolumeGridScalarIsosurface;
 class VolumeGridScalarQuantity;
+class VolumeGridStreamedScalarQuantity;
 class VolumeGridVectorQuantity;
 
 template <> // Specialize the quantity type
@@ -43,6 +45,7 @@ public:
   virtual void drawPick() override;
   virtual void updateObjectSpaceBounds() override;
   virtual std::string typeName() override;
+  virtual std::string drawSortKey() override; // the material
   virtual void refresh() override;
 
   // Build the imgui display
@@ -69,6 +72,10 @@ public:
   template <class Func>
   VolumeGridScalarQuantity* addScalarQuantityFromBatchCallable(std::string name, Func&& func, DataType dataType_ = DataType::STANDARD);
 
+  // Stream the values from a raw file of 32-bit floats laid out like the grid's nodes, which is memory-mapped rather
+  // than loaded. See VolumeGridStreamedScalarQuantity.
+  VolumeGridStreamedScalarQuantity* addScalarQuantityFromRawFile(std::string name, std::string filename, size_t headerBytes = 0, DataType dataType_ = DataType::STANDARD);
+
   template <class T>
   VolumeGridVectorQuantity* addVectorQuantity(std::string name, const T& vecValues, VectorType dataType_ = VectorType::STANDARD);
 
@@ -82,12 +89,13 @@ public:
   VolumeGrid* setMaterial(std::string name);
   std::string getMaterial();
 
-  // Rendering helpers used by quantities
-  std::vector<glm::vec3> gridPointLocations; // always populated
-  void populateGeometry();
+  // Rendering helpers used by quantities. Node positions are computed in the shader from the node index, so they are
+  // never stored; the point uniforms carry the grid's bounds and resolution.
   void setVolumeGridUniforms(render::ShaderProgram& p);
   void setVolumeGridPointUniforms(render::ShaderProgram& p);
+  void setVolumeGridRaymarchUniforms(render::ShaderProgram& p);
   std::vector<std::string> addVolumeGridPointRules(std::vector<std::string> initRules);
+  std::vector<glm::vec3> boundingBoxTriangles() const; // 12 triangles, for programs which rasterize the grid's bounds
   
   // Helpers for computing with the grid
   size_t nValues() const;
@@ -102,6 +110,11 @@ private:
   
   // === Visualization parameters
   PersistentValue<std::string> material;
+
+  // Nodes are pickable while a quantity draws them as points
+  std::shared_ptr<render::ShaderProgram> pickProgram;
+  bool nodesAreDrawn();
+  void ensurePickProgramPrepared();
   
   // === Quantity adder implementations
   // clang-format off
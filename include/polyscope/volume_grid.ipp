@@ -103,7 +103,7 @@ VolumeGridScalarQuantity* VolumeGrid::addScalarQuantityFromBatchCallable(std::st
 template <class T>
 VolumeGridVectorQuantity* VolumeGrid::addVectorQuantity(std::string name, const T& vecValues, VectorType dataType_) {
   validateSize(vecValues, nValues(), "grid vector quantity " + name);
-  return addVectorQuantityImpl(name, standardizeArray<glm::vec3, T>(vecValues), dataType_);
+  return addVectorQuantityImpl(name, standardizeVectorArray<glm::vec3, 3>(vecValues), dataType_);
 }
 
 /*
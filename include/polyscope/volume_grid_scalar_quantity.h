@@ -5,6 +5,7 @@
 #include "polyscope/polyscope.h"
 
 #include "polyscope/affine_remapper.h"
+#include "polyscope/grid_isosurface.h"
 #include "polyscope/histogram.h"
 #include "polyscope/render/color_maps.h"
 #include "polyscope/scalar_quantity.h"
@@ -18,8 +19,11 @@ public:
   VolumeGridScalarQuantity(std::string name, VolumeGrid& grid_, const std::vector<double>& values_, DataType dataType_);
 
   virtual void draw() override;
+  virtual void drawDelayed() override;
   virtual void buildCustomUI() override;
+  virtual void buildPickUI(size_t ind) override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
   virtual std::string niceName() override;
 
@@ -42,15 +46,29 @@ public:
   VolumeGridScalarQuantity* setIsosurfaceColor(glm::vec3 val);
   glm::vec3 getIsosurfaceColor();
 
+  // Raymarch the isosurface through a 3D texture of the values, rather than extracting a mesh. The level can then be
+  // changed interactively, at a per-pixel cost each frame.
+  VolumeGridScalarQuantity* setIsosurfaceRaymarch(bool val);
+  bool getIsosurfaceRaymarch();
+
+
+  // Volume viz (direct volume rendering, raymarched through a 3D texture of the values)
+
+  VolumeGridScalarQuantity* setVolumeVizEnabled(bool val);
+  bool getVolumeVizEnabled();
+
+  // Optical depth of a ray crossing the grid diagonal through values at the top of the range. Opacity ramps linearly
+  // from zero at the bottom of the range.
+  VolumeGridScalarQuantity* setVolumeDensity(float val);
+  float getVolumeDensity();
+
 
 protected:
   void createProgram();
-  void fillPositions();
   void resetMapRange();
 
   const DataType dataType;
   std::vector<double> values;
-  std::vector<glm::vec3> positions;
 
   // Visualize as points
   PersistentValue<bool> pointVizEnabled;
@@ -58,14 +76,27 @@ protected:
   void createPointProgram();
 
   // Visualize as isosurface
-  // TODO
   PersistentValue<bool> isosurfaceVizEnabled;
   PersistentValue<float> isosurfaceLevel;
   PersistentValue<glm::vec3> isosurfaceColor;
   std::shared_ptr<render::ShaderProgram> isosurfaceProgram;
+  std::unique_ptr<GridIsosurfaceExtractor> isosurfaceExtractor; // references values
   void createIsosurfaceProgram();
 
+  // Raymarched isosurface
+  PersistentValue<bool> isosurfaceRaymarch;
+  std::shared_ptr<render::ShaderProgram> isosurfaceRaymarchProgram;
+  void createIsosurfaceRaymarchProgram();
+
   // Visualize as raymarched volume
+  PersistentValue<bool> volumeVizEnabled;
+  PersistentValue<float> volumeDensity;
+  std::shared_ptr<render::ShaderProgram> volumeProgram;
+  void createVolumeProgram();
+
+  // The values as a 3D texture, shared by the raymarched visualizations. Only created if one of them is used.
+  std::shared_ptr<render::TextureBuffer> valuesTexture;
+  void ensureValuesTexture();
 };
 
 } // namespace polyscope
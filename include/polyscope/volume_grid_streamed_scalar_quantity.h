@@ -0,0 +1,135 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/polyscope.h"
+
+#include "polyscope/affine_remapper.h"
+#include "polyscope/histogram.h"
+#include "polyscope/render/color_maps.h"
+#include "polyscope/scalar_quantity.h"
+#include "polyscope/volume_brick_pyramid.h"
+#include "polyscope/volume_grid.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace polyscope {
+
+// A scalar quantity on a volume grid which is never loaded in full. The values are read from a memory-mapped raw file
+// through a VolumeBrickPyramid, and each frame the bricks wanted for the current view are paged in to a fixed-size
+// cache on the GPU: bricks are refined from the coarsest level while they are in the view frustum and their voxels
+// cover more than a few pixels, as far as the cache allows. A few bricks are uploaded per frame, coarse ones first;
+// until a brick arrives, the nearest coarser resident brick is drawn in its place, so the picture sharpens over a few
+// frames as the camera settles. The raymarched isosurface and volume visualizations render from the cache.
+class VolumeGridStreamedScalarQuantity : public VolumeGridQuantity,
+                                         public ScalarQuantity<VolumeGridStreamedScalarQuantity> {
+
+public:
+  VolumeGridStreamedScalarQuantity(std::string name, VolumeGrid& grid_, std::unique_ptr<VolumeBrickPyramid>&& pyramid_,
+                                   DataType dataType_);
+
+  virtual void draw() override;
+  virtual void drawDelayed() override;
+  virtual void buildCustomUI() override;
+  virtual void refresh() override;
+  virtual void refreshMaterial() override;
+
+  virtual std::string niceName() override;
+
+  const VolumeBrickPyramid& getPyramid() const;
+
+  // == Getters and setters
+
+  // Isosurface viz (raymarched)
+
+  VolumeGridStreamedScalarQuantity* setIsosurfaceVizEnabled(bool val);
+  bool getIsosurfaceVizEnabled();
+
+  VolumeGridStreamedScalarQuantity* setIsosurfaceLevel(float value);
+  float getIsosurfaceLevel();
+
+  VolumeGridStreamedScalarQuantity* setIsosurfaceColor(glm::vec3 val);
+  glm::vec3 getIsosurfaceColor();
+
+
+  // Volume viz, as in VolumeGridScalarQuantity
+
+  VolumeGridStreamedScalarQuantity* setVolumeVizEnabled(bool val);
+  bool getVolumeVizEnabled();
+
+  VolumeGridStreamedScalarQuantity* setVolumeDensity(float val);
+  float getVolumeDensity();
+
+
+  // Streaming
+
+  // Size of the GPU cache, in bricks of (brickSize+1)^3 floats (about 140 kB each). Changing it empties the cache.
+  VolumeGridStreamedScalarQuantity* setCacheBricks(size_t val);
+  size_t getCacheBricks();
+
+  VolumeGridStreamedScalarQuantity* setMaxBrickUploadsPerFrame(size_t val);
+  size_t getMaxBrickUploadsPerFrame();
+
+  // Bricks are refined until a voxel covers fewer than this many pixels
+  VolumeGridStreamedScalarQuantity* setLevelOfDetailPixels(float val);
+  float getLevelOfDetailPixels();
+
+  size_t getResidentBrickCount() const;
+  size_t getTotalBrickUploads() const;
+  bool getCacheComplete() const; // every brick wanted for the last view is resident
+
+
+protected:
+  std::unique_ptr<VolumeBrickPyramid> pyramid;
+  const DataType dataType;
+
+  // Raymarched isosurface
+  PersistentValue<bool> isosurfaceVizEnabled;
+  PersistentValue<float> isosurfaceLevel;
+  PersistentValue<glm::vec3> isosurfaceColor;
+  std::shared_ptr<render::ShaderProgram> isosurfaceProgram;
+  void createIsosurfaceProgram();
+
+  // Raymarched volume
+  PersistentValue<bool> volumeVizEnabled;
+  PersistentValue<float> volumeDensity;
+  std::shared_ptr<render::ShaderProgram> volumeProgram;
+  void createVolumeProgram();
+
+  // == The brick cache
+
+  struct BrickRef {
+    size_t level;
+    std::array<size_t, 3> brick;
+  };
+  struct CacheSlot {
+    uint64_t key;
+    uint64_t lastUsed; // update counter when it was last wanted
+    bool pinned;       // the coarsest level is never evicted, so every brick has a resident ancestor
+  };
+
+  size_t cacheBricks = 512;
+  size_t maxBrickUploadsPerFrame = 16;
+  float levelOfDetailPixels = 1.5;
+
+  std::shared_ptr<render::TextureBuffer> atlasTexture;
+  std::shared_ptr<render::TextureBuffer> pageTableTexture;
+  std::array<size_t, 3> atlasBricks;
+  std::vector<float> pageTableData;
+  std::vector<CacheSlot> slots;
+  std::unordered_map<uint64_t, uint32_t> residentSlots; // brick key --> slot
+  std::vector<uint64_t> lastCut;
+  glm::mat4 lastViewMat{0.f};
+  uint64_t updateCount = 0;
+  size_t totalBrickUploads = 0;
+  bool cacheComplete = false;
+
+  void ensureCache();
+  void updateCache();
+  std::vector<BrickRef> selectBricks(const glm::mat4& modelView, const glm::mat4& projMat) const;
+  std::array<glm::vec3, 2> brickBounds(size_t level, std::array<size_t, 3> brick) const;
+  void setStreamingUniforms(render::ShaderProgram& p);
+};
+
+} // namespace polyscope
@@ -0,0 +1,123 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#pragma once
+
+#include "polyscope/polyscope.h"
+
+#include "polyscope/render/managed_buffer.h"
+#include "polyscope/scaled_value.h"
+#include "polyscope/standardize_data_array.h"
+#include "polyscope/vector_quantity.h"
+#include "polyscope/volume_grid.h"
+
+#include <vector>
+
+namespace polyscope {
+
+// A vector at each node of the grid, in the same order as the scalar quantity values (see VolumeGrid::flattenIndex()).
+// Drawn as arrows at a subsample of the nodes, and/or as streamlines traced through the trilinearly interpolated field.
+class VolumeGridVectorQuantity : public VolumeGridQuantity, public VectorQuantityBase<VolumeGridVectorQuantity> {
+
+public:
+  VolumeGridVectorQuantity(std::string name, VolumeGrid& grid_, const std::vector<glm::vec3>& vectors_,
+                           VectorType vectorType_);
+
+  virtual void draw() override;
+  virtual void buildCustomUI() override;
+  virtual void buildPickUI(size_t ind) override;
+  virtual void refresh() override;
+  virtual std::string niceName() override;
+
+  template <class V>
+  void updateData(const V& newVectors);
+
+  // === Members
+
+  // The vectors at each node. Arrows read them on the GPU, streamlines are traced from the host copy.
+  render::ManagedBuffer<glm::vec3> vectors;
+
+  // == Getters and setters
+
+  // Arrow viz
+
+  VolumeGridVectorQuantity* setArrowVizEnabled(bool val);
+  bool getArrowVizEnabled();
+
+  // Draw an arrow at every n'th node along each axis. Nodes are picked in the shader from the arrow index, so nothing
+  // is uploaded for the subsample. If setMaxDrawnVectors() is also used, the stride grows until the count fits.
+  VolumeGridVectorQuantity* setSampleStride(size_t val);
+  size_t getSampleStride();
+
+  // Move each arrow to a random (but fixed) node within its stride cell, which hides the aliasing of a regular pattern
+  VolumeGridVectorQuantity* setSampleJitter(bool val);
+  bool getSampleJitter();
+
+
+  // Streamline viz
+
+  VolumeGridVectorQuantity* setStreamlineVizEnabled(bool val);
+  bool getStreamlineVizEnabled();
+
+  // Streamlines are traced forward and backward from each seed point. By default the seeds are a regular lattice of
+  // this many points along each axis of the grid.
+  VolumeGridVectorQuantity* setStreamlineSeedsPerAxis(size_t val);
+  size_t getStreamlineSeedsPerAxis();
+
+  // Trace from these points instead of the lattice. An empty list goes back to the lattice.
+  VolumeGridVectorQuantity* setStreamlineSeeds(const std::vector<glm::vec3>& seeds);
+  std::vector<glm::vec3> getStreamlineSeeds();
+
+  // The number of steps of half the minimum grid spacing taken in each direction, at most
+  VolumeGridVectorQuantity* setStreamlineMaxSteps(size_t val);
+  size_t getStreamlineMaxSteps();
+
+  VolumeGridVectorQuantity* setStreamlineRadius(double val, bool isRelative = true);
+  double getStreamlineRadius();
+
+  // The traced streamlines, as polylines (mostly for testing). Traced on demand, and cached until the data or seeds
+  // change.
+  const std::vector<std::vector<glm::vec3>>& getStreamlines();
+
+
+protected:
+  std::vector<glm::vec3> vectorsData;
+
+  // Arrows at the sampled nodes
+  PersistentValue<bool> arrowVizEnabled;
+  PersistentValue<int> sampleStride;
+  PersistentValue<bool> sampleJitter;
+  size_t effectiveSampleStride();
+  std::array<size_t, 3> sampleRes(size_t stride);
+  void drawArrows();
+  void createArrowProgram();
+
+  // Streamlines
+  PersistentValue<bool> streamlineVizEnabled;
+  PersistentValue<int> streamlineSeedsPerAxis;
+  PersistentValue<int> streamlineMaxSteps;
+  PersistentValue<ScaledValue<float>> streamlineRadius;
+  std::vector<glm::vec3> streamlineSeedsManual;
+  std::vector<std::vector<glm::vec3>> streamlines; // cached, valid if streamlinesTraced
+  bool streamlinesTraced = false;
+  std::shared_ptr<render::ShaderProgram> streamlineProgram;
+  std::string streamlineProgramMaterial;
+  std::vector<glm::vec3> streamlineSeedPoints();
+  void traceStreamlines();
+  void invalidateStreamlines();
+  void drawStreamlines();
+  void createStreamlineProgram();
+
+  void updateMaxLength();
+};
+
+
+template <class V>
+void VolumeGridVectorQuantity::updateData(const V& newVectors) {
+  validateSize(newVectors, vectors.size(), "grid vector quantity " + name);
+  vectors.data = standardizeVectorArray<glm::vec3, 3>(newVectors);
+  vectors.markHostBufferUpdated();
+  updateMaxLength();
+  invalidateStreamlines();
+}
+
+} // namespace polyscope
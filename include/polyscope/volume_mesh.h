@@ -42,10 +42,15 @@ public:
 
   // === Member functions ===
 
-  // Construct a new volume mesh structure
+  // Construct a new volume mesh structure (tet entries of cellIndices are padded with INVALID_IND)
   VolumeMesh(std::string name, const std::vector<glm::vec3>& vertexPositions,
              const std::vector<std::array<uint32_t, 8>>& cellIndices);
 
+  // Construct from cells which are already split by type. In the ordering of cells, the tets come first, followed by
+  // the hexes.
+  VolumeMesh(std::string name, const std::vector<glm::vec3>& vertexPositions,
+             std::vector<std::array<uint32_t, 4>> tetIndices, std::vector<std::array<uint32_t, 8>> hexIndices);
+
   // TODO add constructors & adaptors without intermediate nested list
 
   // Build the imgui display
@@ -59,7 +64,9 @@ public:
   virtual void drawPick() override;
   virtual void updateObjectSpaceBounds() override;
   virtual std::string typeName() override;
+  virtual std::string drawSortKey() override; // the material
   virtual void refresh() override;
+  virtual size_t nSubsetElements() override; // the cells
 
   // == Geometric quantities
   // (actually, these are wrappers around the private raw data members, but external users should interact with these
@@ -72,6 +79,7 @@ public:
   render::ManagedBuffer<uint32_t> triangleVertexInds; // on the split, triangulated mesh [3 * nTriFace]
   render::ManagedBuffer<uint32_t> triangleFaceInds;   // on the split, triangulated mesh [3 * nTriFace]
   render::ManagedBuffer<uint32_t> triangleCellInds;   // on the split, triangulated mesh [3 * nTriFace]
+  render::ManagedBuffer<uint32_t> triangleCells;      // on the split, triangulated mesh, once per triangle [nTriFace]
 
   // internal triangle data for rendering
   render::ManagedBuffer<glm::vec3> baryCoord;  // on the split, triangulated mesh [3 * nTriFace]
@@ -107,19 +115,31 @@ public:
 
   // === Indexing conventions & data
 
-  std::vector<std::array<uint32_t, 8>> cells; // unused entries hold INVALID_IND
+  // Cells are stored by type, each at its own width. In a mesh with both types, cellHexStart[iC] is the number of hexes
+  // before cell iC (so the cell is a hex if cellHexStart[iC + 1] differs), and it is empty otherwise. Use cellType()
+  // and cellVertices() rather than indexing these directly.
+  std::vector<std::array<uint32_t, 4>> tetCells;
+  std::vector<std::array<uint32_t, 8>> hexCells;
+  std::vector<uint32_t> cellHexStart;
+
+  // The vertices of cell iC, 4 for a tet and 8 for a hex
+  const uint32_t* cellVertices(size_t iC) const;
 
   // === Manage the mesh itself
 
   // Counts
   size_t nVertices() { return vertexPositions.size(); }
-  size_t nCells() { return cells.size(); }
+  size_t nCells() const { return tetCells.size() + hexCells.size(); }
 
   // In these face counts, the shared face between two cells is counted twice. (really it should face-side or half-face
   // or something)
   size_t nFacesTriangulation() const { return nFacesTriangulationCount; }
   size_t nFaces() const { return nFacesCount; }
 
+  // The number of triangles currently in the draw buffers, which omit interior faces unless they might be seen (see
+  // setSkipHiddenInteriorFaces())
+  size_t nDrawnFacesTriangulation() const { return nDrawnFacesTriangulationCount; }
+
   // Derived geometric quantities
   std::vector<char> faceIsInterior; // a flat array whose order matches the iteration order of the mesh
 
@@ -130,14 +150,25 @@ public:
   std::vector<std::string> addVolumeMeshRules(std::vector<std::string> initRules, bool withSurfaceShade = true,
                                               bool isSlice = false);
 
+  // Cell data (quantities, cull positions) can be stored once per cell and looked up per fragment from the triangle
+  // being drawn, via triangleCells, rather than expanded out to every triangle corner. Needs the cell and triangle
+  // indices to be exact as floats. Quantities then use the MESH_FETCH_FACE_* rules, a cell is a 'face' there;
+  // addVolumeMeshRules() adds the rule which maps triangles to cells.
+  bool canFetchCellData();
+
   // Manage a separate tetrahedral representation used for volumetric visualizations
-  // (for a pure-tet mesh this will be the same as the cells array)
+  // (for a pure-tet mesh this is the tetCells array itself, rather than a copy). It depends only on the cells, which
+  // never change after construction, so it is built once on first use and kept across refresh().
   // TODO use a managed buffer for this
-  std::vector<std::array<uint32_t, 4>> tets;
+  const std::vector<std::array<uint32_t, 4>>& getTets(); // builds the decomposition if needed
   size_t nTets();
   void computeTets();    // fills tet buffer
   void ensureHaveTets(); //  ensure the tet buffer is filled (but don't rebuild if already done)
 
+  // The order in which the slice buffers hold the tets of getTets() (see fillSliceGeometryBuffers()). It follows a
+  // space-filling curve through the tet centers, so that the tets near any plane fall in a few runs of it.
+  const std::vector<uint32_t>& getSliceTetOrder();
+
   // === Member variables ===
   static const std::string structureTypeName;
 
@@ -164,6 +195,12 @@ public:
   VolumeMesh* setEdgeWidth(double newVal);
   double getEdgeWidth();
 
+  // If true, interior faces are left out of the draw buffers until they could actually be seen: while a slice plane
+  // is active for this mesh, it is being inspected, it is transparent, or it has a visible subset of cells.
+  // (default: true)
+  VolumeMesh* setSkipHiddenInteriorFaces(bool newVal);
+  bool getSkipHiddenInteriorFaces();
+
   VolumeMeshVertexScalarQuantity* getLevelSetQuantity();
   void setLevelSetQuantity(VolumeMeshVertexScalarQuantity* _levelSet);
 
@@ -171,6 +208,12 @@ public:
   void setVolumeMeshUniforms(render::ShaderProgram& p);
   void fillGeometryBuffers(render::ShaderProgram& p);
   void fillSliceGeometryBuffers(render::ShaderProgram& p);
+
+  // Ranges (first, count) of positions in getSliceTetOrder() whose tets are cut by the plane
+  // dot(sliceVector, x) = slicePoint, as consumed by ShaderProgram::setDrawRanges(). Runs of consecutive cut tets share
+  // a range. Only the tets in boxes of the slice index which the plane crosses are tested.
+  std::vector<std::array<size_t, 2>> computeSlicedTetRanges(glm::vec3 sliceVector, float slicePoint);
+
   static const std::vector<std::vector<std::array<size_t, 3>>>& cellStencil(VolumeCellType type);
 
   // Slice plane listeners
@@ -181,6 +224,31 @@ public:
 
 
 private:
+  // Cells split by type, along with cellHexStart (see above)
+  struct CellsByType {
+    std::vector<std::array<uint32_t, 4>> tets;
+    std::vector<std::array<uint32_t, 8>> hexes;
+    std::vector<uint32_t> hexStart;
+  };
+  static CellsByType splitCellsByType(const std::vector<std::array<uint32_t, 8>>& cellIndices);
+  static CellsByType tetsThenHexes(std::vector<std::array<uint32_t, 4>> tetIndices,
+                                   std::vector<std::array<uint32_t, 8>> hexIndices);
+  VolumeMesh(std::string name, const std::vector<glm::vec3>& vertexPositions, CellsByType cellsByType);
+
+  // The tet decomposition of a mesh with hexes (see getTets())
+  std::vector<std::array<uint32_t, 4>> tetDecomposition;
+
+  // Spatial index for slicing. sliceTetBounds[0] holds the bounding box of each run of sliceLeafSize tets in
+  // sliceTetOrder, and each further level bounds groups of sliceBranching boxes of the level below, up to a single root.
+  // The order is kept when the vertices move, and only the boxes are refit.
+  static const size_t sliceLeafSize = 64;
+  static const size_t sliceBranching = 8;
+  std::vector<uint32_t> sliceTetOrder;
+  std::vector<std::vector<std::array<glm::vec3, 2>>> sliceTetBounds;
+  bool sliceTetBoundsValid = false;
+  void computeSliceTetOrder();
+  void computeSliceTetBounds();
+
   // == Mesh geometry buffers
   // Storage for the managed buffers above. You should generally interact with these through the managed buffers, not
   // these members.
@@ -192,6 +260,7 @@ private:
   std::vector<uint32_t> triangleVertexIndsData; // to the split, triangulated mesh
   std::vector<uint32_t> triangleFaceIndsData;   // to the split, triangulated mesh
   std::vector<uint32_t> triangleCellIndsData;   // to the split, triangulated mesh
+  std::vector<uint32_t> triangleCellsData;      // to the split, triangulated mesh
 
   // internal triangle data for rendering
   std::vector<glm::vec3> baryCoordData;
@@ -208,6 +277,7 @@ private:
   PersistentValue<glm::vec3> edgeColor;
   PersistentValue<std::string> material;
   PersistentValue<float> edgeWidth;
+  PersistentValue<bool> skipHiddenInteriorFaces;
 
   // Level sets
   // TODO: not currently really supported
@@ -219,6 +289,8 @@ private:
   void preparePick();
   void geometryChanged();
   void recomputeGeometryIfPopulated();
+  bool interiorFacesMayBeVisible();
+  void ensureDrawBuffersHoldVisibleFaces(); // rebuild the connectivity data if interior faces became (in)visible
 
   // Picking-related
   // Order of indexing: vertices, cells
@@ -241,6 +313,8 @@ private:
   // Internal members
   size_t nFacesTriangulationCount = 0;
   size_t nFacesCount = 0;
+  size_t nDrawnFacesTriangulationCount = 0;
+  bool interiorFacesInBuffers = true;
 
   // === Helper functions
 
@@ -263,8 +337,8 @@ private:
 
   VolumeMeshVertexColorQuantity* addVertexColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
   VolumeMeshCellColorQuantity* addCellColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors);
-  VolumeMeshVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
-  VolumeMeshCellScalarQuantity* addCellScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type);
+  VolumeMeshVertexScalarQuantity* addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
+  VolumeMeshCellScalarQuantity* addCellScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type);
   VolumeMeshVertexVectorQuantity* addVertexVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
   VolumeMeshCellVectorQuantity* addCellVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType);
 
@@ -8,15 +8,9 @@ template <class V, class F>
 VolumeMesh* registerTetMesh(std::string name, const V& vertexPositions, const F& tetIndices) {
   checkInitialized();
 
-  // Standardize the array, and pad out extra indices with -1 for our representation
-  std::vector<std::array<uint32_t, 8>> tetIndsArr = standardizeVectorArray<std::array<uint32_t, 8>, 4>(tetIndices);
-  for (size_t iC = 0; iC < tetIndsArr.size(); iC++) {
-    for (size_t j = 4; j < 8; j++) {
-      tetIndsArr[iC][j] = INVALID_IND_32;
-    }
-  }
-
-  VolumeMesh* s = new VolumeMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions), tetIndsArr);
+  VolumeMesh* s = new VolumeMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                 standardizeVectorArray<std::array<uint32_t, 4>, 4>(tetIndices),
+                                 std::vector<std::array<uint32_t, 8>>());
 
   bool success = registerStructure(s);
   if (!success) {
@@ -61,19 +55,9 @@ template <class V, class Ft, class Fh>
 VolumeMesh* registerTetHexMesh(std::string name, const V& vertexPositions, const Ft& tetIndices, const Fh& hexIndices) {
   checkInitialized();
 
-  // Standardize the array, and pad out extra indices with -1 for our representation
-  std::vector<std::array<uint32_t, 8>> tetIndsArr = standardizeVectorArray<std::array<uint32_t, 8>, 4>(tetIndices);
-  for (size_t iC = 0; iC < tetIndsArr.size(); iC++) {
-    for (size_t j = 4; j < 8; j++) {
-      tetIndsArr[iC][j] = INVALID_IND_32;
-    }
-  }
-  std::vector<std::array<uint32_t, 8>> hexIndsArr = standardizeVectorArray<std::array<uint32_t, 8>, 8>(hexIndices);
-
-  // combine the arrays
-  tetIndsArr.insert(tetIndsArr.end(), hexIndsArr.begin(), hexIndsArr.end());
-
-  VolumeMesh* s = new VolumeMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions), tetIndsArr);
+  VolumeMesh* s = new VolumeMesh(name, standardizeVectorArray<glm::vec3, 3>(vertexPositions),
+                                 standardizeVectorArray<std::array<uint32_t, 4>, 4>(tetIndices),
+                                 standardizeVectorArray<std::array<uint32_t, 8>, 8>(hexIndices));
 
   bool success = registerStructure(s);
   if (!success) {
@@ -88,6 +72,7 @@ template <class V>
 void VolumeMesh::updateVertexPositions(const V& newPositions) {
   validateSize(newPositions, nVertices(), "newPositions");
   vertexPositions.data = standardizeVectorArray<glm::vec3, 3>(newPositions);
+  vertexPositions.setStreaming(true); // positions which get updated are likely to be updated again, e.g. every frame
   vertexPositions.markHostBufferUpdated();
   geometryChanged();
 }
@@ -145,13 +130,13 @@ VolumeMeshCellColorQuantity* VolumeMesh::addCellColorQuantity(std::string name,
 template <class T>
 VolumeMeshVertexScalarQuantity* VolumeMesh::addVertexScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, nVertices(), "vertex scalar quantity " + name);
-  return addVertexScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addVertexScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 template <class T>
 VolumeMeshCellScalarQuantity* VolumeMesh::addCellScalarQuantity(std::string name, const T& data, DataType type) {
   validateSize(data, nCells(), "cell scalar quantity " + name);
-  return addCellScalarQuantityImpl(name, standardizeArray<double, T>(data), type);
+  return addCellScalarQuantityImpl(name, standardizeArray<float, T>(data), type);
 }
 
 
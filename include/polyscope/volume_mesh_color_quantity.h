@@ -20,6 +20,7 @@ public:
   virtual void draw() override;
   virtual std::string niceName() override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
 protected:
   // UI internals
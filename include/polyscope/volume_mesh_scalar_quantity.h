@@ -13,15 +13,18 @@
 
 namespace polyscope {
 
+class SurfaceMesh;
+
 class VolumeMeshScalarQuantity : public VolumeMeshQuantity, public ScalarQuantity<VolumeMeshScalarQuantity> {
 public:
   VolumeMeshScalarQuantity(std::string name, VolumeMesh& mesh_, std::string definedOn,
-                           const std::vector<double>& values_, DataType dataType);
+                           const std::vector<float>& values_, DataType dataType);
 
   virtual void draw() override;
   virtual void buildCustomUI() override;
   virtual std::string niceName() override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
 protected:
   const std::string definedOn;
@@ -38,7 +41,7 @@ protected:
 
 class VolumeMeshVertexScalarQuantity : public VolumeMeshScalarQuantity {
 public:
-  VolumeMeshVertexScalarQuantity(std::string name, const std::vector<double>& values_, VolumeMesh& mesh_,
+  VolumeMeshVertexScalarQuantity(std::string name, const std::vector<float>& values_, VolumeMesh& mesh_,
                                  DataType dataType_ = DataType::STANDARD);
 
   virtual void createProgram() override;
@@ -53,18 +56,39 @@ public:
   void fillLevelSetData(render::ShaderProgram& p);
   std::shared_ptr<render::ShaderProgram> levelSetProgram;
 
+  // When caching is enabled, the level set is extracted on the CPU once per change of the level (or the shown
+  // quantity) and the resulting triangles are drawn directly, rather than slicing every tet in a geometry shader each
+  // frame. This is much faster to draw on large meshes when the level is not changing.
+  void setLevelSetCaching(bool v);
+  bool getLevelSetCaching();
+
+  // Extract the current level set and register it as a new surface mesh, with the shown quantity as a vertex scalar
+  SurfaceMesh* registerLevelSetAsSurfaceMesh(std::string name);
+
   void fillSliceColorBuffers(render::ShaderProgram& p);
 
   virtual void buildCustomUI() override;
   virtual void buildScalarOptionsUI() override;
   void buildVertexInfoGUI(size_t vInd) override;
   virtual void refresh() override;
+  virtual void refreshMaterial() override;
 
   // TODO make these persistent values
 
   float levelSetValue;
   bool isDrawingLevelSet;
   VolumeMeshVertexScalarQuantity* showQuantity;
+  bool levelSetCaching;
+
+private:
+  // The cached level set, as a triangle soup. Each vertex lies on the tet mesh edge levelSetVertexEdges[i] (ordered
+  // with the smaller index first), at parameter levelSetVertexT[i] along it.
+  std::shared_ptr<render::ShaderProgram> cachedLevelSetProgram;
+  float cachedLevelSetValue;
+  std::vector<std::array<uint32_t, 2>> levelSetVertexEdges;
+  std::vector<float> levelSetVertexT;
+  void computeLevelSetTriangles();
+  void createCachedLevelSetProgram();
 };
 
 
@@ -74,7 +98,7 @@ public:
 
 class VolumeMeshCellScalarQuantity : public VolumeMeshScalarQuantity {
 public:
-  VolumeMeshCellScalarQuantity(std::string name, const std::vector<double>& values_, VolumeMesh& mesh_,
+  VolumeMeshCellScalarQuantity(std::string name, const std::vector<float>& values_, VolumeMesh& mesh_,
                                DataType dataType_ = DataType::STANDARD);
 
   virtual void createProgram() override;
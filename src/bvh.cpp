@@ -0,0 +1,222 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/bvh.h"
+
+#include "polyscope/messages.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace polyscope {
+
+namespace {
+const float INF = std::numeric_limits<float>::infinity();
+const uint32_t BVH_LEAF_SIZE = 4;
+} // namespace
+
+BVH::BVH() {}
+
+void BVH::clear() {
+  nodes.clear();
+  primInds.clear();
+  built = false;
+}
+
+void BVH::build(const std::vector<glm::vec3>& primMin, const std::vector<glm::vec3>& primMax) {
+  clear();
+
+  if (primMin.size() != primMax.size()) {
+    exception("BVH build: primitive bound arrays have different sizes");
+  }
+  if (primMin.size() >= std::numeric_limits<uint32_t>::max()) {
+    exception("BVH build: too many primitives");
+  }
+
+  uint32_t nPrim = static_cast<uint32_t>(primMin.size());
+  primInds.resize(nPrim);
+  std::vector<glm::vec3> centroids(nPrim);
+  for (uint32_t i = 0; i < nPrim; i++) {
+    primInds[i] = i;
+    centroids[i] = 0.5f * (primMin[i] + primMax[i]);
+  }
+
+  if (nPrim > 0) {
+    nodes.reserve(2 * (nPrim / BVH_LEAF_SIZE + 1));
+    buildRecursive(primMin, primMax, centroids, 0, nPrim);
+  }
+
+  built = true;
+}
+
+uint32_t BVH::buildRecursive(const std::vector<glm::vec3>& primMin, const std::vector<glm::vec3>& primMax,
+                             const std::vector<glm::vec3>& centroids, uint32_t start, uint32_t end) {
+
+  uint32_t nodeInd = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+
+  // Bound the primitives and their centroids
+  glm::vec3 bboxMin{INF, INF, INF};
+  glm::vec3 bboxMax{-INF, -INF, -INF};
+  glm::vec3 centMin{INF, INF, INF};
+  glm::vec3 centMax{-INF, -INF, -INF};
+  for (uint32_t i = start; i < end; i++) {
+    uint32_t p = primInds[i];
+    bboxMin = glm::min(bboxMin, primMin[p]);
+    bboxMax = glm::max(bboxMax, primMax[p]);
+    centMin = glm::min(centMin, centroids[p]);
+    centMax = glm::max(centMax, centroids[p]);
+  }
+  nodes[nodeInd].bboxMin = bboxMin;
+  nodes[nodeInd].bboxMax = bboxMax;
+
+  // Make a leaf if there are few enough primitives, or they can't be separated
+  glm::vec3 centExtent = centMax - centMin;
+  float maxExtent = std::max(centExtent.x, std::max(centExtent.y, centExtent.z));
+  if (end - start <= BVH_LEAF_SIZE || !(maxExtent > 0.)) {
+    nodes[nodeInd].start = start;
+    nodes[nodeInd].count = end - start;
+    return nodeInd;
+  }
+
+  // Split at the median along the longest axis
+  int axis = 0;
+  if (centExtent.y > centExtent[axis]) axis = 1;
+  if (centExtent.z > centExtent[axis]) axis = 2;
+  uint32_t mid = start + (end - start) / 2;
+  std::nth_element(primInds.begin() + start, primInds.begin() + mid, primInds.begin() + end,
+                   [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+  buildRecursive(primMin, primMax, centroids, start, mid); // first child is always nodeInd + 1
+  uint32_t secondChild = buildRecursive(primMin, primMax, centroids, mid, end);
+  nodes[nodeInd].start = secondChild;
+  nodes[nodeInd].count = 0;
+
+  return nodeInd;
+}
+
+std::pair<size_t, float> BVH::intersectRay(glm::vec3 rayStart, glm::vec3 rayDir,
+                                           const std::function<float(size_t)>& intersectPrimitive) const {
+
+  size_t bestInd = INVALID_IND;
+  float bestT = INF;
+  if (nodes.empty()) return {bestInd, bestT};
+
+  glm::vec3 rayDirInv = 1.f / rayDir;
+
+  std::vector<uint32_t> stack;
+  stack.push_back(0);
+  while (!stack.empty()) {
+    uint32_t nodeInd = stack.back();
+    stack.pop_back();
+    const Node& node = nodes[nodeInd];
+
+    if (rayBoxIntersection(rayStart, rayDirInv, node.bboxMin, node.bboxMax) >= bestT) continue;
+
+    if (node.count > 0) {
+      // Leaf: test the primitives
+      for (uint32_t i = node.start; i < node.start + node.count; i++) {
+        uint32_t p = primInds[i];
+        float t = intersectPrimitive(p);
+        if (t < bestT) {
+          bestT = t;
+          bestInd = p;
+        }
+      }
+    } else {
+      stack.push_back(node.start);
+      stack.push_back(nodeInd + 1);
+    }
+  }
+
+  return {bestInd, bestT};
+}
+
+// == Ray-primitive intersection helpers
+
+float rayTriangleIntersection(glm::vec3 rayStart, glm::vec3 rayDir, glm::vec3 pA, glm::vec3 pB, glm::vec3 pC) {
+  // Moller-Trumbore
+  glm::vec3 e1 = pB - pA;
+  glm::vec3 e2 = pC - pA;
+  glm::vec3 pVec = glm::cross(rayDir, e2);
+  float det = glm::dot(e1, pVec);
+  if (std::fabs(det) < 1e-20f) return INF;
+  float invDet = 1.f / det;
+
+  glm::vec3 tVec = rayStart - pA;
+  float u = glm::dot(tVec, pVec) * invDet;
+  if (u < 0.f || u > 1.f) return INF;
+
+  glm::vec3 qVec = glm::cross(tVec, e1);
+  float v = glm::dot(rayDir, qVec) * invDet;
+  if (v < 0.f || u + v > 1.f) return INF;
+
+  float t = glm::dot(e2, qVec) * invDet;
+  if (t < 0.f) return INF;
+  return t;
+}
+
+float raySphereIntersection(glm::vec3 rayStart, glm::vec3 rayDir, glm::vec3 center, float radius) {
+  glm::vec3 oc = rayStart - center;
+  float a = glm::dot(rayDir, rayDir);
+  float b = glm::dot(rayDir, oc);
+  float c = glm::dot(oc, oc) - radius * radius;
+  float h = b * b - a * c;
+  if (h < 0.f || a == 0.f) return INF;
+  float sqrtH = std::sqrt(h);
+  float t = (-b - sqrtH) / a;
+  if (t < 0.f) t = (-b + sqrtH) / a; // ray starts inside
+  if (t < 0.f) return INF;
+  return t;
+}
+
+float rayCapsuleIntersection(glm::vec3 rayStart, glm::vec3 rayDir, glm::vec3 pA, glm::vec3 pB, float radius) {
+
+  // Work with a unit direction, and convert back to the caller's parameterization at the end
+  float dirLen = glm::length(rayDir);
+  if (dirLen == 0.f) return INF;
+  glm::vec3 rd = rayDir / dirLen;
+
+  glm::vec3 ba = pB - pA;
+  glm::vec3 oa = rayStart - pA;
+  float baba = glm::dot(ba, ba);
+  float bard = glm::dot(ba, rd);
+  float baoa = glm::dot(ba, oa);
+  float rdoa = glm::dot(rd, oa);
+  float oaoa = glm::dot(oa, oa);
+  float a = baba - bard * bard;
+
+  // Degenerate cases (zero-length segment, or ray parallel to the axis): only the end caps can be hit first
+  if (baba == 0.f || a <= 1e-12f * baba) {
+    return std::min(raySphereIntersection(rayStart, rayDir, pA, radius),
+                    raySphereIntersection(rayStart, rayDir, pB, radius));
+  }
+
+  // Cylindrical body
+  float b = baba * rdoa - baoa * bard;
+  float c = baba * oaoa - baoa * baoa - radius * radius * baba;
+  float h = b * b - a * c;
+  if (h < 0.f) return INF;
+  float t = (-b - std::sqrt(h)) / a;
+  float y = baoa + t * bard;
+  if (y > 0.f && y < baba) {
+    if (t < 0.f) return INF;
+    return t / dirLen;
+  }
+
+  // End caps
+  glm::vec3 cap = (y <= 0.f) ? pA : pB;
+  return raySphereIntersection(rayStart, rayDir, cap, radius);
+}
+
+float rayBoxIntersection(glm::vec3 rayStart, glm::vec3 rayDirInv, glm::vec3 bboxMin, glm::vec3 bboxMax) {
+  glm::vec3 t0 = (bboxMin - rayStart) * rayDirInv;
+  glm::vec3 t1 = (bboxMax - rayStart) * rayDirInv;
+  glm::vec3 tNear = glm::min(t0, t1);
+  glm::vec3 tFar = glm::max(t0, t1);
+  float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+  float tExit = std::min(tFar.x, std::min(tFar.y, tFar.z));
+  if (tEnter > tExit) return INF;
+  return tEnter;
+}
+
+} // namespace polyscope
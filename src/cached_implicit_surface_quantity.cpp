@@ -0,0 +1,138 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/cached_implicit_surface_quantity.h"
+
+#include "polyscope/floating_quantity_structure.h"
+#include "polyscope/view.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace polyscope {
+
+constexpr float CachedImplicitSurfaceQuantity::reprojectionStartFactor;
+
+CachedImplicitSurfaceQuantity::CachedImplicitSurfaceQuantity(Structure& parent_, std::string name,
+                                                             BatchFunction func_, ImplicitRenderMode mode_,
+                                                             ImplicitRenderOpts opts_)
+    : DepthRenderImageQuantity(parent_, name, 1, 1, {std::numeric_limits<float>::infinity()}, {glm::vec3{0., 0., 0.}},
+                               ImageOrigin::UpperLeft),
+      func(func_), mode(mode_), opts(opts_) {
+  update();
+}
+
+void CachedImplicitSurfaceQuantity::drawDelayed() {
+  if (!isEnabled()) return;
+  update();
+  DepthRenderImageQuantity::drawDelayed();
+}
+
+bool CachedImplicitSurfaceQuantity::update() {
+
+  // Renders from the current view need a perspective camera, keep the last render until we have one
+  if (!opts.cameraParameters.isValid() && view::projectionMode != ProjectionMode::Perspective) return false;
+
+  ImplicitRenderOpts frameOpts = opts;
+  resolveImplicitRenderOpts(getGlobalFloatingQuantityStructure(), frameOpts);
+  bool viewChanged = internal::implicitRenderViewChanged(uniquePrefix(), frameOpts.cameraParameters, frameOpts.dimX,
+                                                         frameOpts.dimY);
+  if (!viewChanged && !parametersChanged) return false;
+
+  size_t newDimX = frameOpts.dimX;
+  size_t newDimY = frameOpts.dimY;
+  std::vector<float> startDepths;
+  bool useStartDepths = reprojection && !parametersChanged && !lastHitPositions.empty();
+  if (useStartDepths) {
+    startDepths = reprojectStartDepths(frameOpts.cameraParameters, newDimX, newDimY);
+  }
+
+  // (counted atomically, the function may be called from several threads)
+  std::atomic<size_t> nEvals(0);
+  auto countedFunc = [&](const float* pos, float* out, size_t n) {
+    nEvals += n;
+    func(pos, out, n);
+  };
+
+  std::vector<float> rayDepthOut;
+  std::vector<glm::vec3> rayPosOut;
+  std::vector<glm::vec3> normalOut;
+  std::tie(rayDepthOut, rayPosOut, normalOut) =
+      renderImplicitSurfaceTracer(countedFunc, mode, frameOpts, useStartDepths ? &startDepths : nullptr);
+
+  lastHitPositions.clear();
+  for (size_t i = 0; i < rayDepthOut.size(); i++) {
+    if (std::isfinite(rayDepthOut[i])) lastHitPositions.push_back(rayPosOut[i]);
+  }
+
+  if (newDimX == dimX && newDimY == dimY) {
+    updateGeometryBuffers(rayDepthOut, normalOut);
+  } else {
+    resizeGeometryBuffers(newDimX, newDimY, rayDepthOut, normalOut);
+  }
+
+  parametersChanged = false;
+  lastEvaluationCount = nEvals;
+  renderCount++;
+  return true;
+}
+
+std::vector<float> CachedImplicitSurfaceQuantity::reprojectStartDepths(const CameraParameters& params, size_t newDimX,
+                                                                       size_t newDimY) {
+
+  // Splat the distance to each previous hit in to the pixel it now lands in, keeping the nearest
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> hintDepths(newDimX * newDimY, inf);
+  glm::mat4x4 viewMat = params.getViewMat();
+  float fovY = glm::radians(params.getFoVVerticalDegrees());
+  glm::mat4 projMat = glm::infinitePerspective(fovY, params.getAspectRatioWidthOverHeight(), 1.f);
+  glm::vec4 viewport = {0., 0., newDimX, newDimY};
+  glm::vec3 cameraLoc = params.getPosition();
+  for (const glm::vec3& p : lastHitPositions) {
+    if ((viewMat * glm::vec4(p, 1.)).z >= 0.) continue; // behind the camera
+
+    // (same pixel convention as CameraParameters::generateCameraRays() with ImageOrigin::UpperLeft)
+    glm::vec3 screenPos = glm::project(p, viewMat, projMat, viewport);
+    long iX = std::lround(screenPos.x);
+    long iY = static_cast<long>(newDimY) - std::lround(screenPos.y);
+    if (iX < 0 || iY < 0 || iX >= static_cast<long>(newDimX) || iY >= static_cast<long>(newDimY)) continue;
+
+    float& hint = hintDepths[iY * newDimX + iX];
+    hint = std::min(hint, glm::length(p - cameraLoc));
+  }
+
+  // Start each ray short of the nearest hint in its neighborhood, which covers small gaps between the splats
+  std::vector<float> startDepths(newDimX * newDimY, 0.);
+  for (size_t iY = 0; iY < newDimY; iY++) {
+    for (size_t iX = 0; iX < newDimX; iX++) {
+      float nearest = inf;
+      for (size_t jY = (iY == 0 ? 0 : iY - 1); jY <= std::min(iY + 1, newDimY - 1); jY++) {
+        for (size_t jX = (iX == 0 ? 0 : iX - 1); jX <= std::min(iX + 1, newDimX - 1); jX++) {
+          nearest = std::min(nearest, hintDepths[jY * newDimX + jX]);
+        }
+      }
+      if (nearest < inf) startDepths[iY * newDimX + iX] = reprojectionStartFactor * nearest;
+    }
+  }
+
+  return startDepths;
+}
+
+void CachedImplicitSurfaceQuantity::markParametersChanged() {
+  parametersChanged = true;
+  requestRedraw();
+}
+
+CachedImplicitSurfaceQuantity* CachedImplicitSurfaceQuantity::setReprojection(bool newVal) {
+  reprojection = newVal;
+  return this;
+}
+bool CachedImplicitSurfaceQuantity::getReprojection() { return reprojection; }
+
+size_t CachedImplicitSurfaceQuantity::getLastEvaluationCount() { return lastEvaluationCount; }
+
+size_t CachedImplicitSurfaceQuantity::getRenderCount() { return renderCount; }
+
+} // namespace polyscope
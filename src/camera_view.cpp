@@ -3,6 +3,7 @@
 #include "polyscope/camera_view.h"
 
 #include "polyscope/file_helpers.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
@@ -21,6 +22,275 @@ namespace polyscope {
 
 // Initialize statics
 const std::string CameraView::structureTypeName = "Camera View";
+std::weak_ptr<CameraView::Batch> CameraView::sharedBatch;
+
+const std::array<std::array<size_t, 2>, 11> CameraView::widgetEdges = {
+    {{{0, 1}}, {{0, 2}}, {{0, 3}}, {{0, 4}}, {{1, 2}}, {{2, 4}}, {{4, 3}}, {{3, 1}}, {{6, 7}}, {{7, 5}}, {{5, 6}}}};
+const std::array<std::array<size_t, 3>, 7> CameraView::widgetPickTriangles = {
+    {{{0, 2, 1}}, {{0, 4, 2}}, {{0, 3, 4}}, {{0, 1, 3}}, {{1, 2, 4}}, {{1, 4, 3}}, {{5, 7, 6}}}};
+
+namespace {
+// Below this many batchable camera views, each draws its own widget
+const size_t minBatchedCameraViews = 16;
+} // namespace
+
+// The widgets of the batched camera views, drawn as one instanced draw of all of their nodes, one of all of their
+// edges, and one (non-instanced) pick draw. The geometry is expanded on the host in world space, with each camera
+// view's transform applied, and rebuilt when the batched camera views or anything they draw from changes.
+//
+// update() works out the batch once per pass over the structures (see internal::structureDrawPassCount), and then the
+// first batched camera view to be drawn in the pass draws it for all of them.
+struct CameraView::Batch {
+
+  // The inputs the buffers are built from, besides the camera parameters (see version)
+  struct MemberState {
+    glm::mat4 transform;
+    glm::vec3 color;
+    float radius;
+    bool operator==(const MemberState& o) const {
+      return transform == o.transform && color == o.color && radius == o.radius;
+    }
+  };
+  struct Contents {
+    std::vector<CameraView*> members;
+    std::vector<MemberState> states;
+    uint64_t version = 0;
+    float lengthScale = -1.;
+    bool operator==(const Contents& o) const {
+      return members == o.members && states == o.states && version == o.version && lengthScale == o.lengthScale;
+    }
+  };
+
+  Contents current;
+  Contents drawnContents, pickContents; // what the programs hold
+  uint64_t version = 1;                 // bumped by other changes to any camera view, so they all rebuild
+  uint64_t updatePass = 0;
+  uint64_t drawPass = 0;
+  uint64_t pickPass = 0;
+
+  std::shared_ptr<render::ShaderProgram> nodeProgram, edgeProgram, pickProgram;
+
+  void update() {
+    if (updatePass == internal::structureDrawPassCount) return;
+    updatePass = internal::structureDrawPassCount;
+
+    Contents next;
+    next.version = version;
+    next.lengthScale = state::lengthScale;
+    InsertionOrderedMap<std::string, std::shared_ptr<Structure>>* cameras = nullptr;
+    if (state::structures.find(structureTypeName) != state::structures.end()) {
+      cameras = &state::structures[structureTypeName];
+    }
+    if (cameras && options::batchCameraViews) {
+      for (auto& s : *cameras) {
+        CameraView* c = static_cast<CameraView*>(s.second.get());
+        if (c->batchEligible()) next.members.push_back(c);
+      }
+      if (next.members.size() < minBatchedCameraViews) next.members.clear();
+    }
+
+    if (cameras) {
+      for (auto& s : *cameras) static_cast<CameraView*>(s.second.get())->inBatch = false;
+    }
+    for (CameraView* c : next.members) {
+      c->inBatch = true;
+      next.states.push_back(
+          MemberState{c->getTransform(), c->getWidgetColor(), c->getWidgetFocalLength() * c->getWidgetThickness()});
+    }
+    current = std::move(next);
+  }
+
+  void removeMember(CameraView* c) {
+    for (size_t i = 0; i < current.members.size(); i++) {
+      if (current.members[i] != c) continue;
+      current.members.erase(current.members.begin() + i);
+      current.states.erase(current.states.begin() + i);
+      break;
+    }
+    version++;
+  }
+
+  void refresh() {
+    nodeProgram.reset();
+    edgeProgram.reset();
+    pickProgram.reset();
+    version++;
+  }
+
+  void draw(CameraView& lead) {
+    if (nodeProgram == nullptr || edgeProgram == nullptr) {
+      // (all members are opaque and use every slice plane, so any of them gives the same rules)
+      nodeProgram = render::engine->requestShader(
+          "RAYCAST_SPHERE_INSTANCED", lead.addStructureRules({"SPHERE_PROPAGATE_COLOR_INSTANCED", "SHADE_COLOR",
+                                                              "SPHERE_VARIABLE_SIZE_INSTANCED"}));
+      render::engine->setMaterial(*nodeProgram, "flat");
+      edgeProgram = render::engine->requestShader(
+          "RAYCAST_CYLINDER_INSTANCED", lead.addStructureRules({"CYLINDER_PROPAGATE_COLOR_INSTANCED", "SHADE_COLOR",
+                                                                "CYLINDER_VARIABLE_SIZE_INSTANCED"}));
+      render::engine->setMaterial(*edgeProgram, "flat");
+      drawnContents = Contents();
+    }
+    if (!(drawnContents == current)) {
+      fillDrawGeometry();
+      drawnContents = current;
+    }
+
+    // The geometry is already in world space
+    glm::mat4 viewMat = view::getCameraViewMatrix();
+    for (render::ShaderProgram* p : {nodeProgram.get(), edgeProgram.get()}) {
+      lead.setStructureUniforms(*p);
+      p->setUniform("u_modelView", glm::value_ptr(viewMat));
+    }
+    nodeProgram->setUniform("u_pointRadius", 1.f);
+    nodeProgram->setInstanceCount(static_cast<uint32_t>(8 * current.members.size()));
+    edgeProgram->setUniform("u_radius", 1.f);
+    edgeProgram->setInstanceCount(static_cast<uint32_t>(widgetEdges.size() * current.members.size()));
+
+    nodeProgram->draw();
+    edgeProgram->draw();
+  }
+
+  void drawPick(CameraView& lead) {
+    for (CameraView* c : current.members) c->ensurePickRange();
+
+    if (pickProgram == nullptr) {
+      pickProgram = render::engine->requestShader("MESH", lead.addStructureRules({"MESH_PROPAGATE_PICK_SIMPLE"}),
+                                                  render::ShaderReplacementDefaults::Pick);
+      pickContents = Contents();
+    }
+    if (!(pickContents == current)) {
+      fillPickGeometry();
+      pickContents = current;
+    }
+
+    lead.setStructureUniforms(*pickProgram);
+    glm::mat4 viewMat = view::getCameraViewMatrix();
+    pickProgram->setUniform("u_modelView", glm::value_ptr(viewMat));
+    pickProgram->draw();
+  }
+
+  // The widget nodes of each member, in world space
+  std::vector<std::array<glm::vec3, 8>> computeNodes() {
+    std::vector<std::array<glm::vec3, 8>> nodes(current.members.size());
+    parallelFor(
+        0, nodes.size(),
+        [&](size_t start, size_t end) {
+          for (size_t i = start; i < end; i++) {
+            std::array<glm::vec3, 8> local = current.members[i]->computeWidgetNodes();
+            const glm::mat4& T = current.states[i].transform;
+            for (size_t j = 0; j < local.size(); j++) nodes[i][j] = glm::vec3(T * glm::vec4(local[j], 1.));
+          }
+        },
+        256);
+    return nodes;
+  }
+
+  void fillDrawGeometry() {
+    std::vector<std::array<glm::vec3, 8>> nodes = computeNodes();
+    size_t nMembers = nodes.size();
+    size_t nEdges = widgetEdges.size();
+
+    std::vector<glm::vec3> nodePos(8 * nMembers), nodeColor(8 * nMembers);
+    std::vector<float> nodeRadius(8 * nMembers);
+    std::vector<glm::vec3> edgeTail(nEdges * nMembers), edgeTip(nEdges * nMembers), edgeColor(nEdges * nMembers);
+    std::vector<float> edgeRadius(nEdges * nMembers);
+    parallelFor(
+        0, nMembers,
+        [&](size_t start, size_t end) {
+          for (size_t i = start; i < end; i++) {
+            // (the radius in world space, if the transform scales)
+            const MemberState& s = current.states[i];
+            float radius = s.radius * std::cbrt(std::abs(glm::determinant(glm::mat3(s.transform))));
+            for (size_t j = 0; j < 8; j++) {
+              nodePos[8 * i + j] = nodes[i][j];
+              nodeColor[8 * i + j] = s.color;
+              nodeRadius[8 * i + j] = radius;
+            }
+            for (size_t j = 0; j < nEdges; j++) {
+              edgeTail[nEdges * i + j] = nodes[i][widgetEdges[j][0]];
+              edgeTip[nEdges * i + j] = nodes[i][widgetEdges[j][1]];
+              edgeColor[nEdges * i + j] = s.color;
+              edgeRadius[nEdges * i + j] = radius;
+            }
+          }
+        },
+        256);
+
+    std::vector<glm::vec2> quadCorners = {{-1., -1.}, {1., -1.}, {-1., 1.}, {-1., 1.}, {1., -1.}, {1., 1.}};
+    nodeProgram->setAttribute("a_quadCorner", quadCorners);
+    nodeProgram->setAttribute("a_position", nodePos);
+    nodeProgram->setAttribute("a_color", nodeColor);
+    nodeProgram->setAttribute("a_pointRadius", nodeRadius);
+    for (const char* attr : {"a_position", "a_color", "a_pointRadius"}) nodeProgram->setAttributePerInstance(attr);
+
+    edgeProgram->setAttribute("a_boxCorner", cylinderBoxCorners());
+    edgeProgram->setAttribute("a_position_tail", edgeTail);
+    edgeProgram->setAttribute("a_position_tip", edgeTip);
+    edgeProgram->setAttribute("a_color", edgeColor);
+    edgeProgram->setAttribute("a_tailRadius", edgeRadius);
+    edgeProgram->setAttribute("a_tipRadius", edgeRadius);
+    for (const char* attr : {"a_position_tail", "a_position_tip", "a_color", "a_tailRadius", "a_tipRadius"}) {
+      edgeProgram->setAttributePerInstance(attr);
+    }
+  }
+
+  void fillPickGeometry() {
+    std::vector<std::array<glm::vec3, 8>> nodes = computeNodes();
+    size_t nMembers = nodes.size();
+    size_t nVerts = 3 * widgetPickTriangles.size();
+
+    std::vector<glm::vec3> positions(nVerts * nMembers), bcoord(nVerts * nMembers), faceColor(nVerts * nMembers);
+    std::vector<std::array<glm::vec3, 3>> tripleColors(nVerts * nMembers);
+    parallelFor(
+        0, nMembers,
+        [&](size_t start, size_t end) {
+          for (size_t i = start; i < end; i++) {
+            glm::vec3 pickColor = current.members[i]->pickColor;
+            for (size_t j = 0; j < widgetPickTriangles.size(); j++) {
+              for (size_t k = 0; k < 3; k++) {
+                size_t iV = nVerts * i + 3 * j + k;
+                positions[iV] = nodes[i][widgetPickTriangles[j][k]];
+                bcoord[iV] = glm::vec3(k == 0, k == 1, k == 2);
+                faceColor[iV] = pickColor;
+                tripleColors[iV] = std::array<glm::vec3, 3>{pickColor, pickColor, pickColor};
+              }
+            }
+          }
+        },
+        256);
+
+    pickProgram->setAttribute("a_vertexPositions", positions);
+    pickProgram->setAttribute("a_barycoord", bcoord);
+    pickProgram->setAttribute<glm::vec3, 3>("a_vertexColors", tripleColors);
+    pickProgram->setAttribute("a_faceColor", faceColor);
+  }
+
+  // The 12 triangles of a cylinder's bounding box, as (x, y) in the cross-section and 0 / 1 for the tail / tip end
+  // (the same as a curve network's)
+  static std::vector<glm::vec3> cylinderBoxCorners() {
+    const std::array<glm::vec3, 14> strip = {{{-1., 1., 1.},
+                                              {1., 1., 1.},
+                                              {-1., -1., 1.},
+                                              {1., -1., 1.},
+                                              {1., -1., 0.},
+                                              {1., 1., 1.},
+                                              {1., 1., 0.},
+                                              {-1., 1., 1.},
+                                              {-1., 1., 0.},
+                                              {-1., -1., 1.},
+                                              {-1., -1., 0.},
+                                              {1., -1., 0.},
+                                              {-1., 1., 0.},
+                                              {1., 1., 0.}}};
+    std::vector<glm::vec3> boxCorners;
+    for (size_t i = 0; i + 2 < strip.size(); i++) {
+      size_t a = (i % 2 == 0) ? i : i + 1;
+      size_t b = (i % 2 == 0) ? i + 1 : i;
+      boxCorners.insert(boxCorners.end(), {strip[a], strip[b], strip[i + 2]});
+    }
+    return boxCorners;
+  }
+};
 
 // Constructor
 CameraView::CameraView(std::string name, const CameraParameters& params_)
@@ -29,47 +299,62 @@ CameraView::CameraView(std::string name, const CameraParameters& params_)
       widgetThickness(uniquePrefix() + "#widgetThickness", 0.02),
       widgetColor(uniquePrefix() + "#widgetColor", glm::vec3{0., 0., 0.}) {
 
+  batch = sharedBatch.lock();
+  if (!batch) {
+    batch = std::make_shared<Batch>();
+    sharedBatch = batch;
+  }
+
   updateObjectSpaceBounds();
 }
 
+CameraView::~CameraView() { batch->removeMember(this); }
+
+bool CameraView::batchEligible() {
+  return isEnabled() && !isStatic() && getTransparency() == 1. && getSlicePlaneIgnoreMask() == 0 &&
+         !getCullWholeElements();
+}
+
 
 void CameraView::draw() {
   if (!isEnabled()) {
     return;
   }
 
-  // Ensure we have prepared buffers
-  if (nodeProgram == nullptr || edgeProgram == nullptr) {
-    prepare();
-  }
+  batch->update();
+  if (inBatch) {
+    if (batch->drawPass != internal::structureDrawPassCount) {
+      batch->drawPass = internal::structureDrawPassCount;
+      batch->draw(*this);
+    }
+  } else {
 
+    // Ensure we have prepared buffers
+    if (nodeProgram == nullptr || edgeProgram == nullptr) {
+      prepare();
+    }
 
-  // The camera frame geometry attributes depend on the scene length scale. If the length scale has changed, regenerate
-  // those attributes. (It would be better if we could implement the frame geometry in uniforms only, so we don't have
-  // to do this)
-  if (preparedLengthScale != state::lengthScale) {
-    fillCameraWidgetGeometry(nodeProgram.get(), edgeProgram.get(), nullptr);
-  }
+    // The camera frame geometry attributes depend on the scene length scale. If the length scale has changed,
+    // regenerate those attributes. (It would be better if we could implement the frame geometry in uniforms only, so
+    // we don't have to do this)
+    if (preparedLengthScale != state::lengthScale) {
+      fillCameraWidgetGeometry(nodeProgram.get(), edgeProgram.get(), nullptr);
+    }
 
-  // Set program uniforms
-  setStructureUniforms(*nodeProgram);
-  setStructureUniforms(*edgeProgram);
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  nodeProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  nodeProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
-  nodeProgram->setUniform("u_pointRadius", getWidgetFocalLength() * getWidgetThickness());
-  nodeProgram->setUniform("u_baseColor", widgetColor.get());
+    // Set program uniforms
+    setStructureUniforms(*nodeProgram);
+    setStructureUniforms(*edgeProgram);
+    nodeProgram->setUniform("u_pointRadius", getWidgetFocalLength() * getWidgetThickness());
+    nodeProgram->setUniform("u_baseColor", widgetColor.get());
 
 
-  edgeProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  edgeProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
-  edgeProgram->setUniform("u_radius", getWidgetFocalLength() * getWidgetThickness());
-  edgeProgram->setUniform("u_baseColor", widgetColor.get());
+    edgeProgram->setUniform("u_radius", getWidgetFocalLength() * getWidgetThickness());
+    edgeProgram->setUniform("u_baseColor", widgetColor.get());
 
-  // Draw the camera view wireframe
-  nodeProgram->draw();
-  edgeProgram->draw();
+    // Draw the camera view wireframe
+    nodeProgram->draw();
+    edgeProgram->draw();
+  }
 
   render::engine->applyTransparencySettings();
 
@@ -100,6 +385,15 @@ void CameraView::drawPick() {
     return;
   }
 
+  batch->update();
+  if (inBatch) {
+    if (batch->pickPass != internal::structureDrawPassCount) {
+      batch->pickPass = internal::structureDrawPassCount;
+      batch->drawPick(*this);
+    }
+    return;
+  }
+
   // Ensure we have prepared buffers
   if (pickFrameProgram == nullptr) {
     preparePick();
@@ -139,14 +433,18 @@ void CameraView::prepare() {
 }
 
 
-void CameraView::preparePick() {
-
+void CameraView::ensurePickRange() {
   // Request pick indices if we don't already have them
   if (pickStart == INVALID_IND) {
     size_t pickCount = 1;
     pickStart = pick::requestPickBufferRange(this, pickCount);
     pickColor = pick::indToVec(pickStart);
   }
+}
+
+void CameraView::preparePick() {
+
+  ensurePickRange();
 
   // Create a new pick program
   std::vector<std::string> rules = addStructureRules({"MESH_PROPAGATE_PICK_SIMPLE"});
@@ -158,13 +456,11 @@ void CameraView::preparePick() {
 }
 
 
-void CameraView::fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, render::ShaderProgram* edgeProgram,
-                                          render::ShaderProgram* pickFrameProgram) {
+std::array<glm::vec3, 8> CameraView::computeWidgetNodes() {
 
   // NOTE: this coullllld be done with uniforms, so we don't have to ever edit the geometry at all.
   // FOV slightly tricky though.
 
-
   // Camera frame geometry
   // NOTE: some of this is duplicated in getFrameBillboardGeometry()
   glm::vec3 root = params.getPosition();
@@ -186,33 +482,28 @@ void CameraView::fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, re
   glm::vec3 triangleRight = frameCenter + 1.2f * frameUp - 0.7f * frameLeft;
   glm::vec3 triangleTop = frameCenter + 2.f * frameUp;
 
+  return std::array<glm::vec3, 8>{{root, frameUpperLeft, frameUpperRight, frameLowerLeft, frameLowerRight,
+                                   triangleTop, triangleLeft, triangleRight}};
+}
+
+void CameraView::fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, render::ShaderProgram* edgeProgram,
+                                          render::ShaderProgram* pickFrameProgram) {
+
+  std::array<glm::vec3, 8> nodes = computeWidgetNodes();
+
   if (nodeProgram) {
-    std::vector<glm::vec3> allPos{root,        frameUpperLeft, frameUpperRight, frameLowerLeft, frameLowerRight,
-                                  triangleTop, triangleLeft,   triangleRight};
+    std::vector<glm::vec3> allPos(nodes.begin(), nodes.end());
     nodeProgram->setAttribute("a_position", allPos);
     preparedLengthScale = state::lengthScale;
   }
 
   if (edgeProgram) {
-    // Fill edges
-    std::vector<glm::vec3> posTail(11);
-    std::vector<glm::vec3> posTip(11);
-    auto addEdge = [&](glm::vec3 a, glm::vec3 b) {
-      posTail.push_back(a);
-      posTip.push_back(b);
-    };
-
-    addEdge(root, frameUpperLeft);
-    addEdge(root, frameUpperRight);
-    addEdge(root, frameLowerLeft);
-    addEdge(root, frameLowerRight);
-    addEdge(frameUpperLeft, frameUpperRight);
-    addEdge(frameUpperRight, frameLowerRight);
-    addEdge(frameLowerRight, frameLowerLeft);
-    addEdge(frameLowerLeft, frameUpperLeft);
-    addEdge(triangleLeft, triangleRight);
-    addEdge(triangleRight, triangleTop);
-    addEdge(triangleTop, triangleLeft);
+    std::vector<glm::vec3> posTail;
+    std::vector<glm::vec3> posTip;
+    for (const std::array<size_t, 2>& e : widgetEdges) {
+      posTail.push_back(nodes[e[0]]);
+      posTip.push_back(nodes[e[1]]);
+    }
 
     edgeProgram->setAttribute("a_position_tail", posTail);
     edgeProgram->setAttribute("a_position_tip", posTip);
@@ -221,56 +512,21 @@ void CameraView::fillCameraWidgetGeometry(render::ShaderProgram* nodeProgram, re
   if (pickFrameProgram) {
 
     std::vector<glm::vec3> positions;
-    std::vector<glm::vec3> normals;
     std::vector<glm::vec3> bcoord;
     std::vector<glm::vec3> cullPos;
-
-    auto addPolygon = [&](std::vector<glm::vec3> vertices) {
-      size_t D = vertices.size();
-
-      // implicitly triangulate from root
-      glm::vec3 pRoot = vertices[0];
-      for (size_t j = 1; (j + 1) < D; j++) {
-        glm::vec3 pB = vertices[j];
-        glm::vec3 pC = vertices[(j + 1) % D];
-        glm::vec3 faceN = glm::cross(pB - pRoot, pC - pRoot);
-
-        // Vertex positions
-        positions.push_back(pRoot);
-        positions.push_back(pB);
-        positions.push_back(pC);
-
-        // Face normals
-        normals.push_back(faceN);
-        normals.push_back(faceN);
-        normals.push_back(faceN);
-
-        // Bary coords
-        bcoord.push_back(glm::vec3{1., 0., 0.});
-        bcoord.push_back(glm::vec3{0., 1., 0.});
-        bcoord.push_back(glm::vec3{0., 0., 1.});
-
-        // Cull position
-        cullPos.push_back(root);
-        cullPos.push_back(root);
-        cullPos.push_back(root);
+    for (const std::array<size_t, 3>& t : widgetPickTriangles) {
+      for (size_t k = 0; k < 3; k++) {
+        positions.push_back(nodes[t[k]]);
+        bcoord.push_back(glm::vec3(k == 0, k == 1, k == 2));
+        cullPos.push_back(nodes[0]);
       }
-
-      pickPreparedLengthScale = state::lengthScale;
-    };
-
-    addPolygon({root, frameUpperRight, frameUpperLeft});
-    addPolygon({root, frameLowerRight, frameUpperRight});
-    addPolygon({root, frameLowerLeft, frameLowerRight});
-    addPolygon({root, frameUpperLeft, frameLowerLeft});
-    addPolygon({frameUpperLeft, frameUpperRight, frameLowerRight, frameLowerLeft});
-    addPolygon({triangleTop, triangleRight, triangleLeft});
+    }
+    pickPreparedLengthScale = state::lengthScale;
 
     pickFrameProgram->setAttribute("a_vertexPositions", positions);
-    // pickFrameProgram->setAttribute("a_vertexNormals", normals); // unused
     pickFrameProgram->setAttribute("a_barycoord", bcoord);
 
-    size_t nFaces = 7;
+    size_t nFaces = widgetPickTriangles.size();
     std::vector<glm::vec3> faceColor(3 * nFaces, pickColor);
     std::vector<std::array<glm::vec3, 3>> tripleColors(3 * nFaces,
                                                        std::array<glm::vec3, 3>{pickColor, pickColor, pickColor});
@@ -288,6 +544,8 @@ void CameraView::updateCameraParameters(const CameraParameters& newParams) {
 }
 
 void CameraView::geometryChanged() {
+  batch->version++;
+
   // if the programs are populated, repopulate them
   if (nodeProgram) {
     fillCameraWidgetGeometry(nodeProgram.get(), edgeProgram.get(), nullptr);
@@ -385,6 +643,7 @@ void CameraView::refresh() {
   nodeProgram.reset();
   edgeProgram.reset();
   pickFrameProgram.reset();
+  batch->refresh();
   QuantityStructure<CameraView>::refresh(); // call base class version, which refreshes quantities
 }
 
@@ -415,14 +674,14 @@ CameraParameters CameraView::getCameraParameters() const { return params; }
 CameraView* CameraView::setWidgetFocalLength(float newVal, bool isRelative) {
   widgetFocalLength = ScaledValue<float>(newVal, isRelative);
   geometryChanged();
-  polyscope::requestRedraw();
+  requestRedraw();
   return this;
 }
 float CameraView::getWidgetFocalLength() { return widgetFocalLength.get().asAbsolute(); }
 
 CameraView* CameraView::setWidgetThickness(float newVal) {
   widgetThickness = newVal;
-  polyscope::requestRedraw();
+  requestRedraw();
   return this;
 }
 float CameraView::getWidgetThickness() { return widgetThickness.get(); }
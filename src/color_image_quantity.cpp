@@ -13,7 +13,7 @@ namespace polyscope {
 
 ColorImageQuantity::ColorImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY,
                                        const std::vector<glm::vec4>& data_, ImageOrigin imageOrigin_)
-    : ImageQuantity(parent_, name, dimX, dimY, imageOrigin_), data(data_) {}
+    : ImageQuantity(parent_, name, dimX, dimY, imageOrigin_, TextureFormat::RGBA32F), data(data_) {}
 
 
 void ColorImageQuantity::buildCustomUI() {
@@ -35,17 +35,29 @@ void ColorImageQuantity::buildCustomUI() {
 
 std::string ColorImageQuantity::niceName() { return name + " (color image)"; }
 
-void ColorImageQuantity::ensureRawTexturePopulated() {
-  if (textureRaw) return; // already populated, nothing to do
+bool ColorImageQuantity::ensureRawTexturePopulated() {
+  if (textureRaw) return true; // already populated, nothing to do
+  if (!acquireTextureUpload()) return false;
 
   // Must be rendering from a buffer of data, copy it over (common case)
 
-  textureRaw = render::engine->generateTextureBuffer(TextureFormat::RGBA32F, dimX, dimY, &(data.front()[0]));
+  // (the data is converted to the storage format during the upload)
+  textureRaw = render::engine->generateTextureBuffer(textureFormat, dimX, dimY, &(data.front()[0]));
+  textureRaw->setMemoryOwner(uniquePrefix() + "textureRaw");
+  return true;
 }
 
-void ColorImageQuantity::prepareFullscreen() {
+bool ColorImageQuantity::textureFormatSupported(TextureFormat format) {
+  return format == TextureFormat::RGBA8 || format == TextureFormat::RGBA16F || format == TextureFormat::RGBA32F;
+}
+
+void ColorImageQuantity::releaseTextures() {
+  fullscreenProgram.reset();
+  billboardProgram.reset();
+  textureRaw.reset();
+}
 
-  ensureRawTexturePopulated();
+void ColorImageQuantity::prepareFullscreen() {
 
   // Create the sourceProgram
   fullscreenProgram =
@@ -57,8 +69,6 @@ void ColorImageQuantity::prepareFullscreen() {
 
 void ColorImageQuantity::prepareBillboard() {
 
-  ensureRawTexturePopulated();
-
   // Create the sourceProgram
   billboardProgram = render::engine->requestShader(
       "TEXTURE_DRAW_PLAIN",
@@ -70,6 +80,7 @@ void ColorImageQuantity::prepareBillboard() {
 
 void ColorImageQuantity::showFullscreen() {
 
+  if (!ensureRawTexturePopulated()) return;
   if (!fullscreenProgram) {
     prepareFullscreen();
   }
@@ -84,8 +95,8 @@ void ColorImageQuantity::showFullscreen() {
 
 
 void ColorImageQuantity::showInImGuiWindow() {
+  if (!ensureRawTexturePopulated()) return;
   if (!fullscreenProgram) prepareFullscreen();
-  ensureRawTexturePopulated();
 
   ImGui::Begin(name.c_str(), nullptr, ImGuiWindowFlags_NoScrollbar);
 
@@ -106,6 +117,7 @@ void ColorImageQuantity::showInImGuiWindow() {
 
 void ColorImageQuantity::showInBillboard(glm::vec3 center, glm::vec3 upVec, glm::vec3 rightVec) {
 
+  if (!ensureRawTexturePopulated()) return;
   if (!billboardProgram) {
     prepareBillboard();
   }
@@ -66,6 +66,19 @@ int iUniqueColor = 0;
 
 glm::vec3 getNextUniqueColor() { return indexOffsetHue(uniqueColorBase, iUniqueColor++); }
 
+glm::vec3 getIndexedDistinctColor(int index) { return indexOffsetHue(uniqueColorBase, index); }
+
+uint32_t packColorRGBA8(glm::vec3 color) {
+  glm::vec3 c = unitClamp(color) * 255.f + 0.5f;
+  return packColorRGBA8(static_cast<uint8_t>(c.x), static_cast<uint8_t>(c.y), static_cast<uint8_t>(c.z));
+}
+
+glm::vec3 unpackColorRGBA8(uint32_t packed) {
+  return glm::vec3{static_cast<float>(packed & 0xFF), static_cast<float>((packed >> 8) & 0xFF),
+                   static_cast<float>((packed >> 16) & 0xFF)} /
+         255.f;
+}
+
 glm::vec3 RGBtoHSV(glm::vec3 rgb) {
   glm::vec3 hsv;
   ImGui::ColorConvertRGBtoHSV(rgb[0], rgb[1], rgb[2], hsv[0], hsv[1], hsv[2]);
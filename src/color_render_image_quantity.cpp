@@ -25,12 +25,6 @@ void ColorRenderImageQuantity::drawDelayed() {
   if (!program) prepare();
 
   // set uniforms
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-
-  program->setUniform("u_projMatrix", glm::value_ptr(P));
-  program->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  program->setUniform("u_viewport", render::engine->getCurrentViewport());
   program->setUniform("u_transparency", transparency.get());
 
   // make sure we have actual depth testing enabled
@@ -73,6 +67,7 @@ void ColorRenderImageQuantity::prepare() {
   static_assert(sizeof(glm::vec3) == sizeof(float) * 3, "glm vec padding breaks direct copy");
   textureColor = render::engine->generateTextureBuffer(TextureFormat::RGB32F, dimX, dimY,
                                                        static_cast<float*>(&colorData.front()[0]));
+  textureColor->setMemoryOwner(uniquePrefix() + "textureColor");
 
   // Create the sourceProgram
   program = render::engine->requestShader("TEXTURE_DRAW_RENDERIMAGE_PLAIN",
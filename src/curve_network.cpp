@@ -2,20 +2,56 @@
 
 #include "polyscope/curve_network.h"
 
+#include "polyscope/internal.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
 #include "imgui.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
 
 namespace polyscope {
 
 // Initialize statics
 const std::string CurveNetwork::structureTypeName = "Curve Network";
 
+namespace {
+
+// Edges between consecutive nodes along each strip, numbered strip by strip
+std::vector<std::array<size_t, 2>> stripOffsetsToEdges(const std::string& name, const std::vector<size_t>& stripOffsets) {
+  if (stripOffsets.empty() || stripOffsets.front() != 0) {
+    exception("CurveNetwork [" + name + "] strip offsets must be non-empty and start at 0");
+  }
+
+  std::vector<std::array<size_t, 2>> edges;
+  for (size_t iS = 0; iS + 1 < stripOffsets.size(); iS++) {
+    size_t start = stripOffsets[iS];
+    size_t end = stripOffsets[iS + 1];
+    if (end < start) {
+      exception("CurveNetwork [" + name + "] strip offsets must be non-decreasing, but strip " + std::to_string(iS) +
+                " has offsets { " + std::to_string(start) + " , " + std::to_string(end) + " }");
+    }
+    for (size_t iN = start; iN + 1 < end; iN++) {
+      edges.push_back({iN, iN + 1});
+    }
+  }
+  return edges;
+}
+
+float pointSegmentDistance(glm::vec3 p, glm::vec3 a, glm::vec3 b) {
+  glm::vec3 d = b - a;
+  float len2 = glm::dot(d, d);
+  float t = len2 > 0.f ? glm::clamp(glm::dot(p - a, d) / len2, 0.f, 1.f) : 0.f;
+  return glm::length(p - (a + t * d));
+}
+
+} // namespace
+
 // Constructor
 CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std::vector<std::array<size_t, 2>> edges_)
     : // clang-format off
@@ -24,10 +60,19 @@ CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std:
       edgeTailInds(uniquePrefix() + "edgeTailInds", edgeTailIndsData),
       edgeTipInds(uniquePrefix() + "edgeTipInds", edgeTipIndsData),
       edgeCenters(uniquePrefix() + "edgeCenters", edgeCentersData, std::bind(&CurveNetwork::computeEdgeCenters, this)),         
+      stripNodeEdgeInds(uniquePrefix() + "stripNodeEdgeInds", stripNodeEdgeIndsData, std::bind(&CurveNetwork::computeStripNodeEdgeInds, this)),
+      edgeNodeInds(uniquePrefix() + "edgeNodeInds", edgeNodeIndsData, std::bind(&CurveNetwork::computeEdgeNodeInds, this)),
+      stripDrawInds(uniquePrefix() + "stripDrawInds", stripDrawIndsData, std::bind(&CurveNetwork::computeStripDrawInds, this)),
       nodePositionsData(std::move(nodes_)), 
+      nodeVisibleSubsetMask(uniquePrefix() + "nodeVisibleSubsetMask", nodeVisibleSubsetMaskData),
+      nodeHighlightedSubsetMask(uniquePrefix() + "nodeHighlightedSubsetMask", nodeHighlightedSubsetMaskData),
       color(uniquePrefix() + "#color", getNextUniqueColor()), 
       radius(uniquePrefix() + "#radius", relativeValue(0.005)),
-      material(uniquePrefix() + "#material", "clay")
+      material(uniquePrefix() + "#material", "clay"),
+      instancedDrawing(uniquePrefix() + "#instancedDrawing", false),
+      depthPrepass(uniquePrefix() + "#depthPrepass", false),
+      lodEnabled(uniquePrefix() + "#lodEnabled", false),
+      lodPixelTolerance(uniquePrefix() + "#lodPixelTolerance", 0.5)
 // clang-format on
 {
 
@@ -62,6 +107,16 @@ CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std:
   updateObjectSpaceBounds();
 }
 
+CurveNetwork::CurveNetwork(std::string name, std::vector<glm::vec3> nodes_, std::vector<size_t> stripOffsets_)
+    : CurveNetwork(name, std::move(nodes_), stripOffsetsToEdges(name, stripOffsets_)) {
+
+  if (stripOffsets_.back() != nNodes()) {
+    exception("CurveNetwork [" + name + "] last strip offset is " + std::to_string(stripOffsets_.back()) +
+              " but there are " + std::to_string(nNodes()) + " nodes.");
+  }
+  stripOffsets = std::move(stripOffsets_);
+}
+
 float CurveNetwork::computeRadiusMultiplierUniform() {
   if (nodeRadiusQuantityName != "" && !nodeRadiusQuantityAutoscale) {
     // special case: ignore radius uniform
@@ -81,19 +136,17 @@ float CurveNetwork::computeRadiusMultiplierUniform() {
 
 // Helper to set uniforms
 void CurveNetwork::setCurveNetworkNodeUniforms(render::ShaderProgram& p) {
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  p.setUniform("u_viewport", render::engine->getCurrentViewport());
   p.setUniform("u_pointRadius", computeRadiusMultiplierUniform());
+  if (drawsInstanced()) {
+    p.setInstanceCount(static_cast<uint32_t>(nNodes()));
+  }
 }
 
 void CurveNetwork::setCurveNetworkEdgeUniforms(render::ShaderProgram& p) {
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  p.setUniform("u_viewport", render::engine->getCurrentViewport());
   p.setUniform("u_radius", computeRadiusMultiplierUniform());
+  if (drawsInstanced()) {
+    p.setInstanceCount(static_cast<uint32_t>(nEdges()));
+  }
 }
 
 void CurveNetwork::draw() {
@@ -101,6 +154,20 @@ void CurveNetwork::draw() {
     return;
   }
 
+  if (isPolylineStrips() && getLODEnabled()) {
+    updateLOD();
+  }
+
+  // Lay down the depth of the tubes first, so that the shading below only runs for the visible fragment of each pixel
+  // (not with transparency, which needs the fragments behind too)
+  bool prepass = getDepthPrepass() && render::engine->getTransparencyMode() == TransparencyMode::None;
+  if (prepass) {
+    render::engine->setColorMask({false, false, false, false});
+    drawPickPrograms();
+    render::engine->setColorMask();
+    render::engine->setDepthMode(DepthMode::LEqual);
+  }
+
   // If there is no dominant quantity, then this class is responsible for drawing points
   if (dominantQuantity == nullptr) {
 
@@ -119,9 +186,11 @@ void CurveNetwork::draw() {
     edgeProgram->setUniform("u_baseColor", getColor());
     nodeProgram->setUniform("u_baseColor", getColor());
 
-    // Draw the actual curve network
+    // Draw the actual curve network (strips are continuous tubes, with no spheres at the nodes)
     edgeProgram->draw();
-    nodeProgram->draw();
+    if (!isPolylineStrips()) {
+      nodeProgram->draw();
+    }
   }
 
   // Draw the quantities
@@ -131,6 +200,8 @@ void CurveNetwork::draw() {
   for (auto& x : floatingQuantities) {
     x.second->draw();
   }
+
+  if (prepass) render::engine->setDepthMode();
 }
 
 void CurveNetwork::drawDelayed() {
@@ -151,6 +222,14 @@ void CurveNetwork::drawPick() {
     return;
   }
 
+  drawPickPrograms();
+}
+
+void CurveNetwork::drawPickPrograms() {
+  if (isPolylineStrips() && getLODEnabled()) {
+    updateLOD();
+  }
+
   // Ensure we have prepared buffers
   if (edgePickProgram == nullptr || nodePickProgram == nullptr) {
     preparePick();
@@ -164,9 +243,30 @@ void CurveNetwork::drawPick() {
   setCurveNetworkNodeUniforms(*nodePickProgram);
 
   edgePickProgram->draw();
-  nodePickProgram->draw();
+  if (!isPolylineStrips()) {
+    nodePickProgram->draw();
+  }
+}
+
+std::vector<std::string> CurveNetwork::toInstancedRules(std::vector<std::string> rules) {
+  if (!drawsInstanced()) return rules;
+
+  // The instanced programs have no geometry shader, so rules which pass data through one have their own versions.
+  // Indexed and expanded edge data both end up per-instance.
+  const std::string cylIndexed = "CYLINDER_INDEXED_";
+  for (std::string& rule : rules) {
+    if (rule.find("SPHERE_PROPAGATE_") == 0 || rule == "SPHERE_VARIABLE_SIZE") {
+      rule += "_INSTANCED";
+    } else if (rule.find(cylIndexed) == 0) {
+      rule = "CYLINDER_" + rule.substr(cylIndexed.size()) + "_INSTANCED";
+    } else if (rule.find("CYLINDER_") == 0 && rule != "CYLINDER_CULLPOS_FROM_MID") {
+      rule += "_INSTANCED";
+    }
+  }
+  return rules;
 }
 
+std::string CurveNetwork::nodeProgramName() { return drawsInstanced() ? "RAYCAST_SPHERE_INSTANCED" : "RAYCAST_SPHERE"; }
 std::vector<std::string> CurveNetwork::addCurveNetworkNodeRules(std::vector<std::string> initRules) {
   initRules = addStructureRules(initRules);
 
@@ -176,11 +276,34 @@ std::vector<std::string> CurveNetwork::addCurveNetworkNodeRules(std::vector<std:
   if (wantsCullPosition()) {
     initRules.push_back("SPHERE_CULLPOS_FROM_CENTER");
   }
-  return initRules;
+  initRules = addSubsetRules(initRules, "SPHERE_PROPAGATE_SUBSET_INDEX");
+  return toInstancedRules(initRules);
 }
 std::vector<std::string> CurveNetwork::addCurveNetworkEdgeRules(std::vector<std::string> initRules) {
   initRules = addStructureRules(initRules);
 
+  // use node radius to blend cylinder radius
+  if (nodeRadiusQuantityName != "") {
+    initRules.push_back(isPolylineStrips() ? "TUBE_VARIABLE_SIZE" : "CYLINDER_INDEXED_VARIABLE_SIZE");
+  }
+
+  if (wantsCullPosition()) {
+    initRules.push_back(isPolylineStrips() ? "TUBE_CULLPOS_FROM_MID" : "CYLINDER_CULLPOS_FROM_MID");
+  }
+  initRules = addSubsetRules(initRules, isPolylineStrips() ? "TUBE_PROPAGATE_SUBSET_INDEX"
+                                                           : "CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX");
+  return toInstancedRules(initRules);
+}
+std::string CurveNetwork::edgeProgramName() {
+  if (isPolylineStrips()) return "RIBBON_TUBE";
+  return drawsInstanced() ? "RAYCAST_CYLINDER_INSTANCED" : "RAYCAST_CYLINDER_INDEXED";
+}
+std::string CurveNetwork::expandedEdgeProgramName() {
+  return drawsInstanced() ? "RAYCAST_CYLINDER_INSTANCED" : "RAYCAST_CYLINDER";
+}
+std::vector<std::string> CurveNetwork::addCurveNetworkExpandedEdgeRules(std::vector<std::string> initRules) {
+  initRules = addStructureRules(initRules);
+
   // use node radius to blend cylinder radius
   if (nodeRadiusQuantityName != "") {
     initRules.push_back("CYLINDER_VARIABLE_SIZE");
@@ -189,7 +312,8 @@ std::vector<std::string> CurveNetwork::addCurveNetworkEdgeRules(std::vector<std:
   if (wantsCullPosition()) {
     initRules.push_back("CYLINDER_CULLPOS_FROM_MID");
   }
-  return initRules;
+  initRules = addSubsetRules(initRules, "CYLINDER_PROPAGATE_SUBSET_INDEX");
+  return toInstancedRules(initRules);
 }
 
 void CurveNetwork::prepare() {
@@ -200,12 +324,12 @@ void CurveNetwork::prepare() {
   // It no quantity is coloring the network, draw with a default color
 
   {
-    nodeProgram = render::engine->requestShader("RAYCAST_SPHERE", addCurveNetworkNodeRules({"SHADE_BASECOLOR"}));
+    nodeProgram = render::engine->requestShader(nodeProgramName(), addCurveNetworkNodeRules({"SHADE_BASECOLOR"}));
     render::engine->setMaterial(*nodeProgram, getMaterial());
   }
 
   {
-    edgeProgram = render::engine->requestShader("RAYCAST_CYLINDER", addCurveNetworkEdgeRules({"SHADE_BASECOLOR"}));
+    edgeProgram = render::engine->requestShader(edgeProgramName(), addCurveNetworkEdgeRules({"SHADE_BASECOLOR"}));
     render::engine->setMaterial(*edgeProgram, getMaterial());
   }
 
@@ -215,8 +339,6 @@ void CurveNetwork::prepare() {
 }
 
 void CurveNetwork::preparePick() {
-  edgeTailInds.ensureHostBufferPopulated();
-  edgeTipInds.ensureHostBufferPopulated();
 
   // Pick index layout (local indices):
   //   |     --- nodes ---     |      --- edges ---      |
@@ -227,50 +349,33 @@ void CurveNetwork::preparePick() {
   size_t totalPickElements = nNodes() + nEdges();
   size_t pickStart = pick::requestPickBufferRange(this, totalPickElements);
 
+  // Pick colors are computed in the shaders from the node and edge indices
   { // Set up node picking program
     nodePickProgram =
-        render::engine->requestShader("RAYCAST_SPHERE", addCurveNetworkNodeRules({"SPHERE_PROPAGATE_COLOR"}),
+        render::engine->requestShader(nodeProgramName(),
+                                      removeSubsetHighlightRules(addCurveNetworkNodeRules({"SPHERE_PROPAGATE_PICK"})),
                                       render::ShaderReplacementDefaults::Pick);
-
-    // Fill color buffer with packed point indices
-    std::vector<glm::vec3> pickColors;
-    pickColors.reserve(nNodes());
-    for (size_t i = pickStart; i < pickStart + nNodes(); i++) {
-      glm::vec3 val = pick::indToVec(i);
-      pickColors.push_back(pick::indToVec(i));
-    }
-
-    // Store data in buffers
-    nodePickProgram->setAttribute("a_color", pickColors);
+    nodePickProgram->setMemoryOwner(uniquePrefix() + "nodePick");
+    nodePickProgram->setUniform("u_pickStart", pick::indToDigits(pickStart));
 
     fillNodeGeometryBuffers(*nodePickProgram);
   }
 
   { // Set up edge picking program
+    std::string pickRule = isPolylineStrips() ? "TUBE_PROPAGATE_PICK" : "CYLINDER_INDEXED_PROPAGATE_PICK";
+    std::vector<std::string> rules = removeSubsetHighlightRules(addCurveNetworkEdgeRules({pickRule}));
     edgePickProgram =
-        render::engine->requestShader("RAYCAST_CYLINDER", addCurveNetworkEdgeRules({"CYLINDER_PROPAGATE_PICK"}),
-                                      render::ShaderReplacementDefaults::Pick);
-
-    // Fill color buffer with packed node/edge indices
-    std::vector<glm::vec3> edgePickTail(nEdges());
-    std::vector<glm::vec3> edgePickTip(nEdges());
-    std::vector<glm::vec3> edgePickEdge(nEdges());
-
-    // Fill posiiton and pick index buffers
-    for (size_t iE = 0; iE < nEdges(); iE++) {
-      size_t eTail = edgeTailInds.data[iE];
-      size_t eTip = edgeTipInds.data[iE];
-
-      glm::vec3 colorValTail = pick::indToVec(pickStart + eTail);
-      glm::vec3 colorValTip = pick::indToVec(pickStart + eTip);
-      glm::vec3 colorValEdge = pick::indToVec(pickStart + nNodes() + iE);
-      edgePickTail[iE] = colorValTail;
-      edgePickTip[iE] = colorValTip;
-      edgePickEdge[iE] = colorValEdge;
+        render::engine->requestShader(edgeProgramName(), rules, render::ShaderReplacementDefaults::Pick);
+    edgePickProgram->setMemoryOwner(uniquePrefix() + "edgePick");
+    edgePickProgram->setUniform("u_pickStart", pick::indToDigits(pickStart));
+    edgePickProgram->setUniform("u_edgePickStart", pick::indToDigits(pickStart + nNodes()));
+    if (isPolylineStrips()) {
+      edgePickProgram->setAttribute("a_nodeEdgeInd", stripNodeEdgeInds.getRenderAttributeBuffer());
+    }
+    if (drawsInstanced()) {
+      edgePickProgram->setAttribute("a_tailInd", edgeTailInds.getRenderAttributeBuffer());
+      edgePickProgram->setAttribute("a_tipInd", edgeTipInds.getRenderAttributeBuffer());
     }
-    edgePickProgram->setAttribute("a_color_tail", edgePickTail);
-    edgePickProgram->setAttribute("a_color_tip", edgePickTip);
-    edgePickProgram->setAttribute("a_color_edge", edgePickEdge);
 
     fillEdgeGeometryBuffers(*edgePickProgram);
   }
@@ -283,9 +388,55 @@ void CurveNetwork::fillNodeGeometryBuffers(render::ShaderProgram& program) {
     CurveNetworkNodeScalarQuantity& nodeRadQ = resolveNodeRadiusQuantity();
     program.setAttribute("a_pointRadius", nodeRadQ.values.getRenderAttributeBuffer());
   }
+
+  // The nodes have their own masks (see subsetMasksChanged()), bound here before the structure would bind the edge ones
+  if (program.hasTexture("t_visibleSubset")) {
+    program.setTextureFromAttributeBuffer("t_visibleSubset", nodeVisibleSubsetMask.getRenderAttributeBuffer());
+  }
+  if (program.hasTexture("t_highlightedSubset")) {
+    program.setTextureFromAttributeBuffer("t_highlightedSubset", nodeHighlightedSubsetMask.getRenderAttributeBuffer());
+  }
+
+  if (drawsInstanced()) {
+    // The two triangles of the quad are the only per-vertex data; everything per-node advances once per instance
+    // (including attributes the quantities set after this).
+    std::vector<glm::vec2> quadCorners = {{-1., -1.}, {1., -1.}, {-1., 1.}, {-1., 1.}, {1., -1.}, {1., 1.}};
+    program.setAttribute("a_quadCorner", quadCorners);
+    for (const char* attr : {"a_position", "a_pointRadius", "a_value", "a_color"}) {
+      if (program.hasAttribute(attr)) program.setAttributePerInstance(attr);
+    }
+  }
 }
 
 void CurveNetwork::fillEdgeGeometryBuffers(render::ShaderProgram& program) {
+  if (drawsInstanced()) {
+    fillExpandedEdgeGeometryBuffers(program);
+    return;
+  }
+
+  // Edges are drawn as indexed lines over the node buffers, so the only per-edge data is the index buffer
+  program.setAttribute("a_position", nodePositions.getRenderAttributeBuffer());
+
+  if (nodeRadiusQuantityName != "") {
+    CurveNetworkNodeScalarQuantity& nodeRadQ = resolveNodeRadiusQuantity();
+    program.setAttribute("a_nodeRadius", nodeRadQ.values.getRenderAttributeBuffer());
+  }
+
+  if (isPolylineStrips()) {
+    if (program.hasAttribute("a_subsetIndex")) {
+      program.setAttribute("a_subsetIndex", stripNodeEdgeInds.getRenderAttributeBuffer());
+    }
+    // (drawn from the managed buffer, so changing the level of detail updates every program)
+    program.setPrimitiveRestartIndex(std::numeric_limits<uint32_t>::max());
+    program.setIndex(stripDrawInds.getRenderAttributeBuffer());
+    return;
+  }
+
+  // (drawn from the managed buffer, so appending edges extends the index without re-filling the program)
+  program.setIndex(edgeNodeInds.getRenderAttributeBuffer());
+}
+
+void CurveNetwork::fillExpandedEdgeGeometryBuffers(render::ShaderProgram& program) {
   program.setAttribute("a_position_tail", nodePositions.getIndexedRenderAttributeBuffer(edgeTailInds));
   program.setAttribute("a_position_tip", nodePositions.getIndexedRenderAttributeBuffer(edgeTipInds));
 
@@ -294,6 +445,38 @@ void CurveNetwork::fillEdgeGeometryBuffers(render::ShaderProgram& program) {
     program.setAttribute("a_tailRadius", nodeRadQ.values.getIndexedRenderAttributeBuffer(edgeTailInds));
     program.setAttribute("a_tipRadius", nodeRadQ.values.getIndexedRenderAttributeBuffer(edgeTipInds));
   }
+
+  if (drawsInstanced()) {
+    // The 12 triangles of the edge's bounding box (the same strip as the geometry shader), as (x, y) in the
+    // cross-section and 0 / 1 for the tail / tip end
+    const std::array<glm::vec3, 14> strip = {{{-1., 1., 1.},
+                                              {1., 1., 1.},
+                                              {-1., -1., 1.},
+                                              {1., -1., 1.},
+                                              {1., -1., 0.},
+                                              {1., 1., 1.},
+                                              {1., 1., 0.},
+                                              {-1., 1., 1.},
+                                              {-1., 1., 0.},
+                                              {-1., -1., 1.},
+                                              {-1., -1., 0.},
+                                              {1., -1., 0.},
+                                              {-1., 1., 0.},
+                                              {1., 1., 0.}}};
+    std::vector<glm::vec3> boxCorners;
+    for (size_t i = 0; i + 2 < strip.size(); i++) {
+      // (flip every other triangle, as a strip does, to keep the winding consistent)
+      size_t a = (i % 2 == 0) ? i : i + 1;
+      size_t b = (i % 2 == 0) ? i + 1 : i;
+      boxCorners.insert(boxCorners.end(), {strip[a], strip[b], strip[i + 2]});
+    }
+    program.setAttribute("a_boxCorner", boxCorners);
+    for (const char* attr : {"a_position_tail", "a_position_tip", "a_tailRadius", "a_tipRadius", "a_value",
+                             "a_value_tail", "a_value_tip", "a_color", "a_color_tail", "a_color_tip", "a_tailInd",
+                             "a_tipInd"}) {
+      if (program.hasAttribute(attr)) program.setAttributePerInstance(attr);
+    }
+  }
 }
 
 void CurveNetwork::computeEdgeCenters() {
@@ -313,8 +496,318 @@ void CurveNetwork::computeEdgeCenters() {
   edgeCenters.markHostBufferUpdated();
 }
 
+void CurveNetwork::computeEdgeNodeInds() {
+  edgeTailInds.ensureHostBufferPopulated();
+  edgeTipInds.ensureHostBufferPopulated();
+
+  edgeNodeInds.data.resize(2 * nEdges());
+  for (size_t iE = 0; iE < nEdges(); iE++) {
+    edgeNodeInds.data[2 * iE + 0] = edgeTailInds.data[iE];
+    edgeNodeInds.data[2 * iE + 1] = edgeTipInds.data[iE];
+  }
+
+  edgeNodeInds.markHostBufferUpdated();
+}
+
+void CurveNetwork::computeStripDrawInds() {
+  // One line strip per strip, with the end nodes repeated as their own adjacent nodes. With LOD, each chunk of a strip
+  // contributes the nodes of its current level.
+  const uint32_t restartInd = std::numeric_limits<uint32_t>::max();
+  bool useLOD = lodChunkLevels.size() == lodChunkNodes.size() && !lodChunkNodes.empty();
+  size_t nChunks = lodChunkNodes.size();
+  size_t nLevels = lodLevelTolerances.size();
+
+  std::vector<uint32_t>& inds = stripDrawInds.data;
+  inds.clear();
+  inds.reserve((useLOD ? 0 : nNodes()) + 4 * nStrips());
+  lodDrawSegmentCount = 0;
+  for (size_t iS = 0; iS < nStrips(); iS++) {
+    size_t start = stripOffsets[iS];
+    size_t end = stripOffsets[iS + 1];
+    if (end - start < 2) continue;
+    inds.push_back(start);
+    size_t stripStart = inds.size();
+    if (useLOD) {
+      for (size_t iC = lodStripChunks[iS]; iC < lodStripChunks[iS + 1]; iC++) {
+        size_t level = lodChunkLevels[iC];
+        if (level == nLevels) {
+          for (size_t iN = lodChunkNodes[iC][0]; iN < lodChunkNodes[iC][1]; iN++) inds.push_back(iN);
+        } else {
+          const size_t* offsets = &lodLevelOffsets[level * (nChunks + 1)];
+          inds.insert(inds.end(), lodLevelNodes.begin() + offsets[iC], lodLevelNodes.begin() + offsets[iC + 1]);
+        }
+      }
+    } else {
+      for (size_t iN = start; iN + 1 < end; iN++) inds.push_back(iN);
+    }
+    inds.push_back(end - 1);
+    lodDrawSegmentCount += inds.size() - stripStart - 1;
+    inds.push_back(end - 1);
+    inds.push_back(restartInd);
+  }
+
+  stripDrawInds.markHostBufferUpdated();
+}
+
+void CurveNetwork::ensureHaveLOD() {
+  if (lodBuilt) return;
+  lodBuilt = true;
+
+  nodePositions.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = nodePositions.data;
+
+  // Split the strips in to chunks, which share their end nodes
+  lodStripChunks.assign(1, 0);
+  lodChunkNodes.clear();
+  for (size_t iS = 0; iS < nStrips(); iS++) {
+    size_t start = stripOffsets[iS];
+    size_t end = stripOffsets[iS + 1];
+    for (size_t a = start; a + 1 < end; a += lodChunkEdges) {
+      lodChunkNodes.push_back({static_cast<uint32_t>(a), static_cast<uint32_t>(std::min(a + lodChunkEdges, end - 1))});
+    }
+    lodStripChunks.push_back(lodChunkNodes.size());
+  }
+  size_t nChunks = lodChunkNodes.size();
+
+  // The error of each node is its distance from the segment it splits in the Douglas-Peucker hierarchy, clamped to be
+  // no more than that of the node which split the segment before, so that the nodes above any tolerance are a prefix
+  // of the hierarchy. The ends of the chunks are always kept.
+  std::vector<float> nodeError(nNodes(), std::numeric_limits<float>::infinity());
+  lodChunkBounds.resize(nChunks);
+  parallelFor(
+      0, nChunks,
+      [&](size_t blockStart, size_t blockEnd) {
+        struct Span {
+          uint32_t a, b;
+          float error;
+        };
+        std::vector<Span> stack;
+        for (size_t iC = blockStart; iC < blockEnd; iC++) {
+          uint32_t first = lodChunkNodes[iC][0];
+          uint32_t last = lodChunkNodes[iC][1];
+
+          glm::vec3 bMin = pos[first];
+          glm::vec3 bMax = pos[first];
+          for (uint32_t iN = first; iN <= last; iN++) {
+            bMin = glm::min(bMin, pos[iN]);
+            bMax = glm::max(bMax, pos[iN]);
+          }
+          lodChunkBounds[iC] = glm::vec4(0.5f * (bMin + bMax), 0.5f * glm::length(bMax - bMin));
+
+          stack.push_back(Span{first, last, std::numeric_limits<float>::infinity()});
+          while (!stack.empty()) {
+            Span s = stack.back();
+            stack.pop_back();
+            if (s.b - s.a < 2) continue;
+            uint32_t split = s.a + 1;
+            float maxDist = -1.f;
+            for (uint32_t iN = s.a + 1; iN < s.b; iN++) {
+              float d = pointSegmentDistance(pos[iN], pos[s.a], pos[s.b]);
+              if (d > maxDist) {
+                maxDist = d;
+                split = iN;
+              }
+            }
+            float error = std::min(maxDist, s.error);
+            nodeError[split] = error;
+            stack.push_back(Span{s.a, split, error});
+            stack.push_back(Span{split, s.b, error});
+          }
+        }
+      },
+      16);
+
+  // Levels at geometrically shrinking tolerances, until they are nearly as large as the full network
+  lodLevelTolerances.clear();
+  lodLevelOffsets.clear();
+  lodLevelNodes.clear();
+  const size_t maxLevels = 12;
+  float tolerance = 0.125f * objectSpaceLengthScale;
+  std::vector<size_t> counts(nChunks + 1);
+  for (size_t iL = 0; iL < maxLevels && tolerance > 0.f; iL++, tolerance *= 0.25f) {
+    parallelFor(
+        0, nChunks,
+        [&](size_t blockStart, size_t blockEnd) {
+          for (size_t iC = blockStart; iC < blockEnd; iC++) {
+            size_t count = 0;
+            for (uint32_t iN = lodChunkNodes[iC][0]; iN < lodChunkNodes[iC][1]; iN++) {
+              if (nodeError[iN] >= tolerance) count++;
+            }
+            counts[iC + 1] = count;
+          }
+        },
+        64);
+    size_t base = lodLevelNodes.size();
+    counts[0] = base;
+    for (size_t iC = 0; iC < nChunks; iC++) counts[iC + 1] += counts[iC];
+    if (2 * (counts[nChunks] - base) > nNodes()) break;
+
+    lodLevelOffsets.insert(lodLevelOffsets.end(), counts.begin(), counts.end());
+    lodLevelNodes.resize(counts[nChunks]);
+    parallelFor(
+        0, nChunks,
+        [&](size_t blockStart, size_t blockEnd) {
+          for (size_t iC = blockStart; iC < blockEnd; iC++) {
+            size_t iOut = counts[iC];
+            for (uint32_t iN = lodChunkNodes[iC][0]; iN < lodChunkNodes[iC][1]; iN++) {
+              if (nodeError[iN] >= tolerance) lodLevelNodes[iOut++] = iN;
+            }
+          }
+        },
+        64);
+    lodLevelTolerances.push_back(tolerance);
+  }
+
+  stripDrawInds.setStreaming(true); // updated as the camera moves
+}
+
+void CurveNetwork::updateLOD() {
+  // only update once per frame, on the first (main camera) draw
+  if (lodLastUpdate == internal::renderSceneCount) return;
+  lodLastUpdate = internal::renderSceneCount;
+
+  ensureHaveLOD();
+  size_t nChunks = lodChunkNodes.size();
+  size_t nLevels = lodLevelTolerances.size();
+
+  // Pixels per object-space unit of length at unit distance from the camera (or at any distance, if orthographic)
+  glm::mat4 modelView = view::getCameraViewMatrix() * objectTransform.get();
+  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
+  bool orthographic = projMat[3][3] != 0.f;
+  float scale = std::max({glm::length(glm::vec3(modelView[0])), glm::length(glm::vec3(modelView[1])),
+                          glm::length(glm::vec3(modelView[2]))});
+  float pixelsPerUnit = 0.5f * projMat[1][1] * view::bufferHeight * scale;
+
+  // Each chunk takes the coarsest level which is within the tolerance at its nearest point to the camera
+  bool changed = lodChunkLevels.size() != nChunks;
+  lodChunkLevels.resize(nChunks);
+  for (size_t iC = 0; iC < nChunks; iC++) {
+    glm::vec3 center = glm::vec3(modelView * glm::vec4(glm::vec3(lodChunkBounds[iC]), 1.));
+    float dist = orthographic ? 1.f : -center.z - scale * lodChunkBounds[iC].w;
+    uint8_t level = static_cast<uint8_t>(nLevels);
+    if (dist > 0.f) {
+      for (size_t iL = 0; iL < nLevels; iL++) {
+        if (lodLevelTolerances[iL] * pixelsPerUnit <= getLODPixelTolerance() * dist) {
+          level = static_cast<uint8_t>(iL);
+          break;
+        }
+      }
+    }
+    if (lodChunkLevels[iC] != level) changed = true;
+    lodChunkLevels[iC] = level;
+  }
+
+  if (changed) {
+    computeStripDrawInds();
+  }
+}
+
+void CurveNetwork::clearLOD() {
+  if (!lodBuilt) return;
+  lodBuilt = false;
+  lodStripChunks.clear();
+  lodChunkNodes.clear();
+  lodChunkBounds.clear();
+  lodLevelTolerances.clear();
+  lodLevelOffsets.clear();
+  lodLevelNodes.clear();
+  lodChunkLevels.clear();
+  lodLastUpdate = INVALID_IND_64;
+  if (stripDrawInds.hasData()) computeStripDrawInds();
+}
+
+void CurveNetwork::computeStripNodeEdgeInds() {
+  stripNodeEdgeInds.data.resize(nNodes());
+
+  // The last node of each strip has no outgoing edge, so it takes its incoming one. Isolated nodes are never drawn by
+  // edge programs, but still get a valid edge index.
+  size_t iE = 0;
+  for (size_t iS = 0; iS < nStrips(); iS++) {
+    size_t start = stripOffsets[iS];
+    size_t end = stripOffsets[iS + 1];
+    for (size_t iN = start; iN < end; iN++) {
+      if (iN + 1 < end) {
+        stripNodeEdgeInds.data[iN] = iE;
+        iE++;
+      } else if (iN > start) {
+        stripNodeEdgeInds.data[iN] = iE - 1;
+      } else {
+        stripNodeEdgeInds.data[iN] = std::min(iE, std::max(nEdges(), (size_t)1) - 1);
+      }
+    }
+  }
+
+  stripNodeEdgeInds.markHostBufferUpdated();
+}
+
+RayPickResult CurveNetwork::rayPick(glm::vec3 rayStart, glm::vec3 rayDir) {
+  RayPickResult result;
+
+  rayDir = glm::normalize(rayDir);
+  glm::vec3 objStart, objDir;
+  std::tie(objStart, objDir) = rayToObjectSpace(rayStart, rayDir);
+
+  // NOTE: variable node radii from a quantity are not accounted for
+  float objRadius = getRadius() * glm::length(objDir);
+
+  nodePositions.ensureHostBufferPopulated();
+  edgeTailInds.ensureHostBufferPopulated();
+  edgeTipInds.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = nodePositions.data;
+  const std::vector<uint32_t>& tails = edgeTailInds.data;
+  const std::vector<uint32_t>& tips = edgeTipInds.data;
+
+  // (Re)build the acceleration structure if needed
+  if (!rayPickBVH.isBuilt() || rayPickBVHRadius != objRadius) {
+    std::vector<glm::vec3> primMin(tails.size()), primMax(tails.size());
+    glm::vec3 r{objRadius, objRadius, objRadius};
+    for (size_t iE = 0; iE < tails.size(); iE++) {
+      primMin[iE] = glm::min(pos[tails[iE]], pos[tips[iE]]) - r;
+      primMax[iE] = glm::max(pos[tails[iE]], pos[tips[iE]]) + r;
+    }
+    rayPickBVH.build(primMin, primMax);
+    rayPickBVHRadius = objRadius;
+  }
+
+  // Edges are rendered as cylinders with sphere nodes at the ends, so test against capsules
+  std::pair<size_t, float> hit = rayPickBVH.intersectRay(objStart, objDir, [&](size_t iE) {
+    return rayCapsuleIntersection(objStart, objDir, pos[tails[iE]], pos[tips[iE]], objRadius);
+  });
+  if (hit.first == INVALID_IND) return result;
+
+  result.isHit = true;
+  result.depth = hit.second;
+  result.position = rayStart + hit.second * rayDir;
+  result.elementInd = hit.first;
+  return result;
+}
+
+size_t CurveNetwork::nSubsetElements() { return nEdges(); }
+
+void CurveNetwork::subsetMasksChanged() {
+  // A node is in a subset if any of its edges is
+  std::vector<uint32_t>& tails = edgeTailInds.getPopulatedHostBufferRef();
+  std::vector<uint32_t>& tips = edgeTipInds.getPopulatedHostBufferRef();
+  auto deriveNodeMask = [&](render::ManagedBuffer<uint32_t>& edgeMask, render::ManagedBuffer<uint32_t>& nodeMask,
+                            bool isSet) {
+    nodeMask.data.assign(std::max<size_t>(1, (nNodes() + 31) / 32), 0u);
+    if (isSet) {
+      std::vector<uint32_t>& edgeBits = edgeMask.getPopulatedHostBufferRef();
+      for (size_t iE = 0; iE < nEdges() && iE / 32 < edgeBits.size(); iE++) {
+        if (((edgeBits[iE / 32] >> (iE % 32)) & 1u) == 0) continue;
+        nodeMask.data[tails[iE] / 32] |= (1u << (tails[iE] % 32));
+        nodeMask.data[tips[iE] / 32] |= (1u << (tips[iE] % 32));
+      }
+    }
+    nodeMask.markHostBufferUpdated();
+  };
+  deriveNodeMask(visibleSubsetMask, nodeVisibleSubsetMask, visibleSubsetIsSet);
+  deriveNodeMask(highlightedSubsetMask, nodeHighlightedSubsetMask, highlightedSubsetIsSet);
+}
+
 void CurveNetwork::refresh() {
   recomputeGeometryIfPopulated();
+  rayPickBVH.clear();
 
   nodeProgram.reset();
   edgeProgram.reset();
@@ -339,7 +832,7 @@ void CurveNetwork::buildPickUI(size_t localPickID) {
 
 void CurveNetwork::buildNodePickUI(size_t nodeInd) {
 
-  ImGui::TextUnformatted(("node #" + std::to_string(nodeInd) + "  ").c_str());
+  ImGui::Text("node #%zu  ", nodeInd);
   ImGui::SameLine();
   ImGui::TextUnformatted(to_string(nodePositions.getValue(nodeInd)).c_str());
 
@@ -359,11 +852,11 @@ void CurveNetwork::buildNodePickUI(size_t nodeInd) {
 }
 
 void CurveNetwork::buildEdgePickUI(size_t edgeInd) {
-  ImGui::TextUnformatted(("edge #" + std::to_string(edgeInd) + "  ").c_str());
+  ImGui::Text("edge #%zu  ", edgeInd);
   ImGui::SameLine();
   size_t n0 = edgeTailInds.getValue(edgeInd);
   size_t n1 = edgeTipInds.getValue(edgeInd);
-  ImGui::TextUnformatted(("  " + std::to_string(n0) + " -- " + std::to_string(n1)).c_str());
+  ImGui::Text("  %zu -- %zu", n0, n1);
 
   ImGui::Spacing();
   ImGui::Spacing();
@@ -414,36 +907,115 @@ void CurveNetwork::buildCustomOptionsUI() {
   }
 
 
+  if (!isPolylineStrips()) {
+    if (ImGui::MenuItem("Instanced Drawing", NULL, getInstancedDrawing())) setInstancedDrawing(!getInstancedDrawing());
+  } else {
+    if (ImGui::MenuItem("Level of Detail", NULL, getLODEnabled())) setLODEnabled(!getLODEnabled());
+  }
+  if (ImGui::MenuItem("Depth Pre-pass", NULL, getDepthPrepass())) setDepthPrepass(!getDepthPrepass());
+
   if (render::buildMaterialOptionsGui(material.get())) {
     material.manuallyChanged();
     setMaterial(material.get()); // trigger the other updates that happen on set()
   }
 }
 
-void CurveNetwork::updateObjectSpaceBounds() {
-  nodePositions.ensureHostBufferPopulated();
+void CurveNetwork::appendNodesAndEdgesImpl(const std::vector<glm::vec3>& newNodes,
+                                           const std::vector<std::array<size_t, 2>>& newEdges) {
+  if (isPolylineStrips()) {
+    exception("CurveNetwork [" + name + "] cannot append to a network made of polyline strips");
+  }
 
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : nodePositions.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
+  size_t oldNodeCount = nNodes();
+  size_t maxInd = oldNodeCount + newNodes.size();
+  std::vector<uint32_t> newTails(newEdges.size());
+  std::vector<uint32_t> newTips(newEdges.size());
+  for (size_t iE = 0; iE < newEdges.size(); iE++) {
+    size_t nA = std::get<0>(newEdges[iE]);
+    size_t nB = std::get<1>(newEdges[iE]);
+    if (nA >= maxInd || nB >= maxInd) {
+      exception("CurveNetwork [" + name + "] appended edge " + std::to_string(iE) + " has bad node indices { " +
+                std::to_string(nA) + " , " + std::to_string(nB) + " } but there are " + std::to_string(maxInd) +
+                " nodes.");
+    }
+    newTails[iE] = nA;
+    newTips[iE] = nB;
+  }
+
+  // Nodes first, so the views indexed by the edges are in bounds when the edges are appended
+  nodePositions.appendData(newNodes);
+  edgeTailInds.appendData(newTails);
+  edgeTipInds.appendData(newTips);
+
+  nodeDegrees.resize(nNodes(), 0);
+  for (size_t iE = 0; iE < newEdges.size(); iE++) {
+    nodeDegrees[newTails[iE]]++;
+    nodeDegrees[newTips[iE]]++;
+  }
+
+  // Extend the computed buffers with just the new edges, if they have been computed
+  if (edgeNodeInds.hasData()) {
+    std::vector<uint32_t> newEdgeNodeInds(2 * newEdges.size());
+    for (size_t iE = 0; iE < newEdges.size(); iE++) {
+      newEdgeNodeInds[2 * iE + 0] = newTails[iE];
+      newEdgeNodeInds[2 * iE + 1] = newTips[iE];
+    }
+    edgeNodeInds.appendData(newEdgeNodeInds);
+  }
+  if (edgeCenters.hasData()) {
+    nodePositions.ensureHostBufferPopulated();
+    std::vector<glm::vec3> newCenters(newEdges.size());
+    for (size_t iE = 0; iE < newEdges.size(); iE++) {
+      newCenters[iE] = 0.5f * (nodePositions.data[newTails[iE]] + nodePositions.data[newTips[iE]]);
+    }
+    edgeCenters.appendData(newCenters);
   }
-  objectSpaceBoundingBox = std::make_tuple(min, max);
 
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : nodePositions.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
+  rayPickBVH.clear();
+  nodePickProgram.reset(); // the pick range is sized to the element counts
+  edgePickProgram.reset();
+
+  // Grow the bounds with just the new nodes; the length scale is approximated by the box diagonal
+  if (oldNodeCount == 0) {
+    updateObjectSpaceBounds();
+  } else if (!newNodes.empty()) {
+    glm::vec3 min = std::get<0>(objectSpaceBoundingBox);
+    glm::vec3 max = std::get<1>(objectSpaceBoundingBox);
+    for (const glm::vec3& p : newNodes) {
+      min = componentwiseMin(min, p);
+      max = componentwiseMax(max, p);
+    }
+    objectSpaceBoundingBox = std::make_tuple(min, max);
+    objectSpaceLengthScale = glm::length(max - min);
   }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+
+  requestRedraw();
+}
+
+void CurveNetwork::updateNodePositions(std::vector<glm::vec3>&& newPositions) {
+  validateSize(newPositions, nNodes(), "newPositions");
+  nodePositions.data = std::move(newPositions);
+  nodePositions.setStreaming(true); // positions which get updated are likely to be updated again, e.g. every frame
+  nodePositions.markHostBufferUpdated();
+  rayPickBVH.clear();
+  clearLOD(); // the levels are rebuilt from the new positions when next drawn
+  recomputeGeometryIfPopulated();
+}
+
+void CurveNetwork::updateObjectSpaceBounds() {
+  nodePositions.ensureHostBufferPopulated();
+
+  // bounding box, and length scale as twice the radius from the center of the bounding box
+  glm::vec3 min, max;
+  float lengthScale;
+  computeBoundsAndLengthScale(nodePositions.data.data(), nodePositions.data.size(), min, max, lengthScale);
+  objectSpaceBoundingBox = std::make_tuple(min, max);
+  objectSpaceLengthScale = lengthScale;
 }
 
 CurveNetwork* CurveNetwork::setColor(glm::vec3 newVal) {
   color = newVal;
-  polyscope::requestRedraw();
+  requestRedraw();
   return this;
 }
 glm::vec3 CurveNetwork::getColor() { return color.get(); }
@@ -468,18 +1040,57 @@ void CurveNetwork::clearNodeRadiusQuantity() {
 
 CurveNetwork* CurveNetwork::setRadius(float newVal, bool isRelative) {
   radius = ScaledValue<float>(newVal, isRelative);
-  polyscope::requestRedraw();
+  requestRedraw();
   return this;
 }
 float CurveNetwork::getRadius() { return radius.get().asAbsolute(); }
 
 CurveNetwork* CurveNetwork::setMaterial(std::string m) {
   material = m;
-  refresh(); // (serves the purpose of re-initializing everything, though this is a bit overkill)
+  // the material is just a set of textures, swap them on the existing programs
+  if (nodeProgram) render::engine->setMaterial(*nodeProgram, getMaterial());
+  if (edgeProgram) render::engine->setMaterial(*edgeProgram, getMaterial());
+  refreshQuantityMaterials();
   requestRedraw();
   return this;
 }
 std::string CurveNetwork::getMaterial() { return material.get(); }
+std::string CurveNetwork::drawSortKey() { return material.get(); }
+
+CurveNetwork* CurveNetwork::setInstancedDrawing(bool newVal) {
+  instancedDrawing = newVal;
+  refresh(); // the geometry is the same, only the shaders change
+  requestRedraw();
+  return this;
+}
+bool CurveNetwork::getInstancedDrawing() { return instancedDrawing.get(); }
+
+CurveNetwork* CurveNetwork::setDepthPrepass(bool newVal) {
+  depthPrepass = newVal;
+  requestRedraw();
+  return this;
+}
+bool CurveNetwork::getDepthPrepass() { return depthPrepass.get(); }
+
+CurveNetwork* CurveNetwork::setLODEnabled(bool newVal) {
+  lodEnabled = newVal;
+  if (!newVal) clearLOD(); // back to drawing all nodes
+  requestRedraw();
+  return this;
+}
+bool CurveNetwork::getLODEnabled() { return lodEnabled.get(); }
+
+CurveNetwork* CurveNetwork::setLODPixelTolerance(float newVal) {
+  lodPixelTolerance = newVal;
+  requestRedraw();
+  return this;
+}
+float CurveNetwork::getLODPixelTolerance() { return lodPixelTolerance.get(); }
+
+size_t CurveNetwork::getLODDrawSegmentCount() {
+  if (!isPolylineStrips() || !getLODEnabled() || lodChunkLevels.empty()) return nEdges();
+  return lodDrawSegmentCount;
+}
 
 std::string CurveNetwork::typeName() { return structureTypeName; }
 
@@ -495,47 +1106,79 @@ void CurveNetworkQuantity::buildEdgeInfoGUI(size_t edgeInd) {}
 // === Quantity adders
 
 
-CurveNetworkNodeColorQuantity* CurveNetwork::addNodeColorQuantityImpl(std::string name,
-                                                                      const std::vector<glm::vec3>& colors) {
-  CurveNetworkNodeColorQuantity* q = new CurveNetworkNodeColorQuantity(name, colors, *this);
+CurveNetworkNodeScalarQuantity* CurveNetwork::addNodeScalarQuantity(std::string name, std::vector<float>&& values,
+                                                                    DataType type) {
+  validateSize(values, nNodes(), "curve network node scalar quantity " + name);
+  return addNodeScalarQuantityImpl(name, std::move(values), type);
+}
+
+CurveNetworkEdgeScalarQuantity* CurveNetwork::addEdgeScalarQuantity(std::string name, std::vector<float>&& values,
+                                                                    DataType type) {
+  validateSize(values, nEdges(), "curve network edge scalar quantity " + name);
+  return addEdgeScalarQuantityImpl(name, std::move(values), type);
+}
+
+CurveNetworkNodeColorQuantity* CurveNetwork::addNodeColorQuantity(std::string name, std::vector<glm::vec3>&& values) {
+  validateSize(values, nNodes(), "curve network node color quantity " + name);
+  return addNodeColorQuantityImpl(name, std::move(values));
+}
+
+CurveNetworkEdgeColorQuantity* CurveNetwork::addEdgeColorQuantity(std::string name, std::vector<glm::vec3>&& values) {
+  validateSize(values, nEdges(), "curve network edge color quantity " + name);
+  return addEdgeColorQuantityImpl(name, std::move(values));
+}
+
+CurveNetworkNodeVectorQuantity* CurveNetwork::addNodeVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                                    VectorType vectorType) {
+  validateSize(vectors, nNodes(), "curve network node vector quantity " + name);
+  return addNodeVectorQuantityImpl(name, std::move(vectors), vectorType);
+}
+
+CurveNetworkEdgeVectorQuantity* CurveNetwork::addEdgeVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                                    VectorType vectorType) {
+  validateSize(vectors, nEdges(), "curve network edge vector quantity " + name);
+  return addEdgeVectorQuantityImpl(name, std::move(vectors), vectorType);
+}
+
+CurveNetworkNodeColorQuantity* CurveNetwork::addNodeColorQuantityImpl(std::string name, std::vector<glm::vec3> colors) {
+  CurveNetworkNodeColorQuantity* q = new CurveNetworkNodeColorQuantity(name, std::move(colors), *this);
   addQuantity(q);
   return q;
 }
 
-CurveNetworkEdgeColorQuantity* CurveNetwork::addEdgeColorQuantityImpl(std::string name,
-                                                                      const std::vector<glm::vec3>& colors) {
-  CurveNetworkEdgeColorQuantity* q = new CurveNetworkEdgeColorQuantity(name, colors, *this);
+CurveNetworkEdgeColorQuantity* CurveNetwork::addEdgeColorQuantityImpl(std::string name, std::vector<glm::vec3> colors) {
+  CurveNetworkEdgeColorQuantity* q = new CurveNetworkEdgeColorQuantity(name, std::move(colors), *this);
   addQuantity(q);
   return q;
 }
 
 
 CurveNetworkNodeScalarQuantity*
-CurveNetwork::addNodeScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type) {
-  CurveNetworkNodeScalarQuantity* q = new CurveNetworkNodeScalarQuantity(name, data, *this, type);
+CurveNetwork::addNodeScalarQuantityImpl(std::string name, std::vector<float> data, DataType type) {
+  CurveNetworkNodeScalarQuantity* q = new CurveNetworkNodeScalarQuantity(name, std::move(data), *this, type);
   addQuantity(q);
   return q;
 }
 
 CurveNetworkEdgeScalarQuantity*
-CurveNetwork::addEdgeScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type) {
-  CurveNetworkEdgeScalarQuantity* q = new CurveNetworkEdgeScalarQuantity(name, data, *this, type);
+CurveNetwork::addEdgeScalarQuantityImpl(std::string name, std::vector<float> data, DataType type) {
+  CurveNetworkEdgeScalarQuantity* q = new CurveNetworkEdgeScalarQuantity(name, std::move(data), *this, type);
   addQuantity(q);
   return q;
 }
 
 CurveNetworkNodeVectorQuantity* CurveNetwork::addNodeVectorQuantityImpl(std::string name,
-                                                                        const std::vector<glm::vec3>& vectors,
+                                                                        std::vector<glm::vec3> vectors,
                                                                         VectorType vectorType) {
-  CurveNetworkNodeVectorQuantity* q = new CurveNetworkNodeVectorQuantity(name, vectors, *this, vectorType);
+  CurveNetworkNodeVectorQuantity* q = new CurveNetworkNodeVectorQuantity(name, std::move(vectors), *this, vectorType);
   addQuantity(q);
   return q;
 }
 
 CurveNetworkEdgeVectorQuantity* CurveNetwork::addEdgeVectorQuantityImpl(std::string name,
-                                                                        const std::vector<glm::vec3>& vectors,
+                                                                        std::vector<glm::vec3> vectors,
                                                                         VectorType vectorType) {
-  CurveNetworkEdgeVectorQuantity* q = new CurveNetworkEdgeVectorQuantity(name, vectors, *this, vectorType);
+  CurveNetworkEdgeVectorQuantity* q = new CurveNetworkEdgeVectorQuantity(name, std::move(vectors), *this, vectorType);
   addQuantity(q);
   return q;
 }
@@ -555,4 +1198,20 @@ CurveNetworkNodeScalarQuantity& CurveNetwork::resolveNodeRadiusQuantity() {
   return *sizeScalarQ;
 }
 
+CurveNetwork* registerCurveNetworkLine(std::string name, std::vector<glm::vec3>&& nodes) {
+  checkInitialized();
+
+  std::vector<std::array<size_t, 2>> edges;
+  for (size_t iE = 1; iE < nodes.size(); iE++) {
+    edges.push_back({iE - 1, iE});
+  }
+
+  CurveNetwork* s = new CurveNetwork(name, std::move(nodes), std::move(edges));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
 } // namespace polyscope
@@ -9,8 +9,9 @@
 namespace polyscope {
 
 CurveNetworkColorQuantity::CurveNetworkColorQuantity(std::string name, CurveNetwork& network_, std::string definedOn_,
-                                                     const std::vector<glm::vec3>& colorValues_)
-    : CurveNetworkQuantity(name, network_, true), ColorQuantity(*this, colorValues_), definedOn(definedOn_) {}
+                                                     std::vector<glm::vec3> colorValues_)
+    : CurveNetworkQuantity(name, network_, true), ColorQuantity(*this, std::move(colorValues_)),
+      definedOn(definedOn_) {}
 
 void CurveNetworkColorQuantity::draw() {
   if (!isEnabled()) return;
@@ -27,7 +28,9 @@ void CurveNetworkColorQuantity::draw() {
   parent.setCurveNetworkNodeUniforms(*nodeProgram);
 
   edgeProgram->draw();
-  nodeProgram->draw();
+  if (!parent.isPolylineStrips()) {
+    nodeProgram->draw();
+  }
 }
 
 // ========================================================
@@ -36,15 +39,17 @@ void CurveNetworkColorQuantity::draw() {
 
 CurveNetworkNodeColorQuantity::CurveNetworkNodeColorQuantity(std::string name, std::vector<glm::vec3> values_,
                                                              CurveNetwork& network_)
-    : CurveNetworkColorQuantity(name, network_, "node", values_) {}
+    : CurveNetworkColorQuantity(name, network_, "node", std::move(values_)) {}
 
 void CurveNetworkNodeColorQuantity::createProgram() {
 
   // Create the program to draw this quantity
   nodeProgram = render::engine->requestShader(
-      "RAYCAST_SPHERE", parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_COLOR", "SHADE_COLOR"}));
-  edgeProgram = render::engine->requestShader(
-      "RAYCAST_CYLINDER", parent.addCurveNetworkEdgeRules({"CYLINDER_PROPAGATE_BLEND_COLOR", "SHADE_COLOR"}));
+      parent.nodeProgramName(), parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_COLOR", "SHADE_COLOR"}));
+  std::string blendRule =
+      parent.isPolylineStrips() ? "TUBE_PROPAGATE_BLEND_COLOR" : "CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR";
+  edgeProgram = render::engine->requestShader(parent.edgeProgramName(),
+                                              parent.addCurveNetworkEdgeRules({blendRule, "SHADE_COLOR"}));
 
   // Fill geometry buffers
   parent.fillEdgeGeometryBuffers(*edgeProgram);
@@ -55,8 +60,7 @@ void CurveNetworkNodeColorQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_color_tail", colors.getIndexedRenderAttributeBuffer(parent.edgeTailInds));
-    edgeProgram->setAttribute("a_color_tip", colors.getIndexedRenderAttributeBuffer(parent.edgeTipInds));
+    parent.setEdgeNodeAttribute(*edgeProgram, "a_color", colors);
   }
 
   render::engine->setMaterial(*nodeProgram, parent.getMaterial());
@@ -84,24 +88,36 @@ void CurveNetworkColorQuantity::refresh() {
   Quantity::refresh();
 }
 
+void CurveNetworkColorQuantity::refreshMaterial() {
+  if (nodeProgram) render::engine->setMaterial(*nodeProgram, parent.getMaterial());
+  if (edgeProgram) render::engine->setMaterial(*edgeProgram, parent.getMaterial());
+}
+
 // ========================================================
 // ==========            Edge Color              ==========
 // ========================================================
 
 CurveNetworkEdgeColorQuantity::CurveNetworkEdgeColorQuantity(std::string name, std::vector<glm::vec3> values_,
                                                              CurveNetwork& network_)
-    : CurveNetworkColorQuantity(name, network_, "edge", values_),
+    : CurveNetworkColorQuantity(name, network_, "edge", std::move(values_)),
       nodeAverageColors(uniquePrefix() + "#nodeAverageColors", nodeAverageColorsData) {}
 
 void CurveNetworkEdgeColorQuantity::createProgram() {
 
   nodeProgram = render::engine->requestShader(
-      "RAYCAST_SPHERE", parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_COLOR", "SHADE_COLOR"}));
-  edgeProgram = render::engine->requestShader(
-      "RAYCAST_CYLINDER", parent.addCurveNetworkEdgeRules({"CYLINDER_PROPAGATE_COLOR", "SHADE_COLOR"}));
+      parent.nodeProgramName(), parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_COLOR", "SHADE_COLOR"}));
+  if (parent.isPolylineStrips()) {
+    edgeProgram = render::engine->requestShader(
+        parent.edgeProgramName(), parent.addCurveNetworkEdgeRules({"TUBE_PROPAGATE_COLOR", "SHADE_COLOR"}));
+    parent.fillEdgeGeometryBuffers(*edgeProgram);
+  } else {
+    edgeProgram = render::engine->requestShader(
+        parent.expandedEdgeProgramName(),
+        parent.addCurveNetworkExpandedEdgeRules({"CYLINDER_PROPAGATE_COLOR", "SHADE_COLOR"}));
+    parent.fillExpandedEdgeGeometryBuffers(*edgeProgram);
+  }
 
   // Fill geometry buffers
-  parent.fillEdgeGeometryBuffers(*edgeProgram);
   parent.fillNodeGeometryBuffers(*nodeProgram);
 
   { // Fill node color buffers
@@ -111,7 +127,12 @@ void CurveNetworkEdgeColorQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_color", colors.getRenderAttributeBuffer());
+    if (parent.isPolylineStrips()) {
+      // strip programs read each edge's color at its tail node
+      edgeProgram->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.stripNodeEdgeInds));
+    } else {
+      edgeProgram->setAttribute("a_color", colors.getRenderAttributeBuffer());
+    }
   }
 
   render::engine->setMaterial(*nodeProgram, parent.getMaterial());
@@ -13,8 +13,9 @@ using std::endl;
 namespace polyscope {
 
 CurveNetworkScalarQuantity::CurveNetworkScalarQuantity(std::string name, CurveNetwork& network_, std::string definedOn_,
-                                                       const std::vector<double>& values_, DataType dataType_)
-    : CurveNetworkQuantity(name, network_, true), ScalarQuantity(*this, values_, dataType_), definedOn(definedOn_) {}
+                                                       std::vector<float> values_, DataType dataType_)
+    : CurveNetworkQuantity(name, network_, true), ScalarQuantity(*this, std::move(values_), dataType_),
+      definedOn(definedOn_) {}
 
 void CurveNetworkScalarQuantity::draw() {
   if (!isEnabled()) return;
@@ -34,7 +35,9 @@ void CurveNetworkScalarQuantity::draw() {
   setScalarUniforms(*nodeProgram);
 
   edgeProgram->draw();
-  nodeProgram->draw();
+  if (!parent.isPolylineStrips()) {
+    nodeProgram->draw();
+  }
 }
 
 void CurveNetworkScalarQuantity::buildCustomUI() {
@@ -60,24 +63,31 @@ void CurveNetworkScalarQuantity::refresh() {
   Quantity::refresh();
 }
 
+void CurveNetworkScalarQuantity::refreshMaterial() {
+  if (nodeProgram) render::engine->setMaterial(*nodeProgram, parent.getMaterial());
+  if (edgeProgram) render::engine->setMaterial(*edgeProgram, parent.getMaterial());
+}
+
 std::string CurveNetworkScalarQuantity::niceName() { return name + " (" + definedOn + " scalar)"; }
 
 // ========================================================
 // ==========             Node Scalar            ==========
 // ========================================================
 
-CurveNetworkNodeScalarQuantity::CurveNetworkNodeScalarQuantity(std::string name, const std::vector<double>& values_,
+CurveNetworkNodeScalarQuantity::CurveNetworkNodeScalarQuantity(std::string name, std::vector<float> values_,
                                                                CurveNetwork& network_, DataType dataType_)
-    : CurveNetworkScalarQuantity(name, network_, "node", values_, dataType_)
+    : CurveNetworkScalarQuantity(name, network_, "node", std::move(values_), dataType_)
 
 {}
 
 void CurveNetworkNodeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
   nodeProgram = render::engine->requestShader(
-      "RAYCAST_SPHERE", addScalarRules(parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_VALUE"})));
-  edgeProgram = render::engine->requestShader(
-      "RAYCAST_CYLINDER", addScalarRules(parent.addCurveNetworkEdgeRules({"CYLINDER_PROPAGATE_BLEND_VALUE"})));
+      parent.nodeProgramName(), addScalarRules(parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_VALUE"})));
+  std::string blendRule =
+      parent.isPolylineStrips() ? "TUBE_PROPAGATE_BLEND_VALUE" : "CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE";
+  edgeProgram = render::engine->requestShader(parent.edgeProgramName(),
+                                              addScalarRules(parent.addCurveNetworkEdgeRules({blendRule})));
 
   // Fill geometry buffers
   parent.fillNodeGeometryBuffers(*nodeProgram);
@@ -88,8 +98,7 @@ void CurveNetworkNodeScalarQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_value_tail", values.getIndexedRenderAttributeBuffer(parent.edgeTailInds));
-    edgeProgram->setAttribute("a_value_tip", values.getIndexedRenderAttributeBuffer(parent.edgeTipInds));
+    parent.setEdgeNodeAttribute(*edgeProgram, "a_value", values);
   }
 
   edgeProgram->setTextureFromColormap("t_colormap", cMap.get());
@@ -111,20 +120,27 @@ void CurveNetworkNodeScalarQuantity::buildNodeInfoGUI(size_t nInd) {
 // ==========            Edge Scalar             ==========
 // ========================================================
 
-CurveNetworkEdgeScalarQuantity::CurveNetworkEdgeScalarQuantity(std::string name, const std::vector<double>& values_,
+CurveNetworkEdgeScalarQuantity::CurveNetworkEdgeScalarQuantity(std::string name, std::vector<float> values_,
                                                                CurveNetwork& network_, DataType dataType_)
-    : CurveNetworkScalarQuantity(name, network_, "edge", values_, dataType_),
+    : CurveNetworkScalarQuantity(name, network_, "edge", std::move(values_), dataType_),
       nodeAverageValues(uniquePrefix() + "#nodeAverageValues", nodeAverageValuesData) {}
 
 void CurveNetworkEdgeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
   nodeProgram = render::engine->requestShader(
-      "RAYCAST_SPHERE", addScalarRules(parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_VALUE"})));
-  edgeProgram = render::engine->requestShader(
-      "RAYCAST_CYLINDER", addScalarRules(parent.addCurveNetworkEdgeRules({"CYLINDER_PROPAGATE_VALUE"})));
+      parent.nodeProgramName(), addScalarRules(parent.addCurveNetworkNodeRules({"SPHERE_PROPAGATE_VALUE"})));
+  if (parent.isPolylineStrips()) {
+    edgeProgram = render::engine->requestShader(
+        parent.edgeProgramName(), addScalarRules(parent.addCurveNetworkEdgeRules({"TUBE_PROPAGATE_VALUE"})));
+    parent.fillEdgeGeometryBuffers(*edgeProgram);
+  } else {
+    edgeProgram = render::engine->requestShader(
+        parent.expandedEdgeProgramName(),
+        addScalarRules(parent.addCurveNetworkExpandedEdgeRules({"CYLINDER_PROPAGATE_VALUE"})));
+    parent.fillExpandedEdgeGeometryBuffers(*edgeProgram);
+  }
 
   // Fill geometry buffers
-  parent.fillEdgeGeometryBuffers(*edgeProgram);
   parent.fillNodeGeometryBuffers(*nodeProgram);
 
   { // Fill node color buffers
@@ -133,7 +149,12 @@ void CurveNetworkEdgeScalarQuantity::createProgram() {
   }
 
   { // Fill edge color buffers
-    edgeProgram->setAttribute("a_value", values.getRenderAttributeBuffer());
+    if (parent.isPolylineStrips()) {
+      // strip programs read each edge's value at its tail node
+      edgeProgram->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.stripNodeEdgeInds));
+    } else {
+      edgeProgram->setAttribute("a_value", values.getRenderAttributeBuffer());
+    }
   }
 
   edgeProgram->setTextureFromColormap("t_colormap", cMap.get());
@@ -25,7 +25,7 @@ CurveNetworkNodeVectorQuantity::CurveNetworkNodeVectorQuantity(std::string name,
                                                                CurveNetwork& network_, VectorType vectorType_)
 
     : CurveNetworkVectorQuantity(name, network_),
-      VectorQuantity<CurveNetworkNodeVectorQuantity>(*this, vectors_, parent.nodePositions, vectorType_) {
+      VectorQuantity<CurveNetworkNodeVectorQuantity>(*this, std::move(vectors_), parent.nodePositions, vectorType_) {
   refresh();
 }
 
@@ -66,7 +66,7 @@ std::string CurveNetworkNodeVectorQuantity::niceName() { return name + " (node v
 CurveNetworkEdgeVectorQuantity::CurveNetworkEdgeVectorQuantity(std::string name, std::vector<glm::vec3> vectors_,
                                                                CurveNetwork& network_, VectorType vectorType_)
     : CurveNetworkVectorQuantity(name, network_),
-      VectorQuantity<CurveNetworkEdgeVectorQuantity>(*this, vectors_, parent.edgeCenters, vectorType_) {
+      VectorQuantity<CurveNetworkEdgeVectorQuantity>(*this, std::move(vectors_), parent.edgeCenters, vectorType_) {
   refresh();
 }
 
@@ -24,12 +24,6 @@ void DepthRenderImageQuantity::drawDelayed() {
   if (!program) prepare();
 
   // set uniforms
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-
-  program->setUniform("u_projMatrix", glm::value_ptr(P));
-  program->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  program->setUniform("u_viewport", render::engine->getCurrentViewport());
   program->setUniform("u_baseColor", color.get());
   program->setUniform("u_transparency", transparency.get());
 
@@ -0,0 +1,287 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/distributed.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/screenshot.h"
+#include "polyscope/view.h"
+
+#include "json/json.hpp"
+using json = nlohmann::json;
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <tuple>
+
+namespace polyscope {
+namespace distributed {
+
+namespace {
+
+void checkCommunicator(const Communicator& comm) {
+  if (comm.size < 1 || comm.rank < 0 || comm.rank >= comm.size) {
+    exception("distributed: invalid communicator rank " + std::to_string(comm.rank) + " of " +
+              std::to_string(comm.size));
+  }
+  if (comm.size > 1 && (!comm.send || !comm.recv || !comm.exchange)) {
+    exception("distributed: the communicator must provide send, recv, and exchange");
+  }
+}
+
+void sendString(const Communicator& comm, int peer, const std::string& data) {
+  uint64_t bytes = data.size();
+  comm.send(peer, &bytes, sizeof(bytes));
+  if (bytes > 0) comm.send(peer, data.data(), data.size());
+}
+
+std::string recvString(const Communicator& comm, int peer) {
+  uint64_t bytes = 0;
+  comm.recv(peer, &bytes, sizeof(bytes));
+  std::string data(bytes, '\0');
+  if (bytes > 0) comm.recv(peer, &data[0], data.size());
+  return data;
+}
+
+// The pixels [begin, end) which a rank holds after the given number of binary swap rounds. Each round halves the
+// range, and the rank keeps the upper half if it has that round's bit set.
+void swapRegion(int rank, int rounds, size_t nPix, size_t& begin, size_t& end) {
+  begin = 0;
+  end = nPix;
+  for (int k = 0; k < rounds; k++) {
+    size_t mid = begin + (end - begin) / 2;
+    if (rank & (1 << k)) {
+      begin = mid;
+    } else {
+      end = mid;
+    }
+  }
+}
+
+// Color and depth of the pixels [begin, end), packed in one message
+std::vector<unsigned char> packPixels(const std::vector<unsigned char>& color, const std::vector<float>& depth,
+                                      size_t begin, size_t end) {
+  size_t n = end - begin;
+  std::vector<unsigned char> msg(8 * n);
+  std::memcpy(msg.data(), color.data() + 4 * begin, 4 * n);
+  std::memcpy(msg.data() + 4 * n, depth.data() + begin, 4 * n);
+  return msg;
+}
+
+// Keep the nearer of the local and incoming pixels in [begin, end)
+void compositePixels(std::vector<unsigned char>& color, std::vector<float>& depth,
+                     const std::vector<unsigned char>& msg, size_t begin, size_t end) {
+  size_t n = end - begin;
+  const unsigned char* inColor = msg.data();
+  const unsigned char* inDepthBytes = msg.data() + 4 * n;
+  for (size_t i = 0; i < n; i++) {
+    float inDepth;
+    std::memcpy(&inDepth, inDepthBytes + 4 * i, sizeof(float));
+    if (inDepth < depth[begin + i]) {
+      depth[begin + i] = inDepth;
+      std::memcpy(&color[4 * (begin + i)], inColor + 4 * i, 4);
+    }
+  }
+}
+
+void copyPixels(std::vector<unsigned char>& color, std::vector<float>& depth, const std::vector<unsigned char>& msg,
+                size_t begin, size_t end) {
+  size_t n = end - begin;
+  std::memcpy(color.data() + 4 * begin, msg.data(), 4 * n);
+  std::memcpy(depth.data() + begin, msg.data() + 4 * n, 4 * n);
+}
+
+} // namespace
+
+void broadcast(const Communicator& comm, std::string& data) {
+  checkCommunicator(comm);
+  if (comm.rank == 0) {
+    for (int r = 1; r < comm.size; r++) {
+      sendString(comm, r, data);
+    }
+  } else {
+    data = recvString(comm, 0);
+  }
+}
+
+void synchronizeState(const Communicator& comm) {
+  checkCommunicator(comm);
+
+  // Scene extents of this rank's structures, merged the same way updateStructureExtents() merges structures
+  float lengthScale = 0.;
+  glm::vec3 bboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 bboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      Structure& s = *x.second;
+      if (!s.hasExtents()) continue;
+      lengthScale = std::max(lengthScale, s.lengthScale());
+      auto bbox = s.boundingBox();
+      bboxMin = componentwiseMin(bboxMin, std::get<0>(bbox));
+      bboxMax = componentwiseMax(bboxMax, std::get<1>(bbox));
+    }
+  }
+  std::array<float, 7> extents{lengthScale, bboxMin.x, bboxMin.y, bboxMin.z, bboxMax.x, bboxMax.y, bboxMax.z};
+
+  std::string stateData;
+  if (comm.rank == 0) {
+    for (int r = 1; r < comm.size; r++) {
+      std::array<float, 7> other;
+      comm.recv(r, other.data(), sizeof(other));
+      extents[0] = std::max(extents[0], other[0]);
+      for (int i = 0; i < 3; i++) {
+        extents[1 + i] = std::min(extents[1 + i], other[1 + i]);
+        extents[4 + i] = std::max(extents[4 + i], other[4 + i]);
+      }
+    }
+
+    json enabled = json::object();
+    for (auto& cat : state::structures) {
+      for (auto& x : cat.second) {
+        enabled[cat.first][x.first] = x.second->isEnabled();
+      }
+    }
+    json j = {{"view", view::getViewAsJson()}, {"extents", extents}, {"enabled", enabled}};
+    stateData = j.dump();
+  } else {
+    comm.send(0, extents.data(), sizeof(extents));
+  }
+
+  broadcast(comm, stateData);
+  json j = json::parse(stateData);
+
+  if (comm.rank != 0) {
+    view::setViewFromJson(j["view"].get<std::string>(), false);
+
+    // Structures which rank 0 does not have are left alone
+    const json& enabled = j["enabled"];
+    for (auto& cat : state::structures) {
+      if (enabled.find(cat.first) == enabled.end()) continue;
+      const json& catEnabled = enabled[cat.first];
+      for (auto& x : cat.second) {
+        if (catEnabled.find(x.first) == catEnabled.end()) continue;
+        bool val = catEnabled[x.first].get<bool>();
+        if (x.second->isEnabled() != val) x.second->setEnabled(val);
+      }
+    }
+  }
+
+  // If no rank has anything with extents, keep the current ones
+  std::vector<float> extentsData = j["extents"].get<std::vector<float>>();
+  std::copy(extentsData.begin(), extentsData.end(), extents.begin());
+  glm::vec3 newMin{extents[1], extents[2], extents[3]};
+  glm::vec3 newMax{extents[4], extents[5], extents[6]};
+  if (isFinite(newMin) && isFinite(newMax)) {
+    if (extents[0] == 0.) extents[0] = glm::length(newMax - newMin);
+    if (state::lengthScale != extents[0] || std::get<0>(state::boundingBox) != newMin ||
+        std::get<1>(state::boundingBox) != newMax) {
+      state::lengthScale = extents[0];
+      state::boundingBox = std::make_tuple(newMin, newMax);
+      requestRedraw();
+    }
+  }
+}
+
+void compositeImages(const Communicator& comm, std::vector<unsigned char>& color, std::vector<float>& depth, int w,
+                     int h) {
+  checkCommunicator(comm);
+  size_t nPix = static_cast<size_t>(w) * h;
+  if (color.size() != 4 * nPix || depth.size() != nPix) {
+    exception("distributed::compositeImages(): buffers do not match the " + std::to_string(w) + "x" +
+              std::to_string(h) + " image size");
+  }
+  if (comm.size == 1) return;
+
+  std::array<int, 2> size0{w, h};
+  if (comm.rank == 0) {
+    for (int r = 1; r < comm.size; r++) comm.send(r, size0.data(), sizeof(size0));
+  } else {
+    comm.recv(0, size0.data(), sizeof(size0));
+    if (size0[0] != w || size0[1] != h) {
+      exception("distributed::compositeImages(): image size " + std::to_string(w) + "x" + std::to_string(h) +
+                " on rank " + std::to_string(comm.rank) + " does not match " + std::to_string(size0[0]) + "x" +
+                std::to_string(size0[1]) + " on rank 0");
+    }
+  }
+
+  // Binary swap runs on the largest power of two of the ranks; each rank beyond it first hands its whole image to its
+  // counterpart rank - pow2.
+  int pow2 = 1;
+  int rounds = 0;
+  while (2 * pow2 <= comm.size) {
+    pow2 *= 2;
+    rounds++;
+  }
+  if (comm.rank >= pow2) {
+    std::vector<unsigned char> msg = packPixels(color, depth, 0, nPix);
+    comm.send(comm.rank - pow2, msg.data(), msg.size());
+    return;
+  }
+  if (comm.rank + pow2 < comm.size) {
+    std::vector<unsigned char> msg(8 * nPix);
+    comm.recv(comm.rank + pow2, msg.data(), msg.size());
+    compositePixels(color, depth, msg, 0, nPix);
+  }
+
+  // Each round, partners split the range they share, and each composites the half it keeps
+  size_t begin = 0;
+  size_t end = nPix;
+  for (int k = 0; k < rounds; k++) {
+    int bit = 1 << k;
+    int partner = comm.rank ^ bit;
+    size_t mid = begin + (end - begin) / 2;
+    bool keepUpper = (comm.rank & bit) != 0;
+    size_t keepBegin = keepUpper ? mid : begin;
+    size_t keepEnd = keepUpper ? end : mid;
+    size_t sendBegin = keepUpper ? begin : mid;
+    size_t sendEnd = keepUpper ? mid : end;
+
+    std::vector<unsigned char> sendMsg = packPixels(color, depth, sendBegin, sendEnd);
+    std::vector<unsigned char> recvMsg(8 * (keepEnd - keepBegin));
+    comm.exchange(partner, sendMsg.data(), sendMsg.size(), recvMsg.data(), recvMsg.size());
+    compositePixels(color, depth, recvMsg, keepBegin, keepEnd);
+
+    begin = keepBegin;
+    end = keepEnd;
+  }
+
+  // Gather the finished pieces on rank 0
+  if (comm.rank == 0) {
+    for (int r = 1; r < pow2; r++) {
+      size_t rBegin, rEnd;
+      swapRegion(r, rounds, nPix, rBegin, rEnd);
+      std::vector<unsigned char> msg(8 * (rEnd - rBegin));
+      comm.recv(r, msg.data(), msg.size());
+      copyPixels(color, depth, msg, rBegin, rEnd);
+    }
+  } else {
+    std::vector<unsigned char> msg = packPixels(color, depth, begin, end);
+    comm.send(0, msg.data(), msg.size());
+  }
+}
+
+std::vector<unsigned char> renderComposited(const Communicator& comm, bool transparentBG) {
+  synchronizeState(comm);
+
+  int w = view::bufferWidth;
+  int h = view::bufferHeight;
+  size_t nPix = static_cast<size_t>(w) * h;
+  std::vector<unsigned char> color(4 * nPix);
+  std::vector<float> depth(nPix);
+  RenderBufferTargets targets;
+  targets.color = color.data();
+  targets.depth = depth.data();
+  renderToBuffers(targets, transparentBG);
+
+  compositeImages(comm, color, depth, w, h);
+
+  if (comm.rank != 0) return {};
+  return color;
+}
+
+} // namespace distributed
+} // namespace polyscope
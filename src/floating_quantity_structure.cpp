@@ -5,6 +5,7 @@
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/tiled_image_quantity.h"
 
 #include "imgui.h"
 
@@ -113,6 +114,12 @@ void removeFloatingQuantity(std::string name, bool errorIfAbsent) {
   internal::globalFloatingQuantityStructure->removeQuantity(name, errorIfAbsent);
 }
 
+TiledColorImageQuantity* addTiledColorImageQuantityFromLoader(std::string name, size_t dimX, size_t dimY,
+                                                              ImageTileLoader loader, ImageOrigin imageOrigin) {
+  FloatingQuantityStructure* q = getGlobalFloatingQuantityStructure();
+  return q->addTiledColorImageQuantityFromLoader(name, dimX, dimY, loader, imageOrigin);
+}
+
 void removeAllFloatingQuantities() {
   if (!internal::globalFloatingQuantityStructure) return;
   internal::globalFloatingQuantityStructure->removeAllQuantities();
@@ -0,0 +1,77 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/frame_arena.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+namespace polyscope {
+
+FrameArena::FrameArena(size_t blockSize_) : blockSize(blockSize_) {}
+
+void* FrameArena::allocate(size_t nBytes, size_t alignment) {
+  if (nBytes == 0) nBytes = 1;
+
+  // Use the first block from the current one on which has room, adding a block if none do
+  while (true) {
+    if (currBlock < blocks.size()) {
+      Block& b = blocks[currBlock];
+      uintptr_t base = reinterpret_cast<uintptr_t>(b.data.get());
+      uintptr_t ptr = (base + currOffset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+      size_t newOffset = (ptr - base) + nBytes;
+      if (newOffset <= b.size) {
+        currOffset = newOffset;
+        return reinterpret_cast<void*>(ptr);
+      }
+      usedInEarlierBlocks += currOffset;
+      currBlock++;
+      currOffset = 0;
+      continue;
+    }
+
+    Block newBlock;
+    newBlock.size = std::max(blockSize, nBytes + alignment);
+    newBlock.data.reset(new char[newBlock.size]);
+    blocks.push_back(std::move(newBlock));
+  }
+}
+
+void FrameArena::reset() {
+  currBlock = 0;
+  currOffset = 0;
+  usedInEarlierBlocks = 0;
+}
+
+size_t FrameArena::bytesUsed() const { return usedInEarlierBlocks + currOffset; }
+
+size_t FrameArena::capacity() const {
+  size_t total = 0;
+  for (const Block& b : blocks) total += b.size;
+  return total;
+}
+
+FrameArena& frameArena() {
+  static FrameArena arena;
+  return arena;
+}
+
+const char* frameFormat(const char* format, ...) {
+  va_list args, argsCopy;
+  va_start(args, format);
+  va_copy(argsCopy, args);
+  int len = std::vsnprintf(nullptr, 0, format, args);
+  va_end(args);
+
+  if (len < 0) {
+    va_end(argsCopy);
+    return "";
+  }
+  char* buff = static_cast<char*>(frameArena().allocate(len + 1, 1));
+  std::vsnprintf(buff, len + 1, format, argsCopy);
+  va_end(argsCopy);
+  return buff;
+}
+
+} // namespace polyscope
@@ -0,0 +1,337 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/grid_isosurface.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace polyscope {
+
+namespace {
+
+const size_t BLOCK_SIZE = 8;  // cells per side of a min/max block
+const size_t SLAB_LAYERS = 8; // layers of cells per slab, the unit of parallel work
+
+// Indices referring to the first plane of the next slab are tagged with this bit until all slabs are done
+const uint32_t NEXT_SLAB_BIT = 0x80000000u;
+
+// Marching cubes triangle table, as in deps/MarchingCubeCpp. The low 4 bits of each entry hold the number of
+// triangles, followed by 4 bits per triangle corner giving the cell edge it lies on. Cell corner c is offset from the
+// cell origin by bits 0/1/2 of c along x/y/z; see the edge list in extract() for the edge numbering.
+const uint64_t MC_TRIANGLE_TABLE[256] = {
+    0ULL, 33793ULL, 36945ULL, 159668546ULL,
+    18961ULL, 144771090ULL, 5851666ULL, 595283255635ULL,
+    20913ULL, 67640146ULL, 193993474ULL, 655980856339ULL,
+    88782242ULL, 736732689667ULL, 797430812739ULL, 194554754ULL,
+    26657ULL, 104867330ULL, 136709522ULL, 298069416227ULL,
+    109224258ULL, 8877909667ULL, 318136408323ULL, 1567994331701604ULL,
+    189884450ULL, 350847647843ULL, 559958167731ULL, 3256298596865604ULL,
+    447393122899ULL, 651646838401572ULL, 2538311371089956ULL, 737032694307ULL,
+    29329ULL, 43484162ULL, 91358498ULL, 374810899075ULL,
+    158485010ULL, 178117478419ULL, 88675058979ULL, 433581536604804ULL,
+    158486962ULL, 649105605635ULL, 4866906995ULL, 3220959471609924ULL,
+    649165714851ULL, 3184943915608436ULL, 570691368417972ULL, 595804498035ULL,
+    124295042ULL, 431498018963ULL, 508238522371ULL, 91518530ULL,
+    318240155763ULL, 291789778348404ULL, 1830001131721892ULL, 375363605923ULL,
+    777781811075ULL, 1136111028516116ULL, 3097834205243396ULL, 508001629971ULL,
+    2663607373704004ULL, 680242583802939237ULL, 333380770766129845ULL, 179746658ULL,
+    42545ULL, 138437538ULL, 93365810ULL, 713842853011ULL,
+    73602098ULL, 69575510115ULL, 23964357683ULL, 868078761575828ULL,
+    28681778ULL, 713778574611ULL, 250912709379ULL, 2323825233181284ULL,
+    302080811955ULL, 3184439127991172ULL, 1694042660682596ULL, 796909779811ULL,
+    176306722ULL, 150327278147ULL, 619854856867ULL, 1005252473234484ULL,
+    211025400963ULL, 36712706ULL, 360743481544788ULL, 150627258963ULL,
+    117482600995ULL, 1024968212107700ULL, 2535169275963444ULL, 4734473194086550421ULL,
+    628107696687956ULL, 9399128243ULL, 5198438490361643573ULL, 194220594ULL,
+    104474994ULL, 566996932387ULL, 427920028243ULL, 2014821863433780ULL,
+    492093858627ULL, 147361150235284ULL, 2005882975110676ULL, 9671606099636618005ULL,
+    777701008947ULL, 3185463219618820ULL, 482784926917540ULL, 2900953068249785909ULL,
+    1754182023747364ULL, 4274848857537943333ULL, 13198752741767688709ULL, 2015093490989156ULL,
+    591272318771ULL, 2659758091419812ULL, 1531044293118596ULL, 298306479155ULL,
+    408509245114388ULL, 210504348563ULL, 9248164405801223541ULL, 91321106ULL,
+    2660352816454484ULL, 680170263324308757ULL, 8333659837799955077ULL, 482966828984116ULL,
+    4274926723105633605ULL, 3184439197724820ULL, 192104450ULL, 15217ULL,
+    45937ULL, 129205250ULL, 129208402ULL, 529245952323ULL,
+    169097138ULL, 770695537027ULL, 382310500883ULL, 2838550742137652ULL,
+    122763026ULL, 277045793139ULL, 81608128403ULL, 1991870397907988ULL,
+    362778151475ULL, 2059003085103236ULL, 2132572377842852ULL, 655681091891ULL,
+    58419234ULL, 239280858627ULL, 529092143139ULL, 1568257451898804ULL,
+    447235128115ULL, 679678845236084ULL, 2167161349491220ULL, 1554184567314086709ULL,
+    165479003923ULL, 1428768988226596ULL, 977710670185060ULL, 10550024711307499077ULL,
+    1305410032576132ULL, 11779770265620358997ULL, 333446212255967269ULL, 978168444447012ULL,
+    162736434ULL, 35596216627ULL, 138295313843ULL, 891861543990356ULL,
+    692616541075ULL, 3151866750863876ULL, 100103641866564ULL, 6572336607016932133ULL,
+    215036012883ULL, 726936420696196ULL, 52433666ULL, 82160664963ULL,
+    2588613720361524ULL, 5802089162353039525ULL, 214799000387ULL, 144876322ULL,
+    668013605731ULL, 110616894681956ULL, 1601657732871812ULL, 430945547955ULL,
+    3156382366321172ULL, 7644494644932993285ULL, 3928124806469601813ULL, 3155990846772900ULL,
+    339991010498708ULL, 10743689387941597493ULL, 5103845475ULL, 105070898ULL,
+    3928064910068824213ULL, 156265010ULL, 1305138421793636ULL, 27185ULL,
+    195459938ULL, 567044449971ULL, 382447549283ULL, 2175279159592324ULL,
+    443529919251ULL, 195059004769796ULL, 2165424908404116ULL, 1554158691063110021ULL,
+    504228368803ULL, 1436350466655236ULL, 27584723588724ULL, 1900945754488837749ULL,
+    122971970ULL, 443829749251ULL, 302601798803ULL, 108558722ULL,
+    724700725875ULL, 43570095105972ULL, 2295263717447940ULL, 2860446751369014181ULL,
+    2165106202149444ULL, 69275726195ULL, 2860543885641537797ULL, 2165106320445780ULL,
+    2280890014640004ULL, 11820349930268368933ULL, 8721082628082003989ULL, 127050770ULL,
+    503707084675ULL, 122834978ULL, 2538193642857604ULL, 10129ULL,
+    801441490467ULL, 2923200302876740ULL, 1443359556281892ULL, 2901063790822564949ULL,
+    2728339631923524ULL, 7103874718248233397ULL, 12775311047932294245ULL, 95520290ULL,
+    2623783208098404ULL, 1900908618382410757ULL, 137742672547ULL, 2323440239468964ULL,
+    362478212387ULL, 727199575803140ULL, 73425410ULL, 34337ULL,
+    163101314ULL, 668566030659ULL, 801204361987ULL, 73030562ULL,
+    591509145619ULL, 162574594ULL, 100608342969108ULL, 5553ULL,
+    724147968595ULL, 1436604830452292ULL, 176259090ULL, 42001ULL,
+    143955266ULL, 2385ULL, 18433ULL, 0ULL,
+};
+
+} // namespace
+
+GridIsosurfaceExtractor::GridIsosurfaceExtractor(const double* values_, std::array<size_t, 3> steps_)
+    : values(values_), steps(steps_), blockSteps{0, 0, 0} {
+
+  for (size_t d = 0; d < 3; d++) {
+    if (steps[d] < 2) return; // no cells at all
+  }
+  for (size_t d = 0; d < 3; d++) {
+    blockSteps[d] = (steps[d] - 1 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  }
+  blockMin.resize(blockSteps[0] * blockSteps[1] * blockSteps[2]);
+  blockMax.resize(blockMin.size());
+
+  const size_t nY = steps[1];
+  const size_t nZ = steps[2];
+  parallelFor(
+      0, blockSteps[0],
+      [&](size_t start, size_t end) {
+        for (size_t bi = start; bi < end; bi++) {
+          size_t iEnd = std::min((bi + 1) * BLOCK_SIZE, steps[0] - 1);
+          for (size_t bj = 0; bj < blockSteps[1]; bj++) {
+            size_t jEnd = std::min((bj + 1) * BLOCK_SIZE, steps[1] - 1);
+            for (size_t bk = 0; bk < blockSteps[2]; bk++) {
+              size_t kEnd = std::min((bk + 1) * BLOCK_SIZE, steps[2] - 1);
+
+              // a block of cells touches the nodes on both of its boundaries
+              double vMin = std::numeric_limits<double>::infinity();
+              double vMax = -std::numeric_limits<double>::infinity();
+              for (size_t i = bi * BLOCK_SIZE; i <= iEnd; i++) {
+                for (size_t j = bj * BLOCK_SIZE; j <= jEnd; j++) {
+                  const double* row = values + (i * nY + j) * nZ;
+                  for (size_t k = bk * BLOCK_SIZE; k <= kEnd; k++) {
+                    vMin = std::min(vMin, row[k]);
+                    vMax = std::max(vMax, row[k]);
+                  }
+                }
+              }
+
+              size_t b = (bi * blockSteps[1] + bj) * blockSteps[2] + bk;
+              blockMin[b] = vMin;
+              blockMax[b] = vMax;
+            }
+          }
+        }
+      },
+      1);
+}
+
+IsosurfaceMesh GridIsosurfaceExtractor::extract(double level) const {
+  IsosurfaceMesh mesh;
+  if (blockMin.empty()) return mesh;
+
+  const size_t nX = steps[0];
+  const size_t nY = steps[1];
+  const size_t nZ = steps[2];
+  const size_t nLayers = nX - 1;
+  const size_t nSlabs = (nLayers + SLAB_LAYERS - 1) / SLAB_LAYERS;
+  const size_t planeSize = nY * nZ;
+
+  auto value = [&](size_t i, size_t j, size_t k) { return values[(i * nY + j) * nZ + k]; };
+
+  // Only blocks whose range straddles the level can contain a crossing edge or a non-empty cell
+  auto blockActive = [&](size_t bi, size_t bj, size_t bk) {
+    size_t b = (bi * blockSteps[1] + bj) * blockSteps[2] + bk;
+    return blockMin[b] < level && blockMax[b] >= level;
+  };
+  auto blockOfNode = [&](size_t n, size_t d) { return std::min(n / BLOCK_SIZE, blockSteps[d] - 1); };
+
+  // Central differences in index space, one-sided on the boundary
+  auto gradient = [&](std::array<size_t, 3> ind) {
+    glm::vec3 g;
+    for (size_t d = 0; d < 3; d++) {
+      std::array<size_t, 3> lo = ind;
+      std::array<size_t, 3> hi = ind;
+      if (lo[d] > 0) lo[d]--;
+      if (hi[d] + 1 < steps[d]) hi[d]++;
+      g[d] = (value(hi[0], hi[1], hi[2]) - value(lo[0], lo[1], lo[2])) / (hi[d] - lo[d]);
+    }
+    return g;
+  };
+
+  // Each slab meshes its own layers of cells. It creates the vertices on its first node plane and on the planes and
+  // layers in its interior, while the vertices on its last plane are created by the next slab, which emits its first
+  // plane before anything else. References to those are recorded as a rank within that plane and resolved afterwards.
+  std::vector<IsosurfaceMesh> slabMeshes(nSlabs);
+  parallelFor(
+      0, nSlabs,
+      [&](size_t slabStart, size_t slabEnd) {
+        // vertex index for each crossing edge: y- and z-edges of the current (A) and next (B) node planes, and x-edges
+        // in the layer between them; entries for other edges are stale and never read
+        std::vector<uint32_t> yEdgeA(planeSize), zEdgeA(planeSize), yEdgeB(planeSize), zEdgeB(planeSize);
+        std::vector<uint32_t> xEdge(planeSize);
+
+        for (size_t iSlab = slabStart; iSlab < slabEnd; iSlab++) {
+          IsosurfaceMesh& out = slabMeshes[iSlab];
+          size_t layerStart = iSlab * SLAB_LAYERS;
+          size_t layerEnd = std::min(layerStart + SLAB_LAYERS, nLayers);
+          uint32_t nNextSlab = 0;
+
+          auto processEdge = [&](size_t i, size_t j, size_t k, size_t d, uint32_t& vertexInd, bool inNextSlab) {
+            std::array<size_t, 3> a{i, j, k};
+            std::array<size_t, 3> b = a;
+            b[d]++;
+            double va = value(a[0], a[1], a[2]) - level;
+            double vb = value(b[0], b[1], b[2]) - level;
+            if (std::isnan(va) || std::isnan(vb) || (va < 0.) == (vb < 0.)) return;
+
+            if (inNextSlab) {
+              vertexInd = NEXT_SLAB_BIT | nNextSlab++;
+              return;
+            }
+
+            float t = static_cast<float>(va / (va - vb));
+            glm::vec3 p{i, j, k};
+            p[d] += t;
+            glm::vec3 n = (1.f - t) * gradient(a) + t * gradient(b);
+            if (!(glm::dot(n, n) > 0.f)) {
+              n = glm::vec3{0., 0., 0.};
+              n[d] = vb > va ? 1.f : -1.f;
+            }
+
+            vertexInd = static_cast<uint32_t>(out.vertices.size());
+            out.vertices.push_back(p);
+            out.normals.push_back(glm::normalize(n));
+          };
+
+          // the y- and z-edges in node plane i
+          auto scanPlane = [&](size_t i, std::vector<uint32_t>& yEdge, std::vector<uint32_t>& zEdge, bool inNextSlab) {
+            size_t bi = blockOfNode(i, 0);
+            for (size_t j = 0; j < nY; j++) {
+              size_t bj = blockOfNode(j, 1);
+              for (size_t bk = 0; bk < blockSteps[2]; bk++) {
+                if (!blockActive(bi, bj, bk)) continue;
+                size_t kEnd = (bk + 1 == blockSteps[2]) ? nZ : (bk + 1) * BLOCK_SIZE;
+                for (size_t k = bk * BLOCK_SIZE; k < kEnd; k++) {
+                  if (j + 1 < nY) processEdge(i, j, k, 1, yEdge[j * nZ + k], inNextSlab);
+                  if (k + 1 < nZ) processEdge(i, j, k, 2, zEdge[j * nZ + k], inNextSlab);
+                }
+              }
+            }
+          };
+
+          // the x-edges between node planes i and i+1
+          auto scanLayer = [&](size_t i) {
+            size_t bi = blockOfNode(i, 0);
+            for (size_t j = 0; j < nY; j++) {
+              size_t bj = blockOfNode(j, 1);
+              for (size_t bk = 0; bk < blockSteps[2]; bk++) {
+                if (!blockActive(bi, bj, bk)) continue;
+                size_t kEnd = (bk + 1 == blockSteps[2]) ? nZ : (bk + 1) * BLOCK_SIZE;
+                for (size_t k = bk * BLOCK_SIZE; k < kEnd; k++) {
+                  processEdge(i, j, k, 0, xEdge[j * nZ + k], false);
+                }
+              }
+            }
+          };
+
+          // triangles for the cells between node planes i and i+1
+          auto meshCells = [&](size_t i) {
+            size_t bi = i / BLOCK_SIZE;
+            for (size_t j = 0; j + 1 < nY; j++) {
+              size_t bj = j / BLOCK_SIZE;
+              for (size_t bk = 0; bk < blockSteps[2]; bk++) {
+                if (!blockActive(bi, bj, bk)) continue;
+                size_t kEnd = std::min((bk + 1) * BLOCK_SIZE, nZ - 1);
+                for (size_t k = bk * BLOCK_SIZE; k < kEnd; k++) {
+
+                  int config = 0;
+                  bool missing = false;
+                  for (int c = 0; c < 8; c++) {
+                    double v = value(i + (c & 1), j + ((c >> 1) & 1), k + ((c >> 2) & 1));
+                    if (v < level) config |= (1 << c);
+                    missing = missing || std::isnan(v);
+                  }
+                  if (missing || config == 0 || config == 255) continue;
+
+                  size_t jk = j * nZ + k;
+                  const uint32_t edges[12] = {
+                      xEdge[jk],       xEdge[jk + nZ],  xEdge[jk + 1],       xEdge[jk + nZ + 1], // along x
+                      yEdgeA[jk],      yEdgeB[jk],      yEdgeA[jk + 1],      yEdgeB[jk + 1],     // along y
+                      zEdgeA[jk],      zEdgeB[jk],      zEdgeA[jk + nZ],     zEdgeB[jk + nZ],    // along z
+                  };
+
+                  uint64_t entry = MC_TRIANGLE_TABLE[config];
+                  size_t nCorners = 3 * (entry & 0xF);
+                  for (size_t iC = 0; iC < nCorners; iC++) {
+                    out.indices.push_back(edges[(entry >> (4 * (iC + 1))) & 0xF]);
+                  }
+                }
+              }
+            }
+          };
+
+          scanPlane(layerStart, yEdgeA, zEdgeA, false);
+          for (size_t i = layerStart; i < layerEnd; i++) {
+            scanLayer(i);
+            bool nextInNextSlab = (i + 1 == layerEnd) && (layerEnd < nLayers);
+            scanPlane(i + 1, yEdgeB, zEdgeB, nextInNextSlab);
+            meshCells(i);
+            std::swap(yEdgeA, yEdgeB);
+            std::swap(zEdgeA, zEdgeB);
+          }
+        }
+      },
+      1);
+
+  // Concatenate the slabs, resolving references to the next slab's first plane
+  std::vector<size_t> vertexStart(nSlabs + 1, 0);
+  std::vector<size_t> indexStart(nSlabs + 1, 0);
+  for (size_t iSlab = 0; iSlab < nSlabs; iSlab++) {
+    vertexStart[iSlab + 1] = vertexStart[iSlab] + slabMeshes[iSlab].vertices.size();
+    indexStart[iSlab + 1] = indexStart[iSlab] + slabMeshes[iSlab].indices.size();
+  }
+  if (vertexStart[nSlabs] >= NEXT_SLAB_BIT) {
+    exception("isosurface has too many vertices (" + std::to_string(vertexStart[nSlabs]) + ")");
+  }
+
+  mesh.vertices.resize(vertexStart[nSlabs]);
+  mesh.normals.resize(vertexStart[nSlabs]);
+  mesh.indices.resize(indexStart[nSlabs]);
+  parallelFor(
+      0, nSlabs,
+      [&](size_t start, size_t end) {
+        for (size_t iSlab = start; iSlab < end; iSlab++) {
+          IsosurfaceMesh& slab = slabMeshes[iSlab];
+          std::copy(slab.vertices.begin(), slab.vertices.end(), mesh.vertices.begin() + vertexStart[iSlab]);
+          std::copy(slab.normals.begin(), slab.normals.end(), mesh.normals.begin() + vertexStart[iSlab]);
+          for (size_t iInd = 0; iInd < slab.indices.size(); iInd++) {
+            uint32_t ind = slab.indices[iInd];
+            if (ind & NEXT_SLAB_BIT) {
+              ind = static_cast<uint32_t>(vertexStart[iSlab + 1] + (ind & ~NEXT_SLAB_BIT));
+            } else {
+              ind = static_cast<uint32_t>(vertexStart[iSlab] + ind);
+            }
+            mesh.indices[indexStart[iSlab] + iInd] = ind;
+          }
+          slab = IsosurfaceMesh(); // release as we go
+        }
+      },
+      1);
+
+  return mesh;
+}
+
+} // namespace polyscope
@@ -6,6 +6,8 @@
 
 #include "imgui_internal.h"
 
+#include <unordered_set>
+
 namespace {
 bool CheckboxTristate(const char* label, int* v_tristate) {
   bool ret;
@@ -247,20 +249,63 @@ void Group::cullExpiredChildren() {
 }
 
 Group* Group::setEnabled(bool newEnabled) {
-  for (std::weak_ptr<Group>& childWeak : childrenGroups) {
-    std::shared_ptr<Group> child = childWeak.lock();
-    if (child) {
-      child->setEnabled(newEnabled);
+  forEachStructure([&](Structure& s) { s.setEnabled(newEnabled); });
+  return this;
+}
+
+void Group::setTransform(glm::mat4x4 transform) {
+  forEachStructure([&](Structure& s) { s.setTransform(transform); });
+}
+
+void Group::translate(glm::vec3 vec) {
+  forEachStructure([&](Structure& s) { s.translate(vec); });
+}
+
+void Group::resetTransform() {
+  forEachStructure([&](Structure& s) { s.resetTransform(); });
+}
+
+void Group::forEachStructure(const std::function<void(Structure&)>& func) {
+  std::vector<Structure*> structures = getDescendantStructures();
+
+  internal::beginStructureExtentsBatch();
+  try {
+    for (Structure* s : structures) {
+      func(*s);
     }
+  } catch (...) {
+    internal::endStructureExtentsBatch();
+    throw;
   }
+  internal::endStructureExtentsBatch();
+}
 
-  for (std::weak_ptr<Structure>& childWeak : childrenStructures) {
-    std::shared_ptr<Structure> child = childWeak.lock();
-    if (child) {
-      child->setEnabled(newEnabled);
+std::vector<Structure*> Group::getDescendantStructures() {
+  std::vector<Structure*> result;
+  std::unordered_set<Structure*> seenStructures;
+  std::unordered_set<Group*> seenGroups;
+
+  std::vector<Group*> toVisit{this};
+  seenGroups.insert(this);
+  while (!toVisit.empty()) {
+    Group* g = toVisit.back();
+    toVisit.pop_back();
+
+    for (std::weak_ptr<Structure>& childWeak : g->childrenStructures) {
+      std::shared_ptr<Structure> child = childWeak.lock();
+      if (child && seenStructures.insert(child.get()).second) {
+        result.push_back(child.get());
+      }
+    }
+    for (std::weak_ptr<Group>& childWeak : g->childrenGroups) {
+      std::shared_ptr<Group> child = childWeak.lock();
+      if (child && seenGroups.insert(child.get()).second) {
+        toVisit.push_back(child.get());
+      }
     }
   }
-  return this;
+
+  return result;
 }
 
 bool Group::isRootGroup() { return !parentGroup.expired(); }
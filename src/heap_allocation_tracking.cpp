@@ -0,0 +1,59 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/profiling.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Heap allocation counting, see profiling::heapAllocationTrackingEnabled(). When POLYSCOPE_TRACK_HEAP_ALLOCATIONS is
+// defined, this replaces the global allocation functions of the whole program, so it is off by default.
+
+namespace polyscope {
+namespace profiling {
+
+namespace {
+std::atomic<uint64_t> heapAllocationCounter(0);
+}
+
+bool heapAllocationTrackingEnabled() {
+#ifdef POLYSCOPE_TRACK_HEAP_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t getHeapAllocationCount() { return heapAllocationCounter.load(std::memory_order_relaxed); }
+
+#ifdef POLYSCOPE_TRACK_HEAP_ALLOCATIONS
+namespace {
+void* countedAllocate(std::size_t n) {
+  heapAllocationCounter.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(n == 0 ? 1 : n);
+}
+} // namespace
+#endif
+
+} // namespace profiling
+} // namespace polyscope
+
+#ifdef POLYSCOPE_TRACK_HEAP_ALLOCATIONS
+
+void* operator new(std::size_t n) {
+  void* p = polyscope::profiling::countedAllocate(n);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return polyscope::profiling::countedAllocate(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+  return polyscope::profiling::countedAllocate(n);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif
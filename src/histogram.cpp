@@ -3,6 +3,7 @@
 #include "polyscope/histogram.h"
 
 #include "polyscope/affine_remapper.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 
 #include "imgui.h"
@@ -13,69 +14,201 @@
 
 namespace polyscope {
 
+// The images are drawn at a 4:1 aspect, so each cell is that shape. Pages have a fixed number of cells and never grow,
+// since once ImGui has been handed a texture it must stay alive until the frame is drawn.
+struct Histogram::AtlasPage {
+  static const unsigned int cellSizeX = 600;
+  static const unsigned int cellSizeY = 150;
+  static const size_t nCells = 16;
+
+  std::shared_ptr<render::TextureBuffer> texture;
+  std::shared_ptr<render::FrameBuffer> framebuffer;
+  std::vector<char> cellUsed = std::vector<char>(nCells, false);
+};
+
+std::vector<std::weak_ptr<Histogram::AtlasPage>> Histogram::atlasPages;
+
 Histogram::Histogram() {}
 
 Histogram::Histogram(std::vector<double>& values) { buildHistogram(values); }
 
-Histogram::~Histogram() {}
+Histogram::~Histogram() {
+  if (atlasPage) atlasPage->cellUsed[atlasCell] = false;
+}
+
+size_t Histogram::getAtlasPageCount() {
+  size_t count = 0;
+  for (const std::weak_ptr<AtlasPage>& page : atlasPages) {
+    if (!page.expired()) count++;
+  }
+  return count;
+}
+
+void Histogram::acquireAtlasCell() {
+
+  // Take a free cell in an existing page if there is one
+  for (const std::weak_ptr<AtlasPage>& weakPage : atlasPages) {
+    std::shared_ptr<AtlasPage> page = weakPage.lock();
+    if (!page) continue;
+    for (size_t iCell = 0; iCell < AtlasPage::nCells; iCell++) {
+      if (page->cellUsed[iCell]) continue;
+      page->cellUsed[iCell] = true;
+      atlasPage = page;
+      atlasCell = iCell;
+      return;
+    }
+  }
+
+  // Otherwise start a new page
+  std::shared_ptr<AtlasPage> page = std::make_shared<AtlasPage>();
+  unsigned int sizeX = AtlasPage::cellSizeX;
+  unsigned int sizeY = AtlasPage::cellSizeY * AtlasPage::nCells;
+  page->framebuffer = render::engine->generateFrameBuffer(sizeX, sizeY);
+  page->texture = render::engine->generateTextureBuffer(TextureFormat::RGBA8, sizeX, sizeY);
+  page->texture->setMemoryOwner("histograms");
+  page->framebuffer->addColorBuffer(page->texture);
+  page->cellUsed[0] = true;
+  atlasPages.erase(std::remove_if(atlasPages.begin(), atlasPages.end(),
+                                  [](const std::weak_ptr<AtlasPage>& p) { return p.expired(); }),
+                   atlasPages.end());
+  atlasPages.push_back(page);
+  atlasPage = page;
+  atlasCell = 0;
+}
 
 void Histogram::buildHistogram(const std::vector<double>& values) {
+  buildHistogramFromValues(values, robustMinMax(values));
+}
 
-  // Build arrays of values
-  size_t N = values.size();
+void Histogram::buildHistogram(const std::vector<float>& values) {
+  buildHistogramFromValues(values, robustMinMax(values));
+}
 
-  // == Build histogram
-  dataRange = robustMinMax(values);
-  colormapRange = dataRange;
+void Histogram::buildHistogram(const std::vector<double>& values, std::pair<double, double> valueRange) {
+  buildHistogramFromValues(values, valueRange);
+}
 
-  // Helper to build the four histogram variants
-  auto buildCurve = [&](size_t binCount, std::vector<std::array<float, 2>>& curveX, std::vector<float>& curveY) {
-    // linspace coords
-    double range = dataRange.second - dataRange.first;
-    double inc = range / binCount;
-    std::vector<double> sumBin(binCount, 0.0);
+void Histogram::buildHistogram(const std::vector<float>& values, std::pair<double, double> valueRange) {
+  buildHistogramFromValues(values, valueRange);
+}
 
-    // count values in buckets
-    for (size_t iData = 0; iData < N; iData++) {
+void Histogram::buildHistogram(std::shared_ptr<render::AttributeBuffer> values,
+                               std::pair<double, double> valueRange) {
 
-      double iBinf = binCount * (values[iData] - dataRange.first) / range;
-      size_t iBin = std::floor(glm::clamp(iBinf, 0.0, (double)binCount - 1));
+  dataRange = valueRange;
+  colormapRange = dataRange;
+  size_t binCount = rawHistBinCount;
+
+  // Splat each value as a point on to its bin's pixel, summing with additive blending. Only the bin counts are read
+  // back, not the values.
+  if (!binFramebuffer) {
+    binTexture = render::engine->generateTextureBuffer(TextureFormat::RGBA32F, binCount, 1);
+    binFramebuffer = render::engine->generateFrameBuffer(binCount, 1);
+    binFramebuffer->addColorBuffer(binTexture);
+    binProgram = render::engine->requestShader("HISTOGRAM_BIN", {}, render::ShaderReplacementDefaults::Process);
+  }
+  binProgram->setAttribute("a_value", values);
+  binProgram->setUniform("u_dataRangeMin", dataRange.first);
+  binProgram->setUniform("u_dataRangeMax", dataRange.second);
+  binProgram->setUniform("u_binCount", static_cast<float>(binCount));
+
+  binFramebuffer->clearColor = {0.0, 0.0, 0.0};
+  binFramebuffer->clearAlpha = 0.0;
+  binFramebuffer->setViewport(0, 0, binCount, 1);
+  binFramebuffer->bindForRendering();
+  binFramebuffer->clear();
+  render::engine->setDepthMode(DepthMode::Disable);
+  render::engine->setBlendMode(BlendMode::WeightedAdd);
+  binProgram->draw();
+  render::engine->setBlendMode();
+  render::engine->setDepthMode();
+
+  std::vector<float> binPixels = binFramebuffer->readFloat4Region(0, 0, binCount, 1);
+  std::vector<double> binCounts(binCount);
+  for (size_t iBin = 0; iBin < binCount; iBin++) {
+    binCounts[iBin] = binPixels[4 * iBin];
+  }
+  buildCurvesFromCounts(binCounts);
+}
 
-      // NaN values and finite values near the bottom of float range lead to craziness, so only increment bins if we got
-      // something reasonable
-      if (iBin < binCount) {
-        sumBin[iBin] += 1.0;
-      }
-    }
+template <typename T>
+void Histogram::buildHistogramFromValues(const std::vector<T>& values, std::pair<double, double> valueRange) {
 
+  // Build arrays of values
+  size_t N = values.size();
 
-    // build histogram coords
-    curveX = std::vector<std::array<float, 2>>(binCount);
-    curveY = std::vector<float>(binCount);
-    double prevSumU = 0.0;
-    double prevSumW = 0.0;
-    double prevXEnd = dataRange.first;
+  // == Build histogram
+  dataRange = valueRange;
+  colormapRange = dataRange;
+  size_t binCount = rawHistBinCount;
+  double range = dataRange.second - dataRange.first;
+
+  // count values in buckets, in fixed-size chunks in parallel, then sum the per-chunk counts
+  const size_t chunkSize = 1 << 16;
+  size_t nChunks = (N + chunkSize - 1) / chunkSize;
+  std::vector<size_t> chunkBins(nChunks * binCount, 0);
+  parallelFor(
+      0, nChunks,
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          size_t* bins = &chunkBins[iC * binCount];
+          size_t iEnd = std::min(N, (iC + 1) * chunkSize);
+          for (size_t iData = iC * chunkSize; iData < iEnd; iData++) {
+
+            double iBinf = binCount * (values[iData] - dataRange.first) / range;
+            size_t iBin = std::floor(glm::clamp(iBinf, 0.0, (double)binCount - 1));
+
+            // NaN values and finite values near the bottom of float range lead to craziness, so only increment bins
+            // if we got something reasonable
+            if (iBin < binCount) {
+              bins[iBin]++;
+            }
+          }
+        }
+      },
+      1);
+  std::vector<double> sumBin(binCount, 0.0);
+  for (size_t iC = 0; iC < nChunks; iC++) {
     for (size_t iBin = 0; iBin < binCount; iBin++) {
-      // y value
-      curveY[iBin] = sumBin[iBin];
-
-      // x value
-      double xEnd = prevXEnd + inc;
-      curveX[iBin] = {{static_cast<float>(prevXEnd), static_cast<float>(xEnd)}};
-      prevXEnd = xEnd;
+      sumBin[iBin] += chunkBins[iC * binCount + iBin];
     }
+  }
+
+  buildCurvesFromCounts(sumBin);
+}
 
-    { // Rescale curves to [0,1] in both dimensions
-      double maxHeight = *std::max_element(curveY.begin(), curveY.end());
-      for (size_t i = 0; i < binCount; i++) {
-        curveX[i][0] = (curveX[i][0] - dataRange.first) / range;
-        curveX[i][1] = (curveX[i][1] - dataRange.first) / range;
-        curveY[i] /= maxHeight;
-      }
+void Histogram::buildCurvesFromCounts(const std::vector<double>& binCounts) {
+
+  // linspace coords
+  size_t binCount = binCounts.size();
+  double range = dataRange.second - dataRange.first;
+  double inc = range / binCount;
+
+  // build histogram coords
+  rawHistCurveX = std::vector<std::array<float, 2>>(binCount);
+  rawHistCurveY = std::vector<float>(binCount);
+  double prevXEnd = dataRange.first;
+  for (size_t iBin = 0; iBin < binCount; iBin++) {
+    // y value
+    rawHistCurveY[iBin] = binCounts[iBin];
+
+    // x value
+    double xEnd = prevXEnd + inc;
+    rawHistCurveX[iBin] = {{static_cast<float>(prevXEnd), static_cast<float>(xEnd)}};
+    prevXEnd = xEnd;
+  }
+
+  { // Rescale curves to [0,1] in both dimensions
+    double maxHeight = *std::max_element(rawHistCurveY.begin(), rawHistCurveY.end());
+    for (size_t i = 0; i < binCount; i++) {
+      rawHistCurveX[i][0] = (rawHistCurveX[i][0] - dataRange.first) / range;
+      rawHistCurveX[i][1] = (rawHistCurveX[i][1] - dataRange.first) / range;
+      if (maxHeight > 0) rawHistCurveY[i] /= maxHeight;
     }
-  };
+  }
 
-  buildCurve(rawHistBinCount, rawHistCurveX, rawHistCurveY);
+  // the drawing program holds the old curve, it gets re-created on the next draw
+  program.reset();
 }
 
 
@@ -133,9 +266,8 @@ void Histogram::fillBuffers() {
 
 void Histogram::prepare() {
 
-  framebuffer = render::engine->generateFrameBuffer(texDim, texDim);
-  texture = render::engine->generateTextureBuffer(TextureFormat::RGBA8, texDim, texDim);
-  framebuffer->addColorBuffer(texture);
+  if (!atlasPage) acquireAtlasCell();
+  textureValid = false;
 
   // Create the program
   program = render::engine->requestShader("HISTOGRAM", {}, render::ShaderReplacementDefaults::Process);
@@ -151,12 +283,15 @@ void Histogram::renderToTexture() {
   if (!program) {
     prepare();
   }
+  if (textureValid && renderedColormapRange == colormapRange) return;
 
-  framebuffer->clearColor = {0.0, 0.0, 0.0};
-  framebuffer->clearAlpha = 0.2;
-  framebuffer->setViewport(0, 0, texDim, texDim);
-  framebuffer->bindForRendering();
-  framebuffer->clear();
+  render::FrameBuffer& framebuffer = *atlasPage->framebuffer;
+  int cellStartY = static_cast<int>(atlasCell * AtlasPage::cellSizeY);
+  framebuffer.clearColor = {0.0, 0.0, 0.0};
+  framebuffer.clearAlpha = 0.2;
+  framebuffer.setViewport(0, cellStartY, AtlasPage::cellSizeX, AtlasPage::cellSizeY);
+  framebuffer.bindForRendering();
+  framebuffer.clearRegion(0, cellStartY, AtlasPage::cellSizeX, AtlasPage::cellSizeY);
 
   // = Set uniforms
 
@@ -167,12 +302,17 @@ void Histogram::renderToTexture() {
 
   // Draw
   program->draw();
+
+  textureValid = true;
+  renderedColormapRange = colormapRange;
+  textureRenderCount++;
 }
 
 
 void Histogram::buildUI(float width) {
 
   // NOTE: I'm surprised this works, since we're drawing in the middle of imgui's processing. Possible source of bugs?
+  // (This only draws when something has changed.)
   renderToTexture();
 
   // Compute size for image
@@ -183,8 +323,10 @@ void Histogram::buildUI(float width) {
   }
   float h = w / aspect;
 
-  // Render image
-  ImGui::Image(texture->getNativeHandle(), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0));
+  // Render image, this histogram's cell of the atlas page
+  float cellTop = static_cast<float>(atlasCell + 1) / AtlasPage::nCells;
+  float cellBottom = static_cast<float>(atlasCell) / AtlasPage::nCells;
+  ImGui::Image(atlasPage->texture->getNativeHandle(), ImVec2(w, h), ImVec2(0, cellTop), ImVec2(1, cellBottom));
 
   // Helpful info for drawing annotations below
   ImU32 annoColor = ImGui::ColorConvertFloat4ToU32(ImVec4(254 / 255., 221 / 255., 66 / 255., 1.0));
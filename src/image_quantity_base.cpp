@@ -7,16 +7,41 @@
 
 #include "imgui.h"
 
+#include <set>
+
 namespace polyscope {
 
+namespace {
+
+std::set<ImageQuantity*>& liveImageQuantities() {
+  static std::set<ImageQuantity*> quantities;
+  return quantities;
+}
+
+int textureUploadsThisFrame = 0;
+
+} // namespace
+
+namespace internal {
+void pageImageTextures() {
+  textureUploadsThisFrame = 0;
+  if (!options::imageTexturePaging) return;
+  for (ImageQuantity* q : liveImageQuantities()) {
+    if (!q->shownSinceLastPaging) q->releaseTextures();
+    q->shownSinceLastPaging = false;
+  }
+}
+} // namespace internal
 
 ImageQuantity::ImageQuantity(Structure& parent_, std::string name_, size_t dimX_, size_t dimY_,
-                             ImageOrigin imageOrigin_)
+                             ImageOrigin imageOrigin_, TextureFormat defaultTextureFormat_)
     : FloatingQuantity(name_, parent_), parent(parent_), dimX(dimX_), dimY(dimY_), imageOrigin(imageOrigin_),
       transparency(uniquePrefix() + "transparency", 1.0),
       isShowingFullscreen(uniquePrefix() + "isShowingFullscreen", false),
       isShowingImGuiWindow(uniquePrefix() + "isShowingImGuiWindow", true),
-      isShowingCameraBillboard(uniquePrefix() + "isCameraBillboard", false) {
+      isShowingCameraBillboard(uniquePrefix() + "isCameraBillboard", false), textureFormat(defaultTextureFormat_) {
+
+  liveImageQuantities().insert(this);
 
   parentStructureCameraView = dynamic_cast<CameraView*>(&parent);
   if (parentIsCameraView()) {
@@ -26,10 +51,13 @@ ImageQuantity::ImageQuantity(Structure& parent_, std::string name_, size_t dimX_
   }
 }
 
+ImageQuantity::~ImageQuantity() { liveImageQuantities().erase(this); }
+
 void ImageQuantity::draw() {
   if (!isEnabled()) return;
 
   if (getShowInImGuiWindow()) {
+    shownSinceLastPaging = true;
     renderIntermediate();
   }
 }
@@ -37,10 +65,12 @@ void ImageQuantity::draw() {
 void ImageQuantity::drawDelayed() {
   if (!isEnabled()) return;
   if (getShowFullscreen()) {
+    shownSinceLastPaging = true;
     showFullscreen();
   }
 
   if (getShowInCameraBillboard()) {
+    shownSinceLastPaging = true;
     glm::vec3 billboardCenter, billboardUp, billboardRight;
     std::tie(billboardCenter, billboardUp, billboardRight) = parentStructureCameraView->getFrameBillboardGeometry();
 
@@ -90,6 +120,27 @@ void ImageQuantity::setTransparency(float newVal) {
 
 float ImageQuantity::getTransparency() { return transparency.get(); }
 
+void ImageQuantity::setTextureFormat(TextureFormat newFormat) {
+  if (!textureFormatSupported(newFormat)) {
+    exception("texture format not supported by image quantity " + name);
+    return;
+  }
+  textureFormat = newFormat;
+  releaseTextures();
+  requestRedraw();
+}
+TextureFormat ImageQuantity::getTextureFormat() { return textureFormat; }
+
+bool ImageQuantity::acquireTextureUpload() {
+  if (!options::imageTexturePaging || options::imageTextureUploadsPerFrame <= 0) return true;
+  if (textureUploadsThisFrame >= options::imageTextureUploadsPerFrame) {
+    requestRedraw(); // try again next frame
+    return false;
+  }
+  textureUploadsThisFrame++;
+  return true;
+}
+
 bool ImageQuantity::parentIsCameraView() { return parentStructureCameraView != nullptr; }
 
 void ImageQuantity::buildImageOptionsUI() {
@@ -123,6 +174,7 @@ void ImageQuantity::buildImageUI() {
 
   if (isEnabled() && parent.isEnabled()) {
     if (getShowInImGuiWindow()) {
+      shownSinceLastPaging = true;
       showInImGuiWindow();
     }
   }
@@ -0,0 +1,60 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/implicit_helpers.h"
+
+#include "polyscope/cached_implicit_surface_quantity.h"
+#include "polyscope/implicit_surface_glsl_quantity.h"
+
+#include <map>
+
+namespace polyscope {
+namespace internal {
+
+namespace {
+struct ImplicitRenderView {
+  glm::mat4x4 viewMat;
+  float fovVerticalDegrees;
+  float aspectRatio;
+  int32_t dimX, dimY;
+};
+std::map<std::string, ImplicitRenderView> lastImplicitRenderViews;
+} // namespace
+
+bool implicitRenderViewChanged(std::string key, const CameraParameters& params, int32_t dimX, int32_t dimY) {
+  ImplicitRenderView newView{params.getViewMat(), params.getFoVVerticalDegrees(), params.getAspectRatioWidthOverHeight(),
+                             dimX, dimY};
+
+  auto it = lastImplicitRenderViews.find(key);
+  bool changed = it == lastImplicitRenderViews.end() || it->second.viewMat != newView.viewMat ||
+                 it->second.fovVerticalDegrees != newView.fovVerticalDegrees ||
+                 it->second.aspectRatio != newView.aspectRatio || it->second.dimX != newView.dimX ||
+                 it->second.dimY != newView.dimY;
+
+  lastImplicitRenderViews[key] = newView;
+  return changed;
+}
+
+} // namespace internal
+
+CachedImplicitSurfaceQuantity* renderImplicitSurfaceCachedBatch(std::string name,
+                                                                std::function<void(const float*, float*, size_t)> func,
+                                                                ImplicitRenderMode mode, ImplicitRenderOpts opts) {
+  checkInitialized();
+
+  FloatingQuantityStructure* parent = getGlobalFloatingQuantityStructure();
+  CachedImplicitSurfaceQuantity* q = new CachedImplicitSurfaceQuantity(*parent, name, func, mode, opts);
+  parent->addQuantity(q);
+  return q;
+}
+
+ImplicitSurfaceGLSLQuantity* renderImplicitSurfaceGLSL(std::string name, std::string functionBody,
+                                                       ImplicitRenderMode mode, ImplicitRenderOpts opts) {
+  checkInitialized();
+
+  FloatingQuantityStructure* parent = getGlobalFloatingQuantityStructure();
+  ImplicitSurfaceGLSLQuantity* q = new ImplicitSurfaceGLSLQuantity(*parent, name, functionBody, mode, opts);
+  parent->addQuantity(q);
+  return q;
+}
+
+} // namespace polyscope
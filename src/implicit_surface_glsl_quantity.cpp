@@ -0,0 +1,141 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/polyscope.h"
+
+#include "polyscope/implicit_surface_glsl_quantity.h"
+#include "polyscope/view.h"
+
+#include "imgui.h"
+
+namespace polyscope {
+
+
+ImplicitSurfaceGLSLQuantity::ImplicitSurfaceGLSLQuantity(Structure& parent_, std::string name,
+                                                         std::string functionBody_, ImplicitRenderMode mode_,
+                                                         ImplicitRenderOpts opts_)
+    : FloatingQuantity(name, parent_), functionBody(functionBody_), mode(mode_), opts(opts_),
+      color(uniquePrefix() + "#color", getNextUniqueColor()), material(uniquePrefix() + "#material", "clay"),
+      transparency(uniquePrefix() + "#transparency", 1.0) {
+  registerFunctionRule();
+}
+
+void ImplicitSurfaceGLSLQuantity::draw() {}
+
+void ImplicitSurfaceGLSLQuantity::drawDelayed() {
+  if (!isEnabled()) return;
+
+  if (!program) prepare();
+
+  // set uniforms
+  glm::mat4 viewMat = view::getCameraViewMatrix();
+  glm::mat4 invViewMat = glm::inverse(viewMat);
+  program->setUniform("u_viewMatrix", glm::value_ptr(viewMat));
+  program->setUniform("u_invViewMatrix", glm::value_ptr(invViewMat));
+  program->setUniform("u_missDist", opts.missDist.asAbsolute());
+  program->setUniform("u_hitDist", opts.hitDist.asAbsolute());
+  program->setUniform("u_stepFactor", opts.stepFactor);
+  program->setUniform("u_stepSize", opts.stepSize.asAbsolute());
+  program->setUniform("u_normalSampleEps", opts.normalSampleEps);
+  program->setUniform("u_nMaxSteps", static_cast<int>(opts.nMaxSteps));
+  program->setUniform("u_sphereMarch", mode == ImplicitRenderMode::SphereMarch ? 1 : 0);
+  program->setUniform("u_baseColor", color.get());
+  program->setUniform("u_transparency", transparency.get());
+
+  // make sure we have actual depth testing enabled
+  render::engine->setDepthMode(DepthMode::LEqual);
+  render::engine->setBlendMode(BlendMode::Over);
+
+  // draw
+  program->draw();
+}
+
+void ImplicitSurfaceGLSLQuantity::buildCustomUI() {
+  ImGui::SameLine();
+
+  if (ImGui::ColorEdit3("color", &color.get()[0], ImGuiColorEditFlags_NoInputs)) {
+    setColor(getColor());
+  }
+  ImGui::SameLine();
+
+  // == Options popup
+  if (ImGui::Button("Options")) {
+    ImGui::OpenPopup("OptionsPopup");
+  }
+  if (ImGui::BeginPopup("OptionsPopup")) {
+
+    if (ImGui::BeginMenu("Transparency")) {
+      if (ImGui::SliderFloat("Alpha", &transparency.get(), 0., 1., "%.3f")) setTransparency(transparency.get());
+      ImGui::EndMenu();
+    }
+
+    if (render::buildMaterialOptionsGui(material.get())) {
+      material.manuallyChanged();
+      setMaterial(material.get()); // trigger the other updates that happen on set()
+    }
+
+    ImGui::EndPopup();
+  }
+}
+
+void ImplicitSurfaceGLSLQuantity::refresh() {
+  program = nullptr;
+  Quantity::refresh();
+}
+
+void ImplicitSurfaceGLSLQuantity::registerFunctionRule() {
+  functionRuleName = uniquePrefix() + "#implicitFunction#" + std::to_string(functionRevision++);
+  std::string source = "float implicitFunction(vec3 p) {\n" + functionBody + "\n}\n";
+  render::ShaderReplacementRule rule(functionRuleName, {{"IMPLICIT_FUNCTION", source}});
+  render::engine->registerShaderRule(functionRuleName, rule);
+}
+
+void ImplicitSurfaceGLSLQuantity::prepare() {
+  program = render::engine->requestShader("IMPLICIT_SURFACE_GLSL",
+                                          {functionRuleName, "LIGHT_MATCAP", "SHADE_BASECOLOR"},
+                                          render::ShaderReplacementDefaults::Process);
+
+  program->setAttribute("a_position", render::engine->screenTrianglesCoords());
+  render::engine->setMaterial(*program, material.get());
+}
+
+
+std::string ImplicitSurfaceGLSLQuantity::niceName() { return name + " (implicit surface)"; }
+
+ImplicitSurfaceGLSLQuantity* ImplicitSurfaceGLSLQuantity::setEnabled(bool newEnabled) {
+  enabled = newEnabled;
+  requestRedraw();
+  return this;
+}
+
+ImplicitSurfaceGLSLQuantity* ImplicitSurfaceGLSLQuantity::setFunction(std::string newBody) {
+  functionBody = newBody;
+  registerFunctionRule();
+  refresh();
+  requestRedraw();
+  return this;
+}
+std::string ImplicitSurfaceGLSLQuantity::getFunction() { return functionBody; }
+
+ImplicitSurfaceGLSLQuantity* ImplicitSurfaceGLSLQuantity::setColor(glm::vec3 newVal) {
+  color = newVal;
+  polyscope::requestRedraw();
+  return this;
+}
+glm::vec3 ImplicitSurfaceGLSLQuantity::getColor() { return color.get(); }
+
+ImplicitSurfaceGLSLQuantity* ImplicitSurfaceGLSLQuantity::setMaterial(std::string m) {
+  material = m;
+  if (program) render::engine->setMaterial(*program, material.get());
+  requestRedraw();
+  return this;
+}
+std::string ImplicitSurfaceGLSLQuantity::getMaterial() { return material.get(); }
+
+ImplicitSurfaceGLSLQuantity* ImplicitSurfaceGLSLQuantity::setTransparency(float newVal) {
+  transparency = newVal;
+  requestRedraw();
+  return this;
+}
+float ImplicitSurfaceGLSLQuantity::getTransparency() { return transparency.get(); }
+
+} // namespace polyscope
@@ -10,6 +10,12 @@ uint64_t uniqueID = 42;
 uint64_t getNextUniqueID() { return uniqueID++; }
 
 bool pointCloudEfficiencyWarningReported = false;
+uint64_t renderSceneCount = 0;
+uint64_t structureDrawPassCount = 0;
+bool interactiveQualityActive = false;
+bool dynamicResolutionActive = false;
+uint64_t sceneContentVersion = 0;
+uint64_t dynamicContentChanges = 0;
 FloatingQuantityStructure* globalFloatingQuantityStructure = nullptr;
 
 } // namespace internal
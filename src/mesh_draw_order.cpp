@@ -0,0 +1,171 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/mesh_draw_order.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+namespace polyscope {
+
+namespace {
+
+// Parameters of the optimization, as suggested by Forsyth. The simulated cache is an LRU cache, which is larger than
+// real FIFO caches; the result does not depend much on matching the hardware.
+const int simulatedCacheSize = 32;
+const float cacheDecayPower = 1.5f;
+const float lastTriangleScore = 0.75f;
+const float valenceBoostScale = 2.0f;
+const float valenceBoostPower = 0.5f;
+
+// How much we would like to draw the triangles of a vertex next: a lot if it is recently used, and a lot if it has few
+// triangles left (so that it can drop out of the cache, rather than leaving stragglers to draw later)
+float vertexScore(int cachePosition, uint32_t nActiveTriangles) {
+  if (nActiveTriangles == 0) return -1.f;
+
+  float score = 0.f;
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      // used by the last triangle, so it is no better to draw it right away than soon
+      score = lastTriangleScore;
+    } else {
+      float scaler = 1.f / (simulatedCacheSize - 3);
+      score = std::pow(1.f - (cachePosition - 3) * scaler, cacheDecayPower);
+    }
+  }
+  score += valenceBoostScale * std::pow(static_cast<float>(nActiveTriangles), -valenceBoostPower);
+  return score;
+}
+
+} // namespace
+
+std::vector<uint32_t> optimizeTriangleOrderForVertexCache(const std::vector<uint32_t>& triVertexInds,
+                                                          size_t nVertices) {
+  const size_t nTri = triVertexInds.size() / 3;
+
+  // The triangles of each vertex, of which the first nActive[v] have not been drawn yet
+  std::vector<uint32_t> vertTriStart(nVertices + 1, 0);
+  for (uint32_t v : triVertexInds) vertTriStart[v + 1]++;
+  for (size_t v = 0; v < nVertices; v++) vertTriStart[v + 1] += vertTriStart[v];
+  std::vector<uint32_t> vertTris(triVertexInds.size());
+  std::vector<uint32_t> nActive(nVertices, 0);
+  for (size_t iT = 0; iT < nTri; iT++) {
+    for (size_t k = 0; k < 3; k++) {
+      uint32_t v = triVertexInds[3 * iT + k];
+      vertTris[vertTriStart[v] + nActive[v]++] = static_cast<uint32_t>(iT);
+    }
+  }
+
+  std::vector<int> cachePosition(nVertices, -1);
+  std::vector<float> vertScore(nVertices);
+  for (size_t v = 0; v < nVertices; v++) vertScore[v] = vertexScore(-1, nActive[v]);
+
+  std::vector<float> triScore(nTri);
+  int64_t best = -1;
+  for (size_t iT = 0; iT < nTri; iT++) {
+    triScore[iT] = vertScore[triVertexInds[3 * iT]] + vertScore[triVertexInds[3 * iT + 1]] +
+                   vertScore[triVertexInds[3 * iT + 2]];
+    if (best == -1 || triScore[iT] > triScore[best]) best = iT;
+  }
+
+  std::vector<char> triDrawn(nTri, false);
+  std::vector<uint32_t> order;
+  order.reserve(nTri);
+  std::vector<uint32_t> cache, newCache;
+  size_t nextUndrawn = 0;
+
+  while (order.size() < nTri) {
+
+    // When no triangle in the cache is left, start again from the next one in the original order
+    if (best == -1) {
+      while (triDrawn[nextUndrawn]) nextUndrawn++;
+      best = nextUndrawn;
+    }
+    uint32_t iT = static_cast<uint32_t>(best);
+    triDrawn[iT] = true;
+    order.push_back(iT);
+
+    // It is no longer active for its vertices
+    const uint32_t* tri = &triVertexInds[3 * iT];
+    for (size_t k = 0; k < 3; k++) {
+      uint32_t v = tri[k];
+      uint32_t* tris = &vertTris[vertTriStart[v]];
+      for (uint32_t i = 0; i < nActive[v];) {
+        if (tris[i] == iT) {
+          std::swap(tris[i], tris[--nActive[v]]);
+        } else {
+          i++;
+        }
+      }
+    }
+
+    // Its vertices move to the front of the cache
+    newCache.clear();
+    for (size_t k = 0; k < 3; k++) {
+      if (std::find(newCache.begin(), newCache.end(), tri[k]) == newCache.end()) newCache.push_back(tri[k]);
+    }
+    for (uint32_t v : cache) {
+      if (v != tri[0] && v != tri[1] && v != tri[2]) newCache.push_back(v);
+    }
+    for (size_t i = 0; i < newCache.size(); i++) {
+      cachePosition[newCache[i]] = i < static_cast<size_t>(simulatedCacheSize) ? static_cast<int>(i) : -1;
+    }
+
+    // Rescore the vertices which moved (including those pushed out), and their triangles, picking the best next
+    best = -1;
+    float bestScore = -1.f;
+    for (uint32_t v : newCache) {
+      vertScore[v] = vertexScore(cachePosition[v], nActive[v]);
+    }
+    for (uint32_t v : newCache) {
+      const uint32_t* tris = &vertTris[vertTriStart[v]];
+      for (uint32_t i = 0; i < nActive[v]; i++) {
+        uint32_t jT = tris[i];
+        const uint32_t* triJ = &triVertexInds[3 * jT];
+        triScore[jT] = vertScore[triJ[0]] + vertScore[triJ[1]] + vertScore[triJ[2]];
+        if (triScore[jT] > bestScore) {
+          bestScore = triScore[jT];
+          best = jT;
+        }
+      }
+    }
+
+    if (newCache.size() > static_cast<size_t>(simulatedCacheSize)) newCache.resize(simulatedCacheSize);
+    cache.swap(newCache);
+  }
+
+  return order;
+}
+
+std::vector<uint32_t> vertexOrderOfFirstUse(const std::vector<uint32_t>& triVertexInds, size_t nVertices) {
+  std::vector<char> used(nVertices, false);
+  std::vector<uint32_t> order;
+  order.reserve(nVertices);
+  for (uint32_t v : triVertexInds) {
+    if (!used[v]) {
+      used[v] = true;
+      order.push_back(v);
+    }
+  }
+  for (size_t v = 0; v < nVertices; v++) {
+    if (!used[v]) order.push_back(static_cast<uint32_t>(v));
+  }
+  return order;
+}
+
+double averageCacheMissRatio(const std::vector<uint32_t>& triVertexInds, size_t cacheSize) {
+  size_t nTri = triVertexInds.size() / 3;
+  if (nTri == 0) return 0.;
+
+  std::deque<uint32_t> cache;
+  size_t nMisses = 0;
+  for (uint32_t v : triVertexInds) {
+    if (std::find(cache.begin(), cache.end(), v) != cache.end()) continue;
+    nMisses++;
+    cache.push_back(v);
+    if (cache.size() > cacheSize) cache.pop_front();
+  }
+  return static_cast<double>(nMisses) / nTri;
+}
+
+} // namespace polyscope
@@ -0,0 +1,200 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/occlusion_culling.h"
+
+#include "polyscope/parallel.h"
+#include "polyscope/polyscope.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace polyscope {
+namespace occlusion {
+
+namespace {
+
+// The camera may move this far from where the depth was captured before culling is suspended
+const float maxCameraMotion = 0.02;          // relative to the length scale
+const float minCameraDirectionCos = 0.99939; // 2 degrees
+
+struct DepthPyramid {
+  std::vector<std::vector<float>> levels; // farthest depth per texel; level 0 is the full buffer
+  std::vector<std::array<size_t, 2>> sizes;
+
+  // The frame it was captured in
+  glm::mat4 viewProjMat;
+  glm::mat4 viewMat;
+  glm::vec3 cameraPosition;
+  glm::vec3 cameraDirection;
+  uint64_t sceneContentVersion;
+};
+
+std::shared_ptr<const DepthPyramid> latestPyramid;
+bool readbackPending = false;
+
+// The current frame
+std::shared_ptr<const DepthPyramid> framePyramid; // null if culling is not active
+glm::mat4 frameViewProjMat;
+bool frameDepthStale = false; // the pyramid is from a different view or scene
+std::atomic<size_t> culledCount{0};
+
+bool cullingApplies() {
+  return options::occlusionCulling && render::engine->getTransparencyMode() == TransparencyMode::None;
+}
+
+std::shared_ptr<DepthPyramid> buildPyramid(std::vector<float>& depth, size_t w, size_t h) {
+  std::shared_ptr<DepthPyramid> p = std::make_shared<DepthPyramid>();
+  p->levels.push_back(std::move(depth));
+  p->sizes.push_back({w, h});
+
+  while (w > 1 || h > 1) {
+    size_t prevW = w;
+    size_t prevH = h;
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+    const std::vector<float>& prev = p->levels.back();
+    std::vector<float> next(w * h);
+    parallelFor(
+        0, h,
+        [&](size_t start, size_t end) {
+          for (size_t y = start; y < end; y++) {
+            for (size_t x = 0; x < w; x++) {
+              size_t x0 = 2 * x;
+              size_t y0 = 2 * y;
+              size_t x1 = std::min(x0 + 1, prevW - 1);
+              size_t y1 = std::min(y0 + 1, prevH - 1);
+              next[y * w + x] = std::max(std::max(prev[y0 * prevW + x0], prev[y0 * prevW + x1]),
+                                         std::max(prev[y1 * prevW + x0], prev[y1 * prevW + x1]));
+            }
+          }
+        },
+        16);
+    p->levels.push_back(std::move(next));
+    p->sizes.push_back({w, h});
+  }
+  return p;
+}
+
+} // namespace
+
+void beginFrame() {
+  culledCount = 0;
+  framePyramid = nullptr;
+  if (!cullingApplies() || !latestPyramid) return;
+  const DepthPyramid& p = *latestPyramid;
+
+  // Conservative fallback: stop culling while the camera is far from the captured view
+  glm::vec3 lookDir, upDir, rightDir;
+  view::getCameraFrame(lookDir, upDir, rightDir);
+  glm::vec3 cameraPosition = view::getCameraWorldPosition();
+  if (glm::length(cameraPosition - p.cameraPosition) > maxCameraMotion * state::lengthScale ||
+      glm::dot(lookDir, p.cameraDirection) < minCameraDirectionCos) {
+    return;
+  }
+
+  framePyramid = latestPyramid;
+  frameViewProjMat = view::getCameraPerspectiveMatrix() * view::getCameraViewMatrix();
+  frameDepthStale = view::viewMat != p.viewMat || internal::sceneContentVersion != p.sceneContentVersion;
+}
+
+void captureSceneDepth() {
+
+  // Culled structures are drawn a frame late when the depth they were tested against is out of date, so make sure
+  // there is another frame
+  if (framePyramid && frameDepthStale && culledCount > 0) {
+    internal::requestViewRedraw();
+  }
+
+  if (!cullingApplies()) {
+    latestPyramid = nullptr;
+    return;
+  }
+  if (readbackPending) return; // at most one capture in flight
+
+  glm::vec3 lookDir, upDir, rightDir;
+  view::getCameraFrame(lookDir, upDir, rightDir);
+  glm::mat4 viewMat = view::getCameraViewMatrix();
+  glm::mat4 viewProjMat = view::getCameraPerspectiveMatrix() * viewMat;
+  glm::vec3 cameraPosition = view::getCameraWorldPosition();
+  uint64_t sceneContentVersion = internal::sceneContentVersion;
+
+  render::FrameBuffer& buffer = *render::engine->sceneBuffer;
+  size_t w = buffer.getSizeX();
+  size_t h = buffer.getSizeY();
+  if (w == 0 || h == 0) return;
+
+  readbackPending = true;
+  buffer.readDepthRegionAsync(0, 0, w, h, [=](std::vector<float> depth) {
+    readbackPending = false;
+    if (depth.size() != w * h) return;
+    std::shared_ptr<DepthPyramid> p = buildPyramid(depth, w, h);
+    p->viewProjMat = viewProjMat;
+    p->viewMat = viewMat;
+    p->cameraPosition = cameraPosition;
+    p->cameraDirection = lookDir;
+    p->sceneContentVersion = sceneContentVersion;
+    latestPyramid = p;
+  });
+}
+
+bool boxMayBeVisible(glm::vec3 worldMin, glm::vec3 worldMax, const glm::mat4& viewProjMat) {
+  if (!framePyramid || viewProjMat != frameViewProjMat) return true;
+  const DepthPyramid& p = *framePyramid;
+
+  // Project the box in to the captured view. Its nearest depth is at a corner.
+  glm::vec2 ndcMin{std::numeric_limits<float>::infinity()};
+  glm::vec2 ndcMax{-std::numeric_limits<float>::infinity()};
+  float ndcDepthMin = std::numeric_limits<float>::infinity();
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 corner{(i & 1) ? worldMax.x : worldMin.x, (i & 2) ? worldMax.y : worldMin.y,
+                     (i & 4) ? worldMax.z : worldMin.z};
+    glm::vec4 c = p.viewProjMat * glm::vec4(corner, 1.);
+    if (!(c.w > 1e-6f)) return true; // reaches behind the camera
+    glm::vec3 ndc = glm::vec3(c) / c.w;
+    ndcMin = glm::min(ndcMin, glm::vec2(ndc));
+    ndcMax = glm::max(ndcMax, glm::vec2(ndc));
+    ndcDepthMin = std::min(ndcDepthMin, ndc.z);
+  }
+  float depthMin = 0.5f * ndcDepthMin + 0.5f;
+  if (!(depthMin > 0.f)) return true;
+  ndcMin = glm::max(ndcMin, glm::vec2{-1.f, -1.f});
+  ndcMax = glm::min(ndcMax, glm::vec2{1.f, 1.f});
+  if (ndcMin.x > ndcMax.x || ndcMin.y > ndcMax.y) return true; // off screen, left to the frustum test
+
+  // The covered pixels, then the level at which they span at most a couple of texels
+  const std::array<size_t, 2>& size0 = p.sizes[0];
+  auto toPixel = [](float ndc, size_t size) {
+    float px = std::floor((0.5f * ndc + 0.5f) * size);
+    return static_cast<size_t>(glm::clamp(px, 0.f, static_cast<float>(size - 1)));
+  };
+  size_t x0 = toPixel(ndcMin.x, size0[0]);
+  size_t x1 = toPixel(ndcMax.x, size0[0]);
+  size_t y0 = toPixel(ndcMin.y, size0[1]);
+  size_t y1 = toPixel(ndcMax.y, size0[1]);
+  size_t extent = std::max(x1 - x0, y1 - y0);
+  size_t level = 0;
+  while ((extent >> level) > 1 && level + 1 < p.levels.size()) level++;
+
+  const std::vector<float>& depth = p.levels[level];
+  size_t levelW = p.sizes[level][0];
+  for (size_t y = y0 >> level; y <= (y1 >> level); y++) {
+    for (size_t x = x0 >> level; x <= (x1 >> level); x++) {
+      if (depthMin <= depth[y * levelW + x]) return true;
+    }
+  }
+
+  culledCount++;
+  return false;
+}
+
+bool isActive() { return framePyramid != nullptr; }
+
+size_t getCulledCount() { return culledCount; }
+
+} // namespace occlusion
+} // namespace polyscope
@@ -12,9 +12,14 @@ std::string printPrefix = "[polyscope] ";
 bool errorsThrowExceptions = false;
 bool debugDrawPickBuffer = false;
 int maxFPS = 60;
+int swapInterval = 1;
+bool lowLatencyInteraction = false;
 bool usePrefsFile = true;
 bool initializeWithDefaultStructures = true;
 bool alwaysRedraw = false;
+bool sleepWhenIdle = false;
+double idleWakeInterval = 0.5;
+bool reuseIdleUI = false;
 bool autocenterStructures = false;
 bool autoscaleStructures = false;
 bool automaticallyComputeSceneExtents = true;
@@ -23,6 +28,10 @@ bool giveFocusOnShow = false;
 
 bool screenshotTransparency = true;
 std::string screenshotExtension = ".png";
+bool screenshotEncodeInBackground = true;
+int screenshotPNGCompressionLevel = 0;
+std::string ffmpegExecutable = "ffmpeg";
+std::string recordingEncoderArgs = "-c:v libx264 -preset veryfast -crf 18 -pix_fmt yuv420p";
 
 // == Scene options
 
@@ -30,16 +39,49 @@ std::string screenshotExtension = ".png";
 bool groundPlaneEnabled = true;
 GroundPlaneMode groundPlaneMode = GroundPlaneMode::TileReflection;
 ScaledValue<float> groundPlaneHeightFactor = 0;
+bool groundPlaneHeightLocked = false;
+float groundReflectionScale = 0.5;
 int shadowBlurIters = 2;
 float shadowDarkness = 0.25;
 
 // Rendering options
 
 int ssaaFactor = 1;
+float renderScale = 1.;
+bool temporalAntialiasing = false;
+int temporalAntialiasingSamples = 16;
+bool ambientOcclusion = false;
+float ambientOcclusionRadius = 0.03;
+float ambientOcclusionStrength = 1.0;
+bool ambientOcclusionFullResolution = false;
 
 // Transparency
 TransparencyMode transparencyMode = TransparencyMode::None;
 int transparencyRenderPasses = 8;
+bool adaptiveTransparencyRenderPasses = true;
+bool adaptiveQuality = false;
+int adaptiveQualitySSAAFactor = 1;
+int adaptiveQualityTransparencyRenderPasses = 2;
+bool dynamicResolution = false;
+float dynamicResolutionTargetMs = 16.7;
+float dynamicResolutionMinScale = 0.5;
+HostMemoryPolicy hostMemoryPolicy = HostMemoryPolicy::KeepHostCopy;
+bool enableFrustumCulling = true;
+bool occlusionCulling = false;
+bool sortDrawsByMaterial = true;
+int maxWorkerThreads = -1;
+bool retainRemovedStructureSettings = false;
+int maxRetainedPersistentValues = 100000;
+int gpuMemoryBudgetMB = -1;
+bool compressDisabledQuantities = false;
+bool imageTexturePaging = false;
+int imageTextureUploadsPerFrame = 4;
+bool prepareStructuresInBackground = false;
+bool optimizeMeshDrawOrder = false;
+bool spatiallyOrderPointClouds = false;
+float impostorFallbackPixelSize = 1.;
+bool batchCameraViews = true;
+std::string shaderCacheDirectory = "";
 
 // === Advanced ImGui configuration
 
@@ -56,5 +98,7 @@ bool enableRenderErrorChecks = false;
 bool enableRenderErrorChecks = true;
 #endif
 
+bool enableProfiling = false;
+
 } // namespace options
 } // namespace polyscope
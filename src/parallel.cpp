@@ -0,0 +1,265 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/parallel.h"
+
+#include "polyscope/options.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polyscope {
+
+struct TaskGroup::State {
+  std::atomic<size_t> pending{0};
+  std::mutex mutex; // guards the members below
+  std::exception_ptr firstException;
+  ParallelBackend backend;                     // the external backend when the group was made (if any)
+  std::vector<std::function<void()>> deferred; // tasks waiting to be handed to the backend
+  bool usesPool = false;                       // whether the group holds a reference on the pool
+
+  void runGuarded(const std::function<void()>& task) {
+    try {
+      task();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!firstException) firstException = std::current_exception();
+    }
+  }
+};
+
+namespace {
+
+ParallelBackend externalBackend;
+
+// === The internal pool
+
+// Each worker has its own queue, which it pushes to and pops from at the back (so nested work stays local), while
+// idle threads steal from the front of the others. Threads which are not workers share one extra queue.
+struct Task {
+  std::function<void()> func;
+  std::shared_ptr<TaskGroup::State> group;
+};
+
+struct TaskQueue {
+  std::mutex mutex;
+  std::deque<Task> tasks;
+};
+
+thread_local int workerIndex = -1; // this thread's queue, if it is a worker
+
+struct Pool {
+  std::vector<std::unique_ptr<TaskQueue>> queues = std::vector<std::unique_ptr<TaskQueue>>(1);
+  std::vector<std::thread> workers;
+  std::atomic<size_t> queuedCount{0}; // only changes with a queue locked, so nonzero means some queue has a task
+
+  // Sleeping threads wait on wake, for queued tasks (or for the group they wait on to finish)
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+  bool stopping = false;
+
+  // The workers are only (re)started while no task groups exist, since their queues go with them
+  std::mutex usersMutex;
+  size_t users = 0;
+
+  Pool() { queues[0].reset(new TaskQueue()); }
+  ~Pool() { stopWorkers(); }
+
+  void acquire() {
+    std::lock_guard<std::mutex> lock(usersMutex);
+    size_t nWorkers = workerThreadCount() - 1;
+    if (users == 0 && workers.size() != nWorkers) {
+      stopWorkers();
+      queues.resize(nWorkers + 1);
+      for (std::unique_ptr<TaskQueue>& q : queues) q.reset(new TaskQueue());
+      for (size_t i = 0; i < nWorkers; i++) workers.emplace_back(&Pool::workerLoop, this, static_cast<int>(i));
+    }
+    users++;
+  }
+
+  void release() {
+    std::lock_guard<std::mutex> lock(usersMutex);
+    users--;
+  }
+
+  void stopWorkers() {
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& w : workers) w.join();
+    workers.clear();
+    stopping = false;
+  }
+
+  void notify(bool all) {
+    { std::lock_guard<std::mutex> lock(wakeMutex); } // (so a thread between checking and sleeping sees this)
+    if (all) {
+      wake.notify_all();
+    } else {
+      wake.notify_one();
+    }
+  }
+
+  void push(Task task) {
+    TaskQueue& q = *queues[workerIndex >= 0 ? workerIndex : queues.size() - 1];
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(std::move(task));
+      queuedCount++;
+    }
+    notify(false);
+  }
+
+  bool pop(Task& task) {
+    size_t nQueues = queues.size();
+    size_t own = workerIndex >= 0 ? workerIndex : nQueues - 1;
+    for (size_t i = 0; i < nQueues; i++) {
+      TaskQueue& q = *queues[(own + i) % nQueues];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.tasks.empty()) continue;
+      if (i == 0) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      } else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      queuedCount--;
+      return true;
+    }
+    return false;
+  }
+
+  void run(Task& task) {
+    task.group->runGuarded(task.func);
+    if (--task.group->pending == 0) notify(true);
+  }
+
+  void workerLoop(int index) {
+    workerIndex = index;
+    while (true) {
+      Task task;
+      if (pop(task)) {
+        run(task);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      wake.wait(lock, [&]() { return stopping || queuedCount > 0; });
+      if (stopping) return;
+    }
+  }
+
+  // Run queued tasks (of any group) until the group is done
+  void waitFor(TaskGroup::State& group) {
+    while (group.pending > 0) {
+      Task task;
+      if (pop(task)) {
+        run(task);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(wakeMutex);
+      wake.wait(lock, [&]() { return group.pending == 0 || queuedCount > 0; });
+    }
+  }
+};
+
+Pool& pool() {
+  static Pool p;
+  return p;
+}
+
+} // namespace
+
+size_t workerThreadCount() {
+  if (options::maxWorkerThreads > 0) {
+    return static_cast<size_t>(options::maxWorkerThreads);
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void setParallelBackend(ParallelBackend backend) { externalBackend = backend; }
+
+TaskGroup::TaskGroup() : state(new State()) {
+  state->backend = externalBackend;
+  if (!state->backend && workerIndex < 0) {
+    // (groups made by the workers are nested in some other group, which already holds the pool)
+    pool().acquire();
+    state->usesPool = true;
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  try {
+    wait();
+  } catch (...) {
+  }
+  if (state->usesPool) pool().release();
+}
+
+void TaskGroup::run(std::function<void()> task) {
+  if (state->backend) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->deferred.push_back(std::move(task));
+    return;
+  }
+  state->pending++;
+  pool().push(Task{std::move(task), state});
+}
+
+void TaskGroup::wait() {
+  if (state->backend) {
+    // Tasks may add more tasks, so hand them over until none are left
+    while (true) {
+      std::vector<std::function<void()>> tasks;
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        tasks.swap(state->deferred);
+      }
+      if (tasks.empty()) break;
+      state->backend(tasks.size(), [&](size_t i) { state->runGuarded(tasks[i]); });
+    }
+  } else {
+    pool().waitFor(*state);
+  }
+
+  std::exception_ptr e;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    std::swap(e, state->firstException);
+  }
+  if (e) std::rethrow_exception(e);
+}
+
+void parallelFor(size_t start, size_t end, const std::function<void(size_t, size_t)>& func, size_t minBlockSize) {
+  if (end <= start) return;
+  size_t count = end - start;
+  minBlockSize = std::max<size_t>(1, minBlockSize);
+
+  // Decide how many threads to use
+  size_t nThreads = std::min(workerThreadCount(), std::max<size_t>(1, count / minBlockSize));
+  if (nThreads <= 1) {
+    func(start, end);
+    return;
+  }
+
+  // A few blocks per thread (but none below the minimum size), so the threads which finish early or join late can
+  // take over some of the work
+  size_t nBlocks = std::max(nThreads, std::min(4 * nThreads, count / minBlockSize));
+  size_t blockSize = (count + nBlocks - 1) / nBlocks;
+
+  TaskGroup group;
+  for (size_t blockStart = start; blockStart < end; blockStart += blockSize) {
+    size_t blockEnd = std::min(end, blockStart + blockSize);
+    group.run([&func, blockStart, blockEnd]() { func(blockStart, blockEnd); });
+  }
+  group.wait();
+}
+
+} // namespace polyscope
@@ -2,10 +2,153 @@
 
 #include "polyscope/persistent_value.h"
 
+#include "polyscope/options.h"
 #include "polyscope/render/color_maps.h"
 
+#include <algorithm>
+#include <list>
+#include <map>
+
 namespace polyscope {
 namespace detail {
+
+namespace {
+// interned names of all persistent values, ordered so that those under a prefix can be found. Function-local so they
+// are usable during static initialization.
+std::map<std::string, PersistentKey>& getPersistentKeys() {
+  static std::map<std::string, PersistentKey> keys;
+  return keys;
+}
+
+// A key is an index in to the list of these
+struct NameRecord {
+  std::string name;
+  uint32_t holders = 0; // live persistent values with the name
+  bool retained = false; // in the eviction queue
+  std::list<PersistentKey>::iterator queuePos;
+};
+std::vector<NameRecord>& getNameRecords() {
+  static std::vector<NameRecord> records;
+  return records;
+}
+std::vector<PersistentKey>& getFreeKeys() {
+  static std::vector<PersistentKey> freeKeys;
+  return freeKeys;
+}
+
+// The names no live value holds, least recently released first
+std::list<PersistentKey>& getRetainedQueue() {
+  static std::list<PersistentKey> queue;
+  return queue;
+}
+
+std::vector<PersistentCacheBase*>& getAllCaches() {
+  static std::vector<PersistentCacheBase*> caches;
+  return caches;
+}
+
+std::vector<std::string>& getPinnedPrefixes() {
+  static std::vector<std::string> prefixes;
+  return prefixes;
+}
+
+bool hasPrefix(const std::string& name, const std::string& prefix) {
+  return name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool isPinned(const std::string& name) {
+  for (const std::string& prefix : getPinnedPrefixes()) {
+    if (hasPrefix(name, prefix)) return true;
+  }
+  return false;
+}
+
+void removeFromQueue(NameRecord& record) {
+  if (!record.retained) return;
+  getRetainedQueue().erase(record.queuePos);
+  record.retained = false;
+}
+
+// Forget a name no live value holds, and its entries in all the caches
+void dropName(PersistentKey key) {
+  NameRecord& record = getNameRecords()[key];
+  removeFromQueue(record);
+  for (PersistentCacheBase* cache : getAllCaches()) cache->erase(key);
+  getPersistentKeys().erase(record.name);
+  record = NameRecord();
+  getFreeKeys().push_back(key);
+}
+
+void evictRetainedNames() {
+  if (options::maxRetainedPersistentValues < 0) return;
+  std::list<PersistentKey>& queue = getRetainedQueue();
+  while (queue.size() > static_cast<size_t>(options::maxRetainedPersistentValues)) {
+    PersistentKey key = queue.front();
+    NameRecord& record = getNameRecords()[key];
+    if (isPinned(record.name)) {
+      removeFromQueue(record); // (queued again if it is released after being unpinned)
+    } else {
+      dropName(key);
+    }
+  }
+}
+} // namespace
+
+PersistentKey internPersistentName(const std::string& name) {
+  std::map<std::string, PersistentKey>& persistentKeys = getPersistentKeys();
+  std::vector<NameRecord>& records = getNameRecords();
+  auto it = persistentKeys.find(name);
+  if (it != persistentKeys.end()) return it->second;
+  PersistentKey key;
+  if (getFreeKeys().empty()) {
+    key = static_cast<PersistentKey>(records.size());
+    records.emplace_back();
+  } else {
+    key = getFreeKeys().back();
+    getFreeKeys().pop_back();
+  }
+  records[key].name = name;
+  persistentKeys.emplace(name, key);
+  return key;
+}
+
+const std::string& persistentName(PersistentKey key) { return getNameRecords()[key].name; }
+
+void reservePersistentNames(size_t count) { getNameRecords().reserve(getNameRecords().size() + count); }
+
+void acquirePersistentName(PersistentKey key) {
+  NameRecord& record = getNameRecords()[key];
+  record.holders++;
+  removeFromQueue(record);
+}
+
+void releasePersistentName(PersistentKey key) {
+  NameRecord& record = getNameRecords()[key];
+  record.holders--;
+  if (record.holders > 0) return;
+  record.queuePos = getRetainedQueue().insert(getRetainedQueue().end(), key);
+  record.retained = true;
+  evictRetainedNames();
+}
+
+void dropPersistentValues(const std::string& namePrefix) {
+  std::vector<PersistentKey> toDrop;
+  std::map<std::string, PersistentKey>& persistentKeys = getPersistentKeys();
+  for (auto it = persistentKeys.lower_bound(namePrefix); it != persistentKeys.end() && hasPrefix(it->first, namePrefix);
+       ++it) {
+    if (getNameRecords()[it->second].holders == 0 && !isPinned(it->first)) toDrop.push_back(it->second);
+  }
+  for (PersistentKey key : toDrop) dropName(key);
+}
+
+size_t retainedPersistentNameCount() { return getRetainedQueue().size(); }
+
+PersistentCacheBase::PersistentCacheBase() { getAllCaches().push_back(this); }
+PersistentCacheBase::~PersistentCacheBase() {
+  std::vector<PersistentCacheBase*>& caches = getAllCaches();
+  caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+}
+
 // storage for persistent value global caches
 // clang-format off
 PersistentCache<double> persistentCache_double;
@@ -22,4 +165,12 @@ PersistentCache<BackFacePolicy> persistentCache_BackFacePolicy;
 PersistentCache<MeshShadeStyle> persistentCache_MeshNormalType;
 // clang-format on
 } // namespace detail
+
+void pinPersistentValues(const std::string& namePrefix) { detail::getPinnedPrefixes().push_back(namePrefix); }
+
+void unpinPersistentValues(const std::string& namePrefix) {
+  std::vector<std::string>& prefixes = detail::getPinnedPrefixes();
+  prefixes.erase(std::remove(prefixes.begin(), prefixes.end(), namePrefix), prefixes.end());
+}
+
 } // namespace polyscope
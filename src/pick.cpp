@@ -4,7 +4,11 @@
 
 #include "polyscope/polyscope.h"
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <limits>
+#include <map>
 #include <tuple>
 #include <unordered_map>
 
@@ -15,13 +19,25 @@ size_t currLocalPickInd = 0;
 Structure* currPickStructure = nullptr;
 bool haveSelectionVal = false;
 
-// The next pick index that a structure can use to identify its elements
-// (get it by calling request pickBufferRange())
-size_t nextPickBufferInd = 1; // 0 reserved for "none"
-                              //
-// Track which ranges have been allocated to which structures
-// std::vector<std::tuple<size_t, size_t, Structure*>> structureRanges;
-std::unordered_map<Structure*, std::tuple<size_t, size_t>> structureRanges;
+// The end of the allocated pick indices: everything from here on is free
+// (get a range by calling requestPickBufferRange())
+uint64_t nextPickBufferInd = 1; // 0 reserved for "none"
+
+// Released ranges below nextPickBufferInd, as start --> end. Adjacent free ranges are merged, and a free range reaching
+// nextPickBufferInd is returned to it, so scenes which create and remove structures continuously reuse the same
+// indices rather than drifting upward.
+std::map<uint64_t, uint64_t> freeRanges;
+
+// Track which ranges have been allocated to which structures, as [start, end). The same ranges are kept sorted by
+// start, so that pick results can be mapped back to a structure with a binary search.
+std::unordered_map<Structure*, std::tuple<uint64_t, uint64_t>> structureRanges;
+std::map<uint64_t, std::tuple<uint64_t, Structure*>> rangesByStart;
+
+// The pick buffer is cached between queries, and only re-rendered when something in the scene changes (signaled via
+// invalidatePickBuffer(), which is called by requestRedraw()), or the buffer size changes.
+bool pickBufferValid = false;
+int pickBufferWidth = -1;
+int pickBufferHeight = -1;
 
 
 // == Set up picking
@@ -39,17 +55,76 @@ size_t requestPickBufferRange(Structure* requestingStructure, size_t count) {
   }
 #pragma GCC diagnostic pop
 
-  if (count > maxPickInd || maxPickInd - count < nextPickBufferInd) {
-    exception("Wow, you sure do have a lot of stuff, Polyscope can't even count it all. (Ran out of indices while "
-              "enumerating structure elements for pick buffer.)");
+  // A structure which re-requests (e.g. because it rebuilt its pick program) keeps its old range if it still fits, so
+  // repeatedly re-preparing does not use up the index space
+  auto existing = structureRanges.find(requestingStructure);
+  if (existing != structureRanges.end()) {
+    uint64_t oldStart = std::get<0>(existing->second);
+    uint64_t oldEnd = std::get<1>(existing->second);
+    if (count <= oldEnd - oldStart) {
+      return oldStart;
+    }
+    releasePickBufferRange(requestingStructure);
+  }
+
+  // Reuse the lowest released range which is big enough, the remainder stays free
+  uint64_t ret = INVALID_IND_64;
+  for (std::map<uint64_t, uint64_t>::iterator it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+    if (it->second - it->first >= count) {
+      ret = it->first;
+      uint64_t freeEnd = it->second;
+      freeRanges.erase(it);
+      if (ret + count < freeEnd) freeRanges[ret + count] = freeEnd;
+      break;
+    }
+  }
+
+  // Otherwise, take a new range from the end
+  if (ret == INVALID_IND_64) {
+    if (count > maxPickInd || maxPickInd - count < nextPickBufferInd) {
+      exception("Wow, you sure do have a lot of stuff, Polyscope can't even count it all. (Ran out of indices while "
+                "enumerating structure elements for pick buffer.)");
+    }
+    ret = nextPickBufferInd;
+    nextPickBufferInd += count;
   }
 
-  size_t ret = nextPickBufferInd;
-  nextPickBufferInd += count;
-  structureRanges[requestingStructure] = std::make_tuple(ret, nextPickBufferInd);
+  structureRanges[requestingStructure] = std::make_tuple(ret, ret + count);
+  rangesByStart[ret] = std::make_tuple(ret + count, requestingStructure);
   return ret;
 }
 
+void invalidatePickBuffer() { pickBufferValid = false; }
+
+void releasePickBufferRange(Structure* s) {
+  auto it = structureRanges.find(s);
+  if (it == structureRanges.end()) return;
+  uint64_t start = std::get<0>(it->second);
+  uint64_t end = std::get<1>(it->second);
+  rangesByStart.erase(start);
+  structureRanges.erase(it);
+
+  // Merge with the free ranges on either side
+  std::map<uint64_t, uint64_t>::iterator after = freeRanges.lower_bound(start);
+  if (after != freeRanges.end() && after->first == end) {
+    end = after->second;
+    after = freeRanges.erase(after);
+  }
+  if (after != freeRanges.begin()) {
+    std::map<uint64_t, uint64_t>::iterator before = std::prev(after);
+    if (before->second == start) {
+      start = before->first;
+      freeRanges.erase(before);
+    }
+  }
+
+  if (end == nextPickBufferInd) {
+    nextPickBufferInd = start;
+  } else {
+    freeRanges[start] = end;
+  }
+}
+
 // == Manage stateful picking
 
 void resetSelection() {
@@ -88,21 +163,16 @@ void setSelection(std::pair<Structure*, size_t> newPick) {
 
 std::pair<Structure*, size_t> globalIndexToLocal(size_t globalInd) {
 
-  // ONEDAY: this could be asymptotically better if we cared
+  // The last range starting at or before the index
+  auto it = rangesByStart.upper_bound(globalInd);
+  if (it == rangesByStart.begin()) return {nullptr, 0};
+  --it;
 
-  // Loop through the ranges that we have allocated to find the one correpsonding to this structure.
-  for (const auto& x : structureRanges) {
+  uint64_t rangeStart = it->first;
+  uint64_t rangeEnd = std::get<0>(it->second);
+  if (globalInd >= rangeEnd) return {nullptr, 0}; // in a gap left by a released range
 
-    Structure* structure = x.first;
-    size_t rangeStart = std::get<0>(x.second);
-    size_t rangeEnd = std::get<1>(x.second);
-
-    if (globalInd >= rangeStart && globalInd < rangeEnd) {
-      return {structure, globalInd - rangeStart};
-    }
-  }
-
-  return {nullptr, 0};
+  return {std::get<1>(it->second), globalInd - rangeStart};
 }
 
 size_t localIndexToGlobal(std::pair<Structure*, size_t> localPick) {
@@ -112,51 +182,154 @@ size_t localIndexToGlobal(std::pair<Structure*, size_t> localPick) {
     exception("structure does not match any allocated pick range");
   }
 
-  std::tuple<size_t, size_t> range = structureRanges[localPick.first];
-  size_t rangeStart = std::get<0>(range);
-  size_t rangeEnd = std::get<1>(range);
+  uint64_t rangeStart = std::get<0>(structureRanges[localPick.first]);
   return rangeStart + localPick.second;
 }
 
 
-std::pair<Structure*, size_t> evaluatePickQuery(int xPos, int yPos) {
+bool renderPickBuffer() {
 
-  // NOTE: hack used for debugging: if xPos == yPos == -1 we do a pick render but do not query the value.
+  render::engine->allocatePickBuffer();
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
 
-  // Be sure not to pick outside of buffer
-  if (xPos < -1 || xPos >= view::bufferWidth || yPos < -1 || yPos >= view::bufferHeight) {
-    return {nullptr, 0};
+  bool sizeChanged = pickBufferWidth != view::bufferWidth || pickBufferHeight != view::bufferHeight;
+  if (pickBufferValid && !sizeChanged && !options::alwaysRedraw) {
+    return true;
   }
 
-  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
-
   render::engine->setDepthMode();
   render::engine->setBlendMode(BlendMode::Disable);
 
   pickFramebuffer->resize(view::bufferWidth, view::bufferHeight);
   pickFramebuffer->setViewport(0, 0, view::bufferWidth, view::bufferHeight);
   pickFramebuffer->clearColor = glm::vec3{0., 0., 0.};
-  if (!pickFramebuffer->bindForRendering()) return {nullptr, 0};
+  if (!pickFramebuffer->bindForRendering()) return false;
   pickFramebuffer->clear();
 
   // Render pick buffer
-  for (auto cat : state::structures) {
-    for (auto x : cat.second) {
-      x.second->drawPick();
-    }
+  render::engine->updateFrameUniforms();
+  internal::structureDrawPassCount++;
+  RenderQueueOrder order =
+      options::sortDrawsByMaterial ? RenderQueueOrder::StateSorted : RenderQueueOrder::Registration;
+  for (RenderQueueItem& item : buildRenderQueue(order)) {
+    if (item.structure->isLoading()) continue;
+    item.structure->drawPick();
   }
 
+  pickBufferValid = true;
+  pickBufferWidth = view::bufferWidth;
+  pickBufferHeight = view::bufferHeight;
+  return true;
+}
+
+std::pair<Structure*, size_t> evaluatePickQuery(int xPos, int yPos) {
+
+  // NOTE: hack used for debugging: if xPos == yPos == -1 we do a pick render but do not query the value.
+
+  // Be sure not to pick outside of buffer
+  if (xPos < -1 || xPos >= view::bufferWidth || yPos < -1 || yPos >= view::bufferHeight) {
+    return {nullptr, 0};
+  }
+
+  // Only re-renders if the cached contents are stale
+  if (!renderPickBuffer()) return {nullptr, 0};
+
   if (xPos == -1 || yPos == -1) {
     return {nullptr, 0};
   }
 
   // Read from the pick buffer
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
   std::array<float, 4> result = pickFramebuffer->readFloat4(xPos, view::bufferHeight - yPos);
   size_t globalInd = pick::vecToInd(glm::vec3{result[0], result[1], result[2]});
 
   return pick::globalIndexToLocal(globalInd);
 }
 
+void evaluatePickQueryAsync(int xPos, int yPos, std::function<void(std::pair<Structure*, size_t>)> callback) {
+
+  // Be sure not to pick outside of buffer
+  if (xPos < 0 || xPos >= view::bufferWidth || yPos < 0 || yPos >= view::bufferHeight) {
+    callback({nullptr, 0});
+    return;
+  }
+
+  if (!renderPickBuffer()) {
+    callback({nullptr, 0});
+    return;
+  }
+
+  // Issue the read; the index is resolved on delivery, so removed structures will not be returned
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+  pickFramebuffer->readFloat4Async(xPos, view::bufferHeight - yPos, [callback](std::array<float, 4> result) {
+    size_t globalInd = pick::vecToInd(glm::vec3{result[0], result[1], result[2]});
+    callback(pick::globalIndexToLocal(globalInd));
+  });
+}
+
+std::unordered_map<Structure*, std::vector<size_t>> evaluatePickRegionQuery(int xStart, int yStart, int xEnd,
+                                                                            int yEnd) {
+
+  std::unordered_map<Structure*, std::vector<size_t>> result;
+
+  // Clamp the region to the buffer
+  if (xStart > xEnd) std::swap(xStart, xEnd);
+  if (yStart > yEnd) std::swap(yStart, yEnd);
+  xStart = std::max(xStart, 0);
+  yStart = std::max(yStart, 0);
+  xEnd = std::min(xEnd, view::bufferWidth - 1);
+  yEnd = std::min(yEnd, view::bufferHeight - 1);
+  if (xStart > xEnd || yStart > yEnd) {
+    return result;
+  }
+
+  if (!renderPickBuffer()) return result;
+
+  // Read the whole region at once (flipping y, as in evaluatePickQuery())
+  int sizeX = xEnd - xStart + 1;
+  int sizeY = yEnd - yStart + 1;
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+  std::vector<float> pixels = pickFramebuffer->readFloat4Region(xStart, view::bufferHeight - yEnd, sizeX, sizeY);
+
+  // Decode to unique global indices
+  std::vector<size_t> globalInds;
+  globalInds.reserve(sizeX * sizeY);
+  for (size_t i = 0; i + 3 < pixels.size(); i += 4) {
+    size_t globalInd = pick::vecToInd(glm::vec3{pixels[i + 0], pixels[i + 1], pixels[i + 2]});
+    if (globalInd != 0) globalInds.push_back(globalInd);
+  }
+  std::sort(globalInds.begin(), globalInds.end());
+  globalInds.erase(std::unique(globalInds.begin(), globalInds.end()), globalInds.end());
+
+  // Map to structures. Since the global indices are sorted, the local indices for each structure are too.
+  for (size_t globalInd : globalInds) {
+    std::pair<Structure*, size_t> localPick = pick::globalIndexToLocal(globalInd);
+    if (localPick.first == nullptr) continue;
+    result[localPick.first].push_back(localPick.second);
+  }
+
+  return result;
+}
+
+std::pair<Structure*, RayPickResult> evaluateRayPickQuery(glm::vec3 rayStart, glm::vec3 rayDir) {
+
+  Structure* bestStructure = nullptr;
+  RayPickResult bestResult;
+
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      if (!x.second->isEnabled()) continue;
+      RayPickResult result = x.second->rayPick(rayStart, rayDir);
+      if (result.isHit && result.depth < bestResult.depth) {
+        bestStructure = x.second.get();
+        bestResult = result;
+      }
+    }
+  }
+
+  return {bestStructure, bestResult};
+}
+
 } // namespace pick
 
 
@@ -0,0 +1,563 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/ply_streaming.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/point_cloud.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/surface_mesh.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace polyscope {
+
+namespace {
+
+// == PLY parsing
+
+enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PlyProperty {
+  std::string name;
+  PlyType type;
+  bool isList = false;
+  PlyType countType; // only for lists
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count = 0;
+  std::vector<PlyProperty> properties;
+
+  int findProperty(const std::string& propName) const {
+    for (size_t i = 0; i < properties.size(); i++) {
+      if (properties[i].name == propName) return static_cast<int>(i);
+    }
+    return -1;
+  }
+};
+
+struct PlyHeader {
+  PlyFormat format;
+  std::vector<PlyElement> elements;
+};
+
+size_t plyTypeSize(PlyType type) {
+  switch (type) {
+  case PlyType::Int8:
+  case PlyType::UInt8:
+    return 1;
+  case PlyType::Int16:
+  case PlyType::UInt16:
+    return 2;
+  case PlyType::Int32:
+  case PlyType::UInt32:
+  case PlyType::Float32:
+    return 4;
+  case PlyType::Float64:
+    return 8;
+  }
+  return 0;
+}
+
+PlyType parsePlyType(const std::string& name) {
+  if (name == "char" || name == "int8") return PlyType::Int8;
+  if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+  if (name == "short" || name == "int16") return PlyType::Int16;
+  if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+  if (name == "int" || name == "int32") return PlyType::Int32;
+  if (name == "uint" || name == "uint32") return PlyType::UInt32;
+  if (name == "float" || name == "float32") return PlyType::Float32;
+  if (name == "double" || name == "float64") return PlyType::Float64;
+  throw std::runtime_error("unknown PLY property type '" + name + "'");
+}
+
+// Leaves the stream at the start of the data. Throws std::runtime_error on any problem.
+PlyHeader readPlyHeader(std::ifstream& in) {
+  PlyHeader header;
+  bool haveFormat = false;
+
+  std::string line;
+  std::getline(in, line);
+  if (line.compare(0, 3, "ply") != 0) throw std::runtime_error("not a PLY file");
+
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    std::istringstream lineStream(line);
+    std::string keyword;
+    lineStream >> keyword;
+
+    if (keyword == "format") {
+      std::string formatName;
+      lineStream >> formatName;
+      if (formatName == "ascii") {
+        header.format = PlyFormat::Ascii;
+      } else if (formatName == "binary_little_endian") {
+        header.format = PlyFormat::BinaryLittleEndian;
+      } else if (formatName == "binary_big_endian") {
+        header.format = PlyFormat::BinaryBigEndian;
+      } else {
+        throw std::runtime_error("unknown PLY format '" + formatName + "'");
+      }
+      haveFormat = true;
+    } else if (keyword == "element") {
+      PlyElement element;
+      lineStream >> element.name >> element.count;
+      header.elements.push_back(element);
+    } else if (keyword == "property") {
+      if (header.elements.empty()) throw std::runtime_error("PLY property before any element");
+      PlyProperty prop;
+      std::string typeName;
+      lineStream >> typeName;
+      if (typeName == "list") {
+        std::string countTypeName, valueTypeName;
+        lineStream >> countTypeName >> valueTypeName;
+        prop.isList = true;
+        prop.countType = parsePlyType(countTypeName);
+        prop.type = parsePlyType(valueTypeName);
+      } else {
+        prop.type = parsePlyType(typeName);
+      }
+      lineStream >> prop.name;
+      header.elements.back().properties.push_back(prop);
+    } else if (keyword == "end_header") {
+      if (!haveFormat) throw std::runtime_error("PLY header has no format");
+      return header;
+    }
+    // comments, obj_info, etc are ignored
+  }
+
+  throw std::runtime_error("PLY header is not terminated");
+}
+
+// Buffered reads from the data section of the file
+class PlyDataReader {
+public:
+  PlyDataReader(std::ifstream& in_, PlyFormat format_) : in(in_), format(format_), buffer(1 << 20) {}
+
+  double readValue(PlyType type) {
+    if (format == PlyFormat::Ascii) {
+      return std::strtod(readToken().c_str(), nullptr);
+    }
+
+    unsigned char bytes[8];
+    size_t n = plyTypeSize(type);
+    readBytes(bytes, n);
+    if (format == PlyFormat::BinaryBigEndian) std::reverse(bytes, bytes + n);
+
+    switch (type) {
+    case PlyType::Int8:
+      return decode<int8_t>(bytes);
+    case PlyType::UInt8:
+      return decode<uint8_t>(bytes);
+    case PlyType::Int16:
+      return decode<int16_t>(bytes);
+    case PlyType::UInt16:
+      return decode<uint16_t>(bytes);
+    case PlyType::Int32:
+      return decode<int32_t>(bytes);
+    case PlyType::UInt32:
+      return decode<uint32_t>(bytes);
+    case PlyType::Float32:
+      return decode<float>(bytes);
+    case PlyType::Float64:
+      return decode<double>(bytes);
+    }
+    return 0.;
+  }
+
+  // Read one element record, calling onValue(propertyIndex, value) for the scalar properties and
+  // onList(propertyIndex, count) followed by onValue() for each entry of list properties
+  template <typename ScalarFunc, typename ListFunc>
+  void readRecord(const PlyElement& element, ScalarFunc onValue, ListFunc onList) {
+    for (size_t iProp = 0; iProp < element.properties.size(); iProp++) {
+      const PlyProperty& prop = element.properties[iProp];
+      if (prop.isList) {
+        size_t count = static_cast<size_t>(readValue(prop.countType));
+        onList(iProp, count);
+        for (size_t i = 0; i < count; i++) onValue(iProp, readValue(prop.type));
+      } else {
+        onValue(iProp, readValue(prop.type));
+      }
+    }
+  }
+
+  void skipElement(const PlyElement& element) {
+    for (size_t i = 0; i < element.count; i++) {
+      readRecord(
+          element, [](size_t, double) {}, [](size_t, size_t) {});
+    }
+  }
+
+private:
+  std::ifstream& in;
+  const PlyFormat format;
+  std::vector<char> buffer;
+  size_t bufferPos = 0;
+  size_t bufferEnd = 0;
+
+  template <typename T>
+  static double decode(const unsigned char* bytes) {
+    T val;
+    std::memcpy(&val, bytes, sizeof(T));
+    return static_cast<double>(val);
+  }
+
+  bool refill() {
+    in.read(buffer.data(), buffer.size());
+    bufferPos = 0;
+    bufferEnd = static_cast<size_t>(in.gcount());
+    return bufferEnd > 0;
+  }
+
+  void readBytes(unsigned char* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      if (bufferPos == bufferEnd && !refill()) throw std::runtime_error("PLY file is truncated");
+      out[i] = static_cast<unsigned char>(buffer[bufferPos++]);
+    }
+  }
+
+  std::string readToken() {
+    std::string token;
+    while (true) {
+      if (bufferPos == bufferEnd && !refill()) break;
+      char c = buffer[bufferPos];
+      bool isSpace = c == ' ' || c == '\n' || c == '\r' || c == '\t';
+      if (isSpace && !token.empty()) break;
+      if (!isSpace) token.push_back(c);
+      bufferPos++;
+    }
+    if (token.empty()) throw std::runtime_error("PLY file is truncated");
+    return token;
+  }
+};
+
+// Open a PLY file and read its header, throwing a polyscope exception on failure
+void openPly(const std::string& filename, std::ifstream& in, PlyHeader& header) {
+  in.open(filename, std::ios::binary);
+  if (!in) {
+    exception("could not open PLY file " + filename);
+  }
+  try {
+    header = readPlyHeader(in);
+  } catch (const std::runtime_error& e) {
+    exception("failed to read PLY file " + filename + ": " + e.what());
+  }
+}
+
+// Index of the named element, or -1
+int findElement(const PlyHeader& header, const std::string& name) {
+  for (size_t i = 0; i < header.elements.size(); i++) {
+    if (header.elements[i].name == name) return static_cast<int>(i);
+  }
+  return -1;
+}
+
+// Indices of the x, y, z properties of the vertex element, which must all exist
+std::array<int, 3> findPositionProperties(const PlyElement& vertexElement, const std::string& filename) {
+  std::array<int, 3> inds = {vertexElement.findProperty("x"), vertexElement.findProperty("y"),
+                             vertexElement.findProperty("z")};
+  for (int i : inds) {
+    if (i < 0) exception("PLY file " + filename + " vertices do not have x, y, z properties");
+  }
+  return inds;
+}
+
+void postLoadWarning(const std::string& filename, const std::string& what) {
+  postToMainThread([=]() { warning("loading PLY file " + filename + " failed", what); });
+}
+
+// == Point clouds
+
+// Owned by the point cloud being loaded (as its backgroundLoader), so that removing the cloud cancels the load
+struct PointCloudPLYLoad {
+  PointCloud* cloud = nullptr;
+  std::weak_ptr<PointCloudPLYLoad> self;
+  std::string filename;
+  std::ifstream in;
+  PlyHeader header;
+  size_t chunkSize;
+
+  // chunks which have been posted to the main thread but not yet applied; the reader stays at most a couple ahead
+  const size_t maxChunksInFlight = 2;
+  size_t chunksInFlight = 0;
+  std::atomic<bool> cancelled{false};
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::thread worker;
+
+  ~PointCloudPLYLoad() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      cancelled = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+  }
+
+  void run() {
+    try {
+      PlyDataReader reader(in, header.format);
+      for (const PlyElement& element : header.elements) {
+        if (element.name != "vertex") {
+          reader.skipElement(element);
+          continue;
+        }
+        readVertices(reader, element);
+        return;
+      }
+    } catch (const std::exception& e) {
+      if (!cancelled) postLoadWarning(filename, e.what());
+    }
+  }
+
+  void readVertices(PlyDataReader& reader, const PlyElement& element) {
+    std::array<int, 3> posProps = findPositionProperties(element, filename);
+
+    size_t start = 0;
+    while (start < element.count) {
+      size_t count = std::min(chunkSize, element.count - start);
+      std::shared_ptr<std::vector<glm::vec3>> chunk = std::make_shared<std::vector<glm::vec3>>(count);
+      for (size_t i = 0; i < count; i++) {
+        if (cancelled) return;
+        glm::vec3& p = (*chunk)[i];
+        reader.readRecord(
+            element,
+            [&](size_t iProp, double val) {
+              for (int c = 0; c < 3; c++) {
+                if (static_cast<int>(iProp) == posProps[c]) p[c] = static_cast<float>(val);
+              }
+            },
+            [](size_t, size_t) {});
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return chunksInFlight < maxChunksInFlight || cancelled; });
+        if (cancelled) return;
+        chunksInFlight++;
+      }
+
+      std::weak_ptr<PointCloudPLYLoad> weakSelf = self;
+      postToMainThread([weakSelf, chunk, start]() {
+        std::shared_ptr<PointCloudPLYLoad> load = weakSelf.lock();
+        if (!load) return; // the point cloud was removed
+        load->applyChunk(*chunk, start);
+      });
+      start += count;
+    }
+  }
+
+  // On the main thread
+  void applyChunk(const std::vector<glm::vec3>& chunk, size_t start) {
+    cloud->points.ensureHostBufferPopulated();
+    std::copy(chunk.begin(), chunk.end(), cloud->points.data.begin() + start);
+    cloud->setValidPointCount(start + chunk.size());
+    updateStructureExtents();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      chunksInFlight--;
+    }
+    cv.notify_all();
+  }
+};
+
+// == Surface meshes
+
+struct SurfaceMeshPLYLoad {
+  std::string name;
+  std::string filename;
+  std::function<void(SurfaceMesh*)> onLoaded;
+  std::ifstream in;
+  PlyHeader header;
+  std::atomic<bool> cancelled{false};
+  std::thread worker;
+
+  // read straight in to the final arrays
+  std::vector<glm::vec3> vertexPositions;
+  std::vector<uint32_t> faceIndsEntries;
+  std::vector<uint32_t> faceIndsStart;
+
+  ~SurfaceMeshPLYLoad() {
+    cancelled = true;
+    if (worker.joinable()) worker.join();
+  }
+
+  void run() {
+    try {
+      PlyDataReader reader(in, header.format);
+      for (const PlyElement& element : header.elements) {
+        if (cancelled) return;
+        if (element.name == "vertex") {
+          readVertices(reader, element);
+        } else if (element.name == "face") {
+          readFaces(reader, element);
+        } else {
+          reader.skipElement(element);
+        }
+      }
+    } catch (const std::exception& e) {
+      if (!cancelled) postLoadWarning(filename, e.what());
+      finish(false);
+      return;
+    }
+    finish(true);
+  }
+
+  void readVertices(PlyDataReader& reader, const PlyElement& element) {
+    std::array<int, 3> posProps = findPositionProperties(element, filename);
+    vertexPositions.resize(element.count);
+    for (size_t iV = 0; iV < element.count; iV++) {
+      if (cancelled) return;
+      glm::vec3& p = vertexPositions[iV];
+      reader.readRecord(
+          element,
+          [&](size_t iProp, double val) {
+            for (int c = 0; c < 3; c++) {
+              if (static_cast<int>(iProp) == posProps[c]) p[c] = static_cast<float>(val);
+            }
+          },
+          [](size_t, size_t) {});
+    }
+  }
+
+  void readFaces(PlyDataReader& reader, const PlyElement& element) {
+    int indsProp = element.findProperty("vertex_indices");
+    if (indsProp < 0) indsProp = element.findProperty("vertex_index");
+
+    faceIndsStart.reserve(element.count + 1);
+    faceIndsEntries.reserve(3 * element.count);
+    faceIndsStart.push_back(0);
+    for (size_t iF = 0; iF < element.count; iF++) {
+      if (cancelled) return;
+      reader.readRecord(
+          element,
+          [&](size_t iProp, double val) {
+            if (static_cast<int>(iProp) == indsProp) faceIndsEntries.push_back(static_cast<uint32_t>(val));
+          },
+          [](size_t, size_t) {});
+      faceIndsStart.push_back(static_cast<uint32_t>(faceIndsEntries.size()));
+    }
+  }
+
+  void finish(bool success);
+};
+
+// Mesh loads which are still running; removed once their mesh has been registered
+std::list<std::shared_ptr<SurfaceMeshPLYLoad>> pendingMeshLoads;
+
+void SurfaceMeshPLYLoad::finish(bool success) {
+  if (cancelled) return;
+  SurfaceMeshPLYLoad* load = this;
+  postToMainThread([load, success]() {
+    // take ownership back from the pending list
+    std::shared_ptr<SurfaceMeshPLYLoad> loadPtr;
+    for (std::list<std::shared_ptr<SurfaceMeshPLYLoad>>::iterator it = pendingMeshLoads.begin();
+         it != pendingMeshLoads.end(); ++it) {
+      if (it->get() == load) {
+        loadPtr = *it;
+        pendingMeshLoads.erase(it);
+        break;
+      }
+    }
+    if (!loadPtr) return;
+    loadPtr->worker.join(); // it has nothing left to do
+    if (!success) return;
+
+    SurfaceMesh* mesh = new SurfaceMesh(loadPtr->name);
+    mesh->vertexPositions.data.swap(loadPtr->vertexPositions);
+    mesh->vertexPositions.markHostBufferUpdated();
+    mesh->faceIndsStart.swap(loadPtr->faceIndsStart);
+    mesh->faceIndsEntries.swap(loadPtr->faceIndsEntries);
+    mesh->computeConnectivityData();
+    mesh->updateObjectSpaceBounds();
+
+    bool registered = registerStructure(mesh);
+    if (!registered) {
+      safeDelete(mesh);
+      return;
+    }
+    if (loadPtr->onLoaded) loadPtr->onLoaded(mesh);
+  });
+}
+
+} // namespace
+
+PointCloud* registerPointCloudPLYStreaming(std::string name, std::string filename, size_t chunkSize) {
+  checkInitialized();
+
+  std::shared_ptr<PointCloudPLYLoad> load = std::make_shared<PointCloudPLYLoad>();
+  load->self = load;
+  load->filename = filename;
+  load->chunkSize = std::max<size_t>(chunkSize, 1);
+  openPly(filename, load->in, load->header);
+
+  int vertexElement = findElement(load->header, "vertex");
+  if (vertexElement < 0) {
+    exception("PLY file " + filename + " has no vertices");
+    return nullptr;
+  }
+  findPositionProperties(load->header.elements[vertexElement], filename);
+
+  // All points are allocated up front, and filled in as they are read
+  PointCloud* cloud =
+      new PointCloud(name, std::vector<glm::vec3>(load->header.elements[vertexElement].count, glm::vec3{0., 0., 0.}));
+  cloud->setValidPointCount(0);
+  bool success = registerStructure(cloud);
+  if (!success) {
+    safeDelete(cloud);
+    return nullptr;
+  }
+
+  load->cloud = cloud;
+  cloud->backgroundLoader = load;
+  load->worker = std::thread(&PointCloudPLYLoad::run, load.get());
+  return cloud;
+}
+
+void registerSurfaceMeshPLYStreaming(std::string name, std::string filename,
+                                     std::function<void(SurfaceMesh*)> onLoaded) {
+  checkInitialized();
+
+  std::shared_ptr<SurfaceMeshPLYLoad> load = std::make_shared<SurfaceMeshPLYLoad>();
+  load->name = name;
+  load->filename = filename;
+  load->onLoaded = onLoaded;
+  openPly(filename, load->in, load->header);
+
+  int vertexElement = findElement(load->header, "vertex");
+  int faceElement = findElement(load->header, "face");
+  if (vertexElement < 0 || faceElement < 0) {
+    exception("PLY file " + filename + " does not have both vertices and faces");
+    return;
+  }
+  findPositionProperties(load->header.elements[vertexElement], filename);
+  const PlyElement& faces = load->header.elements[faceElement];
+  int indsProp = faces.findProperty("vertex_indices");
+  if (indsProp < 0) indsProp = faces.findProperty("vertex_index");
+  if (indsProp < 0 || !faces.properties[indsProp].isList) {
+    exception("PLY file " + filename + " faces do not have a vertex_indices list");
+    return;
+  }
+
+  pendingMeshLoads.push_back(load);
+  load->worker = std::thread(&SurfaceMeshPLYLoad::run, load.get());
+}
+
+} // namespace polyscope
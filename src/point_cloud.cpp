@@ -3,16 +3,22 @@
 #include "polyscope/point_cloud.h"
 
 #include "polyscope/file_helpers.h"
+#include "polyscope/internal.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
 #include "polyscope/point_cloud_color_quantity.h"
+#include "polyscope/point_cloud_label_quantity.h"
 #include "polyscope/point_cloud_scalar_quantity.h"
 #include "polyscope/point_cloud_vector_quantity.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
@@ -30,7 +36,15 @@ PointCloud::PointCloud(std::string name, std::vector<glm::vec3> points_)
       pointRenderMode(uniquePrefix() + "#pointRenderMode", "sphere"),
       pointColor(uniquePrefix() + "#pointColor", getNextUniqueColor()),
       pointRadius(uniquePrefix() + "#pointRadius", relativeValue(0.005)),
-      material(uniquePrefix() + "#material", "clay")
+      material(uniquePrefix() + "#material", "clay"),
+      lodEnabled(uniquePrefix() + "#lodEnabled", false),
+      lodPointsPerPixel(uniquePrefix() + "#lodPointsPerPixel", 1.),
+      instancedDrawing(uniquePrefix() + "#instancedDrawing", false),
+      depthPrepass(uniquePrefix() + "#depthPrepass", false),
+      spatialOrderEnabled(uniquePrefix() + "#spatialOrderEnabled", options::spatiallyOrderPointClouds),
+      lodOrder(uniquePrefix() + "#lodOrder", lodOrderData),
+      spatialOrder(uniquePrefix() + "#spatialOrder", spatialOrderData),
+      depthOrder(uniquePrefix() + "#depthOrder", depthOrderData)
 // clang-format on
 {
   cullWholeElements.setPassive(true);
@@ -39,17 +53,13 @@ PointCloud::PointCloud(std::string name, std::vector<glm::vec3> points_)
 
 // Helper to set uniforms
 void PointCloud::setPointCloudUniforms(render::ShaderProgram& p) {
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-
-  if (getPointRenderMode() == PointRenderMode::Sphere) {
-    p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-    p.setUniform("u_viewport", render::engine->getCurrentViewport());
-  }
+  setPointCloudUniforms(p, p.getUniformHandle("u_pointRadius"));
+}
 
+void PointCloud::setPointCloudUniforms(render::ShaderProgram& p, render::UniformHandle pointRadiusHandle) {
   if (pointRadiusQuantityName != "" && !pointRadiusQuantityAutoscale) {
     // special case: ignore radius uniform
-    p.setUniform("u_pointRadius", 1.);
+    p.setUniform(pointRadiusHandle, 1.);
   } else {
     // common case
 
@@ -59,7 +69,22 @@ void PointCloud::setPointCloudUniforms(render::ShaderProgram& p) {
       scalarQScale = std::max(0., radQ.getDataRange().second);
     }
 
-    p.setUniform("u_pointRadius", pointRadius.get().asAbsolute() / scalarQScale);
+    p.setUniform(pointRadiusHandle, pointRadius.get().asAbsolute() / scalarQScale);
+  }
+
+  if (thresholdQuantityName != "" && p.hasUniform("u_thresholdLow")) {
+    p.setUniform("u_thresholdLow", thresholdRange.first);
+    p.setUniform("u_thresholdHigh", thresholdRange.second);
+  }
+
+  // Only a prefix of the points is drawn while loading or with LOD; instanced programs draw that many instances
+  size_t drawCount = drawnPointCount();
+  if (getInstancedDrawing()) {
+    p.setInstanceCount(static_cast<uint32_t>(drawCount));
+  } else if (drawCount < nPoints() || getLODEnabled()) {
+    p.setDrawRanges({{0, drawCount}});
+  } else {
+    p.clearDrawRanges();
   }
 }
 
@@ -77,6 +102,31 @@ void PointCloud::draw() {
     internal::pointCloudEfficiencyWarningReported = true;
   }
 
+  if (getLODEnabled()) {
+    updateLODDrawCount();
+  }
+
+  // The programs draw through the depth order while it is used
+  bool depthSorted = usesDepthSort();
+  if (depthSorted != programsDepthSorted) {
+    programsDepthSorted = depthSorted;
+    refreshPrograms();
+  }
+  if (programsDepthSorted) {
+    updateDepthOrder();
+  }
+
+  // Lay down the depth of the spheres first, so that the shading below only runs for the visible fragment of each pixel
+  bool prepass = usesDepthPrepass();
+  if (prepass) {
+    ensurePickProgramPrepared();
+    setStructureUniforms(*pickProgram);
+    setPointCloudUniforms(*pickProgram);
+    render::engine->setColorMask({false, false, false, false});
+    pickProgram->draw();
+    render::engine->setColorMask();
+    render::engine->setDepthMode(DepthMode::LEqual);
+  }
 
   // If there is no dominant quantity, then this class is responsible for drawing points
   if (dominantQuantity == nullptr) {
@@ -86,8 +136,8 @@ void PointCloud::draw() {
 
     // Set program uniforms
     setStructureUniforms(*program);
-    setPointCloudUniforms(*program);
-    program->setUniform("u_baseColor", pointColor.get());
+    setPointCloudUniforms(*program, programPointRadius);
+    program->setUniform(programBaseColor, pointColor.get());
 
     // Draw the actual point cloud
     program->draw();
@@ -100,6 +150,14 @@ void PointCloud::draw() {
   for (auto& x : floatingQuantities) {
     x.second->draw();
   }
+
+  if (prepass) render::engine->setDepthMode();
+}
+
+bool PointCloud::usesDepthPrepass() {
+  // (with transparency the fragments behind are needed too, and quads don't write a depth of their own)
+  return getDepthPrepass() && getPointRenderMode() == PointRenderMode::Sphere &&
+         render::engine->getTransparencyMode() == TransparencyMode::None;
 }
 
 void PointCloud::drawDelayed() {
@@ -122,6 +180,9 @@ void PointCloud::drawPick() {
 
   // Ensure we have prepared buffers
   ensurePickProgramPrepared();
+  if (getLODEnabled() && lodLastUpdate == INVALID_IND_64) {
+    updateLODDrawCount(); // not drawn yet
+  }
 
   // Set uniforms
   setStructureUniforms(*pickProgram);
@@ -140,6 +201,8 @@ void PointCloud::ensureRenderProgramPrepared() {
       addPointCloudRules({"SHADE_BASECOLOR"})
   );
   // clang-format on
+  programPointRadius = program->getUniformHandle("u_pointRadius");
+  programBaseColor = program->getUniformHandle("u_baseColor");
 
   setPointProgramGeometryAttributes(*program);
 
@@ -149,50 +212,389 @@ void PointCloud::ensureRenderProgramPrepared() {
 void PointCloud::ensurePickProgramPrepared() {
   ensureRenderProgramPrepared();
 
-  // Request pick indices
-  size_t pickCount = nPoints();
-  size_t pickStart = pick::requestPickBufferRange(this, pickCount);
+  // If already prepared, do nothing
+  if (pickProgram) return;
+
+  // Request pick indices. A cloud which is being appended to gets headroom, so that the pick program does not need to
+  // be rebuilt for every append (pick colors are computed from the vertex ID, so nothing else depends on the count).
+  pickRangeCount = nPoints();
+  if (appendedTo) {
+    pickRangeCount = std::min(pickRangeCount + pickRangeCount / 2 + 1024, maxPointCount);
+  }
+  size_t pickStart = pick::requestPickBufferRange(this, pickRangeCount);
 
-  // Create a new pick program
+  // Create a new pick program. Pick colors are computed in the shader from the point index; the LOD and spatial draw
+  // orders shuffle the points, so in that case the index comes from the order buffer.
+  render::ManagedBuffer<uint32_t>* drawOrder = ensureDrawOrder();
   // clang-format off
   pickProgram = render::engine->requestShader(
       getShaderNameForRenderMode(), 
-      addPointCloudRules({"SPHERE_PROPAGATE_COLOR"}, true),
+      removeSubsetHighlightRules(
+          addPointCloudRules({drawOrder ? "SPHERE_PROPAGATE_PICK_INDEXED" : "SPHERE_PROPAGATE_PICK"}, true)),
       render::ShaderReplacementDefaults::Pick
   );
   // clang-format on
+  pickProgram->setMemoryOwner(uniquePrefix() + "pick");
 
   setPointProgramGeometryAttributes(*pickProgram);
-
-  // Fill color buffer with packed point indices
-  std::vector<glm::vec3> pickColors;
-  for (size_t i = pickStart; i < pickStart + pickCount; i++) {
-    glm::vec3 val = pick::indToVec(i);
-    pickColors.push_back(pick::indToVec(i));
+  pickProgram->setUniform("u_pickStart", pick::indToDigits(pickStart));
+  if (drawOrder) {
+    pickProgram->setAttribute("a_pickIndex", drawOrder->getRenderAttributeBuffer());
   }
-
-  // Store data in buffers
-  pickProgram->setAttribute("a_color", pickColors);
 }
 
 void PointCloud::setPointProgramGeometryAttributes(render::ShaderProgram& p) {
-  p.setAttribute("a_position", points.getRenderAttributeBuffer());
+  p.setAttribute("a_position", getPointAttributeBuffer(points));
   if (pointRadiusQuantityName != "") {
     PointCloudScalarQuantity& radQ = resolvePointRadiusQuantity();
-    p.setAttribute("a_pointRadius", radQ.values.getRenderAttributeBuffer());
+    p.setAttribute("a_pointRadius", getPointAttributeBuffer(radQ.values));
+  }
+  if (thresholdQuantityName != "") {
+    PointCloudScalarQuantity& thresholdQ = resolveThresholdQuantity();
+    p.setAttribute("a_thresholdValue", getPointAttributeBuffer(thresholdQ.values));
+  }
+  if (p.hasAttribute("a_subsetIndex")) {
+    p.setAttribute("a_subsetIndex", ensureDrawOrder()->getRenderAttributeBuffer());
+  }
+
+  if (getInstancedDrawing()) {
+    // The two triangles of the quad are the only per-vertex data; everything per-point advances once per instance
+    // (including attributes the quantities set after this).
+    std::vector<glm::vec2> quadCorners = {{-1., -1.}, {1., -1.}, {-1., 1.}, {-1., 1.}, {1., -1.}, {1., 1.}};
+    p.setAttribute("a_quadCorner", quadCorners);
+    for (const char* attrName : {"a_position", "a_pointRadius", "a_thresholdValue", "a_value", "a_value2", "a_color",
+                                 "a_colorPacked", "a_labelIndex", "a_pickIndex", "a_subsetIndex"}) {
+      if (p.hasAttribute(attrName)) p.setAttributePerInstance(attrName);
+    }
+  }
+
+  if (programsDepthSorted) {
+    p.setIndex(depthOrder.getRenderAttributeBuffer());
+  }
+}
+
+namespace {
+
+// Morton codes of the points on a 2^mortonLevels grid over the box
+const int mortonLevels = 10;
+std::vector<uint32_t> computeMortonCodes(const glm::vec3* pos, size_t n, glm::vec3 bMin, glm::vec3 bMax) {
+  const uint32_t gridRes = 1u << mortonLevels;
+  glm::vec3 cellScale = glm::vec3(1.f) / glm::max(bMax - bMin, glm::vec3(1e-20f));
+  auto spreadBits = [](uint32_t x) { // insert two zeros between each of the low 10 bits
+    x = (x | (x << 16)) & 0x030000FF;
+    x = (x | (x << 8)) & 0x0300F00F;
+    x = (x | (x << 4)) & 0x030C30C3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+  };
+  std::vector<uint32_t> code(n);
+  parallelFor(0, n, [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      glm::vec3 t = (pos[i] - bMin) * cellScale;
+      uint32_t c[3];
+      for (int d = 0; d < 3; d++) {
+        c[d] = std::min(gridRes - 1, static_cast<uint32_t>(std::max(0.f, t[d]) * gridRes));
+      }
+      code[i] = spreadBits(c[0]) | (spreadBits(c[1]) << 1) | (spreadBits(c[2]) << 2);
+    }
+  });
+  return code;
+}
+
+// Maps floats to unsigned integers which sort in the same order
+uint32_t sortableFloatKey(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(float));
+  return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Stably sort the values by their keys (both are reordered), one byte at a time starting from the least significant.
+// Each pass counts the digits of blocks of the entries in parallel, then scatters the blocks in parallel, each to its
+// own offsets for every digit.
+void radixSortByKey(std::vector<uint32_t>& keys, std::vector<uint32_t>& values) {
+  size_t n = keys.size();
+  std::vector<uint32_t> keysOut(n), valuesOut(n);
+  size_t nBlocks = std::max<size_t>(1, std::min(4 * workerThreadCount(), n / 16384));
+  size_t blockSize = (n + nBlocks - 1) / nBlocks;
+  std::vector<std::array<size_t, 256>> offsets(nBlocks);
+
+  for (int shift = 0; shift < 32; shift += 8) {
+    parallelFor(
+        0, nBlocks,
+        [&](size_t bStart, size_t bEnd) {
+          for (size_t b = bStart; b < bEnd; b++) {
+            offsets[b].fill(0);
+            for (size_t i = b * blockSize; i < std::min(n, (b + 1) * blockSize); i++) {
+              offsets[b][(keys[i] >> shift) & 255]++;
+            }
+          }
+        },
+        1);
+
+    // (a pass where all the keys have the same digit changes nothing)
+    size_t total = 0;
+    bool singleDigit = false;
+    for (size_t d = 0; d < 256; d++) {
+      size_t digitStart = total;
+      for (size_t b = 0; b < nBlocks; b++) {
+        size_t count = offsets[b][d];
+        offsets[b][d] = total;
+        total += count;
+      }
+      if (total - digitStart == n) singleDigit = true;
+    }
+    if (singleDigit) continue;
+
+    parallelFor(
+        0, nBlocks,
+        [&](size_t bStart, size_t bEnd) {
+          for (size_t b = bStart; b < bEnd; b++) {
+            for (size_t i = b * blockSize; i < std::min(n, (b + 1) * blockSize); i++) {
+              size_t dst = offsets[b][(keys[i] >> shift) & 255]++;
+              keysOut[dst] = keys[i];
+              valuesOut[dst] = values[i];
+            }
+          }
+        },
+        1);
+    keys.swap(keysOut);
+    values.swap(valuesOut);
+  }
+}
+
+} // namespace
+
+void PointCloud::ensureHaveLODOrder() {
+  size_t n = nPoints();
+  if (lodOrder.size() == n) return;
+
+  // Morton codes on a 2^maxLevel grid over the bounding box, and a pseudo-random rank for each point
+  const int maxLevel = mortonLevels;
+  std::vector<uint32_t> code = computeMortonCodes(points.getPopulatedHostDataPtr(), n,
+                                                  std::get<0>(objectSpaceBoundingBox),
+                                                  std::get<1>(objectSpaceBoundingBox));
+  auto hashRank = [](uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+  };
+  std::vector<uint32_t> rank(n);
+  for (size_t i = 0; i < n; i++) rank[i] = hashRank(static_cast<uint32_t>(i));
+
+  // A point's level is the coarsest grid level at which it has the lowest rank in its cell, so each level adds one
+  // point to every cell which is newly occupied at that resolution. Cells at every level are contiguous in Morton
+  // order, so all levels are resolved in one pass over the sorted points.
+  std::vector<uint32_t> sorted(n);
+  for (size_t i = 0; i < n; i++) sorted[i] = i;
+  std::sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) { return code[a] < code[b]; });
+
+  std::vector<uint8_t> level(n, maxLevel + 1);
+  std::array<uint32_t, maxLevel + 1> cellBest;
+  auto finishCells = [&](int firstLevel) {
+    for (int L = firstLevel; L <= maxLevel; L++) {
+      uint8_t& l = level[cellBest[L]];
+      l = std::min<uint8_t>(l, L);
+    }
+  };
+  for (size_t k = 0; k < n; k++) {
+    uint32_t i = sorted[k];
+
+    // the coarsest level at which this point starts a new cell
+    int newCellLevel = maxLevel + 1;
+    if (k == 0) {
+      newCellLevel = 0;
+    } else {
+      uint32_t diff = code[i] ^ code[sorted[k - 1]];
+      for (int L = 0; L <= maxLevel; L++) {
+        if ((diff >> (3 * (maxLevel - L))) != 0) {
+          newCellLevel = L;
+          break;
+        }
+      }
+      if (newCellLevel <= maxLevel) finishCells(newCellLevel);
+    }
+
+    for (int L = 0; L <= maxLevel; L++) {
+      if (L >= newCellLevel || rank[i] < rank[cellBest[L]]) cellBest[L] = i;
+    }
+  }
+  if (n > 0) finishCells(0);
+
+  // Order by level, and randomly within each level
+  lodOrder.data = sorted;
+  std::sort(lodOrder.data.begin(), lodOrder.data.end(), [&](uint32_t a, uint32_t b) {
+    if (level[a] != level[b]) return level[a] < level[b];
+    return rank[a] < rank[b];
+  });
+  lodOrder.markHostBufferUpdated();
+}
+
+bool PointCloud::usesSpatialOrder() {
+  return getSpatialOrderEnabled() && !getLODEnabled() && !appendedTo && getValidPointCount() == nPoints();
+}
+
+void PointCloud::ensureHaveSpatialOrder() {
+  size_t n = nPoints();
+  if (spatialOrder.size() == n) return;
+
+  std::vector<uint32_t> code = computeMortonCodes(points.getPopulatedHostDataPtr(), n,
+                                                  std::get<0>(objectSpaceBoundingBox),
+                                                  std::get<1>(objectSpaceBoundingBox));
+  spatialOrder.data.resize(n);
+  for (size_t i = 0; i < n; i++) spatialOrder.data[i] = i;
+  std::sort(spatialOrder.data.begin(), spatialOrder.data.end(), [&](uint32_t a, uint32_t b) {
+    if (code[a] != code[b]) return code[a] < code[b];
+    return a < b;
+  });
+  spatialOrder.markHostBufferUpdated();
+}
+
+render::ManagedBuffer<uint32_t>* PointCloud::ensureDrawOrder() {
+  if (getLODEnabled()) {
+    ensureHaveLODOrder();
+    return &lodOrder;
+  }
+  if (usesSpatialOrder()) {
+    ensureHaveSpatialOrder();
+    return &spatialOrder;
+  }
+  return nullptr;
+}
+
+size_t PointCloud::drawnPointCount() {
+  if (getValidPointCount() < nPoints()) return getValidPointCount();
+  if (getLODEnabled()) return lodDrawCount;
+  return nPoints();
+}
+
+bool PointCloud::usesDepthSort() {
+  return render::engine->getTransparencyMode() == TransparencyMode::Sorted && getTransparency() < 1. &&
+         !getInstancedDrawing() && nPoints() > 0;
+}
+
+void PointCloud::updateDepthOrder() {
+  // only sort once per frame, on the first (main camera) draw
+  if (depthOrderLastUpdate == internal::renderSceneCount) return;
+  depthOrderLastUpdate = internal::renderSceneCount;
+
+  size_t n = drawnPointCount();
+  if (n == 0) {
+    depthOrder.data = {0}; // (nothing of it is drawn, see setPointCloudUniforms())
+    depthOrder.markHostBufferUpdated();
+    return;
+  }
+
+  // The view depth of a point is z = dot(depthRow, (p, 1)) in camera space, which is negative in front of the camera
+  glm::mat4 modelView = view::getCameraViewMatrix() * objectTransform.get();
+  glm::vec4 depthRow{modelView[0][2], modelView[1][2], modelView[2][2], modelView[3][2]};
+
+  // Sort the drawn copy of the positions on the device, if the backend can
+  if (render::engine->supportsPointDepthSort()) {
+    std::shared_ptr<render::AttributeBuffer> positions = getPointAttributeBuffer(points);
+    std::shared_ptr<render::AttributeBuffer> target = depthOrder.getRenderAttributeBufferForDeviceWrite(n);
+    if (render::engine->sortPointsByDepth(positions, n, depthRow, target)) {
+      depthOrder.markRenderAttributeBufferUpdated();
+      return;
+    }
+  }
+
+  // Otherwise on the host. The keys are computed in the previous order, so that one can be kept if it is still sorted.
+  std::vector<uint32_t>& order = depthOrder.data;
+  bool changed = false;
+  if (order.size() != n) {
+    order.resize(n);
+    for (size_t i = 0; i < n; i++) order[i] = i;
+    changed = true;
+  }
+  const glm::vec3* pos = points.getPopulatedHostDataPtr();
+  render::ManagedBuffer<uint32_t>* drawOrder = ensureDrawOrder();
+  const uint32_t* drawInds = drawOrder ? drawOrder->getPopulatedHostDataPtr() : nullptr;
+  std::vector<uint32_t> keys(n);
+  parallelFor(0, n, [&](size_t start, size_t end) {
+    for (size_t k = start; k < end; k++) {
+      uint32_t i = order[k];
+      glm::vec3 p = pos[drawInds ? drawInds[i] : i];
+      keys[k] = sortableFloatKey(glm::dot(glm::vec3(depthRow), p) + depthRow.w);
+    }
+  });
+  if (!std::is_sorted(keys.begin(), keys.end())) {
+    radixSortByKey(keys, order);
+    changed = true;
+  }
+  if (changed) depthOrder.markHostBufferUpdated();
+}
+
+std::vector<uint32_t> PointCloud::getDepthSortOrder() {
+  if (!programsDepthSorted) return {};
+  return depthOrder.getPopulatedHostBufferRef();
+}
+
+void PointCloud::updateLODDrawCount() {
+  // only update once per frame, on the first (main camera) draw
+  if (lodLastUpdate == internal::renderSceneCount) return;
+  lodLastUpdate = internal::renderSceneCount;
+
+  size_t n = nPoints();
+  glm::mat4 viewProjMat = view::getCameraPerspectiveMatrix() * view::getCameraViewMatrix() * objectTransform.get();
+
+  // Area of the bounding box on the screen, in pixels
+  glm::vec3 bMin = std::get<0>(objectSpaceBoundingBox);
+  glm::vec3 bMax = std::get<1>(objectSpaceBoundingBox);
+  glm::vec2 ndcMin{1., 1.};
+  glm::vec2 ndcMax{-1., -1.};
+  bool behindCamera = false;
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 corner{(i & 1) ? bMax.x : bMin.x, (i & 2) ? bMax.y : bMin.y, (i & 4) ? bMax.z : bMin.z};
+    glm::vec4 c = viewProjMat * glm::vec4(corner, 1.);
+    if (c.w <= 0) {
+      behindCamera = true;
+      break;
+    }
+    ndcMin = glm::min(ndcMin, glm::vec2(c) / c.w);
+    ndcMax = glm::max(ndcMax, glm::vec2(c) / c.w);
+  }
+  if (behindCamera) { // the camera is inside or very near the cloud, use the whole screen
+    ndcMin = glm::vec2{-1., -1.};
+    ndcMax = glm::vec2{1., 1.};
+  }
+  ndcMin = glm::clamp(ndcMin, glm::vec2(-1.), glm::vec2(1.));
+  ndcMax = glm::clamp(ndcMax, glm::vec2(-1.), glm::vec2(1.));
+  glm::vec2 extent = glm::max(ndcMax - ndcMin, glm::vec2(0.));
+  double pixelArea = 0.25 * extent.x * view::bufferWidth * extent.y * view::bufferHeight;
+
+  size_t target = std::min(n, static_cast<size_t>(getLODPointsPerPixel() * pixelArea) + 1);
+
+  // Draw a coarse subset while the camera moves, and refine while it is still
+  if (viewProjMat != lodLastViewProjMat || internal::interactiveQualityActive) {
+    lodDrawCount = std::max<size_t>(1, target / 8);
+  } else {
+    lodDrawCount = std::min(target, 2 * lodDrawCount);
+  }
+  lodDrawCount = std::min(lodDrawCount, n);
+  lodLastViewProjMat = viewProjMat;
+
+  if (lodDrawCount < target) {
+    internal::requestViewRedraw();
   }
 }
 
 std::string PointCloud::getShaderNameForRenderMode() {
+  std::string suffix = getInstancedDrawing() ? "_INSTANCED" : "";
+  if (programsDepthSorted) suffix = "_INDEXED";
   if (getPointRenderMode() == PointRenderMode::Sphere)
-    return "RAYCAST_SPHERE";
+    return "RAYCAST_SPHERE" + suffix;
   else if (getPointRenderMode() == PointRenderMode::Quad)
-    return "POINT_QUAD";
+    return "POINT_QUAD" + suffix;
   return "ERROR";
 }
 
 size_t PointCloud::nPoints() { return points.size(); }
 
+size_t PointCloud::nSubsetElements() { return nPoints(); }
+
 glm::vec3 PointCloud::getPointPosition(size_t iPt) { return points.getValue(iPt); }
 
 
@@ -202,12 +604,29 @@ std::vector<std::string> PointCloud::addPointCloudRules(std::vector<std::string>
     if (pointRadiusQuantityName != "") {
       initRules.push_back("SPHERE_VARIABLE_SIZE");
     }
+    if (thresholdQuantityName != "") {
+      initRules.push_back("SPHERE_PROPAGATE_THRESHOLD");
+      initRules.push_back("THRESHOLD_CULL");
+    }
+    // (the element index of a drawn point comes from the draw order, like the pick index)
+    initRules = addSubsetRules(initRules, ensureDrawOrder() ? "SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE"
+                                                            : "SPHERE_PROPAGATE_SUBSET_INDEX");
     if (wantsCullPosition()) {
       if (getPointRenderMode() == PointRenderMode::Sphere)
         initRules.push_back("SPHERE_CULLPOS_FROM_CENTER");
       else if (getPointRenderMode() == PointRenderMode::Quad)
         initRules.push_back("SPHERE_CULLPOS_FROM_CENTER_QUAD");
     }
+
+    // The instanced programs have no geometry shader, so the rules which pass data through one have their own versions
+    if (getInstancedDrawing()) {
+      for (std::string& rule : initRules) {
+        if (rule.find("SPHERE_PROPAGATE_") == 0 || rule == "SPHERE_VARIABLE_SIZE" ||
+            rule == "SPHERE_CULLPOS_FROM_CENTER_QUAD") {
+          rule += "_INSTANCED";
+        }
+      }
+    }
   }
   return initRules;
 }
@@ -228,8 +647,17 @@ PointCloudScalarQuantity& PointCloud::resolvePointRadiusQuantity() {
   return *sizeScalarQ;
 }
 
+PointCloudScalarQuantity& PointCloud::resolveThresholdQuantity() {
+  PointCloudScalarQuantity* thresholdQ = dynamic_cast<PointCloudScalarQuantity*>(getQuantity(thresholdQuantityName));
+  if (thresholdQ == nullptr) {
+    exception("Cannot threshold point cloud [" + name + "] by quantity [" + thresholdQuantityName +
+              "], it is not a scalar quantity of the cloud");
+  }
+  return *thresholdQ;
+}
+
 void PointCloud::buildPickUI(size_t localPickID) {
-  ImGui::TextUnformatted(("#" + std::to_string(localPickID) + "  ").c_str());
+  ImGui::Text("#%zu  ", localPickID);
   ImGui::SameLine();
   ImGui::TextUnformatted(to_string(getPointPosition(localPickID)).c_str());
 
@@ -250,6 +678,10 @@ void PointCloud::buildPickUI(size_t localPickID) {
 
 void PointCloud::buildCustomUI() {
   ImGui::Text("# points: %lld", static_cast<long long int>(nPoints()));
+  if (getValidPointCount() < nPoints()) {
+    ImGui::SameLine();
+    ImGui::Text("(%lld loaded)", static_cast<long long int>(getValidPointCount()));
+  }
   if (ImGui::ColorEdit3("Point color", &pointColor.get()[0], ImGuiColorEditFlags_NoInputs)) {
     setPointColor(getPointColor());
   }
@@ -261,6 +693,16 @@ void PointCloud::buildCustomUI() {
     requestRedraw();
   }
   ImGui::PopItemWidth();
+
+  if (thresholdQuantityName != "") {
+    float low = static_cast<float>(thresholdRange.first);
+    float high = static_cast<float>(thresholdRange.second);
+    std::pair<double, double> dataRange = resolveThresholdQuantity().getDataRange();
+    float speed = static_cast<float>((dataRange.second - dataRange.first) / 200.);
+    if (ImGui::DragFloatRange2("Threshold", &low, &high, speed, dataRange.first, dataRange.second, "%.4g")) {
+      setThresholdRange(low, high);
+    }
+  }
 }
 
 void PointCloud::buildCustomOptionsUI() {
@@ -301,44 +743,112 @@ void PointCloud::buildCustomOptionsUI() {
     ImGui::EndMenu();
   }
 
+  if (ImGui::BeginMenu("Threshold")) {
+
+    if (ImGui::MenuItem("none", nullptr, thresholdQuantityName == "")) clearThresholdQuantity();
+    ImGui::Separator();
+
+    for (auto& q : quantities) {
+      PointCloudScalarQuantity* scalarQ = dynamic_cast<PointCloudScalarQuantity*>(q.second.get());
+      if (scalarQ != nullptr) {
+        if (ImGui::MenuItem(scalarQ->name.c_str(), nullptr, thresholdQuantityName == scalarQ->name)) {
+          std::pair<double, double> dataRange = scalarQ->getDataRange();
+          setThresholdQuantity(scalarQ, dataRange.first, dataRange.second);
+        }
+      }
+    }
+
+    ImGui::EndMenu();
+  }
+
+  if (ImGui::MenuItem("Level of Detail", NULL, getLODEnabled())) setLODEnabled(!getLODEnabled());
+  if (ImGui::MenuItem("Instanced Drawing", NULL, getInstancedDrawing())) setInstancedDrawing(!getInstancedDrawing());
+  if (ImGui::MenuItem("Depth Pre-pass", NULL, getDepthPrepass())) setDepthPrepass(!getDepthPrepass());
+  if (ImGui::MenuItem("Spatial Draw Order", NULL, getSpatialOrderEnabled())) {
+    setSpatialOrderEnabled(!getSpatialOrderEnabled());
+  }
+
   if (render::buildMaterialOptionsGui(material.get())) {
     material.manuallyChanged();
     setMaterial(material.get()); // trigger the other updates that happen on set()
   }
 }
 
-void PointCloud::updateObjectSpaceBounds() {
-  points.ensureHostBufferPopulated();
+void PointCloud::updatePointPositions(std::vector<glm::vec3>&& newPositions) {
+  validateSize(newPositions, nPoints(), "point cloud updated positions " + name);
+  points.data = std::move(newPositions);
+  points.setStreaming(true); // positions which get updated are likely to be updated again, e.g. every frame
+  points.markHostBufferUpdated();
+  rayPickBVH.clear();
+}
 
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : points.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
-  }
+void PointCloud::updateObjectSpaceBounds() {
+  // read through the pointer, to avoid copying externally-owned positions
+  const glm::vec3* pos = points.getPopulatedHostDataPtr();
+  size_t nPos = getValidPointCount();
+
+  // bounding box, and length scale as twice the radius from the center of the bounding box
+  glm::vec3 min, max;
+  float lengthScale;
+  computeBoundsAndLengthScale(pos, nPos, min, max, lengthScale);
   objectSpaceBoundingBox = std::make_tuple(min, max);
-
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : points.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
-  }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+  objectSpaceLengthScale = lengthScale;
 }
 
+bool PointCloud::hasExtents() { return getValidPointCount() > 0; }
 
 std::string PointCloud::typeName() { return structureTypeName; }
 
 
 void PointCloud::refresh() {
+  rayPickBVH.clear();
+  lodLastUpdate = INVALID_IND_64;
+  refreshPrograms();
+}
+
+void PointCloud::refreshPrograms() {
   program.reset();
   pickProgram.reset();
   QuantityStructure<PointCloud>::refresh(); // call base class version, which refreshes quantities
 }
 
 
+RayPickResult PointCloud::rayPick(glm::vec3 rayStart, glm::vec3 rayDir) {
+  RayPickResult result;
+
+  rayDir = glm::normalize(rayDir);
+  glm::vec3 objStart, objDir;
+  std::tie(objStart, objDir) = rayToObjectSpace(rayStart, rayDir);
+
+  // NOTE: variable point radii from a quantity are not accounted for
+  float objRadius = static_cast<float>(getPointRadius()) * glm::length(objDir);
+
+  const glm::vec3* pos = points.getPopulatedHostDataPtr();
+  size_t nPos = points.size();
+
+  // (Re)build the acceleration structure if needed
+  if (!rayPickBVH.isBuilt() || rayPickBVHRadius != objRadius) {
+    std::vector<glm::vec3> primMin(nPos), primMax(nPos);
+    glm::vec3 r{objRadius, objRadius, objRadius};
+    for (size_t i = 0; i < nPos; i++) {
+      primMin[i] = pos[i] - r;
+      primMax[i] = pos[i] + r;
+    }
+    rayPickBVH.build(primMin, primMax);
+    rayPickBVHRadius = objRadius;
+  }
+
+  std::pair<size_t, float> hit = rayPickBVH.intersectRay(
+      objStart, objDir, [&](size_t i) { return raySphereIntersection(objStart, objDir, pos[i], objRadius); });
+  if (hit.first == INVALID_IND) return result;
+
+  result.isHit = true;
+  result.depth = hit.second;
+  result.position = rayStart + hit.second * rayDir;
+  result.elementInd = hit.first;
+  return result;
+}
+
 // === Set point size from a scalar quantity
 void PointCloud::setPointRadiusQuantity(PointCloudScalarQuantity* quantity, bool autoScale) {
   setPointRadiusQuantity(quantity->name, autoScale);
@@ -358,6 +868,32 @@ void PointCloud::clearPointRadiusQuantity() {
   refresh();
 }
 
+void PointCloud::setThresholdQuantity(PointCloudScalarQuantity* quantity, double low, double high) {
+  setThresholdQuantity(quantity->name, low, high);
+}
+
+void PointCloud::setThresholdQuantity(std::string name, double low, double high) {
+  if (dynamic_cast<PointCloudScalarQuantity*>(getQuantity(name)) == nullptr) {
+    exception("Cannot threshold point cloud [" + this->name + "] by quantity [" + name +
+              "], it is not a scalar quantity of the cloud");
+  }
+  thresholdQuantityName = name;
+  thresholdRange = {low, high};
+  refresh();
+}
+
+void PointCloud::setThresholdRange(double low, double high) {
+  thresholdRange = {low, high};
+  requestRedraw();
+}
+
+std::pair<double, double> PointCloud::getThresholdRange() { return thresholdRange; }
+
+void PointCloud::clearThresholdQuantity() {
+  thresholdQuantityName = "";
+  refresh();
+}
+
 // === Quantities
 
 // Quantity default methods
@@ -370,15 +906,52 @@ void PointCloudQuantity::buildInfoGUI(size_t pointInd) {}
 // === Quantity adders
 
 
-PointCloudColorQuantity* PointCloud::addColorQuantityImpl(std::string name, const std::vector<glm::vec3>& colors) {
-  PointCloudColorQuantity* q = new PointCloudColorQuantity(name, colors, *this);
+PointCloudScalarQuantity* PointCloud::addScalarQuantity(std::string name, std::vector<float>&& values, DataType type) {
+  validateSize(values, nPoints(), "point cloud scalar quantity " + name);
+  return addScalarQuantityImpl(name, std::move(values), type);
+}
+
+PointCloudColorQuantity* PointCloud::addColorQuantity(std::string name, std::vector<glm::vec3>&& values) {
+  validateSize(values, nPoints(), "point cloud color quantity " + name);
+  return addColorQuantityImpl(name, std::move(values));
+}
+
+PointCloudVectorQuantity* PointCloud::addVectorQuantity(std::string name, std::vector<glm::vec3>&& vectors,
+                                                        VectorType vectorType) {
+  validateSize(vectors, nPoints(), "point cloud vector quantity " + name);
+  return addVectorQuantityImpl(name, std::move(vectors), vectorType);
+}
+
+PointCloudColorQuantity* PointCloud::addColorQuantityImpl(std::string name, std::vector<glm::vec3> colors) {
+  PointCloudColorQuantity* q = new PointCloudColorQuantity(name, std::move(colors), *this);
+  addQuantity(q);
+  return q;
+}
+
+PointCloudColorQuantity* PointCloud::addPackedColorQuantityImpl(std::string name, std::vector<uint32_t> packedColors) {
+  PointCloudColorQuantity* q = new PointCloudColorQuantity(name, std::move(packedColors), *this);
   addQuantity(q);
   return q;
 }
 
-PointCloudScalarQuantity* PointCloud::addScalarQuantityImpl(std::string name, const std::vector<double>& data,
-                                                            DataType type) {
-  PointCloudScalarQuantity* q = new PointCloudScalarQuantity(name, data, *this, type);
+PointCloudLabelQuantity* PointCloud::addLabelQuantityImpl(std::string name, const std::vector<uint32_t>& labels) {
+  PointCloudLabelQuantity* q = new PointCloudLabelQuantity(name, labels, *this);
+  addQuantity(q);
+  return q;
+}
+
+PointCloudScalarQuantity* PointCloud::addScalarQuantityImpl(std::string name, std::vector<float> data, DataType type) {
+  PointCloudScalarQuantity* q = new PointCloudScalarQuantity(name, std::move(data), *this, type);
+  addQuantity(q);
+  return q;
+}
+
+PointCloudTimeSeriesScalarQuantity* PointCloud::addTimeSeriesScalarQuantityImpl(std::string name,
+                                                                                const std::vector<float>& frameValues,
+                                                                                size_t nFrames, DataType type,
+                                                                                bool halfPrecision) {
+  PointCloudTimeSeriesScalarQuantity* q =
+      new PointCloudTimeSeriesScalarQuantity(name, frameValues, nFrames, *this, type, halfPrecision);
   addQuantity(q);
   return q;
 }
@@ -401,9 +974,9 @@ PointCloud::addLocalParameterizationQuantityImpl(std::string name, const std::ve
   return q;
 }
 
-PointCloudVectorQuantity* PointCloud::addVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors,
+PointCloudVectorQuantity* PointCloud::addVectorQuantityImpl(std::string name, std::vector<glm::vec3> vectors,
                                                             VectorType vectorType) {
-  PointCloudVectorQuantity* q = new PointCloudVectorQuantity(name, vectors, *this, vectorType);
+  PointCloudVectorQuantity* q = new PointCloudVectorQuantity(name, std::move(vectors), *this, vectorType);
   addQuantity(q);
   return q;
 }
@@ -417,8 +990,8 @@ PointCloud* PointCloud::setPointRenderMode(PointRenderMode newVal) {
     pointRenderMode = "quad";
     break;
   }
-  refresh();
-  polyscope::requestRedraw();
+  refreshPrograms(); // the geometry is the same, only the shaders change
+  requestRedraw();
   return this;
 }
 PointRenderMode PointCloud::getPointRenderMode() {
@@ -432,24 +1005,226 @@ PointRenderMode PointCloud::getPointRenderMode() {
 
 PointCloud* PointCloud::setPointColor(glm::vec3 newVal) {
   pointColor = newVal;
-  polyscope::requestRedraw();
+  requestRedraw();
   return this;
 }
 glm::vec3 PointCloud::getPointColor() { return pointColor.get(); }
 
 PointCloud* PointCloud::setMaterial(std::string m) {
   material = m;
-  refresh();
+  // the material is just a set of textures, swap them on the existing programs
+  if (program) render::engine->setMaterial(*program, getMaterial());
+  refreshQuantityMaterials();
   requestRedraw();
   return this;
 }
 std::string PointCloud::getMaterial() { return material.get(); }
+std::string PointCloud::drawSortKey() { return material.get(); }
+
+PointCloud* PointCloud::setLODEnabled(bool newVal) {
+  lodEnabled = newVal;
+  refresh(); // draw buffers are gathered through the LOD order
+  requestRedraw();
+  return this;
+}
+bool PointCloud::getLODEnabled() { return lodEnabled.get(); }
+
+PointCloud* PointCloud::setLODPointsPerPixel(float newVal) {
+  lodPointsPerPixel = newVal;
+  requestRedraw();
+  return this;
+}
+float PointCloud::getLODPointsPerPixel() { return lodPointsPerPixel.get(); }
+
+PointCloud* PointCloud::setInstancedDrawing(bool newVal) {
+  instancedDrawing = newVal;
+  refreshPrograms(); // the geometry is the same, only the shaders change
+  requestRedraw();
+  return this;
+}
+bool PointCloud::getInstancedDrawing() { return instancedDrawing.get(); }
+
+PointCloud* PointCloud::setDepthPrepass(bool newVal) {
+  depthPrepass = newVal;
+  requestRedraw();
+  return this;
+}
+bool PointCloud::getDepthPrepass() { return depthPrepass.get(); }
+
+size_t PointCloud::getLODDrawCount() { return getLODEnabled() ? lodDrawCount : nPoints(); }
+
+PointCloud* PointCloud::setSpatialOrderEnabled(bool newVal) {
+  spatialOrderEnabled = newVal;
+  refreshPrograms(); // draw buffers are gathered through the spatial order
+  requestRedraw();
+  return this;
+}
+bool PointCloud::getSpatialOrderEnabled() { return spatialOrderEnabled.get(); }
+
+void PointCloud::setValidPointCount(size_t n) {
+  n = std::min(n, nPoints());
+  size_t oldCount = getValidPointCount();
+  bool wasUsingSpatialOrder = usesSpatialOrder();
+  validPointCount = n;
+  if (usesSpatialOrder() != wasUsingSpatialOrder) {
+    spatialOrder.reset(); // (built from the positions once they are all loaded)
+    refreshPrograms();
+  }
+  if (n > oldCount) {
+    points.markHostBufferRangeUpdated(oldCount, n);
+  }
+  rayPickBVH.clear();
+
+  if (n == nPoints() || n < oldCount || oldCount == 0) {
+    updateObjectSpaceBounds();
+  } else {
+    // rather than rescanning all of the points for every chunk (the length scale is exact again after the final one)
+    growObjectSpaceBounds(points.getPopulatedHostDataPtr() + oldCount, n - oldCount);
+  }
+  requestRedraw();
+}
+
+void PointCloud::growObjectSpaceBounds(const glm::vec3* pos, size_t count) {
+  glm::vec3 min = std::get<0>(objectSpaceBoundingBox);
+  glm::vec3 max = std::get<1>(objectSpaceBoundingBox);
+  for (size_t i = 0; i < count; i++) {
+    min = componentwiseMin(min, pos[i]);
+    max = componentwiseMax(max, pos[i]);
+  }
+  objectSpaceBoundingBox = std::make_tuple(min, max);
+  objectSpaceLengthScale = glm::length(max - min);
+}
+
+void PointCloud::appendPointsImpl(const std::vector<glm::vec3>& newPoints) {
+  size_t oldCount = nPoints();
+  bool allValid = getValidPointCount() == oldCount;
+  if (usesSpatialOrder()) {
+    refreshPrograms(); // appended points are drawn in order, see setSpatialOrderEnabled()
+  }
+  if (maxPointCount != INVALID_IND && !allValid) {
+    exception("PointCloud [" + name + "] cannot append to a point cloud with a max point count while it is loading");
+  }
+
+  // Lay out the new points: fill the cloud up to the maximum, then overwrite the oldest points
+  lastAppend.oldSize = oldCount;
+  lastAppend.count = newPoints.size();
+  lastAppend.skip = 0;
+  if (maxPointCount != INVALID_IND && newPoints.size() > maxPointCount) {
+    lastAppend.skip = newPoints.size() - maxPointCount;
+  }
+  size_t nKept = newPoints.size() - lastAppend.skip;
+  size_t nFree = maxPointCount == INVALID_IND ? nKept : maxPointCount - oldCount;
+  lastAppend.nGrow = std::min(nKept, nFree);
+  lastAppend.overwriteStart = ringHead;
+  size_t nOverwrite = nKept - lastAppend.nGrow;
+  if (nOverwrite > 0) {
+    ringHead = (ringHead + nOverwrite) % maxPointCount;
+  }
+  appendedTo = true;
+
+  appendPointValues(points, newPoints);
+  rayPickBVH.clear();
+  if (nPoints() > pickRangeCount) {
+    pickProgram.reset(); // (re-requests a larger pick range)
+  }
+
+  // (the LOD order is rebuilt when it is next needed, since its size no longer matches)
+  if (!allValid) {
+    // the new points come after ones which are not valid yet, see setValidPointCount()
+  } else if (oldCount == 0) {
+    updateObjectSpaceBounds();
+  } else {
+    growObjectSpaceBounds(newPoints.data() + lastAppend.skip, nKept);
+  }
+  requestRedraw();
+}
+
+void PointCloud::appendPointsImpl(const std::vector<glm::vec3>& newPoints,
+                                  const std::map<std::string, std::vector<float>>& scalarValues,
+                                  const std::map<std::string, std::vector<glm::vec3>>& colorValues) {
+
+  // Check everything before appending anything, so a bad argument leaves the cloud as it was
+  std::vector<PointCloudScalarQuantity*> scalarQs;
+  for (const auto& entry : scalarValues) {
+    PointCloudScalarQuantity* q = dynamic_cast<PointCloudScalarQuantity*>(getQuantity(entry.first));
+    if (q == nullptr) {
+      exception("PointCloud [" + name + "] has no scalar quantity named " + entry.first + " to append to");
+    }
+    validateSize(entry.second, newPoints.size(), "appended values of " + entry.first);
+    scalarQs.push_back(q);
+  }
+  std::vector<PointCloudColorQuantity*> colorQs;
+  for (const auto& entry : colorValues) {
+    PointCloudColorQuantity* q = dynamic_cast<PointCloudColorQuantity*>(getQuantity(entry.first));
+    if (q == nullptr) {
+      exception("PointCloud [" + name + "] has no color quantity named " + entry.first + " to append to");
+    }
+    validateSize(entry.second, newPoints.size(), "appended colors of " + entry.first);
+    colorQs.push_back(q);
+  }
+
+  appendPointsImpl(newPoints);
+
+  size_t iQ = 0;
+  for (const auto& entry : scalarValues) {
+    appendPointValues(scalarQs[iQ++]->values, entry.second);
+  }
+  iQ = 0;
+  for (const auto& entry : colorValues) {
+    PointCloudColorQuantity* q = colorQs[iQ++];
+    if (q->isPacked()) {
+      std::vector<uint32_t> packedColors(entry.second.size());
+      for (size_t i = 0; i < entry.second.size(); i++) packedColors[i] = packColorRGBA8(entry.second[i]);
+      appendPointValues(q->colorsPacked, packedColors);
+    } else {
+      appendPointValues(q->colors, entry.second);
+    }
+  }
+}
+
+void PointCloud::setMaxPointCount(size_t n) {
+  if (n == 0 || n < nPoints()) {
+    exception("PointCloud [" + name + "] max point count " + std::to_string(n) + " must be positive and at least " +
+              "the current point count " + std::to_string(nPoints()));
+  }
+  maxPointCount = n;
+  ringHead = 0;
+}
+
+size_t PointCloud::getMaxPointCount() { return maxPointCount; }
+
+size_t PointCloud::getValidPointCount() { return std::min(validPointCount, nPoints()); }
 
 PointCloud* PointCloud::setPointRadius(double newVal, bool isRelative) {
   pointRadius = ScaledValue<float>(newVal, isRelative);
-  polyscope::requestRedraw();
+  requestRedraw();
   return this;
 }
 double PointCloud::getPointRadius() { return pointRadius.get().asAbsolute(); }
 
+PointCloud* registerPointCloud(std::string name, std::vector<glm::vec3>&& points) {
+  checkInitialized();
+
+  PointCloud* s = new PointCloud(name, std::move(points));
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+PointCloud* registerPointCloud(std::string name, const glm::vec3* points, size_t nPoints,
+                               std::shared_ptr<const void> owner) {
+  checkInitialized();
+
+  PointCloud* s = new PointCloud(name, std::vector<glm::vec3>());
+  s->points.setExternalData(points, nPoints, owner);
+  s->updateObjectSpaceBounds();
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
 } // namespace polyscope
@@ -9,9 +9,13 @@
 namespace polyscope {
 
 
-PointCloudColorQuantity::PointCloudColorQuantity(std::string name, const std::vector<glm::vec3>& values_,
+PointCloudColorQuantity::PointCloudColorQuantity(std::string name, std::vector<glm::vec3> values_,
                                                  PointCloud& pointCloud_)
-    : PointCloudQuantity(name, pointCloud_, true), ColorQuantity(*this, values_) {}
+    : PointCloudQuantity(name, pointCloud_, true), ColorQuantity(*this, std::move(values_)) {}
+
+PointCloudColorQuantity::PointCloudColorQuantity(std::string name, std::vector<uint32_t> packedValues_,
+                                                 PointCloud& pointCloud_)
+    : PointCloudQuantity(name, pointCloud_, true), ColorQuantity(*this, std::move(packedValues_)) {}
 
 void PointCloudColorQuantity::draw() {
   if (!isEnabled()) return;
@@ -36,12 +40,16 @@ void PointCloudColorQuantity::createPointProgram() {
   // clang-format off
   pointProgram = render::engine->requestShader(
       parent.getShaderNameForRenderMode(), 
-      parent.addPointCloudRules({"SPHERE_PROPAGATE_COLOR", "SHADE_COLOR"})
+      parent.addPointCloudRules({colorRule("SPHERE_PROPAGATE_COLOR"), "SHADE_COLOR"})
   );
   // clang-format on
 
   parent.setPointProgramGeometryAttributes(*pointProgram);
-  pointProgram->setAttribute("a_color", colors.getRenderAttributeBuffer());
+  if (isPacked()) {
+    pointProgram->setAttribute(colorAttributeName(), parent.getPointAttributeBuffer(colorsPacked));
+  } else {
+    pointProgram->setAttribute(colorAttributeName(), parent.getPointAttributeBuffer(colors));
+  }
 
   // Fill buffers
   render::engine->setMaterial(*pointProgram, parent.getMaterial());
@@ -53,12 +61,16 @@ void PointCloudColorQuantity::refresh() {
   Quantity::refresh();
 }
 
+void PointCloudColorQuantity::refreshMaterial() {
+  if (pointProgram) render::engine->setMaterial(*pointProgram, parent.getMaterial());
+}
+
 
 void PointCloudColorQuantity::buildPickUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
 
-  glm::vec3 color = colors.getValue(ind);
+  glm::vec3 color = getColor(ind);
   ImGui::ColorEdit3("", &color[0], ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker);
   ImGui::SameLine();
   std::string colorStr = to_string_short(color);
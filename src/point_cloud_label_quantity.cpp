@@ -0,0 +1,207 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/point_cloud_label_quantity.h"
+
+#include "polyscope/color_management.h"
+#include "polyscope/polyscope.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace polyscope {
+
+
+PointCloudLabelQuantity::PointCloudLabelQuantity(std::string name, const std::vector<uint32_t>& labels_,
+                                                 PointCloud& pointCloud_)
+    : PointCloudQuantity(name, pointCloud_, true), labelIndices(uniquePrefix() + "#labelIndices", labelIndicesData) {
+
+  // One counting pass finds the distinct labels, then each point is given the index of its label among them
+  std::unordered_map<uint32_t, size_t> countOf;
+  for (uint32_t l : labels_) {
+    countOf[l]++;
+  }
+  labels.reserve(countOf.size());
+  for (const std::pair<const uint32_t, size_t>& entry : countOf) {
+    labels.push_back(entry.first);
+  }
+  std::sort(labels.begin(), labels.end());
+
+  std::unordered_map<uint32_t, uint32_t> indexOf;
+  labelCounts.resize(labels.size());
+  labelTable.resize(labels.size());
+  for (size_t i = 0; i < labels.size(); i++) {
+    indexOf[labels[i]] = static_cast<uint32_t>(i);
+    labelCounts[i] = countOf[labels[i]];
+    labelTable[i] = glm::vec4(getIndexedDistinctColor(static_cast<int>(i)), 1.);
+  }
+
+  labelIndicesData.resize(labels_.size());
+  for (size_t i = 0; i < labels_.size(); i++) {
+    labelIndicesData[i] = indexOf[labels_[i]];
+  }
+}
+
+void PointCloudLabelQuantity::draw() {
+  if (!isEnabled()) return;
+
+  // Make the program if we don't have one already
+  if (pointProgram == nullptr) {
+    createProgram();
+  }
+
+  // Set uniforms
+  parent.setStructureUniforms(*pointProgram);
+  parent.setPointCloudUniforms(*pointProgram);
+  pointProgram->setUniform("u_labelTableWidth", labelTableTexture->getSizeX());
+
+  pointProgram->draw();
+}
+
+void PointCloudLabelQuantity::buildCustomUI() {
+  ImGui::SameLine();
+  ImGui::Text("%zu labels", labels.size());
+
+  if (ImGui::TreeNode("Labels")) {
+    if (ImGui::Button("Show all")) setAllLabelsVisible(true);
+    ImGui::SameLine();
+    if (ImGui::Button("Hide all")) setAllLabelsVisible(false);
+
+    // (there may be thousands, so only the visible rows are built)
+    ImGui::BeginChild("labelList", ImVec2(0, 12 * ImGui::GetTextLineHeightWithSpacing()), true);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(labels.size()));
+    while (clipper.Step()) {
+      for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+        ImGui::PushID(i);
+        bool visible = labelTable[i].a != 0.;
+        if (ImGui::Checkbox("##visible", &visible)) setLabelVisible(labels[i], visible);
+        ImGui::SameLine();
+        glm::vec3 color(labelTable[i]);
+        if (ImGui::ColorEdit3("##color", &color[0], ImGuiColorEditFlags_NoInputs)) setLabelColor(labels[i], color);
+        ImGui::SameLine();
+        ImGui::Text("%u  (%zu points)", labels[i], labelCounts[i]);
+        ImGui::PopID();
+      }
+    }
+    ImGui::EndChild();
+
+    ImGui::TreePop();
+  }
+}
+
+void PointCloudLabelQuantity::createProgram() {
+
+  // Create the program to draw this quantity
+  // clang-format off
+  pointProgram = render::engine->requestShader(
+      parent.getShaderNameForRenderMode(),
+      parent.addPointCloudRules({"SPHERE_PROPAGATE_LABEL", "SHADE_LABEL_TABLE"})
+  );
+  // clang-format on
+
+  parent.setPointProgramGeometryAttributes(*pointProgram);
+  pointProgram->setAttribute("a_labelIndex", parent.getPointAttributeBuffer(labelIndices));
+
+  // Fill buffers
+  ensureLabelTableTexture();
+  pointProgram->setTextureFromBuffer("t_labelTable", labelTableTexture.get());
+  render::engine->setMaterial(*pointProgram, parent.getMaterial());
+}
+
+void PointCloudLabelQuantity::ensureLabelTableTexture() {
+  if (labelTableTexture) return;
+
+  // Wrap in to rows of labelTableWidth, padding out the last one
+  size_t nLabels = std::max<size_t>(labels.size(), 1);
+  unsigned int width = static_cast<unsigned int>(std::min(nLabels, static_cast<size_t>(labelTableWidth)));
+  unsigned int height = static_cast<unsigned int>((nLabels + width - 1) / width);
+  std::vector<glm::vec4> texData(labelTable);
+  texData.resize(static_cast<size_t>(width) * height, glm::vec4(0.));
+
+  labelTableTexture = render::engine->generateTextureBuffer(TextureFormat::RGBA32F, width, height,
+                                                            reinterpret_cast<const float*>(texData.data()));
+  labelTableTexture->setMemoryOwner(uniquePrefix() + "labelTable");
+}
+
+void PointCloudLabelQuantity::updateLabelTableEntry(size_t iLabel) {
+  if (labelTableTexture) {
+    unsigned int width = labelTableTexture->getSizeX();
+    labelTableTexture->setDataRegion(iLabel % width, iLabel / width, 1, 1, &labelTable[iLabel][0]);
+  }
+  requestRedraw();
+}
+
+void PointCloudLabelQuantity::refresh() {
+  pointProgram.reset();
+  Quantity::refresh();
+}
+
+void PointCloudLabelQuantity::refreshMaterial() {
+  if (pointProgram) render::engine->setMaterial(*pointProgram, parent.getMaterial());
+}
+
+void PointCloudLabelQuantity::buildPickUI(size_t ind) {
+  ImGui::TextUnformatted(name.c_str());
+  ImGui::NextColumn();
+  ImGui::Text("%u", getLabel(ind));
+  ImGui::NextColumn();
+}
+
+const std::vector<uint32_t>& PointCloudLabelQuantity::getLabels() const { return labels; }
+
+size_t PointCloudLabelQuantity::getLabelCount(uint32_t label) const { return labelCounts[labelTableIndex(label)]; }
+
+uint32_t PointCloudLabelQuantity::getLabel(size_t pointInd) { return labels[labelIndices.getValue(pointInd)]; }
+
+size_t PointCloudLabelQuantity::labelTableIndex(uint32_t label) const {
+  std::vector<uint32_t>::const_iterator it = std::lower_bound(labels.begin(), labels.end(), label);
+  if (it == labels.end() || *it != label) {
+    exception("label quantity " + name + " has no label " + std::to_string(label));
+    return 0;
+  }
+  return it - labels.begin();
+}
+
+PointCloudLabelQuantity* PointCloudLabelQuantity::setLabelColor(uint32_t label, glm::vec3 color) {
+  size_t i = labelTableIndex(label);
+  labelTable[i] = glm::vec4(color, labelTable[i].a);
+  updateLabelTableEntry(i);
+  return this;
+}
+
+glm::vec3 PointCloudLabelQuantity::getLabelColor(uint32_t label) const {
+  return glm::vec3(labelTable[labelTableIndex(label)]);
+}
+
+PointCloudLabelQuantity* PointCloudLabelQuantity::setLabelVisible(uint32_t label, bool visible) {
+  size_t i = labelTableIndex(label);
+  labelTable[i].a = visible ? 1. : 0.;
+  updateLabelTableEntry(i);
+  return this;
+}
+
+bool PointCloudLabelQuantity::getLabelVisible(uint32_t label) const {
+  return labelTable[labelTableIndex(label)].a != 0.;
+}
+
+PointCloudLabelQuantity* PointCloudLabelQuantity::setAllLabelsVisible(bool visible) {
+  for (glm::vec4& entry : labelTable) {
+    entry.a = visible ? 1. : 0.;
+  }
+  // Rewrite the whole table at once, rather than an entry at a time
+  if (labelTableTexture) {
+    unsigned int width = labelTableTexture->getSizeX();
+    unsigned int height = labelTableTexture->getSizeY();
+    std::vector<glm::vec4> texData(labelTable);
+    texData.resize(static_cast<size_t>(width) * height, glm::vec4(0.));
+    labelTableTexture->setDataRegion(0, 0, width, height, reinterpret_cast<const float*>(texData.data()));
+  }
+  requestRedraw();
+  return this;
+}
+
+std::string PointCloudLabelQuantity::niceName() { return name + " (label)"; }
+
+} // namespace polyscope
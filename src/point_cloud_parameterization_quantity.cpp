@@ -47,7 +47,7 @@ void PointCloudParameterizationQuantity::createProgram() {
 }
 
 void PointCloudParameterizationQuantity::fillCoordBuffers(render::ShaderProgram& p) {
-  p.setAttribute("a_value2", coords.getRenderAttributeBuffer());
+  p.setAttribute("a_value2", parent.getPointAttributeBuffer(coords));
 }
 
 void PointCloudParameterizationQuantity::buildCustomUI() {
@@ -72,15 +72,22 @@ void PointCloudParameterizationQuantity::refresh() {
   Quantity::refresh();
 }
 
+void PointCloudParameterizationQuantity::refreshMaterial() {
+  if (program) render::engine->setMaterial(*program, parent.getMaterial());
+}
+
 std::string PointCloudParameterizationQuantity::niceName() { return name + " (parameterization)"; }
 
 void PointCloudParameterizationQuantity::buildPickUI(size_t ind) {
 
-  glm::vec2 coord = coords.getValue(ind);
-
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
-  ImGui::Text("<%g,%g>", coord.x, coord.y);
+  glm::vec2 coord;
+  if (coords.tryGetValue(ind, coord)) { // (doesn't wait if the coords were written on the device)
+    ImGui::Text("<%g,%g>", coord.x, coord.y);
+  } else {
+    ImGui::TextUnformatted("...");
+  }
   ImGui::NextColumn();
 }
 
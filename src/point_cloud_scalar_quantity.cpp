@@ -9,9 +9,9 @@
 namespace polyscope {
 
 
-PointCloudScalarQuantity::PointCloudScalarQuantity(std::string name, const std::vector<double>& values_,
+PointCloudScalarQuantity::PointCloudScalarQuantity(std::string name, std::vector<float> values_,
                                                    PointCloud& pointCloud_, DataType dataType_)
-    : PointCloudQuantity(name, pointCloud_, true), ScalarQuantity(*this, values_, dataType_) {}
+    : PointCloudQuantity(name, pointCloud_, true), ScalarQuantity(*this, std::move(values_), dataType_) {}
 
 void PointCloudScalarQuantity::draw() {
   if (!isEnabled()) return;
@@ -59,7 +59,7 @@ void PointCloudScalarQuantity::createProgram() {
   // clang-format on
 
   parent.setPointProgramGeometryAttributes(*pointProgram);
-  pointProgram->setAttribute("a_value", values.getRenderAttributeBuffer());
+  pointProgram->setAttribute("a_value", parent.getPointAttributeBuffer(values));
 
   // Fill buffers
   pointProgram->setTextureFromColormap("t_colormap", cMap.get());
@@ -72,10 +72,19 @@ void PointCloudScalarQuantity::refresh() {
   Quantity::refresh();
 }
 
+void PointCloudScalarQuantity::refreshMaterial() {
+  if (pointProgram) render::engine->setMaterial(*pointProgram, parent.getMaterial());
+}
+
 void PointCloudScalarQuantity::buildPickUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
-  ImGui::Text("%g", values.getValue(ind));
+  float val;
+  if (values.tryGetValue(ind, val)) { // (doesn't wait if the values were written on the device)
+    ImGui::Text("%g", val);
+  } else {
+    ImGui::TextUnformatted("...");
+  }
   ImGui::NextColumn();
 }
 
@@ -0,0 +1,241 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/point_cloud_time_series_scalar_quantity.h"
+
+#include "polyscope/internal.h"
+#include "polyscope/polyscope.h"
+
+#include "glm/gtc/packing.hpp"
+#include "imgui.h"
+
+#include <algorithm>
+
+namespace polyscope {
+
+namespace {
+std::vector<float> firstFrame(const std::vector<float>& frameValues, size_t frameSize) {
+  return std::vector<float>(frameValues.begin(), frameValues.begin() + std::min(frameSize, frameValues.size()));
+}
+} // namespace
+
+PointCloudTimeSeriesScalarQuantity::PointCloudTimeSeriesScalarQuantity(std::string name,
+                                                                       const std::vector<float>& frameValues,
+                                                                       size_t nFrames_, PointCloud& pointCloud_,
+                                                                       DataType dataType_, bool halfPrecision)
+    : PointCloudScalarQuantity(name, firstFrame(frameValues, pointCloud_.nPoints()), pointCloud_, dataType_),
+      nFramesStored(nFrames_), frameSize(pointCloud_.nPoints()) {
+
+  if (nFramesStored == 0) exception("time series quantity " + name + " must have at least one frame");
+  if (frameValues.size() != nFramesStored * frameSize) {
+    exception("time series quantity " + name + " has " + std::to_string(frameValues.size()) + " values, expected " +
+              std::to_string(nFramesStored) + " frames of " + std::to_string(frameSize));
+  }
+
+  if (halfPrecision) {
+    frameData16.resize(frameValues.size());
+    for (size_t i = 0; i < frameValues.size(); i++) {
+      frameData16[i] = glm::packHalf1x16(frameValues[i]);
+    }
+  } else {
+    frameData = frameValues;
+  }
+
+  // the colormap covers every frame
+  dataRange = scalarDataRange(frameValues);
+  hist.colormapRange = dataRange;
+  resetMapRange();
+}
+
+void PointCloudTimeSeriesScalarQuantity::draw() {
+  if (!isEnabled()) return;
+
+  if (playing) {
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - playStartTime).count();
+    currentFrame = (playStartFrame + static_cast<size_t>(elapsed * playbackFPS)) % nFramesStored;
+    requestRedraw(); // keep playing
+  }
+
+  if (pointProgram == nullptr) {
+    createProgram();
+    drawnFrameBuffer = nullptr;
+  }
+
+  // Switch to the current frame. If it is resident this only re-points the program's attribute at its buffer.
+  ResidentFrame& resident = ensureResident(currentFrame);
+  if (resident.buffer.get() != drawnFrameBuffer) {
+    pointProgram->setAttribute("a_value", parent.getPointAttributeBuffer(*resident.buffer));
+    drawnFrameBuffer = resident.buffer.get();
+  }
+
+  PointCloudScalarQuantity::draw();
+
+  prefetchNextFrame();
+}
+
+void PointCloudTimeSeriesScalarQuantity::buildCustomUI() {
+  PointCloudScalarQuantity::buildCustomUI();
+
+  // Timeline
+  int frameInd = static_cast<int>(currentFrame);
+  ImGui::PushItemWidth(200);
+  if (ImGui::SliderInt("frame", &frameInd, 0, static_cast<int>(nFramesStored) - 1)) {
+    setFrame(static_cast<size_t>(frameInd));
+  }
+  ImGui::PopItemWidth();
+  ImGui::SameLine();
+  if (ImGui::Checkbox("Play", &playing)) setPlaying(playing);
+}
+
+void PointCloudTimeSeriesScalarQuantity::buildPickUI(size_t ind) {
+  ImGui::TextUnformatted(name.c_str());
+  ImGui::NextColumn();
+  ImGui::Text("%g (frame %zu)", frameValue(currentFrame, ind), currentFrame);
+  ImGui::NextColumn();
+}
+
+void PointCloudTimeSeriesScalarQuantity::refresh() {
+  drawnFrameBuffer = nullptr;
+  residentFrames.clear(); // (e.g. the LOD order changed, the frames are re-uploaded as needed)
+  PointCloudScalarQuantity::refresh();
+}
+
+std::string PointCloudTimeSeriesScalarQuantity::niceName() { return name + " (time series scalar)"; }
+
+size_t PointCloudTimeSeriesScalarQuantity::nFrames() { return nFramesStored; }
+
+PointCloudTimeSeriesScalarQuantity* PointCloudTimeSeriesScalarQuantity::setFrame(size_t newFrame) {
+  if (newFrame >= nFramesStored) {
+    exception("frame " + std::to_string(newFrame) + " out of range for time series quantity " + name + " with " +
+              std::to_string(nFramesStored) + " frames");
+  }
+  currentFrame = newFrame;
+  playStartFrame = currentFrame;
+  playStartTime = std::chrono::steady_clock::now();
+  requestRedraw();
+  return this;
+}
+
+size_t PointCloudTimeSeriesScalarQuantity::getFrame() { return currentFrame; }
+
+std::vector<float> PointCloudTimeSeriesScalarQuantity::getFrameValues(size_t frame) {
+  if (frame >= nFramesStored) exception("frame " + std::to_string(frame) + " out of range for " + name);
+  std::vector<float> vals(frameSize);
+  for (size_t i = 0; i < frameSize; i++) {
+    vals[i] = frameValue(frame, i);
+  }
+  return vals;
+}
+
+PointCloudTimeSeriesScalarQuantity* PointCloudTimeSeriesScalarQuantity::setPlaying(bool newVal) {
+  playing = newVal;
+  playStartFrame = currentFrame;
+  playStartTime = std::chrono::steady_clock::now();
+  requestRedraw();
+  return this;
+}
+bool PointCloudTimeSeriesScalarQuantity::isPlaying() { return playing; }
+
+PointCloudTimeSeriesScalarQuantity* PointCloudTimeSeriesScalarQuantity::setPlaybackFPS(float newVal) {
+  if (!(newVal > 0.)) exception("playback FPS must be positive");
+  playbackFPS = newVal;
+  playStartFrame = currentFrame;
+  playStartTime = std::chrono::steady_clock::now();
+  return this;
+}
+float PointCloudTimeSeriesScalarQuantity::getPlaybackFPS() { return playbackFPS; }
+
+PointCloudTimeSeriesScalarQuantity* PointCloudTimeSeriesScalarQuantity::setResidentFrameCount(size_t newVal) {
+  if (newVal == 0) exception("must keep at least one frame resident");
+  residentFrameCount = newVal;
+  if (residentFrames.size() > residentFrameCount) {
+    drawnFrameBuffer = nullptr;
+    residentFrames.clear();
+    requestRedraw();
+  }
+  return this;
+}
+size_t PointCloudTimeSeriesScalarQuantity::getResidentFrameCount() { return residentFrameCount; }
+
+bool PointCloudTimeSeriesScalarQuantity::isFrameResident(size_t frame) { return findResidentFrame(frame) != nullptr; }
+
+float PointCloudTimeSeriesScalarQuantity::frameValue(size_t frame, size_t ind) {
+  size_t i = frame * frameSize + ind;
+  if (!frameData16.empty()) return glm::unpackHalf1x16(frameData16[i]);
+  return frameData[i];
+}
+
+size_t PointCloudTimeSeriesScalarQuantity::frameDistance(size_t frameA, size_t frameB) {
+  size_t d = frameA > frameB ? frameA - frameB : frameB - frameA;
+  return std::min(d, nFramesStored - d);
+}
+
+PointCloudTimeSeriesScalarQuantity::ResidentFrame* PointCloudTimeSeriesScalarQuantity::findResidentFrame(size_t frame) {
+  for (std::unique_ptr<ResidentFrame>& r : residentFrames) {
+    if (r->frame == frame) return r.get();
+  }
+  return nullptr;
+}
+
+PointCloudTimeSeriesScalarQuantity::ResidentFrame& PointCloudTimeSeriesScalarQuantity::ensureResident(size_t frame) {
+  ResidentFrame* resident = findResidentFrame(frame);
+  if (resident) return *resident;
+
+  if (residentFrames.size() < residentFrameCount) {
+    residentFrames.emplace_back(new ResidentFrame());
+    resident = residentFrames.back().get();
+  } else {
+    // replace the frame which is least likely to be needed soon
+    std::vector<size_t> order = prefetchOrder();
+    auto priority = [&](size_t f) {
+      if (f == currentFrame) return size_t(0);
+      auto it = std::find(order.begin(), order.end(), f);
+      if (it != order.end()) return static_cast<size_t>(it - order.begin()) + 1;
+      return order.size() + 1 + frameDistance(f, currentFrame);
+    };
+    resident = residentFrames.front().get();
+    for (std::unique_ptr<ResidentFrame>& r : residentFrames) {
+      if (priority(r->frame) > priority(resident->frame)) resident = r.get();
+    }
+  }
+
+  resident->frame = frame;
+  resident->data = getFrameValues(frame);
+  if (resident->buffer) {
+    resident->buffer->markHostBufferUpdated();
+  } else {
+    resident->buffer.reset(new render::ManagedBuffer<float>(
+        uniquePrefix() + "#frame" + std::to_string(residentFrames.size() - 1), resident->data));
+  }
+  parent.getPointAttributeBuffer(*resident->buffer); // upload now, rather than during the draw which needs it
+  frameUploadCount++;
+
+  return *resident;
+}
+
+std::vector<size_t> PointCloudTimeSeriesScalarQuantity::prefetchOrder() {
+  // Nearby frames in the order they are likely to be shown: ahead, then behind, one step further each time. Only as
+  // many as fit alongside the current frame, so prefetching never evicts a frame which it would then want again.
+  size_t nCandidates = std::min(residentFrameCount, nFramesStored) - 1;
+  std::vector<size_t> order;
+  for (size_t i = 0; i < nCandidates; i++) {
+    size_t step = i / 2 + 1;
+    if (i % 2 == 0) {
+      order.push_back((currentFrame + step) % nFramesStored);
+    } else {
+      order.push_back((currentFrame + nFramesStored - step) % nFramesStored);
+    }
+  }
+  return order;
+}
+
+void PointCloudTimeSeriesScalarQuantity::prefetchNextFrame() {
+  for (size_t frame : prefetchOrder()) {
+    if (!findResidentFrame(frame)) {
+      ensureResident(frame);
+      internal::requestViewRedraw(); // draw again soon, to prefetch the next one
+      return;
+    }
+  }
+}
+
+} // namespace polyscope
@@ -16,7 +16,7 @@ PointCloudVectorQuantity::PointCloudVectorQuantity(std::string name, std::vector
                                                    PointCloud& pointCloud_, VectorType vectorType_)
 
     : PointCloudQuantity(name, pointCloud_),
-      VectorQuantity<PointCloudVectorQuantity>(*this, vectors_, parent.points, vectorType_) {}
+      VectorQuantity<PointCloudVectorQuantity>(*this, std::move(vectors_), parent.points, vectorType_) {}
 
 void PointCloudVectorQuantity::draw() {
   if (!isEnabled()) return;
@@ -34,8 +34,14 @@ void PointCloudVectorQuantity::buildPickUI(size_t ind) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
 
+  glm::vec3 vec;
+  if (!vectors.tryGetValue(ind, vec)) { // (doesn't wait if the vectors were written on the device)
+    ImGui::TextUnformatted("...");
+    ImGui::NextColumn();
+    return;
+  }
+
   std::stringstream buffer;
-  glm::vec3 vec = vectors.getValue(ind);
   buffer << vec;
   ImGui::TextUnformatted(buffer.str().c_str());
 
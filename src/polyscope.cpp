@@ -2,15 +2,27 @@
 
 #include "polyscope/polyscope.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <thread>
 
 #include "imgui.h"
 
+#include "polyscope/combining_hash_functions.h"
+#include "polyscope/frame_arena.h"
+#include "polyscope/image_quantity_base.h"
+#include "polyscope/occlusion_culling.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
+#include "polyscope/profiling.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/render/managed_buffer.h"
 #include "polyscope/view.h"
 
 #include "stb_image.h"
@@ -35,11 +47,18 @@ struct ContextEntry {
   ImGuiContext* context;
   std ::function<void()> callback;
   bool drawDefaultUI;
+  bool allowIdle;        // may the main loop sleep while this context is on top (see options::sleepWhenIdle)
+  bool callbackBuildsUI; // does the callback draw ImGui windows, so the UI can't be reused (see options::reuseIdleUI)
 };
 std::vector<ContextEntry> contextStack;
 
 bool redrawNextFrame = true;
 
+// Set if a redraw was requested while the scene was last rendered (e.g. by progressive refinement), in which case the
+// next render can't be skipped even if nothing else changed
+uint64_t viewRedrawRequestCount = 0;
+bool lastRenderRequestedRedraw = false;
+
 // Some state about imgui windows to stack them
 float imguiStackMargin = 10;
 float lastWindowHeightPolyscope = 200;
@@ -49,6 +68,33 @@ float rightWindowsWidth = 500;
 
 auto lastMainLoopIterTime = std::chrono::steady_clock::now();
 
+// Frames drawn since the last sign of activity. ImGui needs a few frames after input to settle (hover highlights,
+// closing popups, etc), so the main loop keeps drawing for that long before it sleeps.
+size_t framesSinceActivity = 0;
+const size_t idleSettleFrames = 3;
+
+// The context the UI was last built in, and what the last check for activity saw, for reusing the UI while it is idle
+// (see options::reuseIdleUI)
+ImGuiContext* lastBuiltUIContext = nullptr;
+uint64_t lastUIInputEventCount = 0;
+uint64_t lastUIRedrawRequestCount = 0;
+size_t uiFramesSinceActivity = 0;
+
+// The render thread of showAsync(), and the frame count which threads waiting on it sync against
+std::thread asyncRenderThread;
+std::atomic<bool> asyncRunning{false};
+std::atomic<bool> asyncStopRequested{false};
+std::atomic<size_t> asyncFrameWaiters{0};
+std::mutex asyncFrameMutex;
+std::condition_variable asyncFrameCV;
+size_t asyncFramesDrawn = 0;
+
+bool mainLoopHasWork() {
+  return redrawNextFrame || options::alwaysRedraw || view::midflight || isRecording() || hasRemoteClient() ||
+         asyncStopRequested || asyncFrameWaiters > 0 || render::engine->hasPendingReadbacks() ||
+         !render::engine->temporalAccumulationConverged();
+}
+
 const std::string prefsFilename = ".polyscope.ini";
 
 void readPrefsFile() {
@@ -120,13 +166,14 @@ void writePrefsFile() {
 
 // Helper to get a structure map
 
-std::map<std::string, std::shared_ptr<Structure>>& getStructureMapCreateIfNeeded(std::string typeName) {
-  if (state::structures.find(typeName) == state::structures.end()) {
-    state::structures[typeName] = std::map<std::string, std::shared_ptr<Structure>>();
-  }
-  return state::structures[typeName];
+InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& getStructureMapCreateIfNeeded(std::string typeName) {
+  return state::structures[typeName]; // inserts an empty map if needed
 }
 
+// Registered structures by handle, and the next handle to hand out. Handles are never reused.
+std::unordered_map<StructureHandle, Structure*> structuresByHandle;
+StructureHandle nextStructureHandle = 1;
+
 } // namespace
 
 // === Core global functions
@@ -151,11 +198,14 @@ void init(std::string backend) {
 
   // Initialie ImGUI
   IMGUI_CHECKVERSION();
-  render::engine->initializeImGui();
+  {
+    profiling::InitPhaseTimer phaseTimer("imgui and fonts");
+    render::engine->initializeImGui();
+  }
 
   // Create an initial context based context. Note that calling show() never actually uses this context, because it
   // pushes a new one each time. But using frameTick() may use this context.
-  contextStack.push_back(ContextEntry{ImGui::GetCurrentContext(), nullptr, true});
+  contextStack.push_back(ContextEntry{ImGui::GetCurrentContext(), nullptr, true, true, false});
 
   view::invalidateView();
 
@@ -171,7 +221,9 @@ void checkInitialized() {
 
 bool isInitialized() { return state::initialized; }
 
-void pushContext(std::function<void()> callbackFunction, bool drawDefaultUI) {
+namespace {
+void pushContextImpl(std::function<void()> callbackFunction, bool drawDefaultUI, bool allowIdle,
+                     bool callbackBuildsUI) {
 
   // Create a new context and push it on to the stack
   ImGuiContext* newContext = ImGui::CreateContext(render::engine->getImGuiGlobalFontAtlas());
@@ -186,7 +238,7 @@ void pushContext(std::function<void()> callbackFunction, bool drawDefaultUI) {
                           // was necessary to fix a bug where keys like delete, etc would break in subcontexts. The
                           // problem was that the key mappings (e.g. GLFW_KEY_BACKSPACE --> ImGuiKey_Backspace) need to
                           // be populated in io.KeyMap, and these entries would get lost on creating a new context.
-  contextStack.push_back(ContextEntry{newContext, callbackFunction, drawDefaultUI});
+  contextStack.push_back(ContextEntry{newContext, callbackFunction, drawDefaultUI, allowIdle, callbackBuildsUI});
 
   if (contextStack.size() > 50) {
     // Catch bugs with nested show()
@@ -201,14 +253,33 @@ void pushContext(std::function<void()> callbackFunction, bool drawDefaultUI) {
   size_t currentContextStackSize = contextStack.size();
   while (contextStack.size() >= currentContextStackSize) {
 
-    // The windowing system will let the main loop busy-loop on some platforms. Make sure that doesn't happen.
+    // Sleep until something happens, if there is nothing to draw
+    if (options::sleepWhenIdle && contextStack.back().allowIdle) {
+      if (mainLoopHasWork()) {
+        framesSinceActivity = 0;
+      } else if (framesSinceActivity >= idleSettleFrames) {
+        while (!render::engine->waitEvents(options::idleWakeInterval) && !mainLoopHasWork()) {
+        }
+        framesSinceActivity = 0;
+      }
+      framesSinceActivity++;
+    }
+
+    // The windowing system will let the main loop busy-loop on some platforms. Make sure that doesn't happen. Sleep
+    // through most of the wait, and only yield for the last bit, since sleeps may overshoot.
     if (options::maxFPS != -1) {
       auto currTime = std::chrono::steady_clock::now();
       long microsecPerLoop = 1000000 / options::maxFPS;
       microsecPerLoop = (95 * microsecPerLoop) / 100; // give a little slack so we actually hit target fps
-      while (std::chrono::duration_cast<std::chrono::microseconds>(currTime - lastMainLoopIterTime).count() <
-             microsecPerLoop) {
-        std::this_thread::yield();
+      const long microsecYield = 2000;
+      long microsecElapsed;
+      while ((microsecElapsed = std::chrono::duration_cast<std::chrono::microseconds>(currTime - lastMainLoopIterTime)
+                                    .count()) < microsecPerLoop) {
+        if (microsecPerLoop - microsecElapsed > microsecYield) {
+          std::this_thread::sleep_for(std::chrono::microseconds(microsecPerLoop - microsecElapsed - microsecYield));
+        } else {
+          std::this_thread::yield();
+        }
         currTime = std::chrono::steady_clock::now();
       }
     }
@@ -232,6 +303,11 @@ void pushContext(std::function<void()> callbackFunction, bool drawDefaultUI) {
     ImGui::SetCurrentContext(contextStack.back().context);
   }
 }
+} // namespace
+
+void pushContext(std::function<void()> callbackFunction, bool drawDefaultUI) {
+  pushContextImpl(callbackFunction, drawDefaultUI, true, true);
+}
 
 
 void popContext() {
@@ -240,6 +316,7 @@ void popContext() {
     return;
   }
   contextStack.pop_back();
+  lastBuiltUIContext = nullptr; // (the outer context's UI is built again before it is reused)
 }
 
 ImGuiContext* getCurrentContext() { return contextStack.empty() ? nullptr : contextStack.back().context; }
@@ -256,32 +333,244 @@ void frameTick() {
   mainLoopIteration();
 }
 
-void requestRedraw() { redrawNextFrame = true; }
+namespace {
+// Functions posted from other threads with postToMainThread(). Producers append under the lock, and the main thread
+// swaps the whole batch out before running it, so the lock is never held while running.
+std::mutex postedUpdatesMutex;
+std::vector<std::function<void()>> postedUpdates;
+} // namespace
+
+void postToMainThread(std::function<void()> func) {
+  {
+    std::lock_guard<std::mutex> lock(postedUpdatesMutex);
+    postedUpdates.push_back(std::move(func));
+  }
+  if (render::engine) render::engine->wakeEventWait(); // in case the main loop is sleeping
+}
+
+void processPostedUpdates() {
+  std::vector<std::function<void()>> batch;
+  {
+    std::lock_guard<std::mutex> lock(postedUpdatesMutex);
+    batch.swap(postedUpdates);
+  }
+  if (batch.empty()) return;
+
+  for (std::function<void()>& func : batch) {
+    func();
+  }
+  requestRedraw();
+}
+
+void requestRedraw() {
+  internal::sceneContentVersion++;
+  internal::requestViewRedraw();
+}
+
+namespace internal {
+void requestRedrawForStructure(const std::string& prefixedName) {
+  // prefixes look like "type#name#", and names never contain '#'
+  size_t typeEnd = prefixedName.find('#');
+  size_t nameEnd = typeEnd == std::string::npos ? typeEnd : prefixedName.find('#', typeEnd + 1);
+  bool isStatic = false;
+  if (nameEnd != std::string::npos) {
+    auto typeMap = state::structures.find(prefixedName.substr(0, typeEnd));
+    if (typeMap != state::structures.end()) {
+      auto it = typeMap->second.find(prefixedName.substr(typeEnd + 1, nameEnd - typeEnd - 1));
+      isStatic = it != typeMap->second.end() && it->second->isStatic();
+    }
+  }
+  if (!isStatic) dynamicContentChanges++;
+  requestRedraw();
+}
+
+void requestViewRedraw() {
+  redrawNextFrame = true;
+  viewRedrawRequestCount++;
+  pick::invalidatePickBuffer();
+}
+} // namespace internal
 bool redrawRequested() { return redrawNextFrame; }
 
+namespace {
+
+// Frustum culling for every structure, in the order they are iterated in state::structures. Entry i is false if the
+// i'th structure is enabled but certainly outside the view. The tests are independent, so with many structures they
+// are spread across worker threads; only issuing the draws has to stay in order on the main (GL) thread.
+FrameVector<char> structuresMayBeVisible(const glm::mat4& viewProjMat) {
+  FrameVector<Structure*> all;
+  for (auto& catMap : state::structures) {
+    for (auto& s : catMap.second) {
+      all.push_back(s.second.get());
+    }
+  }
+
+  FrameVector<char> visible(all.size(), true);
+  if (!options::enableFrustumCulling) return visible;
+  auto testRange = [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      visible[i] = !all[i]->isEnabled() || all[i]->mayBeInViewFrustum(viewProjMat);
+    }
+  };
+  const size_t minBlockSize = 256;
+  if (all.size() <= minBlockSize) {
+    testRange(0, all.size()); // (a single block; skip wrapping it in a std::function, which allocates)
+  } else {
+    parallelFor(0, all.size(), testRange, minBlockSize);
+  }
+  return visible;
+}
+
+} // namespace
+
+FrameVector<RenderQueueItem> buildRenderQueue(RenderQueueOrder order) {
+  glm::mat4 viewMat = view::getCameraViewMatrix();
+  glm::mat4 viewProjMat = view::getCameraPerspectiveMatrix() * viewMat;
+  FrameVector<char> visible = structuresMayBeVisible(viewProjMat);
+
+  FrameVector<RenderQueueItem> queue;
+  queue.reserve(visible.size());
+  size_t iStructure = 0;
+  size_t iType = 0;
+  for (auto& catMap : state::structures) {
+    for (auto& s : catMap.second) {
+      if (!visible[iStructure++]) continue;
+      queue.push_back(RenderQueueItem{&catMap.first, s.second.get(), iType, 0.f});
+    }
+    iType++;
+  }
+  if (order == RenderQueueOrder::Registration) return queue;
+
+  // Sort keys. The depth is that of the bounding box center, in front of the camera.
+  FrameVector<std::string> materials(queue.size());
+  for (size_t i = 0; i < queue.size(); i++) {
+    Structure* s = queue[i].structure;
+    if (!s->isEnabled() || !s->hasExtents()) continue;
+    if (order == RenderQueueOrder::StateSorted) materials[i] = s->drawSortKey();
+    std::tuple<glm::vec3, glm::vec3> bbox = s->boundingBox();
+    glm::vec3 center = 0.5f * (std::get<0>(bbox) + std::get<1>(bbox));
+    glm::vec4 viewPos = viewMat * glm::vec4(center, 1.);
+    queue[i].depth = -viewPos.z / viewPos.w;
+  }
+
+  FrameVector<size_t> perm(queue.size());
+  for (size_t i = 0; i < perm.size(); i++) perm[i] = i;
+  if (order == RenderQueueOrder::StateSorted) {
+    // Group by type (ie, programs) and then material, front-to-back within a group for early depth rejection
+    std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) {
+      if (queue[a].typeIndex != queue[b].typeIndex) return queue[a].typeIndex < queue[b].typeIndex;
+      if (materials[a] != materials[b]) return materials[a] < materials[b];
+      return queue[a].depth < queue[b].depth;
+    });
+  } else {
+    std::stable_sort(perm.begin(), perm.end(), [&](size_t a, size_t b) { return queue[a].depth > queue[b].depth; });
+  }
+
+  FrameVector<RenderQueueItem> sorted;
+  sorted.reserve(queue.size());
+  for (size_t i : perm) sorted.push_back(queue[i]);
+  return sorted;
+}
+
+namespace {
+// Which structures drawStructures() draws. Set while the scene is drawn in layers (see Structure::setStatic()).
+enum class StructureLayer { All, Static, Dynamic };
+StructureLayer drawnStructureLayer = StructureLayer::All;
+
+// Likewise, set while the opaque and transparent structures are drawn separately for TransparencyMode::Sorted
+enum class StructureOpacity { All, Opaque, Transparent };
+StructureOpacity drawnStructureOpacity = StructureOpacity::All;
+} // namespace
+
 void drawStructures() {
+  profiling::ScopedTimer timer("drawStructures");
 
   // Draw all off the structures registered with polyscope
 
-  for (auto catMap : state::structures) {
-    for (auto s : catMap.second) {
-      s.second->draw();
+  // Structures whose programs are still compiling in the background get skipped (partially, if some of their programs
+  // were ready), and the scene is redrawn until they have caught up
+  render::engine->deferShaderCompiles = true;
+  internal::structureDrawPassCount++;
+
+  RenderQueueOrder order = RenderQueueOrder::Registration;
+  if (options::sortDrawsByMaterial) {
+    bool blended = render::engine->getTransparencyMode() == TransparencyMode::Simple;
+    order = blended ? RenderQueueOrder::BackToFront : RenderQueueOrder::StateSorted;
+  }
+  if (drawnStructureOpacity == StructureOpacity::Transparent) {
+    // Blended over each other, so they must be ordered (and must not hide each other)
+    order = RenderQueueOrder::BackToFront;
+    render::engine->setDepthMode(DepthMode::LEqualReadOnly);
+  }
+  for (RenderQueueItem& item : buildRenderQueue(order)) {
+    Structure* s = item.structure;
+    if (drawnStructureLayer != StructureLayer::All &&
+        s->isStatic() != (drawnStructureLayer == StructureLayer::Static)) {
+      continue;
+    }
+    if (drawnStructureOpacity != StructureOpacity::All &&
+        (s->getTransparency() < 1.) != (drawnStructureOpacity == StructureOpacity::Transparent)) {
+      continue;
+    }
+    if (s->isLoading()) {
+      requestRedraw(); // keep checking until it is ready
+      continue;
+    }
+    profiling::ScopedTimer structureTimer(*item.typeName, s->name, true);
+    if (s->isEnabled()) s->lastDrawnSceneCount = internal::renderSceneCount;
+    try {
+      s->draw();
+    } catch (const render::ShaderProgramNotReady&) {
+      requestRedraw();
     }
   }
 
+  render::engine->deferShaderCompiles = false;
+
   // Also render any slice plane geometry
+  if (drawnStructureLayer == StructureLayer::Static || drawnStructureOpacity == StructureOpacity::Transparent) return;
   for (SlicePlane* s : state::slicePlanes) {
     s->drawGeometry();
   }
 }
 
+namespace {
+
+// If over options::gpuMemoryBudgetMB, release the GPU resources of structures which were not drawn in the last
+// rendered frame, least recently drawn first
+void enforceGPUMemoryBudget() {
+  if (options::gpuMemoryBudgetMB < 0) return;
+
+  size_t budget = static_cast<size_t>(options::gpuMemoryBudgetMB) << 20;
+  size_t total = render::getGPUMemoryUsage().totalBytes();
+  if (total <= budget) return;
+
+  std::vector<Structure*> candidates;
+  for (auto& catMap : state::structures) {
+    for (auto& s : catMap.second) {
+      if (s.second->lastDrawnSceneCount < internal::renderSceneCount) candidates.push_back(s.second.get());
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](Structure* a, Structure* b) { return a->lastDrawnSceneCount < b->lastDrawnSceneCount; });
+
+  for (Structure* s : candidates) {
+    size_t structureBytes = s->getGPUMemoryUsage().totalBytes();
+    if (structureBytes == 0) continue;
+    s->releaseGPUResources();
+    total -= std::min(total, structureBytes);
+    if (total <= budget) break;
+  }
+}
+
+} // namespace
+
 void drawStructuresDelayed() {
   // "delayed" drawing allows structures to render things which should be rendered after most of the scene has been
   // drawn
-  for (auto catMap : state::structures) {
-    for (auto s : catMap.second) {
-      s.second->drawDelayed();
-    }
+  for (RenderQueueItem& item : buildRenderQueue(RenderQueueOrder::Registration)) {
+    if (item.structure->isLoading()) continue;
+    item.structure->drawDelayed();
   }
 }
 
@@ -289,12 +578,53 @@ namespace {
 
 float dragDistSinceLastRelease = 0.0;
 
+// For options::lowLatencyInteraction: the mouse button of the camera drag in this frame's input (-1 if none), how far
+// past the mouse position of this frame's input lateCameraUpdate() has carried the drag, and when the input which the
+// frame shows was sampled
+int cameraDragButton = -1;
+glm::vec2 lateCameraDragOffset{0., 0.};
+std::chrono::steady_clock::time_point inputSampleTime;
+
+// The camera motion of a drag of the mouse (with the left button if dragLeft, otherwise the right) by mouseDelta to
+// mousePos, in window coordinates
+void processCameraDrag(bool dragLeft, glm::vec2 mousePos, glm::vec2 mouseDelta) {
+  ImGuiIO& io = ImGui::GetIO();
+
+  glm::vec2 dragDelta{mouseDelta.x / view::windowWidth, -mouseDelta.y / view::windowHeight};
+  dragDistSinceLastRelease += std::abs(dragDelta.x);
+  dragDistSinceLastRelease += std::abs(dragDelta.y);
+
+  // exactly one of these will be true
+  bool isRotate = dragLeft && !io.KeyShift && !io.KeyCtrl;
+  bool isTranslate = (dragLeft && io.KeyShift && !io.KeyCtrl) || !dragLeft;
+  bool isDragZoom = dragLeft && io.KeyShift && io.KeyCtrl;
+
+  if (isDragZoom) {
+    view::processZoom(dragDelta.y * 5);
+  }
+  if (isRotate) {
+    glm::vec2 currPos{mousePos.x / view::windowWidth, (view::windowHeight - mousePos.y) / view::windowHeight};
+    currPos = (currPos * 2.0f) - glm::vec2{1.0, 1.0};
+    if (std::abs(currPos.x) <= 1.0 && std::abs(currPos.y) <= 1.0) {
+      view::processRotate(currPos - 2.0f * dragDelta, currPos);
+    }
+  }
+  if (isTranslate) {
+    view::processTranslate(dragDelta);
+  }
+}
+
 void processInputEvents() {
   ImGuiIO& io = ImGui::GetIO();
 
+  // (see lateCameraUpdate())
+  glm::vec2 lateAppliedDrag = lateCameraDragOffset;
+  lateCameraDragOffset = glm::vec2{0., 0.};
+  cameraDragButton = -1;
+
   // If any mouse button is pressed, trigger a redraw
   if (ImGui::IsAnyMouseDown()) {
-    requestRedraw();
+    internal::requestViewRedraw();
   }
 
   bool widgetCapturedMouse = false;
@@ -312,7 +642,7 @@ void processInputEvents() {
       double yoffset = io.MouseWheel;
 
       if (xoffset != 0 || yoffset != 0) {
-        requestRedraw();
+        internal::requestViewRedraw();
 
         // On some setups, shift flips the scroll direction, so take the max
         // scrolling in any direction
@@ -341,30 +671,10 @@ void processInputEvents() {
       bool dragLeft = ImGui::IsMouseDragging(0);
       bool dragRight = !dragLeft && ImGui::IsMouseDragging(1); // left takes priority, so only one can be true
       if (dragLeft || dragRight) {
-
-        glm::vec2 dragDelta{io.MouseDelta.x / view::windowWidth, -io.MouseDelta.y / view::windowHeight};
-        dragDistSinceLastRelease += std::abs(dragDelta.x);
-        dragDistSinceLastRelease += std::abs(dragDelta.y);
-
-        // exactly one of these will be true
-        bool isRotate = dragLeft && !io.KeyShift && !io.KeyCtrl;
-        bool isTranslate = (dragLeft && io.KeyShift && !io.KeyCtrl) || dragRight;
-        bool isDragZoom = dragLeft && io.KeyShift && io.KeyCtrl;
-
-        if (isDragZoom) {
-          view::processZoom(dragDelta.y * 5);
-        }
-        if (isRotate) {
-          glm::vec2 currPos{io.MousePos.x / view::windowWidth,
-                            (view::windowHeight - io.MousePos.y) / view::windowHeight};
-          currPos = (currPos * 2.0f) - glm::vec2{1.0, 1.0};
-          if (std::abs(currPos.x) <= 1.0 && std::abs(currPos.y) <= 1.0) {
-            view::processRotate(currPos - 2.0f * dragDelta, currPos);
-          }
-        }
-        if (isTranslate) {
-          view::processTranslate(dragDelta);
-        }
+        // (less the part of the motion which the late update of the last frame already applied)
+        glm::vec2 mouseDelta = glm::vec2{io.MouseDelta.x, io.MouseDelta.y} - lateAppliedDrag;
+        processCameraDrag(dragLeft, glm::vec2{io.MousePos.x, io.MousePos.y}, mouseDelta);
+        cameraDragButton = dragLeft ? 0 : 1;
       }
 
       // Click picks
@@ -409,6 +719,138 @@ void processInputEvents() {
   }
 }
 
+// With options::lowLatencyInteraction, carry this frame's camera drag on to where the mouse is now, right before the
+// scene is rendered. The input was sampled at the start of the frame, before the UI was built and the user callback
+// ran, which may take a good part of the frame. The next frame's input only applies the motion beyond this.
+void lateCameraUpdate() {
+  if (!options::lowLatencyInteraction || cameraDragButton < 0) return;
+  glm::vec2 mousePos;
+  if (!render::engine->sampleCursorPosition(mousePos)) return;
+  inputSampleTime = std::chrono::steady_clock::now();
+
+  ImGuiIO& io = ImGui::GetIO();
+  glm::vec2 offset = mousePos - glm::vec2{io.MousePos.x, io.MousePos.y};
+  if (offset == lateCameraDragOffset) return;
+  processCameraDrag(cameraDragButton == 0, mousePos, offset - lateCameraDragOffset);
+  lateCameraDragOffset = offset;
+  internal::requestViewRedraw();
+}
+
+glm::mat4 lastIterationViewMat{0.f};
+bool ssaaReducedForInteraction = false;
+
+// Decide whether this frame is rendered at reduced quality. The camera counts as moving if the view changed since the
+// last iteration, a camera flight is in progress, or the mouse is held down over the 3D view (so a drag which pauses
+// for a frame does not flicker back to full quality).
+void updateInteractiveQuality() {
+  bool viewChanged = view::viewMat != lastIterationViewMat;
+  lastIterationViewMat = view::viewMat;
+  bool mouseHeld = ImGui::IsAnyMouseDown() && !ImGui::GetIO().WantCaptureMouse;
+  bool cameraMoving = viewChanged || view::midflight || mouseHeld;
+  bool moving = options::adaptiveQuality && cameraMoving;
+  bool scaling = options::dynamicResolution && cameraMoving;
+
+  if ((internal::interactiveQualityActive && !moving) || (internal::dynamicResolutionActive && !scaling)) {
+    // the camera just came to rest, render again at full quality
+    internal::requestViewRedraw();
+  }
+  internal::interactiveQualityActive = moving;
+  internal::dynamicResolutionActive = scaling;
+}
+
+// Pick the next resolution scale from how long the last render of the scene took. Steps are damped and quantized so
+// the buffers are not reallocated every frame while the frame time hovers near the target.
+float nextDynamicResolutionScale(float currScale, float maxScale) {
+  profiling::TimerStats stats = profiling::getTimerStats("renderScene");
+  float frameMs = static_cast<float>(stats.cpu.lastMs);
+  if (stats.hasGPU) frameMs = std::max(frameMs, static_cast<float>(stats.gpu.lastMs));
+  if (frameMs <= 0.) return currScale;
+
+  float target = std::max(options::dynamicResolutionTargetMs, 1.f);
+  float newScale = currScale;
+  if (frameMs > target) {
+    // pixel count scales with the square of the resolution scale
+    newScale = currScale * std::max(std::sqrt(target / frameMs), 0.8f);
+  } else if (frameMs < 0.75 * target) {
+    newScale = currScale * std::min(std::sqrt(target / frameMs), 1.1f);
+  }
+
+  float minScale = std::min(glm::clamp(options::dynamicResolutionMinScale, 0.05f, 1.f), maxScale);
+  newScale = glm::clamp(newScale, minScale, maxScale);
+  newScale = std::round(newScale * 20.f) / 20.f;
+  return glm::clamp(newScale, minScale, maxScale);
+}
+
+// The resolution scale of the scene buffers when dynamic resolution is not reducing it, see options::renderScale
+float baseRenderScale() {
+  float scale = options::renderScale;
+  if (scale <= 0.f) {
+    scale = view::bufferWidth > 0 ? static_cast<float>(view::windowWidth) / view::bufferWidth : 1.f;
+  }
+  return glm::clamp(scale, 0.05f, 1.f);
+}
+
+// Switch the scene buffers between the full and reduced SSAA factors, and scale them while dynamic resolution is
+// active. This reallocates the buffers, but only happens when an interaction starts or ends, or the scale changes.
+void applyInteractiveSSAA() {
+  if (internal::interactiveQualityActive || internal::dynamicResolutionActive) {
+    int reducedFactor = options::ssaaFactor;
+    if (internal::interactiveQualityActive) {
+      reducedFactor = glm::clamp(options::adaptiveQualitySSAAFactor, 1, options::ssaaFactor);
+    }
+    if (internal::dynamicResolutionActive) {
+      reducedFactor = 1;
+    }
+    if (render::engine->getSSAAFactor() != reducedFactor) {
+      render::engine->setSSAAFactor(reducedFactor);
+    }
+    ssaaReducedForInteraction = true;
+  } else if (ssaaReducedForInteraction) {
+    render::engine->setSSAAFactor(options::ssaaFactor);
+    ssaaReducedForInteraction = false;
+  }
+
+  float newScale = baseRenderScale();
+  if (internal::dynamicResolutionActive) {
+    newScale = nextDynamicResolutionScale(render::engine->getResolutionScale(), newScale);
+  }
+  if (render::engine->getResolutionScale() != newScale) {
+    render::engine->setResolutionScale(newScale);
+  }
+}
+
+// Adaptive depth peeling. The structures drawn in each peel pass are wrapped in an occlusion query, and the results
+// are read back on a later frame (never waiting on the GPU) to find how many passes the scene needs: up to and
+// including the first pass which drew nothing, or one more than last time if every pass drew something.
+int depthPeelPassCount = -1; // -1 if not measured yet
+glm::mat4 depthPeelCountViewMat{0.f};
+uint64_t depthPeelCountSceneVersion = 0;
+int depthPeelPassesQueried = 0; // passes of the frame whose queries are in flight
+glm::mat4 depthPeelQueryViewMat{0.f};
+uint64_t depthPeelQuerySceneVersion = 0;
+
+// Returns false if the queries in flight have not finished yet
+bool readDepthPeelQueries() {
+  if (depthPeelPassesQueried == 0) return true;
+
+  int count = depthPeelPassesQueried + 1;
+  for (int iPass = 0; iPass < depthPeelPassesQueried; iPass++) {
+    bool anySamplesPassed;
+    if (!render::engine->getOcclusionQueryResult(iPass, anySamplesPassed)) return false;
+    if (!anySamplesPassed) {
+      count = iPass + 1;
+      break;
+    }
+  }
+
+  // The scene needs another frame if the count changed since the last measurement
+  if (count != depthPeelPassCount) internal::requestViewRedraw();
+  depthPeelPassCount = count;
+  depthPeelCountViewMat = depthPeelQueryViewMat;
+  depthPeelCountSceneVersion = depthPeelQuerySceneVersion;
+  depthPeelPassesQueried = 0;
+  return true;
+}
 
 void renderSlicePlanes() {
   for (SlicePlane* s : state::slicePlanes) {
@@ -416,79 +858,347 @@ void renderSlicePlanes() {
   }
 }
 
+namespace {
+
+void hashMatrix(size_t& seed, const glm::mat4& m) {
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) hash_combine::hash_combine(seed, m[i][j]);
+  }
+}
+
+// The skip key of the scene passes, which covers everything the rendered image depends on: the scene content (changes
+// to which go through requestRedraw()), the camera, and the render settings. 0 (never skip) if skipping is off.
+uint64_t sceneSkipKey(int nPeelPasses, uint64_t contentVersion = internal::sceneContentVersion) {
+  if (options::alwaysRedraw || lastRenderRequestedRedraw) return 0;
+  size_t seed = 0;
+  hash_combine::hash_combine(seed, contentVersion);
+  hashMatrix(seed, view::viewMat);
+  hashMatrix(seed, view::getCameraPerspectiveMatrix());
+  hash_combine::hash_combine(seed, render::engine->sceneBuffer->getSizeX());
+  hash_combine::hash_combine(seed, render::engine->sceneBuffer->getSizeY());
+  hash_combine::hash_combine(seed, static_cast<int>(render::engine->getTransparencyMode()));
+  hash_combine::hash_combine(seed, render::engine->deferredShadingActive());
+  hash_combine::hash_combine(seed, internal::interactiveQualityActive);
+  hash_combine::hash_combine(seed, nPeelPasses);
+  return seed == 0 ? 1 : seed;
+}
+
+// The static layer only depends on the changes which were not credited to dynamic structures. Transforms can be set
+// without a redraw request, so those of the static structures count too.
+uint64_t staticLayerSkipKey() {
+  size_t seed = sceneSkipKey(0, internal::sceneContentVersion - internal::dynamicContentChanges);
+  if (seed == 0) return 0;
+  for (auto& catMap : state::structures) {
+    for (auto& s : catMap.second) {
+      if (!s.second->isStatic() || !s.second->isEnabled()) continue;
+      hash_combine::hash_combine(seed, s.second->getHandle());
+      hashMatrix(seed, s.second->getTransform());
+    }
+  }
+  return seed == 0 ? 1 : seed;
+}
+
+bool anyStaticStructureEnabled() {
+  for (auto& catMap : state::structures) {
+    for (auto& s : catMap.second) {
+      if (s.second->isStatic() && s.second->isEnabled()) return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
 void renderScene() {
+  profiling::ScopedTimer timer("renderScene", true);
   processLazyProperties();
+  internal::renderSceneCount++;
+  uint64_t redrawRequestsBefore = viewRedrawRequestCount;
+  render::engine->updateFrameUniforms();
 
+  applyInteractiveSSAA();
   render::engine->applyTransparencySettings();
+  render::engine->prepareGlobalPrograms();
 
   render::engine->sceneBuffer->clearColor = {0., 0., 0.};
   render::engine->sceneBuffer->clearAlpha = 0.;
-  render::engine->sceneBuffer->clear();
 
   if (!render::engine->bindSceneBuffer()) return;
 
   // If a view has never been set, this will set it to the home view
   view::ensureViewValid();
 
+  // The frame is declared as passes of the engine's render graph, which skips them if nothing they depend on changed
+  // since they last ran (e.g. a redraw while the mouse is held over a still scene)
+  render::RenderGraph& graph = render::engine->frameGraph;
+  graph.beginFrame();
+  render::RenderResource sceneColor = graph.importResource("sceneColor");
+  render::RenderResource sceneDepth = graph.importResource("sceneDepth");
+  render::RenderResource sceneColorFinal = graph.importResource("sceneColorFinal");
+  bool structuresDrawn = false;
+  bool staticDrawn = false;
+
+  // Static structures are layered in the plain forward path only, the others draw every structure in several steps
+  bool useStaticLayer = render::engine->getTransparencyMode() == TransparencyMode::None &&
+                        !render::engine->deferredShadingActive() && anyStaticStructureEnabled();
+  if (!useStaticLayer && render::engine->hasStaticLayer()) render::engine->releaseStaticLayer();
+
+  // Clears and binds the scene buffer, before the first pass to draw in to it
+  auto beginScenePass = [&]() {
+    render::engine->sceneBuffer->clear();
+    render::engine->bindSceneBuffer();
+    occlusion::beginFrame();
+    structuresDrawn = true;
+  };
+
   if (render::engine->getTransparencyMode() == TransparencyMode::Pretty) {
     // Special depth peeling case: multiple render passes
     // We will perform several "peeled" rounds of rendering in to the usual scene buffer. After each, we will manually
     // composite in to the final scene buffer.
 
+    int nPasses = options::transparencyRenderPasses;
+    if (internal::interactiveQualityActive) {
+      nPasses = std::max(1, std::min(nPasses, options::adaptiveQualityTransparencyRenderPasses));
+    }
 
-    // Clear the final buffer explicitly since we will gradually composite in to it rather than just blitting directly
-    // as in normal rendering.
-    render::engine->sceneBufferFinal->clearColor = glm::vec3{0., 0., 0.};
-    render::engine->sceneBufferFinal->clearAlpha = 0;
-    render::engine->sceneBufferFinal->clear();
+    bool adaptivePasses = options::adaptiveTransparencyRenderPasses && render::engine->supportsOcclusionQueries();
+    bool issueQueries = false;
+    if (adaptivePasses) {
+      issueQueries = readDepthPeelQueries();
+      if (depthPeelPassCount > 0) nPasses = std::min(nPasses, depthPeelPassCount);
 
-    render::engine->setDepthMode(); // we need depth to be enabled for the clear below to do anything
-    render::engine->sceneDepthMinFrame->clear();
+      // If the count was measured for a different view or scene, render again to check it
+      if (view::viewMat != depthPeelCountViewMat || internal::sceneContentVersion != depthPeelCountSceneVersion) {
+        internal::requestViewRedraw();
+      }
+    } else {
+      depthPeelPassCount = -1;
+    }
+    if (issueQueries) {
+      depthPeelPassesQueried = nPasses;
+      depthPeelQueryViewMat = view::viewMat;
+      depthPeelQuerySceneVersion = internal::sceneContentVersion;
+    }
 
+    render::RenderResource sceneDepthMin = graph.importResource("sceneDepthMin");
+    auto peel = [&]() {
+      beginScenePass();
 
-    for (int iPass = 0; iPass < options::transparencyRenderPasses; iPass++) {
+      // Clear the final buffer explicitly since we will gradually composite in to it rather than just blitting
+      // directly as in normal rendering.
+      render::engine->sceneBufferFinal->clearColor = glm::vec3{0., 0., 0.};
+      render::engine->sceneBufferFinal->clearAlpha = 0;
+      render::engine->sceneBufferFinal->clear();
 
-      render::engine->bindSceneBuffer();
-      render::engine->clearSceneBuffer();
+      render::engine->setDepthMode(); // we need depth to be enabled for the clear below to do anything
+      render::engine->sceneDepthMinFrame->clear();
 
-      render::engine->applyTransparencySettings();
-      drawStructures();
+      for (int iPass = 0; iPass < nPasses; iPass++) {
+        profiling::ScopedTimer passTimer("depth peel pass", true);
+
+        render::engine->bindSceneBuffer();
+        render::engine->clearSceneBuffer();
 
-      // Draw ground plane, slicers, etc
-      bool isRedraw = iPass > 0;
-      render::engine->groundPlane.draw(isRedraw);
-      if (!isRedraw) {
-        // Only on first pass (kinda weird, but works out, and doesn't really matter)
-        renderSlicePlanes();
         render::engine->applyTransparencySettings();
-        drawStructuresDelayed();
+        if (issueQueries) render::engine->beginOcclusionQuery(iPass);
+        drawStructures();
+        if (issueQueries) render::engine->endOcclusionQuery();
+
+        // Draw ground plane, slicers, etc
+        bool isRedraw = iPass > 0;
+        render::engine->groundPlane.draw(isRedraw);
+        if (!isRedraw) {
+          // Only on first pass (kinda weird, but works out, and doesn't really matter)
+          renderSlicePlanes();
+          render::engine->applyTransparencySettings();
+          drawStructuresDelayed();
+        }
+
+        // Composite the result of this pass in to the result buffer
+        render::engine->sceneBufferFinal->bind();
+        render::engine->setDepthMode(DepthMode::Disable);
+        render::engine->setBlendMode(BlendMode::Under);
+        render::engine->compositePeel->draw();
+
+        // Update the minimum depth texture
+        render::engine->updateMinDepthTexture();
       }
+    };
+    // (the queries must be issued, so don't skip a frame which measures them)
+    graph.addPass("depth peel", {}, {sceneColor, sceneDepth, sceneDepthMin, sceneColorFinal}, peel,
+                  issueQueries ? 0 : sceneSkipKey(nPasses));
+
+  } else if (render::engine->getTransparencyMode() == TransparencyMode::WeightedBlended) {
+    // Weighted blended transparency: a single pass accumulates all structures in to the color and revealage targets,
+    // which are then resolved in to the final buffer.
+
+    render::RenderResource sceneRevealage = graph.importResource("sceneRevealage");
+    auto weightedBlended = [&]() {
+      beginScenePass();
+      render::engine->sceneBufferWeightedBlended->clear();
+      render::engine->applyTransparencySettings();
+      drawStructures();
+      render::engine->applyTransparencySettings();
+      drawStructuresDelayed();
+
+      render::engine->sceneBufferFinal->clearColor = glm::vec3{0., 0., 0.};
+      render::engine->sceneBufferFinal->clearAlpha = 0;
+      render::engine->sceneBufferFinal->clear();
+      render::engine->setDepthMode(DepthMode::Disable);
+      render::engine->setBlendMode(BlendMode::Disable);
+      render::engine->compositeWeightedBlended->draw();
+    };
+    graph.addPass("weighted blended structures", {}, {sceneColor, sceneDepth, sceneRevealage, sceneColorFinal},
+                  weightedBlended, sceneSkipKey(0));
+
+    // The ground plane and slice planes don't write revealage, draw them normally and composite them behind
+    auto planes = [&]() {
+      render::engine->bindSceneBuffer();
+      render::engine->clearSceneBuffer();
+      render::engine->applyTransparencySettings();
+      render::engine->groundPlane.draw();
+      renderSlicePlanes();
 
-      // Composite the result of this pass in to the result buffer
       render::engine->sceneBufferFinal->bind();
       render::engine->setDepthMode(DepthMode::Disable);
       render::engine->setBlendMode(BlendMode::Under);
       render::engine->compositePeel->draw();
-
-      // Update the minimum depth texture
-      render::engine->updateMinDepthTexture();
-    }
-
+    };
+    graph.addPass("weighted blended planes", {sceneColorFinal}, {sceneColor, sceneDepth, sceneColorFinal}, planes,
+                  sceneSkipKey(0));
 
   } else {
     // Normal case: single render pass
+    uint64_t skipKey = sceneSkipKey(0);
+
+    if (render::engine->deferredShadingActive()) {
+      // Draw the structures unlit in to the G-buffer, then light them in to the scene buffer
+      unsigned int sizeX = render::engine->sceneBuffer->getSizeX();
+      unsigned int sizeY = render::engine->sceneBuffer->getSizeY();
+      render::RenderResource albedo =
+          graph.createTransientTexture("gBufferAlbedo", TextureFormat::RGBA16F, sizeX, sizeY);
+      render::RenderResource normal =
+          graph.createTransientTexture("gBufferNormal", TextureFormat::RGBA16F, sizeX, sizeY);
+
+      auto gBuffer = [&]() {
+        beginScenePass();
+        render::engine->bindGBuffer(graph.getTexture(albedo), graph.getTexture(normal));
+        render::engine->applyTransparencySettings();
+        drawStructures();
+      };
+      graph.addPass("g-buffer", {}, {albedo, normal, sceneDepth}, gBuffer, skipKey);
 
-    render::engine->applyTransparencySettings();
-    drawStructures();
+      auto lighting = [&]() {
+        render::engine->resolveDeferredShading();
+        render::engine->applyTransparencySettings();
+        occlusion::captureSceneDepth();
+      };
+      graph.addPass("deferred lighting", {albedo, normal, sceneDepth}, {sceneColor}, lighting, skipKey);
+    } else if (useStaticLayer) {
+      // The static structures are cached in their own layer, which the others are drawn over
+      render::RenderResource staticLayer = graph.importResource("staticLayer");
+      auto staticStructures = [&]() {
+        render::engine->bindStaticLayer();
+        render::engine->applyTransparencySettings();
+        drawnStructureLayer = StructureLayer::Static;
+        drawStructures();
+        drawnStructureLayer = StructureLayer::All;
+        staticDrawn = true;
+      };
+      graph.addPass("static structures", {}, {staticLayer}, staticStructures, staticLayerSkipKey());
+
+      auto dynamicStructures = [&]() {
+        beginScenePass();
+        render::engine->compositeStaticLayer();
+        render::engine->applyTransparencySettings();
+        drawnStructureLayer = StructureLayer::Dynamic;
+        drawStructures();
+        drawnStructureLayer = StructureLayer::All;
+        occlusion::captureSceneDepth();
+      };
+      graph.addPass("structures", {staticLayer}, {sceneColor, sceneDepth}, dynamicStructures, skipKey);
+    } else {
+      // With sorted transparency only the opaque structures are drawn here, the transparent ones go over them below
+      bool sorted = render::engine->getTransparencyMode() == TransparencyMode::Sorted;
+      auto structures = [&, sorted]() {
+        beginScenePass();
+        render::engine->applyTransparencySettings();
+        if (sorted) drawnStructureOpacity = StructureOpacity::Opaque;
+        drawStructures();
+        drawnStructureOpacity = StructureOpacity::All;
+        occlusion::captureSceneDepth();
+      };
+      graph.addPass("structures", {}, {sceneColor, sceneDepth}, structures, skipKey);
+    }
 
-    render::engine->groundPlane.draw();
-    renderSlicePlanes();
+    auto planes = [&]() {
+      render::engine->bindSceneBuffer();
+      render::engine->groundPlane.draw();
+      renderSlicePlanes();
+    };
+    graph.addPass("ground and slice planes", {}, {sceneColor, sceneDepth}, planes, skipKey);
+
+    if (render::engine->getTransparencyMode() == TransparencyMode::Sorted) {
+      auto transparentStructures = [&]() {
+        render::engine->bindSceneBuffer();
+        render::engine->applyTransparencySettings();
+        drawnStructureOpacity = StructureOpacity::Transparent;
+        drawStructures();
+        drawnStructureOpacity = StructureOpacity::All;
+      };
+      graph.addPass("sorted transparent structures", {}, {sceneColor, sceneDepth}, transparentStructures, skipKey);
+    }
 
-    render::engine->applyTransparencySettings();
-    drawStructuresDelayed();
+    auto delayed = [&]() {
+      render::engine->bindSceneBuffer();
+      render::engine->applyTransparencySettings();
+      drawStructuresDelayed();
+    };
+    graph.addPass("delayed structures", {}, {sceneColor, sceneDepth}, delayed, skipKey);
+
+    if (options::ambientOcclusion) {
+      std::array<unsigned int, 2> aoSize = render::engine->getAmbientOcclusionSize();
+      render::RenderResource ao =
+          graph.createTransientTexture("ambientOcclusion", TextureFormat::RG16F, aoSize[0], aoSize[1]);
+
+      size_t aoKey = skipKey;
+      hash_combine::hash_combine(aoKey, options::ambientOcclusionRadius);
+      hash_combine::hash_combine(aoKey, options::ambientOcclusionStrength);
+      hash_combine::hash_combine(aoKey, state::lengthScale);
+      auto resolveAO = [&]() { render::engine->resolveSceneWithAmbientOcclusion(graph.getTexture(ao)); };
+      graph.addPass("ambient occlusion", {sceneColor, sceneDepth}, {ao, sceneColorFinal}, resolveAO,
+                    skipKey == 0 ? 0 : (aoKey == 0 ? 1 : aoKey));
+    } else {
+      auto resolve = [&]() { render::engine->sceneBuffer->blitTo(render::engine->sceneBufferFinal.get()); };
+      graph.addPass("resolve", {sceneColor}, {sceneColorFinal}, resolve, skipKey);
+    }
+  }
+
+  graph.markOutput(sceneColorFinal);
+  graph.execute();
+
+  // Structures count as drawn in frames which reuse the previous image (see enforceGPUMemoryBudget())
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      bool reused = x.second->isStatic() && useStaticLayer ? !staticDrawn : !structuresDrawn;
+      if (reused && x.second->isEnabled()) x.second->lastDrawnSceneCount = internal::renderSceneCount;
+    }
+  }
+  lastRenderRequestedRedraw = viewRedrawRequestCount != redrawRequestsBefore;
+}
 
-    render::engine->sceneBuffer->blitTo(render::engine->sceneBufferFinal.get());
+// Render any enabled viewports whose images are out of date. They share the scene buffers with the main view, so
+// returns true if the buffers were overwritten.
+bool renderViewports() {
+  bool rendered = false;
+  for (Viewport* v : state::viewports) {
+    if (!v->needsRender()) continue;
+    v->beginRender();
+    renderScene();
+    v->endRender();
+    rendered = true;
   }
+  return rendered;
 }
 
 void renderSceneToScreen() {
@@ -497,11 +1207,32 @@ void renderSceneToScreen() {
     // special debug draw
     pick::evaluatePickQuery(-1, -1); // populate the buffer
     render::engine->pickFramebuffer->blitTo(render::engine->displayBuffer.get());
+  } else if (options::temporalAntialiasing) {
+    render::engine->applyLightingTransform(render::engine->getTemporalResult());
   } else {
     render::engine->applyLightingTransform(render::engine->sceneColorFinal);
   }
 }
 
+// Sub-pixel offset for the i'th temporal antialiasing sample, in normalized device coordinates. The first sample is
+// unjittered, so a view which keeps changing looks the same as without antialiasing; the rest follow a (2,3) Halton
+// sequence over the pixel.
+glm::vec2 temporalJitter(int sampleInd) {
+  if (sampleInd == 0) return glm::vec2{0., 0.};
+  auto halton = [](int i, int base) {
+    float f = 1.;
+    float r = 0.;
+    while (i > 0) {
+      f /= base;
+      r += f * (i % base);
+      i /= base;
+    }
+    return r;
+  };
+  glm::vec2 offsetPixels{halton(sampleInd, 2) - 0.5f, halton(sampleInd, 3) - 0.5f};
+  return 2.f * offsetPixels / glm::vec2{view::bufferWidth, view::bufferHeight};
+}
+
 } // namespace
 
 void buildPolyscopeGui() {
@@ -596,6 +1327,24 @@ void buildPolyscopeGui() {
       render::engine->showTextureInImGuiWindow("Scene", render::engine->sceneColor.get());
       render::engine->showTextureInImGuiWindow("Scene Final", render::engine->sceneColorFinal.get());
     }
+
+    ImGui::SetNextTreeNodeOpen(false, ImGuiCond_FirstUseEver);
+    if (ImGui::TreeNode("Profiling")) {
+      profiling::buildProfilingGui();
+      ImGui::TreePop();
+    }
+
+    ImGui::SetNextTreeNodeOpen(false, ImGuiCond_FirstUseEver);
+    if (ImGui::TreeNode("Memory")) {
+      // everything, including engine-internal buffers which no structure owns
+      render::GPUMemoryUsage gpuUsage = render::getGPUMemoryUsage();
+      ImGui::Text("GPU total (est.): %.2f MB", static_cast<double>(gpuUsage.totalBytes()) / (1 << 20));
+      ImGui::Text("Host buffers:     %.2f MB", static_cast<double>(render::getManagedBufferHostBytes()) / (1 << 20));
+      ImGui::PushItemWidth(100);
+      ImGui::InputInt("GPU budget (MB, -1 for none)", &options::gpuMemoryBudgetMB);
+      ImGui::PopItemWidth();
+      ImGui::TreePop();
+    }
     ImGui::TreePop();
   }
 
@@ -606,7 +1355,69 @@ void buildPolyscopeGui() {
   ImGui::End();
 }
 
+namespace {
+
+// Categories with more structures than this are shown as a filterable, clipped list of rows (with just the name and
+// enabled checkbox), plus the full UI of the row which was clicked
+const size_t largeStructureListSize = 64;
+
+void buildLargeStructureListGui(const std::string& catName,
+                                InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& structureMap) {
+  static std::map<std::string, ImGuiTextFilter> filters;
+  static std::map<std::string, std::string> selectedNames;
+  ImGuiTextFilter& filter = filters[catName];
+  std::string& selectedName = selectedNames[catName];
+
+  filter.Draw("Filter", 160);
+
+  // Only a search visits every structure; otherwise rows map directly to registry entries
+  std::vector<size_t> matches;
+  if (filter.IsActive()) {
+    for (size_t i = 0; i < structureMap.size(); i++) {
+      if (filter.PassFilter(structureMap.entryAt(i).first.c_str())) matches.push_back(i);
+    }
+  }
+  size_t nRows = filter.IsActive() ? matches.size() : structureMap.size();
+
+  // (the checkboxes and selection only change state, they never add or remove structures, so the registry is safe to
+  // index directly here)
+  const size_t maxVisibleRows = 12;
+  float listHeight = std::min(nRows, maxVisibleRows) * ImGui::GetFrameHeightWithSpacing();
+  ImGui::BeginChild("structure list", ImVec2(0, listHeight), true);
+  ImGuiListClipper clipper;
+  clipper.Begin(static_cast<int>(nRows));
+  while (clipper.Step()) {
+    for (int iRow = clipper.DisplayStart; iRow < clipper.DisplayEnd; iRow++) {
+      size_t ind = filter.IsActive() ? matches[iRow] : iRow;
+      const std::string& name = structureMap.entryAt(ind).first;
+      Structure& s = *structureMap.entryAt(ind).second;
+      ImGui::PushID(name.c_str());
+      bool enabled = s.isEnabled();
+      if (ImGui::Checkbox("##enabled", &enabled)) s.setEnabled(enabled);
+      ImGui::SameLine();
+      if (ImGui::Selectable(name.c_str(), name == selectedName)) {
+        selectedName = (name == selectedName) ? "" : name;
+      }
+      ImGui::PopID();
+    }
+  }
+  clipper.End();
+  ImGui::EndChild();
+
+  // The full UI for the selected structure
+  auto selectedIt = structureMap.find(selectedName);
+  if (selectedIt != structureMap.end()) {
+    std::shared_ptr<Structure> selected = selectedIt->second;
+    ImGui::SetNextTreeNodeOpen(true, ImGuiCond_Appearing);
+    selected->buildUI();
+  }
+}
+
+} // namespace
+
 void buildStructureGui() {
+  profiling::ScopedTimer timer("buildStructureGui");
+
   // Create window
   static bool showStructureWindow = true;
 
@@ -627,26 +1438,59 @@ void buildStructureGui() {
     }
   }
 
-  for (auto catMapEntry : state::structures) {
-    std::string catName = catMapEntry.first;
+  // Structure UIs may register or remove structures, and the registry must not be modified while it is being iterated,
+  // so each category's UI works from a snapshot of the structures it will build UI for. Large categories only build
+  // the rows which are on screen (see buildLargeStructureListGui()).
+  FrameVector<FrameString> catNames;
+  for (auto& catMapEntry : state::structures) {
+    catNames.emplace_back(catMapEntry.first.c_str());
+  }
 
-    std::map<std::string, std::shared_ptr<Structure>>& structureMap = catMapEntry.second;
+  for (const FrameString& catNameEntry : catNames) {
+    std::string catName(catNameEntry.c_str());
+    auto catIt = state::structures.find(catName);
+    if (catIt == state::structures.end()) continue; // removed by an earlier category's UI
+    InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& structureMap = catIt->second;
 
     ImGui::PushID(catName.c_str()); // ensure there are no conflicts with
                                     // identically-named labels
 
     // Build the structure's UI
     ImGui::SetNextTreeNodeOpen(structureMap.size() > 0, ImGuiCond_FirstUseEver);
-    if (ImGui::CollapsingHeader((catName + " (" + std::to_string(structureMap.size()) + ")").c_str())) {
+    if (ImGui::CollapsingHeader(frameFormat("%s (%zu)", catName.c_str(), structureMap.size()))) {
       // Draw shared GUI elements for all instances of the structure
       if (structureMap.size() > 0) {
-        structureMap.begin()->second->buildSharedStructureUI();
+        std::shared_ptr<Structure> front = structureMap.entryAt(0).second;
+        front->buildSharedStructureUI();
       }
 
-      for (auto x : structureMap) {
-        ImGui::SetNextTreeNodeOpen(structureMap.size() <= 8,
-                                   ImGuiCond_FirstUseEver); // closed by default if more than 8
-        x.second->buildUI();
+      if (structureMap.size() > 1) {
+        std::vector<std::shared_ptr<Structure>> all;
+        bool enableAll = ImGui::SmallButton("Enable all");
+        ImGui::SameLine();
+        bool disableAll = ImGui::SmallButton("Disable all");
+        if (enableAll || disableAll) {
+          for (auto& x : structureMap) {
+            all.push_back(x.second);
+          }
+          for (std::shared_ptr<Structure>& x : all) {
+            x->setEnabled(enableAll);
+          }
+        }
+      }
+
+      if (structureMap.size() > largeStructureListSize) {
+        buildLargeStructureListGui(catName, structureMap);
+      } else {
+        std::vector<std::shared_ptr<Structure>> list;
+        for (auto& x : structureMap) {
+          list.push_back(x.second);
+        }
+        for (std::shared_ptr<Structure>& x : list) {
+          ImGui::SetNextTreeNodeOpen(list.size() <= 8,
+                                     ImGuiCond_FirstUseEver); // closed by default if more than 8
+          x->buildUI();
+        }
       }
     }
 
@@ -678,6 +1522,7 @@ void buildPickGui() {
 }
 
 void buildUserGuiAndInvokeCallback() {
+  profiling::ScopedTimer timer("buildUserGuiAndInvokeCallback");
 
   if (!options::invokeUserCallbackForNestedShow && contextStack.size() > 2) {
     // NOTE: this may have funky interactions with manually calling frameTick()
@@ -710,9 +1555,43 @@ void buildUserGuiAndInvokeCallback() {
   }
 }
 
+namespace {
+// Whether the UI can be drawn from the last frame's ImGui draw data rather than built again, see options::reuseIdleUI
+bool uiIsIdle() {
+  uint64_t inputEventCount = render::engine->getInputEventCount();
+  ImGuiIO& io = ImGui::GetIO();
+  bool active = !options::reuseIdleUI || contextStack.back().callbackBuildsUI ||
+                ImGui::GetCurrentContext() != lastBuiltUIContext || inputEventCount != lastUIInputEventCount ||
+                viewRedrawRequestCount != lastUIRedrawRequestCount || options::alwaysRedraw || view::midflight ||
+                isRecording() || hasRemoteClient() || io.WantCaptureMouse || io.WantTextInput;
+  lastUIInputEventCount = inputEventCount;
+  lastUIRedrawRequestCount = viewRedrawRequestCount;
+  if (active) {
+    uiFramesSinceActivity = 0;
+    return false;
+  }
+
+  // ImGui needs a few frames after activity to settle, see idleSettleFrames
+  uiFramesSinceActivity++;
+  return uiFramesSinceActivity > idleSettleFrames;
+}
+} // namespace
+
 void draw(bool withUI, bool withContextCallback) {
+  // Release the previous frame's temporaries, unless this is a nested draw (e.g. a screenshot from a UI callback)
+  static int drawDepth = 0;
+  if (drawDepth == 0) frameArena().reset();
+  drawDepth++;
+  struct DrawDepthGuard {
+    ~DrawDepthGuard() { drawDepth--; }
+  } drawDepthGuard;
+
+  profiling::ScopedTimer frameTimer("draw", true);
   processLazyProperties();
 
+  // (before anything is drawn, so nothing in flight for this frame refers to released buffers)
+  enforceGPUMemoryBudget();
+
   // Update buffer and context
   render::engine->makeContextCurrent();
   render::engine->bindDisplay();
@@ -720,12 +1599,17 @@ void draw(bool withUI, bool withContextCallback) {
   render::engine->setBackgroundAlpha(view::bgColor[3]);
   render::engine->clearDisplay();
 
-  if (withUI) {
+  // (only for frames of the main loop, whose UI is the one which is reused)
+  bool reuseUI = withUI && drawDepth == 1 && uiIsIdle();
+  bool buildUI = withUI && !reuseUI;
+
+  if (buildUI) {
     render::engine->ImGuiNewFrame();
+    lastBuiltUIContext = ImGui::GetCurrentContext();
   }
 
   // Build the GUI components
-  if (withUI) {
+  if (buildUI) {
     if (contextStack.back().drawDefaultUI) {
 
       // Note: It is important to build the user GUI first, because it is likely that callbacks there will modify
@@ -741,6 +1625,8 @@ void draw(bool withUI, bool withContextCallback) {
         for (Widget* w : state::widgets) {
           w->buildGUI();
         }
+
+        buildViewportsGui();
       }
     }
   }
@@ -753,15 +1639,35 @@ void draw(bool withUI, bool withContextCallback) {
 
   processLazyProperties();
 
-  // Draw structures in the scene
-  if (redrawNextFrame || options::alwaysRedraw) {
+  // Viewports render first, since they leave their contents in the scene buffers. The main view is then rendered again,
+  // unless it is shown from the temporal antialiasing history (which they don't touch).
+  bool sceneBuffersOverwritten = renderViewports() && !options::temporalAntialiasing;
+
+  // (only for frames of the main loop, not e.g. screenshots taken from a callback)
+  if (withUI && drawDepth == 1) lateCameraUpdate();
+
+  // Draw structures in the scene. With temporal antialiasing a still scene is rendered again (with a new jitter) until
+  // it has all of its samples, and any change starts the average over.
+  bool sceneChanged = redrawNextFrame || options::alwaysRedraw;
+  if (sceneChanged || sceneBuffersOverwritten || !render::engine->temporalAccumulationConverged()) {
+    if (options::temporalAntialiasing) {
+      if (sceneChanged) render::engine->resetTemporalAccumulation();
+      view::projectionJitter = temporalJitter(render::engine->getTemporalSampleCount());
+    }
     renderScene();
+    if (options::temporalAntialiasing) {
+      view::projectionJitter = glm::vec2{0., 0.};
+      render::engine->accumulateTemporalSample();
+    }
     redrawNextFrame = false;
+    internal::pageImageTextures();
   }
   renderSceneToScreen();
 
   // Draw the GUI
   if (withUI) {
+    internal::captureRecordingFrame(false);
+
     // render widgets
     render::engine->bindDisplay();
     for (Widget* w : state::widgets) {
@@ -769,27 +1675,45 @@ void draw(bool withUI, bool withContextCallback) {
     }
 
     render::engine->bindDisplay();
-    render::engine->ImGuiRender();
+    {
+      profiling::ScopedTimer timer("ImGuiRender", true);
+      if (reuseUI) {
+        render::engine->ImGuiRenderLast();
+      } else {
+        render::engine->ImGuiRender();
+      }
+    }
+    internal::captureRecordingFrame(true);
+    internal::captureRemoteFrame();
   }
 }
 
 
 void mainLoopIteration() {
 
+  processPostedUpdates();
   processLazyProperties();
 
   render::engine->makeContextCurrent();
   render::engine->updateWindowSize();
 
+  // Deliver any async framebuffer reads from previous frames which have finished
+  render::engine->processPendingReadbacks();
+
   // Process UI events
   render::engine->pollEvents();
+  inputSampleTime = std::chrono::steady_clock::now();
+  internal::processRemoteInput();
   processInputEvents();
   view::updateFlight();
+  updateInteractiveQuality();
   showDelayedWarnings();
 
   // Rendering
   draw();
   render::engine->swapDisplayBuffers();
+  profiling::recordTime("input to present", inputSampleTime, std::chrono::steady_clock::now());
+  profiling::endFrame();
 }
 
 void show(size_t forFrames) {
@@ -798,6 +1722,9 @@ void show(size_t forFrames) {
     exception("must initialize Polyscope with polyscope::init() before calling polyscope::show().");
   }
 
+  // (counting frames requires drawing them, so only an open-ended show() may sleep)
+  bool allowIdle = forFrames == std::numeric_limits<size_t>::max();
+
   // the popContext() doesn't quit until _after_ the last frame, so we need to decrement by 1 to get the count right
   if (forFrames > 0) forFrames--;
 
@@ -813,7 +1740,7 @@ void show(size_t forFrames) {
     render::engine->focusWindow();
   }
 
-  pushContext(checkFrames);
+  pushContextImpl(checkFrames, true, allowIdle, false);
 
   if (options::usePrefsFile) {
     writePrefsFile();
@@ -825,13 +1752,119 @@ void show(size_t forFrames) {
   }
 }
 
+void showAsync() {
+
+  if (!state::initialized) {
+    exception("must initialize Polyscope with polyscope::init() before calling polyscope::showAsync().");
+  }
+  if (isShowingAsync()) return;
+  if (asyncRenderThread.joinable()) {
+    asyncRenderThread.join(); // the window was closed, but nobody called stopAsync()
+  }
+
+  asyncStopRequested = false;
+  asyncRunning = true;
+  render::engine->releaseContext();
+
+  asyncRenderThread = std::thread([]() {
+    render::engine->makeContextCurrent();
+    if (options::giveFocusOnShow) {
+      render::engine->focusWindow();
+    }
+
+    auto countFrame = []() {
+      {
+        std::lock_guard<std::mutex> lock(asyncFrameMutex);
+        asyncFramesDrawn++;
+      }
+      asyncFrameCV.notify_all();
+      if (asyncStopRequested) {
+        popContext();
+      }
+    };
+    pushContextImpl(countFrame, true, true, false);
+
+    if (options::usePrefsFile) {
+      writePrefsFile();
+    }
+    if (contextStack.size() == 1) {
+      render::engine->hideWindow();
+    }
+    render::engine->releaseContext();
+
+    {
+      std::lock_guard<std::mutex> lock(asyncFrameMutex);
+      asyncRunning = false;
+    }
+    asyncFrameCV.notify_all();
+  });
+}
+
+bool isShowingAsync() { return asyncRunning; }
+
+void stopAsync() {
+  if (!asyncRenderThread.joinable()) return;
+  if (std::this_thread::get_id() == asyncRenderThread.get_id()) {
+    exception("stopAsync() cannot be called from the render thread, e.g. in the user callback");
+    return;
+  }
+
+  asyncStopRequested = true;
+  render::engine->wakeEventWait();
+  asyncRenderThread.join();
+  asyncStopRequested = false;
+
+  render::engine->makeContextCurrent();
+}
+
+void waitForNextFrame() {
+  if (!asyncRenderThread.joinable() || std::this_thread::get_id() == asyncRenderThread.get_id()) {
+    exception("waitForNextFrame() can only be called while showAsync() runs, from another thread");
+    return;
+  }
+
+  // The frame in progress may have begun before this call, so wait for the one after it
+  std::unique_lock<std::mutex> lock(asyncFrameMutex);
+  size_t targetFrame = asyncFramesDrawn + 2;
+  asyncFrameWaiters++;
+  render::engine->wakeEventWait();
+  asyncFrameCV.wait(lock, [&]() { return asyncFramesDrawn >= targetFrame || !asyncRunning; });
+  asyncFrameWaiters--;
+}
+
+void waitForPostedUpdates() {
+  if (!isShowingAsync() || std::this_thread::get_id() == asyncRenderThread.get_id()) {
+    processPostedUpdates();
+    return;
+  }
+
+  // Posted functions run in order, so once this one has run, so has everything before it
+  std::shared_ptr<bool> done = std::make_shared<bool>(false);
+  postToMainThread([done]() {
+    {
+      std::lock_guard<std::mutex> lock(asyncFrameMutex);
+      *done = true;
+    }
+    asyncFrameCV.notify_all();
+  });
+  std::unique_lock<std::mutex> lock(asyncFrameMutex);
+  asyncFrameCV.wait(lock, [&]() { return *done || !asyncRunning; });
+}
+
 void shutdown() {
 
+  stopAsync();
+
   // TODO should we make an effort to destruct everything here?
   if (options::usePrefsFile) {
     writePrefsFile();
   }
 
+  // Don't drop any outstanding async reads or file writes (e.g. screenshots which have not been written yet)
+  stopRecording();
+  stopRemoteServer();
+  flushScreenshots();
+
   render::engine->shutdownImGui();
 }
 
@@ -880,7 +1913,7 @@ bool setParentGroupOfStructure(std::string typeName, std::string child, std::str
     return false;
   }
 
-  std::map<std::string, std::shared_ptr<Structure>>& sMap = getStructureMapCreateIfNeeded(typeName);
+  InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& sMap = getStructureMapCreateIfNeeded(typeName);
 
   // check if child exists
   bool childExists = sMap.find(child) != sMap.end();
@@ -899,16 +1932,91 @@ bool setParentGroupOfStructure(Structure* child, std::string parent) {
   return setParentGroupOfStructure(child->typeName(), child->name, parent);
 }
 
+namespace {
+int structureExtentsBatchDepth = 0;
+bool structureExtentsBatchPending = false;
+
+// The largest length scale and the union of the bounding boxes of all structures, before the fix-ups in
+// applySceneExtents(). Kept so that registering a structure can extend them in constant time, rather than visiting
+// every structure again. Only valid while accumulatedExtentsValid.
+bool accumulatedExtentsValid = false;
+float accumulatedLengthScale = 0.;
+glm::vec3 accumulatedBboxMin, accumulatedBboxMax;
+
+void resetAccumulatedExtents() {
+  accumulatedLengthScale = 0.;
+  accumulatedBboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  accumulatedBboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+}
+
+void accumulateExtents(Structure& s) {
+  if (!s.hasExtents()) return;
+  accumulatedLengthScale = std::max(accumulatedLengthScale, s.lengthScale());
+  auto bbox = s.boundingBox();
+  accumulatedBboxMin = componentwiseMin(accumulatedBboxMin, std::get<0>(bbox));
+  accumulatedBboxMax = componentwiseMax(accumulatedBboxMax, std::get<1>(bbox));
+}
+
+void applySceneExtents() {
+  state::lengthScale = accumulatedLengthScale;
+  glm::vec3 minBbox = accumulatedBboxMin;
+  glm::vec3 maxBbox = accumulatedBboxMax;
+
+  // If we got a non-finite bounding box, fix it
+  if (!isFinite(minBbox) || !isFinite(maxBbox)) {
+    minBbox = -glm::vec3{1, 1, 1};
+    maxBbox = glm::vec3{1, 1, 1};
+  }
+
+  // If we got a degenerate bounding box, perturb it slightly
+  if (minBbox == maxBbox) {
+    double offsetScale = (state::lengthScale == 0) ? 1e-5 : state::lengthScale * 1e-5;
+    glm::vec3 offset{offsetScale, offsetScale, offsetScale};
+    minBbox = minBbox - offset / 2.f;
+    maxBbox = maxBbox + offset / 2.f;
+  }
+
+  std::get<0>(state::boundingBox) = minBbox;
+  std::get<1>(state::boundingBox) = maxBbox;
+
+  // If we got a bounding box but not a length scale we can use the size of the
+  // box as a scale. If we got neither, we'll end up with a constant near 1 due
+  // to the above correction
+  if (state::lengthScale == 0) {
+    state::lengthScale = glm::length(maxBbox - minBbox);
+  }
+
+  requestRedraw();
+}
+
+// Update the scene extents for a structure which was just added
+void extendStructureExtents(Structure& s) {
+  if (!options::automaticallyComputeSceneExtents || structureExtentsBatchDepth > 0 || !accumulatedExtentsValid) {
+    updateStructureExtents();
+    return;
+  }
+  accumulateExtents(s);
+  applySceneExtents();
+}
+
+// Set while registerStructure() removes the structure it replaces
+bool replacingStructure = false;
+} // namespace
+
 bool registerStructure(Structure* s, bool replaceIfPresent) {
+  profiling::ScopedTimer timer("registerStructure");
 
   std::string typeName = s->typeName();
-  std::map<std::string, std::shared_ptr<Structure>>& sMap = getStructureMapCreateIfNeeded(typeName);
+  InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& sMap = getStructureMapCreateIfNeeded(typeName);
 
   // Check if the structure name is in use
   bool inUse = sMap.find(s->name) != sMap.end();
   if (inUse) {
     if (replaceIfPresent) {
-      removeStructure(s->name);
+      // (the replacement keeps the settings of the old one)
+      replacingStructure = true;
+      removeStructure(typeName, s->name);
+      replacingStructure = false;
     } else {
       exception("Attempted to register structure with name " + s->name +
                 ", but a structure with that name already exists");
@@ -917,16 +2025,23 @@ bool registerStructure(Structure* s, bool replaceIfPresent) {
   }
 
   // Center/scale if desired
+  // (the structure is not in the scene yet, so this does not change the scene extents)
+  bool extentsPendingBefore = structureExtentsBatchPending;
+  structureExtentsBatchDepth++;
   if (options::autocenterStructures) {
     s->centerBoundingBox();
   }
   if (options::autoscaleStructures) {
     s->rescaleToUnit();
   }
+  structureExtentsBatchDepth--;
+  structureExtentsBatchPending = extentsPendingBefore;
 
   // Add the new structure
   sMap[s->name] = std::shared_ptr<Structure>(s); // take ownership with a shared pointer
-  updateStructureExtents();
+  s->handle = nextStructureHandle++;
+  structuresByHandle[s->handle] = s;
+  extendStructureExtents(*s);
   requestRedraw();
 
   return true;
@@ -941,7 +2056,7 @@ Structure* getStructure(std::string type, std::string name) {
     exception("No structures of type " + type + " registered");
     return nullptr;
   }
-  std::map<std::string, std::shared_ptr<Structure>>& sMap = state::structures[type];
+  InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& sMap = state::structures[type];
 
   // Special automatic case, return any
   if (name == "") {
@@ -961,12 +2076,18 @@ Structure* getStructure(std::string type, std::string name) {
   return sMap[name].get();
 }
 
+Structure* getStructureByHandle(StructureHandle handle) {
+  auto it = structuresByHandle.find(handle);
+  if (it == structuresByHandle.end()) return nullptr;
+  return it->second;
+}
+
 bool hasStructure(std::string type, std::string name) {
   // If there are no structures of that type it is an automatic fail
   if (state::structures.find(type) == state::structures.end()) {
     return false;
   }
-  std::map<std::string, std::shared_ptr<Structure>>& sMap = state::structures[type];
+  InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& sMap = state::structures[type];
 
   // Special automatic case, return any
   if (name == "") {
@@ -1016,7 +2137,7 @@ void removeStructure(std::string type, std::string name, bool errorIfAbsent) {
     }
     return;
   }
-  std::map<std::string, std::shared_ptr<Structure>>& sMap = state::structures[type];
+  InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& sMap = state::structures[type];
 
   // Check if structure exists
   if (sMap.find(name) == sMap.end()) {
@@ -1036,8 +2157,15 @@ void removeStructure(std::string type, std::string name, bool errorIfAbsent) {
     g.second->removeChildStructure(s);
   }
   pick::resetSelectionIfStructure(s);
+  pick::releasePickBufferRange(s);
+  structuresByHandle.erase(s->handle);
+  std::string prefix = s->uniquePrefix();
   sMap.erase(s->name);
+  if (!options::retainRemovedStructureSettings && !replacingStructure) {
+    detail::dropPersistentValues(prefix);
+  }
   updateStructureExtents();
+  requestRedraw(); // also ensures the cached pick buffer does not refer to the removed structure
   return;
 }
 
@@ -1049,8 +2177,8 @@ void removeStructure(std::string name, bool errorIfAbsent) {
 
   // Check if we can find exactly one structure matching the name
   Structure* targetStruct = nullptr;
-  for (auto typeMap : state::structures) {
-    for (auto entry : typeMap.second) {
+  for (auto& typeMap : state::structures) {
+    for (auto& entry : typeMap.second) {
 
       // Found a matching structure
       if (entry.first == name) {
@@ -1081,11 +2209,12 @@ void removeStructure(std::string name, bool errorIfAbsent) {
 
 void removeAllStructures() {
 
-  for (auto typeMap : state::structures) {
+  internal::beginStructureExtentsBatch();
+  for (auto& typeMap : state::structures) {
 
     // dodge iterator invalidation
     std::vector<std::string> names;
-    for (auto entry : typeMap.second) {
+    for (auto& entry : typeMap.second) {
       names.push_back(entry.first);
     }
 
@@ -1094,6 +2223,7 @@ void removeAllStructures() {
       removeStructure(typeMap.first, name);
     }
   }
+  internal::endStructureExtentsBatch();
 
   requestRedraw();
   pick::resetSelection();
@@ -1105,8 +2235,8 @@ void refresh() {
   render::engine->groundPlane.prepare();
 
   // reset all of the structures
-  for (auto cat : state::structures) {
-    for (auto x : cat.second) {
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
       x.second->refresh();
     }
   }
@@ -1127,6 +2257,7 @@ float shadowDarkness = .4;
 } // namespace lazy
 
 void processLazyProperties() {
+  profiling::ScopedTimer timer("processLazyProperties");
 
   // Note: This function essentially represents lazy software design, and it's an ugly and error-prone part of the
   // system. The reason for it that some settings require action on a change (e..g re-drawing the scene), but we want to
@@ -1182,57 +2313,45 @@ void processLazyProperties() {
   }
 };
 
+namespace internal {
+void beginStructureExtentsBatch() { structureExtentsBatchDepth++; }
+
+void endStructureExtentsBatch() {
+  if (structureExtentsBatchDepth == 0) exception("endStructureExtentsBatch() without a matching begin");
+  structureExtentsBatchDepth--;
+  if (structureExtentsBatchDepth == 0 && structureExtentsBatchPending) {
+    structureExtentsBatchPending = false;
+    updateStructureExtents();
+  }
+}
+} // namespace internal
+
 void updateStructureExtents() {
 
   if (!options::automaticallyComputeSceneExtents) {
+    accumulatedExtentsValid = false;
+    return;
+  }
+
+  if (structureExtentsBatchDepth > 0) {
+    structureExtentsBatchPending = true;
     return;
   }
 
   // Note: the cost multiple calls to this function scales only with the number of structures, not the size of the data
-  // in those structures, because structures internally cache the extents of their data.
+  // in those structures, because structures internally cache the extents of their data. Registering a structure only
+  // extends the current extents (see extendStructureExtents()), so bulk registration does not pay this cost each time.
 
   // Compute length scale and bbox as the max of all structures
-  state::lengthScale = 0.0;
-  glm::vec3 minBbox = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 maxBbox = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-
-  for (auto cat : state::structures) {
-    for (auto x : cat.second) {
-      if (!x.second->hasExtents()) {
-        continue;
-      }
-      state::lengthScale = std::max(state::lengthScale, x.second->lengthScale());
-      auto bbox = x.second->boundingBox();
-      minBbox = componentwiseMin(minBbox, std::get<0>(bbox));
-      maxBbox = componentwiseMax(maxBbox, std::get<1>(bbox));
+  resetAccumulatedExtents();
+  for (auto& cat : state::structures) {
+    for (auto& x : cat.second) {
+      accumulateExtents(*x.second);
     }
   }
+  accumulatedExtentsValid = true;
 
-  // If we got a non-finite bounding box, fix it
-  if (!isFinite(minBbox) || !isFinite(maxBbox)) {
-    minBbox = -glm::vec3{1, 1, 1};
-    maxBbox = glm::vec3{1, 1, 1};
-  }
-
-  // If we got a degenerate bounding box, perturb it slightly
-  if (minBbox == maxBbox) {
-    double offsetScale = (state::lengthScale == 0) ? 1e-5 : state::lengthScale * 1e-5;
-    glm::vec3 offset{offsetScale, offsetScale, offsetScale};
-    minBbox = minBbox - offset / 2.f;
-    maxBbox = maxBbox + offset / 2.f;
-  }
-
-  std::get<0>(state::boundingBox) = minBbox;
-  std::get<1>(state::boundingBox) = maxBbox;
-
-  // If we got a bounding box but not a length scale we can use the size of the
-  // box as a scale. If we got neither, we'll end up with a constant near 1 due
-  // to the above correction
-  if (state::lengthScale == 0) {
-    state::lengthScale = glm::length(maxBbox - minBbox);
-  }
-
-  requestRedraw();
+  applySceneExtents();
 }
 
 namespace state {
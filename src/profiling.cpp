@@ -0,0 +1,447 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/profiling.h"
+
+#include "imgui.h"
+#include "polyscope/messages.h"
+#include "polyscope/options.h"
+#include "polyscope/render/engine.h"
+
+#include "json/json.hpp"
+using json = nlohmann::json;
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef POLYSCOPE_ENABLE_TRACY
+#include "tracy/TracyC.h"
+#endif
+
+namespace polyscope {
+namespace profiling {
+
+namespace {
+
+// Number of frames kept for the rolling statistics
+const size_t windowSize = 120;
+
+struct TimerRecord {
+  std::string name;
+
+  // accumulated over the current frame
+  double cpuFrameMs = 0.;
+  size_t callsThisFrame = 0;
+  size_t lastCallsPerFrame = 0;
+
+  // one sample per frame in which the timer ran
+  std::deque<double> cpuSamples;
+  std::deque<double> gpuSamples;
+
+  // GPU time per frame, for frames which may still have timers in flight
+  std::map<uint64_t, double> gpuPendingFrames;
+};
+
+// Records are never removed (only cleared), so that GPU results in flight always refer to the right timer
+std::vector<TimerRecord> timers;
+std::vector<InitPhaseTime> initPhaseTimes;
+std::unordered_map<std::string, size_t> timerIDs;
+uint64_t currentFrame = 0;
+std::vector<render::GPUTimerResult> gpuResults;
+
+// Frame capture, see beginFrameCapture()
+bool capturingFrames = false;
+std::map<uint64_t, FrameTimings> capturedFrames;
+
+// Heap allocation counts, see getLastFrameHeapAllocations()
+uint64_t heapAllocationsAtFrameStart = 0;
+uint64_t lastFrameHeapAllocations = 0;
+
+// Reused for looking up timers by name, so that a lookup does not allocate once the key has grown to fit
+std::string timerKey;
+
+// Trace recording, see beginTrace()
+struct TraceEvent {
+  size_t timerID;
+  double startUs;
+  double durationUs;
+};
+struct TraceCounter {
+  size_t timerID;
+  double timeUs;
+  double gpuMs;
+};
+bool tracing = false;
+std::vector<TraceEvent> traceEvents;
+std::vector<TraceCounter> traceCounters;
+std::vector<std::pair<uint64_t, double>> traceFrameEnds; // (frame, time)
+std::map<uint64_t, double> tracePendingFrameEnds;         // for placing GPU timings which have not all arrived
+
+double steadyMicroseconds(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration<double, std::micro>(t.time_since_epoch()).count();
+}
+
+#ifdef POLYSCOPE_ENABLE_TRACY
+// Zones of the timers currently open, innermost last
+std::vector<TracyCZoneCtx> tracyZones;
+#endif
+
+bool timersEnabled() {
+#ifdef POLYSCOPE_ENABLE_TRACY
+  return true;
+#else
+  return options::enableProfiling || options::dynamicResolution || tracing;
+#endif
+}
+
+size_t getTimerID(const std::string& name) {
+  auto it = timerIDs.find(name);
+  if (it != timerIDs.end()) return it->second;
+
+  size_t newID = timers.size();
+  timers.emplace_back();
+  timers.back().name = name;
+  timerIDs[name] = newID;
+  return newID;
+}
+
+void pushSample(std::deque<double>& samples, double val) {
+  samples.push_back(val);
+  while (samples.size() > windowSize) samples.pop_front();
+}
+
+RollingTime summarize(const std::deque<double>& samples) {
+  RollingTime result;
+  if (samples.empty()) return result;
+  result.lastMs = samples.back();
+  double sum = 0.;
+  for (double v : samples) {
+    sum += v;
+    result.maxMs = std::max(result.maxMs, v);
+  }
+  result.meanMs = sum / samples.size();
+  return result;
+}
+
+TimerStats statsForRecord(const TimerRecord& t) {
+  TimerStats stats;
+  stats.cpu = summarize(t.cpuSamples);
+  stats.gpu = summarize(t.gpuSamples);
+  stats.hasGPU = !t.gpuSamples.empty();
+  stats.callsPerFrame = t.lastCallsPerFrame;
+  return stats;
+}
+
+} // namespace
+
+ScopedTimer::ScopedTimer(const char* name, bool withGPU_) {
+  if (!timersEnabled()) return;
+  timerKey.assign(name);
+  begin(getTimerID(timerKey), withGPU_);
+}
+
+ScopedTimer::ScopedTimer(const std::string& name, bool withGPU_) {
+  if (!timersEnabled()) return;
+  begin(getTimerID(name), withGPU_);
+}
+
+ScopedTimer::ScopedTimer(const std::string& category, const std::string& name, bool withGPU_) {
+  if (!timersEnabled()) return;
+  timerKey.assign(category);
+  timerKey.push_back(' ');
+  timerKey.append(name);
+  begin(getTimerID(timerKey), withGPU_);
+}
+
+void ScopedTimer::begin(size_t timerID_, bool withGPU_) {
+  active = true;
+  timerID = timerID_;
+  withGPU = withGPU_ && render::engine != nullptr &&
+            (options::enableProfiling || options::dynamicResolution || tracing); // (not for Tracy alone)
+  if (withGPU) {
+    render::engine->beginGPUTimer(timerID, currentFrame);
+  }
+#ifdef POLYSCOPE_ENABLE_TRACY
+  const std::string& name = timers[timerID].name;
+  uint64_t srcloc = ___tracy_alloc_srcloc_name(0, "", 0, "", 0, name.c_str(), name.size(), 0);
+  tracyZones.push_back(___tracy_emit_zone_begin_alloc(srcloc, 1));
+#endif
+  start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer() {
+  if (!active) return;
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  if (withGPU) {
+    render::engine->endGPUTimer();
+  }
+#ifdef POLYSCOPE_ENABLE_TRACY
+  ___tracy_emit_zone_end(tracyZones.back());
+  tracyZones.pop_back();
+#endif
+  if (tracing) {
+    traceEvents.push_back(TraceEvent{timerID, steadyMicroseconds(start), 1000. * elapsed.count()});
+  }
+  TimerRecord& t = timers[timerID];
+  t.cpuFrameMs += elapsed.count();
+  t.callsThisFrame++;
+}
+
+void recordTime(const std::string& name, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end) {
+  if (!timersEnabled()) return;
+  size_t timerID = getTimerID(name);
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+  if (tracing) {
+    traceEvents.push_back(TraceEvent{timerID, steadyMicroseconds(start), 1000. * elapsed.count()});
+  }
+  TimerRecord& t = timers[timerID];
+  t.cpuFrameMs += elapsed.count();
+  t.callsThisFrame++;
+}
+
+InitPhaseTimer::InitPhaseTimer(const char* name_) : name(name_), start(std::chrono::steady_clock::now()) {}
+
+InitPhaseTimer::~InitPhaseTimer() {
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  InitPhaseTime phase;
+  phase.name = name;
+  phase.ms = elapsed.count();
+  initPhaseTimes.push_back(phase);
+}
+
+std::vector<InitPhaseTime> getInitPhaseTimes() { return initPhaseTimes; }
+
+std::map<std::string, TimerStats> getTimerStats() {
+  std::map<std::string, TimerStats> result;
+  for (const TimerRecord& t : timers) {
+    if (t.cpuSamples.empty() && t.gpuSamples.empty()) continue;
+    result[t.name] = statsForRecord(t);
+  }
+  return result;
+}
+
+TimerStats getTimerStats(const std::string& name) {
+  auto it = timerIDs.find(name);
+  if (it == timerIDs.end()) return TimerStats();
+  return statsForRecord(timers[it->second]);
+}
+
+void resetTimers() {
+  for (TimerRecord& t : timers) {
+    t.cpuFrameMs = 0.;
+    t.callsThisFrame = 0;
+    t.lastCallsPerFrame = 0;
+    t.cpuSamples.clear();
+    t.gpuSamples.clear();
+    t.gpuPendingFrames.clear();
+  }
+}
+
+void endFrame() {
+
+  // (counted first, so the bookkeeping below is not included)
+  uint64_t heapAllocations = getHeapAllocationCount();
+  lastFrameHeapAllocations = heapAllocations - heapAllocationsAtFrameStart;
+
+  // CPU timings are complete as soon as the frame is
+  FrameTimings* captured = nullptr;
+  if (capturingFrames) {
+    captured = &capturedFrames[currentFrame];
+    captured->frame = currentFrame;
+    captured->heapAllocations = lastFrameHeapAllocations;
+  }
+  for (TimerRecord& t : timers) {
+    if (t.callsThisFrame == 0) continue;
+    pushSample(t.cpuSamples, t.cpuFrameMs);
+    if (captured) captured->cpuMs[t.name] = t.cpuFrameMs;
+    t.lastCallsPerFrame = t.callsThisFrame;
+    t.cpuFrameMs = 0.;
+    t.callsThisFrame = 0;
+  }
+
+  if (tracing) {
+    double nowUs = steadyMicroseconds(std::chrono::steady_clock::now());
+    traceFrameEnds.emplace_back(currentFrame, nowUs);
+    tracePendingFrameEnds[currentFrame] = nowUs;
+  }
+#ifdef POLYSCOPE_ENABLE_TRACY
+  ___tracy_emit_frame_mark(nullptr);
+#endif
+
+  // GPU timings trickle in; a frame's total is final once no timers from it (or earlier) are still in flight
+  if (render::engine != nullptr) {
+    gpuResults.clear();
+    uint64_t oldestPendingFrame = render::engine->collectGPUTimers(gpuResults);
+    for (const render::GPUTimerResult& r : gpuResults) {
+      if (r.timerID >= timers.size()) continue;
+      timers[r.timerID].gpuPendingFrames[r.frame] += r.ms;
+    }
+    for (TimerRecord& t : timers) {
+      while (!t.gpuPendingFrames.empty() && t.gpuPendingFrames.begin()->first < oldestPendingFrame) {
+        pushSample(t.gpuSamples, t.gpuPendingFrames.begin()->second);
+        if (capturingFrames) {
+          auto it = capturedFrames.find(t.gpuPendingFrames.begin()->first);
+          if (it != capturedFrames.end()) it->second.gpuMs[t.name] = t.gpuPendingFrames.begin()->second;
+        }
+        if (tracing) {
+          auto it = tracePendingFrameEnds.find(t.gpuPendingFrames.begin()->first);
+          if (it != tracePendingFrameEnds.end()) {
+            size_t id = &t - &timers[0];
+            traceCounters.push_back(TraceCounter{id, it->second, t.gpuPendingFrames.begin()->second});
+          }
+        }
+        t.gpuPendingFrames.erase(t.gpuPendingFrames.begin());
+      }
+    }
+    tracePendingFrameEnds.erase(tracePendingFrameEnds.begin(), tracePendingFrameEnds.lower_bound(oldestPendingFrame));
+  }
+
+  currentFrame++;
+  heapAllocationsAtFrameStart = getHeapAllocationCount();
+}
+
+void beginFrameCapture() {
+  capturingFrames = true;
+  capturedFrames.clear();
+}
+
+std::vector<FrameTimings> endFrameCapture() {
+  std::vector<FrameTimings> result;
+  result.reserve(capturedFrames.size());
+  for (std::pair<const uint64_t, FrameTimings>& entry : capturedFrames) {
+    result.push_back(std::move(entry.second));
+  }
+  capturingFrames = false;
+  capturedFrames.clear();
+  return result;
+}
+
+void beginTrace() {
+  tracing = true;
+  traceEvents.clear();
+  traceCounters.clear();
+  traceFrameEnds.clear();
+  tracePendingFrameEnds.clear();
+}
+
+bool isTracing() { return tracing; }
+
+void endTrace(std::string filename) {
+  if (!tracing) {
+    exception("endTrace() called without beginTrace()");
+    return;
+  }
+  tracing = false;
+
+#ifdef _WIN32
+  int pid = _getpid();
+#else
+  int pid = getpid();
+#endif
+
+  std::ofstream outFile(filename);
+  if (!outFile) {
+    exception("could not open trace file " + filename + " for writing");
+    return;
+  }
+
+  // Written by hand rather than as one json object, since traces can hold millions of events
+  outFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  outFile << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid
+          << ",\"tid\":0,\"args\":{\"name\":\"polyscope\"}}";
+  outFile.precision(3);
+  outFile << std::fixed;
+  for (const TraceEvent& e : traceEvents) {
+    outFile << ",\n{\"ph\":\"X\",\"name\":" << json(timers[e.timerID].name).dump() << ",\"cat\":\"polyscope\",\"pid\":"
+            << pid << ",\"tid\":0,\"ts\":" << e.startUs << ",\"dur\":" << e.durationUs << "}";
+  }
+  for (const std::pair<uint64_t, double>& f : traceFrameEnds) {
+    outFile << ",\n{\"ph\":\"i\",\"name\":\"frame " << f.first << "\",\"cat\":\"polyscope\",\"s\":\"p\",\"pid\":" << pid
+            << ",\"tid\":0,\"ts\":" << f.second << "}";
+  }
+  for (const TraceCounter& c : traceCounters) {
+    outFile << ",\n{\"ph\":\"C\",\"name\":" << json("GPU " + timers[c.timerID].name).dump()
+            << ",\"cat\":\"polyscope\",\"pid\":" << pid << ",\"tid\":0,\"ts\":" << c.timeUs
+            << ",\"args\":{\"ms\":" << c.gpuMs << "}}";
+  }
+  outFile << "\n]}\n";
+
+  traceEvents.clear();
+  traceCounters.clear();
+  traceFrameEnds.clear();
+  tracePendingFrameEnds.clear();
+}
+
+uint64_t getFrameIndex() { return currentFrame; }
+
+uint64_t getLastFrameHeapAllocations() { return lastFrameHeapAllocations; }
+
+void buildProfilingGui() {
+
+  ImGui::Checkbox("Enable profiling", &options::enableProfiling);
+  ImGui::SameLine();
+  if (ImGui::Button("Reset")) {
+    resetTimers();
+  }
+
+  if (heapAllocationTrackingEnabled()) {
+    ImGui::Text("heap allocations last frame: %llu", static_cast<unsigned long long>(lastFrameHeapAllocations));
+  }
+
+  if (!initPhaseTimes.empty() && ImGui::TreeNode("init")) {
+    double totalMs = 0.;
+    for (const InitPhaseTime& p : initPhaseTimes) {
+      ImGui::Text("%s: %.2f ms", p.name.c_str(), p.ms);
+      totalMs += p.ms;
+    }
+    ImGui::Text("total: %.2f ms", totalMs);
+    ImGui::TreePop();
+  }
+
+  std::map<std::string, TimerStats> stats = getTimerStats();
+  if (stats.empty()) {
+    ImGui::TextUnformatted("no timings recorded");
+    return;
+  }
+
+  ImGui::TextUnformatted("times in ms, mean / max over recent frames");
+  ImGui::Columns(4);
+  ImGui::SetColumnWidth(0, ImGui::GetWindowWidth() / 2);
+  ImGui::TextUnformatted("timer");
+  ImGui::NextColumn();
+  ImGui::TextUnformatted("calls");
+  ImGui::NextColumn();
+  ImGui::TextUnformatted("CPU");
+  ImGui::NextColumn();
+  ImGui::TextUnformatted("GPU");
+  ImGui::NextColumn();
+  ImGui::Separator();
+  for (const std::pair<const std::string, TimerStats>& entry : stats) {
+    const TimerStats& s = entry.second;
+    ImGui::TextUnformatted(entry.first.c_str());
+    ImGui::NextColumn();
+    ImGui::Text("%zu", s.callsPerFrame);
+    ImGui::NextColumn();
+    ImGui::Text("%.2f / %.2f", s.cpu.meanMs, s.cpu.maxMs);
+    ImGui::NextColumn();
+    if (s.hasGPU) {
+      ImGui::Text("%.2f / %.2f", s.gpu.meanMs, s.gpu.maxMs);
+    }
+    ImGui::NextColumn();
+  }
+  ImGui::Columns(1);
+}
+
+} // namespace profiling
+} // namespace polyscope
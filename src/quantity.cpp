@@ -5,6 +5,9 @@
 #include "imgui.h"
 
 #include "polyscope/messages.h"
+#include "polyscope/options.h"
+#include "polyscope/profiling.h"
+#include "polyscope/render/managed_buffer.h"
 #include "polyscope/structure.h"
 
 namespace polyscope {
@@ -13,7 +16,8 @@ namespace polyscope {
 // (subclasses could be a structure-specific quantity or a floating quantity)
 
 Quantity::Quantity(std::string name_, Structure& parentStructure_)
-    : parent(parentStructure_), name(name_), enabled(parent.typeName() + "#" + parent.name + "#" + name, false) {
+    : parent(parentStructure_), name(name_), uniquePrefixStr(parent.uniquePrefix() + name_ + "#"),
+      enabled(parent.uniquePrefix() + name_, false) {
   validateName(name);
 }
 
@@ -33,8 +37,23 @@ bool Quantity::isEnabled() { return enabled.get(); }
 
 void Quantity::refresh() { requestRedraw(); }
 
-std::string Quantity::niceName() { return name; }
+void Quantity::refreshMaterial() {}
+
+void Quantity::requestRedraw() { parent.requestRedraw(); }
+
+void Quantity::updateDataCompression() {
+  if (!isEnabled()) {
+    if (!options::compressDisabledQuantities || dataCompressed) return;
+    refresh(); // drops the programs, which hold on to the render buffers
+    render::compressManagedBufferHostData(uniquePrefix());
+    dataCompressed = true;
+  } else if (dataCompressed) {
+    profiling::ScopedTimer timer("enable compressed quantity");
+    render::decompressManagedBufferHostData(uniquePrefix());
+    dataCompressed = false;
+  }
+}
 
-std::string Quantity::uniquePrefix() { return parent.uniquePrefix() + name + "#"; }
+std::string Quantity::niceName() { return name; }
 
 } // namespace polyscope
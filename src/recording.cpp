@@ -0,0 +1,244 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/recording.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/options.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/view.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+namespace polyscope {
+
+namespace {
+
+// Frames waiting for the writer; main loop blocks once this many are queued
+const size_t maxQueuedFrames = 8;
+
+struct RecordingFrame {
+  std::vector<unsigned char> pixels;
+  size_t copies = 1; // number of output frames this one stands for
+};
+
+struct Recording {
+  // exactly one of these is set
+  FILE* pipe = nullptr;
+  std::function<void(const std::vector<unsigned char>&, int, int)> callback;
+
+  int fps = 30;
+  bool withUI = false;
+  int width = 0;
+  int height = 0;
+  std::chrono::steady_clock::time_point startTime;
+  size_t framesEmitted = 0;
+  bool warnedSize = false;
+
+  // shared with the writer thread
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<RecordingFrame> queue;
+  bool finished = false;
+  bool failed = false;
+  std::thread writer;
+};
+
+std::unique_ptr<Recording> recording;
+
+#ifdef _WIN32
+FILE* openPipe(const std::string& command) { return _popen(command.c_str(), "wb"); }
+int closePipe(FILE* pipe) { return _pclose(pipe); }
+#else
+FILE* openPipe(const std::string& command) { return popen(command.c_str(), "w"); }
+int closePipe(FILE* pipe) { return pclose(pipe); }
+#endif
+
+bool writeFrame(Recording& rec, const std::vector<unsigned char>& pixels) {
+  if (rec.callback) {
+    rec.callback(pixels, rec.width, rec.height);
+    return true;
+  }
+  return std::fwrite(pixels.data(), 1, pixels.size(), rec.pipe) == pixels.size();
+}
+
+void writerLoop(Recording* rec) {
+
+#ifndef _WIN32
+  // if the encoder exits early, get an error from fwrite() rather than a SIGPIPE killing the process
+  sigset_t sigpipeSet;
+  sigemptyset(&sigpipeSet);
+  sigaddset(&sigpipeSet, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipeSet, nullptr);
+#endif
+
+  while (true) {
+    RecordingFrame frame;
+    {
+      std::unique_lock<std::mutex> lock(rec->mutex);
+      rec->cv.wait(lock, [&]() { return !rec->queue.empty() || rec->finished; });
+      if (rec->queue.empty()) return;
+      frame = std::move(rec->queue.front());
+      rec->queue.pop_front();
+    }
+    rec->cv.notify_all();
+
+    for (size_t i = 0; i < frame.copies; i++) {
+      if (!writeFrame(*rec, frame.pixels)) {
+        std::lock_guard<std::mutex> lock(rec->mutex);
+        rec->failed = true;
+        rec->queue.clear();
+        rec->cv.notify_all();
+        return;
+      }
+    }
+  }
+}
+
+void queueFrame(Recording& rec, RecordingFrame frame) {
+  {
+    std::unique_lock<std::mutex> lock(rec.mutex);
+    rec.cv.wait(lock, [&]() { return rec.queue.size() < maxQueuedFrames || rec.failed; });
+    if (rec.failed) return;
+    rec.queue.push_back(std::move(frame));
+  }
+  rec.cv.notify_all();
+}
+
+void beginRecording(std::unique_ptr<Recording> rec) {
+  rec->width = view::bufferWidth;
+  rec->height = view::bufferHeight;
+  rec->startTime = std::chrono::steady_clock::now();
+  rec->writer = std::thread(writerLoop, rec.get());
+  recording = std::move(rec);
+}
+
+} // namespace
+
+void startRecording(std::string filename, int fps, bool withUI) {
+  if (isRecording()) {
+    exception("startRecording() called while already recording");
+    return;
+  }
+  if (fps <= 0) {
+    exception("recording fps must be positive");
+    return;
+  }
+
+  std::unique_ptr<Recording> rec(new Recording());
+  rec->fps = fps;
+  rec->withUI = withUI;
+
+  // ffmpeg reads raw frames from stdin; they are bottom row first, so flip them back (and pad to even dimensions, which
+  // most codecs require)
+  std::string command = options::ffmpegExecutable + " -loglevel error -y -f rawvideo -pix_fmt rgba -s " +
+                        std::to_string(view::bufferWidth) + "x" + std::to_string(view::bufferHeight) + " -r " +
+                        std::to_string(fps) + " -i - -vf \"vflip,pad=ceil(iw/2)*2:ceil(ih/2)*2\" " +
+                        options::recordingEncoderArgs + " \"" + filename + "\"";
+  rec->pipe = openPipe(command);
+  if (rec->pipe == nullptr) {
+    exception("failed to launch encoder for recording: " + command);
+    return;
+  }
+
+  beginRecording(std::move(rec));
+}
+
+void startRecording(std::function<void(const std::vector<unsigned char>&, int, int)> frameCallback, int fps,
+                    bool withUI) {
+  if (isRecording()) {
+    exception("startRecording() called while already recording");
+    return;
+  }
+  if (fps <= 0) {
+    exception("recording fps must be positive");
+    return;
+  }
+
+  std::unique_ptr<Recording> rec(new Recording());
+  rec->callback = frameCallback;
+  rec->fps = fps;
+  rec->withUI = withUI;
+  beginRecording(std::move(rec));
+}
+
+void stopRecording() {
+  if (!isRecording()) return;
+
+  // deliver any frames still being read back
+  render::engine->processPendingReadbacks(true);
+
+  {
+    std::lock_guard<std::mutex> lock(recording->mutex);
+    recording->finished = true;
+  }
+  recording->cv.notify_all();
+  recording->writer.join();
+
+  bool failed = recording->failed;
+  if (recording->pipe != nullptr) {
+    failed = (closePipe(recording->pipe) != 0) || failed;
+  }
+  recording.reset();
+
+  if (failed) {
+    warning("recording encoder failed", "the video may be incomplete");
+  }
+}
+
+bool isRecording() { return recording != nullptr; }
+
+namespace internal {
+
+void captureRecordingFrame(bool uiDrawn) {
+  if (!recording || recording->withUI != uiDrawn) return;
+
+  {
+    std::lock_guard<std::mutex> lock(recording->mutex);
+    if (recording->failed) {
+      // the writer has stopped, clean up
+      recording->finished = true;
+    }
+  }
+  if (recording->finished) {
+    stopRecording();
+    return;
+  }
+
+  // Emit however many output frames have come due since the last one
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - recording->startTime;
+  size_t framesDue = static_cast<size_t>(elapsed.count() * recording->fps) + 1;
+  if (framesDue <= recording->framesEmitted) return;
+  size_t copies = framesDue - recording->framesEmitted;
+  recording->framesEmitted = framesDue;
+
+  if (view::bufferWidth != recording->width || view::bufferHeight != recording->height) {
+    if (!recording->warnedSize) {
+      warning("window size changed while recording", "frames are dropped until it is restored");
+      recording->warnedSize = true;
+    }
+    return;
+  }
+
+  Recording* rec = recording.get();
+  render::engine->displayBuffer->readBufferAsync([=](std::vector<unsigned char> buff) {
+    RecordingFrame frame;
+    frame.pixels.swap(buff);
+    frame.copies = copies;
+    queueFrame(*rec, std::move(frame));
+  });
+}
+
+} // namespace internal
+
+} // namespace polyscope
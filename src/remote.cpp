@@ -0,0 +1,588 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/remote.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/screenshot.h"
+#include "polyscope/view.h"
+
+#include "imgui.h"
+#include "json/json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace polyscope {
+
+namespace {
+
+#ifndef _WIN32
+
+// The page served at /, which shows the frames and sends input back
+const char* clientPage = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>Polyscope</title>
+<style>body{margin:0;overflow:hidden;background:#000}img{display:block;width:100vw;height:100vh}</style></head>
+<body><img id="view" tabindex="0" draggable="false">
+<script>
+const view = document.getElementById("view");
+const ws = new WebSocket("ws://" + location.host + "/ws");
+ws.binaryType = "blob";
+let shown = null;
+ws.onmessage = (e) => {
+  const url = URL.createObjectURL(e.data);
+  view.onload = () => { if (shown) URL.revokeObjectURL(shown); shown = url; };
+  view.src = url;
+};
+const send = (o) => { if (ws.readyState === 1) ws.send(JSON.stringify(o)); };
+const resize = () => send({type: "resize", width: Math.round(innerWidth * devicePixelRatio),
+                           height: Math.round(innerHeight * devicePixelRatio)});
+ws.onopen = resize;
+addEventListener("resize", resize);
+const pos = (e) => {
+  const r = view.getBoundingClientRect();
+  send({type: "mousemove", x: (e.clientX - r.left) / r.width, y: (e.clientY - r.top) / r.height});
+};
+const buttons = [0, 2, 1]; // browser left, middle, right --> ImGui left, right, middle
+const button = (e, down) => send({type: "mousebutton", button: buttons[e.button], down: down});
+view.addEventListener("mousemove", pos);
+view.addEventListener("mousedown", (e) => { pos(e); button(e, true); });
+addEventListener("mouseup", (e) => button(e, false));
+view.addEventListener("wheel", (e) => {
+  e.preventDefault();
+  send({type: "wheel", x: -e.deltaX / 100, y: -e.deltaY / 100});
+});
+view.addEventListener("contextmenu", (e) => e.preventDefault());
+const key = (e, down) => { e.preventDefault(); send({type: "key", key: e.key, down: down});
+                           if (down && e.key.length === 1) send({type: "text", text: e.key}); };
+view.addEventListener("keydown", (e) => key(e, true));
+view.addEventListener("keyup", (e) => key(e, false));
+view.focus();
+</script></body></html>
+)HTML";
+
+// == Handshake helpers (RFC 6455 needs a SHA-1 of the client key)
+
+std::array<unsigned char, 20> sha1(const std::string& message) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  std::vector<unsigned char> data(message.begin(), message.end());
+  uint64_t bitLength = static_cast<uint64_t>(data.size()) * 8;
+  data.push_back(0x80);
+  while (data.size() % 64 != 56) data.push_back(0);
+  for (int i = 7; i >= 0; i--) data.push_back(static_cast<unsigned char>(bitLength >> (8 * i)));
+
+  auto rotl = [](uint32_t v, int s) { return (v << s) | (v >> (32 - s)); };
+  for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+      w[i] = (uint32_t(data[chunk + 4 * i]) << 24) | (uint32_t(data[chunk + 4 * i + 1]) << 16) |
+             (uint32_t(data[chunk + 4 * i + 2]) << 8) | uint32_t(data[chunk + 4 * i + 3]);
+    }
+    for (int i = 16; i < 80; i++) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+
+  std::array<unsigned char, 20> digest;
+  for (int i = 0; i < 20; i++) digest[i] = static_cast<unsigned char>(h[i / 4] >> (24 - 8 * (i % 4)));
+  return digest;
+}
+
+std::string base64(const unsigned char* data, size_t n) {
+  const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (size_t i = 0; i < n; i += 3) {
+    uint32_t v = uint32_t(data[i]) << 16;
+    if (i + 1 < n) v |= uint32_t(data[i + 1]) << 8;
+    if (i + 2 < n) v |= data[i + 2];
+    out.push_back(table[(v >> 18) & 63]);
+    out.push_back(table[(v >> 12) & 63]);
+    out.push_back(i + 1 < n ? table[(v >> 6) & 63] : '=');
+    out.push_back(i + 2 < n ? table[v & 63] : '=');
+  }
+  return out;
+}
+
+// The value of an HTTP header, or "" if absent (header names are case-insensitive)
+std::string headerValue(const std::string& request, std::string name) {
+  std::string lower = request;
+  std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+  size_t start = lower.find("\r\n" + name + ":");
+  if (start == std::string::npos) return "";
+  start += name.size() + 3;
+  size_t end = request.find("\r\n", start);
+  std::string value = request.substr(start, end - start);
+  value.erase(0, value.find_first_not_of(" \t"));
+  value.erase(value.find_last_not_of(" \t") + 1);
+  return value;
+}
+
+#ifdef MSG_NOSIGNAL
+const int sendFlags = MSG_NOSIGNAL;
+#else
+const int sendFlags = 0;
+#endif
+
+bool sendAll(int fd, const void* data, size_t n) {
+  const char* bytes = static_cast<const char*>(data);
+  while (n > 0) {
+    ssize_t sent = ::send(fd, bytes, n, sendFlags);
+    if (sent <= 0) return false;
+    bytes += sent;
+    n -= sent;
+  }
+  return true;
+}
+
+bool recvAll(int fd, void* data, size_t n) {
+  char* bytes = static_cast<char*>(data);
+  while (n > 0) {
+    ssize_t got = ::recv(fd, bytes, n, 0);
+    if (got <= 0) return false;
+    bytes += got;
+    n -= got;
+  }
+  return true;
+}
+
+struct RemoteServer {
+  int listenFd = -1;
+  int fps = 30;
+  int jpegQuality = 80;
+  std::atomic<bool> stopping{false};
+
+  // The connected client. Written by the server thread; frames are sent by the encoder thread, under sendMutex.
+  std::mutex sendMutex;
+  int clientFd = -1;
+  std::atomic<bool> connected{false};
+
+  // Input from the client, waiting for the main loop
+  std::mutex inputMutex;
+  std::deque<json> input;
+  bool inputSinceFrame = false;
+
+  // The newest frame waiting to be encoded and sent
+  std::mutex frameMutex;
+  std::condition_variable frameCV;
+  std::vector<unsigned char> framePixels;
+  int frameWidth = 0;
+  int frameHeight = 0;
+  bool framePending = false;
+
+  // Main thread only
+  bool readbackInFlight = false;
+  std::chrono::steady_clock::time_point lastFrameTime;
+  uint64_t lastFrameSceneCount = 0;
+
+  std::thread serverThread;
+  std::thread encoderThread;
+};
+
+std::unique_ptr<RemoteServer> server;
+
+bool sendMessage(RemoteServer& s, unsigned char opcode, const void* data, size_t n) {
+  std::vector<unsigned char> header{static_cast<unsigned char>(0x80 | opcode)};
+  if (n < 126) {
+    header.push_back(static_cast<unsigned char>(n));
+  } else if (n < 65536) {
+    header.insert(header.end(), {126, static_cast<unsigned char>(n >> 8), static_cast<unsigned char>(n)});
+  } else {
+    header.push_back(127);
+    for (int i = 7; i >= 0; i--) header.push_back(static_cast<unsigned char>(static_cast<uint64_t>(n) >> (8 * i)));
+  }
+  std::lock_guard<std::mutex> lock(s.sendMutex);
+  if (s.clientFd < 0) return false;
+  return sendAll(s.clientFd, header.data(), header.size()) && sendAll(s.clientFd, data, n);
+}
+
+void dropClient(RemoteServer& s) {
+  std::lock_guard<std::mutex> lock(s.sendMutex);
+  if (s.clientFd >= 0) ::close(s.clientFd);
+  s.clientFd = -1;
+  s.connected = false;
+}
+
+// Read one HTTP request on a new connection, and either upgrade it to be the client or answer it and close it
+void acceptConnection(RemoteServer& s, int fd) {
+  timeval timeout{2, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+  int noSigpipe = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+#endif
+
+  std::string request;
+  char buf[1024];
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < 16384) {
+    ssize_t got = ::recv(fd, buf, sizeof(buf), 0);
+    if (got <= 0) {
+      ::close(fd);
+      return;
+    }
+    request.append(buf, got);
+  }
+
+  std::string key = headerValue(request, "Sec-WebSocket-Key");
+  if (!key.empty()) {
+    std::array<unsigned char, 20> digest = sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " +
+                           base64(digest.data(), digest.size()) + "\r\n\r\n";
+    if (!sendAll(fd, response.data(), response.size())) {
+      ::close(fd);
+      return;
+    }
+    timeval noTimeout{0, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &noTimeout, sizeof(noTimeout));
+
+    dropClient(s);
+    {
+      std::lock_guard<std::mutex> lock(s.sendMutex);
+      s.clientFd = fd;
+      s.connected = true;
+    }
+    render::engine->wakeEventWait();
+    return;
+  }
+
+  std::string response;
+  if (request.compare(0, 6, "GET / ") == 0) {
+    response = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: " +
+               std::to_string(std::string(clientPage).size()) + "\r\nConnection: close\r\n\r\n" + clientPage;
+  } else {
+    response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  }
+  sendAll(fd, response.data(), response.size());
+  ::close(fd);
+}
+
+// Read one WebSocket frame from the client. Returns false if the connection should be dropped.
+bool readClientFrame(RemoteServer& s, int fd, std::string& message) {
+  unsigned char header[2];
+  if (!recvAll(fd, header, 2)) return false;
+  bool fin = header[0] & 0x80;
+  unsigned char opcode = header[0] & 0x0F;
+  uint64_t n = header[1] & 0x7F;
+  if (n == 126) {
+    unsigned char ext[2];
+    if (!recvAll(fd, ext, 2)) return false;
+    n = (uint64_t(ext[0]) << 8) | ext[1];
+  } else if (n == 127) {
+    unsigned char ext[8];
+    if (!recvAll(fd, ext, 8)) return false;
+    n = 0;
+    for (int i = 0; i < 8; i++) n = (n << 8) | ext[i];
+  }
+  if (n > (1u << 24)) return false; // input events are small
+
+  unsigned char mask[4] = {0, 0, 0, 0};
+  if ((header[1] & 0x80) && !recvAll(fd, mask, 4)) return false;
+  std::string payload(n, '\0');
+  if (n > 0 && !recvAll(fd, &payload[0], n)) return false;
+  for (size_t i = 0; i < payload.size(); i++) payload[i] ^= mask[i % 4];
+
+  switch (opcode) {
+  case 0x0: // continuation
+  case 0x1: // text
+    message += payload;
+    if (!fin) return true;
+    try {
+      json event = json::parse(message);
+      std::lock_guard<std::mutex> lock(s.inputMutex);
+      s.input.push_back(event);
+    } catch (const std::exception&) {
+      // ignore anything which is not an event
+    }
+    message.clear();
+    render::engine->wakeEventWait();
+    return true;
+  case 0x8: // close
+    return false;
+  case 0x9: // ping
+    sendMessage(s, 0xA, payload.data(), payload.size());
+    return true;
+  default:
+    return true;
+  }
+}
+
+void serverLoop(RemoteServer* s) {
+  std::string message;
+  while (!s->stopping) {
+    int clientFd;
+    {
+      std::lock_guard<std::mutex> lock(s->sendMutex);
+      clientFd = s->clientFd;
+    }
+
+    pollfd fds[2] = {{s->listenFd, POLLIN, 0}, {clientFd, POLLIN, 0}};
+    int nReady = ::poll(fds, clientFd >= 0 ? 2 : 1, 100);
+    if (nReady <= 0) continue;
+
+    if (fds[0].revents & POLLIN) {
+      int fd = ::accept(s->listenFd, nullptr, nullptr);
+      if (fd >= 0) acceptConnection(*s, fd);
+      message.clear();
+      continue; // the client may have been replaced
+    }
+    if (clientFd >= 0 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+      if (!readClientFrame(*s, clientFd, message)) {
+        dropClient(*s);
+        message.clear();
+      }
+    }
+  }
+}
+
+void encoderLoop(RemoteServer* s) {
+  while (true) {
+    std::vector<unsigned char> pixels;
+    int w, h;
+    {
+      std::unique_lock<std::mutex> lock(s->frameMutex);
+      s->frameCV.wait(lock, [&]() { return s->framePending || s->stopping; });
+      if (s->stopping) return;
+      pixels.swap(s->framePixels);
+      w = s->frameWidth;
+      h = s->frameHeight;
+      s->framePending = false;
+    }
+
+    std::vector<unsigned char> jpeg = internal::encodeJPEG(pixels.data(), w, h, s->jpegQuality);
+    if (!sendMessage(*s, 0x2, jpeg.data(), jpeg.size())) {
+      dropClient(*s);
+    }
+  }
+}
+
+ImGuiKey imguiKeyFromName(const std::string& name) {
+  if (name.size() == 1) {
+    char c = static_cast<char>(::tolower(name[0]));
+    if (c >= 'a' && c <= 'z') return static_cast<ImGuiKey>(ImGuiKey_A + (c - 'a'));
+    if (c >= '0' && c <= '9') return static_cast<ImGuiKey>(ImGuiKey_0 + (c - '0'));
+    if (c == ' ') return ImGuiKey_Space;
+  }
+  if (name == "Shift") return ImGuiMod_Shift;
+  if (name == "Control") return ImGuiMod_Ctrl;
+  if (name == "Alt") return ImGuiMod_Alt;
+  if (name == "Meta") return ImGuiMod_Super;
+  if (name == "Enter") return ImGuiKey_Enter;
+  if (name == "Escape") return ImGuiKey_Escape;
+  if (name == "Backspace") return ImGuiKey_Backspace;
+  if (name == "Tab") return ImGuiKey_Tab;
+  if (name == "Delete") return ImGuiKey_Delete;
+  if (name == "Home") return ImGuiKey_Home;
+  if (name == "End") return ImGuiKey_End;
+  if (name == "ArrowLeft") return ImGuiKey_LeftArrow;
+  if (name == "ArrowRight") return ImGuiKey_RightArrow;
+  if (name == "ArrowUp") return ImGuiKey_UpArrow;
+  if (name == "ArrowDown") return ImGuiKey_DownArrow;
+  return ImGuiKey_None;
+}
+
+void applyInputEvent(const json& event) {
+  ImGuiIO& io = ImGui::GetIO();
+  std::string type = event.value("type", "");
+  if (type == "mousemove") {
+    io.AddMousePosEvent(event.value("x", 0.f) * view::windowWidth, event.value("y", 0.f) * view::windowHeight);
+  } else if (type == "mousebutton") {
+    int button = event.value("button", 0);
+    if (button >= 0 && button < ImGuiMouseButton_COUNT) io.AddMouseButtonEvent(button, event.value("down", false));
+  } else if (type == "wheel") {
+    io.AddMouseWheelEvent(event.value("x", 0.f), event.value("y", 0.f));
+  } else if (type == "key") {
+    ImGuiKey key = imguiKeyFromName(event.value("key", ""));
+    if (key != ImGuiKey_None) io.AddKeyEvent(key, event.value("down", false));
+  } else if (type == "text") {
+    io.AddInputCharactersUTF8(event.value("text", "").c_str());
+  } else if (type == "resize") {
+    int w = std::min(std::max(event.value("width", view::windowWidth), 16), 8192);
+    int h = std::min(std::max(event.value("height", view::windowHeight), 16), 8192);
+    if (w != view::windowWidth || h != view::windowHeight) view::setWindowSize(w, h);
+  }
+}
+
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+
+void startRemoteServer(int port, int fps, int jpegQuality) {
+  exception("the remote render server is not available on Windows");
+}
+void stopRemoteServer() {}
+bool isRemoteServerRunning() { return false; }
+bool hasRemoteClient() { return false; }
+
+namespace internal {
+void processRemoteInput() {}
+void captureRemoteFrame() {}
+} // namespace internal
+
+#else
+
+void startRemoteServer(int port, int fps, int jpegQuality) {
+  if (isRemoteServerRunning()) {
+    exception("startRemoteServer() called while the server is already running");
+    return;
+  }
+  if (fps <= 0) {
+    exception("remote server fps must be positive");
+    return;
+  }
+
+  std::unique_ptr<RemoteServer> s(new RemoteServer());
+  s->fps = fps;
+  s->jpegQuality = std::min(std::max(jpegQuality, 1), 100);
+
+  s->listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (s->listenFd < 0) {
+    exception("remote server could not create a socket");
+    return;
+  }
+  int reuse = 1;
+  setsockopt(s->listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  if (::bind(s->listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(s->listenFd, 4) != 0) {
+    ::close(s->listenFd);
+    exception("remote server could not listen on port " + std::to_string(port));
+    return;
+  }
+
+  internal::prepareImageEncoding();
+  s->lastFrameTime = std::chrono::steady_clock::now();
+  s->serverThread = std::thread(serverLoop, s.get());
+  s->encoderThread = std::thread(encoderLoop, s.get());
+  server = std::move(s);
+  info("Polyscope remote server listening on port " + std::to_string(port));
+}
+
+void stopRemoteServer() {
+  if (!isRemoteServerRunning()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(server->frameMutex);
+    server->stopping = true;
+  }
+  server->frameCV.notify_all();
+  server->serverThread.join();
+  server->encoderThread.join();
+  dropClient(*server);
+  ::close(server->listenFd);
+
+  // a readback may still be in flight, holding on to the server
+  render::engine->processPendingReadbacks(true);
+  server.reset();
+}
+
+bool isRemoteServerRunning() { return server != nullptr; }
+
+bool hasRemoteClient() { return server != nullptr && server->connected; }
+
+namespace internal {
+
+void processRemoteInput() {
+  if (!server) return;
+
+  std::deque<json> events;
+  {
+    std::lock_guard<std::mutex> lock(server->inputMutex);
+    events.swap(server->input);
+  }
+  if (events.empty()) return;
+  server->inputSinceFrame = true;
+  for (const json& event : events) {
+    applyInputEvent(event);
+  }
+}
+
+void captureRemoteFrame() {
+  if (!server || !server->connected || server->readbackInFlight) return;
+
+  // Send at most fps frames per second, and only if something may have changed (or once a second anyway)
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - server->lastFrameTime).count();
+  if (elapsed < 1. / server->fps) return;
+  bool changed = server->inputSinceFrame || server->lastFrameSceneCount != internal::renderSceneCount;
+  if (!changed && elapsed < 1.) return;
+  server->lastFrameTime = now;
+  server->lastFrameSceneCount = internal::renderSceneCount;
+  server->inputSinceFrame = false;
+
+  RemoteServer* s = server.get();
+  int w = view::bufferWidth;
+  int h = view::bufferHeight;
+  s->readbackInFlight = true;
+  render::engine->displayBuffer->readBufferAsync([=](std::vector<unsigned char> pixels) {
+    s->readbackInFlight = false;
+    if (pixels.size() != static_cast<size_t>(w) * h * 4) return;
+    {
+      std::lock_guard<std::mutex> lock(s->frameMutex);
+      s->framePixels.swap(pixels);
+      s->frameWidth = w;
+      s->frameHeight = h;
+      s->framePending = true;
+    }
+    s->frameCV.notify_all();
+  });
+}
+
+} // namespace internal
+
+#endif
+
+} // namespace polyscope
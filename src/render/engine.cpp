@@ -3,13 +3,20 @@
 
 #include "polyscope/render/engine.h"
 
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/profiling.h"
 #include "polyscope/render/colormap_defs.h"
 #include "polyscope/render/material_defs.h"
 
+#include "glm/gtc/packing.hpp"
 #include "imgui.h"
 #include "stb_image.h"
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
 namespace polyscope {
 
 int dimension(const TextureFormat& x) {
@@ -59,6 +66,34 @@ std::string renderDataTypeName(const RenderDataType& r) {
   return "";
 }
 
+size_t renderDataTypeSizeInBytes(const RenderDataType& r) {
+  switch (r) {
+  case RenderDataType::Vector2Float:
+    return 2 * sizeof(float);
+  case RenderDataType::Vector3Float:
+    return 3 * sizeof(float);
+  case RenderDataType::Vector4Float:
+    return 4 * sizeof(float);
+  case RenderDataType::Matrix44Float:
+    return 16 * sizeof(float);
+  case RenderDataType::Float:
+    return sizeof(float);
+  case RenderDataType::Int:
+    return sizeof(int32_t);
+  case RenderDataType::UInt:
+    return sizeof(uint32_t);
+  case RenderDataType::Index:
+    return sizeof(uint32_t);
+  case RenderDataType::Vector2UInt:
+    return 2 * sizeof(uint32_t);
+  case RenderDataType::Vector3UInt:
+    return 3 * sizeof(uint32_t);
+  case RenderDataType::Vector4UInt:
+    return 4 * sizeof(uint32_t);
+  }
+  return 0;
+}
+
 int renderDataTypeCountCompatbility(const RenderDataType r1, const RenderDataType r2) {
 
   if (r1 == r2) return 1;
@@ -84,6 +119,10 @@ std::string modeName(const TransparencyMode& m) {
     return "Simple";
   case TransparencyMode::Pretty:
     return "Pretty";
+  case TransparencyMode::WeightedBlended:
+    return "Weighted Blended";
+  case TransparencyMode::Sorted:
+    return "Sorted";
   }
   return "";
 }
@@ -102,18 +141,192 @@ std::string getImageOriginRule(ImageOrigin imageOrigin) {
 
 namespace render {
 
+namespace {
+// All live buffers, for memory accounting. These are intentionally leaked, so that buffers which are destroyed during
+// static destruction can still unregister themselves.
+std::unordered_set<const AttributeBuffer*>& liveAttributeBuffers() {
+  static std::unordered_set<const AttributeBuffer*>* buffers = new std::unordered_set<const AttributeBuffer*>();
+  return *buffers;
+}
+std::unordered_set<const TextureBuffer*>& liveTextureBuffers() {
+  static std::unordered_set<const TextureBuffer*>* buffers = new std::unordered_set<const TextureBuffer*>();
+  return *buffers;
+}
+std::unordered_set<const RenderBuffer*>& liveRenderBuffers() {
+  static std::unordered_set<const RenderBuffer*>* buffers = new std::unordered_set<const RenderBuffer*>();
+  return *buffers;
+}
+
+size_t textureFormatSizeInBytes(TextureFormat format) {
+  switch (format) {
+  case TextureFormat::RGB8:
+    return 3;
+  case TextureFormat::RGBA8:
+    return 4;
+  case TextureFormat::RG16F:
+    return 4;
+  case TextureFormat::RGB16F:
+    return 6;
+  case TextureFormat::RGBA16F:
+    return 8;
+  case TextureFormat::RGBA32F:
+    return 16;
+  case TextureFormat::RGB32F:
+    return 12;
+  case TextureFormat::R32F:
+    return 4;
+  case TextureFormat::R16F:
+    return 2;
+  case TextureFormat::DEPTH24:
+    return 4; // usually padded
+  }
+  return 0;
+}
+
+size_t renderBufferTypeSizeInBytes(RenderBufferType type) {
+  switch (type) {
+  case RenderBufferType::Color:
+    return 4; // usually padded
+  case RenderBufferType::ColorAlpha:
+    return 4;
+  case RenderBufferType::Depth:
+    return 4;
+  case RenderBufferType::Float4:
+    return 16;
+  }
+  return 0;
+}
+
+bool hasPrefix(const std::string& str, const std::string& prefix) {
+  return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+} // namespace
+
+GPUMemoryUsage getGPUMemoryUsage() { return getGPUMemoryUsage(""); }
+
+GPUMemoryUsage getGPUMemoryUsage(const std::string& ownerPrefix) {
+  GPUMemoryUsage usage;
+  for (const AttributeBuffer* b : liveAttributeBuffers()) {
+    if (hasPrefix(b->getMemoryOwner(), ownerPrefix)) usage.attributeBytes += b->getSizeInBytes();
+  }
+  for (const TextureBuffer* b : liveTextureBuffers()) {
+    if (hasPrefix(b->getMemoryOwner(), ownerPrefix)) usage.textureBytes += b->getSizeInBytes();
+  }
+  for (const RenderBuffer* b : liveRenderBuffers()) {
+    if (hasPrefix(b->getMemoryOwner(), ownerPrefix)) usage.renderBufferBytes += b->getSizeInBytes();
+  }
+  return usage;
+}
+
 AttributeBuffer::AttributeBuffer(RenderDataType dataType_, int arrayCount_)
-    : dataType(dataType_), arrayCount(arrayCount_), uniqueID(render::engine->getNextUniqueID()) {}
+    : dataType(dataType_), arrayCount(arrayCount_), uniqueID(render::engine->getNextUniqueID()) {
+  liveAttributeBuffers().insert(this);
+}
+
+AttributeBuffer::~AttributeBuffer() { liveAttributeBuffers().erase(this); }
 
-AttributeBuffer::~AttributeBuffer() {}
+void AttributeBuffer::setUpdatedDataSize(int64_t newDataSize) {
+  if (newDataSize != dataSize && !resizable) exception("updated data must have same size");
+  dataSize = newDataSize;
+}
+
+template <typename T>
+void AttributeBuffer::appendData(const std::vector<T>& data, size_t dataStart, size_t dataEnd) {
+  if (dataStart > dataEnd || dataEnd > data.size()) exception("bad data range in appendData()");
+  if (dataStart == dataEnd) return;
 
-TextureBuffer::TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_)
-    : dim(dim_), format(format_), sizeX(sizeX_), sizeY(sizeY_), uniqueID(render::engine->getNextUniqueID()) {
+  if (!isSet()) {
+    std::vector<T> initData(data.begin() + dataStart, data.begin() + dataEnd);
+    setData(initData);
+    return;
+  }
+
+  if (!resizable) exception("can only append to a resizable buffer");
+  size_t oldCount = dataSize / arrayCount; // in units of T
+  resize(oldCount + (dataEnd - dataStart));
+  setDataRange(data, dataStart, dataEnd, oldCount);
+}
+
+// clang-format off
+template void AttributeBuffer::appendData(const std::vector<glm::vec2>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<glm::vec3>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<glm::vec4>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<float>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<double>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<int32_t>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<uint32_t>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<glm::uvec2>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<glm::uvec3>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<glm::uvec4>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t dataEnd);
+template void AttributeBuffer::appendData(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t dataEnd);
+// clang-format on
+
+size_t AttributeBuffer::getSizeInBytes() const {
+  if (!isSet()) return 0;
+  return static_cast<size_t>(dataSize) * renderDataTypeSizeInBytes(dataType);
+}
+
+namespace {
+template <typename T>
+void deliverRange(const std::vector<T>& values, std::function<void(const void*)>& callback) {
+  callback(values.empty() ? nullptr : &values.front());
+}
+} // namespace
+
+void AttributeBuffer::getDataRangeRawAsync(size_t ind, size_t count, std::function<void(const void*)> callback) {
+  // no async support, read now
+  switch (dataType) {
+  case RenderDataType::Float:
+    deliverRange(getDataRange_float(ind, count), callback);
+    break;
+  case RenderDataType::Vector2Float:
+    deliverRange(getDataRange_vec2(ind, count), callback);
+    break;
+  case RenderDataType::Vector3Float:
+    deliverRange(getDataRange_vec3(ind, count), callback);
+    break;
+  case RenderDataType::Vector4Float:
+    deliverRange(getDataRange_vec4(ind, count), callback);
+    break;
+  case RenderDataType::Int:
+    deliverRange(getDataRange_int(ind, count), callback);
+    break;
+  case RenderDataType::UInt:
+  case RenderDataType::Index:
+    deliverRange(getDataRange_uint32(ind, count), callback);
+    break;
+  case RenderDataType::Vector2UInt:
+    deliverRange(getDataRange_uvec2(ind, count), callback);
+    break;
+  case RenderDataType::Vector3UInt:
+    deliverRange(getDataRange_uvec3(ind, count), callback);
+    break;
+  case RenderDataType::Vector4UInt:
+    deliverRange(getDataRange_uvec4(ind, count), callback);
+    break;
+  default:
+    exception("cannot read back attribute buffers of type " + renderDataTypeName(dataType));
+    break;
+  }
+}
+
+TextureBuffer::TextureBuffer(int dim_, TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_,
+                             unsigned int sizeZ_)
+    : dim(dim_), format(format_), sizeX(sizeX_), sizeY(sizeY_), sizeZ(sizeZ_),
+      uniqueID(render::engine->getNextUniqueID()) {
   if (sizeX > (1 << 22)) exception("OpenGL error: invalid texture dimensions");
   if (dim > 1 && sizeY > (1 << 22)) exception("OpenGL error: invalid texture dimensions");
+  if (dim > 2 && sizeZ > (1 << 22)) exception("OpenGL error: invalid texture dimensions");
+  liveTextureBuffers().insert(this);
 }
 
-TextureBuffer::~TextureBuffer() {}
+TextureBuffer::~TextureBuffer() { liveTextureBuffers().erase(this); }
+
+size_t TextureBuffer::getSizeInBytes() const {
+  return static_cast<size_t>(getTotalSize()) * textureFormatSizeInBytes(format);
+}
 
 void TextureBuffer::setFilterMode(FilterMode newMode) {}
 
@@ -130,15 +343,46 @@ unsigned int TextureBuffer::getTotalSize() const {
   case 2:
     return getSizeX() * getSizeY();
   case 3:
-    exception("not implemented");
-    return -1;
+    return getSizeX() * getSizeY() * getSizeZ();
   }
   return -1;
 }
 
+void TextureBuffer::checkRegionInBounds(unsigned int xStart, unsigned int yStart, unsigned int w,
+                                        unsigned int h) const {
+  if (dim != 2) {
+    exception("texture region updates are only supported for 2D textures");
+  }
+  if (xStart + w > sizeX || yStart + h > sizeY) {
+    exception("texture region [" + std::to_string(xStart) + "," + std::to_string(xStart + w) + ")x[" +
+              std::to_string(yStart) + "," + std::to_string(yStart + h) + ") is out of bounds for a texture of size " +
+              std::to_string(sizeX) + "x" + std::to_string(sizeY));
+  }
+}
+
+void TextureBuffer::checkRegionInBounds3D(unsigned int xStart, unsigned int yStart, unsigned int zStart,
+                                          unsigned int w, unsigned int h, unsigned int d) const {
+  if (dim != 3) {
+    exception("3D texture region updates are only supported for 3D textures");
+  }
+  if (xStart + w > sizeX || yStart + h > sizeY || zStart + d > sizeZ) {
+    exception("texture region starting at [" + std::to_string(xStart) + "," + std::to_string(yStart) + "," +
+              std::to_string(zStart) + "] of size " + std::to_string(w) + "x" + std::to_string(h) + "x" +
+              std::to_string(d) + " is out of bounds for a texture of size " + std::to_string(sizeX) + "x" +
+              std::to_string(sizeY) + "x" + std::to_string(sizeZ));
+  }
+}
+
 RenderBuffer::RenderBuffer(RenderBufferType type_, unsigned int sizeX_, unsigned int sizeY_)
     : type(type_), sizeX(sizeX_), sizeY(sizeY_), uniqueID(render::engine->getNextUniqueID()) {
   if (sizeX > (1 << 22) || sizeY > (1 << 22)) exception("OpenGL error: invalid renderbuffer dimensions");
+  liveRenderBuffers().insert(this);
+}
+
+RenderBuffer::~RenderBuffer() { liveRenderBuffers().erase(this); }
+
+size_t RenderBuffer::getSizeInBytes() const {
+  return static_cast<size_t>(sizeX) * sizeY * renderBufferTypeSizeInBytes(type);
 }
 
 void RenderBuffer::resize(unsigned int newX, unsigned int newY) {
@@ -181,6 +425,19 @@ void FrameBuffer::verifyBufferSizes() {
   }
 }
 
+void FrameBuffer::readFloat4Async(int xPos, int yPos, std::function<void(std::array<float, 4>)> callback) {
+  callback(readFloat4(xPos, yPos));
+}
+
+void FrameBuffer::readBufferAsync(std::function<void(std::vector<unsigned char>)> callback) {
+  callback(readBuffer());
+}
+
+void FrameBuffer::readDepthRegionAsync(int xPos, int yPos, int sizeX, int sizeY,
+                                       std::function<void(std::vector<float>)> callback) {
+  callback(readDepthRegion(xPos, yPos, sizeX, sizeY));
+}
+
 ShaderReplacementRule::ShaderReplacementRule() {}
 
 ShaderReplacementRule::ShaderReplacementRule(std::string ruleName_,
@@ -199,7 +456,7 @@ ShaderProgram::ShaderProgram(DrawMode dm) : drawMode(dm), uniqueID(render::engin
 
   drawMode = dm;
   if (dm == DrawMode::IndexedLines || dm == DrawMode::IndexedLineStrip || dm == DrawMode::IndexedLineStripAdjacency ||
-      dm == DrawMode::IndexedTriangles) {
+      dm == DrawMode::IndexedTriangles || dm == DrawMode::IndexedPoints) {
     useIndex = true;
   }
 
@@ -208,6 +465,39 @@ ShaderProgram::ShaderProgram(DrawMode dm) : drawMode(dm), uniqueID(render::engin
   }
 }
 
+void ShaderProgram::setDrawRanges(const std::vector<std::array<size_t, 2>>& ranges) {
+  useDrawRanges = true;
+  drawRangeFirsts.resize(ranges.size());
+  drawRangeCounts.resize(ranges.size());
+  for (size_t i = 0; i < ranges.size(); i++) {
+    drawRangeFirsts[i] = static_cast<int>(ranges[i][0]);
+    drawRangeCounts[i] = static_cast<int>(ranges[i][1]);
+  }
+}
+
+void ShaderProgram::clearDrawRanges() {
+  useDrawRanges = false;
+  drawRangeFirsts.clear();
+  drawRangeCounts.clear();
+}
+
+void ShaderProgram::setInstanceCount(uint32_t count) {
+  useInstancing = true;
+  instanceCount = count;
+}
+
+void ShaderProgram::clearInstanceCount() {
+  useInstancing = false;
+  instanceCount = 1;
+}
+
+void ShaderProgram::setVertexCount(size_t count) { vertexCount = static_cast<int64_t>(count); }
+
+Engine::Engine() {
+  // Start decoding the material which nearly every structure uses, so it overlaps creating the window and context
+  prefetchDefaultMaterial("clay");
+}
+
 void Engine::buildEngineGui() {
 
   ImGui::SetNextTreeNodeOpen(false, ImGuiCond_FirstUseEver);
@@ -234,7 +524,8 @@ void Engine::buildEngineGui() {
     if (ImGui::TreeNode("Transparency")) {
 
       if (ImGui::BeginCombo("Mode", modeName(transparencyMode).c_str())) {
-        for (TransparencyMode m : {TransparencyMode::None, TransparencyMode::Simple, TransparencyMode::Pretty}) {
+        for (TransparencyMode m : {TransparencyMode::None, TransparencyMode::Simple, TransparencyMode::Pretty,
+                                   TransparencyMode::WeightedBlended, TransparencyMode::Sorted}) {
           std::string mName = modeName(m);
           if (ImGui::Selectable(mName.c_str(), transparencyMode == m)) {
             options::transparencyMode = m;
@@ -260,6 +551,20 @@ void Engine::buildEngineGui() {
         if (ImGui::InputInt("Render Passes", &options::transparencyRenderPasses)) {
           requestRedraw();
         }
+        if (ImGui::Checkbox("Stop at first empty pass", &options::adaptiveTransparencyRenderPasses)) {
+          requestRedraw();
+        }
+        break;
+      }
+      case TransparencyMode::WeightedBlended: {
+        ImGui::TextWrapped("Single-pass order-independent transparency. Much cheaper than Pretty, but overlapping "
+                           "surfaces are blended by an approximate depth weighting rather than sorted exactly.");
+        break;
+      }
+      case TransparencyMode::Sorted: {
+        ImGui::TextWrapped("Single-pass transparency which draws transparent structures back to front, over the opaque "
+                           "ones. The points of point clouds are sorted individually, so they are exact; other "
+                           "structures which overlap themselves may not look right.");
         break;
       }
       }
@@ -290,6 +595,76 @@ void Engine::buildEngineGui() {
         options::ssaaFactor = ssaaFactor;
         requestRedraw();
       }
+      bool logicalResolution = options::renderScale <= 0.f;
+      if (ImGui::Checkbox("logical resolution", &logicalResolution)) {
+        options::renderScale = logicalResolution ? -1.f : 1.f;
+        requestRedraw();
+      }
+      if (!logicalResolution) {
+        if (ImGui::SliderFloat("render scale", &options::renderScale, 0.25, 1.)) requestRedraw();
+      }
+      if (ImGui::Checkbox("temporal (while still)", &options::temporalAntialiasing)) {
+        requestRedraw();
+      }
+      if (options::temporalAntialiasing) {
+        ImGui::SameLine();
+        ImGui::PushItemWidth(80);
+        if (ImGui::InputInt("samples", &options::temporalAntialiasingSamples, 1)) {
+          options::temporalAntialiasingSamples = std::max(options::temporalAntialiasingSamples, 1);
+        }
+        ImGui::PopItemWidth();
+      }
+      ImGui::TreePop();
+    }
+
+    // == Ambient occlusion
+    ImGui::SetNextTreeNodeOpen(false, ImGuiCond_FirstUseEver);
+    if (ImGui::TreeNode("Ambient Occlusion")) {
+      if (ImGui::Checkbox("enabled", &options::ambientOcclusion)) requestRedraw();
+      if (options::ambientOcclusion) {
+        ImGui::PushItemWidth(120);
+        if (ImGui::SliderFloat("radius", &options::ambientOcclusionRadius, 0.001, 0.2, "%.3f",
+                               ImGuiSliderFlags_Logarithmic)) {
+          requestRedraw();
+        }
+        if (ImGui::SliderFloat("strength", &options::ambientOcclusionStrength, 0., 4.)) requestRedraw();
+        if (ImGui::Checkbox("full resolution", &options::ambientOcclusionFullResolution)) requestRedraw();
+        ImGui::PopItemWidth();
+      }
+      ImGui::TreePop();
+    }
+
+    // == Deferred shading
+    bool deferredShadingVal = deferredShading;
+    if (ImGui::Checkbox("Deferred Shading", &deferredShadingVal)) {
+      setDeferredShading(deferredShadingVal);
+      requestRedraw();
+    }
+    if (deferredShading && !deferredShadingActive()) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("(not with transparency)");
+    }
+
+    // == Adaptive quality
+    ImGui::SetNextTreeNodeOpen(false, ImGuiCond_FirstUseEver);
+    if (ImGui::TreeNode("Adaptive Quality")) {
+      ImGui::Checkbox("reduce while moving", &options::adaptiveQuality);
+      if (options::adaptiveQuality) {
+        if (ImGui::InputInt("SSAA (moving)", &options::adaptiveQualitySSAAFactor, 1)) {
+          options::adaptiveQualitySSAAFactor = glm::clamp(options::adaptiveQualitySSAAFactor, 1, 4);
+        }
+        if (ImGui::InputInt("Render Passes (moving)", &options::adaptiveQualityTransparencyRenderPasses)) {
+          options::adaptiveQualityTransparencyRenderPasses =
+              std::max(options::adaptiveQualityTransparencyRenderPasses, 1);
+        }
+      }
+      ImGui::Checkbox("dynamic resolution", &options::dynamicResolution);
+      if (options::dynamicResolution) {
+        ImGui::InputFloat("target frame ms", &options::dynamicResolutionTargetMs);
+        options::dynamicResolutionTargetMs = std::max(options::dynamicResolutionTargetMs, 1.f);
+        ImGui::SliderFloat("min scale", &options::dynamicResolutionMinScale, 0.1, 1.);
+        ImGui::Text("current scale: %.2f", resolutionScale);
+      }
       ImGui::TreePop();
     }
 
@@ -364,8 +739,57 @@ void Engine::setBackgroundAlpha(float newAlpha) {
   targetBuffer.clearAlpha = newAlpha;
 }
 
-void Engine::setCurrentViewport(glm::vec4 val) { currViewport = val; }
+void Engine::setCurrentViewport(glm::vec4 val) {
+  if (val != currViewport) frameUniformsVersion++;
+  currViewport = val;
+}
 glm::vec4 Engine::getCurrentViewport() { return currViewport; }
+
+void Engine::updateFrameUniforms() {
+  bool changed = false;
+
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  if (P != frameProjMatrix) {
+    frameProjMatrix = P;
+    frameInvProjMatrix = glm::inverse(P);
+    changed = true;
+  }
+
+  // Slice planes in view space, indexed by their position in state::slicePlanes. Inactive planes get values which
+  // never cull anything.
+  glm::mat4 viewMat = view::getCameraViewMatrix();
+  int count = static_cast<int>(state::slicePlanes.size());
+  for (int i = 0; i < count; i++) {
+    SlicePlane* s = state::slicePlanes[i];
+    glm::vec4 center, normal;
+    if (s->getActive()) {
+      center = viewMat * glm::vec4(s->getCenter(), 1.);
+      normal = viewMat * glm::vec4(s->getNormal(), 0.);
+    } else {
+      center = glm::vec4{std::numeric_limits<float>::infinity(), 0., 0., 1.};
+      normal = glm::vec4{-1., 0., 0., 0.};
+    }
+    if (i >= frameSlicePlaneCount || center != frameSlicePlaneCenters[i] || normal != frameSlicePlaneNormals[i]) {
+      frameSlicePlaneCenters[i] = center;
+      frameSlicePlaneNormals[i] = normal;
+      changed = true;
+    }
+  }
+  if (count != frameSlicePlaneCount) {
+    frameSlicePlaneCount = count;
+    changed = true;
+  }
+
+  if (options::impostorFallbackPixelSize != frameImpostorFallbackPixelSize) {
+    frameImpostorFallbackPixelSize = options::impostorFallbackPixelSize;
+    changed = true;
+  }
+
+  if (changed) frameUniformsVersion++;
+}
+const glm::mat4& Engine::getFrameProjMatrix() { return frameProjMatrix; }
+const glm::mat4& Engine::getFrameInvProjMatrix() { return frameInvProjMatrix; }
+uint64_t Engine::getFrameUniformsVersion() { return frameUniformsVersion; }
 void Engine::setCurrentPixelScaling(float val) { currPixelScale = val; }
 float Engine::getCurrentPixelScaling() { return currPixelScale; }
 
@@ -381,16 +805,212 @@ void Engine::clearDisplay() {
 }
 
 
+void Engine::processPendingReadbacks(bool blockUntilDone) {}
+
+bool Engine::hasPendingReadbacks() { return false; }
+
+bool Engine::supportsAttributeBufferGather() { return false; }
+
+bool Engine::gatherAttributeBuffer(AttributeBuffer& source, AttributeBuffer& indices, AttributeBuffer& target) {
+  return false;
+}
+
+bool Engine::supportsAttributeBufferBlend() { return false; }
+
+bool Engine::blendAttributeBuffers(AttributeBuffer& a, AttributeBuffer& b, float t, bool normalize,
+                                   AttributeBuffer& target) {
+  return false;
+}
+
+bool Engine::supportsMeshGeometryCompute() { return false; }
+
+bool Engine::computeMeshGeometry(AttributeBuffer& positions, AttributeBuffer& faceIndsStart,
+                                 AttributeBuffer& faceIndsEntries, AttributeBuffer& vertexFaceAdjStart,
+                                 AttributeBuffer& vertexFaceAdjEntries, AttributeBuffer* faceNormals,
+                                 AttributeBuffer* faceCenters, AttributeBuffer* vertexNormals) {
+  return false;
+}
+
+namespace {
+
+// Each work group of the radix sort programs handles a tile of this many keys, with 4-bit digits
+const size_t radixSortTileSize = 1024;
+const size_t radixSortBuckets = 16;
+
+// Spread a dispatch over two dimensions, to stay below the limit on the work group count in each
+void dispatchGroups(ShaderProgram& program, size_t nGroups) {
+  uint32_t groupsX = static_cast<uint32_t>(std::min<size_t>(nGroups, 32768));
+  uint32_t groupsY = static_cast<uint32_t>((nGroups + groupsX - 1) / groupsX);
+  program.dispatch(groupsX, groupsY);
+}
+
+} // namespace
+
+bool Engine::supportsPointDepthSort() { return supportsComputeShaders(); }
+
+bool Engine::sortPointsByDepth(std::shared_ptr<AttributeBuffer> positions, size_t count, glm::vec4 depthRow,
+                               std::shared_ptr<AttributeBuffer> order) {
+  if (!supportsPointDepthSort()) return false;
+  if (positions->getType() != RenderDataType::Vector3Float || positions->getArrayCount() != 1) {
+    exception("sortPointsByDepth() positions must be a vec3 buffer");
+  }
+  if (order->getType() != RenderDataType::UInt || order->getArrayCount() != 1) {
+    exception("sortPointsByDepth() order must be a uint32 buffer");
+  }
+  if (static_cast<size_t>(std::max<int64_t>(0, positions->getDataSize())) < count ||
+      static_cast<size_t>(std::max<int64_t>(0, order->getDataSize())) < count) {
+    exception("sortPointsByDepth() buffers have fewer than count entries");
+  }
+  if (count == 0) return true;
+
+  if (!depthSortKeys) {
+    // (all or none, in case one is still compiling)
+    std::shared_ptr<ShaderProgram> keysProgram =
+        requestShader("DEPTH_SORT_KEYS", {}, ShaderReplacementDefaults::Compute);
+    std::shared_ptr<ShaderProgram> countProgram =
+        requestShader("RADIX_SORT_COUNT", {}, ShaderReplacementDefaults::Compute);
+    std::shared_ptr<ShaderProgram> scanProgram =
+        requestShader("RADIX_SORT_SCAN", {}, ShaderReplacementDefaults::Compute);
+    std::shared_ptr<ShaderProgram> scatterProgram =
+        requestShader("RADIX_SORT_SCATTER", {}, ShaderReplacementDefaults::Compute);
+    depthSortKeys = keysProgram;
+    radixSortCount = countProgram;
+    radixSortScan = scanProgram;
+    radixSortScatter = scatterProgram;
+  }
+
+  // Scratch space, which only grows
+  size_t nTiles = (count + radixSortTileSize - 1) / radixSortTileSize;
+  auto ensureScratch = [&](std::shared_ptr<AttributeBuffer>& buff, size_t n) {
+    if (!buff) {
+      buff = generateAttributeBuffer(RenderDataType::UInt);
+      buff->setMemoryOwner("engine");
+      buff->setResizable(true);
+    }
+    if (buff->getDataSize() < static_cast<int64_t>(n)) buff->setDataRaw(nullptr, n);
+  };
+  ensureScratch(depthSortKeysBuffer[0], count);
+  ensureScratch(depthSortKeysBuffer[1], count);
+  ensureScratch(depthSortValuesScratch, count);
+  ensureScratch(depthSortHistogram, radixSortBuckets * nTiles);
+  std::shared_ptr<AttributeBuffer> values[2] = {order, depthSortValuesScratch};
+
+  uint32_t countU = static_cast<uint32_t>(count);
+  uint32_t nTilesU = static_cast<uint32_t>(nTiles);
+  depthSortKeys->setUniform("u_count", countU);
+  depthSortKeys->setUniform("u_depthRow", depthRow);
+  depthSortKeys->setStorageBuffer("b_positions", positions);
+  depthSortKeys->setStorageBuffer("b_keys", depthSortKeysBuffer[0]);
+  depthSortKeys->setStorageBuffer("b_values", order);
+  dispatchGroups(*depthSortKeys, (count + 255) / 256);
+
+  // Least significant digit first; each pass counts the digits of every tile, scans the counts (digit-major, so the
+  // scan gives each tile's offset for each digit directly), and scatters stably. An even number of passes ends in
+  // the first buffers, ie `order`.
+  radixSortCount->setUniform("u_count", countU);
+  radixSortCount->setUniform("u_tileCount", nTilesU);
+  radixSortCount->setStorageBuffer("b_histogram", depthSortHistogram);
+  radixSortScan->setUniform("u_length", static_cast<uint32_t>(radixSortBuckets * nTiles));
+  radixSortScan->setStorageBuffer("b_histogram", depthSortHistogram);
+  radixSortScatter->setUniform("u_count", countU);
+  radixSortScatter->setUniform("u_tileCount", nTilesU);
+  radixSortScatter->setStorageBuffer("b_histogram", depthSortHistogram);
+  for (uint32_t iPass = 0; iPass < 8; iPass++) {
+    uint32_t in = iPass % 2;
+    uint32_t out = 1 - in;
+    memoryBarrier(MemoryBarrierType::StorageBuffer);
+    radixSortCount->setUniform("u_shift", 4 * iPass);
+    radixSortCount->setStorageBuffer("b_keys", depthSortKeysBuffer[in]);
+    dispatchGroups(*radixSortCount, nTiles);
+
+    memoryBarrier(MemoryBarrierType::StorageBuffer);
+    radixSortScan->dispatch(1);
+
+    memoryBarrier(MemoryBarrierType::StorageBuffer);
+    radixSortScatter->setUniform("u_shift", 4 * iPass);
+    radixSortScatter->setStorageBuffer("b_keysIn", depthSortKeysBuffer[in]);
+    radixSortScatter->setStorageBuffer("b_valuesIn", values[in]);
+    radixSortScatter->setStorageBuffer("b_keysOut", depthSortKeysBuffer[out]);
+    radixSortScatter->setStorageBuffer("b_valuesOut", values[out]);
+    dispatchGroups(*radixSortScatter, nTiles);
+  }
+  memoryBarrier(MemoryBarrierType::All);
+
+  return true;
+}
+
+bool Engine::waitEvents(double timeoutSeconds) {
+  pollEvents();
+  return true;
+}
+
+void Engine::wakeEventWait() {}
+
+bool Engine::sampleCursorPosition(glm::vec2& pos) { return false; }
+
+uint64_t Engine::getInputEventCount() { return 0; }
+
+void Engine::releaseContext() {}
+
+void Engine::beginGPUTimer(size_t timerID, uint64_t frame) {}
+
+void Engine::endGPUTimer() {}
+
+uint64_t Engine::collectGPUTimers(std::vector<GPUTimerResult>& results) {
+  return std::numeric_limits<uint64_t>::max();
+}
+
+bool Engine::supportsOcclusionQueries() { return false; }
+
+void Engine::beginOcclusionQuery(size_t queryID) {}
+
+void Engine::endOcclusionQuery() {}
+
+bool Engine::getOcclusionQueryResult(size_t queryID, bool& anySamplesPassed) { return false; }
+
+bool Engine::supportsComputeShaders() { return false; }
+
+void Engine::memoryBarrier(MemoryBarrierType type) {}
+
+void Engine::resetCostCounters() {
+  costCounters = EngineCostCounters();
+  frameCostCounters = EngineCostCounters();
+  lastFrameCostCounters = EngineCostCounters();
+}
+
 void Engine::clearSceneBuffer() { sceneBuffer->clear(); }
 
+namespace {
+unsigned int scaledSize(unsigned int size, float scale) {
+  return std::max(1u, static_cast<unsigned int>(std::lround(scale * size)));
+}
+} // namespace
+
 void Engine::resizeScreenBuffers() {
   unsigned int width = view::bufferWidth;
   unsigned int height = view::bufferHeight;
+  unsigned int sceneWidth = scaledSize(width, getSceneBufferScale());
+  unsigned int sceneHeight = scaledSize(height, getSceneBufferScale());
   displayBuffer->resize(width, height);
   displayBufferAlt->resize(width, height);
-  sceneBuffer->resize(ssaaFactor * width, ssaaFactor * height);
-  sceneBufferFinal->resize(ssaaFactor * width, ssaaFactor * height);
-  sceneDepthMinFrame->resize(ssaaFactor * width, ssaaFactor * height);
+  sceneBuffer->resize(sceneWidth, sceneHeight);
+  sceneBufferFinal->resize(sceneWidth, sceneHeight);
+
+  // The targets of the transparency modes are only kept at full size while their mode is on
+  if (transparencyMode == TransparencyMode::Pretty) {
+    sceneDepthMinFrame->resize(sceneWidth, sceneHeight);
+  } else {
+    sceneDepthMinFrame->resize(1, 1);
+  }
+  if (transparencyMode == TransparencyMode::WeightedBlended) {
+    sceneBufferWeightedBlended->resize(sceneWidth, sceneHeight);
+  } else {
+    sceneRevealage->resize(1, 1); // (the rest of that buffer is the scene color and depth)
+  }
+
+  // The graph's imported buffers lost their contents, and its transient textures are the wrong size
+  frameGraph.invalidate();
+  frameGraph.releaseTransientTextures();
 }
 
 void Engine::setScreenBufferViewports() {
@@ -398,16 +1018,19 @@ void Engine::setScreenBufferViewports() {
   unsigned int yStart = 0;
   unsigned int sizeX = view::bufferWidth;
   unsigned int sizeY = view::bufferHeight;
+  unsigned int sceneSizeX = scaledSize(sizeX, getSceneBufferScale());
+  unsigned int sceneSizeY = scaledSize(sizeY, getSceneBufferScale());
 
   displayBuffer->setViewport(xStart, yStart, sizeX, sizeY);
   displayBufferAlt->setViewport(xStart, yStart, sizeX, sizeY);
-  sceneBuffer->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
-  sceneBufferFinal->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
-  sceneDepthMinFrame->setViewport(ssaaFactor * xStart, ssaaFactor * yStart, ssaaFactor * sizeX, ssaaFactor * sizeY);
+  sceneBuffer->setViewport(xStart, yStart, sceneSizeX, sceneSizeY);
+  sceneBufferFinal->setViewport(xStart, yStart, sceneSizeX, sceneSizeY);
+  sceneDepthMinFrame->setViewport(xStart, yStart, sceneSizeX, sceneSizeY);
+  sceneBufferWeightedBlended->setViewport(xStart, yStart, sceneSizeX, sceneSizeY);
 }
 
 bool Engine::bindSceneBuffer() {
-  setCurrentPixelScaling(ssaaFactor);
+  setCurrentPixelScaling(getSceneBufferScale());
   return sceneBuffer->bindForRendering();
 }
 
@@ -452,6 +1075,12 @@ void Engine::applyLightingTransform(std::shared_ptr<TextureBuffer>& texture) {
       break;
     case TransparencyMode::Pretty:
       break;
+    case TransparencyMode::WeightedBlended:
+      break;
+    case TransparencyMode::Sorted:
+      // (the structures are composited over a clear background, so the color is premultiplied by the coverage)
+      resolveRules.push_back("TRANSPARENCY_RESOLVE_SIMPLE");
+      break;
     }
 
     mapLight = render::engine->requestShader("MAP_LIGHT", resolveRules, render::ShaderReplacementDefaults::Process);
@@ -479,6 +1108,18 @@ void Engine::applyLightingTransform(std::shared_ptr<TextureBuffer>& texture) {
 
 void Engine::setMaterial(ShaderProgram& program, const std::string& mat) {
   const Material& m = getMaterial(mat);
+
+  // Programs using LIGHT_DEFERRED only record which material they are, it is bound by the lighting pass
+  if (!program.hasTexture("t_mat_r")) {
+    for (size_t i = 0; i < materials.size(); i++) {
+      if (materials[i].get() != &m) continue;
+      program.setUniform("u_materialIndex", static_cast<float>(i));
+      if (deferredMaterialsInUse.size() <= i) deferredMaterialsInUse.resize(i + 1, false);
+      deferredMaterialsInUse[i] = true;
+    }
+    return;
+  }
+
   program.setTextureFromBuffer("t_mat_r", m.textureBuffers[0].get());
   program.setTextureFromBuffer("t_mat_g", m.textureBuffers[1].get());
   program.setTextureFromBuffer("t_mat_b", m.textureBuffers[2].get());
@@ -492,9 +1133,7 @@ void Engine::renderBackground() {
     /*
       case BackgroundView::Env: {
         glm::mat4 V = view::getCameraViewMatrix();
-        glm::mat4 P = view::getCameraPerspectiveMatrix();
         renderTextureSphereBG->setUniform("u_viewMatrix", glm::value_ptr(V));
-        renderTextureSphereBG->setUniform("u_projMatrix", glm::value_ptr(P));
         renderTextureSphereBG->setTextureFromBuffer("t_image", envMapOrig.get());
         setDepthMode(DepthMode::LEqualReadOnly);
         renderTextureSphereBG->draw();
@@ -523,6 +1162,18 @@ void Engine::setTransparencyMode(TransparencyMode newMode) {
         defaultRules_sceneObject.end());
     break;
   }
+  case TransparencyMode::WeightedBlended: {
+    defaultRules_sceneObject.erase(std::remove(defaultRules_sceneObject.begin(), defaultRules_sceneObject.end(),
+                                               "TRANSPARENCY_WEIGHTED_STRUCTURE"),
+                                   defaultRules_sceneObject.end());
+    break;
+  }
+  case TransparencyMode::Sorted: {
+    defaultRules_sceneObject.erase(
+        std::remove(defaultRules_sceneObject.begin(), defaultRules_sceneObject.end(), "TRANSPARENCY_STRUCTURE"),
+        defaultRules_sceneObject.end());
+    break;
+  }
   }
 
   transparencyMode = newMode;
@@ -540,6 +1191,21 @@ void Engine::setTransparencyMode(TransparencyMode newMode) {
     defaultRules_sceneObject.push_back("TRANSPARENCY_PEEL_STRUCTURE");
     break;
   }
+  case TransparencyMode::WeightedBlended: {
+    defaultRules_sceneObject.push_back("TRANSPARENCY_WEIGHTED_STRUCTURE");
+    break;
+  }
+  case TransparencyMode::Sorted: {
+    defaultRules_sceneObject.push_back("TRANSPARENCY_STRUCTURE");
+    break;
+  }
+  }
+  updateSceneObjectLightingRule();
+
+  // The transparency targets are sized by the mode
+  if (sceneBuffer) {
+    resizeScreenBuffers();
+    setScreenBufferViewports();
   }
 
   // Regenerate _all_ the things
@@ -556,10 +1222,34 @@ bool Engine::transparencyEnabled() {
     return true;
   case TransparencyMode::Pretty:
     return true;
+  case TransparencyMode::WeightedBlended:
+    return true;
+  case TransparencyMode::Sorted:
+    return true;
   }
   return false;
 }
 
+void Engine::setDeferredShading(bool newVal) {
+  if (newVal == deferredShading) return;
+  deferredShading = newVal;
+  updateSceneObjectLightingRule();
+  refresh();
+}
+
+bool Engine::getDeferredShading() { return deferredShading; }
+
+bool Engine::deferredShadingActive() { return deferredShading && transparencyMode == TransparencyMode::None; }
+
+void Engine::updateSceneObjectLightingRule() {
+  // The transparency rules write their own second output, so they fall back to forward lighting
+  std::string lightingRule = deferredShadingActive() ? "LIGHT_DEFERRED" : "LIGHT_MATCAP";
+  for (std::string& rule : defaultRules_sceneObject) {
+    if (rule == "LIGHT_MATCAP" || rule == "LIGHT_DEFERRED") rule = lightingRule;
+  }
+  deferredMaterialsInUse.clear(); // refilled as the programs are recreated
+}
+
 void Engine::setSSAAFactor(int newVal) {
   if (newVal < 1 || newVal > 4) exception("ssaaFactor must be one of 1,2,3,4");
   ssaaFactor = newVal;
@@ -570,10 +1260,237 @@ bool Engine::getFrontFaceCCW() { return frontFaceCCW; }
 
 int Engine::getSSAAFactor() { return ssaaFactor; }
 
+void Engine::setResolutionScale(float newVal) {
+  if (!(newVal > 0. && newVal <= 1.)) exception("resolution scale must be in (0, 1]");
+  resolutionScale = newVal;
+  updateWindowSize(true);
+}
+
+float Engine::getResolutionScale() { return resolutionScale; }
+
+float Engine::getSceneBufferScale() { return ssaaFactor == 1 ? resolutionScale : ssaaFactor; }
+
+void Engine::resetTemporalAccumulation() { temporalSampleCount = 0; }
+
+void Engine::accumulateTemporalSample() {
+  unsigned int sizeX = sceneBufferFinal->getSizeX();
+  unsigned int sizeY = sceneBufferFinal->getSizeY();
+
+  if (!temporalAccumulate) {
+    for (int i = 0; i < 2; i++) {
+      temporalHistoryColor[i] = generateTextureBuffer(TextureFormat::RGBA16F, sizeX, sizeY);
+      temporalHistoryBuffer[i] = generateFrameBuffer(sizeX, sizeY);
+      temporalHistoryBuffer[i]->addColorBuffer(temporalHistoryColor[i]);
+      temporalHistoryBuffer[i]->setDrawBuffers();
+    }
+    temporalAccumulate =
+        render::engine->requestShader("TEMPORAL_ACCUMULATE", {}, render::ShaderReplacementDefaults::Process);
+    temporalAccumulate->setAttribute("a_position", screenTrianglesCoords());
+    temporalAccumulate->setTextureFromBuffer("t_image", sceneColorFinal.get());
+  }
+
+  // Follow the size of the scene buffers, starting over if it changed
+  for (int i = 0; i < 2; i++) {
+    if (temporalHistoryBuffer[i]->getSizeX() != sizeX || temporalHistoryBuffer[i]->getSizeY() != sizeY) {
+      temporalHistoryBuffer[i]->resize(sizeX, sizeY);
+      temporalSampleCount = 0;
+    }
+    temporalHistoryBuffer[i]->setViewport(0, 0, sizeX, sizeY);
+  }
+
+  int targetInd = 1 - temporalHistoryInd;
+  temporalAccumulate->setTextureFromBuffer("t_history", temporalHistoryColor[temporalHistoryInd].get());
+  temporalAccumulate->setUniform("u_weight", 1.f / (temporalSampleCount + 1));
+  temporalHistoryBuffer[targetInd]->bind();
+  setDepthMode(DepthMode::Disable);
+  setBlendMode(BlendMode::Disable);
+  temporalAccumulate->draw();
+
+  temporalHistoryInd = targetInd;
+  temporalSampleCount++;
+}
+
+int Engine::getTemporalSampleCount() { return temporalSampleCount; }
+
+bool Engine::temporalAccumulationConverged() {
+  return !options::temporalAntialiasing || temporalSampleCount >= options::temporalAntialiasingSamples;
+}
+
+std::shared_ptr<TextureBuffer>& Engine::getTemporalResult() {
+  if (temporalSampleCount == 0) return sceneColorFinal;
+  return temporalHistoryColor[temporalHistoryInd];
+}
+
+std::array<unsigned int, 2> Engine::getAmbientOcclusionSize() {
+  unsigned int sizeX = sceneBuffer->getSizeX();
+  unsigned int sizeY = sceneBuffer->getSizeY();
+  if (!options::ambientOcclusionFullResolution) {
+    sizeX = std::max(1u, sizeX / 2);
+    sizeY = std::max(1u, sizeY / 2);
+  }
+  return {{sizeX, sizeY}};
+}
+
+void Engine::resolveSceneWithAmbientOcclusion(std::shared_ptr<TextureBuffer> aoTexture) {
+  unsigned int sizeX = aoTexture->getSizeX();
+  unsigned int sizeY = aoTexture->getSizeY();
+
+  if (!ambientOcclusionEstimate) {
+    ambientOcclusionEstimate =
+        render::engine->requestShader("AMBIENT_OCCLUSION_ESTIMATE", {}, render::ShaderReplacementDefaults::Process);
+    ambientOcclusionEstimate->setAttribute("a_position", screenTrianglesCoords());
+    ambientOcclusionEstimate->setTextureFromBuffer("t_depth", sceneDepth.get());
+
+    ambientOcclusionComposite =
+        render::engine->requestShader("AMBIENT_OCCLUSION_COMPOSITE", {}, render::ShaderReplacementDefaults::Process);
+    ambientOcclusionComposite->setAttribute("a_position", screenTrianglesCoords());
+    ambientOcclusionComposite->setTextureFromBuffer("t_image", sceneColor.get());
+    ambientOcclusionComposite->setTextureFromBuffer("t_depth", sceneDepth.get());
+  }
+  ambientOcclusionComposite->setTextureFromBuffer("t_ao", aoTexture.get());
+
+  std::shared_ptr<FrameBuffer> aoBuffer = generateFrameBuffer(sizeX, sizeY);
+  aoBuffer->addColorBuffer(aoTexture);
+  aoBuffer->setDrawBuffers();
+  aoBuffer->setViewport(0, 0, sizeX, sizeY);
+
+  // Estimate
+  setDepthMode(DepthMode::Disable);
+  setBlendMode(BlendMode::Disable);
+  aoBuffer->bind();
+  ambientOcclusionEstimate->setUniform("u_radius", options::ambientOcclusionRadius * state::lengthScale);
+  ambientOcclusionEstimate->setUniform("u_strength", options::ambientOcclusionStrength);
+  ambientOcclusionEstimate->draw();
+
+  // Upsample and apply, in place of the usual blit
+  sceneBufferFinal->bind();
+  ambientOcclusionComposite->draw();
+}
+
+bool Engine::bindGBuffer(std::shared_ptr<TextureBuffer> albedo, std::shared_ptr<TextureBuffer> normal) {
+  unsigned int sizeX = sceneBuffer->getSizeX();
+  unsigned int sizeY = sceneBuffer->getSizeY();
+
+  if (!deferredLighting) {
+    deferredLighting =
+        render::engine->requestShader("DEFERRED_LIGHTING", {}, render::ShaderReplacementDefaults::Process);
+    deferredLighting->setAttribute("a_position", screenTrianglesCoords());
+    setMaterial(*deferredLighting, "clay");
+  }
+  deferredLighting->setTextureFromBuffer("t_albedo", albedo.get());
+  deferredLighting->setTextureFromBuffer("t_normalMaterial", normal.get());
+
+  gBuffer = generateFrameBuffer(sizeX, sizeY);
+  gBuffer->addColorBuffer(albedo);
+  gBuffer->addColorBuffer(normal);
+  gBuffer->addDepthBuffer(sceneDepth);
+  gBuffer->setDrawBuffers();
+  gBuffer->clearColor = glm::vec3{0., 0., 0.};
+  gBuffer->clearAlpha = 0.0;
+  gBuffer->setViewport(0, 0, sizeX, sizeY);
+
+  gBufferPassActive = true;
+  gBuffer->clear();
+  setCurrentPixelScaling(getSceneBufferScale());
+  return gBuffer->bindForRendering();
+}
+
+void Engine::resolveDeferredShading() {
+  gBufferPassActive = false;
+  gBuffer.reset();
+  bindSceneBuffer();
+  setDepthMode(DepthMode::Disable);
+  setBlendMode(BlendMode::Disable);
+
+  // One pass per material in use, then one copying the pixels drawn without deferred lighting (index -1)
+  for (size_t i = 0; i < deferredMaterialsInUse.size(); i++) {
+    if (!deferredMaterialsInUse[i]) continue;
+    setMaterial(*deferredLighting, materials[i]->name);
+    deferredLighting->setUniform("u_materialIndex", static_cast<float>(i));
+    deferredLighting->draw();
+  }
+  deferredLighting->setUniform("u_materialIndex", -1.f);
+  deferredLighting->draw();
+}
+
+bool Engine::bindStaticLayer() {
+  unsigned int sizeX = sceneBuffer->getSizeX();
+  unsigned int sizeY = sceneBuffer->getSizeY();
+
+  if (!staticLayerBuffer) {
+    staticLayerColor = generateTextureBuffer(TextureFormat::RGBA16F, sizeX, sizeY);
+    staticLayerDepth = generateTextureBuffer(TextureFormat::DEPTH24, sizeX, sizeY);
+    staticLayerBuffer = generateFrameBuffer(sizeX, sizeY);
+    staticLayerBuffer->addColorBuffer(staticLayerColor);
+    staticLayerBuffer->addDepthBuffer(staticLayerDepth);
+    staticLayerBuffer->setDrawBuffers();
+    staticLayerBuffer->clearColor = glm::vec3{0., 0., 0.};
+    staticLayerBuffer->clearAlpha = 0.0;
+
+    copyStaticLayerDepth = requestShader("DEPTH_COPY", {}, render::ShaderReplacementDefaults::Process);
+    copyStaticLayerDepth->setAttribute("a_position", screenTrianglesCoords());
+    copyStaticLayerDepth->setTextureFromBuffer("t_depth", staticLayerDepth.get());
+  }
+  if (staticLayerBuffer->getSizeX() != sizeX || staticLayerBuffer->getSizeY() != sizeY) {
+    staticLayerBuffer->resize(sizeX, sizeY);
+  }
+  staticLayerBuffer->setViewport(0, 0, sizeX, sizeY);
+
+  staticLayerBuffer->clear();
+  setCurrentPixelScaling(getSceneBufferScale());
+  return staticLayerBuffer->bindForRendering();
+}
+
+void Engine::compositeStaticLayer() {
+  staticLayerBuffer->blitTo(sceneBuffer.get());
+
+  // The scene depth was just cleared to the far plane, so a less-than test copies every pixel the layer covers. (The
+  // depth-only buffer is remade rather than resized, which would clear the scene depth.)
+  unsigned int sizeX = sceneBuffer->getSizeX();
+  unsigned int sizeY = sceneBuffer->getSizeY();
+  if (!staticLayerDepthTarget || staticLayerDepthTarget->getSizeX() != sizeX ||
+      staticLayerDepthTarget->getSizeY() != sizeY) {
+    staticLayerDepthTarget = generateFrameBuffer(sizeX, sizeY);
+    staticLayerDepthTarget->addDepthBuffer(sceneDepth);
+  }
+  staticLayerDepthTarget->setViewport(0, 0, sizeX, sizeY);
+  setDepthMode(DepthMode::Less);
+  setBlendMode(BlendMode::Disable);
+  staticLayerDepthTarget->bind();
+  copyStaticLayerDepth->draw();
+
+  bindSceneBuffer();
+}
+
+void Engine::releaseStaticLayer() {
+  staticLayerBuffer.reset();
+  staticLayerDepthTarget.reset();
+  staticLayerColor.reset();
+  staticLayerDepth.reset();
+  copyStaticLayerDepth.reset();
+}
+
+bool Engine::hasStaticLayer() { return staticLayerBuffer != nullptr; }
+
+void Engine::allocatePickBuffer() {
+  if (pickFramebuffer) return;
+
+  // (the ids are packed in to the float channels at full precision, so this stays 32-bit)
+  pickColorBuffer = generateRenderBuffer(RenderBufferType::Float4, view::bufferWidth, view::bufferHeight);
+  pickDepthBuffer = generateRenderBuffer(RenderBufferType::Depth, view::bufferWidth, view::bufferHeight);
+
+  pickFramebuffer = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+  pickFramebuffer->addColorBuffer(pickColorBuffer);
+  pickFramebuffer->addDepthBuffer(pickDepthBuffer);
+  pickFramebuffer->setDrawBuffers();
+}
+
 void Engine::allocateGlobalBuffersAndPrograms() {
 
   // Note: The display frame buffer should be manually wrapped by child classes
 
+  profiling::InitPhaseTimer phaseTimer("global buffers");
+
   { // Scene buffer
 
     // Note that this is basically duplicated in ground_plane.cpp, changes here should probably be reflected there
@@ -590,14 +1507,29 @@ void Engine::allocateGlobalBuffersAndPrograms() {
     sceneBuffer->clearAlpha = 0.0;
   }
 
+  // (the targets of the transparency modes start out small, resizeScreenBuffers() sizes them for the mode in use)
+
   { // Alternate depth texture used for some effects
-    sceneDepthMin = generateTextureBuffer(TextureFormat::DEPTH24, view::bufferWidth, view::bufferHeight);
+    sceneDepthMin = generateTextureBuffer(TextureFormat::DEPTH24, 1, 1);
 
-    sceneDepthMinFrame = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+    sceneDepthMinFrame = generateFrameBuffer(1, 1);
     sceneDepthMinFrame->addDepthBuffer(sceneDepthMin);
     sceneDepthMinFrame->clearDepth = 0.0;
   }
 
+  { // Weighted blended transparency renders in to the usual scene color & depth, plus a revealage target
+    sceneRevealage = generateTextureBuffer(TextureFormat::R16F, 1, 1);
+
+    sceneBufferWeightedBlended = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+    sceneBufferWeightedBlended->addColorBuffer(sceneColor);
+    sceneBufferWeightedBlended->addColorBuffer(sceneRevealage);
+    sceneBufferWeightedBlended->addDepthBuffer(sceneDepth);
+    sceneBufferWeightedBlended->setDrawBuffers();
+
+    sceneBufferWeightedBlended->clearColor = glm::vec3{0., 0., 0.};
+    sceneBufferWeightedBlended->clearAlpha = 0.0;
+  }
+
   { // "Final" scene buffer (after resolving)
     sceneColorFinal = generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
 
@@ -624,47 +1556,46 @@ void Engine::allocateGlobalBuffersAndPrograms() {
     displayBufferAlt->clearAlpha = 0.0;
   }
 
-  { // Pick buffer
-    pickColorBuffer = generateRenderBuffer(RenderBufferType::Float4, view::bufferWidth, view::bufferHeight);
-    pickDepthBuffer = generateRenderBuffer(RenderBufferType::Depth, view::bufferWidth, view::bufferHeight);
-
-    pickFramebuffer = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
-    pickFramebuffer->addColorBuffer(pickColorBuffer);
-    pickFramebuffer->addDepthBuffer(pickDepthBuffer);
-    pickFramebuffer->setDrawBuffers();
-  }
-
   // Make sure all the buffer sizes are up to date
   updateWindowSize(true);
 
-  { // Generate the general-use programs
-    // clang-format off
-    renderTexturePlain = render::engine->requestShader("TEXTURE_DRAW_PLAIN", {}, render::ShaderReplacementDefaults::Process);
-    renderTexturePlain->setAttribute("a_position", screenTrianglesCoords());
+  // (the general-use programs are compiled by prepareGlobalPrograms() when the first frame needs them)
+
+  { // Load defaults
+    loadDefaultMaterials();
+    loadDefaultColorMaps();
+  }
+}
+
+void Engine::prepareGlobalPrograms() {
+  if (copyDepth) return;
+  profiling::ScopedTimer timer("prepareGlobalPrograms");
 
-    renderTextureDot3 = render::engine->requestShader("TEXTURE_DRAW_DOT3", {}, render::ShaderReplacementDefaults::Process);
-    renderTextureDot3->setAttribute("a_position", screenTrianglesCoords());
+  // clang-format off
+  renderTexturePlain = render::engine->requestShader("TEXTURE_DRAW_PLAIN", {}, render::ShaderReplacementDefaults::Process);
+  renderTexturePlain->setAttribute("a_position", screenTrianglesCoords());
 
-    renderTextureMap3 = render::engine->requestShader("TEXTURE_DRAW_MAP3", {}, render::ShaderReplacementDefaults::Process);
-    renderTextureMap3->setAttribute("a_position", screenTrianglesCoords());
+  renderTextureDot3 = render::engine->requestShader("TEXTURE_DRAW_DOT3", {}, render::ShaderReplacementDefaults::Process);
+  renderTextureDot3->setAttribute("a_position", screenTrianglesCoords());
 
-    renderTextureSphereBG = render::engine->requestShader("TEXTURE_DRAW_SPHEREBG", {}, render::ShaderReplacementDefaults::Process);
-    renderTextureSphereBG->setAttribute("a_position", distantCubeCoords());
+  renderTextureMap3 = render::engine->requestShader("TEXTURE_DRAW_MAP3", {}, render::ShaderReplacementDefaults::Process);
+  renderTextureMap3->setAttribute("a_position", screenTrianglesCoords());
 
-    compositePeel = render::engine->requestShader("COMPOSITE_PEEL", {}, render::ShaderReplacementDefaults::Process);
-    compositePeel->setAttribute("a_position", screenTrianglesCoords());
-    compositePeel->setTextureFromBuffer("t_image", sceneColor.get());
+  renderTextureSphereBG = render::engine->requestShader("TEXTURE_DRAW_SPHEREBG", {}, render::ShaderReplacementDefaults::Process);
+  renderTextureSphereBG->setAttribute("a_position", distantCubeCoords());
 
-    copyDepth = render::engine->requestShader("DEPTH_COPY", {}, render::ShaderReplacementDefaults::Process);
-    copyDepth->setAttribute("a_position", screenTrianglesCoords());
-    copyDepth->setTextureFromBuffer("t_depth", sceneDepth.get());
-    // clang-format on
-  }
+  compositePeel = render::engine->requestShader("COMPOSITE_PEEL", {}, render::ShaderReplacementDefaults::Process);
+  compositePeel->setAttribute("a_position", screenTrianglesCoords());
+  compositePeel->setTextureFromBuffer("t_image", sceneColor.get());
+  compositeWeightedBlended = render::engine->requestShader("COMPOSITE_WEIGHTED_BLENDED", {}, render::ShaderReplacementDefaults::Process);
+  compositeWeightedBlended->setAttribute("a_position", screenTrianglesCoords());
+  compositeWeightedBlended->setTextureFromBuffer("t_accum", sceneColor.get());
+  compositeWeightedBlended->setTextureFromBuffer("t_revealage", sceneRevealage.get());
 
-  { // Load defaults
-    loadDefaultMaterials();
-    loadDefaultColorMaps();
-  }
+  copyDepth = render::engine->requestShader("DEPTH_COPY", {}, render::ShaderReplacementDefaults::Process);
+  copyDepth->setAttribute("a_position", screenTrianglesCoords());
+  copyDepth->setTextureFromBuffer("t_depth", sceneDepth.get());
+  // clang-format on
 }
 
 uint64_t Engine::getNextUniqueID() {
@@ -686,28 +1617,30 @@ void Engine::popBindFramebufferForRendering() {
   renderFramebufferStack.pop_back();
 }
 
-void Engine::addSlicePlane(std::string uniquePostfix) {
-
-  // NOTE: Unfortunately, the logic here and in slice_plane.cpp depends on the names constructed from the postfix being
-  // identical.
+void Engine::addSlicePlane() {
 
-  createSlicePlaneFliterRule(uniquePostfix);
+  if (slicePlaneCount >= static_cast<int>(maxSlicePlanes)) {
+    exception("cannot add slice plane, at most " + std::to_string(maxSlicePlanes) + " are supported");
+  }
   slicePlaneCount++;
 
-  // Add rules
-  std::vector<std::string> newRules{"SLICE_PLANE_CULL_" + uniquePostfix};
-  defaultRules_sceneObject.insert(defaultRules_sceneObject.end(), newRules.begin(), newRules.end());
-  defaultRules_pick.insert(defaultRules_pick.end(), newRules.begin(), newRules.end());
+  // The planes themselves are read from the frame uniforms, so the programs only need to be regenerated when culling is
+  // first turned on
+  if (slicePlaneCount > 1) return;
+
+  defaultRules_sceneObject.push_back("SLICE_PLANE_CULL");
+  defaultRules_pick.push_back("SLICE_PLANE_CULL");
 
   // Regenerate everything
   polyscope::refresh();
 }
 
-void Engine::removeSlicePlane(std::string uniquePostfix) {
+void Engine::removeSlicePlane() {
 
   slicePlaneCount--;
+  if (slicePlaneCount > 0) return;
+
   // Remove the (last occurence of the) rules we added
-  std::vector<std::string> newRules{"SLICE_PLANE_CULL_" + uniquePostfix};
   auto deleteLast = [&](std::vector<std::string>& vec, std::string target) {
     for (size_t i = vec.size(); i > 0; i--) {
       if (vec[i - 1] == target) {
@@ -716,12 +1649,8 @@ void Engine::removeSlicePlane(std::string uniquePostfix) {
       }
     }
   };
-  for (std::string r : newRules) {
-    deleteLast(defaultRules_sceneObject, r);
-    deleteLast(defaultRules_pick, r);
-  }
-
-  // Don't bother undoing the createRule(), since it doesn't really hurt to leave it around
+  deleteLast(defaultRules_sceneObject, "SLICE_PLANE_CULL");
+  deleteLast(defaultRules_pick, "SLICE_PLANE_CULL");
 
   // Regenerate everything
   polyscope::refresh();
@@ -785,79 +1714,138 @@ std::vector<glm::vec4> Engine::distantCubeCoords() {
 }
 
 void Engine::updateMinDepthTexture() {
+  prepareGlobalPrograms();
   setDepthMode(DepthMode::Greater);
   sceneDepthMinFrame->bind();
   copyDepth->draw();
 }
 
 
-// Helper (TODO rework to load custom materials)
-void Engine::loadDefaultMaterial(std::string name) {
-
-  Material* newMaterial = new Material();
-  newMaterial->name = name;
-
-  std::array<unsigned char const*, 4> buff;
-  std::array<size_t, 4> buffSize;
+namespace {
 
+// The embedded images of a built-in material, for the r, g, b, k channels. Returns false for unknown names.
+bool getDefaultMaterialSources(const std::string& name, std::array<unsigned char const*, 4>& buff,
+                               std::array<size_t, 4>& buffSize) {
   // clang-format off
   if(name == "clay") {
-    newMaterial->supportsRGB = true;
     buff[0] = &bindata_clay_r[0]; buffSize[0] = bindata_clay_r.size();
     buff[1] = &bindata_clay_g[0]; buffSize[1] = bindata_clay_g.size();
     buff[2] = &bindata_clay_b[0]; buffSize[2] = bindata_clay_b.size();
     buff[3] = &bindata_clay_k[0]; buffSize[3] = bindata_clay_k.size();
   }
   else if(name == "wax") {
-    newMaterial->supportsRGB = true;
     buff[0] = &bindata_wax_r[0]; buffSize[0] = bindata_wax_r.size();
     buff[1] = &bindata_wax_g[0]; buffSize[1] = bindata_wax_g.size();
     buff[2] = &bindata_wax_b[0]; buffSize[2] = bindata_wax_b.size();
     buff[3] = &bindata_wax_k[0]; buffSize[3] = bindata_wax_k.size();
   }
   else if(name == "candy") {
-    newMaterial->supportsRGB = true;
     buff[0] = &bindata_candy_r[0]; buffSize[0] = bindata_candy_r.size();
     buff[1] = &bindata_candy_g[0]; buffSize[1] = bindata_candy_g.size();
     buff[2] = &bindata_candy_b[0]; buffSize[2] = bindata_candy_b.size();
     buff[3] = &bindata_candy_k[0]; buffSize[3] = bindata_candy_k.size();
   }
   else if(name == "flat") {
-    newMaterial->supportsRGB = true;
     buff[0] = &bindata_flat_r[0]; buffSize[0] = bindata_flat_r.size();
     buff[1] = &bindata_flat_g[0]; buffSize[1] = bindata_flat_g.size();
     buff[2] = &bindata_flat_b[0]; buffSize[2] = bindata_flat_b.size();
     buff[3] = &bindata_flat_k[0]; buffSize[3] = bindata_flat_k.size();
   } 
   else if(name == "mud") {
-    newMaterial->supportsRGB = false;
     for(int i = 0; i < 4; i++) {buff[i] = &bindata_mud[0]; buffSize[i] = bindata_mud.size();}
 	}
   else if(name == "ceramic") {
-    newMaterial->supportsRGB = false;
     for(int i = 0; i < 4; i++) {buff[i] = &bindata_ceramic[0]; buffSize[i] = bindata_ceramic.size();}
 	}
   else if(name == "jade") {
-    newMaterial->supportsRGB = false;
     for(int i = 0; i < 4; i++) {buff[i] = &bindata_jade[0]; buffSize[i] = bindata_jade.size();}
 	}
   else if(name == "normal") {
-    newMaterial->supportsRGB = false;
     for(int i = 0; i < 4; i++) {buff[i] = &bindata_normal[0]; buffSize[i] = bindata_normal.size();}
 	} else {
-    exception("unrecognized default material name " + name);
+    return false;
   }
   // clang-format on
+  return true;
+}
+
+} // namespace
+
+void Engine::decodeDefaultMaterial(const std::string& name, DecodedMaterial& out) {
+  std::array<unsigned char const*, 4> buff;
+  std::array<size_t, 4> buffSize;
+  if (!getDefaultMaterialSources(name, buff, buffSize)) return;
 
+  // Decode the distinct images in parallel (the single-color materials use one image for all four channels), converting
+  // them to the half floats which the textures store
   for (int i = 0; i < 4; i++) {
-    int width, height, nComp;
-    float* data = stbi_loadf_from_memory(buff[i], buffSize[i], &width, &height, &nComp, 3);
-    if (!data) exception("failed to load material");
-    newMaterial->textureBuffers[i] = loadMaterialTexture(data, width, height);
-    stbi_image_free(data);
+    out.source[i] = i;
+    for (int j = 0; j < i; j++) {
+      if (buff[j] == buff[i]) {
+        out.source[i] = j;
+        break;
+      }
+    }
   }
+  parallelFor(
+      0, 4,
+      [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) {
+          if (out.source[i] != static_cast<int>(i)) continue;
+          int width, height, nComp;
+          float* data = stbi_loadf_from_memory(buff[i], buffSize[i], &width, &height, &nComp, 3);
+          if (!data) continue;
+          DecodedMaterialImage& image = out.images[i];
+          image.width = width;
+          image.height = height;
+          image.data.resize(3 * static_cast<size_t>(width) * height);
+          for (size_t j = 0; j < image.data.size(); j++) {
+            image.data[j] = glm::packHalf1x16(data[j]);
+          }
+          stbi_image_free(data);
+        }
+      },
+      1);
+}
 
-  materials.emplace_back(newMaterial);
+void Engine::prefetchDefaultMaterial(const std::string& name) {
+  std::array<unsigned char const*, 4> buff;
+  std::array<size_t, 4> buffSize;
+  if (prefetchedMaterials.count(name) > 0 || !getDefaultMaterialSources(name, buff, buffSize)) return;
+
+  if (!materialPrefetchTasks) materialPrefetchTasks.reset(new TaskGroup());
+  DecodedMaterial& target = prefetchedMaterials[name];
+  materialPrefetchTasks->run([name, &target]() { decodeDefaultMaterial(name, target); });
+}
+
+void Engine::loadDefaultMaterial(Material& material) {
+  const std::string& name = material.name;
+
+  std::array<unsigned char const*, 4> buff;
+  std::array<size_t, 4> buffSize;
+  if (!getDefaultMaterialSources(name, buff, buffSize)) {
+    exception("unrecognized default material name " + name);
+  }
+
+  // Take the images if they were prefetched, otherwise decode them now. Either way they are uploaded here, on the
+  // render thread.
+  DecodedMaterial decoded;
+  auto it = prefetchedMaterials.find(name);
+  if (it != prefetchedMaterials.end()) {
+    materialPrefetchTasks->wait();
+    decoded = std::move(it->second);
+    prefetchedMaterials.erase(it);
+  } else {
+    decodeDefaultMaterial(name, decoded);
+  }
+
+  for (int i = 0; i < 4; i++) {
+    if (decoded.images[decoded.source[i]].data.empty()) exception("failed to load material " + name);
+  }
+  for (int i = 0; i < 4; i++) {
+    const DecodedMaterialImage& d = decoded.images[decoded.source[i]];
+    material.textureBuffers[i] = loadMaterialTextureHalfFloat(d.data.data(), d.width, d.height);
+  }
 }
 
 void Engine::loadBlendableMaterial(std::string matName, std::array<std::string, 4> filenames) {
@@ -929,21 +1917,40 @@ std::shared_ptr<TextureBuffer> Engine::loadMaterialTexture(float* data, int widt
   return t;
 }
 
+std::shared_ptr<TextureBuffer> Engine::loadMaterialTextureHalfFloat(const uint16_t* data, int width, int height) {
+  std::shared_ptr<TextureBuffer> t =
+      engine->generateTextureBuffer(TextureFormat::RGB16F, width, height, static_cast<const unsigned char*>(nullptr));
+  t->setDataRegionHalfFloat(0, 0, width, height, data);
+  t->setFilterMode(FilterMode::Linear);
+  return t;
+}
+
 void Engine::loadDefaultMaterials() {
-  loadDefaultMaterial("clay");
-  loadDefaultMaterial("wax");
-  loadDefaultMaterial("candy");
-  loadDefaultMaterial("flat");
-  loadDefaultMaterial("mud");
-  loadDefaultMaterial("ceramic");
-  loadDefaultMaterial("jade");
-  loadDefaultMaterial("normal");
+  // Only registered here; each is decoded the first time it is used, so startup doesn't pay for all of them
+  const std::array<std::pair<const char*, bool>, 8> defaults{{{"clay", true},
+                                                             {"wax", true},
+                                                             {"candy", true},
+                                                             {"flat", true},
+                                                             {"mud", false},
+                                                             {"ceramic", false},
+                                                             {"jade", false},
+                                                             {"normal", false}}};
+  for (const std::pair<const char*, bool>& d : defaults) {
+    Material* newMaterial = new Material();
+    newMaterial->name = d.first;
+    newMaterial->supportsRGB = d.second;
+    newMaterial->isBuiltIn = true;
+    materials.emplace_back(newMaterial);
+  }
 }
 
 
 Material& Engine::getMaterial(const std::string& name) {
   for (std::unique_ptr<Material>& m : materials) {
-    if (name == m->name) return *m;
+    if (name == m->name) {
+      if (m->isBuiltIn && !m->isLoaded()) loadDefaultMaterial(*m);
+      return *m;
+    }
   }
 
   exception("unrecognized material name: " + name);
@@ -996,6 +2003,26 @@ const ValueColorMap& Engine::getColorMap(const std::string& name) {
   return *colorMaps[0];
 }
 
+std::shared_ptr<TextureBuffer> Engine::getColorMapTexture(const std::string& name) {
+  auto it = colorMapTextures.find(name);
+  if (it != colorMapTextures.end()) return it->second;
+
+  const ValueColorMap& colormap = getColorMap(name);
+  std::vector<float> colorBuffer(3 * colormap.values.size());
+  for (size_t i = 0; i < colormap.values.size(); i++) {
+    colorBuffer[3 * i + 0] = static_cast<float>(colormap.values[i][0]);
+    colorBuffer[3 * i + 1] = static_cast<float>(colormap.values[i][1]);
+    colorBuffer[3 * i + 2] = static_cast<float>(colormap.values[i][2]);
+  }
+
+  std::shared_ptr<TextureBuffer> t =
+      generateTextureBuffer(TextureFormat::RGB32F, colormap.values.size(), colorBuffer.data());
+  t->setFilterMode(FilterMode::Linear);
+  t->setMemoryOwner("colormaps");
+  colorMapTextures[name] = t;
+  return t;
+}
+
 
 void Engine::configureImGui() {
 
@@ -3,6 +3,7 @@
 #include "polyscope/render/ground_plane.h"
 
 #include "polyscope/polyscope.h"
+#include "polyscope/profiling.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/render/material_defs.h"
 
@@ -66,6 +67,20 @@ void GroundPlane::populateGroundPlaneGeometry() {
 }
 
 void GroundPlane::prepare() {
+
+  // Release the buffers of the previous mode, only the ones the new mode needs are allocated below
+  groundPlaneProgram.reset();
+  sceneAltColorTexture.reset();
+  sceneAltDepthTexture.reset();
+  sceneAltFrameBuffer.reset();
+  for (int i = 0; i < 2; i++) {
+    blurColorTextures[i].reset();
+    blurFrameBuffers[i].reset();
+  }
+  blurProgram.reset();
+  copyTexProgram.reset();
+  groundPlanePrepared = false;
+
   if (options::groundPlaneMode == GroundPlaneMode::None) {
     return;
   }
@@ -103,20 +118,19 @@ void GroundPlane::prepare() {
   }
 
   // For all effects which will use the alternate scene buffers, prepare them
+  // (they are allocated small, draw() sizes them for the effect before rendering in to them)
   if (options::groundPlaneMode == GroundPlaneMode::TileReflection ||
       options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
 
     if (options::groundPlaneMode == GroundPlaneMode::TileReflection) {
       // only use color buffer for reflection
-      sceneAltColorTexture =
-          render::engine->generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
+      sceneAltColorTexture = render::engine->generateTextureBuffer(TextureFormat::RGBA16F, 1, 1);
       sceneAltColorTexture->setFilterMode(FilterMode::Linear);
     }
-    sceneAltDepthTexture =
-        render::engine->generateTextureBuffer(TextureFormat::DEPTH24, view::bufferWidth, view::bufferHeight);
+    sceneAltDepthTexture = render::engine->generateTextureBuffer(TextureFormat::DEPTH24, 1, 1);
 
 
-    sceneAltFrameBuffer = render::engine->generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+    sceneAltFrameBuffer = render::engine->generateFrameBuffer(1, 1);
     if (options::groundPlaneMode == GroundPlaneMode::TileReflection) {
       sceneAltFrameBuffer->addColorBuffer(sceneAltColorTexture);
     }
@@ -135,11 +149,11 @@ void GroundPlane::prepare() {
 
   if (options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
     // Blur buffers and program
+    // (the shadow is a mask, so one channel is enough)
     for (int i = 0; i < 2; i++) {
-      blurColorTextures[i] =
-          render::engine->generateTextureBuffer(TextureFormat::RGBA16F, view::bufferWidth, view::bufferHeight);
+      blurColorTextures[i] = render::engine->generateTextureBuffer(TextureFormat::R16F, 1, 1);
       blurColorTextures[i]->setFilterMode(FilterMode::Linear);
-      blurFrameBuffers[i] = render::engine->generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+      blurFrameBuffers[i] = render::engine->generateFrameBuffer(1, 1);
 
       blurFrameBuffers[i]->addColorBuffer(blurColorTextures[i]);
       blurFrameBuffers[i]->setDrawBuffers();
@@ -162,13 +176,53 @@ void GroundPlane::prepare() {
     groundPlaneProgram->setTextureFromBuffer("t_minDepth", render::engine->sceneDepthMin.get());
   }
 
+  shadowSignature.clear();
+  reflectionSignature.clear();
   groundPlanePrepared = true;
 }
 
+std::vector<double> GroundPlane::computeShadowSignature(double groundHeight) {
+  // Anything other than the camera which could change the shadow: redraws requested by the scene contents, the ground
+  // plane settings, and structure transforms (which can be set without requesting a redraw)
+  std::vector<double> sig = {static_cast<double>(internal::sceneContentVersion), groundHeight,
+                             static_cast<double>(view::upDir), static_cast<double>(options::shadowBlurIters),
+                             state::lengthScale};
+  for (auto& catMap : state::structures) {
+    for (auto& s : catMap.second) {
+      sig.push_back(s.second->isEnabled());
+      glm::mat4 T = s.second->getTransform();
+      for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+          sig.push_back(T[i][j]);
+        }
+      }
+    }
+  }
+  return sig;
+}
+
+std::vector<double> GroundPlane::computeReflectionSignature(double groundHeight, unsigned int altWidth,
+                                                            unsigned int altHeight) {
+  std::vector<double> sig = computeShadowSignature(groundHeight);
+  glm::mat4 V = view::viewMat;
+  glm::mat4 P = view::getCameraPerspectiveMatrix();
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      sig.push_back(V[i][j]);
+      sig.push_back(P[i][j]);
+    }
+  }
+  sig.push_back(altWidth);
+  sig.push_back(altHeight);
+  sig.push_back(render::engine->getCurrentPixelScaling());
+  return sig;
+}
+
 void GroundPlane::draw(bool isRedraw) {
   if (options::groundPlaneMode == GroundPlaneMode::None) {
     return;
   }
+  profiling::ScopedTimer timer("ground plane", true);
 
   // don't draw ground in planar mode
   if (view::style == view::NavigateStyle::Planar) return;
@@ -178,6 +232,7 @@ void GroundPlane::draw(bool isRedraw) {
   }
   if (view::upDir != groundPlaneViewCached) {
     populateGroundPlaneGeometry();
+    lockedSceneBottomValid = false;
   }
 
   // Get logical "up" direction to which the ground plane is oriented
@@ -194,23 +249,27 @@ void GroundPlane::draw(bool isRedraw) {
 
   // Location for ground plane
   double bboxBottom = sign == 1.0 ? std::get<0>(state::boundingBox)[iP] : std::get<1>(state::boundingBox)[iP];
-  double bboxHeight = std::get<1>(state::boundingBox)[iP] - std::get<0>(state::boundingBox)[iP];
+  if (options::groundPlaneHeightLocked) {
+    if (!lockedSceneBottomValid) {
+      lockedSceneBottom = bboxBottom;
+      lockedSceneBottomValid = true;
+    }
+    bboxBottom = lockedSceneBottom;
+  } else {
+    lockedSceneBottomValid = false;
+  }
   double heightEPS = state::lengthScale * 1e-4;
   double groundHeight = bboxBottom - sign * (options::groundPlaneHeightFactor.asAbsolute() + heightEPS);
 
-  // Viewport
-  glm::vec4 viewport = render::engine->getCurrentViewport();
-  glm::vec2 viewportDim{viewport[2], viewport[3]};
-  int factor = render::engine->getSSAAFactor();
+  float factor = render::engine->getSceneBufferScale();
+  float reflectionScale = glm::clamp(options::groundReflectionScale, 0.05f, 1.f);
+  unsigned int altWidth = std::max(1u, static_cast<unsigned int>(factor * view::bufferWidth * reflectionScale));
+  unsigned int altHeight = std::max(1u, static_cast<unsigned int>(factor * view::bufferHeight * reflectionScale));
 
   auto setUniforms = [&]() {
     glm::mat4 viewMat = view::getCameraViewMatrix();
     groundPlaneProgram->setUniform("u_viewMatrix", glm::value_ptr(viewMat));
 
-    glm::mat4 projMat = view::getCameraPerspectiveMatrix();
-    groundPlaneProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-    groundPlaneProgram->setUniform("u_viewportDim", viewportDim);
-
     if (options::groundPlaneMode == GroundPlaneMode::Tile ||
         options::groundPlaneMode == GroundPlaneMode::TileReflection) {
       groundPlaneProgram->setUniform("u_center", state::center());
@@ -220,6 +279,9 @@ void GroundPlane::draw(bool isRedraw) {
 
     if (options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
       groundPlaneProgram->setUniform("u_shadowDarkness", options::shadowDarkness);
+      groundPlaneProgram->setUniform("u_shadowMapBasisU", shadowMapBasisU);
+      groundPlaneProgram->setUniform("u_shadowMapBasisV", shadowMapBasisV);
+      groundPlaneProgram->setUniform("u_shadowMapOffset", shadowMapOffset);
     }
 
     switch (view::projectionMode) {
@@ -258,15 +320,20 @@ void GroundPlane::draw(bool isRedraw) {
   */
 
   // Render the scene to implement the mirror effect
-  if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::TileReflection) {
+  // This doubles the cost of drawing the scene, so it's skipped on frames where neither the scene nor the camera
+  // changed (e.g. only the UI did), reusing the mirrored image from before.
+  if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::TileReflection &&
+      computeReflectionSignature(groundHeight, altWidth, altHeight) != reflectionSignature) {
+    reflectionSignature = computeReflectionSignature(groundHeight, altWidth, altHeight);
 
     // Prepare the alternate scene buffers
-    // (use a texture 1/4 the area of the view buffer, it's supposed to be blurry anyway and this saves perf)
+    // (at a reduced resolution, by default 1/4 the area of the view buffer, it's supposed to be blurry anyway)
     render::engine->setBlendMode();
     render::engine->setDepthMode();
-    sceneAltFrameBuffer->resize(factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-    sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-    render::engine->setCurrentPixelScaling(factor / 2.);
+    sceneAltFrameBuffer->resize(altWidth, altHeight);
+    sceneAltFrameBuffer->setViewport(0, 0, altWidth, altHeight);
+    float origPixelScaling = render::engine->getCurrentPixelScaling();
+    render::engine->setCurrentPixelScaling(factor * reflectionScale);
 
     sceneAltFrameBuffer->bindForRendering();
     sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
@@ -297,16 +364,21 @@ void GroundPlane::draw(bool isRedraw) {
     // Restore original values
     render::engine->setFrontFaceCCW(!render::engine->getFrontFaceCCW());
     view::viewMat = origViewMat;
+    render::engine->setCurrentPixelScaling(origPixelScaling);
   }
 
   // Render the scene to implement the shadow effect
-  if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::ShadowOnly) {
+  // The shadow map is stored in ground plane coordinates rather than screen coordinates, so it does not depend on the
+  // camera and is only re-rendered when something else in the scene changes.
+  if (!isRedraw && options::groundPlaneMode == GroundPlaneMode::ShadowOnly &&
+      computeShadowSignature(groundHeight) != shadowSignature) {
+    shadowSignature = computeShadowSignature(groundHeight);
 
     // Prepare the alternate scene buffers
     render::engine->setBlendMode();
     render::engine->setDepthMode();
-    sceneAltFrameBuffer->resize(factor * view::bufferWidth, factor * view::bufferHeight);
-    sceneAltFrameBuffer->setViewport(0, 0, factor * view::bufferWidth, factor * view::bufferHeight);
+    sceneAltFrameBuffer->resize(shadowMapResolution, shadowMapResolution);
+    sceneAltFrameBuffer->setViewport(0, 0, shadowMapResolution, shadowMapResolution);
 
     sceneAltFrameBuffer->bindForRendering();
     sceneAltFrameBuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
@@ -314,20 +386,52 @@ void GroundPlane::draw(bool isRedraw) {
 
     // Make sure all framebuffers are the right shape
     for (int i = 0; i < 2; i++) {
-      blurFrameBuffers[i]->resize(factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
-      blurFrameBuffers[i]->setViewport(0, 0, factor * view::bufferWidth / 2, factor * view::bufferHeight / 2);
+      blurFrameBuffers[i]->resize(shadowMapResolution / 2, shadowMapResolution / 2);
+      blurFrameBuffers[i]->setViewport(0, 0, shadowMapResolution / 2, shadowMapResolution / 2);
       blurFrameBuffers[i]->clear();
     }
 
     // Render to a texture so we can sample from it on the ground
     sceneAltFrameBuffer->bindForRendering();
 
-    // Push a view matrix which projects on to the ground plane
+    // Push a view matrix which flattens the scene on to the ground plane, and then lays the plane out facing the camera
+    // at a fixed depth. Every point then lands at the same depth, so the camera projection acts as a 2D affine map from
+    // ground coordinates to the shadow map. We fit that map to cover the footprint of the scene.
+    int iA = (iP + 1) % 3;
+    int iB = (iP + 2) % 3;
+    glm::vec3 bboxMin = std::get<0>(state::boundingBox);
+    glm::vec3 bboxMax = std::get<1>(state::boundingBox);
+    glm::vec3 bboxCenter = 0.5f * (bboxMin + bboxMax);
+    float pad = 0.05 * state::lengthScale;
+    float halfA = 0.6 * (bboxMax[iA] - bboxMin[iA]) + pad;
+    float halfB = 0.6 * (bboxMax[iB] - bboxMin[iB]) + pad;
+
+    glm::mat4 P = view::getCameraPerspectiveMatrix();
+    float nearClip = view::nearClipRatio * state::lengthScale;
+    float farClip = view::farClipRatio * state::lengthScale;
+    float mapDepth = 0.5 * (nearClip + farClip);
+    if (view::projectionMode == ProjectionMode::Perspective) {
+      mapDepth = glm::clamp(std::max(P[0][0] * halfA, P[1][1] * halfB), 1.5f * nearClip, 0.5f * farClip);
+    }
+    float w = -P[2][3] * mapDepth + P[3][3];
+    glm::vec2 ndcScale{P[0][0] / w, P[1][1] / w};
+    glm::vec2 ndcShift{(-P[2][0] * mapDepth + P[3][0]) / w, (-P[2][1] * mapDepth + P[3][1]) / w};
+    float s = std::min(1.f, std::min(1.f / (ndcScale.x * halfA), 1.f / (ndcScale.y * halfB)));
+
     glm::mat4 origViewMat = view::viewMat;
-    glm::mat4 projMat = glm::mat4(1.0);
-    projMat[iP][iP] = 0.;
-    projMat[3][iP] = groundHeight;
-    view::viewMat = view::viewMat * projMat;
+    glm::mat4 mapViewMat(0.f);
+    mapViewMat[iA][0] = s;
+    mapViewMat[iB][1] = s;
+    mapViewMat[3] = glm::vec4{-s * bboxCenter[iA], -s * bboxCenter[iB], -mapDepth, 1.};
+    view::viewMat = mapViewMat;
+
+    // The inverse map, used by the ground shader to look up the shadow at each point:
+    // uv = 0.5 * (ndcScale * s * (p - center) + ndcShift) + 0.5
+    shadowMapBasisU = glm::vec3{0., 0., 0.};
+    shadowMapBasisV = glm::vec3{0., 0., 0.};
+    shadowMapBasisU[iA] = 0.5 * ndcScale.x * s;
+    shadowMapBasisV[iB] = 0.5 * ndcScale.y * s;
+    shadowMapOffset = 0.5f * (ndcShift - ndcScale * s * glm::vec2{bboxCenter[iA], bboxCenter[iB]}) + 0.5f;
 
     // Draw everything
     render::engine->setDepthMode();
@@ -342,7 +446,7 @@ void GroundPlane::draw(bool isRedraw) {
     // == Blur
 
     // Do some blur iterations (ends in same buffer it started in)
-    int nBlur = options::shadowBlurIters * render::engine->getSSAAFactor();
+    int nBlur = options::shadowBlurIters;
     // int nBlur = 0;
     for (int i = 0; i < nBlur; i++) {
       // horizontal blur
@@ -407,6 +511,7 @@ void GroundPlane::buildGui() {
     ImGui::PopItemWidth();
 
     if (ImGui::SliderFloat("Height", options::groundPlaneHeightFactor.getValuePtr(), -1.0, 1.0)) requestRedraw();
+    if (ImGui::Checkbox("Lock height", &options::groundPlaneHeightLocked)) requestRedraw();
 
     switch (options::groundPlaneMode) {
     case GroundPlaneMode::None:
@@ -414,6 +519,7 @@ void GroundPlane::buildGui() {
     case GroundPlaneMode::Tile:
       break;
     case GroundPlaneMode::TileReflection:
+      if (ImGui::SliderFloat("Reflection Resolution", &options::groundReflectionScale, 0.1, 1.0)) requestRedraw();
       break;
     case GroundPlaneMode::ShadowOnly:
       if (ImGui::SliderFloat("Shadow Darkness", &options::shadowDarkness, .0, 1.0)) requestRedraw();
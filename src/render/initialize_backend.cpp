@@ -3,6 +3,8 @@
 #include "polyscope/messages.h"
 #include "polyscope/render/engine.h"
 
+#include <cstdlib>
+
 namespace polyscope {
 namespace render {
 
@@ -16,6 +18,7 @@ std::string engineBackendName = "";
 // we don't want to just include the appropriate headers, because they may define conflicting symbols
 namespace backend_openGL3_glfw {
 void initializeRenderEngine();
+void initializeRenderEngineHeadlessEGL();
 }
 namespace backend_openGL_mock {
 void initializeRenderEngine();
@@ -37,6 +40,13 @@ void initializeRenderEngine(std::string backend) {
     backend = "openGL3_glfw";
 #endif
 
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+    // With no display to open a window on (e.g. a headless GPU server), render offscreen instead
+    if (std::getenv("DISPLAY") == nullptr && std::getenv("WAYLAND_DISPLAY") == nullptr) {
+      backend = "openGL3_egl";
+    }
+#endif
+
     if (backend == "") {
       exception("no Polyscope backends available");
     }
@@ -47,8 +57,14 @@ void initializeRenderEngine(std::string backend) {
   // Initialize the appropriate backend
   if (backend == "openGL3_glfw") {
     backend_openGL3_glfw::initializeRenderEngine();
+  } else if (backend == "openGL3_egl") {
+    backend_openGL3_glfw::initializeRenderEngineHeadlessEGL();
   } else if (backend == "openGL_mock") {
     backend_openGL_mock::initializeRenderEngine();
+  } else if (backend == "vulkan") {
+    // The shaders are assembled from GLSL source and replacement rules at runtime, so a Vulkan backend would also need
+    // a runtime SPIR-V compiler. Neither is part of this build yet.
+    exception("the vulkan backend is not available in this build of Polyscope, use openGL3_glfw or openGL3_egl");
   } else {
     exception("unrecognized Polyscope backend " + backend);
   }
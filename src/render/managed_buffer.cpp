@@ -1,6 +1,10 @@
 // Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
 
 
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include "polyscope/render/managed_buffer.h"
@@ -14,23 +18,271 @@
 namespace polyscope {
 namespace render {
 
+namespace {
+// All live managed buffers, for memory accounting. Intentionally leaked, like the render buffer registries in
+// engine.cpp.
+struct ManagedBufferRecord {
+  const std::string* name;
+  std::function<size_t()> hostSizeInBytes;
+  std::function<void()> releaseRenderBuffers;
+  std::function<void(uint64_t, size_t)> updateIndexedViewsOf; // re-gather views which use the index buffer with this ID
+  std::function<void()> flushDeferredUpdate;
+  std::function<void()> compressHostData;
+  std::function<bool()> decompressHostData; // returns true if the data was compressed
+};
+std::unordered_map<const void*, ManagedBufferRecord>& liveManagedBuffers() {
+  static std::unordered_map<const void*, ManagedBufferRecord>* buffers =
+      new std::unordered_map<const void*, ManagedBufferRecord>();
+  return *buffers;
+}
+
+// Like gather(), but returns false rather than reading out of bounds. While a mesh's connectivity is being updated, the
+// values and the indices of a view change one at a time, and the view is gathered again once both have.
+template <typename T>
+bool gatherIfInBounds(const std::vector<T>& input, const std::vector<uint32_t>& inds, std::vector<T>& result) {
+  for (uint32_t i : inds) {
+    if (i >= input.size()) return false;
+  }
+  result = gather(input, inds);
+  return true;
+}
+
+// Open update batches, and the buffers with deferred updates (see beginManagedBufferUpdateBatch())
+int updateBatchDepth = 0;
+std::vector<const void*> buffersWithDeferredUpdates;
+
+bool hasPrefix(const std::string& str, const std::string& prefix) {
+  return str.size() >= prefix.size() && str.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Texture layout of the supported texture view types (see getTextureViewBuffer()), returning the number of components
+// per entry, or 0 if the type cannot be viewed as a texture
+template <typename T>
+size_t textureViewFormat(TextureFormat& format) {
+  return 0;
+}
+template <>
+size_t textureViewFormat<float>(TextureFormat& format) {
+  format = TextureFormat::R32F;
+  return 1;
+}
+template <>
+size_t textureViewFormat<uint32_t>(TextureFormat& format) {
+  format = TextureFormat::R32F;
+  return 1;
+}
+template <>
+size_t textureViewFormat<glm::vec3>(TextureFormat& format) {
+  format = TextureFormat::RGB32F;
+  return 3;
+}
+
+template <typename T>
+void appendTexel(std::vector<float>& texels, const T& val) {}
+void appendTexel(std::vector<float>& texels, const float& val) { texels.push_back(val); }
+void appendTexel(std::vector<float>& texels, const uint32_t& val) { texels.push_back(static_cast<float>(val)); }
+void appendTexel(std::vector<float>& texels, const glm::vec3& val) {
+  texels.push_back(val.x);
+  texels.push_back(val.y);
+  texels.push_back(val.z);
+}
+
+// Lossless compression of host data (see compressHostData()). The bytes are split in to planes, one for each byte of
+// an entry, and each byte is XORed with the same byte of the previous entry, so that repeated or slowly-varying values
+// (and the sign and exponent bytes of most floats) turn in to runs of zeros. Those are then run-length encoded: a
+// control byte c with the high bit set stands for (c & 0x7F) + 1 zeros, otherwise the c + 1 bytes after it are copied.
+void compressBytes(const uint8_t* src, size_t nEntries, size_t entrySize, std::vector<uint8_t>& out) {
+  out.clear();
+  uint8_t literals[128];
+  size_t nLiterals = 0;
+  size_t nZeros = 0;
+  auto flushLiterals = [&]() {
+    if (nLiterals == 0) return;
+    out.push_back(static_cast<uint8_t>(nLiterals - 1));
+    out.insert(out.end(), literals, literals + nLiterals);
+    nLiterals = 0;
+  };
+  auto flushZeros = [&]() {
+    if (nZeros == 0) return;
+    out.push_back(static_cast<uint8_t>(0x80 | (nZeros - 1)));
+    nZeros = 0;
+  };
+
+  for (size_t iByte = 0; iByte < entrySize; iByte++) {
+    uint8_t prev = 0;
+    for (size_t i = 0; i < nEntries; i++) {
+      uint8_t val = src[i * entrySize + iByte];
+      uint8_t delta = val ^ prev;
+      prev = val;
+      if (delta == 0) {
+        flushLiterals();
+        if (++nZeros == 128) flushZeros();
+      } else {
+        flushZeros();
+        literals[nLiterals++] = delta;
+        if (nLiterals == 128) flushLiterals();
+      }
+    }
+  }
+  flushLiterals();
+  flushZeros();
+}
+
+void decompressBytes(const std::vector<uint8_t>& in, size_t nEntries, size_t entrySize, uint8_t* dst) {
+  size_t total = nEntries * entrySize;
+  size_t pos = 0; // in plane order
+  uint8_t prev = 0;
+  auto emit = [&](uint8_t delta) {
+    size_t iByte = pos / nEntries;
+    size_t i = pos % nEntries;
+    if (i == 0) prev = 0;
+    prev ^= delta;
+    dst[i * entrySize + iByte] = prev;
+    pos++;
+  };
+
+  size_t iIn = 0;
+  while (iIn < in.size() && pos < total) {
+    uint8_t c = in[iIn++];
+    size_t count = (c & 0x7F) + 1;
+    for (size_t j = 0; j < count && pos < total; j++) {
+      emit((c & 0x80) ? 0 : in[iIn++]);
+    }
+  }
+  if (pos != total) exception("corrupt compressed data in ManagedBuffer");
+}
+
+} // namespace
+
+size_t getManagedBufferHostBytes(const std::string& namePrefix) {
+  size_t total = 0;
+  for (const std::pair<const void* const, ManagedBufferRecord>& entry : liveManagedBuffers()) {
+    if (hasPrefix(*entry.second.name, namePrefix)) total += entry.second.hostSizeInBytes();
+  }
+  return total;
+}
+
+void releaseManagedBufferRenderBuffers(const std::string& namePrefix) {
+  // collect first, reading back data may touch the registry
+  std::vector<std::function<void()>> toRelease;
+  for (const std::pair<const void* const, ManagedBufferRecord>& entry : liveManagedBuffers()) {
+    if (hasPrefix(*entry.second.name, namePrefix)) toRelease.push_back(entry.second.releaseRenderBuffers);
+  }
+  for (std::function<void()>& f : toRelease) {
+    f();
+  }
+}
+
+void compressManagedBufferHostData(const std::string& namePrefix) {
+  // collect first, reading back data may touch the registry
+  std::vector<std::function<void()>> toCompress;
+  for (const std::pair<const void* const, ManagedBufferRecord>& entry : liveManagedBuffers()) {
+    if (hasPrefix(*entry.second.name, namePrefix)) toCompress.push_back(entry.second.compressHostData);
+  }
+  for (std::function<void()>& f : toCompress) {
+    f();
+  }
+}
+
+size_t decompressManagedBufferHostData(const std::string& namePrefix) {
+  std::vector<std::function<bool()>> toDecompress;
+  for (const std::pair<const void* const, ManagedBufferRecord>& entry : liveManagedBuffers()) {
+    if (hasPrefix(*entry.second.name, namePrefix)) toDecompress.push_back(entry.second.decompressHostData);
+  }
+  size_t count = 0;
+  for (std::function<bool()>& f : toDecompress) {
+    if (f()) count++;
+  }
+  return count;
+}
+
+void beginManagedBufferUpdateBatch() { updateBatchDepth++; }
+
+void endManagedBufferUpdateBatch() {
+  if (updateBatchDepth == 0) exception("endManagedBufferUpdateBatch() without a matching begin");
+  updateBatchDepth--;
+  if (updateBatchDepth > 0) return;
+
+  // (each flush brings that buffer and the views gathered from it up to date, so the order does not matter)
+  std::vector<const void*> toFlush;
+  toFlush.swap(buffersWithDeferredUpdates);
+  for (const void* ptr : toFlush) {
+    auto it = liveManagedBuffers().find(ptr);
+    if (it != liveManagedBuffers().end()) it->second.flushDeferredUpdate(); // (may have been deleted since)
+  }
+}
+
+// Indexed views of other buffers are gathered through index buffers, so when the indices change those views must be
+// re-gathered too. If only the indices from firstChanged onward are new (appended), only those entries are gathered.
+void updateIndexedViewsUsing(uint64_t indicesID, size_t firstChanged) {
+  // collect first, updating the views may touch the registry
+  std::vector<std::function<void(uint64_t, size_t)>> toUpdate;
+  for (const std::pair<const void* const, ManagedBufferRecord>& entry : liveManagedBuffers()) {
+    toUpdate.push_back(entry.second.updateIndexedViewsOf);
+  }
+  for (std::function<void(uint64_t, size_t)>& f : toUpdate) {
+    f(indicesID, firstChanged);
+  }
+}
+
 template <typename T>
 ManagedBuffer<T>::ManagedBuffer(const std::string& name_, std::vector<T>& data_)
     : name(name_), uniqueID(internal::getNextUniqueID()), data(data_), dataGetsComputed(false),
-      hostBufferIsPopulated(true) {}
+      hostBufferIsPopulated(true), readbackCache(std::make_shared<ReadbackCache>()) {
+  liveManagedBuffers()[this] =
+      ManagedBufferRecord{&name, [this]() { return hostSizeInBytes(); }, [this]() { releaseRenderBuffers(); },
+                          [this](uint64_t indicesID, size_t firstChanged) {
+                            updateIndexedViewsOf(indicesID, firstChanged);
+                          },
+                          [this]() { flushDeferredUpdate(); }, [this]() { compressHostData(); },
+                          [this]() {
+                            bool wasCompressed = hostDataIsCompressed();
+                            decompressHostData();
+                            return wasCompressed;
+                          }};
+}
 
 template <typename T>
 ManagedBuffer<T>::ManagedBuffer(const std::string& name_, std::vector<T>& data_, std::function<void()> computeFunc_)
     : name(name_), uniqueID(internal::getNextUniqueID()), data(data_), dataGetsComputed(true),
-      computeFunc(computeFunc_), hostBufferIsPopulated(false) {}
+      computeFunc(computeFunc_), hostBufferIsPopulated(false), readbackCache(std::make_shared<ReadbackCache>()) {
+  liveManagedBuffers()[this] =
+      ManagedBufferRecord{&name, [this]() { return hostSizeInBytes(); }, [this]() { releaseRenderBuffers(); },
+                          [this](uint64_t indicesID, size_t firstChanged) {
+                            updateIndexedViewsOf(indicesID, firstChanged);
+                          },
+                          [this]() { flushDeferredUpdate(); }, [this]() { compressHostData(); },
+                          [this]() {
+                            bool wasCompressed = hostDataIsCompressed();
+                            decompressHostData();
+                            return wasCompressed;
+                          }};
+}
+
+template <typename T>
+ManagedBuffer<T>::~ManagedBuffer() {
+  liveManagedBuffers().erase(this);
+}
+
+template <typename T>
+size_t ManagedBuffer<T>::hostSizeInBytes() const {
+  if (sharedSource) return 0; // (counted for the source)
+  return data.size() * sizeof(T) + compressedData.size();
+}
 
 
 template <typename T>
 void ManagedBuffer<T>::ensureHostBufferPopulated() {
+  if (sharedSource) return sharedSource->ensureHostBufferPopulated();
 
   switch (currentCanonicalDataSource()) {
   case CanonicalDataSource::HostData:
-    // good to go, nothing needs to be done
+    // good to go, nothing needs to be done (except copying if the data is external)
+    copyExternalDataToHost();
+    break;
+
+  case CanonicalDataSource::Compressed:
+    decompressHostData();
     break;
 
   case CanonicalDataSource::NeedsCompute:
@@ -46,34 +298,220 @@ void ManagedBuffer<T>::ensureHostBufferPopulated() {
     if (!renderAttributeBuffer) exception("render buffer should be allocated but isn't");
 
     // copy the data back from the renderBuffer
-    data = getAttributeBufferDataRange<T>(*renderAttributeBuffer, 0, renderAttributeBuffer->getDataSize());
+    data = getAttributeBufferDataRange<T>(*renderAttributeBuffer, 0,
+                                          renderAttributeBuffer->getDataSize() / renderAttributeBuffer->getArrayCount());
+    hostBufferIsPopulated = true;
 
     break;
   };
 }
 
+template <typename T>
+void ManagedBuffer<T>::ensureHostBufferPopulatedAsync(std::function<void()> callback) {
+  if (sharedSource) return sharedSource->ensureHostBufferPopulatedAsync(callback);
+
+  if (currentCanonicalDataSource() != CanonicalDataSource::RenderBuffer) {
+    ensureHostBufferPopulated();
+    callback();
+    return;
+  }
+
+  std::weak_ptr<ReadbackCache> weakCache = readbackCache;
+  uint64_t version = readbackCache->version;
+  getAttributeBufferDataRangeAsync<T>(*renderAttributeBuffer, 0, size(),
+                                      [this, weakCache, version, callback](std::vector<T> vals) {
+                                        std::shared_ptr<ReadbackCache> cache = weakCache.lock();
+                                        if (!cache) return; // the buffer is gone
+
+                                        // if the render buffer was updated while the read was in flight, read again
+                                        if (cache->version != version) {
+                                          ensureHostBufferPopulatedAsync(callback);
+                                          return;
+                                        }
+
+                                        if (currentCanonicalDataSource() == CanonicalDataSource::RenderBuffer) {
+                                          data = vals;
+                                          hostBufferIsPopulated = true;
+                                        }
+                                        callback();
+                                      });
+}
+
 template <typename T>
 std::vector<T>& ManagedBuffer<T>::getPopulatedHostBufferRef() {
+  if (sharedSource) return sharedSource->getPopulatedHostBufferRef();
   ensureHostBufferPopulated();
   return data;
 }
 
+template <typename T>
+void ManagedBuffer<T>::setExternalData(const T* ptr, size_t n, std::shared_ptr<const void> owner) {
+  if (sharedSource) return sharedSource->setExternalData(ptr, n, owner);
+  // Doubles get converted to floats on upload, so they cannot be uploaded directly
+  if (std::is_same<T, double>::value) {
+    exception("ManagedBuffer " + name + " cannot use external data, the type does not match the render buffer layout");
+  }
+  if (ptr == nullptr && n > 0) exception("ManagedBuffer " + name + " setExternalData() with null pointer");
+
+  std::vector<T>().swap(data); // actually release the memory
+  externalData = ptr;
+  externalDataSize = n;
+  externalDataOwner = owner;
+
+  markHostBufferUpdated();
+}
+
+template <typename T>
+bool ManagedBuffer<T>::hasExternalData() const {
+  if (sharedSource) return sharedSource->hasExternalData();
+  return externalData != nullptr;
+}
+
+template <typename T>
+const T* ManagedBuffer<T>::getPopulatedHostDataPtr() {
+  if (sharedSource) return sharedSource->getPopulatedHostDataPtr();
+  if (hostBufferIsPopulated && externalData) {
+    return externalData;
+  }
+  ensureHostBufferPopulated();
+  return data.data();
+}
+
+template <typename T>
+void ManagedBuffer<T>::copyExternalDataToHost() {
+  if (!externalData) return;
+  data.assign(externalData, externalData + externalDataSize);
+  externalData = nullptr;
+  externalDataSize = 0;
+  externalDataOwner.reset();
+}
+
 template <typename T>
 void ManagedBuffer<T>::markHostBufferUpdated() {
+  if (sharedSource) return sharedSource->markHostBufferUpdated();
   hostBufferIsPopulated = true;
+  discardCompressedData(); // (if the host data was compressed, the caller replaced it)
+
+  // `data` is always empty while using external data; if it has been filled, the caller replaced the values
+  if (externalData && !data.empty()) {
+    externalData = nullptr;
+    externalDataSize = 0;
+    externalDataOwner.reset();
+  }
+
+  if (deferUpdate(true, 0, 0)) return;
 
   // If the data is stored in the device-side buffers, update it as needed
   if (renderAttributeBuffer) {
-    renderAttributeBuffer->setData(data);
-    requestRedraw();
+    if (externalData) {
+      renderAttributeBuffer->setDataRaw(externalData, externalDataSize);
+    } else {
+      renderAttributeBuffer->setData(data);
+    }
+    internal::requestRedrawForStructure(name);
   }
+
+  if (!existingIndexedViews.empty()) {
+    updateIndexedViews();
+    internal::requestRedrawForStructure(name);
+  }
+
+  if (textureView) {
+    updateTextureView();
+    internal::requestRedrawForStructure(name);
+  }
+
+  if (std::is_same<T, uint32_t>::value) {
+    updateIndexedViewsUsing(uniqueID, 0);
+  }
+
+  releaseHostBufferIfAllowed();
+}
+
+template <typename T>
+void ManagedBuffer<T>::appendData(const std::vector<T>& newValues) {
+  if (sharedSource) return sharedSource->appendData(newValues);
+  if (newValues.empty()) return;
+
+  ensureHostBufferPopulated();
+  copyExternalDataToHost();
+  size_t oldSize = data.size();
+  data.insert(data.end(), newValues.begin(), newValues.end());
+  hostBufferIsPopulated = true;
+
+  // Indexed views of this buffer are unchanged; their indices only refer to the old entries
+  if (renderAttributeBuffer) {
+    renderAttributeBuffer->appendData(data, oldSize, data.size());
+    internal::requestRedrawForStructure(name);
+  }
+
+  if (textureView) {
+    updateTextureView(); // (always re-uploaded whole)
+    internal::requestRedrawForStructure(name);
+  }
+
+  if (std::is_same<T, uint32_t>::value) {
+    updateIndexedViewsUsing(uniqueID, oldSize);
+  }
+
+  releaseHostBufferIfAllowed();
+}
+
+template <typename T>
+void ManagedBuffer<T>::markHostBufferRangeUpdated(size_t rangeStart, size_t rangeEnd) {
+  if (sharedSource) return sharedSource->markHostBufferRangeUpdated(rangeStart, rangeEnd);
+  // External data is always re-uploaded whole
+  if (hostBufferIsPopulated && externalData && data.empty()) {
+    markHostBufferUpdated();
+    return;
+  }
+
+  if (rangeStart > rangeEnd || rangeEnd > data.size()) {
+    exception("bad range [" + std::to_string(rangeStart) + "," + std::to_string(rangeEnd) +
+              ") in ManagedBuffer " + name + " markHostBufferRangeUpdated()");
+  }
+
+  // If the host buffer was not valid before, there is no previous data to partially update
+  if (!hostBufferIsPopulated) {
+    markHostBufferUpdated();
+    return;
+  }
+
+  if (rangeStart == rangeEnd) return;
+  if (deferUpdate(false, rangeStart, rangeEnd)) return;
+
+  if (renderAttributeBuffer) {
+    renderAttributeBuffer->setDataRange(data, rangeStart, rangeEnd, rangeStart);
+    internal::requestRedrawForStructure(name);
+  }
+
+  if (!existingIndexedViews.empty()) {
+    updateIndexedViewsRange(rangeStart, rangeEnd);
+    internal::requestRedrawForStructure(name);
+  }
+
+  if (textureView) {
+    updateTextureView(); // (always re-uploaded whole)
+    internal::requestRedrawForStructure(name);
+  }
+
+  releaseHostBufferIfAllowed();
 }
 
 template <typename T>
 T ManagedBuffer<T>::getValue(size_t ind) {
+  if (sharedSource) return sharedSource->getValue(ind);
 
   switch (currentCanonicalDataSource()) {
   case CanonicalDataSource::HostData:
+    if (ind >= size())
+      exception("out of bounds access in ManagedBuffer " + name + " getValue(" + std::to_string(ind) + ")");
+    if (externalData) return externalData[ind];
+    return data[ind];
+    break;
+
+  case CanonicalDataSource::Compressed:
+    decompressHostData();
     if (ind >= data.size())
       exception("out of bounds access in ManagedBuffer " + name + " getValue(" + std::to_string(ind) + ")");
     return data[ind];
@@ -89,6 +527,8 @@ T ManagedBuffer<T>::getValue(size_t ind) {
   case CanonicalDataSource::RenderBuffer:
     if (static_cast<int64_t>(ind) >= renderAttributeBuffer->getDataSize())
       exception("out of bounds access in ManagedBuffer " + name + " getValue(" + std::to_string(ind) + ")");
+    typename std::unordered_map<size_t, T>::iterator cached = readbackCache->values.find(ind);
+    if (cached != readbackCache->values.end()) return cached->second;
     T val = getAttributeBufferData<T>(*renderAttributeBuffer, ind);
     return val;
     break;
@@ -97,20 +537,80 @@ T ManagedBuffer<T>::getValue(size_t ind) {
   return T(); // dummy return
 }
 
+template <typename T>
+void ManagedBuffer<T>::getValueAsync(size_t ind, std::function<void(T)> callback) {
+  if (sharedSource) return sharedSource->getValueAsync(ind, callback);
+
+  if (currentCanonicalDataSource() != CanonicalDataSource::RenderBuffer) {
+    callback(getValue(ind));
+    return;
+  }
+
+  typename std::unordered_map<size_t, T>::iterator cached = readbackCache->values.find(ind);
+  if (cached != readbackCache->values.end()) {
+    callback(cached->second);
+    return;
+  }
+
+  if (ind >= size())
+    exception("out of bounds access in ManagedBuffer " + name + " getValueAsync(" + std::to_string(ind) + ")");
+
+  readbackCache->pending.insert(ind);
+  std::weak_ptr<ReadbackCache> weakCache = readbackCache;
+  uint64_t version = readbackCache->version;
+  getAttributeBufferDataRangeAsync<T>(*renderAttributeBuffer, ind, 1,
+                                      [weakCache, version, ind, callback](std::vector<T> vals) {
+                                        std::shared_ptr<ReadbackCache> cache = weakCache.lock();
+                                        if (!cache) return; // the buffer is gone
+                                        if (cache->version == version) {
+                                          cache->pending.erase(ind);
+                                          if (cache->values.size() >= maxCachedReadbackValues) cache->values.clear();
+                                          cache->values[ind] = vals[0];
+                                        }
+                                        callback(vals[0]);
+                                      });
+}
+
+template <typename T>
+bool ManagedBuffer<T>::tryGetValue(size_t ind, T& val) {
+  if (sharedSource) return sharedSource->tryGetValue(ind, val);
+
+  if (currentCanonicalDataSource() != CanonicalDataSource::RenderBuffer) {
+    val = getValue(ind);
+    return true;
+  }
+
+  if (readbackCache->pending.find(ind) == readbackCache->pending.end()) {
+    getValueAsync(ind, [](T) {});
+  }
+
+  // (backends without async reads have already delivered it)
+  typename std::unordered_map<size_t, T>::iterator cached = readbackCache->values.find(ind);
+  if (cached == readbackCache->values.end()) return false;
+  val = cached->second;
+  return true;
+}
+
 template <typename T>
 size_t ManagedBuffer<T>::size() {
+  if (sharedSource) return sharedSource->size();
 
   switch (currentCanonicalDataSource()) {
   case CanonicalDataSource::HostData:
+    if (externalData) return externalDataSize;
     return data.size();
     break;
 
+  case CanonicalDataSource::Compressed:
+    return compressedDataSize;
+    break;
+
   case CanonicalDataSource::NeedsCompute:
     return 0;
     break;
 
   case CanonicalDataSource::RenderBuffer:
-    return renderAttributeBuffer->getDataSize();
+    return renderAttributeBuffer->getDataSize() / renderAttributeBuffer->getArrayCount();
     break;
   };
 
@@ -119,14 +619,42 @@ size_t ManagedBuffer<T>::size() {
 
 template <typename T>
 bool ManagedBuffer<T>::hasData() {
-  if (hostBufferIsPopulated || renderAttributeBuffer) {
+  if (sharedSource) return sharedSource->hasData();
+  if (hostBufferIsPopulated || hostDataCompressed || renderAttributeBuffer) {
     return true;
   }
   return false;
 }
 
+template <typename T>
+bool ManagedBuffer<T>::dataIsDeviceOnly() {
+  if (sharedSource) return sharedSource->dataIsDeviceOnly();
+  return currentCanonicalDataSource() == CanonicalDataSource::RenderBuffer;
+}
+
+template <typename T>
+void ManagedBuffer<T>::setStreaming(bool newVal) {
+  if (sharedSource) return sharedSource->setStreaming(newVal);
+  if (newVal == streaming) return;
+  streaming = newVal;
+
+  if (renderAttributeBuffer) renderAttributeBuffer->setStreaming(streaming);
+  for (std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>& existingViewTup :
+       existingIndexedViews) {
+    std::shared_ptr<render::AttributeBuffer> viewBufferPtr = std::get<1>(existingViewTup).lock();
+    if (viewBufferPtr) viewBufferPtr->setStreaming(streaming);
+  }
+}
+
+template <typename T>
+bool ManagedBuffer<T>::getStreaming() {
+  if (sharedSource) return sharedSource->getStreaming();
+  return streaming;
+}
+
 template <typename T>
 void ManagedBuffer<T>::recomputeIfPopulated() {
+  if (sharedSource) return sharedSource->recomputeIfPopulated();
   if (!dataGetsComputed) { // sanity check
     exception("called recomputeIfPopulated() on buffer which does not get computed");
   }
@@ -143,24 +671,132 @@ void ManagedBuffer<T>::recomputeIfPopulated() {
 
 template <typename T>
 std::shared_ptr<render::AttributeBuffer> ManagedBuffer<T>::getRenderAttributeBuffer() {
+  if (sharedSource) return sharedSource->getRenderAttributeBuffer();
   if (!renderAttributeBuffer) {
+    if (hostBufferIsPopulated && externalData) {
+      // upload straight from the external memory
+      renderAttributeBuffer = generateAttributeBuffer<T>(render::engine);
+      renderAttributeBuffer->setMemoryOwner(name);
+      renderAttributeBuffer->setStreaming(streaming);
+      renderAttributeBuffer->setResizable(true);
+      renderAttributeBuffer->setDataRaw(externalData, externalDataSize);
+      return renderAttributeBuffer;
+    }
+
     ensureHostBufferPopulated(); // warning: the order of these matters because of how hostBufferPopulated works
     renderAttributeBuffer = generateAttributeBuffer<T>(render::engine);
+    renderAttributeBuffer->setMemoryOwner(name);
+    renderAttributeBuffer->setStreaming(streaming);
+    renderAttributeBuffer->setResizable(true); // the data may change length, e.g. when a mesh's connectivity changes
     renderAttributeBuffer->setData(data);
+    releaseHostBufferIfAllowed();
   }
   return renderAttributeBuffer;
 }
 
+template <typename T>
+std::shared_ptr<render::AttributeBuffer> ManagedBuffer<T>::getRenderAttributeBufferForDeviceWrite(size_t n) {
+  if (sharedSource) return sharedSource->getRenderAttributeBufferForDeviceWrite(n);
+  if (std::is_same<T, double>::value) {
+    exception("ManagedBuffer " + name + " holds doubles, which cannot be written directly in the render buffer");
+  }
+  if (n == 0) exception("ManagedBuffer " + name + " cannot be written on the device with zero entries");
+
+  if (hasData()) getRenderAttributeBuffer(); // (keeps the current values, in case only some get written)
+
+  if (renderAttributeBuffer && renderAttributeBuffer->isSet()) {
+    if (size() != n) renderAttributeBuffer->resize(n);
+  } else {
+    renderAttributeBuffer = generateAttributeBuffer<T>(render::engine);
+    renderAttributeBuffer->setMemoryOwner(name);
+    renderAttributeBuffer->setStreaming(streaming);
+    renderAttributeBuffer->setResizable(true);
+    renderAttributeBuffer->setDataRaw(nullptr, n);
+  }
+
+  invalidateHostBuffer();
+  return renderAttributeBuffer;
+}
+
+template <typename T>
+void ManagedBuffer<T>::releaseRenderBuffers() {
+  if (sharedSource) return; // (the source owns them)
+  if (renderAttributeBuffer) {
+    // the render buffer might hold the only copy
+    if (!hostBufferIsPopulated) ensureHostBufferPopulated();
+    renderAttributeBuffer.reset();
+  }
+  existingIndexedViews.clear();
+  textureView.reset();
+}
+
+template <typename T>
+void ManagedBuffer<T>::reset() {
+  if (sharedSource) return;
+  invalidateHostBuffer();
+  hostBufferIsPopulated = !dataGetsComputed; // (externally-set data is now empty)
+  renderAttributeBuffer.reset();
+  existingIndexedViews.clear();
+  textureView.reset();
+}
+
+template <typename T>
+void ManagedBuffer<T>::compressHostData() {
+  if (sharedSource || hostDataCompressed || externalData || updateDeferred) return;
+  if (!hostBufferIsPopulated) {
+    if (!renderAttributeBuffer) return; // (not computed yet, nothing to compress)
+    ensureHostBufferPopulated();
+  }
+  releaseRenderBuffers();
+
+  std::vector<uint8_t> packed;
+  compressBytes(reinterpret_cast<const uint8_t*>(data.data()), data.size(), sizeof(T), packed);
+  if (packed.size() >= data.size() * sizeof(T)) return; // doesn't compress
+
+  compressedData.swap(packed);
+  compressedDataSize = data.size();
+  hostDataCompressed = true;
+  hostBufferIsPopulated = false;
+  std::vector<T>().swap(data); // actually release the memory
+}
+
+template <typename T>
+void ManagedBuffer<T>::decompressHostData() {
+  if (sharedSource || !hostDataCompressed) return;
+  data.resize(compressedDataSize);
+  decompressBytes(compressedData, compressedDataSize, sizeof(T), reinterpret_cast<uint8_t*>(data.data()));
+  hostBufferIsPopulated = true;
+  discardCompressedData();
+}
+
+template <typename T>
+bool ManagedBuffer<T>::hostDataIsCompressed() const {
+  if (sharedSource) return sharedSource->hostDataIsCompressed();
+  return hostDataCompressed;
+}
+
+template <typename T>
+void ManagedBuffer<T>::discardCompressedData() {
+  hostDataCompressed = false;
+  compressedDataSize = 0;
+  std::vector<uint8_t>().swap(compressedData);
+}
+
 template <typename T>
 void ManagedBuffer<T>::markRenderAttributeBufferUpdated() {
+  if (sharedSource) return sharedSource->markRenderAttributeBufferUpdated();
   invalidateHostBuffer();
   updateIndexedViews();
-  requestRedraw();
+  if (textureView) updateTextureView();
+  internal::requestRedrawForStructure(name);
 }
 
 template <typename T>
 std::shared_ptr<render::AttributeBuffer>
-ManagedBuffer<T>::getIndexedRenderAttributeBuffer(ManagedBuffer<uint32_t>& indices) {
+ManagedBuffer<T>::getIndexedRenderAttributeBuffer(ManagedBuffer<uint32_t>& indexBuffer) {
+  if (sharedSource) return sharedSource->getIndexedRenderAttributeBuffer(indexBuffer);
+  ManagedBuffer<uint32_t>& indices = indexBuffer.canonical(); // (views are gathered through the buffer holding them)
+
   removeDeletedIndexedViews(); // periodic filtering
 
   // Check if we have already created this indexed view, and if so just return it
@@ -180,11 +816,16 @@ ManagedBuffer<T>::getIndexedRenderAttributeBuffer(ManagedBuffer<uint32_t>& indic
   }
 
   // We don't have it. Create a new one and return that.
-  ensureHostBufferPopulated();
   std::shared_ptr<render::AttributeBuffer> newBuffer = generateAttributeBuffer<T>(render::engine);
-  indices.ensureHostBufferPopulated();
-  std::vector<T> expandData = gather(data, indices.data);
-  newBuffer->setData(expandData); // initially populate
+  newBuffer->setMemoryOwner(name + "#indexedView");
+  newBuffer->setStreaming(streaming);
+  newBuffer->setResizable(true);
+  if (!gatherIndexedViewOnDevice(indices, *newBuffer)) {
+    ensureHostBufferPopulated();
+    indices.ensureHostBufferPopulated();
+    std::vector<T> expandData = gather(data, indices.data);
+    newBuffer->setData(expandData); // initially populate
+  }
   existingIndexedViews.emplace_back(&indices, newBuffer);
 
   return newBuffer;
@@ -206,12 +847,167 @@ void ManagedBuffer<T>::updateIndexedViews() {
     render::AttributeBuffer& viewBuffer = *viewBufferPtr;
 
     // apply the indexing and set the data
+    if (gatherIndexedViewOnDevice(indices, viewBuffer)) continue;
+    ensureHostBufferPopulated(); // gathering needs the values in `data`
     indices.ensureHostBufferPopulated();
-    std::vector<T> expandData = gather(data, indices.data);
+    std::vector<T> expandData;
+    if (!gatherIfInBounds(data, indices.data, expandData)) continue;
     viewBuffer.setData(expandData);
+  }
+}
+
+template <typename T>
+void ManagedBuffer<T>::updateIndexedViewsOf(uint64_t indicesID, size_t firstChanged) {
+  removeDeletedIndexedViews(); // periodic filtering
+
+  for (std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>& existingViewTup :
+       existingIndexedViews) {
+
+    std::shared_ptr<render::AttributeBuffer> viewBufferPtr = std::get<1>(existingViewTup).lock();
+    if (!viewBufferPtr) continue;
+
+    render::ManagedBuffer<uint32_t>& indices = *std::get<0>(existingViewTup);
+    if (indices.uniqueID != indicesID) continue;
+    internal::requestRedrawForStructure(name);
 
-    // TODO fornow, only CPU-side updating is supported. Add direct GPU-side support using the bufferIndexCopyProgram
-    // below.
+    if (gatherIndexedViewOnDevice(indices, *viewBufferPtr)) continue;
+    ensureHostBufferPopulated();
+    indices.ensureHostBufferPopulated();
+
+    // appended indices: gather just the new entries on to the end of the view
+    size_t viewCount = viewBufferPtr->isSet() ? viewBufferPtr->getDataSize() / viewBufferPtr->getArrayCount() : 0;
+    if (firstChanged > 0 && viewCount == firstChanged && firstChanged <= indices.data.size()) {
+      std::vector<uint32_t> newInds(indices.data.begin() + firstChanged, indices.data.end());
+      std::vector<T> expandData;
+      if (!gatherIfInBounds(data, newInds, expandData)) continue;
+      viewBufferPtr->appendData(expandData, 0, expandData.size());
+      continue;
+    }
+
+    std::vector<T> expandData;
+    if (!gatherIfInBounds(data, indices.data, expandData)) continue;
+    viewBufferPtr->setData(expandData);
+  }
+}
+
+template <typename T>
+void ManagedBuffer<T>::updateIndexedViewsRange(size_t rangeStart, size_t rangeEnd) {
+  removeDeletedIndexedViews(); // periodic filtering
+
+  // Entries of the view which are within this many of each other get uploaded together as a single contiguous run
+  // (re-uploading the unchanged values in between), rather than issuing many tiny updates.
+  const size_t MAX_RUN_GAP = 64;
+
+  for (std::tuple<render::ManagedBuffer<uint32_t>*, std::weak_ptr<render::AttributeBuffer>>& existingViewTup :
+       existingIndexedViews) {
+
+    std::shared_ptr<render::AttributeBuffer> viewBufferPtr = std::get<1>(existingViewTup).lock();
+    if (!viewBufferPtr) continue; // skip if it has been deleted (will be removed eventually)
+
+    // note: index buffer must still be alive here. we can't check it, you will just get memory errors
+    // if it has been deleted
+    render::ManagedBuffer<uint32_t>& indices = *std::get<0>(existingViewTup);
+    render::AttributeBuffer& viewBuffer = *viewBufferPtr;
+
+    // (the render buffer already has the new values, so re-gathering the whole view on the device is cheaper than
+    // finding the modified entries)
+    if (gatherIndexedViewOnDevice(indices, viewBuffer)) continue;
+
+    indices.ensureHostBufferPopulated();
+    const std::vector<uint32_t>& inds = indices.data;
+
+    // Find the runs of view entries which index in to the modified range, and upload each of them
+    std::vector<T> runData;
+    size_t i = 0;
+    while (i < inds.size()) {
+
+      // advance to the next modified entry
+      if (inds[i] < rangeStart || inds[i] >= rangeEnd) {
+        i++;
+        continue;
+      }
+
+      // extend the run as long as there is another modified entry nearby
+      size_t runStart = i;
+      size_t runEnd = i + 1;
+      for (size_t j = runEnd; j < inds.size() && j < runEnd + MAX_RUN_GAP; j++) {
+        if (inds[j] >= rangeStart && inds[j] < rangeEnd) {
+          runEnd = j + 1;
+        }
+      }
+
+      runData.resize(runEnd - runStart);
+      for (size_t j = runStart; j < runEnd; j++) {
+        runData[j - runStart] = data[inds[j]];
+      }
+      viewBuffer.setDataRange(runData, 0, runData.size(), runStart);
+
+      i = runEnd;
+    }
+  }
+}
+
+template <typename T>
+void ManagedBuffer<T>::shareFrom(ManagedBuffer<T>& source) {
+  ManagedBuffer<T>& target = source.canonical();
+  if (&target == this) exception("ManagedBuffer " + name + " cannot share its own data");
+  if (&target.data != &data) {
+    exception("ManagedBuffer " + name + " can only share from " + source.name + " if they wrap the same data");
+  }
+  sharedSource = &target;
+
+  // forget anything of our own, the data (being the same vector) is left alone
+  renderAttributeBuffer.reset();
+  existingIndexedViews.clear();
+  textureView.reset();
+  externalData = nullptr;
+  externalDataSize = 0;
+  externalDataOwner.reset();
+}
+
+template <typename T>
+bool ManagedBuffer<T>::isShared() const {
+  return sharedSource != nullptr;
+}
+
+template <typename T>
+ManagedBuffer<T>& ManagedBuffer<T>::canonical() {
+  return sharedSource ? *sharedSource : *this;
+}
+
+template <typename T>
+std::shared_ptr<render::TextureBuffer> ManagedBuffer<T>::getTextureViewBuffer() {
+  if (sharedSource) return sharedSource->getTextureViewBuffer();
+  if (!textureView) updateTextureView();
+  return textureView;
+}
+
+template <typename T>
+void ManagedBuffer<T>::updateTextureView() {
+  TextureFormat format;
+  size_t nComponents = textureViewFormat<T>(format);
+  if (nComponents == 0) {
+    exception("ManagedBuffer " + name + " cannot be viewed as a texture, the type is not supported");
+  }
+
+  // Lay out the values in rows, padding the last one
+  ensureHostBufferPopulated();
+  unsigned int nRows = static_cast<unsigned int>(
+      std::max(static_cast<size_t>(1), (data.size() + textureViewRowLength - 1) / textureViewRowLength));
+  std::vector<float> texels;
+  texels.reserve(nComponents * textureViewRowLength * nRows);
+  for (const T& val : data) {
+    appendTexel(texels, val);
+  }
+  texels.resize(nComponents * textureViewRowLength * nRows, 0.f);
+
+  if (textureView) {
+    // overwrite the texture in place, shader programs refer to it
+    if (textureView->getSizeY() != nRows) textureView->resize(textureViewRowLength, nRows);
+    textureView->setDataRegion(0, 0, textureViewRowLength, nRows, texels.data());
+  } else {
+    textureView = render::engine->generateTextureBuffer(format, textureViewRowLength, nRows, texels.data());
+    textureView->setMemoryOwner(name + "#textureView");
   }
 }
 
@@ -227,10 +1023,67 @@ void ManagedBuffer<T>::removeDeletedIndexedViews() {
       existingIndexedViews.end());
 }
 
+template <typename T>
+bool ManagedBuffer<T>::deferUpdate(bool fullUpdate, size_t rangeStart, size_t rangeEnd) {
+  if (updateBatchDepth == 0) return false;
+
+  if (!updateDeferred) {
+    updateDeferred = true;
+    deferredFullUpdate = fullUpdate;
+    deferredRangeStart = rangeStart;
+    deferredRangeEnd = rangeEnd;
+    buffersWithDeferredUpdates.push_back(this);
+  } else if (fullUpdate) {
+    deferredFullUpdate = true;
+  } else {
+    deferredRangeStart = std::min(deferredRangeStart, rangeStart);
+    deferredRangeEnd = std::max(deferredRangeEnd, rangeEnd);
+  }
+  return true;
+}
+
+template <typename T>
+void ManagedBuffer<T>::flushDeferredUpdate() {
+  if (!updateDeferred) return;
+  updateDeferred = false;
+
+  // the data may have been resized by a later update, which made that one a full update
+  if (deferredFullUpdate || deferredRangeEnd > size()) {
+    markHostBufferUpdated();
+  } else {
+    markHostBufferRangeUpdated(deferredRangeStart, deferredRangeEnd);
+  }
+}
+
 template <typename T>
 void ManagedBuffer<T>::invalidateHostBuffer() {
+  updateDeferred = false; // (the values to upload are gone, the render buffer holds the new ones)
   hostBufferIsPopulated = false;
+  discardReadbackCache();
   data.clear();
+  discardCompressedData();
+  externalData = nullptr;
+  externalDataSize = 0;
+  externalDataOwner.reset();
+}
+
+template <typename T>
+void ManagedBuffer<T>::releaseHostBufferIfAllowed() {
+  if (options::hostMemoryPolicy != HostMemoryPolicy::ReleaseAfterUpload) return;
+  if (updateDeferred) return; // the render buffer is not up to date yet
+  if (!renderAttributeBuffer || !hostBufferIsPopulated || externalData) return;
+  if (std::is_same<T, double>::value) return; // would lose precision, the render buffer only holds floats
+
+  hostBufferIsPopulated = false;
+  std::vector<T>().swap(data); // actually release the memory
+  discardReadbackCache();
+}
+
+template <typename T>
+void ManagedBuffer<T>::discardReadbackCache() {
+  readbackCache->version++;
+  readbackCache->values.clear();
+  readbackCache->pending.clear();
 }
 
 template <typename T>
@@ -241,6 +1094,10 @@ typename ManagedBuffer<T>::CanonicalDataSource ManagedBuffer<T>::currentCanonica
     return CanonicalDataSource::HostData;
   }
 
+  if (hostDataCompressed) {
+    return CanonicalDataSource::Compressed;
+  }
+
   // Check if the render buffer contains the canonical data
   if (renderAttributeBuffer) {
     return CanonicalDataSource::RenderBuffer;
@@ -258,19 +1115,21 @@ typename ManagedBuffer<T>::CanonicalDataSource ManagedBuffer<T>::currentCanonica
 
 
 template <typename T>
-void ManagedBuffer<T>::ensureHaveBufferIndexCopyProgram() {
-  if (bufferIndexCopyProgram) return;
-
-  // sanity check
-  if (!renderAttributeBuffer) exception("ManagedBuffer " + name + " asked to copy indices, but has no buffers");
-
-  // TODO allocate the transform feedback program
-}
+bool ManagedBuffer<T>::gatherIndexedViewOnDevice(ManagedBuffer<uint32_t>& indices, render::AttributeBuffer& view) {
+  if (!render::engine->supportsAttributeBufferGather()) return false;
+
+  size_t nValues = size();
+  size_t nIndices = indices.size();
+  if (nValues == 0 || nIndices == 0) return false;
+
+  // Like gatherIfInBounds(), leave the view as it is while the values and indices are partway through an update. This
+  // only reads the indices if they are on the host anyway.
+  if (!indices.dataIsDeviceOnly()) {
+    const uint32_t* inds = indices.getPopulatedHostDataPtr();
+    if (*std::max_element(inds, inds + nIndices) >= nValues) return true;
+  }
 
-template <typename T>
-void ManagedBuffer<T>::invokeBufferIndexCopyProgram() {
-  ensureHaveBufferIndexCopyProgram();
-  bufferIndexCopyProgram->draw();
+  return render::engine->gatherAttributeBuffer(*getRenderAttributeBuffer(), *indices.getRenderAttributeBuffer(), view);
 }
 
 // === Explicit template instantiation for the supported types
@@ -19,10 +19,12 @@
 #include "polyscope/render/opengl/shaders/lighting_shaders.h"
 #include "polyscope/render/opengl/shaders/ribbon_shaders.h"
 #include "polyscope/render/opengl/shaders/rules.h"
+#include "polyscope/render/opengl/shaders/sort_shaders.h"
 #include "polyscope/render/opengl/shaders/sphere_shaders.h"
 #include "polyscope/render/opengl/shaders/surface_mesh_shaders.h"
 #include "polyscope/render/opengl/shaders/texture_draw_shaders.h"
 #include "polyscope/render/opengl/shaders/vector_shaders.h"
+#include "polyscope/render/opengl/shaders/volume_grid_shaders.h"
 #include "polyscope/render/opengl/shaders/volume_mesh_shaders.h"
 
 
@@ -81,12 +83,13 @@ void GLAttributeBuffer::setData(const std::vector<glm::vec2>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
   } else {
 
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<glm::vec3>& data) {
@@ -99,11 +102,12 @@ void GLAttributeBuffer::setData(const std::vector<glm::vec3>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 2>>& data) {
@@ -114,11 +118,12 @@ void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 2>>& dat
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(2 * data.size());
 
   } else {
     dataSize = 2 * data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 3>>& data) {
@@ -129,11 +134,12 @@ void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 3>>& dat
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(3 * data.size());
 
   } else {
     dataSize = 3 * data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 4>>& data) {
@@ -144,11 +150,12 @@ void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 4>>& dat
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(4 * data.size());
 
   } else {
     dataSize = 4 * data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<glm::vec4>& data) {
@@ -161,11 +168,12 @@ void GLAttributeBuffer::setData(const std::vector<glm::vec4>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<float>& data) {
@@ -175,11 +183,12 @@ void GLAttributeBuffer::setData(const std::vector<float>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<double>& data) {
@@ -195,11 +204,12 @@ void GLAttributeBuffer::setData(const std::vector<double>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<int32_t>& data) {
@@ -212,12 +222,13 @@ void GLAttributeBuffer::setData(const std::vector<int32_t>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
   } else {
 
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<uint32_t>& data) {
@@ -230,11 +241,12 @@ void GLAttributeBuffer::setData(const std::vector<uint32_t>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<glm::uvec2>& data) {
@@ -244,10 +256,11 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec2>& data) {
   bind();
 
   if (isSet()) {
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 void GLAttributeBuffer::setData(const std::vector<glm::uvec3>& data) {
   checkType(RenderDataType::Vector3UInt);
@@ -255,10 +268,11 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec3>& data) {
   bind();
 
   if (isSet()) {
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 }
 
 void GLAttributeBuffer::setData(const std::vector<glm::uvec4>& data) {
@@ -267,10 +281,132 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec4>& data) {
   bind();
 
   if (isSet()) {
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
   } else {
     dataSize = data.size();
   }
+  glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
+}
+
+void GLAttributeBuffer::setDataRaw(const void* data, size_t nElements) {
+  size_t nEntries = arrayCount * nElements;
+
+  bind();
+
+  if (isSet()) {
+    setUpdatedDataSize(nEntries);
+  } else {
+    dataSize = nEntries;
+  }
+  if (data) glEngine->countUpload(getMemoryOwner(), getSizeInBytes()); // (null data only allocates)
+}
+
+void GLAttributeBuffer::resize(size_t newNElements) {
+  if (!isSet()) exception("can only resize a buffer which has already been set");
+  setUpdatedDataSize(arrayCount * newNElements);
+}
+
+// update ranges of data
+
+void GLAttributeBuffer::checkRange(size_t inputSize, size_t dataStart, size_t dataEnd, size_t bufferStart) {
+  if (!isSet()) exception("can only update a range of a buffer which has already been set");
+  if (dataStart > dataEnd || dataEnd > inputSize) exception("bad data range in setDataRange()");
+  size_t bufferCount = dataSize / arrayCount; // in units of the input type
+  if (bufferStart + (dataEnd - dataStart) > bufferCount) exception("range is out of bounds in setDataRange()");
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector2Float);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector4Float);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<float>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Float);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<double>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Float);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Int);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::UInt);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector2UInt);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3UInt);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector4UInt);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(2);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(3);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(4);
+  checkRange(data.size(), dataStart, dataEnd, bufferStart);
+  glEngine->countUpload(getMemoryOwner(), (dataEnd - dataStart) * arrayCount * renderDataTypeSizeInBytes(dataType));
 }
 
 // get single data values
@@ -434,6 +570,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int size1D, con
     : TextureBuffer(1, format_, size1D) {
 
   checkGLError();
+  if (data) glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 
   setFilterMode(FilterMode::Nearest);
 }
@@ -441,6 +578,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int size1D, con
     : TextureBuffer(1, format_, size1D) {
 
   checkGLError();
+  if (data) glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 
   setFilterMode(FilterMode::Nearest);
 }
@@ -451,6 +589,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
     : TextureBuffer(2, format_, sizeX_, sizeY_) {
 
   checkGLError();
+  if (data) glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 
   setFilterMode(FilterMode::Nearest);
 }
@@ -459,6 +598,18 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
     : TextureBuffer(2, format_, sizeX_, sizeY_) {
 
   checkGLError();
+  if (data) glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
+
+  setFilterMode(FilterMode::Nearest);
+}
+
+// create a 3D texture from data
+GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
+                                 const float* data)
+    : TextureBuffer(3, format_, sizeX_, sizeY_, sizeZ_) {
+
+  checkGLError();
+  if (data) glEngine->countUpload(getMemoryOwner(), getSizeInBytes());
 
   setFilterMode(FilterMode::Nearest);
 }
@@ -475,6 +626,9 @@ void GLTextureBuffer::resize(unsigned int newLen) {
   if (dim == 2) {
     exception("OpenGL error: called 1D resize on 2D texture");
   }
+  if (dim == 3) {
+    exception("OpenGL error: called 1D resize on 3D texture");
+  }
   checkGLError();
 }
 
@@ -488,6 +642,9 @@ void GLTextureBuffer::resize(unsigned int newX, unsigned int newY) {
   }
   if (dim == 2) {
   }
+  if (dim == 3) {
+    exception("OpenGL error: called 2D resize on 3D texture");
+  }
   checkGLError();
 }
 
@@ -543,6 +700,30 @@ std::vector<glm::vec3> GLTextureBuffer::getDataVector3() {
 
   return outData;
 }
+void GLTextureBuffer::setDataRegion(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                                    const float* data) {
+  checkRegionInBounds(xStart, yStart, w, h);
+  bind();
+  glEngine->countUpload(getMemoryOwner(), static_cast<size_t>(w) * h * getSizeInBytes() / getTotalSize());
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataRegionHalfFloat(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                                             const uint16_t* data) {
+  checkRegionInBounds(xStart, yStart, w, h);
+  bind();
+  glEngine->countUpload(getMemoryOwner(), static_cast<size_t>(w) * h * dimension(format) * sizeof(uint16_t));
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataRegion3D(unsigned int xStart, unsigned int yStart, unsigned int zStart, unsigned int w,
+                                      unsigned int h, unsigned int d, const float* data) {
+  checkRegionInBounds3D(xStart, yStart, zStart, w, h, d);
+  bind();
+  glEngine->countUpload(getMemoryOwner(), static_cast<size_t>(w) * h * d * getSizeInBytes() / getTotalSize());
+  checkGLError();
+}
+
 void GLTextureBuffer::bind() {
   if (dim == 1) {
   }
@@ -674,6 +855,10 @@ void GLFrameBuffer::clear() {
   if (!bindForRendering()) return;
 }
 
+void GLFrameBuffer::clearRegion(int startX, int startY, unsigned int sizeX, unsigned int sizeY) {
+  if (!bindForRendering()) return;
+}
+
 std::array<float, 4> GLFrameBuffer::readFloat4(int xPos, int yPos) {
   // Read from the buffer
   std::array<float, 4> result = {1., 2., 3., 4.};
@@ -681,12 +866,24 @@ std::array<float, 4> GLFrameBuffer::readFloat4(int xPos, int yPos) {
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readFloat4Region(int xPos, int yPos, int sizeX, int sizeY) {
+  // Read from the buffer
+  std::vector<float> result(4 * sizeX * sizeY, 0.);
+  return result;
+}
+
 float GLFrameBuffer::readDepth(int xPos, int yPos) {
   // Read from the buffer
   float result = 0.5;
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readDepthRegion(int xPos, int yPos, int sizeX, int sizeY) {
+  // Read from the buffer
+  std::vector<float> result(sizeX * sizeY, 0.5);
+  return result;
+}
+
 std::vector<unsigned char> GLFrameBuffer::readBuffer() {
   bind();
 
@@ -728,15 +925,25 @@ GLCompiledProgram::GLCompiledProgram(const std::vector<ShaderStageSpecification>
     for (ShaderSpecTexture t : s.textures) {
       addUniqueTexture(t);
     }
+    for (ShaderSpecStorageBuffer b : s.storageBuffers) {
+      addUniqueStorageBuffer(b);
+    }
   }
 
-  if (attributes.size() == 0) {
+  // (the mock can build compute programs, so the API can be exercised, but never runs them; it reports no support
+  // for compute shaders so that callers use their fallbacks)
+  if (drawMode == DrawMode::Compute) {
+    if (stages.size() != 1 || stages[0].stage != ShaderStageType::Compute) {
+      exception("compute programs must consist of a single compute stage");
+    }
+  } else if (attributes.size() == 0) {
     throw std::invalid_argument("Uh oh... GLProgram has no attributes");
   }
 
   // Perform setup tasks
   compileGLProgram(stages);
   setDataLocations();
+  glEngine->countShaderCompilation();
 }
 
 GLCompiledProgram::~GLCompiledProgram() {}
@@ -768,7 +975,7 @@ void GLCompiledProgram::addUniqueAttribute(ShaderSpecAttribute newAttribute) {
       return;
     }
   }
-  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount, nullptr});
+  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount, nullptr, false});
 }
 
 void GLCompiledProgram::addUniqueUniform(ShaderSpecUniform newUniform) {
@@ -795,14 +1002,28 @@ void GLCompiledProgram::addUniqueTexture(ShaderSpecTexture newTexture) {
       return;
     }
   }
-  textures.push_back(GLShaderTexture{newTexture.name, newTexture.dim, 777, false, nullptr, nullptr});
+  textures.push_back(GLShaderTexture{newTexture.name, newTexture.dim, 777, false, nullptr, nullptr, "", nullptr});
+}
+
+void GLCompiledProgram::addUniqueStorageBuffer(ShaderSpecStorageBuffer newBuffer) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name == newBuffer.name) {
+
+      // if it occurs twice, confirm that the occurences match
+      if (b.type != newBuffer.type)
+        exception("storage buffer " + b.name + " appears twice in program with different types");
+
+      return;
+    }
+  }
+  storageBuffers.push_back(GLShaderStorageBuffer{newBuffer.name, newBuffer.type, nullptr});
 }
 
 
 GLShaderProgram::GLShaderProgram(const std::shared_ptr<GLCompiledProgram>& compiledProgram_)
     : ShaderProgram(compiledProgram_->getDrawMode()), uniforms(compiledProgram_->getUniforms()),
       attributes(compiledProgram_->getAttributes()), textures(compiledProgram_->getTextures()),
-      compiledProgram(compiledProgram_) {
+      storageBuffers(compiledProgram_->getStorageBuffers()), compiledProgram(compiledProgram_) {
   createBuffers(); // only handles texture & index things, attributes are lazily created
 }
 
@@ -860,6 +1081,17 @@ void GLShaderProgram::setAttribute(std::string name, std::shared_ptr<AttributeBu
   throw std::invalid_argument("Tried to set nonexistent attribute with name " + name);
 }
 
+void GLShaderProgram::setAttributePerInstance(std::string name) {
+  for (GLShaderAttribute& a : attributes) {
+    if (a.name == name) {
+      a.perInstance = true;
+      return;
+    }
+  }
+
+  throw std::invalid_argument("Tried to set nonexistent attribute with name " + name);
+}
+
 
 void GLShaderProgram::assignBufferToVAO(GLShaderAttribute& a) {
 
@@ -912,6 +1144,7 @@ void GLShaderProgram::createBuffer(GLShaderAttribute& a) {
 void GLShaderProgram::ensureBufferExists(GLShaderAttribute& a) {
   if (!a.buff) {
     createBuffer(a);
+    a.buff->setMemoryOwner(memoryOwner);
   }
 }
 
@@ -924,212 +1157,177 @@ bool GLShaderProgram::hasUniform(std::string name) {
   return false;
 }
 
-// Set an integer
-void GLShaderProgram::setUniform(std::string name, int val) {
+UniformHandle GLShaderProgram::getUniformHandle(const std::string& name) { return getUniformHandle(name.c_str()); }
 
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Int) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
+UniformHandle GLShaderProgram::getUniformHandle(const char* name) {
+  for (size_t i = 0; i < uniforms.size(); i++) {
+    if (uniforms[i].name == name) {
+      UniformHandle handle;
+      handle.index = static_cast<int32_t>(i);
+      return handle;
     }
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  throw std::invalid_argument("Tried to set nonexistent uniform with name " + std::string(name));
+}
+
+bool GLShaderProgram::hasUniform(UniformHandle handle) {
+  getUniform(handle);
+  return true;
+}
+
+GLShaderUniform& GLShaderProgram::getUniform(UniformHandle handle) {
+  if (handle.index < 0 || static_cast<size_t>(handle.index) >= uniforms.size()) {
+    throw std::invalid_argument("Tried to set uniform with invalid handle");
+  }
+  return uniforms[handle.index];
+}
+
+// Set an integer
+void GLShaderProgram::setUniform(UniformHandle handle, int val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Int) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
+  }
 }
+void GLShaderProgram::setUniform(std::string name, int val) { setUniform(getUniformHandle(name), val); }
 
 // Set an unsigned integer
-void GLShaderProgram::setUniform(std::string name, unsigned int val) {
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, unsigned int val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::UInt) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, unsigned int val) { setUniform(getUniformHandle(name), val); }
 
 // Set a float
-void GLShaderProgram::setUniform(std::string name, float val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, float val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, float val) { setUniform(getUniformHandle(name), val); }
 
 // Set a double --- WARNING casts down to float
-void GLShaderProgram::setUniform(std::string name, double val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, double val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, double val) { setUniform(getUniformHandle(name), val); }
 
 // Set a 4x4 uniform matrix
-void GLShaderProgram::setUniform(std::string name, float* val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Matrix44Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, float* val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Matrix44Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, float* val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector2 uniform
-void GLShaderProgram::setUniform(std::string name, glm::vec2 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector2Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec2 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector2Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::vec2 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector3 uniform
-void GLShaderProgram::setUniform(std::string name, glm::vec3 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector3Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec3 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector3Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::vec3 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector4 uniform
-void GLShaderProgram::setUniform(std::string name, glm::vec4 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector4Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec4 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector4Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::vec4 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector3 uniform from a float array
-void GLShaderProgram::setUniform(std::string name, std::array<float, 3> val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector3Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, std::array<float, 3> val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector3Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+}
+void GLShaderProgram::setUniform(std::string name, std::array<float, 3> val) {
+  setUniform(getUniformHandle(name), val);
 }
 
 // Set a vec4 uniform
-void GLShaderProgram::setUniform(std::string name, float x, float y, float z, float w) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector4Float) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, float x, float y, float z, float w) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector4Float) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+}
+void GLShaderProgram::setUniform(std::string name, float x, float y, float z, float w) {
+  setUniform(getUniformHandle(name), x, y, z, w);
 }
 
 // Set a uint vector2 uniform
-void GLShaderProgram::setUniform(std::string name, glm::uvec2 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector2UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec2 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector2UInt) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::uvec2 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a uint vector3 uniform
-void GLShaderProgram::setUniform(std::string name, glm::uvec3 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector3UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec3 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector3UInt) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::uvec3 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a uint vector4 uniform
-void GLShaderProgram::setUniform(std::string name, glm::uvec4 val) {
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.type == RenderDataType::Vector4UInt) {
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec4 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.type == RenderDataType::Vector4UInt) {
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::uvec4 val) { setUniform(getUniformHandle(name), val); }
 
 bool GLShaderProgram::hasAttribute(std::string name) {
   for (GLShaderAttribute& a : attributes) {
@@ -1294,6 +1492,8 @@ void GLShaderProgram::setTexture1D(std::string name, unsigned char* texData, uns
     // Create a new texture object
     t.textureBufferOwned.reset(new GLTextureBuffer(TextureFormat::RGB8, length, texData));
     t.textureBuffer = t.textureBufferOwned.get();
+    t.attributeBuffer = nullptr;
+    t.textureBufferOwned->setMemoryOwner(memoryOwner);
 
 
     // Set policies
@@ -1330,6 +1530,8 @@ void GLShaderProgram::setTexture2D(std::string name, unsigned char* texData, uns
       t.textureBufferOwned.reset(new GLTextureBuffer(TextureFormat::RGB8, width, height, texData));
     }
     t.textureBuffer = t.textureBufferOwned.get();
+    t.attributeBuffer = nullptr;
+    t.textureBufferOwned->setMemoryOwner(memoryOwner);
 
 
     // Set policies
@@ -1364,6 +1566,8 @@ void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* text
       throw std::invalid_argument("Bad texture in setTextureFromBuffer()");
     }
 
+    t.colormapName = "";
+    t.attributeBuffer = nullptr;
     t.isSet = true;
     return;
   }
@@ -1371,9 +1575,65 @@ void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* text
   throw std::invalid_argument("No texture with name " + name);
 }
 
-void GLShaderProgram::setTextureFromColormap(std::string name, const std::string& colormapName, bool allowUpdate) {
-  const ValueColorMap& colormap = render::engine->getColorMap(colormapName);
+void GLShaderProgram::setTextureFromAttributeBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) {
+  for (GLShaderTexture& t : textures) {
+    if (t.name != name) continue;
+
+    if (t.dim != 1) {
+      throw std::invalid_argument("Tried to use texture with mismatched dimension " + std::to_string(t.dim));
+    }
+    if (buffer->getType() == RenderDataType::Matrix44Float) {
+      throw std::invalid_argument("Matrix data cannot be read as a buffer texture");
+    }
+
+    t.attributeBuffer = std::dynamic_pointer_cast<GLAttributeBuffer>(buffer);
+    if (!t.attributeBuffer) {
+      throw std::invalid_argument("Bad buffer in setTextureFromAttributeBuffer()");
+    }
+
+    t.textureBuffer = nullptr;
+    t.textureBufferOwned = nullptr;
+    t.colormapName = "";
+    t.isSet = true;
+    return;
+  }
+
+  throw std::invalid_argument("No texture with name " + name);
+}
+
+bool GLShaderProgram::hasStorageBuffer(std::string name) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name == name) return true;
+  }
+  return false;
+}
+
+bool GLShaderProgram::storageBufferIsSet(std::string name) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name == name) return b.buff != nullptr;
+  }
+  return false;
+}
 
+void GLShaderProgram::setStorageBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name != name) continue;
+
+    if (buffer->getType() != b.type) {
+      throw std::invalid_argument("Tried to set storage buffer " + name + " to incompatible type. Storage buffer " +
+                                  renderDataTypeName(b.type) + " set with buffer of type " +
+                                  renderDataTypeName(buffer->getType()));
+    }
+
+    b.buff = std::dynamic_pointer_cast<GLAttributeBuffer>(buffer);
+    if (!b.buff) throw std::invalid_argument("storage buffer " + name + " engine type cast failed");
+    return;
+  }
+
+  throw std::invalid_argument("No storage buffer with name " + name);
+}
+
+void GLShaderProgram::setTextureFromColormap(std::string name, const std::string& colormapName, bool allowUpdate) {
   // Find the right texture
   for (GLShaderTexture& t : textures) {
     if (t.name != name) continue;
@@ -1382,25 +1642,18 @@ void GLShaderProgram::setTextureFromColormap(std::string name, const std::string
       throw std::invalid_argument("Attempted to set texture twice");
     }
 
+    // Already holds this colormap; nothing to upload
+    if (t.isSet && t.colormapName == colormapName) return;
+
     if (t.dim != 1) {
       throw std::invalid_argument("Tried to use texture with mismatched dimension " + std::to_string(t.dim));
     }
 
-    // Fill a buffer with the data
-    unsigned int dataLength = colormap.values.size() * 3;
-    std::vector<float> colorBuffer(dataLength);
-    for (unsigned int i = 0; i < colormap.values.size(); i++) {
-      colorBuffer[3 * i + 0] = static_cast<float>(colormap.values[i][0]);
-      colorBuffer[3 * i + 1] = static_cast<float>(colormap.values[i][1]);
-      colorBuffer[3 * i + 2] = static_cast<float>(colormap.values[i][2]);
-    }
-
-    // glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, colormap.values.size(), 0, GL_RGB, GL_FLOAT, &(colorBuffer[0]));
-    t.textureBufferOwned = std::dynamic_pointer_cast<GLTextureBuffer>(
-        engine->generateTextureBuffer(TextureFormat::RGB32F, colormap.values.size(), &(colorBuffer[0])));
-    t.textureBufferOwned->setFilterMode(FilterMode::Linear);
+    // Colormap textures are shared between all programs, so this is only a rebind
+    t.textureBufferOwned = std::dynamic_pointer_cast<GLTextureBuffer>(render::engine->getColorMapTexture(colormapName));
     t.textureBuffer = t.textureBufferOwned.get();
-
+    t.attributeBuffer = nullptr;
+    t.colormapName = colormapName;
 
     t.isSet = true;
     return;
@@ -1427,6 +1680,7 @@ void GLShaderProgram::setIndex(std::vector<std::array<unsigned int, 3>>& indices
   }
 
   delete[] rawData;
+  indexBuffer.reset();
 }
 
 void GLShaderProgram::setIndex(std::vector<glm::uvec3>& indices) {
@@ -1436,6 +1690,7 @@ void GLShaderProgram::setIndex(std::vector<glm::uvec3>& indices) {
   }
 
   indexSize = 3 * indices.size();
+  indexBuffer.reset();
 }
 
 void GLShaderProgram::setIndex(std::vector<unsigned int>& indices) {
@@ -1458,6 +1713,25 @@ void GLShaderProgram::setIndex(std::vector<unsigned int>& indices) {
     }
   }
   indexSize = indices.size();
+
+  maxIndex = -1;
+  for (unsigned int x : indices) {
+    maxIndex = std::max(maxIndex, static_cast<int64_t>(x));
+  }
+  indexBuffer.reset();
+}
+
+void GLShaderProgram::setIndex(std::shared_ptr<AttributeBuffer> indices) {
+  if (!useIndex) {
+    throw std::invalid_argument("Tried to setIndex() when program drawMode does not use indexed "
+                                "drawing");
+  }
+  if (indices->getType() != RenderDataType::UInt || indices->getArrayCount() != 1) {
+    throw std::invalid_argument("Tried to setIndex() with a buffer which does not hold UInt indices");
+  }
+
+  indexBuffer = indices;
+  maxIndex = -1; // (the mock buffers don't hold their data, so the indices can't be checked)
 }
 
 // Check that uniforms and attributes are all set and of consistent size
@@ -1481,6 +1755,18 @@ void GLShaderProgram::validateData() {
 
     int compatCount = renderDataTypeCountCompatbility(a.type, a.buff->getType());
 
+    if (a.perInstance) {
+      if (!useInstancing) {
+        throw std::invalid_argument("Attribute " + a.name + " is per-instance, but no instance count has been set");
+      }
+      if (a.buff->getDataSize() / (a.arrayCount * compatCount) < static_cast<int64_t>(instanceCount)) {
+        throw std::invalid_argument("Per-instance attribute " + a.name + " has size " +
+                                    std::to_string(a.buff->getDataSize()) + " but there are " +
+                                    std::to_string(instanceCount) + " instances");
+      }
+      continue;
+    }
+
     if (attributeSize == -1) { // first one we've seen
       attributeSize = a.buff->getDataSize() / (a.arrayCount * compatCount);
     } else { // not the first one we've seen
@@ -1491,20 +1777,48 @@ void GLShaderProgram::validateData() {
       }
     }
   }
+  if (vertexCount >= 0) {
+    if (attributeSize != -1 && attributeSize != vertexCount) {
+      throw std::invalid_argument("Attributes have size " + std::to_string(attributeSize) +
+                                  " but the vertex count is " + std::to_string(vertexCount));
+    }
+    attributeSize = vertexCount;
+  }
   drawDataLength = static_cast<unsigned int>(attributeSize);
 
+  if (useInstancing && useDrawRanges) {
+    throw std::invalid_argument("Draw ranges cannot be combined with instanced drawing");
+  }
+
   // Check textures
   for (GLShaderTexture& t : textures) {
     if (!t.isSet) {
       throw std::invalid_argument("Texture " + t.name + " has not been set");
     }
+    if (t.attributeBuffer && !t.attributeBuffer->isSet()) {
+      throw std::invalid_argument("Buffer for texture " + t.name + " has not been filled");
+    }
+  }
+
+  // Check storage buffers
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (!b.buff || !b.buff->isSet()) {
+      throw std::invalid_argument("Storage buffer " + b.name + " has not been set");
+    }
   }
 
   // Check index (if applicable)
   if (useIndex) {
+    if (indexBuffer) {
+      indexSize = indexBuffer->isSet() ? indexBuffer->getDataSize() : -1;
+    }
     if (indexSize == -1) {
       throw std::invalid_argument("Index buffer has not been filled");
     }
+    if (!usePrimitiveRestart && attributeSize != -1 && maxIndex >= attributeSize) {
+      throw std::invalid_argument("Index buffer refers to element " + std::to_string(maxIndex) +
+                                  ", but attributes have size " + std::to_string(attributeSize));
+    }
     drawDataLength = static_cast<unsigned int>(indexSize);
   }
 }
@@ -1533,13 +1847,34 @@ void GLShaderProgram::activateTextures() {
   }
 }
 
+void GLShaderProgram::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) {
+  if (!isCompute()) exception("dispatch() called on a program which draws, use draw()");
+  validateData();
+
+  activateTextures();
+  glEngine->countComputeDispatch();
+
+  checkGLError();
+}
+
 void GLShaderProgram::draw() {
+  if (isCompute()) exception("draw() called on a compute program, use dispatch()");
   validateData();
 
+  if (useDrawRanges) {
+    for (size_t i = 0; i < drawRangeFirsts.size(); i++) {
+      if (drawRangeFirsts[i] < 0 || drawRangeCounts[i] < 0 ||
+          static_cast<size_t>(drawRangeFirsts[i] + drawRangeCounts[i]) > drawDataLength) {
+        throw std::invalid_argument("draw range out of bounds");
+      }
+    }
+  }
+
   if (usePrimitiveRestart) {
   }
 
   activateTextures();
+  glEngine->countDrawCall();
 
   switch (drawMode) {
   case DrawMode::Points:
@@ -1562,6 +1897,10 @@ void GLShaderProgram::draw() {
     break;
   case DrawMode::IndexedTriangles:
     break;
+  case DrawMode::IndexedPoints:
+    break;
+  case DrawMode::Compute:
+    break;
   }
 
   if (usePrimitiveRestart) {
@@ -1599,7 +1938,10 @@ void MockGLEngine::initializeImGui() {
 
 void MockGLEngine::shutdownImGui() { ImGui::DestroyContext(); }
 
-void MockGLEngine::swapDisplayBuffers() {}
+void MockGLEngine::swapDisplayBuffers() {
+  lastFrameCostCounters = frameCostCounters;
+  frameCostCounters = EngineCostCounters();
+}
 
 std::vector<unsigned char> MockGLEngine::readDisplayBuffer() {
   // Get buffer size
@@ -1675,13 +2017,15 @@ void MockGLEngine::ImGuiNewFrame() {
 
 void MockGLEngine::ImGuiRender() { ImGui::Render(); }
 
-void MockGLEngine::setDepthMode(DepthMode newMode) {}
+void MockGLEngine::ImGuiRenderLast() {}
+
+void MockGLEngine::setDepthMode(DepthMode newMode) { countStateChange(); }
 
-void MockGLEngine::setBlendMode(BlendMode newMode) {}
+void MockGLEngine::setBlendMode(BlendMode newMode) { countStateChange(); }
 
-void MockGLEngine::setColorMask(std::array<bool, 4> mask) {}
+void MockGLEngine::setColorMask(std::array<bool, 4> mask) { countStateChange(); }
 
-void MockGLEngine::setBackfaceCull(bool newVal) {}
+void MockGLEngine::setBackfaceCull(bool newVal) { countStateChange(); }
 
 std::string MockGLEngine::getClipboardText() {
   std::string clipboardData = "";
@@ -1695,6 +2039,42 @@ void MockGLEngine::applyTransparencySettings() {}
 void MockGLEngine::setFrontFaceCCW(bool newVal) {
   if (newVal == frontFaceCCW) return;
   frontFaceCCW = newVal;
+  countStateChange();
+}
+
+namespace {
+template <typename F>
+void countInBoth(EngineCostCounters& total, EngineCostCounters& frame, F&& update) {
+  update(total);
+  update(frame);
+}
+} // namespace
+
+void MockGLEngine::countUpload(const std::string& owner, size_t nBytes) {
+  countInBoth(costCounters, frameCostCounters, [&](EngineCostCounters& c) {
+    c.bytesUploaded += nBytes;
+    c.bytesUploadedPerBuffer[owner] += nBytes;
+  });
+}
+
+void MockGLEngine::countDrawCall() {
+  countInBoth(costCounters, frameCostCounters, [](EngineCostCounters& c) { c.drawCalls++; });
+}
+
+void MockGLEngine::countComputeDispatch() {
+  countInBoth(costCounters, frameCostCounters, [](EngineCostCounters& c) { c.computeDispatches++; });
+}
+
+void MockGLEngine::countShaderCompilation() {
+  countInBoth(costCounters, frameCostCounters, [](EngineCostCounters& c) { c.shaderCompilations++; });
+}
+
+void MockGLEngine::countStateChange() {
+  countInBoth(costCounters, frameCostCounters, [](EngineCostCounters& c) { c.stateChanges++; });
+}
+
+void MockGLEngine::countAllocation() {
+  countInBoth(costCounters, frameCostCounters, [](EngineCostCounters& c) { c.bufferAllocations++; });
 }
 
 // == Factories
@@ -1702,28 +2082,40 @@ void MockGLEngine::setFrontFaceCCW(bool newVal) {
 
 std::shared_ptr<AttributeBuffer> MockGLEngine::generateAttributeBuffer(RenderDataType dataType_, int arrayCount_) {
   GLAttributeBuffer* newA = new GLAttributeBuffer(dataType_, arrayCount_);
+  countAllocation();
   return std::shared_ptr<AttributeBuffer>(newA);
 }
 
 std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat format, unsigned int size1D,
                                                                    const unsigned char* data) {
   GLTextureBuffer* newT = new GLTextureBuffer(format, size1D, data);
+  countAllocation();
   return std::shared_ptr<TextureBuffer>(newT);
 }
 
 std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat format, unsigned int size1D,
                                                                    const float* data) {
   GLTextureBuffer* newT = new GLTextureBuffer(format, size1D, data);
+  countAllocation();
   return std::shared_ptr<TextureBuffer>(newT);
 }
 std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
                                                                    unsigned int sizeY_, const unsigned char* data) {
   GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, data);
+  countAllocation();
   return std::shared_ptr<TextureBuffer>(newT);
 }
 std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
                                                                    unsigned int sizeY_, const float* data) {
   GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, data);
+  countAllocation();
+  return std::shared_ptr<TextureBuffer>(newT);
+}
+std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
+                                                                   unsigned int sizeY_, unsigned int sizeZ_,
+                                                                   const float* data) {
+  GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, sizeZ_, data);
+  countAllocation();
   return std::shared_ptr<TextureBuffer>(newT);
 }
 
@@ -1731,11 +2123,13 @@ std::shared_ptr<TextureBuffer> MockGLEngine::generateTextureBuffer(TextureFormat
 std::shared_ptr<RenderBuffer> MockGLEngine::generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
                                                                  unsigned int sizeY_) {
   GLRenderBuffer* newR = new GLRenderBuffer(type, sizeX_, sizeY_);
+  countAllocation();
   return std::shared_ptr<RenderBuffer>(newR);
 }
 
 std::shared_ptr<FrameBuffer> MockGLEngine::generateFrameBuffer(unsigned int sizeX_, unsigned int sizeY_) {
   GLFrameBuffer* newF = new GLFrameBuffer(sizeX_, sizeY_);
+  countAllocation();
   return std::shared_ptr<FrameBuffer>(newF);
 }
 
@@ -1767,6 +2161,10 @@ std::string MockGLEngine::programKeyFromRules(const std::string& programName, co
     for (const std::string& s : defaultRules_process) builder << s << "# ";
     break;
   }
+  case ShaderReplacementDefaults::Compute: {
+    for (const std::string& s : defaultRules_compute) builder << s << "# ";
+    break;
+  }
   case ShaderReplacementDefaults::None: {
     break;
   }
@@ -1813,6 +2211,10 @@ std::shared_ptr<GLCompiledProgram> MockGLEngine::getCompiledProgram(const std::s
       fullCustomRules.insert(fullCustomRules.begin(), defaultRules_process.begin(), defaultRules_process.end());
       break;
     }
+    case ShaderReplacementDefaults::Compute: {
+      fullCustomRules.insert(fullCustomRules.begin(), defaultRules_compute.begin(), defaultRules_compute.end());
+      break;
+    }
     case ShaderReplacementDefaults::None: {
       break;
     }
@@ -1835,11 +2237,17 @@ std::shared_ptr<GLCompiledProgram> MockGLEngine::getCompiledProgram(const std::s
       rules.push_back(thisRule);
     }
 
-    // Actually apply rule substitutions
-    std::vector<ShaderStageSpecification> updatedStages = applyShaderReplacements(stages, rules);
+    // Actually apply rule substitutions, and move the frame-global uniforms to the shared block
+    std::vector<ShaderStageSpecification> updatedStages = useFrameUniformBlock(applyShaderReplacements(stages, rules));
 
-    // Create a new compiled program (GL work happens in the constructor)
-    compiledProgamCache[progKey] = std::shared_ptr<GLCompiledProgram>(new GLCompiledProgram(updatedStages, dm));
+    // Reuse an identical program if one has been compiled, otherwise create a new compiled program (GL work happens in
+    // the constructor)
+    std::string sourceKey = programKeyFromStages(updatedStages, dm);
+    std::shared_ptr<GLCompiledProgram>& compiled = compiledProgramSourceCache[sourceKey];
+    if (!compiled) {
+      compiled = std::shared_ptr<GLCompiledProgram>(new GLCompiledProgram(updatedStages, dm));
+    }
+    compiledProgamCache[progKey] = compiled;
   }
 
   // Now that the cache must contain the compiled program, just return it
@@ -1874,27 +2282,53 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderProgram("MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("SLICE_TETS", {SLICE_TETS_VERT_SHADER, SLICE_TETS_GEOM_SHADER, SLICE_TETS_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("INDEXED_MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
+  registerShaderProgram("INDEXED_MESH_COMPRESSED", {FLEX_MESH_COMPRESSED_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
   registerShaderProgram("RAYCAST_SPHERE", {FLEX_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("POINT_QUAD", {FLEX_POINTQUAD_VERT_SHADER, FLEX_POINTQUAD_GEOM_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_SPHERE_INDEXED", {FLEX_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::IndexedPoints);
+  registerShaderProgram("POINT_QUAD_INDEXED", {FLEX_POINTQUAD_VERT_SHADER, FLEX_POINTQUAD_GEOM_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::IndexedPoints);
+  registerShaderProgram("RAYCAST_SPHERE_INSTANCED", {FLEX_SPHERE_INSTANCED_VERT_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("POINT_QUAD_INSTANCED", {FLEX_POINTQUAD_INSTANCED_VERT_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RAYCAST_VECTOR", {FLEX_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("RAYCAST_TANGENT_VECTOR", {FLEX_TANGENT_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_VECTOR_INDEXED", {FLEX_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::IndexedPoints);
+  registerShaderProgram("RAYCAST_TANGENT_VECTOR_INDEXED", {FLEX_TANGENT_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::IndexedPoints);
   registerShaderProgram("RAYCAST_CYLINDER", {FLEX_CYLINDER_VERT_SHADER, FLEX_CYLINDER_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_CYLINDER_INDEXED", {FLEX_CYLINDER_INDEXED_VERT_SHADER, FLEX_CYLINDER_INDEXED_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::IndexedLines);
+  registerShaderProgram("RAYCAST_CYLINDER_INSTANCED", {FLEX_CYLINDER_INSTANCED_VERT_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("HISTOGRAM", {HISTOGRAM_VERT_SHADER, HISTOGRAM_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("HISTOGRAM_BIN", {HISTOGRAM_BIN_VERT_SHADER, HISTOGRAM_BIN_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("DEPTH_SORT_KEYS", {DEPTH_SORT_KEYS_COMPUTE_SHADER}, DrawMode::Compute);
+  registerShaderProgram("RADIX_SORT_COUNT", {RADIX_SORT_COUNT_COMPUTE_SHADER}, DrawMode::Compute);
+  registerShaderProgram("RADIX_SORT_SCAN", {RADIX_SORT_SCAN_COMPUTE_SHADER}, DrawMode::Compute);
+  registerShaderProgram("RADIX_SORT_SCATTER", {RADIX_SORT_SCATTER_COMPUTE_SHADER}, DrawMode::Compute);
   registerShaderProgram("GROUND_PLANE_TILE", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_TILE_REFLECT", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_REFLECT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_SHADOW", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_SHADOW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("MAP_LIGHT", {TEXTURE_DRAW_VERT_SHADER, MAP_LIGHT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RIBBON", {RIBBON_VERT_SHADER, RIBBON_GEOM_SHADER, RIBBON_FRAG_SHADER}, DrawMode::IndexedLineStripAdjacency);
+  registerShaderProgram("RIBBON_TUBE", {RIBBON_TUBE_VERT_SHADER, RIBBON_TUBE_GEOM_SHADER, RIBBON_TUBE_FRAG_SHADER}, DrawMode::IndexedLineStripAdjacency);
   registerShaderProgram("SLICE_PLANE", {SLICE_PLANE_VERT_SHADER, SLICE_PLANE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_RAYMARCH_VOLUME", {GRID_RAYMARCH_VERT_SHADER, GRID_RAYMARCH_VOLUME_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_RAYMARCH_ISOSURFACE", {GRID_RAYMARCH_VERT_SHADER, GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("SPARSE_GRID_RAYMARCH_ISOSURFACE", {GRID_RAYMARCH_VERT_SHADER, SPARSE_GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_NODE_SPHERE", {GRID_NODE_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("GRID_NODE_VECTOR", {GRID_NODE_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
 
   registerShaderProgram("TEXTURE_DRAW_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_DOT3", {TEXTURE_DRAW_VERT_SHADER, DOT3_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_MAP3", {TEXTURE_DRAW_VERT_SHADER, MAP3_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_SPHEREBG", {SPHEREBG_DRAW_VERT_SHADER, SPHEREBG_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_RENDERIMAGE_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("IMPLICIT_SURFACE_GLSL", {TEXTURE_DRAW_VERT_SHADER, IMPLICIT_SURFACE_MARCH_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("COMPOSITE_PEEL", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_PEEL}, DrawMode::Triangles);
+  registerShaderProgram("COMPOSITE_WEIGHTED_BLENDED", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_WEIGHTED_BLENDED}, DrawMode::Triangles);
+  registerShaderProgram("TEMPORAL_ACCUMULATE", {TEXTURE_DRAW_VERT_SHADER, TEMPORAL_ACCUMULATE}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_COPY", {TEXTURE_DRAW_VERT_SHADER, DEPTH_COPY}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_TO_MASK", {TEXTURE_DRAW_VERT_SHADER, DEPTH_TO_MASK}, DrawMode::Triangles);
+  registerShaderProgram("AMBIENT_OCCLUSION_ESTIMATE", {TEXTURE_DRAW_VERT_SHADER, AMBIENT_OCCLUSION_ESTIMATE}, DrawMode::Triangles);
+  registerShaderProgram("AMBIENT_OCCLUSION_COMPOSITE", {TEXTURE_DRAW_VERT_SHADER, AMBIENT_OCCLUSION_COMPOSITE}, DrawMode::Triangles);
+  registerShaderProgram("DEFERRED_LIGHTING", {TEXTURE_DRAW_VERT_SHADER, DEFERRED_LIGHTING}, DrawMode::Triangles);
   registerShaderProgram("SCALAR_TEXTURE_COLORMAP", {TEXTURE_DRAW_VERT_SHADER, SCALAR_TEXTURE_COLORMAP}, DrawMode::Triangles);
   registerShaderProgram("BLUR_RGB", {TEXTURE_DRAW_VERT_SHADER, BLUR_RGB}, DrawMode::Triangles);
   registerShaderProgram("TRANSFORMATION_GIZMO_ROT", {TRANSFORMATION_GIZMO_ROT_VERT, TRANSFORMATION_GIZMO_ROT_FRAG}, DrawMode::Triangles);
@@ -1903,6 +2337,7 @@ void MockGLEngine::populateDefaultShadersAndRules() {
 
   // Utility rules
   registerShaderRule("GLSL_VERSION", GLSL_VERSION);
+  registerShaderRule("GLSL_VERSION_COMPUTE", GLSL_VERSION_COMPUTE);
   registerShaderRule("GLOBAL_FRAGMENT_FILTER", GLOBAL_FRAGMENT_FILTER);
   registerShaderRule("DOWNSAMPLE_RESOLVE_1", DOWNSAMPLE_RESOLVE_1);
   registerShaderRule("DOWNSAMPLE_RESOLVE_2", DOWNSAMPLE_RESOLVE_2);
@@ -1912,18 +2347,25 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("TRANSPARENCY_STRUCTURE", TRANSPARENCY_STRUCTURE);
   registerShaderRule("TRANSPARENCY_RESOLVE_SIMPLE", TRANSPARENCY_RESOLVE_SIMPLE);
   registerShaderRule("TRANSPARENCY_PEEL_STRUCTURE", TRANSPARENCY_PEEL_STRUCTURE);
+  registerShaderRule("TRANSPARENCY_WEIGHTED_STRUCTURE", TRANSPARENCY_WEIGHTED_STRUCTURE);
   registerShaderRule("TRANSPARENCY_PEEL_GROUND", TRANSPARENCY_PEEL_GROUND);
   
   registerShaderRule("GENERATE_VIEW_POS", GENERATE_VIEW_POS);
   registerShaderRule("CULL_POS_FROM_VIEW", CULL_POS_FROM_VIEW);
+  registerShaderRule("SLICE_PLANE_CULL", SLICE_PLANE_CULL);
+  registerShaderRule("THRESHOLD_CULL", THRESHOLD_CULL);
+  registerShaderRule("SUBSET_VISIBLE_CULL", SUBSET_VISIBLE_CULL);
+  registerShaderRule("SUBSET_HIGHLIGHT", SUBSET_HIGHLIGHT);
 
   // Lighting and shading things
   registerShaderRule("LIGHT_MATCAP", LIGHT_MATCAP);
+  registerShaderRule("LIGHT_DEFERRED", LIGHT_DEFERRED);
   registerShaderRule("LIGHT_PASSTHRU", LIGHT_PASSTHRU);
   registerShaderRule("SHADE_BASECOLOR", SHADE_BASECOLOR);
   registerShaderRule("SHADE_COLOR", SHADE_COLOR);
   registerShaderRule("SHADE_COLORMAP_VALUE", SHADE_COLORMAP_VALUE);
   registerShaderRule("SHADE_COLORMAP_ANGULAR2", SHADE_COLORMAP_ANGULAR2);
+  registerShaderRule("SHADE_LABEL_TABLE", SHADE_LABEL_TABLE);
   registerShaderRule("SHADE_GRID_VALUE2", SHADE_GRID_VALUE2);
   registerShaderRule("SHADE_CHECKER_VALUE2", SHADE_CHECKER_VALUE2);
   registerShaderRule("SHADEVALUE_MAG_VALUE2", SHADEVALUE_MAG_VALUE2);
@@ -1937,6 +2379,7 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("TEXTURE_SHADE_COLOR", TEXTURE_SHADE_COLOR);
   registerShaderRule("TEXTURE_PROPAGATE_VALUE", TEXTURE_PROPAGATE_VALUE);
   registerShaderRule("TEXTURE_BILLBOARD_FROM_UNIFORMS", TEXTURE_BILLBOARD_FROM_UNIFORMS);
+  registerShaderRule("TEXTURE_RECT_FROM_UNIFORMS", TEXTURE_RECT_FROM_UNIFORMS);
 
   // mesh things
   registerShaderRule("MESH_WIREFRAME", MESH_WIREFRAME);
@@ -1948,19 +2391,57 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("MESH_PROPAGATE_VALUE", MESH_PROPAGATE_VALUE);
   registerShaderRule("MESH_PROPAGATE_VALUE2", MESH_PROPAGATE_VALUE2);
   registerShaderRule("MESH_PROPAGATE_COLOR", MESH_PROPAGATE_COLOR);
+  registerShaderRule("MESH_PROPAGATE_COLOR_PACKED", MESH_PROPAGATE_COLOR_PACKED);
+  registerShaderRule("MESH_FACE_INDEX_FROM_PRIMITIVE_ID", MESH_FACE_INDEX_FROM_PRIMITIVE_ID);
+  registerShaderRule("MESH_FACE_INDEX_FROM_TRIANGLE_MAP", MESH_FACE_INDEX_FROM_TRIANGLE_MAP);
+  registerShaderRule("MESH_FETCH_FACE_VALUE", MESH_FETCH_FACE_VALUE);
+  registerShaderRule("MESH_FETCH_FACE_COLOR", MESH_FETCH_FACE_COLOR);
+  registerShaderRule("MESH_FETCH_FACE_CULLPOS", MESH_FETCH_FACE_CULLPOS);
   registerShaderRule("MESH_PROPAGATE_HALFEDGE_VALUE", MESH_PROPAGATE_HALFEDGE_VALUE);
   registerShaderRule("MESH_PROPAGATE_CULLPOS", MESH_PROPAGATE_CULLPOS);
+  registerShaderRule("MESH_PROPAGATE_SUBSET_INDEX", MESH_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("MESH_PROPAGATE_THRESHOLD", MESH_PROPAGATE_THRESHOLD);
+  registerShaderRule("MESH_PROPAGATE_VECTOR", MESH_PROPAGATE_VECTOR);
+  registerShaderRule("MESH_PROPAGATE_TANGENT_VECTOR", MESH_PROPAGATE_TANGENT_VECTOR);
+  registerShaderRule("MESH_SHADE_LIC", MESH_SHADE_LIC);
   registerShaderRule("MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE", MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE);
   registerShaderRule("MESH_PROPAGATE_PICK", MESH_PROPAGATE_PICK);
   registerShaderRule("MESH_PROPAGATE_PICK_SIMPLE", MESH_PROPAGATE_PICK_SIMPLE);
+  registerShaderRule("MESH_PICK_FROM_INDICES", MESH_PICK_FROM_INDICES);
+  registerShaderRule("MESH_PICK_CORNERS_FROM_INDICES", MESH_PICK_CORNERS_FROM_INDICES);
+  registerShaderRule("MESH_PICK_HALFEDGES_FROM_INDICES", MESH_PICK_HALFEDGES_FROM_INDICES);
+  registerShaderRule("MESH_INSTANCED", MESH_INSTANCED);
+  registerShaderRule("MESH_INSTANCE_COLOR", MESH_INSTANCE_COLOR);
+  registerShaderRule("MESH_INSTANCED_PICK", MESH_INSTANCED_PICK);
 
   // sphere things
+  registerShaderRule("GRID_SAMPLE_DENSE", GRID_SAMPLE_DENSE);
+  registerShaderRule("GRID_SAMPLE_STREAMED", GRID_SAMPLE_STREAMED);
   registerShaderRule("SPHERE_PROPAGATE_VALUE", SPHERE_PROPAGATE_VALUE);
   registerShaderRule("SPHERE_PROPAGATE_VALUE2", SPHERE_PROPAGATE_VALUE2);
   registerShaderRule("SPHERE_PROPAGATE_COLOR", SPHERE_PROPAGATE_COLOR);
+  registerShaderRule("SPHERE_PROPAGATE_COLOR_PACKED", SPHERE_PROPAGATE_COLOR_PACKED);
+  registerShaderRule("SPHERE_PROPAGATE_LABEL", SPHERE_PROPAGATE_LABEL);
+  registerShaderRule("SPHERE_PROPAGATE_THRESHOLD", SPHERE_PROPAGATE_THRESHOLD);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX", SPHERE_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE", SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE);
+  registerShaderRule("SPHERE_PROPAGATE_PICK", SPHERE_PROPAGATE_PICK);
+  registerShaderRule("SPHERE_PROPAGATE_PICK_INDEXED", SPHERE_PROPAGATE_PICK_INDEXED);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER", SPHERE_CULLPOS_FROM_CENTER);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER_QUAD", SPHERE_CULLPOS_FROM_CENTER_QUAD);
   registerShaderRule("SPHERE_VARIABLE_SIZE", SPHERE_VARIABLE_SIZE);
+  registerShaderRule("SPHERE_PROPAGATE_VALUE_INSTANCED", SPHERE_PROPAGATE_VALUE_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_VALUE2_INSTANCED", SPHERE_PROPAGATE_VALUE2_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_COLOR_INSTANCED", SPHERE_PROPAGATE_COLOR_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_COLOR_PACKED_INSTANCED", SPHERE_PROPAGATE_COLOR_PACKED_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_LABEL_INSTANCED", SPHERE_PROPAGATE_LABEL_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_THRESHOLD_INSTANCED", SPHERE_PROPAGATE_THRESHOLD_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX_INSTANCED", SPHERE_PROPAGATE_SUBSET_INDEX_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE_INSTANCED", SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_PICK_INSTANCED", SPHERE_PROPAGATE_PICK_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_PICK_INDEXED_INSTANCED", SPHERE_PROPAGATE_PICK_INDEXED_INSTANCED);
+  registerShaderRule("SPHERE_CULLPOS_FROM_CENTER_QUAD_INSTANCED", SPHERE_CULLPOS_FROM_CENTER_QUAD_INSTANCED);
+  registerShaderRule("SPHERE_VARIABLE_SIZE_INSTANCED", SPHERE_VARIABLE_SIZE_INSTANCED);
 
   // vector things
   registerShaderRule("VECTOR_PROPAGATE_COLOR", VECTOR_PROPAGATE_COLOR);
@@ -1973,8 +2454,29 @@ void MockGLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("CYLINDER_PROPAGATE_COLOR", CYLINDER_PROPAGATE_COLOR);
   registerShaderRule("CYLINDER_PROPAGATE_BLEND_COLOR", CYLINDER_PROPAGATE_BLEND_COLOR);
   registerShaderRule("CYLINDER_PROPAGATE_PICK", CYLINDER_PROPAGATE_PICK);
+  registerShaderRule("CYLINDER_PROPAGATE_SUBSET_INDEX", CYLINDER_PROPAGATE_SUBSET_INDEX);
   registerShaderRule("CYLINDER_CULLPOS_FROM_MID", CYLINDER_CULLPOS_FROM_MID);
   registerShaderRule("CYLINDER_VARIABLE_SIZE", CYLINDER_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE", CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR", CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_PICK", CYLINDER_INDEXED_PROPAGATE_PICK);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX", CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("CYLINDER_INDEXED_VARIABLE_SIZE", CYLINDER_INDEXED_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_PROPAGATE_VALUE_INSTANCED", CYLINDER_PROPAGATE_VALUE_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_BLEND_VALUE_INSTANCED", CYLINDER_PROPAGATE_BLEND_VALUE_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_COLOR_INSTANCED", CYLINDER_PROPAGATE_COLOR_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_BLEND_COLOR_INSTANCED", CYLINDER_PROPAGATE_BLEND_COLOR_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_PICK_INSTANCED", CYLINDER_PROPAGATE_PICK_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_SUBSET_INDEX_INSTANCED", CYLINDER_PROPAGATE_SUBSET_INDEX_INSTANCED);
+  registerShaderRule("CYLINDER_VARIABLE_SIZE_INSTANCED", CYLINDER_VARIABLE_SIZE_INSTANCED);
+  registerShaderRule("TUBE_PROPAGATE_BLEND_VALUE", TUBE_PROPAGATE_BLEND_VALUE);
+  registerShaderRule("TUBE_PROPAGATE_VALUE", TUBE_PROPAGATE_VALUE);
+  registerShaderRule("TUBE_PROPAGATE_BLEND_COLOR", TUBE_PROPAGATE_BLEND_COLOR);
+  registerShaderRule("TUBE_PROPAGATE_COLOR", TUBE_PROPAGATE_COLOR);
+  registerShaderRule("TUBE_PROPAGATE_PICK", TUBE_PROPAGATE_PICK);
+  registerShaderRule("TUBE_PROPAGATE_SUBSET_INDEX", TUBE_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("TUBE_CULLPOS_FROM_MID", TUBE_CULLPOS_FROM_MID);
+  registerShaderRule("TUBE_VARIABLE_SIZE", TUBE_VARIABLE_SIZE);
 
   // marching tets things
   registerShaderRule("SLICE_TETS_BASECOLOR_SHADE", SLICE_TETS_BASECOLOR_SHADE);
@@ -1987,11 +2489,6 @@ void MockGLEngine::populateDefaultShadersAndRules() {
 };
 
 
-void MockGLEngine::createSlicePlaneFliterRule(std::string uniquePostfix) {
-  using namespace backend_openGL3_glfw;
-  registeredShaderRules.insert({"SLICE_PLANE_CULL_" + uniquePostfix, generateSlicePlaneRule(uniquePostfix)});
-}
-
 } // namespace backend_openGL_mock
 } // namespace render
 } // namespace polyscope
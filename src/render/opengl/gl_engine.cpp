@@ -9,6 +9,7 @@
 #include "polyscope/messages.h"
 #include "polyscope/options.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/profiling.h"
 #include "polyscope/utilities.h"
 
 #include "polyscope/render/shader_builder.h"
@@ -22,15 +23,22 @@
 #include "polyscope/render/opengl/shaders/lighting_shaders.h"
 #include "polyscope/render/opengl/shaders/ribbon_shaders.h"
 #include "polyscope/render/opengl/shaders/rules.h"
+#include "polyscope/render/opengl/shaders/sort_shaders.h"
 #include "polyscope/render/opengl/shaders/sphere_shaders.h"
 #include "polyscope/render/opengl/shaders/surface_mesh_shaders.h"
 #include "polyscope/render/opengl/shaders/texture_draw_shaders.h"
 #include "polyscope/render/opengl/shaders/vector_shaders.h"
+#include "polyscope/render/opengl/shaders/volume_grid_shaders.h"
 #include "polyscope/render/opengl/shaders/volume_mesh_shaders.h"
 
 #include "stb_image.h"
 
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <set>
+#include <sstream>
 
 namespace polyscope {
 namespace render {
@@ -46,6 +54,17 @@ void initializeRenderEngine() {
   engine->allocateGlobalBuffersAndPrograms();
 }
 
+void initializeRenderEngineHeadlessEGL() {
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+  glEngine = new GLEngine(true);
+  engine = glEngine;
+  glEngine->initialize();
+  engine->allocateGlobalBuffersAndPrograms();
+#else
+  exception("Polyscope was not compiled with support for backend: openGL3_egl");
+#endif
+}
+
 // == Map enums to native values
 
 // clang-format off
@@ -101,11 +120,13 @@ inline GLenum type(const TextureFormat& x) {
   return GL_UNSIGNED_BYTE;
 }
 
+const GLenum PS_GL_COMPUTE_SHADER = 0x91B9; // (GL 4.3, not in the GL 3.3 loader)
+
 inline GLenum native(const ShaderStageType& x) {
   switch (x) {
     case ShaderStageType::Vertex:           return GL_VERTEX_SHADER;
     case ShaderStageType::Geometry:         return GL_GEOMETRY_SHADER;
-    //case ShaderStageType::Compute:          return GL_COMPUTE_SHADER;
+    case ShaderStageType::Compute:          return PS_GL_COMPUTE_SHADER;
     case ShaderStageType::Fragment:         return GL_FRAGMENT_SHADER;
   }
   exception("bad enum");
@@ -143,6 +164,79 @@ inline GLenum colorAttachNum(const unsigned int i) {
 // clang-format on
 
 
+namespace {
+// The program and vertex array last bound through the wrappers below, or -1 if unknown. Scenes with many small
+// structures bind and set uniforms on a long run of programs each pass, and skipping the redundant binds keeps the
+// per-draw driver overhead down. Reset by invalidateBindingCache() wherever code outside this file may have changed
+// the bindings or state (ImGui, context switches).
+GLint boundProgramHandle = -1;
+GLint boundVAOHandle = -1;
+
+// Input events received by the window, see GLEngine::getInputEventCount() (the GLFW callbacks can't carry state)
+uint64_t glfwInputEventCount = 0;
+
+void useProgram(GLuint handle) {
+  if (boundProgramHandle == static_cast<GLint>(handle)) return;
+  glUseProgram(handle);
+  boundProgramHandle = handle;
+}
+
+void bindVertexArray(GLuint handle) {
+  if (boundVAOHandle == static_cast<GLint>(handle)) return;
+  glBindVertexArray(handle);
+  boundVAOHandle = handle;
+}
+
+// Likewise the active texture unit and the texture last bound to each unit, as {target, handle}. Units bind a texture
+// per target, so this only knows that the last binding is still current.
+GLint activeTextureUnit = -1;
+std::vector<std::pair<GLenum, GLuint>> boundTextures;
+
+void activeTexture(GLuint unit) {
+  if (activeTextureUnit == static_cast<GLint>(unit)) return;
+  glActiveTexture(GL_TEXTURE0 + unit);
+  activeTextureUnit = unit;
+}
+
+void bindTexture(GLenum target, GLuint handle) {
+  if (activeTextureUnit < 0) {
+    glBindTexture(target, handle);
+    return;
+  }
+  if (static_cast<size_t>(activeTextureUnit) >= boundTextures.size()) {
+    boundTextures.resize(activeTextureUnit + 1, std::make_pair(GLenum(0), GLuint(0)));
+  }
+  std::pair<GLenum, GLuint>& bound = boundTextures[activeTextureUnit];
+  if (bound.first == target && bound.second == handle) return;
+  glBindTexture(target, handle);
+  bound = std::make_pair(target, handle);
+}
+
+void forgetBoundTexture(GLuint handle) { // (deleting a texture unbinds it, and the handle may be reused)
+  for (std::pair<GLenum, GLuint>& bound : boundTextures) {
+    if (bound.second == handle) bound = std::make_pair(GLenum(0), GLuint(0));
+  }
+}
+
+// And the fixed-function state last set through GLEngine::setDepthMode() and friends, or -1 if unknown. Each pass
+// sets the same modes for every structure it draws, so most of these calls are redundant.
+int currDepthMode = -1;
+int currBlendMode = -1; // (combined with whether a G-buffer pass is active, which changes the blending)
+int currColorMask = -1;
+int currBackfaceCull = -1;
+
+void invalidateBindingCache() {
+  boundProgramHandle = -1;
+  boundVAOHandle = -1;
+  activeTextureUnit = -1;
+  boundTextures.clear();
+  currDepthMode = -1;
+  currBlendMode = -1;
+  currColorMask = -1;
+  currBackfaceCull = -1;
+}
+} // namespace
+
 // Stateful error checker
 void checkGLError(bool fatal = true) {
 
@@ -251,6 +345,28 @@ void GLAttributeBuffer::checkArray(int testArrayCount) {
 
 GLenum GLAttributeBuffer::getTarget() { return GL_ARRAY_BUFFER; }
 
+GLenum GLAttributeBuffer::getUsage() { return streaming ? GL_STREAM_DRAW : GL_STATIC_DRAW; }
+
+void GLAttributeBuffer::allocateFullBuffer(size_t nBytes, const void* dataPtr) {
+  profiling::ScopedTimer timer("GLAttributeBuffer upload");
+  glBufferData(getTarget(), nBytes, dataPtr, getUsage());
+  capacityBytes = nBytes;
+}
+
+void GLAttributeBuffer::updateFullBuffer(size_t nBytes, const void* dataPtr) {
+  profiling::ScopedTimer timer("GLAttributeBuffer upload");
+  if (nBytes > capacityBytes) {
+    // (only for resizable buffers) grow geometrically, so that repeated resizes rarely reallocate
+    capacityBytes = std::max(nBytes, capacityBytes + capacityBytes / 2);
+    glBufferData(getTarget(), capacityBytes, nullptr, getUsage());
+  } else if (streaming) {
+    // Orphan the old storage first. The driver can then hand us fresh memory immediately, rather than blocking until
+    // in-flight draws which still read the old contents have finished.
+    glBufferData(getTarget(), capacityBytes, nullptr, GL_STREAM_DRAW);
+  }
+  glBufferSubData(getTarget(), 0, nBytes, dataPtr);
+}
+
 void GLAttributeBuffer::setData(const std::vector<glm::vec2>& data) {
   checkType(RenderDataType::Vector2Float);
 
@@ -261,13 +377,13 @@ void GLAttributeBuffer::setData(const std::vector<glm::vec2>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
-    glBufferSubData(getTarget(), 0, 2 * dataSize * sizeof(float), &data[0]);
+    updateFullBuffer(2 * dataSize * sizeof(float), &data[0]);
 
   } else {
 
-    glBufferData(getTarget(), 2 * data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(2 * data.size() * sizeof(float), &data[0]);
     dataSize = data.size();
   }
 }
@@ -282,12 +398,12 @@ void GLAttributeBuffer::setData(const std::vector<glm::vec3>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
-    glBufferSubData(getTarget(), 0, 3 * dataSize * sizeof(float), &data[0]);
+    updateFullBuffer(3 * dataSize * sizeof(float), &data[0]);
 
   } else {
-    glBufferData(getTarget(), 3 * data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(3 * data.size() * sizeof(float), &data[0]);
     dataSize = data.size();
   }
 }
@@ -300,12 +416,12 @@ void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 2>>& dat
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(2 * data.size());
 
-    glBufferSubData(getTarget(), 0, 2 * 3 * dataSize * sizeof(float), &data[0]);
+    updateFullBuffer(3 * dataSize * sizeof(float), &data[0]);
 
   } else {
-    glBufferData(getTarget(), 2 * 3 * data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(2 * 3 * data.size() * sizeof(float), &data[0]);
     dataSize = 2 * data.size();
   }
 }
@@ -318,12 +434,12 @@ void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 3>>& dat
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(3 * data.size());
 
-    glBufferSubData(getTarget(), 0, 3 * 3 * dataSize * sizeof(float), &data[0]);
+    updateFullBuffer(3 * dataSize * sizeof(float), &data[0]);
 
   } else {
-    glBufferData(getTarget(), 3 * 3 * data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(3 * 3 * data.size() * sizeof(float), &data[0]);
     dataSize = 3 * data.size();
   }
 }
@@ -336,12 +452,12 @@ void GLAttributeBuffer::setData(const std::vector<std::array<glm::vec3, 4>>& dat
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(4 * data.size());
 
-    glBufferSubData(getTarget(), 0, 4 * 3 * dataSize * sizeof(float), &data[0]);
+    updateFullBuffer(3 * dataSize * sizeof(float), &data[0]);
 
   } else {
-    glBufferData(getTarget(), 4 * 3 * data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(4 * 3 * data.size() * sizeof(float), &data[0]);
     dataSize = 4 * data.size();
   }
 }
@@ -356,12 +472,12 @@ void GLAttributeBuffer::setData(const std::vector<glm::vec4>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
-    glBufferSubData(getTarget(), 0, 4 * dataSize * sizeof(float), &data[0]);
+    updateFullBuffer(4 * dataSize * sizeof(float), &data[0]);
 
   } else {
-    glBufferData(getTarget(), 4 * data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(4 * data.size() * sizeof(float), &data[0]);
     dataSize = data.size();
   }
 }
@@ -373,12 +489,12 @@ void GLAttributeBuffer::setData(const std::vector<float>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
-    glBufferSubData(getTarget(), 0, dataSize * sizeof(float), &data[0]);
+    updateFullBuffer(dataSize * sizeof(float), &data[0]);
 
   } else {
-    glBufferData(getTarget(), data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(data.size() * sizeof(float), &data[0]);
     dataSize = data.size();
   }
 }
@@ -396,12 +512,12 @@ void GLAttributeBuffer::setData(const std::vector<double>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
-    glBufferSubData(getTarget(), 0, dataSize * sizeof(float), &floatData[0]);
+    updateFullBuffer(dataSize * sizeof(float), &floatData[0]);
 
   } else {
-    glBufferData(getTarget(), data.size() * sizeof(float), &floatData[0], GL_STATIC_DRAW);
+    allocateFullBuffer(data.size() * sizeof(float), &floatData[0]);
     dataSize = data.size();
   }
 }
@@ -419,13 +535,13 @@ void GLAttributeBuffer::setData(const std::vector<int32_t>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
-    glBufferSubData(getTarget(), 0, dataSize * sizeof(GLint), &data[0]);
+    updateFullBuffer(dataSize * sizeof(GLint), &data[0]);
 
   } else {
 
-    glBufferData(getTarget(), data.size() * sizeof(GLint), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(data.size() * sizeof(GLint), &data[0]);
     dataSize = data.size();
   }
 }
@@ -442,12 +558,12 @@ void GLAttributeBuffer::setData(const std::vector<uint32_t>& data) {
 
   if (isSet()) {
 
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
+    setUpdatedDataSize(data.size());
 
-    glBufferSubData(getTarget(), 0, dataSize * sizeof(GLuint), &data[0]);
+    updateFullBuffer(dataSize * sizeof(GLuint), &data[0]);
 
   } else {
-    glBufferData(getTarget(), data.size() * sizeof(GLuint), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(data.size() * sizeof(GLuint), &data[0]);
     dataSize = data.size();
   }
 }
@@ -461,10 +577,10 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec2>& data) {
   bind();
 
   if (isSet()) {
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
-    glBufferSubData(getTarget(), 0, 2 * dataSize * sizeof(GLuint), &data[0]);
+    setUpdatedDataSize(data.size());
+    updateFullBuffer(2 * dataSize * sizeof(GLuint), &data[0]);
   } else {
-    glBufferData(getTarget(), 2 * data.size() * sizeof(GLuint), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(2 * data.size() * sizeof(GLuint), &data[0]);
     dataSize = data.size();
   }
 }
@@ -477,10 +593,10 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec3>& data) {
   bind();
 
   if (isSet()) {
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
-    glBufferSubData(getTarget(), 0, 3 * dataSize * sizeof(GLuint), &data[0]);
+    setUpdatedDataSize(data.size());
+    updateFullBuffer(3 * dataSize * sizeof(GLuint), &data[0]);
   } else {
-    glBufferData(getTarget(), 3 * data.size() * sizeof(GLuint), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(3 * data.size() * sizeof(GLuint), &data[0]);
     dataSize = data.size();
   }
 }
@@ -494,14 +610,164 @@ void GLAttributeBuffer::setData(const std::vector<glm::uvec4>& data) {
   bind();
 
   if (isSet()) {
-    if (static_cast<int64_t>(data.size()) != dataSize) exception("updated data must have same size");
-    glBufferSubData(getTarget(), 0, 4 * dataSize * sizeof(GLuint), &data[0]);
+    setUpdatedDataSize(data.size());
+    updateFullBuffer(4 * dataSize * sizeof(GLuint), &data[0]);
   } else {
-    glBufferData(getTarget(), 4 * data.size() * sizeof(GLuint), &data[0], GL_STATIC_DRAW);
+    allocateFullBuffer(4 * data.size() * sizeof(GLuint), &data[0]);
     dataSize = data.size();
   }
 }
 
+void GLAttributeBuffer::setDataRaw(const void* data, size_t nElements) {
+  size_t nEntries = arrayCount * nElements;
+  size_t nBytes = nEntries * renderDataTypeSizeInBytes(dataType);
+
+  bind();
+
+  if (isSet()) {
+    setUpdatedDataSize(nEntries);
+    updateFullBuffer(nBytes, data);
+  } else {
+    allocateFullBuffer(nBytes, data);
+    dataSize = nEntries;
+  }
+}
+
+void GLAttributeBuffer::resize(size_t newNElements) {
+  if (!isSet()) exception("can only resize a buffer which has already been set");
+
+  size_t entryBytes = renderDataTypeSizeInBytes(dataType);
+  size_t oldBytes = dataSize * entryBytes;
+  setUpdatedDataSize(arrayCount * newNElements);
+  size_t newBytes = dataSize * entryBytes;
+  if (newBytes <= capacityBytes) return;
+
+  // Grow geometrically. The buffer keeps its name (vertex arrays refer to it), so the old contents are copied out to a
+  // temporary buffer and back while the storage is reallocated, all on the device.
+  size_t newCapacity = std::max(newBytes, capacityBytes + capacityBytes / 2);
+  GLuint tempBuffer;
+  glGenBuffers(1, &tempBuffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, tempBuffer);
+  glBufferData(GL_COPY_WRITE_BUFFER, oldBytes, nullptr, GL_STREAM_COPY);
+  glBindBuffer(GL_COPY_READ_BUFFER, VBOLoc);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+
+  bind();
+  glBufferData(getTarget(), newCapacity, nullptr, getUsage());
+  capacityBytes = newCapacity;
+
+  glBindBuffer(GL_COPY_READ_BUFFER, tempBuffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, VBOLoc);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+  glDeleteBuffers(1, &tempBuffer);
+
+  checkGLError();
+}
+
+// update ranges of data
+
+template <typename T>
+void GLAttributeBuffer::setDataRangeHelper(const std::vector<T>& data, size_t dataStart, size_t dataEnd,
+                                           size_t bufferStart) {
+  if (!isSet()) exception("can only update a range of a buffer which has already been set");
+  if (dataStart > dataEnd || dataEnd > data.size()) exception("bad data range in setDataRange()");
+  size_t bufferCount = dataSize / arrayCount; // in units of T
+  if (bufferStart + (dataEnd - dataStart) > bufferCount) exception("range is out of bounds in setDataRange()");
+  if (dataStart == dataEnd) return;
+
+  bind();
+  glBufferSubData(getTarget(), bufferStart * sizeof(T), (dataEnd - dataStart) * sizeof(T), &data[dataStart]);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec2>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector2Float);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec3>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::vec4>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector4Float);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<float>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Float);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<double>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Float);
+
+  // Convert input data to floats
+  if (dataStart > dataEnd || dataEnd > data.size()) exception("bad data range in setDataRange()");
+  std::vector<float> floatData(dataEnd - dataStart);
+  for (size_t i = dataStart; i < dataEnd; i++) {
+    floatData[i - dataStart] = static_cast<float>(data[i]);
+  }
+
+  setDataRangeHelper(floatData, 0, floatData.size(), bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<int32_t>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Int);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<uint32_t>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::UInt);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec2>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector2UInt);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec3>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3UInt);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<glm::uvec4>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector4UInt);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 2>>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(2);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 3>>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(3);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
+void GLAttributeBuffer::setDataRange(const std::vector<std::array<glm::vec3, 4>>& data, size_t dataStart, size_t dataEnd,
+                                     size_t bufferStart) {
+  checkType(RenderDataType::Vector3Float);
+  checkArray(4);
+  setDataRangeHelper(data, dataStart, dataEnd, bufferStart);
+}
+
 // get single data values
 
 float GLAttributeBuffer::getData_float(size_t ind) {
@@ -584,7 +850,7 @@ std::vector<float> GLAttributeBuffer::getDataRange_float(size_t ind, size_t coun
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Float) exception("bad getData type");
   bind();
-  std::vector<float> readValues;
+  std::vector<float> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(float), count * sizeof(float), &readValues.front());
   return readValues;
 }
@@ -602,7 +868,7 @@ std::vector<glm::vec2> GLAttributeBuffer::getDataRange_vec2(size_t ind, size_t c
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Vector2Float) exception("bad getData type");
   bind();
-  std::vector<glm::vec2> readValues;
+  std::vector<glm::vec2> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(glm::vec2), count * sizeof(glm::vec2), &readValues.front());
   return readValues;
 }
@@ -610,7 +876,7 @@ std::vector<glm::vec3> GLAttributeBuffer::getDataRange_vec3(size_t ind, size_t c
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Vector3Float) exception("bad getData type");
   bind();
-  std::vector<glm::vec3> readValues;
+  std::vector<glm::vec3> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(glm::vec3), count * sizeof(glm::vec3), &readValues.front());
   return readValues;
 }
@@ -618,7 +884,7 @@ std::vector<glm::vec4> GLAttributeBuffer::getDataRange_vec4(size_t ind, size_t c
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Vector4Float) exception("bad getData type");
   bind();
-  std::vector<glm::vec4> readValues;
+  std::vector<glm::vec4> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(glm::vec4), count * sizeof(glm::vec4), &readValues.front());
   return readValues;
 }
@@ -626,7 +892,7 @@ std::vector<int> GLAttributeBuffer::getDataRange_int(size_t ind, size_t count) {
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Int) exception("bad getData type");
   bind();
-  std::vector<GLint> readValues;
+  std::vector<GLint> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(GLint), count * sizeof(GLint), &readValues.front());
 
   // probably does nothing
@@ -641,7 +907,7 @@ std::vector<uint32_t> GLAttributeBuffer::getDataRange_uint32(size_t ind, size_t
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::UInt) exception("bad getData type");
   bind();
-  std::vector<uint32_t> readValues;
+  std::vector<uint32_t> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(uint32_t), count * sizeof(uint32_t), &readValues.front());
   return readValues;
 }
@@ -649,7 +915,7 @@ std::vector<glm::uvec2> GLAttributeBuffer::getDataRange_uvec2(size_t ind, size_t
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Vector2Float) exception("bad getData type");
   bind();
-  std::vector<glm::uvec2> readValues;
+  std::vector<glm::uvec2> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(glm::uvec2), count * sizeof(glm::uvec2), &readValues.front());
   return readValues;
 }
@@ -657,7 +923,7 @@ std::vector<glm::uvec3> GLAttributeBuffer::getDataRange_uvec3(size_t ind, size_t
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Vector3Float) exception("bad getData type");
   bind();
-  std::vector<glm::uvec3> readValues;
+  std::vector<glm::uvec3> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(glm::uvec3), count * sizeof(glm::uvec3), &readValues.front());
   return readValues;
 }
@@ -665,12 +931,39 @@ std::vector<glm::uvec4> GLAttributeBuffer::getDataRange_uvec4(size_t ind, size_t
   if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
   if (getType() != RenderDataType::Vector4Float) exception("bad getData type");
   bind();
-  std::vector<glm::uvec4> readValues;
+  std::vector<glm::uvec4> readValues(count);
   glGetBufferSubData(getTarget(), ind * sizeof(glm::uvec4), count * sizeof(glm::uvec4), &readValues.front());
   return readValues;
 }
 
 
+void GLAttributeBuffer::getDataRangeRawAsync(size_t ind, size_t count, std::function<void(const void*)> callback) {
+  if (!isSet() || ind + count > static_cast<size_t>(getDataSize())) exception("bad getData");
+  if (count == 0) {
+    callback(nullptr);
+    return;
+  }
+
+  size_t entryBytes = renderDataTypeSizeInBytes(getType());
+  GLPendingReadback readback;
+  readback.nBytes = count * entryBytes;
+  readback.deliver = callback;
+
+  // Unlike glGetBufferSubData(), the copy does not wait for pending draws which use the buffer
+  glGenBuffers(1, &readback.pboHandle);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, readback.pboHandle);
+  glBufferData(GL_COPY_WRITE_BUFFER, readback.nBytes, nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_COPY_READ_BUFFER, VBOLoc);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, ind * entryBytes, 0, readback.nBytes);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  checkGLError();
+
+  glEngine->addPendingReadback(readback);
+}
+
+
 uint32_t GLAttributeBuffer::getNativeBufferID() { return static_cast<uint32_t>(VBOLoc); }
 
 // =============================================================
@@ -683,7 +976,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int size1D, con
     : TextureBuffer(1, format_, size1D) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_1D, handle);
+  bindTexture(GL_TEXTURE_1D, handle);
   glTexImage1D(GL_TEXTURE_1D, 0, internalFormat(format), size1D, 0, formatF(format), GL_UNSIGNED_BYTE, data);
   checkGLError();
 
@@ -693,7 +986,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int size1D, con
     : TextureBuffer(1, format_, size1D) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_1D, handle);
+  bindTexture(GL_TEXTURE_1D, handle);
   glTexImage1D(GL_TEXTURE_1D, 0, internalFormat(format), size1D, 0, formatF(format), GL_FLOAT, data);
   checkGLError();
 
@@ -706,7 +999,7 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
     : TextureBuffer(2, format_, sizeX_, sizeY_) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_2D, handle);
+  bindTexture(GL_TEXTURE_2D, handle);
   glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(format), sizeX, sizeY, 0, formatF(format), GL_UNSIGNED_BYTE, data);
   checkGLError();
 
@@ -717,14 +1010,34 @@ GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, uns
     : TextureBuffer(2, format_, sizeX_, sizeY_) {
 
   glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_2D, handle);
+  bindTexture(GL_TEXTURE_2D, handle);
   glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(format), sizeX, sizeY, 0, formatF(format), GL_FLOAT, data);
   checkGLError();
 
   setFilterMode(FilterMode::Nearest);
 }
 
-GLTextureBuffer::~GLTextureBuffer() { glDeleteTextures(1, &handle); }
+// create a 3D texture from data
+GLTextureBuffer::GLTextureBuffer(TextureFormat format_, unsigned int sizeX_, unsigned int sizeY_, unsigned int sizeZ_,
+                                 const float* data)
+    : TextureBuffer(3, format_, sizeX_, sizeY_, sizeZ_) {
+
+  glGenTextures(1, &handle);
+  bindTexture(GL_TEXTURE_3D, handle);
+
+  // rows of a single-channel float texture may not be 4-aligned in general, so don't assume they are
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage3D(GL_TEXTURE_3D, 0, internalFormat(format), sizeX, sizeY, sizeZ, 0, formatF(format), GL_FLOAT, data);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  checkGLError();
+
+  setFilterMode(FilterMode::Nearest);
+}
+
+GLTextureBuffer::~GLTextureBuffer() {
+  forgetBoundTexture(handle);
+  glDeleteTextures(1, &handle);
+}
 
 void GLTextureBuffer::resize(unsigned int newLen) {
 
@@ -737,6 +1050,9 @@ void GLTextureBuffer::resize(unsigned int newLen) {
   if (dim == 2) {
     exception("OpenGL error: called 1D resize on 2D texture");
   }
+  if (dim == 3) {
+    exception("OpenGL error: called 1D resize on 3D texture");
+  }
   checkGLError();
 }
 
@@ -751,6 +1067,9 @@ void GLTextureBuffer::resize(unsigned int newX, unsigned int newY) {
   if (dim == 2) {
     glTexImage2D(GL_TEXTURE_2D, 0, internalFormat(format), sizeX, sizeY, 0, formatF(format), type(format), nullptr);
   }
+  if (dim == 3) {
+    exception("OpenGL error: called 2D resize on 3D texture");
+  }
   checkGLError();
 }
 
@@ -769,9 +1088,12 @@ void GLTextureBuffer::setFilterMode(FilterMode newMode) {
     break;
   }
   glTexParameteri(textureType(), GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  if (dim == 2) {
+  if (dim >= 2) {
     glTexParameteri(textureType(), GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   }
+  if (dim == 3) {
+    glTexParameteri(textureType(), GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  }
 
   checkGLError();
 }
@@ -818,18 +1140,53 @@ std::vector<glm::vec3> GLTextureBuffer::getDataVector3() {
   return outData;
 }
 
+void GLTextureBuffer::setDataRegion(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                                    const float* data) {
+  checkRegionInBounds(xStart, yStart, w, h);
+
+  bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, xStart, yStart, w, h, formatF(format), GL_FLOAT, data);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataRegionHalfFloat(unsigned int xStart, unsigned int yStart, unsigned int w, unsigned int h,
+                                             const uint16_t* data) {
+  checkRegionInBounds(xStart, yStart, w, h);
+
+  bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, xStart, yStart, w, h, formatF(format), GL_HALF_FLOAT, data);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  checkGLError();
+}
+
+void GLTextureBuffer::setDataRegion3D(unsigned int xStart, unsigned int yStart, unsigned int zStart, unsigned int w,
+                                      unsigned int h, unsigned int d, const float* data) {
+  checkRegionInBounds3D(xStart, yStart, zStart, w, h, d);
+
+  bind();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage3D(GL_TEXTURE_3D, 0, xStart, yStart, zStart, w, h, d, formatF(format), GL_FLOAT, data);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  checkGLError();
+}
+
 GLenum GLTextureBuffer::textureType() {
   if (dim == 1) {
     return GL_TEXTURE_1D;
   } else if (dim == 2) {
     return GL_TEXTURE_2D;
+  } else if (dim == 3) {
+    return GL_TEXTURE_3D;
   }
   exception("bad texture type");
   return GL_TEXTURE_1D;
 }
 
 void GLTextureBuffer::bind() {
-  glBindTexture(textureType(), handle);
+  bindTexture(textureType(), handle);
   checkGLError();
 }
 
@@ -1001,6 +1358,8 @@ bool GLFrameBuffer::bindForRendering() {
   // Enable blending
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  currDepthMode = -1; // (these don't match any of the modes exactly)
+  currBlendMode = -1;
 
   checkGLError();
   return true;
@@ -1014,6 +1373,18 @@ void GLFrameBuffer::clear() {
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
+void GLFrameBuffer::clearRegion(int startX, int startY, unsigned int sizeX, unsigned int sizeY) {
+  if (!bindForRendering()) return;
+
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(startX, startY, sizeX, sizeY);
+  glClearColor(clearColor[0], clearColor[1], clearColor[2], clearAlpha);
+  glClearDepth(clearDepth);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  glDisable(GL_SCISSOR_TEST);
+  checkGLError();
+}
+
 std::array<float, 4> GLFrameBuffer::readFloat4(int xPos, int yPos) {
 
   // if (colorRenderBuffer == nullptr || colorRenderBuffer->getType() != RenderBufferType::Float4) {
@@ -1031,6 +1402,20 @@ std::array<float, 4> GLFrameBuffer::readFloat4(int xPos, int yPos) {
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readFloat4Region(int xPos, int yPos, int sizeX, int sizeY) {
+
+  glFlush();
+  glFinish();
+  bind();
+
+  // Read from the buffer
+  std::vector<float> result(4 * sizeX * sizeY);
+  if (result.empty()) return result;
+  glReadPixels(xPos, yPos, sizeX, sizeY, GL_RGBA, GL_FLOAT, &result.front());
+
+  return result;
+}
+
 float GLFrameBuffer::readDepth(int xPos, int yPos) {
 
   // TODO does no error checking for the case where no depth buffer is attached
@@ -1046,6 +1431,20 @@ float GLFrameBuffer::readDepth(int xPos, int yPos) {
   return result;
 }
 
+std::vector<float> GLFrameBuffer::readDepthRegion(int xPos, int yPos, int sizeX, int sizeY) {
+
+  glFlush();
+  glFinish();
+  bind();
+
+  // Read from the buffer
+  std::vector<float> result(sizeX * sizeY);
+  if (result.empty()) return result;
+  glReadPixels(xPos, yPos, sizeX, sizeY, GL_DEPTH_COMPONENT, GL_FLOAT, &result.front());
+
+  return result;
+}
+
 std::vector<unsigned char> GLFrameBuffer::readBuffer() {
 
   glFlush();
@@ -1064,6 +1463,59 @@ std::vector<unsigned char> GLFrameBuffer::readBuffer() {
   return buff;
 }
 
+namespace {
+// Issue a glReadPixels() in to a fresh pixel buffer object, and register it with the engine to be delivered once the
+// GPU has finished. The framebuffer to read from must already be bound.
+void enqueueAsyncReadPixels(int xPos, int yPos, int w, int h, GLenum format, GLenum type, size_t nBytes,
+                            std::function<void(const void*)> deliver) {
+
+  GLPendingReadback readback;
+  readback.nBytes = nBytes;
+  readback.deliver = deliver;
+
+  glGenBuffers(1, &readback.pboHandle);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pboHandle);
+  glBufferData(GL_PIXEL_PACK_BUFFER, nBytes, nullptr, GL_STREAM_READ);
+  glReadPixels(xPos, yPos, w, h, format, type, 0); // offset in to the bound pack buffer
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  checkGLError();
+
+  glEngine->addPendingReadback(readback);
+}
+} // namespace
+
+void GLFrameBuffer::readFloat4Async(int xPos, int yPos, std::function<void(std::array<float, 4>)> callback) {
+  bind();
+  enqueueAsyncReadPixels(xPos, yPos, 1, 1, GL_RGBA, GL_FLOAT, 4 * sizeof(float), [callback](const void* data) {
+    std::array<float, 4> result;
+    std::memcpy(&result, data, 4 * sizeof(float));
+    callback(result);
+  });
+}
+
+void GLFrameBuffer::readBufferAsync(std::function<void(std::vector<unsigned char>)> callback) {
+  bind();
+  int w = getSizeX();
+  int h = getSizeY();
+  size_t buffSize = w * h * 4;
+  enqueueAsyncReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, buffSize, [callback, buffSize](const void* data) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    callback(std::vector<unsigned char>(bytes, bytes + buffSize));
+  });
+}
+
+void GLFrameBuffer::readDepthRegionAsync(int xPos, int yPos, int sizeX, int sizeY,
+                                         std::function<void(std::vector<float>)> callback) {
+  bind();
+  size_t count = static_cast<size_t>(sizeX) * sizeY;
+  enqueueAsyncReadPixels(xPos, yPos, sizeX, sizeY, GL_DEPTH_COMPONENT, GL_FLOAT, count * sizeof(float),
+                         [callback, count](const void* data) {
+                           const float* values = static_cast<const float*>(data);
+                           callback(std::vector<float>(values, values + count));
+                         });
+}
+
 void GLFrameBuffer::blitTo(FrameBuffer* targetIn) {
 
   // it _better_ be a GL buffer
@@ -1084,6 +1536,258 @@ void GLFrameBuffer::blitTo(FrameBuffer* targetIn) {
 // =============================================================
 
 
+namespace {
+
+// == On-disk program binary cache (see options::shaderCacheDirectory)
+// The entry points are core in GL 4.1 and available through ARB_get_program_binary, but not in the GL 3.3 loader, so
+// they are fetched manually.
+
+#ifdef _WIN32
+#define POLYSCOPE_GL_APIENTRY __stdcall
+#else
+#define POLYSCOPE_GL_APIENTRY
+#endif
+
+const GLenum PS_GL_PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+const GLenum PS_GL_PROGRAM_BINARY_LENGTH = 0x8741;
+const GLenum PS_GL_NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+const GLenum PS_GL_COMPLETION_STATUS_KHR = 0x91B1;
+
+typedef void(POLYSCOPE_GL_APIENTRY* GetProgramBinaryFunc)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+typedef void(POLYSCOPE_GL_APIENTRY* ProgramBinaryFunc)(GLuint, GLenum, const void*, GLsizei);
+typedef void(POLYSCOPE_GL_APIENTRY* ProgramParameteriFunc)(GLuint, GLenum, GLint);
+typedef void(POLYSCOPE_GL_APIENTRY* MaxShaderCompilerThreadsFunc)(GLuint);
+
+// Entry points and extensions are looked up through whichever API created the context
+typedef void (*GLProcFunc)();
+GLProcFunc getGLProcAddress(const char* name) {
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+  if (glEngine->isHeadless()) return reinterpret_cast<GLProcFunc>(eglGetProcAddress(name));
+#endif
+  return reinterpret_cast<GLProcFunc>(glfwGetProcAddress(name));
+}
+
+bool isGLExtensionSupported(const char* name) {
+  if (!glEngine->isHeadless()) return glfwExtensionSupported(name);
+
+  GLint nExtensions = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &nExtensions);
+  for (GLint i = 0; i < nExtensions; i++) {
+    const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+    if (ext != nullptr && std::strcmp(ext, name) == 0) return true;
+  }
+  return false;
+}
+
+GetProgramBinaryFunc psGetProgramBinary = nullptr;
+ProgramBinaryFunc psProgramBinary = nullptr;
+ProgramParameteriFunc psProgramParameteri = nullptr;
+std::string driverIdentifier;
+bool parallelShaderCompileSupported = false;
+
+const char programCacheMagic[] = "polyscope-program-binary-v1";
+
+void loadProgramBinaryFunctions() {
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  bool supported = (major > 4 || (major == 4 && minor >= 1)) || isGLExtensionSupported("GL_ARB_get_program_binary");
+  if (supported) {
+    psGetProgramBinary = reinterpret_cast<GetProgramBinaryFunc>(getGLProcAddress("glGetProgramBinary"));
+    psProgramBinary = reinterpret_cast<ProgramBinaryFunc>(getGLProcAddress("glProgramBinary"));
+    psProgramParameteri = reinterpret_cast<ProgramParameteriFunc>(getGLProcAddress("glProgramParameteri"));
+  }
+
+  // some drivers support the calls, but no formats
+  GLint nFormats = 0;
+  if (psGetProgramBinary) glGetIntegerv(PS_GL_NUM_PROGRAM_BINARY_FORMATS, &nFormats);
+  if (nFormats == 0) {
+    psGetProgramBinary = nullptr;
+    psProgramBinary = nullptr;
+    psProgramParameteri = nullptr;
+  }
+
+  driverIdentifier = std::string(reinterpret_cast<const char*>(glGetString(GL_VENDOR))) + "|" +
+                     reinterpret_cast<const char*>(glGetString(GL_RENDERER)) + "|" +
+                     reinterpret_cast<const char*>(glGetString(GL_VERSION));
+}
+
+// KHR_parallel_shader_compile (or the equivalent ARB extension) lets compiles run on driver threads, and adds a
+// non-blocking completion query
+void loadParallelShaderCompileFunctions() {
+  MaxShaderCompilerThreadsFunc maxThreads = nullptr;
+  if (isGLExtensionSupported("GL_KHR_parallel_shader_compile")) {
+    maxThreads = reinterpret_cast<MaxShaderCompilerThreadsFunc>(getGLProcAddress("glMaxShaderCompilerThreadsKHR"));
+  } else if (isGLExtensionSupported("GL_ARB_parallel_shader_compile")) {
+    maxThreads = reinterpret_cast<MaxShaderCompilerThreadsFunc>(getGLProcAddress("glMaxShaderCompilerThreadsARB"));
+  }
+  if (maxThreads == nullptr) return;
+
+  maxThreads(0xFFFFFFFF); // let the driver pick
+  parallelShaderCompileSupported = true;
+}
+
+// == Compute programs
+// Compute shaders and shader storage buffers are core in GL 4.3, and likewise fetched manually. Drivers usually give a
+// 4.x context even though 3.3 is requested, but where they do not (e.g. macOS, which stops at 4.1) compute programs
+// are unavailable.
+
+const GLenum PS_GL_SHADER_STORAGE_BUFFER = 0x90D2;
+const GLenum PS_GL_SHADER_STORAGE_BLOCK = 0x92E6;
+const GLbitfield PS_GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT = 0x00000001;
+const GLbitfield PS_GL_ELEMENT_ARRAY_BARRIER_BIT = 0x00000002;
+const GLbitfield PS_GL_TEXTURE_FETCH_BARRIER_BIT = 0x00000008;
+const GLbitfield PS_GL_BUFFER_UPDATE_BARRIER_BIT = 0x00000200;
+const GLbitfield PS_GL_SHADER_STORAGE_BARRIER_BIT = 0x00002000;
+const GLbitfield PS_GL_ALL_BARRIER_BITS = 0xFFFFFFFF;
+
+typedef void(POLYSCOPE_GL_APIENTRY* DispatchComputeFunc)(GLuint, GLuint, GLuint);
+typedef void(POLYSCOPE_GL_APIENTRY* MemoryBarrierFunc)(GLbitfield);
+typedef GLuint(POLYSCOPE_GL_APIENTRY* GetProgramResourceIndexFunc)(GLuint, GLenum, const GLchar*);
+typedef void(POLYSCOPE_GL_APIENTRY* ShaderStorageBlockBindingFunc)(GLuint, GLuint, GLuint);
+
+DispatchComputeFunc psDispatchCompute = nullptr;
+MemoryBarrierFunc psMemoryBarrier = nullptr;
+GetProgramResourceIndexFunc psGetProgramResourceIndex = nullptr;
+ShaderStorageBlockBindingFunc psShaderStorageBlockBinding = nullptr;
+bool computeShadersSupported = false;
+
+void loadComputeFunctions() {
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (!(major > 4 || (major == 4 && minor >= 3))) return;
+
+  psDispatchCompute = reinterpret_cast<DispatchComputeFunc>(getGLProcAddress("glDispatchCompute"));
+  psMemoryBarrier = reinterpret_cast<MemoryBarrierFunc>(getGLProcAddress("glMemoryBarrier"));
+  psGetProgramResourceIndex =
+      reinterpret_cast<GetProgramResourceIndexFunc>(getGLProcAddress("glGetProgramResourceIndex"));
+  psShaderStorageBlockBinding =
+      reinterpret_cast<ShaderStorageBlockBindingFunc>(getGLProcAddress("glShaderStorageBlockBinding"));
+  computeShadersSupported =
+      psDispatchCompute && psMemoryBarrier && psGetProgramResourceIndex && psShaderStorageBlockBinding;
+}
+
+GLbitfield nativeBarrierBits(MemoryBarrierType type) {
+  switch (type) {
+  case MemoryBarrierType::StorageBuffer:
+    return PS_GL_SHADER_STORAGE_BARRIER_BIT;
+  case MemoryBarrierType::VertexAttribute:
+    return PS_GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+  case MemoryBarrierType::Index:
+    return PS_GL_ELEMENT_ARRAY_BARRIER_BIT;
+  case MemoryBarrierType::Texture:
+    return PS_GL_TEXTURE_FETCH_BARRIER_BIT;
+  case MemoryBarrierType::HostRead:
+    return PS_GL_BUFFER_UPDATE_BARRIER_BIT;
+  case MemoryBarrierType::All:
+    return PS_GL_ALL_BARRIER_BITS;
+  }
+  return PS_GL_ALL_BARRIER_BITS;
+}
+
+// Buffer textures read one component per texel (the three-component formats need GL 4.0, and this keeps the
+// indexing the same for every type)
+GLenum bufferTextureFormat(RenderDataType type) {
+  switch (type) {
+  case RenderDataType::Int:
+    return GL_R32I;
+  case RenderDataType::UInt:
+  case RenderDataType::Index:
+  case RenderDataType::Vector2UInt:
+  case RenderDataType::Vector3UInt:
+  case RenderDataType::Vector4UInt:
+    return GL_R32UI;
+  default:
+    return GL_R32F;
+  }
+}
+
+bool programBinaryCacheEnabled() {
+  return !options::shaderCacheDirectory.empty() && psGetProgramBinary && psProgramBinary && psProgramParameteri;
+}
+
+// 64-bit FNV-1a, which (unlike std::hash) is stable across builds
+uint64_t stableHash(const std::string& str) {
+  uint64_t h = 14695981039346656037ull;
+  for (char c : str) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+std::string programCachePath(const std::string& key) {
+  std::stringstream path;
+  path << options::shaderCacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << stableHash(key)
+       << ".glprog";
+  return path.str();
+}
+
+// An entry holds the magic string, the full key (to guard against hash collisions), the binary format, then the binary
+bool loadProgramBinary(const std::string& key, ProgramHandle& handle) {
+  std::ifstream inFile(programCachePath(key), std::ios::binary);
+  if (!inFile) return false;
+
+  auto readString = [&](std::string& str) {
+    uint64_t len = 0;
+    inFile.read(reinterpret_cast<char*>(&len), sizeof(len));
+    if (!inFile || len > (1ull << 30)) return false;
+    str.resize(len);
+    inFile.read(&str[0], len);
+    return static_cast<bool>(inFile);
+  };
+
+  std::string magic, storedKey, binary;
+  GLenum format;
+  if (!readString(magic) || magic != programCacheMagic) return false;
+  if (!readString(storedKey) || storedKey != key) return false;
+  inFile.read(reinterpret_cast<char*>(&format), sizeof(format));
+  if (!inFile || !readString(binary)) return false;
+
+  handle = glCreateProgram();
+  psProgramBinary(handle, format, binary.data(), static_cast<GLsizei>(binary.size()));
+  GLint status = 0;
+  glGetProgramiv(handle, GL_LINK_STATUS, &status);
+  if (!status) {
+    // e.g. the driver was updated, just compile from scratch
+    glDeleteProgram(handle);
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    return false;
+  }
+  return true;
+}
+
+void saveProgramBinary(const std::string& key, ProgramHandle handle) {
+  GLint binaryLength = 0;
+  glGetProgramiv(handle, PS_GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+  if (binaryLength <= 0) return;
+
+  std::string binary(binaryLength, '\0');
+  GLenum format = 0;
+  GLsizei writtenLength = 0;
+  psGetProgramBinary(handle, binaryLength, &writtenLength, &format, &binary[0]);
+  binary.resize(writtenLength);
+
+  std::ofstream outFile(programCachePath(key), std::ios::binary | std::ios::trunc);
+  if (!outFile) {
+    if (options::verbosity > 2) info("could not write shader cache entry in " + options::shaderCacheDirectory);
+    return;
+  }
+  auto writeString = [&](const std::string& str) {
+    uint64_t len = str.size();
+    outFile.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    outFile.write(str.data(), len);
+  };
+  writeString(programCacheMagic);
+  writeString(key);
+  outFile.write(reinterpret_cast<const char*>(&format), sizeof(format));
+  writeString(binary);
+}
+
+} // namespace
+
 GLCompiledProgram::GLCompiledProgram(const std::vector<ShaderStageSpecification>& stages, DrawMode dm) : drawMode(dm) {
 
   // Collect attributes and uniforms from all of the shaders
@@ -1097,87 +1801,149 @@ GLCompiledProgram::GLCompiledProgram(const std::vector<ShaderStageSpecification>
     for (ShaderSpecTexture t : s.textures) {
       addUniqueTexture(t);
     }
+    for (ShaderSpecStorageBuffer b : s.storageBuffers) {
+      addUniqueStorageBuffer(b);
+    }
   }
 
-  if (attributes.size() == 0) {
+  if (drawMode == DrawMode::Compute) {
+    if (stages.size() != 1 || stages[0].stage != ShaderStageType::Compute) {
+      exception("compute programs must consist of a single compute stage");
+    }
+    if (!computeShadersSupported) {
+      exception("compute programs are not supported by this OpenGL context (requires 4.3), check "
+                "supportsComputeShaders() first");
+    }
+  } else if (attributes.size() == 0) {
     throw std::invalid_argument("Uh oh... GLProgram has no attributes");
+  } else if (!storageBuffers.empty() && !computeShadersSupported) {
+    exception("storage buffers are not supported by this OpenGL context (requires 4.3), check "
+              "supportsComputeShaders() first");
   }
 
-  // Perform setup tasks
+  // Start compiling. This may continue in the background, see finishCompile()
   compileGLProgram(stages);
   checkGLError();
-
-  setDataLocations();
-  checkGLError();
 }
 
-GLCompiledProgram::~GLCompiledProgram() { glDeleteProgram(programHandle); }
+GLCompiledProgram::~GLCompiledProgram() {
+  for (const std::pair<ShaderHandle, std::string>& h : pendingShaders) {
+    glDeleteShader(h.first);
+  }
+  glDeleteProgram(programHandle);
+  if (boundProgramHandle == static_cast<GLint>(programHandle)) invalidateBindingCache();
+}
 
 void GLCompiledProgram::compileGLProgram(const std::vector<ShaderStageSpecification>& stages) {
+  profiling::ScopedTimer timer("shader compile");
 
+  // Load a previously-linked copy, if there is one
+  if (programBinaryCacheEnabled()) {
+    binaryCacheKey = driverIdentifier + "\n" + shaderCommonSource + "\n" + programKeyFromStages(stages, drawMode);
+    if (loadProgramBinary(binaryCacheKey, programHandle)) {
+      binaryCacheKey.clear(); // nothing to save
+      return;
+    }
+  }
 
-  // Compile all of the shaders
-  std::vector<ShaderHandle> handles;
+  // Issue the compiles. Statuses are not checked until finishCompile(), so that drivers which compile in parallel can
+  // work on the program in the background.
   for (const ShaderStageSpecification& s : stages) {
     ShaderHandle h = glCreateShader(native(s.stage));
     std::array<const char*, 2> srcs = {s.src.c_str(), shaderCommonSource};
     glShaderSource(h, 2, &(srcs[0]), nullptr);
     glCompileShader(h);
+    pendingShaders.emplace_back(h, s.src);
+  }
 
-    // Catch the error here, so we can print shader source before re-throwing
-    try {
+  // Create the program and attach the shaders
+  programHandle = glCreateProgram();
+  for (const std::pair<ShaderHandle, std::string>& h : pendingShaders) {
+    glAttachShader(programHandle, h.first);
+  }
 
-      GLint status;
-      glGetShaderiv(h, GL_COMPILE_STATUS, &status);
-      if (!status) {
-        printShaderInfoLog(h);
-        std::cout << "Program text:" << std::endl;
-        std::cout << s.src.c_str() << std::endl;
-        exception("[polyscope] GL shader compile failed");
-      }
+  // Link the program
+  if (!binaryCacheKey.empty()) psProgramParameteri(programHandle, PS_GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glLinkProgram(programHandle);
+}
 
-      if (options::verbosity > 2) {
-        printShaderInfoLog(h);
-      }
+bool GLCompiledProgram::isCompileComplete() {
+  if (compileFinished || pendingShaders.empty()) return true;
+  if (!parallelShaderCompileSupported) return true; // can't ask without blocking, compiling will not wait any longer
 
-      checkGLError();
-    } catch (...) {
-      std::cout << "GLError() after shader compilation! Program text:" << std::endl;
-      std::cout << s.src.c_str() << std::endl;
-      throw;
-    }
+  GLint complete = GL_FALSE;
+  glGetProgramiv(programHandle, PS_GL_COMPLETION_STATUS_KHR, &complete);
+  return complete == GL_TRUE;
+}
 
-    handles.push_back(h);
-  }
+void GLCompiledProgram::finishCompile() {
+  if (compileFinished) return;
+  profiling::ScopedTimer timer("shader link");
 
-  // Create the program and attach the shaders
-  programHandle = glCreateProgram();
-  for (ShaderHandle h : handles) {
-    glAttachShader(programHandle, h);
-  }
+  if (!pendingShaders.empty()) {
 
-  // Link the program
-  glLinkProgram(programHandle);
-  if (options::verbosity > 2) {
-    printProgramInfoLog(programHandle);
-  }
-  GLint status;
-  glGetProgramiv(programHandle, GL_LINK_STATUS, &status);
-  if (!status) {
-    printProgramInfoLog(programHandle);
-    exception("[polyscope] GL program compile failed");
-  }
+    // Check the shaders
+    for (const std::pair<ShaderHandle, std::string>& h : pendingShaders) {
+
+      // Catch the error here, so we can print shader source before re-throwing
+      try {
+
+        GLint status;
+        glGetShaderiv(h.first, GL_COMPILE_STATUS, &status);
+        if (!status) {
+          printShaderInfoLog(h.first);
+          std::cout << "Program text:" << std::endl;
+          std::cout << h.second.c_str() << std::endl;
+          exception("[polyscope] GL shader compile failed");
+        }
 
-  // Delete the shaders we just compiled, they aren't used after link
-  for (ShaderHandle h : handles) {
-    glDeleteShader(h);
+        if (options::verbosity > 2) {
+          printShaderInfoLog(h.first);
+        }
+
+        checkGLError();
+      } catch (...) {
+        std::cout << "GLError() after shader compilation! Program text:" << std::endl;
+        std::cout << h.second.c_str() << std::endl;
+        throw;
+      }
+    }
+
+    // Check the link
+    if (options::verbosity > 2) {
+      printProgramInfoLog(programHandle);
+    }
+    GLint status;
+    glGetProgramiv(programHandle, GL_LINK_STATUS, &status);
+    if (!status) {
+      printProgramInfoLog(programHandle);
+      exception("[polyscope] GL program compile failed");
+    }
+
+    // Delete the shaders we just compiled, they aren't used after link
+    for (const std::pair<ShaderHandle, std::string>& h : pendingShaders) {
+      glDeleteShader(h.first);
+    }
+    pendingShaders.clear();
+
+    if (!binaryCacheKey.empty()) saveProgramBinary(binaryCacheKey, programHandle);
+    binaryCacheKey.clear();
   }
+  checkGLError();
 
+  setDataLocations();
   checkGLError();
+  compileFinished = true;
 }
 
 void GLCompiledProgram::setDataLocations() {
-  glUseProgram(programHandle);
+  useProgram(programHandle);
+
+  // Frame-global uniforms come from the shared block, if the program uses any of them
+  GLuint frameBlockIndex = glGetUniformBlockIndex(programHandle, frameUniformBlockName);
+  if (frameBlockIndex != GL_INVALID_INDEX) {
+    glUniformBlockBinding(programHandle, frameBlockIndex, frameUniformBlockBinding);
+  }
 
   // Uniforms
   for (GLShaderUniform& u : uniforms) {
@@ -1208,6 +1974,22 @@ void GLCompiledProgram::setDataLocations() {
     // exception("failed to get location for texture " + t.name);
   }
 
+  // Storage buffers get a binding point each, in order
+  uint32_t iBinding = 0;
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    b.binding = iBinding++;
+    GLuint blockIndex = GL_INVALID_INDEX;
+    if (computeShadersSupported) {
+      blockIndex = psGetProgramResourceIndex(programHandle, PS_GL_SHADER_STORAGE_BLOCK, b.name.c_str());
+    }
+    b.active = blockIndex != GL_INVALID_INDEX;
+    if (b.active) {
+      psShaderStorageBlockBinding(programHandle, blockIndex, b.binding);
+    } else {
+      info("failed to get index for storage buffer " + b.name);
+    }
+  }
+
   checkGLError();
 }
 
@@ -1222,7 +2004,7 @@ void GLCompiledProgram::addUniqueAttribute(ShaderSpecAttribute newAttribute) {
       return;
     }
   }
-  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount, -1, nullptr});
+  attributes.push_back(GLShaderAttribute{newAttribute.name, newAttribute.type, newAttribute.arrayCount, -1, nullptr, false});
 }
 
 void GLCompiledProgram::addUniqueUniform(ShaderSpecUniform newUniform) {
@@ -1249,14 +2031,29 @@ void GLCompiledProgram::addUniqueTexture(ShaderSpecTexture newTexture) {
       return;
     }
   }
-  textures.push_back(GLShaderTexture{newTexture.name, newTexture.dim, 777, false, nullptr, nullptr, 777});
+  textures.push_back(
+      GLShaderTexture{newTexture.name, newTexture.dim, 777, false, nullptr, nullptr, 777, "", nullptr, 0, 0});
+}
+
+void GLCompiledProgram::addUniqueStorageBuffer(ShaderSpecStorageBuffer newBuffer) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name == newBuffer.name) {
+
+      // if it occurs twice, confirm that the occurences match
+      if (b.type != newBuffer.type)
+        exception("storage buffer " + b.name + " appears twice in program with different types");
+
+      return;
+    }
+  }
+  storageBuffers.push_back(GLShaderStorageBuffer{newBuffer.name, newBuffer.type, 0, false, nullptr});
 }
 
 
 GLShaderProgram::GLShaderProgram(const std::shared_ptr<GLCompiledProgram>& compiledProgram_)
     : ShaderProgram(compiledProgram_->getDrawMode()), uniforms(compiledProgram_->getUniforms()),
       attributes(compiledProgram_->getAttributes()), textures(compiledProgram_->getTextures()),
-      compiledProgram(compiledProgram_) {
+      storageBuffers(compiledProgram_->getStorageBuffers()), compiledProgram(compiledProgram_) {
 
   // Create a VAO
   glGenVertexArrays(1, &vaoHandle);
@@ -1268,9 +2065,14 @@ GLShaderProgram::GLShaderProgram(const std::shared_ptr<GLCompiledProgram>& compi
 
 GLShaderProgram::~GLShaderProgram() {
   // TODO delete the vao and index VBO?
+  for (GLShaderTexture& t : textures) {
+    if (t.bufferTextureHandle == 0) continue;
+    glDeleteTextures(1, &t.bufferTextureHandle);
+    forgetBoundTexture(t.bufferTextureHandle);
+  }
 }
 
-void GLShaderProgram::bindVAO() { glBindVertexArray(vaoHandle); }
+void GLShaderProgram::bindVAO() { bindVertexArray(vaoHandle); }
 
 void GLShaderProgram::createBuffers() {
   bindVAO();
@@ -1344,7 +2146,7 @@ void GLShaderProgram::assignBufferToVAO(GLShaderAttribute& a) {
   a.buff->bind();
   checkGLError();
 
-  // Choose the correct type for the buffer
+  // Choose the correct type for the buffer (integer types are passed through as integers, not converted to float)
   for (int iArrInd = 0; iArrInd < a.arrayCount; iArrInd++) {
 
     glEnableVertexAttribArray(a.location + iArrInd);
@@ -1355,12 +2157,12 @@ void GLShaderProgram::assignBufferToVAO(GLShaderAttribute& a) {
                             reinterpret_cast<void*>(sizeof(float) * 1 * iArrInd));
       break;
     case RenderDataType::Int:
-      glVertexAttribPointer(a.location + iArrInd, 1, GL_INT, GL_FALSE, sizeof(int) * 1 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(int) * 1 * iArrInd));
+      glVertexAttribIPointer(a.location + iArrInd, 1, GL_INT, sizeof(int) * 1 * a.arrayCount,
+                             reinterpret_cast<void*>(sizeof(int) * 1 * iArrInd));
       break;
     case RenderDataType::UInt:
-      glVertexAttribPointer(a.location + iArrInd, 1, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 1 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 1 * iArrInd));
+      glVertexAttribIPointer(a.location + iArrInd, 1, GL_UNSIGNED_INT, sizeof(uint32_t) * 1 * a.arrayCount,
+                             reinterpret_cast<void*>(sizeof(uint32_t) * 1 * iArrInd));
       break;
     case RenderDataType::Vector2Float:
       glVertexAttribPointer(a.location + iArrInd, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2 * a.arrayCount,
@@ -1375,26 +2177,40 @@ void GLShaderProgram::assignBufferToVAO(GLShaderAttribute& a) {
                             reinterpret_cast<void*>(sizeof(float) * 4 * iArrInd));
       break;
     case RenderDataType::Vector2UInt:
-      glVertexAttribPointer(a.location + iArrInd, 2, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 2 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 2 * iArrInd));
+      glVertexAttribIPointer(a.location + iArrInd, 2, GL_UNSIGNED_INT, sizeof(uint32_t) * 2 * a.arrayCount,
+                             reinterpret_cast<void*>(sizeof(uint32_t) * 2 * iArrInd));
       break;
     case RenderDataType::Vector3UInt:
-      glVertexAttribPointer(a.location + iArrInd, 3, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 3 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 3 * iArrInd));
+      glVertexAttribIPointer(a.location + iArrInd, 3, GL_UNSIGNED_INT, sizeof(uint32_t) * 3 * a.arrayCount,
+                             reinterpret_cast<void*>(sizeof(uint32_t) * 3 * iArrInd));
       break;
     case RenderDataType::Vector4UInt:
-      glVertexAttribPointer(a.location + iArrInd, 4, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t) * 4 * a.arrayCount,
-                            reinterpret_cast<void*>(sizeof(uint32_t) * 4 * iArrInd));
+      glVertexAttribIPointer(a.location + iArrInd, 4, GL_UNSIGNED_INT, sizeof(uint32_t) * 4 * a.arrayCount,
+                             reinterpret_cast<void*>(sizeof(uint32_t) * 4 * iArrInd));
       break;
     default:
       throw std::invalid_argument("Unrecognized GLShaderAttribute type");
       break;
     }
+
+    glVertexAttribDivisor(a.location + iArrInd, a.perInstance ? 1 : 0);
   }
 
   checkGLError();
 }
 
+void GLShaderProgram::setAttributePerInstance(std::string name) {
+  for (GLShaderAttribute& a : attributes) {
+    if (a.name == name) {
+      a.perInstance = true;
+      if (a.location != -1 && a.buff) assignBufferToVAO(a);
+      return;
+    }
+  }
+
+  throw std::invalid_argument("Tried to set nonexistent attribute with name " + name);
+}
+
 void GLShaderProgram::createBuffer(GLShaderAttribute& a) {
   if (a.location == -1) return;
 
@@ -1412,6 +2228,7 @@ void GLShaderProgram::createBuffer(GLShaderAttribute& a) {
 void GLShaderProgram::ensureBufferExists(GLShaderAttribute& a) {
   if (a.location != -1 && !a.buff) {
     createBuffer(a);
+    a.buff->setMemoryOwner(memoryOwner);
   }
 }
 
@@ -1424,253 +2241,214 @@ bool GLShaderProgram::hasUniform(std::string name) {
   return false;
 }
 
-// Set an integer
-void GLShaderProgram::setUniform(std::string name, int val) {
-  glUseProgram(compiledProgram->getHandle());
+UniformHandle GLShaderProgram::getUniformHandle(const std::string& name) { return getUniformHandle(name.c_str()); }
 
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Int) {
-        glUniform1i(u.location, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
+UniformHandle GLShaderProgram::getUniformHandle(const char* name) {
+  for (size_t i = 0; i < uniforms.size(); i++) {
+    if (uniforms[i].name == name) {
+      UniformHandle handle;
+      handle.index = static_cast<int32_t>(i);
+      return handle;
     }
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  throw std::invalid_argument("Tried to set nonexistent uniform with name " + std::string(name));
 }
 
-// Set an unsigned integer
-void GLShaderProgram::setUniform(std::string name, unsigned int val) {
-  glUseProgram(compiledProgram->getHandle());
+bool GLShaderProgram::hasUniform(UniformHandle handle) { return getUniform(handle).location != -1; }
 
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::UInt) {
-        glUniform1ui(u.location, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+GLShaderUniform& GLShaderProgram::getUniform(UniformHandle handle) {
+  if (handle.index < 0 || static_cast<size_t>(handle.index) >= uniforms.size()) {
+    throw std::invalid_argument("Tried to set uniform with invalid handle");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+  return uniforms[handle.index];
 }
 
-// Set a float
-void GLShaderProgram::setUniform(std::string name, float val) {
-  glUseProgram(compiledProgram->getHandle());
+// Set an integer
+void GLShaderProgram::setUniform(UniformHandle handle, int val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Int) {
+    glUniform1i(u.location, val);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
+  }
+}
+void GLShaderProgram::setUniform(std::string name, int val) { setUniform(getUniformHandle(name), val); }
 
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Float) {
-        glUniform1f(u.location, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+// Set an unsigned integer
+void GLShaderProgram::setUniform(UniformHandle handle, unsigned int val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::UInt) {
+    glUniform1ui(u.location, val);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, unsigned int val) { setUniform(getUniformHandle(name), val); }
 
-// Set a double --- WARNING casts down to float
-void GLShaderProgram::setUniform(std::string name, double val) {
-  glUseProgram(compiledProgram->getHandle());
+// Set a float
+void GLShaderProgram::setUniform(UniformHandle handle, float val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Float) {
+    glUniform1f(u.location, val);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
+  }
+}
+void GLShaderProgram::setUniform(std::string name, float val) { setUniform(getUniformHandle(name), val); }
 
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Float) {
-        glUniform1f(u.location, static_cast<float>(val));
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+// Set a double --- WARNING casts down to float
+void GLShaderProgram::setUniform(UniformHandle handle, double val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Float) {
+    glUniform1f(u.location, static_cast<float>(val));
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, double val) { setUniform(getUniformHandle(name), val); }
 
 // Set a 4x4 uniform matrix
 // TODO why do we use a pointer here... makes no sense
-void GLShaderProgram::setUniform(std::string name, float* val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Matrix44Float) {
-        glUniformMatrix4fv(u.location, 1, false, val);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, float* val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Matrix44Float) {
+    glUniformMatrix4fv(u.location, 1, false, val);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, float* val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector2 uniform
-void GLShaderProgram::setUniform(std::string name, glm::vec2 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector2Float) {
-        glUniform2f(u.location, val.x, val.y);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec2 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector2Float) {
+    glUniform2f(u.location, val.x, val.y);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::vec2 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector3 uniform
-void GLShaderProgram::setUniform(std::string name, glm::vec3 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector3Float) {
-        glUniform3f(u.location, val.x, val.y, val.z);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec3 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector3Float) {
+    glUniform3f(u.location, val.x, val.y, val.z);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::vec3 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector4 uniform
-void GLShaderProgram::setUniform(std::string name, glm::vec4 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector4Float) {
-        glUniform4f(u.location, val.x, val.y, val.z, val.w);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::vec4 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector4Float) {
+    glUniform4f(u.location, val.x, val.y, val.z, val.w);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::vec4 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a vector3 uniform from a float array
-void GLShaderProgram::setUniform(std::string name, std::array<float, 3> val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector3Float) {
-        glUniform3f(u.location, val[0], val[1], val[2]);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, std::array<float, 3> val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector3Float) {
+    glUniform3f(u.location, val[0], val[1], val[2]);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+}
+void GLShaderProgram::setUniform(std::string name, std::array<float, 3> val) {
+  setUniform(getUniformHandle(name), val);
 }
 
 // Set a vec4 uniform
-void GLShaderProgram::setUniform(std::string name, float x, float y, float z, float w) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector4Float) {
-        glUniform4f(u.location, x, y, z, w);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, float x, float y, float z, float w) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector4Float) {
+    glUniform4f(u.location, x, y, z, w);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
+}
+void GLShaderProgram::setUniform(std::string name, float x, float y, float z, float w) {
+  setUniform(getUniformHandle(name), x, y, z, w);
 }
 
 // Set a uint vector2 uniform
-void GLShaderProgram::setUniform(std::string name, glm::uvec2 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector2UInt) {
-        glUniform2ui(u.location, val.x, val.y);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec2 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector2UInt) {
+    glUniform2ui(u.location, val.x, val.y);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::uvec2 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a uint vector3 uniform
-void GLShaderProgram::setUniform(std::string name, glm::uvec3 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector3UInt) {
-        glUniform3ui(u.location, val.x, val.y, val.z);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec3 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector3UInt) {
+    glUniform3ui(u.location, val.x, val.y, val.z);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::uvec3 val) { setUniform(getUniformHandle(name), val); }
 
 // Set a uint vector4 uniform
-void GLShaderProgram::setUniform(std::string name, glm::uvec4 val) {
-  glUseProgram(compiledProgram->getHandle());
-
-  for (GLShaderUniform& u : uniforms) {
-    if (u.name == name) {
-      if (u.location == -1) return;
-      if (u.type == RenderDataType::Vector4UInt) {
-        glUniform4ui(u.location, val.x, val.y, val.z, val.w);
-        u.isSet = true;
-      } else {
-        throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
-      }
-      return;
-    }
+void GLShaderProgram::setUniform(UniformHandle handle, glm::uvec4 val) {
+  GLShaderUniform& u = getUniform(handle);
+  if (u.location == -1) return;
+  useProgram(compiledProgram->getHandle());
+  if (u.type == RenderDataType::Vector4UInt) {
+    glUniform4ui(u.location, val.x, val.y, val.z, val.w);
+    u.isSet = true;
+  } else {
+    throw std::invalid_argument("Tried to set GLShaderUniform with wrong type");
   }
-  throw std::invalid_argument("Tried to set nonexistent uniform with name " + name);
 }
+void GLShaderProgram::setUniform(std::string name, glm::uvec4 val) { setUniform(getUniformHandle(name), val); }
 
 bool GLShaderProgram::hasAttribute(std::string name) {
   for (GLShaderAttribute& a : attributes) {
@@ -1716,7 +2494,7 @@ void GLShaderProgram::setAttribute(std::string name, const std::vector<glm::vec2
 }
 
 void GLShaderProgram::setAttribute(std::string name, const std::vector<glm::vec3>& data) {
-  glBindVertexArray(vaoHandle); // TODO remove these?
+  bindVertexArray(vaoHandle); // TODO remove these?
 
   // pass-through to the buffer
   for (GLShaderAttribute& a : attributes) {
@@ -1731,7 +2509,7 @@ void GLShaderProgram::setAttribute(std::string name, const std::vector<glm::vec3
 }
 
 void GLShaderProgram::setAttribute(std::string name, const std::vector<glm::vec4>& data) {
-  glBindVertexArray(vaoHandle);
+  bindVertexArray(vaoHandle);
 
   // pass-through to the buffer
   for (GLShaderAttribute& a : attributes) {
@@ -1746,7 +2524,7 @@ void GLShaderProgram::setAttribute(std::string name, const std::vector<glm::vec4
 }
 
 void GLShaderProgram::setAttribute(std::string name, const std::vector<float>& data) {
-  glBindVertexArray(vaoHandle);
+  bindVertexArray(vaoHandle);
 
   // pass-through to the buffer
   for (GLShaderAttribute& a : attributes) {
@@ -1761,7 +2539,7 @@ void GLShaderProgram::setAttribute(std::string name, const std::vector<float>& d
 }
 
 void GLShaderProgram::setAttribute(std::string name, const std::vector<double>& data) {
-  glBindVertexArray(vaoHandle);
+  bindVertexArray(vaoHandle);
 
   // pass-through to the buffer
   for (GLShaderAttribute& a : attributes) {
@@ -1776,7 +2554,7 @@ void GLShaderProgram::setAttribute(std::string name, const std::vector<double>&
 }
 
 void GLShaderProgram::setAttribute(std::string name, const std::vector<int32_t>& data) {
-  glBindVertexArray(vaoHandle);
+  bindVertexArray(vaoHandle);
 
   // pass-through to the buffer
   for (GLShaderAttribute& a : attributes) {
@@ -1791,7 +2569,7 @@ void GLShaderProgram::setAttribute(std::string name, const std::vector<int32_t>&
 }
 
 void GLShaderProgram::setAttribute(std::string name, const std::vector<uint32_t>& data) {
-  glBindVertexArray(vaoHandle);
+  bindVertexArray(vaoHandle);
 
   // pass-through to the buffer
   for (GLShaderAttribute& a : attributes) {
@@ -1841,6 +2619,8 @@ void GLShaderProgram::setTexture1D(std::string name, unsigned char* texData, uns
     // Create a new texture object
     t.textureBufferOwned.reset(new GLTextureBuffer(TextureFormat::RGB8, length, texData));
     t.textureBuffer = t.textureBufferOwned.get();
+    t.attributeBuffer = nullptr;
+    t.textureBufferOwned->setMemoryOwner(memoryOwner);
 
 
     // Set policies
@@ -1875,6 +2655,8 @@ void GLShaderProgram::setTexture2D(std::string name, unsigned char* texData, uns
       t.textureBufferOwned.reset(new GLTextureBuffer(TextureFormat::RGB8, width, height, texData));
     }
     t.textureBuffer = t.textureBufferOwned.get();
+    t.attributeBuffer = nullptr;
+    t.textureBufferOwned->setMemoryOwner(memoryOwner);
 
 
     // Set policies
@@ -1903,7 +2685,7 @@ void GLShaderProgram::setTexture2D(std::string name, unsigned char* texData, uns
 }
 
 void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* textureBuffer) {
-  glUseProgram(compiledProgram->getHandle());
+  useProgram(compiledProgram->getHandle());
 
   // Find the right texture
   for (GLShaderTexture& t : textures) {
@@ -1918,6 +2700,8 @@ void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* text
       throw std::invalid_argument("Bad texture in setTextureFromBuffer()");
     }
 
+    t.colormapName = "";
+    t.attributeBuffer = nullptr;
     t.isSet = true;
     return;
   }
@@ -1925,11 +2709,68 @@ void GLShaderProgram::setTextureFromBuffer(std::string name, TextureBuffer* text
   throw std::invalid_argument("No texture with name " + name);
 }
 
-void GLShaderProgram::setTextureFromColormap(std::string name, const std::string& colormapName, bool allowUpdate) {
-  const ValueColorMap& colormap = render::engine->getColorMap(colormapName);
+void GLShaderProgram::setTextureFromAttributeBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) {
+  for (GLShaderTexture& t : textures) {
+    if (t.name != name || t.location == -1) continue;
 
-  // TODO switch to global shared buffers from colormap
+    if (t.dim != 1) {
+      throw std::invalid_argument("Tried to use texture with mismatched dimension " + std::to_string(t.dim));
+    }
+    if (buffer->getType() == RenderDataType::Matrix44Float) {
+      throw std::invalid_argument("Matrix data cannot be read as a buffer texture");
+    }
+
+    t.attributeBuffer = std::dynamic_pointer_cast<GLAttributeBuffer>(buffer);
+    if (!t.attributeBuffer) {
+      throw std::invalid_argument("Bad buffer in setTextureFromAttributeBuffer()");
+    }
 
+    // The texture is created and attached when the program is next used, since the buffer may not be allocated yet
+    if (t.bufferTextureHandle == 0) glGenTextures(1, &t.bufferTextureHandle);
+    t.bufferTextureSource = 0;
+    t.textureBuffer = nullptr;
+    t.textureBufferOwned = nullptr;
+    t.colormapName = "";
+    t.isSet = true;
+    return;
+  }
+
+  throw std::invalid_argument("No texture with name " + name);
+}
+
+bool GLShaderProgram::hasStorageBuffer(std::string name) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name == name && b.active) return true;
+  }
+  return false;
+}
+
+bool GLShaderProgram::storageBufferIsSet(std::string name) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name == name && b.active) return b.buff != nullptr;
+  }
+  return false;
+}
+
+void GLShaderProgram::setStorageBuffer(std::string name, std::shared_ptr<AttributeBuffer> buffer) {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (b.name != name) continue;
+
+    if (buffer->getType() != b.type) {
+      throw std::invalid_argument("Tried to set storage buffer " + name + " to incompatible type. Storage buffer " +
+                                  renderDataTypeName(b.type) + " set with buffer of type " +
+                                  renderDataTypeName(buffer->getType()));
+    }
+
+    b.buff = std::dynamic_pointer_cast<GLAttributeBuffer>(buffer);
+    if (!b.buff) throw std::invalid_argument("storage buffer " + name + " engine type cast failed");
+    return;
+  }
+
+  throw std::invalid_argument("No storage buffer with name " + name);
+}
+
+void GLShaderProgram::setTextureFromColormap(std::string name, const std::string& colormapName, bool allowUpdate) {
   // Find the right texture
   for (GLShaderTexture& t : textures) {
     if (t.name != name || t.location == -1) continue;
@@ -1938,25 +2779,18 @@ void GLShaderProgram::setTextureFromColormap(std::string name, const std::string
       throw std::invalid_argument("Attempted to set texture twice");
     }
 
+    // Already holds this colormap; nothing to upload
+    if (t.isSet && t.colormapName == colormapName) return;
+
     if (t.dim != 1) {
       throw std::invalid_argument("Tried to use texture with mismatched dimension " + std::to_string(t.dim));
     }
 
-    // Fill a buffer with the data
-    unsigned int dataLength = colormap.values.size() * 3;
-    std::vector<float> colorBuffer(dataLength);
-    for (unsigned int i = 0; i < colormap.values.size(); i++) {
-      colorBuffer[3 * i + 0] = static_cast<float>(colormap.values[i][0]);
-      colorBuffer[3 * i + 1] = static_cast<float>(colormap.values[i][1]);
-      colorBuffer[3 * i + 2] = static_cast<float>(colormap.values[i][2]);
-    }
-
-    // glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, colormap.values.size(), 0, GL_RGB, GL_FLOAT, &(colorBuffer[0]));
-    t.textureBufferOwned = std::dynamic_pointer_cast<GLTextureBuffer>(
-        engine->generateTextureBuffer(TextureFormat::RGB32F, colormap.values.size(), &(colorBuffer[0])));
-    t.textureBufferOwned->setFilterMode(FilterMode::Linear);
+    // Colormap textures are shared between all programs, so this is only a rebind
+    t.textureBufferOwned = std::dynamic_pointer_cast<GLTextureBuffer>(render::engine->getColorMapTexture(colormapName));
     t.textureBuffer = t.textureBufferOwned.get();
-
+    t.attributeBuffer = nullptr;
+    t.colormapName = colormapName;
 
     t.isSet = true;
     return;
@@ -1987,6 +2821,7 @@ void GLShaderProgram::setIndex(std::vector<std::array<unsigned int, 3>>& indices
 
   delete[] rawData;
   indexSize = 3 * indices.size();
+  indexBuffer.reset();
 }
 
 void GLShaderProgram::setIndex(std::vector<glm::uvec3>& indices) {
@@ -2002,6 +2837,7 @@ void GLShaderProgram::setIndex(std::vector<glm::uvec3>& indices) {
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, 3 * indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
 
   indexSize = 3 * indices.size();
+  indexBuffer.reset();
 }
 
 void GLShaderProgram::setIndex(std::vector<unsigned int>& indices) {
@@ -2027,6 +2863,20 @@ void GLShaderProgram::setIndex(std::vector<unsigned int>& indices) {
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
   indexSize = indices.size();
+  indexBuffer.reset();
+}
+
+void GLShaderProgram::setIndex(std::shared_ptr<AttributeBuffer> indices) {
+  if (!useIndex) {
+    throw std::invalid_argument("Tried to setIndex() when program drawMode does not use indexed "
+                                "drawing");
+  }
+  if (indices->getType() != RenderDataType::UInt || indices->getArrayCount() != 1) {
+    throw std::invalid_argument("Tried to setIndex() with a buffer which does not hold UInt indices");
+  }
+
+  // (the size is read from the buffer when drawing, it may change)
+  indexBuffer = indices;
 }
 
 // Check that uniforms and attributes are all set and of consistent size
@@ -2052,6 +2902,18 @@ void GLShaderProgram::validateData() {
 
     int compatCount = renderDataTypeCountCompatbility(a.type, a.buff->getType());
 
+    if (a.perInstance) {
+      if (!useInstancing) {
+        throw std::invalid_argument("Attribute " + a.name + " is per-instance, but no instance count has been set");
+      }
+      if (a.buff->getDataSize() / (a.arrayCount * compatCount) < static_cast<int64_t>(instanceCount)) {
+        throw std::invalid_argument("Per-instance attribute " + a.name + " has size " +
+                                    std::to_string(a.buff->getDataSize()) + " but there are " +
+                                    std::to_string(instanceCount) + " instances");
+      }
+      continue;
+    }
+
     if (attributeSize == -1) { // first one we've seen
       attributeSize = a.buff->getDataSize() / (a.arrayCount * compatCount);
     } else { // not the first one we've seen
@@ -2062,18 +2924,43 @@ void GLShaderProgram::validateData() {
       }
     }
   }
+  if (vertexCount >= 0) {
+    if (attributeSize != -1 && attributeSize != vertexCount) {
+      throw std::invalid_argument("Attributes have size " + std::to_string(attributeSize) +
+                                  " but the vertex count is " + std::to_string(vertexCount));
+    }
+    attributeSize = vertexCount;
+  }
   drawDataLength = static_cast<unsigned int>(attributeSize);
 
+  if (useInstancing && useDrawRanges) {
+    throw std::invalid_argument("Draw ranges cannot be combined with instanced drawing");
+  }
+
   // Check textures
   for (GLShaderTexture& t : textures) {
     if (t.location == -1) continue;
     if (!t.isSet) {
       throw std::invalid_argument("Texture " + t.name + " has not been set");
     }
+    if (t.attributeBuffer && !t.attributeBuffer->isSet()) {
+      throw std::invalid_argument("Buffer for texture " + t.name + " has not been filled");
+    }
+  }
+
+  // Check storage buffers
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (!b.active) continue;
+    if (!b.buff || !b.buff->isSet()) {
+      throw std::invalid_argument("Storage buffer " + b.name + " has not been set");
+    }
   }
 
   // Check index (if applicable)
   if (useIndex) {
+    if (indexBuffer) {
+      indexSize = indexBuffer->isSet() ? indexBuffer->getDataSize() : -1;
+    }
     if (indexSize == -1) {
       throw std::invalid_argument("Index buffer has not been filled");
     }
@@ -2093,17 +2980,52 @@ void GLShaderProgram::activateTextures() {
   for (GLShaderTexture& t : textures) {
     if (t.location == -1) continue;
 
-    glActiveTexture(GL_TEXTURE0 + t.index);
-    t.textureBuffer->bind();
+    activeTexture(t.index);
+    if (t.attributeBuffer) {
+      bindTexture(GL_TEXTURE_BUFFER, t.bufferTextureHandle);
+      // (re)attach if the buffer has been reallocated under a new handle
+      if (t.bufferTextureSource != t.attributeBuffer->getHandle()) {
+        glTexBuffer(GL_TEXTURE_BUFFER, bufferTextureFormat(t.attributeBuffer->getType()),
+                    t.attributeBuffer->getHandle());
+        t.bufferTextureSource = t.attributeBuffer->getHandle();
+      }
+    } else {
+      t.textureBuffer->bind();
+    }
     glUniform1i(t.location, t.index);
   }
 }
 
+void GLShaderProgram::bindStorageBuffers() {
+  for (GLShaderStorageBuffer& b : storageBuffers) {
+    if (!b.active) continue;
+    glBindBufferBase(PS_GL_SHADER_STORAGE_BUFFER, b.binding, b.buff->getHandle());
+  }
+}
+
+void GLShaderProgram::dispatch(uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) {
+  if (!isCompute()) exception("dispatch() called on a program which draws, use draw()");
+  profiling::ScopedTimer timer(timerName, true);
+  validateData();
+
+  glEngine->uploadFrameUniforms();
+  useProgram(compiledProgram->getHandle());
+  activateTextures();
+  bindStorageBuffers();
+
+  if (groupsX > 0 && groupsY > 0 && groupsZ > 0) psDispatchCompute(groupsX, groupsY, groupsZ);
+
+  checkGLError();
+}
+
 void GLShaderProgram::draw() {
+  if (isCompute()) exception("draw() called on a compute program, use dispatch()");
+  profiling::ScopedTimer timer(timerName, true);
   validateData();
 
-  glUseProgram(compiledProgram->getHandle());
-  glBindVertexArray(vaoHandle);
+  glEngine->uploadFrameUniforms();
+  useProgram(compiledProgram->getHandle());
+  bindVertexArray(vaoHandle);
 
   if (usePrimitiveRestart) {
     glEnable(GL_PRIMITIVE_RESTART);
@@ -2111,42 +3033,76 @@ void GLShaderProgram::draw() {
   }
 
   activateTextures();
+  bindStorageBuffers();
+
+  // Non-indexed draws cover either all of the data, or the ranges set by setDrawRanges()
+  auto drawArrays = [&](GLenum mode) {
+    if (useInstancing) {
+      if (instanceCount > 0) glDrawArraysInstanced(mode, 0, drawDataLength, instanceCount);
+    } else if (!useDrawRanges) {
+      glDrawArrays(mode, 0, drawDataLength);
+    } else if (!drawRangeFirsts.empty()) {
+      glMultiDrawArrays(mode, drawRangeFirsts.data(), drawRangeCounts.data(),
+                        static_cast<GLsizei>(drawRangeFirsts.size()));
+    }
+  };
+
+  // Indexed draws likewise, with the ranges in units of indices
+  auto drawElements = [&](GLenum mode) {
+    if (indexBuffer) {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, std::dynamic_pointer_cast<GLAttributeBuffer>(indexBuffer)->getHandle());
+    } else {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
+    }
+    if (useInstancing) {
+      if (instanceCount > 0) glDrawElementsInstanced(mode, drawDataLength, GL_UNSIGNED_INT, 0, instanceCount);
+    } else if (!useDrawRanges) {
+      glDrawElements(mode, drawDataLength, GL_UNSIGNED_INT, 0);
+    } else if (!drawRangeFirsts.empty()) {
+      std::vector<const GLvoid*> offsets(drawRangeFirsts.size());
+      for (size_t i = 0; i < drawRangeFirsts.size(); i++) {
+        offsets[i] = reinterpret_cast<const GLvoid*>(static_cast<size_t>(drawRangeFirsts[i]) * sizeof(GLuint));
+      }
+      glMultiDrawElements(mode, drawRangeCounts.data(), GL_UNSIGNED_INT, offsets.data(),
+                          static_cast<GLsizei>(drawRangeFirsts.size()));
+    }
+  };
 
   switch (drawMode) {
   case DrawMode::Points:
-    glDrawArrays(GL_POINTS, 0, drawDataLength);
+    drawArrays(GL_POINTS);
     break;
   case DrawMode::Triangles:
-    glDrawArrays(GL_TRIANGLES, 0, drawDataLength);
+    drawArrays(GL_TRIANGLES);
     break;
   case DrawMode::Lines:
-    glDrawArrays(GL_LINES, 0, drawDataLength);
+    drawArrays(GL_LINES);
     break;
   case DrawMode::TrianglesAdjacency:
-    glDrawArrays(GL_TRIANGLES_ADJACENCY, 0, drawDataLength);
+    drawArrays(GL_TRIANGLES_ADJACENCY);
     break;
   case DrawMode::LinesAdjacency:
-    glDrawArrays(GL_LINES_ADJACENCY, 0, drawDataLength);
+    drawArrays(GL_LINES_ADJACENCY);
     break;
   case DrawMode::IndexedLines:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINES, drawDataLength, GL_UNSIGNED_INT, 0);
+    drawElements(GL_LINES);
     break;
   case DrawMode::IndexedLineStrip:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINE_STRIP, drawDataLength, GL_UNSIGNED_INT, 0);
+    drawElements(GL_LINE_STRIP);
     break;
   case DrawMode::IndexedLinesAdjacency:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINES_ADJACENCY, drawDataLength, GL_UNSIGNED_INT, 0);
+    drawElements(GL_LINES_ADJACENCY);
     break;
   case DrawMode::IndexedLineStripAdjacency:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_LINE_STRIP_ADJACENCY, drawDataLength, GL_UNSIGNED_INT, 0);
+    drawElements(GL_LINE_STRIP_ADJACENCY);
     break;
   case DrawMode::IndexedTriangles:
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-    glDrawElements(GL_TRIANGLES, drawDataLength, GL_UNSIGNED_INT, 0);
+    drawElements(GL_TRIANGLES);
+    break;
+  case DrawMode::IndexedPoints:
+    drawElements(GL_POINTS);
+    break;
+  case DrawMode::Compute:
     break;
   }
 
@@ -2157,9 +3113,61 @@ void GLShaderProgram::draw() {
   checkGLError();
 }
 
-GLEngine::GLEngine() {}
+GLEngine::GLEngine(bool headless_) : headless(headless_) {}
 
 void GLEngine::initialize() {
+
+  {
+    profiling::InitPhaseTimer phaseTimer("window and context");
+    if (headless) {
+      initializeEGLContext();
+    } else {
+      initializeGLFWContext();
+    }
+  }
+
+  if (options::verbosity > 0) {
+    std::cout << options::printPrefix << "Backend: " << (headless ? "openGL3_egl" : "openGL3_glfw") << " -- "
+              << "Loaded openGL version: " << glGetString(GL_VERSION) << std::endl;
+  }
+  loadProgramBinaryFunctions();
+  loadParallelShaderCompileFunctions();
+  loadComputeFunctions();
+
+  { // Manually create the screen frame buffer
+    if (headless) {
+      // There is no window, so the display is an ordinary offscreen framebuffer
+      std::shared_ptr<RenderBuffer> screenColor =
+          generateRenderBuffer(RenderBufferType::ColorAlpha, view::bufferWidth, view::bufferHeight);
+      std::shared_ptr<RenderBuffer> screenDepth =
+          generateRenderBuffer(RenderBufferType::Depth, view::bufferWidth, view::bufferHeight);
+      displayBuffer = generateFrameBuffer(view::bufferWidth, view::bufferHeight);
+      displayBuffer->addColorBuffer(screenColor);
+      displayBuffer->addDepthBuffer(screenDepth);
+      displayBuffer->setDrawBuffers();
+      displayBuffer->bind();
+    } else {
+      GLFrameBuffer* glScreenBuffer = new GLFrameBuffer(view::bufferWidth, view::bufferHeight, true);
+      displayBuffer.reset(glScreenBuffer);
+      glScreenBuffer->bind();
+    }
+    glClearColor(1., 1., 1., 0.);
+    // glClearColor(0., 0., 0., 0.);
+    // glClearDepth(1.);
+  }
+
+  // The buffer backing the frame-global uniform block, which stays bound for the life of the context
+  glGenBuffers(1, &frameUniformBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, frameUniformBlockSizeInBytes, nullptr, GL_DYNAMIC_DRAW);
+  glBindBufferBase(GL_UNIFORM_BUFFER, frameUniformBlockBinding, frameUniformBuffer);
+  checkGLError();
+
+  profiling::InitPhaseTimer phaseTimer("default shaders and rules");
+  populateDefaultShadersAndRules();
+}
+
+void GLEngine::initializeGLFWContext() {
   // Small callback function for GLFW errors
   auto error_print_callback = [](int error, const char* description) {
     if (polyscope::options::verbosity > 0) {
@@ -2186,7 +3194,7 @@ void GLEngine::initialize() {
   glfwWindowHint(GLFW_FOCUS_ON_SHOW, GLFW_FALSE);
   mainWindow = glfwCreateWindow(view::windowWidth, view::windowHeight, options::programName.c_str(), NULL, NULL);
   glfwMakeContextCurrent(mainWindow);
-  glfwSwapInterval(1); // Enable vsync
+  applySwapInterval();
   glfwSetWindowPos(mainWindow, view::initWindowPosX, view::initWindowPosY);
 
   // Set initial window size
@@ -2205,26 +3213,97 @@ void GLEngine::initialize() {
     exception(options::printPrefix + "ERROR: Failed to load openGL using GLAD");
   }
 #endif
-  if (options::verbosity > 0) {
-    std::cout << options::printPrefix << "Backend: openGL3_glfw -- "
-              << "Loaded openGL version: " << glGetString(GL_VERSION) << std::endl;
-  }
 
 #ifdef __APPLE__
   // Hack to classify the process as interactive
   glfwPollEvents();
 #endif
+}
 
-  { // Manually create the screen frame buffer
-    GLFrameBuffer* glScreenBuffer = new GLFrameBuffer(view::bufferWidth, view::bufferHeight, true);
-    displayBuffer.reset(glScreenBuffer);
-    glScreenBuffer->bind();
-    glClearColor(1., 1., 1., 0.);
-    // glClearColor(0., 0., 0., 0.);
-    // glClearDepth(1.);
+void GLEngine::initializeEGLContext() {
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+
+  // === Initialize EGL
+  // Prefer enumerating the GPUs directly, which needs no windowing system at all, and fall back on the default display
+  EGLint major, minor;
+  PFNEGLQUERYDEVICESEXTPROC queryDevices =
+      reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (queryDevices && getPlatformDisplay) {
+    const EGLint maxDevices = 16;
+    EGLDeviceEXT devices[maxDevices];
+    EGLint nDevices = 0;
+    if (queryDevices(maxDevices, devices, &nDevices)) {
+      for (EGLint iDev = 0; iDev < nDevices && eglDisplay == EGL_NO_DISPLAY; iDev++) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[iDev], nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor)) eglDisplay = display;
+      }
+    }
+  }
+  if (eglDisplay == EGL_NO_DISPLAY) {
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor)) eglDisplay = display;
+  }
+  if (eglDisplay == EGL_NO_DISPLAY) {
+    exception(options::printPrefix + "ERROR: Failed to initialize EGL");
   }
 
-  populateDefaultShadersAndRules();
+  // Nothing is ever drawn to an EGL surface, but creating a context still needs a config
+  // clang-format off
+  const EGLint configAttribs[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_ALPHA_SIZE, 8,
+    EGL_DEPTH_SIZE, 24,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  // clang-format on
+  EGLConfig config;
+  EGLint nConfigs = 0;
+  if (!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &nConfigs) || nConfigs == 0) {
+    exception(options::printPrefix + "ERROR: Failed to find a suitable EGL config");
+  }
+
+  // OpenGL version things
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    exception(options::printPrefix + "ERROR: EGL does not support the openGL API");
+  }
+  // clang-format off
+  const EGLint contextAttribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+  // clang-format on
+  eglContext = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+  if (eglContext == EGL_NO_CONTEXT) {
+    exception(options::printPrefix + "ERROR: Failed to create an EGL openGL 3.3 context");
+  }
+
+  // Surfaceless: all drawing goes to framebuffer objects
+  if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+    exception(options::printPrefix +
+              "ERROR: Failed to make the EGL context current (surfaceless contexts may not be supported)");
+  }
+
+  // With no window, the buffer is exactly the requested window size
+  view::bufferWidth = view::windowWidth;
+  view::bufferHeight = view::windowHeight;
+
+  // === Initialize openGL
+  // Load openGL functions (using GLAD)
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+    exception(options::printPrefix + "ERROR: Failed to load openGL using GLAD");
+  }
+
+#else
+  exception("Polyscope was not compiled with support for backend: openGL3_egl");
+#endif
 }
 
 
@@ -2233,24 +3312,58 @@ void GLEngine::initializeImGui() {
 
   ImGui::CreateContext(); // must call once at start
 
-  // Set up ImGUI glfw bindings
-  ImGui_ImplGlfw_InitForOpenGL(mainWindow, true);
+  // Set up ImGUI glfw bindings (headless, there is no platform backend, see ImGuiNewFrame())
+  if (!headless) {
+    // Count input events, for getInputEventCount(). These go in first, so that the ImGui bindings chain to them
+    // rather than replacing them.
+    glfwSetMouseButtonCallback(mainWindow, [](GLFWwindow*, int, int, int) { glfwInputEventCount++; });
+    glfwSetScrollCallback(mainWindow, [](GLFWwindow*, double, double) { glfwInputEventCount++; });
+    glfwSetKeyCallback(mainWindow, [](GLFWwindow*, int, int, int, int) { glfwInputEventCount++; });
+    glfwSetCharCallback(mainWindow, [](GLFWwindow*, unsigned int) { glfwInputEventCount++; });
+    glfwSetCursorPosCallback(mainWindow, [](GLFWwindow*, double, double) { glfwInputEventCount++; });
+    glfwSetCursorEnterCallback(mainWindow, [](GLFWwindow*, int) { glfwInputEventCount++; });
+    glfwSetWindowFocusCallback(mainWindow, [](GLFWwindow*, int) { glfwInputEventCount++; });
+    glfwSetFramebufferSizeCallback(mainWindow, [](GLFWwindow*, int, int) { glfwInputEventCount++; });
+
+    ImGui_ImplGlfw_InitForOpenGL(mainWindow, true);
+  }
   const char* glsl_version = "#version 150";
   ImGui_ImplOpenGL3_Init(glsl_version);
 
   configureImGui();
+  invalidateBindingCache(); // (uploading the fonts binds a texture)
 }
 
 void GLEngine::shutdownImGui() {
   // ImGui shutdown things
   ImGui_ImplOpenGL3_Shutdown();
-  ImGui_ImplGlfw_Shutdown();
+  if (!headless) {
+    ImGui_ImplGlfw_Shutdown();
+  }
   ImGui::DestroyContext();
 }
 
 void GLEngine::swapDisplayBuffers() {
   bindDisplay();
+  if (headless) {
+    glFlush(); // nothing to present
+    return;
+  }
+  if (options::swapInterval != appliedSwapInterval) applySwapInterval();
   glfwSwapBuffers(mainWindow);
+
+  // Wait for the frame rather than letting the driver queue frames ahead, each of which lags the input by a refresh
+  if (options::lowLatencyInteraction) glFinish();
+}
+
+void GLEngine::applySwapInterval() {
+  int interval = options::swapInterval;
+  if (interval < 0 && !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+      !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+    interval = -interval; // (no adaptive sync)
+  }
+  glfwSwapInterval(interval);
+  appliedSwapInterval = options::swapInterval;
 }
 
 std::vector<unsigned char> GLEngine::readDisplayBuffer() {
@@ -2274,15 +3387,592 @@ std::vector<unsigned char> GLEngine::readDisplayBuffer() {
 }
 
 
+void GLEngine::addPendingReadback(GLPendingReadback readback) { pendingReadbacks.push_back(readback); }
+
+void GLEngine::uploadFrameUniforms() {
+  if (uploadedFrameUniformsVersion == frameUniformsVersion) return;
+
+  // std140 layout of the block declared by useFrameUniformBlock()
+  std::array<float, frameUniformBlockSizeInBytes / sizeof(float)> data;
+  data.fill(0.);
+  const float* projPtr = glm::value_ptr(frameProjMatrix);
+  const float* invProjPtr = glm::value_ptr(frameInvProjMatrix);
+  for (size_t i = 0; i < 16; i++) {
+    data[i] = projPtr[i];
+    data[16 + i] = invProjPtr[i];
+  }
+  for (size_t i = 0; i < 4; i++) {
+    data[32 + i] = currViewport[i];
+  }
+  data[36] = currViewport[2];
+  data[37] = currViewport[3];
+  for (int i = 0; i < frameSlicePlaneCount; i++) {
+    for (size_t j = 0; j < 4; j++) {
+      data[40 + 4 * i + j] = frameSlicePlaneCenters[i][j];
+      data[40 + 4 * (maxSlicePlanes + i) + j] = frameSlicePlaneNormals[i][j];
+    }
+  }
+  int32_t count = frameSlicePlaneCount;
+  std::memcpy(&data[40 + 8 * maxSlicePlanes], &count, sizeof(count));
+  data[41 + 8 * maxSlicePlanes] = frameImpostorFallbackPixelSize;
+
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, frameUniformBlockSizeInBytes, data.data());
+  checkGLError();
+  uploadedFrameUniformsVersion = frameUniformsVersion;
+}
+
+bool GLEngine::hasPendingReadbacks() { return !pendingReadbacks.empty(); }
+
+namespace {
+// Build a vertex-only program which writes the given outputs with transform feedback (interleaved in to one buffer,
+// unless bufferMode is GL_SEPARATE_ATTRIBS), with the attributes at locations 0, 1, ... Returns 0 on failure, after
+// printing the log.
+GLuint buildTransformFeedbackProgram(const std::string& source, const std::vector<std::string>& attributeNames,
+                                     const std::vector<std::string>& varyingNames,
+                                     GLenum bufferMode = GL_INTERLEAVED_ATTRIBS) {
+  GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+  const char* sourcePtr = source.c_str();
+  glShaderSource(shader, 1, &sourcePtr, nullptr);
+  glCompileShader(shader);
+
+  GLuint program = glCreateProgram();
+  glAttachShader(program, shader);
+  for (size_t i = 0; i < attributeNames.size(); i++) {
+    glBindAttribLocation(program, static_cast<GLuint>(i), attributeNames[i].c_str());
+  }
+  std::vector<const char*> varyingPtrs;
+  for (const std::string& n : varyingNames) varyingPtrs.push_back(n.c_str());
+  glTransformFeedbackVaryings(program, static_cast<GLsizei>(varyingPtrs.size()), varyingPtrs.data(), bufferMode);
+  glLinkProgram(program);
+  glDeleteShader(shader);
+
+  GLint status = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  if (!status) {
+    printProgramInfoLog(program);
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  checkGLError();
+  return program;
+}
+} // namespace
+
+bool GLEngine::supportsAttributeBufferGather() { return !gatherFailed; }
+
+unsigned int GLEngine::getGatherProgram(size_t nWords) {
+  auto it = gatherPrograms.find(nWords);
+  if (it != gatherPrograms.end()) return it->second;
+
+  // Copy each element as nWords raw 32-bit words, so any type (and array count) works the same way. The words are
+  // written out in groups of up to 4, interleaved in to the target buffer by transform feedback.
+  std::string source = "#version 330 core\n"
+                       "in uint a_index;\n"
+                       "uniform usamplerBuffer t_source;\n";
+  std::vector<std::string> varyingNames;
+  std::string body = "  int base = int(a_index) * " + std::to_string(nWords) + ";\n";
+  for (size_t start = 0; start < nWords; start += 4) {
+    size_t count = std::min(nWords - start, static_cast<size_t>(4));
+    std::string type = count == 1 ? "uint" : "uvec" + std::to_string(count);
+    std::string name = "o_words" + std::to_string(start / 4);
+    source += "flat out " + type + " " + name + ";\n";
+    varyingNames.push_back(name);
+
+    body += "  " + name + " = " + type + "(";
+    for (size_t i = 0; i < count; i++) {
+      if (i > 0) body += ", ";
+      body += "texelFetch(t_source, base + " + std::to_string(start + i) + ").r";
+    }
+    body += ");\n";
+  }
+  source += "void main() {\n" + body + "}\n";
+
+  GLuint program = buildTransformFeedbackProgram(source, {"a_index"}, varyingNames);
+  if (program == 0) {
+    gatherFailed = true;
+    return 0;
+  }
+
+  gatherPrograms[nWords] = program;
+  return program;
+}
+
+bool GLEngine::gatherAttributeBuffer(AttributeBuffer& sourceIn, AttributeBuffer& indicesIn, AttributeBuffer& targetIn) {
+  if (gatherFailed) return false;
+
+  GLAttributeBuffer* source = dynamic_cast<GLAttributeBuffer*>(&sourceIn);
+  GLAttributeBuffer* indices = dynamic_cast<GLAttributeBuffer*>(&indicesIn);
+  GLAttributeBuffer* target = dynamic_cast<GLAttributeBuffer*>(&targetIn);
+  if (!source || !indices || !target) exception("tried to gather non-GL buffers");
+  if (source->getType() != target->getType() || source->getArrayCount() != target->getArrayCount()) {
+    exception("gatherAttributeBuffer() source and target must have the same type");
+  }
+  if (renderDataTypeSizeInBytes(indices->getType()) != sizeof(uint32_t) || indices->getArrayCount() != 1) {
+    exception("gatherAttributeBuffer() indices must be uint32 values");
+  }
+  if (!source->isSet() || !indices->isSet()) return false;
+
+  size_t elementBytes = source->getArrayCount() * renderDataTypeSizeInBytes(source->getType());
+  size_t nWords = elementBytes / sizeof(uint32_t);
+  size_t nSourceWords = source->getDataSize() * renderDataTypeSizeInBytes(source->getType()) / sizeof(uint32_t);
+  size_t nOut = indices->getDataSize();
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  if (elementBytes % sizeof(uint32_t) != 0 || nSourceWords > static_cast<size_t>(maxTexels)) return false;
+
+  GLuint program = getGatherProgram(nWords);
+  if (program == 0) return false;
+
+  // Size the target without uploading anything
+  if (target->isSet()) {
+    target->resize(nOut);
+  } else {
+    target->setDataRaw(nullptr, nOut);
+  }
+
+  if (gatherVAO == 0) {
+    glGenVertexArrays(1, &gatherVAO);
+    glGenTextures(1, &gatherSourceTexture);
+  }
+
+  useProgram(program);
+  activeTexture(0);
+  bindTexture(GL_TEXTURE_BUFFER, gatherSourceTexture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, source->getHandle());
+  glUniform1i(glGetUniformLocation(program, "t_source"), 0);
+
+  bindVertexArray(gatherVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, indices->getHandle());
+  glEnableVertexAttribArray(0);
+  glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, 0, nullptr);
+
+  glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, target->getHandle(), 0, nOut * elementBytes);
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(nOut));
+  glEndTransformFeedback();
+  glDisable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  bindTexture(GL_TEXTURE_BUFFER, 0);
+
+  checkGLError();
+  return true;
+}
+
+bool GLEngine::supportsAttributeBufferBlend() { return !blendFailed; }
+
+bool GLEngine::blendAttributeBuffers(AttributeBuffer& aIn, AttributeBuffer& bIn, float t, bool normalize,
+                                     AttributeBuffer& targetIn) {
+  if (blendFailed) return false;
+
+  GLAttributeBuffer* a = dynamic_cast<GLAttributeBuffer*>(&aIn);
+  GLAttributeBuffer* b = dynamic_cast<GLAttributeBuffer*>(&bIn);
+  GLAttributeBuffer* target = dynamic_cast<GLAttributeBuffer*>(&targetIn);
+  if (!a || !b || !target) exception("tried to blend non-GL buffers");
+  for (GLAttributeBuffer* buff : {a, b, target}) {
+    if (buff->getType() != RenderDataType::Vector3Float || buff->getArrayCount() != 1) {
+      exception("blendAttributeBuffers() only supports vec3 buffers");
+    }
+  }
+  if (a->getDataSize() != b->getDataSize()) exception("blendAttributeBuffers() inputs must be the same size");
+  if (!a->isSet()) return false;
+
+  if (blendProgram == 0) {
+    std::string source = "#version 330 core\n"
+                         "in vec3 a_a;\n"
+                         "in vec3 a_b;\n"
+                         "uniform float u_t;\n"
+                         "uniform int u_normalize;\n"
+                         "out vec3 o_value;\n"
+                         "void main() {\n"
+                         "  vec3 v = mix(a_a, a_b, u_t);\n"
+                         "  float len = length(v);\n"
+                         "  if (u_normalize != 0 && len > 0.) v /= len;\n"
+                         "  o_value = v;\n"
+                         "}\n";
+    blendProgram = buildTransformFeedbackProgram(source, {"a_a", "a_b"}, {"o_value"});
+    if (blendProgram == 0) {
+      blendFailed = true;
+      return false;
+    }
+    glGenVertexArrays(1, &blendVAO);
+  }
+
+  // Size the target without uploading anything
+  size_t n = a->getDataSize();
+  if (target->isSet()) {
+    target->resize(n);
+  } else {
+    target->setDataRaw(nullptr, n);
+  }
+
+  useProgram(blendProgram);
+  glUniform1f(glGetUniformLocation(blendProgram, "u_t"), t);
+  glUniform1i(glGetUniformLocation(blendProgram, "u_normalize"), normalize ? 1 : 0);
+
+  bindVertexArray(blendVAO);
+  GLAttributeBuffer* inputs[2] = {a, b};
+  for (GLuint i = 0; i < 2; i++) {
+    glBindBuffer(GL_ARRAY_BUFFER, inputs[i]->getHandle());
+    glEnableVertexAttribArray(i);
+    glVertexAttribPointer(i, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  }
+
+  glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, target->getHandle(), 0, n * sizeof(glm::vec3));
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(n));
+  glEndTransformFeedback();
+  glDisable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+  checkGLError();
+  return true;
+}
+
+bool GLEngine::supportsMeshGeometryCompute() { return !meshGeometryFailed; }
+
+bool GLEngine::computeMeshGeometry(AttributeBuffer& positionsIn, AttributeBuffer& faceIndsStartIn,
+                                   AttributeBuffer& faceIndsEntriesIn, AttributeBuffer& vertexFaceAdjStartIn,
+                                   AttributeBuffer& vertexFaceAdjEntriesIn, AttributeBuffer* faceNormalsIn,
+                                   AttributeBuffer* faceCentersIn, AttributeBuffer* vertexNormalsIn) {
+  if (meshGeometryFailed) return false;
+
+  GLAttributeBuffer* positions = dynamic_cast<GLAttributeBuffer*>(&positionsIn);
+  GLAttributeBuffer* faceIndsStart = dynamic_cast<GLAttributeBuffer*>(&faceIndsStartIn);
+  GLAttributeBuffer* faceIndsEntries = dynamic_cast<GLAttributeBuffer*>(&faceIndsEntriesIn);
+  GLAttributeBuffer* vertexFaceAdjStart = dynamic_cast<GLAttributeBuffer*>(&vertexFaceAdjStartIn);
+  GLAttributeBuffer* vertexFaceAdjEntries = dynamic_cast<GLAttributeBuffer*>(&vertexFaceAdjEntriesIn);
+  if (!positions || !faceIndsStart || !faceIndsEntries || !vertexFaceAdjStart || !vertexFaceAdjEntries) {
+    exception("tried to compute mesh geometry from non-GL buffers");
+  }
+  if (positions->getType() != RenderDataType::Vector3Float || positions->getArrayCount() != 1) {
+    exception("computeMeshGeometry() positions must be a vec3 buffer");
+  }
+  for (GLAttributeBuffer* buff : {faceIndsStart, faceIndsEntries, vertexFaceAdjStart, vertexFaceAdjEntries}) {
+    if (buff->getType() != RenderDataType::UInt || buff->getArrayCount() != 1) {
+      exception("computeMeshGeometry() connectivity must be uint32 buffers");
+    }
+    if (!buff->isSet()) return false;
+  }
+  for (AttributeBuffer* buff : {faceNormalsIn, faceCentersIn, vertexNormalsIn}) {
+    if (buff && (buff->getType() != RenderDataType::Vector3Float || buff->getArrayCount() != 1)) {
+      exception("computeMeshGeometry() outputs must be vec3 buffers");
+    }
+  }
+  if (!positions->isSet()) return false;
+
+  size_t nVertices = positions->getDataSize();
+  size_t nFaces = faceIndsStart->getDataSize() - 1;
+  if (faceIndsStart->getDataSize() == 0 || vertexFaceAdjStart->getDataSize() != nVertices + 1) {
+    exception("computeMeshGeometry() connectivity does not match the positions");
+  }
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  for (size_t nTexels : {3 * nVertices, 3 * nFaces, faceIndsEntries->getDataSize(),
+                         vertexFaceAdjEntries->getDataSize()}) {
+    if (nTexels > static_cast<size_t>(maxTexels)) return false;
+  }
+
+  if (meshFaceGeometryProgram == 0) {
+    // (the same arithmetic as SurfaceMesh::faceNormalOf(), faceCenterOf(), faceAreaOf(), and vertexNormalOf())
+    std::string faceSource = "#version 330 core\n"
+                             "uniform samplerBuffer t_positions;\n"
+                             "uniform usamplerBuffer t_faceStart;\n"
+                             "uniform usamplerBuffer t_faceEntries;\n"
+                             "out vec3 o_normal;\n"
+                             "out vec3 o_center;\n"
+                             "out float o_area;\n"
+                             "vec3 position(int start, int j) {\n"
+                             "  int base = 3 * int(texelFetch(t_faceEntries, start + j).r);\n"
+                             "  return vec3(texelFetch(t_positions, base).r, texelFetch(t_positions, base + 1).r,\n"
+                             "              texelFetch(t_positions, base + 2).r);\n"
+                             "}\n"
+                             "void main() {\n"
+                             "  int start = int(texelFetch(t_faceStart, gl_VertexID).r);\n"
+                             "  int D = int(texelFetch(t_faceStart, gl_VertexID + 1).r) - start;\n"
+                             "  vec3 N = vec3(0.);\n"
+                             "  vec3 C = vec3(0.);\n"
+                             "  float A = 0.;\n"
+                             "  if (D == 3) {\n"
+                             "    vec3 pA = position(start, 0);\n"
+                             "    vec3 pB = position(start, 1);\n"
+                             "    vec3 pC = position(start, 2);\n"
+                             "    N = cross(pB - pA, pC - pA);\n"
+                             "    A = 0.5 * length(N);\n"
+                             "    C = pA + pB + pC;\n"
+                             "  } else {\n"
+                             "    vec3 pRoot = position(start, 0);\n"
+                             "    for (int j = 0; j < D; j++) {\n"
+                             "      vec3 pA = position(start, j);\n"
+                             "      vec3 pB = position(start, (j + 1) % D);\n"
+                             "      vec3 pC = position(start, (j + 2) % D);\n"
+                             "      N += cross(pC - pB, pA - pB);\n"
+                             "      C += pA;\n"
+                             "      if (j >= 1 && j + 1 < D) A += 0.5 * length(cross(pA - pRoot, pB - pRoot));\n"
+                             "    }\n"
+                             "  }\n"
+                             "  o_normal = normalize(N);\n"
+                             "  o_center = C / float(D);\n"
+                             "  o_area = A;\n"
+                             "}\n";
+    std::string vertexSource = "#version 330 core\n"
+                               "uniform usamplerBuffer t_adjStart;\n"
+                               "uniform usamplerBuffer t_adjEntries;\n"
+                               "uniform samplerBuffer t_faceNormals;\n"
+                               "uniform samplerBuffer t_faceAreas;\n"
+                               "out vec3 o_normal;\n"
+                               "void main() {\n"
+                               "  int start = int(texelFetch(t_adjStart, gl_VertexID).r);\n"
+                               "  int end = int(texelFetch(t_adjStart, gl_VertexID + 1).r);\n"
+                               "  vec3 N = vec3(0.);\n"
+                               "  for (int i = start; i < end; i++) {\n"
+                               "    int iF = int(texelFetch(t_adjEntries, i).r);\n"
+                               "    vec3 fN = vec3(texelFetch(t_faceNormals, 3 * iF).r,\n"
+                               "                   texelFetch(t_faceNormals, 3 * iF + 1).r,\n"
+                               "                   texelFetch(t_faceNormals, 3 * iF + 2).r);\n"
+                               "    N += fN * texelFetch(t_faceAreas, iF).r;\n"
+                               "  }\n"
+                               "  o_normal = normalize(N);\n"
+                               "}\n";
+    meshFaceGeometryProgram =
+        buildTransformFeedbackProgram(faceSource, {}, {"o_normal", "o_center", "o_area"}, GL_SEPARATE_ATTRIBS);
+    meshVertexNormalProgram = buildTransformFeedbackProgram(vertexSource, {}, {"o_normal"});
+    if (meshFaceGeometryProgram == 0 || meshVertexNormalProgram == 0) {
+      meshGeometryFailed = true;
+      return false;
+    }
+    glGenVertexArrays(1, &meshGeometryVAO);
+    glGenTextures(4, meshGeometryTextures.data());
+    meshGeometryScratchNormals = generateAttributeBuffer(RenderDataType::Vector3Float, 1);
+    meshGeometryScratchCenters = generateAttributeBuffer(RenderDataType::Vector3Float, 1);
+    meshGeometryAreas = generateAttributeBuffer(RenderDataType::Float, 1);
+    meshGeometryScratchNormals->setMemoryOwner("engine");
+    meshGeometryScratchCenters->setMemoryOwner("engine");
+    meshGeometryAreas->setMemoryOwner("engine");
+  }
+
+  // Size the outputs without uploading anything
+  auto sizeOutput = [&](AttributeBuffer& buff, size_t n) -> GLAttributeBuffer& {
+    if (buff.isSet()) {
+      buff.resize(n);
+    } else {
+      buff.setDataRaw(nullptr, n);
+    }
+    return dynamic_cast<GLAttributeBuffer&>(buff);
+  };
+  GLAttributeBuffer& faceNormals = sizeOutput(faceNormalsIn ? *faceNormalsIn : *meshGeometryScratchNormals, nFaces);
+  GLAttributeBuffer& faceCenters = sizeOutput(faceCentersIn ? *faceCentersIn : *meshGeometryScratchCenters, nFaces);
+  GLAttributeBuffer& faceAreas = sizeOutput(*meshGeometryAreas, nFaces);
+
+  auto bindSource = [&](GLuint program, int unit, const char* name, GLenum format, GLAttributeBuffer& buff) {
+    activeTexture(unit);
+    bindTexture(GL_TEXTURE_BUFFER, meshGeometryTextures[unit]);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buff.getHandle());
+    glUniform1i(glGetUniformLocation(program, name), unit);
+  };
+  auto runFeedback = [&](size_t n) {
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(n));
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+  };
+  bindVertexArray(meshGeometryVAO);
+
+  // The faces
+  useProgram(meshFaceGeometryProgram);
+  bindSource(meshFaceGeometryProgram, 0, "t_positions", GL_R32F, *positions);
+  bindSource(meshFaceGeometryProgram, 1, "t_faceStart", GL_R32UI, *faceIndsStart);
+  bindSource(meshFaceGeometryProgram, 2, "t_faceEntries", GL_R32UI, *faceIndsEntries);
+  glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, faceNormals.getHandle(), 0, nFaces * sizeof(glm::vec3));
+  glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 1, faceCenters.getHandle(), 0, nFaces * sizeof(glm::vec3));
+  glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 2, faceAreas.getHandle(), 0, nFaces * sizeof(float));
+  runFeedback(nFaces);
+  for (GLuint i = 0; i < 3; i++) glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, 0);
+
+  // The vertices, from the face values
+  if (vertexNormalsIn) {
+    GLAttributeBuffer& vertexNormals = sizeOutput(*vertexNormalsIn, nVertices);
+    useProgram(meshVertexNormalProgram);
+    bindSource(meshVertexNormalProgram, 0, "t_adjStart", GL_R32UI, *vertexFaceAdjStart);
+    bindSource(meshVertexNormalProgram, 1, "t_adjEntries", GL_R32UI, *vertexFaceAdjEntries);
+    bindSource(meshVertexNormalProgram, 2, "t_faceNormals", GL_R32F, faceNormals);
+    bindSource(meshVertexNormalProgram, 3, "t_faceAreas", GL_R32F, faceAreas);
+    glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, vertexNormals.getHandle(), 0, nVertices * sizeof(glm::vec3));
+    runFeedback(nVertices);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  }
+
+  for (int unit = 3; unit >= 0; unit--) {
+    activeTexture(unit);
+    bindTexture(GL_TEXTURE_BUFFER, 0);
+  }
+
+  checkGLError();
+  return true;
+}
+
+void GLEngine::processPendingReadbacks(bool blockUntilDone) {
+  if (pendingReadbacks.empty()) return;
+
+  // Take the list, since delivery callbacks might issue new reads
+  std::vector<GLPendingReadback> toProcess;
+  toProcess.swap(pendingReadbacks);
+
+  std::vector<GLPendingReadback> stillPending;
+  for (GLPendingReadback& r : toProcess) {
+
+    GLbitfield waitFlags = blockUntilDone ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+    GLuint64 timeout = blockUntilDone ? GL_TIMEOUT_IGNORED : 0;
+    GLenum waitResult = glClientWaitSync(r.fence, waitFlags, timeout);
+    if (waitResult != GL_ALREADY_SIGNALED && waitResult != GL_CONDITION_SATISFIED) {
+      stillPending.push_back(r);
+      continue;
+    }
+
+    // The data is ready, map it and hand it off
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pboHandle);
+    void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, r.nBytes, GL_MAP_READ_BIT);
+    if (data != nullptr) {
+      r.deliver(data);
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glDeleteSync(r.fence);
+    glDeleteBuffers(1, &r.pboHandle);
+  }
+
+  // Anything which is not yet finished (or was issued by a callback) stays queued
+  stillPending.insert(stillPending.end(), pendingReadbacks.begin(), pendingReadbacks.end());
+  pendingReadbacks.swap(stillPending);
+  checkGLError();
+}
+
+unsigned int GLEngine::getTimerQuery() {
+  if (freeTimerQueries.empty()) {
+    GLuint q;
+    glGenQueries(1, &q);
+    return q;
+  }
+  unsigned int q = freeTimerQueries.back();
+  freeTimerQueries.pop_back();
+  return q;
+}
+
+void GLEngine::beginGPUTimer(size_t timerID, uint64_t frame) {
+  GLGPUTimer timer{timerID, frame, getTimerQuery(), getTimerQuery()};
+  glQueryCounter(timer.startQuery, GL_TIMESTAMP);
+  openGPUTimers.push_back(timer);
+}
+
+void GLEngine::endGPUTimer() {
+  if (openGPUTimers.empty()) return;
+  GLGPUTimer timer = openGPUTimers.back();
+  openGPUTimers.pop_back();
+  glQueryCounter(timer.endQuery, GL_TIMESTAMP);
+  pendingGPUTimers.push_back(timer);
+}
+
+uint64_t GLEngine::collectGPUTimers(std::vector<GPUTimerResult>& results) {
+
+  // Queries finish in the order they were issued, so stop at the first one which is not available yet
+  while (!pendingGPUTimers.empty()) {
+    GLGPUTimer& timer = pendingGPUTimers.front();
+    GLint available = 0;
+    glGetQueryObjectiv(timer.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) break;
+
+    GLuint64 startTime, endTime;
+    glGetQueryObjectui64v(timer.startQuery, GL_QUERY_RESULT, &startTime);
+    glGetQueryObjectui64v(timer.endQuery, GL_QUERY_RESULT, &endTime);
+    results.push_back({timer.timerID, timer.frame, static_cast<double>(endTime - startTime) * 1e-6});
+
+    freeTimerQueries.push_back(timer.startQuery);
+    freeTimerQueries.push_back(timer.endQuery);
+    pendingGPUTimers.pop_front();
+  }
+  checkGLError();
+
+  uint64_t oldestFrame = std::numeric_limits<uint64_t>::max();
+  if (!pendingGPUTimers.empty()) oldestFrame = pendingGPUTimers.front().frame;
+  for (const GLGPUTimer& timer : openGPUTimers) oldestFrame = std::min(oldestFrame, timer.frame);
+  return oldestFrame;
+}
+
+bool GLEngine::supportsOcclusionQueries() { return true; }
+
+bool GLEngine::supportsComputeShaders() { return computeShadersSupported; }
+
+void GLEngine::memoryBarrier(MemoryBarrierType type) {
+  if (!computeShadersSupported) return;
+  psMemoryBarrier(nativeBarrierBits(type));
+  checkGLError();
+}
+
+void GLEngine::beginOcclusionQuery(size_t queryID) {
+  while (occlusionQueries.size() <= queryID) {
+    GLuint q;
+    glGenQueries(1, &q);
+    occlusionQueries.push_back(q);
+  }
+  glBeginQuery(GL_ANY_SAMPLES_PASSED, occlusionQueries[queryID]);
+}
+
+void GLEngine::endOcclusionQuery() { glEndQuery(GL_ANY_SAMPLES_PASSED); }
+
+bool GLEngine::getOcclusionQueryResult(size_t queryID, bool& anySamplesPassed) {
+  if (queryID >= occlusionQueries.size()) return false;
+  GLint available = 0;
+  glGetQueryObjectiv(occlusionQueries[queryID], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) return false;
+  GLuint result = 0;
+  glGetQueryObjectuiv(occlusionQueries[queryID], GL_QUERY_RESULT, &result);
+  anySamplesPassed = result != 0;
+  return true;
+}
+
 void GLEngine::checkError(bool fatal) { checkGLError(fatal); }
 
-void GLEngine::makeContextCurrent() { glfwMakeContextCurrent(mainWindow); }
+void GLEngine::makeContextCurrent() {
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+  if (headless) {
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext);
+    invalidateBindingCache();
+    return;
+  }
+#endif
+  glfwMakeContextCurrent(mainWindow);
+  invalidateBindingCache();
+}
 
-void GLEngine::focusWindow() { glfwFocusWindow(mainWindow); }
+void GLEngine::releaseContext() {
+#ifdef POLYSCOPE_BACKEND_OPENGL3_EGL_ENABLED
+  if (headless) {
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return;
+  }
+#endif
+  glfwMakeContextCurrent(nullptr);
+}
 
-void GLEngine::showWindow() { glfwShowWindow(mainWindow); }
+// When headless, the window functions below act on an imaginary window of size view::windowWidth x windowHeight
+
+void GLEngine::focusWindow() {
+  if (headless) return;
+  glfwFocusWindow(mainWindow);
+}
+
+void GLEngine::showWindow() {
+  if (headless) return;
+  glfwShowWindow(mainWindow);
+}
 
 void GLEngine::hideWindow() {
+  if (headless) return;
   glfwHideWindow(mainWindow);
   glfwPollEvents(); // this shouldn't be necessary, but seems to be needed at least on macOS. Perhaps realted to a
                     // glfw bug? e.g. https://github.com/glfw/glfw/issues/1300 and related bugs
@@ -2290,8 +3980,13 @@ void GLEngine::hideWindow() {
 
 void GLEngine::updateWindowSize(bool force) {
   int newBufferWidth, newBufferHeight, newWindowWidth, newWindowHeight;
-  glfwGetFramebufferSize(mainWindow, &newBufferWidth, &newBufferHeight);
-  glfwGetWindowSize(mainWindow, &newWindowWidth, &newWindowHeight);
+  if (headless) {
+    newBufferWidth = newWindowWidth = view::windowWidth;
+    newBufferHeight = newWindowHeight = view::windowHeight;
+  } else {
+    glfwGetFramebufferSize(mainWindow, &newBufferWidth, &newBufferHeight);
+    glfwGetWindowSize(mainWindow, &newWindowWidth, &newWindowHeight);
+  }
   if (force || newBufferWidth != view::bufferWidth || newBufferHeight != view::bufferHeight ||
       newWindowHeight != view::windowHeight || newWindowWidth != view::windowWidth) {
     // Basically a resize callback
@@ -2313,24 +4008,33 @@ void GLEngine::updateWindowSize(bool force) {
 
 
 void GLEngine::applyWindowSize() {
-  glfwSetWindowSize(mainWindow, view::windowWidth, view::windowHeight);
+  if (!headless) {
+    glfwSetWindowSize(mainWindow, view::windowWidth, view::windowHeight);
+  }
   updateWindowSize(true);
 }
 
 
 void GLEngine::setWindowResizable(bool newVal) {
+  if (headless) return;
   glfwSetWindowAttrib(mainWindow, GLFW_RESIZABLE, newVal ? GLFW_TRUE : GLFW_FALSE);
 }
 
-bool GLEngine::getWindowResizable() { return glfwGetWindowAttrib(mainWindow, GLFW_RESIZABLE); }
+bool GLEngine::getWindowResizable() {
+  if (headless) return false;
+  return glfwGetWindowAttrib(mainWindow, GLFW_RESIZABLE);
+}
 
 std::tuple<int, int> GLEngine::getWindowPos() {
-  int x, y;
-  glfwGetWindowPos(mainWindow, &x, &y);
+  int x = 0, y = 0;
+  if (!headless) {
+    glfwGetWindowPos(mainWindow, &x, &y);
+  }
   return std::tuple<int, int>{x, y};
 }
 
 bool GLEngine::windowRequestsClose() {
+  if (headless) return false;
   bool shouldClose = glfwWindowShouldClose(mainWindow);
   if (shouldClose) {
     glfwSetWindowShouldClose(mainWindow, false); // un-set the state bit so we can close again
@@ -2339,9 +4043,36 @@ bool GLEngine::windowRequestsClose() {
   return false;
 }
 
-void GLEngine::pollEvents() { glfwPollEvents(); }
+void GLEngine::pollEvents() {
+  if (headless) return;
+  glfwPollEvents();
+}
+
+bool GLEngine::waitEvents(double timeoutSeconds) {
+  if (headless) return Engine::waitEvents(timeoutSeconds);
+  // GLFW does not say whether anything arrived, so take a wait which ran to the timeout as having seen nothing
+  auto start = std::chrono::steady_clock::now();
+  glfwWaitEventsTimeout(timeoutSeconds);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < timeoutSeconds;
+}
+
+void GLEngine::wakeEventWait() {
+  if (headless) return;
+  glfwPostEmptyEvent();
+}
+
+uint64_t GLEngine::getInputEventCount() { return glfwInputEventCount; }
+
+bool GLEngine::sampleCursorPosition(glm::vec2& pos) {
+  if (headless) return false;
+  double x, y;
+  glfwGetCursorPos(mainWindow, &x, &y);
+  pos = glm::vec2{x, y};
+  return true;
+}
 
 bool GLEngine::isKeyPressed(char c) {
+  if (headless) return false;
   if (c >= '0' && c <= '9') return ImGui::IsKeyPressed(GLFW_KEY_0 + (c - '0'));
   if (c >= 'a' && c <= 'z') return ImGui::IsKeyPressed(GLFW_KEY_A + (c - 'a'));
   exception("keyPressed only supports 0-9, a-z");
@@ -2350,7 +4081,16 @@ bool GLEngine::isKeyPressed(char c) {
 
 void GLEngine::ImGuiNewFrame() {
   ImGui_ImplOpenGL3_NewFrame();
-  ImGui_ImplGlfw_NewFrame();
+  invalidateBindingCache();
+  if (headless) {
+    // fill in what the platform backend would
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(view::windowWidth, view::windowHeight);
+    io.DisplayFramebufferScale = ImVec2(1., 1.);
+    io.DeltaTime = 1.f / 60.f;
+  } else {
+    ImGui_ImplGlfw_NewFrame();
+  }
   ImGui::NewFrame();
 
   // ImGui::ShowDemoWindow();
@@ -2359,9 +4099,21 @@ void GLEngine::ImGuiNewFrame() {
 void GLEngine::ImGuiRender() {
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  invalidateBindingCache();
+}
+
+void GLEngine::ImGuiRenderLast() {
+  // (the draw data of the last ImGui::Render() stays valid until the next frame begins)
+  ImDrawData* drawData = ImGui::GetDrawData();
+  if (drawData == nullptr) return;
+  ImGui_ImplOpenGL3_RenderDrawData(drawData);
+  invalidateBindingCache();
 }
 
 void GLEngine::setDepthMode(DepthMode newMode) {
+  if (currDepthMode == static_cast<int>(newMode)) return;
+  currDepthMode = static_cast<int>(newMode);
+
   switch (newMode) {
   case DepthMode::Less:
     glEnable(GL_DEPTH_TEST);
@@ -2396,6 +4148,10 @@ void GLEngine::setDepthMode(DepthMode newMode) {
 }
 
 void GLEngine::setBlendMode(BlendMode newMode) {
+  int blendState = 2 * static_cast<int>(newMode) + (gBufferPassActive ? 1 : 0);
+  if (currBlendMode == blendState) return;
+  currBlendMode = blendState;
+
   switch (newMode) {
   case BlendMode::Over:
     glEnable(GL_BLEND);
@@ -2430,11 +4186,22 @@ void GLEngine::setBlendMode(BlendMode newMode) {
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // doesn't actually matter
     break;
   }
+
+  // The normal & material target of the G-buffer must never be blended
+  if (gBufferPassActive) glDisablei(GL_BLEND, 1);
 }
 
-void GLEngine::setColorMask(std::array<bool, 4> mask) { glColorMask(mask[0], mask[1], mask[2], mask[3]); }
+void GLEngine::setColorMask(std::array<bool, 4> mask) {
+  int maskBits = (mask[0] ? 1 : 0) | (mask[1] ? 2 : 0) | (mask[2] ? 4 : 0) | (mask[3] ? 8 : 0);
+  if (currColorMask == maskBits) return;
+  currColorMask = maskBits;
+  glColorMask(mask[0], mask[1], mask[2], mask[3]);
+}
 
 void GLEngine::setBackfaceCull(bool newVal) {
+  if (currBackfaceCull == static_cast<int>(newVal)) return;
+  currBackfaceCull = static_cast<int>(newVal);
+
   if (newVal) {
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
@@ -2468,6 +4235,17 @@ void GLEngine::applyTransparencySettings() {
     setDepthMode();
     break;
   }
+  case TransparencyMode::WeightedBlended: {
+    setBlendMode(BlendMode::WeightedAdd);
+    setDepthMode(DepthMode::Disable);
+    break;
+  }
+  case TransparencyMode::Sorted: {
+    // (the transparent structures are drawn with a read-only depth test, see drawStructures())
+    setBlendMode(BlendMode::AlphaOver);
+    setDepthMode();
+    break;
+  }
   }
 }
 
@@ -2510,6 +4288,12 @@ std::shared_ptr<TextureBuffer> GLEngine::generateTextureBuffer(TextureFormat for
   GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, data);
   return std::shared_ptr<TextureBuffer>(newT);
 }
+std::shared_ptr<TextureBuffer> GLEngine::generateTextureBuffer(TextureFormat format, unsigned int sizeX_,
+                                                               unsigned int sizeY_, unsigned int sizeZ_,
+                                                               const float* data) {
+  GLTextureBuffer* newT = new GLTextureBuffer(format, sizeX_, sizeY_, sizeZ_, data);
+  return std::shared_ptr<TextureBuffer>(newT);
+}
 
 std::shared_ptr<RenderBuffer> GLEngine::generateRenderBuffer(RenderBufferType type, unsigned int sizeX_,
                                                              unsigned int sizeY_) {
@@ -2550,6 +4334,10 @@ std::string GLEngine::programKeyFromRules(const std::string& programName, const
     for (const std::string& s : defaultRules_process) builder << s << "# ";
     break;
   }
+  case ShaderReplacementDefaults::Compute: {
+    for (const std::string& s : defaultRules_compute) builder << s << "# ";
+    break;
+  }
   case ShaderReplacementDefaults::None: {
     break;
   }
@@ -2595,6 +4383,10 @@ std::shared_ptr<GLCompiledProgram> GLEngine::getCompiledProgram(const std::strin
       fullCustomRules.insert(fullCustomRules.begin(), defaultRules_process.begin(), defaultRules_process.end());
       break;
     }
+    case ShaderReplacementDefaults::Compute: {
+      fullCustomRules.insert(fullCustomRules.begin(), defaultRules_compute.begin(), defaultRules_compute.end());
+      break;
+    }
     case ShaderReplacementDefaults::None: {
       break;
     }
@@ -2617,11 +4409,17 @@ std::shared_ptr<GLCompiledProgram> GLEngine::getCompiledProgram(const std::strin
       rules.push_back(thisRule);
     }
 
-    // Actually apply rule substitutions
-    std::vector<ShaderStageSpecification> updatedStages = applyShaderReplacements(stages, rules);
+    // Actually apply rule substitutions, and move the frame-global uniforms to the shared block
+    std::vector<ShaderStageSpecification> updatedStages = useFrameUniformBlock(applyShaderReplacements(stages, rules));
 
-    // Create a new compiled program (GL work happens in the constructor)
-    compiledProgamCache[progKey] = std::shared_ptr<GLCompiledProgram>(new GLCompiledProgram(updatedStages, dm));
+    // Reuse an identical program if one has been compiled, otherwise create a new compiled program (GL work happens in
+    // the constructor)
+    std::string sourceKey = programKeyFromStages(updatedStages, dm);
+    std::shared_ptr<GLCompiledProgram>& compiled = compiledProgramSourceCache[sourceKey];
+    if (!compiled) {
+      compiled = std::shared_ptr<GLCompiledProgram>(new GLCompiledProgram(updatedStages, dm));
+    }
+    compiledProgamCache[progKey] = compiled;
   }
 
   // Now that the cache must contain the compiled program, just return it
@@ -2631,7 +4429,13 @@ std::shared_ptr<GLCompiledProgram> GLEngine::getCompiledProgram(const std::strin
 std::shared_ptr<ShaderProgram> GLEngine::requestShader(const std::string& programName,
                                                        const std::vector<std::string>& customRules,
                                                        ShaderReplacementDefaults defaults) {
-  GLShaderProgram* newP = new GLShaderProgram(getCompiledProgram(programName, customRules, defaults));
+  std::shared_ptr<GLCompiledProgram> compiled = getCompiledProgram(programName, customRules, defaults);
+  if (deferShaderCompiles && !compiled->isCompileComplete()) {
+    throw ShaderProgramNotReady(programName);
+  }
+  compiled->finishCompile();
+  GLShaderProgram* newP = new GLShaderProgram(compiled);
+  newP->timerName = "shader " + programName;
   return std::shared_ptr<ShaderProgram>(newP);
 }
 
@@ -2652,27 +4456,53 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderProgram("MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("SLICE_TETS", {SLICE_TETS_VERT_SHADER, SLICE_TETS_GEOM_SHADER, SLICE_TETS_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("INDEXED_MESH", {FLEX_MESH_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
+  registerShaderProgram("INDEXED_MESH_COMPRESSED", {FLEX_MESH_COMPRESSED_VERT_SHADER, FLEX_MESH_FRAG_SHADER}, DrawMode::IndexedTriangles);
   registerShaderProgram("RAYCAST_SPHERE", {FLEX_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("POINT_QUAD", {FLEX_POINTQUAD_VERT_SHADER, FLEX_POINTQUAD_GEOM_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_SPHERE_INDEXED", {FLEX_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::IndexedPoints);
+  registerShaderProgram("POINT_QUAD_INDEXED", {FLEX_POINTQUAD_VERT_SHADER, FLEX_POINTQUAD_GEOM_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::IndexedPoints);
+  registerShaderProgram("RAYCAST_SPHERE_INSTANCED", {FLEX_SPHERE_INSTANCED_VERT_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("POINT_QUAD_INSTANCED", {FLEX_POINTQUAD_INSTANCED_VERT_SHADER, FLEX_POINTQUAD_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RAYCAST_VECTOR", {FLEX_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
   registerShaderProgram("RAYCAST_TANGENT_VECTOR", {FLEX_TANGENT_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_VECTOR_INDEXED", {FLEX_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::IndexedPoints);
+  registerShaderProgram("RAYCAST_TANGENT_VECTOR_INDEXED", {FLEX_TANGENT_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::IndexedPoints);
   registerShaderProgram("RAYCAST_CYLINDER", {FLEX_CYLINDER_VERT_SHADER, FLEX_CYLINDER_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("RAYCAST_CYLINDER_INDEXED", {FLEX_CYLINDER_INDEXED_VERT_SHADER, FLEX_CYLINDER_INDEXED_GEOM_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::IndexedLines);
+  registerShaderProgram("RAYCAST_CYLINDER_INSTANCED", {FLEX_CYLINDER_INSTANCED_VERT_SHADER, FLEX_CYLINDER_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("HISTOGRAM", {HISTOGRAM_VERT_SHADER, HISTOGRAM_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("HISTOGRAM_BIN", {HISTOGRAM_BIN_VERT_SHADER, HISTOGRAM_BIN_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("DEPTH_SORT_KEYS", {DEPTH_SORT_KEYS_COMPUTE_SHADER}, DrawMode::Compute);
+  registerShaderProgram("RADIX_SORT_COUNT", {RADIX_SORT_COUNT_COMPUTE_SHADER}, DrawMode::Compute);
+  registerShaderProgram("RADIX_SORT_SCAN", {RADIX_SORT_SCAN_COMPUTE_SHADER}, DrawMode::Compute);
+  registerShaderProgram("RADIX_SORT_SCATTER", {RADIX_SORT_SCATTER_COMPUTE_SHADER}, DrawMode::Compute);
   registerShaderProgram("GROUND_PLANE_TILE", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_TILE_REFLECT", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_TILE_REFLECT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("GROUND_PLANE_SHADOW", {GROUND_PLANE_VERT_SHADER, GROUND_PLANE_SHADOW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("MAP_LIGHT", {TEXTURE_DRAW_VERT_SHADER, MAP_LIGHT_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("RIBBON", {RIBBON_VERT_SHADER, RIBBON_GEOM_SHADER, RIBBON_FRAG_SHADER}, DrawMode::IndexedLineStripAdjacency);
+  registerShaderProgram("RIBBON_TUBE", {RIBBON_TUBE_VERT_SHADER, RIBBON_TUBE_GEOM_SHADER, RIBBON_TUBE_FRAG_SHADER}, DrawMode::IndexedLineStripAdjacency);
   registerShaderProgram("SLICE_PLANE", {SLICE_PLANE_VERT_SHADER, SLICE_PLANE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_RAYMARCH_VOLUME", {GRID_RAYMARCH_VERT_SHADER, GRID_RAYMARCH_VOLUME_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_RAYMARCH_ISOSURFACE", {GRID_RAYMARCH_VERT_SHADER, GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("SPARSE_GRID_RAYMARCH_ISOSURFACE", {GRID_RAYMARCH_VERT_SHADER, SPARSE_GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("GRID_NODE_SPHERE", {GRID_NODE_SPHERE_VERT_SHADER, FLEX_SPHERE_GEOM_SHADER, FLEX_SPHERE_FRAG_SHADER}, DrawMode::Points);
+  registerShaderProgram("GRID_NODE_VECTOR", {GRID_NODE_VECTOR_VERT_SHADER, FLEX_VECTOR_GEOM_SHADER, FLEX_VECTOR_FRAG_SHADER}, DrawMode::Points);
 
   registerShaderProgram("TEXTURE_DRAW_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_DOT3", {TEXTURE_DRAW_VERT_SHADER, DOT3_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_MAP3", {TEXTURE_DRAW_VERT_SHADER, MAP3_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_SPHEREBG", {SPHEREBG_DRAW_VERT_SHADER, SPHEREBG_DRAW_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("TEXTURE_DRAW_RENDERIMAGE_PLAIN", {TEXTURE_DRAW_VERT_SHADER, PLAIN_RENDERIMAGE_TEXTURE_DRAW_FRAG_SHADER}, DrawMode::Triangles);
+  registerShaderProgram("IMPLICIT_SURFACE_GLSL", {TEXTURE_DRAW_VERT_SHADER, IMPLICIT_SURFACE_MARCH_FRAG_SHADER}, DrawMode::Triangles);
   registerShaderProgram("COMPOSITE_PEEL", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_PEEL}, DrawMode::Triangles);
+  registerShaderProgram("COMPOSITE_WEIGHTED_BLENDED", {TEXTURE_DRAW_VERT_SHADER, COMPOSITE_WEIGHTED_BLENDED}, DrawMode::Triangles);
+  registerShaderProgram("TEMPORAL_ACCUMULATE", {TEXTURE_DRAW_VERT_SHADER, TEMPORAL_ACCUMULATE}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_COPY", {TEXTURE_DRAW_VERT_SHADER, DEPTH_COPY}, DrawMode::Triangles);
   registerShaderProgram("DEPTH_TO_MASK", {TEXTURE_DRAW_VERT_SHADER, DEPTH_TO_MASK}, DrawMode::Triangles);
+  registerShaderProgram("AMBIENT_OCCLUSION_ESTIMATE", {TEXTURE_DRAW_VERT_SHADER, AMBIENT_OCCLUSION_ESTIMATE}, DrawMode::Triangles);
+  registerShaderProgram("AMBIENT_OCCLUSION_COMPOSITE", {TEXTURE_DRAW_VERT_SHADER, AMBIENT_OCCLUSION_COMPOSITE}, DrawMode::Triangles);
+  registerShaderProgram("DEFERRED_LIGHTING", {TEXTURE_DRAW_VERT_SHADER, DEFERRED_LIGHTING}, DrawMode::Triangles);
   registerShaderProgram("SCALAR_TEXTURE_COLORMAP", {TEXTURE_DRAW_VERT_SHADER, SCALAR_TEXTURE_COLORMAP}, DrawMode::Triangles);
   registerShaderProgram("BLUR_RGB", {TEXTURE_DRAW_VERT_SHADER, BLUR_RGB}, DrawMode::Triangles);
   registerShaderProgram("TRANSFORMATION_GIZMO_ROT", {TRANSFORMATION_GIZMO_ROT_VERT, TRANSFORMATION_GIZMO_ROT_FRAG}, DrawMode::Triangles);
@@ -2681,6 +4511,7 @@ void GLEngine::populateDefaultShadersAndRules() {
 
   // Utility rules
   registerShaderRule("GLSL_VERSION", GLSL_VERSION);
+  registerShaderRule("GLSL_VERSION_COMPUTE", GLSL_VERSION_COMPUTE);
   registerShaderRule("GLOBAL_FRAGMENT_FILTER", GLOBAL_FRAGMENT_FILTER);
   registerShaderRule("DOWNSAMPLE_RESOLVE_1", DOWNSAMPLE_RESOLVE_1);
   registerShaderRule("DOWNSAMPLE_RESOLVE_2", DOWNSAMPLE_RESOLVE_2);
@@ -2690,18 +4521,25 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("TRANSPARENCY_STRUCTURE", TRANSPARENCY_STRUCTURE);
   registerShaderRule("TRANSPARENCY_RESOLVE_SIMPLE", TRANSPARENCY_RESOLVE_SIMPLE);
   registerShaderRule("TRANSPARENCY_PEEL_STRUCTURE", TRANSPARENCY_PEEL_STRUCTURE);
+  registerShaderRule("TRANSPARENCY_WEIGHTED_STRUCTURE", TRANSPARENCY_WEIGHTED_STRUCTURE);
   registerShaderRule("TRANSPARENCY_PEEL_GROUND", TRANSPARENCY_PEEL_GROUND);
   
   registerShaderRule("GENERATE_VIEW_POS", GENERATE_VIEW_POS);
   registerShaderRule("CULL_POS_FROM_VIEW", CULL_POS_FROM_VIEW);
+  registerShaderRule("SLICE_PLANE_CULL", SLICE_PLANE_CULL);
+  registerShaderRule("THRESHOLD_CULL", THRESHOLD_CULL);
+  registerShaderRule("SUBSET_VISIBLE_CULL", SUBSET_VISIBLE_CULL);
+  registerShaderRule("SUBSET_HIGHLIGHT", SUBSET_HIGHLIGHT);
 
   // Lighting and shading things
   registerShaderRule("LIGHT_MATCAP", LIGHT_MATCAP);
+  registerShaderRule("LIGHT_DEFERRED", LIGHT_DEFERRED);
   registerShaderRule("LIGHT_PASSTHRU", LIGHT_PASSTHRU);
   registerShaderRule("SHADE_BASECOLOR", SHADE_BASECOLOR);
   registerShaderRule("SHADE_COLOR", SHADE_COLOR);
   registerShaderRule("SHADE_COLORMAP_VALUE", SHADE_COLORMAP_VALUE);
   registerShaderRule("SHADE_COLORMAP_ANGULAR2", SHADE_COLORMAP_ANGULAR2);
+  registerShaderRule("SHADE_LABEL_TABLE", SHADE_LABEL_TABLE);
   registerShaderRule("SHADE_GRID_VALUE2", SHADE_GRID_VALUE2);
   registerShaderRule("SHADE_CHECKER_VALUE2", SHADE_CHECKER_VALUE2);
   registerShaderRule("SHADEVALUE_MAG_VALUE2", SHADEVALUE_MAG_VALUE2);
@@ -2715,6 +4553,7 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("TEXTURE_SHADE_COLOR", TEXTURE_SHADE_COLOR);
   registerShaderRule("TEXTURE_PROPAGATE_VALUE", TEXTURE_PROPAGATE_VALUE);
   registerShaderRule("TEXTURE_BILLBOARD_FROM_UNIFORMS", TEXTURE_BILLBOARD_FROM_UNIFORMS);
+  registerShaderRule("TEXTURE_RECT_FROM_UNIFORMS", TEXTURE_RECT_FROM_UNIFORMS);
 
   // mesh things
   registerShaderRule("MESH_WIREFRAME", MESH_WIREFRAME);
@@ -2726,19 +4565,57 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("MESH_PROPAGATE_VALUE", MESH_PROPAGATE_VALUE);
   registerShaderRule("MESH_PROPAGATE_VALUE2", MESH_PROPAGATE_VALUE2);
   registerShaderRule("MESH_PROPAGATE_COLOR", MESH_PROPAGATE_COLOR);
+  registerShaderRule("MESH_PROPAGATE_COLOR_PACKED", MESH_PROPAGATE_COLOR_PACKED);
+  registerShaderRule("MESH_FACE_INDEX_FROM_PRIMITIVE_ID", MESH_FACE_INDEX_FROM_PRIMITIVE_ID);
+  registerShaderRule("MESH_FACE_INDEX_FROM_TRIANGLE_MAP", MESH_FACE_INDEX_FROM_TRIANGLE_MAP);
+  registerShaderRule("MESH_FETCH_FACE_VALUE", MESH_FETCH_FACE_VALUE);
+  registerShaderRule("MESH_FETCH_FACE_COLOR", MESH_FETCH_FACE_COLOR);
+  registerShaderRule("MESH_FETCH_FACE_CULLPOS", MESH_FETCH_FACE_CULLPOS);
   registerShaderRule("MESH_PROPAGATE_HALFEDGE_VALUE", MESH_PROPAGATE_HALFEDGE_VALUE);
   registerShaderRule("MESH_PROPAGATE_CULLPOS", MESH_PROPAGATE_CULLPOS);
+  registerShaderRule("MESH_PROPAGATE_SUBSET_INDEX", MESH_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("MESH_PROPAGATE_THRESHOLD", MESH_PROPAGATE_THRESHOLD);
+  registerShaderRule("MESH_PROPAGATE_VECTOR", MESH_PROPAGATE_VECTOR);
+  registerShaderRule("MESH_PROPAGATE_TANGENT_VECTOR", MESH_PROPAGATE_TANGENT_VECTOR);
+  registerShaderRule("MESH_SHADE_LIC", MESH_SHADE_LIC);
   registerShaderRule("MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE", MESH_PROPAGATE_TYPE_AND_BASECOLOR2_SHADE);
   registerShaderRule("MESH_PROPAGATE_PICK", MESH_PROPAGATE_PICK);
   registerShaderRule("MESH_PROPAGATE_PICK_SIMPLE", MESH_PROPAGATE_PICK_SIMPLE);
+  registerShaderRule("MESH_PICK_FROM_INDICES", MESH_PICK_FROM_INDICES);
+  registerShaderRule("MESH_PICK_CORNERS_FROM_INDICES", MESH_PICK_CORNERS_FROM_INDICES);
+  registerShaderRule("MESH_PICK_HALFEDGES_FROM_INDICES", MESH_PICK_HALFEDGES_FROM_INDICES);
+  registerShaderRule("MESH_INSTANCED", MESH_INSTANCED);
+  registerShaderRule("MESH_INSTANCE_COLOR", MESH_INSTANCE_COLOR);
+  registerShaderRule("MESH_INSTANCED_PICK", MESH_INSTANCED_PICK);
 
   // sphere things
+  registerShaderRule("GRID_SAMPLE_DENSE", GRID_SAMPLE_DENSE);
+  registerShaderRule("GRID_SAMPLE_STREAMED", GRID_SAMPLE_STREAMED);
   registerShaderRule("SPHERE_PROPAGATE_VALUE", SPHERE_PROPAGATE_VALUE);
   registerShaderRule("SPHERE_PROPAGATE_VALUE2", SPHERE_PROPAGATE_VALUE2);
   registerShaderRule("SPHERE_PROPAGATE_COLOR", SPHERE_PROPAGATE_COLOR);
+  registerShaderRule("SPHERE_PROPAGATE_COLOR_PACKED", SPHERE_PROPAGATE_COLOR_PACKED);
+  registerShaderRule("SPHERE_PROPAGATE_LABEL", SPHERE_PROPAGATE_LABEL);
+  registerShaderRule("SPHERE_PROPAGATE_THRESHOLD", SPHERE_PROPAGATE_THRESHOLD);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX", SPHERE_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE", SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE);
+  registerShaderRule("SPHERE_PROPAGATE_PICK", SPHERE_PROPAGATE_PICK);
+  registerShaderRule("SPHERE_PROPAGATE_PICK_INDEXED", SPHERE_PROPAGATE_PICK_INDEXED);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER", SPHERE_CULLPOS_FROM_CENTER);
   registerShaderRule("SPHERE_CULLPOS_FROM_CENTER_QUAD", SPHERE_CULLPOS_FROM_CENTER_QUAD);
   registerShaderRule("SPHERE_VARIABLE_SIZE", SPHERE_VARIABLE_SIZE);
+  registerShaderRule("SPHERE_PROPAGATE_VALUE_INSTANCED", SPHERE_PROPAGATE_VALUE_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_VALUE2_INSTANCED", SPHERE_PROPAGATE_VALUE2_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_COLOR_INSTANCED", SPHERE_PROPAGATE_COLOR_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_COLOR_PACKED_INSTANCED", SPHERE_PROPAGATE_COLOR_PACKED_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_LABEL_INSTANCED", SPHERE_PROPAGATE_LABEL_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_THRESHOLD_INSTANCED", SPHERE_PROPAGATE_THRESHOLD_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX_INSTANCED", SPHERE_PROPAGATE_SUBSET_INDEX_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE_INSTANCED", SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_PICK_INSTANCED", SPHERE_PROPAGATE_PICK_INSTANCED);
+  registerShaderRule("SPHERE_PROPAGATE_PICK_INDEXED_INSTANCED", SPHERE_PROPAGATE_PICK_INDEXED_INSTANCED);
+  registerShaderRule("SPHERE_CULLPOS_FROM_CENTER_QUAD_INSTANCED", SPHERE_CULLPOS_FROM_CENTER_QUAD_INSTANCED);
+  registerShaderRule("SPHERE_VARIABLE_SIZE_INSTANCED", SPHERE_VARIABLE_SIZE_INSTANCED);
 
   // vector things
   registerShaderRule("VECTOR_PROPAGATE_COLOR", VECTOR_PROPAGATE_COLOR);
@@ -2751,8 +4628,29 @@ void GLEngine::populateDefaultShadersAndRules() {
   registerShaderRule("CYLINDER_PROPAGATE_COLOR", CYLINDER_PROPAGATE_COLOR);
   registerShaderRule("CYLINDER_PROPAGATE_BLEND_COLOR", CYLINDER_PROPAGATE_BLEND_COLOR);
   registerShaderRule("CYLINDER_PROPAGATE_PICK", CYLINDER_PROPAGATE_PICK);
+  registerShaderRule("CYLINDER_PROPAGATE_SUBSET_INDEX", CYLINDER_PROPAGATE_SUBSET_INDEX);
   registerShaderRule("CYLINDER_CULLPOS_FROM_MID", CYLINDER_CULLPOS_FROM_MID);
   registerShaderRule("CYLINDER_VARIABLE_SIZE", CYLINDER_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE", CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR", CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_PICK", CYLINDER_INDEXED_PROPAGATE_PICK);
+  registerShaderRule("CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX", CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("CYLINDER_INDEXED_VARIABLE_SIZE", CYLINDER_INDEXED_VARIABLE_SIZE);
+  registerShaderRule("CYLINDER_PROPAGATE_VALUE_INSTANCED", CYLINDER_PROPAGATE_VALUE_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_BLEND_VALUE_INSTANCED", CYLINDER_PROPAGATE_BLEND_VALUE_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_COLOR_INSTANCED", CYLINDER_PROPAGATE_COLOR_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_BLEND_COLOR_INSTANCED", CYLINDER_PROPAGATE_BLEND_COLOR_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_PICK_INSTANCED", CYLINDER_PROPAGATE_PICK_INSTANCED);
+  registerShaderRule("CYLINDER_PROPAGATE_SUBSET_INDEX_INSTANCED", CYLINDER_PROPAGATE_SUBSET_INDEX_INSTANCED);
+  registerShaderRule("CYLINDER_VARIABLE_SIZE_INSTANCED", CYLINDER_VARIABLE_SIZE_INSTANCED);
+  registerShaderRule("TUBE_PROPAGATE_BLEND_VALUE", TUBE_PROPAGATE_BLEND_VALUE);
+  registerShaderRule("TUBE_PROPAGATE_VALUE", TUBE_PROPAGATE_VALUE);
+  registerShaderRule("TUBE_PROPAGATE_BLEND_COLOR", TUBE_PROPAGATE_BLEND_COLOR);
+  registerShaderRule("TUBE_PROPAGATE_COLOR", TUBE_PROPAGATE_COLOR);
+  registerShaderRule("TUBE_PROPAGATE_PICK", TUBE_PROPAGATE_PICK);
+  registerShaderRule("TUBE_PROPAGATE_SUBSET_INDEX", TUBE_PROPAGATE_SUBSET_INDEX);
+  registerShaderRule("TUBE_CULLPOS_FROM_MID", TUBE_CULLPOS_FROM_MID);
+  registerShaderRule("TUBE_VARIABLE_SIZE", TUBE_VARIABLE_SIZE);
 
   // marching tets things
   registerShaderRule("SLICE_TETS_BASECOLOR_SHADE", SLICE_TETS_BASECOLOR_SHADE);
@@ -2764,10 +4662,6 @@ void GLEngine::populateDefaultShadersAndRules() {
   // clang-format on
 };
 
-void GLEngine::createSlicePlaneFliterRule(std::string uniquePostfix) {
-  registeredShaderRules.insert({"SLICE_PLANE_CULL_" + uniquePostfix, generateSlicePlaneRule(uniquePostfix)});
-}
-
 
 } // namespace backend_openGL3_glfw
 } // namespace render
@@ -2783,6 +4677,9 @@ namespace polyscope {
 namespace render {
 namespace backend_openGL3_glfw {
 void initializeRenderEngine() { exception("Polyscope was not compiled with support for backend: openGL3_glfw"); }
+void initializeRenderEngineHeadlessEGL() {
+  exception("Polyscope was not compiled with support for backend: openGL3_egl");
+}
 } // namespace backend_openGL3_glfw
 } // namespace render
 } // namespace polyscope
@@ -34,6 +34,14 @@ void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY) {
     basisY = normalize(cross(unitNormal, basisX));
 }
 
+// The radius in pixels of a sphere at centerView (in view space) as drawn on the screen, or LARGE_FLOAT() if it is
+// behind the camera
+float projectedPixelRadius(mat4 projMat, vec2 viewportDim, vec4 centerView, float radius) {
+    float w = (projMat * centerView).w;
+    if(w <= 0.) return LARGE_FLOAT();
+    return 0.5 * radius * max(abs(projMat[0][0]) * viewportDim.x, abs(projMat[1][1]) * viewportDim.y) / w;
+}
+
 float orenNayarDiffuse(
   vec3 lightDirection,
   vec3 viewDirection,
@@ -105,6 +113,16 @@ vec3 lightSurfaceMat(vec3 normal, vec3 color, sampler2D t_mat_r, sampler2D t_mat
   return colorCombined;
 }
 
+// Pick colors: the global pick index startDigits + offset, packed as in pick::indToVec(). The start is given as its
+// 22-bit digits (see pick::indToDigits()), so the full 64-bit index space is available.
+vec3 pickIndexToColor(uvec3 startDigits, uint offset) {
+  const uint mask = 4194303u; // 2^22 - 1
+  uint low = startDigits.x + (offset & mask);
+  uint med = startDigits.y + (offset >> 22) + (low >> 22);
+  uint high = startDigits.z + (med >> 22);
+  return vec3(float(low & mask), float(med & mask), float(high)) / 4194304.;
+}
+
 vec2 sphericalTexCoords(vec3 v) {
   const vec2 invMap = vec2(0.1591, 0.3183);
   vec2 uv = vec2(atan(v.z, v.x), asin(v.y));
@@ -113,6 +131,26 @@ vec2 sphericalTexCoords(vec3 v) {
   return uv;
 }
 
+// Entry i of an attribute buffer read as a buffer texture, one component per texel (see
+// ShaderProgram::setTextureFromAttributeBuffer())
+float fetchBufferFloat(samplerBuffer t, int i) { return texelFetch(t, i).r; }
+vec2 fetchBufferVec2(samplerBuffer t, int i) { return vec2(texelFetch(t, 2*i).r, texelFetch(t, 2*i+1).r); }
+vec3 fetchBufferVec3(samplerBuffer t, int i) {
+  return vec3(texelFetch(t, 3*i).r, texelFetch(t, 3*i+1).r, texelFetch(t, 3*i+2).r);
+}
+vec4 fetchBufferVec4(samplerBuffer t, int i) {
+  return vec4(texelFetch(t, 4*i).r, texelFetch(t, 4*i+1).r, texelFetch(t, 4*i+2).r, texelFetch(t, 4*i+3).r);
+}
+uint fetchBufferUInt(usamplerBuffer t, int i) { return texelFetch(t, i).r; }
+int fetchBufferInt(isamplerBuffer t, int i) { return texelFetch(t, i).r; }
+
+// Bit i of a mask of 32-bit words read as a buffer texture, false past its end
+bool subsetMaskContains(usamplerBuffer mask, uint i) {
+  int word = int(i >> 5u);
+  if (word >= textureSize(mask)) return false;
+  return ((texelFetch(mask, word).r >> (i & 31u)) & 1u) != 0u;
+}
+
 // Two useful references:
 //   - https://stackoverflow.com/questions/38938498/how-do-i-convert-gl-fragcoord-to-a-world-space-point-in-a-fragment-shader
 //   - https://stackoverflow.com/questions/11277501/how-to-recover-view-space-position-given-view-space-depth-value-and-ndc-xy
@@ -198,6 +236,19 @@ bool rayDiskIntersection(vec3 rayStart, vec3 rayDir, vec3 planePos, vec3 planeDi
   return true;
 }
 
+// Slab test against an axis-aligned box. On a hit, [tNear, tFar] is the part of the ray inside the box, with tNear
+// clamped to 0 when the ray starts inside.
+bool rayBoxIntersection(vec3 rayStart, vec3 rayDir, vec3 boxMin, vec3 boxMax, out float tNear, out float tFar) {
+  vec3 invDir = 1. / rayDir;
+  vec3 t0 = (boxMin - rayStart) * invDir;
+  vec3 t1 = (boxMax - rayStart) * invDir;
+  vec3 tMin = min(t0, t1);
+  vec3 tMax = max(t0, t1);
+  tNear = max(max(tMin.x, tMin.y), max(tMin.z, 0.));
+  tFar = min(min(tMax.x, tMax.y), tMax.z);
+  return tNear <= tFar;
+}
+
 bool rayCylinderIntersection(vec3 rayStart, vec3 rayDir, vec3 cylTail, vec3 cylTip, float cylRad, out float tHit, out vec3 pHit, out vec3 nHit) {
     
     rayDir = normalize(rayDir);
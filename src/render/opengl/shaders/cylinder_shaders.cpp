@@ -54,6 +54,8 @@ const ShaderStageSpecification FLEX_CYLINDER_GEOM_SHADER = {
     // uniforms
     {
         {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_viewportDim", RenderDataType::Vector2Float},
+        {"u_impostorFallbackPixelSize", RenderDataType::Float},
         {"u_radius", RenderDataType::Float},
     }, 
 
@@ -71,13 +73,17 @@ R"(
         layout(triangle_strip, max_vertices=14) out;
         in vec4 position_tip[];
         uniform mat4 u_projMatrix;
+        uniform vec2 u_viewportDim;
+        uniform float u_impostorFallbackPixelSize;
         uniform float u_radius;
         out vec3 tipView;
         out vec3 tailView;
+        flat out float cylinderFlat;
 
         ${ GEOM_DECLARATIONS }$
 
         void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+        float projectedPixelRadius(mat4 projMat, vec2 viewportDim, vec4 centerView, float radius);
 
         void main() {
             float tipRadius = u_radius;
@@ -108,22 +114,193 @@ R"(
             vec4 p8 = tipProj + dxTip + dyTip;
             
             // Other data to emit   
+
+            // Cylinders thinner than about a pixel are drawn as a flat line one pixel wide, which the fragment shader
+            // does not raycast
+            float tailPixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, gl_in[0].gl_Position, tailRadius);
+            float tipPixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, position_tip[0], tipRadius);
+            if(2. * max(tailPixelRadius, tipPixelRadius) < u_impostorFallbackPixelSize) {
+              vec2 pixelNDC = 2. / u_viewportDim;
+              vec2 lineDir = (tipProj.xy / tipProj.w - tailProj.xy / tailProj.w) / pixelNDC;
+              lineDir = length(lineDir) > 0. ? normalize(lineDir) : vec2(1., 0.);
+              vec4 along = vec4(0.5 * pixelNDC * lineDir, 0., 0.);
+              vec4 across = vec4(0.5 * pixelNDC * vec2(-lineDir.y, lineDir.x), 0., 0.);
+              vec4 q1 = tailProj + tailProj.w * (-along - across);
+              vec4 q2 = tailProj + tailProj.w * (-along + across);
+              vec4 q3 = tipProj + tipProj.w * (along - across);
+              vec4 q4 = tipProj + tipProj.w * (along + across);
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q1; EmitVertex(); 
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q2; EmitVertex(); 
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q3; EmitVertex(); 
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q4; EmitVertex(); 
+              EndPrimitive();
+              return;
+            }
+    
+            // Emit the vertices as a triangle strip
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p7; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p8; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p5; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p6; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p2; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p8; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p4; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p7; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p3; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p5; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p1; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p2; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p3; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p4; EmitVertex();
+    
+            EndPrimitive();
+
+        }
+
+)"
+};
+
+
+// Variant of the cylinder pipeline which is drawn as indexed lines over the node buffers: each line is (tail, tip), so
+// per-node data is read directly rather than being copied out per-edge.
+const ShaderStageSpecification FLEX_CYLINDER_INDEXED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+    }, 
+
+    // attributes
+    {
+        {"a_position", RenderDataType::Vector3Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position;
+        uniform mat4 u_modelView;
+        
+        ${ VERT_DECLARATIONS }$
+        
+        void main()
+        {
+            gl_Position = u_modelView * vec4(a_position, 1.0);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+const ShaderStageSpecification FLEX_CYLINDER_INDEXED_GEOM_SHADER = {
+    
+    ShaderStageType::Geometry,
+    
+    // uniforms
+    {
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_viewportDim", RenderDataType::Vector2Float},
+        {"u_impostorFallbackPixelSize", RenderDataType::Float},
+        {"u_radius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        layout(lines) in;
+        layout(triangle_strip, max_vertices=14) out;
+        uniform mat4 u_projMatrix;
+        uniform vec2 u_viewportDim;
+        uniform float u_impostorFallbackPixelSize;
+        uniform float u_radius;
+        out vec3 tipView;
+        out vec3 tailView;
+        flat out float cylinderFlat;
+
+        ${ GEOM_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+        float projectedPixelRadius(mat4 projMat, vec2 viewportDim, vec4 centerView, float radius);
+
+        void main() {
+            float tipRadius = u_radius;
+            float tailRadius = u_radius;
+            ${ CYLINDER_SET_RADIUS_GEOM }$
+
+            // Build an orthogonal basis
+            vec3 tailViewVal = gl_in[0].gl_Position.xyz / gl_in[0].gl_Position.w;
+            vec3 tipViewVal = gl_in[1].gl_Position.xyz / gl_in[1].gl_Position.w;
+            vec3 cylDir = normalize(tipViewVal - tailViewVal);
+            vec3 basisX; vec3 basisY; buildTangentBasis(cylDir, basisX, basisY);
+  
+            // Compute corners of cube
+            vec4 tailProj = u_projMatrix * gl_in[0].gl_Position;
+            vec4 tipProj = u_projMatrix * gl_in[1].gl_Position;
+            vec4 dxTip = u_projMatrix * vec4(basisX * tipRadius, 0.);
+            vec4 dyTip = u_projMatrix * vec4(basisY * tipRadius, 0.);
+            vec4 dxTail = u_projMatrix * vec4(basisX * tailRadius, 0.);
+            vec4 dyTail = u_projMatrix * vec4(basisY * tailRadius, 0.);
+
+            vec4 p1 = tailProj - dxTail - dyTail;
+            vec4 p2 = tailProj + dxTail - dyTail;
+            vec4 p3 = tailProj - dxTail + dyTail;
+            vec4 p4 = tailProj + dxTail + dyTail;
+            vec4 p5 = tipProj - dxTip - dyTip;
+            vec4 p6 = tipProj + dxTip - dyTip;
+            vec4 p7 = tipProj - dxTip + dyTip;
+            vec4 p8 = tipProj + dxTip + dyTip;
+            
+            // Other data to emit   
+
+            // Cylinders thinner than about a pixel are drawn as a flat line one pixel wide, which the fragment shader
+            // does not raycast
+            float tailPixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, gl_in[0].gl_Position, tailRadius);
+            float tipPixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, gl_in[1].gl_Position, tipRadius);
+            if(2. * max(tailPixelRadius, tipPixelRadius) < u_impostorFallbackPixelSize) {
+              vec2 pixelNDC = 2. / u_viewportDim;
+              vec2 lineDir = (tipProj.xy / tipProj.w - tailProj.xy / tailProj.w) / pixelNDC;
+              lineDir = length(lineDir) > 0. ? normalize(lineDir) : vec2(1., 0.);
+              vec4 along = vec4(0.5 * pixelNDC * lineDir, 0., 0.);
+              vec4 across = vec4(0.5 * pixelNDC * vec2(-lineDir.y, lineDir.x), 0., 0.);
+              vec4 q1 = tailProj + tailProj.w * (-along - across);
+              vec4 q2 = tailProj + tailProj.w * (-along + across);
+              vec4 q3 = tipProj + tipProj.w * (along - across);
+              vec4 q4 = tipProj + tipProj.w * (along + across);
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q1; EmitVertex(); 
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q2; EmitVertex(); 
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q3; EmitVertex(); 
+              ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 1.; gl_Position = q4; EmitVertex(); 
+              EndPrimitive();
+              return;
+            }
     
             // Emit the vertices as a triangle strip
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p7; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p8; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p5; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p6; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p2; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p8; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p4; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p7; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p3; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p5; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p1; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p2; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p3; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; gl_Position = p4; EmitVertex();
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p7; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p8; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p5; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p6; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p2; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p8; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p4; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p7; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p3; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p5; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p1; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p2; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p3; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ tailView = tailViewVal; tipView = tipViewVal; cylinderFlat = 0.; gl_Position = p4; EmitVertex();
     
             EndPrimitive();
 
@@ -133,6 +310,97 @@ R"(
 };
 
 
+// Variant of the cylinder pipeline without a geometry shader, which is slow on some hardware for very many edges. Each
+// edge is an instance, drawn as the triangles of its bounding box; a_boxCorner gives the corner as (x, y) offsets in
+// the cross-section basis and z = 0 / 1 for the tail / tip end. All other attributes are per-instance. It is paired with
+// the fragment shader below, and takes the _INSTANCED versions of the rules.
+const ShaderStageSpecification FLEX_CYLINDER_INSTANCED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_viewportDim", RenderDataType::Vector2Float},
+        {"u_impostorFallbackPixelSize", RenderDataType::Float},
+        {"u_radius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+        {"a_position_tail", RenderDataType::Vector3Float},
+        {"a_position_tip", RenderDataType::Vector3Float},
+        {"a_boxCorner", RenderDataType::Vector3Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position_tail;
+        in vec3 a_position_tip;
+        in vec3 a_boxCorner;
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform vec2 u_viewportDim;
+        uniform float u_impostorFallbackPixelSize;
+        uniform float u_radius;
+        out vec3 tailView;
+        out vec3 tipView;
+        flat out float cylinderFlat;
+        
+        ${ VERT_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+        float projectedPixelRadius(mat4 projMat, vec2 viewportDim, vec4 centerView, float radius);
+        
+        void main()
+        {
+            float tipRadius = u_radius;
+            float tailRadius = u_radius;
+            ${ CYLINDER_SET_RADIUS_VERT }$
+
+            // Build an orthogonal basis
+            vec4 tailViewH = u_modelView * vec4(a_position_tail, 1.0);
+            vec4 tipViewH = u_modelView * vec4(a_position_tip, 1.0);
+            tailView = tailViewH.xyz / tailViewH.w;
+            tipView = tipViewH.xyz / tipViewH.w;
+            vec3 cylDir = normalize(tipView - tailView);
+            vec3 basisX; vec3 basisY; buildTangentBasis(cylDir, basisX, basisY);
+
+            // This corner of the bounding box
+            bool atTip = a_boxCorner.z > 0.5;
+            vec4 endView = atTip ? tipViewH : tailViewH;
+            float endRadius = atTip ? tipRadius : tailRadius;
+            vec3 offset = (a_boxCorner.x * basisX + a_boxCorner.y * basisY) * endRadius;
+            gl_Position = u_projMatrix * (endView + vec4(offset, 0.));
+
+            // Cylinders thinner than about a pixel are drawn flat, as in the geometry shaders: the box collapses to a
+            // line one pixel wide
+            cylinderFlat = 0.;
+            float tailPixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, tailViewH, tailRadius);
+            float tipPixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, tipViewH, tipRadius);
+            if(2. * max(tailPixelRadius, tipPixelRadius) < u_impostorFallbackPixelSize) {
+              cylinderFlat = 1.;
+              vec4 tailProj = u_projMatrix * tailViewH;
+              vec4 tipProj = u_projMatrix * tipViewH;
+              vec2 pixelNDC = 2. / u_viewportDim;
+              vec2 lineDir = (tipProj.xy / tipProj.w - tailProj.xy / tailProj.w) / pixelNDC;
+              lineDir = length(lineDir) > 0. ? normalize(lineDir) : vec2(1., 0.);
+              vec2 along = 0.5 * pixelNDC * lineDir * (atTip ? 1. : -1.);
+              vec2 across = 0.5 * pixelNDC * vec2(-lineDir.y, lineDir.x) * (a_boxCorner.x > 0. ? 1. : -1.);
+              vec4 endProj = atTip ? tipProj : tailProj;
+              gl_Position = endProj + endProj.w * vec4(along + across, 0., 0.);
+            }
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
 const ShaderStageSpecification FLEX_CYLINDER_FRAG_SHADER = {
     
     ShaderStageType::Fragment,
@@ -154,12 +422,18 @@ const ShaderStageSpecification FLEX_CYLINDER_FRAG_SHADER = {
     // source
 R"(
         ${ GLSL_VERSION }$
+        // The ray hit is never nearer than the proxy geometry, so declaring that keeps early depth testing on
+        #ifdef GL_ARB_conservative_depth
+        #extension GL_ARB_conservative_depth : enable
+        layout(depth_greater) out float gl_FragDepth;
+        #endif
         uniform mat4 u_projMatrix; 
         uniform mat4 u_invProjMatrix;
         uniform vec4 u_viewport;
         uniform float u_radius;
         in vec3 tailView;
         in vec3 tipView;
+        flat in float cylinderFlat;
         layout(location = 0) out vec4 outputF;
 
         float LARGE_FLOAT();
@@ -180,15 +454,31 @@ R"(
            float tailRadius = u_radius;
            ${ CYLINDER_SET_RADIUS_FRAG }$
 
-           // Raycast to the cylinder
+           // Raycast to the cylinder, unless it is drawn flat (then it is less than a pixel wide, so the point on its
+           // axis nearest the ray stands in for the hit)
            float tHit;
            vec3 pHit;
            vec3 nHit;
-           rayTaperedCylinderIntersection(vec3(0., 0., 0), viewRay, tailView, tipView, tailRadius, tipRadius, tHit, pHit, nHit);
-           if(tHit >= LARGE_FLOAT()) {
-              discard;
+           float depth;
+           if(cylinderFlat > 0.5) {
+              vec3 rayDir = normalize(viewRay);
+              vec3 axis = tipView - tailView;
+              float b = dot(rayDir, axis);
+              float c = dot(axis, axis);
+              float denom = c - b * b;
+              float s = denom > 1e-12 * c ? (b * dot(rayDir, tailView) - dot(axis, tailView)) / denom : 0.;
+              pHit = tailView + clamp(s, 0., 1.) * axis;
+              vec3 toCamera = -pHit;
+              nHit = toCamera - dot(toCamera, axis) / max(c, 1e-12) * axis;
+              nHit = dot(nHit, nHit) > 0. ? normalize(nHit) : normalize(toCamera);
+              depth = gl_FragCoord.z;
+           } else {
+              rayTaperedCylinderIntersection(vec3(0., 0., 0), viewRay, tailView, tipView, tailRadius, tipRadius, tHit, pHit, nHit);
+              if(tHit >= LARGE_FLOAT()) {
+                 discard;
+              }
+              depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
            }
-           float depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
 
            ${ GLOBAL_FRAGMENT_FILTER_PREP }$
            ${ GLOBAL_FRAGMENT_FILTER }$
@@ -374,22 +664,25 @@ const ShaderReplacementRule CYLINDER_CULLPOS_FROM_MID (
     /* textures */ {}
 );
 
-// data for picking
+// data for picking: the ends pick as their nodes (offset from u_pickStart by node index) and the middle as the edge
+// (offset from u_edgePickStart by edge index)
 const ShaderReplacementRule CYLINDER_PROPAGATE_PICK (
     /* rule name */ "CYLINDER_PROPAGATE_PICK",
     { /* replacement sources */
       {"VERT_DECLARATIONS", R"(
-          in vec3 a_color_tail;
-          in vec3 a_color_tip;
-          in vec3 a_color_edge;
+          uniform uvec3 u_pickStart;
+          uniform uvec3 u_edgePickStart;
+          in uint a_tailInd;
+          in uint a_tipInd;
           out vec3 a_colorTailToGeom;
           out vec3 a_colorTipToGeom;
           out vec3 a_colorEdgeToGeom;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
         )"},
       {"VERT_ASSIGNMENTS", R"(
-          a_colorTailToGeom = a_color_tail;
-          a_colorTipToGeom = a_color_tip;
-          a_colorEdgeToGeom = a_color_edge;
+          a_colorTailToGeom = pickIndexToColor(u_pickStart, a_tailInd);
+          a_colorTipToGeom = pickIndexToColor(u_pickStart, a_tipInd);
+          a_colorEdgeToGeom = pickIndexToColor(u_edgePickStart, uint(gl_VertexID));
         )"},
       {"GEOM_DECLARATIONS", R"(
           in vec3 a_colorTailToGeom[];
@@ -423,15 +716,46 @@ const ShaderReplacementRule CYLINDER_PROPAGATE_PICK (
           }
         )"},
     },
-    /* uniforms */ {},
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+      {"u_edgePickStart", RenderDataType::Vector3UInt},
+    },
     /* attributes */ {
-      {"a_color_tail", RenderDataType::Vector3Float},
-      {"a_color_tip", RenderDataType::Vector3Float},
-      {"a_color_edge", RenderDataType::Vector3Float},
+      {"a_tailInd", RenderDataType::UInt},
+      {"a_tipInd", RenderDataType::UInt},
     },
     /* textures */ {}
 );
 
+// the element index for subsets (see SUBSET_VISIBLE_CULL) is the edge index
+const ShaderReplacementRule CYLINDER_PROPAGATE_SUBSET_INDEX (
+    /* rule name */ "CYLINDER_PROPAGATE_SUBSET_INDEX",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          flat out uint a_subsetIndexToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToGeom = uint(gl_VertexID);
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToGeom[];
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_subsetIndexToFrag = a_subsetIndexToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 const ShaderReplacementRule CYLINDER_VARIABLE_SIZE (
     /* rule name */ "CYLINDER_VARIABLE_SIZE",
     { /* replacement sources */
@@ -476,6 +800,408 @@ const ShaderReplacementRule CYLINDER_VARIABLE_SIZE (
     /* textures */ {}
 );
 
+// == Rules for the indexed variant, where vertex attributes are per-node and [0] / [1] are the tail / tip
+
+const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE (
+    /* rule name */ "CYLINDER_INDEXED_PROPAGATE_BLEND_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value;
+          out float a_valueToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueToGeom = a_value;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in float a_valueToGeom[];
+          out float a_valueTailToFrag;
+          out float a_valueTipToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_valueTailToFrag = a_valueToGeom[0]; 
+          a_valueTipToFrag = a_valueToGeom[1]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueTailToFrag;
+          in float a_valueTipToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          float shadeValue = mix(a_valueTailToFrag, a_valueTipToFrag, tEdge);
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR (
+    /* rule name */ "CYLINDER_INDEXED_PROPAGATE_BLEND_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color;
+          out vec3 a_colorToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToGeom = a_color;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in vec3 a_colorToGeom[];
+          out vec3 a_colorTailToFrag;
+          out vec3 a_colorTipToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorTailToFrag = a_colorToGeom[0]; 
+          a_colorTipToFrag = a_colorToGeom[1]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_colorTailToFrag;
+          in vec3 a_colorTipToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          vec3 shadeColor = mix(a_colorTailToFrag, a_colorTipToFrag, tEdge);
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+// indexed drawing means gl_VertexID is the node index, and the primitive ID is the edge index
+const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_PICK (
+    /* rule name */ "CYLINDER_INDEXED_PROPAGATE_PICK",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          out vec3 a_colorToGeom;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToGeom = pickIndexToColor(u_pickStart, uint(gl_VertexID));
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          uniform uvec3 u_edgePickStart;
+          in vec3 a_colorToGeom[];
+          flat out vec3 a_colorTailToFrag;
+          flat out vec3 a_colorTipToFrag;
+          flat out vec3 a_colorEdgeToFrag;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorTailToFrag = a_colorToGeom[0]; 
+          a_colorTipToFrag = a_colorToGeom[1]; 
+          a_colorEdgeToFrag = pickIndexToColor(u_edgePickStart, uint(gl_PrimitiveIDIn)); 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorTailToFrag;
+          flat in vec3 a_colorTipToFrag;
+          flat in vec3 a_colorEdgeToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          float endWidth = 0.2;
+          vec3 shadeColor;
+          if(tEdge < endWidth) {
+            shadeColor = a_colorTailToFrag;
+          } else if (tEdge < (1.0f - endWidth)) {
+            shadeColor = a_colorEdgeToFrag;
+          } else {
+            shadeColor = a_colorTipToFrag;
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+      {"u_edgePickStart", RenderDataType::Vector3UInt},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX (
+    /* rule name */ "CYLINDER_INDEXED_PROPAGATE_SUBSET_INDEX",
+    { /* replacement sources */
+      {"GEOM_DECLARATIONS", R"(
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_subsetIndexToFrag = uint(gl_PrimitiveIDIn); 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_INDEXED_VARIABLE_SIZE (
+    /* rule name */ "CYLINDER_INDEXED_VARIABLE_SIZE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_nodeRadius;
+          out float a_nodeRadiusToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_nodeRadiusToGeom = a_nodeRadius;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in float a_nodeRadiusToGeom[];
+          out float a_tipRadiusToFrag;
+          out float a_tailRadiusToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_tipRadiusToFrag = a_nodeRadiusToGeom[1]; 
+          a_tailRadiusToFrag = a_nodeRadiusToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_tipRadiusToFrag;
+          in float a_tailRadiusToFrag;
+        )"},
+      {"CYLINDER_SET_RADIUS_GEOM", R"(
+          tipRadius *= a_nodeRadiusToGeom[1];
+          tailRadius *= a_nodeRadiusToGeom[0];
+        )"},
+      {"CYLINDER_SET_RADIUS_FRAG", R"(
+          tipRadius *= a_tipRadiusToFrag;
+          tailRadius *= a_tailRadiusToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_nodeRadius", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+// == Rules for the instanced variant, where vertex attributes are per-edge and the edge index is the instance ID. Per-node
+// data is gathered to each edge's tail and tip.
+
+const ShaderReplacementRule CYLINDER_PROPAGATE_VALUE_INSTANCED (
+    /* rule name */ "CYLINDER_PROPAGATE_VALUE_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value;
+          out float a_valueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueToFrag = a_value;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_valueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_VALUE_INSTANCED (
+    /* rule name */ "CYLINDER_PROPAGATE_BLEND_VALUE_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value_tail;
+          in float a_value_tip;
+          out float a_valueTailToFrag;
+          out float a_valueTipToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueTailToFrag = a_value_tail;
+          a_valueTipToFrag = a_value_tip;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueTailToFrag;
+          in float a_valueTipToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          float shadeValue = mix(a_valueTailToFrag, a_valueTipToFrag, tEdge);
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value_tail", RenderDataType::Float},
+      {"a_value_tip", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_PROPAGATE_COLOR_INSTANCED (
+    /* rule name */ "CYLINDER_PROPAGATE_COLOR_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color;
+          out vec3 a_colorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = a_color;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_PROPAGATE_BLEND_COLOR_INSTANCED (
+    /* rule name */ "CYLINDER_PROPAGATE_BLEND_COLOR_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color_tail;
+          in vec3 a_color_tip;
+          out vec3 a_colorTailToFrag;
+          out vec3 a_colorTipToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorTailToFrag = a_color_tail;
+          a_colorTipToFrag = a_color_tip;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_colorTailToFrag;
+          in vec3 a_colorTipToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          vec3 shadeColor = mix(a_colorTailToFrag, a_colorTipToFrag, tEdge);
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color_tail", RenderDataType::Vector3Float},
+      {"a_color_tip", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_PROPAGATE_PICK_INSTANCED (
+    /* rule name */ "CYLINDER_PROPAGATE_PICK_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          uniform uvec3 u_edgePickStart;
+          in uint a_tailInd;
+          in uint a_tipInd;
+          flat out vec3 a_colorTailToFrag;
+          flat out vec3 a_colorTipToFrag;
+          flat out vec3 a_colorEdgeToFrag;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorTailToFrag = pickIndexToColor(u_pickStart, a_tailInd);
+          a_colorTipToFrag = pickIndexToColor(u_pickStart, a_tipInd);
+          a_colorEdgeToFrag = pickIndexToColor(u_edgePickStart, uint(gl_InstanceID));
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorTailToFrag;
+          flat in vec3 a_colorTipToFrag;
+          flat in vec3 a_colorEdgeToFrag;
+          float length2(vec3 x);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float tEdge = dot(pHit - tailView, tipView - tailView) / length2(tipView - tailView);
+          float endWidth = 0.2;
+          vec3 shadeColor;
+          if(tEdge < endWidth) {
+            shadeColor = a_colorTailToFrag;
+          } else if (tEdge < (1.0f - endWidth)) {
+            shadeColor = a_colorEdgeToFrag;
+          } else {
+            shadeColor = a_colorTipToFrag;
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+      {"u_edgePickStart", RenderDataType::Vector3UInt},
+    },
+    /* attributes */ {
+      {"a_tailInd", RenderDataType::UInt},
+      {"a_tipInd", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_PROPAGATE_SUBSET_INDEX_INSTANCED (
+    /* rule name */ "CYLINDER_PROPAGATE_SUBSET_INDEX_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToFrag = uint(gl_InstanceID);
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule CYLINDER_VARIABLE_SIZE_INSTANCED (
+    /* rule name */ "CYLINDER_VARIABLE_SIZE_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_tipRadius;
+          in float a_tailRadius;
+          out float a_tipRadiusToFrag;
+          out float a_tailRadiusToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_tipRadiusToFrag = a_tipRadius;
+          a_tailRadiusToFrag = a_tailRadius;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_tipRadiusToFrag;
+          in float a_tailRadiusToFrag;
+        )"},
+      {"CYLINDER_SET_RADIUS_VERT", R"(
+          tipRadius *= a_tipRadius;
+          tailRadius *= a_tailRadius;
+        )"},
+      {"CYLINDER_SET_RADIUS_FRAG", R"(
+          tipRadius *= a_tipRadiusToFrag;
+          tailRadius *= a_tailRadiusToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_tipRadius", RenderDataType::Float},
+      {"a_tailRadius", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
 // clang-format on
 
 } // namespace backend_openGL3_glfw
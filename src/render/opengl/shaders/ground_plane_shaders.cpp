@@ -256,7 +256,10 @@ const ShaderStageSpecification GROUND_PLANE_SHADOW_FRAG_SHADER = {
       {"u_shadowDarkness", RenderDataType::Float},
       {"u_cameraHeight", RenderDataType::Float},
       {"u_groundHeight", RenderDataType::Float},
-      {"u_upSign", RenderDataType::Float}
+      {"u_upSign", RenderDataType::Float},
+      {"u_shadowMapBasisU", RenderDataType::Vector3Float},
+      {"u_shadowMapBasisV", RenderDataType::Vector3Float},
+      {"u_shadowMapOffset", RenderDataType::Vector2Float}
     }, 
 
     // attributes
@@ -280,6 +283,9 @@ R"(
       uniform float u_cameraHeight;
       uniform float u_groundHeight;
       uniform float u_upSign;
+      uniform vec3 u_shadowMapBasisU;
+      uniform vec3 u_shadowMapBasisV;
+      uniform vec2 u_shadowMapOffset;
       in vec4 PositionWorldHomog;
       layout(location = 0) out vec4 outputF;
       
@@ -290,11 +296,16 @@ R"(
         float depth = gl_FragCoord.z;
         ${ GLOBAL_FRAGMENT_FILTER }$
 
-        vec2 screenCoords = vec2(gl_FragCoord.x / u_viewportDim.x, gl_FragCoord.y / u_viewportDim.y);
-        float shadowVal = texture(t_shadow, screenCoords).r;
+        // The shadow map is stored in ground plane coordinates
+        vec3 positionWorld = PositionWorldHomog.xyz / PositionWorldHomog.w;
+        vec2 shadowCoords = vec2(dot(positionWorld, u_shadowMapBasisU), dot(positionWorld, u_shadowMapBasisV)) + u_shadowMapOffset;
+        float shadowVal = 0.;
+        if(all(greaterThanEqual(shadowCoords, vec2(0., 0.))) && all(lessThanEqual(shadowCoords, vec2(1., 1.)))) {
+          shadowVal = texture(t_shadow, shadowCoords).r;
+        }
         shadowVal = pow(clamp(shadowVal, 0., 1.), 0.25);
 
-        float shadowMax = u_shadowDarkness + 0. * PositionWorldHomog.x;  // use PositionWorldHomog to prevent silly optimizing out
+        float shadowMax = u_shadowDarkness;
         vec3 groundColor = vec3(0., 0., 0.);
         //vec3 groundColor = vec3(1., 0., 0.);
 
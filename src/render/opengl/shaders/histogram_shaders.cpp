@@ -85,6 +85,75 @@ R"(
 )"
 };
 
+const ShaderStageSpecification HISTOGRAM_BIN_VERT_SHADER =  {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+      {"u_dataRangeMin", RenderDataType::Float},
+      {"u_dataRangeMax", RenderDataType::Float},
+      {"u_binCount", RenderDataType::Float},
+    },
+
+    // attributes
+    {
+        {"a_value", RenderDataType::Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+      ${ GLSL_VERSION }$
+      in float a_value;
+
+      uniform float u_dataRangeMin;
+      uniform float u_dataRangeMax;
+      uniform float u_binCount;
+
+      void main()
+      {
+          // NaN values land outside the viewport, and so are not counted
+          if(isnan(a_value)) {
+            gl_Position = vec4(2., 2., 0., 1.);
+            return;
+          }
+
+          // one pixel per bin; values outside the range are counted in the first/last bin
+          float iBin = floor(u_binCount * (a_value - u_dataRangeMin) / (u_dataRangeMax - u_dataRangeMin));
+          iBin = clamp(iBin, 0., u_binCount - 1.);
+          gl_Position = vec4(2. * (iBin + 0.5) / u_binCount - 1., 0., 0., 1.);
+      }
+)"
+};
+
+const ShaderStageSpecification HISTOGRAM_BIN_FRAG_SHADER = {
+
+    ShaderStageType::Fragment,
+
+    {}, // uniforms
+
+    // attributes
+    {
+    },
+
+    {}, // textures
+
+    // source
+R"(
+      ${ GLSL_VERSION }$
+
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        // summed by additive blending
+        outputF = vec4(1., 0., 0., 1.);
+      }
+)"
+};
+
 // clang-format on
 
 } // namespace backend_openGL3_glfw
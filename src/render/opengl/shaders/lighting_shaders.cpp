@@ -222,6 +222,30 @@ const ShaderReplacementRule TRANSPARENCY_PEEL_STRUCTURE (
     }
 );
 
+// Weighted blended order-independent transparency (McGuire & Bavoil 2013). Rendered with additive blending, the color
+// target accumulates premultiplied color and alpha scaled by a depth weight, and the revealage target accumulates
+// -log(1 - alpha), so its sum gives the product of the transmittances after exponentiating.
+const ShaderReplacementRule TRANSPARENCY_WEIGHTED_STRUCTURE (
+    /* rule name */ "TRANSPARENCY_WEIGHTED_STRUCTURE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform float u_transparency;
+          layout(location = 1) out vec4 outputRevealage;
+        )"},
+      {"GENERATE_ALPHA", R"(
+          float wboitAlpha = clamp(u_transparency, 0., 0.999);
+          float wboitWeight = clamp(3e3 * pow(1. - gl_FragCoord.z, 3.), 1e-2, 3e3);
+          outputRevealage = vec4(-log(1. - wboitAlpha), 0., 0., 1.);
+          alphaOut = wboitAlpha * wboitWeight;
+        )"},
+    },
+    /* uniforms */ {
+        {"u_transparency", RenderDataType::Float},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 const ShaderReplacementRule TRANSPARENCY_PEEL_GROUND (
     /* rule name */ "TRANSPARENCY_PEEL_GROUND",
     { /* replacement sources */
@@ -201,6 +201,452 @@ R"(
 )"
 };
 
+// Tubes along polyline strips. Like the ribbon above, each strip is drawn as an indexed line strip with adjacency, so
+// adjacent segments agree on the mitered cross-section at their shared node and the tube is continuous. Each segment is
+// a camera-facing quad whose fragments are shaded and depth-tested as the surface of the tube.
+
+const ShaderStageSpecification RIBBON_TUBE_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+    }, 
+
+    // attributes
+    {
+        {"a_position", RenderDataType::Vector3Float},
+    },
+    
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position;
+        uniform mat4 u_modelView;
+
+        ${ VERT_DECLARATIONS }$
+
+        void main()
+        {
+            gl_Position = u_modelView * vec4(a_position, 1.0);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+const ShaderStageSpecification RIBBON_TUBE_GEOM_SHADER = {
+    
+    ShaderStageType::Geometry,
+    
+    // uniforms
+    {
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_radius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+    },
+    
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        layout(lines_adjacency) in;
+        layout(triangle_strip, max_vertices=4) out;
+        uniform mat4 u_projMatrix;
+        uniform float u_radius;
+        out vec3 centerView;
+        out vec3 sideView;
+        out float sideCoord;
+        out float radiusToFrag;
+        out float tEdge;
+
+        ${ GEOM_DECLARATIONS }$
+
+        // the sum of unit directions into and out of a node, so both segments sharing the node compute the same value
+        vec3 mitreTangent(vec3 dirA, vec3 dirB) {
+            vec3 t = dirA + dirB;
+            if(dot(t, t) < 1e-12) return dirB;
+            return normalize(t);
+        }
+
+        // the direction across the tube at a node, perpendicular to the tangent and the view ray
+        vec3 tubeSide(vec3 tangent, vec3 center) {
+            vec3 side = cross(tangent, center);
+            if(dot(side, side) < 1e-12) side = cross(tangent, vec3(0., 1., 0.));
+            if(dot(side, side) < 1e-12) side = cross(tangent, vec3(1., 0., 0.));
+            return normalize(side);
+        }
+
+        void main() {
+            int emitInd;
+            vec3 pos0 = gl_in[0].gl_Position.xyz / gl_in[0].gl_Position.w;
+            vec3 pos1 = gl_in[1].gl_Position.xyz / gl_in[1].gl_Position.w;
+            vec3 pos2 = gl_in[2].gl_Position.xyz / gl_in[2].gl_Position.w;
+            vec3 pos3 = gl_in[3].gl_Position.xyz / gl_in[3].gl_Position.w;
+            if(pos1 == pos2) return;
+
+            // the ends of a strip repeat the end node as its own neighbor
+            vec3 dir = normalize(pos2 - pos1);
+            vec3 prevDir = (pos0 == pos1) ? dir : normalize(pos1 - pos0);
+            vec3 nextDir = (pos2 == pos3) ? dir : normalize(pos3 - pos2);
+            vec3 sideTail = tubeSide(mitreTangent(prevDir, dir), pos1);
+            vec3 sideTip = tubeSide(mitreTangent(dir, nextDir), pos2);
+
+            float tailRadius = u_radius;
+            float tipRadius = u_radius;
+            ${ TUBE_SET_RADIUS_GEOM }$
+
+            emitInd = 1;
+            ${ GEOM_PER_EMIT }$ centerView = pos1; sideView = sideTail; radiusToFrag = tailRadius; tEdge = 0.; sideCoord = -1.;
+            gl_Position = u_projMatrix * vec4(pos1 - tailRadius * sideTail, 1.); EmitVertex();
+            ${ GEOM_PER_EMIT }$ centerView = pos1; sideView = sideTail; radiusToFrag = tailRadius; tEdge = 0.; sideCoord = 1.;
+            gl_Position = u_projMatrix * vec4(pos1 + tailRadius * sideTail, 1.); EmitVertex();
+            emitInd = 2;
+            ${ GEOM_PER_EMIT }$ centerView = pos2; sideView = sideTip; radiusToFrag = tipRadius; tEdge = 1.; sideCoord = -1.;
+            gl_Position = u_projMatrix * vec4(pos2 - tipRadius * sideTip, 1.); EmitVertex();
+            ${ GEOM_PER_EMIT }$ centerView = pos2; sideView = sideTip; radiusToFrag = tipRadius; tEdge = 1.; sideCoord = 1.;
+            gl_Position = u_projMatrix * vec4(pos2 + tipRadius * sideTip, 1.); EmitVertex();
+
+            EndPrimitive();
+        }
+)"
+};
+
+const ShaderStageSpecification RIBBON_TUBE_FRAG_SHADER = {
+    
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    {
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+    }, 
+
+    {}, // attributes
+    {}, // textures 
+ 
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        uniform mat4 u_projMatrix;
+        in vec3 centerView;
+        in vec3 sideView;
+        in float sideCoord;
+        in float radiusToFrag;
+        in float tEdge;
+        layout(location = 0) out vec4 outputF;
+
+        float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+
+        ${ FRAG_DECLARATIONS }$
+
+        void main()
+        {
+           vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+
+           // Reconstruct the point on the tube surface from the position across the quad
+           vec3 toCamera = normalize(-centerView);
+           vec3 side = normalize(sideView - dot(sideView, toCamera) * toCamera);
+           float s = clamp(sideCoord, -1., 1.);
+           vec3 nHit = normalize(s * side + sqrt(max(1. - s * s, 0.)) * toCamera);
+           vec3 pHit = centerView + radiusToFrag * nHit;
+           float depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
+
+           ${ GLOBAL_FRAGMENT_FILTER_PREP }$
+           ${ GLOBAL_FRAGMENT_FILTER }$
+           
+           // Set depth (expensive!)
+           gl_FragDepth = depth;
+
+           // Shading
+           ${ GENERATE_SHADE_VALUE }$
+           ${ GENERATE_SHADE_COLOR }$
+
+           // Lighting
+           vec3 shadeNormal = nHit;
+           ${ GENERATE_LIT_COLOR }$
+
+           // Set alpha
+           float alphaOut = 1.0;
+           ${ GENERATE_ALPHA }$
+
+           // Write output
+           outputF = vec4(litColor, alphaOut);
+        }
+)"
+};
+
+// == Rules for tubes. Vertex attributes are per-node, and emitInd is the node ([1] tail, [2] tip) of each vertex.
+
+// per-node values, interpolated along the tube
+const ShaderReplacementRule TUBE_PROPAGATE_BLEND_VALUE (
+    /* rule name */ "TUBE_PROPAGATE_BLEND_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value;
+          out float a_valueToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueToGeom = a_value;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in float a_valueToGeom[];
+          out float a_valueToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_valueToFrag = a_valueToGeom[emitInd]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_valueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+// per-segment values, stored at the tail node of each segment
+const ShaderReplacementRule TUBE_PROPAGATE_VALUE (
+    /* rule name */ "TUBE_PROPAGATE_VALUE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value;
+          out float a_valueToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueToGeom = a_value;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in float a_valueToGeom[];
+          flat out float a_valueToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_valueToFrag = a_valueToGeom[1]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in float a_valueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_valueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule TUBE_PROPAGATE_BLEND_COLOR (
+    /* rule name */ "TUBE_PROPAGATE_BLEND_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color;
+          out vec3 a_colorToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToGeom = a_color;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in vec3 a_colorToGeom[];
+          out vec3 a_colorToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorToFrag = a_colorToGeom[emitInd]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule TUBE_PROPAGATE_COLOR (
+    /* rule name */ "TUBE_PROPAGATE_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color;
+          out vec3 a_colorToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToGeom = a_color;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in vec3 a_colorToGeom[];
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorToFrag = a_colorToGeom[1]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+// the ends of each segment pick as their nodes (offset from u_pickStart by node index) and the middle as the edge
+// (offset from u_edgePickStart by the edge index stored at its tail node)
+const ShaderReplacementRule TUBE_PROPAGATE_PICK (
+    /* rule name */ "TUBE_PROPAGATE_PICK",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          uniform uvec3 u_edgePickStart;
+          in uint a_nodeEdgeInd;
+          out vec3 a_nodeColorToGeom;
+          out vec3 a_edgeColorToGeom;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_nodeColorToGeom = pickIndexToColor(u_pickStart, uint(gl_VertexID));
+          a_edgeColorToGeom = pickIndexToColor(u_edgePickStart, a_nodeEdgeInd);
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in vec3 a_nodeColorToGeom[];
+          in vec3 a_edgeColorToGeom[];
+          flat out vec3 a_colorTailToFrag;
+          flat out vec3 a_colorTipToFrag;
+          flat out vec3 a_colorEdgeToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorTailToFrag = a_nodeColorToGeom[1]; 
+          a_colorTipToFrag = a_nodeColorToGeom[2]; 
+          a_colorEdgeToFrag = a_edgeColorToGeom[1]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorTailToFrag;
+          flat in vec3 a_colorTipToFrag;
+          flat in vec3 a_colorEdgeToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float endWidth = 0.2;
+          vec3 shadeColor;
+          if(tEdge < endWidth) {
+            shadeColor = a_colorTailToFrag;
+          } else if (tEdge < (1.0f - endWidth)) {
+            shadeColor = a_colorEdgeToFrag;
+          } else {
+            shadeColor = a_colorTipToFrag;
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+      {"u_edgePickStart", RenderDataType::Vector3UInt},
+    },
+    /* attributes */ {
+      {"a_nodeEdgeInd", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+// the element index for subsets (see SUBSET_VISIBLE_CULL) is the edge index stored at the segment's tail node
+const ShaderReplacementRule TUBE_PROPAGATE_SUBSET_INDEX (
+    /* rule name */ "TUBE_PROPAGATE_SUBSET_INDEX",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_subsetIndex;
+          flat out uint a_subsetIndexToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToGeom = a_subsetIndex;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToGeom[];
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_subsetIndexToFrag = a_subsetIndexToGeom[1]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_subsetIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule TUBE_CULLPOS_FROM_MID (
+    /* rule name */ "TUBE_CULLPOS_FROM_MID",
+    { /* replacement sources */
+      {"GEOM_DECLARATIONS", R"(
+          flat out vec3 a_segmentMidToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_segmentMidToFrag = 0.5 * (pos1 + pos2); 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_segmentMidToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          vec3 cullPos = a_segmentMidToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule TUBE_VARIABLE_SIZE (
+    /* rule name */ "TUBE_VARIABLE_SIZE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_nodeRadius;
+          out float a_nodeRadiusToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_nodeRadiusToGeom = a_nodeRadius;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in float a_nodeRadiusToGeom[];
+        )"},
+      {"TUBE_SET_RADIUS_GEOM", R"(
+          tailRadius *= a_nodeRadiusToGeom[1];
+          tipRadius *= a_nodeRadiusToGeom[2];
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_nodeRadius", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
 // clang-format on
 
 } // namespace backend_openGL3_glfw
@@ -17,6 +17,15 @@ const ShaderReplacementRule GLSL_VERSION(
     }
 );
 
+// compute shaders are core in GLSL 4.30, see Engine::supportsComputeShaders()
+const ShaderReplacementRule GLSL_VERSION_COMPUTE(
+    /* rule name */ "GLSL_VERSION_COMPUTE",
+    /* replacement sources */
+    {
+        {"GLSL_VERSION", "#version 430 core"},
+    }
+);
+
 // possibly discards a fragment due to global rules
 const ShaderReplacementRule GLOBAL_FRAGMENT_FILTER(
     /* rule name */ "GLOBAL_FRAGMENT_FILTER",
@@ -54,6 +63,28 @@ const ShaderReplacementRule LIGHT_MATCAP (
     }
 );
 
+// write the unlit color and the shading normal in to the G-buffer, the lighting happens afterward in DEFERRED_LIGHTING
+// input: vec3 albedoColor, vec3 shadeNormal;
+// output: vec3 litColor (just the albedo)
+const ShaderReplacementRule LIGHT_DEFERRED (
+    /* rule name */ "LIGHT_DEFERRED",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform float u_materialIndex;
+          layout(location = 1) out vec4 outputNormalMaterial;
+        )"},
+      {"GENERATE_LIT_COLOR", R"(
+          vec3 litColor = albedoColor;
+          outputNormalMaterial = vec4(normalize(shadeNormal), u_materialIndex + 1.);
+      )"}
+    },
+    /* uniforms */ {
+      {"u_materialIndex", RenderDataType::Float},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 // "light" by just copying the value 
 // input: vec3 albedoColor;
 // output: vec3 litColor after lighting
@@ -149,6 +180,33 @@ const ShaderReplacementRule SHADE_COLORMAP_ANGULAR2(
     }
 );
 
+// input: uint shadeLabelIndex
+// output: vec3 albedoColor
+// The table is a 2D texture with a row of u_labelTableWidth entries at a time (to stay under 1D texture size limits),
+// each holding the label's color, and alpha 0 if the label is hidden.
+const ShaderReplacementRule SHADE_LABEL_TABLE(
+    /* rule name */ "SHADE_LABEL_TABLE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform uint u_labelTableWidth;
+          uniform sampler2D t_labelTable;
+        )"},
+      {"GENERATE_SHADE_COLOR", R"(
+          ivec2 labelTexel = ivec2(int(shadeLabelIndex % u_labelTableWidth), int(shadeLabelIndex / u_labelTableWidth));
+          vec4 labelEntry = texelFetch(t_labelTable, labelTexel, 0);
+          if(labelEntry.a == 0.) discard;
+          vec3 albedoColor = labelEntry.rgb;
+      )"}
+    },
+    /* uniforms */ {
+        {"u_labelTableWidth", RenderDataType::UInt},
+    },
+    /* attributes */ {},
+    /* textures */ {
+        {"t_labelTable", 2}
+    }
+);
+
 const ShaderReplacementRule SHADE_GRID_VALUE2 (
     /* rule name */ "SHADE_GRID_VALUE2",
     { /* replacement sources */
@@ -311,29 +369,94 @@ const ShaderReplacementRule CULL_POS_FROM_VIEW (
 );
 
 
-ShaderReplacementRule generateSlicePlaneRule(std::string uniquePostfix) {
-
-  std::string centerUniformName = "u_slicePlaneCenter_" + uniquePostfix;
-  std::string normalUniformName = "u_slicePlaneNormal_" + uniquePostfix;
-
-  // This takes what is otherwise a simple rule, and substitues uniquely named uniforms so that we can have multiple slice planes
-  ShaderReplacementRule slicePlaneRule (
-      /* rule name */ "SLICE_PLANE_CULL_" + uniquePostfix,
-      { /* replacement sources */
-        {"FRAG_DECLARATIONS", "uniform vec3 " + centerUniformName + "; uniform vec3 " + normalUniformName + ";"},
-        {"GLOBAL_FRAGMENT_FILTER", 
-         "if(dot(cullPos, " + normalUniformName + ") < dot( " + centerUniformName + " , " + normalUniformName + ")) { discard; }"}
-      },
-      /* uniforms */ {
-        {centerUniformName, RenderDataType::Vector3Float},
-        {normalUniformName, RenderDataType::Vector3Float},
-      },
-      /* attributes */ {},
-      /* textures */ {}
-  );
-
-  return slicePlaneRule;
-}
+// Thresholding by a scalar, which a structure-specific rule provides as thresholdValue in GLOBAL_FRAGMENT_FILTER_PREP
+const ShaderReplacementRule THRESHOLD_CULL (
+    /* rule name */ "THRESHOLD_CULL",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+        uniform float u_thresholdLow;
+        uniform float u_thresholdHigh;
+      )"},
+      {"GLOBAL_FRAGMENT_FILTER", R"(
+        if(thresholdValue < u_thresholdLow || thresholdValue > u_thresholdHigh) { discard; }
+      )"},
+    },
+    /* uniforms */ {
+      {"u_thresholdLow", RenderDataType::Float},
+      {"u_thresholdHigh", RenderDataType::Float},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+// Element subsets (see Structure::setVisibleSubset()), which a structure-specific rule provides as subsetIndex in
+// GLOBAL_FRAGMENT_FILTER_PREP. The masks hold one bit per element.
+const ShaderReplacementRule SUBSET_VISIBLE_CULL (
+    /* rule name */ "SUBSET_VISIBLE_CULL",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+        uniform usamplerBuffer t_visibleSubset;
+        bool subsetMaskContains(usamplerBuffer mask, uint i);
+      )"},
+      {"GLOBAL_FRAGMENT_FILTER", R"(
+        if(!subsetMaskContains(t_visibleSubset, subsetIndex)) { discard; }
+      )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_visibleSubset", 1},
+    }
+);
+
+// (not for pick programs, whose colors it would change)
+const ShaderReplacementRule SUBSET_HIGHLIGHT (
+    /* rule name */ "SUBSET_HIGHLIGHT",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+        uniform usamplerBuffer t_highlightedSubset;
+        uniform vec3 u_subsetHighlightColor;
+        bool subsetMaskContains(usamplerBuffer mask, uint i);
+      )"},
+      {"GENERATE_LIT_COLOR", R"(
+        if(subsetMaskContains(t_highlightedSubset, subsetIndex)) {
+          litColor = mix(litColor, u_subsetHighlightColor, 0.6);
+        }
+      )"},
+    },
+    /* uniforms */ {
+      {"u_subsetHighlightColor", RenderDataType::Vector3Float},
+    },
+    /* attributes */ {},
+    /* textures */ {
+      {"t_highlightedSubset", 1},
+    }
+);
+
+// The planes come from the frame uniform block (see Engine::updateFrameUniforms()), so adding, moving, or toggling
+// planes never changes the program. Bit i of the mask skips plane i, for structures which ignore it.
+const ShaderReplacementRule SLICE_PLANE_CULL (
+    /* rule name */ "SLICE_PLANE_CULL",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", "uniform vec4 u_slicePlaneCenters[" + std::to_string(maxSlicePlanes) + "];\n" +
+                            "uniform vec4 u_slicePlaneNormals[" + std::to_string(maxSlicePlanes) + "];\n" + R"(
+        uniform int u_slicePlaneCount;
+        uniform uint u_slicePlaneIgnoreMask;
+      )"},
+      {"GLOBAL_FRAGMENT_FILTER", R"(
+        for(int iSlicePlane = 0; iSlicePlane < u_slicePlaneCount; iSlicePlane++) {
+          if((u_slicePlaneIgnoreMask & (1u << uint(iSlicePlane))) != 0u) continue;
+          vec3 sliceNormal = u_slicePlaneNormals[iSlicePlane].xyz;
+          if(dot(cullPos, sliceNormal) < dot(u_slicePlaneCenters[iSlicePlane].xyz, sliceNormal)) { discard; }
+        }
+      )"},
+    },
+    /* uniforms */ {
+      {"u_slicePlaneIgnoreMask", RenderDataType::UInt},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
 
 // clang-format on
 
@@ -0,0 +1,258 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+
+#include "polyscope/render/opengl/shaders/sort_shaders.h"
+
+namespace polyscope {
+namespace render {
+namespace backend_openGL3_glfw {
+
+// clang-format off
+
+const ShaderStageSpecification DEPTH_SORT_KEYS_COMPUTE_SHADER = {
+
+    ShaderStageType::Compute,
+
+    // uniforms
+    {
+        {"u_count", RenderDataType::UInt},
+        {"u_depthRow", RenderDataType::Vector4Float},
+    },
+
+    {}, // attributes
+
+    {}, // textures
+
+    // source
+R"(
+      ${ GLSL_VERSION }$
+      layout(local_size_x = 256) in;
+
+      uniform uint u_count;
+      uniform vec4 u_depthRow;
+      layout(std430) buffer b_positions { float positions[]; };
+      layout(std430) buffer b_keys { uint keys[]; };
+      layout(std430) buffer b_values { uint values[]; };
+
+      void main() {
+        uint i = (gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x) * 256u + gl_LocalInvocationID.x;
+        if (i >= u_count) return;
+
+        vec3 p = vec3(positions[3u * i], positions[3u * i + 1u], positions[3u * i + 2u]);
+        float z = dot(u_depthRow.xyz, p) + u_depthRow.w;
+
+        // flip the bits so that the keys sort as unsigned integers in the order of the floats
+        uint bits = floatBitsToUint(z);
+        keys[i] = (bits & 0x80000000u) != 0u ? ~bits : (bits | 0x80000000u);
+        values[i] = i;
+      }
+)",
+
+    // storage buffers
+    {
+        {"b_positions", RenderDataType::Vector3Float},
+        {"b_keys", RenderDataType::UInt},
+        {"b_values", RenderDataType::UInt},
+    }
+};
+
+const ShaderStageSpecification RADIX_SORT_COUNT_COMPUTE_SHADER = {
+
+    ShaderStageType::Compute,
+
+    // uniforms
+    {
+        {"u_count", RenderDataType::UInt},
+        {"u_shift", RenderDataType::UInt},
+        {"u_tileCount", RenderDataType::UInt},
+    },
+
+    {}, // attributes
+
+    {}, // textures
+
+    // source
+R"(
+      ${ GLSL_VERSION }$
+      layout(local_size_x = 256) in;
+
+      uniform uint u_count;
+      uniform uint u_shift;
+      uniform uint u_tileCount;
+      layout(std430) buffer b_keys { uint keys[]; };
+      layout(std430) buffer b_histogram { uint histogram[]; }; // [digit * u_tileCount + tile]
+
+      shared uint counts[16];
+
+      void main() {
+        uint tile = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+        if (tile >= u_tileCount) return;
+        uint t = gl_LocalInvocationID.x;
+
+        if (t < 16u) counts[t] = 0u;
+        barrier();
+
+        uint start = tile * 1024u + 4u * t;
+        for (uint j = 0u; j < 4u; j++) {
+          if (start + j < u_count) atomicAdd(counts[(keys[start + j] >> u_shift) & 15u], 1u);
+        }
+        barrier();
+
+        if (t < 16u) histogram[t * u_tileCount + tile] = counts[t];
+      }
+)",
+
+    // storage buffers
+    {
+        {"b_keys", RenderDataType::UInt},
+        {"b_histogram", RenderDataType::UInt},
+    }
+};
+
+const ShaderStageSpecification RADIX_SORT_SCAN_COMPUTE_SHADER = {
+
+    ShaderStageType::Compute,
+
+    // uniforms
+    {
+        {"u_length", RenderDataType::UInt},
+    },
+
+    {}, // attributes
+
+    {}, // textures
+
+    // source
+R"(
+      ${ GLSL_VERSION }$
+      layout(local_size_x = 1024) in;
+
+      uniform uint u_length;
+      layout(std430) buffer b_histogram { uint histogram[]; };
+
+      shared uint sums[1024];
+
+      // Exclusive prefix sum of the whole histogram, in a single work group: each thread sums a contiguous chunk, the
+      // chunk sums are scanned, then each thread writes the prefix sums of its chunk
+      void main() {
+        uint t = gl_LocalInvocationID.x;
+        uint chunk = (u_length + 1023u) / 1024u;
+        uint start = min(t * chunk, u_length);
+        uint end = min(start + chunk, u_length);
+
+        uint sum = 0u;
+        for (uint i = start; i < end; i++) sum += histogram[i];
+        sums[t] = sum;
+        barrier();
+
+        if (t == 0u) {
+          uint total = 0u;
+          for (uint k = 0u; k < 1024u; k++) {
+            uint s = sums[k];
+            sums[k] = total;
+            total += s;
+          }
+        }
+        barrier();
+
+        uint offset = sums[t];
+        for (uint i = start; i < end; i++) {
+          uint c = histogram[i];
+          histogram[i] = offset;
+          offset += c;
+        }
+      }
+)",
+
+    // storage buffers
+    {
+        {"b_histogram", RenderDataType::UInt},
+    }
+};
+
+const ShaderStageSpecification RADIX_SORT_SCATTER_COMPUTE_SHADER = {
+
+    ShaderStageType::Compute,
+
+    // uniforms
+    {
+        {"u_count", RenderDataType::UInt},
+        {"u_shift", RenderDataType::UInt},
+        {"u_tileCount", RenderDataType::UInt},
+    },
+
+    {}, // attributes
+
+    {}, // textures
+
+    // source
+R"(
+      ${ GLSL_VERSION }$
+      layout(local_size_x = 256) in;
+
+      uniform uint u_count;
+      uniform uint u_shift;
+      uniform uint u_tileCount;
+      layout(std430) buffer b_keysIn { uint keysIn[]; };
+      layout(std430) buffer b_valuesIn { uint valuesIn[]; };
+      layout(std430) buffer b_keysOut { uint keysOut[]; };
+      layout(std430) buffer b_valuesOut { uint valuesOut[]; };
+      layout(std430) buffer b_histogram { uint histogram[]; }; // scanned, [digit * u_tileCount + tile]
+
+      // ranks[d * 256 + t]: the number of keys with digit d in the tile before those of thread t
+      shared uint ranks[16 * 256];
+
+      void main() {
+        uint tile = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+        if (tile >= u_tileCount) return;
+        uint t = gl_LocalInvocationID.x;
+        uint start = tile * 1024u + 4u * t;
+
+        uint counts[16];
+        for (uint d = 0u; d < 16u; d++) counts[d] = 0u;
+        for (uint j = 0u; j < 4u; j++) {
+          if (start + j < u_count) counts[(keysIn[start + j] >> u_shift) & 15u]++;
+        }
+        for (uint d = 0u; d < 16u; d++) ranks[d * 256u + t] = counts[d];
+        barrier();
+
+        if (t < 16u) {
+          uint sum = 0u;
+          for (uint k = 0u; k < 256u; k++) {
+            uint c = ranks[t * 256u + k];
+            ranks[t * 256u + k] = sum;
+            sum += c;
+          }
+        }
+        barrier();
+
+        // Keys keep their order within each digit, so the sort is stable
+        for (uint d = 0u; d < 16u; d++) counts[d] = 0u;
+        for (uint j = 0u; j < 4u; j++) {
+          uint i = start + j;
+          if (i >= u_count) break;
+          uint key = keysIn[i];
+          uint d = (key >> u_shift) & 15u;
+          uint dst = histogram[d * u_tileCount + tile] + ranks[d * 256u + t] + counts[d];
+          counts[d]++;
+          keysOut[dst] = key;
+          valuesOut[dst] = valuesIn[i];
+        }
+      }
+)",
+
+    // storage buffers
+    {
+        {"b_keysIn", RenderDataType::UInt},
+        {"b_valuesIn", RenderDataType::UInt},
+        {"b_keysOut", RenderDataType::UInt},
+        {"b_valuesOut", RenderDataType::UInt},
+        {"b_histogram", RenderDataType::UInt},
+    }
+};
+
+// clang-format on
+
+} // namespace backend_openGL3_glfw
+} // namespace render
+} // namespace polyscope
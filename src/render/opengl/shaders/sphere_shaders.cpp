@@ -50,6 +50,8 @@ const ShaderStageSpecification FLEX_SPHERE_GEOM_SHADER = {
     // uniforms
     {
         {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_viewportDim", RenderDataType::Vector2Float},
+        {"u_impostorFallbackPixelSize", RenderDataType::Float},
         {"u_pointRadius", RenderDataType::Float},
     }, 
 
@@ -67,12 +69,16 @@ R"(
         layout(triangle_strip, max_vertices=4) out;
         in vec4 position_tip[];
         uniform mat4 u_projMatrix;
+        uniform vec2 u_viewportDim;
+        uniform float u_impostorFallbackPixelSize;
         uniform float u_pointRadius;
         out vec3 sphereCenterView;
+        flat out float sphereFlat;
 
         ${ GEOM_DECLARATIONS }$
 
         void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+        float projectedPixelRadius(mat4 projMat, vec2 viewportDim, vec4 centerView, float radius);
 
         void main() {
            
@@ -89,6 +95,17 @@ R"(
             vec4 center = u_projMatrix * (gl_in[0].gl_Position + vec4(dirToCam, 0.) * pointRadius);
             vec4 dx = u_projMatrix * (vec4(basisX, 0.) * pointRadius);
             vec4 dy = u_projMatrix * (vec4(basisY, 0.) * pointRadius);
+
+            // Spheres smaller than about a pixel are drawn as a flat pixel-sized quad, which the fragment shader does
+            // not raycast
+            float sphereFlatVal = 0.;
+            float pixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, gl_in[0].gl_Position, pointRadius);
+            if(2. * pixelRadius < u_impostorFallbackPixelSize) {
+              sphereFlatVal = 1.;
+              dx = vec4(center.w / u_viewportDim.x, 0., 0., 0.);
+              dy = vec4(0., center.w / u_viewportDim.y, 0., 0.);
+            }
+
             vec4 p1 = center - dx - dy;
             vec4 p2 = center + dx - dy;
             vec4 p3 = center - dx + dy;
@@ -99,10 +116,10 @@ R"(
             vec3 sphereCenterViewVal = gl_in[0].gl_Position.xyz / gl_in[0].gl_Position.w;
     
             // Emit the vertices as a triangle strip
-            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; gl_Position = p1; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; gl_Position = p2; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; gl_Position = p3; EmitVertex(); 
-            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; gl_Position = p4; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; sphereFlat = sphereFlatVal; gl_Position = p1; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; sphereFlat = sphereFlatVal; gl_Position = p2; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; sphereFlat = sphereFlatVal; gl_Position = p3; EmitVertex(); 
+            ${ GEOM_PER_EMIT }$ sphereCenterView = sphereCenterViewVal; sphereFlat = sphereFlatVal; gl_Position = p4; EmitVertex(); 
     
             EndPrimitive();
 
@@ -132,11 +149,17 @@ const ShaderStageSpecification FLEX_SPHERE_FRAG_SHADER = {
     // source
 R"(
         ${ GLSL_VERSION }$
+        // The ray hit is never nearer than the proxy geometry, so declaring that keeps early depth testing on
+        #ifdef GL_ARB_conservative_depth
+        #extension GL_ARB_conservative_depth : enable
+        layout(depth_greater) out float gl_FragDepth;
+        #endif
         uniform mat4 u_projMatrix; 
         uniform mat4 u_invProjMatrix;
         uniform vec4 u_viewport;
         uniform float u_pointRadius;
         in vec3 sphereCenterView;
+        flat in float sphereFlat;
         layout(location = 0) out vec4 outputF;
 
         float LARGE_FLOAT();
@@ -156,15 +179,23 @@ R"(
            float pointRadius = u_pointRadius;
            ${ SPHERE_SET_POINT_RADIUS_FRAG }$
 
-           // Raycast to the sphere 
+           // Raycast to the sphere, unless it is drawn flat (then it covers less than a pixel, so the point nearest the
+           // camera stands in for all of it)
            float tHit;
            vec3 pHit;
            vec3 nHit;
-           bool hit = raySphereIntersection(vec3(0., 0., 0), viewRay, sphereCenterView, pointRadius, tHit, pHit, nHit);
-           if(tHit >= LARGE_FLOAT()) {
-              discard;
+           float depth;
+           if(sphereFlat > 0.5) {
+              nHit = normalize(-sphereCenterView);
+              pHit = sphereCenterView + pointRadius * nHit;
+              depth = gl_FragCoord.z;
+           } else {
+              bool hit = raySphereIntersection(vec3(0., 0., 0), viewRay, sphereCenterView, pointRadius, tHit, pHit, nHit);
+              if(tHit >= LARGE_FLOAT()) {
+                 discard;
+              }
+              depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
            }
-           float depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
 
            ${ GLOBAL_FRAGMENT_FILTER_PREP }$
            ${ GLOBAL_FRAGMENT_FILTER }$
@@ -350,6 +381,136 @@ R"(
 )"
 };
 
+//  These INSTANCED vertex shaders draw the same billboard quads without a geometry shader, which is slow on some
+//  hardware for very many points. Each point is an instance, drawn as two triangles whose corners come from
+//  a_quadCorner; all other attributes are per-instance. They are paired with the fragment shaders above, and take the
+//  _INSTANCED versions of the rules below.
+
+const ShaderStageSpecification FLEX_SPHERE_INSTANCED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_viewportDim", RenderDataType::Vector2Float},
+        {"u_impostorFallbackPixelSize", RenderDataType::Float},
+        {"u_pointRadius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+        {"a_position", RenderDataType::Vector3Float},
+        {"a_quadCorner", RenderDataType::Vector2Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position;
+        in vec2 a_quadCorner;
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform vec2 u_viewportDim;
+        uniform float u_impostorFallbackPixelSize;
+        uniform float u_pointRadius;
+        out vec3 sphereCenterView;
+        flat out float sphereFlat;
+        
+        ${ VERT_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+        float projectedPixelRadius(mat4 projMat, vec2 viewportDim, vec4 centerView, float radius);
+        
+        void main()
+        {
+            float pointRadius = u_pointRadius;
+            ${ SPHERE_SET_POINT_RADIUS_VERT }$
+
+            // This corner of a billboard quad facing the camera, shifted toward the camera like the geometry shader's
+            vec4 centerView = u_modelView * vec4(a_position, 1.0);
+            vec3 dirToCam = normalize(-centerView.xyz);
+            vec3 basisX;
+            vec3 basisY;
+            buildTangentBasis(dirToCam, basisX, basisY);
+            vec4 center = u_projMatrix * (centerView + vec4(dirToCam, 0.) * pointRadius);
+            vec4 dx = u_projMatrix * (vec4(basisX, 0.) * pointRadius);
+            vec4 dy = u_projMatrix * (vec4(basisY, 0.) * pointRadius);
+
+            // Spheres smaller than about a pixel are drawn flat, as in the geometry shader
+            sphereFlat = 0.;
+            float pixelRadius = projectedPixelRadius(u_projMatrix, u_viewportDim, centerView, pointRadius);
+            if(2. * pixelRadius < u_impostorFallbackPixelSize) {
+              sphereFlat = 1.;
+              dx = vec4(center.w / u_viewportDim.x, 0., 0., 0.);
+              dy = vec4(0., center.w / u_viewportDim.y, 0., 0.);
+            }
+
+            gl_Position = center + a_quadCorner.x * dx + a_quadCorner.y * dy;
+            sphereCenterView = centerView.xyz / centerView.w;
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+const ShaderStageSpecification FLEX_POINTQUAD_INSTANCED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_pointRadius", RenderDataType::Float},
+    }, 
+
+    // attributes
+    {
+        {"a_position", RenderDataType::Vector3Float},
+        {"a_quadCorner", RenderDataType::Vector2Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position;
+        in vec2 a_quadCorner;
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform float u_pointRadius;
+        
+        ${ VERT_DECLARATIONS }$
+
+        void buildTangentBasis(vec3 unitNormal, out vec3 basisX, out vec3 basisY);
+        
+        void main()
+        {
+            float pointRadius = u_pointRadius;
+            ${ SPHERE_SET_POINT_RADIUS_VERT }$
+
+            // This corner of a billboard quad facing the camera
+            vec4 centerView = u_modelView * vec4(a_position, 1.0);
+            vec3 dirToCam = normalize(-centerView.xyz);
+            vec3 basisX;
+            vec3 basisY;
+            buildTangentBasis(dirToCam, basisX, basisY);
+            vec4 center = u_projMatrix * centerView;
+            vec4 dx = u_projMatrix * (vec4(basisX, 0.) * pointRadius);
+            vec4 dy = u_projMatrix * (vec4(basisY, 0.) * pointRadius);
+            gl_Position = center + a_quadCorner.x * dx + a_quadCorner.y * dy;
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
 
 // == Rules
 
@@ -446,6 +607,230 @@ const ShaderReplacementRule SPHERE_PROPAGATE_COLOR (
     /* textures */ {}
 );
 
+// As SPHERE_PROPAGATE_COLOR, from 8-bit colors packed in a uint (see packColorRGBA8())
+const ShaderReplacementRule SPHERE_PROPAGATE_COLOR_PACKED (
+    /* rule name */ "SPHERE_PROPAGATE_COLOR_PACKED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_colorPacked;
+          out vec3 a_colorToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToGeom = vec3(float(a_colorPacked & 0xFFu), float((a_colorPacked >> 8) & 0xFFu),
+                               float((a_colorPacked >> 16) & 0xFFu)) / 255.;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in vec3 a_colorToGeom[];
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorToFrag = a_colorToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_colorPacked", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_LABEL (
+    /* rule name */ "SPHERE_PROPAGATE_LABEL",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_labelIndex;
+          flat out uint a_labelIndexToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_labelIndexToGeom = a_labelIndex;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          flat in uint a_labelIndexToGeom[];
+          flat out uint a_labelIndexToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_labelIndexToFrag = a_labelIndexToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_labelIndexToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          uint shadeLabelIndex = a_labelIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_labelIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_THRESHOLD (
+    /* rule name */ "SPHERE_PROPAGATE_THRESHOLD",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_thresholdValue;
+          out float a_thresholdValueToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_thresholdValueToGeom = a_thresholdValue;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in float a_thresholdValueToGeom[];
+          flat out float a_thresholdValueToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_thresholdValueToFrag = a_thresholdValueToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in float a_thresholdValueToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          float thresholdValue = a_thresholdValueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_thresholdValue", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+// the element index for subsets (see SUBSET_VISIBLE_CULL) is the point index, or comes from the draw order buffer
+const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX (
+    /* rule name */ "SPHERE_PROPAGATE_SUBSET_INDEX",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          flat out uint a_subsetIndexToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToGeom = uint(gl_VertexID);
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToGeom[];
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_subsetIndexToFrag = a_subsetIndexToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE (
+    /* rule name */ "SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_subsetIndex;
+          flat out uint a_subsetIndexToGeom;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToGeom = a_subsetIndex;
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToGeom[];
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_subsetIndexToFrag = a_subsetIndexToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_subsetIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+// pick colors computed from the point index, offset from u_pickStart
+const ShaderReplacementRule SPHERE_PROPAGATE_PICK (
+    /* rule name */ "SPHERE_PROPAGATE_PICK",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          out vec3 a_colorToGeom;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToGeom = pickIndexToColor(u_pickStart, uint(gl_VertexID));
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in vec3 a_colorToGeom[];
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorToFrag = a_colorToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+// same as above, but for points which are drawn out of order; a_pickIndex gives the index of each
+const ShaderReplacementRule SPHERE_PROPAGATE_PICK_INDEXED (
+    /* rule name */ "SPHERE_PROPAGATE_PICK_INDEXED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          in uint a_pickIndex;
+          out vec3 a_colorToGeom;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToGeom = pickIndexToColor(u_pickStart, a_pickIndex);
+        )"},
+      {"GEOM_DECLARATIONS", R"(
+          in vec3 a_colorToGeom[];
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"GEOM_PER_EMIT", R"(
+          a_colorToFrag = a_colorToGeom[0]; 
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+    },
+    /* attributes */ {
+      {"a_pickIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
 const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER(
     /* rule name */ "SPHERE_CULLPOS_FROM_CENTER",
     { /* replacement sources */
@@ -518,6 +903,301 @@ const ShaderReplacementRule SPHERE_VARIABLE_SIZE (
     /* textures */ {}
 );
 
+// == Rules for the instanced pipeline
+// Like the ones above, but the vertex shader passes values straight to the fragment shader, and the point index is the
+// instance ID.
+
+const ShaderReplacementRule SPHERE_PROPAGATE_VALUE_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_VALUE_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_value;
+          out float a_valueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_valueToFrag = a_value;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_valueToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = a_valueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_VALUE2_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_VALUE2_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec2 a_value2;
+          out vec2 a_value2ToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_value2ToFrag = a_value2;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec2 a_value2ToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec2 shadeValue2 = a_value2ToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_value2", RenderDataType::Vector2Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_COLOR_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_COLOR_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_color;
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = a_color;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_color", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_COLOR_PACKED_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_COLOR_PACKED_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_colorPacked;
+          flat out vec3 a_colorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = vec3(float(a_colorPacked & 0xFFu), float((a_colorPacked >> 8) & 0xFFu),
+                               float((a_colorPacked >> 16) & 0xFFu)) / 255.;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_colorPacked", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_LABEL_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_LABEL_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_labelIndex;
+          flat out uint a_labelIndexToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_labelIndexToFrag = a_labelIndex;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_labelIndexToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          uint shadeLabelIndex = a_labelIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_labelIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_THRESHOLD_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_THRESHOLD_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_thresholdValue;
+          flat out float a_thresholdValueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_thresholdValueToFrag = a_thresholdValue;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in float a_thresholdValueToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          float thresholdValue = a_thresholdValueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_thresholdValue", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_SUBSET_INDEX_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToFrag = uint(gl_InstanceID);
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_SUBSET_INDEX_FROM_ATTRIBUTE_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_subsetIndex;
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToFrag = a_subsetIndex;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_subsetIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_PICK_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_PICK_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          flat out vec3 a_colorToFrag;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = pickIndexToColor(u_pickStart, uint(gl_InstanceID));
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_PROPAGATE_PICK_INDEXED_INSTANCED (
+    /* rule name */ "SPHERE_PROPAGATE_PICK_INDEXED_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          in uint a_pickIndex;
+          flat out vec3 a_colorToFrag;
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = pickIndexToColor(u_pickStart, a_pickIndex);
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+    },
+    /* attributes */ {
+      {"a_pickIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_CULLPOS_FROM_CENTER_QUAD_INSTANCED(
+    /* rule name */ "SPHERE_CULLPOS_FROM_CENTER_QUAD_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          out vec3 sphereCenterView;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          sphereCenterView = centerView.xyz / centerView.w;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 sphereCenterView;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          vec3 cullPos = sphereCenterView;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule SPHERE_VARIABLE_SIZE_INSTANCED (
+    /* rule name */ "SPHERE_VARIABLE_SIZE_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_pointRadius;
+          out float a_pointRadiusToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_pointRadiusToFrag = a_pointRadius;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_pointRadiusToFrag;
+        )"},
+      {"SPHERE_SET_POINT_RADIUS_VERT", R"(
+          pointRadius *= a_pointRadius;
+        )"},
+      {"SPHERE_SET_POINT_RADIUS_FRAG", R"(
+          pointRadius *= a_pointRadiusToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_pointRadius", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
 // clang-format on
 
 } // namespace backend_openGL3_glfw
@@ -57,6 +57,65 @@ R"(
 )"
 };
 
+// Reads each vertex from a packed uvec3: 16-bit positions quantized over a box (x | y << 16, z | normal.u << 16,
+// normal.v), and an octahedral-encoded normal. Only for indexed drawing, so there are no barycentric coordinates.
+const ShaderStageSpecification FLEX_MESH_COMPRESSED_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_positionQuantMin", RenderDataType::Vector3Float},
+        {"u_positionQuantScale", RenderDataType::Vector3Float},
+    }, 
+
+    // attributes
+    {
+        {"a_vertexCompressed", RenderDataType::Vector3UInt},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+        uniform vec3 u_positionQuantMin;
+        uniform vec3 u_positionQuantScale;
+        
+        in uvec3 a_vertexCompressed;
+        out vec3 a_barycoordToFrag;
+        out vec3 a_vertexNormalToFrag;
+        
+        ${ VERT_DECLARATIONS }$
+        
+        void main()
+        {
+            vec3 a_vertexPositions = u_positionQuantMin + u_positionQuantScale *
+              vec3(float(a_vertexCompressed.x & 0xFFFFu), float(a_vertexCompressed.x >> 16), float(a_vertexCompressed.y & 0xFFFFu));
+
+            vec2 octNormal = vec2(float(a_vertexCompressed.y >> 16), float(a_vertexCompressed.z & 0xFFFFu)) * (2. / 65535.) - 1.;
+            vec3 a_vertexNormals = vec3(octNormal, 1. - abs(octNormal.x) - abs(octNormal.y));
+            if (a_vertexNormals.z < 0.) {
+              vec2 signs = vec2(octNormal.x >= 0. ? 1. : -1., octNormal.y >= 0. ? 1. : -1.);
+              a_vertexNormals.xy = (1. - abs(octNormal.yx)) * signs;
+            }
+            a_vertexNormals = normalize(a_vertexNormals);
+
+            gl_Position = u_projMatrix * u_modelView * vec4(a_vertexPositions,1.);
+            
+            a_vertexNormalToFrag = mat3(u_modelView) * a_vertexNormals;
+            a_barycoordToFrag = vec3(0.);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
 const ShaderStageSpecification FLEX_MESH_FRAG_SHADER = {
     
     ShaderStageType::Fragment,
@@ -223,6 +282,123 @@ const ShaderReplacementRule MESH_PROPAGATE_COLOR (
     /* textures */ {}
 );
 
+// As MESH_PROPAGATE_COLOR, from 8-bit colors packed in a uint (see packColorRGBA8())
+const ShaderReplacementRule MESH_PROPAGATE_COLOR_PACKED (
+    /* rule name */ "MESH_PROPAGATE_COLOR_PACKED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_colorPacked;
+          out vec3 a_colorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_colorToFrag = vec3(float(a_colorPacked & 0xFFu), float((a_colorPacked >> 8) & 0xFFu),
+                               float((a_colorPacked >> 16) & 0xFFu)) / 255.;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_colorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = a_colorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_colorPacked", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+// Face data fetched by primitive ID, one texel per face, rather than expanded out to triangle corners. One of the
+// MESH_FACE_INDEX_* rules defines meshFaceIndex(), the face of the triangle being shaded, and meshFaceTexel() to read a
+// face data texture laid out in rows.
+const ShaderReplacementRule MESH_FACE_INDEX_FROM_PRIMITIVE_ID (
+    /* rule name */ "MESH_FACE_INDEX_FROM_PRIMITIVE_ID",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          vec4 meshFaceTexel(sampler2D t, int ind) {
+            int rowLength = textureSize(t, 0).x;
+            return texelFetch(t, ivec2(ind % rowLength, ind / rowLength), 0);
+          }
+          int meshFaceIndex() { return gl_PrimitiveID; } // each face is a single triangle
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {}
+);
+
+const ShaderReplacementRule MESH_FACE_INDEX_FROM_TRIANGLE_MAP (
+    /* rule name */ "MESH_FACE_INDEX_FROM_TRIANGLE_MAP",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler2D t_triangleFaces;
+          vec4 meshFaceTexel(sampler2D t, int ind) {
+            int rowLength = textureSize(t, 0).x;
+            return texelFetch(t, ivec2(ind % rowLength, ind / rowLength), 0);
+          }
+          int meshFaceIndex() { return int(meshFaceTexel(t_triangleFaces, gl_PrimitiveID).r); }
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_triangleFaces", 2},
+    }
+);
+
+const ShaderReplacementRule MESH_FETCH_FACE_VALUE (
+    /* rule name */ "MESH_FETCH_FACE_VALUE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler2D t_faceValues;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          float shadeValue = meshFaceTexel(t_faceValues, meshFaceIndex()).r;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_faceValues", 2},
+    }
+);
+
+const ShaderReplacementRule MESH_FETCH_FACE_COLOR (
+    /* rule name */ "MESH_FETCH_FACE_COLOR",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler2D t_faceValues;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeColor = meshFaceTexel(t_faceValues, meshFaceIndex()).rgb;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_faceValues", 2},
+    }
+);
+
+// (the transform to view space happens per fragment, since the face is only known there)
+const ShaderReplacementRule MESH_FETCH_FACE_CULLPOS (
+    /* rule name */ "MESH_FETCH_FACE_CULLPOS",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform mat4 u_modelView;
+          uniform sampler2D t_faceCullPos;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          vec3 cullPos = vec3(u_modelView * vec4(meshFaceTexel(t_faceCullPos, meshFaceIndex()).xyz, 1.));
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_faceCullPos", 2},
+    }
+);
+
 const ShaderReplacementRule MESH_PROPAGATE_VALUE2 (
     /* rule name */ "MESH_PROPAGATE_VALUE2",
     { /* replacement sources */
@@ -271,6 +447,172 @@ const ShaderReplacementRule MESH_PROPAGATE_CULLPOS (
     /* textures */ {}
 );
 
+// the element index for subsets (see SUBSET_VISIBLE_CULL): the face of a surface mesh, or the cell of a volume mesh
+const ShaderReplacementRule MESH_PROPAGATE_SUBSET_INDEX (
+    /* rule name */ "MESH_PROPAGATE_SUBSET_INDEX",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_subsetIndex;
+          flat out uint a_subsetIndexToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_subsetIndexToFrag = a_subsetIndex;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in uint a_subsetIndexToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          uint subsetIndex = a_subsetIndexToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_subsetIndex", RenderDataType::UInt},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule MESH_PROPAGATE_THRESHOLD (
+    /* rule name */ "MESH_PROPAGATE_THRESHOLD",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in float a_thresholdValue;
+          out float a_thresholdValueToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_thresholdValueToFrag = a_thresholdValue;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in float a_thresholdValueToFrag;
+        )"},
+      {"GLOBAL_FRAGMENT_FILTER_PREP", R"(
+          float thresholdValue = a_thresholdValueToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_thresholdValue", RenderDataType::Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule MESH_PROPAGATE_VECTOR (
+    /* rule name */ "MESH_PROPAGATE_VECTOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_vector;
+          out vec3 a_vectorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_vectorToFrag = a_vector;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_vectorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeVector = a_vectorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_vector", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule MESH_PROPAGATE_TANGENT_VECTOR (
+    /* rule name */ "MESH_PROPAGATE_TANGENT_VECTOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec2 a_tangentVector;
+          in vec3 a_basisVectorX;
+          in vec3 a_basisVectorY;
+          out vec3 a_vectorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_vectorToFrag = a_tangentVector.x * a_basisVectorX + a_tangentVector.y * a_basisVectorY;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_vectorToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          vec3 shadeVector = a_vectorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_tangentVector", RenderDataType::Vector2Float},
+      {"a_basisVectorX", RenderDataType::Vector3Float},
+      {"a_basisVectorY", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+// input: vec3 shadeVector, in object space
+// output: vec3 albedoColor
+// Line integral convolution: value noise anchored to the surface, averaged along a short straight streak in the
+// direction of the vector at each fragment. The cost is a fixed number of noise lookups per pixel.
+const ShaderReplacementRule MESH_SHADE_LIC (
+    /* rule name */ "MESH_SHADE_LIC",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          out vec3 a_licPositionToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_licPositionToFrag = a_vertexPositions;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          in vec3 a_licPositionToFrag;
+          uniform vec3 u_baseColor;
+          uniform float u_licNoiseFreq;
+          uniform float u_licLength;
+
+          float licHash(vec3 p) {
+            p = fract(p * 0.3183099 + vec3(0.1, 0.2, 0.3));
+            p *= 17.0;
+            return fract(p.x * p.y * p.z * (p.x + p.y + p.z));
+          }
+
+          float licNoise(vec3 x) {
+            vec3 i = floor(x);
+            vec3 f = fract(x);
+            f = f * f * (3. - 2. * f);
+            return mix(mix(mix(licHash(i + vec3(0., 0., 0.)), licHash(i + vec3(1., 0., 0.)), f.x),
+                           mix(licHash(i + vec3(0., 1., 0.)), licHash(i + vec3(1., 1., 0.)), f.x), f.y),
+                       mix(mix(licHash(i + vec3(0., 0., 1.)), licHash(i + vec3(1., 0., 1.)), f.x),
+                           mix(licHash(i + vec3(0., 1., 1.)), licHash(i + vec3(1., 1., 1.)), f.x), f.y), f.z);
+          }
+        )"},
+      {"GENERATE_SHADE_COLOR", R"(
+          vec3 licPos = a_licPositionToFrag * u_licNoiseFreq;
+          float licVecLen = length(shadeVector);
+          float licSum = 0.;
+          if (licVecLen > 0.) {
+            vec3 licDir = shadeVector / licVecLen;
+            const int nLICSamples = 16;
+            for (int iS = 0; iS < nLICSamples; iS++) {
+              float t = (float(iS) / float(nLICSamples - 1) - 0.5) * u_licLength;
+              licSum += licNoise(licPos + t * licDir);
+            }
+            licSum /= float(nLICSamples);
+          } else {
+            licSum = licNoise(licPos);
+          }
+
+          // averaging flattens the noise toward its mean; stretch the contrast back out
+          float licValue = clamp(0.5 + 3. * (licSum - 0.5), 0., 1.);
+          vec3 albedoColor = u_baseColor * mix(0.2, 1., licValue);
+        )"},
+    },
+    /* uniforms */ {
+      {"u_baseColor", RenderDataType::Vector3Float},
+      {"u_licNoiseFreq", RenderDataType::Float},
+      {"u_licLength", RenderDataType::Float},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 const ShaderReplacementRule MESH_WIREFRAME(
     /* rule name */ "MESH_WIREFRAME",
     { /* replacement sources */
@@ -516,6 +858,205 @@ const ShaderReplacementRule MESH_PROPAGATE_PICK_SIMPLE ( // this one does faces
     /* textures */ {}
 );
 
+// Picking with colors computed in the shader from the element indices of each triangle, offset from u_pickStart.
+// Faces and vertices; the halfedge and corner rules below add those elements.
+const ShaderReplacementRule MESH_PICK_FROM_INDICES (
+    /* rule name */ "MESH_PICK_FROM_INDICES",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_faceInd;
+          in uint a_vertexInds[3];
+          flat out uint a_faceIndToFrag;
+          flat out uint a_vertexIndsToFrag[3];
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_faceIndToFrag = a_faceInd;
+          for(int i = 0; i < 3; i++) {
+              a_vertexIndsToFrag[i] = a_vertexInds[i];
+          }
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          uniform uvec3 u_pickStart;
+          uniform uint u_facePickOffset;
+          uniform float u_vertexPickRadius;
+          flat in uint a_faceIndToFrag;
+          flat in uint a_vertexIndsToFrag[3];
+          vec3 pickIndexToColor(uvec3 startDigits, uint offset);
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          // pick shapes are in barycentric 0-1 units
+          vec3 shadeColor = pickIndexToColor(u_pickStart, u_facePickOffset + a_faceIndToFrag);
+          bool pickColorSet = false;
+          for(int i = 0; i < 3; i++) {
+              if(a_barycoordToFrag[i] > 1.0-u_vertexPickRadius) {
+                shadeColor = pickIndexToColor(u_pickStart, a_vertexIndsToFrag[i]);
+                pickColorSet = true;
+              }
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pickStart", RenderDataType::Vector3UInt},
+      {"u_facePickOffset", RenderDataType::UInt},
+      {"u_vertexPickRadius", RenderDataType::Float},
+    },
+    /* attributes */ {
+      {"a_faceInd", RenderDataType::UInt},
+      {"a_vertexInds", RenderDataType::UInt, 3},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule MESH_PICK_CORNERS_FROM_INDICES (
+    /* rule name */ "MESH_PICK_CORNERS_FROM_INDICES",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_cornerInds[3];
+          flat out uint a_cornerIndsToFrag[3];
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          for(int i = 0; i < 3; i++) {
+              a_cornerIndsToFrag[i] = a_cornerInds[i];
+          }
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          uniform uint u_cornerPickOffset;
+          flat in uint a_cornerIndsToFrag[3];
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          for(int i = 0; i < 3; i++) {
+              if(!pickColorSet && a_barycoordToFrag[i] > 1.0-0.25) {
+                shadeColor = pickIndexToColor(u_pickStart, u_cornerPickOffset + a_cornerIndsToFrag[i]);
+                pickColorSet = true;
+              }
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_cornerPickOffset", RenderDataType::UInt},
+    },
+    /* attributes */ {
+      {"a_cornerInds", RenderDataType::UInt, 3},
+    },
+    /* textures */ {}
+);
+
+// halfedges or edges, whichever indices are given; internal edges of triangulated polygons pick as the face
+const ShaderReplacementRule MESH_PICK_HALFEDGES_FROM_INDICES (
+    /* rule name */ "MESH_PICK_HALFEDGES_FROM_INDICES",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in uint a_halfedgeInds[3];
+          in vec3 a_edgeIsReal;
+          flat out uint a_halfedgeIndsToFrag[3];
+          flat out vec3 a_edgeIsRealToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          for(int i = 0; i < 3; i++) {
+              a_halfedgeIndsToFrag[i] = a_halfedgeInds[i];
+          }
+          a_edgeIsRealToFrag = a_edgeIsReal;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          uniform uint u_halfedgePickOffset;
+          flat in uint a_halfedgeIndsToFrag[3];
+          flat in vec3 a_edgeIsRealToFrag;
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          for(int i = 0; i < 3; i++) {
+              float eDist = a_barycoordToFrag[(i+2)%3];
+              if(!pickColorSet && a_edgeIsRealToFrag[i] > 0.5 && eDist < 0.15) {
+                shadeColor = pickIndexToColor(u_pickStart, u_halfedgePickOffset + a_halfedgeIndsToFrag[i]);
+                pickColorSet = true;
+              }
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_halfedgePickOffset", RenderDataType::UInt},
+    },
+    /* attributes */ {
+      {"a_halfedgeInds", RenderDataType::UInt, 3},
+      {"a_edgeIsReal", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+// Each instance applies its own transform before the modelview. Redefining u_modelView means every later use in the
+// vertex stage (positions, normals, cull positions) picks it up; the macro does not expand recursively.
+const ShaderReplacementRule MESH_INSTANCED (
+    /* rule name */ "MESH_INSTANCED",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec4 a_instanceTransform[4];
+          #define u_modelView (u_modelView * mat4(a_instanceTransform[0], a_instanceTransform[1], a_instanceTransform[2], a_instanceTransform[3]))
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_instanceTransform", RenderDataType::Vector4Float, 4},
+    },
+    /* textures */ {}
+);
+
+const ShaderReplacementRule MESH_INSTANCE_COLOR (
+    /* rule name */ "MESH_INSTANCE_COLOR",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          in vec3 a_instanceColor;
+          flat out vec3 a_instanceColorToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_instanceColorToFrag = a_instanceColor;
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          flat in vec3 a_instanceColorToFrag;
+        )"},
+      {"GENERATE_SHADE_COLOR", R"(
+          albedoColor = a_instanceColorToFrag;
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {
+      {"a_instanceColor", RenderDataType::Vector3Float},
+    },
+    /* textures */ {}
+);
+
+// Offsets the pick color from MESH_PICK_FROM_INDICES by instanceID * u_instancePickStride, adding in the base
+// 2^22 digits that pick::indToVec() packs into each channel
+const ShaderReplacementRule MESH_INSTANCED_PICK (
+    /* rule name */ "MESH_INSTANCED_PICK",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          flat out uint a_instanceIDToFrag;
+        )"},
+      {"VERT_ASSIGNMENTS", R"(
+          a_instanceIDToFrag = uint(gl_InstanceID);
+        )"},
+      {"FRAG_DECLARATIONS", R"(
+          uniform uint u_instancePickStride;
+          flat in uint a_instanceIDToFrag;
+          vec3 offsetPickColor(vec3 c, uint offset) {
+            const float factor = 4194304.; // 2^22
+            const uint mask = 4194303u;
+            uint low = uint(round(c.x * factor)) + (offset & mask);
+            uint med = uint(round(c.y * factor)) + (offset >> 22) + (low >> 22);
+            uint high = uint(round(c.z * factor)) + (med >> 22);
+            return vec3(float(low & mask), float(med & mask), float(high)) / factor;
+          }
+        )"},
+      {"GENERATE_SHADE_VALUE", R"(
+          shadeColor = offsetPickColor(shadeColor, a_instanceIDToFrag * u_instancePickStride);
+        )"},
+    },
+    /* uniforms */ {
+      {"u_instancePickStride", RenderDataType::UInt},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 // clang-format on
 
 } // namespace backend_openGL3_glfw
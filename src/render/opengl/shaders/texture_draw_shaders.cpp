@@ -205,6 +205,122 @@ R"(
 )"
 };
 
+const ShaderStageSpecification IMPLICIT_SURFACE_MARCH_FRAG_SHADER = {
+  // Ray march an implicit function through each pixel of the view, with the function itself supplied by a rule
+  // replacing IMPLICIT_FUNCTION (see renderImplicitSurfaceGLSL()). Rays start at the near plane, and are marched in
+  // world space exactly like renderImplicitSurface() does on the CPU.
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_viewMatrix", RenderDataType::Matrix44Float},
+        {"u_invViewMatrix", RenderDataType::Matrix44Float},
+        {"u_transparency", RenderDataType::Float},
+        {"u_missDist", RenderDataType::Float},
+        {"u_hitDist", RenderDataType::Float},
+        {"u_stepFactor", RenderDataType::Float},
+        {"u_stepSize", RenderDataType::Float},
+        {"u_normalSampleEps", RenderDataType::Float},
+        {"u_nMaxSteps", RenderDataType::Int},
+        {"u_sphereMarch", RenderDataType::Int},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { },
+    
+    // source 
+R"(
+
+  ${ GLSL_VERSION }$
+  uniform mat4 u_projMatrix; 
+  uniform mat4 u_invProjMatrix;
+  uniform vec4 u_viewport;
+  uniform mat4 u_viewMatrix;
+  uniform mat4 u_invViewMatrix;
+  uniform float u_transparency;
+  uniform float u_missDist;
+  uniform float u_hitDist;
+  uniform float u_stepFactor;
+  uniform float u_stepSize;
+  uniform float u_normalSampleEps;
+  uniform int u_nMaxSteps;
+  uniform int u_sphereMarch;
+
+  in vec2 tCoord;
+  layout(location = 0) out vec4 outputF;
+    
+  float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+
+  ${ FRAG_DECLARATIONS }$
+
+  ${ IMPLICIT_FUNCTION }$
+
+  void main() {
+
+    // Build the ray through this fragment, in view space then world space
+    vec2 ndc = 2. * (gl_FragCoord.xy - u_viewport.xy) / u_viewport.zw - 1.;
+    vec4 nearH = u_invProjMatrix * vec4(ndc, -1., 1.);
+    vec4 farH = u_invProjMatrix * vec4(ndc, 1., 1.);
+    vec3 viewOrigin = nearH.xyz / nearH.w;
+    vec3 viewDir = normalize(farH.xyz / farH.w - viewOrigin);
+    vec3 rayOrigin = (u_invViewMatrix * vec4(viewOrigin, 1.)).xyz;
+    vec3 rayDir = normalize(mat3(u_invViewMatrix) * viewDir);
+
+    // March along the ray, stopping when the value is small or changes sign
+    float val = implicitFunction(rayOrigin);
+    bool initSign = val < 0.;
+    float rayDepth = 0.;
+    bool hit = false;
+    for (int iStep = 0; iStep < u_nMaxSteps; iStep++) {
+      if (rayDepth > u_missDist) break;
+      if (abs(val) < u_hitDist || (val < 0.) != initSign) {
+        hit = true;
+        break;
+      }
+      rayDepth += (u_sphereMarch == 1) ? abs(val) * u_stepFactor : u_stepSize;
+      val = implicitFunction(rayOrigin + rayDepth * rayDir);
+    }
+    if (!hit) discard;
+    vec3 hitPos = rayOrigin + rayDepth * rayDir;
+
+    // Depth of the hit
+    vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+    gl_FragDepth = fragDepthFromView(u_projMatrix, depthRange, viewOrigin + rayDepth * viewDir);
+
+    // Normal from finite differences on a tetrahedron (see https://iquilezles.org/articles/normalsSDF/)
+    float h = max(rayDepth * u_normalSampleEps, 1e-7);
+    vec3 normalWorld = vec3(1., -1., -1.) * implicitFunction(hitPos + h * vec3(1., -1., -1.)) +
+                       vec3(-1., -1., 1.) * implicitFunction(hitPos + h * vec3(-1., -1., 1.)) +
+                       vec3(-1., 1., -1.) * implicitFunction(hitPos + h * vec3(-1., 1., -1.)) +
+                       vec3(1., 1., 1.) * implicitFunction(hitPos + h * vec3(1., 1., 1.));
+    vec3 normal = normalize(mat3(u_viewMatrix) * normalWorld);
+
+    // Shading
+    ${ GENERATE_SHADE_VALUE }$
+    ${ GENERATE_SHADE_COLOR }$
+
+    // Lighting
+    vec3 shadeNormal = normal;
+    ${ GENERATE_LIT_COLOR }$
+
+     // Set alpha
+    float alphaOut = u_transparency;
+    ${ GENERATE_ALPHA }$
+
+    // Write output
+    outputF = vec4(litColor, alphaOut);
+  }
+)"
+};
+
 const ShaderStageSpecification DOT3_TEXTURE_DRAW_FRAG_SHADER = {
     
     // stage
@@ -341,6 +457,77 @@ R"(
 )"
 };
 
+const ShaderStageSpecification COMPOSITE_WEIGHTED_BLENDED = {
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { {"t_accum", 2}, {"t_revealage", 2} },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_accum;
+      uniform sampler2D t_revealage;
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        vec4 accum = texture(t_accum, tCoord);
+        float coverage = 1. - exp(-texture(t_revealage, tCoord).r);
+        vec3 color = accum.rgb / max(accum.a, 1e-5);
+        outputF = vec4(color * coverage, coverage); // premultiplied, like the peeling composite
+      }
+)"
+};
+
+const ShaderStageSpecification TEMPORAL_ACCUMULATE = {
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+      {"u_weight", RenderDataType::Float},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { {"t_image", 2}, {"t_history", 2} },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_image;
+      uniform sampler2D t_history;
+      uniform float u_weight;
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        // running mean of the samples so far; the first sample ignores the (uninitialized) history
+        vec4 val = texture(t_image, tCoord);
+        if (u_weight < 1.) {
+          val = mix(texture(t_history, tCoord), val, u_weight);
+        }
+        outputF = val;
+      }
+)"
+};
+
 const ShaderStageSpecification DEPTH_COPY = {
     
     // stage
@@ -372,6 +559,193 @@ R"(
 )"
 };
 
+const ShaderStageSpecification AMBIENT_OCCLUSION_ESTIMATE = {
+  // Screen-space ambient occlusion from the depth buffer alone. Writes the unoccluded fraction to red, and the view
+  // depth to green (or 0 for the background) for the depth-aware upsampling in AMBIENT_OCCLUSION_COMPOSITE.
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+      {"u_projMatrix", RenderDataType::Matrix44Float},
+      {"u_invProjMatrix", RenderDataType::Matrix44Float},
+      {"u_radius", RenderDataType::Float},
+      {"u_strength", RenderDataType::Float},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { {"t_depth", 2} },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_depth;
+      uniform mat4 u_projMatrix;
+      uniform mat4 u_invProjMatrix;
+      uniform float u_radius;
+      uniform float u_strength;
+      layout(location = 0) out vec4 outputF;
+
+      vec3 viewPosition(vec2 coord) {
+        float depth = texture(t_depth, coord).r;
+        vec4 pos = u_invProjMatrix * vec4(2. * coord - 1., 2. * depth - 1., 1.);
+        return pos.xyz / pos.w;
+      }
+
+      void main()
+      {
+        float depth = texture(t_depth, tCoord).r;
+        if (depth >= 1.) {
+          outputF = vec4(1., 0., 0., 1.);
+          return;
+        }
+
+        vec3 p = viewPosition(tCoord);
+        vec3 n = normalize(cross(dFdx(p), dFdy(p)));
+
+        // The sampling disk's radius in texture coordinates (for perspective, it shrinks with distance)
+        bool isOrtho = u_projMatrix[3][3] == 1.;
+        vec2 diskRadius = 0.5 * u_radius * vec2(u_projMatrix[0][0], u_projMatrix[1][1]);
+        if (!isOrtho) diskRadius /= -p.z;
+
+        // Golden angle spiral, rotated per-pixel with interleaved gradient noise
+        const int nSamples = 12;
+        float rot = 6.2831853 * fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+        float bias = 0.02 * u_radius;
+        float occlusion = 0.;
+        for (int i = 0; i < nSamples; i++) {
+          float a = rot + 2.3999632 * float(i);
+          float r = sqrt((float(i) + 0.5) / float(nSamples));
+          vec3 q = viewPosition(tCoord + r * diskRadius * vec2(cos(a), sin(a)));
+          vec3 v = q - p;
+          float vv = dot(v, v);
+          float falloff = max(0., 1. - vv / (u_radius * u_radius));
+          occlusion += falloff * max(0., dot(v, n) - bias) / (sqrt(vv) + 1e-4 * u_radius);
+        }
+        float ao = clamp(1. - u_strength * occlusion / float(nSamples), 0., 1.);
+
+        outputF = vec4(ao, -p.z, 0., 1.);
+      }
+)"
+};
+
+const ShaderStageSpecification AMBIENT_OCCLUSION_COMPOSITE = {
+  // Darken the scene color by the ambient occlusion, upsampling it with weights that favor samples at a similar depth,
+  // so the occlusion doesn't bleed across silhouettes
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+      {"u_invProjMatrix", RenderDataType::Matrix44Float},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { {"t_image", 2}, {"t_depth", 2}, {"t_ao", 2} },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_image;
+      uniform sampler2D t_depth;
+      uniform sampler2D t_ao;
+      uniform mat4 u_invProjMatrix;
+      layout(location = 0) out vec4 outputF;
+
+      void main()
+      {
+        vec4 color = texture(t_image, tCoord);
+        float depth = texture(t_depth, tCoord).r;
+        if (depth >= 1.) {
+          outputF = color;
+          return;
+        }
+        vec4 pos = u_invProjMatrix * vec4(2. * tCoord - 1., 2. * depth - 1., 1.);
+        float z = -pos.z / pos.w;
+
+        vec2 aoTexel = 1. / vec2(textureSize(t_ao, 0));
+        float sum = 0.;
+        float weightSum = 0.;
+        for (int i = -1; i <= 1; i++) {
+          for (int j = -1; j <= 1; j++) {
+            vec2 s = texture(t_ao, tCoord + vec2(i, j) * aoTexel).rg;
+            if (s.g == 0.) continue; // background
+            float w = 1. / (1e-3 + abs(s.g - z) / max(abs(z), 1e-6));
+            sum += w * s.r;
+            weightSum += w;
+          }
+        }
+        float ao = weightSum > 0. ? sum / weightSum : 1.;
+
+        outputF = vec4(color.rgb * ao, color.a);
+      }
+)"
+};
+
+const ShaderStageSpecification DEFERRED_LIGHTING = {
+  // Light the pixels of the G-buffer which were drawn with one material, see LIGHT_DEFERRED. Drawn once per material,
+  // since each has its own matcap textures, and once more with index -1 to copy the pixels drawn without it.
+    
+    // stage
+    ShaderStageType::Fragment,
+    
+    // uniforms
+    { 
+      {"u_materialIndex", RenderDataType::Float},
+    }, 
+
+    // attributes
+    { },
+    
+    // textures 
+    { {"t_albedo", 2}, {"t_normalMaterial", 2}, {"t_mat_r", 2}, {"t_mat_g", 2}, {"t_mat_b", 2}, {"t_mat_k", 2} },
+    
+    // source 
+R"(
+      ${ GLSL_VERSION }$
+
+      in vec2 tCoord;
+      uniform sampler2D t_albedo;
+      uniform sampler2D t_normalMaterial;
+      uniform sampler2D t_mat_r;
+      uniform sampler2D t_mat_g;
+      uniform sampler2D t_mat_b;
+      uniform sampler2D t_mat_k;
+      uniform float u_materialIndex;
+      layout(location = 0) out vec4 outputF;
+
+      vec3 lightSurfaceMat(vec3 normal, vec3 color,
+                           sampler2D t_mat_r, sampler2D t_mat_g, sampler2D t_mat_b, sampler2D t_mat_k);
+
+      void main()
+      {
+        // the G-buffer holds 1 + the material index, or 0 where nothing was drawn with deferred lighting
+        vec4 normalMaterial = texture(t_normalMaterial, tCoord);
+        if (abs(normalMaterial.a - (u_materialIndex + 1.)) > 0.5) discard;
+        vec4 albedo = texture(t_albedo, tCoord);
+        if (u_materialIndex < 0.) {
+          outputF = albedo;
+          return;
+        }
+
+        vec3 litColor = lightSurfaceMat(normalize(normalMaterial.xyz), albedo.rgb, t_mat_r, t_mat_g, t_mat_b, t_mat_k);
+        outputF = vec4(litColor, albedo.a);
+      }
+)"
+};
+
 const ShaderStageSpecification DEPTH_TO_MASK = {
   // writes 0./1. mask to red channel
     
@@ -579,6 +953,34 @@ const ShaderReplacementRule TEXTURE_PROPAGATE_VALUE(
     }
 );
 
+// draws the texture sub-rectangle [u_tcoordMin, u_tcoordMax] to the rectangle [u_rectMin, u_rectMax] in the
+// [-1,1]^2 quad (before any billboard transform)
+const ShaderReplacementRule TEXTURE_RECT_FROM_UNIFORMS(
+    /* rule name */ "TEXTURE_RECT_FROM_UNIFORMS",
+    { /* replacement sources */
+      {"VERT_DECLARATIONS", R"(
+          uniform vec2 u_rectMin;
+          uniform vec2 u_rectMax;
+          uniform vec2 u_tcoordMin;
+          uniform vec2 u_tcoordMax;
+        )" },
+      {"TCOORD_ADJUST", R"(
+        tCoord = mix(u_tcoordMin, u_tcoordMax, tCoord);
+      )"},
+      {"POSITION_ADJUST", R"(
+        position.xy = mix(u_rectMin, u_rectMax, (position.xy + vec2(1.)) / 2.);
+      )"}
+    },
+    /* uniforms */ {
+      {"u_rectMin", RenderDataType::Vector2Float},
+      {"u_rectMax", RenderDataType::Vector2Float},
+      {"u_tcoordMin", RenderDataType::Vector2Float},
+      {"u_tcoordMax", RenderDataType::Vector2Float},
+    },
+    /* attributes */ {},
+    /* textures */ {}
+);
+
 const ShaderReplacementRule TEXTURE_BILLBOARD_FROM_UNIFORMS(
     /* rule name */ "TEXTURE_BILLBOARD_FROM_UNIFORMS",
     { /* replacement sources */
@@ -0,0 +1,669 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/render/opengl/shaders/volume_grid_shaders.h"
+
+namespace polyscope {
+namespace render {
+namespace backend_openGL3_glfw {
+
+// These shaders rasterize the bounding box of a volume grid, and march a ray through the grid values for each covered
+// pixel. The values come from sampleVolume(), which a GRID_SAMPLE_* rule defines. Both faces of the box get
+// rasterized; each fragment figures out on its own whether it is responsible for the ray, so the result does not depend
+// on triangle winding or face culling.
+
+const ShaderStageSpecification GRID_RAYMARCH_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+    },
+
+    // attributes
+    {
+        {"a_position", RenderDataType::Vector3Float},
+    },
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        in vec3 a_position;
+        uniform mat4 u_modelView;
+        uniform mat4 u_projMatrix;
+
+        ${ VERT_DECLARATIONS }$
+
+        void main()
+        {
+            gl_Position = u_projMatrix * u_modelView * vec4(a_position, 1.0);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+// Emission-absorption volume rendering. The colormap is applied to each sample, and the opacity ramps linearly across
+// the data range.
+const ShaderStageSpecification GRID_RAYMARCH_VOLUME_FRAG_SHADER = {
+
+    ShaderStageType::Fragment,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_invModelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_boundMin", RenderDataType::Vector3Float},
+        {"u_boundMax", RenderDataType::Vector3Float},
+        {"u_gridRes", RenderDataType::Vector3Float},
+        {"u_stepSize", RenderDataType::Float},
+        {"u_density", RenderDataType::Float},
+        {"u_densityRangeLow", RenderDataType::Float},
+        {"u_densityRangeHigh", RenderDataType::Float},
+    },
+
+    { }, // attributes
+
+    {}, // textures (from a GRID_SAMPLE_* rule)
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+        uniform mat4 u_modelView;
+        uniform mat4 u_invModelView;
+        uniform mat4 u_projMatrix;
+        uniform mat4 u_invProjMatrix;
+        uniform vec4 u_viewport;
+        uniform vec3 u_boundMin;
+        uniform vec3 u_boundMax;
+        uniform vec3 u_gridRes;
+        uniform float u_stepSize;
+        uniform float u_density;
+        uniform float u_densityRangeLow;
+        uniform float u_densityRangeHigh;
+        layout(location = 0) out vec4 outputF;
+
+        vec3 fragmentViewPosition(vec4 viewport, vec2 depthRange, mat4 invProjMat, vec4 fragCoord);
+        float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+        bool rayBoxIntersection(vec3 rayStart, vec3 rayDir, vec3 boxMin, vec3 boxMax, out float tNear, out float tFar);
+
+        ${ FRAG_DECLARATIONS }$
+
+        void main()
+        {
+           // Build a ray corresponding to this fragment, in object space where the grid is an axis-aligned box
+           vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+           vec3 viewRay = fragmentViewPosition(u_viewport, depthRange, u_invProjMatrix, gl_FragCoord);
+           vec3 rayStart = (u_invModelView * vec4(0., 0., 0., 1.)).xyz;
+           vec3 rayDir = normalize((u_invModelView * vec4(viewRay, 0.)).xyz);
+
+           float tNear;
+           float tFar;
+           if(!rayBoxIntersection(rayStart, rayDir, u_boundMin, u_boundMax, tNear, tFar)) {
+              discard;
+           }
+
+           // From outside the box, only the face where the ray enters does the work
+           float entryDepth = fragDepthFromView(u_projMatrix, depthRange, (u_modelView * vec4(rayStart + tNear * rayDir, 1.)).xyz);
+           float exitDepth = fragDepthFromView(u_projMatrix, depthRange, (u_modelView * vec4(rayStart + tFar * rayDir, 1.)).xyz);
+           bool cameraInside = tNear <= 0.;
+           if(!cameraInside && abs(gl_FragCoord.z - entryDepth) > abs(gl_FragCoord.z - exitDepth)) {
+              discard;
+           }
+
+           float depth = cameraInside ? gl_FragCoord.z : entryDepth;
+           ${ GLOBAL_FRAGMENT_FILTER_PREP }$
+           ${ GLOBAL_FRAGMENT_FILTER }$
+
+           // March front to back, accumulating premultiplied color
+           vec3 colorAccum = vec3(0., 0., 0.);
+           float alphaAccum = 0.;
+           int nSteps = int(ceil((tFar - tNear) / u_stepSize));
+           for(int iStep = 0; iStep < nSteps; iStep++) {
+              vec3 pObj = rayStart + (tNear + (float(iStep) + 0.5) * u_stepSize) * rayDir;
+              float shadeValue = sampleVolume(pObj);
+
+              // Shading
+              ${ GENERATE_SHADE_COLOR }$
+
+              float densityT = clamp((shadeValue - u_densityRangeLow) / (u_densityRangeHigh - u_densityRangeLow), 0., 1.);
+              float sampleAlpha = 1. - exp(-u_density * densityT * u_stepSize);
+              colorAccum += (1. - alphaAccum) * sampleAlpha * albedoColor;
+              alphaAccum += (1. - alphaAccum) * sampleAlpha;
+
+              // Early ray termination
+              if(alphaAccum > 0.995) {
+                break;
+              }
+           }
+
+           if(alphaAccum <= 0.) {
+              discard;
+           }
+
+           // Set alpha
+           float alphaOut = 1.0;
+           ${ GENERATE_ALPHA }$
+
+           // Write output (un-premultiplied, the volume is blended over the scene)
+           outputF = vec4(colorAccum / alphaAccum, alphaAccum * alphaOut);
+        }
+)"
+};
+
+// Finds the first crossing of a level set along the ray, and shades it like an opaque surface.
+const ShaderStageSpecification GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER = {
+
+    ShaderStageType::Fragment,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_invModelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_boundMin", RenderDataType::Vector3Float},
+        {"u_boundMax", RenderDataType::Vector3Float},
+        {"u_gridRes", RenderDataType::Vector3Float},
+        {"u_stepSize", RenderDataType::Float},
+        {"u_isoLevel", RenderDataType::Float},
+    },
+
+    { }, // attributes
+
+    {}, // textures (from a GRID_SAMPLE_* rule)
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+        uniform mat4 u_modelView;
+        uniform mat4 u_invModelView;
+        uniform mat4 u_projMatrix;
+        uniform mat4 u_invProjMatrix;
+        uniform vec4 u_viewport;
+        uniform vec3 u_boundMin;
+        uniform vec3 u_boundMax;
+        uniform vec3 u_gridRes;
+        uniform float u_stepSize;
+        uniform float u_isoLevel;
+        layout(location = 0) out vec4 outputF;
+
+        vec3 fragmentViewPosition(vec4 viewport, vec2 depthRange, mat4 invProjMat, vec4 fragCoord);
+        float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+        bool rayBoxIntersection(vec3 rayStart, vec3 rayDir, vec3 boxMin, vec3 boxMax, out float tNear, out float tFar);
+
+        ${ FRAG_DECLARATIONS }$
+
+        void main()
+        {
+           // Build a ray corresponding to this fragment, in object space where the grid is an axis-aligned box
+           vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+           vec3 viewRay = fragmentViewPosition(u_viewport, depthRange, u_invProjMatrix, gl_FragCoord);
+           vec3 rayStart = (u_invModelView * vec4(0., 0., 0., 1.)).xyz;
+           vec3 rayDir = normalize((u_invModelView * vec4(viewRay, 0.)).xyz);
+
+           float tNear;
+           float tFar;
+           if(!rayBoxIntersection(rayStart, rayDir, u_boundMin, u_boundMax, tNear, tFar)) {
+              discard;
+           }
+
+           // From outside the box, only the face where the ray enters does the work
+           float entryDepth = fragDepthFromView(u_projMatrix, depthRange, (u_modelView * vec4(rayStart + tNear * rayDir, 1.)).xyz);
+           float exitDepth = fragDepthFromView(u_projMatrix, depthRange, (u_modelView * vec4(rayStart + tFar * rayDir, 1.)).xyz);
+           bool cameraInside = tNear <= 0.;
+           if(!cameraInside && abs(gl_FragCoord.z - entryDepth) > abs(gl_FragCoord.z - exitDepth)) {
+              discard;
+           }
+
+           // March until the sign of (value - level) changes, then interpolate the crossing within the step
+           float tPrev = tNear;
+           float vPrev = sampleVolume(rayStart + tNear * rayDir) - u_isoLevel;
+           float tHit = -1.;
+           int nSteps = int(ceil((tFar - tNear) / u_stepSize));
+           for(int iStep = 1; iStep <= nSteps; iStep++) {
+              float t = min(tNear + float(iStep) * u_stepSize, tFar);
+              float v = sampleVolume(rayStart + t * rayDir) - u_isoLevel;
+              if((v < 0.) != (vPrev < 0.)) {
+                tHit = tPrev + (t - tPrev) * vPrev / (vPrev - v);
+                break;
+              }
+              tPrev = t;
+              vPrev = v;
+           }
+           if(tHit < 0.) {
+              discard;
+           }
+           vec3 pHitObj = rayStart + tHit * rayDir;
+           vec3 pHit = (u_modelView * vec4(pHitObj, 1.)).xyz;
+           float depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
+
+           ${ GLOBAL_FRAGMENT_FILTER_PREP }$
+           ${ GLOBAL_FRAGMENT_FILTER }$
+
+           // Set depth (expensive!)
+           gl_FragDepth = depth;
+
+           // Normal from the central-difference gradient, facing the viewer
+           vec3 h = (u_boundMax - u_boundMin) / max(u_gridRes - 1., vec3(1., 1., 1.));
+           vec3 gradObj = vec3(
+              sampleVolume(pHitObj + vec3(h.x, 0., 0.)) - sampleVolume(pHitObj - vec3(h.x, 0., 0.)),
+              sampleVolume(pHitObj + vec3(0., h.y, 0.)) - sampleVolume(pHitObj - vec3(0., h.y, 0.)),
+              sampleVolume(pHitObj + vec3(0., 0., h.z)) - sampleVolume(pHitObj - vec3(0., 0., h.z))
+           ) / (2. * h);
+           vec3 nHit = normalize(transpose(mat3(u_invModelView)) * gradObj);
+           if(dot(nHit, pHit) > 0.) {
+              nHit = -nHit;
+           }
+
+           // Shading
+           ${ GENERATE_SHADE_VALUE }$
+           ${ GENERATE_SHADE_COLOR }$
+
+           // Lighting
+           vec3 shadeNormal = nHit;
+           ${ GENERATE_LIT_COLOR }$
+
+           // Set alpha
+           float alphaOut = 1.0;
+           ${ GENERATE_ALPHA }$
+
+           // Write output
+           outputF = vec4(litColor, alphaOut);
+        }
+)"
+};
+
+
+// The same for a sparse volume grid, whose values live in an atlas of padded bricks. Samples which land in an empty
+// brick jump straight to where the ray leaves it. NaN values are missing data, and no crossing is reported next to
+// them.
+const ShaderStageSpecification SPARSE_GRID_RAYMARCH_ISOSURFACE_FRAG_SHADER = {
+
+    ShaderStageType::Fragment,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_invModelView", RenderDataType::Matrix44Float},
+        {"u_projMatrix", RenderDataType::Matrix44Float},
+        {"u_invProjMatrix", RenderDataType::Matrix44Float},
+        {"u_viewport", RenderDataType::Vector4Float},
+        {"u_boundMin", RenderDataType::Vector3Float},
+        {"u_boundMax", RenderDataType::Vector3Float},
+        {"u_gridOrigin", RenderDataType::Vector3Float},
+        {"u_gridSpacing", RenderDataType::Vector3Float},
+        {"u_brickRangeMin", RenderDataType::Vector3Float},
+        {"u_brickRangeRes", RenderDataType::Vector3Float},
+        {"u_atlasBricks", RenderDataType::Vector3Float},
+        {"u_brickSize", RenderDataType::Float},
+        {"u_stepSize", RenderDataType::Float},
+        {"u_isoLevel", RenderDataType::Float},
+    },
+
+    { }, // attributes
+
+    // textures
+    {
+        {"t_brickIndex", 3},
+        {"t_volume", 3},
+    },
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+        uniform mat4 u_modelView;
+        uniform mat4 u_invModelView;
+        uniform mat4 u_projMatrix;
+        uniform mat4 u_invProjMatrix;
+        uniform vec4 u_viewport;
+        uniform vec3 u_boundMin;
+        uniform vec3 u_boundMax;
+        uniform vec3 u_gridOrigin;
+        uniform vec3 u_gridSpacing;
+        uniform vec3 u_brickRangeMin;
+        uniform vec3 u_brickRangeRes;
+        uniform vec3 u_atlasBricks;
+        uniform float u_brickSize;
+        uniform float u_stepSize;
+        uniform float u_isoLevel;
+        uniform sampler3D t_brickIndex;
+        uniform sampler3D t_volume;
+        layout(location = 0) out vec4 outputF;
+
+        vec3 fragmentViewPosition(vec4 viewport, vec2 depthRange, mat4 invProjMat, vec4 fragCoord);
+        float fragDepthFromView(mat4 projMat, vec2 depthRange, vec3 viewPoint);
+        bool rayBoxIntersection(vec3 rayStart, vec3 rayDir, vec3 boxMin, vec3 boxMax, out float tNear, out float tFar);
+
+        ${ FRAG_DECLARATIONS }$
+
+        // The brick containing a point (relative to the start of the brick range), and its atlas slot, or -1 if empty
+        float lookupBrick(vec3 pObj, out vec3 brick) {
+          vec3 node = (pObj - u_gridOrigin) / u_gridSpacing;
+          brick = clamp(floor(node / u_brickSize) - u_brickRangeMin, vec3(0., 0., 0.), u_brickRangeRes - 1.);
+          return texelFetch(t_brickIndex, ivec3(brick), 0).r;
+        }
+
+        float sampleBrick(vec3 pObj, vec3 brick, float slot) {
+          // padded bricks of u_brickSize+1 nodes per side, with the nodes at texel centers
+          vec3 local = (pObj - u_gridOrigin) / u_gridSpacing - (brick + u_brickRangeMin) * u_brickSize;
+          local = clamp(local, vec3(0., 0., 0.), vec3(u_brickSize));
+          vec3 slotCoord = vec3(mod(slot, u_atlasBricks.x), mod(floor(slot / u_atlasBricks.x), u_atlasBricks.y),
+                                floor(slot / (u_atlasBricks.x * u_atlasBricks.y)));
+          float padded = u_brickSize + 1.;
+          return texture(t_volume, (slotCoord * padded + local + 0.5) / (u_atlasBricks * padded)).r;
+        }
+
+        float sampleVolume(vec3 pObj) {
+          vec3 brick;
+          float slot = lookupBrick(pObj, brick);
+          if(slot < 0.) return uintBitsToFloat(0x7fc00000u); // NaN
+          return sampleBrick(pObj, brick, slot);
+        }
+
+        void main()
+        {
+           // Build a ray corresponding to this fragment, in object space where the bricks are axis-aligned boxes
+           vec2 depthRange = vec2(gl_DepthRange.near, gl_DepthRange.far);
+           vec3 viewRay = fragmentViewPosition(u_viewport, depthRange, u_invProjMatrix, gl_FragCoord);
+           vec3 rayStart = (u_invModelView * vec4(0., 0., 0., 1.)).xyz;
+           vec3 rayDir = normalize((u_invModelView * vec4(viewRay, 0.)).xyz);
+
+           float tNear;
+           float tFar;
+           if(!rayBoxIntersection(rayStart, rayDir, u_boundMin, u_boundMax, tNear, tFar)) {
+              discard;
+           }
+
+           // From outside the box, only the face where the ray enters does the work
+           float entryDepth = fragDepthFromView(u_projMatrix, depthRange, (u_modelView * vec4(rayStart + tNear * rayDir, 1.)).xyz);
+           float exitDepth = fragDepthFromView(u_projMatrix, depthRange, (u_modelView * vec4(rayStart + tFar * rayDir, 1.)).xyz);
+           bool cameraInside = tNear <= 0.;
+           if(!cameraInside && abs(gl_FragCoord.z - entryDepth) > abs(gl_FragCoord.z - exitDepth)) {
+              discard;
+           }
+
+           // March until the sign of (value - level) changes between two consecutive valid samples. Every iteration
+           // either takes a step or leaves a brick, which bounds the loop.
+           vec3 brickExtent = u_brickSize * u_gridSpacing;
+           float tHit = -1.;
+           float t = tNear;
+           float tPrev = tNear;
+           float vPrev = 0.;
+           bool havePrev = false;
+           int nBrickSkips = 3 * int(u_brickRangeRes.x + u_brickRangeRes.y + u_brickRangeRes.z);
+           int maxIter = int(ceil((tFar - tNear) / u_stepSize)) + nBrickSkips + 2;
+           for(int iIter = 0; iIter < maxIter && t <= tFar; iIter++) {
+              vec3 p = rayStart + t * rayDir;
+              vec3 brick;
+              float slot = lookupBrick(p, brick);
+
+              if(slot < 0.) {
+                // skip the empty brick
+                vec3 brickMin = u_gridOrigin + (brick + u_brickRangeMin) * brickExtent;
+                float tBrickNear;
+                float tBrickFar;
+                rayBoxIntersection(rayStart, rayDir, brickMin, brickMin + brickExtent, tBrickNear, tBrickFar);
+                t = max(t, tBrickFar) + 1e-3 * u_stepSize;
+                havePrev = false;
+                continue;
+              }
+
+              float v = sampleBrick(p, brick, slot) - u_isoLevel;
+              if(isnan(v)) {
+                havePrev = false;
+              } else {
+                if(havePrev && (v < 0.) != (vPrev < 0.)) {
+                  tHit = tPrev + (t - tPrev) * vPrev / (vPrev - v);
+                  break;
+                }
+                tPrev = t;
+                vPrev = v;
+                havePrev = true;
+              }
+              t += u_stepSize;
+           }
+           if(tHit < 0.) {
+              discard;
+           }
+           vec3 pHitObj = rayStart + tHit * rayDir;
+           vec3 pHit = (u_modelView * vec4(pHitObj, 1.)).xyz;
+           float depth = fragDepthFromView(u_projMatrix, depthRange, pHit);
+
+           ${ GLOBAL_FRAGMENT_FILTER_PREP }$
+           ${ GLOBAL_FRAGMENT_FILTER }$
+
+           // Set depth (expensive!)
+           gl_FragDepth = depth;
+
+           // Normal from the central-difference gradient, facing the viewer. Next to missing data, use the ray.
+           vec3 h = u_gridSpacing;
+           vec3 gradObj = vec3(
+              sampleVolume(pHitObj + vec3(h.x, 0., 0.)) - sampleVolume(pHitObj - vec3(h.x, 0., 0.)),
+              sampleVolume(pHitObj + vec3(0., h.y, 0.)) - sampleVolume(pHitObj - vec3(0., h.y, 0.)),
+              sampleVolume(pHitObj + vec3(0., 0., h.z)) - sampleVolume(pHitObj - vec3(0., 0., h.z))
+           ) / (2. * h);
+           if(any(isnan(gradObj)) || dot(gradObj, gradObj) == 0.) {
+              gradObj = -rayDir;
+           }
+           vec3 nHit = normalize(transpose(mat3(u_invModelView)) * gradObj);
+           if(dot(nHit, pHit) > 0.) {
+              nHit = -nHit;
+           }
+
+           // Shading
+           ${ GENERATE_SHADE_VALUE }$
+           ${ GENERATE_SHADE_COLOR }$
+
+           // Lighting
+           vec3 shadeNormal = nHit;
+           ${ GENERATE_LIT_COLOR }$
+
+           // Set alpha
+           float alphaOut = 1.0;
+           ${ GENERATE_ALPHA }$
+
+           // Write output
+           outputF = vec4(litColor, alphaOut);
+        }
+)"
+};
+
+// Grid nodes drawn as spheres, with the position of each computed from its index rather than read from a buffer.
+// Node indices are flattened with the last grid index fastest-varying, as for the grid's values.
+const ShaderStageSpecification GRID_NODE_SPHERE_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_boundMin", RenderDataType::Vector3Float},
+        {"u_boundMax", RenderDataType::Vector3Float},
+        {"u_gridRes", RenderDataType::Vector3Float},
+    },
+
+    { }, // attributes
+
+    {}, // textures
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        uniform mat4 u_modelView;
+        uniform vec3 u_boundMin;
+        uniform vec3 u_boundMax;
+        uniform vec3 u_gridRes;
+
+        ${ VERT_DECLARATIONS }$
+
+        void main()
+        {
+            int resY = int(u_gridRes.y);
+            int resZ = int(u_gridRes.z);
+            ivec3 ind = ivec3(gl_VertexID / (resY * resZ), (gl_VertexID / resZ) % resY, gl_VertexID % resZ);
+            vec3 t = vec3(ind) / max(u_gridRes - 1., vec3(1., 1., 1.));
+            vec3 a_position = mix(u_boundMin, u_boundMax, t);
+
+            gl_Position = u_modelView * vec4(a_position, 1.0);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+// Vectors at a subsample of the grid nodes: every u_sampleStride'th node along each axis, optionally moved to a random
+// node of its stride cell. The vectors are read from a buffer of the node values, as 3 floats per node.
+const ShaderStageSpecification GRID_NODE_VECTOR_VERT_SHADER = {
+
+    ShaderStageType::Vertex,
+
+    // uniforms
+    {
+        {"u_modelView", RenderDataType::Matrix44Float},
+        {"u_boundMin", RenderDataType::Vector3Float},
+        {"u_boundMax", RenderDataType::Vector3Float},
+        {"u_gridRes", RenderDataType::Vector3Float},
+        {"u_sampleRes", RenderDataType::Vector3Float},
+        {"u_sampleStride", RenderDataType::Float},
+        {"u_sampleJitter", RenderDataType::Float},
+    },
+
+    { }, // attributes
+
+    // textures
+    {
+        {"t_gridVectors", 1},
+    },
+
+    // source
+R"(
+        ${ GLSL_VERSION }$
+
+        uniform mat4 u_modelView;
+        uniform vec3 u_boundMin;
+        uniform vec3 u_boundMax;
+        uniform vec3 u_gridRes;
+        uniform vec3 u_sampleRes;
+        uniform float u_sampleStride;
+        uniform float u_sampleJitter;
+        uniform samplerBuffer t_gridVectors;
+        out vec4 vector;
+
+        ${ VERT_DECLARATIONS }$
+
+        uint hashSample(uint x) {
+            x ^= x >> 16; x *= 0x7feb352du;
+            x ^= x >> 15; x *= 0x846ca68bu;
+            x ^= x >> 16;
+            return x;
+        }
+
+        void main()
+        {
+            int sampleY = int(u_sampleRes.y);
+            int sampleZ = int(u_sampleRes.z);
+            ivec3 sampleInd =
+                ivec3(gl_VertexID / (sampleY * sampleZ), (gl_VertexID / sampleZ) % sampleY, gl_VertexID % sampleZ);
+            int stride = int(u_sampleStride);
+            ivec3 res = ivec3(u_gridRes);
+            ivec3 ind = sampleInd * stride;
+
+            if (u_sampleJitter > 0.) {
+              // (the cells at the far end of each axis may be cut short)
+              uvec3 cellSize = uvec3(min(ivec3(stride), res - ind));
+              uint h = hashSample(uint(gl_VertexID));
+              ind += ivec3(uvec3(h, h >> 10, h >> 20) % cellSize);
+            }
+
+            int node = (ind.x * res.y + ind.y) * res.z + ind.z;
+            vec3 t = vec3(ind) / max(u_gridRes - 1., vec3(1., 1., 1.));
+            vec3 a_position = mix(u_boundMin, u_boundMax, t);
+            vec3 a_vector = vec3(texelFetch(t_gridVectors, 3 * node).x, texelFetch(t_gridVectors, 3 * node + 1).x,
+                                 texelFetch(t_gridVectors, 3 * node + 2).x);
+
+            gl_Position = u_modelView * vec4(a_position, 1.0);
+            vector = u_modelView * vec4(a_vector, 0.0);
+
+            ${ VERT_ASSIGNMENTS }$
+        }
+)"
+};
+
+
+// The values as a dense 3D texture
+const ShaderReplacementRule GRID_SAMPLE_DENSE (
+    /* rule name */ "GRID_SAMPLE_DENSE",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform sampler3D t_volume;
+          float sampleVolume(vec3 pObj) {
+            // grid nodes sit at texel centers, and the last grid index is the fastest-varying texture axis
+            vec3 coord = (pObj - u_boundMin) / (u_boundMax - u_boundMin);
+            coord = (coord * (u_gridRes - 1.) + 0.5) / u_gridRes;
+            return texture(t_volume, coord.zyx).r;
+          }
+        )"},
+    },
+    /* uniforms */ {},
+    /* attributes */ {},
+    /* textures */ {
+      {"t_volume", 3},
+    }
+);
+
+// The values streamed in to a cache of bricks of varying level of detail. The page table has an entry per brick of the
+// full-resolution grid, giving the atlas slot and level of the resident brick which covers it, as slot * 32 + level.
+// Bricks are padded by one node so trilinear lookups stay within a slot, and the first grid index is the texture x.
+const ShaderReplacementRule GRID_SAMPLE_STREAMED (
+    /* rule name */ "GRID_SAMPLE_STREAMED",
+    { /* replacement sources */
+      {"FRAG_DECLARATIONS", R"(
+          uniform vec3 u_pageTableRes;
+          uniform vec3 u_atlasBricks;
+          uniform float u_brickSize;
+          uniform sampler3D t_pageTable;
+          uniform sampler3D t_volume;
+          float sampleVolume(vec3 pObj) {
+            vec3 node = (pObj - u_boundMin) / (u_boundMax - u_boundMin) * (u_gridRes - 1.);
+            vec3 fineBrick = clamp(floor(node / u_brickSize), vec3(0., 0., 0.), u_pageTableRes - 1.);
+            float entry = texelFetch(t_pageTable, ivec3(fineBrick), 0).r;
+            float level = mod(entry, 32.);
+            float slot = floor(entry / 32.);
+
+            // level L nodes sit on every 2^L-th full-resolution node
+            float scale = exp2(level);
+            vec3 brick = floor(fineBrick / scale);
+            vec3 local = clamp(node / scale - brick * u_brickSize, vec3(0., 0., 0.), vec3(u_brickSize));
+            vec3 slotCoord = vec3(mod(slot, u_atlasBricks.x), mod(floor(slot / u_atlasBricks.x), u_atlasBricks.y),
+                                  floor(slot / (u_atlasBricks.x * u_atlasBricks.y)));
+            float padded = u_brickSize + 1.;
+            return texture(t_volume, (slotCoord * padded + local + 0.5) / (u_atlasBricks * padded)).r;
+          }
+        )"},
+    },
+    /* uniforms */ {
+      {"u_pageTableRes", RenderDataType::Vector3Float},
+      {"u_atlasBricks", RenderDataType::Vector3Float},
+      {"u_brickSize", RenderDataType::Float},
+    },
+    /* attributes */ {},
+    /* textures */ {
+      {"t_pageTable", 3},
+      {"t_volume", 3},
+    }
+);
+
+
+} // namespace backend_openGL3_glfw
+} // namespace render
+} // namespace polyscope
@@ -0,0 +1,267 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/render/render_graph.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/render/engine.h"
+
+#include <algorithm>
+
+namespace polyscope {
+namespace render {
+
+namespace {
+const size_t UNASSIGNED = static_cast<size_t>(-1);
+}
+
+void RenderGraph::beginFrame() {
+  if (executing) exception("RenderGraph::beginFrame() called while executing");
+  resources.clear();
+  passes.clear();
+  outputs.clear();
+}
+
+RenderResource RenderGraph::importResource(const std::string& name) {
+  resources.push_back(Resource{name, false, TextureFormat::RGBA8, 0, 0, UNASSIGNED});
+  return resources.size() - 1;
+}
+
+RenderResource RenderGraph::createTransientTexture(const std::string& name, TextureFormat format, unsigned int sizeX,
+                                                   unsigned int sizeY) {
+  resources.push_back(Resource{name, true, format, sizeX, sizeY, UNASSIGNED});
+  return resources.size() - 1;
+}
+
+void RenderGraph::addPass(const std::string& name, const std::vector<RenderResource>& reads,
+                          const std::vector<RenderResource>& writes, std::function<void()> execute, uint64_t skipKey) {
+  for (RenderResource r : reads) {
+    if (r >= resources.size()) exception("render graph pass " + name + " reads an undeclared resource");
+  }
+  for (RenderResource r : writes) {
+    if (r >= resources.size()) exception("render graph pass " + name + " writes an undeclared resource");
+  }
+  passes.push_back(Pass{name, reads, writes, execute, skipKey});
+}
+
+void RenderGraph::markOutput(RenderResource resource) {
+  if (resource >= resources.size()) exception("render graph output is an undeclared resource");
+  outputs.push_back(resource);
+}
+
+uint64_t RenderGraph::resourceVersion(const std::string& name) {
+  std::map<std::string, uint64_t>::iterator it = versions.find(name);
+  return it == versions.end() ? 0 : it->second;
+}
+
+bool RenderGraph::canSkip(const Pass& pass, const std::vector<char>& modified) {
+  if (pass.skipKey == 0) return false;
+  std::map<std::string, PassRecord>::iterator it = records.find(pass.name);
+  if (it == records.end() || it->second.skipKey != pass.skipKey) return false;
+
+  // The inputs are what they were, and the outputs still hold what the previous frame left in them
+  for (RenderResource r : pass.reads) {
+    if (modified[r]) return false;
+  }
+  for (RenderResource r : pass.writes) {
+    if (!resources[r].transient && modified[r]) return false;
+  }
+  return importedVersions(pass) == it->second.versions;
+}
+
+std::vector<std::pair<std::string, uint64_t>> RenderGraph::importedVersions(const Pass& pass) {
+  std::vector<std::pair<std::string, uint64_t>> result;
+  for (const std::vector<RenderResource>* list : {&pass.reads, &pass.writes}) {
+    for (RenderResource r : *list) {
+      if (!resources[r].transient) result.emplace_back(resources[r].name, resourceVersion(resources[r].name));
+    }
+  }
+  return result;
+}
+
+bool RenderGraph::writes(const Pass& pass, RenderResource resource) {
+  return std::find(pass.writes.begin(), pass.writes.end(), resource) != pass.writes.end();
+}
+
+void RenderGraph::execute() {
+  frameIndex++;
+  stats = Stats();
+  size_t nPasses = passes.size();
+
+  // Decide which passes skip, going forward. A skipped pass leaves its outputs as the whole previous frame left them,
+  // which is only what the pass itself produced if no later pass changed them. So an earlier writer must run as well
+  // when a running pass writes the same resource, reads a transient one (whose contents are otherwise undefined), or
+  // reads an imported one which a later pass writes. Forcing a pass to run may stop others from skipping; repeat until
+  // it settles.
+  std::vector<char> skips(nPasses, false);
+  std::vector<char> forced(nPasses, false);
+  while (true) {
+    std::vector<char> modified(resources.size(), false);
+    for (size_t i = 0; i < nPasses; i++) {
+      skips[i] = !forced[i] && canSkip(passes[i], modified);
+      if (!skips[i]) {
+        for (RenderResource r : passes[i].writes) modified[r] = true;
+      }
+    }
+
+    bool changed = false;
+    for (size_t j = 0; j < nPasses; j++) {
+      if (skips[j]) continue;
+      for (const std::vector<RenderResource>* list : {&passes[j].reads, &passes[j].writes}) {
+        for (RenderResource r : *list) {
+          bool needsWriters = resources[r].transient || writes(passes[j], r);
+          for (size_t k = j + 1; k < nPasses && !needsWriters; k++) {
+            needsWriters = writes(passes[k], r);
+          }
+          if (!needsWriters) continue;
+          for (size_t i = 0; i < j; i++) {
+            if (!skips[i] || forced[i] || !writes(passes[i], r)) continue;
+            forced[i] = true;
+            changed = true;
+          }
+        }
+      }
+    }
+    if (!changed) break;
+  }
+
+  // Cull the passes which don't contribute to the outputs, going backward
+  std::vector<char> needed(resources.size(), false);
+  for (RenderResource r : outputs) needed[r] = true;
+  std::vector<char> runs(nPasses, false);
+  for (size_t iRev = 0; iRev < nPasses; iRev++) {
+    size_t i = nPasses - 1 - iRev;
+    if (skips[i]) {
+      stats.passesSkipped++;
+      continue;
+    }
+    for (RenderResource r : passes[i].writes) {
+      if (needed[r]) runs[i] = true;
+    }
+    if (!runs[i]) {
+      stats.passesCulled++;
+      continue;
+    }
+    for (RenderResource r : passes[i].reads) needed[r] = true;
+  }
+
+  allocateTransients(runs);
+
+  executing = true;
+  try {
+    for (size_t i = 0; i < nPasses; i++) {
+      if (!runs[i]) continue;
+      passes[i].execute();
+      stats.passesRun++;
+      for (RenderResource r : passes[i].writes) {
+        if (!resources[r].transient) versions[resources[r].name] = nextVersion++;
+      }
+    }
+  } catch (...) {
+    // whatever the failed pass wrote is unknown
+    executing = false;
+    records.clear();
+    throw;
+  }
+  executing = false;
+
+  // Remember what the frame left in the resources of each pass, for skipping in the next one
+  for (size_t i = 0; i < nPasses; i++) {
+    if (runs[i] || skips[i]) {
+      records[passes[i].name] = PassRecord{passes[i].skipKey, importedVersions(passes[i])};
+    } else {
+      records.erase(passes[i].name);
+    }
+  }
+}
+
+void RenderGraph::allocateTransients(const std::vector<char>& runs) {
+
+  // Free the textures which have gone unused for a while
+  pool.erase(std::remove_if(pool.begin(), pool.end(),
+                            [&](const PoolSlot& s) {
+                              return frameIndex - s.lastUsedFrame > static_cast<uint64_t>(transientRetainFrames);
+                            }),
+             pool.end());
+  for (PoolSlot& s : pool) s.busyUntil = 0;
+
+  // The span of passes which use each transient this frame
+  const size_t NONE = UNASSIGNED;
+  std::vector<size_t> first(resources.size(), NONE);
+  std::vector<size_t> last(resources.size(), 0);
+  for (size_t i = 0; i < passes.size(); i++) {
+    if (!runs[i]) continue;
+    for (const std::vector<RenderResource>* list : {&passes[i].reads, &passes[i].writes}) {
+      for (RenderResource r : *list) {
+        if (!resources[r].transient) continue;
+        if (first[r] == NONE) first[r] = i;
+        last[r] = std::max(last[r], i);
+      }
+    }
+  }
+
+  std::vector<RenderResource> order;
+  for (RenderResource r = 0; r < resources.size(); r++) {
+    if (first[r] != NONE) order.push_back(r);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](RenderResource a, RenderResource b) { return first[a] < first[b]; });
+
+  // Greedily place each in a free, matching texture, preferring the one it had last frame
+  for (RenderResource r : order) {
+    Resource& res = resources[r];
+    size_t chosen = NONE;
+    for (size_t iSlot = 0; iSlot < pool.size(); iSlot++) {
+      PoolSlot& s = pool[iSlot];
+      if (s.format != res.format || s.sizeX != res.sizeX || s.sizeY != res.sizeY || s.busyUntil > first[r]) continue;
+      if (chosen == NONE || s.lastResourceName == res.name) chosen = iSlot;
+      if (s.lastResourceName == res.name) break;
+    }
+    if (chosen == NONE) {
+      pool.push_back(PoolSlot{res.format, res.sizeX, res.sizeY, nullptr, "", 0, 0});
+      chosen = pool.size() - 1;
+    }
+
+    PoolSlot& s = pool[chosen];
+    if (!s.texture) {
+      s.texture = engine->generateTextureBuffer(res.format, res.sizeX, res.sizeY);
+      s.texture->setMemoryOwner("render graph");
+    }
+    s.lastResourceName = res.name;
+    s.lastUsedFrame = frameIndex;
+    s.busyUntil = last[r] + 1;
+    res.slot = chosen;
+    stats.transientResources++;
+  }
+
+  for (PoolSlot& s : pool) {
+    if (s.lastUsedFrame == frameIndex) stats.transientTextures++;
+  }
+}
+
+std::shared_ptr<TextureBuffer> RenderGraph::getTexture(RenderResource resource) {
+  if (!executing) exception("RenderGraph::getTexture() called outside of a pass");
+  if (resource >= resources.size() || !resources[resource].transient) {
+    exception("RenderGraph::getTexture() called on a resource which is not a transient texture");
+  }
+  if (resources[resource].slot == UNASSIGNED) {
+    exception("RenderGraph::getTexture() called on " + resources[resource].name + ", which no running pass uses");
+  }
+  return pool[resources[resource].slot].texture;
+}
+
+void RenderGraph::invalidate() { records.clear(); }
+
+void RenderGraph::releaseTransientTextures() {
+  if (executing) exception("RenderGraph::releaseTransientTextures() called while executing");
+  pool.clear();
+}
+
+size_t RenderGraph::getPooledTextureBytes() const {
+  size_t bytes = 0;
+  for (const PoolSlot& s : pool) {
+    if (s.texture) bytes += s.texture->getSizeInBytes();
+  }
+  return bytes;
+}
+
+} // namespace render
+} // namespace polyscope
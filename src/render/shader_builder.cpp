@@ -4,6 +4,8 @@
 
 #include "polyscope/messages.h"
 
+#include <sstream>
+
 
 namespace polyscope {
 namespace render {
@@ -20,13 +22,10 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
     if (debugPrint) std::cout << "Replacement rule: " << rule.ruleName << std::endl;
 
     for (const std::pair<std::string, std::string>& r : rule.replacements) {
-      std::string key = r.first;
-      std::string value = r.second;
-
-      if (replacements.find(key) == replacements.end()) {
-        replacements[key] = "";
-      }
-      replacements[key] = replacements[key] + "// from rule: " + rule.ruleName + "\n" + value + "\n";
+      std::string& text = replacements[r.first];
+      text += "// from rule: " + rule.ruleName + "\n";
+      text += r.second;
+      text += "\n";
     }
   }
 
@@ -35,58 +34,59 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
   const std::string endTagToken = " }$";
 
   // == Apply the replacements to the shader source
+  // (in one pass over each source, appending to the result, since this runs for every new combination of rules)
   std::vector<ShaderStageSpecification> replacedStages;
-  for (ShaderStageSpecification stage : stages) { // iterate by value to modify
-    std::string progText = stage.src;
-    std::string resultText = "";
-
-    while (!progText.empty()) {
+  replacedStages.reserve(stages.size());
+  for (const ShaderStageSpecification& stage : stages) {
+    const std::string& progText = stage.src;
+    std::string resultText;
+    resultText.reserve(progText.size() + 1024);
 
-      if (debugPrint) std::cout << "searching " << progText << std::endl;
+    size_t pos = 0; // start of the source not processed yet
+    while (true) {
 
       // Find the next tag in the program
-      auto tagStart = progText.find(startTagToken);
-      auto tagEnd = progText.find(endTagToken);
+      size_t tagStart = progText.find(startTagToken, pos);
+      size_t tagEnd = progText.find(endTagToken, pos);
 
       if (tagStart != npos && tagEnd == npos) exception("ShaderBuilder: no end tag matching start tag");
       if (tagStart == npos && tagEnd != npos) exception("ShaderBuilder: no start tag matching end tag");
 
       // no more tags, concatenate in the rest of the source finish looping
-      if (tagStart == npos && tagEnd == npos) {
-        resultText += progText;
-        progText = "";
-      } else {
+      if (tagStart == npos) {
+        resultText.append(progText, pos, npos);
+        break;
+      }
+      if (tagEnd < tagStart) exception("ShaderBuilder: no start tag matching end tag");
 
-        if (debugPrint) std::cout << "FOUND TAG: " << tagStart << " " << tagEnd << std::endl;
+      if (debugPrint) std::cout << "FOUND TAG: " << tagStart << " " << tagEnd << std::endl;
 
-        std::string srcBefore = progText.substr(0, tagStart);
-        std::string tag = progText.substr(tagStart + startTagToken.size(), tagEnd - (tagStart + startTagToken.size()));
-        std::string srcAfter = progText.substr(tagEnd + endTagToken.size(), npos);
+      size_t nameStart = tagStart + startTagToken.size();
+      std::string tag = progText.substr(nameStart, tagEnd - nameStart);
 
-        if (debugPrint) std::cout << "  TAG NAME: [" << tag << "]\n";
+      if (debugPrint) std::cout << "  TAG NAME: [" << tag << "]\n";
 
-        resultText += srcBefore + "\n// tag ${ " + tag + " }$\n";
-        if (replacements.find(tag) != replacements.end()) {
-          resultText += replacements[tag];
-          // std::cout << "  ADDING REPLACEMENT: [" << replacements[tag] << "]\n";
-        }
-        // resultText += "// END ADDIITIONS FROM TAG ${ " + tag + " $}\n";
-        progText = srcAfter; // continue processing the remaining program text
+      resultText.append(progText, pos, tagStart - pos);
+      resultText += "\n// tag ${ " + tag + " }$\n";
+      std::map<std::string, std::string>::const_iterator it = replacements.find(tag);
+      if (it != replacements.end()) {
+        resultText += it->second;
       }
+      pos = tagEnd + endTagToken.size(); // continue processing the remaining program text
     }
 
     // For now, we put the uniform listings on the all stages, attributes on vertex shaders, and textures on fragment
-    // shaders, since this is where they are mostly commonly used. These listings are only used internally by Polyscope
-    // to check inputs, so this should be fine even if they happen to be used elsewhere.
+    // (and compute) shaders, since this is where they are mostly commonly used. These listings are only used
+    // internally by Polyscope to check inputs, so this should be fine even if they happen to be used elsewhere.
 
     // == Union the uniforms
     std::vector<ShaderSpecUniform> replacedUniforms = stage.uniforms;
     for (const ShaderReplacementRule& rule : replacementRules) {
-      for (ShaderSpecUniform newU : rule.uniforms) {
+      for (const ShaderSpecUniform& newU : rule.uniforms) {
 
         // Look for a matching-named existing uniform
         bool existingFound = false;
-        for (ShaderSpecUniform existingU : replacedUniforms) {
+        for (const ShaderSpecUniform& existingU : replacedUniforms) {
           if (existingU.name == newU.name) {
             // check for conflics
             if (existingU.type != newU.type) {
@@ -109,11 +109,11 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
     std::vector<ShaderSpecAttribute> replacedAttributes = stage.attributes;
     if (stage.stage == ShaderStageType::Vertex) {
       for (const ShaderReplacementRule& rule : replacementRules) {
-        for (ShaderSpecAttribute newA : rule.attributes) {
+        for (const ShaderSpecAttribute& newA : rule.attributes) {
 
           // Look for a matching-named existing attribute
           bool existingFound = false;
-          for (ShaderSpecAttribute existingA : replacedAttributes) {
+          for (const ShaderSpecAttribute& existingA : replacedAttributes) {
             if (existingA.name == newA.name) {
               // check for conflics
               if (existingA.type != newA.type) {
@@ -140,13 +140,13 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
 
     // == Union the textures
     std::vector<ShaderSpecTexture> replacedTextures = stage.textures;
-    if (stage.stage == ShaderStageType::Fragment) {
+    if (stage.stage == ShaderStageType::Fragment || stage.stage == ShaderStageType::Compute) {
       for (const ShaderReplacementRule& rule : replacementRules) {
-        for (ShaderSpecTexture newT : rule.textures) {
+        for (const ShaderSpecTexture& newT : rule.textures) {
 
           // Look for a matching-named existing texture
           bool existingFound = false;
-          for (ShaderSpecTexture existingT : replacedTextures) {
+          for (const ShaderSpecTexture& existingT : replacedTextures) {
             if (existingT.name == newT.name) {
               // check for conflics
               if (existingT.dim != newT.dim) {
@@ -168,12 +168,105 @@ applyShaderReplacements(const std::vector<ShaderStageSpecification>& stages,
 
 
     // create a new specification, which is identical except for the replaced source text
-    ShaderStageSpecification newStage{stage.stage, replacedUniforms, replacedAttributes, replacedTextures, resultText};
-    replacedStages.push_back(newStage);
+    replacedStages.push_back(ShaderStageSpecification{stage.stage, std::move(replacedUniforms),
+                                                      std::move(replacedAttributes), std::move(replacedTextures),
+                                                      std::move(resultText), stage.storageBuffers});
   }
 
   return replacedStages;
 }
 
+namespace {
+
+// Declarations of the frame-global uniforms, exactly as they appear in the shader sources and rules
+const std::vector<std::pair<std::string, std::string>> frameUniformDeclarations = {
+    {"u_projMatrix", "uniform mat4 u_projMatrix;"},
+    {"u_invProjMatrix", "uniform mat4 u_invProjMatrix;"},
+    {"u_viewport", "uniform vec4 u_viewport;"},
+    {"u_viewportDim", "uniform vec2 u_viewportDim;"},
+    {"u_slicePlaneCenters", "uniform vec4 u_slicePlaneCenters[" + std::to_string(maxSlicePlanes) + "];"},
+    {"u_slicePlaneNormals", "uniform vec4 u_slicePlaneNormals[" + std::to_string(maxSlicePlanes) + "];"},
+    {"u_slicePlaneCount", "uniform int u_slicePlaneCount;"},
+    {"u_impostorFallbackPixelSize", "uniform float u_impostorFallbackPixelSize;"},
+};
+
+// Must match the std140 layout written by the backend
+const std::string frameUniformBlockDeclaration = R"(
+layout(std140) uniform PolyscopeFrameUniforms {
+  mat4 u_projMatrix;
+  mat4 u_invProjMatrix;
+  vec4 u_viewport;
+  vec2 u_viewportDim;
+  vec4 u_slicePlaneCenters[)" + std::to_string(maxSlicePlanes) + R"(];
+  vec4 u_slicePlaneNormals[)" + std::to_string(maxSlicePlanes) + R"(];
+  int u_slicePlaneCount;
+  float u_impostorFallbackPixelSize;
+};
+)";
+
+bool isFrameUniform(const std::string& name) {
+  for (const std::pair<std::string, std::string>& d : frameUniformDeclarations) {
+    if (d.first == name) return true;
+  }
+  return false;
+}
+
+} // namespace
+
+const char* frameUniformBlockName = "PolyscopeFrameUniforms";
+
+std::vector<ShaderStageSpecification> useFrameUniformBlock(const std::vector<ShaderStageSpecification>& stages) {
+
+  std::vector<ShaderStageSpecification> updatedStages;
+  for (const ShaderStageSpecification& stage : stages) {
+
+    std::vector<ShaderSpecUniform> uniforms;
+    for (const ShaderSpecUniform& u : stage.uniforms) {
+      if (!isFrameUniform(u.name)) uniforms.push_back(u);
+    }
+
+    // Remove all of the individual declarations, and put the block where the first one was
+    std::string src = stage.src;
+    size_t firstPos = std::string::npos;
+    for (const std::pair<std::string, std::string>& d : frameUniformDeclarations) {
+      size_t pos;
+      while ((pos = src.find(d.second)) != std::string::npos) {
+        src.erase(pos, d.second.size());
+        if (firstPos == std::string::npos || pos < firstPos) firstPos = pos;
+      }
+    }
+    if (firstPos != std::string::npos) {
+      src.insert(firstPos, frameUniformBlockDeclaration);
+    }
+
+    updatedStages.push_back(
+        ShaderStageSpecification{stage.stage, uniforms, stage.attributes, stage.textures, src, stage.storageBuffers});
+  }
+
+  return updatedStages;
+}
+
+std::string programKeyFromStages(const std::vector<ShaderStageSpecification>& stages, DrawMode dm) {
+  std::stringstream builder;
+  builder << "$DRAWMODE: " << static_cast<int>(dm) << "\n";
+  for (const ShaderStageSpecification& stage : stages) {
+    builder << "$STAGE: " << static_cast<int>(stage.stage) << "\n";
+    for (const ShaderSpecUniform& u : stage.uniforms) {
+      builder << "$UNIFORM: " << u.name << " " << static_cast<int>(u.type) << "\n";
+    }
+    for (const ShaderSpecAttribute& a : stage.attributes) {
+      builder << "$ATTRIBUTE: " << a.name << " " << static_cast<int>(a.type) << " " << a.arrayCount << "\n";
+    }
+    for (const ShaderSpecTexture& t : stage.textures) {
+      builder << "$TEXTURE: " << t.name << " " << t.dim << "\n";
+    }
+    for (const ShaderSpecStorageBuffer& b : stage.storageBuffers) {
+      builder << "$STORAGEBUFFER: " << b.name << " " << static_cast<int>(b.type) << "\n";
+    }
+    builder << stage.src << "\n";
+  }
+  return builder.str();
+}
+
 } // namespace render
 } // namespace polyscope
@@ -262,5 +262,74 @@ std::vector<glm::uvec4> getAttributeBufferDataRange<glm::uvec4>(AttributeBuffer&
   return buff.getDataRange_uvec4(ind, count);
 }
 
+// == Get buffer data asynchronously
+
+namespace {
+
+// How values of type T are stored in a buffer: as `arity` consecutive entries of type Stored
+template <typename T>
+struct BufferStorage {
+  typedef T Stored;
+  static const size_t arity = 1;
+};
+template <>
+struct BufferStorage<double> {
+  typedef float Stored;
+  static const size_t arity = 1;
+};
+template <>
+struct BufferStorage<size_t> {
+  typedef uint32_t Stored;
+  static const size_t arity = 1;
+};
+template <size_t N>
+struct BufferStorage<std::array<glm::vec3, N>> {
+  typedef glm::vec3 Stored;
+  static const size_t arity = N;
+};
+
+template <typename T, typename S>
+void fromStorage(const S* src, T& dst) {
+  dst = static_cast<T>(*src);
+}
+template <size_t N>
+void fromStorage(const glm::vec3* src, std::array<glm::vec3, N>& dst) {
+  for (size_t j = 0; j < N; j++) dst[j] = src[j];
+}
+
+} // namespace
+
+template <typename T>
+void getAttributeBufferDataRangeAsync(AttributeBuffer& buff, size_t ind, size_t count,
+                                      std::function<void(std::vector<T>)> callback) {
+  typedef typename BufferStorage<T>::Stored S;
+  const size_t arity = BufferStorage<T>::arity;
+  buff.getDataRangeRawAsync(arity * ind, arity * count, [callback, count, arity](const void* data) {
+    const S* stored = static_cast<const S*>(data);
+    std::vector<T> out(count);
+    for (size_t i = 0; i < count; i++) {
+      fromStorage(stored + arity * i, out[i]);
+    }
+    callback(out);
+  });
+}
+
+// clang-format off
+template void getAttributeBufferDataRangeAsync<float>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<float>)>);
+template void getAttributeBufferDataRangeAsync<double>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<double>)>);
+template void getAttributeBufferDataRangeAsync<glm::vec2>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<glm::vec2>)>);
+template void getAttributeBufferDataRangeAsync<glm::vec3>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<glm::vec3>)>);
+template void getAttributeBufferDataRangeAsync<glm::vec4>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<glm::vec4>)>);
+template void getAttributeBufferDataRangeAsync<std::array<glm::vec3, 2>>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<std::array<glm::vec3, 2>>)>);
+template void getAttributeBufferDataRangeAsync<std::array<glm::vec3, 3>>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<std::array<glm::vec3, 3>>)>);
+template void getAttributeBufferDataRangeAsync<std::array<glm::vec3, 4>>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<std::array<glm::vec3, 4>>)>);
+template void getAttributeBufferDataRangeAsync<size_t>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<size_t>)>);
+template void getAttributeBufferDataRangeAsync<uint32_t>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<uint32_t>)>);
+template void getAttributeBufferDataRangeAsync<int32_t>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<int32_t>)>);
+template void getAttributeBufferDataRangeAsync<glm::uvec2>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<glm::uvec2>)>);
+template void getAttributeBufferDataRangeAsync<glm::uvec3>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<glm::uvec3>)>);
+template void getAttributeBufferDataRangeAsync<glm::uvec4>(AttributeBuffer&, size_t, size_t, std::function<void(std::vector<glm::uvec4>)>);
+// clang-format on
+
 } // namespace render
 } // namespace polyscope
@@ -6,6 +6,8 @@
 
 #include "imgui.h"
 
+#include "glm/gtc/packing.hpp"
+
 namespace polyscope {
 
 
@@ -38,20 +40,96 @@ void RenderImageQuantityBase::addOptionsPopupEntries() {
 
 void RenderImageQuantityBase::updateGeometryBuffers(const std::vector<float>& newDepthData,
                                                     const std::vector<glm::vec3>& newNormalData) {
+  updateGeometryBuffersRegion(0, 0, dimX, dimY, newDepthData, newNormalData);
+}
+
+void RenderImageQuantityBase::resizeGeometryBuffers(size_t newDimX, size_t newDimY,
+                                                    const std::vector<float>& newDepthData,
+                                                    const std::vector<glm::vec3>& newNormalData) {
+  if (newDepthData.size() != newDimX * newDimY || newNormalData.size() != newDimX * newDimY) {
+    exception("resized render image " + name + " should have " + std::to_string(newDimX * newDimY) + " pixels");
+  }
+  dimX = newDimX;
+  dimY = newDimY;
   depthData = newDepthData;
   normalData = newNormalData;
+  refresh();
+  requestRedraw();
+}
+
+void RenderImageQuantityBase::copyDepthRegion(size_t xStart, size_t yStart, size_t w, size_t h,
+                                              const std::vector<float>& newDepthData) {
+  if (xStart + w > dimX || yStart + h > dimY) {
+    exception("region update for " + name + " is out of bounds");
+  }
+  if (newDepthData.size() != w * h) {
+    exception("region update for " + name + " has " + std::to_string(newDepthData.size()) +
+              " depth values, expected " + std::to_string(w * h));
+  }
+
+  for (size_t j = 0; j < h; j++) {
+    std::copy(newDepthData.begin() + j * w, newDepthData.begin() + (j + 1) * w,
+              depthData.begin() + (yStart + j) * dimX + xStart);
+  }
 
-  // if prepared, re-prepare
-  // TODO do a fast update in the same buffer here
   if (textureDepth) {
-    prepareGeometryBuffers();
+    textureDepth->setDataRegion(xStart, yStart, w, h, &newDepthData.front());
+  }
+}
+
+void RenderImageQuantityBase::updateGeometryBuffersRegion(size_t xStart, size_t yStart, size_t w, size_t h,
+                                                          const std::vector<float>& newDepthData,
+                                                          const std::vector<glm::vec3>& newNormalData) {
+  if (w == 0 || h == 0) return;
+  if (newNormalData.size() != w * h) {
+    exception("region update for " + name + " has " + std::to_string(newNormalData.size()) +
+              " normal values, expected " + std::to_string(w * h));
+  }
+  copyDepthRegion(xStart, yStart, w, h, newDepthData);
+
+  for (size_t j = 0; j < h; j++) {
+    std::copy(newNormalData.begin() + j * w, newNormalData.begin() + (j + 1) * w,
+              normalData.begin() + (yStart + j) * dimX + xStart);
+  }
+
+  if (textureNormal) {
+    textureNormal->setDataRegion(xStart, yStart, w, h, static_cast<const float*>(&newNormalData.front()[0]));
   }
+
+  requestRedraw();
+}
+
+void RenderImageQuantityBase::updateGeometryBuffersRegionHalfNormals(size_t xStart, size_t yStart, size_t w, size_t h,
+                                                                     const std::vector<float>& newDepthData,
+                                                                     const std::vector<uint16_t>& newNormalDataHalf) {
+  if (w == 0 || h == 0) return;
+  if (newNormalDataHalf.size() != 3 * w * h) {
+    exception("region update for " + name + " has " + std::to_string(newNormalDataHalf.size()) +
+              " half-float normal components, expected " + std::to_string(3 * w * h));
+  }
+  copyDepthRegion(xStart, yStart, w, h, newDepthData);
+
+  // the host copy stays full precision
+  for (size_t j = 0; j < h; j++) {
+    for (size_t i = 0; i < w; i++) {
+      const uint16_t* n = &newNormalDataHalf[3 * (j * w + i)];
+      normalData[(yStart + j) * dimX + xStart + i] =
+          glm::vec3{glm::unpackHalf1x16(n[0]), glm::unpackHalf1x16(n[1]), glm::unpackHalf1x16(n[2])};
+    }
+  }
+
+  if (textureNormal) {
+    textureNormal->setDataRegionHalfFloat(xStart, yStart, w, h, &newNormalDataHalf.front());
+  }
+
+  requestRedraw();
 }
 
 void RenderImageQuantityBase::prepareGeometryBuffers() {
 
   // == depth texture
   textureDepth = render::engine->generateTextureBuffer(TextureFormat::R32F, dimX, dimY, &depthData.front());
+  textureDepth->setMemoryOwner(uniquePrefix() + "textureDepth");
 
   // == normal texture
 
@@ -60,6 +138,7 @@ void RenderImageQuantityBase::prepareGeometryBuffers() {
 
   textureNormal = render::engine->generateTextureBuffer(TextureFormat::RGB32F, dimX, dimY,
                                                         static_cast<float*>(&normalData.front()[0]));
+  textureNormal->setMemoryOwner(uniquePrefix() + "textureNormal");
 }
 
 void RenderImageQuantityBase::refresh() {
@@ -11,8 +11,9 @@ namespace polyscope {
 
 
 ScalarImageQuantity::ScalarImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY,
-                                         const std::vector<double>& data_, ImageOrigin imageOrigin_, DataType dataType_)
-    : ImageQuantity(parent_, name, dimX, dimY, imageOrigin_), ScalarQuantity(*this, data_, dataType_) {}
+                                         const std::vector<float>& data_, ImageOrigin imageOrigin_, DataType dataType_)
+    : ImageQuantity(parent_, name, dimX, dimY, imageOrigin_, TextureFormat::R32F),
+      ScalarQuantity(*this, data_, dataType_) {}
 
 
 void ScalarImageQuantity::buildCustomUI() {
@@ -34,32 +35,46 @@ void ScalarImageQuantity::buildCustomUI() {
   buildImageUI();
 }
 
-void ScalarImageQuantity::ensureRawTexturePopulated() {
-  if (textureRaw) return; // already populated, nothing to do
+bool ScalarImageQuantity::ensureRawTexturePopulated() {
+  if (textureRaw) return true; // already populated, nothing to do
+  if (!acquireTextureUpload()) return false;
 
   // Must be rendering from a buffer of data, copy it over (common case)
 
   values.ensureHostBufferPopulated();
-  const std::vector<double>& srcData = values.data;
+  const std::vector<float>& srcData = values.data;
   std::vector<float> srcDataFloat(srcData.size());
   for (size_t i = 0; i < srcData.size(); i++) {
     srcDataFloat[i] = static_cast<float>(srcData[i]);
   }
-  textureRaw = render::engine->generateTextureBuffer(TextureFormat::R32F, dimX, dimY, &(srcDataFloat.front()));
+  textureRaw = render::engine->generateTextureBuffer(textureFormat, dimX, dimY, &(srcDataFloat.front()));
+  textureRaw->setMemoryOwner(uniquePrefix() + "textureRaw");
+  return true;
+}
+
+bool ScalarImageQuantity::textureFormatSupported(TextureFormat format) {
+  return format == TextureFormat::R16F || format == TextureFormat::R32F;
+}
+
+void ScalarImageQuantity::releaseTextures() {
+  fullscreenProgram.reset();
+  billboardProgram.reset();
+  textureRaw.reset();
+  framebufferIntermediate.reset();
+  textureIntermediateRendered.reset();
 }
 
 void ScalarImageQuantity::prepareIntermediateRender() {
   // Texture and sourceProgram for rendering in
   framebufferIntermediate = render::engine->generateFrameBuffer(dimX, dimY);
   textureIntermediateRendered = render::engine->generateTextureBuffer(TextureFormat::RGB16F, dimX, dimY);
+  textureIntermediateRendered->setMemoryOwner(uniquePrefix() + "textureIntermediateRendered");
   framebufferIntermediate->addColorBuffer(textureIntermediateRendered);
   framebufferIntermediate->setViewport(0, 0, dimX, dimY);
 }
 
 void ScalarImageQuantity::prepareFullscreen() {
 
-  ensureRawTexturePopulated();
-
   // Create the sourceProgram
   fullscreenProgram = render::engine->requestShader(
       "SCALAR_TEXTURE_COLORMAP", this->addScalarRules({getImageOriginRule(imageOrigin), "TEXTURE_SET_TRANSPARENCY"}),
@@ -71,8 +86,6 @@ void ScalarImageQuantity::prepareFullscreen() {
 
 void ScalarImageQuantity::prepareBillboard() {
 
-  ensureRawTexturePopulated();
-
   // Create the sourceProgram
   billboardProgram =
       render::engine->requestShader("SCALAR_TEXTURE_COLORMAP",
@@ -86,6 +99,7 @@ void ScalarImageQuantity::prepareBillboard() {
 
 void ScalarImageQuantity::showFullscreen() {
 
+  if (!ensureRawTexturePopulated()) return;
   if (!fullscreenProgram) {
     prepareFullscreen();
   }
@@ -100,9 +114,9 @@ void ScalarImageQuantity::showFullscreen() {
 }
 
 void ScalarImageQuantity::renderIntermediate() {
+  if (!ensureRawTexturePopulated()) return;
   if (!fullscreenProgram) prepareFullscreen();
   if (!textureIntermediateRendered) prepareIntermediateRender();
-  ensureRawTexturePopulated();
 
   // Set uniforms
   this->setScalarUniforms(*fullscreenProgram);
@@ -135,6 +149,7 @@ void ScalarImageQuantity::showInImGuiWindow() {
 
 void ScalarImageQuantity::showInBillboard(glm::vec3 center, glm::vec3 upVec, glm::vec3 rightVec) {
 
+  if (!ensureRawTexturePopulated()) return;
   if (!billboardProgram) {
     prepareBillboard();
   }
@@ -178,7 +193,7 @@ ScalarImageQuantity* ScalarImageQuantity::setEnabled(bool newEnabled) {
 // Instantiate a construction helper which is used to avoid header dependencies. See forward declaration and note in
 // structure.ipp.
 ScalarImageQuantity* createScalarImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
-                                               const std::vector<double>& data, ImageOrigin imageOrigin,
+                                               const std::vector<float>& data, ImageOrigin imageOrigin,
                                                DataType dataType) {
   return new ScalarImageQuantity(parent, name, dimX, dimY, data, imageOrigin, dataType);
 }
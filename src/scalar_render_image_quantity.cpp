@@ -13,7 +13,7 @@ namespace polyscope {
 ScalarRenderImageQuantity::ScalarRenderImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY,
                                                      const std::vector<float>& depthData,
                                                      const std::vector<glm::vec3>& normalData,
-                                                     const std::vector<double>& scalarData_, ImageOrigin imageOrigin,
+                                                     const std::vector<float>& scalarData_, ImageOrigin imageOrigin,
                                                      DataType dataType_)
     : RenderImageQuantityBase(parent_, name, dimX, dimY, depthData, normalData, imageOrigin),
       ScalarQuantity(*this, scalarData_, dataType_) {}
@@ -26,12 +26,6 @@ void ScalarRenderImageQuantity::drawDelayed() {
   if (!program) prepare();
 
   // set uniforms
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-
-  program->setUniform("u_projMatrix", glm::value_ptr(P));
-  program->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  program->setUniform("u_viewport", render::engine->getCurrentViewport());
   program->setUniform("u_transparency", transparency.get());
 
   setScalarUniforms(*program);
@@ -76,13 +70,8 @@ void ScalarRenderImageQuantity::prepare() {
 
   // push the color data to the buffer
   values.ensureHostBufferPopulated();
-  std::vector<float> floatData(values.data.size());
-  for (size_t i = 0; i < values.data.size(); i++) {
-    floatData[i] = static_cast<float>(values.data[i]);
-  }
-
-  textureScalar =
-      render::engine->generateTextureBuffer(TextureFormat::R32F, dimX, dimY, static_cast<float*>(&floatData.front()));
+  textureScalar = render::engine->generateTextureBuffer(TextureFormat::R32F, dimX, dimY, &values.data.front());
+  textureScalar->setMemoryOwner(uniquePrefix() + "textureScalar");
 
   // Create the sourceProgram
   program = render::engine->requestShader("TEXTURE_DRAW_RENDERIMAGE_PLAIN",
@@ -113,7 +102,7 @@ ScalarRenderImageQuantity* ScalarRenderImageQuantity::setEnabled(bool newEnabled
 ScalarRenderImageQuantity* createScalarRenderImage(Structure& parent, std::string name, size_t dimX, size_t dimY,
                                                    const std::vector<float>& depthData,
                                                    const std::vector<glm::vec3>& normalData,
-                                                   const std::vector<double>& scalarData, ImageOrigin imageOrigin,
+                                                   const std::vector<float>& scalarData, ImageOrigin imageOrigin,
                                                    DataType dataType) {
 
   return new ScalarRenderImageQuantity(parent, name, dimX, dimY, depthData, normalData, scalarData, imageOrigin,
@@ -0,0 +1,513 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/scene_file.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/persistent_value.h"
+#include "polyscope/point_cloud.h"
+#include "polyscope/point_cloud_color_quantity.h"
+#include "polyscope/point_cloud_scalar_quantity.h"
+#include "polyscope/polyscope.h"
+#include "polyscope/surface_color_quantity.h"
+#include "polyscope/surface_mesh.h"
+#include "polyscope/surface_scalar_quantity.h"
+
+#include "json/json.hpp"
+using json = nlohmann::json;
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace polyscope {
+
+namespace {
+
+// File layout: fixed header, json metadata, then the binary blobs the metadata refers to, each aligned so they can be
+// used in place from the mapped file.
+const char sceneFileMagic[8] = {'P', 'S', 'S', 'C', 'E', 'N', 'E', '\0'};
+const uint32_t sceneFileVersion = 1;
+const size_t blobAlignment = 64;
+
+struct SceneFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t metadataBytes;
+};
+
+size_t alignUp(size_t x) { return (x + blobAlignment - 1) / blobAlignment * blobAlignment; }
+
+// == Writing
+
+struct BlobWriter {
+  std::vector<std::pair<const void*, size_t>> blobs;
+  size_t dataBytes = 0;
+
+  // Returns the description of the blob stored in the json metadata. Offsets are relative to the start of the data.
+  template <typename T>
+  json add(const T* ptr, size_t count) {
+    size_t bytes = count * sizeof(T);
+    json entry = {{"offset", dataBytes}, {"count", count}};
+    blobs.emplace_back(ptr, bytes);
+    dataBytes = alignUp(dataBytes + bytes);
+    return entry;
+  }
+};
+
+template <typename T>
+json blobForBuffer(BlobWriter& writer, render::ManagedBuffer<T>& buffer) {
+  const T* ptr = buffer.getPopulatedHostDataPtr();
+  return writer.add(ptr, buffer.size());
+}
+
+template <typename T>
+json blobForVector(BlobWriter& writer, const std::vector<T>& vec) {
+  return writer.add(vec.data(), vec.size());
+}
+
+json scalarQuantityEntry(BlobWriter& writer, std::string location, std::string name, render::ManagedBuffer<float>& values,
+                         DataType dataType) {
+  return {{"kind", "scalar"},
+          {"location", location},
+          {"name", name},
+          {"dataType", static_cast<int>(dataType)},
+          {"values", blobForBuffer(writer, values)}};
+}
+
+json colorQuantityEntry(BlobWriter& writer, std::string location, std::string name,
+                        render::ManagedBuffer<glm::vec3>& colors) {
+  return {{"kind", "color"}, {"location", location}, {"name", name}, {"values", blobForBuffer(writer, colors)}};
+}
+
+template <typename QuantityT>
+json colorQuantityEntry(BlobWriter& writer, std::string location, ColorQuantity<QuantityT>& colorQ) {
+  if (colorQ.isPacked()) {
+    return {{"kind", "colorPacked"},
+            {"location", location},
+            {"name", colorQ.quantity.name},
+            {"values", blobForBuffer(writer, colorQ.colorsPacked)}};
+  }
+  return colorQuantityEntry(writer, location, colorQ.quantity.name, colorQ.colors);
+}
+
+json pointCloudEntry(BlobWriter& writer, PointCloud& cloud) {
+  json quantities = json::array();
+  for (std::pair<const std::string, std::unique_ptr<PointCloudQuantity>>& entry : cloud.quantities) {
+    Quantity* q = entry.second.get();
+    if (PointCloudScalarQuantity* scalarQ = dynamic_cast<PointCloudScalarQuantity*>(q)) {
+      quantities.push_back(scalarQuantityEntry(writer, "point", q->name, scalarQ->values, scalarQ->getDataType()));
+    } else if (PointCloudColorQuantity* colorQ = dynamic_cast<PointCloudColorQuantity*>(q)) {
+      quantities.push_back(colorQuantityEntry(writer, "point", *colorQ));
+    } else {
+      warning("saveScene(): skipping quantity " + q->name + " on point cloud " + cloud.name,
+              "only scalar and color quantities are saved");
+    }
+  }
+
+  return {{"type", PointCloud::structureTypeName},
+          {"name", cloud.name},
+          {"points", blobForBuffer(writer, cloud.points)},
+          {"quantities", quantities}};
+}
+
+json surfaceMeshEntry(BlobWriter& writer, SurfaceMesh& mesh) {
+  json quantities = json::array();
+  for (std::pair<const std::string, std::unique_ptr<SurfaceMeshQuantity>>& entry : mesh.quantities) {
+    Quantity* q = entry.second.get();
+    if (SurfaceVertexScalarQuantity* scalarQ = dynamic_cast<SurfaceVertexScalarQuantity*>(q)) {
+      quantities.push_back(scalarQuantityEntry(writer, "vertex", q->name, scalarQ->values, scalarQ->getDataType()));
+    } else if (SurfaceFaceScalarQuantity* scalarQ = dynamic_cast<SurfaceFaceScalarQuantity*>(q)) {
+      quantities.push_back(scalarQuantityEntry(writer, "face", q->name, scalarQ->values, scalarQ->getDataType()));
+    } else if (SurfaceVertexColorQuantity* colorQ = dynamic_cast<SurfaceVertexColorQuantity*>(q)) {
+      quantities.push_back(colorQuantityEntry(writer, "vertex", *colorQ));
+    } else if (SurfaceFaceColorQuantity* colorQ = dynamic_cast<SurfaceFaceColorQuantity*>(q)) {
+      quantities.push_back(colorQuantityEntry(writer, "face", q->name, colorQ->colors));
+    } else {
+      warning("saveScene(): skipping quantity " + q->name + " on surface mesh " + mesh.name,
+              "only vertex/face scalar and color quantities are saved");
+    }
+  }
+
+  // (getting the derived buffers computes them if needed, so that loading never has to)
+  json result = {{"type", SurfaceMesh::structureTypeName},
+          {"name", mesh.name},
+          {"vertexPositions", blobForBuffer(writer, mesh.vertexPositions)},
+          {"faceIndsStart", blobForVector(writer, mesh.faceIndsStart)},
+          {"faceIndsEntries", blobForVector(writer, mesh.faceIndsEntries)},
+          {"triangleVertexInds", blobForBuffer(writer, mesh.triangleVertexInds)},
+          {"triangleFaceInds", blobForBuffer(writer, mesh.triangleFaceInds)},
+          {"baryCoord", blobForBuffer(writer, mesh.baryCoord)},
+          {"edgeIsReal", blobForBuffer(writer, mesh.edgeIsReal)},
+          {"quantities", quantities}};
+  if (mesh.optimizeDrawOrder) {
+    // the triangle buffers above are in the optimized order (for a view, the source's)
+    std::vector<uint32_t> triangleStartOfFace(mesh.nFaces());
+    for (size_t iF = 0; iF < mesh.nFaces(); iF++) {
+      triangleStartOfFace[iF] = mesh.faceTriangleStart(iF);
+    }
+    result["triangleStartOfFace"] = blobForVector(writer, triangleStartOfFace);
+  }
+  return result;
+}
+
+// == Persistent values
+
+json vec3ToJSON(glm::vec3 v) { return {v.x, v.y, v.z}; }
+glm::vec3 vec3FromJSON(const json& j) { return glm::vec3{j[0].get<float>(), j[1].get<float>(), j[2].get<float>()}; }
+
+json mat4ToJSON(const glm::mat4& m) {
+  json result = json::array();
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) result.push_back(m[i][j]);
+  }
+  return result;
+}
+glm::mat4 mat4FromJSON(const json& j) {
+  glm::mat4 m;
+  for (int i = 0; i < 4; i++) {
+    for (int k = 0; k < 4; k++) m[i][k] = j[4 * i + k].get<float>();
+  }
+  return m;
+}
+
+template <typename T, typename F>
+json cacheToJSON(F toJSON) {
+  json result = json::object();
+  const detail::PersistentCache<T>& cache = detail::getPersistentCacheRef<T>();
+  for (size_t i = 0; i < cache.keys.size(); i++) {
+    if (cache.keys[i] == detail::INVALID_PERSISTENT_KEY) continue;
+    result[detail::persistentName(cache.keys[i])] = toJSON(cache.values[i]);
+  }
+  return result;
+}
+
+template <typename T, typename F>
+void cacheFromJSON(const json& j, const std::string& key, F fromJSON) {
+  if (j.find(key) == j.end()) return;
+  for (json::const_iterator it = j[key].begin(); it != j[key].end(); ++it) {
+    detail::getPersistentCacheRef<T>().set(it.key(), fromJSON(it.value()));
+  }
+}
+
+template <typename T>
+json plainToJSON(const T& v) {
+  return v;
+}
+template <typename T>
+json enumToJSON(const T& v) {
+  return static_cast<int>(v);
+}
+template <typename T>
+json scaledToJSON(const ScaledValue<T>& v) {
+  ScaledValue<T> copy = v;
+  return {*copy.getValuePtr(), copy.isRelative()};
+}
+
+json persistentValuesToJSON() {
+  return {
+      {"double", cacheToJSON<double>(plainToJSON<double>)},
+      {"float", cacheToJSON<float>(plainToJSON<float>)},
+      {"bool", cacheToJSON<bool>(plainToJSON<bool>)},
+      {"string", cacheToJSON<std::string>(plainToJSON<std::string>)},
+      {"vec3", cacheToJSON<glm::vec3>(vec3ToJSON)},
+      {"mat4", cacheToJSON<glm::mat4>(mat4ToJSON)},
+      {"scaledDouble", cacheToJSON<ScaledValue<double>>(scaledToJSON<double>)},
+      {"scaledFloat", cacheToJSON<ScaledValue<float>>(scaledToJSON<float>)},
+      {"stringList", cacheToJSON<std::vector<std::string>>(plainToJSON<std::vector<std::string>>)},
+      {"paramVizStyle", cacheToJSON<ParamVizStyle>(enumToJSON<ParamVizStyle>)},
+      {"backFacePolicy", cacheToJSON<BackFacePolicy>(enumToJSON<BackFacePolicy>)},
+      {"meshShadeStyle", cacheToJSON<MeshShadeStyle>(enumToJSON<MeshShadeStyle>)},
+  };
+}
+
+template <typename T>
+T plainFromJSON(const json& j) {
+  return j.get<T>();
+}
+template <typename T>
+T enumFromJSON(const json& j) {
+  return static_cast<T>(j.get<int>());
+}
+template <typename T>
+ScaledValue<T> scaledFromJSON(const json& j) {
+  return ScaledValue<T>(j[0].get<T>(), j[1].get<bool>());
+}
+
+void persistentValuesFromJSON(const json& j) {
+  cacheFromJSON<double>(j, "double", plainFromJSON<double>);
+  cacheFromJSON<float>(j, "float", plainFromJSON<float>);
+  cacheFromJSON<bool>(j, "bool", plainFromJSON<bool>);
+  cacheFromJSON<std::string>(j, "string", plainFromJSON<std::string>);
+  cacheFromJSON<glm::vec3>(j, "vec3", vec3FromJSON);
+  cacheFromJSON<glm::mat4>(j, "mat4", mat4FromJSON);
+  cacheFromJSON<ScaledValue<double>>(j, "scaledDouble", scaledFromJSON<double>);
+  cacheFromJSON<ScaledValue<float>>(j, "scaledFloat", scaledFromJSON<float>);
+  cacheFromJSON<std::vector<std::string>>(j, "stringList", plainFromJSON<std::vector<std::string>>);
+  cacheFromJSON<ParamVizStyle>(j, "paramVizStyle", enumFromJSON<ParamVizStyle>);
+  cacheFromJSON<BackFacePolicy>(j, "backFacePolicy", enumFromJSON<BackFacePolicy>);
+  cacheFromJSON<MeshShadeStyle>(j, "meshShadeStyle", enumFromJSON<MeshShadeStyle>);
+}
+
+// == Reading
+
+// The whole file, mapped read-only (or read in to memory where mapping is unavailable)
+class MappedSceneFile {
+public:
+  MappedSceneFile(const std::string& filename) {
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr != MAP_FAILED) {
+        mapped = static_cast<const unsigned char*>(ptr);
+        mappedBytes = st.st_size;
+      }
+    }
+    close(fd); // the mapping stays valid
+#else
+    std::ifstream inFile(filename, std::ios::binary | std::ios::ate);
+    if (!inFile) return;
+    fallbackData.resize(static_cast<size_t>(inFile.tellg()));
+    inFile.seekg(0);
+    inFile.read(reinterpret_cast<char*>(fallbackData.data()), fallbackData.size());
+    mapped = fallbackData.data();
+    mappedBytes = fallbackData.size();
+#endif
+  }
+
+  ~MappedSceneFile() {
+#ifndef _WIN32
+    if (mapped != nullptr) munmap(const_cast<unsigned char*>(mapped), mappedBytes);
+#endif
+  }
+
+  MappedSceneFile(const MappedSceneFile&) = delete;
+  MappedSceneFile& operator=(const MappedSceneFile&) = delete;
+
+  const unsigned char* mapped = nullptr;
+  size_t mappedBytes = 0;
+  size_t dataStart = 0;
+
+private:
+#ifdef _WIN32
+  std::vector<unsigned char> fallbackData;
+#endif
+};
+
+template <typename T>
+const T* blobPtr(const MappedSceneFile& file, const json& entry, size_t& count) {
+  size_t offset = entry["offset"].get<size_t>();
+  count = entry["count"].get<size_t>();
+  size_t start = file.dataStart + offset;
+  if (start > file.mappedBytes || count > (file.mappedBytes - start) / sizeof(T)) {
+    exception("scene file is truncated or corrupt");
+  }
+  return reinterpret_cast<const T*>(file.mapped + start);
+}
+
+template <typename T>
+std::vector<T> blobVector(const MappedSceneFile& file, const json& entry) {
+  size_t count;
+  const T* ptr = blobPtr<T>(file, entry, count);
+  return std::vector<T>(ptr, ptr + count);
+}
+
+template <typename T>
+void setBufferFromBlob(render::ManagedBuffer<T>& buffer, const std::shared_ptr<MappedSceneFile>& file,
+                       const json& entry, size_t expectedCount) {
+  size_t count;
+  const T* ptr = blobPtr<T>(*file, entry, count);
+  if (count != expectedCount) exception("scene file buffer " + buffer.name + " has the wrong size");
+  buffer.setExternalData(ptr, count, file);
+}
+
+void loadPointCloud(const std::shared_ptr<MappedSceneFile>& file, const json& entry) {
+  std::string name = entry["name"].get<std::string>();
+  size_t nPoints;
+  const glm::vec3* points = blobPtr<glm::vec3>(*file, entry["points"], nPoints);
+  PointCloud* cloud = registerPointCloud(name, points, nPoints, file);
+
+  for (const json& qEntry : entry["quantities"]) {
+    std::string qName = qEntry["name"].get<std::string>();
+    if (qEntry["kind"] == "scalar") {
+      std::vector<float> values = blobVector<float>(*file, qEntry["values"]);
+      cloud->addScalarQuantity(qName, values, static_cast<DataType>(qEntry["dataType"].get<int>()));
+    } else if (qEntry["kind"] == "color") {
+      cloud->addColorQuantity(qName, blobVector<glm::vec3>(*file, qEntry["values"]));
+    } else if (qEntry["kind"] == "colorPacked") {
+      cloud->addPackedColorQuantity(qName, blobVector<uint32_t>(*file, qEntry["values"]));
+    }
+  }
+}
+
+void loadSurfaceMesh(const std::shared_ptr<MappedSceneFile>& file, const json& entry) {
+  std::string name = entry["name"].get<std::string>();
+
+  SurfaceMesh* mesh = new SurfaceMesh(name);
+  size_t nVerts;
+  const glm::vec3* positions = blobPtr<glm::vec3>(*file, entry["vertexPositions"], nVerts);
+  mesh->vertexPositions.setExternalData(positions, nVerts, file);
+  mesh->faceIndsStart = blobVector<uint32_t>(*file, entry["faceIndsStart"]);
+  mesh->faceIndsEntries = blobVector<uint32_t>(*file, entry["faceIndsEntries"]);
+  if (mesh->faceIndsStart.empty()) exception("scene file surface mesh " + name + " has no face list");
+
+  // the triangulation comes from the file, so don't start computing it in the background
+  bool prepareInBackground = options::prepareStructuresInBackground;
+  options::prepareStructuresInBackground = false;
+  mesh->computeConnectivityData();
+  options::prepareStructuresInBackground = prepareInBackground;
+
+  size_t nTriCorners = 3 * mesh->nFacesTriangulation();
+  setBufferFromBlob(mesh->triangleVertexInds, file, entry["triangleVertexInds"], nTriCorners);
+  setBufferFromBlob(mesh->triangleFaceInds, file, entry["triangleFaceInds"], nTriCorners);
+  setBufferFromBlob(mesh->baryCoord, file, entry["baryCoord"], nTriCorners);
+  setBufferFromBlob(mesh->edgeIsReal, file, entry["edgeIsReal"], nTriCorners);
+  mesh->optimizeDrawOrder = entry.find("triangleStartOfFace") != entry.end();
+  if (mesh->optimizeDrawOrder) {
+    mesh->triangleStartOfFace = blobVector<uint32_t>(*file, entry["triangleStartOfFace"]);
+    if (mesh->triangleStartOfFace.size() != mesh->nFaces()) {
+      exception("scene file surface mesh " + name + " has a draw order of the wrong size");
+    }
+  }
+  mesh->updateObjectSpaceBounds();
+
+  bool success = registerStructure(mesh);
+  if (!success) {
+    safeDelete(mesh);
+    return;
+  }
+
+  for (const json& qEntry : entry["quantities"]) {
+    std::string qName = qEntry["name"].get<std::string>();
+    bool onVertices = qEntry["location"] == "vertex";
+    if (qEntry["kind"] == "scalar") {
+      std::vector<float> values = blobVector<float>(*file, qEntry["values"]);
+      DataType dataType = static_cast<DataType>(qEntry["dataType"].get<int>());
+      if (onVertices) {
+        mesh->addVertexScalarQuantity(qName, values, dataType);
+      } else {
+        mesh->addFaceScalarQuantity(qName, values, dataType);
+      }
+    } else if (qEntry["kind"] == "color") {
+      std::vector<glm::vec3> colors = blobVector<glm::vec3>(*file, qEntry["values"]);
+      if (onVertices) {
+        mesh->addVertexColorQuantity(qName, colors);
+      } else {
+        mesh->addFaceColorQuantity(qName, colors);
+      }
+    } else if (qEntry["kind"] == "colorPacked" && onVertices) {
+      mesh->addPackedVertexColorQuantity(qName, blobVector<uint32_t>(*file, qEntry["values"]));
+    }
+  }
+}
+
+} // namespace
+
+void saveScene(std::string filename) {
+  checkInitialized();
+
+  BlobWriter writer;
+  json structures = json::array();
+  for (auto& cat : state::structures) {
+    for (std::pair<const std::string, std::shared_ptr<Structure>>& entry : cat.second) {
+      Structure* s = entry.second.get();
+      if (PointCloud* cloud = dynamic_cast<PointCloud*>(s)) {
+        structures.push_back(pointCloudEntry(writer, *cloud));
+      } else if (SurfaceMesh* mesh = dynamic_cast<SurfaceMesh*>(s)) {
+        structures.push_back(surfaceMeshEntry(writer, *mesh));
+      } else {
+        warning("saveScene(): skipping structure " + s->name, "only point clouds and surface meshes are saved");
+      }
+    }
+  }
+
+  json metadata = {{"structures", structures}, {"persistentValues", persistentValuesToJSON()}};
+  std::string metadataStr = metadata.dump();
+
+  SceneFileHeader header;
+  std::memcpy(header.magic, sceneFileMagic, sizeof(sceneFileMagic));
+  header.version = sceneFileVersion;
+  header.reserved = 0;
+  header.metadataBytes = metadataStr.size();
+
+  std::ofstream outFile(filename, std::ios::binary);
+  if (!outFile) {
+    exception("saveScene(): could not open " + filename + " for writing");
+    return;
+  }
+
+  const char padding[blobAlignment] = {};
+  outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  outFile.write(metadataStr.data(), metadataStr.size());
+  size_t pos = sizeof(header) + metadataStr.size();
+  outFile.write(padding, alignUp(pos) - pos);
+
+  for (const std::pair<const void*, size_t>& blob : writer.blobs) {
+    outFile.write(static_cast<const char*>(blob.first), blob.second);
+    outFile.write(padding, alignUp(blob.second) - blob.second);
+  }
+
+  if (!outFile) {
+    exception("saveScene(): failed writing " + filename);
+  }
+}
+
+void loadScene(std::string filename) {
+  checkInitialized();
+
+  std::shared_ptr<MappedSceneFile> file = std::make_shared<MappedSceneFile>(filename);
+  if (file->mapped == nullptr) {
+    exception("loadScene(): could not open " + filename);
+    return;
+  }
+
+  SceneFileHeader header;
+  if (file->mappedBytes < sizeof(header)) {
+    exception("loadScene(): " + filename + " is not a scene file");
+    return;
+  }
+  std::memcpy(&header, file->mapped, sizeof(header));
+  if (std::memcmp(header.magic, sceneFileMagic, sizeof(sceneFileMagic)) != 0) {
+    exception("loadScene(): " + filename + " is not a scene file");
+    return;
+  }
+  if (header.version != sceneFileVersion) {
+    exception("loadScene(): " + filename + " has unsupported version " + std::to_string(header.version));
+    return;
+  }
+  if (header.metadataBytes > file->mappedBytes - sizeof(header)) {
+    exception("loadScene(): " + filename + " is truncated or corrupt");
+    return;
+  }
+  file->dataStart = alignUp(sizeof(header) + header.metadataBytes);
+
+  const char* metadataStart = reinterpret_cast<const char*>(file->mapped + sizeof(header));
+  json metadata = json::parse(metadataStart, metadataStart + header.metadataBytes);
+
+  // Restore the options first, so the structures pick them up as they are registered
+  persistentValuesFromJSON(metadata["persistentValues"]);
+
+  for (const json& entry : metadata["structures"]) {
+    std::string type = entry["type"].get<std::string>();
+
+    if (type == PointCloud::structureTypeName) {
+      loadPointCloud(file, entry);
+    } else if (type == SurfaceMesh::structureTypeName) {
+      loadSurfaceMesh(file, entry);
+    }
+  }
+}
+
+} // namespace polyscope
@@ -2,11 +2,20 @@
 
 #include "polyscope/screenshot.h"
 
+#include "polyscope/parallel.h"
+#include "polyscope/pick.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/view.h"
 
 #include "stb_image_write.h"
 
 #include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <memory>
 #include <string>
 
 namespace polyscope {
@@ -33,17 +42,50 @@ bool hasExtension(std::string str, std::string ext) {
   }
 }
 
-} // namespace
+// Image files which are being encoded in the background, oldest first
+std::deque<std::future<void>> pendingImageWrites;
 
+size_t maxPendingImageWrites() { return workerThreadCount(); }
 
-void saveImage(std::string name, unsigned char* buffer, int w, int h, int channels) {
+void waitForImageWrites(size_t maxRemaining) {
+  while (pendingImageWrites.size() > maxRemaining) {
+    pendingImageWrites.front().get();
+    pendingImageWrites.pop_front();
+  }
+}
+
+// Set the global stb options used by writeImageFile(). These are read by the encoding threads, so they are only ever
+// changed on the main thread, once no writes are in flight.
+void setImageWriteOptions() {
+  static bool flipSet = false;
+  if (!flipSet || stbi_write_png_compression_level != options::screenshotPNGCompressionLevel) {
+    waitForImageWrites(0);
+    // our buffers are from openGL, so they are flipped
+    stbi_flip_vertically_on_write(1);
+    stbi_write_png_compression_level = options::screenshotPNGCompressionLevel;
+    flipSet = true;
+  }
+}
 
-  // our buffers are from openGL, so they are flipped
-  stbi_flip_vertically_on_write(1);
-  stbi_write_png_compression_level = 0;
+// Uncompressed pixels, top row first, with no header
+void writeRawImageFile(std::string name, unsigned char* buffer, int w, int h, int channels) {
+  std::ofstream outFile(name, std::ios::binary);
+  if (!outFile) {
+    return;
+  }
+  size_t rowBytes = static_cast<size_t>(channels) * w;
+  for (int j = h - 1; j >= 0; j--) {
+    outFile.write(reinterpret_cast<const char*>(buffer + j * rowBytes), rowBytes);
+  }
+}
+
+// Safe to call concurrently, once setImageWriteOptions() has been called
+void writeImageFile(std::string name, unsigned char* buffer, int w, int h, int channels) {
 
   // Auto-detect filename
-  if (hasExtension(name, ".png")) {
+  if (hasExtension(name, ".raw")) {
+    writeRawImageFile(name, buffer, w, h, channels);
+  } else if (hasExtension(name, ".png")) {
     stbi_write_png(name.c_str(), w, h, channels, buffer, channels * w);
   } else if (hasExtension(name, ".jpg") || hasExtension(name, "jpeg")) {
     stbi_write_jpg(name.c_str(), w, h, channels, buffer, 100);
@@ -63,7 +105,159 @@ void saveImage(std::string name, unsigned char* buffer, int w, int h, int channe
   }
 }
 
-void screenshot(std::string filename, bool transparentBG) {
+// Writes an RGBA png a few rows at a time, as they arrive. stb can only compress a whole image at once, so the pixels
+// are written in uncompressed deflate blocks; the file is about the size of the raw pixels.
+class StreamingPNGWriter {
+public:
+  StreamingPNGWriter(std::ostream& out_, int w, int h) : out(out_), rowBytes(4 * static_cast<size_t>(w)) {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      crcTable[n] = c;
+    }
+
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    out.write(reinterpret_cast<const char*>(signature), 8);
+    std::vector<unsigned char> header;
+    appendBigEndian(header, static_cast<uint32_t>(w));
+    appendBigEndian(header, static_cast<uint32_t>(h));
+    header.insert(header.end(), {8, 6, 0, 0, 0}); // 8 bits, RGBA, deflate, no filtering, no interlacing
+    writeChunk("IHDR", header);
+  }
+
+  // Rows of RGBA pixels, top row first
+  void writeRows(const unsigned char* rows, int nRows) {
+    std::vector<unsigned char> filtered;
+    filtered.reserve((rowBytes + 1) * nRows);
+    for (int j = 0; j < nRows; j++) {
+      filtered.push_back(0); // no filter
+      filtered.insert(filtered.end(), rows + j * rowBytes, rows + (j + 1) * rowBytes);
+    }
+    for (size_t start = 0; start < filtered.size(); start += 5552) { // the most bytes before the sums can overflow
+      size_t end = std::min(filtered.size(), start + 5552);
+      for (size_t i = start; i < end; i++) {
+        adlerA += filtered[i];
+        adlerB += adlerA;
+      }
+      adlerA %= 65521;
+      adlerB %= 65521;
+    }
+
+    std::vector<unsigned char> data;
+    if (!startedStream) {
+      data.insert(data.end(), {0x78, 0x01}); // zlib header
+      startedStream = true;
+    }
+    for (size_t start = 0; start < filtered.size(); start += 65535) {
+      uint16_t len = static_cast<uint16_t>(std::min<size_t>(65535, filtered.size() - start));
+      appendStoredBlockHeader(data, len, false);
+      data.insert(data.end(), filtered.begin() + start, filtered.begin() + start + len);
+    }
+    writeChunk("IDAT", data);
+  }
+
+  void finish() {
+    std::vector<unsigned char> data;
+    if (!startedStream) data.insert(data.end(), {0x78, 0x01});
+    appendStoredBlockHeader(data, 0, true);
+    appendBigEndian(data, (adlerB << 16) | adlerA);
+    writeChunk("IDAT", data);
+    writeChunk("IEND", {});
+  }
+
+private:
+  std::ostream& out;
+  size_t rowBytes;
+  uint32_t crcTable[256];
+  uint32_t adlerA = 1;
+  uint32_t adlerB = 0;
+  bool startedStream = false;
+
+  static void appendBigEndian(std::vector<unsigned char>& data, uint32_t v) {
+    data.insert(data.end(), {static_cast<unsigned char>(v >> 24), static_cast<unsigned char>(v >> 16),
+                             static_cast<unsigned char>(v >> 8), static_cast<unsigned char>(v)});
+  }
+
+  static void appendStoredBlockHeader(std::vector<unsigned char>& data, uint16_t len, bool final) {
+    uint16_t nlen = static_cast<uint16_t>(~len);
+    data.insert(data.end(), {static_cast<unsigned char>(final ? 1 : 0), static_cast<unsigned char>(len & 0xFF),
+                             static_cast<unsigned char>(len >> 8), static_cast<unsigned char>(nlen & 0xFF),
+                             static_cast<unsigned char>(nlen >> 8)});
+  }
+
+  void writeChunk(const char* type, const std::vector<unsigned char>& data) {
+    std::vector<unsigned char> length;
+    appendBigEndian(length, static_cast<uint32_t>(data.size()));
+    out.write(reinterpret_cast<const char*>(length.data()), 4);
+
+    uint32_t crc = 0xFFFFFFFFu;
+    auto addCRC = [&](const unsigned char* bytes, size_t n) {
+      for (size_t i = 0; i < n; i++) crc = crcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    };
+    addCRC(reinterpret_cast<const unsigned char*>(type), 4);
+    addCRC(data.data(), data.size());
+    out.write(type, 4);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    std::vector<unsigned char> crcBytes;
+    appendBigEndian(crcBytes, crc ^ 0xFFFFFFFFu);
+    out.write(reinterpret_cast<const char*>(crcBytes.data()), 4);
+  }
+};
+
+} // namespace
+
+
+void saveImage(std::string name, unsigned char* buffer, int w, int h, int channels) {
+  setImageWriteOptions();
+  writeImageFile(name, buffer, w, h, channels);
+}
+
+namespace internal {
+
+void prepareImageEncoding() { setImageWriteOptions(); }
+
+std::vector<unsigned char> encodeJPEG(const unsigned char* pixels, int w, int h, int quality) {
+  std::vector<unsigned char> result;
+  stbi_write_jpg_to_func(
+      [](void* context, void* data, int size) {
+        std::vector<unsigned char>& out = *static_cast<std::vector<unsigned char>*>(context);
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+      },
+      &result, w, h, 4, pixels, quality);
+  return result;
+}
+
+} // namespace internal
+
+void flushScreenshots() {
+  if (render::engine != nullptr) {
+    render::engine->processPendingReadbacks(true);
+  }
+  waitForImageWrites(0);
+}
+
+namespace {
+
+// Write the image, in the background if options::screenshotEncodeInBackground is set. Blocks only if too many writes
+// are already in flight.
+void queueImageWrite(std::string filename, std::shared_ptr<std::vector<unsigned char>> data, int w, int h,
+                     int channels) {
+  setImageWriteOptions();
+  if (!options::screenshotEncodeInBackground) {
+    writeImageFile(filename, &data->front(), w, h, channels);
+    return;
+  }
+
+  waitForImageWrites(maxPendingImageWrites() - 1);
+  pendingImageWrites.push_back(
+      std::async(std::launch::async, [=]() { writeImageFile(filename, &data->front(), w, h, channels); }));
+}
+
+// Render the current view in to the alternate display buffer, which screenshots read from.
+// Must be paired with a call to finishScreenshotRender().
+void renderScreenshot(bool transparentBG) {
 
   render::engine->useAltDisplayBuffer = true;
   if (transparentBG) render::engine->lightCopy = true; // copy directly in to buffer without blending
@@ -75,32 +269,364 @@ void screenshot(std::string filename, bool transparentBG) {
   bool requestedAlready = redrawRequested();
   requestRedraw();
 
+  // screenshots are always taken at full quality
+  bool interactiveQualityWasActive = internal::interactiveQualityActive;
+  bool dynamicResolutionWasActive = internal::dynamicResolutionActive;
+  internal::interactiveQualityActive = false;
+  internal::dynamicResolutionActive = false;
+
   draw(false, false);
+  while (!render::engine->temporalAccumulationConverged()) {
+    draw(false, false); // accumulate the rest of the temporal antialiasing samples
+  }
 
+  internal::interactiveQualityActive = interactiveQualityWasActive;
+  internal::dynamicResolutionActive = dynamicResolutionWasActive;
   if (requestedAlready) {
     requestRedraw();
   }
+}
+
+void finishScreenshotRender(bool transparentBG) {
+  render::engine->useAltDisplayBuffer = false;
+  if (transparentBG) render::engine->lightCopy = false;
+}
+
+void setOpaqueAlpha(std::vector<unsigned char>& buff, int w, int h) {
+  for (int j = 0; j < h; j++) {
+    for (int i = 0; i < w; i++) {
+      int ind = i + j * w;
+      buff[4 * ind + 3] = std::numeric_limits<unsigned char>::max();
+    }
+  }
+}
+
+void writeScreenshotBuffer(std::string filename, std::vector<unsigned char>& buff, int w, int h, bool transparentBG) {
+
+  // Set alpha to 1
+  if (!transparentBG) {
+    setOpaqueAlpha(buff, w, h);
+  }
+
+  // Save to file
+  std::shared_ptr<std::vector<unsigned char>> data = std::make_shared<std::vector<unsigned char>>();
+  data->swap(buff);
+  queueImageWrite(filename, data, w, h, 4);
+}
+
+} // namespace
+
+void screenshot(std::string filename, bool transparentBG) {
+
+  renderScreenshot(transparentBG);
 
   // these _should_ always be accurate
   int w = view::bufferWidth;
   int h = view::bufferHeight;
   std::vector<unsigned char> buff = render::engine->displayBufferAlt->readBuffer();
 
-  // Set alpha to 1
-  if (!transparentBG) {
+  writeScreenshotBuffer(filename, buff, w, h, transparentBG);
+
+  finishScreenshotRender(transparentBG);
+}
+
+void screenshotAsync(std::string filename, bool transparentBG) {
+
+  // Write out any earlier async screenshots which have finished in the meantime
+  render::engine->processPendingReadbacks();
+
+  renderScreenshot(transparentBG);
+
+  int w = view::bufferWidth;
+  int h = view::bufferHeight;
+  render::engine->displayBufferAlt->readBufferAsync([=](std::vector<unsigned char> buff) {
+    writeScreenshotBuffer(filename, buff, w, h, transparentBG);
+  });
+
+  finishScreenshotRender(transparentBG);
+}
+
+void renderSequence(const std::vector<CameraParameters>& cameras,
+                    std::function<void(size_t, std::vector<unsigned char>&, int, int)> frameCallback, int width,
+                    int height, bool transparentBG) {
+
+  // Save the current view and buffer size, restored below
+  CameraParameters initialCamera = view::getCameraParametersForCurrentView();
+  int initialBufferWidth = view::bufferWidth;
+  int initialBufferHeight = view::bufferHeight;
+
+  // Render at the requested size. Only the buffer size changes, the window is untouched.
+  bool resized = width > 0 && height > 0 && (width != view::bufferWidth || height != view::bufferHeight);
+  if (resized) {
+    view::bufferWidth = width;
+    view::bufferHeight = height;
+    render::engine->resizeScreenBuffers();
+    render::engine->setScreenBufferViewports();
+  }
+  int w = view::bufferWidth;
+  int h = view::bufferHeight;
+
+  for (size_t iFrame = 0; iFrame < cameras.size(); iFrame++) {
+    view::setViewToCamera(cameras[iFrame]);
+    renderScreenshot(transparentBG);
+
+    render::engine->displayBufferAlt->readBufferAsync([=](std::vector<unsigned char> buff) {
+      if (!transparentBG) {
+        setOpaqueAlpha(buff, w, h);
+      }
+      frameCallback(iFrame, buff, w, h);
+    });
+
+    finishScreenshotRender(transparentBG);
+
+    // Hand off any frames which have finished while later ones render
+    render::engine->processPendingReadbacks();
+  }
+  render::engine->processPendingReadbacks(true);
+
+  // Restore
+  if (resized) {
+    view::bufferWidth = initialBufferWidth;
+    view::bufferHeight = initialBufferHeight;
+    render::engine->resizeScreenBuffers();
+    render::engine->setScreenBufferViewports();
+  }
+  view::setViewToCamera(initialCamera);
+}
+
+void screenshotSequence(const std::vector<CameraParameters>& cameras, const std::vector<std::string>& filenames,
+                        int width, int height, bool transparentBG) {
+
+  if (filenames.size() != cameras.size()) {
+    exception("screenshotSequence() got " + std::to_string(cameras.size()) + " cameras but " +
+              std::to_string(filenames.size()) + " filenames");
+    return;
+  }
+
+  renderSequence(
+      cameras,
+      [&](size_t iFrame, std::vector<unsigned char>& pixels, int w, int h) {
+        std::shared_ptr<std::vector<unsigned char>> data = std::make_shared<std::vector<unsigned char>>();
+        data->swap(pixels);
+        queueImageWrite(filenames[iFrame], data, w, h, 4);
+      },
+      width, height, transparentBG);
+
+  // all files are on disk when this returns
+  waitForImageWrites(0);
+}
+
+void renderTiled(int width, int height,
+                 std::function<void(int, std::vector<unsigned char>&, int, int)> stripCallback, int tileSize,
+                 bool transparentBG) {
+
+  if (width <= 0 || height <= 0 || tileSize <= 0) {
+    exception("renderTiled() got an image of " + std::to_string(width) + "x" + std::to_string(height) +
+              " in tiles of " + std::to_string(tileSize));
+    return;
+  }
+
+  // Render every tile at the same size, cropping those which hang off the edge of the image
+  int initialBufferWidth = view::bufferWidth;
+  int initialBufferHeight = view::bufferHeight;
+  view::bufferWidth = tileSize;
+  view::bufferHeight = tileSize;
+  render::engine->resizeScreenBuffers();
+  render::engine->setScreenBufferViewports();
+  view::projectionTileImageSize = glm::ivec2{width, height};
+
+  int nTilesX = (width + tileSize - 1) / tileSize;
+  int nTilesY = (height + tileSize - 1) / tileSize;
+  std::vector<unsigned char> strip;
+  for (int iTileY = nTilesY - 1; iTileY >= 0; iTileY--) { // tile offsets are from the bottom, strips from the top
+    int y0 = iTileY * tileSize;
+    int stripHeight = std::min(tileSize, height - y0);
+    strip.resize(4 * static_cast<size_t>(width) * stripHeight);
+
+    for (int iTileX = 0; iTileX < nTilesX; iTileX++) {
+      int x0 = iTileX * tileSize;
+      int tileWidth = std::min(tileSize, width - x0);
+      view::projectionTileOffset = glm::ivec2{x0, y0};
+
+      renderScreenshot(transparentBG);
+      std::vector<unsigned char> tile = render::engine->displayBufferAlt->readBuffer(); // bottom row first
+      finishScreenshotRender(transparentBG);
+
+      for (int j = 0; j < stripHeight; j++) {
+        const unsigned char* src = &tile[4 * static_cast<size_t>(stripHeight - 1 - j) * tileSize];
+        std::copy(src, src + 4 * tileWidth, &strip[4 * (static_cast<size_t>(j) * width + x0)]);
+      }
+    }
+
+    if (!transparentBG) {
+      setOpaqueAlpha(strip, width, stripHeight);
+    }
+    stripCallback(height - y0 - stripHeight, strip, width, stripHeight);
+  }
+
+  // Restore
+  view::projectionTileOffset = glm::ivec2{0, 0};
+  view::projectionTileImageSize = glm::ivec2{0, 0};
+  view::bufferWidth = initialBufferWidth;
+  view::bufferHeight = initialBufferHeight;
+  render::engine->resizeScreenBuffers();
+  render::engine->setScreenBufferViewports();
+  requestRedraw();
+}
+
+void screenshotTiled(std::string filename, int width, int height, int tileSize, bool transparentBG) {
+
+  bool raw = hasExtension(filename, ".raw");
+  if (!raw && !hasExtension(filename, ".png")) {
+    exception("screenshotTiled() can only write .png or .raw files, not " + filename);
+    return;
+  }
+  std::ofstream outFile(filename, std::ios::binary);
+  if (!outFile) {
+    exception("screenshotTiled() could not open " + filename);
+    return;
+  }
+
+  if (raw) {
+    renderTiled(
+        width, height,
+        [&](int, std::vector<unsigned char>& pixels, int, int) {
+          outFile.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        },
+        tileSize, transparentBG);
+    return;
+  }
+
+  StreamingPNGWriter png(outFile, width, height);
+  renderTiled(
+      width, height, [&](int, std::vector<unsigned char>& pixels, int, int h) { png.writeRows(pixels.data(), h); },
+      tileSize, transparentBG);
+  png.finish();
+}
+
+void renderToBuffers(const RenderBufferTargets& targets, bool transparentBG) {
+
+  int w = view::bufferWidth;
+  int h = view::bufferHeight;
+  size_t nPix = static_cast<size_t>(w) * h;
+  size_t rowsPerBlock = std::max<size_t>(1, 16384 / std::max(w, 1));
+
+  // Color, exactly as a screenshot would be. This comes first, since rendering invalidates the pick buffer.
+  if (targets.color != nullptr) {
+    renderScreenshot(transparentBG);
+    std::vector<unsigned char> buff = render::engine->displayBufferAlt->readBuffer();
+    finishScreenshotRender(transparentBG);
+
+    if (!transparentBG) {
+      setOpaqueAlpha(buff, w, h);
+    }
+    size_t rowBytes = 4 * static_cast<size_t>(w);
+    for (int j = 0; j < h; j++) {
+      std::copy(buff.begin() + j * rowBytes, buff.begin() + (j + 1) * rowBytes, targets.color + (h - 1 - j) * rowBytes);
+    }
+  }
+
+  if (targets.depth == nullptr && targets.normal == nullptr && targets.pickID == nullptr) return;
+
+  // Everything else comes from one pick render
+  if (!pick::renderPickBuffer()) {
+    exception("renderToBuffers() could not render the pick buffer");
+    return;
+  }
+  render::FrameBuffer* pickFramebuffer = render::engine->pickFramebuffer.get();
+
+  if (targets.pickID != nullptr) {
+    std::vector<float> ids = pickFramebuffer->readFloat4Region(0, 0, w, h);
+    parallelFor(
+        0, h,
+        [&](size_t jStart, size_t jEnd) {
+          for (size_t j = jStart; j < jEnd; j++) {
+            for (size_t i = 0; i < static_cast<size_t>(w); i++) {
+              size_t ind = j * w + i;
+              targets.pickID[(h - 1 - j) * w + i] =
+                  pick::vecToInd(glm::vec3{ids[4 * ind + 0], ids[4 * ind + 1], ids[4 * ind + 2]});
+            }
+          }
+        },
+        rowsPerBlock);
+  }
+
+  if (targets.depth == nullptr && targets.normal == nullptr) return;
+
+  // Unproject the depth buffer to view-space positions (in buffer row order, bottom first)
+  std::vector<float> rawDepth = pickFramebuffer->readDepthRegion(0, 0, w, h);
+  glm::mat4 invProj = glm::inverse(view::getCameraPerspectiveMatrix());
+  std::vector<glm::vec3> viewPos(nPix);
+  std::vector<char> hit(nPix);
+  parallelFor(
+      0, h,
+      [&](size_t jStart, size_t jEnd) {
+        for (size_t j = jStart; j < jEnd; j++) {
+          for (size_t i = 0; i < static_cast<size_t>(w); i++) {
+            size_t ind = j * w + i;
+            hit[ind] = rawDepth[ind] < 1.;
+            glm::vec4 ndc{(i + 0.5f) / w * 2.f - 1.f, (j + 0.5f) / h * 2.f - 1.f, 2.f * rawDepth[ind] - 1.f, 1.f};
+            glm::vec4 p = invProj * ndc;
+            viewPos[ind] = glm::vec3(p) / p.w;
+          }
+        }
+      },
+      rowsPerBlock);
+
+  if (targets.depth != nullptr) {
     for (int j = 0; j < h; j++) {
       for (int i = 0; i < w; i++) {
-        int ind = i + j * w;
-        buff[4 * ind + 3] = std::numeric_limits<unsigned char>::max();
+        size_t ind = j * w + i;
+        targets.depth[(h - 1 - j) * w + i] = hit[ind] ? -viewPos[ind].z : std::numeric_limits<float>::infinity();
       }
     }
   }
 
-  // Save to file
-  saveImage(filename, &(buff.front()), w, h, 4);
-
-  render::engine->useAltDisplayBuffer = false;
-  if (transparentBG) render::engine->lightCopy = false;
+  if (targets.normal != nullptr) {
+    // Differences toward whichever neighbor is closest in depth, which avoids smearing normals across silhouettes
+    auto pickDifference = [&](size_t ind, size_t prevInd, size_t nextInd, bool hasPrev, bool hasNext, glm::vec3& diff) {
+      hasPrev = hasPrev && hit[prevInd];
+      hasNext = hasNext && hit[nextInd];
+      if (hasPrev && hasNext) {
+        glm::vec3 dPrev = viewPos[ind] - viewPos[prevInd];
+        glm::vec3 dNext = viewPos[nextInd] - viewPos[ind];
+        diff = std::abs(dPrev.z) < std::abs(dNext.z) ? dPrev : dNext;
+      } else if (hasPrev) {
+        diff = viewPos[ind] - viewPos[prevInd];
+      } else if (hasNext) {
+        diff = viewPos[nextInd] - viewPos[ind];
+      } else {
+        return false;
+      }
+      return true;
+    };
+
+    parallelFor(
+        0, h,
+        [&](size_t jStart, size_t jEnd) {
+          for (size_t j = jStart; j < jEnd; j++) {
+            for (size_t i = 0; i < static_cast<size_t>(w); i++) {
+              size_t ind = j * w + i;
+              float* out = targets.normal + 3 * ((h - 1 - j) * w + i);
+              glm::vec3 n{0., 0., 0.};
+              glm::vec3 dx, dy;
+              if (hit[ind] && pickDifference(ind, ind - 1, ind + 1, i > 0, i + 1 < static_cast<size_t>(w), dx) &&
+                  pickDifference(ind, ind - w, ind + w, j > 0, j + 1 < static_cast<size_t>(h), dy)) {
+                n = glm::cross(dx, dy);
+                float len = glm::length(n);
+                if (len > 0.) {
+                  n /= len;
+                  if (glm::dot(n, viewPos[ind]) > 0.) n = -n;
+                }
+              }
+              out[0] = n.x;
+              out[1] = n.y;
+              out[2] = n.z;
+            }
+          }
+        },
+        rowsPerBlock);
+  }
 }
 
 void screenshot(bool transparentBG) {
@@ -5,10 +5,9 @@
 #include "polyscope/polyscope.h"
 #include "polyscope/volume_mesh.h"
 
-namespace polyscope {
+#include <algorithm>
 
-// NOTE: Unfortunately, the logic here and in the engine depends on the names constructed from the postfix being
-// identical.
+namespace polyscope {
 
 namespace {
 // storage for slice planes "owned" by the scene itself
@@ -76,16 +75,10 @@ SlicePlane::SlicePlane(std::string name_)
       objectTransform(uniquePrefix() + "#object_transform", glm::mat4(1.0)),
       color(uniquePrefix() + "#color", getNextUniqueColor()),
       gridLineColor(uniquePrefix() + "#gridLineColor", glm::vec3{.97, .97, .97}),
-      transparency(uniquePrefix() + "#transparency", 0.5), shouldInspectMesh(false), inspectedMeshName(""),
-      transformGizmo(uniquePrefix() + "#transformGizmo", objectTransform.get(), &objectTransform),
-      sliceBufferArr{{{uniquePrefix() + "#slice1", sliceBufferDataArr[0]},
-                      {uniquePrefix() + "#slice2", sliceBufferDataArr[1]},
-                      {uniquePrefix() + "#slice3", sliceBufferDataArr[2]},
-                      {uniquePrefix() + "#slice4", sliceBufferDataArr[3]}}}
-
-{
+      transparency(uniquePrefix() + "#transparency", 0.5),
+      transformGizmo(uniquePrefix() + "#transformGizmo", objectTransform.get(), &objectTransform) {
+  render::engine->addSlicePlane();
   state::slicePlanes.push_back(this);
-  render::engine->addSlicePlane(postfix);
   transformGizmo.enabled = true;
   prepare();
 }
@@ -93,7 +86,7 @@ SlicePlane::SlicePlane(std::string name_)
 SlicePlane::~SlicePlane() {
   ensureVolumeInspectValid();
   setVolumeMeshToInspect(""); // disable any slicing
-  render::engine->removeSlicePlane(postfix);
+  render::engine->removeSlicePlane();
   auto pos = std::find(state::slicePlanes.begin(), state::slicePlanes.end(), this);
   if (pos == state::slicePlanes.end()) return;
   state::slicePlanes.erase(pos);
@@ -131,105 +124,164 @@ void SlicePlane::setSliceGeomUniforms(render::ShaderProgram& p) {
 }
 
 
-void SlicePlane::setVolumeMeshToInspect(std::string meshname) {
-  VolumeMesh* oldMeshToInspect = polyscope::getVolumeMesh(inspectedMeshName);
-  if (oldMeshToInspect != nullptr) {
-    oldMeshToInspect->removeSlicePlaneListener(this);
+void SlicePlane::setVolumeMeshToInspect(std::string meshName) {
+  std::vector<std::string> meshNames;
+  if (meshName != "") meshNames.push_back(meshName);
+  setVolumeMeshesToInspect(meshNames);
+}
+
+std::string SlicePlane::getVolumeMeshToInspect() {
+  ensureVolumeInspectValid();
+  return inspectedMeshes.empty() ? "" : inspectedMeshes.front().name;
+}
+
+void SlicePlane::setVolumeMeshesToInspect(const std::vector<std::string>& meshNames) {
+  ensureVolumeInspectValid();
+  for (InspectedVolumeMesh& inspected : inspectedMeshes) {
+    getVolumeMesh(inspected.name)->removeSlicePlaneListener(this);
   }
-  inspectedMeshName = meshname;
-  VolumeMesh* meshToInspect = polyscope::getVolumeMesh(inspectedMeshName);
-  if (meshToInspect == nullptr) {
-    inspectedMeshName = "";
-    shouldInspectMesh = false;
-    volumeInspectProgram.reset();
-    return;
+  inspectedMeshes.clear();
+  for (const std::string& meshName : meshNames) {
+    addVolumeMeshToInspect(meshName);
   }
+}
+
+std::vector<std::string> SlicePlane::getVolumeMeshesToInspect() {
+  ensureVolumeInspectValid();
+  std::vector<std::string> meshNames;
+  for (InspectedVolumeMesh& inspected : inspectedMeshes) meshNames.push_back(inspected.name);
+  return meshNames;
+}
+
+void SlicePlane::addVolumeMeshToInspect(std::string meshName) {
+  ensureVolumeInspectValid();
+  if (findInspectedMesh(meshName) != nullptr) return;
+  VolumeMesh* meshToInspect = polyscope::getVolumeMesh(meshName);
+  if (meshToInspect == nullptr) return;
+
   drawPlane = false;
   meshToInspect->addSlicePlaneListener(this);
   meshToInspect->setCullWholeElements(false);
   meshToInspect->ensureHaveTets(); // do this as early as possible because it is expensive
-  shouldInspectMesh = true;
-  volumeInspectProgram.reset();
+  inspectedMeshes.push_back(InspectedVolumeMesh{meshName, nullptr, {}, glm::vec4(), false});
 }
 
-std::string SlicePlane::getVolumeMeshToInspect() { return inspectedMeshName; }
-
-void SlicePlane::ensureVolumeInspectValid() {
-  if (!shouldInspectMesh) return;
+void SlicePlane::removeVolumeMeshToInspect(std::string meshName) {
+  ensureVolumeInspectValid();
+  for (size_t i = 0; i < inspectedMeshes.size(); i++) {
+    if (inspectedMeshes[i].name != meshName) continue;
+    getVolumeMesh(meshName)->removeSlicePlaneListener(this);
+    inspectedMeshes.erase(inspectedMeshes.begin() + i);
+    return;
+  }
+}
 
-  // This method exists to save us in any cases where we might be inspecting a volume mesh when that mesh is deleted. We
-  // can't just call setVolumeMeshToInspect(""), because that tries to look up the volume mesh.
+bool SlicePlane::isInspectingVolumeMesh(std::string meshName) {
+  ensureVolumeInspectValid();
+  return findInspectedMesh(meshName) != nullptr;
+}
 
-  if (!hasVolumeMesh(inspectedMeshName)) {
-    inspectedMeshName = "";
-    shouldInspectMesh = false;
-    volumeInspectProgram = nullptr;
+void SlicePlane::setGroupToInspect(std::string groupName) {
+  if (state::groups.find(groupName) == state::groups.end()) {
+    exception("cannot inspect group [" + groupName + "], no group with that name exists");
+    return;
   }
+  std::vector<std::string> meshNames;
+  for (Structure* s : state::groups[groupName]->getDescendantStructures()) {
+    if (s->typeName() == VolumeMesh::structureTypeName) meshNames.push_back(s->name);
+  }
+  setVolumeMeshesToInspect(meshNames);
 }
 
-void SlicePlane::createVolumeSliceProgram() {
-  VolumeMesh* meshToInspect = polyscope::getVolumeMesh(inspectedMeshName);
-  volumeInspectProgram = render::engine->requestShader(
-      "SLICE_TETS", meshToInspect->addVolumeMeshRules({"SLICE_TETS_BASECOLOR_SHADE"}, true, true));
-  meshToInspect->fillSliceGeometryBuffers(*volumeInspectProgram);
-  render::engine->setMaterial(*volumeInspectProgram, meshToInspect->getMaterial());
+SlicePlane::InspectedVolumeMesh* SlicePlane::findInspectedMesh(const std::string& meshName) {
+  for (InspectedVolumeMesh& inspected : inspectedMeshes) {
+    if (inspected.name == meshName) return &inspected;
+  }
+  return nullptr;
 }
 
-void SlicePlane::resetVolumeSliceProgram() { volumeInspectProgram.reset(); }
+void SlicePlane::ensureVolumeInspectValid() {
 
-void SlicePlane::setSliceAttributes(render::ShaderProgram& p) {
-  VolumeMesh* meshToInspect = polyscope::getVolumeMesh(inspectedMeshName);
+  // This method exists to save us in any cases where we might be inspecting a volume mesh when that mesh is deleted. We
+  // can't just call removeVolumeMeshToInspect(), because that tries to look up the volume mesh.
+  inspectedMeshes.erase(std::remove_if(inspectedMeshes.begin(), inspectedMeshes.end(),
+                                       [](const InspectedVolumeMesh& m) { return !hasVolumeMesh(m.name); }),
+                        inspectedMeshes.end());
+}
 
+void SlicePlane::createVolumeSliceProgram(InspectedVolumeMesh& inspected, VolumeMesh& mesh) {
+  inspected.program = render::engine->requestShader(
+      "SLICE_TETS", mesh.addVolumeMeshRules({"SLICE_TETS_BASECOLOR_SHADE"}, true, true));
+  mesh.fillSliceGeometryBuffers(*inspected.program);
+  render::engine->setMaterial(*inspected.program, mesh.getMaterial());
+}
 
-  size_t cellCount = meshToInspect->nCells();
-  for (int i = 0; i < 4; i++) {
-    sliceBufferDataArr[i].resize(cellCount);
-  }
-  for (size_t iC = 0; iC < cellCount; iC++) {
-    const std::array<uint32_t, 8>& cell = meshToInspect->cells[iC];
-    for (int i = 0; i < 4; i++) {
-      sliceBufferDataArr[i][iC] = cell[i];
-    }
+void SlicePlane::resetVolumeSliceProgram() {
+  for (InspectedVolumeMesh& inspected : inspectedMeshes) {
+    inspected.program.reset();
+    inspected.slicedTetRangesValid = false;
   }
+}
 
-  for (int i = 0; i < 4; i++) {
-    sliceBufferArr[i].markHostBufferUpdated();
-  }
+void SlicePlane::resetVolumeSliceProgram(VolumeMesh& mesh) {
+  InspectedVolumeMesh* inspected = findInspectedMesh(mesh.name);
+  if (inspected == nullptr) return;
+  inspected->program.reset();
+  inspected->slicedTetRangesValid = false;
+}
+
+void SlicePlane::refreshVolumeSliceMaterial(VolumeMesh& mesh) {
+  InspectedVolumeMesh* inspected = findInspectedMesh(mesh.name);
+  if (inspected == nullptr || !inspected->program) return;
+  render::engine->setMaterial(*inspected->program, mesh.getMaterial());
+}
 
-  p.setAttribute("a_slice_1", meshToInspect->vertexPositions.getIndexedRenderAttributeBuffer(sliceBufferArr[0]));
-  p.setAttribute("a_slice_2", meshToInspect->vertexPositions.getIndexedRenderAttributeBuffer(sliceBufferArr[1]));
-  p.setAttribute("a_slice_3", meshToInspect->vertexPositions.getIndexedRenderAttributeBuffer(sliceBufferArr[2]));
-  p.setAttribute("a_slice_4", meshToInspect->vertexPositions.getIndexedRenderAttributeBuffer(sliceBufferArr[3]));
+void SlicePlane::ensureSlicedTetRangesCurrent(InspectedVolumeMesh& inspected, VolumeMesh& mesh, glm::vec4 plane) {
+  if (inspected.slicedTetRangesValid && plane == inspected.slicedTetRangesPlane) return;
+  inspected.slicedTetRanges = mesh.computeSlicedTetRanges(glm::vec3(plane), plane.w);
+  inspected.slicedTetRangesPlane = plane;
+  inspected.slicedTetRangesValid = true;
+}
+
+void SlicePlane::setSliceDrawRanges(render::ShaderProgram& p, VolumeMesh& mesh) {
+  InspectedVolumeMesh* inspected = findInspectedMesh(mesh.name);
+  if (inspected == nullptr) {
+    p.setDrawRanges({});
+    return;
+  }
+  p.setDrawRanges(inspected->slicedTetRanges);
 }
 
 void SlicePlane::drawGeometry() {
   if (!active.get()) return;
 
   ensureVolumeInspectValid();
+  if (inspectedMeshes.empty()) return;
 
-  if (shouldInspectMesh) {
-    VolumeMesh* vMesh = polyscope::getVolumeMesh(inspectedMeshName);
-
-    // guard against situations where the volume mesh we are slicing has been deleted
-    if (vMesh == nullptr) {
-      setVolumeMeshToInspect("");
-      return;
-    }
+  // (the same plane which setSliceGeomUniforms() gives the shader)
+  glm::vec3 norm = getNormal();
+  glm::vec4 plane(norm, glm::dot(getCenter(), norm));
 
-    if (vMesh->wantsCullPosition()) return;
-
-    if (volumeInspectProgram == nullptr) {
-      createVolumeSliceProgram();
-    }
+  for (InspectedVolumeMesh& inspected : inspectedMeshes) {
+    VolumeMesh* vMesh = polyscope::getVolumeMesh(inspected.name);
+    if (vMesh->wantsCullPosition()) continue;
 
+    // Meshes which the plane misses draw nothing, so sweeping the plane through many blocks only costs the ones it cuts
+    ensureSlicedTetRangesCurrent(inspected, *vMesh, plane);
+    if (inspected.slicedTetRanges.empty()) continue;
 
     if (vMesh->dominantQuantity == nullptr) {
-      vMesh->setStructureUniforms(*volumeInspectProgram);
-      setSceneObjectUniforms(*volumeInspectProgram, true);
-      setSliceGeomUniforms(*volumeInspectProgram);
-      vMesh->setVolumeMeshUniforms(*volumeInspectProgram);
-      volumeInspectProgram->setUniform("u_baseColor1", vMesh->getColor());
-      volumeInspectProgram->draw();
+      if (inspected.program == nullptr) {
+        createVolumeSliceProgram(inspected, *vMesh);
+      }
+      render::ShaderProgram& p = *inspected.program;
+      vMesh->setStructureUniforms(p);
+      setSceneObjectUniformsIgnoringThis(p, *vMesh);
+      setSliceGeomUniforms(p);
+      vMesh->setVolumeMeshUniforms(p);
+      p.setUniform("u_baseColor1", vMesh->getColor());
+      p.setDrawRanges(inspected.slicedTetRanges);
+      p.draw();
     }
 
     for (auto it = vMesh->quantities.begin(); it != vMesh->quantities.end(); it++) {
@@ -247,9 +299,6 @@ void SlicePlane::draw() {
     // Set uniforms
     glm::mat4 viewMat = view::getCameraViewMatrix();
     planeProgram->setUniform("u_viewMatrix", glm::value_ptr(viewMat));
-    glm::mat4 projMat = view::getCameraPerspectiveMatrix();
-    planeProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-
     planeProgram->setUniform("u_objectMatrix", glm::value_ptr(objectTransform.get()));
     planeProgram->setUniform("u_lengthScale", state::lengthScale);
     planeProgram->setUniform("u_color", color.get());
@@ -311,13 +360,25 @@ void SlicePlane::buildGUI() {
       //  Loop over volume meshes and offer them to be inspected
       for (std::pair<const std::string, std::shared_ptr<Structure>>& it : state::structures["Volume Mesh"]) {
         std::string vMeshName = it.first;
-        if (ImGui::MenuItem(vMeshName.c_str(), NULL, inspectedMeshName == vMeshName)) {
-          setVolumeMeshToInspect(vMeshName);
+        bool isInspected = isInspectingVolumeMesh(vMeshName);
+        if (ImGui::MenuItem(vMeshName.c_str(), NULL, isInspected)) {
+          if (isInspected) {
+            removeVolumeMeshToInspect(vMeshName);
+          } else {
+            addVolumeMeshToInspect(vMeshName);
+          }
         }
       }
 
-      // "None" option
-      if (ImGui::MenuItem("None", NULL, inspectedMeshName == "")) {
+      // "All" and "None" options
+      if (ImGui::MenuItem("All")) {
+        std::vector<std::string> meshNames;
+        for (std::pair<const std::string, std::shared_ptr<Structure>>& it : state::structures["Volume Mesh"]) {
+          meshNames.push_back(it.first);
+        }
+        setVolumeMeshesToInspect(meshNames);
+      }
+      if (ImGui::MenuItem("None", NULL, inspectedMeshes.empty())) {
         setVolumeMeshToInspect("");
       }
 
@@ -331,24 +392,17 @@ void SlicePlane::buildGUI() {
   ImGui::PopID();
 }
 
-void SlicePlane::setSceneObjectUniforms(render::ShaderProgram& p, bool alwaysPass) {
-  if (!p.hasUniform("u_slicePlaneNormal_" + postfix)) {
+void SlicePlane::setSceneObjectUniformsIgnoringThis(render::ShaderProgram& p, Structure& structure) {
+  if (!p.hasUniform("u_slicePlaneIgnoreMask")) {
     return;
   }
 
-  glm::vec3 normal, center;
-
-  if (alwaysPass) {
-    normal = glm::vec3{-1., 0., 0.};
-    center = glm::vec3{std::numeric_limits<float>::infinity(), 0., 0.};
-  } else {
-    glm::mat4 viewMat = view::getCameraViewMatrix();
-    normal = glm::vec3(viewMat * glm::vec4(getNormal(), 0.));
-    center = glm::vec3(viewMat * glm::vec4(getCenter(), 1.));
+  uint32_t mask = structure.getSlicePlaneIgnoreMask();
+  auto pos = std::find(state::slicePlanes.begin(), state::slicePlanes.end(), this);
+  if (pos != state::slicePlanes.end()) {
+    mask |= (1u << (pos - state::slicePlanes.begin()));
   }
-
-  p.setUniform("u_slicePlaneNormal_" + postfix, normal);
-  p.setUniform("u_slicePlaneCenter_" + postfix, center);
+  p.setUniform("u_slicePlaneIgnoreMask", mask);
 }
 
 glm::vec3 SlicePlane::getCenter() {
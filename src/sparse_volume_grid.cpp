@@ -0,0 +1,328 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+
+#include "polyscope/sparse_volume_grid.h"
+
+#include "polyscope/parallel.h"
+
+#include "imgui.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace polyscope {
+
+// Initialize statics
+const std::string SparseVolumeGrid::structureTypeName = "Sparse Volume Grid";
+const int32_t SparseVolumeGrid::brickSize;
+
+namespace {
+
+// 21 bits per brick coordinate, offset so negative coordinates pack too
+uint64_t packBrickCoord(glm::ivec3 b) {
+  const int64_t offset = 1 << 20;
+  return (static_cast<uint64_t>(b.x + offset) << 42) | (static_cast<uint64_t>(b.y + offset) << 21) |
+         static_cast<uint64_t>(b.z + offset);
+}
+
+} // namespace
+
+SparseVolumeGrid::SparseVolumeGrid(std::string name, glm::vec3 origin_, glm::vec3 spacing_,
+                                   const std::vector<glm::ivec3>& activeNodes_)
+    : QuantityStructure<SparseVolumeGrid>(name, typeName()), origin(origin_), spacing(spacing_),
+      brickRangeMin{0, 0, 0}, brickRangeMax{0, 0, 0}, atlasBricks{1, 1, 1},
+      material(uniquePrefix() + "#material", "clay") {
+
+  const int32_t maxBrickCoord = (1 << 20) - 1;
+  const size_t brickValues = brickSize * brickSize * brickSize;
+
+  // Allocate a brick for each distinct brick containing an active node
+  activeNodes.reserve(activeNodes_.size());
+  activeNodeValueInds.reserve(activeNodes_.size());
+  std::unordered_map<uint64_t, size_t> seenValueInds;
+  for (glm::ivec3 node : activeNodes_) {
+    glm::ivec3 b = brickOfNode(node);
+    if (glm::any(glm::greaterThan(glm::abs(b), glm::ivec3(maxBrickCoord)))) {
+      exception("sparse volume grid " + name + " has a node too far from the origin: " +
+                to_string_short(glm::vec3(node)));
+      return;
+    }
+    uint64_t key = packBrickCoord(b);
+    auto it = brickLookup.find(key);
+    if (it == brickLookup.end()) {
+      it = brickLookup.emplace(key, static_cast<uint32_t>(brickCoords.size())).first;
+      brickCoords.push_back(b);
+    }
+
+    glm::ivec3 local = node - b * brickSize;
+    size_t valueInd = it->second * brickValues + (local.x * brickSize + local.y) * brickSize + local.z;
+    if (!seenValueInds.emplace(valueInd, activeNodes.size()).second) continue; // duplicate
+    activeNodes.push_back(node);
+    activeNodeValueInds.push_back(valueInd);
+  }
+
+  if (!brickCoords.empty()) {
+    brickRangeMin = brickCoords.front();
+    brickRangeMax = brickCoords.front();
+    for (glm::ivec3 b : brickCoords) {
+      brickRangeMin = glm::min(brickRangeMin, b);
+      brickRangeMax = glm::max(brickRangeMax, b);
+    }
+    brickRangeMax += glm::ivec3(1);
+
+    // A roughly cubical atlas, so no side of the texture gets too long
+    int32_t n = static_cast<int32_t>(brickCoords.size());
+    atlasBricks.x = static_cast<int32_t>(std::ceil(std::cbrt(static_cast<double>(n))));
+    atlasBricks.y = static_cast<int32_t>(std::ceil(std::sqrt(static_cast<double>(n) / atlasBricks.x)));
+    atlasBricks.z = (n + atlasBricks.x * atlasBricks.y - 1) / (atlasBricks.x * atlasBricks.y);
+  }
+
+  updateObjectSpaceBounds();
+}
+
+void SparseVolumeGrid::buildCustomUI() {
+  ImGui::Text("active nodes: %lld  bricks: %lld", static_cast<long long int>(nActiveNodes()),
+              static_cast<long long int>(nBricks()));
+  ImGui::TextUnformatted(("origin: " + to_string_short(origin)).c_str());
+  ImGui::TextUnformatted(("spacing: " + to_string_short(spacing)).c_str());
+}
+
+void SparseVolumeGrid::buildPickUI(size_t localPickID) {
+  // For now do nothing
+}
+
+void SparseVolumeGrid::draw() {
+  // For now, do nothing for the actual grid
+  if (!enabled.get()) return;
+
+  // Draw the quantities
+  for (auto& x : quantities) {
+    x.second->draw();
+  }
+  for (auto& x : floatingQuantities) {
+    x.second->draw();
+  }
+}
+
+void SparseVolumeGrid::drawDelayed() {
+  if (!enabled.get()) return;
+
+  for (auto& x : quantities) {
+    x.second->drawDelayed();
+  }
+  for (auto& x : floatingQuantities) {
+    x.second->drawDelayed();
+  }
+}
+
+void SparseVolumeGrid::drawPick() {
+  // For now do nothing
+}
+
+void SparseVolumeGrid::updateObjectSpaceBounds() {
+  // the allocated bricks, including the last layer of cells which reach into the neighboring bricks
+  glm::vec3 boundMin = positionOfNode(brickRangeMin * brickSize);
+  glm::vec3 boundMax = positionOfNode(brickRangeMax * brickSize);
+  objectSpaceBoundingBox = std::make_tuple(boundMin, boundMax);
+  objectSpaceLengthScale = glm::length(boundMax - boundMin);
+}
+
+std::string SparseVolumeGrid::typeName() { return structureTypeName; }
+
+void SparseVolumeGrid::refresh() {
+  brickIndexTexture.reset();
+  QuantityStructure<SparseVolumeGrid>::refresh(); // call base class version, which refreshes quantities
+}
+
+int64_t SparseVolumeGrid::brickIndex(glm::ivec3 brickCoord) const {
+  if (glm::any(glm::lessThan(brickCoord, brickRangeMin)) ||
+      glm::any(glm::greaterThanEqual(brickCoord, brickRangeMax))) {
+    return -1;
+  }
+  auto it = brickLookup.find(packBrickCoord(brickCoord));
+  if (it == brickLookup.end()) return -1;
+  return it->second;
+}
+
+int64_t SparseVolumeGrid::valueIndexOfNode(glm::ivec3 node) const {
+  glm::ivec3 b = brickOfNode(node);
+  int64_t iBrick = brickIndex(b);
+  if (iBrick < 0) return -1;
+  glm::ivec3 local = node - b * brickSize;
+  return iBrick * brickSize * brickSize * brickSize + (local.x * brickSize + local.y) * brickSize + local.z;
+}
+
+std::vector<float> SparseVolumeGrid::gatherActiveValues(const std::vector<float>& values) const {
+  std::vector<float> activeValues(nActiveNodes());
+  for (size_t i = 0; i < activeValues.size(); i++) {
+    activeValues[i] = values[activeNodeValueInds[i]];
+  }
+  return activeValues;
+}
+
+void SparseVolumeGrid::gatherPaddedBrick(const std::vector<float>& values, size_t iBrick, double* out) const {
+  const int32_t p = brickSize + 1;
+  const size_t brickValues = brickSize * brickSize * brickSize;
+  glm::ivec3 b = brickCoords[iBrick];
+
+  // the brick itself and up to 7 neighbors along +x, +y, +z
+  int64_t neighbors[8];
+  for (int c = 0; c < 8; c++) {
+    neighbors[c] = (c == 0) ? static_cast<int64_t>(iBrick) : brickIndex(b + glm::ivec3{c & 1, (c >> 1) & 1, c >> 2});
+  }
+
+  for (int32_t i = 0; i < p; i++) {
+    for (int32_t j = 0; j < p; j++) {
+      for (int32_t k = 0; k < p; k++) {
+        int c = (i == brickSize ? 1 : 0) | (j == brickSize ? 2 : 0) | (k == brickSize ? 4 : 0);
+        double v = std::numeric_limits<double>::quiet_NaN();
+        if (neighbors[c] >= 0) {
+          size_t local = ((i % brickSize) * brickSize + (j % brickSize)) * brickSize + (k % brickSize);
+          v = values[neighbors[c] * brickValues + local];
+        }
+        out[(i * p + j) * p + k] = v;
+      }
+    }
+  }
+}
+
+void SparseVolumeGrid::populateGeometry() {
+  if (activeNodePositions.size() == nActiveNodes()) return;
+  activeNodePositions.resize(nActiveNodes());
+  for (size_t i = 0; i < activeNodePositions.size(); i++) {
+    activeNodePositions[i] = positionOfNode(activeNodes[i]);
+  }
+}
+
+std::vector<glm::vec3> SparseVolumeGrid::boundingBoxTriangles() const {
+  glm::vec3 boundMin = std::get<0>(objectSpaceBoundingBox);
+  glm::vec3 boundMax = std::get<1>(objectSpaceBoundingBox);
+
+  // corner i takes boundMax along axis j when bit j of i is set
+  std::array<glm::vec3, 8> corners;
+  for (int i = 0; i < 8; i++) {
+    corners[i] = glm::vec3{(i & 1) ? boundMax.x : boundMin.x, (i & 2) ? boundMax.y : boundMin.y,
+                           (i & 4) ? boundMax.z : boundMin.z};
+  }
+
+  const int faces[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+  std::vector<glm::vec3> tris;
+  tris.reserve(36);
+  for (const auto& f : faces) {
+    for (int j : {0, 1, 2, 0, 2, 3}) {
+      tris.push_back(corners[f[j]]);
+    }
+  }
+  return tris;
+}
+
+std::shared_ptr<render::TextureBuffer> SparseVolumeGrid::getBrickIndexTexture() {
+  if (brickIndexTexture) return brickIndexTexture;
+
+  // The slot of each brick in the atlas is its index. Exact as a float up to 2^24 bricks.
+  glm::ivec3 res = glm::max(brickRangeMax - brickRangeMin, glm::ivec3(1));
+  std::vector<float> slots(static_cast<size_t>(res.x) * res.y * res.z, -1.f);
+  for (size_t iBrick = 0; iBrick < nBricks(); iBrick++) {
+    glm::ivec3 r = brickCoords[iBrick] - brickRangeMin;
+    slots[(static_cast<size_t>(r.z) * res.y + r.y) * res.x + r.x] = static_cast<float>(iBrick);
+  }
+
+  brickIndexTexture = render::engine->generateTextureBuffer(TextureFormat::R32F, res.x, res.y, res.z, &slots.front());
+  brickIndexTexture->setMemoryOwner(uniquePrefix() + "brickIndexTexture");
+  return brickIndexTexture;
+}
+
+std::shared_ptr<render::TextureBuffer>
+SparseVolumeGrid::generateBrickAtlasTexture(const std::vector<float>& values) const {
+
+  // Each slot holds a padded brick, so trilinear lookups within a slot never need a neighboring slot. Unlike the
+  // values, the texture's x axis is the first node coordinate.
+  const int32_t p = brickSize + 1;
+  glm::ivec3 dims = atlasBricks * p;
+  std::vector<float> atlas(static_cast<size_t>(dims.x) * dims.y * dims.z, std::numeric_limits<float>::quiet_NaN());
+  parallelFor(
+      0, nBricks(),
+      [&](size_t start, size_t end) {
+        std::vector<double> padded(p * p * p);
+        for (size_t iBrick = start; iBrick < end; iBrick++) {
+          gatherPaddedBrick(values, iBrick, padded.data());
+          int32_t s = static_cast<int32_t>(iBrick);
+          glm::ivec3 slot{s % atlasBricks.x, (s / atlasBricks.x) % atlasBricks.y, s / (atlasBricks.x * atlasBricks.y)};
+          glm::ivec3 base = slot * p;
+          for (int32_t i = 0; i < p; i++) {
+            for (int32_t j = 0; j < p; j++) {
+              for (int32_t k = 0; k < p; k++) {
+                size_t t = (static_cast<size_t>(base.z + k) * dims.y + (base.y + j)) * dims.x + (base.x + i);
+                atlas[t] = static_cast<float>(padded[(i * p + j) * p + k]);
+              }
+            }
+          }
+        }
+      },
+      64);
+
+  std::shared_ptr<render::TextureBuffer> tex =
+      render::engine->generateTextureBuffer(TextureFormat::R32F, dims.x, dims.y, dims.z, &atlas.front());
+  tex->setFilterMode(FilterMode::Linear);
+  return tex;
+}
+
+void SparseVolumeGrid::setSparseVolumeGridPointUniforms(render::ShaderProgram& p) {
+  float pointRadius = minGridSpacing() / 8;
+  p.setUniform("u_pointRadius", pointRadius);
+}
+
+void SparseVolumeGrid::setSparseVolumeGridRaymarchUniforms(render::ShaderProgram& p) {
+  glm::mat4 MVinv = glm::inverse(getModelView());
+  p.setUniform("u_invModelView", glm::value_ptr(MVinv));
+  p.setUniform("u_boundMin", std::get<0>(objectSpaceBoundingBox));
+  p.setUniform("u_boundMax", std::get<1>(objectSpaceBoundingBox));
+  p.setUniform("u_gridOrigin", origin);
+  p.setUniform("u_gridSpacing", spacing);
+  p.setUniform("u_brickRangeMin", glm::vec3(brickRangeMin));
+  p.setUniform("u_brickRangeRes", glm::vec3(glm::max(brickRangeMax - brickRangeMin, glm::ivec3(1))));
+  p.setUniform("u_atlasBricks", glm::vec3(atlasBricks));
+  p.setUniform("u_brickSize", static_cast<float>(brickSize));
+  p.setUniform("u_stepSize", minGridSpacing() / 2); // two samples per cell
+}
+
+std::vector<std::string> SparseVolumeGrid::addSparseVolumeGridPointRules(std::vector<std::string> initRules) {
+  initRules = addStructureRules(initRules);
+  if (wantsCullPosition()) {
+    initRules.push_back("SPHERE_CULLPOS_FROM_CENTER");
+  }
+  return initRules;
+}
+
+SparseVolumeGrid* SparseVolumeGrid::setMaterial(std::string m) {
+  material = m;
+  refreshQuantityMaterials();
+  requestRedraw();
+  return this;
+}
+std::string SparseVolumeGrid::getMaterial() { return material.get(); }
+std::string SparseVolumeGrid::drawSortKey() { return material.get(); }
+
+SparseVolumeGridQuantity::SparseVolumeGridQuantity(std::string name_, SparseVolumeGrid& grid_, bool dominates_)
+    : QuantityS<SparseVolumeGrid>(name_, grid_, dominates_) {}
+
+
+SparseVolumeGridScalarQuantity* SparseVolumeGrid::addScalarQuantityImpl(std::string name, std::vector<float>&& values,
+                                                                        DataType dataType_) {
+  SparseVolumeGridScalarQuantity* q = new SparseVolumeGridScalarQuantity(name, *this, std::move(values), dataType_);
+  addQuantity(q);
+  return q;
+}
+
+SparseVolumeGrid* registerSparseVolumeGrid(std::string name, glm::vec3 origin, glm::vec3 spacing,
+                                           const std::vector<glm::ivec3>& activeNodes) {
+  SparseVolumeGrid* s = new SparseVolumeGrid(name, origin, spacing, activeNodes);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
+} // namespace polyscope
@@ -0,0 +1,281 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/sparse_volume_grid_scalar_quantity.h"
+
+#include "polyscope/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace polyscope {
+
+SparseVolumeGridScalarQuantity::SparseVolumeGridScalarQuantity(std::string name, SparseVolumeGrid& grid_,
+                                                               std::vector<float>&& brickValues_, DataType dataType_)
+
+    : SparseVolumeGridQuantity(name, grid_, true),
+      ScalarQuantity(*this, grid_.gatherActiveValues(brickValues_), dataType_), dataType(dataType_),
+      brickValues(std::move(brickValues_)),
+      pointVizEnabled(parent.uniquePrefix() + "#" + name + "#pointVizEnabled", false),
+      isosurfaceVizEnabled(parent.uniquePrefix() + "#" + name + "#isosurfaceVizEnabled", true),
+      isosurfaceLevel(parent.uniquePrefix() + "#" + name + "#isosurfaceLevel",
+                      0.5 * (vizRange.second + vizRange.first)),
+      isosurfaceColor(uniquePrefix() + "#" + name + "#isosurfaceColor", getNextUniqueColor()),
+      isosurfaceRaymarch(parent.uniquePrefix() + "#" + name + "#isosurfaceRaymarch", false)
+
+{}
+
+void SparseVolumeGridScalarQuantity::buildCustomUI() {
+
+  // Select which viz to use
+  ImGui::SameLine();
+  if (ImGui::Button("Mode")) {
+    ImGui::OpenPopup("ModePopup");
+  }
+  if (ImGui::BeginPopup("ModePopup")) {
+    if (ImGui::MenuItem("Points", NULL, &pointVizEnabled.get())) setPointVizEnabled(getPointVizEnabled());
+    if (ImGui::MenuItem("Isosurface", NULL, &isosurfaceVizEnabled.get()))
+      setIsosurfaceVizEnabled(getIsosurfaceVizEnabled());
+    ImGui::EndPopup();
+  }
+
+  // == Options popup
+  ImGui::SameLine();
+  if (ImGui::Button("Options")) {
+    ImGui::OpenPopup("OptionsPopup");
+  }
+  if (ImGui::BeginPopup("OptionsPopup")) {
+    buildScalarOptionsUI();
+    ImGui::EndPopup();
+  }
+
+  if (pointVizEnabled.get()) {
+    buildScalarUI();
+  }
+
+  if (isosurfaceVizEnabled.get()) {
+    ImGui::TextUnformatted("Isosurface:");
+    // Color picker
+    if (ImGui::ColorEdit3("##Color", &isosurfaceColor.get()[0], ImGuiColorEditFlags_NoInputs)) {
+      setIsosurfaceColor(getIsosurfaceColor());
+    }
+    ImGui::SameLine();
+
+    // Set isovalue
+    ImGui::PushItemWidth(120);
+    if (ImGui::SliderFloat("##Radius", &isosurfaceLevel.get(), vizRange.first, vizRange.second, "%.4e")) {
+      setIsosurfaceLevel(getIsosurfaceLevel());
+    }
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Raymarch", &isosurfaceRaymarch.get())) setIsosurfaceRaymarch(getIsosurfaceRaymarch());
+  }
+}
+
+std::string SparseVolumeGridScalarQuantity::niceName() { return name + " (scalar)"; }
+
+void SparseVolumeGridScalarQuantity::refresh() {
+  pointProgram.reset();
+  isosurfaceProgram.reset();
+  isosurfaceRaymarchProgram.reset();
+  atlasTexture.reset();
+}
+
+void SparseVolumeGridScalarQuantity::refreshMaterial() {
+  if (pointProgram) render::engine->setMaterial(*pointProgram, parent.getMaterial());
+  if (isosurfaceProgram) render::engine->setMaterial(*isosurfaceProgram, parent.getMaterial());
+  if (isosurfaceRaymarchProgram) render::engine->setMaterial(*isosurfaceRaymarchProgram, parent.getMaterial());
+}
+
+const std::vector<float>& SparseVolumeGridScalarQuantity::getBrickValues() const { return brickValues; }
+
+void SparseVolumeGridScalarQuantity::draw() {
+  if (!isEnabled()) return;
+
+  // Draw the point viz
+  if (pointVizEnabled.get()) {
+    if (pointProgram == nullptr) {
+      createPointProgram();
+    }
+    parent.setStructureUniforms(*pointProgram);
+    parent.setSparseVolumeGridPointUniforms(*pointProgram);
+    setScalarUniforms(*pointProgram);
+    pointProgram->draw();
+  }
+
+  // Draw the raymarched isosurface
+  if (isosurfaceVizEnabled.get() && isosurfaceRaymarch.get()) {
+    if (isosurfaceRaymarchProgram == nullptr) {
+      createIsosurfaceRaymarchProgram();
+    }
+    parent.setStructureUniforms(*isosurfaceRaymarchProgram);
+    parent.setSparseVolumeGridRaymarchUniforms(*isosurfaceRaymarchProgram);
+    isosurfaceRaymarchProgram->setUniform("u_isoLevel", getIsosurfaceLevel());
+    isosurfaceRaymarchProgram->setUniform("u_baseColor", getIsosurfaceColor());
+    isosurfaceRaymarchProgram->draw();
+  }
+
+  // Draw the extracted isosurface
+  if (isosurfaceVizEnabled.get() && !isosurfaceRaymarch.get()) {
+    if (isosurfaceProgram == nullptr) {
+      createIsosurfaceProgram();
+    }
+    parent.setStructureUniforms(*isosurfaceProgram);
+    isosurfaceProgram->setUniform("u_baseColor", getIsosurfaceColor());
+    isosurfaceProgram->draw();
+  }
+}
+
+void SparseVolumeGridScalarQuantity::createPointProgram() {
+
+  parent.populateGeometry();
+
+  pointProgram = render::engine->requestShader(
+      "RAYCAST_SPHERE", parent.addSparseVolumeGridPointRules(addScalarRules({"SPHERE_PROPAGATE_VALUE"})));
+
+  // Fill buffers
+  pointProgram->setAttribute("a_position", parent.activeNodePositions);
+  pointProgram->setAttribute("a_value", values.getRenderAttributeBuffer());
+  pointProgram->setTextureFromColormap("t_colormap", cMap.get());
+
+  render::engine->setMaterial(*pointProgram, parent.getMaterial());
+}
+
+IsosurfaceMesh SparseVolumeGridScalarQuantity::extractIsosurface() {
+  const int32_t brickSize = SparseVolumeGrid::brickSize;
+  const size_t p = brickSize + 1;
+  const size_t nBricks = parent.nBricks();
+  const double level = getIsosurfaceLevel();
+
+  // Each brick is meshed on its own, along with the layer of cells reaching in to its neighbors, so vertices on the
+  // faces between bricks are not shared. The normals come from the field, so the seams don't show.
+  std::vector<IsosurfaceMesh> brickMeshes(nBricks);
+  parallelFor(
+      0, nBricks,
+      [&](size_t start, size_t end) {
+        std::vector<double> padded(p * p * p);
+        for (size_t iBrick = start; iBrick < end; iBrick++) {
+          parent.gatherPaddedBrick(brickValues, iBrick, padded.data());
+
+          // skip bricks which cannot contain the level before doing any more work (min/max ignore NaN this way)
+          double vMin = std::numeric_limits<double>::infinity();
+          double vMax = -std::numeric_limits<double>::infinity();
+          for (double v : padded) {
+            vMin = std::min(vMin, v);
+            vMax = std::max(vMax, v);
+          }
+          if (!(vMin < level && vMax >= level)) continue;
+
+          GridIsosurfaceExtractor extractor(padded.data(), {p, p, p});
+          IsosurfaceMesh& mesh = brickMeshes[iBrick];
+          mesh = extractor.extract(level);
+
+          glm::vec3 brickOrigin = parent.positionOfNode(parent.getBrickCoords()[iBrick] * brickSize);
+          for (glm::vec3& v : mesh.vertices) {
+            v = brickOrigin + v * parent.spacing;
+          }
+          for (glm::vec3& n : mesh.normals) {
+            n = glm::normalize(n / parent.spacing);
+          }
+        }
+      },
+      16);
+
+  // Concatenate
+  IsosurfaceMesh mesh;
+  size_t nVertices = 0;
+  size_t nIndices = 0;
+  for (const IsosurfaceMesh& m : brickMeshes) {
+    nVertices += m.vertices.size();
+    nIndices += m.indices.size();
+  }
+  if (nVertices > std::numeric_limits<uint32_t>::max()) {
+    exception("isosurface has too many vertices (" + std::to_string(nVertices) + ")");
+    return mesh;
+  }
+  mesh.vertices.reserve(nVertices);
+  mesh.normals.reserve(nVertices);
+  mesh.indices.reserve(nIndices);
+  for (IsosurfaceMesh& m : brickMeshes) {
+    uint32_t offset = static_cast<uint32_t>(mesh.vertices.size());
+    mesh.vertices.insert(mesh.vertices.end(), m.vertices.begin(), m.vertices.end());
+    mesh.normals.insert(mesh.normals.end(), m.normals.begin(), m.normals.end());
+    for (uint32_t ind : m.indices) {
+      mesh.indices.push_back(offset + ind);
+    }
+    m = IsosurfaceMesh(); // release as we go
+  }
+  return mesh;
+}
+
+void SparseVolumeGridScalarQuantity::createIsosurfaceProgram() {
+
+  IsosurfaceMesh mesh = extractIsosurface();
+
+  // Create a render program to draw it
+  isosurfaceProgram = render::engine->requestShader("INDEXED_MESH", parent.addStructureRules({"SHADE_BASECOLOR"}));
+
+  // Populate the program buffers with the extracted mesh
+  isosurfaceProgram->setAttribute("a_position", mesh.vertices);
+  isosurfaceProgram->setAttribute("a_normal", mesh.normals);
+  isosurfaceProgram->setIndex(mesh.indices);
+  isosurfaceProgram->setAttribute("a_barycoord", mesh.normals); // unused
+
+  render::engine->setMaterial(*isosurfaceProgram, parent.getMaterial());
+}
+
+void SparseVolumeGridScalarQuantity::createIsosurfaceRaymarchProgram() {
+  if (!atlasTexture) {
+    atlasTexture = parent.generateBrickAtlasTexture(brickValues);
+    atlasTexture->setMemoryOwner(uniquePrefix() + "atlasTexture");
+  }
+
+  isosurfaceRaymarchProgram = render::engine->requestShader("SPARSE_GRID_RAYMARCH_ISOSURFACE",
+                                                            parent.addStructureRules({"SHADE_BASECOLOR"}));
+
+  isosurfaceRaymarchProgram->setAttribute("a_position", parent.boundingBoxTriangles());
+  isosurfaceRaymarchProgram->setTextureFromBuffer("t_brickIndex", parent.getBrickIndexTexture().get());
+  isosurfaceRaymarchProgram->setTextureFromBuffer("t_volume", atlasTexture.get());
+
+  render::engine->setMaterial(*isosurfaceRaymarchProgram, parent.getMaterial());
+}
+
+// === Getters and setters
+
+SparseVolumeGridScalarQuantity* SparseVolumeGridScalarQuantity::setPointVizEnabled(bool val) {
+  pointVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool SparseVolumeGridScalarQuantity::getPointVizEnabled() { return pointVizEnabled.get(); }
+
+SparseVolumeGridScalarQuantity* SparseVolumeGridScalarQuantity::setIsosurfaceVizEnabled(bool val) {
+  isosurfaceVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool SparseVolumeGridScalarQuantity::getIsosurfaceVizEnabled() { return isosurfaceVizEnabled.get(); }
+
+SparseVolumeGridScalarQuantity* SparseVolumeGridScalarQuantity::setIsosurfaceLevel(float val) {
+  isosurfaceLevel = val;
+  isosurfaceProgram.reset(); // delete the program so it gets recreated with the new value
+  requestRedraw();
+  return this;
+}
+float SparseVolumeGridScalarQuantity::getIsosurfaceLevel() { return isosurfaceLevel.get(); }
+
+SparseVolumeGridScalarQuantity* SparseVolumeGridScalarQuantity::setIsosurfaceColor(glm::vec3 val) {
+  isosurfaceColor = val;
+  requestRedraw();
+  return this;
+}
+glm::vec3 SparseVolumeGridScalarQuantity::getIsosurfaceColor() { return isosurfaceColor.get(); }
+
+SparseVolumeGridScalarQuantity* SparseVolumeGridScalarQuantity::setIsosurfaceRaymarch(bool val) {
+  isosurfaceRaymarch = val;
+  requestRedraw();
+  return this;
+}
+bool SparseVolumeGridScalarQuantity::getIsosurfaceRaymarch() { return isosurfaceRaymarch.get(); }
+
+} // namespace polyscope
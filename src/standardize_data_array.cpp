@@ -0,0 +1,9 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/standardize_data_array_instantiations.h"
+
+// The definitions for polyscope/standardize_data_array_instantiations.h
+
+namespace polyscope {
+POLYSCOPE_STANDARDIZE_INSTANTIATIONS()
+} // namespace polyscope
@@ -11,7 +11,7 @@ std::string backend = "";
 float lengthScale = 1.0;
 std::tuple<glm::vec3, glm::vec3> boundingBox =
     std::tuple<glm::vec3, glm::vec3>{glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.}};
-std::map<std::string, std::map<std::string, std::shared_ptr<Structure>>> structures;
+InsertionOrderedMap<std::string, InsertionOrderedMap<std::string, std::shared_ptr<Structure>>> structures;
 std::map<std::string, std::shared_ptr<Group>> groups;
 std::function<void()> userCallback = nullptr;
 bool doDefaultMouseInteraction = true;
@@ -19,6 +19,7 @@ bool doDefaultMouseInteraction = true;
 // Lists of things
 std::set<Widget*> widgets;
 std::vector<SlicePlane*> slicePlanes;
+std::vector<Viewport*> viewports;
 
 } // namespace state
 } // namespace polyscope
@@ -2,26 +2,41 @@
 
 #include "polyscope/structure.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "polyscope/occlusion_culling.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/render/managed_buffer.h"
 
 #include "imgui.h"
 
 namespace polyscope {
 
 Structure::Structure(std::string name_, std::string subtypeName)
-    : name(name_), enabled(subtypeName + "#" + name + "#enabled", true),
-      objectTransform(subtypeName + "#" + name + "#object_transform", glm::mat4(1.0)),
-      transparency(subtypeName + "#" + name + "#transparency", 1.0),
-      transformGizmo(subtypeName + "#" + name + "#transform_gizmo", objectTransform.get(), &objectTransform),
-      cullWholeElements(subtypeName + "#" + name + "#cullWholeElements", false),
-      ignoredSlicePlaneNames(subtypeName + "#" + name + "#ignored_slice_planes", {}),
+    : name(name_), uniquePrefixStr(subtypeName + "#" + name_ + "#"), enabled(uniquePrefixStr + "enabled", true),
+      objectTransform(uniquePrefixStr + "object_transform", glm::mat4(1.0)),
+      transparency(uniquePrefixStr + "transparency", 1.0),
+      transformGizmo(uniquePrefixStr + "transform_gizmo", objectTransform.get(), &objectTransform),
+      cullWholeElements(uniquePrefixStr + "cullWholeElements", false),
+      staticStructure(uniquePrefixStr + "static", false),
+      ignoredSlicePlaneNames(uniquePrefixStr + "ignored_slice_planes", {}),
+      visibleSubsetMask(uniquePrefixStr + "visibleSubsetMask", visibleSubsetMaskData),
+      highlightedSubsetMask(uniquePrefixStr + "highlightedSubsetMask", highlightedSubsetMaskData),
+      subsetHighlightColor(uniquePrefixStr + "subsetHighlightColor", glm::vec3{1., 0.8, 0.1}),
       objectSpaceBoundingBox(
           std::tuple<glm::vec3, glm::vec3>{glm::vec3{-777, -777, -777}, glm::vec3{-777, -777, -777}}),
       objectSpaceLengthScale(-777) {
   validateName(name);
+  transformGizmo.requestRedrawCallback = [this]() { requestRedraw(); };
 }
 
-Structure::~Structure(){};
+Structure::~Structure() {
+  // (an update which was never committed would defer all buffer updates from now on)
+  while (openUpdates > 0) commitUpdate();
+};
 
 Structure* Structure::setEnabled(bool newEnabled) {
   if (newEnabled == isEnabled()) return this;
@@ -124,6 +139,19 @@ void Structure::buildUI() {
         ImGui::EndMenu();
       }
 
+      // Memory usage
+      if (ImGui::BeginMenu("Memory")) {
+        auto toMB = [](size_t bytes) { return static_cast<double>(bytes) / (1 << 20); };
+        render::GPUMemoryUsage gpuUsage = getGPUMemoryUsage();
+        ImGui::Text("GPU total:     %.2f MB", toMB(gpuUsage.totalBytes()));
+        ImGui::Text("  attributes:  %.2f MB", toMB(gpuUsage.attributeBytes));
+        ImGui::Text("  textures:    %.2f MB", toMB(gpuUsage.textureBytes));
+        ImGui::Text("  renderbufs:  %.2f MB", toMB(gpuUsage.renderBufferBytes));
+        ImGui::Text("Host buffers:  %.2f MB", toMB(getHostMemoryUsage()));
+        ImGui::TextUnformatted("(estimates)");
+        ImGui::EndMenu();
+      }
+
       buildStructureOptionsUI();
 
       // Do any structure-specific stuff here
@@ -132,6 +160,10 @@ void Structure::buildUI() {
       ImGui::EndPopup();
     }
 
+    if (isLoading()) {
+      ImGui::TextUnformatted("loading...");
+    }
+
     // Do any structure-specific stuff here
     this->buildCustomUI();
 
@@ -144,6 +176,10 @@ void Structure::buildUI() {
 }
 
 
+bool Structure::isLoading() { return false; }
+
+std::string Structure::drawSortKey() { return ""; }
+
 void Structure::buildQuantitiesUI() {}
 
 void Structure::buildSharedStructureUI() {}
@@ -166,6 +202,76 @@ std::tuple<glm::vec3, glm::vec3> Structure::boundingBox() {
   return std::tuple<glm::vec3, glm::vec3>{l, u};
 }
 
+bool Structure::mayBeInViewFrustum(const glm::mat4& viewProjMat) {
+  if (!hasExtents()) return true;
+  return objectSpaceBoxMayBeVisible(std::get<0>(objectSpaceBoundingBox), std::get<1>(objectSpaceBoundingBox),
+                                    viewProjMat, false);
+}
+
+bool Structure::objectSpaceBoxMayBeVisible(glm::vec3 bboxMin, glm::vec3 bboxMax, const glm::mat4& viewProjMat,
+                                           bool testSlicePlanes) {
+  for (int d = 0; d < 3; d++) {
+    if (!std::isfinite(bboxMin[d]) || !std::isfinite(bboxMax[d]) || bboxMin[d] > bboxMax[d]) return true;
+  }
+
+  // Bound the box in world space, padded since glyphs like point spheres and vectors are drawn a little past the
+  // geometric extents
+  const glm::mat4& M = objectTransform.get();
+  glm::vec3 worldMin{std::numeric_limits<float>::infinity()};
+  glm::vec3 worldMax{-std::numeric_limits<float>::infinity()};
+  for (int i = 0; i < 8; i++) {
+    glm::vec3 corner{(i & 1) ? bboxMax.x : bboxMin.x, (i & 2) ? bboxMax.y : bboxMin.y,
+                     (i & 4) ? bboxMax.z : bboxMin.z};
+    glm::vec4 w = M * glm::vec4(corner, 1.);
+    worldMin = glm::min(worldMin, glm::vec3(w) / w.w);
+    worldMax = glm::max(worldMax, glm::vec3(w) / w.w);
+  }
+  glm::vec3 pad{0.05f * state::lengthScale};
+  worldMin -= pad;
+  worldMax += pad;
+
+  std::array<glm::vec3, 8> corners;
+  for (int i = 0; i < 8; i++) {
+    corners[i] = glm::vec3{(i & 1) ? worldMax.x : worldMin.x, (i & 2) ? worldMax.y : worldMin.y,
+                           (i & 4) ? worldMax.z : worldMin.z};
+  }
+
+  // The box is outside if all of its corners are on the outer side of any one of the clip planes
+  int outsideCount[6] = {0, 0, 0, 0, 0, 0};
+  for (const glm::vec3& corner : corners) {
+    glm::vec4 c = viewProjMat * glm::vec4(corner, 1.);
+    for (int d = 0; d < 3; d++) {
+      if (c[d] < -c.w) outsideCount[2 * d]++;
+      if (c[d] > c.w) outsideCount[2 * d + 1]++;
+    }
+  }
+  for (int count : outsideCount) {
+    if (count == 8) return false;
+  }
+
+  // ... or if it is entirely on the culled side of any slice plane
+  if (testSlicePlanes) {
+    for (SlicePlane* s : state::slicePlanes) {
+      if (!s->getActive() || getIgnoreSlicePlane(s->name)) continue;
+      glm::vec3 center = s->getCenter();
+      glm::vec3 normal = s->getNormal();
+      bool allCulled = true;
+      for (const glm::vec3& corner : corners) {
+        if (glm::dot(corner - center, normal) >= 0) {
+          allCulled = false;
+          break;
+        }
+      }
+      if (allCulled) return false;
+    }
+  }
+
+  // ... or if it is hidden behind what was drawn on an earlier frame
+  if (!occlusion::boxMayBeVisible(worldMin, worldMax, viewProjMat)) return false;
+
+  return true;
+}
+
 float Structure::lengthScale() {
   // compute the scaling caused by the object transform
   const glm::mat4x4& T = objectTransform.get();
@@ -219,6 +325,15 @@ void Structure::rescaleToUnit() {
 
 bool Structure::hasExtents() { return true; }
 
+RayPickResult Structure::rayPick(glm::vec3 rayStart, glm::vec3 rayDir) { return RayPickResult(); }
+
+std::tuple<glm::vec3, glm::vec3> Structure::rayToObjectSpace(glm::vec3 rayStart, glm::vec3 rayDir) {
+  glm::mat4 invTransform = glm::inverse(objectTransform.get());
+  glm::vec3 objStart = glm::vec3(invTransform * glm::vec4(rayStart, 1.));
+  glm::vec3 objDir = glm::vec3(invTransform * glm::vec4(rayDir, 0.));
+  return std::tuple<glm::vec3, glm::vec3>{objStart, objDir};
+}
+
 glm::mat4 Structure::getModelView() { return view::getCameraViewMatrix() * objectTransform.get(); }
 
 std::vector<std::string> Structure::addStructureRules(std::vector<std::string> initRules) {
@@ -236,22 +351,11 @@ void Structure::setStructureUniforms(render::ShaderProgram& p) {
   glm::mat4 viewMat = getModelView();
   p.setUniform("u_modelView", glm::value_ptr(viewMat));
 
-  if (p.hasUniform("u_projMatrix")) {
-    glm::mat4 projMat = view::getCameraPerspectiveMatrix();
-    p.setUniform("u_projMatrix", glm::value_ptr(projMat));
-  }
-
   if (render::engine->transparencyEnabled()) {
     if (p.hasUniform("u_transparency")) {
       p.setUniform("u_transparency", transparency.get());
     }
 
-    if (p.hasUniform("u_viewportDim")) {
-      glm::vec4 viewport = render::engine->getCurrentViewport();
-      glm::vec2 viewportDim{viewport[2], viewport[3]};
-      p.setUniform("u_viewportDim", viewportDim);
-    }
-
     // Attach the min depth texture, if needed
     // (note that this design is somewhat lazy wrt to the name of the function: it sets a texture, not a uniform, and
     // only actually does anything once on initialization)
@@ -260,10 +364,20 @@ void Structure::setStructureUniforms(render::ShaderProgram& p) {
     }
   }
 
-  // Respect any slice planes
-  for (SlicePlane* s : state::slicePlanes) {
-    bool ignoreThisPlane = getIgnoreSlicePlane(s->name);
-    s->setSceneObjectUniforms(p, ignoreThisPlane);
+  // Respect any slice planes (the planes themselves are frame uniforms)
+  if (p.hasUniform("u_slicePlaneIgnoreMask")) {
+    p.setUniform("u_slicePlaneIgnoreMask", getSlicePlaneIgnoreMask());
+  }
+
+  // Element subsets (the masks are only bound once, they are updated in place)
+  if (p.hasTexture("t_visibleSubset") && !p.textureIsSet("t_visibleSubset")) {
+    p.setTextureFromAttributeBuffer("t_visibleSubset", visibleSubsetMask.getRenderAttributeBuffer());
+  }
+  if (p.hasTexture("t_highlightedSubset") && !p.textureIsSet("t_highlightedSubset")) {
+    p.setTextureFromAttributeBuffer("t_highlightedSubset", highlightedSubsetMask.getRenderAttributeBuffer());
+  }
+  if (p.hasUniform("u_subsetHighlightColor")) {
+    p.setUniform("u_subsetHighlightColor", getSubsetHighlightColor());
   }
 
   // TODO this chain if "if"s is not great. Set up some system in the render engine to conditionally set these? Maybe
@@ -281,7 +395,25 @@ void Structure::setStructureUniforms(render::ShaderProgram& p) {
 
 bool Structure::wantsCullPosition() { return render::engine->slicePlanesEnabled() && getCullWholeElements(); }
 
-std::string Structure::uniquePrefix() { return typeName() + "#" + name + "#"; }
+render::GPUMemoryUsage Structure::getGPUMemoryUsage() { return render::getGPUMemoryUsage(uniquePrefix()); }
+
+size_t Structure::getHostMemoryUsage() { return render::getManagedBufferHostBytes(uniquePrefix()); }
+
+void Structure::releaseGPUResources() {
+  refresh(); // drops all programs, which get lazily re-created
+  render::releaseManagedBufferRenderBuffers(uniquePrefix());
+}
+
+void Structure::beginUpdate() {
+  render::beginManagedBufferUpdateBatch();
+  openUpdates++;
+}
+
+void Structure::commitUpdate() {
+  if (openUpdates == 0) exception("commitUpdate() called on " + name + " without a matching beginUpdate()");
+  openUpdates--;
+  render::endManagedBufferUpdateBatch();
+}
 
 void Structure::remove() { removeStructure(typeName(), name); }
 
@@ -306,12 +438,123 @@ Structure* Structure::setCullWholeElements(bool newVal) {
 }
 bool Structure::getCullWholeElements() { return cullWholeElements.get(); }
 
+namespace {
+
+void fillSubsetMask(std::vector<uint32_t>& mask, const std::vector<size_t>& indices, size_t nElements,
+                    const std::string& structureName) {
+  mask.assign(std::max<size_t>(1, (nElements + 31) / 32), 0u); // (at least one word, for the buffer texture)
+  for (size_t ind : indices) {
+    if (ind >= nElements) {
+      exception("subset index " + std::to_string(ind) + " is out of range for structure [" + structureName +
+                "], which has " + std::to_string(nElements) + " elements");
+    }
+    mask[ind / 32] |= (1u << (ind % 32));
+  }
+}
+
+bool subsetMaskContains(render::ManagedBuffer<uint32_t>& mask, size_t ind) {
+  return ind / 32 < mask.size() && ((mask.getValue(ind / 32) >> (ind % 32)) & 1u) != 0;
+}
+
+} // namespace
+
+Structure* Structure::setVisibleSubset(const std::vector<size_t>& indices) {
+  fillSubsetMask(visibleSubsetMask.data, indices, nSubsetElements(), name);
+  visibleSubsetMask.markHostBufferUpdated();
+  bool rulesChange = !visibleSubsetIsSet;
+  visibleSubsetIsSet = true;
+  subsetMasksChanged();
+  if (rulesChange) refresh();
+  requestRedraw();
+  return this;
+}
+
+Structure* Structure::clearVisibleSubset() {
+  if (!visibleSubsetIsSet) return this;
+  visibleSubsetIsSet = false;
+  subsetMasksChanged();
+  refresh();
+  requestRedraw();
+  return this;
+}
+
+bool Structure::hasVisibleSubset() { return visibleSubsetIsSet; }
+
+bool Structure::isVisibleInSubset(size_t ind) {
+  return !visibleSubsetIsSet || subsetMaskContains(visibleSubsetMask, ind);
+}
+
+Structure* Structure::setHighlightedSubset(const std::vector<size_t>& indices) {
+  fillSubsetMask(highlightedSubsetMask.data, indices, nSubsetElements(), name);
+  highlightedSubsetMask.markHostBufferUpdated();
+  bool rulesChange = !highlightedSubsetIsSet;
+  highlightedSubsetIsSet = true;
+  subsetMasksChanged();
+  if (rulesChange) refresh();
+  requestRedraw();
+  return this;
+}
+
+Structure* Structure::clearHighlightedSubset() {
+  if (!highlightedSubsetIsSet) return this;
+  highlightedSubsetIsSet = false;
+  subsetMasksChanged();
+  refresh();
+  requestRedraw();
+  return this;
+}
+
+bool Structure::hasHighlightedSubset() { return highlightedSubsetIsSet; }
+
+bool Structure::isHighlightedInSubset(size_t ind) {
+  return highlightedSubsetIsSet && subsetMaskContains(highlightedSubsetMask, ind);
+}
+
+Structure* Structure::setSubsetHighlightColor(glm::vec3 newVal) {
+  subsetHighlightColor = newVal;
+  requestRedraw();
+  return this;
+}
+glm::vec3 Structure::getSubsetHighlightColor() { return subsetHighlightColor.get(); }
+
+size_t Structure::nSubsetElements() {
+  exception("structure [" + name + "] of type " + typeName() + " does not support element subsets");
+  return 0;
+}
+
+void Structure::subsetMasksChanged() {}
+
+std::vector<std::string> Structure::addSubsetRules(std::vector<std::string> initRules, const std::string& indexRule) {
+  if (!hasSubsetMasks()) return initRules;
+  initRules.push_back(indexRule);
+  if (visibleSubsetIsSet) initRules.push_back("SUBSET_VISIBLE_CULL");
+  if (highlightedSubsetIsSet) initRules.push_back("SUBSET_HIGHLIGHT");
+  return initRules;
+}
+
+std::vector<std::string> Structure::removeSubsetHighlightRules(std::vector<std::string> pickRules) {
+  pickRules.erase(std::remove(pickRules.begin(), pickRules.end(), "SUBSET_HIGHLIGHT"), pickRules.end());
+  return pickRules;
+}
+
+Structure* Structure::setStatic(bool newVal) {
+  if (newVal == isStatic()) return this;
+  staticStructure = newVal;
+  polyscope::requestRedraw(); // (the structure moves between layers, so both change)
+  return this;
+}
+bool Structure::isStatic() { return staticStructure.get(); }
+
+void Structure::requestRedraw() {
+  if (!isStatic()) internal::dynamicContentChanges++;
+  polyscope::requestRedraw();
+}
+
 Structure* Structure::setIgnoreSlicePlane(std::string name, bool newValue) {
 
   if (getIgnoreSlicePlane(name) == newValue) {
     // no change
     ignoredSlicePlaneNames.manuallyChanged();
-    refresh();
     requestRedraw();
     return this;
   }
@@ -325,7 +568,6 @@ Structure* Structure::setIgnoreSlicePlane(std::string name, bool newValue) {
     names.erase(std::remove(names.begin(), names.end(), name), names.end());
   }
   ignoredSlicePlaneNames.manuallyChanged();
-  refresh();
   requestRedraw();
   return this;
 }
@@ -336,4 +578,12 @@ bool Structure::getIgnoreSlicePlane(std::string name) {
   return ignoreThisPlane;
 }
 
+uint32_t Structure::getSlicePlaneIgnoreMask() {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < state::slicePlanes.size(); i++) {
+    if (getIgnoreSlicePlane(state::slicePlanes[i]->name)) mask |= (1u << i);
+  }
+  return mask;
+}
+
 } // namespace polyscope
@@ -12,6 +12,10 @@ SurfaceColorQuantity::SurfaceColorQuantity(std::string name, SurfaceMesh& mesh_,
                                            const std::vector<glm::vec3>& colorValues_)
     : SurfaceMeshQuantity(name, mesh_, true), ColorQuantity(*this, colorValues_), definedOn(definedOn_) {}
 
+SurfaceColorQuantity::SurfaceColorQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn_,
+                                           const std::vector<uint32_t>& packedColorValues_)
+    : SurfaceMeshQuantity(name, mesh_, true), ColorQuantity(*this, packedColorValues_), definedOn(definedOn_) {}
+
 void SurfaceColorQuantity::draw() {
   if (!isEnabled()) return;
 
@@ -36,20 +40,33 @@ SurfaceVertexColorQuantity::SurfaceVertexColorQuantity(std::string name, Surface
 
 {}
 
+SurfaceVertexColorQuantity::SurfaceVertexColorQuantity(std::string name, SurfaceMesh& mesh_,
+                                                       std::vector<uint32_t> packedColorValues_)
+    : SurfaceColorQuantity(name, mesh_, "vertex", packedColorValues_)
+
+{}
+
 void SurfaceVertexColorQuantity::createProgram() {
   // Create the program to draw this quantity
-  program = render::engine->requestShader("MESH", parent.addSurfaceMeshRules({"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}));
+  program = render::engine->requestShader(
+      parent.getMeshProgramName(true), parent.addSurfaceMeshRules({colorRule("MESH_PROPAGATE_COLOR"), "SHADE_COLOR"}));
 
   parent.setMeshGeometryAttributes(*program);
-  program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleVertexInds));
+  if (isPacked()) {
+    program->setAttribute(colorAttributeName(), parent.getVertexAttributeBuffer(*program, colorsPacked));
+  } else {
+    program->setAttribute(colorAttributeName(), parent.getVertexAttributeBuffer(*program, colors));
+  }
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
+bool SurfaceVertexColorQuantity::fitsMeshTopology() { return nColors() == parent.vertexDataSize; }
+
 void SurfaceVertexColorQuantity::buildVertexInfoGUI(size_t vInd) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
 
-  glm::vec3 tempColor = colors.getValue(vInd);
+  glm::vec3 tempColor = getColor(vInd);
   ImGui::ColorEdit3("", &tempColor[0], ImGuiColorEditFlags_NoInputs | ImGuiColorEditFlags_NoPicker);
   ImGui::SameLine();
   std::string colorStr = to_string_short(tempColor);
@@ -64,6 +81,10 @@ void SurfaceColorQuantity::refresh() {
   Quantity::refresh();
 }
 
+void SurfaceColorQuantity::refreshMaterial() {
+  if (program) render::engine->setMaterial(*program, parent.getMaterial());
+}
+
 // ========================================================
 // ==========            Face Color              ==========
 // ========================================================
@@ -76,13 +97,25 @@ SurfaceFaceColorQuantity::SurfaceFaceColorQuantity(std::string name, SurfaceMesh
 
 void SurfaceFaceColorQuantity::createProgram() {
   // Create the program to draw this quantity
-  program = render::engine->requestShader("MESH", parent.addSurfaceMeshRules({"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}));
-
-  parent.setMeshGeometryAttributes(*program);
-  program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  if (parent.canFetchFaceData()) {
+    // look up the color of each face by primitive ID, rather than expanding the colors to triangle corners
+    program = render::engine->requestShader(
+        parent.getMeshProgramName(true),
+        parent.addSurfaceMeshRules(parent.addFaceFetchRules({"MESH_FETCH_FACE_COLOR", "SHADE_COLOR"})));
+    program->setTextureFromBuffer("t_faceValues", colors.getTextureViewBuffer().get());
+    parent.setFaceFetchTextures(*program);
+    parent.setMeshGeometryAttributes(*program);
+  } else {
+    program =
+        render::engine->requestShader("MESH", parent.addSurfaceMeshRules({"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}));
+    parent.setMeshGeometryAttributes(*program);
+    program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  }
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
+bool SurfaceFaceColorQuantity::fitsMeshTopology() { return colors.size() == parent.faceDataSize; }
+
 void SurfaceFaceColorQuantity::buildFaceInfoGUI(size_t fInd) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
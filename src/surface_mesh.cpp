@@ -3,8 +3,10 @@
 #include "polyscope/surface_mesh.h"
 
 #include "glm/fwd.hpp"
-#include "polyscope/combining_hash_functions.h"
+#include "polyscope/mesh_draw_order.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
+#include "polyscope/profiling.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
@@ -12,47 +14,147 @@
 #include "polyscope/types.h"
 #include "polyscope/utilities.h"
 
-#include <unordered_map>
+#include <algorithm>
+#include <limits>
 #include <utility>
 
 namespace polyscope {
 
+namespace {
+
+// Group the halfedges of a triangle list by the (undirected) edge they lie along. Halfedge 3*iT+j runs from vertex j
+// to vertex j+1 of triangle iT. On return the halfedges of edge i are sortedHalfedges[edgeStart[i]...edgeStart[i+1]),
+// in increasing order. Edges are ordered by their sorted vertex pair.
+//
+// This is an LSD radix sort on 64-bit keys which pack the pair of vertex indices, so it is deterministic and avoids
+// the allocation and cache-miss costs of hashing pairs on large meshes.
+void groupHalfedgesByEdge(const std::vector<uint32_t>& triVertexInds, std::vector<uint32_t>& sortedHalfedges,
+                          std::vector<uint32_t>& edgeStart) {
+
+  size_t nHe = triVertexInds.size();
+  if (nHe >= std::numeric_limits<uint32_t>::max()) exception("too many halfedges to index edges");
+
+  std::vector<uint64_t> keys(nHe);
+  uint64_t allKeyBits = 0;
+  for (size_t iHe = 0; iHe < nHe; iHe++) {
+    size_t iT = iHe / 3;
+    uint64_t vA = triVertexInds[iHe];
+    uint64_t vB = triVertexInds[3 * iT + (iHe + 1) % 3];
+    keys[iHe] = (std::min(vA, vB) << 32) | std::max(vA, vB);
+    allKeyBits |= keys[iHe];
+  }
+
+  sortedHalfedges.resize(nHe);
+  for (size_t iHe = 0; iHe < nHe; iHe++) sortedHalfedges[iHe] = iHe;
+
+  // Stable counting sort on each 16-bit digit, least significant first. Stability keeps the halfedges of each key in
+  // increasing order. Digits which are zero for every key are skipped.
+  const int DIGIT_BITS = 16;
+  const size_t N_BUCKETS = 1 << DIGIT_BITS;
+  std::vector<uint64_t> keysTmp(nHe);
+  std::vector<uint32_t> halfedgesTmp(nHe);
+  std::vector<size_t> bucketStart(N_BUCKETS + 1);
+  for (int shift = 0; shift < 64; shift += DIGIT_BITS) {
+    if (((allKeyBits >> shift) & (N_BUCKETS - 1)) == 0) continue;
+
+    std::fill(bucketStart.begin(), bucketStart.end(), 0);
+    for (uint64_t k : keys) bucketStart[((k >> shift) & (N_BUCKETS - 1)) + 1]++;
+    for (size_t b = 0; b < N_BUCKETS; b++) bucketStart[b + 1] += bucketStart[b];
+
+    for (size_t i = 0; i < nHe; i++) {
+      size_t& dst = bucketStart[(keys[i] >> shift) & (N_BUCKETS - 1)];
+      keysTmp[dst] = keys[i];
+      halfedgesTmp[dst] = sortedHalfedges[i];
+      dst++;
+    }
+    keys.swap(keysTmp);
+    sortedHalfedges.swap(halfedgesTmp);
+  }
+
+  // Find the runs of equal keys
+  edgeStart.clear();
+  for (size_t i = 0; i < nHe; i++) {
+    if (i == 0 || keys[i] != keys[i - 1]) edgeStart.push_back(i);
+  }
+  edgeStart.push_back(nHe);
+}
+
+// Number the edges found by groupHalfedgesByEdge() by order of first appearance when walking the halfedges in order,
+// filling halfedgeEdge[iHe] with the number of the edge containing halfedge iHe. Returns the number of edges.
+size_t numberEdgesByFirstAppearance(const std::vector<uint32_t>& sortedHalfedges,
+                                    const std::vector<uint32_t>& edgeStart, std::vector<uint32_t>& halfedgeEdge) {
+
+  size_t nEdge = edgeStart.size() - 1;
+  const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+  // the first halfedge of each edge, which is the lowest since the groups are sorted
+  std::vector<uint32_t> edgeFromFirstHalfedge(sortedHalfedges.size(), NONE);
+  for (size_t iE = 0; iE < nEdge; iE++) {
+    edgeFromFirstHalfedge[sortedHalfedges[edgeStart[iE]]] = iE;
+  }
+
+  std::vector<uint32_t> edgeNumber(nEdge);
+  uint32_t nextNumber = 0;
+  for (uint32_t iE : edgeFromFirstHalfedge) {
+    if (iE != NONE) edgeNumber[iE] = nextNumber++;
+  }
+
+  halfedgeEdge.resize(sortedHalfedges.size());
+  for (size_t iE = 0; iE < nEdge; iE++) {
+    for (size_t i = edgeStart[iE]; i < edgeStart[iE + 1]; i++) {
+      halfedgeEdge[sortedHalfedges[i]] = edgeNumber[iE];
+    }
+  }
+
+  return nEdge;
+}
+
+} // namespace
+
 // Initialize statics
 const std::string SurfaceMesh::structureTypeName = "Surface Mesh";
 
 
-SurfaceMesh::SurfaceMesh(std::string name_)
+SurfaceMesh::SurfaceMesh(std::string name_) : SurfaceMesh(name_, nullptr) {}
+
+SurfaceMesh::SurfaceMesh(std::string name_, SurfaceMesh* source_)
     : QuantityStructure<SurfaceMesh>(name_, typeName()),
       // clang-format off
 
 // == managed quantities
 
 // positions
-vertexPositions(        uniquePrefix() + "vertexPositions",     vertexPositionsData),
+vertexPositions(        uniquePrefix() + "vertexPositions",     geometryDataOwner(source_).vertexPositionsData),
 
 // connectivity / indices
-// (triangle and face inds are always computed initially when we triangulate the mesh)
-triangleVertexInds(     uniquePrefix() + "triangleVertexInds",          triangleVertexIndsData),
-triangleFaceInds(       uniquePrefix() + "triangleFaceInds",            triangleFaceIndsData),
-triangleCornerInds(     uniquePrefix() + "triangleCornerInds",          triangleCornerIndsData,         std::bind(&SurfaceMesh::computeTriangleCornerInds, this)),
-triangleAllEdgeInds(    uniquePrefix() + "triangleAllEdgeInds",         triangleAllEdgeIndsData,        std::bind(&SurfaceMesh::computeTriangleAllEdgeInds, this)),
-triangleAllHalfedgeInds(   uniquePrefix() + "triangleHalfedgeInds",     triangleAllHalfedgeIndsData,    std::bind(&SurfaceMesh::computeTriangleAllHalfedgeInds, this)),
-triangleAllCornerInds(     uniquePrefix() + "triangleCornerInds",       triangleAllCornerIndsData,      std::bind(&SurfaceMesh::computeTriangleAllCornerInds, this)),
+// (triangle and face inds all come from triangulating the mesh, see computeConnectivityData())
+triangleVertexInds(     uniquePrefix() + "triangleVertexInds",          geometryDataOwner(source_).triangleVertexIndsData,         std::bind(&SurfaceMesh::ensureTriangulationComputed, this)),
+triangleFaceInds(       uniquePrefix() + "triangleFaceInds",            geometryDataOwner(source_).triangleFaceIndsData,           std::bind(&SurfaceMesh::ensureTriangulationComputed, this)),
+triangleCornerInds(     uniquePrefix() + "triangleCornerInds",          geometryDataOwner(source_).triangleCornerIndsData,         std::bind(&SurfaceMesh::computeTriangleCornerInds, this)),
+triangleAllEdgeInds(    uniquePrefix() + "triangleAllEdgeInds",         geometryDataOwner(source_).triangleAllEdgeIndsData,        std::bind(&SurfaceMesh::computeTriangleAllEdgeInds, this)),
+triangleAllHalfedgeInds(   uniquePrefix() + "triangleHalfedgeInds",     geometryDataOwner(source_).triangleAllHalfedgeIndsData,    std::bind(&SurfaceMesh::computeTriangleAllHalfedgeInds, this)),
+triangleAllCornerInds(     uniquePrefix() + "triangleCornerInds",       geometryDataOwner(source_).triangleAllCornerIndsData,      std::bind(&SurfaceMesh::computeTriangleAllCornerInds, this)),
+triangleAllVertexInds(     uniquePrefix() + "triangleAllVertexInds",    geometryDataOwner(source_).triangleAllVertexIndsData,      std::bind(&SurfaceMesh::computeTriangleAllVertexInds, this)),
+triangleFaces(          uniquePrefix() + "triangleFaces",               geometryDataOwner(source_).triangleFacesData,              std::bind(&SurfaceMesh::computeTriangleFaces, this)),
 
 // internal triangle data for rendering
-baryCoord(              uniquePrefix() + "baryCoord",           baryCoordData),
-edgeIsReal(             uniquePrefix() + "edgeIsReal",          edgeIsRealData),
+baryCoord(              uniquePrefix() + "baryCoord",           geometryDataOwner(source_).baryCoordData,          std::bind(&SurfaceMesh::ensureTriangulationComputed, this)),
+edgeIsReal(             uniquePrefix() + "edgeIsReal",          geometryDataOwner(source_).edgeIsRealData,         std::bind(&SurfaceMesh::ensureTriangulationComputed, this)),
+compressedVertexAttributes(uniquePrefix() + "compressedVertexAttributes", geometryDataOwner(source_).compressedVertexAttributesData, std::bind(&SurfaceMesh::computeCompressedVertexAttributes, this)),
 
 // other internally-computed geometry
-faceNormals(            uniquePrefix() + "faceNormals",         faceNormalsData,        std::bind(&SurfaceMesh::computeFaceNormals, this)),
-faceCenters(            uniquePrefix() + "faceCenters",         faceCentersData,        std::bind(&SurfaceMesh::computeFaceCenters, this)),         
-faceAreas(              uniquePrefix() + "faceAreas",           faceAreasData,          std::bind(&SurfaceMesh::computeFaceAreas, this)),
-vertexNormals(          uniquePrefix() + "vertexNormals",       vertexNormalsData,      std::bind(&SurfaceMesh::computeVertexNormals, this)),
-vertexAreas(            uniquePrefix() + "vertexAreas",         vertexAreasData,        std::bind(&SurfaceMesh::computeVertexAreas, this)),
+faceNormals(            uniquePrefix() + "faceNormals",         geometryDataOwner(source_).faceNormalsData,        std::bind(&SurfaceMesh::computeFaceNormals, this)),
+faceCenters(            uniquePrefix() + "faceCenters",         geometryDataOwner(source_).faceCentersData,        std::bind(&SurfaceMesh::computeFaceCenters, this)),         
+faceAreas(              uniquePrefix() + "faceAreas",           geometryDataOwner(source_).faceAreasData,          std::bind(&SurfaceMesh::computeFaceAreas, this)),
+vertexNormals(          uniquePrefix() + "vertexNormals",       geometryDataOwner(source_).vertexNormalsData,      std::bind(&SurfaceMesh::computeVertexNormals, this)),
+vertexAreas(            uniquePrefix() + "vertexAreas",         geometryDataOwner(source_).vertexAreasData,        std::bind(&SurfaceMesh::computeVertexAreas, this)),
 
 // tangent spaces
-defaultFaceTangentBasisX(   uniquePrefix() + "defaultFaceTangentBasisX",  defaultFaceTangentBasisXData,  std::bind(&SurfaceMesh::computeDefaultFaceTangentBasisX, this)),
-defaultFaceTangentBasisY(   uniquePrefix() + "defaultFaceTangentBasisY",  defaultFaceTangentBasisYData,  std::bind(&SurfaceMesh::computeDefaultFaceTangentBasisY, this)),
+defaultFaceTangentBasisX(   uniquePrefix() + "defaultFaceTangentBasisX",  geometryDataOwner(source_).defaultFaceTangentBasisXData,  std::bind(&SurfaceMesh::computeDefaultFaceTangentBasisX, this)),
+defaultFaceTangentBasisY(   uniquePrefix() + "defaultFaceTangentBasisY",  geometryDataOwner(source_).defaultFaceTangentBasisYData,  std::bind(&SurfaceMesh::computeDefaultFaceTangentBasisY, this)),
+
+// optimized draw order
+drawVertexOrder(        uniquePrefix() + "drawVertexOrder",     geometryDataOwner(source_).drawVertexOrderData,    std::bind(&SurfaceMesh::computeDrawVertexOrder, this)),
 
 // == persistent options
 surfaceColor(           uniquePrefix() + "surfaceColor",    getNextUniqueColor()),
@@ -65,13 +167,13 @@ shadeStyle(             uniquePrefix() + "shadeStyle",      MeshShadeStyle::Flat
 // clang-format on
 {}
 
-SurfaceMesh::SurfaceMesh(std::string name_, const std::vector<glm::vec3>& vertexPositions_,
-                         const std::vector<uint32_t>& faceIndsEntries_, const std::vector<uint32_t>& faceIndsStart_)
+SurfaceMesh::SurfaceMesh(std::string name_, std::vector<glm::vec3> vertexPositions_,
+                         std::vector<uint32_t> faceIndsEntries_, std::vector<uint32_t> faceIndsStart_)
     : SurfaceMesh(name_) {
 
-  vertexPositionsData = vertexPositions_;
-  faceIndsEntries = faceIndsEntries_;
-  faceIndsStart = faceIndsStart_;
+  vertexPositionsData = std::move(vertexPositions_);
+  faceIndsEntries = std::move(faceIndsEntries_);
+  faceIndsStart = std::move(faceIndsStart_);
 
   computeConnectivityData();
   updateObjectSpaceBounds();
@@ -88,94 +190,326 @@ SurfaceMesh::SurfaceMesh(std::string name_, const std::vector<glm::vec3>& vertex
   updateObjectSpaceBounds();
 }
 
+SurfaceMesh::SurfaceMesh(std::string name_, SurfaceMesh& source_) : SurfaceMesh(name_, &source_) {
+
+  // the buffers already wrap the source's data (see geometryDataOwner()), so they can alias the source's buffers
+  SurfaceMesh& source = geometryDataOwner(&source_);
+  geometrySource = &source;
+  source.geometryViews.push_back(this);
+
+  // if the source is registered, hold on to it, so that it can be removed before its views
+  if (state::structures.find(typeName()) != state::structures.end()) {
+    InsertionOrderedMap<std::string, std::shared_ptr<Structure>>& sMap = state::structures[typeName()];
+    if (sMap.find(source.name) != sMap.end() && sMap[source.name].get() == &source) {
+      geometrySourceRef = sMap[source.name];
+    }
+  }
+
+  vertexPositions.shareFrom(source.vertexPositions);
+  triangleVertexInds.shareFrom(source.triangleVertexInds);
+  triangleFaceInds.shareFrom(source.triangleFaceInds);
+  triangleCornerInds.shareFrom(source.triangleCornerInds);
+  triangleAllEdgeInds.shareFrom(source.triangleAllEdgeInds);
+  triangleAllHalfedgeInds.shareFrom(source.triangleAllHalfedgeInds);
+  triangleAllCornerInds.shareFrom(source.triangleAllCornerInds);
+  triangleAllVertexInds.shareFrom(source.triangleAllVertexInds);
+  triangleFaces.shareFrom(source.triangleFaces);
+  baryCoord.shareFrom(source.baryCoord);
+  edgeIsReal.shareFrom(source.edgeIsReal);
+  compressedVertexAttributes.shareFrom(source.compressedVertexAttributes);
+  faceNormals.shareFrom(source.faceNormals);
+  faceCenters.shareFrom(source.faceCenters);
+  faceAreas.shareFrom(source.faceAreas);
+  vertexNormals.shareFrom(source.vertexNormals);
+  vertexAreas.shareFrom(source.vertexAreas);
+  defaultFaceTangentBasisX.shareFrom(source.defaultFaceTangentBasisX);
+  defaultFaceTangentBasisY.shareFrom(source.defaultFaceTangentBasisY);
+  drawVertexOrder.shareFrom(source.drawVertexOrder);
+
+  // the connectivity and indexing conventions, which are fixed while the geometry is shared
+  faceIndsStart = source.faceIndsStart;
+  faceIndsEntries = source.faceIndsEntries;
+  edgePerm = source.edgePerm;
+  halfedgePerm = source.halfedgePerm;
+  cornerPerm = source.cornerPerm;
+  vertexDataSize = source.vertexDataSize;
+  faceDataSize = source.faceDataSize;
+  edgeDataSize = source.edgeDataSize;
+  halfedgeDataSize = source.halfedgeDataSize;
+  cornerDataSize = source.cornerDataSize;
+  nCornersCount = source.nCornersCount;
+  nFacesTriangulationCount = source.nFacesTriangulationCount;
+  optimizeDrawOrder = source.optimizeDrawOrder;
+
+  updateObjectSpaceBounds();
+}
+
+SurfaceMesh& SurfaceMesh::geometryDataOwner(SurfaceMesh* source) {
+  if (source == nullptr) return *this;
+  return source->geometrySource ? *source->geometrySource : *source; // (a view of a view shares the original)
+}
+
 void SurfaceMesh::nestedFacesToFlat(const std::vector<std::vector<size_t>>& nestedInds) {
 
-  faceIndsStart.clear();
-  faceIndsEntries.clear();
-  faceIndsStart.push_back(0);
+  // size the arrays up front with a prefix sum of the face degrees, then fill in each face
+  faceIndsStart.resize(nestedInds.size() + 1);
+  faceIndsStart[0] = 0;
+  for (size_t iF = 0; iF < nestedInds.size(); iF++) {
+    faceIndsStart[iF + 1] = faceIndsStart[iF] + nestedInds[iF].size();
+  }
 
-  for (const std::vector<size_t>& face : nestedInds) {
-    for (size_t iV : face) {
-      faceIndsEntries.push_back(iV);
+  faceIndsEntries.resize(faceIndsStart.back());
+  parallelFor(0, nestedInds.size(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      std::copy(nestedInds[iF].begin(), nestedInds[iF].end(), faceIndsEntries.begin() + faceIndsStart[iF]);
     }
-    faceIndsStart.push_back(faceIndsEntries.size());
+  });
+}
+
+SurfaceMesh::~SurfaceMesh() {
+  // the worker reads the face arrays
+  if (triangulationTask.valid()) triangulationTask.wait();
+
+  if (geometrySource) {
+    std::vector<SurfaceMesh*>& views = geometrySource->geometryViews;
+    views.erase(std::remove(views.begin(), views.end(), this), views.end());
+  }
+}
+
+void SurfaceMesh::checkNotGeometryView(std::string operation) {
+  if (geometrySource) {
+    exception("SurfaceMesh " + name + " is a view of the geometry of " + geometrySource->name + ", " + operation +
+              " must be done on that mesh");
+  }
+}
+
+void SurfaceMesh::checkGeometryNotShared(std::string operation) {
+  checkNotGeometryView(operation);
+  if (!geometryViews.empty()) {
+    exception("SurfaceMesh " + name + " shares its geometry with " + std::to_string(geometryViews.size()) +
+              " view(s), " + operation + " is not supported while it does");
+  }
+}
+
+void SurfaceMesh::markGeometryViewsUpdated() {
+  for (SurfaceMesh* view : geometryViews) {
+    view->drawClusters.clear();
+    view->geometryRevision++;
+  }
+}
+
+void SurfaceMesh::validateConnectivity(const std::vector<uint32_t>& entries, const std::vector<uint32_t>& start,
+                                       size_t nVerts) {
+
+  // validate the face list; each face is fan-triangulated, and the triangle counts need at least 3 vertices
+  if (start.empty() || start.front() != 0 || start.back() != entries.size()) {
+    exception("SurfaceMesh " + name + " face start array must begin at 0 and end at the number of face entries");
+  }
+  for (size_t iF = 0; iF + 1 < start.size(); iF++) {
+    if (start[iF + 1] < start[iF] + 3) {
+      exception("SurfaceMesh " + name + " face " + std::to_string(iF) + " has fewer than 3 vertices");
+    }
+  }
+
+  // validate the face-vertex indices
+  for (size_t iV : entries) {
+    if (iV >= nVerts)
+      exception("SurfaceMesh " + name + " has face vertex index " + std::to_string(iV) +
+                " out of bounds for number of vertices " + std::to_string(nVerts));
   }
 }
 
 void SurfaceMesh::computeConnectivityData() {
+  profiling::ScopedTimer timer("SurfaceMesh::computeConnectivityData");
+
+  validateConnectivity(faceIndsEntries, faceIndsStart, vertexPositions.size());
 
   // some number-of-elements arithmetic
   size_t numFaces = faceIndsStart.size() - 1;
   nCornersCount = faceIndsEntries.size();
   nFacesTriangulationCount = nCornersCount - 2 * numFaces;
 
-  // fill out these buffers as we construct the triangulation
-  triangleVertexIndsData.clear();
-  triangleVertexIndsData.resize(3 * nFacesTriangulationCount);
-  triangleFaceIndsData.clear();
-  triangleFaceIndsData.resize(3 * nFacesTriangulationCount);
-  baryCoordData.clear();
-  baryCoordData.resize(3 * nFacesTriangulationCount);
-  edgeIsRealData.clear();
-  edgeIsRealData.resize(3 * nFacesTriangulationCount);
+  vertexDataSize = nVertices();
+  faceDataSize = nFaces();
+  // edgeDataSize = ... we don't know this yet, gets set below
+  halfedgeDataSize = nHalfedges();
+  cornerDataSize = nCorners();
 
-  // validate the face-vertex indices
-  for (size_t iV : faceIndsEntries) {
-    if (iV >= vertexPositions.size())
-      exception("SurfaceMesh " + name + " has face vertex index " + std::to_string(iV) +
-                " out of bounds for number of vertices " + std::to_string(vertexPositions.size()));
+  // The triangulation populates the triangle buffers when they are first needed. For big meshes, optionally start it
+  // now on a worker thread, so that registering the mesh doesn't block.
+  const size_t backgroundMinCorners = 1 << 18;
+  if (options::prepareStructuresInBackground && nCornersCount >= backgroundMinCorners) {
+    triangulationTask = std::async(std::launch::async, [this]() { return computeTriangulation(); });
   }
+}
 
-  // construct the triangualted draw list and all other related data
-  size_t iTriFace = 0;
-  for (size_t iF = 0; iF < numFaces; iF++) {
-    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
+SurfaceMesh::TriangulationData SurfaceMesh::computeTriangulation() const {
 
-    size_t iStart = faceIndsStart[iF];
-    uint32_t vRoot = faceIndsEntries[iStart];
-
-    // implicitly triangulate from root
-    for (size_t j = 1; (j + 1) < D; j++) {
-      uint32_t vB = faceIndsEntries[iStart + j];
-      uint32_t vC = faceIndsEntries[iStart + ((j + 1) % D)];
-
-      // triangle vertex indices
-      triangleVertexIndsData[3 * iTriFace + 0] = vRoot;
-      triangleVertexIndsData[3 * iTriFace + 1] = vB;
-      triangleVertexIndsData[3 * iTriFace + 2] = vC;
-
-      // triangle face indices
-      for (size_t k = 0; k < 3; k++) triangleFaceIndsData[3 * iTriFace + k] = iF;
-
-      // barycentric coordinates
-      baryCoordData[3 * iTriFace + 0] = glm::vec3{1., 0., 0.};
-      baryCoordData[3 * iTriFace + 1] = glm::vec3{0., 1., 0.};
-      baryCoordData[3 * iTriFace + 2] = glm::vec3{0., 0., 1.};
-
-      // internal edges for triangulated polygons
-      glm::vec3 edgeRealV{0., 1., 0.};
-      if (j == 1) {
-        edgeRealV.x = 1.;
-      }
-      if (j + 2 == D) {
-        edgeRealV.z = 1.;
+  size_t numFaces = faceIndsStart.size() - 1;
+
+  // fill out these buffers as we construct the triangulation
+  TriangulationData result;
+  result.vertexInds.resize(3 * nFacesTriangulationCount);
+  result.faceInds.resize(3 * nFacesTriangulationCount);
+  result.baryCoords.resize(3 * nFacesTriangulationCount);
+  result.edgeIsReal.resize(3 * nFacesTriangulationCount);
+
+  // construct the triangulated draw list and all other related data; each face's triangles start at a known offset,
+  // so faces can be filled in parallel
+  parallelFor(0, numFaces, [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
+
+      size_t iStart = faceIndsStart[iF];
+      uint32_t vRoot = faceIndsEntries[iStart];
+      size_t iTriFace = faceIndsStart[iF] - 2 * iF; // (in face order, optimizeTriangulationDrawOrder() moves them)
+
+      // implicitly triangulate from root
+      for (size_t j = 1; (j + 1) < D; j++) {
+        uint32_t vB = faceIndsEntries[iStart + j];
+        uint32_t vC = faceIndsEntries[iStart + ((j + 1) % D)];
+
+        // triangle vertex indices
+        result.vertexInds[3 * iTriFace + 0] = vRoot;
+        result.vertexInds[3 * iTriFace + 1] = vB;
+        result.vertexInds[3 * iTriFace + 2] = vC;
+
+        // triangle face indices
+        for (size_t k = 0; k < 3; k++) result.faceInds[3 * iTriFace + k] = iF;
+
+        // barycentric coordinates
+        result.baryCoords[3 * iTriFace + 0] = glm::vec3{1., 0., 0.};
+        result.baryCoords[3 * iTriFace + 1] = glm::vec3{0., 1., 0.};
+        result.baryCoords[3 * iTriFace + 2] = glm::vec3{0., 0., 1.};
+
+        // internal edges for triangulated polygons
+        glm::vec3 edgeRealV{0., 1., 0.};
+        if (j == 1) {
+          edgeRealV.x = 1.;
+        }
+        if (j + 2 == D) {
+          edgeRealV.z = 1.;
+        }
+        for (size_t k = 0; k < 3; k++) result.edgeIsReal[3 * iTriFace + k] = edgeRealV;
+
+        iTriFace++;
       }
-      for (size_t k = 0; k < 3; k++) edgeIsRealData[3 * iTriFace + k] = edgeRealV;
+    }
+  });
+
+  if (optimizeDrawOrder) optimizeTriangulationDrawOrder(result);
+
+  return result;
+}
+
+namespace {
 
-      iTriFace++;
+// Move each face's run of per-corner triangle data from the face order to the given starts
+template <typename T>
+void moveFaceTriangles(std::vector<T>& perCorner, const std::vector<uint32_t>& faceIndsStart,
+                       const std::vector<uint32_t>& triangleStartOfFace) {
+  std::vector<T> moved(perCorner.size());
+  parallelFor(0, triangleStartOfFace.size(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t nTriCorners = 3 * (faceIndsStart[iF + 1] - faceIndsStart[iF] - 2);
+      size_t from = 3 * (faceIndsStart[iF] - 2 * iF);
+      std::copy(perCorner.begin() + from, perCorner.begin() + from + nTriCorners,
+                moved.begin() + 3 * triangleStartOfFace[iF]);
     }
+  });
+  perCorner.swap(moved);
+}
+
+// The vertex order of indexed draws, and the draw list renumbered in to it
+void computeIndexedDrawOrder(const std::vector<uint32_t>& triVertexInds, size_t nVertices,
+                             std::vector<uint32_t>& vertexOrder, std::vector<uint32_t>& renumberedInds) {
+  vertexOrder = vertexOrderOfFirstUse(triVertexInds, nVertices);
+  std::vector<uint32_t> drawPosition(nVertices);
+  for (size_t i = 0; i < vertexOrder.size(); i++) drawPosition[vertexOrder[i]] = i;
+  renumberedInds.resize(triVertexInds.size());
+  for (size_t i = 0; i < triVertexInds.size(); i++) renumberedInds[i] = drawPosition[triVertexInds[i]];
+}
+
+} // namespace
+
+void SurfaceMesh::optimizeTriangulationDrawOrder(TriangulationData& triangulation) const {
+
+  size_t numFaces = faceIndsStart.size() - 1;
+  std::vector<uint32_t> triangleOrder = optimizeTriangleOrderForVertexCache(triangulation.vertexInds, vertexDataSize);
+
+  // Polygons keep their triangles together (so the per-face layout of the buffers still applies), placed where their
+  // first triangle falls in the optimized order. Fan triangles share a vertex, so this costs little.
+  std::vector<char> facePlaced(numFaces, false);
+  triangulation.triangleStartOfFace.resize(numFaces);
+  uint32_t nextTriangle = 0;
+  for (uint32_t iT : triangleOrder) {
+    uint32_t iF = triangulation.faceInds[3 * iT];
+    if (facePlaced[iF]) continue;
+    facePlaced[iF] = true;
+    triangulation.triangleStartOfFace[iF] = nextTriangle;
+    nextTriangle += faceIndsStart[iF + 1] - faceIndsStart[iF] - 2;
   }
 
-  vertexDataSize = nVertices();
-  faceDataSize = nFaces();
-  // edgeDataSize = ... we don't know this yet, gets set below
-  halfedgeDataSize = nHalfedges();
-  cornerDataSize = nCorners();
+  const std::vector<uint32_t>& starts = triangulation.triangleStartOfFace;
+  moveFaceTriangles(triangulation.vertexInds, faceIndsStart, starts);
+  moveFaceTriangles(triangulation.faceInds, faceIndsStart, starts);
+  moveFaceTriangles(triangulation.baryCoords, faceIndsStart, starts);
+  moveFaceTriangles(triangulation.edgeIsReal, faceIndsStart, starts);
+
+  computeIndexedDrawOrder(triangulation.vertexInds, vertexDataSize, triangulation.drawVertexOrder,
+                          triangulation.drawTriangleVertexInds);
+}
+
+void SurfaceMesh::ensureTriangulationComputed() {
+
+  // take the result from the worker if there is one (waiting for it if necessary), otherwise compute it here
+  TriangulationData result = triangulationTask.valid() ? triangulationTask.get() : computeTriangulation();
+
+  triangleVertexIndsData = std::move(result.vertexInds);
+  triangleFaceIndsData = std::move(result.faceInds);
+  baryCoordData = std::move(result.baryCoords);
+  edgeIsRealData = std::move(result.edgeIsReal);
+  triangleStartOfFace = std::move(result.triangleStartOfFace);
+  drawVertexOrderData = std::move(result.drawVertexOrder);
+  drawTriangleVertexIndsData = std::move(result.drawTriangleVertexInds);
 
   triangleVertexInds.markHostBufferUpdated();
   triangleFaceInds.markHostBufferUpdated();
   baryCoord.markHostBufferUpdated();
   edgeIsReal.markHostBufferUpdated();
+  if (optimizeDrawOrder) drawVertexOrder.markHostBufferUpdated();
+}
+
+void SurfaceMesh::ensureFaceTriangleStarts() {
+  if (optimizeDrawOrder) triangleVertexInds.ensureHostBufferPopulated();
+}
+
+size_t SurfaceMesh::faceTriangleStart(size_t iF) const {
+  if (geometrySource) return geometrySource->faceTriangleStart(iF); // (the triangulation is the source's)
+  return triangleStartOfFace.empty() ? faceIndsStart[iF] - 2 * iF : triangleStartOfFace[iF];
+}
+
+void SurfaceMesh::computeDrawVertexOrder() {
+
+  // this usually comes with the triangulation, unless the triangulation was set from elsewhere (a scene file)
+  triangleVertexInds.ensureHostBufferPopulated();
+  if (drawVertexOrder.hasData()) return;
+
+  computeIndexedDrawOrder(triangleVertexInds.data, nVertices(), drawVertexOrder.data, drawTriangleVertexIndsData);
+  drawVertexOrder.markHostBufferUpdated();
+}
+
+std::vector<uint32_t>& SurfaceMesh::getDrawTriangleVertexInds() {
+  if (geometrySource) return geometrySource->getDrawTriangleVertexInds();
+  if (!optimizeDrawOrder) return triangleVertexInds.getPopulatedHostBufferRef();
+  drawVertexOrder.ensureHostBufferPopulated();
+  return drawTriangleVertexIndsData;
+}
+
+bool SurfaceMesh::isLoading() {
+  if (geometrySource) return geometrySource->isLoading();
+  return triangulationTask.valid() &&
+         triangulationTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
 }
 
 // =================================================
@@ -184,29 +518,13 @@ void SurfaceMesh::computeConnectivityData() {
 
 void SurfaceMesh::computeTriangleAllEdgeInds() {
 
-  // WARNING: logic duplicated in countEdges()
-
   if (edgePerm.empty())
     exception("SurfaceMesh " + name +
               " performed an operation which requires edge indices to be specified, but none have been set. "
               "Call setEdgePermutation().");
 
-  triangleVertexInds.ensureHostBufferPopulated();
-  triangleAllEdgeInds.data.resize(3 * 3 * nFacesTriangulation());
-  halfedgeEdgeCorrespondence.resize(nHalfedges());
-
-  // used to loop over edges
-  std::unordered_map<std::pair<size_t, size_t>, size_t, polyscope::hash_combine::hash<std::pair<size_t, size_t>>>
-      seenEdgeInds;
-
-  auto createEdgeKey = [&](size_t a, size_t b) -> std::pair<size_t, size_t> {
-    return std::make_pair(std::min(a, b), std::max(a, b));
-  };
-
-  size_t psEdgeInd = 0; // polyscope's edge index, iterated according to Polyscope's canonical ordering
   for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
+    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
 
     // TODO why can't we use edges on non triangular meshes? Implement it.
 
@@ -215,186 +533,212 @@ void SurfaceMesh::computeTriangleAllEdgeInds() {
                 " attempted to access triangle-edge indices, but it has non-triangular faces. These indices are "
                 "only well-defined on a pure-triangular mesh.");
     }
+  }
 
-    glm::uvec3 thisTriInds{0, 0, 0};
-    for (size_t j = 0; j < 3; j++) {
-      size_t vA = triangleVertexInds.data[3 * iF + j];
-      size_t vB = triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
+  ensureFaceTriangleStarts();
+  triangleAllEdgeInds.data.resize(3 * 3 * nFacesTriangulation());
+  halfedgeEdgeCorrespondence.resize(nHalfedges());
 
-      std::pair<size_t, size_t> key = createEdgeKey(vA, vB);
+  // polyscope's edge indices, numbered according to Polyscope's canonical ordering (order of first appearance). The
+  // mesh is triangular, so the face list is the triangle list, in the order of the faces.
+  std::vector<uint32_t> sortedHalfedges, edgeStart, halfedgePsEdge;
+  groupHalfedgesByEdge(faceIndsEntries, sortedHalfedges, edgeStart);
+  size_t nPsEdges = numberEdgesByFirstAppearance(sortedHalfedges, edgeStart, halfedgePsEdge);
+  if (nPsEdges > edgePerm.size()) {
+    exception("SurfaceMesh " + name + " edge indexing out of bounds. Did you pass an edge ordering that is too short?");
+  }
 
-      size_t thisEdgeInd;
-      if (seenEdgeInds.find(key) == seenEdgeInds.end()) {
-        // process a new edge in the canonical ordering
-        if (psEdgeInd >= edgePerm.size()) {
-          exception("SurfaceMesh " + name +
-                    " edge indexing out of bounds. Did you pass an edge ordering that is too short?");
-        }
-        thisEdgeInd = edgePerm[psEdgeInd];
-        seenEdgeInds[key] = thisEdgeInd;
-        psEdgeInd++;
-      } else {
-        // we've processed this edge before, retrieve its assigned index
-        thisEdgeInd = seenEdgeInds[key];
-      }
+  // the mesh is triangular, so halfedges of the triangulation are the same as those of the mesh
+  for (size_t iF = 0; iF < nFaces(); iF++) {
+    size_t start = faceIndsStart[iF];
+    size_t iT = faceTriangleStart(iF);
 
+    glm::uvec3 thisTriInds{0, 0, 0};
+    for (size_t j = 0; j < 3; j++) {
+      size_t thisEdgeInd = edgePerm[halfedgePsEdge[3 * iF + j]];
       halfedgeEdgeCorrespondence[start + j] = thisEdgeInd;
       thisTriInds[j] = thisEdgeInd;
     }
 
     for (size_t j = 0; j < 3; j++) {
       for (size_t k = 0; k < 3; k++) {
-        triangleAllEdgeInds.data[9 * iF + 3 * j + k] = thisTriInds[k];
+        triangleAllEdgeInds.data[9 * iT + 3 * j + k] = thisTriInds[k];
       }
     }
   }
 
-  nEdgesCount = psEdgeInd;
+  nEdgesCount = nPsEdges;
   triangleAllEdgeInds.markHostBufferUpdated();
 }
 
 void SurfaceMesh::countEdges() {
 
-  // WARNING: logic duplicated in computeTriangleAllEdgeInds()
-
-  // used to loop over edges
-  std::unordered_map<std::pair<size_t, size_t>, size_t, polyscope::hash_combine::hash<std::pair<size_t, size_t>>>
-      seenEdgeInds;
-
-  auto createEdgeKey = [&](size_t a, size_t b) -> std::pair<size_t, size_t> {
-    return std::make_pair(std::min(a, b), std::max(a, b));
-  };
-
-  size_t psEdgeInd = 0; // polyscope's edge index, iterated according to Polyscope's canonical ordering
   for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
-
+    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
     if (D != 3) {
       exception("SurfaceMesh " + name +
                 " attempted to count edges, but mesh has non-triangular faces. Edge functions are only implemented on "
                 "a pure-triangular mesh.");
     }
-
-    for (size_t j = 0; j < 3; j++) {
-      size_t vA = triangleVertexInds.data[3 * iF + j];
-      size_t vB = triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
-
-      std::pair<size_t, size_t> key = createEdgeKey(vA, vB);
-
-      if (seenEdgeInds.find(key) == seenEdgeInds.end()) {
-        size_t thisEdgeInd = psEdgeInd;
-        seenEdgeInds[key] = thisEdgeInd;
-        psEdgeInd++;
-      }
-    }
   }
 
-  nEdgesCount = psEdgeInd;
+  triangleVertexInds.ensureHostBufferPopulated();
+
+  std::vector<uint32_t> sortedHalfedges, edgeStart;
+  groupHalfedgesByEdge(triangleVertexInds.data, sortedHalfedges, edgeStart);
+  nEdgesCount = edgeStart.size() - 1;
 }
 
 size_t SurfaceMesh::nEdges() {
+  if (geometrySource) return geometrySource->nEdges();
   if (nEdgesCount == INVALID_IND) countEdges();
   return nEdgesCount;
 }
 
 void SurfaceMesh::computeTriangleCornerInds() {
 
-  triangleCornerInds.data.clear();
-  triangleCornerInds.data.reserve(3 * nFacesTriangulation());
+  ensureFaceTriangleStarts();
+  triangleCornerInds.data.resize(3 * nFacesTriangulation());
+  std::vector<uint32_t>& cornerInds = triangleCornerInds.data;
+
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t iStart = faceIndsStart[iF];
+      size_t D = faceIndsStart[iF + 1] - iStart;
+      size_t iT = faceTriangleStart(iF);
+
+      // emit the data for triangles triangulating this face
+      for (size_t j = 1; (j + 1) < D; j++) {
+        cornerInds[3 * iT + 0] = iStart;
+        cornerInds[3 * iT + 1] = iStart + j;
+        cornerInds[3 * iT + 2] = iStart + j + 1;
+        iT++;
+      }
+    }
+  });
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t iStart = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - iStart;
+  triangleCornerInds.markHostBufferUpdated();
+}
+
+void SurfaceMesh::computeTriangleFaces() {
 
-    // emit the data for triangles triangulating this face
-    for (size_t j = 1; (j + 1) < D; j++) {
-      uint32_t c0 = iStart;
-      uint32_t c1 = iStart + j;
-      uint32_t c2 = iStart + j + 1;
+  ensureFaceTriangleStarts();
+  triangleFaces.data.resize(nFacesTriangulation());
+  std::vector<uint32_t>& faces = triangleFaces.data;
 
-      triangleCornerInds.data.push_back(c0);
-      triangleCornerInds.data.push_back(c1);
-      triangleCornerInds.data.push_back(c2);
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
+      std::fill(faces.begin() + faceTriangleStart(iF), faces.begin() + faceTriangleStart(iF) + (D - 2), iF);
     }
-  }
+  });
 
-  triangleCornerInds.markHostBufferUpdated();
+  triangleFaces.markHostBufferUpdated();
 }
 
 void SurfaceMesh::computeTriangleAllHalfedgeInds() {
 
-  triangleAllHalfedgeInds.data.clear();
-  triangleAllHalfedgeInds.data.reserve(3 * 3 * nFacesTriangulation());
+  ensureFaceTriangleStarts();
+  triangleAllHalfedgeInds.data.resize(3 * 3 * nFacesTriangulation());
+  std::vector<uint32_t>& halfedgeInds = triangleAllHalfedgeInds.data;
 
   bool haveCustomIndex = !halfedgePerm.empty();
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t iStart = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - iStart;
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t iStart = faceIndsStart[iF];
+      size_t D = faceIndsStart[iF + 1] - iStart;
+      size_t iT = faceTriangleStart(iF);
 
-    // emit the data for triangles triangulating this face
-    for (size_t j = 1; (j + 1) < D; j++) {
+      // emit the data for triangles triangulating this face
+      for (size_t j = 1; (j + 1) < D; j++) {
 
-      // FORNOW: for polygonal faces, substitute the opposite-edge value for all internal edges of the triangulation
+        // FORNOW: for polygonal faces, substitute the opposite-edge value for all internal edges of the triangulation
 
-      uint32_t he0 = iStart + j; // this is a dummy value due to triangulation of polygons
-      uint32_t he1 = iStart + j; // this is the actual right value for the opposite edge
-      uint32_t he2 = iStart + j; // this is a dummy value due to triangulation of polygons
+        uint32_t he0 = iStart + j; // this is a dummy value due to triangulation of polygons
+        uint32_t he1 = iStart + j; // this is the actual right value for the opposite edge
+        uint32_t he2 = iStart + j; // this is a dummy value due to triangulation of polygons
 
-      // substitute non-dummy values for first and last edge if this is not an internal tri
-      if (j == 1) he0 = iStart;
-      if (j + 2 == D) he2 = iStart + D - 1;
+        // substitute non-dummy values for first and last edge if this is not an internal tri
+        if (j == 1) he0 = iStart;
+        if (j + 2 == D) he2 = iStart + D - 1;
 
-      if (haveCustomIndex) {
-        he0 = halfedgePerm[he0];
-        he1 = halfedgePerm[he1];
-        he2 = halfedgePerm[he2];
-      }
+        if (haveCustomIndex) {
+          he0 = halfedgePerm[he0];
+          he1 = halfedgePerm[he1];
+          he2 = halfedgePerm[he2];
+        }
 
-      for (size_t k = 0; k < 3; k++) {
-        triangleAllHalfedgeInds.data.push_back(he0);
-        triangleAllHalfedgeInds.data.push_back(he1);
-        triangleAllHalfedgeInds.data.push_back(he2);
+        for (size_t k = 0; k < 3; k++) {
+          halfedgeInds[9 * iT + 3 * k + 0] = he0;
+          halfedgeInds[9 * iT + 3 * k + 1] = he1;
+          halfedgeInds[9 * iT + 3 * k + 2] = he2;
+        }
+        iT++;
       }
     }
-  }
+  });
 
   triangleAllHalfedgeInds.markHostBufferUpdated();
 }
 
 void SurfaceMesh::computeTriangleAllCornerInds() {
 
-  triangleAllCornerInds.data.clear();
-  triangleAllCornerInds.data.reserve(3 * nFacesTriangulation());
+  ensureFaceTriangleStarts();
+  triangleAllCornerInds.data.resize(3 * 3 * nFacesTriangulation());
+  std::vector<uint32_t>& cornerInds = triangleAllCornerInds.data;
 
   bool haveCustomIndex = !cornerPerm.empty();
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t iStart = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - iStart;
-
-    // emit the data for triangles triangulating this face
-    for (size_t j = 1; (j + 1) < D; j++) {
-      uint32_t c0 = iStart;
-      uint32_t c1 = iStart + j;
-      uint32_t c2 = iStart + j + 1;
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t iStart = faceIndsStart[iF];
+      size_t D = faceIndsStart[iF + 1] - iStart;
+      size_t iT = faceTriangleStart(iF);
+
+      // emit the data for triangles triangulating this face
+      for (size_t j = 1; (j + 1) < D; j++) {
+        uint32_t c0 = iStart;
+        uint32_t c1 = iStart + j;
+        uint32_t c2 = iStart + j + 1;
+
+        if (haveCustomIndex) {
+          c0 = cornerPerm[c0];
+          c1 = cornerPerm[c1];
+          c2 = cornerPerm[c2];
+        }
 
-      if (haveCustomIndex) {
-        c0 = cornerPerm[c0];
-        c1 = cornerPerm[c1];
-        c2 = cornerPerm[c2];
+        for (size_t k = 0; k < 3; k++) {
+          cornerInds[9 * iT + 3 * k + 0] = c0;
+          cornerInds[9 * iT + 3 * k + 1] = c1;
+          cornerInds[9 * iT + 3 * k + 2] = c2;
+        }
+        iT++;
       }
+    }
+  });
 
+  triangleAllCornerInds.markHostBufferUpdated();
+}
+
+void SurfaceMesh::computeTriangleAllVertexInds() {
+
+  triangleVertexInds.ensureHostBufferPopulated();
+  const std::vector<uint32_t>& vertInds = triangleVertexInds.data;
+  triangleAllVertexInds.data.resize(3 * vertInds.size());
+
+  std::vector<uint32_t>& allVertInds = triangleAllVertexInds.data;
+  parallelFor(0, nFacesTriangulation(), [&](size_t tStart, size_t tEnd) {
+    for (size_t iT = tStart; iT < tEnd; iT++) {
       for (size_t k = 0; k < 3; k++) {
-        triangleAllCornerInds.data.push_back(c0);
-        triangleAllCornerInds.data.push_back(c1);
-        triangleAllCornerInds.data.push_back(c2);
+        for (size_t j = 0; j < 3; j++) {
+          allVertInds[9 * iT + 3 * k + j] = vertInds[3 * iT + j];
+        }
       }
     }
-  }
+  });
 
-  triangleAllCornerInds.markHostBufferUpdated();
+  triangleAllVertexInds.markHostBufferUpdated();
 }
 
 
@@ -406,34 +750,39 @@ void SurfaceMesh::computeTriangleAllCornerInds() {
 size_t SurfaceMesh::nVertices() { return vertexPositions.size(); }
 
 void SurfaceMesh::computeFaceNormals() {
-
   vertexPositions.ensureHostBufferPopulated();
+  computeFaceNormalsOf(vertexPositions.data, faceNormals.data);
+  faceNormals.markHostBufferUpdated();
+}
 
-  faceNormals.data.resize(nFaces());
+void SurfaceMesh::computeFaceNormalsOf(const std::vector<glm::vec3>& pos, std::vector<glm::vec3>& normals) {
+  normals.resize(nFaces());
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      normals[iF] = faceNormalOf(pos, iF);
+    }
+  });
+}
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t iStart = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - iStart;
+glm::vec3 SurfaceMesh::faceNormalOf(const std::vector<glm::vec3>& pos, size_t iF) {
+  size_t iStart = faceIndsStart[iF];
+  size_t D = faceIndsStart[iF + 1] - iStart;
 
-    glm::vec3 fN{0., 0., 0.};
-    if (D == 3) {
-      glm::vec3 pA = vertexPositions.data[faceIndsEntries[iStart + 0]];
-      glm::vec3 pB = vertexPositions.data[faceIndsEntries[iStart + 1]];
-      glm::vec3 pC = vertexPositions.data[faceIndsEntries[iStart + 2]];
-      fN = glm::cross(pB - pA, pC - pA);
-    } else {
-      for (size_t j = 0; j < D; j++) {
-        glm::vec3 pA = vertexPositions.data[faceIndsEntries[iStart + j]];
-        glm::vec3 pB = vertexPositions.data[faceIndsEntries[iStart + (j + 1) % D]];
-        glm::vec3 pC = vertexPositions.data[faceIndsEntries[iStart + (j + 2) % D]];
-        fN += glm::cross(pC - pB, pA - pB);
-      }
+  glm::vec3 fN{0., 0., 0.};
+  if (D == 3) {
+    glm::vec3 pA = pos[faceIndsEntries[iStart + 0]];
+    glm::vec3 pB = pos[faceIndsEntries[iStart + 1]];
+    glm::vec3 pC = pos[faceIndsEntries[iStart + 2]];
+    fN = glm::cross(pB - pA, pC - pA);
+  } else {
+    for (size_t j = 0; j < D; j++) {
+      glm::vec3 pA = pos[faceIndsEntries[iStart + j]];
+      glm::vec3 pB = pos[faceIndsEntries[iStart + (j + 1) % D]];
+      glm::vec3 pC = pos[faceIndsEntries[iStart + (j + 2) % D]];
+      fN += glm::cross(pC - pB, pA - pB);
     }
-    fN = glm::normalize(fN);
-    faceNormals.data[iF] = fN;
   }
-
-  faceNormals.markHostBufferUpdated();
+  return glm::normalize(fN);
 }
 
 void SurfaceMesh::computeFaceCenters() {
@@ -442,104 +791,206 @@ void SurfaceMesh::computeFaceCenters() {
 
   faceCenters.data.resize(nFaces());
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
-    glm::vec3 faceCenter{0., 0., 0.};
-    for (size_t j = 0; j < D; j++) {
-      glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + j]];
-      faceCenter += pA;
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  std::vector<glm::vec3>& centers = faceCenters.data;
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      centers[iF] = faceCenterOf(pos, iF);
     }
-    faceCenter /= D;
-    faceCenters.data[iF] = faceCenter;
-  }
+  });
 
   faceCenters.markHostBufferUpdated();
 }
 
-void SurfaceMesh::computeFaceAreas() {
+glm::vec3 SurfaceMesh::faceCenterOf(const std::vector<glm::vec3>& pos, size_t iF) {
+  size_t start = faceIndsStart[iF];
+  size_t D = faceIndsStart[iF + 1] - start;
+  glm::vec3 faceCenter{0., 0., 0.};
+  for (size_t j = 0; j < D; j++) {
+    glm::vec3 pA = pos[faceIndsEntries[start + j]];
+    faceCenter += pA;
+  }
+  faceCenter /= D;
+  return faceCenter;
+}
 
+void SurfaceMesh::computeFaceAreas() {
   vertexPositions.ensureHostBufferPopulated();
+  computeFaceAreasOf(vertexPositions.data, faceAreas.data);
+  faceAreas.markHostBufferUpdated();
+}
 
-  faceAreas.data.resize(nFaces());
+void SurfaceMesh::computeFaceAreasOf(const std::vector<glm::vec3>& pos, std::vector<double>& areas) {
+  areas.resize(nFaces());
 
   // Loop over faces to compute face-valued quantities
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
-
-    // Compute a face normal
-    double fA;
-    if (D == 3) {
-      glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + 0]];
-      glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + 1]];
-      glm::vec3 pC = vertexPositions.data[faceIndsEntries[start + 2]];
-      glm::vec3 fN = glm::cross(pB - pA, pC - pA);
-      fA = 0.5 * glm::length(fN);
-    } else {
-      fA = 0;
-      glm::vec3 pRoot = vertexPositions.data[faceIndsEntries[start]];
-      for (size_t j = 1; j + 1 < D; j++) {
-        glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + j]];
-        glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + j + 1]];
-        fA += 0.5 * glm::length(glm::cross(pA - pRoot, pB - pRoot));
-      }
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      areas[iF] = faceAreaOf(pos, iF);
     }
+  });
+}
 
-    faceAreas.data[iF] = fA;
-  }
+double SurfaceMesh::faceAreaOf(const std::vector<glm::vec3>& pos, size_t iF) {
+  size_t start = faceIndsStart[iF];
+  size_t D = faceIndsStart[iF + 1] - start;
 
-  faceAreas.markHostBufferUpdated();
+  // Compute a face normal
+  double fA;
+  if (D == 3) {
+    glm::vec3 pA = pos[faceIndsEntries[start + 0]];
+    glm::vec3 pB = pos[faceIndsEntries[start + 1]];
+    glm::vec3 pC = pos[faceIndsEntries[start + 2]];
+    glm::vec3 fN = glm::cross(pB - pA, pC - pA);
+    fA = 0.5 * glm::length(fN);
+  } else {
+    fA = 0;
+    glm::vec3 pRoot = pos[faceIndsEntries[start]];
+    for (size_t j = 1; j + 1 < D; j++) {
+      glm::vec3 pA = pos[faceIndsEntries[start + j]];
+      glm::vec3 pB = pos[faceIndsEntries[start + j + 1]];
+      fA += 0.5 * glm::length(glm::cross(pA - pRoot, pB - pRoot));
+    }
+  }
+  return fA;
 }
 
+void SurfaceMesh::ensureHaveVertexFaceAdjacency() {
+  if (!vertexFaceAdjStart.empty()) return; // already populated
 
-void SurfaceMesh::computeVertexNormals() {
+  // Bucket the face corners by vertex. Faces are visited in order, so each vertex's list is sorted by face.
+  vertexFaceAdjStart.assign(nVertices() + 1, 0);
+  for (uint32_t iV : faceIndsEntries) {
+    vertexFaceAdjStart[iV + 1]++;
+  }
+  for (size_t iV = 0; iV < nVertices(); iV++) {
+    vertexFaceAdjStart[iV + 1] += vertexFaceAdjStart[iV];
+  }
+
+  vertexFaceAdjEntries.resize(faceIndsEntries.size());
+  std::vector<uint32_t> fillPos(vertexFaceAdjStart.begin(), vertexFaceAdjStart.end() - 1);
+  for (size_t iF = 0; iF < nFaces(); iF++) {
+    for (size_t i = faceIndsStart[iF]; i < faceIndsStart[iF + 1]; i++) {
+      vertexFaceAdjEntries[fillPos[faceIndsEntries[i]]++] = static_cast<uint32_t>(iF);
+    }
+  }
+}
 
+void SurfaceMesh::computeVertexNormals() {
   faceNormals.ensureHostBufferPopulated();
   faceAreas.ensureHostBufferPopulated();
+  computeVertexNormalsOf(faceNormals.data, faceAreas.data, vertexNormals.data);
+  vertexNormals.markHostBufferUpdated();
+}
 
-  vertexNormals.data.resize(nVertices());
-
-  const glm::vec3 zero{0., 0., 0.};
-
-  std::fill(vertexNormals.data.begin(), vertexNormals.data.end(), zero);
-
-  // Accumulate quantities from each face
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t start = faceIndsStart[iF];
-    size_t D = faceIndsStart[iF + 1] - start;
-    for (size_t j = 0; j < D; j++) {
-      size_t iV = faceIndsEntries[start + j];
-      vertexNormals.data[iV] += faceNormals.data[iF] * static_cast<float>(faceAreas.data[iF]);
+void SurfaceMesh::computeVertexNormalsOf(const std::vector<glm::vec3>& fNormals, const std::vector<double>& fAreas,
+                                         std::vector<glm::vec3>& vNormals) {
+  ensureHaveVertexFaceAdjacency();
+  vNormals.resize(nVertices());
+  parallelFor(0, nVertices(), [&](size_t vStart, size_t vEnd) {
+    for (size_t iV = vStart; iV < vEnd; iV++) {
+      vNormals[iV] = vertexNormalOf(fNormals, fAreas, iV);
     }
-  }
+  });
+}
 
-  // Normalize
-  for (size_t iV = 0; iV < nVertices(); iV++) {
-    vertexNormals.data[iV] = glm::normalize(vertexNormals.data[iV]);
+glm::vec3 SurfaceMesh::vertexNormalOf(const std::vector<glm::vec3>& fNormals, const std::vector<double>& fAreas,
+                                      size_t iV) {
+  // Gather quantities from the incident faces of the vertex (in face order, so the sum matches a serial
+  // accumulation over faces), then normalize
+  glm::vec3 N{0., 0., 0.};
+  for (size_t i = vertexFaceAdjStart[iV]; i < vertexFaceAdjStart[iV + 1]; i++) {
+    size_t iF = vertexFaceAdjEntries[i];
+    N += fNormals[iF] * static_cast<float>(fAreas[iF]);
   }
-
-  vertexNormals.markHostBufferUpdated();
+  return glm::normalize(N);
 }
 
 void SurfaceMesh::computeVertexAreas() {
 
   faceAreas.ensureHostBufferPopulated();
+  ensureHaveVertexFaceAdjacency();
 
   vertexAreas.data.resize(nVertices());
-  std::fill(vertexAreas.data.begin(), vertexAreas.data.end(), 0.);
 
-  // Accumulate quantities from each face
-  for (size_t iF = 0; iF < nFaces(); iF++) {
+  const std::vector<double>& fAreas = faceAreas.data;
+  std::vector<double>& vAreas = vertexAreas.data;
+  parallelFor(0, nVertices(), [&](size_t vStart, size_t vEnd) {
+    for (size_t iV = vStart; iV < vEnd; iV++) {
+      vAreas[iV] = vertexAreaOf(fAreas, iV);
+    }
+  });
+
+  vertexAreas.markHostBufferUpdated();
+}
+
+double SurfaceMesh::vertexAreaOf(const std::vector<double>& fAreas, size_t iV) {
+  // Gather quantities from the incident faces of the vertex
+  double A = 0.;
+  for (size_t i = vertexFaceAdjStart[iV]; i < vertexFaceAdjStart[iV + 1]; i++) {
+    size_t iF = vertexFaceAdjEntries[i];
     size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
-    size_t start = faceIndsStart[iF];
-    for (size_t j = 0; j < D; j++) {
-      size_t iV = faceIndsEntries[start + j];
-      vertexAreas.data[iV] += faceAreas.data[iF] / D;
+    A += fAreas[iF] / D;
+  }
+  return A;
+}
+
+void SurfaceMesh::computeCompressedVertexAttributes() {
+
+  vertexPositions.ensureHostBufferPopulated();
+  vertexNormals.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  const std::vector<glm::vec3>& normals = vertexNormals.data;
+
+  // The box to quantize over
+  glm::vec3 bMin{std::numeric_limits<float>::infinity()};
+  glm::vec3 bMax{-std::numeric_limits<float>::infinity()};
+  for (const glm::vec3& p : pos) {
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) continue;
+    bMin = glm::min(bMin, p);
+    bMax = glm::max(bMax, p);
+  }
+  if (!(bMin.x <= bMax.x)) {
+    bMin = glm::vec3{0., 0., 0.};
+    bMax = glm::vec3{0., 0., 0.};
+  }
+  compressedPositionMin = bMin;
+  compressedPositionScale = (bMax - bMin) / 65535.f;
+
+  compressedVertexAttributes.data.resize(nVertices());
+  std::vector<glm::uvec3>& packed = compressedVertexAttributes.data;
+  parallelFor(0, nVertices(), [&](size_t vStart, size_t vEnd) {
+    for (size_t iV = vStart; iV < vEnd; iV++) {
+      packed[iV] = compressVertexAttributes(pos[iV], normals[iV]);
     }
+  });
+
+  compressedVertexAttributes.markHostBufferUpdated();
+}
+
+glm::vec3 SurfaceMesh::compressedPositionCoord(glm::vec3 p) {
+  return (p - compressedPositionMin) /
+         glm::max(compressedPositionScale * 65535.f, glm::vec3{std::numeric_limits<float>::min()});
+}
+
+glm::uvec3 SurfaceMesh::compressVertexAttributes(glm::vec3 p, glm::vec3 n) {
+  auto quantize = [](float t) {
+    return static_cast<uint32_t>(glm::clamp(std::round(t * 65535.f), 0.f, 65535.f));
+  };
+
+  glm::vec3 t = compressedPositionCoord(p);
+
+  // octahedral encoding: project on to the octahedron, and fold the lower half over the upper
+  float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+  glm::vec2 oct = (l1 > 0.) ? glm::vec2(n.x, n.y) / l1 : glm::vec2(0., 0.);
+  if (n.z < 0.) {
+    glm::vec2 signs{oct.x >= 0. ? 1. : -1., oct.y >= 0. ? 1. : -1.};
+    oct = (glm::vec2(1., 1.) - glm::abs(glm::vec2(oct.y, oct.x))) * signs;
   }
+  oct = 0.5f * oct + glm::vec2(0.5, 0.5);
 
-  vertexAreas.markHostBufferUpdated();
+  return glm::uvec3{quantize(t.x) | (quantize(t.y) << 16), quantize(t.z) | (quantize(oct.x) << 16),
+                    quantize(oct.y)};
 }
 
 void SurfaceMesh::computeDefaultFaceTangentBasisX() {
@@ -547,28 +998,31 @@ void SurfaceMesh::computeDefaultFaceTangentBasisX() {
   // NOTE: this function is weirdly duplicated into an 'X' and 'Y' paradigm to fit the compute-function-per-buffer
   // paradigm
 
+  if (nFacesTriangulation() != nFaces()) { // (checked up front, errors can't be reported from the parallel loop)
+    exception("Default face tangent spaces only available for pure-triangular meshes");
+  }
   vertexPositions.ensureHostBufferPopulated();
   faceNormals.ensureHostBufferPopulated();
 
   defaultFaceTangentBasisX.data.resize(nFaces());
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
-    if (D != 3) exception("Default face tangent spaces only available for pure-triangular meshes");
-
-    size_t start = faceIndsStart[iF];
-
-    glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + 0]];
-    glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + 1]];
-    glm::vec3 N = faceNormals.data[iF];
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  const std::vector<glm::vec3>& normals = faceNormals.data;
+  std::vector<glm::vec3>& basisXOut = defaultFaceTangentBasisX.data;
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t start = faceIndsStart[iF];
 
-    glm::vec3 basisX = pB - pA;
-    basisX = glm::normalize(basisX - N * glm::dot(N, basisX));
+      glm::vec3 pA = pos[faceIndsEntries[start + 0]];
+      glm::vec3 pB = pos[faceIndsEntries[start + 1]];
+      glm::vec3 N = normals[iF];
 
-    glm::vec3 basisY = glm::normalize(-glm::cross(basisX, N));
+      glm::vec3 basisX = pB - pA;
+      basisX = glm::normalize(basisX - N * glm::dot(N, basisX));
 
-    defaultFaceTangentBasisX.data[iF] = basisX;
-  }
+      basisXOut[iF] = basisX;
+    }
+  });
 
   defaultFaceTangentBasisX.markHostBufferUpdated();
 }
@@ -578,28 +1032,33 @@ void SurfaceMesh::computeDefaultFaceTangentBasisY() {
   // NOTE: this function is weirdly duplicated into an 'X' and 'Y' paradigm to fit the compute-function-per-buffer
   // paradigm
 
+  if (nFacesTriangulation() != nFaces()) { // (checked up front, errors can't be reported from the parallel loop)
+    exception("Default face tangent spaces only available for pure-triangular meshes");
+  }
   vertexPositions.ensureHostBufferPopulated();
   faceNormals.ensureHostBufferPopulated();
 
   defaultFaceTangentBasisY.data.resize(nFaces());
 
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
-    if (D != 3) exception("Default face tangent spaces only available for pure-triangular meshes");
-
-    size_t start = faceIndsStart[iF];
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  const std::vector<glm::vec3>& normals = faceNormals.data;
+  std::vector<glm::vec3>& basisYOut = defaultFaceTangentBasisY.data;
+  parallelFor(0, nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      size_t start = faceIndsStart[iF];
 
-    glm::vec3 pA = vertexPositions.data[faceIndsEntries[start + 0]];
-    glm::vec3 pB = vertexPositions.data[faceIndsEntries[start + 1]];
-    glm::vec3 N = faceNormals.data[iF];
+      glm::vec3 pA = pos[faceIndsEntries[start + 0]];
+      glm::vec3 pB = pos[faceIndsEntries[start + 1]];
+      glm::vec3 N = normals[iF];
 
-    glm::vec3 basisX = pB - pA;
-    basisX = glm::normalize(basisX - N * glm::dot(N, basisX));
+      glm::vec3 basisX = pB - pA;
+      basisX = glm::normalize(basisX - N * glm::dot(N, basisX));
 
-    glm::vec3 basisY = glm::normalize(-glm::cross(basisX, N));
+      glm::vec3 basisY = glm::normalize(-glm::cross(basisX, N));
 
-    defaultFaceTangentBasisY.data[iF] = basisY;
-  }
+      basisYOut[iF] = basisY;
+    }
+  });
 
   defaultFaceTangentBasisY.markHostBufferUpdated();
 }
@@ -628,6 +1087,18 @@ void SurfaceMesh::computeDefaultFaceTangentBasisY() {
 //   edgeLengths.markHostBufferUpdated();
 // }
 
+std::vector<uint32_t> SurfaceMesh::narrowPermutation(const std::vector<size_t>& perm, std::string what) {
+  std::vector<uint32_t> result(perm.size());
+  for (size_t i = 0; i < perm.size(); i++) {
+    if (perm[i] >= INVALID_IND_32) {
+      exception("SurfaceMesh " + name + " " + what + " entry " + std::to_string(perm[i]) +
+                " is too large, indices must fit in 32 bits");
+    }
+    result[i] = static_cast<uint32_t>(perm[i]);
+  }
+  return result;
+}
+
 void SurfaceMesh::checkTriangular() {
   if (nFacesTriangulation() != nFaces()) {
     exception("Cannot proceed, SurfaceMesh " + name + " is not a triangular mesh.");
@@ -637,56 +1108,22 @@ void SurfaceMesh::checkTriangular() {
 void SurfaceMesh::ensureHaveManifoldConnectivity() {
   if (!twinHalfedge.empty()) return; // already populated
 
-  triangleVertexInds.ensureHostBufferPopulated();
-
   twinHalfedge.resize(nHalfedges());
 
-  // Maps from edge (sorted) to all halfedges incident on that edge
-  std::unordered_map<std::pair<size_t, size_t>, std::vector<size_t>,
-                     polyscope::hash_combine::hash<std::pair<size_t, size_t>>>
-      edgeInds;
-
-  // Fill out faceForHalfedge and populate edge lookup map
-  for (size_t iF = 0; iF < nFacesTriangulation(); iF++) {
-    for (size_t j = 0; j < 3; j++) {
-      size_t iV = triangleVertexInds.data[3 * iF + j];
-      size_t iVNext = triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
-      size_t iHe = 3 * iF + j;
-
-
-      std::pair<size_t, size_t> edgeKey(std::min(iV, iVNext), std::max(iV, iVNext));
-
-      // Make sure the key is populated
-      auto it = edgeInds.find(edgeKey);
-      if (it == edgeInds.end()) {
-        it = edgeInds.insert(it, {edgeKey, std::vector<size_t>()});
-      }
-
-      // Add this halfedge to the entry
-      it->second.push_back(iHe);
-    }
-  }
-
-  // Second walk through, setting twins
-  for (size_t iF = 0; iF < nFacesTriangulation(); iF++) {
-    for (size_t j = 0; j < 3; j++) {
-      size_t iV = triangleVertexInds.data[3 * iF + j];
-      size_t iVNext = triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
-      size_t iHe = 3 * iF + j;
-
-      std::pair<size_t, size_t> edgeKey(std::min(iV, iVNext), std::max(iV, iVNext));
-      std::vector<size_t>& edgeHalfedges = edgeInds.find(edgeKey)->second;
-
-      // Pick the first halfedge we find which is not this one
-      size_t myTwin = INVALID_IND;
-      for (size_t t : edgeHalfedges) {
-        if (t != iHe) {
-          myTwin = t;
-          break;
-        }
+  // (on a triangle mesh, the face list is the triangle list with halfedges in order)
+  std::vector<uint32_t> sortedHalfedges, edgeStart;
+  groupHalfedgesByEdge(faceIndsEntries, sortedHalfedges, edgeStart);
+
+  // The twin of each halfedge is the first other halfedge along the same edge
+  for (size_t iE = 0; iE + 1 < edgeStart.size(); iE++) {
+    uint32_t first = sortedHalfedges[edgeStart[iE]];
+    for (size_t i = edgeStart[iE]; i < edgeStart[iE + 1]; i++) {
+      uint32_t iHe = sortedHalfedges[i];
+      if (iHe != first) {
+        twinHalfedge[iHe] = first;
+      } else {
+        twinHalfedge[iHe] = (edgeStart[iE + 1] - edgeStart[iE] > 1) ? sortedHalfedges[i + 1] : INVALID_IND_32;
       }
-
-      twinHalfedge[iHe] = myTwin;
     }
   }
 }
@@ -698,6 +1135,10 @@ void SurfaceMesh::draw() {
 
   render::engine->setBackfaceCull(backFacePolicy.get() == BackFacePolicy::Cull);
 
+  if (usesDrawClusters()) {
+    updateVisibleDrawRanges();
+  }
+
   // If no quantity is drawing the surface, we should draw it
   if (dominantQuantity == nullptr) {
 
@@ -736,6 +1177,10 @@ void SurfaceMesh::drawDelayed() {
 
   render::engine->setBackfaceCull(backFacePolicy.get() == BackFacePolicy::Cull);
 
+  if (usesDrawClusters()) {
+    updateVisibleDrawRanges();
+  }
+
   for (auto& x : quantities) {
     x.second->drawDelayed();
   }
@@ -760,6 +1205,11 @@ void SurfaceMesh::drawPick() {
 
   // Set uniforms
   setStructureUniforms(*pickProgram);
+  if (usesDrawClusters()) {
+    updateVisibleDrawRanges();
+  }
+  applyDrawRanges(*pickProgram);
+  setThresholdUniforms(*pickProgram);
 
   pickProgram->draw();
 
@@ -767,12 +1217,12 @@ void SurfaceMesh::drawPick() {
 }
 
 void SurfaceMesh::prepare() {
-  // clang-format off
-  program = render::engine->requestShader(
-      "MESH", 
-      addSurfaceMeshRules({"SHADE_BASECOLOR"})
-  );
-  // clang-format on
+  std::vector<std::string> rules = addSurfaceMeshRules({"SHADE_BASECOLOR"});
+  if (nInstances() > 0 && !instanceColorsData.empty()) {
+    rules.push_back("MESH_INSTANCE_COLOR");
+  }
+  program = render::engine->requestShader(getMeshProgramName(true), rules);
+  program->setMemoryOwner(uniquePrefix() + "program");
 
   // Populate draw buffers
   setMeshGeometryAttributes(*program);
@@ -781,24 +1231,96 @@ void SurfaceMesh::prepare() {
 
 void SurfaceMesh::preparePick() {
 
-
-  bool simplePick = !(edgesHaveBeenUsed || halfedgesHaveBeenUsed || cornersHaveBeenUsed);
-
-  if (simplePick) {
-    pickProgram =
-        render::engine->requestShader("MESH", addSurfaceMeshRules({"MESH_PROPAGATE_PICK_SIMPLE"}, true, false),
-                                      render::ShaderReplacementDefaults::Pick);
-  } else {
-    pickProgram = render::engine->requestShader("MESH", addSurfaceMeshRules({"MESH_PROPAGATE_PICK"}, true, false),
-                                                render::ShaderReplacementDefaults::Pick);
+  std::vector<std::string> rules = addSurfaceMeshRules({"MESH_PICK_FROM_INDICES"}, true, false);
+  if (cornersHaveBeenUsed) {
+    rules.push_back("MESH_PICK_CORNERS_FROM_INDICES");
+  }
+  if (edgesHaveBeenUsed || halfedgesHaveBeenUsed) {
+    rules.push_back("MESH_PICK_HALFEDGES_FROM_INDICES");
   }
+  if (nInstances() > 0) {
+    rules.push_back("MESH_INSTANCED_PICK");
+  }
+  pickProgram = render::engine->requestShader("MESH", removeSubsetHighlightRules(rules),
+                                              render::ShaderReplacementDefaults::Pick);
+  pickProgram->setMemoryOwner(uniquePrefix() + "pick");
 
   // Populate draw buffers
   setMeshGeometryAttributes(*pickProgram);
   setMeshPickAttributes(*pickProgram);
 }
 
+size_t SurfaceMesh::nSubsetElements() { return nFaces(); }
+
+bool SurfaceMesh::canDrawIndexed() {
+  if (getEdgeWidth() > 0) return false;
+  if (shadeStyle.get() == MeshShadeStyle::Flat && nFacesTriangulation() != nFaces()) return false;
+  if (wantsCullPosition()) return false;
+  if (thresholdQuantityName != "") return false;
+  if (hasSubsetMasks()) return false;
+  return true;
+}
+
+std::string SurfaceMesh::getMeshProgramName(bool perVertexData) {
+  if (!perVertexData || !canDrawIndexed()) return "MESH";
+  return compressedVertexAttributesEnabled ? "INDEXED_MESH_COMPRESSED" : "INDEXED_MESH";
+}
+
+bool SurfaceMesh::canFetchFaceData() {
+  if (usesDrawClusters() && nInstances() == 0) return false;
+  if (std::max(nFaces(), nFacesTriangulation()) >= (static_cast<size_t>(1) << 24)) return false;
+  return true;
+}
+
+std::vector<std::string> SurfaceMesh::addFaceFetchRules(std::vector<std::string> initRules) {
+  if (nFacesTriangulation() == nFaces() && !optimizeDrawOrder) {
+    initRules.push_back("MESH_FACE_INDEX_FROM_PRIMITIVE_ID");
+  } else {
+    initRules.push_back("MESH_FACE_INDEX_FROM_TRIANGLE_MAP");
+  }
+  return initRules;
+}
+
+void SurfaceMesh::setFaceFetchTextures(render::ShaderProgram& p) {
+  if (p.hasTexture("t_triangleFaces")) {
+    p.setTextureFromBuffer("t_triangleFaces", triangleFaces.getTextureViewBuffer().get());
+  }
+}
+
 void SurfaceMesh::setMeshGeometryAttributes(render::ShaderProgram& p) {
+  if (p.usesIndexedDrawing()) {
+    // Only per-vertex data is used (see canDrawIndexed()), so the shared vertex buffers are drawn directly (or their
+    // copies in the optimized draw order). The barycentric coordinates (and normals, when computed from positions) are
+    // unused, but the shader is set up in a lazy way so they are still needed; the position buffer stands in for them
+    // without allocating anything.
+    if (p.hasAttribute("a_vertexCompressed")) {
+      p.setAttribute("a_vertexCompressed", getVertexAttributeBuffer(p, compressedVertexAttributes));
+    } else {
+      std::shared_ptr<render::AttributeBuffer> positionsBuffer = getVertexAttributeBuffer(p, vertexPositions);
+      p.setAttribute("a_vertexPositions", positionsBuffer);
+      if (p.hasAttribute("a_vertexNormals")) {
+        if (getShadeStyle() == MeshShadeStyle::Smooth) {
+          p.setAttribute("a_vertexNormals", getVertexAttributeBuffer(p, vertexNormals));
+        } else {
+          p.setAttribute("a_vertexNormals", positionsBuffer);
+        }
+      }
+      if (p.hasAttribute("a_barycoord")) {
+        p.setAttribute("a_barycoord", positionsBuffer);
+      }
+    }
+    if (p.hasAttribute("a_instanceTransform")) {
+      p.setAttribute("a_instanceTransform", instanceTransformColumnsData);
+      p.setAttributePerInstance("a_instanceTransform");
+    }
+    if (p.hasAttribute("a_instanceColor")) {
+      p.setAttribute("a_instanceColor", instanceColorsData);
+      p.setAttributePerInstance("a_instanceColor");
+    }
+    p.setIndex(getDrawTriangleVertexInds());
+    return;
+  }
+
   if (p.hasAttribute("a_vertexPositions")) {
     p.setAttribute("a_vertexPositions", vertexPositions.getIndexedRenderAttributeBuffer(triangleVertexInds));
   }
@@ -824,141 +1346,92 @@ void SurfaceMesh::setMeshGeometryAttributes(render::ShaderProgram& p) {
   if (wantsCullPosition()) {
     p.setAttribute("a_cullPos", faceCenters.getIndexedRenderAttributeBuffer(triangleFaceInds));
   }
-}
-
-void SurfaceMesh::setMeshPickAttributes(render::ShaderProgram& p) {
-
-  // TODO in principle all of the data this shader needs is already available on the GPU via the [...]Inds attribute
-  // buffers. We could move the encoding / offsetting logic to happen in a shader with some uniforms, and avoid any
-  // CPU-side processing. Maybe the solution is to directly render ints?
-
-  // make sure we have the relevant indexing data
-  bool simplePick = !(edgesHaveBeenUsed || halfedgesHaveBeenUsed || cornersHaveBeenUsed);
-  triangleVertexInds.ensureHostBufferPopulated();
-  triangleFaceInds.ensureHostBufferPopulated();
-  if (edgesHaveBeenUsed) triangleAllEdgeInds.ensureHostBufferPopulated();
-  if (halfedgesHaveBeenUsed) triangleAllHalfedgeInds.ensureHostBufferPopulated();
-  if (cornersHaveBeenUsed) triangleCornerInds.ensureHostBufferPopulated();
-
-  // nEdges() requires computing number of edges, which is expensive and might not even be implemented for polygonal
-  // meshes. This way we only call it if actually needed, and use 0 otherwise.
-  size_t nEdgesSafe = edgesHaveBeenUsed ? nEdges() : 0;
-
-  // Get element indices
-  size_t totalPickElements = nVertices() + nFaces() + nEdgesSafe + nHalfedges() + nCorners();
-
-  // In "local" indices, indexing elements only within this mesh, used for reading later
-  facePickIndStart = nVertices();
-  edgePickIndStart = facePickIndStart + nFaces();
-  halfedgePickIndStart = edgePickIndStart + nEdgesSafe;
-  cornerPickIndStart = halfedgePickIndStart + nHalfedges();
-
-  // In "global" indices, indexing all elements in the scene, used to fill buffers for drawing here
-  size_t pickStart = pick::requestPickBufferRange(this, totalPickElements);
-  size_t vertexGlobalPickIndStart = pickStart;
-  size_t faceGlobalPickIndStart = pickStart + facePickIndStart;
-  size_t edgeGlobalPickIndStart = pickStart + edgePickIndStart;
-  size_t halfedgeGlobalPickIndStart = pickStart + halfedgePickIndStart;
-  size_t cornerGlobalPickIndStart = pickStart + cornerPickIndStart;
-
-  // == Fill buffers
-  std::vector<std::array<glm::vec3, 3>> vertexColors, halfedgeColors, cornerColors;
-  std::vector<glm::vec3> faceColor;
-
-  // Reserve space
-  vertexColors.reserve(3 * nFacesTriangulation());
-  faceColor.reserve(3 * nFacesTriangulation());
-  if (!simplePick) {
-    halfedgeColors.reserve(3 * nFacesTriangulation());
-    cornerColors.reserve(3 * nFacesTriangulation());
+  if (thresholdQuantityName != "") {
+    setThresholdAttribute(p);
   }
+  if (p.hasAttribute("a_subsetIndex")) {
+    p.setAttribute("a_subsetIndex", triangleFaceInds.getRenderAttributeBuffer());
+  }
+  if (p.hasAttribute("a_instanceTransform")) {
+    p.setAttribute("a_instanceTransform", instanceTransformColumnsData);
+    p.setAttributePerInstance("a_instanceTransform");
+  }
+  if (p.hasAttribute("a_instanceColor")) {
+    p.setAttribute("a_instanceColor", instanceColorsData);
+    p.setAttributePerInstance("a_instanceColor");
+  }
+}
 
+void SurfaceMesh::setThresholdAttribute(render::ShaderProgram& p) {
+  SurfaceMeshQuantity* q = getQuantity(thresholdQuantityName);
+  if (SurfaceVertexScalarQuantity* vertexQ = dynamic_cast<SurfaceVertexScalarQuantity*>(q)) {
+    p.setAttribute("a_thresholdValue", vertexQ->values.getIndexedRenderAttributeBuffer(triangleVertexInds));
+  } else if (SurfaceFaceScalarQuantity* faceQ = dynamic_cast<SurfaceFaceScalarQuantity*>(q)) {
+    p.setAttribute("a_thresholdValue", faceQ->values.getIndexedRenderAttributeBuffer(triangleFaceInds));
+  } else {
+    exception("Cannot threshold surface mesh [" + name + "] by quantity [" + thresholdQuantityName +
+              "], it is not a vertex or face scalar quantity of the mesh");
+  }
+}
 
-  // Build all quantities in each face
-  size_t iFTri = 0;
-  for (size_t iF = 0; iF < nFaces(); iF++) {
-    size_t D = faceIndsStart[iF + 1] - faceIndsStart[iF];
-
-    glm::vec3 fColor = pick::indToVec(iF + faceGlobalPickIndStart);
-
-    for (size_t j = 1; (j + 1) < D; j++) {
-
-      // == Build face & vertex index data
-
-      // clang-format off
-      std::array<glm::vec3, 3> vColor = {
-        pick::indToVec(triangleVertexInds.data[3*iFTri + 0] + vertexGlobalPickIndStart),
-        pick::indToVec(triangleVertexInds.data[3*iFTri + 1] + vertexGlobalPickIndStart),
-        pick::indToVec(triangleVertexInds.data[3*iFTri + 2] + vertexGlobalPickIndStart),
-      };
-      // clang-format on
-
-      for (int j = 0; j < 3; j++) {
-        faceColor.push_back(fColor);
-        vertexColors.push_back(vColor);
-      }
-
-      // Second half does halfedges/edges/corners, not used for simple mode
-      if (simplePick) {
-        iFTri++;
-        continue;
-      }
-
-
-      // Fill the halfedge buffer with edge or halfedge data, depending on which are in use
-      // In the pick function we will use the halfedge to look up the edge if needed
-      // (this is an optimization to use one less array of values, because we hit implementation limits in the shader)
-
-      // == Build edge index data, if needed
-
-
-      if (edgesHaveBeenUsed || halfedgesHaveBeenUsed) {
+void SurfaceMesh::setThresholdUniforms(render::ShaderProgram& p) {
+  if (thresholdQuantityName != "" && p.hasUniform("u_thresholdLow")) {
+    p.setUniform("u_thresholdLow", thresholdRange.first);
+    p.setUniform("u_thresholdHigh", thresholdRange.second);
+  }
+}
 
-        const std::vector<uint32_t>& eDataVec =
-            (edgesHaveBeenUsed && !halfedgesHaveBeenUsed) ? triangleAllEdgeInds.data : triangleAllHalfedgeInds.data;
-        size_t offset =
-            (edgesHaveBeenUsed && !halfedgesHaveBeenUsed) ? edgeGlobalPickIndStart : halfedgeGlobalPickIndStart;
+void SurfaceMesh::setMeshPickAttributes(render::ShaderProgram& p) {
 
-        // clang-format off
-        std::array<glm::vec3, 3> eColor = { 
-          fColor, 
-          pick::indToVec(eDataVec[9*iFTri + 1] + offset), 
-          fColor
-        };
-        // clang-format on
-        if (j == 1) eColor[0] = pick::indToVec(eDataVec[9 * iFTri + 0] + offset);
-        if (j + 2 == D) eColor[2] = pick::indToVec(eDataVec[9 * iFTri + 2] + offset);
+  // nEdges() requires computing number of edges, which is expensive and might not even be implemented for polygonal
+  // meshes. This way we only call it if actually needed, and use 0 otherwise.
+  size_t nEdgesSafe = edgesHaveBeenUsed ? nEdges() : 0;
 
-        for (int j = 0; j < 3; j++) halfedgeColors.push_back(eColor);
-      } else {
-        for (int j = 0; j < 3; j++) halfedgeColors.push_back({fColor, fColor, fColor});
-      }
+  // Get element indices
+  size_t totalPickElements = nVertices() + nFaces() + nEdgesSafe + nHalfedges() + nCorners();
 
-      // == Build corner index data, if needed
-
-      if (cornersHaveBeenUsed) {
-        // clang-format off
-        std::array<glm::vec3, 3> cColor = { 
-          pick::indToVec(triangleCornerInds.data[3*iFTri + 0] + cornerGlobalPickIndStart), 
-          pick::indToVec(triangleCornerInds.data[3*iFTri + 1] + cornerGlobalPickIndStart), 
-          pick::indToVec(triangleCornerInds.data[3*iFTri + 2] + cornerGlobalPickIndStart), 
-        };
-        // clang-format on
-        for (int j = 0; j < 3; j++) cornerColors.push_back(cColor);
-      } else {
-        for (int j = 0; j < 3; j++) cornerColors.push_back({vColor[0], vColor[1], vColor[2]});
-      }
+  // In "local" indices, indexing elements only within this mesh, used for reading later
+  facePickIndStart = nVertices();
+  edgePickIndStart = facePickIndStart + nFaces();
+  halfedgePickIndStart = edgePickIndStart + nEdgesSafe;
+  cornerPickIndStart = halfedgePickIndStart + nHalfedges();
 
-      iFTri++;
-    }
+  // Each instance gets its own copy of the range, which the shader offsets by instance. The local indices (and offsets
+  // between instances) are computed in 32 bits.
+  instancePickStride = totalPickElements;
+  size_t totalPickInstances = std::max(nInstances(), static_cast<size_t>(1));
+  if (totalPickElements * totalPickInstances > std::numeric_limits<uint32_t>::max()) {
+    exception("too many elements in surface mesh " + name + " to pick; the pick offset must fit in 32 bits");
   }
+  size_t pickStart = pick::requestPickBufferRange(this, totalPickElements * totalPickInstances);
+
+  // The pick colors are computed in the shader from the same index buffers used to draw the mesh, offset to the
+  // element type's range here
+  p.setUniform("u_pickStart", pick::indToDigits(pickStart));
+  p.setUniform("u_facePickOffset", static_cast<unsigned int>(facePickIndStart));
+  p.setAttribute("a_faceInd", triangleFaceInds.getRenderAttributeBuffer());
+  p.setAttribute("a_vertexInds", triangleAllVertexInds.getRenderAttributeBuffer());
+
+  // Without a separate corner region, the vertex region grows to cover it
+  float vertexPickRadius = 0.2;
+  if (cornersHaveBeenUsed) {
+    vertexPickRadius = 0.15;
+    p.setUniform("u_cornerPickOffset", static_cast<unsigned int>(cornerPickIndStart));
+    p.setAttribute("a_cornerInds", triangleAllCornerInds.getRenderAttributeBuffer());
+  } else if (edgesHaveBeenUsed || halfedgesHaveBeenUsed) {
+    vertexPickRadius = 0.25;
+  }
+  p.setUniform("u_vertexPickRadius", vertexPickRadius);
 
-  // Store data in buffers
-  pickProgram->setAttribute<glm::vec3, 3>("a_vertexColors", vertexColors);
-  pickProgram->setAttribute("a_faceColor", faceColor);
-  if (!simplePick) {
-    pickProgram->setAttribute<glm::vec3, 3>("a_halfedgeColors", halfedgeColors);
-    pickProgram->setAttribute<glm::vec3, 3>("a_cornerColors", cornerColors);
+  // Halfedges give edges too (see buildPickUI()), so edge indices are only used if halfedges are not
+  if (edgesHaveBeenUsed || halfedgesHaveBeenUsed) {
+    if (edgesHaveBeenUsed && !halfedgesHaveBeenUsed) {
+      p.setUniform("u_halfedgePickOffset", static_cast<unsigned int>(edgePickIndStart));
+      p.setAttribute("a_halfedgeInds", triangleAllEdgeInds.getRenderAttributeBuffer());
+    } else {
+      p.setUniform("u_halfedgePickOffset", static_cast<unsigned int>(halfedgePickIndStart));
+      p.setAttribute("a_halfedgeInds", triangleAllHalfedgeInds.getRenderAttributeBuffer());
+    }
   }
 }
 
@@ -975,7 +1448,9 @@ std::vector<std::string> SurfaceMesh::addSurfaceMeshRules(std::vector<std::strin
         initRules.push_back("MESH_WIREFRAME");
       }
 
-      if (shadeStyle.get() == MeshShadeStyle::TriFlat) {
+      // (for triangle meshes, flat shading is the same as shading each triangle flat, and does not need face normals)
+      if (shadeStyle.get() == MeshShadeStyle::TriFlat ||
+          (shadeStyle.get() == MeshShadeStyle::Flat && nFacesTriangulation() == nFaces())) {
         initRules.push_back("MESH_COMPUTE_NORMAL_FROM_POSITION");
       }
 
@@ -1002,11 +1477,29 @@ std::vector<std::string> SurfaceMesh::addSurfaceMeshRules(std::vector<std::strin
     if (wantsCullPosition()) {
       initRules.push_back("MESH_PROPAGATE_CULLPOS");
     }
+
+    if (thresholdQuantityName != "") {
+      initRules.push_back("MESH_PROPAGATE_THRESHOLD");
+      initRules.push_back("THRESHOLD_CULL");
+    }
+
+    initRules = addSubsetRules(initRules, "MESH_PROPAGATE_SUBSET_INDEX");
+
+    if (nInstances() > 0) {
+      initRules.push_back("MESH_INSTANCED");
+    }
   }
   return initRules;
 }
 
 void SurfaceMesh::setSurfaceMeshUniforms(render::ShaderProgram& p) {
+  applyDrawRanges(p);
+  setThresholdUniforms(p);
+  if (p.hasUniform("u_positionQuantMin")) {
+    // (set when the compressed buffer was computed, which happened before it was given to the program)
+    p.setUniform("u_positionQuantMin", geometryOwner().compressedPositionMin);
+    p.setUniform("u_positionQuantScale", geometryOwner().compressedPositionScale);
+  }
   if (getEdgeWidth() > 0) {
     p.setUniform("u_edgeWidth", getEdgeWidth() * render::engine->getCurrentPixelScaling());
     p.setUniform("u_edgeColor", getEdgeColor());
@@ -1014,17 +1507,181 @@ void SurfaceMesh::setSurfaceMeshUniforms(render::ShaderProgram& p) {
   if (backFacePolicy.get() == BackFacePolicy::Custom) {
     p.setUniform("u_backfaceColor", getBackFaceColor());
   }
-  if (shadeStyle.get() == MeshShadeStyle::TriFlat) {
-    glm::mat4 P = view::getCameraPerspectiveMatrix();
-    glm::mat4 Pinv = glm::inverse(P);
-    p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-    p.setUniform("u_viewport", render::engine->getCurrentViewport());
+}
+
+
+void SurfaceMesh::computeDrawClusters() {
+  vertexPositions.ensureHostBufferPopulated();
+  triangleVertexInds.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  const std::vector<uint32_t>& triInds = triangleVertexInds.data;
+  size_t nTri = nFacesTriangulation();
+
+  // Split the triangles in to runs
+  drawClusters.clear();
+  if (meshletDrawing) {
+    // greedily grow each meshlet until the next triangle would exceed one of the limits
+    const size_t noCluster = std::numeric_limits<size_t>::max();
+    std::vector<size_t> vertexLastCluster(nVertices(), noCluster);
+    size_t clusterVertexCount = 0;
+    for (size_t iT = 0; iT < nTri; iT++) {
+      bool startCluster = drawClusters.empty() || drawClusters.back().triangleCount == meshletMaxTriangles;
+      if (!startCluster) {
+        size_t newVertexCount = 0;
+        for (size_t j = 0; j < 3; j++) {
+          if (vertexLastCluster[triInds[3 * iT + j]] != drawClusters.size() - 1) newVertexCount++;
+        }
+        startCluster = clusterVertexCount + newVertexCount > meshletMaxVertices;
+      }
+      if (startCluster) {
+        drawClusters.push_back(DrawCluster{iT, 0});
+        clusterVertexCount = 0;
+      }
+      size_t iC = drawClusters.size() - 1;
+      for (size_t j = 0; j < 3; j++) {
+        size_t& last = vertexLastCluster[triInds[3 * iT + j]];
+        if (last != iC) {
+          last = iC;
+          clusterVertexCount++;
+        }
+      }
+      drawClusters.back().triangleCount++;
+    }
+  } else {
+    for (size_t iT = 0; iT < nTri; iT += drawChunkSize) {
+      size_t count = (nTri - iT < drawChunkSize) ? nTri - iT : drawChunkSize;
+      drawClusters.push_back(DrawCluster{iT, count});
+    }
+  }
+
+  // Bound each cluster, and the normals of its faces (the cone construction follows meshoptimizer)
+  parallelFor(
+      0, drawClusters.size(),
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          DrawCluster& cluster = drawClusters[iC];
+          size_t cornerStart = 3 * cluster.triangleStart;
+          size_t cornerEnd = 3 * (cluster.triangleStart + cluster.triangleCount);
+
+          glm::vec3 bMin{std::numeric_limits<float>::infinity()};
+          glm::vec3 bMax{-std::numeric_limits<float>::infinity()};
+          for (size_t i = cornerStart; i < cornerEnd; i++) {
+            bMin = glm::min(bMin, pos[triInds[i]]);
+            bMax = glm::max(bMax, pos[triInds[i]]);
+          }
+          cluster.boundMin = bMin;
+          cluster.boundMax = bMax;
+          cluster.sphereCenter = 0.5f * (bMin + bMax);
+          cluster.sphereRadius = 0.f;
+          for (size_t i = cornerStart; i < cornerEnd; i++) {
+            cluster.sphereRadius = std::max(cluster.sphereRadius, glm::length(pos[triInds[i]] - cluster.sphereCenter));
+          }
+
+          glm::vec3 axis{0., 0., 0.};
+          for (size_t i = cornerStart; i < cornerEnd; i += 3) {
+            glm::vec3 n = glm::cross(pos[triInds[i + 1]] - pos[triInds[i]], pos[triInds[i + 2]] - pos[triInds[i]]);
+            float len = glm::length(n);
+            if (len > 0.) axis += n / len;
+          }
+          cluster.coneAxis = glm::vec3{0., 0., 0.};
+          cluster.coneCutoff = 1.;
+          float axisLen = glm::length(axis);
+          if (!(axisLen > 0.)) continue;
+          axis /= axisLen;
+
+          float minDot = 1.;
+          for (size_t i = cornerStart; i < cornerEnd; i += 3) {
+            glm::vec3 n = glm::cross(pos[triInds[i + 1]] - pos[triInds[i]], pos[triInds[i + 2]] - pos[triInds[i]]);
+            float len = glm::length(n);
+            if (len > 0.) minDot = std::min(minDot, glm::dot(n / len, axis));
+          }
+          if (minDot <= 0.1f) continue; // too wide to ever cull
+          cluster.coneAxis = axis;
+          cluster.coneCutoff = std::sqrt(1.f - minDot * minDot);
+        }
+      },
+      1);
+}
+
+void SurfaceMesh::updateVisibleDrawRanges() {
+  if (drawClusters.empty() && nFacesTriangulation() > 0) {
+    computeDrawClusters();
+  }
+
+  glm::mat4 viewProjMat = view::getCameraPerspectiveMatrix() * view::getCameraViewMatrix();
+
+  // Back-face culling of whole clusters happens in object space, which needs the transform to preserve orientation
+  bool cullBackClusters = backFacePolicy.get() == BackFacePolicy::Cull &&
+                          view::projectionMode == ProjectionMode::Perspective &&
+                          glm::determinant(glm::mat3(objectTransform.get())) > 0.;
+  glm::vec3 cameraObjectPos{0., 0., 0.};
+  if (cullBackClusters) {
+    glm::vec4 c = glm::inverse(objectTransform.get()) * glm::vec4(view::getCameraWorldPosition(), 1.);
+    cameraObjectPos = glm::vec3(c) / c.w;
+  }
+
+  std::vector<char> clusterVisible(drawClusters.size());
+  parallelFor(
+      0, drawClusters.size(),
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          const DrawCluster& cluster = drawClusters[iC];
+          bool visible = true;
+          if (cullBackClusters) {
+            glm::vec3 toCluster = cluster.sphereCenter - cameraObjectPos;
+            if (glm::dot(toCluster, cluster.coneAxis) >=
+                cluster.coneCutoff * glm::length(toCluster) + cluster.sphereRadius) {
+              visible = false;
+            }
+          }
+          if (visible) {
+            visible = objectSpaceBoxMayBeVisible(cluster.boundMin, cluster.boundMax, viewProjMat, true);
+          }
+          clusterVisible[iC] = visible;
+        }
+      },
+      64);
+
+  visibleDrawRanges.clear();
+  for (size_t iC = 0; iC < drawClusters.size(); iC++) {
+    if (!clusterVisible[iC]) continue;
+
+    size_t first = 3 * drawClusters[iC].triangleStart;
+    size_t count = 3 * drawClusters[iC].triangleCount;
+    if (!visibleDrawRanges.empty() && visibleDrawRanges.back()[0] + visibleDrawRanges.back()[1] == first) {
+      visibleDrawRanges.back()[1] += count; // merge with the previous cluster
+    } else {
+      visibleDrawRanges.push_back({first, count});
+    }
   }
 }
 
+void SurfaceMesh::applyDrawRanges(render::ShaderProgram& p) {
+  if (nInstances() > 0) {
+    // the chunk bounds are for the base mesh, so instanced draws are never culled by chunk
+    p.clearDrawRanges();
+    p.setInstanceCount(static_cast<uint32_t>(nInstances()));
+    if (p.hasUniform("u_instancePickStride")) {
+      p.setUniform("u_instancePickStride", static_cast<unsigned int>(instancePickStride));
+    }
+    return;
+  }
+
+  p.clearInstanceCount();
+  if (usesDrawClusters()) {
+    p.setDrawRanges(visibleDrawRanges);
+  } else {
+    p.clearDrawRanges();
+  }
+}
 
 void SurfaceMesh::buildPickUI(size_t localPickID) {
 
+  if (nInstances() > 0) {
+    ImGui::Text("Instance #%zu", localPickID / instancePickStride);
+    localPickID = localPickID % instancePickStride;
+  }
+
   // Selection type
   if (localPickID < facePickIndStart) {
     buildVertexInfoGui(localPickID);
@@ -1038,16 +1695,23 @@ void SurfaceMesh::buildPickUI(size_t localPickID) {
     if (edgesHaveBeenUsed) {
       // do the edge one too (see not in pick buffer filler)
       uint32_t halfedgeInd = localPickID - halfedgePickIndStart;
-      if (halfedgeInd >= halfedgeEdgeCorrespondence.size()) {
+      const std::vector<uint32_t>& halfedgeEdges = geometryOwner().halfedgeEdgeCorrespondence;
+      if (halfedgeInd >= halfedgeEdges.size()) {
         exception("problem with halfedge edge indices");
       }
-      uint32_t edgeInd = halfedgeEdgeCorrespondence[halfedgeInd];
+      uint32_t edgeInd = halfedgeEdges[halfedgeInd];
 
       ImGui::NewLine();
       buildEdgeInfoGui(edgeInd);
     }
   } else {
-    buildCornerInfoGui(localPickID - cornerPickIndStart);
+    // the pick buffer holds the permuted corner index, if there is a permutation
+    size_t cInd = localPickID - cornerPickIndStart;
+    if (!cornerPerm.empty()) {
+      cInd = std::find(cornerPerm.begin(), cornerPerm.end(), cInd) - cornerPerm.begin();
+      if (cInd >= nCorners()) exception("problem with corner indices");
+    }
+    buildCornerInfoGui(cInd);
   }
 }
 
@@ -1064,7 +1728,7 @@ glm::vec2 SurfaceMesh::projectToScreenSpace(glm::vec3 coord) {
 void SurfaceMesh::buildVertexInfoGui(size_t vInd) {
 
   size_t displayInd = vInd;
-  ImGui::TextUnformatted(("Vertex #" + std::to_string(displayInd)).c_str());
+  ImGui::Text("Vertex #%zu", displayInd);
 
   std::stringstream buffer;
   buffer << vertexPositions.getValue(vInd);
@@ -1088,7 +1752,7 @@ void SurfaceMesh::buildVertexInfoGui(size_t vInd) {
 
 void SurfaceMesh::buildFaceInfoGui(size_t fInd) {
   size_t displayInd = fInd;
-  ImGui::TextUnformatted(("Face #" + std::to_string(displayInd)).c_str());
+  ImGui::Text("Face #%zu", displayInd);
 
   ImGui::Spacing();
   ImGui::Spacing();
@@ -1111,7 +1775,7 @@ void SurfaceMesh::buildEdgeInfoGui(size_t eInd) {
   if (edgePerm.size() > 0) {
     displayInd = edgePerm[eInd];
   }
-  ImGui::TextUnformatted(("Edge #" + std::to_string(displayInd)).c_str());
+  ImGui::Text("Edge #%zu", displayInd);
 
   ImGui::Spacing();
   ImGui::Spacing();
@@ -1134,7 +1798,7 @@ void SurfaceMesh::buildHalfedgeInfoGui(size_t heInd) {
   if (halfedgePerm.size() > 0) {
     displayInd = halfedgePerm[heInd];
   }
-  ImGui::TextUnformatted(("Halfedge #" + std::to_string(displayInd)).c_str());
+  ImGui::Text("Halfedge #%zu", displayInd);
 
   ImGui::Spacing();
   ImGui::Spacing();
@@ -1154,7 +1818,7 @@ void SurfaceMesh::buildHalfedgeInfoGui(size_t heInd) {
 
 void SurfaceMesh::buildCornerInfoGui(size_t cInd) {
   size_t displayInd = cInd;
-  ImGui::TextUnformatted(("Corner #" + std::to_string(displayInd)).c_str());
+  ImGui::Text("Corner #%zu", displayInd);
 
   ImGui::Spacing();
   ImGui::Spacing();
@@ -1179,6 +1843,16 @@ void SurfaceMesh::buildCustomUI() {
   long long int nVertsL = static_cast<long long int>(nVertices());
   long long int nFacesL = static_cast<long long int>(nFaces());
   ImGui::Text("#verts: %lld  #faces: %lld", nVertsL, nFacesL);
+  if (nInstances() > 0) {
+    ImGui::Text("#instances: %lld", static_cast<long long int>(nInstances()));
+  }
+
+  if (!positionKeyframes.empty()) {
+    float t = static_cast<float>(keyframeTime);
+    if (ImGui::SliderFloat("keyframe", &t, 0.f, static_cast<float>(positionKeyframes.size() - 1))) {
+      setKeyframeTime(t);
+    }
+  }
 
   { // Colors
     if (ImGui::ColorEdit3("Color", &surfaceColor.get()[0], ImGuiColorEditFlags_NoInputs))
@@ -1240,11 +1914,8 @@ void SurfaceMesh::buildCustomUI() {
       ImGui::SameLine();
       ImGui::PushItemWidth(75);
       if (ImGui::SliderFloat("Width", &edgeWidth.get(), 0.001, 2.)) {
-        // NOTE: this intentionally circumvents the setEdgeWidth() setter to avoid repopulating the buffer as the
-        // slider is dragged---otherwise we repopulate the buffer on every change, which mostly works fine. This is a
-        // lazy solution instead of better state/buffer management. setEdgeWidth(getEdgeWidth());
-        edgeWidth.manuallyChanged();
-        requestRedraw();
+        // the slider stays above zero, so this never needs to regenerate programs
+        setEdgeWidth(getEdgeWidth());
       }
       ImGui::PopItemWidth();
     }
@@ -1258,6 +1929,19 @@ void SurfaceMesh::buildCustomUI() {
         setBackFaceColor(backFaceColor.get());
     }
   }
+
+  { // Threshold range (only visible if thresholding)
+    SurfaceScalarQuantity* thresholdQ = dynamic_cast<SurfaceScalarQuantity*>(getQuantity(thresholdQuantityName));
+    if (thresholdQ != nullptr) {
+      float low = static_cast<float>(thresholdRange.first);
+      float high = static_cast<float>(thresholdRange.second);
+      std::pair<double, double> dataRange = thresholdQ->getDataRange();
+      float speed = static_cast<float>((dataRange.second - dataRange.first) / 200.);
+      if (ImGui::DragFloatRange2("Threshold", &low, &high, speed, dataRange.first, dataRange.second, "%.4g")) {
+        setThresholdRange(low, high);
+      }
+    }
+  }
 }
 
 
@@ -1267,6 +1951,21 @@ void SurfaceMesh::buildCustomOptionsUI() {
     setMaterial(material.get()); // trigger the other updates that happen on set()
   }
 
+  if (ImGui::BeginMenu("Threshold")) {
+    if (ImGui::MenuItem("none", nullptr, thresholdQuantityName == "")) clearThresholdQuantity();
+    ImGui::Separator();
+    for (auto& q : quantities) {
+      SurfaceScalarQuantity* scalarQ = dynamic_cast<SurfaceScalarQuantity*>(q.second.get());
+      bool usable = dynamic_cast<SurfaceVertexScalarQuantity*>(scalarQ) != nullptr ||
+                    dynamic_cast<SurfaceFaceScalarQuantity*>(scalarQ) != nullptr;
+      if (usable && ImGui::MenuItem(scalarQ->name.c_str(), nullptr, thresholdQuantityName == scalarQ->name)) {
+        std::pair<double, double> dataRange = scalarQ->getDataRange();
+        setThresholdQuantity(scalarQ->name, dataRange.first, dataRange.second);
+      }
+    }
+    ImGui::EndMenu();
+  }
+
   // backfaces
   if (ImGui::BeginMenu("Back Face Policy")) {
     if (ImGui::MenuItem("identical shading", NULL, backFacePolicy.get() == BackFacePolicy::Identical))
@@ -1281,17 +1980,357 @@ void SurfaceMesh::buildCustomOptionsUI() {
   }
 }
 
+void SurfaceMesh::setVertexPositionKeyframesImpl(std::vector<std::vector<glm::vec3>> keyframes) {
+  if (keyframes.empty()) exception("mesh " + name + " was given no vertex position keyframes");
+  checkGeometryNotShared("animating keyframes");
+  if (compressedVertexAttributesEnabled) {
+    exception("mesh " + name + " cannot animate keyframes while using compressed vertex attributes");
+  }
+
+  // The bounds hold every keyframe, the length scale is measured as in updateObjectSpaceBounds()
+  glm::vec3 bboxMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  glm::vec3 bboxMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+  for (const std::vector<glm::vec3>& frame : keyframes) {
+    for (const glm::vec3& p : frame) {
+      bboxMin = componentwiseMin(bboxMin, p);
+      bboxMax = componentwiseMax(bboxMax, p);
+    }
+  }
+  glm::vec3 center = 0.5f * (bboxMin + bboxMax);
+  float lengthScale = 0.;
+  for (const std::vector<glm::vec3>& frame : keyframes) {
+    for (const glm::vec3& p : frame) {
+      lengthScale = std::max(lengthScale, glm::length2(p - center));
+    }
+  }
+  objectSpaceBoundingBox = std::make_tuple(bboxMin, bboxMax);
+  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+
+  // Compute the normals of every keyframe
+  bool onDevice = render::engine->supportsAttributeBufferBlend();
+  positionKeyframes.clear();
+  std::vector<double> areas;
+  for (std::vector<glm::vec3>& frame : keyframes) {
+    PositionKeyframe k;
+    computeFaceNormalsOf(frame, k.faceNormalsData);
+    computeFaceAreasOf(frame, areas);
+    computeVertexNormalsOf(k.faceNormalsData, areas, k.vertexNormalsData);
+    k.positionsData = std::move(frame);
+
+    if (onDevice) {
+      auto upload = [&](std::vector<glm::vec3>& data) {
+        std::shared_ptr<render::AttributeBuffer> buff =
+            render::engine->generateAttributeBuffer(RenderDataType::Vector3Float);
+        buff->setMemoryOwner(uniquePrefix() + "keyframes");
+        buff->setData(data);
+        std::vector<glm::vec3>().swap(data);
+        return buff;
+      };
+      k.positions = upload(k.positionsData);
+      k.vertexNormals = upload(k.vertexNormalsData);
+      k.faceNormals = upload(k.faceNormalsData);
+    }
+    positionKeyframes.push_back(std::move(k));
+  }
+
+  setKeyframeTime(0.);
+}
+
+void SurfaceMesh::clearVertexPositionKeyframes() { positionKeyframes.clear(); }
+
+size_t SurfaceMesh::nVertexPositionKeyframes() { return positionKeyframes.size(); }
+
+void SurfaceMesh::setKeyframeTime(double t) {
+  if (positionKeyframes.empty()) exception("mesh " + name + " has no vertex position keyframes");
+  keyframeTime = glm::clamp(t, 0., static_cast<double>(positionKeyframes.size() - 1));
+  size_t i0 = static_cast<size_t>(std::floor(keyframeTime));
+  size_t i1 = std::min(i0 + 1, positionKeyframes.size() - 1);
+  float blend = static_cast<float>(keyframeTime - i0);
+  PositionKeyframe& k0 = positionKeyframes[i0];
+  PositionKeyframe& k1 = positionKeyframes[i1];
+
+  if (k0.positions) {
+    // Blend straight in to the render buffers, which then hold the only copy of the values. Indexed views (e.g. the
+    // per-corner face normals) are re-gathered on the device.
+    auto blendOnDevice = [&](render::ManagedBuffer<glm::vec3>& buffer, render::AttributeBuffer& a,
+                             render::AttributeBuffer& b, bool normalize) {
+      std::shared_ptr<render::AttributeBuffer> target = buffer.getRenderAttributeBufferForDeviceWrite(a.getDataSize());
+      if (!render::engine->blendAttributeBuffers(a, b, blend, normalize, *target)) {
+        exception("failed to blend vertex position keyframes of mesh " + name);
+      }
+      buffer.markRenderAttributeBufferUpdated();
+    };
+    blendOnDevice(vertexPositions, *k0.positions, *k1.positions, false);
+    blendOnDevice(vertexNormals, *k0.vertexNormals, *k1.vertexNormals, true);
+    blendOnDevice(faceNormals, *k0.faceNormals, *k1.faceNormals, true);
+  } else {
+    auto blendOnHost = [&](render::ManagedBuffer<glm::vec3>& buffer, const std::vector<glm::vec3>& a,
+                           const std::vector<glm::vec3>& b, bool normalize) {
+      buffer.data.resize(a.size());
+      for (size_t i = 0; i < a.size(); i++) {
+        glm::vec3 v = glm::mix(a[i], b[i], blend);
+        buffer.data[i] = normalize ? glm::normalize(v) : v;
+      }
+      buffer.markHostBufferUpdated();
+    };
+    blendOnHost(vertexPositions, k0.positionsData, k1.positionsData, false);
+    blendOnHost(vertexNormals, k0.vertexNormalsData, k1.vertexNormalsData, true);
+    blendOnHost(faceNormals, k0.faceNormalsData, k1.faceNormalsData, true);
+  }
+
+  vertexPositions.setStreaming(true);
+  rayPickBVH.clear();
+  drawClusters.clear();
+  geometryRevision++;
+  requestRedraw();
+}
+
+double SurfaceMesh::getKeyframeTime() { return keyframeTime; }
+
 void SurfaceMesh::recomputeGeometryIfPopulated() {
-  faceNormals.recomputeIfPopulated();
-  faceCenters.recomputeIfPopulated();
+  if (!deviceGeometryCompute || !recomputeGeometryOnDevice()) {
+    faceNormals.recomputeIfPopulated();
+    faceCenters.recomputeIfPopulated();
+    vertexNormals.recomputeIfPopulated();
+  }
   faceAreas.recomputeIfPopulated();
-  vertexNormals.recomputeIfPopulated();
   vertexAreas.recomputeIfPopulated();
+  compressedVertexAttributes.recomputeIfPopulated(); // (after the normals it reads)
   // edgeLengths.recomputeIfPopulated();
 }
 
+namespace {
+
+// Sort and remove duplicates
+void sortUnique(std::vector<uint32_t>& inds) {
+  std::sort(inds.begin(), inds.end());
+  inds.erase(std::unique(inds.begin(), inds.end()), inds.end());
+}
+
+// Mark the given (sorted) entries of the buffer as updated. Runs separated by small gaps are merged, so a scattered
+// set of entries doesn't turn in to a great many tiny uploads.
+template <typename T>
+void markEntriesUpdated(render::ManagedBuffer<T>& buffer, const std::vector<uint32_t>& inds) {
+  const size_t maxGap = 64;
+  size_t i = 0;
+  while (i < inds.size()) {
+    size_t runStart = inds[i];
+    size_t runEnd = inds[i] + 1;
+    for (i++; i < inds.size() && inds[i] <= runEnd + maxGap; i++) runEnd = inds[i] + 1;
+    buffer.markHostBufferRangeUpdated(runStart, runEnd);
+  }
+}
+
+} // namespace
+
+bool SurfaceMesh::recomputeGeometryOnDevice() {
+  if (!render::engine->supportsMeshGeometryCompute()) return false;
+  if (compressedVertexAttributesEnabled) return false; // (which are encoded from the normals on the host)
+
+  // As on the host, only the values which have been computed are updated
+  bool doFaceNormals = faceNormals.hasData();
+  bool doFaceCenters = faceCenters.hasData();
+  bool doVertexNormals = vertexNormals.hasData();
+  if (!doFaceNormals && !doFaceCenters && !doVertexNormals) return true;
+
+  if (deviceGeometryConnectivity.empty()) {
+    ensureHaveVertexFaceAdjacency();
+    for (std::vector<uint32_t>* data : {&faceIndsStart, &faceIndsEntries, &vertexFaceAdjStart, &vertexFaceAdjEntries}) {
+      std::shared_ptr<render::AttributeBuffer> buff = render::engine->generateAttributeBuffer(RenderDataType::UInt);
+      buff->setMemoryOwner(uniquePrefix() + "deviceGeometry");
+      buff->setData(*data);
+      deviceGeometryConnectivity.push_back(buff);
+    }
+  }
+
+  std::shared_ptr<render::AttributeBuffer> fNormals, fCenters, vNormals;
+  if (doFaceNormals) fNormals = faceNormals.getRenderAttributeBufferForDeviceWrite(nFaces());
+  if (doFaceCenters) fCenters = faceCenters.getRenderAttributeBufferForDeviceWrite(nFaces());
+  if (doVertexNormals) vNormals = vertexNormals.getRenderAttributeBufferForDeviceWrite(nVertices());
+  if (!render::engine->computeMeshGeometry(*vertexPositions.getRenderAttributeBuffer(), *deviceGeometryConnectivity[0],
+                                           *deviceGeometryConnectivity[1], *deviceGeometryConnectivity[2],
+                                           *deviceGeometryConnectivity[3], fNormals.get(), fCenters.get(),
+                                           vNormals.get())) {
+    return false;
+  }
+  if (doFaceNormals) faceNormals.markRenderAttributeBufferUpdated();
+  if (doFaceCenters) faceCenters.markRenderAttributeBufferUpdated();
+  if (doVertexNormals) vertexNormals.markRenderAttributeBufferUpdated();
+  return true;
+}
+
+void SurfaceMesh::vertexPositionsPartiallyUpdated(std::vector<uint32_t> changedVertices) {
+  sortUnique(changedVertices);
+  vertexPositions.setStreaming(true); // positions which get updated are likely to be updated again
+  markEntriesUpdated(vertexPositions, changedVertices);
+  rayPickBVH.clear();
+  drawClusters.clear();
+  geometryRevision++;
+  markGeometryViewsUpdated();
+  if (changedVertices.empty()) return;
+  ensureHaveVertexFaceAdjacency();
+
+  // The faces around the changed vertices, and the vertices of those faces, are the ones whose values change
+  std::vector<uint32_t> faces;
+  for (uint32_t iV : changedVertices) {
+    faces.insert(faces.end(), vertexFaceAdjEntries.begin() + vertexFaceAdjStart[iV],
+                 vertexFaceAdjEntries.begin() + vertexFaceAdjStart[iV + 1]);
+  }
+  sortUnique(faces);
+
+  // Past some point it is quicker to recompute everything
+  if (4 * faces.size() > nFaces()) {
+    recomputeGeometryIfPopulated();
+    return;
+  }
+
+  std::vector<uint32_t> vertices;
+  for (uint32_t iF : faces) {
+    vertices.insert(vertices.end(), faceIndsEntries.begin() + faceIndsStart[iF],
+                    faceIndsEntries.begin() + faceIndsStart[iF + 1]);
+  }
+  sortUnique(vertices);
+
+  // As in recomputeGeometryIfPopulated(), only the values which have been computed are updated (those needed to update
+  // them get computed in full, if they weren't already)
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  if (faceNormals.hasData()) {
+    faceNormals.ensureHostBufferPopulated();
+    for (uint32_t iF : faces) faceNormals.data[iF] = faceNormalOf(pos, iF);
+    markEntriesUpdated(faceNormals, faces);
+  }
+  if (faceCenters.hasData()) {
+    faceCenters.ensureHostBufferPopulated();
+    for (uint32_t iF : faces) faceCenters.data[iF] = faceCenterOf(pos, iF);
+    markEntriesUpdated(faceCenters, faces);
+  }
+  if (faceAreas.hasData()) {
+    faceAreas.ensureHostBufferPopulated();
+    for (uint32_t iF : faces) faceAreas.data[iF] = faceAreaOf(pos, iF);
+    markEntriesUpdated(faceAreas, faces);
+  }
+  if (vertexNormals.hasData()) {
+    faceNormals.ensureHostBufferPopulated();
+    faceAreas.ensureHostBufferPopulated();
+    vertexNormals.ensureHostBufferPopulated();
+    for (uint32_t iV : vertices) vertexNormals.data[iV] = vertexNormalOf(faceNormals.data, faceAreas.data, iV);
+    markEntriesUpdated(vertexNormals, vertices);
+  }
+  if (vertexAreas.hasData()) {
+    faceAreas.ensureHostBufferPopulated();
+    vertexAreas.ensureHostBufferPopulated();
+    for (uint32_t iV : vertices) vertexAreas.data[iV] = vertexAreaOf(faceAreas.data, iV);
+    markEntriesUpdated(vertexAreas, vertices);
+  }
+
+  // The compressed attributes are quantized over the bounding box of all vertices. The affected ones are re-encoded in
+  // the existing box if the changed vertices are still inside it (the box may then be a little loose), otherwise the
+  // box changes and all of them are.
+  if (compressedVertexAttributes.hasData()) {
+    bool inBox = true;
+    for (uint32_t iV : changedVertices) {
+      glm::vec3 t = compressedPositionCoord(pos[iV]);
+      if (!(t.x >= 0. && t.x <= 1. && t.y >= 0. && t.y <= 1. && t.z >= 0. && t.z <= 1.)) {
+        inBox = false;
+        break;
+      }
+    }
+    if (inBox) {
+      vertexNormals.ensureHostBufferPopulated();
+      compressedVertexAttributes.ensureHostBufferPopulated();
+      for (uint32_t iV : vertices) {
+        compressedVertexAttributes.data[iV] = compressVertexAttributes(pos[iV], vertexNormals.data[iV]);
+      }
+      markEntriesUpdated(compressedVertexAttributes, vertices);
+    } else {
+      compressedVertexAttributes.recomputeIfPopulated();
+    }
+  }
+}
+
+void SurfaceMesh::updateTopologyImpl(std::vector<glm::vec3>* newPositions, std::vector<uint32_t> newFaceIndsEntries,
+                                     std::vector<uint32_t> newFaceIndsStart, bool keepMatchingQuantities) {
+
+  checkGeometryNotShared("changing the topology");
+
+  size_t newNVerts = newPositions ? newPositions->size() : nVertices();
+  validateConnectivity(newFaceIndsEntries, newFaceIndsStart, newNVerts);
+
+  // a pending background triangulation is of the old faces (and reads them)
+  if (triangulationTask.valid()) triangulationTask.get();
+
+  std::string oldProgramName = getMeshProgramName(true);
+
+  // Swap in the new connectivity. Everything derived from the old connectivity is cleared; the permutations and edge
+  // indexing describe the old elements, so they no longer apply.
+  faceIndsEntries = std::move(newFaceIndsEntries);
+  faceIndsStart = std::move(newFaceIndsStart);
+  positionKeyframes.clear();
+  if (newPositions) vertexPositions.data = std::move(*newPositions); // (marked updated below)
+  edgePerm.clear();
+  halfedgePerm.clear();
+  cornerPerm.clear();
+  nEdgesCount = INVALID_IND;
+  edgeDataSize = INVALID_IND;
+  edgesHaveBeenUsed = false;
+  halfedgeEdgeCorrespondence.clear();
+  twinHalfedge.clear();
+  drawVertexOrder.reset(); // (the triangle order goes with the triangulation)
+  triangleStartOfFace.clear();
+  vertexFaceAdjStart.clear();
+  vertexFaceAdjEntries.clear();
+  deviceGeometryConnectivity.clear();
+  rayPickBVH.clear();
+  drawClusters.clear();
+  geometryRevision++;
+  topologyRevision++;
+  computeConnectivityData();
+
+  // Remove the quantities which no longer fit, before the shared index buffers change
+  std::vector<std::string> quantitiesToRemove;
+  for (std::pair<const std::string, std::unique_ptr<QuantityType>>& entry : quantities) {
+    if (!keepMatchingQuantities || !entry.second->fitsMeshTopology()) quantitiesToRemove.push_back(entry.first);
+  }
+  for (const std::string& qName : quantitiesToRemove) {
+    removeQuantity(qName);
+  }
+
+  // Recompute the buffers which are in use, in place. Their render buffers are resized, and indexed views which are
+  // gathered through the index buffers follow them.
+  if (newPositions) vertexPositions.markHostBufferUpdated();
+  if (triangleVertexInds.hasData() || triangleFaceInds.hasData() || baryCoord.hasData() || edgeIsReal.hasData()) {
+    ensureTriangulationComputed();
+  }
+  triangleCornerInds.recomputeIfPopulated();
+  triangleAllEdgeInds.reset(); // needs a new edge permutation
+  triangleAllHalfedgeInds.recomputeIfPopulated();
+  triangleAllCornerInds.recomputeIfPopulated();
+  triangleAllVertexInds.recomputeIfPopulated();
+  triangleFaces.recomputeIfPopulated();
+  recomputeGeometryIfPopulated();
+  defaultFaceTangentBasisX.recomputeIfPopulated();
+  defaultFaceTangentBasisY.recomputeIfPopulated();
+  updateObjectSpaceBounds();
+
+  // The mesh's program binds the same buffers, so it can be kept if the same variant applies, with just the index
+  // re-uploaded. Pick indices are laid out by element counts, so the pick program is rebuilt, as are the quantities'.
+  if (program && getMeshProgramName(true) != oldProgramName) {
+    program.reset();
+  }
+  if (program && program->usesIndexedDrawing()) {
+    program->setIndex(getDrawTriangleVertexInds());
+  }
+  pickProgram.reset();
+  for (std::pair<const std::string, std::unique_ptr<QuantityType>>& entry : quantities) {
+    entry.second->refresh();
+  }
+  requestRedraw();
+}
+
 void SurfaceMesh::refresh() {
   recomputeGeometryIfPopulated();
+  rayPickBVH.clear();
+  drawClusters.clear();
 
   program.reset();
   pickProgram.reset();
@@ -1299,26 +2338,90 @@ void SurfaceMesh::refresh() {
   QuantityStructure<SurfaceMesh>::refresh(); // call base class version, which refreshes quantities
 }
 
+void SurfaceMesh::refreshShadePrograms() {
+  program.reset();
+  requestRedraw();
+  QuantityStructure<SurfaceMesh>::refresh(); // quantities' programs are built from the same rules
+}
+
+RayPickResult SurfaceMesh::rayPick(glm::vec3 rayStart, glm::vec3 rayDir) {
+  RayPickResult result;
+
+  rayDir = glm::normalize(rayDir);
+  glm::vec3 objStart, objDir;
+  std::tie(objStart, objDir) = rayToObjectSpace(rayStart, rayDir);
+
+  vertexPositions.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+
+  // (Re)build the acceleration structure if needed. Views use their source's, which is over the same geometry.
+  BVH& bvh = geometryOwner().rayPickBVH;
+  if (!bvh.isBuilt()) {
+    std::vector<glm::vec3> primMin(nFaces()), primMax(nFaces());
+    for (size_t iF = 0; iF < nFaces(); iF++) {
+      if (faceIndsStart[iF] == faceIndsStart[iF + 1]) continue; // empty face, never hit
+      glm::vec3 fMin = pos[faceIndsEntries[faceIndsStart[iF]]];
+      glm::vec3 fMax = fMin;
+      for (size_t j = faceIndsStart[iF] + 1; j < faceIndsStart[iF + 1]; j++) {
+        fMin = glm::min(fMin, pos[faceIndsEntries[j]]);
+        fMax = glm::max(fMax, pos[faceIndsEntries[j]]);
+      }
+      primMin[iF] = fMin;
+      primMax[iF] = fMax;
+    }
+    bvh.build(primMin, primMax);
+  }
+
+  // Test against the fan triangulation of each face, as in computeConnectivityData()
+  std::pair<size_t, float> hit = bvh.intersectRay(objStart, objDir, [&](size_t iF) {
+    float tMin = std::numeric_limits<float>::infinity();
+    size_t iStart = faceIndsStart[iF];
+    size_t D = faceIndsStart[iF + 1] - iStart;
+    glm::vec3 pRoot = pos[faceIndsEntries[iStart]];
+    for (size_t j = 1; j + 1 < D; j++) {
+      glm::vec3 pB = pos[faceIndsEntries[iStart + j]];
+      glm::vec3 pC = pos[faceIndsEntries[iStart + j + 1]];
+      tMin = std::min(tMin, rayTriangleIntersection(objStart, objDir, pRoot, pB, pC));
+    }
+    return tMin;
+  });
+  if (hit.first == INVALID_IND) return result;
+
+  result.isHit = true;
+  result.depth = hit.second;
+  result.position = rayStart + hit.second * rayDir;
+  result.elementInd = hit.first;
+  return result;
+}
+
 void SurfaceMesh::updateObjectSpaceBounds() {
 
   vertexPositions.ensureHostBufferPopulated();
 
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : vertexPositions.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
-  }
+  // bounding box, and length scale as twice the radius from the center of the bounding box
+  glm::vec3 min, max;
+  float lengthScale;
+  computeBoundsAndLengthScale(vertexPositions.data.data(), vertexPositions.data.size(), min, max, lengthScale);
   objectSpaceBoundingBox = std::make_tuple(min, max);
-
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : vertexPositions.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
+  objectSpaceLengthScale = lengthScale;
+
+  // if instanced, grow the box to hold the transformed corners of the base box from each instance
+  if (nInstances() > 0 && nVertices() > 0) {
+    glm::vec3 instMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+    glm::vec3 instMax = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+    const std::vector<glm::vec4>& cols = instanceTransformColumnsData;
+    for (size_t iI = 0; iI < nInstances(); iI++) {
+      glm::mat4 T(cols[4 * iI + 0], cols[4 * iI + 1], cols[4 * iI + 2], cols[4 * iI + 3]);
+      for (int iC = 0; iC < 8; iC++) {
+        glm::vec3 corner{(iC & 1) ? max.x : min.x, (iC & 2) ? max.y : min.y, (iC & 4) ? max.z : min.z};
+        glm::vec3 p = glm::vec3(T * glm::vec4(corner, 1.));
+        instMin = componentwiseMin(instMin, p);
+        instMax = componentwiseMax(instMax, p);
+      }
+    }
+    objectSpaceBoundingBox = std::make_tuple(instMin, instMax);
+    objectSpaceLengthScale = glm::length(instMax - instMin);
   }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
 }
 
 std::string SurfaceMesh::typeName() { return structureTypeName; }
@@ -1452,15 +2555,20 @@ glm::vec3 SurfaceMesh::getEdgeColor() { return edgeColor.get(); }
 
 SurfaceMesh* SurfaceMesh::setMaterial(std::string m) {
   material = m;
-  refresh(); // (serves the purpose of re-initializing everything, though this is a bit overkill)
+  // the material is just a set of textures, swap them on the existing programs
+  if (program) render::engine->setMaterial(*program, getMaterial());
+  refreshQuantityMaterials();
   requestRedraw();
   return this;
 }
 std::string SurfaceMesh::getMaterial() { return material.get(); }
+std::string SurfaceMesh::drawSortKey() { return material.get(); }
 
 SurfaceMesh* SurfaceMesh::setEdgeWidth(double newVal) {
+  // the wireframe rule only depends on whether there are edges at all, otherwise the width is just a uniform
+  bool wireframeChanged = (newVal > 0) != (getEdgeWidth() > 0);
   edgeWidth = newVal;
-  refresh();
+  if (wireframeChanged) refreshShadePrograms();
   requestRedraw();
   return this;
 }
@@ -1468,20 +2576,133 @@ double SurfaceMesh::getEdgeWidth() { return edgeWidth.get(); }
 
 SurfaceMesh* SurfaceMesh::setBackFacePolicy(BackFacePolicy newPolicy) {
   backFacePolicy = newPolicy;
-  refresh();
+  pickProgram.reset(); // picking respects the policy too
+  refreshShadePrograms();
   requestRedraw();
   return this;
 }
 BackFacePolicy SurfaceMesh::getBackFacePolicy() { return backFacePolicy.get(); }
 
+SurfaceMesh* SurfaceMesh::setThresholdQuantity(std::string name, double low, double high) {
+  SurfaceMeshQuantity* q = getQuantity(name);
+  bool usable = dynamic_cast<SurfaceVertexScalarQuantity*>(q) != nullptr ||
+                dynamic_cast<SurfaceFaceScalarQuantity*>(q) != nullptr;
+  if (!usable) {
+    exception("Cannot threshold surface mesh [" + this->name + "] by quantity [" + name +
+              "], it is not a vertex or face scalar quantity of the mesh");
+  }
+  thresholdQuantityName = name;
+  thresholdRange = {low, high};
+  refresh();
+  return this;
+}
+
+SurfaceMesh* SurfaceMesh::setThresholdRange(double low, double high) {
+  thresholdRange = {low, high};
+  requestRedraw();
+  return this;
+}
+
+std::pair<double, double> SurfaceMesh::getThresholdRange() { return thresholdRange; }
+
+SurfaceMesh* SurfaceMesh::clearThresholdQuantity() {
+  thresholdQuantityName = "";
+  refresh();
+  return this;
+}
+
 SurfaceMesh* SurfaceMesh::setShadeStyle(MeshShadeStyle newStyle) {
   shadeStyle = newStyle;
-  refresh();
+  refreshShadePrograms();
   requestRedraw();
   return this;
 }
 MeshShadeStyle SurfaceMesh::getShadeStyle() { return shadeStyle.get(); }
 
+SurfaceMesh* SurfaceMesh::setChunkedDrawing(bool newVal) {
+  if (newVal != chunkedDrawing) {
+    chunkedDrawing = newVal;
+    refresh(); // programs which fetch face data depend on it, see canFetchFaceData()
+  }
+  requestRedraw();
+  return this;
+}
+bool SurfaceMesh::getChunkedDrawing() { return chunkedDrawing; }
+
+SurfaceMesh* SurfaceMesh::setMeshletDrawing(bool newVal) {
+  if (newVal != meshletDrawing) {
+    meshletDrawing = newVal;
+    refresh(); // clears the clusters
+    if (meshletDrawing) computeDrawClusters();
+  }
+  requestRedraw();
+  return this;
+}
+bool SurfaceMesh::getMeshletDrawing() { return meshletDrawing; }
+
+SurfaceMesh* SurfaceMesh::setCompressedVertexAttributes(bool newVal) {
+  if (newVal && !positionKeyframes.empty()) {
+    exception("mesh " + name + " has vertex position keyframes, which do not support compressed vertex attributes");
+  }
+  if (newVal != compressedVertexAttributesEnabled) {
+    compressedVertexAttributesEnabled = newVal;
+    refresh();
+  }
+  requestRedraw();
+  return this;
+}
+bool SurfaceMesh::getCompressedVertexAttributes() { return compressedVertexAttributesEnabled; }
+
+SurfaceMesh* SurfaceMesh::setDeviceGeometryCompute(bool newVal) {
+  deviceGeometryCompute = newVal;
+  if (!deviceGeometryCompute) deviceGeometryConnectivity.clear();
+  return this;
+}
+bool SurfaceMesh::getDeviceGeometryCompute() { return deviceGeometryCompute; }
+
+size_t SurfaceMesh::nDrawClusters() {
+  if (drawClusters.empty() && nFacesTriangulation() > 0) {
+    computeDrawClusters();
+  }
+  return drawClusters.size();
+}
+
+SurfaceMesh* SurfaceMesh::setInstanceTransforms(const std::vector<glm::mat4>& transforms) {
+  if (instanceColorsData.size() != transforms.size()) {
+    // the colors no longer correspond to the instances
+    instanceColorsData.clear();
+  }
+
+  instanceTransformColumnsData.resize(4 * transforms.size());
+  for (size_t iI = 0; iI < transforms.size(); iI++) {
+    for (int j = 0; j < 4; j++) {
+      instanceTransformColumnsData[4 * iI + j] = transforms[iI][j];
+    }
+  }
+
+  updateObjectSpaceBounds();
+  refresh();
+  return this;
+}
+
+SurfaceMesh* SurfaceMesh::setInstanceColors(const std::vector<glm::vec3>& colors) {
+  if (colors.size() != nInstances()) {
+    exception("setInstanceColors() for surface mesh " + name + " got " + std::to_string(colors.size()) +
+              " colors, but there are " + std::to_string(nInstances()) + " instances");
+  }
+  instanceColorsData = colors;
+  refresh();
+  return this;
+}
+
+SurfaceMesh* SurfaceMesh::clearInstances() {
+  instanceTransformColumnsData.clear();
+  instanceColorsData.clear();
+  updateObjectSpaceBounds();
+  refresh();
+  return this;
+}
+
 // === Quantity adders
 
 
@@ -1492,6 +2713,13 @@ SurfaceVertexColorQuantity* SurfaceMesh::addVertexColorQuantityImpl(std::string
   return q;
 }
 
+SurfaceVertexColorQuantity* SurfaceMesh::addPackedVertexColorQuantityImpl(std::string name,
+                                                                          const std::vector<uint32_t>& packedColors) {
+  SurfaceVertexColorQuantity* q = new SurfaceVertexColorQuantity(name, *this, packedColors);
+  addQuantity(q);
+  return q;
+}
+
 SurfaceFaceColorQuantity* SurfaceMesh::addFaceColorQuantityImpl(std::string name,
                                                                 const std::vector<glm::vec3>& colors) {
   SurfaceFaceColorQuantity* q = new SurfaceFaceColorQuantity(name, *this, colors);
@@ -1500,7 +2728,7 @@ SurfaceFaceColorQuantity* SurfaceMesh::addFaceColorQuantityImpl(std::string name
 }
 
 SurfaceVertexScalarQuantity* SurfaceMesh::addVertexDistanceQuantityImpl(std::string name,
-                                                                        const std::vector<double>& data) {
+                                                                        const std::vector<float>& data) {
   SurfaceVertexScalarQuantity* q = new SurfaceVertexScalarQuantity(name, data, *this, DataType::MAGNITUDE);
 
   q->setIsolinesEnabled(true);
@@ -1511,7 +2739,7 @@ SurfaceVertexScalarQuantity* SurfaceMesh::addVertexDistanceQuantityImpl(std::str
 }
 
 SurfaceVertexScalarQuantity* SurfaceMesh::addVertexSignedDistanceQuantityImpl(std::string name,
-                                                                              const std::vector<double>& data) {
+                                                                              const std::vector<float>& data) {
   SurfaceVertexScalarQuantity* q = new SurfaceVertexScalarQuantity(name, data, *this, DataType::SYMMETRIC);
 
   q->setIsolinesEnabled(true);
@@ -1551,14 +2779,40 @@ SurfaceMesh::addLocalParameterizationQuantityImpl(std::string name, const std::v
   return q;
 }
 
-SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantityImpl(std::string name, const std::vector<double>& data,
+SurfaceVertexScalarQuantity* SurfaceMesh::addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data,
                                                                       DataType type) {
   SurfaceVertexScalarQuantity* q = new SurfaceVertexScalarQuantity(name, data, *this, type);
   addQuantity(q);
   return q;
 }
 
-SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantityImpl(std::string name, const std::vector<double>& data,
+std::vector<SurfaceVertexScalarQuantity*>
+SurfaceMesh::addVertexScalarQuantitiesImpl(const std::vector<std::string>& names, std::vector<std::vector<float>>& data,
+                                           const std::vector<std::pair<double, double>>& dataRanges, DataType type) {
+  std::vector<SurfaceVertexScalarQuantity*> result;
+  for (size_t i = 0; i < names.size(); i++) {
+    SurfaceVertexScalarQuantity* q =
+        new SurfaceVertexScalarQuantity(names[i], std::move(data[i]), *this, type, &dataRanges[i]);
+    addQuantity(q);
+    result.push_back(q);
+  }
+  return result;
+}
+
+std::vector<SurfaceFaceScalarQuantity*>
+SurfaceMesh::addFaceScalarQuantitiesImpl(const std::vector<std::string>& names, std::vector<std::vector<float>>& data,
+                                         const std::vector<std::pair<double, double>>& dataRanges, DataType type) {
+  std::vector<SurfaceFaceScalarQuantity*> result;
+  for (size_t i = 0; i < names.size(); i++) {
+    SurfaceFaceScalarQuantity* q =
+        new SurfaceFaceScalarQuantity(names[i], std::move(data[i]), *this, type, &dataRanges[i]);
+    addQuantity(q);
+    result.push_back(q);
+  }
+  return result;
+}
+
+SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantityImpl(std::string name, const std::vector<float>& data,
                                                                   DataType type) {
   SurfaceFaceScalarQuantity* q = new SurfaceFaceScalarQuantity(name, data, *this, type);
   addQuantity(q);
@@ -1566,7 +2820,7 @@ SurfaceFaceScalarQuantity* SurfaceMesh::addFaceScalarQuantityImpl(std::string na
 }
 
 
-SurfaceEdgeScalarQuantity* SurfaceMesh::addEdgeScalarQuantityImpl(std::string name, const std::vector<double>& data,
+SurfaceEdgeScalarQuantity* SurfaceMesh::addEdgeScalarQuantityImpl(std::string name, const std::vector<float>& data,
                                                                   DataType type) {
   SurfaceEdgeScalarQuantity* q = new SurfaceEdgeScalarQuantity(name, data, *this, type);
   addQuantity(q);
@@ -1575,14 +2829,14 @@ SurfaceEdgeScalarQuantity* SurfaceMesh::addEdgeScalarQuantityImpl(std::string na
 }
 
 SurfaceHalfedgeScalarQuantity*
-SurfaceMesh::addHalfedgeScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type) {
+SurfaceMesh::addHalfedgeScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type) {
   SurfaceHalfedgeScalarQuantity* q = new SurfaceHalfedgeScalarQuantity(name, data, *this, type);
   addQuantity(q);
   markHalfedgesAsUsed();
   return q;
 }
 
-SurfaceCornerScalarQuantity* SurfaceMesh::addCornerScalarQuantityImpl(std::string name, const std::vector<double>& data,
+SurfaceCornerScalarQuantity* SurfaceMesh::addCornerScalarQuantityImpl(std::string name, const std::vector<float>& data,
                                                                       DataType type) {
   SurfaceCornerScalarQuantity* q = new SurfaceCornerScalarQuantity(name, data, *this, type);
   addQuantity(q);
@@ -1598,6 +2852,19 @@ SurfaceVertexVectorQuantity* SurfaceMesh::addVertexVectorQuantityImpl(std::strin
   return q;
 }
 
+std::vector<SurfaceVertexVectorQuantity*>
+SurfaceMesh::addVertexVectorQuantitiesImpl(const std::vector<std::string>& names,
+                                           std::vector<std::vector<glm::vec3>>& vectors, VectorType vectorType) {
+  std::vector<SurfaceVertexVectorQuantity*> result;
+  for (size_t i = 0; i < names.size(); i++) {
+    SurfaceVertexVectorQuantity* q =
+        new SurfaceVertexVectorQuantity(names[i], std::move(vectors[i]), *this, vectorType);
+    addQuantity(q);
+    result.push_back(q);
+  }
+  return result;
+}
+
 SurfaceFaceVectorQuantity*
 SurfaceMesh::addFaceVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& vectors, VectorType vectorType) {
 
@@ -1640,6 +2907,18 @@ SurfaceMesh::addOneFormTangentVectorQuantityImpl(std::string name, const std::ve
   return q;
 }
 
+SurfaceMesh* registerSurfaceMeshView(std::string name, SurfaceMesh* source) {
+  checkInitialized();
+  if (source == nullptr) exception("registerSurfaceMeshView(): no source mesh given for " + name);
+
+  SurfaceMesh* s = new SurfaceMesh(name, *source);
+  bool success = registerStructure(s);
+  if (!success) {
+    safeDelete(s);
+  }
+  return s;
+}
+
 SurfaceMeshQuantity::SurfaceMeshQuantity(std::string name, SurfaceMesh& parentStructure, bool dominates)
     : QuantityS<SurfaceMesh>(name, parentStructure, dominates) {}
 void SurfaceMeshQuantity::buildVertexInfoGUI(size_t vInd) {}
@@ -1647,5 +2926,6 @@ void SurfaceMeshQuantity::buildFaceInfoGUI(size_t fInd) {}
 void SurfaceMeshQuantity::buildEdgeInfoGUI(size_t eInd) {}
 void SurfaceMeshQuantity::buildHalfedgeInfoGUI(size_t heInd) {}
 void SurfaceMeshQuantity::buildCornerInfoGUI(size_t cInd) {}
+bool SurfaceMeshQuantity::fitsMeshTopology() { return false; }
 
 } // namespace polyscope
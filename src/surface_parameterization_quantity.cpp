@@ -2,12 +2,18 @@
 
 #include "polyscope/surface_parameterization_quantity.h"
 
+#include "polyscope/color_management.h"
+#include "polyscope/disjoint_sets.h"
 #include "polyscope/file_helpers.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace polyscope {
 
 // ==============================================================
@@ -17,7 +23,8 @@ namespace polyscope {
 SurfaceParameterizationQuantity::SurfaceParameterizationQuantity(std::string name, SurfaceMesh& mesh_,
                                                                  const std::vector<glm::vec2>& coords_,
                                                                  ParamCoordsType type_, ParamVizStyle style_)
-    : SurfaceMeshQuantity(name, mesh_, true), ParameterizationQuantity(*this, coords_, type_, style_) {}
+    : SurfaceMeshQuantity(name, mesh_, true), ParameterizationQuantity(*this, coords_, type_, style_),
+      islandColoring(uniquePrefix() + "#islandColoring", false) {}
 
 void SurfaceParameterizationQuantity::draw() {
   if (!isEnabled()) return;
@@ -27,7 +34,20 @@ void SurfaceParameterizationQuantity::draw() {
   }
 
   // Set uniforms
-  setParameterizationUniforms(*program);
+  if (islandColoring.get()) {
+    if (islandsCoordsRevision != coordsRevision) fillIslandColorBuffers(*program); // the coordinates were updated
+    switch (coordsType) {
+    case ParamCoordsType::UNIT:
+      program->setUniform("u_modLen", getCheckerSize());
+      break;
+    case ParamCoordsType::WORLD:
+      program->setUniform("u_modLen", getCheckerSize() * state::lengthScale);
+      break;
+    }
+    program->setUniform("u_modDarkness", getAltDarkness());
+  } else {
+    setParameterizationUniforms(*program);
+  }
   parent.setStructureUniforms(*program);
   parent.setSurfaceMeshUniforms(*program);
 
@@ -36,9 +56,22 @@ void SurfaceParameterizationQuantity::draw() {
 
 void SurfaceParameterizationQuantity::createProgram() {
 
+  if (islandColoring.get()) {
+    // The island colors are per-face, so this is never drawn indexed
+    program = render::engine->requestShader(parent.getMeshProgramName(false),
+                                            parent.addSurfaceMeshRules({"MESH_PROPAGATE_VALUE2", "MESH_PROPAGATE_COLOR",
+                                                                        "SHADE_COLOR", "CHECKER_VALUE2COLOR"}));
+    fillCoordBuffers(*program);
+    fillIslandColorBuffers(*program);
+    parent.setMeshGeometryAttributes(*program);
+    render::engine->setMaterial(*program, parent.getMaterial());
+    return;
+  }
+
   // Create the program to draw this quantity
   program = render::engine->requestShader(
-      "MESH", parent.addSurfaceMeshRules(addParameterizationRules({"MESH_PROPAGATE_VALUE2"})));
+      parent.getMeshProgramName(coordsArePerVertex()),
+      parent.addSurfaceMeshRules(addParameterizationRules({"MESH_PROPAGATE_VALUE2"})));
 
   // Fill buffers
   fillCoordBuffers(*program);
@@ -48,6 +81,127 @@ void SurfaceParameterizationQuantity::createProgram() {
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
+void SurfaceParameterizationQuantity::buildParameterizationOptionsUI() {
+  if (ImGui::MenuItem("Color by island", NULL, islandColoring.get())) setIslandColoring(!islandColoring.get());
+}
+
+void SurfaceParameterizationQuantity::ensureEdgeAdjacencyComputed() {
+  if (edgeAdjacencyValid && edgeAdjacencyTopologyRevision == parent.topologyRevision) return;
+  edgeAdjacencyValid = true;
+  edgeAdjacencyTopologyRevision = parent.topologyRevision;
+
+  // Sort the face-sides by their (unordered) edge, then pair up each side with the first side of the same edge
+  struct FaceSide {
+    uint64_t edgeKey;
+    uint32_t face;
+    uint32_t cornerLow, cornerHigh; // the corners at the lower- and higher-indexed vertex of the edge
+  };
+  std::vector<FaceSide> sides(parent.faceIndsEntries.size());
+  parallelFor(0, parent.nFaces(), [&](size_t fStart, size_t fEnd) {
+    for (size_t iF = fStart; iF < fEnd; iF++) {
+      uint32_t iStart = parent.faceIndsStart[iF];
+      uint32_t D = parent.faceIndsStart[iF + 1] - iStart;
+      for (uint32_t j = 0; j < D; j++) {
+        uint32_t cTail = iStart + j;
+        uint32_t cTip = iStart + (j + 1) % D;
+        uint32_t vTail = parent.faceIndsEntries[cTail];
+        uint32_t vTip = parent.faceIndsEntries[cTip];
+        bool flip = vTip < vTail;
+        uint64_t vLow = flip ? vTip : vTail;
+        uint64_t vHigh = flip ? vTail : vTip;
+        sides[cTail] =
+            FaceSide{(vLow << 32) | vHigh, static_cast<uint32_t>(iF), flip ? cTip : cTail, flip ? cTail : cTip};
+      }
+    }
+  });
+  std::sort(sides.begin(), sides.end(), [](const FaceSide& a, const FaceSide& b) {
+    return a.edgeKey < b.edgeKey || (a.edgeKey == b.edgeKey && a.face < b.face);
+  });
+
+  edgeAdjacentCorners.clear();
+  edgeAdjacentFaces.clear();
+  for (size_t iFirst = 0; iFirst < sides.size();) {
+    size_t iEnd = iFirst + 1;
+    while (iEnd < sides.size() && sides[iEnd].edgeKey == sides[iFirst].edgeKey) iEnd++;
+    for (size_t i = iFirst + 1; i < iEnd; i++) {
+      const FaceSide& a = sides[iFirst];
+      const FaceSide& b = sides[i];
+      edgeAdjacentCorners.push_back({{a.cornerLow, a.cornerHigh, b.cornerLow, b.cornerHigh}});
+      edgeAdjacentFaces.push_back({{a.face, b.face}});
+    }
+    iFirst = iEnd;
+  }
+}
+
+void SurfaceParameterizationQuantity::ensureIslandsComputed() {
+  if (islandsValid && islandsCoordsRevision == coordsRevision && islandsTopologyRevision == parent.topologyRevision) {
+    return;
+  }
+  ensureEdgeAdjacencyComputed();
+  islandsValid = true;
+  islandsCoordsRevision = coordsRevision;
+  islandsTopologyRevision = parent.topologyRevision;
+
+  // Find the seams in parallel, then merge across the rest
+  const std::vector<glm::vec2>& uv = coords.getPopulatedHostBufferRef();
+  std::vector<char> connected(edgeAdjacentCorners.size());
+  parallelFor(0, edgeAdjacentCorners.size(), [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      const std::array<uint32_t, 4>& c = edgeAdjacentCorners[i];
+      connected[i] = uv[coordIndexOfCorner(c[0])] == uv[coordIndexOfCorner(c[2])] &&
+                     uv[coordIndexOfCorner(c[1])] == uv[coordIndexOfCorner(c[3])];
+    }
+  });
+
+  size_t nF = parent.nFaces();
+  DisjointSets sets(nF);
+  for (size_t i = 0; i < edgeAdjacentFaces.size(); i++) {
+    if (connected[i]) sets.merge(edgeAdjacentFaces[i][0], edgeAdjacentFaces[i][1]);
+  }
+
+  // Number the islands in order of their first face
+  std::vector<uint32_t> islandOfRoot(nF, std::numeric_limits<uint32_t>::max());
+  faceIslands.resize(nF);
+  nIslandsCount = 0;
+  for (size_t iF = 0; iF < nF; iF++) {
+    size_t root = sets.find(iF);
+    if (islandOfRoot[root] == std::numeric_limits<uint32_t>::max()) {
+      islandOfRoot[root] = static_cast<uint32_t>(nIslandsCount++);
+    }
+    faceIslands[iF] = islandOfRoot[root];
+  }
+}
+
+void SurfaceParameterizationQuantity::fillIslandColorBuffers(render::ShaderProgram& p) {
+  ensureIslandsComputed();
+  const std::vector<uint32_t>& triFaces = parent.triangleFaceInds.getPopulatedHostBufferRef();
+  std::vector<glm::vec3> colors(triFaces.size());
+  parallelFor(0, triFaces.size(), [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+      colors[i] = getIndexedDistinctColor(static_cast<int>(faceIslands[triFaces[i]]));
+    }
+  });
+  p.setAttribute("a_color", colors);
+}
+
+size_t SurfaceParameterizationQuantity::nIslands() {
+  ensureIslandsComputed();
+  return nIslandsCount;
+}
+
+const std::vector<uint32_t>& SurfaceParameterizationQuantity::getFaceIslands() {
+  ensureIslandsComputed();
+  return faceIslands;
+}
+
+SurfaceParameterizationQuantity* SurfaceParameterizationQuantity::setIslandColoring(bool newVal) {
+  islandColoring = newVal;
+  refresh();
+  requestRedraw();
+  return this;
+}
+bool SurfaceParameterizationQuantity::getIslandColoring() { return islandColoring.get(); }
+
 void SurfaceParameterizationQuantity::buildCustomUI() {
   ImGui::SameLine();
 
@@ -71,6 +225,10 @@ void SurfaceParameterizationQuantity::refresh() {
   Quantity::refresh();
 }
 
+void SurfaceParameterizationQuantity::refreshMaterial() {
+  if (program) render::engine->setMaterial(*program, parent.getMaterial());
+}
+
 // ==============================================================
 // ===============  Corner Parameterization  ====================
 // ==============================================================
@@ -89,6 +247,8 @@ void SurfaceCornerParameterizationQuantity::fillCoordBuffers(render::ShaderProgr
   p.setAttribute("a_value2", coords.getIndexedRenderAttributeBuffer(parent.triangleCornerInds));
 }
 
+bool SurfaceCornerParameterizationQuantity::fitsMeshTopology() { return coords.size() == parent.cornerDataSize; }
+
 void SurfaceCornerParameterizationQuantity::buildCornerInfoGUI(size_t cInd) {
 
   glm::vec2 coord = coords.getValue(cInd);
@@ -113,7 +273,13 @@ SurfaceVertexParameterizationQuantity::SurfaceVertexParameterizationQuantity(std
 std::string SurfaceVertexParameterizationQuantity::niceName() { return name + " (vertex parameterization)"; }
 
 void SurfaceVertexParameterizationQuantity::fillCoordBuffers(render::ShaderProgram& p) {
-  p.setAttribute("a_value2", coords.getIndexedRenderAttributeBuffer(parent.triangleVertexInds));
+  p.setAttribute("a_value2", parent.getVertexAttributeBuffer(p, coords));
+}
+
+bool SurfaceVertexParameterizationQuantity::fitsMeshTopology() { return coords.size() == parent.vertexDataSize; }
+
+size_t SurfaceVertexParameterizationQuantity::coordIndexOfCorner(size_t iCorner) {
+  return parent.faceIndsEntries[iCorner];
 }
 
 void SurfaceVertexParameterizationQuantity::buildVertexInfoGUI(size_t vInd) {
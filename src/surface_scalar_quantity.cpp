@@ -3,16 +3,23 @@
 #include "polyscope/surface_scalar_quantity.h"
 
 #include "polyscope/file_helpers.h"
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 
 #include "imgui.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
 namespace polyscope {
 
 SurfaceScalarQuantity::SurfaceScalarQuantity(std::string name, SurfaceMesh& mesh_, std::string definedOn_,
-                                             const std::vector<double>& values_, DataType dataType_)
-    : SurfaceMeshQuantity(name, mesh_, true), ScalarQuantity(*this, values_, dataType_), definedOn(definedOn_) {}
+                                             std::vector<float> values_, DataType dataType_,
+                                             const std::pair<double, double>* dataRange_)
+    : SurfaceMeshQuantity(name, mesh_, true), ScalarQuantity(*this, std::move(values_), dataType_, dataRange_),
+      definedOn(definedOn_) {}
 
 void SurfaceScalarQuantity::draw() {
   if (!isEnabled()) return;
@@ -52,33 +59,172 @@ void SurfaceScalarQuantity::refresh() {
   Quantity::refresh();
 }
 
+void SurfaceScalarQuantity::refreshMaterial() {
+  if (program) render::engine->setMaterial(*program, parent.getMaterial());
+}
+
 std::string SurfaceScalarQuantity::niceName() { return name + " (" + definedOn + " scalar)"; }
 
 // ========================================================
 // ==========           Vertex Scalar            ==========
 // ========================================================
 
-SurfaceVertexScalarQuantity::SurfaceVertexScalarQuantity(std::string name, const std::vector<double>& values_,
-                                                         SurfaceMesh& mesh_, DataType dataType_)
-    : SurfaceScalarQuantity(name, mesh_, "vertex", values_, dataType_)
+SurfaceVertexScalarQuantity::SurfaceVertexScalarQuantity(std::string name, std::vector<float> values_,
+                                                         SurfaceMesh& mesh_, DataType dataType_,
+                                                         const std::pair<double, double>* dataRange_)
+    : SurfaceScalarQuantity(name, mesh_, "vertex", std::move(values_), dataType_, dataRange_),
+      isolinesExtracted(uniquePrefix() + "#isolinesExtracted", false)
+
+{}
 
-{
-  values.ensureHostBufferPopulated();
-  parent.vertexAreas.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data); // rebuild to incorporate weights
+void SurfaceVertexScalarQuantity::draw() {
+  if (!isEnabled()) return;
+
+  SurfaceScalarQuantity::draw();
+
+  if (isolinesEnabled.get() && isolinesExtracted.get()) {
+    drawExtractedIsolines();
+  }
 }
 
 void SurfaceVertexScalarQuantity::createProgram() {
+  std::vector<std::string> rules = addScalarRules({"MESH_PROPAGATE_VALUE"});
+  if (isolinesExtracted.get()) {
+    // the isolines are drawn as curves instead
+    rules.erase(std::remove(rules.begin(), rules.end(), "ISOLINE_STRIPE_VALUECOLOR"), rules.end());
+  }
+
   // Create the program to draw this quantity
-  program = render::engine->requestShader("MESH", parent.addSurfaceMeshRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
+  program = render::engine->requestShader(parent.getMeshProgramName(true), parent.addSurfaceMeshRules(rules));
 
-  program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleVertexInds));
+  program->setAttribute("a_value", parent.getVertexAttributeBuffer(*program, values));
   parent.setMeshGeometryAttributes(*program);
   render::engine->setMaterial(*program, parent.getMaterial());
   program->setTextureFromColormap("t_colormap", cMap.get());
 }
 
 
+bool SurfaceVertexScalarQuantity::fitsMeshTopology() { return values.size() == parent.vertexDataSize; }
+
+void SurfaceVertexScalarQuantity::refresh() {
+  isolineProgram.reset();
+  isolineSegmentsValid = false;
+  SurfaceScalarQuantity::refresh();
+}
+
+void SurfaceVertexScalarQuantity::buildScalarOptionsUI() {
+  SurfaceScalarQuantity::buildScalarOptionsUI();
+  if (ImGui::MenuItem("Extract isolines as curves", NULL, isolinesExtracted.get())) {
+    setIsolinesExtracted(!isolinesExtracted.get());
+  }
+}
+
+SurfaceVertexScalarQuantity* SurfaceVertexScalarQuantity::setIsolinesExtracted(bool newVal) {
+  isolinesExtracted = newVal;
+  refresh();
+  requestRedraw();
+  return this;
+}
+bool SurfaceVertexScalarQuantity::getIsolinesExtracted() { return isolinesExtracted.get(); }
+
+size_t SurfaceVertexScalarQuantity::nExtractedIsolineSegments() {
+  ensureIsolinesExtracted();
+  return isolineTails.size();
+}
+
+void SurfaceVertexScalarQuantity::ensureIsolinesExtracted() {
+  float period = static_cast<float>(getIsolineWidth());
+  if (isolineSegmentsValid && isolineSegmentsPeriod == period && isolineSegmentsDataRevision == dataRevision &&
+      isolineSegmentsGeometryRevision == parent.geometryRevision) {
+    return;
+  }
+  isolineSegmentsValid = true;
+  isolineSegmentsPeriod = period;
+  isolineSegmentsDataRevision = dataRevision;
+  isolineSegmentsGeometryRevision = parent.geometryRevision;
+  isolineProgram.reset();
+  isolineTails.clear();
+  isolineTips.clear();
+
+  // The isolines are at the multiples of the period, the same as the boundaries of the shader's stripes
+  if (!(period > 0.)) return;
+  if ((dataRange.second - dataRange.first) / period > maxExtractedIsolines) {
+    info("isolines of " + name + " are too closely spaced to extract, increase the isoline width");
+    return;
+  }
+
+  const std::vector<glm::vec3>& positions = parent.vertexPositions.getPopulatedHostBufferRef();
+  const std::vector<uint32_t>& triInds = parent.triangleVertexInds.getPopulatedHostBufferRef();
+  const std::vector<float>& vals = values.getPopulatedHostBufferRef();
+  size_t nTri = triInds.size() / 3;
+
+  // Marching triangles: each isovalue crosses either zero or two edges of a triangle, where a vertex counts as above
+  // the isovalue if its value is >= it. Calls f(tail, tip) for each segment of triangle iTri.
+  auto forEachSegment = [&](size_t iTri, const std::function<void(glm::vec3, glm::vec3)>& f) {
+    uint32_t v[3] = {triInds[3 * iTri], triInds[3 * iTri + 1], triInds[3 * iTri + 2]};
+    float x[3] = {vals[v[0]], vals[v[1]], vals[v[2]]};
+    double kFirst = std::ceil(std::min({x[0], x[1], x[2]}) / period);
+    double kLast = std::floor(std::max({x[0], x[1], x[2]}) / period);
+    for (double k = kFirst; k <= kLast; k++) {
+      float iso = static_cast<float>(k * period);
+      glm::vec3 ends[2];
+      int nEnds = 0;
+      for (int j = 0; j < 3; j++) {
+        int jN = (j + 1) % 3;
+        if ((x[j] >= iso) == (x[jN] >= iso)) continue;
+        float t = (iso - x[j]) / (x[jN] - x[j]);
+        ends[nEnds++] = glm::mix(positions[v[j]], positions[v[jN]], t);
+      }
+      if (nEnds == 2) f(ends[0], ends[1]);
+    }
+  };
+
+  // Count the segments of each triangle, then write them to their offsets, so the output order is deterministic
+  std::vector<size_t> segmentOffsets(nTri + 1, 0);
+  parallelFor(0, nTri, [&](size_t start, size_t end) {
+    for (size_t iTri = start; iTri < end; iTri++) {
+      forEachSegment(iTri, [&](glm::vec3, glm::vec3) { segmentOffsets[iTri + 1]++; });
+    }
+  });
+  for (size_t iTri = 0; iTri < nTri; iTri++) {
+    segmentOffsets[iTri + 1] += segmentOffsets[iTri];
+  }
+  isolineTails.resize(segmentOffsets[nTri]);
+  isolineTips.resize(segmentOffsets[nTri]);
+  parallelFor(0, nTri, [&](size_t start, size_t end) {
+    for (size_t iTri = start; iTri < end; iTri++) {
+      size_t iSeg = segmentOffsets[iTri];
+      forEachSegment(iTri, [&](glm::vec3 tail, glm::vec3 tip) {
+        isolineTails[iSeg] = tail;
+        isolineTips[iSeg] = tip;
+        iSeg++;
+      });
+    }
+  });
+}
+
+void SurfaceVertexScalarQuantity::drawExtractedIsolines() {
+  ensureIsolinesExtracted();
+  if (isolineTails.empty()) return;
+
+  if (isolineProgram == nullptr) {
+    std::vector<std::string> rules = parent.addStructureRules({"SHADE_BASECOLOR"});
+    if (parent.wantsCullPosition()) {
+      rules.push_back("CYLINDER_CULLPOS_FROM_MID");
+    }
+    isolineProgram = render::engine->requestShader("RAYCAST_CYLINDER", rules);
+    isolineProgram->setAttribute("a_position_tail", isolineTails);
+    isolineProgram->setAttribute("a_position_tip", isolineTips);
+    render::engine->setMaterial(*isolineProgram, parent.getMaterial());
+  }
+
+  // Thin curves, dark in proportion to the isoline darkness
+  parent.setStructureUniforms(*isolineProgram);
+  isolineProgram->setUniform("u_radius", 0.002f * parent.lengthScale());
+  isolineProgram->setUniform("u_baseColor", glm::vec3(glm::clamp(1.f - getIsolineDarkness(), 0., 1.)));
+  isolineProgram->draw();
+}
+
 void SurfaceVertexScalarQuantity::buildVertexInfoGUI(size_t vInd) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
@@ -90,27 +236,35 @@ void SurfaceVertexScalarQuantity::buildVertexInfoGUI(size_t vInd) {
 // ==========            Face Scalar             ==========
 // ========================================================
 
-SurfaceFaceScalarQuantity::SurfaceFaceScalarQuantity(std::string name, const std::vector<double>& values_,
-                                                     SurfaceMesh& mesh_, DataType dataType_)
-    : SurfaceScalarQuantity(name, mesh_, "face", values_, dataType_)
+SurfaceFaceScalarQuantity::SurfaceFaceScalarQuantity(std::string name, std::vector<float> values_,
+                                                     SurfaceMesh& mesh_, DataType dataType_,
+                                                     const std::pair<double, double>* dataRange_)
+    : SurfaceScalarQuantity(name, mesh_, "face", std::move(values_), dataType_, dataRange_)
 
-{
-  values.ensureHostBufferPopulated();
-  parent.faceAreas.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data); // rebuild to incorporate weights
-}
+{}
 
 void SurfaceFaceScalarQuantity::createProgram() {
   // Create the program to draw this quantity
-  program = render::engine->requestShader("MESH", parent.addSurfaceMeshRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
-
-  program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  if (parent.canFetchFaceData()) {
+    // look up the value of each face by primitive ID, rather than expanding the values to triangle corners
+    program = render::engine->requestShader(
+        parent.getMeshProgramName(true),
+        parent.addSurfaceMeshRules(addScalarRules(parent.addFaceFetchRules({"MESH_FETCH_FACE_VALUE"}))));
+    program->setTextureFromBuffer("t_faceValues", values.getTextureViewBuffer().get());
+    parent.setFaceFetchTextures(*program);
+  } else {
+    program =
+        render::engine->requestShader("MESH", parent.addSurfaceMeshRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
+    program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  }
   parent.setMeshGeometryAttributes(*program);
   render::engine->setMaterial(*program, parent.getMaterial());
   program->setTextureFromColormap("t_colormap", cMap.get());
 }
 
 
+bool SurfaceFaceScalarQuantity::fitsMeshTopology() { return values.size() == parent.faceDataSize; }
+
 void SurfaceFaceScalarQuantity::buildFaceInfoGUI(size_t fInd) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
@@ -125,14 +279,11 @@ void SurfaceFaceScalarQuantity::buildFaceInfoGUI(size_t fInd) {
 
 // TODO need to do something about values for internal edges in triangulated polygons
 
-SurfaceEdgeScalarQuantity::SurfaceEdgeScalarQuantity(std::string name, const std::vector<double>& values_,
+SurfaceEdgeScalarQuantity::SurfaceEdgeScalarQuantity(std::string name, const std::vector<float>& values_,
                                                      SurfaceMesh& mesh_, DataType dataType_)
     : SurfaceScalarQuantity(name, mesh_, "edge", values_, dataType_)
 
-{
-  values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data); // rebuild to incorporate weights
-}
+{}
 
 void SurfaceEdgeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
@@ -146,6 +297,8 @@ void SurfaceEdgeScalarQuantity::createProgram() {
 }
 
 
+bool SurfaceEdgeScalarQuantity::fitsMeshTopology() { return values.size() == parent.edgeDataSize; }
+
 void SurfaceEdgeScalarQuantity::buildEdgeInfoGUI(size_t eInd) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
@@ -157,14 +310,11 @@ void SurfaceEdgeScalarQuantity::buildEdgeInfoGUI(size_t eInd) {
 // ==========          Halfedge Scalar           ==========
 // ========================================================
 
-SurfaceHalfedgeScalarQuantity::SurfaceHalfedgeScalarQuantity(std::string name, const std::vector<double>& values_,
+SurfaceHalfedgeScalarQuantity::SurfaceHalfedgeScalarQuantity(std::string name, const std::vector<float>& values_,
                                                              SurfaceMesh& mesh_, DataType dataType_)
     : SurfaceScalarQuantity(name, mesh_, "halfedge", values_, dataType_)
 
-{
-  values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
-}
+{}
 
 void SurfaceHalfedgeScalarQuantity::createProgram() {
   // Create the program to draw this quantity
@@ -177,6 +327,8 @@ void SurfaceHalfedgeScalarQuantity::createProgram() {
   program->setTextureFromColormap("t_colormap", cMap.get());
 }
 
+bool SurfaceHalfedgeScalarQuantity::fitsMeshTopology() { return values.size() == parent.halfedgeDataSize; }
+
 void SurfaceHalfedgeScalarQuantity::buildHalfedgeInfoGUI(size_t heInd) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
@@ -188,14 +340,11 @@ void SurfaceHalfedgeScalarQuantity::buildHalfedgeInfoGUI(size_t heInd) {
 // ==========          Corner Scalar           ==========
 // ========================================================
 
-SurfaceCornerScalarQuantity::SurfaceCornerScalarQuantity(std::string name, const std::vector<double>& values_,
+SurfaceCornerScalarQuantity::SurfaceCornerScalarQuantity(std::string name, const std::vector<float>& values_,
                                                          SurfaceMesh& mesh_, DataType dataType_)
     : SurfaceScalarQuantity(name, mesh_, "corner", values_, dataType_)
 
-{
-  values.ensureHostBufferPopulated();
-  hist.buildHistogram(values.data);
-}
+{}
 
 void SurfaceCornerScalarQuantity::createProgram() {
   // Create the program to draw this quantity
@@ -207,6 +356,8 @@ void SurfaceCornerScalarQuantity::createProgram() {
   program->setTextureFromColormap("t_colormap", cMap.get());
 }
 
+bool SurfaceCornerScalarQuantity::fitsMeshTopology() { return values.size() == parent.cornerDataSize; }
+
 void SurfaceCornerScalarQuantity::buildCornerInfoGUI(size_t cInd) {
   ImGui::TextUnformatted(name.c_str());
   ImGui::NextColumn();
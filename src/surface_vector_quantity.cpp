@@ -15,7 +15,82 @@
 namespace polyscope {
 
 SurfaceVectorQuantity::SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh_, MeshElement definedOn_)
-    : SurfaceMeshQuantity(name, mesh_) {}
+    : SurfaceMeshQuantity(name, mesh_), definedOn(definedOn_), licEnabled(uniquePrefix() + "#licEnabled", false),
+      licNoiseScale(uniquePrefix() + "#licNoiseScale", relativeValue(0.005)),
+      licLength(uniquePrefix() + "#licLength", 8.) {}
+
+void SurfaceVectorQuantity::refresh() {
+  licProgram.reset();
+  Quantity::refresh();
+}
+
+void SurfaceVectorQuantity::refreshMaterial() {
+  if (licProgram) render::engine->setMaterial(*licProgram, parent.getMaterial());
+}
+
+void SurfaceVectorQuantity::drawLIC(glm::vec3 color) {
+  if (!licProgram) {
+    createLICProgram();
+  }
+
+  parent.setStructureUniforms(*licProgram);
+  parent.setSurfaceMeshUniforms(*licProgram);
+  licProgram->setUniform("u_baseColor", color);
+  licProgram->setUniform("u_licNoiseFreq", 1. / licNoiseScale.get().asAbsolute());
+  licProgram->setUniform("u_licLength", licLength.get());
+
+  // drawn over the surface itself, which has already written the same depth
+  render::engine->setDepthMode(DepthMode::LEqual);
+  licProgram->draw();
+  render::engine->setDepthMode();
+}
+
+std::shared_ptr<render::ShaderProgram> SurfaceVectorQuantity::requestLICProgram(std::string vectorRule) {
+  std::shared_ptr<render::ShaderProgram> p =
+      render::engine->requestShader(parent.getMeshProgramName(definedOn == MeshElement::VERTEX),
+                                    parent.addSurfaceMeshRules({vectorRule, "MESH_SHADE_LIC"}));
+  parent.setMeshGeometryAttributes(*p);
+  render::engine->setMaterial(*p, parent.getMaterial());
+  return p;
+}
+
+void SurfaceVectorQuantity::buildLICUI() {
+  if (ImGui::Checkbox("Surface LIC", &licEnabled.get())) {
+    setLICEnabled(getLICEnabled());
+  }
+  if (getLICEnabled()) {
+    if (ImGui::SliderFloat("Noise scale", licNoiseScale.get().getValuePtr(), 0.0001, .05, "%.5f",
+                           ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
+      licNoiseScale.manuallyChanged();
+      requestRedraw();
+    }
+    if (ImGui::SliderFloat("Streak length", &licLength.get(), 1., 32., "%.1f")) {
+      licLength.manuallyChanged();
+      requestRedraw();
+    }
+  }
+}
+
+SurfaceVectorQuantity* SurfaceVectorQuantity::setLICEnabled(bool newVal) {
+  licEnabled = newVal;
+  requestRedraw();
+  return this;
+}
+bool SurfaceVectorQuantity::getLICEnabled() { return licEnabled.get(); }
+
+SurfaceVectorQuantity* SurfaceVectorQuantity::setLICNoiseScale(double newVal, bool isRelative) {
+  licNoiseScale = ScaledValue<float>(newVal, isRelative);
+  requestRedraw();
+  return this;
+}
+double SurfaceVectorQuantity::getLICNoiseScale() { return licNoiseScale.get().asAbsolute(); }
+
+SurfaceVectorQuantity* SurfaceVectorQuantity::setLICLength(double newVal) {
+  licLength = newVal;
+  requestRedraw();
+  return this;
+}
+double SurfaceVectorQuantity::getLICLength() { return licLength.get(); }
 
 
 // ========================================================
@@ -25,20 +100,34 @@ SurfaceVectorQuantity::SurfaceVectorQuantity(std::string name, SurfaceMesh& mesh
 SurfaceVertexVectorQuantity::SurfaceVertexVectorQuantity(std::string name, std::vector<glm::vec3> vectors_,
                                                          SurfaceMesh& mesh_, VectorType vectorType_)
     : SurfaceVectorQuantity(name, mesh_, MeshElement::VERTEX),
-      VectorQuantity<SurfaceVertexVectorQuantity>(*this, vectors_, parent.vertexPositions, vectorType_) {}
+      VectorQuantity<SurfaceVertexVectorQuantity>(*this, std::move(vectors_), parent.vertexPositions, vectorType_) {}
 
 void SurfaceVertexVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceVertexVectorQuantity::draw() {
   if (!isEnabled()) return;
-  drawVectors();
+  if (getLICEnabled()) {
+    drawLIC(getVectorColor());
+  } else {
+    drawVectors();
+  }
+}
+
+void SurfaceVertexVectorQuantity::createLICProgram() {
+  licProgram = requestLICProgram("MESH_PROPAGATE_VECTOR");
+  licProgram->setAttribute("a_vector", parent.getVertexAttributeBuffer(*licProgram, vectors));
+}
+
+void SurfaceVertexVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildLICUI();
 }
 
-void SurfaceVertexVectorQuantity::buildCustomUI() { buildVectorUI(); }
 
+bool SurfaceVertexVectorQuantity::fitsMeshTopology() { return vectors.size() == parent.vertexDataSize; }
 
 void SurfaceVertexVectorQuantity::buildVertexInfoGUI(size_t iV) {
   ImGui::TextUnformatted(name.c_str());
@@ -69,15 +158,29 @@ SurfaceFaceVectorQuantity::SurfaceFaceVectorQuantity(std::string name, std::vect
 
 void SurfaceFaceVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceFaceVectorQuantity::draw() {
   if (!isEnabled()) return;
-  drawVectors();
+  if (getLICEnabled()) {
+    drawLIC(getVectorColor());
+  } else {
+    drawVectors();
+  }
+}
+
+void SurfaceFaceVectorQuantity::createLICProgram() {
+  licProgram = requestLICProgram("MESH_PROPAGATE_VECTOR");
+  licProgram->setAttribute("a_vector", vectors.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+}
+
+void SurfaceFaceVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildLICUI();
 }
 
-void SurfaceFaceVectorQuantity::buildCustomUI() { buildVectorUI(); }
+bool SurfaceFaceVectorQuantity::fitsMeshTopology() { return vectors.size() == parent.faceDataSize; }
 
 void SurfaceFaceVectorQuantity::buildFaceInfoGUI(size_t iF) {
   ImGui::TextUnformatted(name.c_str());
@@ -113,15 +216,31 @@ SurfaceFaceTangentVectorQuantity::SurfaceFaceTangentVectorQuantity(std::string n
 
 void SurfaceFaceTangentVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceFaceTangentVectorQuantity::draw() {
   if (!isEnabled()) return;
-  drawVectors();
+  if (getLICEnabled()) {
+    drawLIC(getVectorColor());
+  } else {
+    drawVectors();
+  }
+}
+
+void SurfaceFaceTangentVectorQuantity::createLICProgram() {
+  licProgram = requestLICProgram("MESH_PROPAGATE_TANGENT_VECTOR");
+  licProgram->setAttribute("a_tangentVector", tangentVectors.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  licProgram->setAttribute("a_basisVectorX", drawBasisX.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  licProgram->setAttribute("a_basisVectorY", drawBasisY.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+}
+
+void SurfaceFaceTangentVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildLICUI();
 }
 
-void SurfaceFaceTangentVectorQuantity::buildCustomUI() { buildVectorUI(); }
+bool SurfaceFaceTangentVectorQuantity::fitsMeshTopology() { return tangentVectors.size() == parent.faceDataSize; }
 
 void SurfaceFaceTangentVectorQuantity::buildFaceInfoGUI(size_t iF) {
   ImGui::TextUnformatted(name.c_str());
@@ -161,16 +280,34 @@ SurfaceVertexTangentVectorQuantity::SurfaceVertexTangentVectorQuantity(
 
 void SurfaceVertexTangentVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceVertexTangentVectorQuantity::draw() {
   if (!isEnabled()) return;
-  drawVectors();
+  if (getLICEnabled()) {
+    drawLIC(getVectorColor());
+  } else {
+    drawVectors();
+  }
+}
+
+void SurfaceVertexTangentVectorQuantity::createLICProgram() {
+  licProgram = requestLICProgram("MESH_PROPAGATE_TANGENT_VECTOR");
+  licProgram->setAttribute("a_tangentVector", parent.getVertexAttributeBuffer(*licProgram, tangentVectors));
+  licProgram->setAttribute("a_basisVectorX", parent.getVertexAttributeBuffer(*licProgram, drawBasisX));
+  licProgram->setAttribute("a_basisVectorY", parent.getVertexAttributeBuffer(*licProgram, drawBasisY));
+}
+
+void SurfaceVertexTangentVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildLICUI();
 }
 
-void SurfaceVertexTangentVectorQuantity::buildCustomUI() { buildVectorUI(); }
 
+bool SurfaceVertexTangentVectorQuantity::fitsMeshTopology() {
+  return tangentVectors.size() == parent.vertexDataSize;
+}
 
 void SurfaceVertexTangentVectorQuantity::buildVertexInfoGUI(size_t iV) {
   ImGui::TextUnformatted(name.c_str());
@@ -219,10 +356,11 @@ std::vector<glm::vec2> oneFormToFaceTangentVectors(SurfaceMesh& mesh, const std:
 
     std::array<float, 3> formValues;
     std::array<glm::vec3, 3> vecValues;
+    size_t iT = mesh.faceTriangleStart(iF);
     for (size_t j = 0; j < 3; j++) {
-      size_t vA = mesh.triangleVertexInds.data[3 * iF + j];
-      size_t vB = mesh.triangleVertexInds.data[3 * iF + ((j + 1) % 3)];
-      size_t iE = mesh.triangleAllEdgeInds.data[9 * iF + j];
+      size_t vA = mesh.triangleVertexInds.data[3 * iT + j];
+      size_t vB = mesh.triangleVertexInds.data[3 * iT + ((j + 1) % 3)];
+      size_t iE = mesh.triangleAllEdgeInds.data[9 * iT + j];
 
       bool isCanonicalOriented = (vB > vA) != (canonicalOrientation[iE]); // TODO double check convention
       double orientationSign = isCanonicalOriented ? 1. : -1.;
@@ -256,21 +394,36 @@ SurfaceOneFormTangentVectorQuantity::SurfaceOneFormTangentVectorQuantity(std::st
     : SurfaceVectorQuantity(name, mesh_, MeshElement::FACE),
       TangentVectorQuantity<SurfaceOneFormTangentVectorQuantity>(
           *this, oneFormToFaceTangentVectors(mesh_, oneForm_, canonicalOrientation_),
-          mesh_.defaultFaceTangentBasisX.getPopulatedHostBufferRef(),
-          mesh_.defaultFaceTangentBasisY.getPopulatedHostBufferRef(), parent.faceCenters, 1, VectorType::STANDARD),
+          mesh_.defaultFaceTangentBasisX, mesh_.defaultFaceTangentBasisY, parent.faceCenters, 1, VectorType::STANDARD),
       oneForm(oneForm_), canonicalOrientation(canonicalOrientation_) {}
 
 void SurfaceOneFormTangentVectorQuantity::refresh() {
   refreshVectors();
-  Quantity::refresh();
+  SurfaceVectorQuantity::refresh();
 }
 
 void SurfaceOneFormTangentVectorQuantity::draw() {
   if (!isEnabled()) return;
-  drawVectors();
+  if (getLICEnabled()) {
+    drawLIC(getVectorColor());
+  } else {
+    drawVectors();
+  }
+}
+
+void SurfaceOneFormTangentVectorQuantity::createLICProgram() {
+  licProgram = requestLICProgram("MESH_PROPAGATE_TANGENT_VECTOR");
+  licProgram->setAttribute("a_tangentVector", tangentVectors.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  licProgram->setAttribute("a_basisVectorX", drawBasisX.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+  licProgram->setAttribute("a_basisVectorY", drawBasisY.getIndexedRenderAttributeBuffer(parent.triangleFaceInds));
+}
+
+void SurfaceOneFormTangentVectorQuantity::buildCustomUI() {
+  buildVectorUI();
+  buildLICUI();
 }
 
-void SurfaceOneFormTangentVectorQuantity::buildCustomUI() { buildVectorUI(); }
+bool SurfaceOneFormTangentVectorQuantity::fitsMeshTopology() { return oneForm.size() == parent.edgeDataSize; }
 
 void SurfaceOneFormTangentVectorQuantity::buildEdgeInfoGUI(size_t iE) {
   ImGui::TextUnformatted(name.c_str());
@@ -0,0 +1,463 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+
+#include "polyscope/polyscope.h"
+
+#include "polyscope/tiled_image_quantity.h"
+
+#include "imgui.h"
+#include "polyscope/render/engine.h"
+#include "polyscope/view.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace polyscope {
+
+
+TiledColorImageQuantity::TiledColorImageQuantity(Structure& parent_, std::string name, size_t dimX, size_t dimY,
+                                                 ImageTileLoader loader_, ImageOrigin imageOrigin_)
+    : ImageQuantity(parent_, name, dimX, dimY, imageOrigin_, TextureFormat::RGBA8), loader(loader_) {
+  if (!loader) {
+    exception("tiled image quantity " + name + " needs a tile loader");
+  }
+  if (dimX == 0 || dimY == 0) {
+    exception("tiled image quantity " + name + " has zero size");
+  }
+}
+
+void TiledColorImageQuantity::draw() {
+  // the texture upload budget starts over each time the scene is drawn
+  uploadsThisFrame = 0;
+  ImageQuantity::draw();
+}
+
+void TiledColorImageQuantity::buildCustomUI() {
+  ImGui::SameLine();
+
+  // == Options popup
+  if (ImGui::Button("Options")) {
+    ImGui::OpenPopup("OptionsPopup");
+  }
+  if (ImGui::BeginPopup("OptionsPopup")) {
+
+    buildImageOptionsUI();
+    ImGui::Text("resident tiles: %zu / %zu", nResidentTiles(), maxResidentTiles);
+
+    ImGui::EndPopup();
+  }
+
+  buildImageUI();
+}
+
+std::string TiledColorImageQuantity::niceName() { return name + " (tiled color image)"; }
+
+bool TiledColorImageQuantity::textureFormatSupported(TextureFormat format) {
+  return format == TextureFormat::RGBA8 || format == TextureFormat::RGBA16F || format == TextureFormat::RGBA32F;
+}
+
+void TiledColorImageQuantity::releaseTextures() {
+  fullscreenProgram.reset();
+  billboardProgram.reset();
+  tiles.clear();
+}
+
+// === Pyramid and tile management
+
+int TiledColorImageQuantity::nLevels() {
+  int n = 1;
+  size_t x = dimX;
+  size_t y = dimY;
+  while (x > tileSize || y > tileSize) {
+    x = (x + 1) / 2;
+    y = (y + 1) / 2;
+    n++;
+  }
+  return n;
+}
+
+size_t TiledColorImageQuantity::levelDimX(int level) {
+  size_t x = dimX;
+  for (int i = 0; i < level; i++) x = (x + 1) / 2;
+  return x;
+}
+
+size_t TiledColorImageQuantity::levelDimY(int level) {
+  size_t y = dimY;
+  for (int i = 0; i < level; i++) y = (y + 1) / 2;
+  return y;
+}
+
+size_t TiledColorImageQuantity::nResidentTiles() { return tiles.size(); }
+
+int TiledColorImageQuantity::levelForScale(float scale) {
+  // the finest level which is not minified, i.e. whose pixels cover at least one screen pixel
+  int level = 0;
+  int maxLevel = nLevels() - 1;
+  while (level < maxLevel && std::ldexp(scale, level) < 1.) level++;
+  return level;
+}
+
+render::TextureBuffer* TiledColorImageQuantity::getTile(int level, size_t tileX, size_t tileY) {
+
+  std::array<size_t, 3> key{static_cast<size_t>(level), tileX, tileY};
+  auto it = tiles.find(key);
+  if (it != tiles.end()) {
+    it->second.lastUsed = ++tileUseCount;
+    return it->second.texture.get();
+  }
+
+  // not resident; fetch it, unless we've already done enough of that this frame
+  if (uploadsThisFrame >= tileUploadsPerFrame) {
+    requestRedraw(); // try again next frame
+    return nullptr;
+  }
+  uploadsThisFrame++;
+
+  size_t x0 = tileX * tileSize;
+  size_t y0 = tileY * tileSize;
+  size_t w = std::min(tileSize, levelDimX(level) - x0);
+  size_t h = std::min(tileSize, levelDimY(level) - y0);
+  std::vector<glm::vec4> pixels;
+  loader(level, x0, y0, w, h, pixels);
+  if (pixels.size() != w * h) {
+    exception("tile loader for " + name + " returned " + std::to_string(pixels.size()) + " pixels, expected " +
+              std::to_string(w * h));
+    return nullptr;
+  }
+
+  Tile& tile = tiles[key];
+  tile.texture = render::engine->generateTextureBuffer(textureFormat, w, h, &(pixels.front()[0]));
+  tile.texture->setMemoryOwner(uniquePrefix() + "tile");
+  tile.texture->setFilterMode(FilterMode::Linear);
+  tile.lastUsed = ++tileUseCount;
+  return tile.texture.get();
+}
+
+void TiledColorImageQuantity::evictTiles() {
+  while (tiles.size() > maxResidentTiles) {
+    auto oldest = tiles.begin();
+    for (auto it = tiles.begin(); it != tiles.end(); it++) {
+      if (it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+    }
+    tiles.erase(oldest);
+  }
+}
+
+std::vector<TiledColorImageQuantity::TileDraw>
+TiledColorImageQuantity::gatherTiles(glm::vec2 regionMin, glm::vec2 regionMax, float scale) {
+
+  std::vector<TileDraw> draws;
+  int level = levelForScale(scale);
+  int topLevel = nLevels() - 1;
+  float levelPix = std::ldexp(1.f, level); // size of a pixel at this level, in level-0 pixels
+  float tileExtent = levelPix * tileSize;
+  size_t nTilesX = (levelDimX(level) + tileSize - 1) / tileSize;
+  size_t nTilesY = (levelDimY(level) + tileSize - 1) / tileSize;
+
+  regionMin = glm::max(regionMin, glm::vec2{0., 0.});
+  regionMax = glm::min(regionMax, glm::vec2(dimX, dimY));
+  if (regionMin.x >= regionMax.x || regionMin.y >= regionMax.y) return draws;
+
+  size_t txMin = static_cast<size_t>(regionMin.x / tileExtent);
+  size_t tyMin = static_cast<size_t>(regionMin.y / tileExtent);
+  size_t txMax = std::min(nTilesX - 1, static_cast<size_t>(regionMax.x / tileExtent));
+  size_t tyMax = std::min(nTilesY - 1, static_cast<size_t>(regionMax.y / tileExtent));
+
+  for (size_t ty = tyMin; ty <= tyMax; ty++) {
+    for (size_t tx = txMin; tx <= txMax; tx++) {
+
+      TileDraw d;
+      d.rectMin = glm::vec2{tx * tileExtent, ty * tileExtent};
+      d.rectMax = glm::min(d.rectMin + tileExtent, glm::vec2(dimX, dimY));
+
+      // Use the tile itself if we can, otherwise the nearest coarser tile which is already resident, otherwise the
+      // top of the pyramid
+      int drawLevel = level;
+      d.texture = getTile(level, tx, ty);
+      for (int coarser = level + 1; d.texture == nullptr && coarser <= topLevel; coarser++) {
+        auto it = tiles.find(std::array<size_t, 3>{static_cast<size_t>(coarser), tx >> (coarser - level),
+                                                   ty >> (coarser - level)});
+        if (it != tiles.end()) {
+          it->second.lastUsed = ++tileUseCount;
+          d.texture = it->second.texture.get();
+          drawLevel = coarser;
+        }
+      }
+      if (d.texture == nullptr && level < topLevel) {
+        d.texture = getTile(topLevel, 0, 0);
+        drawLevel = topLevel;
+      }
+      if (d.texture == nullptr) continue;
+
+      // texture coordinates of the rectangle within whichever tile is drawn
+      int shift = drawLevel - level;
+      glm::vec2 drawTileOrigin{static_cast<float>((tx >> shift) * tileSize),
+                               static_cast<float>((ty >> shift) * tileSize)};
+      glm::vec2 drawTileSize{static_cast<float>(d.texture->getSizeX()), static_cast<float>(d.texture->getSizeY())};
+      float drawPix = std::ldexp(1.f, drawLevel);
+      d.uvMin = (d.rectMin / drawPix - drawTileOrigin) / drawTileSize;
+      d.uvMax = (d.rectMax / drawPix - drawTileOrigin) / drawTileSize;
+
+      draws.push_back(d);
+    }
+  }
+
+  return draws;
+}
+
+// === Drawing
+
+void TiledColorImageQuantity::drawTilesWithProgram(render::ShaderProgram& program, const std::vector<TileDraw>& draws) {
+
+  // Tiles are laid out in the [-1,1]^2 quad covering the image. Texture rows follow the data, so for upper-left origin
+  // images the first row goes at the top.
+  bool upperLeft = imageOrigin == ImageOrigin::UpperLeft;
+  for (const TileDraw& d : draws) {
+    glm::vec2 quadMin = 2.f * d.rectMin / glm::vec2(dimX, dimY) - 1.f;
+    glm::vec2 quadMax = 2.f * d.rectMax / glm::vec2(dimX, dimY) - 1.f;
+    if (upperLeft) {
+      program.setUniform("u_rectMin", glm::vec2{quadMin.x, -quadMax.y});
+      program.setUniform("u_rectMax", glm::vec2{quadMax.x, -quadMin.y});
+      program.setUniform("u_tcoordMin", glm::vec2{d.uvMin.x, d.uvMax.y});
+      program.setUniform("u_tcoordMax", glm::vec2{d.uvMax.x, d.uvMin.y});
+    } else {
+      program.setUniform("u_rectMin", quadMin);
+      program.setUniform("u_rectMax", quadMax);
+      program.setUniform("u_tcoordMin", d.uvMin);
+      program.setUniform("u_tcoordMax", d.uvMax);
+    }
+    program.setTextureFromBuffer("t_image", d.texture);
+    program.draw();
+  }
+}
+
+void TiledColorImageQuantity::showFullscreen() {
+
+  if (!fullscreenProgram) {
+    fullscreenProgram =
+        render::engine->requestShader("TEXTURE_DRAW_PLAIN", {"TEXTURE_RECT_FROM_UNIFORMS", "TEXTURE_SET_TRANSPARENCY"},
+                                      render::ShaderReplacementDefaults::Process);
+    fullscreenProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
+  }
+
+  // the image is stretched over the whole view
+  float scale = std::max(static_cast<float>(view::bufferWidth) / dimX, static_cast<float>(view::bufferHeight) / dimY);
+  std::vector<TileDraw> draws = gatherTiles(glm::vec2{0., 0.}, glm::vec2(dimX, dimY), scale);
+
+  fullscreenProgram->setUniform("u_transparency", getTransparency());
+  drawTilesWithProgram(*fullscreenProgram, draws);
+  evictTiles();
+
+  render::engine->applyTransparencySettings();
+}
+
+void TiledColorImageQuantity::showInImGuiWindow() {
+
+  ImGui::Begin(name.c_str(), nullptr, ImGuiWindowFlags_NoScrollbar);
+
+  float w = ImGui::GetContentRegionAvail().x;
+  float h = w * dimY / dimX;
+  if (w <= 0.) {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text("Dimensions: %zux%zu  zoom: %.1fx", dimX, dimY, windowViewZoom);
+
+  ImVec2 canvasMin = ImGui::GetCursorScreenPos();
+  ImVec2 canvasMax(canvasMin.x + w, canvasMin.y + h);
+  ImGui::InvisibleButton("##tiled_image_canvas", ImVec2(w, h));
+
+  // == Zoom with the scroll wheel (about the mouse) and pan by dragging
+  // (view coordinates here are level-0 pixels as displayed, with y down)
+  ImGuiIO& io = ImGui::GetIO();
+  glm::vec2 dims(dimX, dimY);
+  float maxZoom = std::max(1.f, 16.f * dimX / w); // up to 16 screen pixels per image pixel
+  auto viewScale = [&]() { return w * windowViewZoom / dimX; };
+  auto viewMin = [&]() { return windowViewCenter * dims - 0.5f * dims / windowViewZoom; };
+  if (ImGui::IsItemHovered() && io.MouseWheel != 0.) {
+    glm::vec2 mouse{io.MousePos.x - canvasMin.x, io.MousePos.y - canvasMin.y};
+    glm::vec2 pointUnderMouse = viewMin() + mouse / viewScale();
+    windowViewZoom = glm::clamp(windowViewZoom * std::pow(1.25f, io.MouseWheel), 1.f, maxZoom);
+    windowViewCenter = (pointUnderMouse - mouse / viewScale() + 0.5f * dims / windowViewZoom) / dims;
+  }
+  if (ImGui::IsItemActive() && ImGui::IsMouseDragging(0)) {
+    windowViewCenter -= glm::vec2{io.MouseDelta.x, io.MouseDelta.y} / viewScale() / dims;
+  }
+  float halfExtent = 0.5f / windowViewZoom;
+  windowViewCenter = glm::clamp(windowViewCenter, glm::vec2{halfExtent}, glm::vec2{1.f - halfExtent});
+
+  // == Gather and draw the visible tiles
+  bool upperLeft = imageOrigin == ImageOrigin::UpperLeft;
+  glm::vec2 vMin = viewMin();
+  glm::vec2 vMax = vMin + dims / windowViewZoom;
+  float scale = viewScale();
+  glm::vec2 dataMin = upperLeft ? vMin : glm::vec2{vMin.x, dimY - vMax.y};
+  glm::vec2 dataMax = upperLeft ? vMax : glm::vec2{vMax.x, dimY - vMin.y};
+  std::vector<TileDraw> draws = gatherTiles(dataMin, dataMax, scale);
+
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  drawList->PushClipRect(canvasMin, canvasMax, true);
+  for (const TileDraw& d : draws) {
+    // flip to displayed coordinates
+    glm::vec2 dispMin = upperLeft ? d.rectMin : glm::vec2{d.rectMin.x, dimY - d.rectMax.y};
+    glm::vec2 dispMax = upperLeft ? d.rectMax : glm::vec2{d.rectMax.x, dimY - d.rectMin.y};
+    glm::vec2 pMin = (dispMin - vMin) * scale;
+    glm::vec2 pMax = (dispMax - vMin) * scale;
+    ImVec2 uvTopLeft = upperLeft ? ImVec2(d.uvMin.x, d.uvMin.y) : ImVec2(d.uvMin.x, d.uvMax.y);
+    ImVec2 uvBottomRight = upperLeft ? ImVec2(d.uvMax.x, d.uvMax.y) : ImVec2(d.uvMax.x, d.uvMin.y);
+    drawList->AddImage(d.texture->getNativeHandle(), ImVec2(canvasMin.x + pMin.x, canvasMin.y + pMin.y),
+                       ImVec2(canvasMin.x + pMax.x, canvasMin.y + pMax.y), uvTopLeft, uvBottomRight);
+  }
+  drawList->PopClipRect();
+
+  ImGui::End();
+
+  evictTiles();
+}
+
+void TiledColorImageQuantity::showInBillboard(glm::vec3 center, glm::vec3 upVec, glm::vec3 rightVec) {
+
+  if (!billboardProgram) {
+    billboardProgram = render::engine->requestShader(
+        "TEXTURE_DRAW_PLAIN",
+        {"TEXTURE_RECT_FROM_UNIFORMS", "TEXTURE_SET_TRANSPARENCY", "TEXTURE_BILLBOARD_FROM_UNIFORMS"},
+        render::ShaderReplacementDefaults::Process);
+    billboardProgram->setAttribute("a_position", render::engine->screenTrianglesCoords());
+  }
+
+  // ensure the scale of rightVec matches the aspect ratio of the image
+  rightVec = glm::normalize(rightVec) * glm::length(upVec) * ((float)dimX / dimY);
+
+  // pick the level from the height of the billboard on screen
+  glm::mat4 viewProj = view::getCameraPerspectiveMatrix() * parent.getModelView();
+  glm::vec4 pBottom = viewProj * glm::vec4(center - upVec, 1.);
+  glm::vec4 pTop = viewProj * glm::vec4(center + upVec, 1.);
+  float scale = 0.;
+  if (pBottom.w > 0. && pTop.w > 0.) {
+    glm::vec2 ndcDiff = glm::vec2(pTop) / pTop.w - glm::vec2(pBottom) / pBottom.w;
+    float pixelHeight = glm::length(0.5f * ndcDiff * glm::vec2{view::bufferWidth, view::bufferHeight});
+    scale = pixelHeight / dimY;
+  }
+  std::vector<TileDraw> draws = gatherTiles(glm::vec2{0., 0.}, glm::vec2(dimX, dimY), scale);
+
+  // set uniforms
+  parent.setStructureUniforms(*billboardProgram);
+  billboardProgram->setUniform("u_transparency", getTransparency());
+  billboardProgram->setUniform("u_billboardCenter", center);
+  billboardProgram->setUniform("u_billboardUp", upVec);
+  billboardProgram->setUniform("u_billboardRight", rightVec);
+
+  render::engine->setBackfaceCull(false);
+  render::engine->setBlendMode(BlendMode::AlphaOver);
+  drawTilesWithProgram(*billboardProgram, draws);
+  render::engine->setBackfaceCull(); // return to default setting
+  render::engine->applyTransparencySettings();
+  evictTiles();
+}
+
+void TiledColorImageQuantity::refresh() {
+  fullscreenProgram.reset();
+  billboardProgram.reset();
+  Quantity::refresh();
+}
+
+// === Setters and getters
+
+TiledColorImageQuantity* TiledColorImageQuantity::setEnabled(bool newEnabled) {
+  if (newEnabled == isEnabled()) return this;
+  if (newEnabled == true && getShowFullscreen()) {
+    // if drawing fullscreen, disable anything else which was already drawing fullscreen
+    disableAllFullscreenArtists();
+  }
+  enabled = newEnabled;
+  requestRedraw();
+  return this;
+}
+
+void TiledColorImageQuantity::setTileSize(size_t newVal) {
+  if (newVal == 0) {
+    exception("tile size must be positive");
+    return;
+  }
+  tileSize = newVal;
+  tiles.clear();
+  requestRedraw();
+}
+size_t TiledColorImageQuantity::getTileSize() { return tileSize; }
+
+void TiledColorImageQuantity::setMaxResidentTiles(size_t newVal) {
+  maxResidentTiles = newVal;
+  evictTiles();
+}
+size_t TiledColorImageQuantity::getMaxResidentTiles() { return maxResidentTiles; }
+
+void TiledColorImageQuantity::setTileUploadsPerFrame(size_t newVal) { tileUploadsPerFrame = newVal; }
+size_t TiledColorImageQuantity::getTileUploadsPerFrame() { return tileUploadsPerFrame; }
+
+void TiledColorImageQuantity::setWindowView(glm::vec2 center, float zoom) {
+  windowViewCenter = center;
+  windowViewZoom = std::max(zoom, 1.f);
+}
+glm::vec2 TiledColorImageQuantity::getWindowViewCenter() { return windowViewCenter; }
+float TiledColorImageQuantity::getWindowViewZoom() { return windowViewZoom; }
+
+
+ImageTileLoader createImagePyramidTileLoader(size_t dimX, size_t dimY, const std::vector<glm::vec4>& data) {
+
+  struct Pyramid {
+    std::vector<size_t> dimX, dimY;
+    std::vector<std::vector<glm::vec4>> levels;
+  };
+  std::shared_ptr<Pyramid> pyramid = std::make_shared<Pyramid>();
+  pyramid->dimX.push_back(dimX);
+  pyramid->dimY.push_back(dimY);
+  pyramid->levels.push_back(data);
+
+  return [pyramid](int level, size_t x0, size_t y0, size_t w, size_t h, std::vector<glm::vec4>& pixels) {
+    // build coarser levels as needed, each pixel the average of the (up to) four beneath it
+    while (static_cast<int>(pyramid->levels.size()) <= level) {
+      const std::vector<glm::vec4>& fine = pyramid->levels.back();
+      size_t fx = pyramid->dimX.back();
+      size_t fy = pyramid->dimY.back();
+      size_t cx = (fx + 1) / 2;
+      size_t cy = (fy + 1) / 2;
+      std::vector<glm::vec4> coarse(cx * cy);
+      for (size_t j = 0; j < cy; j++) {
+        for (size_t i = 0; i < cx; i++) {
+          glm::vec4 sum{0., 0., 0., 0.};
+          float count = 0.;
+          for (size_t sj = 2 * j; sj < std::min(2 * j + 2, fy); sj++) {
+            for (size_t si = 2 * i; si < std::min(2 * i + 2, fx); si++) {
+              sum += fine[sj * fx + si];
+              count += 1.;
+            }
+          }
+          coarse[j * cx + i] = sum / count;
+        }
+      }
+      pyramid->dimX.push_back(cx);
+      pyramid->dimY.push_back(cy);
+      pyramid->levels.push_back(std::move(coarse));
+    }
+
+    const std::vector<glm::vec4>& src = pyramid->levels[level];
+    size_t srcDimX = pyramid->dimX[level];
+    pixels.resize(w * h);
+    for (size_t j = 0; j < h; j++) {
+      for (size_t i = 0; i < w; i++) {
+        pixels[j * w + i] = src[(y0 + j) * srcDimX + (x0 + i)];
+      }
+    }
+  };
+}
+
+// Instantiate a construction helper which is used to avoid header dependencies. See forward declaration and note in
+// structure.ipp.
+TiledColorImageQuantity* createTiledColorImageQuantity(Structure& parent, std::string name, size_t dimX, size_t dimY,
+                                                       ImageTileLoader loader, ImageOrigin imageOrigin) {
+  return new TiledColorImageQuantity(parent, name, dimX, dimY, loader, imageOrigin);
+}
+
+} // namespace polyscope
@@ -22,6 +22,14 @@ void TransformationGizmo::markUpdated() {
   }
 }
 
+void TransformationGizmo::requestRedraw() {
+  if (requestRedrawCallback) {
+    requestRedrawCallback();
+  } else {
+    polyscope::requestRedraw();
+  }
+}
+
 void TransformationGizmo::prepare() {
 
   { // The rotation rings, drawn via textured quads
@@ -89,11 +97,6 @@ void TransformationGizmo::draw() {
   arrowProgram->setUniform("u_modelView", glm::value_ptr(viewMat));
   sphereProgram->setUniform("u_modelView", glm::value_ptr(viewMat));
 
-  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
-  ringProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-  arrowProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-  sphereProgram->setUniform("u_projMatrix", glm::value_ptr(projMat));
-
   ringProgram->setUniform("u_diskWidthRel", diskWidthObj);
 
   // set selections
@@ -112,16 +115,9 @@ void TransformationGizmo::draw() {
     sphereColor = glm::vec3(0.95);
   }
 
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  arrowProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  arrowProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
   arrowProgram->setUniform("u_lengthMult", vecLength);
   arrowProgram->setUniform("u_radius", 0.2 * gizmoSize);
 
-  sphereProgram->setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  sphereProgram->setUniform("u_viewport", render::engine->getCurrentViewport());
-
   sphereProgram->setUniform("u_pointRadius", sphereRad * gizmoSize);
   sphereProgram->setUniform("u_baseColor", sphereColor);
 
@@ -192,7 +188,7 @@ bool TransformationGizmo::interact() {
         T = glm::rotate(angle, normal) * T;
         T[3] = trans;
         markUpdated();
-        polyscope::requestRedraw();
+        requestRedraw();
 
         dragPrevVec = nearestDir; // store this dir for the next time around
       }
@@ -215,7 +211,7 @@ bool TransformationGizmo::interact() {
         T[3][1] += trans.y;
         T[3][2] += trans.z;
         markUpdated();
-        polyscope::requestRedraw();
+        requestRedraw();
 
         dragPrevVec = nearestPoint; // store this dir for the next time around
       }
@@ -241,7 +237,7 @@ bool TransformationGizmo::interact() {
         T *= scaleRatio;
         T[3] = trans;
         markUpdated();
-        polyscope::requestRedraw();
+        requestRedraw();
 
         dragPrevVec = nearestPoint; // store this dir for the next time around
       }
@@ -4,11 +4,14 @@
 
 
 #include <cmath>
+#include <limits>
+#include <mutex>
 #include <vector>
 
 #include "imgui.h"
 
 #include "polyscope/messages.h"
+#include "polyscope/parallel.h"
 
 
 namespace polyscope {
@@ -52,6 +55,80 @@ std::tuple<std::string, std::string> splitExt(std::string f) {
   return std::tuple<std::string, std::string>{f.substr(0, p), f.substr(p, std::string::npos)};
 }
 
+namespace {
+
+// The bounds are accumulated over the coordinates as a flat array of floats, a few points at a time, so that each lane
+// of the accumulators always holds the same coordinate and the loop maps directly to packed min/max instructions
+// (without needing -ffast-math, as reducing in to a single value would).
+const size_t BOUNDS_POINTS_PER_STEP = 8;
+const size_t BOUNDS_LANES = 3 * BOUNDS_POINTS_PER_STEP;
+
+void accumulateBounds(const float* coords, size_t nPoints, float* lo, float* hi) {
+  size_t nSteps = nPoints / BOUNDS_POINTS_PER_STEP;
+  for (size_t iStep = 0; iStep < nSteps; iStep++) {
+    const float* c = coords + iStep * BOUNDS_LANES;
+    for (size_t j = 0; j < BOUNDS_LANES; j++) {
+      lo[j] = std::min(lo[j], c[j]);
+      hi[j] = std::max(hi[j], c[j]);
+    }
+  }
+  for (size_t j = nSteps * BOUNDS_LANES; j < 3 * nPoints; j++) {
+    lo[j % 3] = std::min(lo[j % 3], coords[j]);
+    hi[j % 3] = std::max(hi[j % 3], coords[j]);
+  }
+}
+
+float maxSquaredDistance(const glm::vec3* points, size_t nPoints, const glm::vec3& center) {
+  float dist2[BOUNDS_POINTS_PER_STEP] = {};
+  size_t nSteps = nPoints / BOUNDS_POINTS_PER_STEP;
+  for (size_t iStep = 0; iStep < nSteps; iStep++) {
+    const glm::vec3* p = points + iStep * BOUNDS_POINTS_PER_STEP;
+    for (size_t k = 0; k < BOUNDS_POINTS_PER_STEP; k++) {
+      float dx = p[k].x - center.x;
+      float dy = p[k].y - center.y;
+      float dz = p[k].z - center.z;
+      dist2[k] = std::max(dist2[k], dx * dx + dy * dy + dz * dz);
+    }
+  }
+  for (size_t i = nSteps * BOUNDS_POINTS_PER_STEP; i < nPoints; i++) {
+    glm::vec3 d = points[i] - center;
+    dist2[0] = std::max(dist2[0], glm::dot(d, d));
+  }
+  return *std::max_element(dist2, dist2 + BOUNDS_POINTS_PER_STEP);
+}
+
+} // namespace
+
+void computeBoundsAndLengthScale(const glm::vec3* points, size_t n, glm::vec3& min, glm::vec3& max,
+                                 float& lengthScale) {
+  const float inf = std::numeric_limits<float>::infinity();
+  std::mutex mutex;
+
+  min = glm::vec3{inf, inf, inf};
+  max = glm::vec3{-inf, -inf, -inf};
+  parallelFor(0, n, [&](size_t start, size_t end) {
+    float lo[BOUNDS_LANES], hi[BOUNDS_LANES];
+    std::fill(lo, lo + BOUNDS_LANES, inf);
+    std::fill(hi, hi + BOUNDS_LANES, -inf);
+    accumulateBounds(&points[start].x, end - start, lo, hi);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t j = 0; j < BOUNDS_LANES; j++) {
+      min[j % 3] = std::min(min[j % 3], lo[j]);
+      max[j % 3] = std::max(max[j % 3], hi[j]);
+    }
+  });
+
+  glm::vec3 center = 0.5f * (min + max);
+  float dist2 = 0.;
+  parallelFor(0, n, [&](size_t start, size_t end) {
+    float blockDist2 = maxSquaredDistance(points + start, end - start, center);
+    std::lock_guard<std::mutex> lock(mutex);
+    dist2 = std::max(dist2, blockDist2);
+  });
+  lengthScale = 2 * std::sqrt(dist2);
+}
+
 void splitTransform(const glm::mat4& trans, glm::mat3x4& R, glm::vec3& T) {
   for (int i = 0; i < 3; i++) {
     for (int j = 0; j < 4; j++) {
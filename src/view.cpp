@@ -33,6 +33,9 @@ double fov = defaultFov;
 double nearClipRatio = defaultNearClipRatio;
 double farClipRatio = defaultFarClipRatio;
 ProjectionMode projectionMode = ProjectionMode::Perspective;
+glm::vec2 projectionJitter{0., 0.};
+glm::ivec2 projectionTileOffset{0, 0};
+glm::ivec2 projectionTileImageSize{0, 0};
 std::array<float, 4> bgColor{{1.0, 1.0, 1.0, 0.0}};
 
 glm::mat4x4 viewMat;
@@ -171,7 +174,7 @@ void processRotate(glm::vec2 startP, glm::vec2 endP) {
   }
 
 
-  requestRedraw();
+  internal::requestViewRedraw();
   immediatelyEndFlight();
 }
 
@@ -182,7 +185,7 @@ void processRotateArcball(glm::vec2 startP, glm::vec2 endP) {
   }
 
 
-  requestRedraw();
+  internal::requestViewRedraw();
   immediatelyEndFlight();
 }
 
@@ -195,7 +198,7 @@ void processTranslate(glm::vec2 delta) {
   glm::mat4x4 camSpaceT = glm::translate(glm::mat4x4(1.0), movementScale * glm::vec3(delta.x, delta.y, 0.0));
   viewMat = camSpaceT * viewMat;
 
-  requestRedraw();
+  internal::requestViewRedraw();
   immediatelyEndFlight();
 }
 
@@ -203,7 +206,7 @@ void processClipPlaneShift(double amount) {
   if (amount == 0.0) return;
   // Adjust the near clipping plane
   nearClipRatio += .03 * amount * nearClipRatio;
-  requestRedraw();
+  internal::requestViewRedraw();
 }
 
 void processZoom(double amount) {
@@ -228,7 +231,7 @@ void processZoom(double amount) {
 
 
   immediatelyEndFlight();
-  requestRedraw();
+  internal::requestViewRedraw();
 }
 
 void invalidateView() { viewMat = glm::mat4x4(std::numeric_limits<float>::quiet_NaN()); }
@@ -288,7 +291,7 @@ void resetCameraToHomeView() {
   nearClipRatio = defaultNearClipRatio;
   farClipRatio = defaultFarClipRatio;
 
-  requestRedraw();
+  internal::requestViewRedraw();
 }
 
 void flyToHomeView() {
@@ -331,7 +334,7 @@ void lookAt(glm::vec3 cameraLocation, glm::vec3 target, glm::vec3 upDir, bool fl
     startFlightTo(targetView, fov);
   } else {
     viewMat = targetView;
-    requestRedraw();
+    internal::requestViewRedraw();
   }
 }
 
@@ -367,15 +370,30 @@ glm::mat4 getCameraPerspectiveMatrix() {
   double nearClip = nearClipRatio * state::lengthScale;
   double fovRad = glm::radians(fov);
   double aspectRatio = (float)bufferWidth / bufferHeight;
+  glm::mat4 jitter = glm::translate(glm::mat4(1.0f), glm::vec3(projectionJitter, 0.f));
+
+  // For a tile, stretch its rectangle of the whole image's normalized device coordinates over the buffer
+  glm::mat4 tile(1.0f);
+  if (projectionTileImageSize.x > 0 && projectionTileImageSize.y > 0) {
+    aspectRatio = (float)projectionTileImageSize.x / projectionTileImageSize.y;
+    glm::vec2 imageSize(projectionTileImageSize);
+    glm::vec2 tileMin(projectionTileOffset);
+    glm::vec2 tileMax = tileMin + glm::vec2(bufferWidth, bufferHeight);
+    glm::vec2 ndcMin = 2.f * tileMin / imageSize - 1.f;
+    glm::vec2 ndcMax = 2.f * tileMax / imageSize - 1.f;
+    tile = glm::scale(glm::mat4(1.0f), glm::vec3(2.f / (ndcMax - ndcMin), 1.f)) *
+           glm::translate(glm::mat4(1.0f), glm::vec3(-0.5f * (ndcMin + ndcMax), 0.f));
+  }
+
   switch (projectionMode) {
   case ProjectionMode::Perspective: {
-    return glm::perspective(fovRad, aspectRatio, nearClip, farClip);
+    return jitter * tile * glm::mat4(glm::perspective(fovRad, aspectRatio, nearClip, farClip));
     break;
   }
   case ProjectionMode::Orthographic: {
     double vert = tan(fovRad / 2.) * state::lengthScale * 2.;
     double horiz = vert * aspectRatio;
-    return glm::ortho(-horiz, horiz, -vert, vert, nearClip, farClip);
+    return jitter * tile * glm::mat4(glm::ortho(-horiz, horiz, -vert, vert, nearClip, farClip));
     break;
   }
   }
@@ -517,7 +535,7 @@ void updateFlight() {
       // linear spline
       fov = (1.0f - t) * flightInitialFov + t * flightTargetFov;
     }
-    requestRedraw(); // flight is still happening, draw again next frame
+    internal::requestViewRedraw(); // flight is still happening, draw again next frame
   }
 }
 
@@ -619,7 +637,7 @@ void setViewFromJson(std::string jsonData, bool flyTo) {
   } else {
     viewMat = newViewMat;
     fov = newFov;
-    requestRedraw();
+    internal::requestViewRedraw();
   }
 }
 void setCameraFromJson(std::string jsonData, bool flyTo) { setViewFromJson(jsonData, flyTo); }
@@ -832,7 +850,7 @@ void buildViewGui() {
       float fovF = fov;
       if (ImGui::SliderFloat(" Field of View", &fovF, minFov, maxFov, "%.2f deg")) {
         fov = fovF;
-        requestRedraw();
+        internal::requestViewRedraw();
       };
 
       // Clip planes
@@ -841,12 +859,12 @@ void buildViewGui() {
       if (ImGui::SliderFloat(" Clip Near", &nearClipRatioF, 0., 10., "%.5f",
                              ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
         nearClipRatio = nearClipRatioF;
-        requestRedraw();
+        internal::requestViewRedraw();
       }
       if (ImGui::SliderFloat(" Clip Far", &farClipRatioF, 1., 1000., "%.2f",
                              ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
         farClipRatio = farClipRatioF;
-        requestRedraw();
+        internal::requestViewRedraw();
       }
 
       // Move speed
@@ -860,12 +878,12 @@ void buildViewGui() {
       if (ImGui::BeginCombo("##ProjectionMode", projectionModeStr.c_str())) {
         if (ImGui::Selectable("Perspective", view::projectionMode == ProjectionMode::Perspective)) {
           view::projectionMode = ProjectionMode::Perspective;
-          requestRedraw();
+          internal::requestViewRedraw();
           ImGui::SetItemDefaultFocus();
         }
         if (ImGui::Selectable("Orthographic", view::projectionMode == ProjectionMode::Orthographic)) {
           view::projectionMode = ProjectionMode::Orthographic;
-          requestRedraw();
+          internal::requestViewRedraw();
           ImGui::SetItemDefaultFocus();
         }
         ImGui::EndCombo();
@@ -958,7 +976,7 @@ void setFrontDir(FrontDir newFrontDir, bool animateFlight) {
   } else {
     resetCameraToHomeView();
   }
-  requestRedraw();
+  internal::requestViewRedraw();
 }
 
 FrontDir getFrontDir() { return frontDir; }
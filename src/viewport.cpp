@@ -0,0 +1,157 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/viewport.h"
+
+#include "polyscope/polyscope.h"
+#include "polyscope/view.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+
+namespace polyscope {
+
+Viewport::Viewport(std::string name_, const CameraParameters& camera_, ProjectionMode projectionMode_)
+    : name(name_), camera(camera_), projectionMode(projectionMode_) {}
+
+void Viewport::buildGUI(float width) {
+  ImGui::PushID(name.c_str());
+  ImGui::BeginGroup();
+  ImGui::TextUnformatted(name.c_str());
+  if (colorTexture) {
+    float height = width * colorTexture->getSizeY() / colorTexture->getSizeX();
+    ImGui::Image(colorTexture->getNativeHandle(), ImVec2(width, height), ImVec2(0, 1), ImVec2(1, 0));
+  } else {
+    ImGui::Dummy(ImVec2(width, width * view::bufferHeight / std::max(view::bufferWidth, 1)));
+  }
+  ImGui::EndGroup();
+  ImGui::PopID();
+}
+
+void Viewport::setCamera(const CameraParameters& newCamera) {
+  camera = newCamera;
+  cameraChanged = true;
+}
+CameraParameters Viewport::getCamera() { return camera; }
+
+void Viewport::setProjectionMode(ProjectionMode newMode) {
+  projectionMode = newMode;
+  cameraChanged = true;
+}
+ProjectionMode Viewport::getProjectionMode() { return projectionMode; }
+
+void Viewport::setEnabled(bool newVal) { enabled = newVal; }
+bool Viewport::isEnabled() { return enabled; }
+
+render::TextureBuffer* Viewport::getColorTexture() { return colorTexture.get(); }
+
+bool Viewport::needsRender() {
+  if (!enabled) return false;
+  if (!colorTexture || cameraChanged || lastSceneContentVersion != internal::sceneContentVersion) return true;
+  return colorTexture->getSizeX() != static_cast<unsigned int>(view::bufferWidth) ||
+         colorTexture->getSizeY() != static_cast<unsigned int>(view::bufferHeight);
+}
+
+void Viewport::beginRender() {
+  savedViewMat = view::viewMat;
+  savedFov = view::fov;
+  savedProjectionMode = view::projectionMode;
+
+  view::setViewToCamera(camera);
+  view::projectionMode = projectionMode;
+}
+
+void Viewport::endRender() {
+  unsigned int w = view::bufferWidth;
+  unsigned int h = view::bufferHeight;
+  if (!colorTexture) {
+    colorTexture = render::engine->generateTextureBuffer(TextureFormat::RGBA8, w, h);
+    framebuffer = render::engine->generateFrameBuffer(w, h);
+    framebuffer->addColorBuffer(colorTexture);
+    framebuffer->setDrawBuffers();
+  } else if (colorTexture->getSizeX() != w || colorTexture->getSizeY() != h) {
+    // resize in place, the texture may already be referenced by this frame's GUI
+    framebuffer->resize(w, h);
+  }
+  framebuffer->setViewport(0, 0, w, h);
+
+  framebuffer->bindForRendering();
+  framebuffer->clearColor = {view::bgColor[0], view::bgColor[1], view::bgColor[2]};
+  framebuffer->clearAlpha = view::bgColor[3];
+  framebuffer->clear();
+  render::engine->applyLightingTransform(render::engine->sceneColorFinal);
+
+  view::viewMat = savedViewMat;
+  view::fov = savedFov;
+  view::projectionMode = savedProjectionMode;
+
+  cameraChanged = false;
+  lastSceneContentVersion = internal::sceneContentVersion;
+  renderCount++;
+}
+
+Viewport* addViewport(std::string name, const CameraParameters& camera, ProjectionMode projectionMode) {
+  if (hasViewport(name)) {
+    exception("Attempted to add viewport with name " + name + ", but a viewport with that name already exists");
+    return nullptr;
+  }
+  state::viewports.push_back(new Viewport(name, camera, projectionMode));
+  return state::viewports.back();
+}
+
+Viewport* getViewport(std::string name) {
+  for (Viewport* v : state::viewports) {
+    if (v->name == name) return v;
+  }
+  exception("No viewport with name " + name);
+  return nullptr;
+}
+
+bool hasViewport(std::string name) {
+  for (Viewport* v : state::viewports) {
+    if (v->name == name) return true;
+  }
+  return false;
+}
+
+void removeViewport(std::string name, bool errorIfAbsent) {
+  for (size_t i = 0; i < state::viewports.size(); i++) {
+    if (state::viewports[i]->name == name) {
+      delete state::viewports[i];
+      state::viewports.erase(state::viewports.begin() + i);
+      return;
+    }
+  }
+  if (errorIfAbsent) {
+    exception("No viewport with name " + name + " to remove");
+  }
+}
+
+void removeAllViewports() {
+  for (Viewport* v : state::viewports) {
+    delete v;
+  }
+  state::viewports.clear();
+}
+
+void buildViewportsGui() {
+  std::vector<Viewport*> shown;
+  for (Viewport* v : state::viewports) {
+    if (v->isEnabled()) shown.push_back(v);
+  }
+  if (shown.empty()) return;
+
+  ImGui::SetNextWindowSize(ImVec2(600, 500), ImGuiCond_FirstUseEver);
+  if (ImGui::Begin("Viewports")) {
+    // two viewports per row, e.g. a 2x2 grid of top/front/side/perspective views
+    float spacing = ImGui::GetStyle().ItemSpacing.x;
+    float width = std::max((ImGui::GetContentRegionAvail().x - spacing) / 2.f, 16.f);
+    for (size_t i = 0; i < shown.size(); i++) {
+      if (i % 2 == 1) ImGui::SameLine();
+      shown[i]->buildGUI(width);
+    }
+  }
+  ImGui::End();
+}
+
+} // namespace polyscope
@@ -0,0 +1,352 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/volume_brick_pyramid.h"
+
+#include "polyscope/messages.h"
+#include "polyscope/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace polyscope {
+
+const size_t VolumeBrickPyramid::brickSize;
+
+// A whole file, mapped read-only. The OS pages it in on demand, which is what lets the full-resolution level be far
+// larger than memory.
+class VolumeBrickPyramid::MappedFile {
+public:
+  MappedFile(const std::string& filename) {
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr != MAP_FAILED) {
+        mapped = static_cast<const unsigned char*>(ptr);
+        mappedBytes = st.st_size;
+      }
+    }
+    close(fd); // the mapping stays valid
+#else
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+      HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping != nullptr) {
+        void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (ptr != nullptr) {
+          mapped = static_cast<const unsigned char*>(ptr);
+          mappedBytes = static_cast<size_t>(size.QuadPart);
+        }
+        CloseHandle(mapping); // the view stays valid
+      }
+    }
+    CloseHandle(file);
+#endif
+  }
+
+  ~MappedFile() {
+    if (mapped == nullptr) return;
+#ifndef _WIN32
+    munmap(const_cast<unsigned char*>(mapped), mappedBytes);
+#else
+    UnmapViewOfFile(mapped);
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const unsigned char* mapped = nullptr;
+  size_t mappedBytes = 0;
+};
+
+namespace {
+
+// Pyramid file layout: this header, then levels 1, 2, ... as raw floats laid out like the full-resolution data
+const char pyramidFileMagic[8] = {'P', 'S', 'P', 'Y', 'R', 'M', 'D', '\0'};
+const uint32_t pyramidFileVersion = 1;
+const size_t pyramidHeaderBytes = 128;
+
+struct PyramidHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t nLevels;
+  uint64_t steps[3];
+  uint64_t rawHeaderBytes;
+  uint64_t rawBytes;  // to notice if the raw file changes
+  int64_t rawModTime; // "
+  float dataMin;
+  float dataMax;
+};
+static_assert(sizeof(PyramidHeader) <= pyramidHeaderBytes, "pyramid header too large");
+
+size_t countOf(const std::array<size_t, 3>& s) { return s[0] * s[1] * s[2]; }
+
+bool statFile(const std::string& filename, uint64_t& bytes, int64_t& modTime) {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) return false;
+  bytes = static_cast<uint64_t>(st.st_size);
+  modTime = static_cast<int64_t>(st.st_mtime);
+  return true;
+}
+
+// One level down: node i of the output is centered on node 2i of the input, renormalizing the weights on the boundary
+void writeDownsampledLevel(const float* src, std::array<size_t, 3> srcSteps, std::array<size_t, 3> dstSteps,
+                           std::ofstream& out) {
+  const float weights[3] = {0.25f, 0.5f, 0.25f};
+  std::vector<float> plane(dstSteps[1] * dstSteps[2]);
+  for (size_t iX = 0; iX < dstSteps[0]; iX++) {
+    parallelFor(
+        0, dstSteps[1],
+        [&](size_t start, size_t end) {
+          for (size_t iY = start; iY < end; iY++) {
+            for (size_t iZ = 0; iZ < dstSteps[2]; iZ++) {
+              float sum = 0.f;
+              float wSum = 0.f;
+              for (int a = -1; a <= 1; a++) {
+                int64_t sX = 2 * static_cast<int64_t>(iX) + a;
+                if (sX < 0 || sX >= static_cast<int64_t>(srcSteps[0])) continue;
+                for (int b = -1; b <= 1; b++) {
+                  int64_t sY = 2 * static_cast<int64_t>(iY) + b;
+                  if (sY < 0 || sY >= static_cast<int64_t>(srcSteps[1])) continue;
+                  const float* row = src + (sX * srcSteps[1] + sY) * srcSteps[2];
+                  for (int c = -1; c <= 1; c++) {
+                    int64_t sZ = 2 * static_cast<int64_t>(iZ) + c;
+                    if (sZ < 0 || sZ >= static_cast<int64_t>(srcSteps[2])) continue;
+                    float w = weights[a + 1] * weights[b + 1] * weights[c + 1];
+                    sum += w * row[sZ];
+                    wSum += w;
+                  }
+                }
+              }
+              plane[iY * dstSteps[2] + iZ] = sum / wSum;
+            }
+          }
+        },
+        16);
+    out.write(reinterpret_cast<const char*>(plane.data()), plane.size() * sizeof(float));
+  }
+}
+
+} // namespace
+
+
+VolumeBrickPyramid::VolumeBrickPyramid(std::string filename_, std::array<size_t, 3> steps_, size_t headerBytes_)
+    : filename(filename_), headerBytes(headerBytes_), dataRange(0.f, 1.f) {
+
+  for (size_t d = 0; d < 3; d++) {
+    if (steps_[d] < 2) {
+      exception("volume " + filename + " must have at least 2 nodes along each axis");
+      return;
+    }
+  }
+  if (headerBytes % sizeof(float) != 0) {
+    exception("volume " + filename + " header size must be a multiple of 4 bytes");
+    return;
+  }
+
+  rawFile.reset(new MappedFile(filename));
+  if (rawFile->mapped == nullptr) {
+    exception("could not map volume file " + filename);
+    return;
+  }
+  size_t expectedBytes = headerBytes + countOf(steps_) * sizeof(float);
+  if (rawFile->mappedBytes != expectedBytes) {
+    exception("volume file " + filename + " has " + std::to_string(rawFile->mappedBytes) + " bytes, expected " +
+              std::to_string(expectedBytes) + " for the given size");
+    return;
+  }
+
+  // Halve until the level fits in one brick
+  steps.push_back(steps_);
+  while (std::max(std::max(steps.back()[0], steps.back()[1]), steps.back()[2]) > brickSize + 1) {
+    std::array<size_t, 3> s = steps.back();
+    for (size_t d = 0; d < 3; d++) {
+      s[d] = (s[d] - 1) / 2 + 1;
+    }
+    steps.push_back(s);
+  }
+
+  if (!loadPyramid()) {
+    buildPyramid();
+    built = true;
+    if (!loadPyramid()) {
+      exception("could not write the level-of-detail pyramid for " + filename + " to " + pyramidFilename(filename));
+      return;
+    }
+  }
+}
+
+VolumeBrickPyramid::~VolumeBrickPyramid() {}
+
+std::string VolumeBrickPyramid::pyramidFilename(const std::string& rawFilename) { return rawFilename + ".pspyramid"; }
+
+bool VolumeBrickPyramid::loadPyramid() {
+  uint64_t rawBytes;
+  int64_t rawModTime;
+  if (!statFile(filename, rawBytes, rawModTime)) return false;
+
+  std::unique_ptr<MappedFile> file(new MappedFile(pyramidFilename(filename)));
+  if (file->mapped == nullptr || file->mappedBytes < pyramidHeaderBytes) return false;
+
+  PyramidHeader header;
+  std::memcpy(&header, file->mapped, sizeof(PyramidHeader));
+  if (std::memcmp(header.magic, pyramidFileMagic, sizeof(pyramidFileMagic)) != 0) return false;
+  if (header.version != pyramidFileVersion || header.nLevels != steps.size()) return false;
+  for (size_t d = 0; d < 3; d++) {
+    if (header.steps[d] != steps[0][d]) return false;
+  }
+  if (header.rawHeaderBytes != headerBytes || header.rawBytes != rawBytes || header.rawModTime != rawModTime) {
+    return false;
+  }
+
+  size_t expectedBytes = pyramidHeaderBytes;
+  for (size_t iLevel = 1; iLevel < steps.size(); iLevel++) {
+    expectedBytes += countOf(steps[iLevel]) * sizeof(float);
+  }
+  if (file->mappedBytes != expectedBytes) return false;
+
+  levels.clear();
+  levels.push_back(reinterpret_cast<const float*>(rawFile->mapped + headerBytes));
+  size_t offset = pyramidHeaderBytes;
+  for (size_t iLevel = 1; iLevel < steps.size(); iLevel++) {
+    levels.push_back(reinterpret_cast<const float*>(file->mapped + offset));
+    offset += countOf(steps[iLevel]) * sizeof(float);
+  }
+  dataRange = std::make_pair(header.dataMin, header.dataMax);
+  pyramidFile = std::move(file);
+  return true;
+}
+
+void VolumeBrickPyramid::buildPyramid() {
+  const float* data = reinterpret_cast<const float*>(rawFile->mapped + headerBytes);
+
+  // Data range, in one streaming pass
+  const size_t chunkSize = 1 << 20;
+  size_t nValues = countOf(steps[0]);
+  size_t nChunks = (nValues + chunkSize - 1) / chunkSize;
+  std::vector<float> chunkMin(nChunks, std::numeric_limits<float>::infinity());
+  std::vector<float> chunkMax(nChunks, -std::numeric_limits<float>::infinity());
+  parallelFor(
+      0, nChunks,
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          for (size_t i = iC * chunkSize; i < std::min(nValues, (iC + 1) * chunkSize); i++) {
+            if (!std::isfinite(data[i])) continue;
+            chunkMin[iC] = std::min(chunkMin[iC], data[i]);
+            chunkMax[iC] = std::max(chunkMax[iC], data[i]);
+          }
+        }
+      },
+      1);
+  float vMin = *std::min_element(chunkMin.begin(), chunkMin.end());
+  float vMax = *std::max_element(chunkMax.begin(), chunkMax.end());
+  if (!(vMin <= vMax)) {
+    vMin = 0.f;
+    vMax = 1.f;
+  }
+
+  PyramidHeader header;
+  std::memset(&header, 0, sizeof(PyramidHeader));
+  std::memcpy(header.magic, pyramidFileMagic, sizeof(pyramidFileMagic));
+  header.version = pyramidFileVersion;
+  header.nLevels = static_cast<uint32_t>(steps.size());
+  for (size_t d = 0; d < 3; d++) {
+    header.steps[d] = steps[0][d];
+  }
+  header.rawHeaderBytes = headerBytes;
+  statFile(filename, header.rawBytes, header.rawModTime);
+  header.dataMin = vMin;
+  header.dataMax = vMax;
+
+  // Write to a temporary file, so a partial pyramid is never mistaken for a complete one. Each level is computed from
+  // the one before, which is mapped back in once written.
+  std::string finalName = pyramidFilename(filename);
+  std::string tmpName = finalName + ".tmp";
+  {
+    std::ofstream out(tmpName, std::ios::binary | std::ios::trunc);
+    std::vector<char> headerBlock(pyramidHeaderBytes, 0);
+    std::memcpy(headerBlock.data(), &header, sizeof(PyramidHeader));
+    out.write(headerBlock.data(), headerBlock.size());
+    if (!out) return;
+  }
+  size_t prevOffset = 0;
+  size_t offset = pyramidHeaderBytes;
+  for (size_t iLevel = 1; iLevel < steps.size(); iLevel++) {
+    std::unique_ptr<MappedFile> prevFile;
+    const float* src = data;
+    if (iLevel > 1) {
+      prevFile.reset(new MappedFile(tmpName));
+      if (prevFile->mapped == nullptr) return;
+      src = reinterpret_cast<const float*>(prevFile->mapped + prevOffset);
+    }
+    std::ofstream out(tmpName, std::ios::binary | std::ios::app);
+    writeDownsampledLevel(src, steps[iLevel - 1], steps[iLevel], out);
+    if (!out) return;
+    prevOffset = offset;
+    offset += countOf(steps[iLevel]) * sizeof(float);
+  }
+
+  std::remove(finalName.c_str());
+  std::rename(tmpName.c_str(), finalName.c_str());
+}
+
+size_t VolumeBrickPyramid::nLevels() const { return steps.size(); }
+
+std::array<size_t, 3> VolumeBrickPyramid::levelSteps(size_t level) const { return steps[level]; }
+
+std::array<size_t, 3> VolumeBrickPyramid::levelBricks(size_t level) const {
+  std::array<size_t, 3> b;
+  for (size_t d = 0; d < 3; d++) {
+    b[d] = std::max<size_t>(1, (steps[level][d] - 1 + brickSize - 1) / brickSize);
+  }
+  return b;
+}
+
+const float* VolumeBrickPyramid::levelData(size_t level) const { return levels[level]; }
+
+void VolumeBrickPyramid::readBrick(size_t level, std::array<size_t, 3> brick, float* out) const {
+  const size_t p = brickSize + 1;
+  const std::array<size_t, 3>& s = steps[level];
+  const float* src = levels[level];
+  for (size_t i = 0; i < p; i++) {
+    size_t iX = std::min(brick[0] * brickSize + i, s[0] - 1);
+    for (size_t j = 0; j < p; j++) {
+      size_t iY = std::min(brick[1] * brickSize + j, s[1] - 1);
+      const float* row = src + (iX * s[1] + iY) * s[2];
+      for (size_t k = 0; k < p; k++) {
+        size_t iZ = std::min(brick[2] * brickSize + k, s[2] - 1);
+        out[(k * p + j) * p + i] = row[iZ];
+      }
+    }
+  }
+}
+
+std::pair<float, float> VolumeBrickPyramid::getDataRange() const { return dataRange; }
+
+bool VolumeBrickPyramid::pyramidWasBuilt() const { return built; }
+
+} // namespace polyscope
@@ -3,6 +3,8 @@
 
 #include "polyscope/volume_grid.h"
 
+#include "polyscope/pick.h"
+
 #include "imgui.h"
 
 namespace polyscope {
@@ -14,7 +16,6 @@ VolumeGrid::VolumeGrid(std::string name, std::array<size_t, 3> steps_, glm::vec3
     : QuantityStructure<VolumeGrid>(name, typeName()), steps(steps_), bound_min(bound_min_), bound_max(bound_max_),
       material(uniquePrefix() + "#material", "clay") {
   updateObjectSpaceBounds();
-  populateGeometry();
 }
 
 void VolumeGrid::buildCustomUI() {
@@ -26,7 +27,24 @@ void VolumeGrid::buildCustomUI() {
 }
 
 void VolumeGrid::buildPickUI(size_t localPickID) {
-  // For now do nothing
+  std::array<size_t, 3> inds = flattenIndex(localPickID);
+  ImGui::Text("node (%zu, %zu, %zu)  ", inds[0], inds[1], inds[2]);
+  ImGui::SameLine();
+  ImGui::TextUnformatted(to_string(positionOfIndex(inds)).c_str());
+
+  ImGui::Spacing();
+  ImGui::Spacing();
+  ImGui::Spacing();
+  ImGui::Indent(20.);
+
+  // Build GUI to show the quantities
+  ImGui::Columns(2);
+  ImGui::SetColumnWidth(0, ImGui::GetWindowWidth() / 3);
+  for (auto& x : quantities) {
+    x.second->buildPickUI(localPickID);
+  }
+
+  ImGui::Indent(-20.);
 }
 
 void VolumeGrid::draw() {
@@ -56,7 +74,31 @@ void VolumeGrid::drawDelayed() {
 }
 
 void VolumeGrid::drawPick() {
-  // For now do nothing
+  if (!enabled.get() || !nodesAreDrawn()) return;
+
+  ensurePickProgramPrepared();
+  setStructureUniforms(*pickProgram);
+  setVolumeGridPointUniforms(*pickProgram);
+  pickProgram->draw();
+}
+
+bool VolumeGrid::nodesAreDrawn() {
+  for (auto& x : quantities) {
+    VolumeGridScalarQuantity* q = dynamic_cast<VolumeGridScalarQuantity*>(x.second.get());
+    if (q != nullptr && q->isEnabled() && q->getPointVizEnabled()) return true;
+  }
+  return false;
+}
+
+void VolumeGrid::ensurePickProgramPrepared() {
+  if (pickProgram) return;
+
+  // Pick colors come from the node index, offset from the start of our range
+  size_t pickStart = pick::requestPickBufferRange(this, nValues());
+  pickProgram = render::engine->requestShader("GRID_NODE_SPHERE", addVolumeGridPointRules({"SPHERE_PROPAGATE_PICK"}),
+                                              render::ShaderReplacementDefaults::Pick);
+  pickProgram->setVertexCount(nValues());
+  pickProgram->setUniform("u_pickStart", pick::indToDigits(pickStart));
 }
 
 void VolumeGrid::updateObjectSpaceBounds() {
@@ -67,30 +109,51 @@ void VolumeGrid::updateObjectSpaceBounds() {
 std::string VolumeGrid::typeName() { return structureTypeName; }
 
 void VolumeGrid::refresh() {
+  pickProgram.reset();
   QuantityStructure<VolumeGrid>::refresh(); // call base class version, which refreshes quantities
 }
 
+std::vector<glm::vec3> VolumeGrid::boundingBoxTriangles() const {
+
+  // corner i takes bound_max along axis j when bit j of i is set
+  std::array<glm::vec3, 8> corners;
+  for (int i = 0; i < 8; i++) {
+    corners[i] = glm::vec3{(i & 1) ? bound_max.x : bound_min.x, (i & 2) ? bound_max.y : bound_min.y,
+                           (i & 4) ? bound_max.z : bound_min.z};
+  }
 
-void VolumeGrid::populateGeometry() {
-  gridPointLocations.resize(nValues());
-  for (size_t i = 0; i < gridPointLocations.size(); i++) {
-    gridPointLocations[i] = positionOfIndex(i);
+  const int faces[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+  std::vector<glm::vec3> tris;
+  tris.reserve(36);
+  for (const auto& f : faces) {
+    for (int j : {0, 1, 2, 0, 2, 3}) {
+      tris.push_back(corners[f[j]]);
+    }
   }
+  return tris;
 }
 
 
 void VolumeGrid::setVolumeGridUniforms(render::ShaderProgram& p) {}
 
 void VolumeGrid::setVolumeGridPointUniforms(render::ShaderProgram& p) {
-  glm::mat4 P = view::getCameraPerspectiveMatrix();
-  glm::mat4 Pinv = glm::inverse(P);
-  p.setUniform("u_invProjMatrix", glm::value_ptr(Pinv));
-  p.setUniform("u_viewport", render::engine->getCurrentViewport());
   float pointRadius = minGridSpacing() / 8;
   p.setUniform("u_pointRadius", pointRadius);
+  p.setUniform("u_boundMin", bound_min);
+  p.setUniform("u_boundMax", bound_max);
+  p.setUniform("u_gridRes", glm::vec3{steps[0], steps[1], steps[2]});
 }
 
 
+void VolumeGrid::setVolumeGridRaymarchUniforms(render::ShaderProgram& p) {
+  glm::mat4 MVinv = glm::inverse(getModelView());
+  p.setUniform("u_invModelView", glm::value_ptr(MVinv));
+  p.setUniform("u_boundMin", bound_min);
+  p.setUniform("u_boundMax", bound_max);
+  p.setUniform("u_gridRes", glm::vec3{steps[0], steps[1], steps[2]});
+  p.setUniform("u_stepSize", minGridSpacing() / 2); // two samples per cell
+}
+
 std::vector<std::string> VolumeGrid::addVolumeGridPointRules(std::vector<std::string> initRules) {
   initRules = addStructureRules(initRules);
   if (wantsCullPosition()) {
@@ -101,11 +164,12 @@ std::vector<std::string> VolumeGrid::addVolumeGridPointRules(std::vector<std::st
 
 VolumeGrid* VolumeGrid::setMaterial(std::string m) {
   material = m;
-  refresh();
+  refreshQuantityMaterials();
   requestRedraw();
   return this;
 }
 std::string VolumeGrid::getMaterial() { return material.get(); }
+std::string VolumeGrid::drawSortKey() { return material.get(); }
 
 VolumeGridQuantity::VolumeGridQuantity(std::string name_, VolumeGrid& curveNetwork_, bool dominates_)
     : QuantityS<VolumeGrid>(name_, curveNetwork_, dominates_) {}
@@ -118,14 +182,21 @@ VolumeGridScalarQuantity* VolumeGrid::addScalarQuantityImpl(std::string name, co
   return q;
 }
 
-/*
+VolumeGridStreamedScalarQuantity* VolumeGrid::addScalarQuantityFromRawFile(std::string name, std::string filename,
+                                                                           size_t headerBytes, DataType dataType_) {
+  std::unique_ptr<VolumeBrickPyramid> pyramid(new VolumeBrickPyramid(filename, steps, headerBytes));
+  VolumeGridStreamedScalarQuantity* q =
+      new VolumeGridStreamedScalarQuantity(name, *this, std::move(pyramid), dataType_);
+  addQuantity(q);
+  return q;
+}
+
 VolumeGridVectorQuantity* VolumeGrid::addVectorQuantityImpl(std::string name, const std::vector<glm::vec3>& data,
                                                             VectorType dataType_) {
   VolumeGridVectorQuantity* q = new VolumeGridVectorQuantity(name, *this, data, dataType_);
   addQuantity(q);
   return q;
 }
-*/
 
 /*
 VolumeGridScalarIsosurface* VolumeGrid::addIsosurfaceQuantityImpl(std::string name, double isoLevel,
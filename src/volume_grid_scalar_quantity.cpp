@@ -2,24 +2,23 @@
 
 #include "polyscope/volume_grid_scalar_quantity.h"
 
-#define MC_CPP_USE_DOUBLE_PRECISION
-#include "MarchingCube/MC.h"
-
 namespace polyscope {
 
 VolumeGridScalarQuantity::VolumeGridScalarQuantity(std::string name, VolumeGrid& grid_,
                                                    const std::vector<double>& values_, DataType dataType_)
 
-    : VolumeGridQuantity(name, grid_, true), ScalarQuantity(*this, values_, dataType_), dataType(dataType_),
+    : VolumeGridQuantity(name, grid_, true),
+      ScalarQuantity(*this, std::vector<float>(values_.begin(), values_.end()), dataType_), dataType(dataType_),
       values(std::move(values_)), pointVizEnabled(parent.uniquePrefix() + "#" + name + "#pointVizEnabled", true),
       isosurfaceVizEnabled(parent.uniquePrefix() + "#" + name + "#isosurfaceVizEnabled", true),
       isosurfaceLevel(parent.uniquePrefix() + "#" + name + "#isosurfaceLevel",
                       0.5 * (vizRange.second + vizRange.first)),
-      isosurfaceColor(uniquePrefix() + "#" + name + "#isosurfaceColor", getNextUniqueColor())
+      isosurfaceColor(uniquePrefix() + "#" + name + "#isosurfaceColor", getNextUniqueColor()),
+      isosurfaceRaymarch(parent.uniquePrefix() + "#" + name + "#isosurfaceRaymarch", false),
+      volumeVizEnabled(parent.uniquePrefix() + "#" + name + "#volumeVizEnabled", false),
+      volumeDensity(parent.uniquePrefix() + "#" + name + "#volumeDensity", 5.)
 
-{
-  fillPositions();
-}
+{}
 void VolumeGridScalarQuantity::buildCustomUI() {
 
   // Select which viz to use
@@ -33,6 +32,7 @@ void VolumeGridScalarQuantity::buildCustomUI() {
     if (ImGui::MenuItem("Points", NULL, &pointVizEnabled.get())) setPointVizEnabled(getPointVizEnabled());
     if (ImGui::MenuItem("Isosurface", NULL, &isosurfaceVizEnabled.get()))
       setIsosurfaceVizEnabled(getIsosurfaceVizEnabled());
+    if (ImGui::MenuItem("Volume", NULL, &volumeVizEnabled.get())) setVolumeVizEnabled(getVolumeVizEnabled());
     // ImGui::Indent(-20);
     ImGui::EndPopup();
   }
@@ -48,10 +48,21 @@ void VolumeGridScalarQuantity::buildCustomUI() {
     ImGui::EndPopup();
   }
 
-  if (pointVizEnabled.get()) {
+  if (pointVizEnabled.get() || volumeVizEnabled.get()) {
     buildScalarUI();
   }
 
+  if (volumeVizEnabled.get()) {
+    ImGui::TextUnformatted("Volume:");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(120);
+    if (ImGui::SliderFloat("density", &volumeDensity.get(), 0.01, 100., "%.2f",
+                           ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
+      setVolumeDensity(getVolumeDensity());
+    }
+    ImGui::PopItemWidth();
+  }
+
   if (isosurfaceVizEnabled.get()) {
     ImGui::TextUnformatted("Isosurface:");
     // Color picker
@@ -63,33 +74,34 @@ void VolumeGridScalarQuantity::buildCustomUI() {
     // Set isovalue
     ImGui::PushItemWidth(120);
     if (ImGui::SliderFloat("##Radius", &isosurfaceLevel.get(), vizRange.first, vizRange.second, "%.4e")) {
-      // Note: we intentionally do this rather than calling setIsosurfaceLevel(), because that function immediately
-      // recomputes the level set mesh, which is too expensive during user interaction
-      isosurfaceLevel.manuallyChanged();
+      setIsosurfaceLevel(getIsosurfaceLevel());
     }
     ImGui::PopItemWidth();
     ImGui::SameLine();
-    if (ImGui::Button("Refresh")) {
-      refresh();
-    }
+    if (ImGui::Checkbox("Raymarch", &isosurfaceRaymarch.get())) setIsosurfaceRaymarch(getIsosurfaceRaymarch());
   }
 }
 
+void VolumeGridScalarQuantity::buildPickUI(size_t ind) {
+  ImGui::TextUnformatted(name.c_str());
+  ImGui::NextColumn();
+  ImGui::Text("%g", values[ind]);
+  ImGui::NextColumn();
+}
+
 std::string VolumeGridScalarQuantity::niceName() { return name + " (scalar)"; }
 
 void VolumeGridScalarQuantity::refresh() {
   pointProgram.reset();
   isosurfaceProgram.reset();
+  isosurfaceRaymarchProgram.reset();
+  volumeProgram.reset();
 }
 
-void VolumeGridScalarQuantity::fillPositions() {
-  positions.clear();
-  // Fill the positions vector with each grid corner position
-  size_t nValues = parent.nValues();
-  positions.resize(nValues);
-  for (size_t i = 0; i < nValues; i++) {
-    positions[i] = parent.positionOfIndex(i);
-  }
+void VolumeGridScalarQuantity::refreshMaterial() {
+  if (pointProgram) render::engine->setMaterial(*pointProgram, parent.getMaterial());
+  if (isosurfaceProgram) render::engine->setMaterial(*isosurfaceProgram, parent.getMaterial());
+  if (isosurfaceRaymarchProgram) render::engine->setMaterial(*isosurfaceRaymarchProgram, parent.getMaterial());
 }
 
 void VolumeGridScalarQuantity::draw() {
@@ -107,8 +119,20 @@ void VolumeGridScalarQuantity::draw() {
     pointProgram->draw();
   }
 
+  // Draw the raymarched isosurface
+  if (isosurfaceVizEnabled.get() && isosurfaceRaymarch.get()) {
+    if (isosurfaceRaymarchProgram == nullptr) {
+      createIsosurfaceRaymarchProgram();
+    }
+    parent.setStructureUniforms(*isosurfaceRaymarchProgram);
+    parent.setVolumeGridRaymarchUniforms(*isosurfaceRaymarchProgram);
+    isosurfaceRaymarchProgram->setUniform("u_isoLevel", getIsosurfaceLevel());
+    isosurfaceRaymarchProgram->setUniform("u_baseColor", getIsosurfaceColor());
+    isosurfaceRaymarchProgram->draw();
+  }
+
   // Draw the isosurface program
-  if (isosurfaceVizEnabled.get()) {
+  if (isosurfaceVizEnabled.get() && !isosurfaceRaymarch.get()) {
     if (isosurfaceProgram == nullptr) {
       createIsosurfaceProgram();
     }
@@ -121,13 +145,36 @@ void VolumeGridScalarQuantity::draw() {
   }
 }
 
+void VolumeGridScalarQuantity::drawDelayed() {
+  if (!isEnabled()) return;
+
+  // The volume is translucent, so it gets blended over the rest of the scene after everything else is drawn
+  if (volumeVizEnabled.get()) {
+    if (volumeProgram == nullptr) {
+      createVolumeProgram();
+    }
+    parent.setStructureUniforms(*volumeProgram);
+    parent.setVolumeGridRaymarchUniforms(*volumeProgram);
+    setScalarUniforms(*volumeProgram);
+    float diagLen = glm::length(parent.bound_max - parent.bound_min);
+    volumeProgram->setUniform("u_density", getVolumeDensity() / diagLen);
+    volumeProgram->setUniform("u_densityRangeLow", vizRange.first);
+    volumeProgram->setUniform("u_densityRangeHigh", vizRange.second);
+
+    render::engine->setDepthMode(DepthMode::LEqualReadOnly);
+    render::engine->setBlendMode(BlendMode::Over);
+    volumeProgram->draw();
+  }
+}
+
 void VolumeGridScalarQuantity::createPointProgram() {
 
+  // Node positions are computed from the vertex ID, only the values are uploaded
   pointProgram = render::engine->requestShader(
-      "RAYCAST_SPHERE", parent.addVolumeGridPointRules(addScalarRules({"SPHERE_PROPAGATE_VALUE"})));
+      "GRID_NODE_SPHERE", parent.addVolumeGridPointRules(addScalarRules({"SPHERE_PROPAGATE_VALUE"})));
 
   // Fill buffers
-  pointProgram->setAttribute("a_position", parent.gridPointLocations);
+  pointProgram->setVertexCount(parent.nValues());
   pointProgram->setAttribute("a_value", values);
   pointProgram->setTextureFromColormap("t_colormap", cMap.get());
 
@@ -136,17 +183,21 @@ void VolumeGridScalarQuantity::createPointProgram() {
 
 void VolumeGridScalarQuantity::createIsosurfaceProgram() {
 
-  // Extract the isosurface from the level set of the scalar field
-  MC::mcMesh mesh;
-  MC::marching_cube(&values.front(), isosurfaceLevel.get(), parent.steps[0], parent.steps[1], parent.steps[2], mesh);
+  // Extract the isosurface from the level set of the scalar field. The extractor keeps a coarse summary of the values,
+  // so it is built once and reused as the level changes.
+  if (!isosurfaceExtractor) {
+    isosurfaceExtractor.reset(new GridIsosurfaceExtractor(values.data(), parent.steps));
+  }
+  IsosurfaceMesh mesh = isosurfaceExtractor->extract(isosurfaceLevel.get());
 
   // Transform the result to be aligned with our volume's spatial layout
-  glm::vec3 scale{(parent.bound_max[0] - parent.bound_min[0]) / (parent.steps[0] - 1),
-                  (parent.bound_max[1] - parent.bound_min[1]) / (parent.steps[1] - 1),
-                  (parent.bound_max[2] - parent.bound_min[2]) / (parent.steps[2] - 1)};
+  glm::vec3 scale = parent.gridSpacing();
   for (auto& p : mesh.vertices) {
     p = p * scale + parent.bound_min;
   }
+  for (auto& n : mesh.normals) {
+    n = glm::normalize(n / scale);
+  }
 
 
   // Create a render program to draw it
@@ -164,6 +215,40 @@ void VolumeGridScalarQuantity::createIsosurfaceProgram() {
   render::engine->setMaterial(*isosurfaceProgram, parent.getMaterial());
 }
 
+void VolumeGridScalarQuantity::ensureValuesTexture() {
+  if (valuesTexture) return;
+
+  // The texture's x axis is the grid's fastest-varying (last) index, so the values can be uploaded in order
+  std::vector<float> valuesFloat(values.begin(), values.end());
+  valuesTexture = render::engine->generateTextureBuffer(TextureFormat::R32F, parent.steps[2], parent.steps[1],
+                                                        parent.steps[0], &valuesFloat.front());
+  valuesTexture->setMemoryOwner(uniquePrefix() + "valuesTexture");
+  valuesTexture->setFilterMode(FilterMode::Linear);
+}
+
+void VolumeGridScalarQuantity::createIsosurfaceRaymarchProgram() {
+  ensureValuesTexture();
+
+  isosurfaceRaymarchProgram = render::engine->requestShader(
+      "GRID_RAYMARCH_ISOSURFACE", parent.addStructureRules({"GRID_SAMPLE_DENSE", "SHADE_BASECOLOR"}));
+
+  isosurfaceRaymarchProgram->setAttribute("a_position", parent.boundingBoxTriangles());
+  isosurfaceRaymarchProgram->setTextureFromBuffer("t_volume", valuesTexture.get());
+
+  render::engine->setMaterial(*isosurfaceRaymarchProgram, parent.getMaterial());
+}
+
+void VolumeGridScalarQuantity::createVolumeProgram() {
+  ensureValuesTexture();
+
+  volumeProgram = render::engine->requestShader("GRID_RAYMARCH_VOLUME", addScalarRules({"GRID_SAMPLE_DENSE"}),
+                                                render::ShaderReplacementDefaults::Process);
+
+  volumeProgram->setAttribute("a_position", parent.boundingBoxTriangles());
+  volumeProgram->setTextureFromBuffer("t_volume", valuesTexture.get());
+  volumeProgram->setTextureFromColormap("t_colormap", cMap.get());
+}
+
 // === Getters and setters
 
 VolumeGridScalarQuantity* VolumeGridScalarQuantity::setPointVizEnabled(bool val) {
@@ -195,4 +280,25 @@ VolumeGridScalarQuantity* VolumeGridScalarQuantity::setIsosurfaceColor(glm::vec3
 }
 glm::vec3 VolumeGridScalarQuantity::getIsosurfaceColor() { return isosurfaceColor.get(); }
 
+VolumeGridScalarQuantity* VolumeGridScalarQuantity::setIsosurfaceRaymarch(bool val) {
+  isosurfaceRaymarch = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridScalarQuantity::getIsosurfaceRaymarch() { return isosurfaceRaymarch.get(); }
+
+VolumeGridScalarQuantity* VolumeGridScalarQuantity::setVolumeVizEnabled(bool val) {
+  volumeVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridScalarQuantity::getVolumeVizEnabled() { return volumeVizEnabled.get(); }
+
+VolumeGridScalarQuantity* VolumeGridScalarQuantity::setVolumeDensity(float val) {
+  volumeDensity = val;
+  requestRedraw();
+  return this;
+}
+float VolumeGridScalarQuantity::getVolumeDensity() { return volumeDensity.get(); }
+
 } // namespace polyscope
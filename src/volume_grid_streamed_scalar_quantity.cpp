@@ -0,0 +1,514 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/volume_grid_streamed_scalar_quantity.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace polyscope {
+
+namespace {
+
+// 5 bits of level and 19 bits per brick coordinate
+uint64_t packBrickKey(size_t level, std::array<size_t, 3> brick) {
+  return (static_cast<uint64_t>(level) << 57) | (static_cast<uint64_t>(brick[0]) << 38) |
+         (static_cast<uint64_t>(brick[1]) << 19) | static_cast<uint64_t>(brick[2]);
+}
+
+std::vector<float> coarsestLevelValues(const VolumeBrickPyramid& pyramid) {
+  size_t top = pyramid.nLevels() - 1;
+  std::array<size_t, 3> s = pyramid.levelSteps(top);
+  const float* data = pyramid.levelData(top);
+  return std::vector<float>(data, data + s[0] * s[1] * s[2]);
+}
+
+const uint64_t unusedSlot = std::numeric_limits<uint64_t>::max();
+
+} // namespace
+
+VolumeGridStreamedScalarQuantity::VolumeGridStreamedScalarQuantity(std::string name, VolumeGrid& grid_,
+                                                                   std::unique_ptr<VolumeBrickPyramid>&& pyramid_,
+                                                                   DataType dataType_)
+    : VolumeGridQuantity(name, grid_, true), ScalarQuantity(*this, coarsestLevelValues(*pyramid_), dataType_),
+      pyramid(std::move(pyramid_)), dataType(dataType_),
+      isosurfaceVizEnabled(parent.uniquePrefix() + "#" + name + "#isosurfaceVizEnabled", true),
+      isosurfaceLevel(parent.uniquePrefix() + "#" + name + "#isosurfaceLevel",
+                      0.5 * (pyramid->getDataRange().first + pyramid->getDataRange().second)),
+      isosurfaceColor(uniquePrefix() + "#" + name + "#isosurfaceColor", getNextUniqueColor()),
+      volumeVizEnabled(parent.uniquePrefix() + "#" + name + "#volumeVizEnabled", false),
+      volumeDensity(parent.uniquePrefix() + "#" + name + "#volumeDensity", 5.) {
+
+  // The values held by the scalar quantity are only the coarsest level, take the range of the full data instead
+  dataRange = pyramid->getDataRange();
+  resetMapRange();
+}
+
+void VolumeGridStreamedScalarQuantity::buildCustomUI() {
+
+  // Select which viz to use
+  ImGui::SameLine();
+  if (ImGui::Button("Mode")) {
+    ImGui::OpenPopup("ModePopup");
+  }
+  if (ImGui::BeginPopup("ModePopup")) {
+    if (ImGui::MenuItem("Isosurface", NULL, &isosurfaceVizEnabled.get()))
+      setIsosurfaceVizEnabled(getIsosurfaceVizEnabled());
+    if (ImGui::MenuItem("Volume", NULL, &volumeVizEnabled.get())) setVolumeVizEnabled(getVolumeVizEnabled());
+    ImGui::EndPopup();
+  }
+
+  // == Options popup
+  ImGui::SameLine();
+  if (ImGui::Button("Options")) {
+    ImGui::OpenPopup("OptionsPopup");
+  }
+  if (ImGui::BeginPopup("OptionsPopup")) {
+    buildScalarOptionsUI();
+    ImGui::EndPopup();
+  }
+
+  if (volumeVizEnabled.get()) {
+    buildScalarUI();
+
+    ImGui::TextUnformatted("Volume:");
+    ImGui::SameLine();
+    ImGui::PushItemWidth(120);
+    if (ImGui::SliderFloat("density", &volumeDensity.get(), 0.01, 100., "%.2f",
+                           ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
+      setVolumeDensity(getVolumeDensity());
+    }
+    ImGui::PopItemWidth();
+  }
+
+  if (isosurfaceVizEnabled.get()) {
+    ImGui::TextUnformatted("Isosurface:");
+    if (ImGui::ColorEdit3("##Color", &isosurfaceColor.get()[0], ImGuiColorEditFlags_NoInputs)) {
+      setIsosurfaceColor(getIsosurfaceColor());
+    }
+    ImGui::SameLine();
+    ImGui::PushItemWidth(120);
+    if (ImGui::SliderFloat("##Radius", &isosurfaceLevel.get(), vizRange.first, vizRange.second, "%.4e")) {
+      setIsosurfaceLevel(getIsosurfaceLevel());
+    }
+    ImGui::PopItemWidth();
+  }
+
+  if (ImGui::TreeNode("Streaming")) {
+    ImGui::Text("%d levels, %d / %d bricks resident", static_cast<int>(pyramid->nLevels()),
+                static_cast<int>(getResidentBrickCount()), static_cast<int>(cacheBricks));
+    ImGui::Text("%d bricks uploaded%s", static_cast<int>(totalBrickUploads), cacheComplete ? "" : " (loading)");
+    ImGui::PushItemWidth(120);
+    if (ImGui::SliderFloat("pixels per voxel", &levelOfDetailPixels, 0.5, 16., "%.1f",
+                           ImGuiSliderFlags_Logarithmic)) {
+      setLevelOfDetailPixels(levelOfDetailPixels);
+    }
+    ImGui::PopItemWidth();
+    ImGui::TreePop();
+  }
+}
+
+std::string VolumeGridStreamedScalarQuantity::niceName() { return name + " (streamed scalar)"; }
+
+const VolumeBrickPyramid& VolumeGridStreamedScalarQuantity::getPyramid() const { return *pyramid; }
+
+void VolumeGridStreamedScalarQuantity::refresh() {
+  isosurfaceProgram.reset();
+  volumeProgram.reset();
+}
+
+void VolumeGridStreamedScalarQuantity::refreshMaterial() {
+  if (isosurfaceProgram) render::engine->setMaterial(*isosurfaceProgram, parent.getMaterial());
+}
+
+void VolumeGridStreamedScalarQuantity::draw() {
+  if (!isEnabled()) return;
+  if (!isosurfaceVizEnabled.get() && !volumeVizEnabled.get()) return;
+
+  updateCache();
+
+  if (isosurfaceVizEnabled.get()) {
+    if (isosurfaceProgram == nullptr) {
+      createIsosurfaceProgram();
+    }
+    parent.setStructureUniforms(*isosurfaceProgram);
+    setStreamingUniforms(*isosurfaceProgram);
+    isosurfaceProgram->setUniform("u_isoLevel", getIsosurfaceLevel());
+    isosurfaceProgram->setUniform("u_baseColor", getIsosurfaceColor());
+    isosurfaceProgram->draw();
+  }
+}
+
+void VolumeGridStreamedScalarQuantity::drawDelayed() {
+  if (!isEnabled()) return;
+
+  if (volumeVizEnabled.get()) {
+    if (volumeProgram == nullptr) {
+      createVolumeProgram();
+    }
+    parent.setStructureUniforms(*volumeProgram);
+    setStreamingUniforms(*volumeProgram);
+    setScalarUniforms(*volumeProgram);
+    float diagLen = glm::length(parent.bound_max - parent.bound_min);
+    volumeProgram->setUniform("u_density", getVolumeDensity() / diagLen);
+    volumeProgram->setUniform("u_densityRangeLow", vizRange.first);
+    volumeProgram->setUniform("u_densityRangeHigh", vizRange.second);
+
+    render::engine->setDepthMode(DepthMode::LEqualReadOnly);
+    render::engine->setBlendMode(BlendMode::Over);
+    volumeProgram->draw();
+  }
+}
+
+void VolumeGridStreamedScalarQuantity::setStreamingUniforms(render::ShaderProgram& p) {
+  parent.setVolumeGridRaymarchUniforms(p);
+
+  // Two samples per cell of the full-resolution grid would be thousands of steps per ray for the grids this is meant
+  // for, so cap the number of steps along the diagonal
+  float diagLen = glm::length(parent.bound_max - parent.bound_min);
+  p.setUniform("u_stepSize", std::max(parent.minGridSpacing() / 2.f, diagLen / 2048.f));
+
+  std::array<size_t, 3> tableRes = pyramid->levelBricks(0);
+  p.setUniform("u_pageTableRes", glm::vec3{tableRes[0], tableRes[1], tableRes[2]});
+  p.setUniform("u_atlasBricks", glm::vec3{atlasBricks[0], atlasBricks[1], atlasBricks[2]});
+  p.setUniform("u_brickSize", static_cast<float>(VolumeBrickPyramid::brickSize));
+}
+
+void VolumeGridStreamedScalarQuantity::createIsosurfaceProgram() {
+  ensureCache();
+
+  isosurfaceProgram = render::engine->requestShader(
+      "GRID_RAYMARCH_ISOSURFACE", parent.addStructureRules({"GRID_SAMPLE_STREAMED", "SHADE_BASECOLOR"}));
+
+  isosurfaceProgram->setAttribute("a_position", parent.boundingBoxTriangles());
+  isosurfaceProgram->setTextureFromBuffer("t_pageTable", pageTableTexture.get());
+  isosurfaceProgram->setTextureFromBuffer("t_volume", atlasTexture.get());
+
+  render::engine->setMaterial(*isosurfaceProgram, parent.getMaterial());
+}
+
+void VolumeGridStreamedScalarQuantity::createVolumeProgram() {
+  ensureCache();
+
+  volumeProgram = render::engine->requestShader("GRID_RAYMARCH_VOLUME", addScalarRules({"GRID_SAMPLE_STREAMED"}),
+                                                render::ShaderReplacementDefaults::Process);
+
+  volumeProgram->setAttribute("a_position", parent.boundingBoxTriangles());
+  volumeProgram->setTextureFromBuffer("t_pageTable", pageTableTexture.get());
+  volumeProgram->setTextureFromBuffer("t_volume", atlasTexture.get());
+  volumeProgram->setTextureFromColormap("t_colormap", cMap.get());
+}
+
+// === The brick cache
+
+void VolumeGridStreamedScalarQuantity::ensureCache() {
+  if (atlasTexture) return;
+
+  // Lay the slots out in a roughly cubical atlas, so no side of the texture gets too long
+  size_t side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(cacheBricks)) - 1e-6));
+  atlasBricks = {side, side, (cacheBricks + side * side - 1) / (side * side)};
+  const size_t padded = VolumeBrickPyramid::brickSize + 1;
+  std::vector<float> zeros(atlasBricks[0] * atlasBricks[1] * atlasBricks[2] * padded * padded * padded, 0.f);
+  atlasTexture = render::engine->generateTextureBuffer(TextureFormat::R32F, atlasBricks[0] * padded,
+                                                       atlasBricks[1] * padded, atlasBricks[2] * padded,
+                                                       &zeros.front());
+  atlasTexture->setMemoryOwner(uniquePrefix() + "atlasTexture");
+  atlasTexture->setFilterMode(FilterMode::Linear);
+
+  std::array<size_t, 3> tableRes = pyramid->levelBricks(0);
+  pageTableData.assign(tableRes[0] * tableRes[1] * tableRes[2], 0.f);
+  pageTableTexture = render::engine->generateTextureBuffer(TextureFormat::R32F, tableRes[0], tableRes[1], tableRes[2],
+                                                           &pageTableData.front());
+  pageTableTexture->setMemoryOwner(uniquePrefix() + "pageTableTexture");
+
+  slots.assign(cacheBricks, CacheSlot{unusedSlot, 0, false});
+  residentSlots.clear();
+  lastCut.clear();
+  cacheComplete = false;
+}
+
+std::array<glm::vec3, 2> VolumeGridStreamedScalarQuantity::brickBounds(size_t level,
+                                                                       std::array<size_t, 3> brick) const {
+  // In full-resolution nodes, a level L brick covers brickSize * 2^L cells from its first node
+  const size_t span = VolumeBrickPyramid::brickSize << level;
+  glm::vec3 spacing = parent.gridSpacing();
+  std::array<glm::vec3, 2> bounds;
+  for (int d = 0; d < 3; d++) {
+    size_t lastNode = parent.steps[d] - 1;
+    bounds[0][d] = parent.bound_min[d] + std::min(brick[d] * span, lastNode) * spacing[d];
+    bounds[1][d] = parent.bound_min[d] + std::min((brick[d] + 1) * span, lastNode) * spacing[d];
+  }
+  return bounds;
+}
+
+std::vector<VolumeGridStreamedScalarQuantity::BrickRef>
+VolumeGridStreamedScalarQuantity::selectBricks(const glm::mat4& modelView, const glm::mat4& projMat) const {
+
+  const glm::mat4 viewProj = projMat * modelView;
+  const glm::vec3 eye = glm::vec3(glm::inverse(modelView) * glm::vec4(0., 0., 0., 1.));
+  const float viewScale = glm::length(glm::vec3(modelView[0]));
+  const float voxelSize = parent.minGridSpacing();
+
+  auto inFrustum = [&](const std::array<glm::vec3, 2>& bounds) {
+    // culled if all corners are outside the same clip plane
+    int outside[6] = {0, 0, 0, 0, 0, 0};
+    for (int c = 0; c < 8; c++) {
+      glm::vec3 corner{bounds[c & 1][0], bounds[(c >> 1) & 1][1], bounds[(c >> 2) & 1][2]};
+      glm::vec4 clip = viewProj * glm::vec4(corner, 1.);
+      for (int d = 0; d < 3; d++) {
+        if (clip[d] < -clip.w) outside[2 * d]++;
+        if (clip[d] > clip.w) outside[2 * d + 1]++;
+      }
+    }
+    for (int i = 0; i < 6; i++) {
+      if (outside[i] == 8) return false;
+    }
+    return true;
+  };
+
+  // The size on screen of a voxel of the brick, at the point of the brick nearest to the camera
+  auto voxelPixels = [&](size_t level, const std::array<glm::vec3, 2>& bounds) {
+    glm::vec3 nearest = glm::clamp(eye, bounds[0], bounds[1]);
+    glm::vec4 pView = modelView * glm::vec4(nearest, 1.);
+    float worldSize = voxelSize * static_cast<float>(1 << level) * viewScale;
+    glm::vec4 clipA = projMat * pView;
+    glm::vec4 clipB = projMat * (pView + glm::vec4(0., worldSize, 0., 0.));
+    if (clipA.w <= 1e-6 || clipB.w <= 1e-6) return std::numeric_limits<float>::infinity();
+    return std::abs(clipB.y / clipB.w - clipA.y / clipA.w) * 0.5f * view::bufferHeight;
+  };
+
+  // Greedily refine the brick with the largest voxels on screen, starting from the coarsest level, as long as one
+  // more refinement fits in the cache
+  std::vector<BrickRef> cut;
+  std::vector<char> refined;
+  std::priority_queue<std::pair<float, size_t>> queue;
+  auto consider = [&](size_t i) {
+    const BrickRef& b = cut[i];
+    if (b.level == 0) return;
+    std::array<glm::vec3, 2> bounds = brickBounds(b.level, b.brick);
+    if (!inFrustum(bounds)) return;
+    float pixels = voxelPixels(b.level, bounds);
+    if (pixels > levelOfDetailPixels) queue.push(std::make_pair(pixels, i));
+  };
+
+  size_t top = pyramid->nLevels() - 1;
+  std::array<size_t, 3> topBricks = pyramid->levelBricks(top);
+  for (size_t i = 0; i < topBricks[0]; i++) {
+    for (size_t j = 0; j < topBricks[1]; j++) {
+      for (size_t k = 0; k < topBricks[2]; k++) {
+        cut.push_back(BrickRef{top, {i, j, k}});
+        refined.push_back(false);
+        consider(cut.size() - 1);
+      }
+    }
+  }
+
+  size_t nLeaves = cut.size();
+  while (!queue.empty()) {
+    size_t iParent = queue.top().second;
+    queue.pop();
+    BrickRef parentRef = cut[iParent];
+    size_t childLevel = parentRef.level - 1;
+    std::array<size_t, 3> childBricks = pyramid->levelBricks(childLevel);
+
+    std::vector<BrickRef> children;
+    for (size_t c = 0; c < 8; c++) {
+      std::array<size_t, 3> child{2 * parentRef.brick[0] + (c & 1), 2 * parentRef.brick[1] + ((c >> 1) & 1),
+                                  2 * parentRef.brick[2] + ((c >> 2) & 1)};
+      if (child[0] < childBricks[0] && child[1] < childBricks[1] && child[2] < childBricks[2]) {
+        children.push_back(BrickRef{childLevel, child});
+      }
+    }
+    if (nLeaves - 1 + children.size() > cacheBricks) continue;
+
+    refined[iParent] = true;
+    nLeaves += children.size() - 1;
+    for (const BrickRef& child : children) {
+      cut.push_back(child);
+      refined.push_back(false);
+      consider(cut.size() - 1);
+    }
+  }
+
+  // Keep the leaves, coarsest first so they are uploaded first
+  std::vector<BrickRef> leaves;
+  for (size_t i = 0; i < cut.size(); i++) {
+    if (!refined[i]) leaves.push_back(cut[i]);
+  }
+  std::stable_sort(leaves.begin(), leaves.end(),
+                   [](const BrickRef& a, const BrickRef& b) { return a.level > b.level; });
+  return leaves;
+}
+
+void VolumeGridStreamedScalarQuantity::updateCache() {
+  ensureCache();
+
+  // Nothing to do if the camera hasn't moved since everything it wanted arrived
+  glm::mat4 viewMat = parent.getModelView();
+  glm::mat4 projMat = view::getCameraPerspectiveMatrix();
+  glm::mat4 viewProj = projMat * viewMat;
+  if (cacheComplete && viewProj == lastViewMat) return;
+  lastViewMat = viewProj;
+  updateCount++;
+
+  std::vector<BrickRef> wanted = selectBricks(viewMat, projMat);
+  std::vector<uint64_t> wantedKeys;
+  for (const BrickRef& b : wanted) {
+    wantedKeys.push_back(packBrickKey(b.level, b.brick));
+  }
+
+  // Mark everything wanted as used first, so none of it gets evicted to make room for the rest
+  for (uint64_t key : wantedKeys) {
+    auto it = residentSlots.find(key);
+    if (it != residentSlots.end()) slots[it->second].lastUsed = updateCount;
+  }
+
+  // Upload missing bricks, least-recently-used slots are reused
+  const size_t padded = VolumeBrickPyramid::brickSize + 1;
+  const size_t top = pyramid->nLevels() - 1;
+  std::vector<float> brickData(padded * padded * padded);
+  size_t nUploads = 0;
+  bool complete = true;
+  for (size_t i = 0; i < wanted.size(); i++) {
+    if (residentSlots.find(wantedKeys[i]) != residentSlots.end()) continue;
+    if (nUploads >= maxBrickUploadsPerFrame) {
+      complete = false;
+      break;
+    }
+
+    size_t iSlot = slots.size();
+    for (size_t s = 0; s < slots.size(); s++) {
+      if (slots[s].key == unusedSlot) {
+        iSlot = s;
+        break;
+      }
+      if (slots[s].pinned || slots[s].lastUsed == updateCount) continue;
+      if (iSlot == slots.size() || slots[s].lastUsed < slots[iSlot].lastUsed) iSlot = s;
+    }
+    if (iSlot == slots.size()) {
+      complete = false;
+      break;
+    }
+
+    if (slots[iSlot].key != unusedSlot) residentSlots.erase(slots[iSlot].key);
+    pyramid->readBrick(wanted[i].level, wanted[i].brick, &brickData.front());
+    size_t sX = iSlot % atlasBricks[0];
+    size_t sY = (iSlot / atlasBricks[0]) % atlasBricks[1];
+    size_t sZ = iSlot / (atlasBricks[0] * atlasBricks[1]);
+    atlasTexture->setDataRegion3D(sX * padded, sY * padded, sZ * padded, padded, padded, padded, &brickData.front());
+    slots[iSlot] = CacheSlot{wantedKeys[i], updateCount, wanted[i].level == top};
+    residentSlots[wantedKeys[i]] = static_cast<uint32_t>(iSlot);
+    nUploads++;
+    totalBrickUploads++;
+  }
+
+  // Rebuild the page table if anything changed. Each wanted brick covers a box of full-resolution bricks, which point
+  // to it or, until it arrives, to its nearest resident ancestor.
+  if (nUploads > 0 || wantedKeys != lastCut) {
+    std::array<size_t, 3> tableRes = pyramid->levelBricks(0);
+    for (const BrickRef& b : wanted) {
+      size_t level = b.level;
+      std::array<size_t, 3> brick = b.brick;
+      auto it = residentSlots.find(packBrickKey(level, brick));
+      while (it == residentSlots.end() && level < top) {
+        level++;
+        brick = {brick[0] / 2, brick[1] / 2, brick[2] / 2};
+        it = residentSlots.find(packBrickKey(level, brick));
+      }
+      if (it == residentSlots.end()) continue;
+      float entry = static_cast<float>(it->second * 32 + level);
+
+      std::array<size_t, 3> lo, hi;
+      for (int d = 0; d < 3; d++) {
+        lo[d] = b.brick[d] << b.level;
+        hi[d] = std::min((b.brick[d] + 1) << b.level, tableRes[d]);
+      }
+      for (size_t z = lo[2]; z < hi[2]; z++) {
+        for (size_t y = lo[1]; y < hi[1]; y++) {
+          for (size_t x = lo[0]; x < hi[0]; x++) {
+            pageTableData[(z * tableRes[1] + y) * tableRes[0] + x] = entry;
+          }
+        }
+      }
+    }
+    pageTableTexture->setDataRegion3D(0, 0, 0, tableRes[0], tableRes[1], tableRes[2], &pageTableData.front());
+    lastCut = wantedKeys;
+  }
+
+  // Keep drawing frames until everything has been streamed in
+  cacheComplete = complete;
+  if (!cacheComplete) requestRedraw();
+}
+
+// === Getters and setters
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setIsosurfaceVizEnabled(bool val) {
+  isosurfaceVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridStreamedScalarQuantity::getIsosurfaceVizEnabled() { return isosurfaceVizEnabled.get(); }
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setIsosurfaceLevel(float val) {
+  isosurfaceLevel = val;
+  requestRedraw();
+  return this;
+}
+float VolumeGridStreamedScalarQuantity::getIsosurfaceLevel() { return isosurfaceLevel.get(); }
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setIsosurfaceColor(glm::vec3 val) {
+  isosurfaceColor = val;
+  requestRedraw();
+  return this;
+}
+glm::vec3 VolumeGridStreamedScalarQuantity::getIsosurfaceColor() { return isosurfaceColor.get(); }
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setVolumeVizEnabled(bool val) {
+  volumeVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridStreamedScalarQuantity::getVolumeVizEnabled() { return volumeVizEnabled.get(); }
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setVolumeDensity(float val) {
+  volumeDensity = val;
+  requestRedraw();
+  return this;
+}
+float VolumeGridStreamedScalarQuantity::getVolumeDensity() { return volumeDensity.get(); }
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setCacheBricks(size_t val) {
+  if (val == 0) exception("brick cache must hold at least one brick");
+  std::array<size_t, 3> topBricks = pyramid->levelBricks(pyramid->nLevels() - 1);
+  cacheBricks = std::max(val, topBricks[0] * topBricks[1] * topBricks[2]);
+
+  // Drop the cache, it is reallocated at the new size on the next draw
+  atlasTexture.reset();
+  pageTableTexture.reset();
+  refresh();
+  requestRedraw();
+  return this;
+}
+size_t VolumeGridStreamedScalarQuantity::getCacheBricks() { return cacheBricks; }
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setMaxBrickUploadsPerFrame(size_t val) {
+  maxBrickUploadsPerFrame = std::max(val, static_cast<size_t>(1));
+  requestRedraw();
+  return this;
+}
+size_t VolumeGridStreamedScalarQuantity::getMaxBrickUploadsPerFrame() { return maxBrickUploadsPerFrame; }
+
+VolumeGridStreamedScalarQuantity* VolumeGridStreamedScalarQuantity::setLevelOfDetailPixels(float val) {
+  levelOfDetailPixels = val;
+  cacheComplete = false; // force a new selection of bricks
+  requestRedraw();
+  return this;
+}
+float VolumeGridStreamedScalarQuantity::getLevelOfDetailPixels() { return levelOfDetailPixels; }
+
+size_t VolumeGridStreamedScalarQuantity::getResidentBrickCount() const { return residentSlots.size(); }
+size_t VolumeGridStreamedScalarQuantity::getTotalBrickUploads() const { return totalBrickUploads; }
+bool VolumeGridStreamedScalarQuantity::getCacheComplete() const { return cacheComplete; }
+
+} // namespace polyscope
@@ -0,0 +1,403 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope/volume_grid_vector_quantity.h"
+
+#include "polyscope/parallel.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace polyscope {
+
+namespace {
+
+// Trilinear interpolation of the node vectors, at a point in the grid's bounds
+glm::vec3 sampleGridVectors(const std::vector<glm::vec3>& data, const std::array<size_t, 3>& res, glm::vec3 boundMin,
+                            glm::vec3 boundMax, glm::vec3 p) {
+  size_t i0[3], i1[3];
+  float frac[3];
+  for (int k = 0; k < 3; k++) {
+    if (res[k] < 2) {
+      i0[k] = i1[k] = 0;
+      frac[k] = 0.;
+      continue;
+    }
+    float t = (p[k] - boundMin[k]) / (boundMax[k] - boundMin[k]) * (res[k] - 1);
+    t = glm::clamp(t, 0.f, static_cast<float>(res[k] - 1));
+    i0[k] = std::min(static_cast<size_t>(t), res[k] - 2);
+    i1[k] = i0[k] + 1;
+    frac[k] = t - i0[k];
+  }
+
+  glm::vec3 result{0., 0., 0.};
+  for (int c = 0; c < 8; c++) {
+    size_t iX = (c & 1) ? i1[0] : i0[0];
+    size_t iY = (c & 2) ? i1[1] : i0[1];
+    size_t iZ = (c & 4) ? i1[2] : i0[2];
+    float w = ((c & 1) ? frac[0] : 1.f - frac[0]) * ((c & 2) ? frac[1] : 1.f - frac[1]) *
+              ((c & 4) ? frac[2] : 1.f - frac[2]);
+    result += w * data[(iX * res[1] + iY) * res[2] + iZ];
+  }
+  return result;
+}
+
+} // namespace
+
+VolumeGridVectorQuantity::VolumeGridVectorQuantity(std::string name, VolumeGrid& grid_,
+                                                   const std::vector<glm::vec3>& vectors_, VectorType vectorType_)
+
+    : VolumeGridQuantity(name, grid_), VectorQuantityBase<VolumeGridVectorQuantity>(*this, vectorType_),
+      vectors(uniquePrefix() + "#values", vectorsData), vectorsData(vectors_),
+      arrowVizEnabled(uniquePrefix() + "#arrowVizEnabled", true), sampleStride(uniquePrefix() + "#sampleStride", 1),
+      sampleJitter(uniquePrefix() + "#sampleJitter", false),
+      streamlineVizEnabled(uniquePrefix() + "#streamlineVizEnabled", false),
+      streamlineSeedsPerAxis(uniquePrefix() + "#streamlineSeedsPerAxis", 8),
+      streamlineMaxSteps(uniquePrefix() + "#streamlineMaxSteps", 200),
+      streamlineRadius(uniquePrefix() + "#streamlineRadius", relativeValue(0.001)) {
+  updateMaxLength();
+}
+
+void VolumeGridVectorQuantity::draw() {
+  if (!isEnabled()) return;
+
+  if (arrowVizEnabled.get()) {
+    drawArrows();
+  }
+
+  if (streamlineVizEnabled.get()) {
+    drawStreamlines();
+  }
+}
+
+void VolumeGridVectorQuantity::buildCustomUI() {
+
+  // Select which viz to use
+  ImGui::SameLine();
+  if (ImGui::Button("Mode")) {
+    ImGui::OpenPopup("ModePopup");
+  }
+  if (ImGui::BeginPopup("ModePopup")) {
+    if (ImGui::MenuItem("Arrows", NULL, &arrowVizEnabled.get())) setArrowVizEnabled(getArrowVizEnabled());
+    if (ImGui::MenuItem("Streamlines", NULL, &streamlineVizEnabled.get()))
+      setStreamlineVizEnabled(getStreamlineVizEnabled());
+    ImGui::EndPopup();
+  }
+
+  buildVectorUI();
+
+  if (arrowVizEnabled.get()) {
+    ImGui::PushItemWidth(100);
+    if (ImGui::InputInt("Stride", &sampleStride.get())) setSampleStride(std::max(sampleStride.get(), 1));
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Jitter", &sampleJitter.get())) setSampleJitter(getSampleJitter());
+  }
+
+  if (streamlineVizEnabled.get()) {
+    ImGui::TextUnformatted("Streamlines:");
+    ImGui::PushItemWidth(100);
+    if (streamlineSeedsManual.empty()) {
+      if (ImGui::InputInt("Seeds per axis", &streamlineSeedsPerAxis.get())) {
+        setStreamlineSeedsPerAxis(std::max(streamlineSeedsPerAxis.get(), 1));
+      }
+    }
+    if (ImGui::InputInt("Max steps", &streamlineMaxSteps.get())) {
+      setStreamlineMaxSteps(std::max(streamlineMaxSteps.get(), 1));
+    }
+    if (ImGui::SliderFloat("Tube radius", streamlineRadius.get().getValuePtr(), 0.0, .1, "%.5f",
+                           ImGuiSliderFlags_Logarithmic | ImGuiSliderFlags_NoRoundToFormat)) {
+      streamlineRadius.manuallyChanged();
+      requestRedraw();
+    }
+    ImGui::PopItemWidth();
+  }
+}
+
+void VolumeGridVectorQuantity::buildPickUI(size_t ind) {
+  ImGui::TextUnformatted(name.c_str());
+  ImGui::NextColumn();
+
+  std::stringstream buffer;
+  glm::vec3 vec = vectors.getValue(ind);
+  buffer << vec;
+  ImGui::TextUnformatted(buffer.str().c_str());
+
+  ImGui::NextColumn();
+  ImGui::NextColumn();
+  ImGui::Text("magnitude: %g", glm::length(vec));
+  ImGui::NextColumn();
+}
+
+void VolumeGridVectorQuantity::refresh() {
+  vectorProgram.reset();
+  streamlineProgram.reset();
+  Quantity::refresh();
+}
+
+std::string VolumeGridVectorQuantity::niceName() { return name + " (vector)"; }
+
+void VolumeGridVectorQuantity::updateMaxLength() {
+  if (vectorLengthRangeManuallySet) return;
+
+  vectors.ensureHostBufferPopulated();
+  float maxLength = 0.;
+  for (const glm::vec3& v : vectors.data) maxLength = std::max(maxLength, glm::length(v));
+  vectorLengthRange = maxLength;
+}
+
+// === Arrows
+
+std::array<size_t, 3> VolumeGridVectorQuantity::sampleRes(size_t stride) {
+  std::array<size_t, 3> res;
+  for (int k = 0; k < 3; k++) res[k] = (parent.steps[k] + stride - 1) / stride;
+  return res;
+}
+
+size_t VolumeGridVectorQuantity::effectiveSampleStride() {
+  size_t stride = static_cast<size_t>(std::max(sampleStride.get(), 1));
+  if (maxDrawnVectors == 0) return stride;
+
+  size_t maxStride = std::max(std::max(parent.steps[0], parent.steps[1]), parent.steps[2]);
+  while (stride < maxStride) {
+    std::array<size_t, 3> res = sampleRes(stride);
+    if (res[0] * res[1] * res[2] <= maxDrawnVectors) break;
+    stride++;
+  }
+  return stride;
+}
+
+void VolumeGridVectorQuantity::drawArrows() {
+  if (!vectorProgram) {
+    createArrowProgram();
+  }
+
+  size_t stride = effectiveSampleStride();
+  std::array<size_t, 3> res = sampleRes(stride);
+
+  parent.setStructureUniforms(*vectorProgram);
+  vectorProgram->setUniform("u_boundMin", parent.bound_min);
+  vectorProgram->setUniform("u_boundMax", parent.bound_max);
+  vectorProgram->setUniform("u_gridRes", glm::vec3(parent.steps[0], parent.steps[1], parent.steps[2]));
+  vectorProgram->setUniform("u_sampleRes", glm::vec3(res[0], res[1], res[2]));
+  vectorProgram->setUniform("u_sampleStride", static_cast<float>(stride));
+  vectorProgram->setUniform("u_sampleJitter", sampleJitter.get() ? 1.f : 0.f);
+  vectorProgram->setUniform("u_radius", vectorRadius.get().asAbsolute());
+  vectorProgram->setUniform("u_baseColor", vectorColor.get());
+  if (vectorType == VectorType::AMBIENT) {
+    vectorProgram->setUniform("u_lengthMult", 1.0);
+  } else {
+    vectorProgram->setUniform("u_lengthMult", vectorLengthMult.get().asAbsolute() / vectorLengthRange);
+  }
+
+  vectorProgram->setVertexCount(res[0] * res[1] * res[2]);
+  vectorProgram->draw();
+}
+
+void VolumeGridVectorQuantity::createArrowProgram() {
+
+  std::vector<std::string> rules = parent.addStructureRules({"SHADE_BASECOLOR"});
+  if (parent.wantsCullPosition()) {
+    rules.push_back("VECTOR_CULLPOS_FROM_TAIL");
+  }
+
+  // Node positions and the sampled subset are computed from the vertex ID, only the vectors are uploaded
+  vectorProgram = render::engine->requestShader("GRID_NODE_VECTOR", rules);
+  vectorProgram->setTextureFromAttributeBuffer("t_gridVectors", vectors.getRenderAttributeBuffer());
+
+  render::engine->setMaterial(*vectorProgram, getMaterial());
+}
+
+// === Streamlines
+
+std::vector<glm::vec3> VolumeGridVectorQuantity::streamlineSeedPoints() {
+  if (!streamlineSeedsManual.empty()) return streamlineSeedsManual;
+
+  // A regular lattice, at the centers of its cells
+  size_t n = static_cast<size_t>(std::max(streamlineSeedsPerAxis.get(), 1));
+  std::vector<glm::vec3> seeds;
+  seeds.reserve(n * n * n);
+  for (size_t iX = 0; iX < n; iX++) {
+    for (size_t iY = 0; iY < n; iY++) {
+      for (size_t iZ = 0; iZ < n; iZ++) {
+        glm::vec3 t = (glm::vec3(iX, iY, iZ) + 0.5f) / static_cast<float>(n);
+        seeds.push_back((1.f - t) * parent.bound_min + t * parent.bound_max);
+      }
+    }
+  }
+  return seeds;
+}
+
+void VolumeGridVectorQuantity::traceStreamlines() {
+  vectors.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& data = vectors.data;
+  const std::array<size_t, 3> res = parent.steps;
+  const glm::vec3 boundMin = parent.bound_min;
+  const glm::vec3 boundMax = parent.bound_max;
+  const float h = 0.5f * parent.minGridSpacing();
+  const float minLength = 1e-6f * vectorLengthRange;
+  const size_t maxSteps = static_cast<size_t>(std::max(streamlineMaxSteps.get(), 1));
+
+  auto field = [&](glm::vec3 p) { return sampleGridVectors(data, res, boundMin, boundMax, p); };
+  auto inBounds = [&](glm::vec3 p) {
+    return glm::all(glm::greaterThanEqual(p, boundMin)) && glm::all(glm::lessThanEqual(p, boundMax));
+  };
+
+  // Steps of fixed length along the field direction (midpoint rule), until the field vanishes or leaves the grid
+  auto traceDirection = [&](glm::vec3 p, float sign, std::vector<glm::vec3>& out) {
+    for (size_t iStep = 0; iStep < maxSteps; iStep++) {
+      glm::vec3 v0 = field(p);
+      if (!(glm::length(v0) > minLength)) return;
+      glm::vec3 v1 = field(p + (0.5f * sign * h) * glm::normalize(v0));
+      if (!(glm::length(v1) > minLength)) return;
+      p += (sign * h) * glm::normalize(v1);
+      if (!inBounds(p)) return;
+      out.push_back(p);
+    }
+  };
+
+  std::vector<glm::vec3> seeds = streamlineSeedPoints();
+  streamlines.assign(seeds.size(), std::vector<glm::vec3>());
+  parallelFor(0, seeds.size(), [&](size_t start, size_t end) {
+    std::vector<glm::vec3> backward;
+    for (size_t iS = start; iS < end; iS++) {
+      std::vector<glm::vec3>& line = streamlines[iS];
+      if (!inBounds(seeds[iS])) continue;
+
+      backward.clear();
+      traceDirection(seeds[iS], -1.f, backward);
+      line.assign(backward.rbegin(), backward.rend());
+      line.push_back(seeds[iS]);
+      traceDirection(seeds[iS], 1.f, line);
+    }
+  });
+
+  streamlinesTraced = true;
+}
+
+void VolumeGridVectorQuantity::invalidateStreamlines() {
+  streamlinesTraced = false;
+  streamlines.clear();
+  streamlineProgram.reset();
+  requestRedraw();
+}
+
+const std::vector<std::vector<glm::vec3>>& VolumeGridVectorQuantity::getStreamlines() {
+  if (!streamlinesTraced) traceStreamlines();
+  return streamlines;
+}
+
+void VolumeGridVectorQuantity::drawStreamlines() {
+  if (!streamlineProgram) {
+    createStreamlineProgram();
+  }
+
+  // (the material setter only knows about the arrow program)
+  if (streamlineProgramMaterial != getMaterial()) {
+    streamlineProgramMaterial = getMaterial();
+    render::engine->setMaterial(*streamlineProgram, streamlineProgramMaterial);
+  }
+
+  parent.setStructureUniforms(*streamlineProgram);
+  streamlineProgram->setUniform("u_radius", streamlineRadius.get().asAbsolute());
+  streamlineProgram->setUniform("u_baseColor", vectorColor.get());
+  streamlineProgram->draw();
+}
+
+void VolumeGridVectorQuantity::createStreamlineProgram() {
+  const std::vector<std::vector<glm::vec3>>& lines = getStreamlines();
+
+  // One line strip per streamline, with the end points repeated as their own adjacent points, like curve network
+  // strips
+  const uint32_t restartInd = std::numeric_limits<uint32_t>::max();
+  std::vector<glm::vec3> positions;
+  std::vector<uint32_t> inds;
+  for (const std::vector<glm::vec3>& line : lines) {
+    if (line.size() < 2) continue;
+    uint32_t start = static_cast<uint32_t>(positions.size());
+    positions.insert(positions.end(), line.begin(), line.end());
+    uint32_t end = static_cast<uint32_t>(positions.size());
+    inds.push_back(start);
+    for (uint32_t i = start; i < end; i++) inds.push_back(i);
+    inds.push_back(end - 1);
+    inds.push_back(restartInd);
+  }
+
+  std::vector<std::string> rules = parent.addStructureRules({"SHADE_BASECOLOR"});
+  if (parent.wantsCullPosition()) {
+    rules.push_back("TUBE_CULLPOS_FROM_MID");
+  }
+  streamlineProgram = render::engine->requestShader("RIBBON_TUBE", rules);
+
+  streamlineProgram->setAttribute("a_position", positions);
+  streamlineProgram->setPrimitiveRestartIndex(restartInd);
+  streamlineProgram->setIndex(inds);
+
+  streamlineProgramMaterial = getMaterial();
+  render::engine->setMaterial(*streamlineProgram, streamlineProgramMaterial);
+}
+
+// === Getters and setters
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setArrowVizEnabled(bool val) {
+  arrowVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridVectorQuantity::getArrowVizEnabled() { return arrowVizEnabled.get(); }
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setSampleStride(size_t val) {
+  sampleStride = static_cast<int>(std::max(val, static_cast<size_t>(1)));
+  requestRedraw();
+  return this;
+}
+size_t VolumeGridVectorQuantity::getSampleStride() { return static_cast<size_t>(sampleStride.get()); }
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setSampleJitter(bool val) {
+  sampleJitter = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridVectorQuantity::getSampleJitter() { return sampleJitter.get(); }
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setStreamlineVizEnabled(bool val) {
+  streamlineVizEnabled = val;
+  requestRedraw();
+  return this;
+}
+bool VolumeGridVectorQuantity::getStreamlineVizEnabled() { return streamlineVizEnabled.get(); }
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setStreamlineSeedsPerAxis(size_t val) {
+  streamlineSeedsPerAxis = static_cast<int>(std::max(val, static_cast<size_t>(1)));
+  invalidateStreamlines();
+  return this;
+}
+size_t VolumeGridVectorQuantity::getStreamlineSeedsPerAxis() {
+  return static_cast<size_t>(streamlineSeedsPerAxis.get());
+}
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setStreamlineSeeds(const std::vector<glm::vec3>& seeds) {
+  streamlineSeedsManual = seeds;
+  invalidateStreamlines();
+  return this;
+}
+std::vector<glm::vec3> VolumeGridVectorQuantity::getStreamlineSeeds() { return streamlineSeedPoints(); }
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setStreamlineMaxSteps(size_t val) {
+  streamlineMaxSteps = static_cast<int>(std::max(val, static_cast<size_t>(1)));
+  invalidateStreamlines();
+  return this;
+}
+size_t VolumeGridVectorQuantity::getStreamlineMaxSteps() { return static_cast<size_t>(streamlineMaxSteps.get()); }
+
+VolumeGridVectorQuantity* VolumeGridVectorQuantity::setStreamlineRadius(double val, bool isRelative) {
+  streamlineRadius = ScaledValue<float>(val, isRelative);
+  requestRedraw();
+  return this;
+}
+double VolumeGridVectorQuantity::getStreamlineRadius() { return streamlineRadius.get().asAbsolute(); }
+
+} // namespace polyscope
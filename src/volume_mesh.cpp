@@ -3,8 +3,9 @@
 #include "polyscope/volume_mesh.h"
 
 #include "polyscope/color_management.h"
-#include "polyscope/combining_hash_functions.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
+#include "polyscope/profiling.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
 #include "polyscope/utilities.h"
@@ -14,7 +15,6 @@
 
 #include <algorithm>
 #include <numeric>
-#include <unordered_map>
 #include <utility>
 
 namespace polyscope {
@@ -97,6 +97,50 @@ const std::vector<std::vector<std::array<size_t, 3>>> VolumeMesh::stencilHex =
 
 VolumeMesh::VolumeMesh(std::string name, const std::vector<glm::vec3>& vertexPositions_,
                        const std::vector<std::array<uint32_t, 8>>& cellIndices_)
+    : VolumeMesh(name, vertexPositions_, splitCellsByType(cellIndices_)) {}
+
+VolumeMesh::VolumeMesh(std::string name, const std::vector<glm::vec3>& vertexPositions_,
+                       std::vector<std::array<uint32_t, 4>> tetIndices_,
+                       std::vector<std::array<uint32_t, 8>> hexIndices_)
+    : VolumeMesh(name, vertexPositions_, tetsThenHexes(std::move(tetIndices_), std::move(hexIndices_))) {}
+
+VolumeMesh::CellsByType VolumeMesh::splitCellsByType(const std::vector<std::array<uint32_t, 8>>& cellIndices) {
+  CellsByType split;
+  for (const std::array<uint32_t, 8>& cell : cellIndices) {
+    if (cell[4] < INVALID_IND_32) {
+      split.hexes.push_back(cell);
+    } else {
+      split.tets.push_back({cell[0], cell[1], cell[2], cell[3]});
+    }
+  }
+
+  // Only a mesh of both types needs to record which cells are hexes
+  if (!split.tets.empty() && !split.hexes.empty()) {
+    split.hexStart.resize(cellIndices.size() + 1);
+    split.hexStart[0] = 0;
+    for (size_t iC = 0; iC < cellIndices.size(); iC++) {
+      split.hexStart[iC + 1] = split.hexStart[iC] + (cellIndices[iC][4] < INVALID_IND_32 ? 1 : 0);
+    }
+  }
+  return split;
+}
+
+VolumeMesh::CellsByType VolumeMesh::tetsThenHexes(std::vector<std::array<uint32_t, 4>> tetIndices,
+                                                  std::vector<std::array<uint32_t, 8>> hexIndices) {
+  CellsByType split;
+  split.tets = std::move(tetIndices);
+  split.hexes = std::move(hexIndices);
+  if (!split.tets.empty() && !split.hexes.empty()) {
+    size_t nTet = split.tets.size();
+    split.hexStart.resize(nTet + split.hexes.size() + 1);
+    for (size_t iC = 0; iC < split.hexStart.size(); iC++) {
+      split.hexStart[iC] = iC < nTet ? 0 : iC - nTet;
+    }
+  }
+  return split;
+}
+
+VolumeMesh::VolumeMesh(std::string name, const std::vector<glm::vec3>& vertexPositions_, CellsByType cellsByType_)
     : QuantityStructure<VolumeMesh>(name, typeName()),
       // clang-format off
 
@@ -109,6 +153,7 @@ vertexPositions(        uniquePrefix() + "vertexPositions",     vertexPositionsD
 triangleVertexInds(     uniquePrefix() + "triangleVertexInds",  triangleVertexIndsData),
 triangleFaceInds(       uniquePrefix() + "triangleFaceInds",    triangleFaceIndsData),
 triangleCellInds(       uniquePrefix() + "triangleCellInds",    triangleCellIndsData),
+triangleCells(          uniquePrefix() + "triangleCells",       triangleCellsData),
 
 // internal triangle data for rendering
 baryCoord(              uniquePrefix() + "baryCoord",           baryCoordData),
@@ -121,7 +166,9 @@ cellCenters(            uniquePrefix() + "cellCenters",         cellCentersData,
 
 
 // == core input data
-cells(cellIndices_),
+tetCells(std::move(cellsByType_.tets)),
+hexCells(std::move(cellsByType_.hexes)),
+cellHexStart(std::move(cellsByType_.hexStart)),
 vertexPositionsData(vertexPositions_), 
 
 // == persistent options
@@ -130,6 +177,7 @@ interiorColor(uniquePrefix() + "interiorColor", color.get()),
 edgeColor(uniquePrefix() + "edgeColor", glm::vec3{0., 0., 0.}), 
 material(uniquePrefix() + "material", "clay"),
 edgeWidth(uniquePrefix() + "edgeWidth", 0.), 
+skipHiddenInteriorFaces(uniquePrefix() + "skipHiddenInteriorFaces", true),
 
 // == misc values
 activeLevelSetQuantity(nullptr) 
@@ -148,75 +196,197 @@ activeLevelSetQuantity(nullptr)
   updateObjectSpaceBounds();
 }
 
-void VolumeMesh::computeCounts() {
+namespace {
 
-  // == Populate counts
-  nFacesCount = 0;
-  nFacesTriangulationCount = 0;
+// A face, as its distinct vertex indices in increasing order, padded with INVALID_IND_32
+using SortedFace = std::array<uint32_t, 4>;
 
-  // == Populate interior/exterior faces
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
-    VolumeCellType cellT = cellType(iC);
-    // Iterate over faces
-    for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
-      nFacesCount++;
-      nFacesTriangulationCount += face.size();
-    }
-  }
-
-  // == Step 1: count occurences of each face
-  std::unordered_map<std::array<uint32_t, 4>, int, polyscope::hash_combine::hash<std::array<uint32_t, 4>>> faceCounts;
-
-  std::set<size_t> faceInds; // Scratch map
+inline void compareSwap(uint32_t& a, uint32_t& b) {
+  if (b < a) std::swap(a, b);
+}
 
-  // Build a sorted list of the indices of this face
+// Sort with a fixed sorting network, then drop repeated vertices (from degenerate cells)
+inline SortedFace sortFace(SortedFace f) {
+  compareSwap(f[0], f[1]);
+  compareSwap(f[2], f[3]);
+  compareSwap(f[0], f[2]);
+  compareSwap(f[1], f[3]);
+  compareSwap(f[1], f[2]);
+  size_t n = 1;
+  for (size_t j = 1; j < 4; j++) {
+    if (f[j] != f[n - 1]) f[n++] = f[j];
+  }
+  for (size_t j = n; j < 4; j++) f[j] = INVALID_IND_32;
+  return f;
+}
 
-  // Helper to build a sorted-index array for a face
-  auto generateSortedFace = [&](const std::array<uint32_t, 8>& cell, const std::vector<std::array<size_t, 3>>& face) {
-    faceInds.clear();
-    for (const std::array<size_t, 3>& tri : face) {
-      for (int j = 0; j < 3; j++) {
-        faceInds.insert(cell[tri[j]]);
-      }
+// Stable parallel LSD radix sort of vals by keys
+void radixSortByKey(std::vector<uint64_t>& keys, std::vector<uint32_t>& vals) {
+  const size_t n = keys.size();
+  const size_t nBlocks = std::max<size_t>(1, std::min<size_t>(256, n / 65536));
+  const size_t blockSize = (n + nBlocks - 1) / nBlocks;
+  std::vector<uint64_t> keysOut(n);
+  std::vector<uint32_t> valsOut(n);
+
+  for (int shift = 0; shift < 64; shift += 8) {
+
+    // Histogram the digit in each block
+    std::vector<std::array<size_t, 256>> offsets(nBlocks);
+    parallelFor(
+        0, nBlocks,
+        [&](size_t blockStart, size_t blockEnd) {
+          for (size_t iB = blockStart; iB < blockEnd; iB++) {
+            std::array<size_t, 256>& counts = offsets[iB];
+            counts.fill(0);
+            for (size_t i = iB * blockSize; i < std::min(n, (iB + 1) * blockSize); i++) {
+              counts[(keys[i] >> shift) & 0xFF]++;
+            }
+          }
+        },
+        1);
+
+    // Skip digits which are the same for every key (e.g. the high bits of vertex indices)
+    bool allSame = false;
+    for (size_t d = 0; d < 256; d++) {
+      size_t total = 0;
+      for (size_t iB = 0; iB < nBlocks; iB++) total += offsets[iB][d];
+      if (total == n) allSame = true;
     }
-    std::array<uint32_t, 4> sortedFace{7777, 7777, 7777, 7777};
-    int j = 0;
-    for (size_t ind : faceInds) {
-      sortedFace[j] = ind;
-      j++;
+    if (allSame) continue;
+
+    // Turn the counts in to output offsets, ordered by digit then block
+    size_t sum = 0;
+    for (size_t d = 0; d < 256; d++) {
+      for (size_t iB = 0; iB < nBlocks; iB++) {
+        size_t c = offsets[iB][d];
+        offsets[iB][d] = sum;
+        sum += c;
+      }
     }
-    return sortedFace;
-  };
 
-  // Iterate over cells
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
-    VolumeCellType cellT = cellType(iC);
+    // Scatter
+    parallelFor(
+        0, nBlocks,
+        [&](size_t blockStart, size_t blockEnd) {
+          for (size_t iB = blockStart; iB < blockEnd; iB++) {
+            std::array<size_t, 256>& next = offsets[iB];
+            for (size_t i = iB * blockSize; i < std::min(n, (iB + 1) * blockSize); i++) {
+              size_t pos = next[(keys[i] >> shift) & 0xFF]++;
+              keysOut[pos] = keys[i];
+              valsOut[pos] = vals[i];
+            }
+          }
+        },
+        1);
+
+    keys.swap(keysOut);
+    vals.swap(valsOut);
+  }
+}
 
-    // Iterate over faces
+} // namespace
+
+void VolumeMesh::computeCounts() {
+  profiling::ScopedTimer timer("VolumeMesh::computeCounts");
+
+  // For each cell type, the distinct local vertices of each face in its stencil
+  std::array<std::vector<SortedFace>, 2> stencilFaceVerts;
+  for (VolumeCellType cellT : {VolumeCellType::TET, VolumeCellType::HEX}) {
     for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
-      std::array<uint32_t, 4> sortedFace = generateSortedFace(cell, face);
-      // Add to the count
-      if (faceCounts.find(sortedFace) == faceCounts.end()) {
-        faceCounts[sortedFace] = 0;
+      SortedFace localVerts{INVALID_IND_32, INVALID_IND_32, INVALID_IND_32, INVALID_IND_32};
+      size_t n = 0;
+      for (const std::array<size_t, 3>& tri : face) {
+        for (size_t v : tri) {
+          if (std::find(localVerts.begin(), localVerts.begin() + n, v) == localVerts.begin() + n) {
+            localVerts[n++] = v;
+          }
+        }
       }
-      faceCounts[sortedFace]++;
+      stencilFaceVerts[cellT == VolumeCellType::HEX].push_back(localVerts);
     }
   }
 
-  // Iterate a second time; all faces which were seen more than once are inteior
-  faceIsInterior.clear();
+  // == Populate counts, and the index of the first face of each block of cells
+  const size_t nCellBlocks = std::max<size_t>(1, std::min<size_t>(1024, nCells() / 4096));
+  const size_t cellBlockSize = (nCells() + nCellBlocks - 1) / nCellBlocks;
+  std::vector<size_t> cellBlockFaceStart(nCellBlocks + 1, 0);
+  nFacesCount = 0;
+  nFacesTriangulationCount = 0;
   for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
     VolumeCellType cellT = cellType(iC);
-
     // Iterate over faces
     for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
-      std::array<uint32_t, 4> sortedFace = generateSortedFace(cell, face);
-      faceIsInterior.push_back(faceCounts[sortedFace] > 1);
+      nFacesCount++;
+      nFacesTriangulationCount += face.size();
     }
+    cellBlockFaceStart[iC / cellBlockSize + 1] = nFacesCount;
   }
+  for (size_t iB = 1; iB <= nCellBlocks; iB++) {
+    cellBlockFaceStart[iB] = std::max(cellBlockFaceStart[iB], cellBlockFaceStart[iB - 1]);
+  }
+  if (nFacesCount >= INVALID_IND_32) {
+    exception("volume mesh " + name + " has too many faces");
+  }
+
+  // == Step 1: build the sorted vertex list of each face, and a sort key from its first two vertices
+  // (the mesh's iteration order of faces is the face index)
+  std::vector<SortedFace> sortedFaces(nFacesCount);
+  std::vector<uint64_t> faceKeys(nFacesCount);
+  std::vector<uint32_t> faceOrder(nFacesCount);
+  parallelFor(
+      0, nCellBlocks,
+      [&](size_t blockStart, size_t blockEnd) {
+        for (size_t iB = blockStart; iB < blockEnd; iB++) {
+          size_t iF = cellBlockFaceStart[iB];
+          for (size_t iC = iB * cellBlockSize; iC < std::min(nCells(), (iB + 1) * cellBlockSize); iC++) {
+            const uint32_t* cell = cellVertices(iC);
+            for (const SortedFace& localVerts : stencilFaceVerts[cellType(iC) == VolumeCellType::HEX]) {
+              SortedFace f;
+              for (size_t j = 0; j < 4; j++) {
+                f[j] = localVerts[j] == INVALID_IND_32 ? INVALID_IND_32 : cell[localVerts[j]];
+              }
+              f = sortFace(f);
+              sortedFaces[iF] = f;
+              faceKeys[iF] = (static_cast<uint64_t>(f[0]) << 32) | f[1];
+              faceOrder[iF] = iF;
+              iF++;
+            }
+          }
+        }
+      },
+      1);
+
+  // == Step 2: sort the faces, so that copies of the same face are adjacent
+  radixSortByKey(faceKeys, faceOrder);
+
+  // == Step 3: all faces which were seen more than once are interior
+  // Runs of equal keys share their first two vertices, and are short; compare the remaining vertices within each.
+  faceIsInterior.assign(nFacesCount, 0);
+  parallelFor(0, nFacesCount, [&](size_t blockStart, size_t blockEnd) {
+    // handle each run which starts in this block
+    size_t runStart = blockStart;
+    while (runStart > 0 && runStart < nFacesCount && faceKeys[runStart] == faceKeys[runStart - 1]) runStart++;
+    while (runStart < blockEnd) {
+      size_t runEnd = runStart + 1;
+      while (runEnd < nFacesCount && faceKeys[runEnd] == faceKeys[runStart]) runEnd++;
+
+      if (runEnd - runStart > 1) {
+        auto lastVerts = [&](uint32_t iF) { return std::make_pair(sortedFaces[iF][2], sortedFaces[iF][3]); };
+        std::sort(faceOrder.begin() + runStart, faceOrder.begin() + runEnd,
+                  [&](uint32_t a, uint32_t b) { return lastVerts(a) < lastVerts(b); });
+        for (size_t i = runStart; i < runEnd;) {
+          size_t j = i + 1;
+          while (j < runEnd && lastVerts(faceOrder[j]) == lastVerts(faceOrder[i])) j++;
+          if (j - i > 1) {
+            for (size_t k = i; k < j; k++) faceIsInterior[faceOrder[k]] = 1;
+          }
+          i = j;
+        }
+      }
+
+      runStart = runEnd;
+    }
+  });
 }
 
 
@@ -225,136 +395,130 @@ void VolumeMesh::computeTets() {
   // https://www.researchgate.net/profile/Julien-Dompierre/publication/221561839_How_to_Subdivide_Pyramids_Prisms_and_Hexahedra_into_Tetrahedra/links/0912f509c0b7294059000000/How-to-Subdivide-Pyramids-Prisms-and-Hexahedra-into-Tetrahedra.pdf?origin=publication_detail
   // It's a bit hard to look at but it works
   // Uses vertex numberings to ensure consistent diagonals between faces, and keeps tet counts to 5 or 6 per hex
-  size_t tetCount = 0;
-  // Get number of tets first
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    switch (cellType(iC)) {
-    case VolumeCellType::HEX: {
-      std::array<size_t, 8> sortedNumbering;
-      std::iota(sortedNumbering.begin(), sortedNumbering.end(), 0);
-      std::sort(sortedNumbering.begin(), sortedNumbering.end(),
-                [this, iC](size_t a, size_t b) -> bool { return cells[iC][a] < cells[iC][b]; });
-      std::array<size_t, 8> rotatedNumbering;
-      std::copy(rotationMap[sortedNumbering[0]].begin(), rotationMap[sortedNumbering[0]].end(),
-                rotatedNumbering.begin());
-      size_t diagCount = 0;
-      auto checkDiagonal = [this, rotatedNumbering, iC](size_t a1, size_t a2, size_t b1, size_t b2) {
-        return (cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b2]]) ||
-               (cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b2]]);
-      };
-      if (checkDiagonal(1, 7, 2, 5)) {
-        diagCount++;
-      }
-      if (checkDiagonal(3, 7, 2, 6)) {
-        diagCount++;
-      }
-      if (checkDiagonal(4, 7, 5, 6)) {
-        diagCount++;
-      }
-      if (diagCount == 0) {
-        tetCount += 5;
-      } else {
-        tetCount += 6;
-      }
-      break;
+
+  // A pure-tet mesh is its own decomposition
+  if (hexCells.empty()) {
+    tetDecomposition.clear();
+    return;
+  }
+
+  // Orient a hex so its minimum vertex sits at corner 0 and its face diagonals are in a canonical configuration,
+  // returning the number of diagonals not incident to V_0
+  auto orientHex = [](const uint32_t* cell, std::array<size_t, 8>& rotatedNumbering) -> size_t {
+    std::array<size_t, 8> sortedNumbering;
+    std::iota(sortedNumbering.begin(), sortedNumbering.end(), 0);
+    std::sort(sortedNumbering.begin(), sortedNumbering.end(),
+              [cell](size_t a, size_t b) -> bool { return cell[a] < cell[b]; });
+    std::copy(rotationMap[sortedNumbering[0]].begin(), rotationMap[sortedNumbering[0]].end(),
+              rotatedNumbering.begin());
+    size_t n = 0;
+    size_t diagCount = 0;
+    // Diagonal exists on the pair of vertices which contain the minimum vertex number
+    auto checkDiagonal = [cell, &rotatedNumbering](size_t a1, size_t a2, size_t b1, size_t b2) {
+      return (cell[rotatedNumbering[a1]] < cell[rotatedNumbering[b1]] &&
+              cell[rotatedNumbering[a1]] < cell[rotatedNumbering[b2]]) ||
+             (cell[rotatedNumbering[a2]] < cell[rotatedNumbering[b1]] &&
+              cell[rotatedNumbering[a2]] < cell[rotatedNumbering[b2]]);
+    };
+    // Minimum vertex will always have 3 diagonals, check other three faces
+    if (checkDiagonal(1, 7, 2, 5)) {
+      n += 4;
+      diagCount++;
     }
-    case VolumeCellType::TET:
-      tetCount += 1;
-      break;
+    if (checkDiagonal(3, 7, 2, 6)) {
+      n += 2;
+      diagCount++;
     }
-  }
-  // Mark each edge as real or not (in the original mesh)
-  std::vector<std::array<bool, 6>> realEdges;
-  // Each hex can make up to 6 tets
-  tets.resize(tetCount);
-  realEdges.resize(tetCount);
-  size_t tetIdx = 0;
-  for (size_t iC = 0; iC < nCells(); iC++) {
-    switch (cellType(iC)) {
-    case VolumeCellType::HEX: {
-      std::array<size_t, 8> sortedNumbering;
-      std::iota(sortedNumbering.begin(), sortedNumbering.end(), 0);
-      std::sort(sortedNumbering.begin(), sortedNumbering.end(),
-                [this, iC](size_t a, size_t b) -> bool { return cells[iC][a] < cells[iC][b]; });
-      std::array<size_t, 8> rotatedNumbering;
-      std::copy(rotationMap[sortedNumbering[0]].begin(), rotationMap[sortedNumbering[0]].end(),
-                rotatedNumbering.begin());
-      size_t n = 0;
-      size_t diagCount = 0;
-      // Diagonal exists on the pair of vertices which contain the minimum vertex number
-      auto checkDiagonal = [this, rotatedNumbering, iC](size_t a1, size_t a2, size_t b1, size_t b2) {
-        return (cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a1]] < cells[iC][rotatedNumbering[b2]]) ||
-               (cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b1]] &&
-                cells[iC][rotatedNumbering[a2]] < cells[iC][rotatedNumbering[b2]]);
-      };
-      // Minimum vertex will always have 3 diagonals, check other three faces
-      if (checkDiagonal(1, 7, 2, 5)) {
-        n += 4;
-        diagCount++;
-      }
-      if (checkDiagonal(3, 7, 2, 6)) {
-        n += 2;
-        diagCount++;
-      }
-      if (checkDiagonal(4, 7, 5, 6)) {
-        n += 1;
-        diagCount++;
-      }
-      // Rotate by 120 or 240 degrees depending on diagonal positions
-      if (n == 1 || n == 6) {
-        size_t temp = rotatedNumbering[1];
-        rotatedNumbering[1] = rotatedNumbering[4];
-        rotatedNumbering[4] = rotatedNumbering[3];
-        rotatedNumbering[3] = temp;
-        temp = rotatedNumbering[5];
-        rotatedNumbering[5] = rotatedNumbering[6];
-        rotatedNumbering[6] = rotatedNumbering[2];
-        rotatedNumbering[2] = temp;
-      } else if (n == 2 || n == 5) {
-        size_t temp = rotatedNumbering[1];
-        rotatedNumbering[1] = rotatedNumbering[3];
-        rotatedNumbering[3] = rotatedNumbering[4];
-        rotatedNumbering[4] = temp;
-        temp = rotatedNumbering[5];
-        rotatedNumbering[5] = rotatedNumbering[2];
-        rotatedNumbering[2] = rotatedNumbering[6];
-        rotatedNumbering[6] = temp;
+    if (checkDiagonal(4, 7, 5, 6)) {
+      n += 1;
+      diagCount++;
+    }
+    // Rotate by 120 or 240 degrees depending on diagonal positions
+    if (n == 1 || n == 6) {
+      size_t temp = rotatedNumbering[1];
+      rotatedNumbering[1] = rotatedNumbering[4];
+      rotatedNumbering[4] = rotatedNumbering[3];
+      rotatedNumbering[3] = temp;
+      temp = rotatedNumbering[5];
+      rotatedNumbering[5] = rotatedNumbering[6];
+      rotatedNumbering[6] = rotatedNumbering[2];
+      rotatedNumbering[2] = temp;
+    } else if (n == 2 || n == 5) {
+      size_t temp = rotatedNumbering[1];
+      rotatedNumbering[1] = rotatedNumbering[3];
+      rotatedNumbering[3] = rotatedNumbering[4];
+      rotatedNumbering[4] = temp;
+      temp = rotatedNumbering[5];
+      rotatedNumbering[5] = rotatedNumbering[2];
+      rotatedNumbering[2] = rotatedNumbering[6];
+      rotatedNumbering[6] = temp;
+    }
+    return diagCount;
+  };
+
+  // Count the tets of each cell, then a prefix sum gives each cell the offset its tets are written at. Both passes run
+  // in parallel, and the output does not depend on the thread count.
+  size_t nCellsCount = nCells();
+  std::vector<size_t> cellTetStart(nCellsCount + 1, 0);
+  parallelFor(0, nCellsCount, [&](size_t blockStart, size_t blockEnd) {
+    std::array<size_t, 8> rotatedNumbering;
+    for (size_t iC = blockStart; iC < blockEnd; iC++) {
+      switch (cellType(iC)) {
+      case VolumeCellType::HEX:
+        cellTetStart[iC + 1] = orientHex(cellVertices(iC), rotatedNumbering) == 0 ? 5 : 6;
+        break;
+      case VolumeCellType::TET:
+        cellTetStart[iC + 1] = 1;
+        break;
       }
+    }
+  });
+  for (size_t iC = 0; iC < nCellsCount; iC++) {
+    cellTetStart[iC + 1] += cellTetStart[iC];
+  }
 
-      // Map final tets according to diagonalMap and the number of diagonals not incident to V_0
-      std::array<std::array<size_t, 4>, 6> tetMap = diagonalMap[diagCount];
-      for (size_t k = 0; k < (diagCount == 0 ? 5 : 6); k++) {
-        for (size_t i = 0; i < 4; i++) {
-          tets[tetIdx][i] = cells[iC][rotatedNumbering[tetMap[k][i]]];
+  tetDecomposition.resize(cellTetStart[nCellsCount]);
+  parallelFor(0, nCellsCount, [&](size_t blockStart, size_t blockEnd) {
+    std::array<size_t, 8> rotatedNumbering;
+    for (size_t iC = blockStart; iC < blockEnd; iC++) {
+      size_t tetIdx = cellTetStart[iC];
+      const uint32_t* cell = cellVertices(iC);
+      switch (cellType(iC)) {
+      case VolumeCellType::HEX: {
+        // Map final tets according to diagonalMap and the number of diagonals not incident to V_0
+        size_t diagCount = orientHex(cell, rotatedNumbering);
+        const std::array<std::array<size_t, 4>, 6>& tetMap = diagonalMap[diagCount];
+        for (size_t k = 0; k < (diagCount == 0 ? 5 : 6); k++) {
+          for (size_t i = 0; i < 4; i++) {
+            tetDecomposition[tetIdx][i] = cell[rotatedNumbering[tetMap[k][i]]];
+          }
+          tetIdx++;
         }
-        tetIdx++;
+        break;
       }
-      break;
-    }
-    case VolumeCellType::TET:
-      for (size_t i = 0; i < 4; i++) {
-        tets[tetIdx][i] = cells[iC][i];
+      case VolumeCellType::TET:
+        for (size_t i = 0; i < 4; i++) {
+          tetDecomposition[tetIdx][i] = cell[i];
+        }
+        break;
       }
-      tetIdx++;
-      break;
     }
-  }
+  });
 }
 
 void VolumeMesh::ensureHaveTets() {
-  if (tets.empty()) {
+  if (tetDecomposition.empty() && !hexCells.empty()) {
     computeTets();
   }
 }
 
-size_t VolumeMesh::nTets() {
+const std::vector<std::array<uint32_t, 4>>& VolumeMesh::getTets() {
   ensureHaveTets();
-  return tets.size();
+  return hexCells.empty() ? tetCells : tetDecomposition;
 }
 
+size_t VolumeMesh::nTets() { return getTets().size(); }
+
 void VolumeMesh::addSlicePlaneListener(polyscope::SlicePlane* sp) { volumeSlicePlaneListeners.push_back(sp); }
 
 void VolumeMesh::removeSlicePlaneListener(polyscope::SlicePlane* sp) {
@@ -370,11 +534,13 @@ void VolumeMesh::fillSliceGeometryBuffers(render::ShaderProgram& program) {
 
   // TODO update this to use new standalone buffers
 
-  ensureHaveTets();
+  const std::vector<std::array<uint32_t, 4>>& tets = getTets();
   vertexPositions.ensureHostBufferPopulated();
 
   // TODO port this to managed buffers
 
+  const std::vector<uint32_t>& order = getSliceTetOrder();
+
   std::vector<glm::vec3> point1;
   std::vector<glm::vec3> point2;
   std::vector<glm::vec3> point3;
@@ -384,12 +550,15 @@ void VolumeMesh::fillSliceGeometryBuffers(render::ShaderProgram& program) {
   point2.resize(tetCount);
   point3.resize(tetCount);
   point4.resize(tetCount);
-  for (size_t tetIdx = 0; tetIdx < tets.size(); tetIdx++) {
-    point1[tetIdx] = vertexPositions.data[tets[tetIdx][0]];
-    point2[tetIdx] = vertexPositions.data[tets[tetIdx][1]];
-    point3[tetIdx] = vertexPositions.data[tets[tetIdx][2]];
-    point4[tetIdx] = vertexPositions.data[tets[tetIdx][3]];
-  }
+  parallelFor(0, tetCount, [&](size_t blockStart, size_t blockEnd) {
+    for (size_t i = blockStart; i < blockEnd; i++) {
+      const std::array<uint32_t, 4>& tet = tets[order[i]];
+      point1[i] = vertexPositions.data[tet[0]];
+      point2[i] = vertexPositions.data[tet[1]];
+      point3[i] = vertexPositions.data[tet[2]];
+      point4[i] = vertexPositions.data[tet[3]];
+    }
+  });
 
   program.setAttribute("a_point_1", point1);
   program.setAttribute("a_point_2", point2);
@@ -402,6 +571,173 @@ void VolumeMesh::fillSliceGeometryBuffers(render::ShaderProgram& program) {
 }
 
 
+namespace {
+// Spread the low 21 bits of v out to every third bit, for 3D Morton codes
+uint64_t spreadBits3(uint64_t v) {
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return v;
+}
+} // namespace
+
+const std::vector<uint32_t>& VolumeMesh::getSliceTetOrder() {
+  if (sliceTetOrder.size() != getTets().size()) {
+    computeSliceTetOrder();
+  }
+  return sliceTetOrder;
+}
+
+void VolumeMesh::computeSliceTetOrder() {
+  const std::vector<std::array<uint32_t, 4>>& tets = getTets();
+  vertexPositions.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  size_t nT = tets.size();
+
+  auto tetCenter = [&](size_t iT) {
+    return 0.25f * (pos[tets[iT][0]] + pos[tets[iT][1]] + pos[tets[iT][2]] + pos[tets[iT][3]]);
+  };
+
+  // Sort the tets by the Morton code of their centers, quantized over the bounding box of the mesh
+  glm::vec3 bboxMin, bboxMax;
+  std::tie(bboxMin, bboxMax) = objectSpaceBoundingBox;
+  glm::vec3 scale = glm::vec3(static_cast<float>((1 << 21) - 1)) / glm::max(bboxMax - bboxMin, glm::vec3(1e-20f));
+  std::vector<uint64_t> keys(nT);
+  sliceTetOrder.resize(nT);
+  parallelFor(0, nT, [&](size_t blockStart, size_t blockEnd) {
+    for (size_t iT = blockStart; iT < blockEnd; iT++) {
+      glm::vec3 q = glm::clamp((tetCenter(iT) - bboxMin) * scale, glm::vec3(0.f), glm::vec3((1 << 21) - 1));
+      keys[iT] = spreadBits3(static_cast<uint64_t>(q.x)) | (spreadBits3(static_cast<uint64_t>(q.y)) << 1) |
+                 (spreadBits3(static_cast<uint64_t>(q.z)) << 2);
+      sliceTetOrder[iT] = static_cast<uint32_t>(iT);
+    }
+  });
+  radixSortByKey(keys, sliceTetOrder);
+
+  sliceTetBoundsValid = false;
+}
+
+void VolumeMesh::computeSliceTetBounds() {
+  const std::vector<std::array<uint32_t, 4>>& tets = getTets();
+  const std::vector<uint32_t>& order = getSliceTetOrder();
+  vertexPositions.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  size_t nT = order.size();
+
+  // Leaves bound runs of tets, and each level above bounds groups of the boxes below
+  sliceTetBounds.clear();
+  sliceTetBounds.emplace_back((nT + sliceLeafSize - 1) / sliceLeafSize);
+  parallelFor(
+      0, sliceTetBounds[0].size(),
+      [&](size_t blockStart, size_t blockEnd) {
+        for (size_t iL = blockStart; iL < blockEnd; iL++) {
+          glm::vec3 bMin{std::numeric_limits<float>::infinity()};
+          glm::vec3 bMax{-std::numeric_limits<float>::infinity()};
+          for (size_t i = iL * sliceLeafSize; i < std::min(nT, (iL + 1) * sliceLeafSize); i++) {
+            for (uint32_t iV : tets[order[i]]) {
+              bMin = glm::min(bMin, pos[iV]);
+              bMax = glm::max(bMax, pos[iV]);
+            }
+          }
+          sliceTetBounds[0][iL] = {bMin, bMax};
+        }
+      },
+      1024);
+  while (sliceTetBounds.back().size() > 1) {
+    const std::vector<std::array<glm::vec3, 2>>& below = sliceTetBounds.back();
+    std::vector<std::array<glm::vec3, 2>> level((below.size() + sliceBranching - 1) / sliceBranching);
+    for (size_t iN = 0; iN < level.size(); iN++) {
+      level[iN] = below[iN * sliceBranching];
+      for (size_t iC = iN * sliceBranching + 1; iC < std::min(below.size(), (iN + 1) * sliceBranching); iC++) {
+        level[iN][0] = glm::min(level[iN][0], below[iC][0]);
+        level[iN][1] = glm::max(level[iN][1], below[iC][1]);
+      }
+    }
+    sliceTetBounds.push_back(std::move(level));
+  }
+
+  sliceTetBoundsValid = true;
+}
+
+std::vector<std::array<size_t, 2>> VolumeMesh::computeSlicedTetRanges(glm::vec3 sliceVector, float slicePoint) {
+  const std::vector<std::array<uint32_t, 4>>& tets = getTets();
+  const std::vector<uint32_t>& order = getSliceTetOrder();
+  if (!sliceTetBoundsValid) computeSliceTetBounds();
+  const std::vector<glm::vec3>& pos = vertexPositions.data;
+  size_t nT = order.size();
+
+  // A tet is cut if its vertices lie on both sides of the plane. Allow a little slack, so that no tet which the
+  // shader's arithmetic might cut is left out.
+  const float tol = 1e-5f * objectSpaceLengthScale;
+
+  // Walk down the boxes which the plane crosses, collecting the leaves it reaches
+  std::vector<size_t> candidateLeaves;
+  glm::vec3 absVector = glm::abs(sliceVector);
+  std::function<void(size_t, size_t)> visit = [&](size_t level, size_t iN) {
+    const std::array<glm::vec3, 2>& box = sliceTetBounds[level][iN];
+    float dCenter = glm::dot(sliceVector, 0.5f * (box[0] + box[1])) - slicePoint;
+    float dRadius = glm::dot(absVector, 0.5f * (box[1] - box[0]));
+    if (!(dCenter - dRadius < 2 * tol && dCenter + dRadius > -2 * tol)) return;
+    if (level == 0) {
+      candidateLeaves.push_back(iN);
+      return;
+    }
+    for (size_t iC = iN * sliceBranching; iC < std::min(sliceTetBounds[level - 1].size(), (iN + 1) * sliceBranching);
+         iC++) {
+      visit(level - 1, iC);
+    }
+  };
+  if (nT > 0) visit(sliceTetBounds.size() - 1, 0);
+
+  // Test the tets of the candidate leaves, gathering the ranges of each block of leaves and then joining them in order
+  const size_t leavesPerBlock = 256;
+  size_t nBlocks = (candidateLeaves.size() + leavesPerBlock - 1) / leavesPerBlock;
+  std::vector<std::vector<std::array<size_t, 2>>> blockRanges(nBlocks);
+  parallelFor(
+      0, nBlocks,
+      [&](size_t blockStart, size_t blockEnd) {
+        for (size_t iB = blockStart; iB < blockEnd; iB++) {
+          std::vector<std::array<size_t, 2>>& ranges = blockRanges[iB];
+          for (size_t iCand = iB * leavesPerBlock; iCand < std::min(candidateLeaves.size(), (iB + 1) * leavesPerBlock);
+               iCand++) {
+            size_t iL = candidateLeaves[iCand];
+            for (size_t i = iL * sliceLeafSize; i < std::min(nT, (iL + 1) * sliceLeafSize); i++) {
+              float dMin = std::numeric_limits<float>::infinity();
+              float dMax = -std::numeric_limits<float>::infinity();
+              for (uint32_t iV : tets[order[i]]) {
+                float d = glm::dot(sliceVector, pos[iV]) - slicePoint;
+                dMin = std::min(dMin, d);
+                dMax = std::max(dMax, d);
+              }
+              if (!(dMin < tol && dMax > -tol)) continue;
+
+              if (!ranges.empty() && ranges.back()[0] + ranges.back()[1] == i) {
+                ranges.back()[1]++;
+              } else {
+                ranges.push_back({i, 1});
+              }
+            }
+          }
+        }
+      },
+      1);
+
+  std::vector<std::array<size_t, 2>> ranges;
+  for (const std::vector<std::array<size_t, 2>>& block : blockRanges) {
+    for (const std::array<size_t, 2>& r : block) {
+      if (!ranges.empty() && ranges.back()[0] + ranges.back()[1] == r[0]) {
+        ranges.back()[1] += r[1]; // continues across the block boundary
+      } else {
+        ranges.push_back(r);
+      }
+    }
+  }
+  return ranges;
+}
+
 VolumeMeshVertexScalarQuantity* VolumeMesh::getLevelSetQuantity() { return activeLevelSetQuantity; }
 
 void VolumeMesh::setLevelSetQuantity(VolumeMeshVertexScalarQuantity* quantity) {
@@ -417,6 +753,8 @@ void VolumeMesh::draw() {
     return;
   }
 
+  ensureDrawBuffersHoldVisibleFaces();
+
   render::engine->setBackfaceCull();
 
   // If no quantity is drawing the volume, we should draw it
@@ -475,6 +813,8 @@ void VolumeMesh::drawPick() {
     return;
   }
 
+  ensureDrawBuffersHoldVisibleFaces();
+
   if (pickProgram == nullptr) {
     preparePick();
   }
@@ -496,8 +836,9 @@ void VolumeMesh::prepare() {
 void VolumeMesh::preparePick() {
 
   // Create a new program
-  pickProgram = render::engine->requestShader("MESH", addVolumeMeshRules({"MESH_PROPAGATE_PICK_SIMPLE"}),
-                                              render::ShaderReplacementDefaults::Pick);
+  std::vector<std::string> rules = removeSubsetHighlightRules(addVolumeMeshRules({"MESH_PROPAGATE_PICK_SIMPLE"}));
+  pickProgram = render::engine->requestShader("MESH", rules, render::ShaderReplacementDefaults::Pick);
+  pickProgram->setMemoryOwner(uniquePrefix() + "pick");
 
   fillGeometryBuffers(*pickProgram);
 
@@ -521,17 +862,18 @@ void VolumeMesh::preparePick() {
   std::vector<glm::vec3> faceColor;
 
   // Reserve space
-  vertexColors.resize(3 * nFacesTriangulation());
-  edgeColors.resize(3 * nFacesTriangulation());
-  halfedgeColors.resize(3 * nFacesTriangulation());
-  cornerColors.resize(3 * nFacesTriangulation());
-  faceColor.resize(3 * nFacesTriangulation());
+  vertexColors.resize(3 * nDrawnFacesTriangulation());
+  edgeColors.resize(3 * nDrawnFacesTriangulation());
+  halfedgeColors.resize(3 * nDrawnFacesTriangulation());
+  cornerColors.resize(3 * nDrawnFacesTriangulation());
+  faceColor.resize(3 * nDrawnFacesTriangulation());
 
+  // (this must enumerate triangles exactly like computeConnectivityData())
   size_t iFront = 0;
-  size_t iBack = nFacesTriangulation() - 1;
+  size_t iBack = nDrawnFacesTriangulation() - 1;
   size_t iF = 0;
   for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
+    const uint32_t* cell = cellVertices(iC);
     VolumeCellType cellT = cellType(iC);
 
     glm::vec3 cellColor = pick::indToVec(cellGlobalPickIndStart + iC);
@@ -539,6 +881,11 @@ void VolumeMesh::preparePick() {
 
     for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
 
+      if (faceIsInterior[iF] && !interiorFacesInBuffers) {
+        iF++;
+        continue;
+      }
+
       // Emit the actual face in the triangulation
       for (size_t j = 0; j < face.size(); j++) {
         const std::array<size_t, 3>& tri = face[j];
@@ -587,12 +934,29 @@ std::vector<std::string> VolumeMesh::addVolumeMeshRules(std::vector<std::string>
   initRules.push_back("MESH_BACKFACE_NORMAL_FLIP");
 
   if (wantsCullPosition() && !isSlice) {
-    initRules.push_back("MESH_PROPAGATE_CULLPOS");
+    initRules.push_back(canFetchCellData() ? "MESH_FETCH_FACE_CULLPOS" : "MESH_PROPAGATE_CULLPOS");
+  }
+
+  // (slices of the cells are not masked)
+  if (!isSlice) {
+    initRules = addSubsetRules(initRules, "MESH_PROPAGATE_SUBSET_INDEX");
+  }
+
+  bool fetchesCellData = std::any_of(initRules.begin(), initRules.end(),
+                                     [](const std::string& rule) { return rule.find("MESH_FETCH_FACE_") == 0; });
+  if (fetchesCellData) {
+    initRules.push_back("MESH_FACE_INDEX_FROM_TRIANGLE_MAP");
   }
 
   return initRules;
 }
 
+size_t VolumeMesh::nSubsetElements() { return nCells(); }
+
+bool VolumeMesh::canFetchCellData() {
+  return std::max(nCells(), nDrawnFacesTriangulation()) < (static_cast<size_t>(1) << 24);
+}
+
 void VolumeMesh::setVolumeMeshUniforms(render::ShaderProgram& p) {
   if (getEdgeWidth() > 0) {
     p.setUniform("u_edgeWidth", getEdgeWidth() * render::engine->getCurrentPixelScaling());
@@ -617,12 +981,22 @@ void VolumeMesh::fillGeometryBuffers(render::ShaderProgram& p) {
   if (wantsEdge) {
     p.setAttribute("a_edgeIsReal", edgeIsReal.getRenderAttributeBuffer());
   }
+  if (p.hasTexture("t_triangleFaces")) {
+    p.setTextureFromBuffer("t_triangleFaces", triangleCells.getTextureViewBuffer().get());
+  }
   if (wantsAttrCullPosition) {
-    p.setAttribute("a_cullPos", cellCenters.getIndexedRenderAttributeBuffer(triangleCellInds));
+    if (p.hasTexture("t_faceCullPos")) {
+      p.setTextureFromBuffer("t_faceCullPos", cellCenters.getTextureViewBuffer().get());
+    } else {
+      p.setAttribute("a_cullPos", cellCenters.getIndexedRenderAttributeBuffer(triangleCellInds));
+    }
   }
   if (wantsFaceType) {
     p.setAttribute("a_faceColorType", faceType.getIndexedRenderAttributeBuffer(triangleFaceInds));
   }
+  if (p.hasAttribute("a_subsetIndex")) {
+    p.setAttribute("a_subsetIndex", triangleCellInds.getRenderAttributeBuffer());
+  }
 }
 
 void VolumeMesh::computeConnectivityData() {
@@ -634,33 +1008,56 @@ void VolumeMesh::computeConnectivityData() {
   // To mitigate this issue, we fill the buffer such that all exterior faces come first, then all interior faces, so
   // that exterior faces always win depth ties. This doesn't totally eliminate the problem, but greatly improves the
   // most egregious cases.
+  //
+  // Interior faces are usually the large majority, and can only be seen through a slice plane or transparency, so
+  // unless that might be happening they are left out entirely (see setSkipHiddenInteriorFaces()).
+
+  interiorFacesInBuffers = interiorFacesMayBeVisible();
+  nDrawnFacesTriangulationCount = 0;
+  {
+    size_t iF = 0;
+    for (size_t iC = 0; iC < nCells(); iC++) {
+      for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellType(iC))) {
+        if (interiorFacesInBuffers || !faceIsInterior[iF]) nDrawnFacesTriangulationCount += face.size();
+        iF++;
+      }
+    }
+  }
 
   // == Allocate buffers
   triangleVertexInds.data.clear();
-  triangleVertexInds.data.resize(3 * nFacesTriangulation());
+  triangleVertexInds.data.resize(3 * nDrawnFacesTriangulation());
   triangleFaceInds.data.clear();
-  triangleFaceInds.data.resize(3 * nFacesTriangulation());
+  triangleFaceInds.data.resize(3 * nDrawnFacesTriangulation());
   triangleCellInds.data.clear();
-  triangleCellInds.data.resize(3 * nFacesTriangulation());
-  triangleCellInds.data.clear();
-  triangleCellInds.data.resize(3 * nFacesTriangulation());
+  triangleCellInds.data.resize(3 * nDrawnFacesTriangulation());
+  triangleCells.data.clear();
+  triangleCells.data.resize(nDrawnFacesTriangulation());
   baryCoord.data.clear();
-  baryCoord.data.resize(3 * nFacesTriangulation());
+  baryCoord.data.resize(3 * nDrawnFacesTriangulation());
   edgeIsReal.data.clear();
-  edgeIsReal.data.resize(3 * nFacesTriangulation());
+  edgeIsReal.data.resize(3 * nDrawnFacesTriangulation());
   faceType.data.clear();
   faceType.data.resize(nFaces());
 
   size_t iF = 0;
   size_t iFront = 0;
-  size_t iBack = nFacesTriangulation() - 1;
+  size_t iBack = nDrawnFacesTriangulation() - 1;
   for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
+    const uint32_t* cell = cellVertices(iC);
     VolumeCellType cellT = cellType(iC);
 
     // Loop over all faces of the cell
     for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
 
+      float faceTypeFloat = faceIsInterior[iF] ? 1. : 0.;
+      faceType.data[iF] = faceTypeFloat;
+
+      if (faceIsInterior[iF] && !interiorFacesInBuffers) {
+        iF++;
+        continue;
+      }
+
       // Loop over the face's triangulation
       for (size_t j = 0; j < face.size(); j++) {
         const std::array<size_t, 3>& tri = face[j];
@@ -681,6 +1078,7 @@ void VolumeMesh::computeConnectivityData() {
         }
         for (size_t k = 0; k < 3; k++) triangleFaceInds.data[3 * iData + k] = iF;
         for (size_t k = 0; k < 3; k++) triangleCellInds.data[3 * iData + k] = iC;
+        triangleCells.data[iData] = iC;
 
         baryCoord.data[3 * iData + 0] = glm::vec3{1., 0., 0.};
         baryCoord.data[3 * iData + 1] = glm::vec3{0., 1., 0.};
@@ -692,9 +1090,6 @@ void VolumeMesh::computeConnectivityData() {
         for (int k = 0; k < 3; k++) edgeIsReal.data[3 * iData + k] = edgeRealV;
       }
 
-      float faceTypeFloat = faceIsInterior[iF] ? 1. : 0.;
-      for (int k = 0; k < 3; k++) faceType.data[iF] = faceTypeFloat;
-
       iF++;
     }
   }
@@ -702,7 +1097,7 @@ void VolumeMesh::computeConnectivityData() {
   triangleVertexInds.markHostBufferUpdated();
   triangleFaceInds.markHostBufferUpdated();
   triangleCellInds.markHostBufferUpdated();
-  triangleCellInds.markHostBufferUpdated();
+  triangleCells.markHostBufferUpdated();
   baryCoord.markHostBufferUpdated();
   edgeIsReal.markHostBufferUpdated();
   faceType.markHostBufferUpdated();
@@ -729,7 +1124,7 @@ void VolumeMesh::computeFaceNormals() {
 
   size_t iF = 0;
   for (size_t iC = 0; iC < nCells(); iC++) {
-    const std::array<uint32_t, 8>& cell = cells[iC];
+    const uint32_t* cell = cellVertices(iC);
     VolumeCellType cellT = cellType(iC);
 
     for (const std::vector<std::array<size_t, 3>>& face : cellStencil(cellT)) {
@@ -763,13 +1158,10 @@ void VolumeMesh::computeCellCenters() {
 
     glm::vec3 center{0., 0., 0};
 
-    int count = 0;
-    const std::array<uint32_t, 8>& cell = cells[iC];
-    for (int j = 0; j < 8; j++) {
-      if (cell[j] < INVALID_IND_32) {
-        center += vertexPositions.data[cell[j]];
-        count++;
-      }
+    const uint32_t* cell = cellVertices(iC);
+    int count = cellType(iC) == VolumeCellType::HEX ? 8 : 4;
+    for (int j = 0; j < count; j++) {
+      center += vertexPositions.data[cell[j]];
     }
     center /= count;
 
@@ -792,7 +1184,7 @@ void VolumeMesh::buildPickUI(size_t localPickID) {
 void VolumeMesh::buildVertexInfoGui(size_t vInd) {
 
   size_t displayInd = vInd;
-  ImGui::TextUnformatted(("Vertex #" + std::to_string(displayInd)).c_str());
+  ImGui::Text("Vertex #%zu", displayInd);
 
   std::stringstream buffer;
   buffer << vertexPositions.getValue(vInd);
@@ -815,7 +1207,7 @@ void VolumeMesh::buildVertexInfoGui(size_t vInd) {
 
 void VolumeMesh::buildCellInfoGUI(size_t cellInd) {
   size_t displayInd = cellInd;
-  ImGui::TextUnformatted(("Cell #" + std::to_string(displayInd)).c_str());
+  ImGui::Text("Cell #%zu", displayInd);
 
   ImGui::Spacing();
   ImGui::Spacing();
@@ -895,7 +1287,7 @@ void VolumeMesh::buildCustomOptionsUI() {
 
 void VolumeMesh::refreshVolumeMeshListeners() {
   for (size_t i = 0; i < volumeSlicePlaneListeners.size(); i++) {
-    volumeSlicePlaneListeners[i]->resetVolumeSliceProgram();
+    volumeSlicePlaneListeners[i]->resetVolumeSliceProgram(*this);
   }
 }
 
@@ -909,6 +1301,8 @@ void VolumeMesh::refresh() {
 
 void VolumeMesh::geometryChanged() {
   recomputeGeometryIfPopulated();
+  refreshVolumeMeshListeners(); // the slice programs hold copies of the positions, and the cut tets may differ
+  sliceTetBoundsValid = false;
   requestRedraw();
   QuantityStructure<VolumeMesh>::refresh();
 }
@@ -918,8 +1312,28 @@ void VolumeMesh::recomputeGeometryIfPopulated() {
   cellCenters.recomputeIfPopulated();
 }
 
+bool VolumeMesh::interiorFacesMayBeVisible() {
+  if (!getSkipHiddenInteriorFaces()) return true;
+  if (hasVisibleSubset()) return true;
+  if (!volumeSlicePlaneListeners.empty()) return true;
+  if (render::engine != nullptr && render::engine->transparencyEnabled() && getTransparency() < 1.) return true;
+  for (SlicePlane* s : state::slicePlanes) {
+    if (s->getActive() && !getIgnoreSlicePlane(s->name)) return true;
+  }
+  return false;
+}
+
+void VolumeMesh::ensureDrawBuffersHoldVisibleFaces() {
+  bool needInterior = interiorFacesMayBeVisible();
+  if (needInterior == interiorFacesInBuffers) return;
+
+  // Re-layout the draw buffers, and drop the programs (and their indexed views) which were built from the old ones
+  computeConnectivityData();
+  refresh();
+}
+
 VolumeCellType VolumeMesh::cellType(size_t i) const {
-  bool isHex = cells[i][4] < INVALID_IND_32;
+  bool isHex = cellHexStart.empty() ? !hexCells.empty() : cellHexStart[i + 1] != cellHexStart[i];
   if (isHex) {
     return VolumeCellType::HEX;
   } else {
@@ -927,26 +1341,27 @@ VolumeCellType VolumeMesh::cellType(size_t i) const {
   }
 };
 
+const uint32_t* VolumeMesh::cellVertices(size_t i) const {
+  if (cellHexStart.empty()) {
+    return hexCells.empty() ? tetCells[i].data() : hexCells[i].data();
+  }
+  if (cellHexStart[i + 1] != cellHexStart[i]) {
+    return hexCells[cellHexStart[i]].data();
+  } else {
+    return tetCells[i - cellHexStart[i]].data();
+  }
+}
+
 void VolumeMesh::updateObjectSpaceBounds() {
 
   vertexPositions.ensureHostBufferPopulated();
 
-  // bounding box
-  glm::vec3 min = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  glm::vec3 max = -glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
-  for (const glm::vec3& p : vertexPositions.data) {
-    min = componentwiseMin(min, p);
-    max = componentwiseMax(max, p);
-  }
+  // bounding box, and length scale as twice the radius from the center of the bounding box
+  glm::vec3 min, max;
+  float lengthScale;
+  computeBoundsAndLengthScale(vertexPositions.data.data(), vertexPositions.data.size(), min, max, lengthScale);
   objectSpaceBoundingBox = std::make_tuple(min, max);
-
-  // length scale, as twice the radius from the center of the bounding box
-  glm::vec3 center = 0.5f * (min + max);
-  float lengthScale = 0.0;
-  for (const glm::vec3& p : vertexPositions.data) {
-    lengthScale = std::max(lengthScale, glm::length2(p - center));
-  }
-  objectSpaceLengthScale = 2 * std::sqrt(lengthScale);
+  objectSpaceLengthScale = lengthScale;
 }
 
 std::string VolumeMesh::typeName() { return structureTypeName; }
@@ -978,11 +1393,17 @@ glm::vec3 VolumeMesh::getEdgeColor() { return edgeColor.get(); }
 
 VolumeMesh* VolumeMesh::setMaterial(std::string m) {
   material = m;
-  refresh(); // (serves the purpose of re-initializing everything, though this is a bit overkill)
+  // the material is just a set of textures, swap them on the existing programs
+  if (program) render::engine->setMaterial(*program, getMaterial());
+  refreshQuantityMaterials();
+  for (SlicePlane* sp : volumeSlicePlaneListeners) {
+    sp->refreshVolumeSliceMaterial(*this);
+  }
   requestRedraw();
   return this;
 }
 std::string VolumeMesh::getMaterial() { return material.get(); }
+std::string VolumeMesh::drawSortKey() { return material.get(); }
 
 VolumeMesh* VolumeMesh::setEdgeWidth(double newVal) {
   edgeWidth = newVal;
@@ -992,6 +1413,13 @@ VolumeMesh* VolumeMesh::setEdgeWidth(double newVal) {
 }
 double VolumeMesh::getEdgeWidth() { return edgeWidth.get(); }
 
+VolumeMesh* VolumeMesh::setSkipHiddenInteriorFaces(bool newVal) {
+  skipHiddenInteriorFaces = newVal;
+  requestRedraw(); // the buffers are updated lazily at draw time
+  return this;
+}
+bool VolumeMesh::getSkipHiddenInteriorFaces() { return skipHiddenInteriorFaces.get(); }
+
 
 // === Quantity adder}
 
@@ -1010,13 +1438,13 @@ VolumeMeshCellColorQuantity* VolumeMesh::addCellColorQuantityImpl(std::string na
 }
 
 VolumeMeshVertexScalarQuantity*
-VolumeMesh::addVertexScalarQuantityImpl(std::string name, const std::vector<double>& data, DataType type) {
+VolumeMesh::addVertexScalarQuantityImpl(std::string name, const std::vector<float>& data, DataType type) {
   VolumeMeshVertexScalarQuantity* q = new VolumeMeshVertexScalarQuantity(name, data, *this, type);
   addQuantity(q);
   return q;
 }
 
-VolumeMeshCellScalarQuantity* VolumeMesh::addCellScalarQuantityImpl(std::string name, const std::vector<double>& data,
+VolumeMeshCellScalarQuantity* VolumeMesh::addCellScalarQuantityImpl(std::string name, const std::vector<float>& data,
                                                                     DataType type) {
   VolumeMeshCellScalarQuantity* q = new VolumeMeshCellScalarQuantity(name, data, *this, type);
   addQuantity(q);
@@ -47,8 +47,9 @@ void VolumeMeshVertexColorQuantity::drawSlice(polyscope::SlicePlane* sp) {
   }
   parent.setStructureUniforms(*sliceProgram);
   // Ignore current slice plane
-  sp->setSceneObjectUniforms(*sliceProgram, true);
+  sp->setSceneObjectUniformsIgnoringThis(*sliceProgram, parent);
   sp->setSliceGeomUniforms(*sliceProgram);
+  sp->setSliceDrawRanges(*sliceProgram, parent);
   parent.setVolumeMeshUniforms(*sliceProgram);
   sliceProgram->draw();
 }
@@ -71,7 +72,9 @@ void VolumeMeshVertexColorQuantity::fillSliceColorBuffers(render::ShaderProgram&
 
   colors.ensureHostBufferPopulated();
 
-  size_t tetCount = parent.nTets();
+  const std::vector<std::array<uint32_t, 4>>& tets = parent.getTets();
+  const std::vector<uint32_t>& order = parent.getSliceTetOrder(); // the order of the slice buffers
+  size_t tetCount = tets.size();
   std::vector<glm::vec3> colorval_1;
   std::vector<glm::vec3> colorval_2;
   std::vector<glm::vec3> colorval_3;
@@ -82,11 +85,12 @@ void VolumeMeshVertexColorQuantity::fillSliceColorBuffers(render::ShaderProgram&
   colorval_3.resize(tetCount);
   colorval_4.resize(tetCount);
 
-  for (size_t iT = 0; iT < parent.tets.size(); iT++) {
-    colorval_1[iT] = colors.data[parent.tets[iT][0]];
-    colorval_2[iT] = colors.data[parent.tets[iT][1]];
-    colorval_3[iT] = colors.data[parent.tets[iT][2]];
-    colorval_4[iT] = colors.data[parent.tets[iT][3]];
+  for (size_t i = 0; i < tetCount; i++) {
+    const std::array<uint32_t, 4>& tet = tets[order[i]];
+    colorval_1[i] = colors.data[tet[0]];
+    colorval_2[i] = colors.data[tet[1]];
+    colorval_3[i] = colors.data[tet[2]];
+    colorval_4[i] = colors.data[tet[3]];
   }
 
   // Store data in buffers
@@ -128,6 +132,11 @@ void VolumeMeshColorQuantity::refresh() {
   Quantity::refresh();
 }
 
+void VolumeMeshColorQuantity::refreshMaterial() {
+  if (program) render::engine->setMaterial(*program, parent.getMaterial());
+  if (sliceProgram) render::engine->setMaterial(*sliceProgram, parent.getMaterial());
+}
+
 // ========================================================
 // ==========            Cell Color              ==========
 // ========================================================
@@ -140,11 +149,20 @@ VolumeMeshCellColorQuantity::VolumeMeshCellColorQuantity(std::string name, Volum
 
 void VolumeMeshCellColorQuantity::createProgram() {
   // Create the program to draw this quantity
-  program = render::engine->requestShader("MESH", parent.addVolumeMeshRules({"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}));
-
-  // Fill color buffers
-  parent.fillGeometryBuffers(*program);
-  program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleCellInds));
+  if (parent.canFetchCellData()) {
+    // look up the color of each cell by the triangle being drawn, rather than expanding the colors to triangle corners
+    program =
+        render::engine->requestShader("MESH", parent.addVolumeMeshRules({"MESH_FETCH_FACE_COLOR", "SHADE_COLOR"}));
+    program->setTextureFromBuffer("t_faceValues", colors.getTextureViewBuffer().get());
+    parent.fillGeometryBuffers(*program);
+  } else {
+    program =
+        render::engine->requestShader("MESH", parent.addVolumeMeshRules({"MESH_PROPAGATE_COLOR", "SHADE_COLOR"}));
+
+    // Fill color buffers
+    parent.fillGeometryBuffers(*program);
+    program->setAttribute("a_color", colors.getIndexedRenderAttributeBuffer(parent.triangleCellInds));
+  }
   render::engine->setMaterial(*program, parent.getMaterial());
 }
 
@@ -2,15 +2,17 @@
 
 #include "polyscope/volume_mesh_scalar_quantity.h"
 
+#include "polyscope/parallel.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/render/engine.h"
+#include "polyscope/surface_mesh.h"
 
 #include "imgui.h"
 
 namespace polyscope {
 
 VolumeMeshScalarQuantity::VolumeMeshScalarQuantity(std::string name, VolumeMesh& mesh_, std::string definedOn_,
-                                                   const std::vector<double>& values_, DataType dataType_)
+                                                   const std::vector<float>& values_, DataType dataType_)
     : VolumeMeshQuantity(name, mesh_, true), ScalarQuantity(*this, values_, dataType_), definedOn(definedOn_) {}
 
 void VolumeMeshScalarQuantity::draw() {
@@ -52,16 +54,21 @@ void VolumeMeshScalarQuantity::refresh() {
   Quantity::refresh();
 }
 
+void VolumeMeshScalarQuantity::refreshMaterial() {
+  if (program) render::engine->setMaterial(*program, parent.getMaterial());
+  if (sliceProgram) render::engine->setMaterial(*sliceProgram, parent.getMaterial());
+}
+
 std::string VolumeMeshScalarQuantity::niceName() { return name + " (" + definedOn + " scalar)"; }
 
 // ========================================================
 // ==========           Vertex Scalar            ==========
 // ========================================================
 
-VolumeMeshVertexScalarQuantity::VolumeMeshVertexScalarQuantity(std::string name, const std::vector<double>& values_,
+VolumeMeshVertexScalarQuantity::VolumeMeshVertexScalarQuantity(std::string name, const std::vector<float>& values_,
                                                                VolumeMesh& mesh_, DataType dataType_)
     : VolumeMeshScalarQuantity(name, mesh_, "vertex", values_, dataType_), levelSetValue(0), isDrawingLevelSet(false),
-      showQuantity(this)
+      showQuantity(this), levelSetCaching(false), cachedLevelSetValue(0)
 
 {
   parent.refreshVolumeMeshListeners(); // just in case this quantity is being drawn
@@ -81,7 +88,9 @@ void VolumeMeshVertexScalarQuantity::fillLevelSetData(render::ShaderProgram& p)
   std::vector<glm::vec3> slice2;
   std::vector<glm::vec3> slice3;
   std::vector<glm::vec3> slice4;
-  size_t tetCount = parent.nTets();
+  const std::vector<std::array<uint32_t, 4>>& tets = parent.getTets();
+  const std::vector<uint32_t>& order = parent.getSliceTetOrder(); // the order of the slice buffers
+  size_t tetCount = tets.size();
   slice1.resize(tetCount);
   slice2.resize(tetCount);
   slice3.resize(tetCount);
@@ -90,15 +99,16 @@ void VolumeMeshVertexScalarQuantity::fillLevelSetData(render::ShaderProgram& p)
   point2.resize(tetCount);
   point3.resize(tetCount);
   point4.resize(tetCount);
-  for (size_t i = 0; i < parent.nTets(); i++) {
-    point1[i] = parent.vertexPositions.data[parent.tets[i][0]];
-    point2[i] = parent.vertexPositions.data[parent.tets[i][1]];
-    point3[i] = parent.vertexPositions.data[parent.tets[i][2]];
-    point4[i] = parent.vertexPositions.data[parent.tets[i][3]];
-    slice1[i] = glm::vec3(values.data[parent.tets[i][0]], 0, 0);
-    slice2[i] = glm::vec3(values.data[parent.tets[i][1]], 0, 0);
-    slice3[i] = glm::vec3(values.data[parent.tets[i][2]], 0, 0);
-    slice4[i] = glm::vec3(values.data[parent.tets[i][3]], 0, 0);
+  for (size_t i = 0; i < tetCount; i++) {
+    const std::array<uint32_t, 4>& tet = tets[order[i]];
+    point1[i] = parent.vertexPositions.data[tet[0]];
+    point2[i] = parent.vertexPositions.data[tet[1]];
+    point3[i] = parent.vertexPositions.data[tet[2]];
+    point4[i] = parent.vertexPositions.data[tet[3]];
+    slice1[i] = glm::vec3(values.data[tet[0]], 0, 0);
+    slice2[i] = glm::vec3(values.data[tet[1]], 0, 0);
+    slice3[i] = glm::vec3(values.data[tet[2]], 0, 0);
+    slice4[i] = glm::vec3(values.data[tet[3]], 0, 0);
   }
   p.setAttribute("a_point_1", point1);
   p.setAttribute("a_point_2", point2);
@@ -119,7 +129,12 @@ void VolumeMeshVertexScalarQuantity::draw() {
   if (!isEnabled()) return;
 
   auto programToDraw = program;
-  if (isDrawingLevelSet) {
+  if (isDrawingLevelSet && levelSetCaching) {
+    if (cachedLevelSetProgram == nullptr || cachedLevelSetValue != levelSetValue) {
+      createCachedLevelSetProgram();
+    }
+    programToDraw = cachedLevelSetProgram;
+  } else if (isDrawingLevelSet) {
     if (levelSetProgram == nullptr) {
       levelSetProgram = createSliceProgram();
       fillLevelSetData(*levelSetProgram);
@@ -133,7 +148,9 @@ void VolumeMeshVertexScalarQuantity::draw() {
 
   // Set uniforms
   parent.setStructureUniforms(*programToDraw);
-  parent.setVolumeMeshUniforms(*programToDraw);
+  if (programToDraw != cachedLevelSetProgram) { // the cached level set is drawn without the tet wireframe
+    parent.setVolumeMeshUniforms(*programToDraw);
+  }
   setScalarUniforms(*programToDraw);
 
   programToDraw->draw();
@@ -152,6 +169,207 @@ void VolumeMeshVertexScalarQuantity::setEnabledLevelSet(bool v) {
   }
 }
 
+void VolumeMeshVertexScalarQuantity::setLevelSetCaching(bool v) {
+  levelSetCaching = v;
+  if (!levelSetCaching) {
+    cachedLevelSetProgram.reset();
+  }
+  requestRedraw();
+}
+
+bool VolumeMeshVertexScalarQuantity::getLevelSetCaching() { return levelSetCaching; }
+
+void VolumeMeshVertexScalarQuantity::computeLevelSetTriangles() {
+
+  values.ensureHostBufferPopulated();
+  const std::vector<std::array<uint32_t, 4>>& tets = parent.getTets();
+  const std::vector<float>& vals = values.data;
+  const double level = levelSetValue;
+
+  // Marching tets. A vertex is below the level if its value is < level; each tet with mixed vertices is cut by one
+  // triangle (1-3 split) or a quad (2-2 split). The tets are processed in fixed-size chunks, first counting the output
+  // of each chunk and then writing it at the chunk's offset, so the result does not depend on the thread count.
+  const size_t chunkSize = 1 << 14;
+  size_t nChunks = (tets.size() + chunkSize - 1) / chunkSize;
+  std::vector<size_t> chunkTriStart(nChunks + 1, 0);
+
+  auto belowMask = [&](size_t iT) {
+    int mask = 0;
+    for (int j = 0; j < 4; j++) {
+      if (vals[tets[iT][j]] < level) mask |= (1 << j);
+    }
+    return mask;
+  };
+  auto nTrisForMask = [](int mask) {
+    int nBelow = (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+    if (nBelow == 0 || nBelow == 4) return 0;
+    return nBelow == 2 ? 2 : 1;
+  };
+
+  parallelFor(
+      0, nChunks,
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          size_t count = 0;
+          for (size_t iT = iC * chunkSize; iT < std::min(tets.size(), (iC + 1) * chunkSize); iT++) {
+            count += nTrisForMask(belowMask(iT));
+          }
+          chunkTriStart[iC + 1] = count;
+        }
+      },
+      1);
+  for (size_t iC = 0; iC < nChunks; iC++) chunkTriStart[iC + 1] += chunkTriStart[iC];
+
+  size_t nTris = chunkTriStart[nChunks];
+  levelSetVertexEdges.resize(3 * nTris);
+  levelSetVertexT.resize(3 * nTris);
+
+  parent.vertexPositions.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = parent.vertexPositions.data;
+
+  parallelFor(
+      0, nChunks,
+      [&](size_t start, size_t end) {
+        for (size_t iC = start; iC < end; iC++) {
+          size_t iOut = 3 * chunkTriStart[iC];
+          for (size_t iT = iC * chunkSize; iT < std::min(tets.size(), (iC + 1) * chunkSize); iT++) {
+            int mask = belowMask(iT);
+            int nTri = nTrisForMask(mask);
+            if (nTri == 0) continue;
+            const std::array<uint32_t, 4>& tet = tets[iT];
+
+            std::array<int, 4> below, above;
+            int nBelow = 0, nAbove = 0;
+            for (int j = 0; j < 4; j++) {
+              if (mask & (1 << j)) {
+                below[nBelow++] = j;
+              } else {
+                above[nAbove++] = j;
+              }
+            }
+
+            // the crossed edges, in order around the cut polygon
+            std::array<std::array<int, 2>, 4> cut;
+            if (nBelow == 1) {
+              cut = {{{below[0], above[0]}, {below[0], above[1]}, {below[0], above[2]}, {0, 0}}};
+            } else if (nBelow == 3) {
+              cut = {{{below[0], above[0]}, {below[1], above[0]}, {below[2], above[0]}, {0, 0}}};
+            } else {
+              cut = {{{below[0], above[0]}, {below[0], above[1]}, {below[1], above[1]}, {below[1], above[0]}}};
+            }
+            int nCut = nTri == 2 ? 4 : 3;
+
+            std::array<std::array<uint32_t, 2>, 4> edges;
+            std::array<float, 4> ts;
+            std::array<glm::vec3, 4> q;
+            for (int k = 0; k < nCut; k++) {
+              uint32_t vA = std::min(tet[cut[k][0]], tet[cut[k][1]]);
+              uint32_t vB = std::max(tet[cut[k][0]], tet[cut[k][1]]);
+              float t = static_cast<float>((level - vals[vA]) / (vals[vB] - vals[vA]));
+              edges[k] = {vA, vB};
+              ts[k] = t;
+              q[k] = (1.f - t) * pos[vA] + t * pos[vB];
+            }
+
+            // orient so the triangles face towards larger values; the cut separates the below and above vertices, so
+            // this holds regardless of the tet's own orientation
+            glm::vec3 n = glm::cross(q[1] - q[0], q[2] - q[0]);
+            bool flip = glm::dot(n, pos[tet[above[0]]] - pos[tet[below[0]]]) < 0;
+
+            for (int iTri = 0; iTri < nTri; iTri++) {
+              std::array<int, 3> corners = {0, iTri + 1, iTri + 2};
+              if (flip) std::swap(corners[1], corners[2]);
+              for (int c : corners) {
+                levelSetVertexEdges[iOut] = edges[c];
+                levelSetVertexT[iOut] = ts[c];
+                iOut++;
+              }
+            }
+          }
+        }
+      },
+      1);
+
+  cachedLevelSetValue = levelSetValue;
+}
+
+void VolumeMeshVertexScalarQuantity::createCachedLevelSetProgram() {
+
+  computeLevelSetTriangles();
+
+  // Expand the triangle soup to draw buffers
+  parent.vertexPositions.ensureHostBufferPopulated();
+  showQuantity->values.ensureHostBufferPopulated();
+  const std::vector<glm::vec3>& pos = parent.vertexPositions.data;
+  const std::vector<float>& showVals = showQuantity->values.data;
+
+  size_t nVerts = levelSetVertexEdges.size();
+  std::vector<glm::vec3> positions(nVerts);
+  std::vector<glm::vec3> normals(nVerts);
+  std::vector<glm::vec3> barycoords(nVerts);
+  std::vector<float> shownValues(nVerts);
+  parallelFor(0, nVerts / 3, [&](size_t start, size_t end) {
+    for (size_t iTri = start; iTri < end; iTri++) {
+      for (size_t j = 0; j < 3; j++) {
+        size_t iV = 3 * iTri + j;
+        const std::array<uint32_t, 2>& e = levelSetVertexEdges[iV];
+        float t = levelSetVertexT[iV];
+        positions[iV] = (1.f - t) * pos[e[0]] + t * pos[e[1]];
+        shownValues[iV] = (1. - t) * showVals[e[0]] + t * showVals[e[1]];
+        barycoords[iV] = glm::vec3{0., 0., 0.};
+        barycoords[iV][j] = 1.;
+      }
+      const glm::vec3& p0 = positions[3 * iTri];
+      glm::vec3 n = glm::cross(positions[3 * iTri + 1] - p0, positions[3 * iTri + 2] - p0);
+      float len = glm::length(n);
+      if (len > 0) n /= len;
+      for (size_t j = 0; j < 3; j++) normals[3 * iTri + j] = n;
+    }
+  });
+
+  cachedLevelSetProgram = render::engine->requestShader(
+      "MESH", parent.addVolumeMeshRules(addScalarRules({"MESH_PROPAGATE_VALUE"}), false, true));
+  cachedLevelSetProgram->setAttribute("a_vertexPositions", positions);
+  cachedLevelSetProgram->setAttribute("a_vertexNormals", normals);
+  cachedLevelSetProgram->setAttribute("a_barycoord", barycoords);
+  cachedLevelSetProgram->setAttribute("a_value", shownValues);
+  cachedLevelSetProgram->setTextureFromColormap("t_colormap", cMap.get());
+  render::engine->setMaterial(*cachedLevelSetProgram, parent.getMaterial());
+}
+
+SurfaceMesh* VolumeMeshVertexScalarQuantity::registerLevelSetAsSurfaceMesh(std::string name) {
+
+  computeLevelSetTriangles();
+  cachedLevelSetProgram.reset();
+
+  // Weld the soup: vertices which lie on the same tet mesh edge are the same vertex
+  auto edgeKey = [](const std::array<uint32_t, 2>& e) { return (static_cast<uint64_t>(e[0]) << 32) | e[1]; };
+  std::vector<uint64_t> keys(levelSetVertexEdges.size());
+  for (size_t iV = 0; iV < keys.size(); iV++) keys[iV] = edgeKey(levelSetVertexEdges[iV]);
+  std::vector<uint64_t> uniqueKeys = keys;
+  std::sort(uniqueKeys.begin(), uniqueKeys.end());
+  uniqueKeys.erase(std::unique(uniqueKeys.begin(), uniqueKeys.end()), uniqueKeys.end());
+
+  parent.vertexPositions.ensureHostBufferPopulated();
+  showQuantity->values.ensureHostBufferPopulated();
+  std::vector<glm::vec3> positions(uniqueKeys.size());
+  std::vector<float> shownValues(uniqueKeys.size());
+  std::vector<std::array<size_t, 3>> faces(keys.size() / 3);
+  for (size_t iV = 0; iV < keys.size(); iV++) {
+    size_t ind = std::lower_bound(uniqueKeys.begin(), uniqueKeys.end(), keys[iV]) - uniqueKeys.begin();
+    const std::array<uint32_t, 2>& e = levelSetVertexEdges[iV];
+    float t = levelSetVertexT[iV];
+    positions[ind] = (1.f - t) * parent.vertexPositions.data[e[0]] + t * parent.vertexPositions.data[e[1]];
+    shownValues[ind] = (1. - t) * showQuantity->values.data[e[0]] + t * showQuantity->values.data[e[1]];
+    faces[iV / 3][iV % 3] = ind;
+  }
+
+  SurfaceMesh* mesh = registerSurfaceMesh(name, positions, faces);
+  mesh->setTransform(parent.getTransform());
+  mesh->addVertexScalarQuantity(showQuantity->name, shownValues, showQuantity->dataType);
+  return mesh;
+}
+
 void VolumeMeshVertexScalarQuantity::drawSlice(polyscope::SlicePlane* sp) {
   if (!isEnabled()) return;
 
@@ -160,8 +378,9 @@ void VolumeMeshVertexScalarQuantity::drawSlice(polyscope::SlicePlane* sp) {
   }
   parent.setStructureUniforms(*sliceProgram);
   // Ignore current slice plane
-  sp->setSceneObjectUniforms(*sliceProgram, true);
+  sp->setSceneObjectUniformsIgnoringThis(*sliceProgram, parent);
   sp->setSliceGeomUniforms(*sliceProgram);
+  sp->setSliceDrawRanges(*sliceProgram, parent);
   parent.setVolumeMeshUniforms(*sliceProgram);
   setScalarUniforms(*sliceProgram);
   sliceProgram->draw();
@@ -187,6 +406,7 @@ void VolumeMeshVertexScalarQuantity::setLevelSetVisibleQuantity(std::string name
   fillLevelSetData(*levelSetProgram);
   setLevelSetUniforms(*levelSetProgram);
   showQuantity = q;
+  cachedLevelSetProgram.reset();
 }
 
 
@@ -198,6 +418,11 @@ void VolumeMeshVertexScalarQuantity::buildScalarOptionsUI() {
   if (ImGui::Checkbox("Level Set", &isDrawingLevelSet)) {
     setEnabledLevelSet(isDrawingLevelSet);
   }
+  if (isDrawingLevelSet) {
+    if (ImGui::Checkbox("Cache Level Set", &levelSetCaching)) {
+      setLevelSetCaching(levelSetCaching);
+    }
+  }
 }
 
 void VolumeMeshVertexScalarQuantity::buildCustomUI() {
@@ -208,7 +433,7 @@ void VolumeMeshVertexScalarQuantity::buildCustomUI() {
     ImGui::DragFloat("##value", &levelSetValue, 0.01f, (float)hist.colormapRange.first,
                      (float)hist.colormapRange.second);
     if (ImGui::BeginMenu("Show Quantity")) {
-      std::map<std::string, std::unique_ptr<polyscope::VolumeMeshQuantity>>::iterator it;
+      auto it = parent.quantities.end();
       for (it = parent.quantities.begin(); it != parent.quantities.end(); it++) {
         std::string quantityName = it->first;
         VolumeMeshQuantity* vmq = it->second.get();
@@ -225,6 +450,13 @@ void VolumeMeshVertexScalarQuantity::buildCustomUI() {
 void VolumeMeshVertexScalarQuantity::refresh() {
   VolumeMeshScalarQuantity::refresh();
   levelSetProgram.reset();
+  cachedLevelSetProgram.reset();
+}
+
+void VolumeMeshVertexScalarQuantity::refreshMaterial() {
+  VolumeMeshScalarQuantity::refreshMaterial();
+  if (levelSetProgram) render::engine->setMaterial(*levelSetProgram, parent.getMaterial());
+  if (cachedLevelSetProgram) render::engine->setMaterial(*cachedLevelSetProgram, parent.getMaterial());
 }
 
 void VolumeMeshVertexScalarQuantity::createProgram() {
@@ -255,22 +487,25 @@ void VolumeMeshVertexScalarQuantity::fillSliceColorBuffers(render::ShaderProgram
 
   values.ensureHostBufferPopulated();
 
-  size_t tetCount = parent.nTets();
-  std::vector<double> colorval_1;
-  std::vector<double> colorval_2;
-  std::vector<double> colorval_3;
-  std::vector<double> colorval_4;
+  const std::vector<std::array<uint32_t, 4>>& tets = parent.getTets();
+  const std::vector<uint32_t>& order = parent.getSliceTetOrder(); // the order of the slice buffers
+  size_t tetCount = tets.size();
+  std::vector<float> colorval_1;
+  std::vector<float> colorval_2;
+  std::vector<float> colorval_3;
+  std::vector<float> colorval_4;
 
   colorval_1.resize(tetCount);
   colorval_2.resize(tetCount);
   colorval_3.resize(tetCount);
   colorval_4.resize(tetCount);
 
-  for (size_t iT = 0; iT < parent.tets.size(); iT++) {
-    colorval_1[iT] = values.data[parent.tets[iT][0]];
-    colorval_2[iT] = values.data[parent.tets[iT][1]];
-    colorval_3[iT] = values.data[parent.tets[iT][2]];
-    colorval_4[iT] = values.data[parent.tets[iT][3]];
+  for (size_t i = 0; i < tetCount; i++) {
+    const std::array<uint32_t, 4>& tet = tets[order[i]];
+    colorval_1[i] = values.data[tet[0]];
+    colorval_2[i] = values.data[tet[1]];
+    colorval_3[i] = values.data[tet[2]];
+    colorval_4[i] = values.data[tet[3]];
   }
 
   // Store data in buffers
@@ -293,7 +528,7 @@ void VolumeMeshVertexScalarQuantity::buildVertexInfoGUI(size_t vInd) {
 // ==========            Cell Scalar             ==========
 // ========================================================
 
-VolumeMeshCellScalarQuantity::VolumeMeshCellScalarQuantity(std::string name, const std::vector<double>& values_,
+VolumeMeshCellScalarQuantity::VolumeMeshCellScalarQuantity(std::string name, const std::vector<float>& values_,
                                                            VolumeMesh& mesh_, DataType dataType_)
     : VolumeMeshScalarQuantity(name, mesh_, "cell", values_, dataType_)
 
@@ -301,11 +536,20 @@ VolumeMeshCellScalarQuantity::VolumeMeshCellScalarQuantity(std::string name, con
 
 void VolumeMeshCellScalarQuantity::createProgram() {
   // Create the program to draw this quantity
-  program = render::engine->requestShader("MESH", parent.addVolumeMeshRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
+  if (parent.canFetchCellData()) {
+    // look up the value of each cell by the triangle being drawn, rather than expanding the values to triangle corners
+    program =
+        render::engine->requestShader("MESH", parent.addVolumeMeshRules(addScalarRules({"MESH_FETCH_FACE_VALUE"})));
+    program->setTextureFromBuffer("t_faceValues", values.getTextureViewBuffer().get());
+    parent.fillGeometryBuffers(*program);
+  } else {
+    program =
+        render::engine->requestShader("MESH", parent.addVolumeMeshRules(addScalarRules({"MESH_PROPAGATE_VALUE"})));
 
-  // Fill color buffers
-  parent.fillGeometryBuffers(*program);
-  program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleCellInds));
+    // Fill color buffers
+    parent.fillGeometryBuffers(*program);
+    program->setAttribute("a_value", values.getIndexedRenderAttributeBuffer(parent.triangleCellInds));
+  }
   program->setTextureFromColormap("t_colormap", cMap.get());
   render::engine->setMaterial(*program, parent.getMaterial());
 }
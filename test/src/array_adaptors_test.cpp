@@ -158,6 +158,42 @@ struct FakeMatrix {
 };
 FakeMatrix fakeMatrix_int{{{1, 2, 3}, {4, 5, 6}}};
 
+// A wannabe Eigen matrix with direct access to its storage, in either order
+struct FakeDenseMatrix {
+  std::vector<double> myData;
+  long long int nRows;
+  enum { IsRowMajor = 0 };
+  long long int rows() const { return nRows; }
+  long long int cols() const { return 3; }
+  long long int innerStride() const { return 1; }
+  long long int outerStride() const { return nRows; }
+  const double* data() const { return myData.data(); }
+  double operator()(int i, int j) const { return myData[j * nRows + i]; }
+};
+FakeDenseMatrix fakeDenseMatrix_colMajor{{1, 4, 2, 5, 3, 6}, 2};
+
+struct FakeDenseMatrixRowMajor {
+  std::vector<float> myData;
+  enum { IsRowMajor = 1 };
+  long long int rows() const { return myData.size() / 3; }
+  long long int cols() const { return 3; }
+  long long int innerStride() const { return 1; }
+  long long int outerStride() const { return 3; }
+  const float* data() const { return myData.data(); }
+  float operator()(int i, int j) const { return myData[3 * i + j]; }
+};
+FakeDenseMatrixRowMajor fakeDenseMatrix_rowMajor{{1, 2, 3, 4, 5, 6}};
+
+// A wannabe Eigen vector viewing every other entry of its storage
+struct FakeStridedVector {
+  std::vector<double> myData;
+  long long int size() const { return myData.size() / 2; }
+  long long int innerStride() const { return 2; }
+  const double* data() const { return myData.data(); }
+  double operator[](size_t i) const { return myData[2 * i]; }
+};
+FakeStridedVector fakeStridedVector{{0.1, -1., 0.2, -1., 0.3, -1.}};
+
 
 // Nested list access with paren-vector
 struct UserArrayParenBracketCustom {
@@ -227,6 +263,24 @@ TEST(ArrayAdaptorTests, access_CallableOperator) {
 // Test that standardizeArray works with iterable
 TEST(ArrayAdaptorTests, access_Iterable) { EXPECT_EQ(polyscope::standardizeArray<double>(arr_listdouble)[0], .1); }
 
+// Test that standardizeArray works with strided and contiguous data
+TEST(ArrayAdaptorTests, access_Strided) {
+  std::vector<float> vals = polyscope::standardizeArray<float>(fakeStridedVector);
+  ASSERT_EQ(vals.size(), 3);
+  EXPECT_NEAR(vals[2], .3, 1e-5);
+}
+
+TEST(ArrayAdaptorTests, access_ContiguousLarge) {
+  // (large enough to be split across threads)
+  std::vector<double> big(1 << 20);
+  for (size_t i = 0; i < big.size(); i++) big[i] = 0.5 * i;
+  std::vector<float> asFloat = polyscope::standardizeArray<float>(big);
+  std::vector<double> asDouble = polyscope::standardizeArray<double>(big);
+  ASSERT_EQ(asFloat.size(), big.size());
+  EXPECT_EQ(asFloat[12345], 0.5f * 12345);
+  EXPECT_EQ(asDouble, big);
+}
+
 // Test that standardizeArray works with a custom accessor function
 TEST(ArrayAdaptorTests, access_FuncAccess) {
   EXPECT_EQ(polyscope::standardizeArray<double>(userArray_funcAccess)[0], .1);
@@ -235,6 +289,28 @@ TEST(ArrayAdaptorTests, access_FuncAccess) {
   EXPECT_NEAR(polyscope::standardizeArray<float>(userArray_funcAccess)[0], .1, 1e-5);
 }
 
+// Test that spans of packed data convert directly
+TEST(ArrayAdaptorTests, data_span) {
+  EXPECT_EQ(polyscope::standardizeArray<double>(polyscope::dataSpan(arr_vecdouble))[2], .3);
+  EXPECT_NEAR(polyscope::standardizeArray<float>(polyscope::dataSpan(arr_vecdouble.data(), 5))[4], .5, 1e-5);
+  EXPECT_EQ(polyscope::standardizeArray<float>(polyscope::dataSpan(arr_vecint)).size(), 5);
+
+  // vectors, as packed vector types or flat scalars
+  std::vector<glm::vec3> vecs{{1., 2., 3.}, {4., 5., 6.}};
+  std::vector<glm::vec3> out = polyscope::standardizeVectorArray<glm::vec3, 3>(polyscope::dataSpan(vecs));
+  EXPECT_EQ(out.size(), 2);
+  EXPECT_EQ(out[1], glm::vec3(4., 5., 6.));
+  std::vector<double> flat{1., 2., 3., 4., 5., 6.};
+  std::vector<std::array<double, 2>> out2 =
+      polyscope::standardizeVectorArray<std::array<double, 2>, 2>(polyscope::dataSpan(flat.data(), 3));
+  EXPECT_EQ(out2.size(), 3);
+  EXPECT_EQ(out2[2][0], 5.);
+  std::vector<glm::vec3> out3 = polyscope::standardizeVectorArray<glm::vec3, 2>(polyscope::dataSpan(flat.data(), 3));
+  EXPECT_EQ(out3[1], glm::vec3(3., 4., 0.));
+
+  EXPECT_EQ(polyscope::adaptorF_size(polyscope::dataSpan(flat.data(), 3)), 3);
+}
+
 
 // Test that accessVector2 works.
 TEST(ArrayAdaptorTests, adaptor_vector2) {
@@ -294,6 +370,28 @@ TEST(ArrayAdaptorTests, adaptor_array_vectors) {
   std::vector<std::array<double, 3>> data{{0.1, 0.2, 0.3}, {0.4, 0.5, 0.6}};
   EXPECT_NEAR((polyscope::standardizeVectorArray<glm::vec3, 3>(std::make_tuple(&data[0][0], 2))[1][1]), 0.5, 1e-5);
 
+  // contiguous packed vectors
+  std::vector<glm::vec3> vec3s{{0.1, 0.2, 0.3}, {0.4, 0.5, 0.6}};
+  EXPECT_EQ((polyscope::standardizeVectorArray<glm::vec3, 3>(vec3s)), vec3s);
+  std::vector<std::array<double, 2>> arr2s{{0.1, 0.2}, {0.4, 0.5}};
+  std::vector<glm::vec3> padded = polyscope::standardizeVectorArray<glm::vec3, 2>(arr2s);
+  EXPECT_NEAR(padded[1][1], 0.5, 1e-5);
+  EXPECT_EQ(padded[1][2], 0.);
+
+  // contiguous packed vectors, large enough to be split across threads
+  std::vector<glm::dvec3> bigVecs(1 << 18);
+  for (size_t i = 0; i < bigVecs.size(); i++) bigVecs[i] = glm::dvec3{i, 2 * i, 3 * i};
+  std::vector<glm::vec3> bigOut = polyscope::standardizeVectorArray<glm::vec3, 3>(bigVecs);
+  ASSERT_EQ(bigOut.size(), bigVecs.size());
+  EXPECT_EQ(bigOut[1000], (glm::vec3{1000, 2000, 3000}));
+
+  // strided matrix data
+  std::vector<glm::vec3> fromColMajor = polyscope::standardizeVectorArray<glm::vec3, 3>(fakeDenseMatrix_colMajor);
+  std::vector<glm::vec3> fromRowMajor = polyscope::standardizeVectorArray<glm::vec3, 3>(fakeDenseMatrix_rowMajor);
+  ASSERT_EQ(fromColMajor.size(), 2);
+  EXPECT_EQ(fromColMajor[1], (glm::vec3{4, 5, 6}));
+  EXPECT_EQ(fromRowMajor, fromColMajor);
+
   // bracket-bracket access
   EXPECT_NEAR(
       (polyscope::standardizeVectorArray<glm::vec3, 3>(std::vector<std::array<double, 3>>{{0.1, 0.2, 0.3}}))[0][0], 0.1,
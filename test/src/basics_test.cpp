@@ -2,22 +2,50 @@
 
 #include "polyscope_test.h"
 
+#include "polyscope/affine_remapper.h"
 #include "polyscope/curve_network.h"
+#include "polyscope/distributed.h"
+#include "polyscope/frame_arena.h"
+#include "polyscope/internal.h"
+#include "polyscope/occlusion_culling.h"
+#include "polyscope/parallel.h"
 #include "polyscope/pick.h"
 #include "polyscope/point_cloud.h"
 #include "polyscope/polyscope.h"
+#include "polyscope/profiling.h"
+#include "polyscope/render/managed_buffer.h"
+#include "polyscope/render/shader_builder.h"
+#include "polyscope/scene_file.h"
 #include "polyscope/surface_mesh.h"
 #include "polyscope/types.h"
+#include "polyscope/view.h"
 #include "polyscope/volume_mesh.h"
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <list>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 
 // ============================================================
 // =============== Basic tests
@@ -43,6 +71,27 @@ TEST_F(PolyscopeTest, NestedShow) {
   polyscope::state::userCallback = nullptr;
 }
 
+// An open-ended show() with idle sleeping still runs frames when there are events (the mock backend always reports
+// them), and can be exited from the callback.
+TEST_F(PolyscopeTest, SleepWhenIdle) {
+  polyscope::options::sleepWhenIdle = true;
+
+  int frameCount = 0;
+  polyscope::state::userCallback = [&]() {
+    frameCount++;
+    if (frameCount == 10) polyscope::popContext();
+  };
+  polyscope::show();
+  EXPECT_EQ(frameCount, 10);
+
+  // frame-counted shows and frameTick() are unaffected
+  polyscope::show(3);
+  polyscope::frameTick();
+
+  polyscope::state::userCallback = nullptr;
+  polyscope::options::sleepWhenIdle = false;
+}
+
 
 // Make sure that creating an empty buffer does not throw errors
 TEST_F(PolyscopeTest, EmptyBuffer) {
@@ -59,31 +108,1967 @@ TEST_F(PolyscopeTest, EmptyBuffer) {
   polyscope::removeAllStructures();
 }
 
+// Repeated pick queries on a static scene reuse the cached pick buffer; make sure the invalidation paths don't crash
+TEST_F(PolyscopeTest, PickBufferCache) {
+  auto psPoints = registerPointCloud();
 
-// ============================================================
-// =============== Ground plane tests
-// ============================================================
+  polyscope::pick::evaluatePickQuery(77, 88);
+  polyscope::pick::evaluatePickQuery(77, 88);
 
-TEST_F(PolyscopeTest, GroundPlaneTest) {
+  psPoints->setPointRadius(0.02);
+  polyscope::pick::evaluatePickQuery(77, 88);
 
-  // Add a structure and cycle through the ground plane options
+  polyscope::pick::invalidatePickBuffer();
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+  polyscope::pick::evaluatePickQuery(77, 88);
+}
+
+TEST_F(PolyscopeTest, PickQueryAsync) {
+  auto psPoints = registerPointCloud();
+
+  bool delivered = false;
+  polyscope::pick::evaluatePickQueryAsync(77, 88, [&](std::pair<polyscope::Structure*, size_t>) { delivered = true; });
+  polyscope::render::engine->processPendingReadbacks(true);
+  EXPECT_TRUE(delivered);
+  EXPECT_FALSE(polyscope::render::engine->hasPendingReadbacks());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PickRegionQuery) {
+  auto psPoints = registerPointCloud();
+
+  // Don't bother trying to actually select anything, but make sure this doesn't crash
+  polyscope::pick::evaluatePickRegionQuery(10, 20, 100, 120);
+  polyscope::pick::evaluatePickRegionQuery(100, 120, 10, 20); // flipped corners
+  polyscope::pick::evaluatePickRegionQuery(-50, -50, 1000000, 1000000);
+
+  // empty region
+  auto result = polyscope::pick::evaluatePickRegionQuery(-50, -50, -10, -10);
+  EXPECT_TRUE(result.empty());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PickIndexDigits) {
+  // the digits shaders offset from are the same ones the pick colors encode
+  for (uint64_t ind : {uint64_t(0), uint64_t(77), uint64_t(1) << 22, (uint64_t(1) << 44) + 5, uint64_t(123456789012)}) {
+    glm::uvec3 digits = polyscope::pick::indToDigits(ind);
+    glm::vec3 color = glm::vec3(digits) / static_cast<float>(1 << polyscope::pick::bitsForPickPacking);
+    EXPECT_EQ(color, polyscope::pick::indToVec(ind));
+    EXPECT_EQ(polyscope::pick::vecToInd(color), ind);
+  }
+}
+
+TEST_F(PolyscopeTest, PickRangeTable) {
+  polyscope::PointCloud* psPoints1 = polyscope::registerPointCloud("cloud1", getPoints());
+  polyscope::PointCloud* psPoints2 = polyscope::registerPointCloud("cloud2", getPoints());
+
+  // ranges far in to the 64-bit index space map back to their structures
+  size_t start1 = polyscope::pick::requestPickBufferRange(psPoints1, uint64_t(1) << 40);
+  size_t start2 = polyscope::pick::requestPickBufferRange(psPoints2, 100);
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(start1 + 12345),
+            std::make_pair(static_cast<polyscope::Structure*>(psPoints1), size_t(12345)));
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(start2 + 99),
+            std::make_pair(static_cast<polyscope::Structure*>(psPoints2), size_t(99)));
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(start2 + 100).first, nullptr);
+  EXPECT_EQ(polyscope::pick::localIndexToGlobal({psPoints2, 7}), start2 + 7);
+
+  // re-requesting a range which fits keeps the old one
+  EXPECT_EQ(polyscope::pick::requestPickBufferRange(psPoints2, 50), start2);
+
+  // released ranges no longer resolve
+  polyscope::pick::releasePickBufferRange(psPoints1);
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(start1 + 12345).first, nullptr);
+
+  // released ranges are reused, so churn does not drift the indices upward
+  size_t start3 = polyscope::pick::requestPickBufferRange(psPoints1, 10);
+  EXPECT_LE(start3, start1);
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(start3 + 9).first, psPoints1);
+  for (int i = 0; i < 5; i++) {
+    polyscope::pick::releasePickBufferRange(psPoints2);
+    EXPECT_LE(polyscope::pick::requestPickBufferRange(psPoints2, 1000), start2);
+  }
+  EXPECT_EQ(polyscope::pick::globalIndexToLocal(start3 + 9).first, psPoints1);
+  EXPECT_EQ(polyscope::pick::localIndexToGlobal({psPoints2, 0}) + 999,
+            polyscope::pick::localIndexToGlobal({psPoints2, 999}));
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SortDrawsByMaterial) {
+  polyscope::PointCloud* psPoints1 = polyscope::registerPointCloud("cloud1", getPoints());
+  polyscope::PointCloud* psPoints2 = polyscope::registerPointCloud("cloud2", getPoints());
+  polyscope::PointCloud* psPoints3 = polyscope::registerPointCloud("cloud3", getPoints());
+  psPoints1->setMaterial("wax");
+  psPoints2->setMaterial("clay");
+  psPoints3->setMaterial("wax");
+  EXPECT_EQ(psPoints1->drawSortKey(), "wax");
+  polyscope::show(3);
+
+  polyscope::options::sortDrawsByMaterial = false;
+  polyscope::show(3);
+  polyscope::options::sortDrawsByMaterial = true;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, OcclusionCulling) {
+  auto psPoints = registerPointCloud();
+  polyscope::view::resetCameraToHomeView();
+  polyscope::options::occlusionCulling = true;
+
+  // the first frame captures the depth, the next one culls against it
+  polyscope::requestRedraw();
+  polyscope::draw();
+  polyscope::requestRedraw();
+  polyscope::draw();
+  EXPECT_TRUE(polyscope::occlusion::isActive());
+
+  glm::mat4 viewProjMat = polyscope::view::getCameraPerspectiveMatrix() * polyscope::view::getCameraViewMatrix();
+  glm::vec3 lookDir, upDir, rightDir;
+  polyscope::view::getCameraFrame(lookDir, upDir, rightDir);
+  glm::vec3 cameraPos = polyscope::view::getCameraWorldPosition();
+  glm::vec3 pad{0.01f * polyscope::state::lengthScale};
+
+  // boxes around the camera, or for other views, are never culled
+  EXPECT_TRUE(polyscope::occlusion::boxMayBeVisible(cameraPos - pad, cameraPos + pad, viewProjMat));
+  EXPECT_TRUE(polyscope::occlusion::boxMayBeVisible(cameraPos - pad, cameraPos + pad, glm::mat4(1.)));
+  if (testBackend == "openGL_mock") {
+    // the mock backend reads back a depth of 0.5 everywhere, which is just in front of the camera
+    glm::vec3 farPos = cameraPos + 5.f * polyscope::state::lengthScale * lookDir;
+    EXPECT_FALSE(polyscope::occlusion::boxMayBeVisible(farPos - pad, farPos + pad, viewProjMat));
+    EXPECT_GT(polyscope::occlusion::getCulledCount(), 0u);
+  }
+
+  // culling stops when the camera jumps away from the captured view
+  polyscope::view::viewMat = glm::translate(polyscope::view::viewMat, 2.f * polyscope::state::lengthScale * rightDir);
+  polyscope::requestRedraw();
+  polyscope::draw();
+  EXPECT_FALSE(polyscope::occlusion::isActive());
+
+  // not used with transparency
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+  EXPECT_FALSE(polyscope::occlusion::isActive());
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::options::occlusionCulling = false;
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RenderQueueOrder) {
+  polyscope::PointCloud* psNear = polyscope::registerPointCloud("near", getPoints());
+  polyscope::PointCloud* psFar = polyscope::registerPointCloud("far", getPoints());
+  polyscope::PointCloud* psClay = polyscope::registerPointCloud("clay", getPoints());
+  psNear->setMaterial("wax");
+  psFar->setMaterial("wax");
+  psClay->setMaterial("clay");
+  polyscope::view::resetCameraToHomeView();
+  glm::vec3 lookDir, upDir, rightDir;
+  polyscope::view::getCameraFrame(lookDir, upDir, rightDir);
+  psFar->translate(2.f * polyscope::state::lengthScale * lookDir);
+
+  auto names = [](polyscope::RenderQueueOrder order) {
+    std::vector<std::string> result;
+    for (polyscope::RenderQueueItem& item : polyscope::buildRenderQueue(order)) {
+      result.push_back(item.structure->name);
+    }
+    return result;
+  };
+  EXPECT_EQ(names(polyscope::RenderQueueOrder::Registration), (std::vector<std::string>{"clay", "far", "near"}));
+  EXPECT_EQ(names(polyscope::RenderQueueOrder::StateSorted), (std::vector<std::string>{"clay", "near", "far"}));
+  EXPECT_EQ(names(polyscope::RenderQueueOrder::BackToFront).front(), "far");
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FrustumCulling) {
+  auto psPoints = registerPointCloud();
+  polyscope::view::resetCameraToHomeView();
+
+  glm::mat4 viewProjMat = polyscope::view::getCameraPerspectiveMatrix() * polyscope::view::getCameraViewMatrix();
+  EXPECT_TRUE(psPoints->mayBeInViewFrustum(viewProjMat));
+
+  // move the structure far off to the side of the view
+  glm::vec3 lookDir, upDir, rightDir;
+  polyscope::view::getCameraFrame(lookDir, upDir, rightDir);
+  psPoints->translate(100.f * polyscope::state::lengthScale * rightDir);
+  viewProjMat = polyscope::view::getCameraPerspectiveMatrix() * polyscope::view::getCameraViewMatrix();
+  EXPECT_FALSE(psPoints->mayBeInViewFrustum(viewProjMat));
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::options::enableFrustumCulling = false;
+  polyscope::show(3);
+  polyscope::options::enableFrustumCulling = true;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FrustumCullingManyStructures) {
+  // enough structures that the culling tests run on worker threads
+  polyscope::view::resetCameraToHomeView();
+  glm::vec3 lookDir, upDir, rightDir;
+  polyscope::view::getCameraFrame(lookDir, upDir, rightDir);
+  std::vector<polyscope::PointCloud*> clouds;
+  for (int i = 0; i < 600; i++) {
+    polyscope::PointCloud* psPoints = polyscope::registerPointCloud("cloud" + std::to_string(i), getPoints());
+    if (i % 2 == 1) psPoints->translate(100.f * polyscope::state::lengthScale * rightDir);
+    clouds.push_back(psPoints);
+  }
+  polyscope::show(3);
+
+  // the same structures are drawn as the serial tests would pick
+  glm::mat4 viewProjMat = polyscope::view::getCameraPerspectiveMatrix() * polyscope::view::getCameraViewMatrix();
+  for (polyscope::PointCloud* psPoints : clouds) {
+    bool drawn = psPoints->lastDrawnSceneCount == polyscope::internal::renderSceneCount;
+    EXPECT_EQ(drawn, psPoints->mayBeInViewFrustum(viewProjMat));
+  }
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, Viewports) {
+  auto psPoints = registerPointCloud();
+  polyscope::show(3);
+
+  polyscope::CameraParameters topCamera = polyscope::view::getCameraParametersForCurrentView();
+  polyscope::Viewport* top = polyscope::addViewport("top", topCamera, polyscope::ProjectionMode::Orthographic);
+  polyscope::Viewport* side = polyscope::addViewport("side", topCamera);
+  EXPECT_THROW(polyscope::addViewport("top", topCamera), std::runtime_error);
+  EXPECT_TRUE(polyscope::hasViewport("side"));
+  EXPECT_EQ(polyscope::getViewport("side"), side);
+
+  // each viewport renders once, and again only when something changes
+  polyscope::show(3);
+  EXPECT_EQ(top->renderCount, 1);
+  EXPECT_EQ(side->renderCount, 1);
+  EXPECT_NE(top->getColorTexture(), nullptr);
+  EXPECT_EQ(polyscope::view::projectionMode, polyscope::ProjectionMode::Perspective);
+
+  side->setCamera(topCamera);
+  polyscope::show(3);
+  EXPECT_EQ(top->renderCount, 1);
+  EXPECT_EQ(side->renderCount, 2);
+
+  psPoints->setPointRadius(0.02);
+  polyscope::show(3);
+  EXPECT_EQ(top->renderCount, 2);
+  EXPECT_EQ(side->renderCount, 3);
+
+  side->setEnabled(false);
+  psPoints->setPointRadius(0.03);
+  polyscope::show(3);
+  EXPECT_EQ(side->renderCount, 3);
+
+  polyscope::removeViewport("side");
+  EXPECT_FALSE(polyscope::hasViewport("side"));
+  polyscope::removeAllViewports();
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, IncrementalSceneExtents) {
+  // registering extends the extents, which should match recomputing them from scratch
+  for (int i = 0; i < 5; i++) {
+    std::vector<glm::vec3> points = getPoints();
+    for (glm::vec3& p : points) p = 2.f * p + glm::vec3{3.f * i, 0., 0.};
+    polyscope::registerPointCloud("cloud" + std::to_string(i), points);
+  }
+  std::tuple<glm::vec3, glm::vec3> incrementalBox = polyscope::state::boundingBox;
+  float incrementalLengthScale = polyscope::state::lengthScale;
+
+  polyscope::updateStructureExtents();
+  EXPECT_EQ(std::get<0>(incrementalBox), std::get<0>(polyscope::state::boundingBox));
+  EXPECT_EQ(std::get<1>(incrementalBox), std::get<1>(polyscope::state::boundingBox));
+  EXPECT_EQ(incrementalLengthScale, polyscope::state::lengthScale);
+
+  // removing shrinks them again
+  polyscope::removeStructure("cloud4");
+  EXPECT_LT(std::get<1>(polyscope::state::boundingBox).x, std::get<1>(incrementalBox).x);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, AdaptiveQuality) {
+  auto psPoints = registerPointCloud();
+  polyscope::options::adaptiveQuality = true;
+  polyscope::options::ssaaFactor = 2;
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
+  polyscope::show(3);
+
+  // rendering while the camera moves uses the reduced settings
+  polyscope::internal::interactiveQualityActive = true;
+  polyscope::requestRedraw();
+  polyscope::draw();
+  EXPECT_EQ(polyscope::render::engine->getSSAAFactor(), 1);
+
+  // and the full settings are restored once it is still
+  polyscope::internal::interactiveQualityActive = false;
+  polyscope::requestRedraw();
+  polyscope::draw();
+  EXPECT_EQ(polyscope::render::engine->getSSAAFactor(), 2);
+
+  polyscope::options::adaptiveQuality = false;
+  polyscope::options::ssaaFactor = 1;
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, AdaptiveDepthPeeling) {
+  auto psPoints = registerPointCloud();
+  psPoints->setTransparency(0.5);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
+  for (int i = 0; i < 4; i++) {
+    polyscope::requestRedraw();
+    polyscope::draw();
+  }
+
+  // always the full number of passes
+  polyscope::options::adaptiveTransparencyRenderPasses = false;
+  polyscope::show(3);
+
+  polyscope::options::adaptiveTransparencyRenderPasses = true;
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, TemporalAntialiasing) {
+  auto psPoints = registerPointCloud();
+  polyscope::options::temporalAntialiasing = true;
+  polyscope::options::temporalAntialiasingSamples = 4;
+
+  // a still scene accumulates samples up to the limit, then stops rendering
+  polyscope::requestRedraw();
+  polyscope::draw();
+  EXPECT_EQ(polyscope::render::engine->getTemporalSampleCount(), 1);
+  for (int i = 0; i < 6; i++) {
+    polyscope::draw();
+  }
+  EXPECT_EQ(polyscope::render::engine->getTemporalSampleCount(), 4);
+  EXPECT_TRUE(polyscope::render::engine->temporalAccumulationConverged());
+  EXPECT_EQ(polyscope::view::projectionJitter, glm::vec2(0., 0.));
+
+  // a change starts over
+  psPoints->setPointRadius(0.02);
+  polyscope::draw();
+  EXPECT_EQ(polyscope::render::engine->getTemporalSampleCount(), 1);
+
+  // screenshots take all of the samples
+  polyscope::screenshot("test_screenshot_temporal.raw", false);
+  polyscope::flushScreenshots();
+  EXPECT_TRUE(polyscope::render::engine->temporalAccumulationConverged());
+
+  polyscope::options::temporalAntialiasing = false;
+  polyscope::options::temporalAntialiasingSamples = 16;
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, AmbientOcclusion) {
   auto psMesh = registerTriangleMesh();
+  polyscope::options::ambientOcclusion = true;
+  polyscope::show(3);
 
-  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::None;
-  polyscope::refresh();
+  // the programs and buffers are made once, then reused
+  polyscope::render::engine->resetCostCounters();
+  polyscope::requestRedraw();
   polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getCostCounters().shaderCompilations, 0u);
 
-  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::Tile;
-  polyscope::refresh();
+  polyscope::options::ambientOcclusionFullResolution = true;
+  polyscope::requestRedraw();
+  polyscope::show(3);
+  polyscope::view::projectionMode = polyscope::ProjectionMode::Orthographic;
+  polyscope::requestRedraw();
   polyscope::show(3);
 
-  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
-  polyscope::refresh();
+  polyscope::view::projectionMode = polyscope::ProjectionMode::Perspective;
+  polyscope::options::ambientOcclusionFullResolution = false;
+  polyscope::options::ambientOcclusion = false;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, DeferredShading) {
+  auto psMesh = registerTriangleMesh();
+  auto psPoints = registerPointCloud();
+  psPoints->setMaterial("wax");
+  polyscope::render::engine->setDeferredShading(true);
+  EXPECT_TRUE(polyscope::render::engine->deferredShadingActive());
+  polyscope::show(3);
+
+  // the G-buffer and lighting pass are made once, then reused
+  polyscope::render::engine->resetCostCounters();
+  polyscope::requestRedraw();
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getCostCounters().shaderCompilations, 0u);
+
+  // changing a material marks it as in use
+  psMesh->setMaterial("candy");
+  polyscope::show(3);
+
+  // transparency falls back to forward lighting
+  polyscope::render::engine->setTransparencyMode(polyscope::TransparencyMode::Simple);
+  EXPECT_FALSE(polyscope::render::engine->deferredShadingActive());
+  polyscope::show(3);
+  polyscope::render::engine->setTransparencyMode(polyscope::TransparencyMode::None);
+  EXPECT_TRUE(polyscope::render::engine->deferredShadingActive());
+  polyscope::show(3);
+
+  polyscope::render::engine->setDeferredShading(false);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, DynamicResolution) {
+  auto psPoints = registerPointCloud();
+  polyscope::options::dynamicResolution = true;
+  polyscope::show(3);
+
+  // scale the scene buffers directly
+  polyscope::render::engine->setResolutionScale(0.5);
+  EXPECT_EQ(polyscope::render::engine->getSceneBufferScale(), 0.5);
+  polyscope::requestRedraw();
+  polyscope::draw();
+  EXPECT_THROW(polyscope::render::engine->setResolutionScale(0.), std::runtime_error);
+
+  // with the camera at rest, the next frame renders at full resolution again
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getResolutionScale(), 1.);
+
+  polyscope::options::dynamicResolution = false;
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RenderScale) {
+  auto psPoints = registerPointCloud();
+  polyscope::options::renderScale = 0.5;
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getSceneBufferScale(), 0.5);
+
+  // dynamic resolution scales down from the render scale, and returns to it at rest
+  polyscope::options::dynamicResolution = true;
+  polyscope::show(3);
+  EXPECT_LE(polyscope::render::engine->getResolutionScale(), 0.5);
+  polyscope::options::dynamicResolution = false;
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getResolutionScale(), 0.5);
+
+  // the logical resolution of the window
+  polyscope::options::renderScale = -1.;
+  polyscope::show(3);
+  float expected = std::min(1.f, static_cast<float>(polyscope::view::windowWidth) / polyscope::view::bufferWidth);
+  EXPECT_FLOAT_EQ(polyscope::render::engine->getResolutionScale(), expected);
+
+  polyscope::options::renderScale = 1.;
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getResolutionScale(), 1.);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, Profiling) {
+  auto psPoints = registerPointCloud();
+  polyscope::options::enableProfiling = true;
+  polyscope::options::alwaysRedraw = true;
+  polyscope::show(3);
+
+  std::map<std::string, polyscope::profiling::TimerStats> stats = polyscope::profiling::getTimerStats();
+  EXPECT_TRUE(stats.find("renderScene") != stats.end());
+  EXPECT_TRUE(stats.find("drawStructures") != stats.end());
+  polyscope::profiling::TimerStats renderStats = polyscope::profiling::getTimerStats("renderScene");
+  EXPECT_GE(renderStats.callsPerFrame, 1);
+  EXPECT_GE(renderStats.cpu.maxMs, renderStats.cpu.meanMs);
+
+  // unknown timers are empty
+  EXPECT_EQ(polyscope::profiling::getTimerStats("not a timer").callsPerFrame, 0);
+
+  // capture every frame
+  uint64_t firstFrame = polyscope::profiling::getFrameIndex();
+  polyscope::profiling::beginFrameCapture();
+  polyscope::show(4);
+  std::vector<polyscope::profiling::FrameTimings> frames = polyscope::profiling::endFrameCapture();
+  ASSERT_GE(frames.size(), 4);
+  for (size_t i = 0; i < frames.size(); i++) {
+    EXPECT_EQ(frames[i].frame, firstFrame + i);
+  }
+  EXPECT_TRUE(frames[1].cpuMs.find("draw") != frames[1].cpuMs.end());
+  EXPECT_TRUE(polyscope::profiling::endFrameCapture().empty());
+
+  polyscope::profiling::resetTimers();
+  EXPECT_TRUE(polyscope::profiling::getTimerStats().empty());
+
+  polyscope::options::enableProfiling = false;
+  polyscope::options::alwaysRedraw = false;
+  polyscope::show(3);
+  EXPECT_TRUE(polyscope::profiling::getTimerStats().empty());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, LowLatencyInteraction) {
+  auto psPoints = registerPointCloud();
+  polyscope::options::enableProfiling = true;
+  polyscope::options::lowLatencyInteraction = true;
+  polyscope::options::swapInterval = 0;
+  polyscope::show(3);
+
+  // the latency of each frame of the main loop is recorded
+  polyscope::profiling::TimerStats latency = polyscope::profiling::getTimerStats("input to present");
+  EXPECT_EQ(latency.callsPerFrame, 1);
+  EXPECT_GE(latency.cpu.lastMs, 0.);
+
+  polyscope::options::swapInterval = -1;
+  polyscope::show(3);
+
+  polyscope::options::swapInterval = 1;
+  polyscope::options::lowLatencyInteraction = false;
+  polyscope::options::enableProfiling = false;
+  polyscope::profiling::resetTimers();
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ReuseIdleUI) {
+  auto psPoints = registerPointCloud();
+  size_t callbackFrames = 0;
+  polyscope::state::userCallback = [&]() { callbackFrames++; };
+  polyscope::options::reuseIdleUI = true;
+
+  // once nothing happens for a few frames, the UI (and the callback) is not built again
+  polyscope::show(20);
+  EXPECT_GT(callbackFrames, 0);
+  EXPECT_LT(callbackFrames, 20);
+
+  // a callback which keeps requesting redraws keeps being invoked
+  callbackFrames = 0;
+  polyscope::state::userCallback = [&]() {
+    callbackFrames++;
+    polyscope::requestRedraw();
+  };
+  polyscope::show(20);
+  EXPECT_EQ(callbackFrames, 20);
+
+  polyscope::options::reuseIdleUI = false;
+  polyscope::state::userCallback = nullptr;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ProfilingTrace) {
+  polyscope::options::alwaysRedraw = true;
+
+  // timers run while tracing, even with profiling off
+  EXPECT_FALSE(polyscope::profiling::isTracing());
+  polyscope::profiling::beginTrace();
+  EXPECT_TRUE(polyscope::profiling::isTracing());
+  auto psPoints = registerPointCloud();
+  polyscope::show(3);
+  std::string filename = "test_trace.json";
+  polyscope::profiling::endTrace(filename);
+  EXPECT_FALSE(polyscope::profiling::isTracing());
+
+  std::ifstream inFile(filename);
+  std::string trace((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(trace.compare(0, 15, "{\"displayTimeUn"), 0);
+  EXPECT_NE(trace.find("\"name\":\"renderScene\""), std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"registerStructure\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"i\""), std::string::npos);
+  inFile.close();
+  std::remove(filename.c_str());
+
+  polyscope::options::alwaysRedraw = false;
+  polyscope::profiling::resetTimers();
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, InitPhaseTimes) {
+  // (init() ran in the fixture setup)
+  std::vector<polyscope::profiling::InitPhaseTime> phases = polyscope::profiling::getInitPhaseTimes();
+  auto hasPhase = [&](std::string name) {
+    for (const polyscope::profiling::InitPhaseTime& p : phases) {
+      if (p.name == name) return p.ms >= 0.;
+    }
+    return false;
+  };
+  EXPECT_TRUE(hasPhase("global buffers"));
+  EXPECT_TRUE(hasPhase("imgui and fonts"));
+
+  // the deferred setup happens by the first frame
+  auto psPoints = registerPointCloud();
+  polyscope::show(3);
+  EXPECT_NE(polyscope::render::engine->copyDepth, nullptr);
+  EXPECT_TRUE(polyscope::render::engine->getMaterial("clay").isLoaded());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, FrameArena) {
+  polyscope::FrameArena arena(256);
+
+  // allocations are aligned, and spill in to new blocks as needed
+  void* a = arena.allocate(10, 1);
+  double* b = static_cast<double*>(arena.allocate(3 * sizeof(double), alignof(double)));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(double), 0);
+  EXPECT_NE(a, static_cast<void*>(b));
+  arena.allocate(1000); // larger than a block
+  EXPECT_GE(arena.bytesUsed(), 1000 + 10 + 3 * sizeof(double));
+  size_t capacity = arena.capacity();
+
+  // resetting keeps the blocks, so doing the same again needs no more memory
+  arena.reset();
+  EXPECT_EQ(arena.bytesUsed(), 0);
+  EXPECT_EQ(arena.allocate(10, 1), a);
+  arena.allocate(3 * sizeof(double), alignof(double));
+  arena.allocate(1000);
+  EXPECT_EQ(arena.capacity(), capacity);
+
+  // containers on top of the per-frame arena
+  polyscope::FrameVector<int> vals;
+  for (int i = 0; i < 100; i++) vals.push_back(i);
+  EXPECT_EQ(vals[77], 77);
+  polyscope::FrameString str("a string which is too long for the small string optimization");
+  str += "!";
+  EXPECT_EQ(str.back(), '!');
+  EXPECT_STREQ(polyscope::frameFormat("%s #%d", "node", 12), "node #12");
+  polyscope::show(3);
+}
+
+TEST_F(PolyscopeTest, HeapAllocationTracking) {
+  if (!polyscope::profiling::heapAllocationTrackingEnabled()) {
+    EXPECT_EQ(polyscope::profiling::getHeapAllocationCount(), 0);
+    GTEST_SKIP() << "built without POLYSCOPE_TRACK_HEAP_ALLOCATIONS";
+  }
+
+  uint64_t before = polyscope::profiling::getHeapAllocationCount();
+  std::unique_ptr<std::vector<int>> allocated(new std::vector<int>(100));
+  EXPECT_GE(polyscope::profiling::getHeapAllocationCount(), before + 2);
+
+  // once the frame arena has grown, temporaries from it don't touch the heap
+  polyscope::show(1);
+  polyscope::FrameVector<int>(1000, 1);
+  polyscope::show(1);
+  before = polyscope::profiling::getHeapAllocationCount();
+  polyscope::FrameVector<int>(1000, 1);
+  polyscope::frameFormat("%s (%d)", "a label", 3);
+  EXPECT_EQ(polyscope::profiling::getHeapAllocationCount(), before);
+
+  // steady-state frames are counted
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  psPoints->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::options::alwaysRedraw = true;
+  polyscope::show(5);
+  polyscope::profiling::beginFrameCapture();
+  polyscope::show(2);
+  std::vector<polyscope::profiling::FrameTimings> frames = polyscope::profiling::endFrameCapture();
+  ASSERT_EQ(frames.size(), 2);
+  EXPECT_EQ(frames[1].heapAllocations, polyscope::profiling::getLastFrameHeapAllocations());
+  RecordProperty("steadyStateFrameHeapAllocations", std::to_string(frames[1].heapAllocations));
+  polyscope::options::alwaysRedraw = false;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, MemoryUsage) {
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  psPoints->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+
+  // the point positions and scalar values are both on the device and the host
+  polyscope::render::GPUMemoryUsage usage = psPoints->getGPUMemoryUsage();
+  EXPECT_GE(usage.attributeBytes, psPoints->nPoints() * (sizeof(glm::vec3) + sizeof(float)));
+  EXPECT_EQ(usage.totalBytes(), usage.attributeBytes + usage.textureBytes + usage.renderBufferBytes);
+  EXPECT_GE(psPoints->getHostMemoryUsage(), psPoints->nPoints() * (sizeof(glm::vec3) + sizeof(double)));
+
+  // quantities are counted under their own prefix, too
+  polyscope::Quantity* q = psPoints->getQuantity("vScalar");
+  EXPECT_GT(polyscope::render::getManagedBufferHostBytes(q->uniquePrefix()), 0);
+  EXPECT_LE(polyscope::render::getGPUMemoryUsage(q->uniquePrefix()).totalBytes(), usage.totalBytes());
+
+  // the global totals include the engine's own buffers
+  EXPECT_GT(polyscope::render::getGPUMemoryUsage().totalBytes(), usage.totalBytes());
+
+  // and it all goes away with the structure
+  std::string prefix = psPoints->uniquePrefix();
+  polyscope::removeAllStructures();
+  EXPECT_EQ(polyscope::render::getGPUMemoryUsage(prefix).totalBytes(), 0);
+  EXPECT_EQ(polyscope::render::getManagedBufferHostBytes(prefix), 0);
+}
+
+TEST_F(PolyscopeTest, FeatureBuffersAllocatedOnUse) {
+  registerPointCloud();
+
+  // The depth peeling targets only take up memory in that mode
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::show(3);
+  size_t noneBytes = polyscope::render::getGPUMemoryUsage().totalBytes();
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
   polyscope::show(3);
+  size_t prettyBytes = polyscope::render::getGPUMemoryUsage().totalBytes();
+  EXPECT_GT(prettyBytes, noneBytes);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::show(3);
+  EXPECT_LT(polyscope::render::getGPUMemoryUsage().totalBytes(), prettyBytes);
 
+  // Turning off the ground shadow releases its buffers
   polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::ShadowOnly;
-  polyscope::refresh();
+  polyscope::show(3);
+  size_t shadowBytes = polyscope::render::getGPUMemoryUsage().totalBytes();
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::None;
+  polyscope::show(3);
+  EXPECT_LT(polyscope::render::getGPUMemoryUsage().totalBytes(), shadowBytes);
+
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, EngineCostCounters) {
+  auto psPoints = registerPointCloud();
+  size_t n = psPoints->nPoints();
+  std::vector<double> vScalar(n, 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // drawing a frame is counted, both in total and per frame
+  polyscope::render::engine->resetCostCounters();
+  polyscope::options::alwaysRedraw = true;
+  polyscope::show(2);
+  const polyscope::render::EngineCostCounters& frameCosts = polyscope::render::engine->getLastFrameCostCounters();
+  EXPECT_GT(frameCosts.drawCalls, 0);
+  EXPECT_GT(frameCosts.stateChanges, 0);
+  EXPECT_EQ(frameCosts.shaderCompilations, 0);
+  EXPECT_GE(polyscope::render::engine->getCostCounters().drawCalls, 2 * frameCosts.drawCalls);
+  polyscope::options::alwaysRedraw = false;
+
+  // updating the scalar uploads its values, once, and nothing else of the cloud
+  polyscope::render::engine->resetCostCounters();
+  q1->updateData(std::vector<double>(n, 3.));
+  polyscope::show(3);
+  polyscope::render::EngineCostCounters costs = polyscope::render::engine->getCostCounters();
+  EXPECT_EQ(costs.bytesUploadedPerBuffer[q1->values.name], n * sizeof(float));
+  EXPECT_EQ(costs.bytesUploadedPerBuffer.count(psPoints->points.name), 0);
+  EXPECT_GE(costs.bytesUploaded, n * sizeof(float));
+
+  // toggling a slice plane compiles nothing, once the programs have been seen with planes
+  polyscope::SlicePlane* plane = polyscope::addSceneSlicePlane();
+  polyscope::show(3);
+  plane->setActive(false);
+  polyscope::show(3);
+  polyscope::render::engine->resetCostCounters();
+  plane->setActive(true);
+  polyscope::show(3);
+  plane->setActive(false);
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getCostCounters().shaderCompilations, 0);
+
+  // new structures allocate their buffers
+  polyscope::render::engine->resetCostCounters();
+  polyscope::registerPointCloud("cloud2", getPoints());
+  polyscope::show(3);
+  EXPECT_GT(polyscope::render::engine->getCostCounters().bufferAllocations, 0);
+
+  polyscope::removeLastSceneSlicePlane();
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SharedColorMapTextures) {
+  auto psPoints1 = polyscope::registerPointCloud("cloud1", getPoints());
+  auto psPoints2 = polyscope::registerPointCloud("cloud2", getPoints());
+  std::vector<double> vScalar(psPoints1->nPoints(), 7.);
+  auto q1 = psPoints1->addScalarQuantity("vScalar", vScalar);
+  auto q2 = psPoints2->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  q2->setEnabled(true);
+  q1->setColorMap("blues");
+  polyscope::show(3);
+
+  // one texture per colormap, held by the engine rather than by either structure
+  EXPECT_EQ(polyscope::render::engine->getColorMapTexture("viridis"),
+            polyscope::render::engine->getColorMapTexture("viridis"));
+  EXPECT_GT(polyscope::render::getGPUMemoryUsage("colormaps").textureBytes, 0);
+
+  // switching between colormaps which have been used creates no textures
+  size_t colormapBytes = polyscope::render::getGPUMemoryUsage("colormaps").textureBytes;
+  q1->setColorMap("viridis");
+  q2->setColorMap("blues");
+  polyscope::show(3);
+  q1->setColorMap("blues");
+  q2->setColorMap("viridis");
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::getGPUMemoryUsage("colormaps").textureBytes, colormapBytes);
+
+  // a new one is created once, however many programs use it
+  q1->setColorMap("reds");
+  q2->setColorMap("reds");
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::getGPUMemoryUsage("colormaps").textureBytes,
+            colormapBytes + polyscope::render::engine->getColorMap("reds").values.size() * 3 * sizeof(float));
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, GPUMemoryBudget) {
+  auto psPoints1 = polyscope::registerPointCloud("cloud1", getPoints());
+  auto psPoints2 = polyscope::registerPointCloud("cloud2", getPoints());
+  std::vector<double> vScalar(psPoints2->nPoints(), 7.);
+  psPoints2->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_GT(psPoints2->getGPUMemoryUsage().totalBytes(), 0);
+
+  // with no room at all, anything not drawn gets evicted
+  polyscope::options::gpuMemoryBudgetMB = 0;
+  psPoints2->setEnabled(false);
+  polyscope::show(3);
+  EXPECT_EQ(psPoints2->getGPUMemoryUsage().totalBytes(), 0);
+  EXPECT_GT(psPoints1->getGPUMemoryUsage().totalBytes(), 0);
+  EXPECT_EQ(psPoints2->getPointPosition(1), getPoints()[1]);
+
+  // and rebuilt when it is drawn again
+  psPoints2->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_GT(psPoints2->getGPUMemoryUsage().totalBytes(), 0);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // data which only lived on the device survives eviction
+  polyscope::options::hostMemoryPolicy = polyscope::HostMemoryPolicy::ReleaseAfterUpload;
+  psPoints2->updatePointPositions(getPoints());
+  polyscope::show(3);
+  psPoints2->setEnabled(false);
+  polyscope::show(3);
+  EXPECT_EQ(psPoints2->getGPUMemoryUsage().totalBytes(), 0);
+  EXPECT_EQ(psPoints2->getPointPosition(1), getPoints()[1]);
+  psPoints2->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::options::hostMemoryPolicy = polyscope::HostMemoryPolicy::KeepHostCopy;
+  polyscope::options::gpuMemoryBudgetMB = -1;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CompressDisabledQuantities) {
+  polyscope::options::compressDisabledQuantities = true;
+  polyscope::options::enableProfiling = true;
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  polyscope::PointCloudScalarQuantity* q = psPoints->addScalarQuantity("vScalar", vScalar);
+  q->setEnabled(true);
+  polyscope::show(3);
+  size_t hostBytes = polyscope::render::getManagedBufferHostBytes(q->uniquePrefix());
+  EXPECT_GT(polyscope::render::getGPUMemoryUsage(q->uniquePrefix()).totalBytes(), 0);
+
+  // disabling compresses the values and frees the GPU buffers
+  q->setEnabled(false);
+  EXPECT_TRUE(q->values.hostDataIsCompressed());
+  EXPECT_LT(polyscope::render::getManagedBufferHostBytes(q->uniquePrefix()), hostBytes);
+  EXPECT_EQ(polyscope::render::getGPUMemoryUsage(q->uniquePrefix()).totalBytes(), 0);
+  EXPECT_EQ(q->values.size(), psPoints->nPoints());
+  polyscope::show(3);
+
+  // and enabling restores them
+  q->setEnabled(true);
+  EXPECT_FALSE(q->values.hostDataIsCompressed());
+  EXPECT_EQ(q->values.getValue(3), 7.f);
+  polyscope::show(3);
+  EXPECT_GT(polyscope::render::getGPUMemoryUsage(q->uniquePrefix()).totalBytes(), 0);
+  std::map<std::string, polyscope::profiling::TimerStats> stats = polyscope::profiling::getTimerStats();
+  EXPECT_TRUE(stats.find("enable compressed quantity") != stats.end());
+
+  // the compression is lossless
+  std::vector<glm::vec3> vals;
+  for (size_t i = 0; i < 1000; i++) {
+    vals.push_back(glm::vec3{static_cast<float>(i / 10), 0.1f * i, i % 3 == 0 ? -1.f / (i + 1) : 2.f});
+  }
+  std::vector<glm::vec3> data = vals;
+  polyscope::render::ManagedBuffer<glm::vec3> buffer("compressed", data);
+  buffer.getRenderAttributeBuffer();
+  buffer.compressHostData();
+  EXPECT_TRUE(buffer.hostDataIsCompressed());
+  EXPECT_TRUE(data.empty());
+  EXPECT_EQ(buffer.getValue(999), vals[999]);
+  EXPECT_EQ(data, vals);
+
+  // updating the data replaces the compressed copy
+  buffer.compressHostData();
+  data = std::vector<glm::vec3>(5, glm::vec3{1., 2., 3.});
+  buffer.markHostBufferUpdated();
+  EXPECT_FALSE(buffer.hostDataIsCompressed());
+  EXPECT_EQ(buffer.size(), 5);
+
+  polyscope::options::compressDisabledQuantities = false;
+  polyscope::options::enableProfiling = false;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ShaderReplacements) {
+  // rules for the same tag are inserted in order, and tags without rules are left empty
+  std::vector<polyscope::render::ShaderStageSpecification> stages = {polyscope::render::ShaderStageSpecification{
+      polyscope::render::ShaderStageType::Vertex,
+      {},
+      {{"a_position", polyscope::RenderDataType::Vector3Float}},
+      {},
+      "void main() {\n${ BODY }$\n${ UNUSED }$\n}\n"}};
+  std::vector<polyscope::render::ShaderReplacementRule> rules = {
+      polyscope::render::ShaderReplacementRule("FIRST", {{"BODY", "int a = 1;"}}, {},
+                                               {{"a_value", polyscope::RenderDataType::Float}}, {}),
+      polyscope::render::ShaderReplacementRule("SECOND", {{"BODY", "int b = 2;"}})};
+  std::vector<polyscope::render::ShaderStageSpecification> replaced =
+      polyscope::render::applyShaderReplacements(stages, rules);
+  ASSERT_EQ(replaced.size(), 1);
+  const std::string& src = replaced[0].src;
+  EXPECT_NE(src.find("int a = 1;"), std::string::npos);
+  EXPECT_LT(src.find("int a = 1;"), src.find("int b = 2;"));
+  EXPECT_LT(src.find("int b = 2;"), src.find("// tag ${ UNUSED }$"));
+  EXPECT_EQ(replaced[0].attributes.size(), 2);
+
+  // unbalanced tags are an error
+  std::vector<polyscope::render::ShaderStageSpecification> unbalanced = {polyscope::render::ShaderStageSpecification{
+      polyscope::render::ShaderStageType::Vertex, {}, {}, {}, "void main() { ${ BODY }\n"}};
+  EXPECT_THROW(polyscope::render::applyShaderReplacements(unbalanced, rules), std::runtime_error);
+}
+
+TEST_F(PolyscopeTest, FrameUniformBlock) {
+  // the frame-global uniforms are moved out of the program's own uniforms
+  std::vector<polyscope::render::ShaderStageSpecification> stages = {polyscope::render::ShaderStageSpecification{
+      polyscope::render::ShaderStageType::Vertex,
+      {{"u_modelView", polyscope::RenderDataType::Matrix44Float},
+       {"u_projMatrix", polyscope::RenderDataType::Matrix44Float}},
+      {},
+      {},
+      "uniform mat4 u_modelView;\nuniform mat4 u_projMatrix;\nvoid main() {}\n"}};
+  std::vector<polyscope::render::ShaderStageSpecification> updated = polyscope::render::useFrameUniformBlock(stages);
+  ASSERT_EQ(updated.size(), 1);
+  ASSERT_EQ(updated[0].uniforms.size(), 1);
+  EXPECT_EQ(updated[0].uniforms[0].name, "u_modelView");
+  EXPECT_EQ(updated[0].src.find("uniform mat4 u_projMatrix;"), std::string::npos);
+  EXPECT_NE(updated[0].src.find(polyscope::render::frameUniformBlockName), std::string::npos);
+
+  // the shared values follow the camera
+  polyscope::show(3);
+  uint64_t version = polyscope::render::engine->getFrameUniformsVersion();
+  polyscope::view::fov = 50.;
+  polyscope::show(3);
+  EXPECT_GT(polyscope::render::engine->getFrameUniformsVersion(), version);
+  EXPECT_EQ(polyscope::render::engine->getFrameProjMatrix(), polyscope::view::getCameraPerspectiveMatrix());
+  polyscope::view::fov = 45.;
+}
+
+TEST_F(PolyscopeTest, UniformHandles) {
+  std::shared_ptr<polyscope::render::ShaderProgram> program =
+      polyscope::render::engine->requestShader("RAYCAST_SPHERE", {"SHADE_BASECOLOR"});
+
+  polyscope::render::UniformHandle radius = program->getUniformHandle("u_pointRadius");
+  EXPECT_TRUE(program->hasUniform(radius));
+  program->setUniform(radius, 0.1f);
+  EXPECT_THROW(program->setUniform(radius, glm::vec3{1., 2., 3.}), std::invalid_argument);
+
+  EXPECT_THROW(program->getUniformHandle("u_notAUniform"), std::invalid_argument);
+  EXPECT_THROW(program->setUniform(polyscope::render::UniformHandle(), 0.1f), std::invalid_argument);
+}
+
+TEST_F(PolyscopeTest, ComputePrograms) {
+  using namespace polyscope::render;
+
+  // clang-format off
+  ShaderStageSpecification doubleValues = {
+    ShaderStageType::Compute,
+    { {"u_count", polyscope::RenderDataType::UInt}, },
+    { },
+    { },
+    R"(
+      ${ GLSL_VERSION }$
+      layout(local_size_x = 64) in;
+      uniform uint u_count;
+      layout(std430) buffer b_values { float values[]; };
+      void main() {
+        uint i = gl_GlobalInvocationID.x;
+        if (i < u_count) values[i] *= 2.;
+      }
+    )",
+    { {"b_values", polyscope::RenderDataType::Float}, }
+  };
+  // clang-format on
+  engine->registerShaderProgram("TEST_DOUBLE_VALUES", {doubleValues}, polyscope::DrawMode::Compute);
+
+  // the mock backend builds and validates compute programs, but reports that it cannot run them
+  EXPECT_FALSE(engine->supportsComputeShaders());
+  std::shared_ptr<ShaderProgram> program =
+      engine->requestShader("TEST_DOUBLE_VALUES", {}, ShaderReplacementDefaults::Compute);
+  EXPECT_TRUE(program->isCompute());
+  EXPECT_TRUE(program->hasStorageBuffer("b_values"));
+  EXPECT_FALSE(program->storageBufferIsSet("b_values"));
+  EXPECT_THROW(program->dispatch(1), std::invalid_argument);
+
+  std::shared_ptr<AttributeBuffer> values = engine->generateAttributeBuffer(polyscope::RenderDataType::Float);
+  values->setData(std::vector<float>(100, 1.f));
+  std::shared_ptr<AttributeBuffer> wrongType = engine->generateAttributeBuffer(polyscope::RenderDataType::Vector3Float);
+  EXPECT_THROW(program->setStorageBuffer("b_values", wrongType), std::invalid_argument);
+  EXPECT_THROW(program->setStorageBuffer("b_nope", values), std::invalid_argument);
+  program->setStorageBuffer("b_values", values);
+  program->setUniform("u_count", 100u);
+
+  size_t dispatches = engine->getCostCounters().computeDispatches;
+  program->dispatch(2);
+  engine->memoryBarrier(MemoryBarrierType::HostRead);
+  EXPECT_EQ(engine->getCostCounters().computeDispatches, dispatches + 1);
+  EXPECT_THROW(program->draw(), std::runtime_error);
+
+  // draw programs cannot be dispatched
+  std::shared_ptr<ShaderProgram> drawProgram = engine->requestShader("RAYCAST_SPHERE", {"SHADE_BASECOLOR"});
+  EXPECT_FALSE(drawProgram->isCompute());
+  EXPECT_THROW(drawProgram->dispatch(1), std::runtime_error);
+}
+
+TEST_F(PolyscopeTest, AttributeBufferTextures) {
+  using namespace polyscope::render;
+
+  // clang-format off
+  ShaderStageSpecification vertStage = {
+    ShaderStageType::Vertex,
+    { },
+    { {"a_position", polyscope::RenderDataType::Vector3Float}, },
+    { {"t_offsets", 1}, },
+    R"(
+      ${ GLSL_VERSION }$
+      in vec3 a_position;
+      uniform samplerBuffer t_offsets;
+      vec3 fetchBufferVec3(samplerBuffer t, int i);
+      void main() { gl_Position = vec4(a_position + fetchBufferVec3(t_offsets, gl_VertexID), 1.); }
+    )"
+  };
+  ShaderStageSpecification fragStage = {
+    ShaderStageType::Fragment, { }, { }, { },
+    R"(
+      ${ GLSL_VERSION }$
+      layout(location = 0) out vec4 outputF;
+      void main() { outputF = vec4(1.); }
+    )"
+  };
+  // clang-format on
+  engine->registerShaderProgram("TEST_OFFSET_POINTS", {vertStage, fragStage}, polyscope::DrawMode::Points);
+  std::shared_ptr<ShaderProgram> program =
+      engine->requestShader("TEST_OFFSET_POINTS", {}, ShaderReplacementDefaults::Process);
+
+  // the same buffer is both the attribute and the indexable texture
+  std::shared_ptr<AttributeBuffer> positions = engine->generateAttributeBuffer(polyscope::RenderDataType::Vector3Float);
+  program->setAttribute("a_position", positions);
+  program->setTextureFromAttributeBuffer("t_offsets", positions);
+  EXPECT_TRUE(program->textureIsSet("t_offsets"));
+  EXPECT_THROW(program->draw(), std::invalid_argument); // not filled yet
+  positions->setData(std::vector<glm::vec3>(10, glm::vec3{1., 2., 3.}));
+  program->draw();
+
+  std::shared_ptr<AttributeBuffer> matrices = engine->generateAttributeBuffer(polyscope::RenderDataType::Matrix44Float);
+  EXPECT_THROW(program->setTextureFromAttributeBuffer("t_offsets", matrices), std::invalid_argument);
+  EXPECT_THROW(program->setTextureFromAttributeBuffer("t_nope", positions), std::invalid_argument);
+
+  // only 1D textures can be read from buffers
+  std::shared_ptr<ShaderProgram> texProgram = engine->requestShader("TEXTURE_DRAW_PLAIN", {});
+  EXPECT_THROW(texProgram->setTextureFromAttributeBuffer("t_image", positions), std::invalid_argument);
+}
+
+TEST_F(PolyscopeTest, RenderGraph) {
+  using namespace polyscope::render;
+  RenderGraph graph;
+  std::vector<std::string> ran;
+
+  // Declares a frame: a -> (transient t1) -> b -> out, c -> (transient t2) -> d -> out, e writes an unused resource
+  auto declare = [&](uint64_t key) {
+    graph.beginFrame();
+    RenderResource out = graph.importResource("out");
+    RenderResource unused = graph.importResource("unused");
+    RenderResource t1 = graph.createTransientTexture("t1", polyscope::TextureFormat::RGBA16F, 8, 8);
+    RenderResource t2 = graph.createTransientTexture("t2", polyscope::TextureFormat::RGBA16F, 8, 8);
+    graph.addPass("a", {}, {t1}, [&]() { ran.push_back("a"); }, key);
+    graph.addPass("b", {t1}, {out}, [&]() { ran.push_back("b"); }, key);
+    graph.addPass("c", {}, {t2}, [&]() { ran.push_back("c"); }, key);
+    graph.addPass("d", {t2, out}, {out}, [&]() {
+      EXPECT_NE(graph.getTexture(t2), nullptr);
+      ran.push_back("d");
+    }, key);
+    graph.addPass("e", {}, {unused}, [&]() { ran.push_back("e"); }, key);
+    graph.markOutput(out);
+  };
+
+  // The unused pass is culled, and the two transients share a texture
+  declare(1);
+  graph.execute();
+  EXPECT_EQ(ran, std::vector<std::string>({"a", "b", "c", "d"}));
+  EXPECT_EQ(graph.getStats().passesCulled, 1u);
+  EXPECT_EQ(graph.getStats().transientResources, 2u);
+  EXPECT_EQ(graph.getStats().transientTextures, 1u);
+  size_t pooledBytes = graph.getPooledTextureBytes();
+  EXPECT_GT(pooledBytes, 0u);
+
+  // Nothing changed, so everything skips
+  ran.clear();
+  declare(1);
+  graph.execute();
+  EXPECT_TRUE(ran.empty());
+  EXPECT_EQ(graph.getStats().passesSkipped, 4u);
+
+  // A new key reruns everything, as does invalidating the imported resources
+  declare(2);
+  graph.execute();
+  EXPECT_EQ(ran, std::vector<std::string>({"a", "b", "c", "d"}));
+  ran.clear();
+  graph.invalidate();
+  declare(2);
+  graph.execute();
+  EXPECT_EQ(ran, std::vector<std::string>({"a", "b", "c", "d"}));
+
+  // Unused pooled textures are freed after a few frames
+  for (int i = 0; i <= graph.transientRetainFrames; i++) {
+    declare(2);
+    graph.execute();
+  }
+  EXPECT_EQ(graph.getPooledTextureBytes(), 0u);
+
+  // Transients are only accessible while executing
+  EXPECT_THROW(graph.getTexture(0), std::runtime_error);
+}
+
+TEST_F(PolyscopeTest, RenderGraphPartialSkip) {
+  using namespace polyscope::render;
+  RenderGraph graph;
+  std::vector<std::string> ran;
+
+  // Two passes drawing in to the same target, then one reading it
+  auto declare = [&](uint64_t keyFirst, uint64_t keySecond, uint64_t keyRead) {
+    graph.beginFrame();
+    RenderResource color = graph.importResource("color");
+    RenderResource result = graph.importResource("result");
+    graph.addPass("first", {}, {color}, [&]() { ran.push_back("first"); }, keyFirst);
+    graph.addPass("second", {}, {color}, [&]() { ran.push_back("second"); }, keySecond);
+    graph.addPass("read", {color}, {result}, [&]() { ran.push_back("read"); }, keyRead);
+    graph.markOutput(result);
+  };
+  declare(1, 1, 1);
+  graph.execute();
+
+  // Only the reader changed
+  ran.clear();
+  declare(1, 1, 2);
+  graph.execute();
+  EXPECT_EQ(ran, std::vector<std::string>({"read"}));
+
+  // The second pass draws over what the first one drew, so that has to rerun too
+  ran.clear();
+  declare(1, 2, 2);
+  graph.execute();
+  EXPECT_EQ(ran, std::vector<std::string>({"first", "second", "read"}));
+}
+
+TEST_F(PolyscopeTest, StaticStructures) {
+  auto psStatic = registerPointCloud("static");
+  auto psDynamic = registerPointCloud("dynamic");
+  EXPECT_FALSE(psStatic->isStatic());
+  psStatic->setStatic(true);
+  EXPECT_TRUE(psStatic->isStatic());
+
+  // Only changes to the dynamic structure count as dynamic
+  uint64_t dynamicChanges = polyscope::internal::dynamicContentChanges;
+  psStatic->setPointRadius(0.02);
+  psStatic->updatePointPositions(getPoints());
+  EXPECT_EQ(polyscope::internal::dynamicContentChanges, dynamicChanges);
+  psDynamic->setPointRadius(0.02);
+  EXPECT_GT(polyscope::internal::dynamicContentChanges, dynamicChanges);
+  dynamicChanges = polyscope::internal::dynamicContentChanges;
+  psDynamic->updatePointPositions(getPoints());
+  EXPECT_GT(polyscope::internal::dynamicContentChanges, dynamicChanges);
+
+  // The static layer exists while there is something to put in it
+  polyscope::show(3);
+  EXPECT_TRUE(polyscope::render::engine->hasStaticLayer());
+  psStatic->setStatic(false);
+  polyscope::show(3);
+  EXPECT_FALSE(polyscope::render::engine->hasStaticLayer());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, StructureRegistryOrderAndHandles) {
+  // structures and quantities iterate in the order they were added
+  polyscope::PointCloud* psZ = registerPointCloud("z_cloud");
+  polyscope::PointCloud* psA = registerPointCloud("a_cloud");
+  std::vector<std::string> names;
+  for (auto& x : polyscope::state::structures[polyscope::PointCloud::structureTypeName]) {
+    names.push_back(x.first);
+  }
+  EXPECT_EQ(names, (std::vector<std::string>{"z_cloud", "a_cloud"}));
+
+  std::vector<double> vals(psA->nPoints(), 1.);
+  psA->addScalarQuantity("z_vals", vals);
+  psA->addScalarQuantity("a_vals", vals);
+  EXPECT_EQ(psA->quantities.begin()->first, "z_vals");
+  psA->removeQuantity("z_vals");
+  EXPECT_EQ(psA->quantities.begin()->first, "a_vals");
+  EXPECT_NE(psA->getQuantity("a_vals"), nullptr);
+
+  // handles find structures without their names, and expire when the structure is removed
+  polyscope::StructureHandle hZ = psZ->getHandle();
+  polyscope::StructureHandle hA = psA->getHandle();
+  EXPECT_NE(hZ, 0);
+  EXPECT_NE(hZ, hA);
+  EXPECT_EQ(polyscope::getStructureByHandle(hA), psA);
+  polyscope::removeStructure(psZ);
+  EXPECT_EQ(polyscope::getStructureByHandle(hZ), nullptr);
+  EXPECT_EQ(polyscope::getStructureByHandle(hA), psA);
+  EXPECT_EQ(polyscope::getStructure(polyscope::PointCloud::structureTypeName, "a_cloud"), psA);
+
+  // replacing a structure hands out a new handle
+  polyscope::PointCloud* psA2 = registerPointCloud("a_cloud");
+  EXPECT_EQ(polyscope::getStructureByHandle(hA), nullptr);
+  polyscope::StructureHandle hA2 = psA2->getHandle();
+  EXPECT_EQ(polyscope::getStructureByHandle(hA2), psA2);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  EXPECT_EQ(polyscope::getStructureByHandle(hA2), nullptr);
+}
+
+TEST_F(PolyscopeTest, LargeStructureList) {
+  // enough structures that the UI switches to a clipped list
+  for (int i = 0; i < 100; i++) {
+    registerPointCloud("cloud" + std::to_string(i));
+  }
+  auto& clouds = polyscope::state::structures[polyscope::PointCloud::structureTypeName];
+  EXPECT_EQ(clouds.entryAt(0).first, "cloud0");
+  EXPECT_EQ(clouds.entryAt(99).first, "cloud99");
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PersistentValueCache) {
+  {
+    polyscope::PersistentValue<float> val("test#persistent#val", 1.);
+    EXPECT_EQ(val.get(), 1.);
+    EXPECT_EQ(val.getName(), "test#persistent#val");
+    val.set(2.);
+  }
+
+  // a new value with the same name picks up the last value set
+  polyscope::PersistentValue<float> val("test#persistent#val", 1.);
+  EXPECT_EQ(val.get(), 2.);
+  val.setPassive(3.);
+  EXPECT_EQ(val.get(), 2.);
+
+  // names can be interned ahead of time, and are shared between types
+  polyscope::detail::PersistentKey key = polyscope::detail::internPersistentName("test#persistent#val");
+  polyscope::PersistentValue<float> valFromKey(key, 1.);
+  EXPECT_EQ(valFromKey.get(), 2.);
+  polyscope::PersistentValue<bool> otherType(key, true);
+  EXPECT_TRUE(otherType.get());
+  EXPECT_EQ(polyscope::detail::internPersistentName("test#persistent#val"), key);
+}
+
+TEST_F(PolyscopeTest, PersistentValueScoping) {
+  // the settings of a removed structure are forgotten, unless it is replaced or they are pinned
+  registerPointCloud("scoped")->setPointRadius(0.123, false);
+  polyscope::removeStructure("scoped");
+  EXPECT_NE(registerPointCloud("scoped")->getPointRadius(), 0.123);
+
+  polyscope::getPointCloud("scoped")->setPointRadius(0.123, false);
+  EXPECT_EQ(registerPointCloud("scoped")->getPointRadius(), 0.123);
+
+  polyscope::pinPersistentValues(polyscope::getPointCloud("scoped")->uniquePrefix());
+  polyscope::removeStructure("scoped");
+  EXPECT_EQ(registerPointCloud("scoped")->getPointRadius(), 0.123);
+  polyscope::unpinPersistentValues(polyscope::getPointCloud("scoped")->uniquePrefix());
+
+  polyscope::options::retainRemovedStructureSettings = true;
+  polyscope::getPointCloud("scoped")->setPointRadius(0.456, false);
+  polyscope::removeStructure("scoped");
+  EXPECT_EQ(registerPointCloud("scoped")->getPointRadius(), 0.456);
+  polyscope::options::retainRemovedStructureSettings = false;
+  polyscope::removeAllStructures();
+
+  // names no live value uses are evicted least recently used first
+  polyscope::options::maxRetainedPersistentValues = 10;
+  for (int i = 0; i < 100; i++) {
+    polyscope::PersistentValue<float> val("test#lru#" + std::to_string(i), 0.);
+    val.set(static_cast<float>(i));
+  }
+  EXPECT_LE(polyscope::detail::retainedPersistentNameCount(), 10u);
+  {
+    polyscope::PersistentValue<float> oldest("test#lru#0", -1.);
+    EXPECT_EQ(oldest.get(), -1.);
+    polyscope::PersistentValue<float> newest("test#lru#99", -1.);
+    EXPECT_EQ(newest.get(), 99.);
+  }
+  polyscope::options::maxRetainedPersistentValues = 100000;
+}
+
+TEST_F(PolyscopeTest, PostToMainThread) {
+  // producer threads register structures, moving their data in to the queue
+  std::vector<std::thread> producers;
+  for (int iThread = 0; iThread < 4; iThread++) {
+    producers.emplace_back([iThread]() {
+      std::vector<glm::vec3> pts(100, glm::vec3{1., 2., 3.});
+      auto registerFunc = [iThread](std::vector<glm::vec3>& p) {
+        polyscope::registerPointCloud("posted" + std::to_string(iThread), p);
+      };
+      polyscope::postToMainThread(std::bind(registerFunc, std::move(pts)));
+    });
+  }
+  for (std::thread& t : producers) t.join();
+  EXPECT_FALSE(polyscope::hasPointCloud("posted0"));
+
+  // they are applied at the start of the next main loop iteration
+  polyscope::show(1);
+  for (int iThread = 0; iThread < 4; iThread++) {
+    EXPECT_TRUE(polyscope::hasPointCloud("posted" + std::to_string(iThread)));
+  }
+
+  // updates run in order
+  std::vector<int> order;
+  polyscope::postToMainThread([&]() { order.push_back(1); });
+  polyscope::postToMainThread([&]() { order.push_back(2); });
+  polyscope::processPostedUpdates();
+  EXPECT_EQ(order, (std::vector<int>{1, 2}));
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ParallelFor) {
+  polyscope::options::maxWorkerThreads = 4;
+
+  // every entry is visited exactly once
+  std::vector<int> visits(1000, 0);
+  polyscope::parallelFor(
+      0, visits.size(),
+      [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) visits[i]++;
+      },
+      1);
+  for (int v : visits) EXPECT_EQ(v, 1);
+
+  // exceptions are forwarded to the caller
+  EXPECT_THROW(polyscope::parallelFor(
+                   0, 1000, [&](size_t start, size_t end) { throw std::runtime_error("oops"); }, 1),
+               std::runtime_error);
+
+  // empty range
+  polyscope::parallelFor(5, 5, [&](size_t start, size_t end) { FAIL(); });
+
+  // nested parallel work shares the pool
+  std::vector<int> nestedVisits(8 * 1000, 0);
+  {
+    polyscope::TaskGroup group;
+    for (size_t iTask = 0; iTask < 8; iTask++) {
+      group.run([&, iTask]() {
+        polyscope::parallelFor(
+            iTask * 1000, (iTask + 1) * 1000,
+            [&](size_t start, size_t end) {
+              for (size_t i = start; i < end; i++) nestedVisits[i]++;
+            },
+            1);
+      });
+    }
+    group.wait();
+  }
+  for (int v : nestedVisits) EXPECT_EQ(v, 1);
+
+  polyscope::options::maxWorkerThreads = -1;
+}
+
+TEST_F(PolyscopeTest, ParallelBackend) {
+  polyscope::options::maxWorkerThreads = 4;
+
+  // an application scheduler (here, a serial one) receives all of the work
+  size_t nJobs = 0;
+  polyscope::setParallelBackend([&](size_t n, const std::function<void(size_t)>& job) {
+    nJobs += n;
+    for (size_t i = 0; i < n; i++) job(i);
+  });
+
+  std::vector<int> visits(1000, 0);
+  polyscope::parallelFor(
+      0, visits.size(),
+      [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) visits[i]++;
+      },
+      1);
+  for (int v : visits) EXPECT_EQ(v, 1);
+  EXPECT_GT(nJobs, 1u);
+
+  polyscope::TaskGroup group;
+  group.run([]() { throw std::runtime_error("oops"); });
+  EXPECT_THROW(group.wait(), std::runtime_error);
+
+  polyscope::setParallelBackend(nullptr);
+  polyscope::options::maxWorkerThreads = -1;
+}
+
+TEST_F(PolyscopeTest, RobustMinMaxParallel) {
+
+  // large enough to be split over several chunks, with non-finite values which must be skipped
+  std::vector<float> vals(300000, 1.f);
+  vals[12] = -std::numeric_limits<float>::infinity();
+  vals[70000] = std::numeric_limits<float>::quiet_NaN();
+  vals[150001] = -3.f;
+  vals[299999] = 5.f;
+  std::pair<double, double> range = polyscope::robustMinMax(vals);
+  EXPECT_EQ(range.first, -3.);
+  EXPECT_EQ(range.second, 5.);
+
+  // no finite values
+  std::vector<float> nans(10, std::numeric_limits<float>::quiet_NaN());
+  range = polyscope::robustMinMax(nans);
+  EXPECT_EQ(range.first, -1.);
+  EXPECT_EQ(range.second, 1.);
+}
+
+TEST_F(PolyscopeTest, BoundsAndLengthScaleParallel) {
+  std::vector<glm::vec3> pts;
+  for (size_t i = 0; i < 100003; i++) {
+    pts.push_back(glm::vec3{polyscope::randomReal(-1., 2.), polyscope::randomReal(-5., 0.), polyscope::randomUnit()});
+  }
+  pts[777].y = std::numeric_limits<float>::quiet_NaN();
+
+  // matches a serial scan, for counts which do and don't fill the last vector step
+  for (size_t n : {size_t(0), size_t(1), size_t(13), pts.size()}) {
+    glm::vec3 expMin = glm::vec3{1, 1, 1} * std::numeric_limits<float>::infinity();
+    glm::vec3 expMax = -expMin;
+    for (size_t i = 0; i < n; i++) {
+      expMin = polyscope::componentwiseMin(expMin, pts[i]);
+      expMax = polyscope::componentwiseMax(expMax, pts[i]);
+    }
+    float expDist2 = 0.;
+    for (size_t i = 0; i < n; i++) {
+      expDist2 = std::max(expDist2, glm::length2(pts[i] - 0.5f * (expMin + expMax)));
+    }
+
+    glm::vec3 min, max;
+    float lengthScale;
+    polyscope::computeBoundsAndLengthScale(pts.data(), n, min, max, lengthScale);
+    EXPECT_EQ(min, expMin);
+    EXPECT_EQ(max, expMax);
+    EXPECT_NEAR(lengthScale, 2 * std::sqrt(expDist2), 1e-5);
+  }
+}
+
+
+// ============================================================
+// =============== Ground plane tests
+// ============================================================
+
+TEST_F(PolyscopeTest, LazyDefaultMaterials) {
+  // all of the built-in materials are available from startup
+  std::vector<std::string> names;
+  for (const std::unique_ptr<polyscope::render::Material>& m : polyscope::render::engine->materials) {
+    names.push_back(m->name);
+    EXPECT_TRUE(m->isBuiltIn);
+  }
+  EXPECT_EQ(names.size(), 8);
+  EXPECT_NE(std::find(names.begin(), names.end(), "jade"), names.end());
+
+  // and their textures are there once used
+  auto psPoints = registerPointCloud();
+  psPoints->setMaterial("jade");
+  polyscope::show(3);
+  polyscope::render::Material& jade = polyscope::render::engine->getMaterial("jade");
+  EXPECT_TRUE(jade.isLoaded());
+  EXPECT_FALSE(jade.supportsRGB);
+  for (const std::shared_ptr<polyscope::render::TextureBuffer>& t : jade.textureBuffers) {
+    EXPECT_NE(t, nullptr);
+  }
+  EXPECT_TRUE(polyscope::render::engine->getMaterial("candy").supportsRGB);
+  EXPECT_THROW(polyscope::render::engine->getMaterial("not a material"), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, GroundPlaneTest) {
+
+  // Add a structure and cycle through the ground plane options
+  auto psMesh = registerTriangleMesh();
+
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::None;
+  polyscope::refresh();
+  polyscope::show(3);
+
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::Tile;
+  polyscope::refresh();
+  polyscope::show(3);
+
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
+  polyscope::refresh();
+  polyscope::show(3);
+
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::ShadowOnly;
+  polyscope::refresh();
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, GroundPlaneShadowCache) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::ShadowOnly;
+  polyscope::refresh();
+  polyscope::show(3);
+
+  // moving the camera redraws, but does not count as a change to the scene, so the cached shadow is reused
+  uint64_t contentVersion = polyscope::internal::sceneContentVersion;
+  polyscope::view::processZoom(0.5);
+  polyscope::view::processRotate(glm::vec2{0., 0.}, glm::vec2{0.1, 0.2});
+  EXPECT_TRUE(polyscope::redrawRequested());
+  EXPECT_EQ(polyscope::internal::sceneContentVersion, contentVersion);
+  polyscope::show(3);
+
+  // changes to the structures re-render it
+  psMesh->translate(glm::vec3{0., 1., 0.});
+  polyscope::show(3);
+  psMesh->setEnabled(false);
+  EXPECT_GT(polyscope::internal::sceneContentVersion, contentVersion);
+  polyscope::show(3);
+
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, GroundPlaneLockedHeightAndReflectionScale) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::options::groundPlaneMode = polyscope::GroundPlaneMode::TileReflection;
+  polyscope::options::groundPlaneHeightLocked = true;
+  polyscope::refresh();
+  polyscope::show(3);
+
+  // the ground stays put as the scene moves
+  psMesh->translate(glm::vec3{0., -1., 0.});
+  polyscope::show(3);
+
+  // a smaller mirrored image, which is re-rendered when the camera moves
+  polyscope::options::groundReflectionScale = 0.25;
+  polyscope::show(3);
+  polyscope::view::processZoom(0.5);
+  polyscope::show(3);
+
+  polyscope::options::groundPlaneHeightLocked = false;
+  polyscope::options::groundReflectionScale = 0.5;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RenderSequence) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+
+  std::vector<polyscope::CameraParameters> cameras;
+  for (int i = 0; i < 4; i++) {
+    polyscope::view::processRotate(glm::vec2{0., 0.}, glm::vec2{0.1, 0.});
+    cameras.push_back(polyscope::view::getCameraParametersForCurrentView());
+  }
+  int initialWidth = polyscope::view::bufferWidth;
+  int initialHeight = polyscope::view::bufferHeight;
+
+  // frames are rendered at the requested size, in order
+  std::vector<size_t> frameInds;
+  polyscope::renderSequence(
+      cameras,
+      [&](size_t iFrame, std::vector<unsigned char>& pixels, int w, int h) {
+        EXPECT_EQ(w, 64);
+        EXPECT_EQ(h, 48);
+        EXPECT_EQ(pixels.size(), 64 * 48 * 4);
+        frameInds.push_back(iFrame);
+      },
+      64, 48, false);
+  ASSERT_EQ(frameInds.size(), cameras.size());
+  for (size_t i = 0; i < frameInds.size(); i++) {
+    EXPECT_EQ(frameInds[i], i);
+  }
+
+  // the view is restored afterwards
+  EXPECT_EQ(polyscope::view::bufferWidth, initialWidth);
+  EXPECT_EQ(polyscope::view::bufferHeight, initialHeight);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ScreenshotTiled) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+  int initialWidth = polyscope::view::bufferWidth;
+  int initialHeight = polyscope::view::bufferHeight;
+
+  // a tile covering the whole image has the usual projection
+  glm::mat4 fullProj = polyscope::view::getCameraPerspectiveMatrix();
+  polyscope::view::projectionTileImageSize = glm::ivec2{initialWidth, initialHeight};
+  glm::mat4 tileProj = polyscope::view::getCameraPerspectiveMatrix();
+  polyscope::view::projectionTileImageSize = glm::ivec2{0, 0};
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      EXPECT_NEAR(tileProj[i][j], fullProj[i][j], 1e-5);
+    }
+  }
+
+  // strips arrive from the top, cropped to the image
+  std::vector<int> rowStarts;
+  polyscope::renderTiled(
+      100, 70,
+      [&](int rowStart, std::vector<unsigned char>& pixels, int w, int h) {
+        EXPECT_EQ(w, 100);
+        EXPECT_EQ(pixels.size(), static_cast<size_t>(w) * h * 4);
+        rowStarts.push_back(rowStart);
+      },
+      32, false);
+  EXPECT_EQ(rowStarts, (std::vector<int>{0, 6, 38}));
+  EXPECT_EQ(polyscope::view::bufferWidth, initialWidth);
+  EXPECT_EQ(polyscope::view::bufferHeight, initialHeight);
+
+  polyscope::screenshotTiled("test_screenshot_tiled.raw", 100, 70, 32);
+  {
+    std::ifstream inFile("test_screenshot_tiled.raw", std::ios::binary | std::ios::ate);
+    ASSERT_TRUE(inFile.good());
+    EXPECT_EQ(static_cast<size_t>(inFile.tellg()), 100 * 70 * 4);
+  }
+  std::remove("test_screenshot_tiled.raw");
+
+  polyscope::screenshotTiled("test_screenshot_tiled.png", 100, 70, 32);
+  {
+    std::ifstream inFile("test_screenshot_tiled.png", std::ios::binary);
+    ASSERT_TRUE(inFile.good());
+    char signature[8];
+    inFile.read(signature, 8);
+    EXPECT_EQ(std::string(signature + 1, 3), "PNG");
+  }
+  std::remove("test_screenshot_tiled.png");
+
+  EXPECT_THROW(polyscope::screenshotTiled("test_screenshot_tiled.jpg", 100, 70), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ScreenshotBackgroundEncode) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+
+  // raw files are just the pixels, so the size is known
+  ASSERT_TRUE(polyscope::options::screenshotEncodeInBackground);
+  polyscope::screenshot("test_screenshot_background.raw", false);
+  polyscope::screenshotAsync("test_screenshot_background_async.raw", false);
+  polyscope::flushScreenshots();
+
+  size_t expectedBytes = static_cast<size_t>(polyscope::view::bufferWidth) * polyscope::view::bufferHeight * 4;
+  for (std::string filename : {"test_screenshot_background.raw", "test_screenshot_background_async.raw"}) {
+    std::ifstream inFile(filename, std::ios::binary | std::ios::ate);
+    ASSERT_TRUE(inFile.good());
+    EXPECT_EQ(static_cast<size_t>(inFile.tellg()), expectedBytes);
+    inFile.close();
+    std::remove(filename.c_str());
+  }
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RecordingCallback) {
+  auto psMesh = registerTriangleMesh();
+
+  size_t nFrames = 0;
+  int initialWidth = polyscope::view::bufferWidth;
+  int initialHeight = polyscope::view::bufferHeight;
+  polyscope::startRecording(
+      [&](const std::vector<unsigned char>& pixels, int w, int h) {
+        EXPECT_EQ(w, initialWidth);
+        EXPECT_EQ(h, initialHeight);
+        EXPECT_EQ(pixels.size(), static_cast<size_t>(w) * h * 4);
+        nFrames++;
+      },
+      30);
+  EXPECT_TRUE(polyscope::isRecording());
+  polyscope::show(3);
+
+  // the first frame is always due
+  polyscope::stopRecording();
+  EXPECT_FALSE(polyscope::isRecording());
+  EXPECT_GE(nFrames, 1);
+
+  polyscope::removeAllStructures();
+}
+
+#ifndef _WIN32
+TEST_F(PolyscopeTest, RemoteServer) {
+  auto psMesh = registerTriangleMesh();
+  int port = 28765;
+  polyscope::startRemoteServer(port, 60);
+  EXPECT_TRUE(polyscope::isRemoteServerRunning());
+  EXPECT_FALSE(polyscope::hasRemoteClient());
+
+  auto connectToServer = [&]() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    EXPECT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    return fd;
+  };
+  auto exchange = [](int fd, std::string request) {
+    send(fd, request.data(), request.size(), 0);
+    std::string response;
+    char buf[4096];
+    while (response.find("\r\n\r\n") == std::string::npos) {
+      ssize_t got = recv(fd, buf, sizeof(buf), 0);
+      if (got <= 0) break;
+      response.append(buf, got);
+    }
+    return response;
+  };
+
+  // the client page
+  int pageFd = connectToServer();
+  EXPECT_EQ(exchange(pageFd, "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n").compare(0, 15, "HTTP/1.1 200 OK"), 0);
+  close(pageFd);
+
+  // the WebSocket handshake, with the example key from RFC 6455
+  int wsFd = connectToServer();
+  std::string response = exchange(wsFd, "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+                                        "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                        "Sec-WebSocket-Version: 13\r\n\r\n");
+  EXPECT_NE(response.find("101 Switching Protocols"), std::string::npos);
+  EXPECT_NE(response.find("s3pPLMBiTxaQ9kYGzhZRbK+xOo="), std::string::npos);
+  for (int i = 0; i < 100 && !polyscope::hasRemoteClient(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(polyscope::hasRemoteClient());
+
+  // frames are sent as binary messages
+  polyscope::show(3);
+  polyscope::render::engine->processPendingReadbacks(true);
+  unsigned char header[2] = {0, 0};
+  EXPECT_EQ(recv(wsFd, header, 2, MSG_WAITALL), 2);
+  EXPECT_EQ(header[0], 0x82);
+
+  close(wsFd);
+  polyscope::stopRemoteServer();
+  EXPECT_FALSE(polyscope::isRemoteServerRunning());
+  polyscope::removeAllStructures();
+}
+#endif
+
+// An in-process stand-in for MPI: ranks are threads, and sends are buffered in mailboxes
+class ThreadCommunicators {
+public:
+  ThreadCommunicators(int size) {
+    for (int r = 0; r < size; r++) {
+      polyscope::distributed::Communicator comm;
+      comm.rank = r;
+      comm.size = size;
+      comm.send = [this, r](int peer, const void* data, size_t bytes) { post(r, peer, data, bytes); };
+      comm.recv = [this, r](int peer, void* data, size_t bytes) { take(peer, r, data, bytes); };
+      comm.exchange = [this, r](int peer, const void* sendData, size_t sendBytes, void* recvData, size_t recvBytes) {
+        post(r, peer, sendData, sendBytes);
+        take(peer, r, recvData, recvBytes);
+      };
+      comms.push_back(comm);
+    }
+  }
+  std::vector<polyscope::distributed::Communicator> comms;
+
+private:
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::map<std::pair<int, int>, std::list<std::vector<unsigned char>>> mailboxes;
+
+  void post(int from, int to, const void* data, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const unsigned char* bytesPtr = static_cast<const unsigned char*>(data);
+    mailboxes[{from, to}].emplace_back(bytesPtr, bytesPtr + bytes);
+    cv.notify_all();
+  }
+  void take(int from, int to, void* data, size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto& box = mailboxes[{from, to}];
+    cv.wait(lock, [&]() { return !box.empty(); });
+    EXPECT_EQ(box.front().size(), bytes);
+    std::copy(box.front().begin(), box.front().begin() + std::min(bytes, box.front().size()),
+              static_cast<unsigned char*>(data));
+    box.pop_front();
+  }
+};
+
+TEST_F(PolyscopeTest, DistributedCompositeImages) {
+  int w = 7;
+  int h = 5;
+  size_t nPix = w * h;
+
+  // Rank r draws color r + 1 at depth ((pixel + r) mod size), or nothing where that is size - 1
+  for (int size : {1, 2, 3, 4, 6}) {
+    ThreadCommunicators threadComms(size);
+    std::vector<std::vector<unsigned char>> colors(size, std::vector<unsigned char>(4 * nPix));
+    std::vector<std::vector<float>> depths(size, std::vector<float>(nPix));
+    for (int r = 0; r < size; r++) {
+      for (size_t i = 0; i < nPix; i++) {
+        int d = (i + r) % size;
+        bool empty = size > 1 && d == size - 1;
+        depths[r][i] = empty ? std::numeric_limits<float>::infinity() : d;
+        for (int c = 0; c < 4; c++) colors[r][4 * i + c] = empty ? 0 : r + 1;
+      }
+    }
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < size; r++) {
+      threads.emplace_back([&, r]() {
+        polyscope::distributed::compositeImages(threadComms.comms[r], colors[r], depths[r], w, h);
+      });
+    }
+    for (std::thread& t : threads) t.join();
+
+    for (size_t i = 0; i < nPix; i++) {
+      float expectedDepth = std::numeric_limits<float>::infinity();
+      int expectedRank = -1;
+      for (int r = 0; r < size; r++) {
+        int d = (i + r) % size;
+        if (size > 1 && d == size - 1) continue;
+        if (d < expectedDepth) {
+          expectedDepth = d;
+          expectedRank = r;
+        }
+      }
+      EXPECT_EQ(depths[0][i], expectedDepth);
+      EXPECT_EQ(colors[0][4 * i], expectedRank < 0 ? 0 : expectedRank + 1);
+    }
+  }
+}
+
+TEST_F(PolyscopeTest, DistributedRender) {
+  auto psMesh = registerTriangleMesh();
+
+  // A single rank composites to its own render
+  polyscope::distributed::Communicator comm;
+  std::vector<unsigned char> image = polyscope::distributed::renderComposited(comm);
+  EXPECT_EQ(image.size(), 4 * static_cast<size_t>(polyscope::view::bufferWidth) * polyscope::view::bufferHeight);
+
+  // Two ranks pick up rank 0's view and enabled states; the scene extents cover both ranks' structures
+  ThreadCommunicators threadComms(2);
+  std::string viewJson = polyscope::view::getViewAsJson();
+  glm::vec3 farAway{100., 0., 0.};
+  std::thread other([&]() {
+    polyscope::distributed::Communicator& comm1 = threadComms.comms[1];
+    std::array<float, 7> extents{1., farAway.x, farAway.y, farAway.z, farAway.x, farAway.y, farAway.z};
+    comm1.send(0, extents.data(), sizeof(extents));
+    std::string state;
+    polyscope::distributed::broadcast(comm1, state);
+    EXPECT_NE(state.find("false"), std::string::npos);
+  });
+  psMesh->setEnabled(false);
+  polyscope::distributed::synchronizeState(threadComms.comms[0]);
+  other.join();
+  EXPECT_EQ(std::get<1>(polyscope::state::boundingBox).x, farAway.x);
+  EXPECT_EQ(polyscope::view::getViewAsJson(), viewJson);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ShowAsync) {
+  std::atomic<size_t> callbackFrames{0};
+  polyscope::state::userCallback = [&]() { callbackFrames++; };
+
+  polyscope::showAsync();
+  EXPECT_TRUE(polyscope::isShowingAsync());
+
+  // Updates posted from this thread run on the render thread
+  std::thread::id updateThread;
+  polyscope::postToMainThread([&]() {
+    updateThread = std::this_thread::get_id();
+    polyscope::registerPointCloud("async points", std::vector<glm::vec3>(10, glm::vec3{1., 2., 3.}));
+  });
+  polyscope::waitForPostedUpdates();
+  EXPECT_NE(updateThread, std::this_thread::get_id());
+
+  size_t framesBefore = callbackFrames;
+  polyscope::waitForNextFrame();
+  EXPECT_GT(callbackFrames, framesBefore);
+
+  polyscope::stopAsync();
+  EXPECT_FALSE(polyscope::isShowingAsync());
+  EXPECT_TRUE(polyscope::hasPointCloud("async points"));
+
+  // The viewer can be shown again
+  polyscope::showAsync();
+  polyscope::waitForNextFrame();
+  polyscope::stopAsync();
+
+  polyscope::state::userCallback = nullptr;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, RenderToBuffers) {
+  auto psMesh = registerTriangleMesh();
+  polyscope::show(3);
+
+  size_t nPix = static_cast<size_t>(polyscope::view::bufferWidth) * polyscope::view::bufferHeight;
+  std::vector<unsigned char> color(4 * nPix);
+  std::vector<float> depth(nPix);
+  std::vector<float> normal(3 * nPix);
+  std::vector<uint64_t> pickID(nPix, 7);
+
+  polyscope::RenderBufferTargets targets;
+  targets.color = color.data();
+  targets.depth = depth.data();
+  targets.normal = normal.data();
+  targets.pickID = pickID.data();
+  polyscope::renderToBuffers(targets, false);
+
+  // the mock backend reads back empty pick IDs and a constant depth, which is a flat surface facing the camera
+  EXPECT_EQ(pickID[nPix / 2], 0);
+  EXPECT_GT(depth[nPix / 2], 0.);
+  EXPECT_NEAR(normal[3 * (nPix / 2) + 2], 1., 1e-3);
+
+  // targets can be skipped
+  polyscope::RenderBufferTargets depthOnly;
+  depthOnly.depth = depth.data();
+  polyscope::renderToBuffers(depthOnly);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SceneFileRoundTrip) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 3.);
+  std::vector<glm::vec3> fColor(psMesh->nFaces(), glm::vec3{.2, .3, .4});
+  psMesh->addVertexScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  psMesh->addFaceColorQuantity("fColor", fColor);
+  psMesh->setSurfaceColor(glm::vec3{.1, .2, .3});
+  auto psPoints = registerPointCloud();
+  psPoints->addScalarQuantity("pScalar", std::vector<double>(psPoints->nPoints(), 5.), polyscope::DataType::SYMMETRIC);
+  size_t nTris = psMesh->nFacesTriangulation();
+  size_t nPoints = psPoints->nPoints();
+  polyscope::show(3);
+
+  polyscope::saveScene("test_scene.psscene");
+  polyscope::removeAllStructures();
+  polyscope::loadScene("test_scene.psscene");
+
+  // geometry and derived buffers come straight from the file
+  ASSERT_TRUE(polyscope::hasSurfaceMesh("test1"));
+  polyscope::SurfaceMesh* loadedMesh = polyscope::getSurfaceMesh("test1");
+  EXPECT_TRUE(loadedMesh->vertexPositions.hasExternalData());
+  EXPECT_TRUE(loadedMesh->triangleVertexInds.hasExternalData());
+  EXPECT_EQ(loadedMesh->nFacesTriangulation(), nTris);
+  EXPECT_EQ(loadedMesh->getSurfaceColor(), glm::vec3(.1, .2, .3));
+  EXPECT_NE(loadedMesh->getQuantity("vScalar"), nullptr);
+  EXPECT_NE(loadedMesh->getQuantity("fColor"), nullptr);
+
+  ASSERT_TRUE(polyscope::hasPointCloud("test1"));
+  polyscope::PointCloud* loadedPoints = polyscope::getPointCloud("test1");
+  EXPECT_TRUE(loadedPoints->points.hasExternalData());
+  EXPECT_EQ(loadedPoints->nPoints(), nPoints);
+  EXPECT_NE(loadedPoints->getQuantity("pScalar"), nullptr);
   polyscope::show(3);
 
   polyscope::removeAllStructures();
+  std::remove("test_scene.psscene");
 }
@@ -158,3 +158,93 @@ TEST_F(PolyscopeTest, AddCameraViewScalarImage) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, CameraViewImageTexturePaging) {
+  polyscope::options::imageTexturePaging = true;
+  polyscope::options::imageTextureUploadsPerFrame = 1;
+
+  int width = 30;
+  int height = 40;
+  std::vector<std::array<float, 4>> imageColor(width * height);
+  std::vector<float> imageScalar(width * height);
+  std::vector<polyscope::CameraView*> cams;
+  for (int i = 0; i < 3; i++) {
+    polyscope::CameraView* cam = polyscope::registerCameraView(
+        "cam" + std::to_string(i),
+        polyscope::CameraParameters(polyscope::CameraIntrinsics::fromFoVDegVerticalAndAspect(60, 2.),
+                                    polyscope::CameraExtrinsics::fromVectors(
+                                        glm::vec3{2., 2., 2. + i}, glm::vec3{-1., -1., -1.}, glm::vec3{0., 1., 0.})));
+    cams.push_back(cam);
+  }
+
+  polyscope::ColorImageQuantity* im0 = cams[0]->addColorAlphaImageQuantity("color", width, height, imageColor,
+                                                                           polyscope::ImageOrigin::UpperLeft);
+  im0->setTextureFormat(polyscope::TextureFormat::RGBA8);
+  im0->setEnabled(true);
+  polyscope::ScalarImageQuantity* im1 =
+      cams[1]->addScalarImageQuantity("scalar", width, height, imageScalar, polyscope::ImageOrigin::UpperLeft);
+  im1->setTextureFormat(polyscope::TextureFormat::R16F);
+  im1->setEnabled(true);
+  polyscope::ColorImageQuantity* im2 = cams[2]->addColorAlphaImageQuantity("color", width, height, imageColor,
+                                                                           polyscope::ImageOrigin::UpperLeft);
+  im2->setEnabled(true);
+  EXPECT_THROW(im2->setTextureFormat(polyscope::TextureFormat::R16F), std::runtime_error);
+
+  // uploads are spread over several frames
+  polyscope::show(10);
+  EXPECT_EQ(cams[0]->getGPUMemoryUsage().textureBytes, static_cast<size_t>(width * height * 4));
+  EXPECT_EQ(cams[1]->getGPUMemoryUsage().textureBytes, static_cast<size_t>(width * height * 2));
+  EXPECT_EQ(cams[2]->getGPUMemoryUsage().textureBytes, static_cast<size_t>(width * height * 16));
+
+  // hidden images are released, and come back when shown again
+  cams[0]->setEnabled(false);
+  polyscope::show(3);
+  EXPECT_EQ(cams[0]->getGPUMemoryUsage().textureBytes, 0);
+  cams[0]->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_EQ(cams[0]->getGPUMemoryUsage().textureBytes, static_cast<size_t>(width * height * 4));
+
+  polyscope::options::imageTexturePaging = false;
+  polyscope::options::imageTextureUploadsPerFrame = 4;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CameraViewBatched) {
+  std::vector<polyscope::CameraView*> cams;
+  for (int i = 0; i < 40; i++) {
+    polyscope::CameraView* cam = polyscope::registerCameraView(
+        "cam" + std::to_string(i),
+        polyscope::CameraParameters(polyscope::CameraIntrinsics::fromFoVDegVerticalAndAspect(60, 2.),
+                                    polyscope::CameraExtrinsics::fromVectors(
+                                        glm::vec3{2., 2., 2. + i}, glm::vec3{-1., -1., -1.}, glm::vec3{0., 1., 0.})));
+    cams.push_back(cam);
+  }
+  std::vector<float> imageScalar(30 * 40);
+  cams[3]->addScalarImageQuantity("scalar", 30, 40, imageScalar, polyscope::ImageOrigin::UpperLeft)->setEnabled(true);
+
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // changes to some of the cameras
+  cams[0]->setWidgetColor(glm::vec3{1., 0., 0.});
+  cams[1]->setWidgetThickness(0.05);
+  cams[2]->setPosition(glm::vec3{1., 0., 0.});
+  cams[5]->updateCameraParameters(cams[4]->getCameraParameters());
+  cams[6]->setTransparency(0.5); // drawn on its own
+  cams[7]->setEnabled(false);
+  polyscope::show(3);
+  polyscope::pick::invalidatePickBuffer();
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // too few to batch
+  for (int i = 10; i < 40; i++) {
+    polyscope::removeCameraView("cam" + std::to_string(i));
+  }
+  polyscope::show(3);
+
+  polyscope::options::batchCameraViews = false;
+  polyscope::show(3);
+  polyscope::options::batchCameraViews = true;
+
+  polyscope::removeAllStructures();
+}
@@ -70,6 +70,10 @@ TEST_F(PolyscopeTest, TransparencyTest) {
   polyscope::options::transparencyMode = polyscope::TransparencyMode::Pretty;
   polyscope::show(3);
 
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::WeightedBlended;
+  polyscope::getSurfaceMesh("test1")->setTransparency(0.5);
+  polyscope::show(3);
+
   polyscope::removeAllStructures();
 }
 
@@ -144,6 +148,41 @@ TEST_F(PolyscopeTest, SlicePlaneTest) {
   polyscope::removeAllStructures();
 }
 
+// Planes are passed through the frame uniforms, so programs needn't change as they come and go
+TEST_F(PolyscopeTest, SlicePlaneManyPlanes) {
+  auto psMesh = registerTriangleMesh();
+  auto psPoints = registerPointCloud();
+
+  std::vector<polyscope::SlicePlane*> planes;
+  for (size_t i = 0; i < polyscope::render::maxSlicePlanes; i++) {
+    planes.push_back(polyscope::addSceneSlicePlane());
+  }
+  EXPECT_THROW(polyscope::addSceneSlicePlane(), std::runtime_error);
+  polyscope::show(3);
+
+  // ignored planes are tracked by their position in the scene
+  psMesh->setIgnoreSlicePlane(planes[1]->name, true);
+  psMesh->setIgnoreSlicePlane(planes[3]->name, true);
+  EXPECT_EQ(psMesh->getSlicePlaneIgnoreMask(), (1u << 1) | (1u << 3));
+  EXPECT_EQ(psPoints->getSlicePlaneIgnoreMask(), 0u);
+  polyscope::show(3);
+
+  // moving or deactivating a plane only updates the frame uniforms
+  planes[2]->setPose(glm::vec3{0.2, 0., 0.}, glm::vec3{0., 1., 0.});
+  planes[4]->setActive(false);
+  uint64_t version = polyscope::render::engine->getFrameUniformsVersion();
+  polyscope::show(3);
+  EXPECT_GT(polyscope::render::engine->getFrameUniformsVersion(), version);
+
+  for (size_t i = 0; i < polyscope::render::maxSlicePlanes; i++) {
+    polyscope::removeLastSceneSlicePlane();
+    polyscope::show(1);
+  }
+  EXPECT_FALSE(polyscope::render::engine->slicePlanesEnabled());
+
+  polyscope::removeAllStructures();
+}
+
 // Register a handful of quantities / structures, then call refresh
 TEST_F(PolyscopeTest, OrthoViewTest) {
 
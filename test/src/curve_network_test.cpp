@@ -38,6 +38,54 @@ TEST_F(PolyscopeTest, CurveNetworkPick) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, CurveNetworkRayPick) {
+  auto psCurve = registerCurveNetwork();
+  psCurve->setRadius(0.05, false);
+
+  // Hits the middle of the edge from node 3 to node 0
+  polyscope::RayPickResult result = psCurve->rayPick(glm::vec3{0.5, 0., -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_TRUE(result.isHit);
+  EXPECT_EQ(result.elementInd, 1);
+
+  result = psCurve->rayPick(glm::vec3{0.3, 0.3, -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_FALSE(result.isHit);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CurveNetworkSubsets) {
+  auto psCurve = registerCurveNetwork();
+
+  psCurve->setVisibleSubset({0, 1});
+  psCurve->setHighlightedSubset({1});
+  EXPECT_TRUE(psCurve->isVisibleInSubset(0));
+  EXPECT_FALSE(psCurve->isVisibleInSubset(2));
+  EXPECT_TRUE(psCurve->isHighlightedInSubset(1));
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psCurve->addEdgeScalarQuantity("eScalar", std::vector<double>(psCurve->nEdges(), 7.))->setEnabled(true);
+  psCurve->setInstancedDrawing(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  psCurve->setInstancedDrawing(false);
+
+  psCurve->clearVisibleSubset();
+  psCurve->clearHighlightedSubset();
+  EXPECT_TRUE(psCurve->isVisibleInSubset(2));
+  polyscope::show(3);
+
+  // polyline strips are drawn as tubes
+  std::vector<glm::vec3> line = {{0., 0., 0.}, {1., 0., 0.}, {1., 1., 0.}, {0., 1., 0.}};
+  polyscope::CurveNetwork* psLine = polyscope::registerCurveNetworkLine("line", std::move(line));
+  psLine->setVisibleSubset({0, 2});
+  psLine->setHighlightedSubset({0});
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
 
 TEST_F(PolyscopeTest, CurveNetworkColorNode) {
   auto psCurve = registerCurveNetwork();
@@ -75,6 +123,35 @@ TEST_F(PolyscopeTest, CurveNetworkScalarEdge) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, CurveNetworkMoveData) {
+  std::vector<glm::vec3> nodes;
+  std::vector<std::array<size_t, 2>> edges;
+  std::tie(nodes, edges) = getCurveNetwork();
+  const glm::vec3* nodesPtr = nodes.data();
+  polyscope::CurveNetwork* psCurve = polyscope::registerCurveNetwork("test1", std::move(nodes), edges);
+  EXPECT_EQ(psCurve->nodePositions.data.data(), nodesPtr);
+
+  std::vector<float> eScalar(psCurve->nEdges(), 9.f);
+  const float* eScalarPtr = eScalar.data();
+  auto q1 = psCurve->addEdgeScalarQuantity("eScalar", std::move(eScalar));
+  EXPECT_EQ(q1->values.data.data(), eScalarPtr);
+
+  std::vector<glm::vec3> nColors(psCurve->nNodes(), glm::vec3{.2, .3, .4});
+  const glm::vec3* nColorsPtr = nColors.data();
+  auto q2 = psCurve->addNodeColorQuantity("nColor", std::move(nColors));
+  EXPECT_EQ(q2->colors.data.data(), nColorsPtr);
+
+  std::vector<glm::vec3> line = std::get<0>(getCurveNetwork());
+  const glm::vec3* linePtr = line.data();
+  polyscope::CurveNetwork* psLine = polyscope::registerCurveNetworkLine("line", std::move(line));
+  EXPECT_EQ(psLine->nodePositions.data.data(), linePtr);
+  EXPECT_EQ(psLine->nEdges(), psLine->nNodes() - 1);
+
+  q1->setEnabled(true);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, CurveNetworkScalarRadius) {
   auto psCurve = registerCurveNetwork();
 
@@ -106,6 +183,32 @@ TEST_F(PolyscopeTest, CurveNetworkScalarRadius) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, CurveNetworkRadiusWithEdgeQuantities) {
+  auto psCurve = registerCurveNetwork();
+
+  // node radii are read from the node buffer by default programs, and expanded per-edge for edge quantities
+  std::vector<double> vRadius(psCurve->nNodes(), 2.);
+  std::vector<double> eScalar(psCurve->nEdges(), 9.);
+  std::vector<glm::vec3> eColors(psCurve->nEdges(), glm::vec3{.2, .3, .4});
+  auto qRad = psCurve->addNodeScalarQuantity("vRadius", vRadius);
+  auto qScalar = psCurve->addEdgeScalarQuantity("eScalar", eScalar);
+  auto qColor = psCurve->addEdgeColorQuantity("eColor", eColors);
+  psCurve->setNodeRadiusQuantity(qRad);
+  polyscope::show(3);
+
+  qScalar->setEnabled(true);
+  polyscope::show(3);
+
+  qColor->setEnabled(true);
+  polyscope::show(3);
+
+  qRad->setEnabled(true);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, CurveNetworkVertexVector) {
   auto psCurve = registerCurveNetwork();
   std::vector<glm::vec3> vals(psCurve->nNodes(), {1., 2., 3.});
@@ -123,3 +226,194 @@ TEST_F(PolyscopeTest, CurveNetworkFaceVector) {
   polyscope::show(3);
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, CurveNetworkStrips) {
+  // three strips, the middle one a single isolated node
+  std::vector<glm::vec3> nodes = {{0., 0., 0.}, {1., 0., 0.}, {1., 1., 0.}, {5., 5., 5.},
+                                  {0., 0., 1.}, {1., 0., 1.}, {2., 0., 1.}, {3., 1., 1.}};
+  std::vector<size_t> offsets = {0, 3, 4, 8};
+  polyscope::CurveNetwork* psCurve = polyscope::registerCurveNetworkStrips("strips", nodes, offsets);
+  EXPECT_TRUE(psCurve->isPolylineStrips());
+  EXPECT_EQ(psCurve->nStrips(), 3);
+  EXPECT_EQ(psCurve->nEdges(), 5);
+  EXPECT_EQ(psCurve->edgeTailInds.getValue(2), 4);
+  EXPECT_EQ(psCurve->edgeTipInds.getValue(2), 5);
+
+  // each node refers to the edge leaving it, or entering it at the end of a strip
+  std::vector<uint32_t> expectedNodeEdges = {0, 1, 1, 2, 2, 3, 4, 4};
+  psCurve->stripNodeEdgeInds.ensureHostBufferPopulated();
+  EXPECT_EQ(psCurve->stripNodeEdgeInds.data, expectedNodeEdges);
+  polyscope::show(3);
+
+  // quantities
+  std::vector<double> vScalar(psCurve->nNodes(), 0.5);
+  std::vector<double> eScalar(psCurve->nEdges(), 9.);
+  std::vector<glm::vec3> vColors(psCurve->nNodes(), glm::vec3{.2, .3, .4});
+  std::vector<glm::vec3> eColors(psCurve->nEdges(), glm::vec3{.2, .3, .4});
+  auto q1 = psCurve->addNodeScalarQuantity("vScalar", vScalar);
+  auto q2 = psCurve->addEdgeScalarQuantity("eScalar", eScalar);
+  auto q3 = psCurve->addNodeColorQuantity("vColor", vColors);
+  auto q4 = psCurve->addEdgeColorQuantity("eColor", eColors);
+  for (polyscope::CurveNetworkQuantity* q : std::vector<polyscope::CurveNetworkQuantity*>{q1, q2, q3, q4}) {
+    q->setEnabled(true);
+    polyscope::show(3);
+  }
+
+  // variable radius and picking
+  psCurve->setNodeRadiusQuantity(q1);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CurveNetworkStripsLOD) {
+  // two dense circles, long enough to be split in to several chunks each
+  size_t n = 3000;
+  std::vector<glm::vec3> nodes;
+  for (size_t iS = 0; iS < 2; iS++) {
+    for (size_t i = 0; i < n; i++) {
+      float t = 2.f * glm::pi<float>() * i / (n - 1);
+      nodes.push_back({std::cos(t), std::sin(t), static_cast<float>(iS)});
+    }
+  }
+  std::vector<size_t> offsets = {0, n, 2 * n};
+  polyscope::CurveNetwork* psCurve = polyscope::registerCurveNetworkStrips("strips", nodes, offsets);
+  EXPECT_EQ(psCurve->getLODDrawSegmentCount(), psCurve->nEdges());
+
+  psCurve->setLODEnabled(true);
+  EXPECT_TRUE(psCurve->getLODEnabled());
+  polyscope::view::lookAt(glm::vec3{0., 0., 3.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+  size_t nearCount = psCurve->getLODDrawSegmentCount();
+  EXPECT_GT(nearCount, 0);
+  EXPECT_LE(nearCount, psCurve->nEdges());
+
+  // far away, the circles are a few pixels wide
+  polyscope::view::lookAt(glm::vec3{0., 0., 1000.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+  size_t farCount = psCurve->getLODDrawSegmentCount();
+  EXPECT_GT(farCount, 0);
+  EXPECT_LT(farCount, nearCount);
+  EXPECT_LT(farCount, psCurve->nEdges() / 10);
+
+  // quantities and picking draw through the same levels
+  std::vector<double> eScalar(psCurve->nEdges(), 9.);
+  psCurve->addEdgeScalarQuantity("eScalar", eScalar)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psCurve->setLODPixelTolerance(2.);
+  EXPECT_EQ(psCurve->getLODPixelTolerance(), 2.f);
+  psCurve->updateNodePositions(nodes); // rebuilds the levels
+  polyscope::show(3);
+  EXPECT_LE(psCurve->getLODDrawSegmentCount(), farCount);
+
+  psCurve->setLODEnabled(false);
+  polyscope::show(3);
+  EXPECT_EQ(psCurve->getLODDrawSegmentCount(), psCurve->nEdges());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CurveNetworkStripsBadOffsets) {
+  std::vector<glm::vec3> nodes(4, glm::vec3{0., 0., 0.});
+  std::vector<size_t> decreasing = {0, 3, 2, 4};
+  std::vector<size_t> tooShort = {0, 2, 3};
+  EXPECT_THROW(polyscope::registerCurveNetworkStrips("strips", nodes, decreasing), std::runtime_error);
+  EXPECT_THROW(polyscope::registerCurveNetworkStrips("strips", nodes, tooShort), std::runtime_error);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CurveNetworkAppend) {
+  auto psCurve = registerCurveNetwork();
+  size_t nNodes = psCurve->nNodes();
+  size_t nEdges = psCurve->nEdges();
+  std::vector<double> vScalar(nNodes, 7.);
+  auto q1 = psCurve->addNodeScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // new nodes, connected to each other and to the old ones
+  std::vector<glm::vec3> newNodes = {{3., 3., 3.}, {4., 3., 3.}};
+  for (int iRep = 0; iRep < 5; iRep++) {
+    size_t n = psCurve->nNodes();
+    std::vector<std::array<size_t, 2>> newEdges = {{0, n}, {n, n + 1}};
+    psCurve->appendNodesAndEdges(newNodes, newEdges);
+    q1->values.appendData(std::vector<float>(newNodes.size(), 3.f));
+    polyscope::show(3);
+  }
+  EXPECT_EQ(psCurve->nNodes(), nNodes + 10);
+  EXPECT_EQ(psCurve->nEdges(), nEdges + 10);
+  EXPECT_EQ(psCurve->nodeDegrees[nNodes], 2u);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // out of bounds edges are rejected
+  std::vector<std::array<size_t, 2>> badEdges = {{0, psCurve->nNodes() + 3}};
+  EXPECT_THROW(psCurve->appendNodesAndEdges(newNodes, badEdges), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CurveNetworkInstancedDrawing) {
+  auto psCurve = registerCurveNetwork();
+  psCurve->setInstancedDrawing(true);
+  EXPECT_TRUE(psCurve->getInstancedDrawing());
+  polyscope::show(3);
+
+  // quantities on nodes and edges
+  std::vector<double> vScalar(psCurve->nNodes(), 7.);
+  std::vector<double> eScalar(psCurve->nEdges(), 9.);
+  std::vector<glm::vec3> vColors(psCurve->nNodes(), glm::vec3{.2, .3, .4});
+  std::vector<glm::vec3> eColors(psCurve->nEdges(), glm::vec3{.2, .3, .4});
+  auto q1 = psCurve->addNodeScalarQuantity("vScalar", vScalar);
+  auto q2 = psCurve->addEdgeScalarQuantity("eScalar", eScalar);
+  auto q3 = psCurve->addNodeColorQuantity("vColor", vColors);
+  auto q4 = psCurve->addEdgeColorQuantity("eColor", eColors);
+  for (polyscope::CurveNetworkQuantity* q : std::vector<polyscope::CurveNetworkQuantity*>{q1, q2, q3, q4}) {
+    q->setEnabled(true);
+    polyscope::show(3);
+  }
+
+  // variable radius
+  psCurve->setNodeRadiusQuantity(q1);
+  polyscope::show(3);
+
+  // appending nodes and edges
+  size_t n = psCurve->nNodes();
+  psCurve->clearNodeRadiusQuantity();
+  psCurve->removeAllQuantities();
+  psCurve->appendNodesAndEdges(std::vector<glm::vec3>{{3., 3., 3.}}, std::vector<std::array<size_t, 2>>{{0, n}});
+  polyscope::show(3);
+
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // back to the geometry shader programs
+  psCurve->setInstancedDrawing(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, CurveNetworkDepthPrepass) {
+  auto psCurve = registerCurveNetwork();
+  psCurve->setDepthPrepass(true);
+  EXPECT_TRUE(psCurve->getDepthPrepass());
+  polyscope::show(3);
+
+  std::vector<double> vScalar(psCurve->nNodes(), 7.);
+  auto q1 = psCurve->addNodeScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  psCurve->setNodeRadiusQuantity(q1);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psCurve->setInstancedDrawing(true);
+  polyscope::show(3);
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+
+  polyscope::removeAllStructures();
+}
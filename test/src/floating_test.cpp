@@ -4,6 +4,10 @@
 
 #include "polyscope/floating_quantities.h"
 
+#include "glm/gtc/packing.hpp"
+
+#include <mutex>
+
 // ============================================================
 // =============== Floating image
 // ============================================================
@@ -68,6 +72,57 @@ TEST_F(PolyscopeTest, FloatingImageTest) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, FloatingTiledImageTest) {
+
+  size_t dimX = 100;
+  size_t dimY = 70;
+  std::vector<std::array<float, 3>> valsRGB(dimX * dimY, std::array<float, 3>{0.44, 0.55, 0.66});
+
+  for (polyscope::ImageOrigin origin : {polyscope::ImageOrigin::UpperLeft, polyscope::ImageOrigin::LowerLeft}) {
+    polyscope::TiledColorImageQuantity* im =
+        polyscope::addTiledColorImageQuantity("im tiled", dimX, dimY, valsRGB, origin);
+    im->setTileSize(16);
+    EXPECT_EQ(im->nLevels(), 4); // 100x70, 50x35, 25x18, 13x9
+    EXPECT_EQ(im->levelDimX(2), 25);
+    EXPECT_EQ(im->levelDimY(2), 18);
+    im->setEnabled(true);
+    polyscope::show(3);
+    EXPECT_GT(im->nResidentTiles(), 0);
+
+    im->setWindowView(glm::vec2{0.3, 0.6}, 8.);
+    polyscope::show(3);
+
+    im->setMaxResidentTiles(2);
+    EXPECT_LE(im->nResidentTiles(), 2);
+    im->setShowFullscreen(true);
+    polyscope::show(3);
+
+    EXPECT_THROW(im->setTextureFormat(polyscope::TextureFormat::R32F), std::runtime_error);
+    im->setTextureFormat(polyscope::TextureFormat::RGBA16F);
+    polyscope::show(3);
+  }
+
+  { // from a loader
+    size_t nLoaded = 0;
+    polyscope::TiledColorImageQuantity* im = polyscope::addTiledColorImageQuantityFromLoader(
+        "im tiled loader", 3000, 2000,
+        [&](int level, size_t x0, size_t y0, size_t w, size_t h, std::vector<glm::vec4>& pixels) {
+          nLoaded++;
+          pixels.assign(w * h, glm::vec4{0.1 * level, 0.2, 0.3, 1.});
+        },
+        polyscope::ImageOrigin::UpperLeft);
+    im->setTileUploadsPerFrame(1);
+    im->setShowFullscreen(true);
+    im->setEnabled(true);
+    polyscope::show(5);
+    EXPECT_GT(nLoaded, 1);
+    EXPECT_EQ(nLoaded, im->nResidentTiles());
+    polyscope::removeFloatingQuantity("im tiled loader", true);
+  }
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, FloatingRenderImageTest) {
 
 
@@ -114,6 +169,42 @@ TEST_F(PolyscopeTest, FloatingRenderImageTest) {
 }
 
 
+TEST_F(PolyscopeTest, FloatingRenderImageRegionUpdateTest) {
+
+  size_t dimX = 300;
+  size_t dimY = 200;
+
+  std::vector<float> depthVals(dimX * dimY, 0.44);
+  std::vector<std::array<float, 3>> normalVals(dimX * dimY, std::array<float, 3>{0.44, 0.55, 0.66});
+  polyscope::DepthRenderImageQuantity* im = polyscope::addDepthRenderImageQuantity(
+      "render im depth", dimX, dimY, depthVals, normalVals, polyscope::ImageOrigin::UpperLeft);
+  im->setEnabled(true);
+  polyscope::show(3);
+
+  // a single tile, with full-precision and half-float normals
+  size_t w = 32;
+  size_t h = 16;
+  std::vector<float> tileDepth(w * h, 0.8);
+  std::vector<glm::vec3> tileNormals(w * h, glm::vec3{0., 0., 1.});
+  std::vector<uint16_t> tileNormalsHalf(3 * w * h, glm::packHalf1x16(0.5));
+  im->updateGeometryBuffersRegion(64, 32, w, h, tileDepth, tileNormals);
+  polyscope::show(3);
+  im->updateGeometryBuffersRegionHalfNormals(dimX - w, dimY - h, w, h, tileDepth, tileNormalsHalf);
+  polyscope::show(3);
+
+  // the full-image update goes through the same path
+  std::vector<glm::vec3> fullNormals(dimX * dimY, glm::vec3{0., 1., 0.});
+  im->updateGeometryBuffers(depthVals, fullNormals);
+  polyscope::show(3);
+
+  // out of bounds, or the wrong amount of data
+  EXPECT_THROW(im->updateGeometryBuffersRegion(dimX - w + 1, 0, w, h, tileDepth, tileNormals), std::runtime_error);
+  EXPECT_THROW(im->updateGeometryBuffersRegion(0, 0, w, h + 1, tileDepth, tileNormals), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+
 // ============================================================
 // =============== Implicit tests
 // ============================================================
@@ -178,3 +269,110 @@ TEST_F(PolyscopeTest, ImplicitSurfaceRenderImageQuantityTest) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, ImplicitSurfaceTiledRenderTest) {
+
+  std::mutex batchMutex;
+  size_t maxBatchSize = 0;
+  auto sphereSDFBatch = [&](const float* pos, float* out, size_t N) {
+    {
+      std::lock_guard<std::mutex> lock(batchMutex);
+      maxBatchSize = std::max(maxBatchSize, N);
+    }
+    for (size_t i = 0; i < N; i++) {
+      out[i] = glm::length(glm::vec3{pos[3 * i + 0], pos[3 * i + 1], pos[3 * i + 2]}) - 0.5f;
+    }
+  };
+
+  polyscope::ImplicitRenderOpts opts;
+  polyscope::ImplicitRenderMode mode = polyscope::ImplicitRenderMode::SphereMarch;
+  opts.subsampleFactor = 16;
+  opts.tileSize = 8;
+  opts.parallel = true;
+
+  // the batch function only ever sees one tile's worth of rays
+  polyscope::renderImplicitSurfaceBatch("sphere sdf", sphereSDFBatch, mode, opts);
+  EXPECT_GT(maxBatchSize, 0);
+  EXPECT_LE(maxBatchSize, 64);
+  polyscope::show(3);
+
+  // progressive: a preview first, then full resolution once the view holds still
+  opts.previewSubsampleFactor = 2;
+  size_t previewPix = polyscope::renderImplicitSurfaceBatch("sphere sdf preview", sphereSDFBatch, mode, opts)->nPix();
+  size_t fullPix = polyscope::renderImplicitSurfaceBatch("sphere sdf preview", sphereSDFBatch, mode, opts)->nPix();
+  EXPECT_LT(previewPix, fullPix);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ImplicitSurfaceCachedTest) {
+
+  auto sphereSDF = [](glm::vec3 p) { return glm::length(p) - 0.5f; };
+
+  polyscope::ImplicitRenderOpts opts;
+  polyscope::ImplicitRenderMode mode = polyscope::ImplicitRenderMode::SphereMarch;
+  opts.subsampleFactor = 16;
+
+  polyscope::view::lookAt(glm::vec3{0., 0., 3.}, glm::vec3{0., 0., 0.});
+  polyscope::CachedImplicitSurfaceQuantity* q =
+      polyscope::renderImplicitSurfaceCached("sphere sdf cached", sphereSDF, mode, opts);
+  EXPECT_EQ(q->getRenderCount(), 1u);
+
+  // nothing changed, nothing to do
+  EXPECT_FALSE(q->update());
+  polyscope::show(3);
+  EXPECT_EQ(q->getRenderCount(), 1u);
+
+  // a full render, then a small camera move starting from the reprojected surface takes fewer evaluations
+  q->markParametersChanged();
+  EXPECT_TRUE(q->update());
+  size_t fullEvals = q->getLastEvaluationCount();
+  polyscope::view::lookAt(glm::vec3{0.05, 0., 3.}, glm::vec3{0., 0., 0.});
+  EXPECT_TRUE(q->update());
+  EXPECT_LT(q->getLastEvaluationCount(), fullEvals);
+
+  // without reprojection, every ray starts at the camera again
+  q->setReprojection(false);
+  polyscope::view::lookAt(glm::vec3{0., 0., 3.}, glm::vec3{0., 0., 0.});
+  EXPECT_TRUE(q->update());
+  EXPECT_EQ(q->getLastEvaluationCount(), fullEvals);
+
+  // re-renders on its own when drawn after a view change
+  size_t renderCount = q->getRenderCount();
+  polyscope::view::lookAt(glm::vec3{0., 0.05, 3.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+  EXPECT_EQ(q->getRenderCount(), renderCount + 1);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, ImplicitSurfaceGLSLTest) {
+
+  polyscope::ImplicitRenderOpts opts;
+  polyscope::ImplicitRenderMode mode = polyscope::ImplicitRenderMode::SphereMarch;
+
+  polyscope::ImplicitSurfaceGLSLQuantity* q =
+      polyscope::renderImplicitSurfaceGLSL("sphere glsl", "return length(p) - 0.5;", mode, opts);
+  polyscope::show(3);
+
+  // the program follows the view with no new compiles
+  polyscope::render::engine->resetCostCounters();
+  polyscope::view::lookAt(glm::vec3{2., 1., 2.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+  EXPECT_EQ(polyscope::render::engine->getCostCounters().shaderCompilations, 0u);
+
+  // replace the function
+  q->setFunction("vec2 q = vec2(length(p.xz) - 0.5, p.y); return length(q) - 0.2;");
+  EXPECT_EQ(q->getFunction(), "vec2 q = vec2(length(p.xz) - 0.5, p.y); return length(q) - 0.2;");
+  q->setColor(glm::vec3{0.2, 0.4, 0.8});
+  q->setMaterial("wax");
+  q->setTransparency(0.5);
+  polyscope::show(3);
+
+  polyscope::renderImplicitSurfaceGLSL("box glsl fixed", "return max(max(abs(p.x), abs(p.y)), abs(p.z)) - 0.3;",
+                                       polyscope::ImplicitRenderMode::FixedStep, opts);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
@@ -233,6 +233,43 @@ TEST_F(PolyscopeTest, TestDocsExample) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, GroupBatchedOperationsTest) {
+  auto psCloud1 = registerPointCloud("test_point_cloud1");
+  auto psCloud2 = registerPointCloud("test_point_cloud2");
+  auto psCurve = registerCurveNetwork("test_curve_network");
+  polyscope::registerGroup("test_group");
+  polyscope::registerGroup("child_group");
+  polyscope::setParentGroupOfGroup("child_group", "test_group");
+  polyscope::setParentGroupOfStructure(psCloud1, "test_group");
+  polyscope::setParentGroupOfStructure(psCloud2, "child_group");
+  polyscope::setParentGroupOfStructure(psCurve, "child_group");
+  polyscope::setParentGroupOfStructure(psCloud1, "child_group"); // in both groups
+  polyscope::Group* group = polyscope::state::groups["test_group"].get();
+
+  EXPECT_EQ(group->getDescendantStructures().size(), 3);
+
+  group->setEnabled(false);
+  EXPECT_FALSE(psCloud1->isEnabled());
+  EXPECT_FALSE(psCloud2->isEnabled());
+  EXPECT_FALSE(psCurve->isEnabled());
+  group->setEnabled(true);
+  EXPECT_TRUE(psCurve->isEnabled());
+
+  // translations apply once per structure, and the scene extents follow
+  glm::vec3 bboxMaxBefore = std::get<1>(polyscope::state::boundingBox);
+  group->translate(glm::vec3{10., 0., 0.});
+  EXPECT_EQ(psCloud1->getPosition(), glm::vec3(10., 0., 0.));
+  EXPECT_EQ(psCurve->getPosition(), glm::vec3(10., 0., 0.));
+  EXPECT_GT(std::get<1>(polyscope::state::boundingBox).x, bboxMaxBefore.x + 5.);
+
+  group->resetTransform();
+  EXPECT_EQ(psCloud2->getPosition(), glm::vec3(0., 0., 0.));
+  polyscope::show(3);
+
+  polyscope::removeAllGroups();
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, TestDeletedGroupReferenceError) {
   // don't run this because we can't catch UI errors
   if (true) return;
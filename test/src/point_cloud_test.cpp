@@ -4,7 +4,9 @@
 #include "polyscope_test.h"
 
 #include "polyscope/curve_network.h"
+#include "polyscope/histogram.h"
 #include "polyscope/pick.h"
+#include "polyscope/ply_streaming.h"
 #include "polyscope/point_cloud.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/surface_mesh.h"
@@ -13,6 +15,8 @@
 #include "gtest/gtest.h"
 
 #include <array>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <list>
 #include <string>
@@ -34,6 +38,21 @@ TEST_F(PolyscopeTest, ShowPointCloud) {
   EXPECT_FALSE(polyscope::hasPointCloud("test1"));
 }
 
+TEST_F(PolyscopeTest, PointCloudFromDataSpan) {
+  std::vector<double> coords;
+  for (glm::vec3 p : getPoints()) {
+    for (int j = 0; j < 3; j++) coords.push_back(p[j]);
+  }
+  polyscope::PointCloud* psPoints =
+      polyscope::registerPointCloud("span points", polyscope::dataSpan(coords.data(), coords.size() / 3));
+  EXPECT_EQ(psPoints->nPoints(), getPoints().size());
+  std::vector<float> vals(psPoints->nPoints(), 7.);
+  psPoints->addScalarQuantity("vals", polyscope::dataSpan(vals))->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, PointCloudUpdateGeometry) {
   auto psPoints = registerPointCloud();
   polyscope::show(3);
@@ -41,7 +60,99 @@ TEST_F(PolyscopeTest, PointCloudUpdateGeometry) {
   psPoints->updatePointPositions(getPoints());
   polyscope::show(3);
 
+  // repeated updates go through the streaming path
+  EXPECT_TRUE(psPoints->points.getStreaming());
+  psPoints->updatePointPositions(getPoints());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudMoveData) {
+  // rvalues of the stored types are moved into the buffers, without copying
+  std::vector<glm::vec3> points = getPoints();
+  const glm::vec3* pointsPtr = points.data();
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("test1", std::move(points));
+  EXPECT_EQ(psPoints->points.data.data(), pointsPtr);
+  size_t n = psPoints->nPoints();
+
+  std::vector<float> scalar(n, 3.f);
+  const float* scalarPtr = scalar.data();
+  auto q1 = psPoints->addScalarQuantity("scalar", std::move(scalar));
+  EXPECT_EQ(q1->values.data.data(), scalarPtr);
+
+  std::vector<glm::vec3> colors(n, glm::vec3{.2, .3, .4});
+  const glm::vec3* colorsPtr = colors.data();
+  auto q2 = psPoints->addColorQuantity("color", std::move(colors));
+  EXPECT_EQ(q2->colors.data.data(), colorsPtr);
+
+  std::vector<glm::vec3> vectors(n, glm::vec3{1., 0., 0.});
+  const glm::vec3* vectorsPtr = vectors.data();
+  auto q3 = psPoints->addVectorQuantity("vector", std::move(vectors));
+  EXPECT_EQ(q3->vectors.data.data(), vectorsPtr);
+
+  std::vector<glm::vec3> newPoints = getPoints();
+  const glm::vec3* newPointsPtr = newPoints.data();
+  psPoints->updatePointPositions(std::move(newPoints));
+  EXPECT_EQ(psPoints->points.data.data(), newPointsPtr);
+
+  // lvalues are still copied, and left alone
+  std::vector<float> kept(n, 1.f);
+  auto q4 = psPoints->addScalarQuantity("kept", kept);
+  EXPECT_EQ(kept.size(), n);
+  EXPECT_NE(q4->values.data.data(), kept.data());
+
+  // sizes are still checked
+  EXPECT_THROW(psPoints->addScalarQuantity("wrong", std::vector<float>(n + 1)), std::runtime_error);
+
+  q1->setEnabled(true);
+  q3->setEnabled(true);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudExternalData) {
+  std::shared_ptr<std::vector<glm::vec3>> pts = std::make_shared<std::vector<glm::vec3>>(getPoints());
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("test1", pts->data(), pts->size(), pts);
+  EXPECT_TRUE(psPoints->points.hasExternalData());
+  EXPECT_EQ(psPoints->nPoints(), pts->size());
+  EXPECT_EQ(psPoints->getPointPosition(2), (*pts)[2]);
+  polyscope::show(3);
+
+  // modify in place
+  (*pts)[0] = glm::vec3{0.5, 0.5, 0.5};
+  psPoints->points.markHostBufferUpdated();
+  EXPECT_TRUE(psPoints->points.hasExternalData());
+  polyscope::show(3);
+
+  // updating positions switches to an internal copy
+  psPoints->updatePointPositions(getPoints());
+  EXPECT_FALSE(psPoints->points.hasExternalData());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudReleaseHostMemory) {
+  polyscope::options::hostMemoryPolicy = polyscope::HostMemoryPolicy::ReleaseAfterUpload;
+
+  auto psPoints = registerPointCloud();
+  size_t nPts = psPoints->nPoints();
+  polyscope::show(3);
+
+  // the host copy is gone once uploaded, but the data is still available
+  EXPECT_TRUE(psPoints->points.data.empty());
+  EXPECT_EQ(psPoints->nPoints(), nPts);
+  psPoints->getPointPosition(1);
+  psPoints->points.ensureHostBufferPopulated();
+  EXPECT_EQ(psPoints->points.data.size(), nPts);
+
+  psPoints->updatePointPositions(getPoints());
+  EXPECT_TRUE(psPoints->points.data.empty());
+  polyscope::show(3);
+
   polyscope::removeAllStructures();
+  polyscope::options::hostMemoryPolicy = polyscope::HostMemoryPolicy::KeepHostCopy;
 }
 
 TEST_F(PolyscopeTest, PointCloudAppearance) {
@@ -74,6 +185,240 @@ TEST_F(PolyscopeTest, PointCloudPick) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudLOD) {
+  std::vector<glm::vec3> points;
+  for (size_t i = 0; i < 10000; i++) {
+    points.push_back({polyscope::randomUnit(), polyscope::randomUnit(), polyscope::randomUnit()});
+  }
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("lod cloud", points);
+  std::vector<double> vScalar(points.size(), 7.);
+  std::vector<glm::vec3> vColor(points.size(), glm::vec3{.2, .3, .4});
+  psPoints->addScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  psPoints->addColorQuantity("vColor", vColor);
+
+  psPoints->setLODEnabled(true);
+  EXPECT_TRUE(psPoints->getLODEnabled());
+  polyscope::show(3);
+  EXPECT_GT(psPoints->getLODDrawCount(), 0);
+  EXPECT_LE(psPoints->getLODDrawCount(), psPoints->nPoints());
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psPoints->getQuantity("vColor")->setEnabled(true);
+  psPoints->setPointRadius(0.02);
+  polyscope::show(3);
+
+  psPoints->setLODPointsPerPixel(0.01);
+  EXPECT_EQ(psPoints->getLODPointsPerPixel(), 0.01f);
+  polyscope::show(3);
+
+  psPoints->setLODEnabled(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudSpatialOrder) {
+  std::vector<glm::vec3> points;
+  for (size_t i = 0; i < 10000; i++) {
+    points.push_back({polyscope::randomUnit(), polyscope::randomUnit(), polyscope::randomUnit()});
+  }
+  polyscope::options::spatiallyOrderPointClouds = true;
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("ordered cloud", points);
+  polyscope::options::spatiallyOrderPointClouds = false;
+  EXPECT_TRUE(psPoints->getSpatialOrderEnabled());
+
+  // quantities are given, and updated, in the original order
+  std::vector<double> vScalar(points.size(), 7.);
+  std::vector<glm::vec3> vColor(points.size(), glm::vec3{.2, .3, .4});
+  polyscope::PointCloudScalarQuantity* q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  vScalar[3] = 1.;
+  q1->updateData(vScalar);
+  psPoints->addColorQuantity("vColor", vColor)->setEnabled(true);
+  psPoints->setPointRadiusQuantity(q1);
+  psPoints->setInstancedDrawing(true);
+  polyscope::show(3);
+  psPoints->setInstancedDrawing(false);
+  psPoints->clearPointRadiusQuantity();
+
+  for (glm::vec3& p : points) p *= 2.;
+  psPoints->updatePointPositions(points);
+  polyscope::show(3);
+
+  // LOD has its own order
+  psPoints->setLODEnabled(true);
+  polyscope::show(3);
+  psPoints->setLODEnabled(false);
+
+  // appended clouds go back to the given order
+  psPoints->appendPoints(std::vector<glm::vec3>{{0., 0., 0.}}, {{"vScalar", {3.f}}}, {{"vColor", {glm::vec3{1.}}}});
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psPoints->setSpatialOrderEnabled(false);
+  EXPECT_FALSE(psPoints->getSpatialOrderEnabled());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudRayPick) {
+  auto psPoints = registerPointCloud();
+  psPoints->setPointRadius(0.1, false);
+
+  polyscope::RayPickResult result = psPoints->rayPick(glm::vec3{0., 1., -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_TRUE(result.isHit);
+  EXPECT_EQ(result.elementInd, 1);
+
+  result = psPoints->rayPick(glm::vec3{0.5, 0.5, -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_FALSE(result.isHit);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudSubsets) {
+  auto psPoints = registerPointCloud();
+
+  psPoints->setVisibleSubset({0, 2, 3});
+  psPoints->setHighlightedSubset({2});
+  EXPECT_TRUE(psPoints->hasVisibleSubset());
+  EXPECT_TRUE(psPoints->isVisibleInSubset(2));
+  EXPECT_FALSE(psPoints->isVisibleInSubset(1));
+  EXPECT_TRUE(psPoints->isHighlightedInSubset(2));
+  EXPECT_FALSE(psPoints->isHighlightedInSubset(0));
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // changing a subset only updates the mask
+  psPoints->setVisibleSubset({1});
+  EXPECT_TRUE(psPoints->isVisibleInSubset(1));
+  EXPECT_FALSE(psPoints->isVisibleInSubset(0));
+  polyscope::show(3);
+
+  // with the other drawing paths and a quantity
+  psPoints->addScalarQuantity("vScalar", std::vector<double>(psPoints->nPoints(), 7.))->setEnabled(true);
+  psPoints->setInstancedDrawing(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  psPoints->setInstancedDrawing(false);
+  psPoints->setLODEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  psPoints->setLODEnabled(false);
+
+  EXPECT_THROW(psPoints->setVisibleSubset({psPoints->nPoints()}), std::runtime_error);
+
+  psPoints->clearVisibleSubset();
+  psPoints->clearHighlightedSubset();
+  EXPECT_FALSE(psPoints->hasVisibleSubset());
+  EXPECT_TRUE(psPoints->isVisibleInSubset(0));
+  EXPECT_FALSE(psPoints->isHighlightedInSubset(2));
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudPLYStreaming) {
+  // a binary file with an extra property, read a few points at a time
+  std::string filename = "test_streaming_cloud.ply";
+  size_t nPts = 1000;
+  {
+    std::ofstream out(filename, std::ios::binary);
+    out << "ply\nformat binary_little_endian 1.0\nelement vertex " << nPts
+        << "\nproperty float x\nproperty float y\nproperty float z\nproperty uchar extra\nend_header\n";
+    for (size_t i = 0; i < nPts; i++) {
+      float p[3] = {static_cast<float>(i), 1.f, 2.f};
+      unsigned char extra = 7;
+      out.write(reinterpret_cast<const char*>(p), sizeof(p));
+      out.write(reinterpret_cast<const char*>(&extra), 1);
+    }
+  }
+
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloudPLYStreaming("streamed", filename, 64);
+  EXPECT_EQ(psPoints->nPoints(), nPts);
+  EXPECT_LT(psPoints->getValidPointCount(), nPts);
+  for (int iter = 0; iter < 10000 && psPoints->getValidPointCount() < nPts; iter++) {
+    polyscope::show(1);
+  }
+  ASSERT_EQ(psPoints->getValidPointCount(), nPts);
+  EXPECT_EQ(psPoints->getPointPosition(17), glm::vec3(17.f, 1.f, 2.f));
+  EXPECT_EQ(psPoints->getPointPosition(nPts - 1), glm::vec3(nPts - 1.f, 1.f, 2.f));
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // removing a cloud mid-load cancels it
+  polyscope::registerPointCloudPLYStreaming("streamed2", filename, 8);
+  polyscope::show(1);
+  polyscope::removeAllStructures();
+
+  std::remove(filename.c_str());
+}
+
+TEST_F(PolyscopeTest, PointCloudAppendPoints) {
+  auto psPoints = registerPointCloud();
+  size_t nPts = psPoints->nPoints();
+  std::vector<double> vScalar(nPts, 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // append repeatedly, extending the quantity to match
+  for (int iRep = 0; iRep < 10; iRep++) {
+    std::vector<glm::vec3> newPoints = {{2.f + iRep, 0.f, 0.f}, {0.f, 2.f + iRep, 0.f}};
+    psPoints->appendPoints(newPoints);
+    q1->values.appendData(std::vector<float>(newPoints.size(), 1.f * iRep));
+    polyscope::show(1);
+  }
+  EXPECT_EQ(psPoints->nPoints(), nPts + 20);
+  EXPECT_EQ(psPoints->getPointPosition(nPts + 19), glm::vec3(0.f, 11.f, 0.f));
+  EXPECT_EQ(std::get<1>(psPoints->boundingBox()).x, 11.f);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudAppendRing) {
+  auto psPoints = registerPointCloud();
+  auto qScalar = psPoints->addScalarQuantity("vScalar", std::vector<double>(psPoints->nPoints(), 7.));
+  std::vector<glm::vec3> vColors(psPoints->nPoints(), glm::vec3{.2, .3, .4});
+  auto qColor = psPoints->addColorQuantity("vColor", vColors);
+  qScalar->setEnabled(true);
+  psPoints->setMaxPointCount(10);
+  polyscope::show(3);
+
+  // the cloud fills up to the maximum, then the oldest points are overwritten
+  for (int iRep = 0; iRep < 5; iRep++) {
+    std::vector<glm::vec3> newPoints(3, glm::vec3{5.f + iRep, 0.f, 0.f});
+    psPoints->appendPoints(newPoints, {{"vScalar", std::vector<float>(3, 1.f * iRep)}},
+                           {{"vColor", std::vector<glm::vec3>(3, glm::vec3{1., 0., 0.})}});
+    polyscope::show(1);
+  }
+  EXPECT_EQ(psPoints->nPoints(), 10u);
+  EXPECT_EQ(psPoints->getPointPosition(0), glm::vec3(7.f, 0.f, 0.f)); // wrapped around
+  EXPECT_EQ(psPoints->getPointPosition(6), glm::vec3(9.f, 0.f, 0.f)); // most recent
+  EXPECT_EQ(psPoints->getPointPosition(9), glm::vec3(6.f, 0.f, 0.f)); // oldest
+  EXPECT_EQ(qScalar->values.getValue(6), 4.f);
+  EXPECT_EQ(qColor->colors.size(), 10u);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // more points than fit at once keeps just the last ones
+  std::vector<glm::vec3> manyPoints(25, glm::vec3{0.f, 0.f, 0.f});
+  manyPoints.back() = glm::vec3{1.f, 2.f, 3.f};
+  psPoints->appendPoints(manyPoints);
+  psPoints->appendPointValues(qScalar->values, std::vector<float>(25, 2.f));
+  psPoints->appendPointValues(qColor->colors, std::vector<glm::vec3>(25, glm::vec3{0., 1., 0.}));
+  EXPECT_EQ(psPoints->nPoints(), 10u);
+  EXPECT_EQ(psPoints->getPointPosition(8), glm::vec3(1.f, 2.f, 3.f));
+  polyscope::show(3);
+
+  // bad arguments
+  EXPECT_THROW(psPoints->appendPoints(manyPoints, {{"nope", std::vector<float>(25, 2.f)}}), std::runtime_error);
+  EXPECT_THROW(psPoints->appendPoints(manyPoints, {{"vScalar", std::vector<float>(3, 2.f)}}), std::runtime_error);
+  EXPECT_THROW(psPoints->setMaxPointCount(5), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
 
 TEST_F(PolyscopeTest, PointCloudColor) {
   auto psPoints = registerPointCloud();
@@ -93,6 +438,81 @@ TEST_F(PolyscopeTest, PointCloudColor) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudPackedColor) {
+  auto psPoints = registerPointCloud();
+  std::vector<uint32_t> vColors(psPoints->nPoints(), polyscope::packColorRGBA8(51, 102, 153));
+  auto q1 = psPoints->addPackedColorQuantity("vcolor", vColors);
+  q1->setEnabled(true);
+  EXPECT_TRUE(q1->isPacked());
+  EXPECT_EQ(q1->nColors(), psPoints->nPoints());
+  EXPECT_NEAR(q1->getColor(0).y, .4, 1e-6);
+  polyscope::show(3);
+
+  // float updates are packed, and packing rounds to the nearest byte
+  std::vector<glm::vec3> vColorsFloat(psPoints->nPoints(), glm::vec3{1., .5, 0.});
+  q1->updateData(vColorsFloat);
+  EXPECT_EQ(q1->colorsPacked.getValue(0), polyscope::packColorRGBA8(255, 128, 0));
+  q1->updateDataPacked(vColors);
+  polyscope::show(3);
+
+  psPoints->setInstancedDrawing(true);
+  polyscope::show(3);
+  std::vector<glm::vec3> newPoints(2, glm::vec3{2.f, 0.f, 0.f});
+  std::vector<glm::vec3> newColors(2, glm::vec3{0., 0., 1.});
+  psPoints->appendPoints(newPoints, {}, {{"vcolor", newColors}});
+  EXPECT_EQ(q1->colorsPacked.getValue(psPoints->nPoints() - 1), polyscope::packColorRGBA8(0, 0, 255));
+  polyscope::show(3);
+
+  // float quantities reject packed updates
+  std::vector<glm::vec3> floatColors(psPoints->nPoints(), glm::vec3{.2, .3, .4});
+  auto q2 = psPoints->addColorQuantity("vcolorFloat", floatColors);
+  EXPECT_THROW(q2->updateDataPacked(vColors), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudLabel) {
+  auto psPoints = registerPointCloud();
+  size_t n = psPoints->nPoints();
+  std::vector<uint32_t> labels(n);
+  for (size_t i = 0; i < n; i++) {
+    labels[i] = (i % 3 == 0) ? 37 : 100000 + (i % 2); // sparse label values are fine
+  }
+  auto q1 = psPoints->addLabelQuantity("labels", labels);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // distinct labels are sorted and counted
+  ASSERT_EQ(q1->getLabels().size(), 3);
+  EXPECT_EQ(q1->getLabels()[0], 37);
+  size_t count37 = 0;
+  for (uint32_t l : labels) count37 += (l == 37);
+  EXPECT_EQ(q1->getLabelCount(37), count37);
+  EXPECT_EQ(q1->getLabel(3), 37);
+  EXPECT_EQ(q1->getLabel(1), 100001);
+  EXPECT_THROW(q1->getLabelCount(38), std::runtime_error);
+
+  // hiding and recoloring labels does not touch the per-point data
+  polyscope::render::engine->resetCostCounters();
+  q1->setLabelVisible(37, false);
+  q1->setLabelColor(100000, glm::vec3{.2, .3, .4});
+  polyscope::show(3);
+  EXPECT_FALSE(q1->getLabelVisible(37));
+  EXPECT_EQ(q1->getLabelColor(100000), glm::vec3(.2, .3, .4));
+  EXPECT_EQ(polyscope::render::engine->getCostCounters().bytesUploadedPerBuffer.count(q1->labelIndices.name), 0);
+  q1->setAllLabelsVisible(true);
+  EXPECT_TRUE(q1->getLabelVisible(37));
+
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Quad);
+  polyscope::show(3);
+  psPoints->setInstancedDrawing(true);
+  polyscope::show(3);
+  psPoints->setLODEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, PointCloudScalar) {
   auto psPoints = registerPointCloud();
 
@@ -112,6 +532,249 @@ TEST_F(PolyscopeTest, PointCloudScalar) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudScalarFloatStorage) {
+  auto psPoints = registerPointCloud();
+
+  // double input is stored at single precision
+  std::vector<double> vScalar(psPoints->nPoints(), 0.1);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  EXPECT_EQ(q1->values.data.size(), psPoints->nPoints());
+  EXPECT_EQ(q1->values.getValue(1), 0.1f);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudScalarHistogramOnDevice) {
+  polyscope::options::hostMemoryPolicy = polyscope::HostMemoryPolicy::ReleaseAfterUpload;
+
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // the values only live on the GPU, and can be counted there
+  EXPECT_TRUE(q1->values.dataIsDeviceOnly());
+  polyscope::Histogram hist;
+  hist.buildHistogram(q1->values.getRenderAttributeBuffer(), std::make_pair(0., 10.));
+  EXPECT_TRUE(q1->values.dataIsDeviceOnly());
+
+  polyscope::removeAllStructures();
+  polyscope::options::hostMemoryPolicy = polyscope::HostMemoryPolicy::KeepHostCopy;
+}
+
+TEST_F(PolyscopeTest, HistogramTextureAtlas) {
+  std::vector<double> values{1., 2., 2., 3., 5., 8.};
+  std::vector<std::unique_ptr<polyscope::Histogram>> hists;
+  for (int i = 0; i < 20; i++) {
+    hists.emplace_back(new polyscope::Histogram());
+    hists.back()->buildHistogram(values);
+  }
+
+  polyscope::state::userCallback = [&]() {
+    for (std::unique_ptr<polyscope::Histogram>& h : hists) h->buildUI();
+  };
+
+  // the images are drawn once, into the cells of a couple of shared pages
+  polyscope::show(3);
+  EXPECT_EQ(hists[0]->getTextureRenderCount(), 1u);
+  EXPECT_EQ(hists[19]->getTextureRenderCount(), 1u);
+  EXPECT_EQ(polyscope::Histogram::getAtlasPageCount(), 2u);
+
+  // and again only when something changes
+  hists[3]->colormapRange = {2., 4.};
+  hists[4]->updateColormap("reds");
+  hists[5]->buildHistogram(values, {0., 10.});
+  polyscope::show(3);
+  EXPECT_EQ(hists[0]->getTextureRenderCount(), 1u);
+  EXPECT_EQ(hists[3]->getTextureRenderCount(), 2u);
+  EXPECT_EQ(hists[4]->getTextureRenderCount(), 2u);
+  EXPECT_EQ(hists[5]->getTextureRenderCount(), 2u);
+
+  // freed cells are reused, and pages go away with their last histogram
+  polyscope::state::userCallback = nullptr;
+  hists.resize(16);
+  EXPECT_EQ(polyscope::Histogram::getAtlasPageCount(), 1u);
+  hists.clear();
+  EXPECT_EQ(polyscope::Histogram::getAtlasPageCount(), 0u);
+}
+
+TEST_F(PolyscopeTest, PointCloudDeviceWrite) {
+  auto psPoints = registerPointCloud();
+  size_t n = psPoints->nPoints();
+  std::vector<float> vScalar(n, 2.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // positions written on the device, as by a CUDA kernel
+  std::shared_ptr<polyscope::render::AttributeBuffer> buff = psPoints->points.getRenderAttributeBufferForDeviceWrite(n);
+  EXPECT_EQ(buff, psPoints->points.getRenderAttributeBuffer());
+  EXPECT_TRUE(psPoints->points.dataIsDeviceOnly());
+  EXPECT_EQ(psPoints->points.size(), n);
+  psPoints->points.markRenderAttributeBufferUpdated();
+  polyscope::show(3);
+
+  // quantity values too, including resizing them
+  q1->values.getRenderAttributeBufferForDeviceWrite(2 * n);
+  EXPECT_EQ(q1->values.size(), 2 * n);
+  q1->values.getRenderAttributeBufferForDeviceWrite(n);
+  EXPECT_EQ(q1->values.size(), n);
+  q1->values.markRenderAttributeBufferUpdated();
+  polyscope::show(3);
+
+  // doubles are stored as floats, and cannot be written directly
+  std::vector<double> vDouble(n, 2.);
+  polyscope::render::ManagedBuffer<double> doubleBuffer("doubles", vDouble);
+  EXPECT_THROW(doubleBuffer.getRenderAttributeBufferForDeviceWrite(n), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudDeviceReadbackAsync) {
+  auto psPoints = registerPointCloud();
+  size_t n = psPoints->nPoints();
+  std::vector<float> vScalar(n, 2.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // written on the device, so the render buffer holds the only copy
+  q1->values.getRenderAttributeBuffer();
+  q1->values.markRenderAttributeBufferUpdated();
+  EXPECT_TRUE(q1->values.dataIsDeviceOnly());
+
+  // single values, delivered by a later frame (or immediately, by backends which read synchronously)
+  bool delivered = false;
+  q1->values.getValueAsync(1, [&](float) { delivered = true; });
+  polyscope::render::engine->processPendingReadbacks(true);
+  EXPECT_TRUE(delivered);
+  float pollValue = -1.;
+  while (!q1->values.tryGetValue(3, pollValue)) polyscope::render::engine->processPendingReadbacks(true);
+  EXPECT_TRUE(q1->values.dataIsDeviceOnly());
+  EXPECT_EQ(q1->values.getValue(3), pollValue); // (cached)
+
+  // the whole buffer
+  bool populated = false;
+  q1->values.ensureHostBufferPopulatedAsync([&]() { populated = true; });
+  polyscope::render::engine->processPendingReadbacks(true);
+  EXPECT_TRUE(populated);
+  EXPECT_FALSE(q1->values.dataIsDeviceOnly());
+  EXPECT_EQ(q1->values.data.size(), n);
+
+  // pick UIs don't wait on the readback
+  polyscope::pick::setSelection(std::make_pair(psPoints, 2));
+  q1->values.markRenderAttributeBufferUpdated();
+  polyscope::show(3);
+
+  // a read which lands after the buffer is gone is dropped
+  {
+    std::vector<glm::vec3> vecs(n, glm::vec3{1., 2., 3.});
+    polyscope::render::ManagedBuffer<glm::vec3> vecBuffer("vecs", vecs);
+    vecBuffer.getRenderAttributeBuffer();
+    vecBuffer.markRenderAttributeBufferUpdated();
+    vecBuffer.getValueAsync(0, [](glm::vec3) {});
+  }
+  polyscope::render::engine->processPendingReadbacks(true);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudBatchedUpdate) {
+  auto psPoints = registerPointCloud();
+  size_t n = psPoints->nPoints();
+  std::vector<float> vScalar(n, 2.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  std::vector<glm::vec3> vColor(n, glm::vec3{.2, .3, .4});
+  auto q2 = psPoints->addColorQuantity("vColor", vColor);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // uploads are deferred until the commit
+  std::vector<glm::vec3> newPositions(n, glm::vec3{1., 2., 3.});
+  psPoints->beginUpdate();
+  psPoints->updatePointPositions(newPositions);
+  q1->updateData(std::vector<float>(n, 3.));
+  q1->updateData(std::vector<float>(n, 4.));
+  q2->updateData(vColor);
+  psPoints->points.data.resize(2 * n);
+  psPoints->points.markHostBufferUpdated();
+  EXPECT_EQ(psPoints->points.getRenderAttributeBuffer()->getDataSize(), n);
+  psPoints->points.data.resize(n);
+  psPoints->points.markHostBufferRangeUpdated(0, 1);
+  psPoints->commitUpdate();
+  EXPECT_EQ(psPoints->points.getRenderAttributeBuffer()->getDataSize(), n);
+  EXPECT_EQ(q1->values.getValue(0), 4.);
+  polyscope::show(3);
+
+  // range updates are merged
+  psPoints->beginUpdate();
+  q1->values.data[1] = 5.;
+  q1->values.markHostBufferRangeUpdated(1, 2);
+  q1->values.data[3] = 6.;
+  q1->values.markHostBufferRangeUpdated(3, 4);
+  psPoints->commitUpdate();
+  EXPECT_EQ(q1->values.getValue(3), 6.);
+  polyscope::show(3);
+
+  EXPECT_THROW(psPoints->commitUpdate(), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudTimeSeriesScalar) {
+  auto psPoints = registerPointCloud();
+  size_t n = psPoints->nPoints();
+  std::vector<std::vector<float>> frames;
+  for (size_t f = 0; f < 20; f++) {
+    frames.push_back(std::vector<float>(n, 0.5f * f));
+  }
+  auto q1 = psPoints->addTimeSeriesScalarQuantity("vSeries", frames);
+  EXPECT_EQ(q1->nFrames(), 20);
+  EXPECT_EQ(q1->getDataRange().second, 9.5);
+  q1->setResidentFrameCount(4);
+  q1->setEnabled(true);
+  polyscope::show(10);
+
+  // the neighbors of the current frame get prefetched
+  EXPECT_TRUE(q1->isFrameResident(0));
+  EXPECT_TRUE(q1->isFrameResident(1));
+  EXPECT_TRUE(q1->isFrameResident(19));
+  EXPECT_FALSE(q1->isFrameResident(10));
+
+  // scrubbing to a resident frame only uploads (at most) the next prefetched one
+  uint64_t uploads = q1->frameUploadCount;
+  q1->setFrame(1);
+  polyscope::show(1);
+  EXPECT_EQ(q1->getFrame(), 1);
+  EXPECT_LE(q1->frameUploadCount, uploads + 1);
+  polyscope::show(10);
+  EXPECT_TRUE(q1->isFrameResident(2));
+  EXPECT_TRUE(q1->isFrameResident(0));
+
+  q1->setFrame(10);
+  polyscope::show(3);
+  EXPECT_TRUE(q1->isFrameResident(10));
+  q1->setPlaying(true);
+  polyscope::show(3);
+  q1->setPlaying(false);
+  EXPECT_THROW(q1->setFrame(20), std::runtime_error);
+
+  // half precision storage
+  auto q2 = psPoints->addTimeSeriesScalarQuantity("vSeriesHalf", frames, polyscope::DataType::STANDARD, true);
+  EXPECT_EQ(q2->getFrameValues(3)[0], 1.5f);
+  q2->setEnabled(true);
+  polyscope::show(3);
+
+  // with level of detail, the frames are drawn in LOD order
+  psPoints->setLODEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, PointCloudVector) {
   auto psPoints = registerPointCloud();
 
@@ -126,6 +789,26 @@ TEST_F(PolyscopeTest, PointCloudVector) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, PointCloudVectorSubsampled) {
+  auto psPoints = registerPointCloud();
+
+  std::vector<glm::vec3> vals(psPoints->nPoints(), {1., 2., 3.});
+  auto q1 = psPoints->addVectorQuantity("vals", vals);
+  q1->setEnabled(true);
+  q1->setMaxDrawnVectors(3);
+  EXPECT_EQ(q1->getMaxDrawnVectors(), 3);
+  polyscope::show(3);
+
+  // more than there are is the same as all of them
+  q1->setMaxDrawnVectors(psPoints->nPoints() + 5);
+  polyscope::show(3);
+
+  q1->setMaxDrawnVectors(0);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 
 TEST_F(PolyscopeTest, PointCloudParam) {
   auto psPoints = registerPointCloud();
@@ -181,3 +864,166 @@ TEST_F(PolyscopeTest, PointCloudScalarRadius) {
 
   polyscope::removeAllStructures();
 }
+
+TEST_F(PolyscopeTest, PointCloudThreshold) {
+  auto psPoints = registerPointCloud();
+  std::vector<double> vScalar(psPoints->nPoints());
+  for (size_t i = 0; i < vScalar.size(); i++) vScalar[i] = i;
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  std::vector<glm::vec3> vColors(psPoints->nPoints(), glm::vec3{.2, .3, .4});
+  psPoints->addColorQuantity("vColor", vColors)->setEnabled(true);
+
+  psPoints->setThresholdQuantity(q1, 2., 5.);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // moving the range only sets uniforms
+  polyscope::render::engine->resetCostCounters();
+  psPoints->setThresholdRange(1., 3.);
+  polyscope::show(3);
+  EXPECT_EQ(psPoints->getThresholdRange(), std::make_pair(1., 3.));
+  EXPECT_EQ(polyscope::render::engine->getCostCounters().shaderCompilations, 0);
+
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Quad);
+  polyscope::show(3);
+  psPoints->setInstancedDrawing(true);
+  polyscope::show(3);
+  psPoints->setLODEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  EXPECT_THROW(psPoints->setThresholdQuantity("vColor", 0., 1.), std::runtime_error);
+  psPoints->clearThresholdQuantity();
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudInstancedDrawing) {
+  auto psPoints = registerPointCloud();
+  psPoints->setInstancedDrawing(true);
+  EXPECT_TRUE(psPoints->getInstancedDrawing());
+  polyscope::show(3);
+
+  // quantities, variable radius, and picking all go through the instanced programs
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  psPoints->setPointRadiusQuantity(q1);
+  polyscope::show(3);
+  std::vector<glm::vec3> vColors(psPoints->nPoints(), glm::vec3{.2, .3, .4});
+  psPoints->addColorQuantity("vColor", vColors)->setEnabled(true);
+  polyscope::show(3);
+  std::vector<glm::vec2> param(psPoints->nPoints(), glm::vec2{.2, .3});
+  psPoints->addParameterizationQuantity("param", param)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Quad);
+  polyscope::show(3);
+
+  // with LOD and appending, only a prefix of the instances is drawn
+  psPoints->setLODEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  psPoints->setLODEnabled(false);
+  psPoints->clearPointRadiusQuantity();
+  psPoints->removeAllQuantities();
+  std::vector<glm::vec3> newPoints(3, glm::vec3{2.f, 0.f, 0.f});
+  psPoints->appendPoints(newPoints);
+  polyscope::show(3);
+
+  psPoints->setInstancedDrawing(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudDepthPrepass) {
+  auto psPoints = registerPointCloud();
+  psPoints->setDepthPrepass(true);
+  EXPECT_TRUE(psPoints->getDepthPrepass());
+  polyscope::show(3);
+
+  std::vector<double> vScalar(psPoints->nPoints(), 7.);
+  auto q1 = psPoints->addScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  psPoints->setPointRadiusQuantity(q1);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // skipped for quads and with transparency
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Quad);
+  polyscope::show(3);
+  psPoints->setPointRenderMode(polyscope::PointRenderMode::Sphere);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Simple;
+  polyscope::show(3);
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+
+  psPoints->setDepthPrepass(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudImpostorFallback) {
+  auto psPoints = registerPointCloud();
+
+  // everything is small enough to be drawn flat
+  polyscope::options::impostorFallbackPixelSize = 1e6;
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+  psPoints->setInstancedDrawing(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::options::impostorFallbackPixelSize = 0.;
+  polyscope::show(3);
+  polyscope::options::impostorFallbackPixelSize = 1.;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, PointCloudSortedTransparency) {
+  // points along the view axis, in a scrambled order
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 1000; i++) {
+    points.push_back(glm::vec3{0.01 * ((i * 7) % 13), 0., 0.001 * ((i * 389) % 1000)});
+  }
+  polyscope::PointCloud* psPoints = polyscope::registerPointCloud("sorted points", points);
+  polyscope::view::lookAt(glm::vec3{0., 0., 10.}, glm::vec3{0., 0., 0.});
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::Sorted;
+  psPoints->setTransparency(0.5);
+  polyscope::show(3);
+
+  // drawn far to near
+  std::vector<uint32_t> order = psPoints->getDepthSortOrder();
+  ASSERT_EQ(order.size(), points.size());
+  std::vector<uint32_t> sortedOrder = order;
+  std::sort(sortedOrder.begin(), sortedOrder.end());
+  for (size_t i = 0; i < sortedOrder.size(); i++) EXPECT_EQ(sortedOrder[i], i);
+  for (size_t i = 1; i < order.size(); i++) EXPECT_LE(points[order[i - 1]].z, points[order[i]].z);
+
+  // the order follows the camera
+  polyscope::view::lookAt(glm::vec3{0., 0., -10.}, glm::vec3{0., 0., 0.});
+  polyscope::show(3);
+  order = psPoints->getDepthSortOrder();
+  ASSERT_EQ(order.size(), points.size());
+  for (size_t i = 1; i < order.size(); i++) EXPECT_GE(points[order[i - 1]].z, points[order[i]].z);
+
+  // along with level of detail and quantities
+  psPoints->setLODEnabled(true);
+  psPoints->addScalarQuantity("vScalar", std::vector<double>(points.size(), 7.))->setEnabled(true);
+  polyscope::show(3);
+  EXPECT_EQ(psPoints->getDepthSortOrder().size(), psPoints->getLODDrawCount());
+  psPoints->setLODEnabled(false);
+
+  // opaque clouds are not sorted
+  psPoints->setTransparency(1.);
+  polyscope::show(3);
+  EXPECT_TRUE(psPoints->getDepthSortOrder().empty());
+
+  polyscope::options::transparencyMode = polyscope::TransparencyMode::None;
+  polyscope::removeAllStructures();
+}
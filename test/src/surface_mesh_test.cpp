@@ -2,6 +2,14 @@
 
 #include "polyscope_test.h"
 
+#include "polyscope/mesh_draw_order.h"
+#include "polyscope/ply_streaming.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
 // ============================================================
 // =============== Surface mesh tests
 // ============================================================
@@ -80,6 +88,90 @@ TEST_F(PolyscopeTest, SurfaceMeshPolygon) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshFlatFaceRegistration) {
+  // a quad and a pentagon, as flat arrays
+  std::vector<glm::vec3> points = {{0., 0., 0.}, {1., 0., 0.}, {1., 1., 0.}, {0., 1., 0.},
+                                   {2., 0., 0.}, {2., 1., 0.}, {1.5, 2., 0.}};
+  std::vector<uint32_t> faceIndsEntries = {0, 1, 2, 3, 1, 4, 5, 6, 2};
+  std::vector<uint32_t> faceIndsStart = {0, 4, 9};
+  polyscope::SurfaceMesh* psMesh =
+      polyscope::registerSurfaceMesh("flat", points, std::move(faceIndsEntries), std::move(faceIndsStart));
+  EXPECT_EQ(psMesh->nFaces(), 2);
+  EXPECT_EQ(psMesh->nCorners(), 9);
+  EXPECT_EQ(psMesh->nFacesTriangulation(), 5);
+
+  // fan triangulation of each face, in face order
+  psMesh->triangleVertexInds.ensureHostBufferPopulated();
+  psMesh->triangleFaceInds.ensureHostBufferPopulated();
+  psMesh->triangleCornerInds.ensureHostBufferPopulated();
+  EXPECT_EQ(psMesh->triangleVertexInds.data,
+            (std::vector<uint32_t>{0, 1, 2, 0, 2, 3, 1, 4, 5, 1, 5, 6, 1, 6, 2}));
+  EXPECT_EQ(psMesh->triangleFaceInds.data, (std::vector<uint32_t>{0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1}));
+  EXPECT_EQ(psMesh->triangleCornerInds.data, (std::vector<uint32_t>{0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7, 4, 7, 8}));
+
+  // the same faces as a nested list
+  std::vector<std::vector<size_t>> nested = {{0, 1, 2, 3}, {1, 4, 5, 6, 2}};
+  polyscope::SurfaceMesh* psNested = polyscope::registerSurfaceMesh("nested", points, nested);
+  psNested->triangleVertexInds.ensureHostBufferPopulated();
+  EXPECT_EQ(psNested->triangleVertexInds.data, psMesh->triangleVertexInds.data);
+  polyscope::show(3);
+
+  // malformed face lists
+  EXPECT_THROW(polyscope::registerSurfaceMesh("bad", points, std::vector<uint32_t>{0, 1, 2, 3, 4},
+                                              std::vector<uint32_t>{0, 3, 5}),
+               std::runtime_error);
+  EXPECT_THROW(polyscope::registerSurfaceMesh("bad", points, std::vector<uint32_t>{0, 1, 2},
+                                              std::vector<uint32_t>{0, 4}),
+               std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshUpdateTopology) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  std::vector<double> fScalar(psMesh->nFaces(), 3.);
+  auto qVert = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  psMesh->addFaceScalarQuantity("fScalar", fScalar);
+  qVert->setEnabled(true);
+  psMesh->setEdgePermutation(std::vector<size_t>{5, 3, 1, 2, 4, 0});
+  polyscope::show(3);
+
+  // drop a face: the vertex quantity still fits, the face quantity does not
+  psMesh->updateTopology(std::vector<std::vector<size_t>>{{1, 3, 2}, {3, 1, 0}, {2, 0, 1}});
+  EXPECT_EQ(psMesh->nFaces(), 3);
+  EXPECT_EQ(psMesh->nFacesTriangulation(), 3);
+  EXPECT_TRUE(psMesh->edgePerm.empty());
+  EXPECT_NE(psMesh->getQuantity("vScalar"), nullptr);
+  EXPECT_EQ(psMesh->getQuantity("fScalar"), nullptr);
+  psMesh->triangleVertexInds.ensureHostBufferPopulated();
+  EXPECT_EQ(psMesh->triangleVertexInds.data, (std::vector<uint32_t>{1, 3, 2, 3, 1, 0, 2, 0, 1}));
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // grow the mesh, with new vertices and a polygon
+  std::vector<glm::vec3> points = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {0, 0, 0}, {1, 1, 0}};
+  psMesh->updateVertexPositionsAndTopology(points, std::vector<std::vector<size_t>>{{1, 3, 2}, {3, 1, 4, 0}});
+  EXPECT_EQ(psMesh->nVertices(), 5);
+  EXPECT_EQ(psMesh->nFacesTriangulation(), 3);
+  EXPECT_EQ(psMesh->getQuantity("vScalar"), nullptr);
+  std::vector<double> fScalar2(psMesh->nFaces(), 1.);
+  psMesh->addFaceScalarQuantity("fScalar", fScalar2)->setEnabled(true);
+  polyscope::show(3);
+
+  // same counts, but asked not to keep quantities
+  psMesh->updateTopology(std::vector<std::vector<size_t>>{{0, 1, 2}, {3, 4, 1, 0}}, false);
+  EXPECT_EQ(psMesh->getQuantity("fScalar"), nullptr);
+  polyscope::show(3);
+
+  // malformed faces leave the mesh as it was
+  EXPECT_THROW(psMesh->updateTopology(std::vector<std::vector<size_t>>{{0, 1, 9}}), std::runtime_error);
+  EXPECT_EQ(psMesh->nFaces(), 2);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshAppearance) {
   auto psMesh = registerTriangleMesh();
 
@@ -118,6 +210,611 @@ TEST_F(PolyscopeTest, SurfaceMeshPick) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshPickAllElements) {
+  auto psMesh = registerTriangleMesh();
+
+  // using each element type adds it to the pick render
+  std::vector<double> eScalar(6, 9.);
+  psMesh->addEdgeScalarQuantity("eScalar", eScalar);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  std::vector<double> heScalar(psMesh->nHalfedges(), 10.);
+  psMesh->addHalfedgeScalarQuantity("heScalar", heScalar);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  std::vector<double> cornerScalar(psMesh->nCorners(), 10.);
+  psMesh->addCornerScalarQuantity("cornerScalar", cornerScalar);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshSubsets) {
+  auto psMesh = registerTriangleMesh();
+
+  psMesh->setVisibleSubset({0, 1});
+  psMesh->setHighlightedSubset({0});
+  EXPECT_TRUE(psMesh->isVisibleInSubset(1));
+  EXPECT_FALSE(psMesh->isVisibleInSubset(2));
+  EXPECT_TRUE(psMesh->isHighlightedInSubset(0));
+  EXPECT_FALSE(psMesh->isHighlightedInSubset(1));
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psMesh->addVertexScalarQuantity("vScalar", std::vector<double>(psMesh->nVertices(), 7.))->setEnabled(true);
+  psMesh->setSubsetHighlightColor(glm::vec3{1., 0., 0.});
+  EXPECT_EQ(psMesh->getSubsetHighlightColor(), glm::vec3(1., 0., 0.));
+  polyscope::show(3);
+
+  EXPECT_THROW(psMesh->setHighlightedSubset({psMesh->nFaces()}), std::runtime_error);
+
+  psMesh->clearVisibleSubset();
+  psMesh->clearHighlightedSubset();
+  EXPECT_TRUE(psMesh->isVisibleInSubset(2));
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshRayPick) {
+  auto psMesh = registerTriangleMesh();
+
+  // Hits the face in the z=0 plane
+  polyscope::RayPickResult result = psMesh->rayPick(glm::vec3{0.1, 0.1, -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_TRUE(result.isHit);
+  EXPECT_EQ(result.elementInd, 1);
+  EXPECT_NEAR(result.depth, 5., 1e-4);
+
+  // Misses entirely
+  result = psMesh->rayPick(glm::vec3{5., 5., -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_FALSE(result.isHit);
+
+  // The acceleration structure gets rebuilt after moving the mesh
+  std::vector<glm::vec3> newPositions = std::get<0>(getTriangleMesh());
+  for (glm::vec3& p : newPositions) p += glm::vec3{5., 5., 0.};
+  psMesh->updateVertexPositions(newPositions);
+  result = psMesh->rayPick(glm::vec3{5.1, 5.1, -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_TRUE(result.isHit);
+
+  // Global query over all structures
+  auto globalResult = polyscope::pick::evaluateRayPickQuery(glm::vec3{5.1, 5.1, -5.}, glm::vec3{0., 0., 1.});
+  EXPECT_EQ(globalResult.first, psMesh);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshChunkedDrawing) {
+  // a grid big enough to be split in to several chunks
+  size_t n = 150;
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> faces;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      points.push_back(glm::vec3{i / (n - 1.), j / (n - 1.), 0.});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      faces.push_back({i * n + j, (i + 1) * n + j, (i + 1) * n + j + 1, i * n + j + 1});
+    }
+  }
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+  psMesh->setChunkedDrawing(true);
+  EXPECT_TRUE(psMesh->getChunkedDrawing());
+  polyscope::show(3);
+
+  std::vector<double> vals(points.size(), 0.44);
+  psMesh->addVertexScalarQuantity("vals", vals)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // a slice plane which removes part of the mesh
+  polyscope::SlicePlane* plane = polyscope::addSceneSlicePlane();
+  plane->setPose(glm::vec3{0.5, 0., 0.}, glm::vec3{1., 0., 0.});
+  polyscope::show(3);
+
+  // geometry updates rebuild the chunk bounds
+  for (glm::vec3& p : points) p.z = p.x * p.y;
+  psMesh->updateVertexPositions(points);
+  polyscope::show(3);
+
+  psMesh->setChunkedDrawing(false);
+  polyscope::show(3);
+
+  polyscope::removeLastSceneSlicePlane();
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshPartialVertexUpdate) {
+  size_t n = 20;
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> faces;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      float x = i / (n - 1.), y = j / (n - 1.);
+      points.push_back(glm::vec3{x, y, x * y});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      faces.push_back({i * n + j, (i + 1) * n + j, (i + 1) * n + j + 1, i * n + j + 1});
+    }
+  }
+  polyscope::SurfaceMesh* psPartial = polyscope::registerSurfaceMesh("partial", points, faces);
+  polyscope::SurfaceMesh* psFull = polyscope::registerSurfaceMesh("full", points, faces);
+  polyscope::show(3);
+  for (polyscope::SurfaceMesh* psMesh : {psPartial, psFull}) {
+    psMesh->faceNormals.ensureHostBufferPopulated();
+    psMesh->faceCenters.ensureHostBufferPopulated();
+    psMesh->faceAreas.ensureHostBufferPopulated();
+    psMesh->vertexNormals.ensureHostBufferPopulated();
+    psMesh->vertexAreas.ensureHostBufferPopulated();
+  }
+
+  // Local edits match recomputing everything
+  std::vector<glm::vec3> moved = {glm::vec3{0.5, 0.5, 0.8}, glm::vec3{0.1, 0.2, 0.3}};
+  psPartial->updateVertexPositionsRange(5 * n + 5, std::vector<glm::vec3>{moved[0]});
+  psPartial->updateVertexPositionsAt({12 * n + 3, 2 * n + 17}, moved);
+  points[5 * n + 5] = moved[0];
+  points[12 * n + 3] = moved[0];
+  points[2 * n + 17] = moved[1];
+  psFull->updateVertexPositions(points);
+
+  EXPECT_TRUE(psPartial->faceNormals.data == psFull->faceNormals.data);
+  EXPECT_TRUE(psPartial->faceCenters.data == psFull->faceCenters.data);
+  EXPECT_TRUE(psPartial->faceAreas.data == psFull->faceAreas.data);
+  EXPECT_TRUE(psPartial->vertexNormals.data == psFull->vertexNormals.data);
+  EXPECT_TRUE(psPartial->vertexAreas.data == psFull->vertexAreas.data);
+  polyscope::show(3);
+
+  EXPECT_THROW(psPartial->updateVertexPositionsRange(n * n, moved), std::runtime_error);
+  EXPECT_THROW(psPartial->updateVertexPositionsAt({0}, moved), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshDeviceGeometryCompute) {
+  auto psMesh = registerTriangleMesh();
+  psMesh->setDeviceGeometryCompute(true);
+  EXPECT_TRUE(psMesh->getDeviceGeometryCompute());
+  polyscope::show(3);
+  psMesh->vertexNormals.ensureHostBufferPopulated();
+
+  // Where the engine can't compute them on the device, the normals are still updated on the host
+  std::vector<glm::vec3> newPositions = std::get<0>(getTriangleMesh());
+  for (glm::vec3& p : newPositions) p = glm::vec3{p.y, p.z, p.x};
+  psMesh->updateVertexPositions(newPositions);
+  polyscope::show(3);
+  auto psHost = polyscope::registerSurfaceMesh("host", newPositions, std::get<1>(getTriangleMesh()));
+  for (polyscope::SurfaceMesh* m : {psMesh, psHost}) {
+    m->faceNormals.ensureHostBufferPopulated();
+    m->vertexNormals.ensureHostBufferPopulated();
+  }
+  EXPECT_TRUE(psMesh->faceNormals.data == psHost->faceNormals.data);
+  EXPECT_TRUE(psMesh->vertexNormals.data == psHost->vertexNormals.data);
+
+  psMesh->setDeviceGeometryCompute(false);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshMeshletDrawing) {
+  size_t n = 60;
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      points.push_back(glm::vec3{i / (n - 1.), j / (n - 1.), 0.});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      faces.push_back({i * n + j, (i + 1) * n + j, (i + 1) * n + j + 1});
+      faces.push_back({i * n + j, (i + 1) * n + j + 1, i * n + j + 1});
+    }
+  }
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+  psMesh->setMeshletDrawing(true);
+  EXPECT_TRUE(psMesh->getMeshletDrawing());
+
+  // every meshlet respects the limits, so there are at least this many
+  size_t nClusters = psMesh->nDrawClusters();
+  EXPECT_GE(nClusters, (faces.size() + polyscope::SurfaceMesh::meshletMaxTriangles - 1) /
+                           polyscope::SurfaceMesh::meshletMaxTriangles);
+  EXPECT_GE(nClusters, points.size() / polyscope::SurfaceMesh::meshletMaxVertices);
+  polyscope::show(3);
+
+  std::vector<double> vals(points.size(), 0.44);
+  psMesh->addVertexScalarQuantity("vals", vals)->setEnabled(true);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // cone culling of back-facing clusters
+  psMesh->setBackFacePolicy(polyscope::BackFacePolicy::Cull);
+  polyscope::show(3);
+  polyscope::view::lookAt(glm::vec3{0.5, 0.5, -3.}, glm::vec3{0.5, 0.5, 0.});
+  polyscope::show(3);
+
+  psMesh->setMeshletDrawing(false);
+  EXPECT_EQ(psMesh->nDrawClusters(), 1);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshIndexedDrawing) {
+  // triangle meshes with per-vertex data draw shared vertex buffers through an index buffer
+  auto psMesh = registerTriangleMesh();
+  EXPECT_TRUE(psMesh->canDrawIndexed());
+  EXPECT_EQ(psMesh->getMeshProgramName(true), "INDEXED_MESH");
+  EXPECT_EQ(psMesh->getMeshProgramName(false), "MESH");
+  polyscope::show(3);
+
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  std::vector<glm::vec3> vColors(psMesh->nVertices(), glm::vec3{.2, .3, .4});
+  std::vector<glm::vec3> vVecs(psMesh->nVertices(), glm::vec3{1., 0., 0.});
+  std::vector<double> fScalar(psMesh->nFaces(), 8.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  auto q2 = psMesh->addVertexColorQuantity("vColor", vColors);
+  auto q3 = psMesh->addVertexVectorQuantity("vVecs", vVecs);
+  auto q4 = psMesh->addFaceScalarQuantity("fScalar", fScalar);
+  q3->setLICEnabled(true);
+  for (polyscope::SurfaceMeshQuantity* q : std::vector<polyscope::SurfaceMeshQuantity*>{q1, q2, q3, q4}) {
+    q->setEnabled(true);
+    psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+    polyscope::show(3);
+    psMesh->setShadeStyle(polyscope::MeshShadeStyle::Flat);
+    polyscope::show(3);
+    q->setEnabled(false);
+  }
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // anything needing per-corner data falls back to expanded buffers
+  psMesh->setEdgeWidth(1.);
+  EXPECT_FALSE(psMesh->canDrawIndexed());
+  q1->setEnabled(true);
+  polyscope::show(3);
+  psMesh->setEdgeWidth(0.);
+  EXPECT_TRUE(psMesh->canDrawIndexed());
+  polyscope::addSceneSlicePlane();
+  psMesh->setCullWholeElements(true);
+  EXPECT_FALSE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+  polyscope::removeLastSceneSlicePlane();
+
+  // chunked drawing selects ranges of the index buffer
+  psMesh->setCullWholeElements(false);
+  psMesh->setChunkedDrawing(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshPackedVertexColor) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<uint32_t> vColors(psMesh->nVertices(), polyscope::packColorRGBA8(51, 102, 153));
+  auto q1 = psMesh->addPackedVertexColorQuantity("vColor", vColors);
+  q1->setEnabled(true);
+  EXPECT_TRUE(q1->isPacked());
+  EXPECT_NEAR(q1->getColor(0).z, .6, 1e-6);
+  polyscope::show(3);
+
+  psMesh->setEdgeWidth(1.); // expanded, non-indexed buffers
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshCompressedVertexAttributes) {
+  auto psMesh = registerTriangleMesh();
+  psMesh->setCompressedVertexAttributes(true);
+  EXPECT_TRUE(psMesh->getCompressedVertexAttributes());
+  EXPECT_EQ(psMesh->getMeshProgramName(true), "INDEXED_MESH_COMPRESSED");
+  polyscope::show(3);
+
+  // positions decode to within a quantization step of the bounding box
+  glm::vec3 bMin{std::numeric_limits<float>::infinity()};
+  glm::vec3 bMax{-std::numeric_limits<float>::infinity()};
+  for (glm::vec3 p : psMesh->vertexPositions.data) {
+    bMin = glm::min(bMin, p);
+    bMax = glm::max(bMax, p);
+  }
+  psMesh->compressedVertexAttributes.ensureHostBufferPopulated();
+  ASSERT_EQ(psMesh->compressedVertexAttributes.data.size(), psMesh->nVertices());
+  for (size_t iV = 0; iV < psMesh->nVertices(); iV++) {
+    glm::uvec3 packed = psMesh->compressedVertexAttributes.data[iV];
+    glm::vec3 q{packed.x & 0xFFFFu, packed.x >> 16, packed.y & 0xFFFFu};
+    glm::vec3 decoded = bMin + q * (bMax - bMin) / 65535.f;
+    EXPECT_LT(glm::length(decoded - psMesh->vertexPositions.data[iV]), 1e-4 * glm::length(bMax - bMin));
+  }
+
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  for (polyscope::MeshShadeStyle style : {polyscope::MeshShadeStyle::Smooth, polyscope::MeshShadeStyle::Flat}) {
+    psMesh->setShadeStyle(style);
+    polyscope::show(3);
+  }
+
+  // geometry updates re-quantize
+  std::vector<glm::vec3> newPositions = psMesh->vertexPositions.data;
+  for (glm::vec3& p : newPositions) p *= 2.;
+  psMesh->updateVertexPositions(newPositions);
+  polyscope::show(3);
+
+  // programs which can't draw indexed are unaffected
+  psMesh->setEdgeWidth(1.);
+  EXPECT_EQ(psMesh->getMeshProgramName(true), "MESH");
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshFaceDataFetch) {
+  // face data is looked up by primitive ID, directly on triangle meshes, or through a triangle-to-face map on polygons
+  std::vector<glm::vec3> points = {{0., 0., 0.}, {1., 0., 0.}, {1., 1., 0.}, {0., 1., 0.}, {2., 0., 0.}};
+  std::vector<std::vector<size_t>> faces = {{0, 1, 2, 3}, {1, 4, 2}};
+  auto psPoly = polyscope::registerSurfaceMesh("poly", points, faces);
+  auto psTri = registerTriangleMesh();
+
+  for (polyscope::SurfaceMesh* psMesh : std::vector<polyscope::SurfaceMesh*>{psTri, psPoly}) {
+    EXPECT_TRUE(psMesh->canFetchFaceData());
+    std::vector<double> fScalar(psMesh->nFaces(), 8.);
+    std::vector<glm::vec3> fColors(psMesh->nFaces(), glm::vec3{.2, .3, .4});
+    auto q1 = psMesh->addFaceScalarQuantity("fScalar", fScalar);
+    auto q2 = psMesh->addFaceColorQuantity("fColor", fColors);
+    for (polyscope::SurfaceMeshQuantity* q : std::vector<polyscope::SurfaceMeshQuantity*>{q1, q2}) {
+      q->setEnabled(true);
+      polyscope::show(3);
+      psMesh->setEdgeWidth(1.);
+      polyscope::show(3);
+      psMesh->setEdgeWidth(0.);
+    }
+
+    // updates go to the texture in place
+    fScalar[0] = 3.;
+    q1->updateData(fScalar);
+    q1->setEnabled(true);
+    polyscope::show(3);
+
+    // chunked drawing restarts the primitive ID, so the values are expanded instead
+    psMesh->setChunkedDrawing(true);
+    EXPECT_FALSE(psMesh->canFetchFaceData());
+    polyscope::show(3);
+    psMesh->setChunkedDrawing(false);
+  }
+
+  psPoly->triangleFaces.ensureHostBufferPopulated();
+  EXPECT_EQ(psPoly->triangleFaces.data, (std::vector<uint32_t>{0, 0, 1}));
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshBackgroundPreparation) {
+  polyscope::options::prepareStructuresInBackground = true;
+
+  // a grid big enough to be triangulated on a worker thread
+  size_t n = 260;
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 4>> faces;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      points.push_back(glm::vec3{i / (n - 1.), j / (n - 1.), 0.});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      faces.push_back({i * n + j, (i + 1) * n + j, (i + 1) * n + j + 1, i * n + j + 1});
+    }
+  }
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // accessing the data waits for it
+  psMesh->triangleVertexInds.ensureHostBufferPopulated();
+  EXPECT_FALSE(psMesh->isLoading());
+  ASSERT_EQ(psMesh->triangleVertexInds.data.size(), 3 * psMesh->nFacesTriangulation());
+  EXPECT_EQ(psMesh->triangleVertexInds.data[3], faces[0][0]);
+  EXPECT_EQ(psMesh->triangleVertexInds.data[4], faces[0][2]);
+  polyscope::show(3);
+
+  polyscope::options::prepareStructuresInBackground = false;
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshOptimizedDrawOrder) {
+  // a grid with its triangles shuffled, so the face order has no locality
+  size_t n = 40;
+  std::vector<glm::vec3> points;
+  std::vector<std::array<size_t, 3>> faces;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      points.push_back(glm::vec3{i / (n - 1.), j / (n - 1.), 0.});
+    }
+  }
+  for (size_t i = 0; i + 1 < n; i++) {
+    for (size_t j = 0; j + 1 < n; j++) {
+      faces.push_back({i * n + j, (i + 1) * n + j, (i + 1) * n + j + 1});
+      faces.push_back({i * n + j, (i + 1) * n + j + 1, i * n + j + 1});
+    }
+  }
+  std::shuffle(faces.begin(), faces.end(), std::mt19937(7));
+
+  polyscope::options::optimizeMeshDrawOrder = true;
+  polyscope::SurfaceMesh* psMesh = polyscope::registerSurfaceMesh("grid", points, faces);
+  polyscope::options::optimizeMeshDrawOrder = false;
+  EXPECT_TRUE(psMesh->optimizeDrawOrder);
+  EXPECT_EQ(psMesh->getMeshProgramName(true), "INDEXED_MESH");
+  polyscope::show(3);
+
+  // the indexed draw reuses far more vertices
+  std::vector<uint32_t>& drawInds = psMesh->getDrawTriangleVertexInds();
+  double shuffledACMR = polyscope::averageCacheMissRatio(psMesh->faceIndsEntries);
+  double optimizedACMR = polyscope::averageCacheMissRatio(drawInds);
+  EXPECT_GT(shuffledACMR, 2.);
+  EXPECT_LT(optimizedACMR, 1.);
+
+  // the triangle buffers are consistently reordered, while the faces and vertices keep their indices
+  psMesh->drawVertexOrder.ensureHostBufferPopulated();
+  psMesh->triangleFaceInds.ensureHostBufferPopulated();
+  psMesh->triangleFaces.ensureHostBufferPopulated();
+  for (size_t iF = 0; iF < faces.size(); iF++) {
+    size_t iT = psMesh->faceTriangleStart(iF);
+    EXPECT_EQ(psMesh->triangleFaces.data[iT], iF);
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_EQ(psMesh->triangleVertexInds.data[3 * iT + k], faces[iF][k]);
+      EXPECT_EQ(psMesh->triangleFaceInds.data[3 * iT + k], iF);
+      EXPECT_EQ(psMesh->drawVertexOrder.data[drawInds[3 * iT + k]], faces[iF][k]);
+    }
+  }
+
+  // quantities are given in the user's order; face data is fetched through the triangle-to-face map
+  EXPECT_TRUE(psMesh->canFetchFaceData());
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  std::vector<double> fScalar(psMesh->nFaces(), 8.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  auto q2 = psMesh->addFaceScalarQuantity("fScalar", fScalar);
+  for (polyscope::SurfaceMeshQuantity* q : std::vector<polyscope::SurfaceMeshQuantity*>{q1, q2}) {
+    q->setEnabled(true);
+    polyscope::show(3);
+    q->setEnabled(false);
+  }
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // geometry updates reach the reordered vertex copies
+  std::vector<glm::vec3> newPositions = points;
+  for (glm::vec3& p : newPositions) p *= 2.;
+  psMesh->updateVertexPositions(newPositions);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+  psMesh->setMeshletDrawing(true);
+  polyscope::show(3);
+
+  // polygons keep their triangles together
+  std::vector<glm::vec3> polyPoints = {{0., 0., 0.}, {1., 0., 0.}, {1., 1., 0.}, {0., 1., 0.}, {2., 0., 0.}};
+  std::vector<std::vector<size_t>> polyFaces = {{0, 1, 2, 3}, {1, 4, 2}};
+  polyscope::options::optimizeMeshDrawOrder = true;
+  polyscope::SurfaceMesh* psPoly = polyscope::registerSurfaceMesh("poly", polyPoints, polyFaces);
+  polyscope::options::optimizeMeshDrawOrder = false;
+  psPoly->triangleFaces.ensureHostBufferPopulated();
+  size_t quadStart = psPoly->faceTriangleStart(0);
+  EXPECT_EQ(psPoly->triangleFaces.data[quadStart], 0u);
+  EXPECT_EQ(psPoly->triangleFaces.data[quadStart + 1], 0u);
+  EXPECT_EQ(psPoly->triangleFaces.data[psPoly->faceTriangleStart(1)], 1u);
+  psPoly->addFaceScalarQuantity("fScalar", std::vector<double>{1., 2.})->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshGeometryView) {
+  polyscope::SurfaceMesh* psMesh = registerTriangleMesh("source");
+  polyscope::SurfaceMesh* psView = polyscope::registerSurfaceMeshView("view", psMesh);
+  EXPECT_TRUE(psView->isGeometryView());
+  EXPECT_EQ(psView->getGeometrySource(), psMesh);
+  EXPECT_EQ(psView->nVertices(), psMesh->nVertices());
+  EXPECT_EQ(psView->nFaces(), psMesh->nFaces());
+
+  // each has its own quantities and settings
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  psMesh->addVertexScalarQuantity("vScalar", vScalar)->setEnabled(true);
+  psView->addFaceColorQuantity("fColor", std::vector<glm::vec3>(psView->nFaces()))->setEnabled(true);
+  psView->setEdgeWidth(1.);
+  polyscope::show(3);
+
+  // the geometry buffers and their render buffers are held once, by the source
+  EXPECT_EQ(psView->vertexPositions.getRenderAttributeBuffer(), psMesh->vertexPositions.getRenderAttributeBuffer());
+  EXPECT_EQ(psView->vertexNormals.getIndexedRenderAttributeBuffer(psView->triangleVertexInds),
+            psMesh->vertexNormals.getIndexedRenderAttributeBuffer(psMesh->triangleVertexInds));
+  EXPECT_EQ(polyscope::render::getManagedBufferHostBytes(psView->uniquePrefix() + "vertexPositions"), 0u);
+  EXPECT_GT(polyscope::render::getManagedBufferHostBytes(psMesh->uniquePrefix() + "vertexPositions"), 0u);
+  EXPECT_TRUE(psView->rayPick(glm::vec3{1., 1., 1.}, glm::vec3{-1., -1., -1.}).isHit);
+
+  // position updates go through the source, and the views follow
+  std::vector<glm::vec3> newPositions = std::get<0>(getTriangleMesh());
+  for (glm::vec3& p : newPositions) p *= 2.;
+  psMesh->updateVertexPositions(newPositions);
+  EXPECT_EQ(psView->vertexPositions.getValue(0), newPositions[0]);
+  polyscope::show(3);
+  EXPECT_THROW(psView->updateVertexPositions(newPositions), std::runtime_error);
+  EXPECT_THROW(psMesh->updateTopology(std::get<1>(getTriangleMesh())), std::runtime_error);
+
+  // the source can be removed first; it lives on while the view uses it
+  polyscope::removeStructure(psMesh);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshPLYStreaming) {
+  std::string filename = "test_streaming_mesh.ply";
+  {
+    std::ofstream out(filename);
+    out << "ply\nformat ascii 1.0\ncomment a quad and a triangle\nelement vertex 5\n"
+        << "property float x\nproperty float y\nproperty float z\n"
+        << "element face 2\nproperty list uchar int vertex_indices\nend_header\n"
+        << "0 0 0\n1 0 0\n1 1 0\n0 1 0\n2 0 0\n"
+        << "4 0 1 2 3\n3 1 4 2\n";
+  }
+
+  polyscope::SurfaceMesh* loadedMesh = nullptr;
+  polyscope::registerSurfaceMeshPLYStreaming("streamed", filename,
+                                             [&](polyscope::SurfaceMesh* m) { loadedMesh = m; });
+  for (int iter = 0; iter < 10000 && loadedMesh == nullptr; iter++) {
+    polyscope::show(1);
+  }
+  ASSERT_TRUE(polyscope::hasSurfaceMesh("streamed"));
+  EXPECT_EQ(loadedMesh, polyscope::getSurfaceMesh("streamed"));
+  EXPECT_EQ(loadedMesh->nVertices(), 5);
+  EXPECT_EQ(loadedMesh->nFaces(), 2);
+  EXPECT_EQ(loadedMesh->nFacesTriangulation(), 3);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  std::remove(filename.c_str());
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshInstanced) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<glm::mat4> transforms;
+  for (int i = 0; i < 5; i++) {
+    glm::mat4 T(1.);
+    T[3] = glm::vec4{2. * i, 0., 0., 1.};
+    transforms.push_back(T);
+  }
+  psMesh->setInstanceTransforms(transforms);
+  EXPECT_EQ(psMesh->nInstances(), 5);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // the bounds cover all of the instances
+  glm::vec3 bboxMin, bboxMax;
+  std::tie(bboxMin, bboxMax) = psMesh->boundingBox();
+  EXPECT_GE(bboxMax.x - bboxMin.x, 8.);
+
+  std::vector<glm::vec3> colors(5, glm::vec3{.2, .3, .4});
+  psMesh->setInstanceColors(colors);
+  psMesh->setChunkedDrawing(true);
+  polyscope::show(3);
+
+  // quantities are drawn on every instance
+  std::vector<double> vals(psMesh->nVertices(), 0.44);
+  psMesh->addVertexScalarQuantity("vals", vals)->setEnabled(true);
+  psMesh->markEdgesAsUsed();
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // colors must match the instance count
+  EXPECT_THROW(psMesh->setInstanceColors(std::vector<glm::vec3>(2)), std::runtime_error);
+
+  psMesh->clearInstances();
+  EXPECT_EQ(psMesh->nInstances(), 0);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshBackface) {
   auto psMesh = registerTriangleMesh();
 
@@ -141,6 +838,40 @@ TEST_F(PolyscopeTest, SurfaceMeshBackface) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshThreshold) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices());
+  for (size_t i = 0; i < vScalar.size(); i++) vScalar[i] = i;
+  std::vector<double> fScalar(psMesh->nFaces(), 8.);
+  std::vector<double> eScalar(psMesh->nEdges(), 2.);
+  auto qVert = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  psMesh->addFaceScalarQuantity("fScalar", fScalar);
+  psMesh->addEdgeScalarQuantity("eScalar", eScalar);
+  qVert->setEnabled(true);
+
+  psMesh->setThresholdQuantity("vScalar", 1., 2.);
+  EXPECT_FALSE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  // moving the range only sets uniforms
+  polyscope::render::engine->resetCostCounters();
+  psMesh->setThresholdRange(0., 3.);
+  polyscope::show(3);
+  EXPECT_EQ(psMesh->getThresholdRange(), std::make_pair(0., 3.));
+  EXPECT_EQ(polyscope::render::engine->getCostCounters().shaderCompilations, 0);
+
+  psMesh->setThresholdQuantity("fScalar", 7., 9.);
+  polyscope::show(3);
+  EXPECT_THROW(psMesh->setThresholdQuantity("eScalar", 0., 1.), std::runtime_error);
+
+  psMesh->clearThresholdQuantity();
+  EXPECT_TRUE(psMesh->canDrawIndexed());
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshColorVertex) {
   auto psMesh = registerTriangleMesh();
   std::vector<glm::vec3> vColors(psMesh->nVertices(), glm::vec3{.2, .3, .4});
@@ -168,6 +899,88 @@ TEST_F(PolyscopeTest, SurfaceMeshScalarVertex) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshScalarVertexRangeUpdate) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // Update just some of the values (the indexed view used for drawing gets updated too)
+  q1->values.data[1] = 3.;
+  q1->values.data[2] = 4.;
+  q1->values.markHostBufferRangeUpdated(1, 3);
+  polyscope::show(3);
+
+  // Empty and out-of-bounds ranges
+  q1->values.markHostBufferRangeUpdated(2, 2);
+  EXPECT_THROW(q1->values.markHostBufferRangeUpdated(2, 100), std::runtime_error);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshScalarVertexExtractedIsolines) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices());
+  for (size_t i = 0; i < vScalar.size(); i++) {
+    vScalar[i] = psMesh->vertexPositions.getValue(i).x;
+  }
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  q1->setEnabled(true);
+  q1->setIsolineWidth(0.05, false);
+  q1->setIsolinesExtracted(true);
+  EXPECT_TRUE(q1->getIsolinesExtracted());
+  polyscope::show(3);
+  size_t nFine = q1->nExtractedIsolineSegments();
+  EXPECT_GT(nFine, 0u);
+
+  // Re-extracted when the spacing or the values change
+  q1->setIsolineWidth(0.5, false);
+  polyscope::show(3);
+  EXPECT_LE(q1->nExtractedIsolineSegments(), nFine);
+  q1->updateData(std::vector<double>(psMesh->nVertices(), 7.));
+  polyscope::show(3);
+  EXPECT_EQ(q1->nExtractedIsolineSegments(), 0u);
+
+  // Back to stripes
+  q1->setIsolinesExtracted(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshAppearanceChangesInPlace) {
+  // Materials and colormaps are swapped on the existing programs
+  auto psMesh = registerTriangleMesh();
+  std::vector<double> vScalar(psMesh->nVertices(), 7.);
+  std::vector<glm::vec2> vParam(psMesh->nVertices(), {.2, .3});
+  auto q1 = psMesh->addVertexScalarQuantity("vScalar", vScalar);
+  auto q2 = psMesh->addVertexParameterizationQuantity("vParam", vParam);
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  q1->setColorMap("blues");
+  EXPECT_EQ(q1->getColorMap(), "blues");
+  psMesh->setMaterial("wax");
+  polyscope::show(3);
+
+  q2->setStyle(polyscope::ParamVizStyle::LOCAL_RAD);
+  q2->setEnabled(true);
+  polyscope::show(3);
+  q2->setColorMap("reds");
+  psMesh->setMaterial("flat");
+  polyscope::show(3);
+
+  // Shading changes regenerate the surface programs, but not picking
+  psMesh->setEdgeWidth(1.);
+  psMesh->setEdgeWidth(2.);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Flat);
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshScalarFace) {
   auto psMesh = registerTriangleMesh();
   std::vector<double> fScalar(psMesh->nFaces(), 8.);
@@ -177,12 +990,55 @@ TEST_F(PolyscopeTest, SurfaceMeshScalarFace) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshScalarBulk) {
+  auto psMesh = registerTriangleMesh();
+
+  std::vector<std::string> names;
+  std::vector<std::vector<double>> vScalars;
+  for (int i = 0; i < 20; i++) {
+    names.push_back("vScalar" + std::to_string(i));
+    std::vector<double> vals(psMesh->nVertices());
+    for (size_t iV = 0; iV < vals.size(); iV++) vals[iV] = static_cast<double>(iV * (i + 1));
+    vScalars.push_back(vals);
+  }
+  std::vector<polyscope::SurfaceVertexScalarQuantity*> qs = psMesh->addVertexScalarQuantities(names, vScalars);
+  ASSERT_EQ(qs.size(), names.size());
+
+  // same as adding them one at a time
+  auto qSingle = psMesh->addVertexScalarQuantity("single", vScalars[7]);
+  EXPECT_EQ(qs[7], psMesh->getQuantity("vScalar7"));
+  EXPECT_EQ(qs[7]->getDataRange(), qSingle->getDataRange());
+  EXPECT_EQ(qs[7]->values.data, qSingle->values.data);
+
+  std::vector<std::vector<float>> fScalars(3, std::vector<float>(psMesh->nFaces(), 8.f));
+  auto fqs = psMesh->addFaceScalarQuantities({"f0", "f1", "f2"}, fScalars);
+  EXPECT_EQ(fqs.size(), 3u);
+
+  std::vector<std::vector<glm::vec3>> vVecs(4, std::vector<glm::vec3>(psMesh->nVertices(), glm::vec3{1., 2., 2.}));
+  auto vqs = psMesh->addVertexVectorQuantities({"v0", "v1", "v2", "v3"}, vVecs);
+  EXPECT_EQ(vqs.size(), 4u);
+  EXPECT_NEAR(vqs[2]->getVectorLengthRange(), 3., 1e-5);
+
+  // inputs are checked up front
+  EXPECT_THROW(psMesh->addVertexScalarQuantities({"a"}, vScalars), std::runtime_error);
+  std::vector<std::vector<double>> wrongSize{std::vector<double>(psMesh->nVertices() + 1)};
+  EXPECT_THROW(psMesh->addVertexScalarQuantities({"a"}, wrongSize), std::runtime_error);
+
+  qs[3]->setEnabled(true);
+  vqs[0]->setEnabled(true);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshScalarEdge) {
   auto psMesh = registerTriangleMesh();
   size_t nEdges = 6;
   std::vector<double> eScalar(nEdges, 9.);
   std::vector<size_t> ePerm = {5, 3, 1, 2, 4, 0};
+  std::vector<size_t> tooLargePerm = {5, 3, 1, 2, 4, polyscope::INVALID_IND_32}; // (stored in 32 bits)
+  EXPECT_THROW(psMesh->setEdgePermutation(tooLargePerm), std::runtime_error);
   psMesh->setEdgePermutation(ePerm);
+  EXPECT_EQ(psMesh->edgePerm, std::vector<uint32_t>(ePerm.begin(), ePerm.end()));
   auto q3 = psMesh->addEdgeScalarQuantity("eScalar", eScalar);
   q3->setEnabled(true);
   polyscope::show(3);
@@ -274,6 +1130,44 @@ TEST_F(PolyscopeTest, SurfaceMeshCornerParam) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, SurfaceMeshParamIslands) {
+  auto psMesh = registerTriangleMesh();
+
+  // Coordinates which agree at every vertex have no seams, so the (closed) mesh is one island
+  std::vector<glm::vec2> vals(psMesh->nCorners());
+  for (size_t iC = 0; iC < vals.size(); iC++) {
+    glm::vec3 p = psMesh->vertexPositions.getValue(psMesh->faceIndsEntries[iC]);
+    vals[iC] = {p.x, p.y};
+  }
+  auto q1 = psMesh->addParameterizationQuantity("param", vals);
+  EXPECT_EQ(q1->nIslands(), 1u);
+  q1->setIslandColoring(true);
+  EXPECT_TRUE(q1->getIslandColoring());
+  q1->setEnabled(true);
+  polyscope::show(3);
+
+  // Distinct coordinates at every corner make every edge a seam
+  for (size_t iC = 0; iC < vals.size(); iC++) {
+    vals[iC] = {static_cast<float>(iC), 0.};
+  }
+  q1->updateCoords(vals);
+  EXPECT_EQ(q1->nIslands(), psMesh->nFaces());
+  std::vector<uint32_t> islands = q1->getFaceIslands();
+  std::sort(islands.begin(), islands.end());
+  EXPECT_EQ(std::unique(islands.begin(), islands.end()) - islands.begin(), static_cast<long>(psMesh->nFaces()));
+  polyscope::show(3);
+
+  // Per-vertex coordinates never have seams
+  std::vector<glm::vec2> vVals(psMesh->nVertices(), {1., 2.});
+  auto q2 = psMesh->addVertexParameterizationQuantity("vParam", vVals);
+  EXPECT_EQ(q2->nIslands(), 1u);
+  q2->setIslandColoring(true);
+  q2->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, SurfaceMeshVertexParam) {
   auto psMesh = registerTriangleMesh();
   std::vector<glm::vec2> vals(psMesh->nVertices(), {1., 2.});
@@ -363,5 +1257,80 @@ TEST_F(PolyscopeTest, SurfaceMeshOneForm) {
   auto q1 = psMesh->addOneFormTangentVectorQuantity("one form vecs", vals, orients);
   q1->setEnabled(true);
   polyscope::show(3);
+  q1->setMaxDrawnVectors(1);
+  polyscope::show(3);
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshVectorLIC) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<glm::vec3> vVals(psMesh->nVertices(), {1., 2., 3.});
+  std::vector<glm::vec3> fVals(psMesh->nFaces(), {1., 2., 3.});
+  std::vector<glm::vec3> basisX(psMesh->nVertices(), {1., 0., 0.});
+  std::vector<glm::vec3> basisY(psMesh->nVertices(), {0., 1., 0.});
+  std::vector<glm::vec2> tVals(psMesh->nVertices(), {1., 2.});
+  std::vector<double> oneForm(6, 3.);
+  std::vector<char> orients(6, true);
+  psMesh->setEdgePermutation(std::vector<size_t>{5, 3, 1, 2, 4, 0});
+
+  auto q1 = psMesh->addVertexVectorQuantity("vecs", vVals);
+  auto q2 = psMesh->addFaceVectorQuantity("face vecs", fVals);
+  auto q3 = psMesh->addVertexTangentVectorQuantity("tangent vecs", tVals, basisX, basisY);
+  auto q4 = psMesh->addOneFormTangentVectorQuantity("one form vecs", oneForm, orients);
+  for (polyscope::SurfaceVectorQuantity* q : std::vector<polyscope::SurfaceVectorQuantity*>{q1, q2, q3, q4}) {
+    q->setEnabled(true);
+    q->setLICEnabled(true);
+    EXPECT_TRUE(q->getLICEnabled());
+    polyscope::show(3);
+  }
+
+  q1->setLICNoiseScale(0.01);
+  q1->setLICLength(16.);
+  EXPECT_EQ(q1->getLICLength(), 16.);
+  polyscope::show(3);
+
+  // back to glyphs
+  q1->setLICEnabled(false);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SurfaceMeshVertexPositionKeyframes) {
+  auto psMesh = registerTriangleMesh();
+  std::vector<glm::vec3> points = psMesh->vertexPositions.data;
+  std::vector<std::vector<glm::vec3>> keyframes(3, points);
+  for (glm::vec3& p : keyframes[1]) p += glm::vec3{2., 0., 0.};
+  for (glm::vec3& p : keyframes[2]) p += glm::vec3{2., 4., 0.};
+
+  psMesh->setVertexPositionKeyframes(keyframes);
+  EXPECT_EQ(psMesh->nVertexPositionKeyframes(), 3);
+  EXPECT_EQ(psMesh->getKeyframeTime(), 0.);
+  polyscope::show(3);
+
+  psMesh->setKeyframeTime(0.5);
+  polyscope::show(3);
+  if (!polyscope::render::engine->supportsAttributeBufferBlend()) {
+    EXPECT_NEAR(psMesh->vertexPositions.getValue(0).x, points[0].x + 1., 1e-5);
+  }
+
+  // clamped to the keyframes
+  psMesh->setKeyframeTime(7.);
+  EXPECT_EQ(psMesh->getKeyframeTime(), 2.);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Flat);
+  polyscope::show(3);
+  psMesh->setShadeStyle(polyscope::MeshShadeStyle::Smooth);
+  polyscope::show(3);
+
+  // wrong sizes
+  keyframes[1].pop_back();
+  EXPECT_THROW(psMesh->setVertexPositionKeyframes(keyframes), std::runtime_error);
+  EXPECT_THROW(psMesh->setCompressedVertexAttributes(true), std::runtime_error);
+
+  psMesh->clearVertexPositionKeyframes();
+  EXPECT_EQ(psMesh->nVertexPositionKeyframes(), 0);
+  EXPECT_THROW(psMesh->setKeyframeTime(0.), std::runtime_error);
+  polyscope::show(3);
+
   polyscope::removeAllStructures();
 }
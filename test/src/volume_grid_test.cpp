@@ -0,0 +1,328 @@
+// Copyright 2017-2023, Nicholas Sharp and the Polyscope contributors. https://polyscope.run
+
+#include "polyscope_test.h"
+
+#include "polyscope/grid_isosurface.h"
+#include "polyscope/pick.h"
+#include "polyscope/sparse_volume_grid.h"
+#include "polyscope/volume_grid.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <utility>
+
+// ============================================================
+// =============== Volume grid tests
+// ============================================================
+
+TEST_F(PolyscopeTest, ShowVolumeGrid) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {10, 12, 14}, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.});
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridScalarPoints) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {10, 12, 14}, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.});
+  auto q = psGrid->addScalarQuantityFromCallable("x", [](float x, float y, float z) { return x; });
+  q->setEnabled(true);
+  q->setIsosurfaceVizEnabled(false);
+  q->setPointVizEnabled(true);
+  polyscope::show(3);
+
+  // nodes are pickable while drawn as points
+  polyscope::pick::evaluatePickQuery(77, 88);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridScalarRaymarch) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {10, 12, 14}, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.});
+  auto q = psGrid->addScalarQuantityFromCallable("sphere sdf", [](float x, float y, float z) { return std::sqrt(x * x + y * y + z * z) - 0.5; });
+  q->setEnabled(true);
+  q->setPointVizEnabled(false);
+
+  // direct volume rendering
+  q->setIsosurfaceVizEnabled(false);
+  q->setVolumeVizEnabled(true);
+  q->setVolumeDensity(10.);
+  EXPECT_EQ(q->getVolumeDensity(), 10.);
+  polyscope::show(3);
+
+  // raymarched isosurface
+  q->setVolumeVizEnabled(false);
+  q->setIsosurfaceVizEnabled(true);
+  q->setIsosurfaceRaymarch(true);
+  polyscope::show(3);
+  q->setIsosurfaceLevel(0.1);
+  polyscope::show(3);
+
+  // both at once, and with a slice plane
+  q->setVolumeVizEnabled(true);
+  polyscope::addSceneSlicePlane();
+  polyscope::show(3);
+  polyscope::removeLastSceneSlicePlane();
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, GridIsosurfaceExtractor) {
+  // sphere distance field on a grid large enough to span several slabs and blocks
+  std::array<size_t, 3> steps{41, 33, 37};
+  std::vector<double> values(steps[0] * steps[1] * steps[2]);
+  for (size_t iX = 0; iX < steps[0]; iX++) {
+    for (size_t iY = 0; iY < steps[1]; iY++) {
+      for (size_t iZ = 0; iZ < steps[2]; iZ++) {
+        glm::vec3 p{iX - 20., iY - 16., iZ - 18.};
+        values[(iX * steps[1] + iY) * steps[2] + iZ] = glm::length(p);
+      }
+    }
+  }
+  polyscope::GridIsosurfaceExtractor extractor(values.data(), steps);
+
+  polyscope::options::maxWorkerThreads = 4;
+  polyscope::IsosurfaceMesh mesh = extractor.extract(12.3);
+  polyscope::options::maxWorkerThreads = 1;
+  polyscope::IsosurfaceMesh meshSerial = extractor.extract(12.3);
+  polyscope::options::maxWorkerThreads = -1;
+
+  ASSERT_GT(mesh.indices.size(), 0u);
+  EXPECT_EQ(mesh.vertices.size(), mesh.normals.size());
+  EXPECT_EQ(mesh.vertices.size(), meshSerial.vertices.size());
+  EXPECT_EQ(mesh.indices.size(), meshSerial.indices.size());
+
+  // the surface is closed and welded: every edge is shared by exactly two triangles
+  std::map<std::pair<uint32_t, uint32_t>, int> edgeCounts;
+  for (size_t iT = 0; iT < mesh.indices.size(); iT += 3) {
+    for (int j = 0; j < 3; j++) {
+      uint32_t a = mesh.indices[iT + j];
+      uint32_t b = mesh.indices[iT + (j + 1) % 3];
+      ASSERT_LT(a, mesh.vertices.size());
+      edgeCounts[{std::min(a, b), std::max(a, b)}]++;
+    }
+  }
+  for (auto& e : edgeCounts) EXPECT_EQ(e.second, 2);
+
+  // normals point outwards, towards larger distances
+  glm::vec3 center{20., 16., 18.};
+  for (size_t iV = 0; iV < mesh.vertices.size(); iV++) {
+    EXPECT_NEAR(glm::length(mesh.vertices[iV] - center), 12.3, 0.1);
+    EXPECT_GT(glm::dot(mesh.normals[iV], mesh.vertices[iV] - center), 0.);
+  }
+
+  // a level outside the range of the field gives an empty mesh
+  EXPECT_EQ(extractor.extract(100.).indices.size(), 0u);
+}
+
+TEST_F(PolyscopeTest, VolumeGridScalarIsosurfaceMesh) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {10, 12, 14}, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.});
+  auto q = psGrid->addScalarQuantityFromCallable(
+      "sphere sdf", [](float x, float y, float z) { return std::sqrt(x * x + y * y + z * z) - 0.5; });
+  q->setEnabled(true);
+  q->setIsosurfaceVizEnabled(true);
+  polyscope::show(3);
+  q->setIsosurfaceLevel(0.1);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridVectorArrows) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {10, 12, 14}, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.});
+  std::vector<glm::vec3> vecs(psGrid->nValues());
+  for (size_t i = 0; i < vecs.size(); i++) {
+    glm::vec3 p = psGrid->positionOfIndex(i);
+    vecs[i] = glm::vec3{-p.y, p.x, 0.2};
+  }
+  polyscope::VolumeGridVectorQuantity* q = psGrid->addVectorQuantity("swirl", vecs);
+  q->setEnabled(true);
+  polyscope::show(3);
+
+  // subsampled by stride, with and without jitter
+  q->setSampleStride(3);
+  EXPECT_EQ(q->getSampleStride(), 3);
+  polyscope::show(3);
+  q->setSampleJitter(true);
+  EXPECT_TRUE(q->getSampleJitter());
+  polyscope::show(3);
+
+  // the stride grows to respect a limit on the count
+  q->setSampleStride(1);
+  q->setMaxDrawnVectors(100);
+  polyscope::show(3);
+
+  std::vector<glm::vec3> vecs2(psGrid->nValues(), glm::vec3{1., 0., 0.});
+  q->updateData(vecs2);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridVectorStreamlines) {
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {10, 12, 14}, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.});
+
+  // a constant field along x: the streamlines are straight lines across the grid
+  std::vector<glm::vec3> vecs(psGrid->nValues(), glm::vec3{1., 0., 0.});
+  polyscope::VolumeGridVectorQuantity* q = psGrid->addVectorQuantity("const", vecs);
+  q->setEnabled(true);
+  q->setArrowVizEnabled(false);
+  q->setStreamlineVizEnabled(true);
+  q->setStreamlineSeedsPerAxis(3);
+  EXPECT_EQ(q->getStreamlineSeeds().size(), 27);
+  polyscope::show(3);
+
+  const std::vector<std::vector<glm::vec3>>& lines = q->getStreamlines();
+  ASSERT_EQ(lines.size(), 27);
+  for (const std::vector<glm::vec3>& line : lines) {
+    ASSERT_GE(line.size(), 2);
+    EXPECT_LT(line.front().x, -0.8);
+    EXPECT_GT(line.back().x, 0.8);
+    for (const glm::vec3& p : line) {
+      EXPECT_NEAR(p.y, line.front().y, 1e-5);
+      EXPECT_NEAR(p.z, line.front().z, 1e-5);
+    }
+  }
+
+  // explicit seeds, and a new field, invalidate the cached lines
+  q->setStreamlineSeeds({glm::vec3{0., 0., 0.}, glm::vec3{0.5, 0.5, 0.5}});
+  EXPECT_EQ(q->getStreamlines().size(), 2);
+  std::vector<glm::vec3> vecs2(psGrid->nValues(), glm::vec3{0., 0., 1.});
+  q->updateData(vecs2);
+  EXPECT_GT(q->getStreamlines()[0].back().z, 0.8);
+  q->setStreamlineMaxSteps(3);
+  EXPECT_EQ(q->getStreamlines()[0].size(), 7);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, SparseVolumeGrid) {
+  // a narrow band of nodes around a sphere, spanning negative coordinates and many bricks
+  const float h = 0.05;
+  std::vector<glm::ivec3> nodes;
+  std::vector<float> sdf;
+  for (int i = -25; i <= 25; i++) {
+    for (int j = -25; j <= 25; j++) {
+      for (int k = -25; k <= 25; k++) {
+        float d = glm::length(glm::vec3{i, j, k} * h) - 0.8f;
+        if (std::abs(d) > 3 * h) continue;
+        nodes.push_back(glm::ivec3{i, j, k});
+        sdf.push_back(d);
+      }
+    }
+  }
+  nodes.push_back(nodes.front()); // duplicates are ignored
+  polyscope::SparseVolumeGrid* psGrid =
+      polyscope::registerSparseVolumeGrid("sparse grid", glm::vec3{0., 0., 0.}, glm::vec3{h, h, h}, nodes);
+  EXPECT_EQ(psGrid->nActiveNodes(), sdf.size());
+  EXPECT_LT(psGrid->nValues(), static_cast<size_t>(51 * 51 * 51));
+
+  // block index lookups
+  EXPECT_EQ(psGrid->brickOfNode(glm::ivec3{-1, 0, 8}), (glm::ivec3{-1, 0, 1}));
+  EXPECT_EQ(psGrid->valueIndexOfNode(glm::ivec3{0, 0, 0}), -1); // the center of the sphere is empty
+  int64_t iVal = psGrid->valueIndexOfNode(nodes.front());
+  ASSERT_GE(iVal, 0);
+  EXPECT_EQ(psGrid->nodeOfValueIndex(iVal), nodes.front());
+
+  polyscope::SparseVolumeGridScalarQuantity* q = psGrid->addScalarQuantity("sdf", sdf);
+  q->setEnabled(true);
+  q->setIsosurfaceLevel(0.);
+
+  // the extracted surface lies on the sphere
+  polyscope::IsosurfaceMesh mesh = q->extractIsosurface();
+  ASSERT_GT(mesh.indices.size(), 0u);
+  for (const glm::vec3& p : mesh.vertices) {
+    EXPECT_NEAR(glm::length(p), 0.8, h);
+  }
+  polyscope::show(3);
+
+  q->setPointVizEnabled(true);
+  q->setIsosurfaceRaymarch(true);
+  polyscope::show(3);
+
+  // sampled at every node of the bricks
+  polyscope::SparseVolumeGridScalarQuantity* q2 = psGrid->addScalarQuantityFromCallable(
+      "sdf sampled", [](float x, float y, float z) { return std::sqrt(x * x + y * y + z * z) - 0.8; });
+  EXPECT_EQ(q2->getBrickValues().size(), psGrid->nValues());
+  q2->setEnabled(true);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeGridStreamedScalar) {
+
+  // Write a sphere SDF to a raw file, behind a small header
+  const size_t n = 70;
+  std::string filename = "test_volume_grid_streamed.raw";
+  std::vector<float> sdf;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      for (size_t k = 0; k < n; k++) {
+        glm::vec3 p = glm::vec3{i, j, k} / (n - 1.f) * 2.f - 1.f;
+        sdf.push_back(glm::length(p) - 0.6f);
+      }
+    }
+  }
+  {
+    std::ofstream out(filename, std::ios::binary);
+    float header[2] = {1., 2.};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&sdf.front()), sdf.size() * sizeof(float));
+  }
+
+  // The pyramid halves the resolution down to a single brick, and is reused once built
+  {
+    polyscope::VolumeBrickPyramid pyramid(filename, {n, n, n}, 8);
+    EXPECT_TRUE(pyramid.pyramidWasBuilt());
+    ASSERT_EQ(pyramid.nLevels(), 3u);
+    EXPECT_EQ(pyramid.levelSteps(1), (std::array<size_t, 3>{35, 35, 35}));
+    EXPECT_EQ(pyramid.levelBricks(0), (std::array<size_t, 3>{3, 3, 3}));
+    EXPECT_EQ(pyramid.levelBricks(2), (std::array<size_t, 3>{1, 1, 1}));
+    EXPECT_FLOAT_EQ(pyramid.getDataRange().first, *std::min_element(sdf.begin(), sdf.end()));
+
+    // the first index is fastest in a brick, and the last brick repeats the end of the data
+    const size_t p = polyscope::VolumeBrickPyramid::brickSize + 1;
+    std::vector<float> brick(p * p * p);
+    pyramid.readBrick(0, {2, 0, 1}, &brick.front());
+    EXPECT_EQ(brick[(3 * p + 2) * p + 1], sdf[((64 + 1) * n + 2) * n + 32 + 3]);
+    EXPECT_EQ(brick[p - 1], sdf[(n - 1) * n * n + 32]);
+  }
+  {
+    polyscope::VolumeBrickPyramid pyramid(filename, {n, n, n}, 8);
+    EXPECT_FALSE(pyramid.pyramidWasBuilt());
+  }
+
+  polyscope::VolumeGrid* psGrid =
+      polyscope::registerVolumeGrid("test grid", {n, n, n}, glm::vec3{-1., -1., -1.}, glm::vec3{1., 1., 1.});
+  polyscope::VolumeGridStreamedScalarQuantity* q = psGrid->addScalarQuantityFromRawFile("sdf", filename, 8);
+  q->setEnabled(true);
+  q->setMaxBrickUploadsPerFrame(4);
+  q->setIsosurfaceLevel(0.);
+  polyscope::show(3);
+
+  // streams in over a few frames, within the cache
+  q->setCacheBricks(20);
+  for (int iter = 0; iter < 100 && !q->getCacheComplete(); iter++) {
+    polyscope::show(1);
+  }
+  EXPECT_TRUE(q->getCacheComplete());
+  EXPECT_LE(q->getResidentBrickCount(), 20u);
+
+  q->setVolumeVizEnabled(true);
+  q->setLevelOfDetailPixels(8.);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  std::remove(filename.c_str());
+  std::remove(polyscope::VolumeBrickPyramid::pyramidFilename(filename).c_str());
+}
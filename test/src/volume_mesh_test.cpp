@@ -63,6 +63,119 @@ TEST_F(PolyscopeTest, ShowVolumeMesh) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, VolumeMeshInteriorFaces) {
+  // two tets sharing the face {1,2,3} (listed in different orders), and a hex sharing a quad with a second hex
+  std::vector<glm::vec3> verts = {
+      {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1},                                    // tets
+      {0, 0, 2}, {1, 0, 2}, {1, 1, 2}, {0, 1, 2}, {0, 0, 3}, {1, 0, 3}, {1, 1, 3}, {0, 1, 3}, // hex 1
+      {0, 0, 4}, {1, 0, 4}, {1, 1, 4}, {0, 1, 4},                                              // hex 2
+  };
+  std::vector<std::array<int, 8>> cells = {
+      {0, 1, 2, 3, -1, -1, -1, -1},
+      {3, 2, 1, 4, -1, -1, -1, -1},
+      {5, 6, 7, 8, 9, 10, 11, 12},
+      {9, 10, 11, 12, 13, 14, 15, 16},
+  };
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+
+  ASSERT_EQ(psVol->nFaces(), 4 + 4 + 6 + 6);
+  size_t nInterior = 0;
+  for (char isInterior : psVol->faceIsInterior) nInterior += isInterior;
+  EXPECT_EQ(nInterior, 4);
+
+  // one of them between the tets
+  size_t nTetInterior = 0;
+  for (size_t iF = 0; iF < 8; iF++) nTetInterior += psVol->faceIsInterior[iF];
+  EXPECT_EQ(nTetInterior, 2);
+
+  // interior faces are only drawn while they might be visible
+  size_t nInteriorTris = 2 * 1 + 2 * 2;
+  polyscope::show(3);
+  EXPECT_EQ(psVol->nDrawnFacesTriangulation(), psVol->nFacesTriangulation() - nInteriorTris);
+
+  polyscope::SlicePlane* p = polyscope::addSceneSlicePlane();
+  polyscope::show(3);
+  EXPECT_EQ(psVol->nDrawnFacesTriangulation(), psVol->nFacesTriangulation());
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psVol->setIgnoreSlicePlane(p->name, true);
+  polyscope::show(3);
+  EXPECT_EQ(psVol->nDrawnFacesTriangulation(), psVol->nFacesTriangulation() - nInteriorTris);
+
+  psVol->setSkipHiddenInteriorFaces(false);
+  polyscope::show(3);
+  EXPECT_EQ(psVol->nDrawnFacesTriangulation(), psVol->nFacesTriangulation());
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeMeshTets) {
+  // two tets and two stacked unit hexes
+  std::vector<glm::vec3> verts = {
+      {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 1},                                    // tets
+      {0, 0, 2}, {1, 0, 2}, {1, 1, 2}, {0, 1, 2}, {0, 0, 3}, {1, 0, 3}, {1, 1, 3}, {0, 1, 3}, // hex 1
+      {0, 0, 4}, {1, 0, 4}, {1, 1, 4}, {0, 1, 4},                                              // hex 2
+  };
+  std::vector<std::array<int, 8>> cells = {
+      {0, 1, 2, 3, -1, -1, -1, -1},
+      {3, 2, 1, 4, -1, -1, -1, -1},
+      {5, 6, 7, 8, 9, 10, 11, 12},
+      {9, 10, 11, 12, 13, 14, 15, 16},
+  };
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+
+  // each hex becomes 5 or 6 tets, which exactly fill it
+  size_t nTets = psVol->nTets();
+  EXPECT_GE(nTets, 2u + 2 * 5);
+  EXPECT_LE(nTets, 2u + 2 * 6);
+  double totalVolume = 0.;
+  for (const std::array<uint32_t, 4>& tet : psVol->getTets()) {
+    glm::vec3 a = verts[tet[0]];
+    totalVolume += std::abs(glm::dot(verts[tet[1]] - a, glm::cross(verts[tet[2]] - a, verts[tet[3]] - a))) / 6.;
+  }
+  EXPECT_NEAR(totalVolume, 1. / 6. + 1. / 3. + 2., 1e-5);
+
+  // the tets are kept across refreshes, and do not depend on the number of threads
+  std::vector<std::array<uint32_t, 4>> tets = psVol->getTets();
+  psVol->refresh();
+  EXPECT_EQ(psVol->getTets(), tets);
+  int oldMaxWorkerThreads = polyscope::options::maxWorkerThreads;
+  polyscope::options::maxWorkerThreads = 1;
+  psVol->computeTets();
+  EXPECT_EQ(psVol->getTets(), tets);
+  polyscope::options::maxWorkerThreads = oldMaxWorkerThreads;
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeMeshCellStorage) {
+  // interleaved tets and hexes keep their order
+  std::vector<glm::vec3> verts;
+  std::vector<std::array<int, 8>> cells;
+  std::tie(verts, cells) = getVolumeMeshData();
+  std::vector<std::array<int, 8>> mixed = {cells[0], cells[1], cells[0]};
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, mixed);
+  ASSERT_EQ(psVol->nCells(), 3);
+  for (size_t iC = 0; iC < 3; iC++) {
+    bool isHex = mixed[iC][4] >= 0;
+    EXPECT_EQ(psVol->cellType(iC), isHex ? polyscope::VolumeCellType::HEX : polyscope::VolumeCellType::TET);
+    for (int j = 0; j < (isHex ? 8 : 4); j++) {
+      EXPECT_EQ(psVol->cellVertices(iC)[j], static_cast<uint32_t>(mixed[iC][j]));
+    }
+  }
+
+  // a pure-tet mesh stores each tet at 4-wide, and is its own tet decomposition
+  std::vector<std::array<int, 4>> tetCells = {{0, 1, 2, 3}, {1, 2, 3, 4}};
+  polyscope::VolumeMesh* psTet = polyscope::registerTetMesh("tet", verts, tetCells);
+  EXPECT_EQ(psTet->tetCells.size(), 2u);
+  EXPECT_TRUE(psTet->hexCells.empty());
+  EXPECT_TRUE(psTet->cellHexStart.empty());
+  EXPECT_EQ(&psTet->getTets(), &psTet->tetCells);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, VolumeMeshUpdatePositions) {
   std::vector<glm::vec3> verts;
   std::vector<std::array<int, 8>> cells;
@@ -129,6 +242,27 @@ TEST_F(PolyscopeTest, VolumeMeshPick) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, VolumeMeshSubsets) {
+  std::vector<glm::vec3> verts;
+  std::vector<std::array<int, 8>> cells;
+  std::tie(verts, cells) = getVolumeMeshData();
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+
+  psVol->setVisibleSubset({1});
+  psVol->setHighlightedSubset({1});
+  EXPECT_FALSE(psVol->isVisibleInSubset(0));
+  EXPECT_TRUE(psVol->isHighlightedInSubset(1));
+  polyscope::show(3);
+  polyscope::pick::evaluatePickQuery(77, 88);
+
+  psVol->clearVisibleSubset();
+  psVol->clearHighlightedSubset();
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  polyscope::removeLastSceneSlicePlane();
+}
+
 
 TEST_F(PolyscopeTest, VolumeMeshColorVertex) {
   std::vector<glm::vec3> verts;
@@ -182,6 +316,37 @@ TEST_F(PolyscopeTest, VolumeMeshScalarCell) {
   polyscope::removeAllStructures();
 }
 
+TEST_F(PolyscopeTest, VolumeMeshCellDataFetch) {
+  std::vector<glm::vec3> verts;
+  std::vector<std::array<int, 8>> cells;
+  std::tie(verts, cells) = getVolumeMeshData();
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+  EXPECT_TRUE(psVol->canFetchCellData());
+
+  // cell values are stored once per cell, not expanded to triangle corners
+  std::vector<float> vals(cells.size(), 0.44);
+  polyscope::VolumeMeshCellScalarQuantity* q1 = psVol->addCellScalarQuantity("vals", vals);
+  q1->setEnabled(true);
+  polyscope::show(3);
+  polyscope::render::GPUMemoryUsage usage = polyscope::render::getGPUMemoryUsage(q1->uniquePrefix());
+  EXPECT_EQ(usage.attributeBytes, 0u);
+  EXPECT_GT(usage.textureBytes, 0u);
+
+  std::vector<glm::vec3> cColors(cells.size(), glm::vec3{.2, .3, .4});
+  psVol->addCellColorQuantity("ccolor", cColors)->setEnabled(true);
+  polyscope::show(3);
+
+  // so are the cull positions, when culling whole cells
+  polyscope::addSceneSlicePlane();
+  psVol->setCullWholeElements(true);
+  polyscope::show(3);
+  psVol->setCullWholeElements(false);
+  polyscope::show(3);
+
+  polyscope::removeLastSceneSlicePlane();
+  polyscope::removeAllStructures();
+}
+
 TEST_F(PolyscopeTest, VolumeMeshVertexVector) {
   std::vector<glm::vec3> verts;
   std::vector<std::array<int, 8>> cells;
@@ -228,3 +393,181 @@ TEST_F(PolyscopeTest, VolumeMeshInspect) {
 
   polyscope::removeLastSceneSlicePlane();
 }
+
+TEST_F(PolyscopeTest, VolumeMeshInspectMany) {
+  std::vector<glm::vec3> verts;
+  std::vector<std::array<int, 8>> cells;
+  std::tie(verts, cells) = getVolumeMeshData();
+  polyscope::VolumeMesh* psVol1 = polyscope::registerVolumeMesh("vol1", verts, cells);
+  for (glm::vec3& v : verts) v.x += 2.;
+  polyscope::VolumeMesh* psVol2 = polyscope::registerVolumeMesh("vol2", verts, cells);
+  std::vector<float> vals(verts.size(), 0.44);
+  psVol2->addVertexScalarQuantity("vals", vals)->setEnabled(true);
+
+  // one plane over both meshes
+  polyscope::SlicePlane* p = polyscope::addSceneSlicePlane();
+  p->setVolumeMeshesToInspect({"vol1", "vol2"});
+  EXPECT_TRUE(p->isInspectingVolumeMesh("vol1"));
+  EXPECT_TRUE(p->isInspectingVolumeMesh("vol2"));
+  EXPECT_EQ(p->getVolumeMeshToInspect(), "vol1");
+  p->setPose(glm::vec3{0., 0., 0.5}, glm::vec3{0., 0., 1.});
+  polyscope::show(3);
+  p->setPose(glm::vec3{2.5, 0., 0.}, glm::vec3{1., 0., 0.}); // only cuts the second mesh
+  polyscope::show(3);
+
+  p->removeVolumeMeshToInspect("vol1");
+  EXPECT_EQ(p->getVolumeMeshesToInspect(), std::vector<std::string>{"vol2"});
+  polyscope::show(3);
+
+  // or all of the meshes in a group
+  polyscope::registerGroup("blocks");
+  polyscope::setParentGroupOfStructure(psVol1, "blocks");
+  polyscope::setParentGroupOfStructure(psVol2, "blocks");
+  p->setGroupToInspect("blocks");
+  EXPECT_EQ(p->getVolumeMeshesToInspect().size(), 2u);
+  polyscope::show(3);
+
+  // removed meshes are dropped
+  polyscope::removeVolumeMesh("vol1");
+  EXPECT_EQ(p->getVolumeMeshesToInspect(), std::vector<std::string>{"vol2"});
+  polyscope::show(3);
+
+  p->setVolumeMeshToInspect("");
+  EXPECT_TRUE(p->getVolumeMeshesToInspect().empty());
+
+  polyscope::removeAllStructures();
+  polyscope::removeAllGroups();
+  polyscope::removeLastSceneSlicePlane();
+}
+
+TEST_F(PolyscopeTest, VolumeMeshSlicedTetRanges) {
+  // two stacked unit hexes, and a tet off to the side
+  std::vector<glm::vec3> verts = {
+      {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1},
+      {0, 0, 2}, {1, 0, 2}, {1, 1, 2}, {0, 1, 2}, {5, 5, 5}, {6, 5, 5}, {5, 6, 5}, {5, 5, 6},
+  };
+  std::vector<std::array<int, 8>> cells = {
+      {0, 1, 2, 3, 4, 5, 6, 7},
+      {4, 5, 6, 7, 8, 9, 10, 11},
+      {12, 13, 14, 15, -1, -1, -1, -1},
+  };
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+  const std::vector<std::array<uint32_t, 4>>& tets = psVol->getTets();
+  const std::vector<uint32_t>& order = psVol->getSliceTetOrder();
+  ASSERT_EQ(order.size(), tets.size());
+
+  // a plane through the lower hex cuts exactly its tets
+  std::vector<std::array<size_t, 2>> ranges = psVol->computeSlicedTetRanges(glm::vec3{0., 0., 1.}, 0.5);
+  std::vector<bool> isCut(tets.size(), false);
+  for (const std::array<size_t, 2>& r : ranges) {
+    for (size_t i = r[0]; i < r[0] + r[1]; i++) isCut[order[i]] = true;
+  }
+  for (size_t iT = 0; iT < tets.size(); iT++) {
+    bool inLowerHex = true;
+    for (uint32_t v : tets[iT]) inLowerHex = inLowerHex && v < 8;
+    EXPECT_EQ(isCut[iT], inLowerHex);
+  }
+
+  // a plane missing everything cuts nothing
+  EXPECT_TRUE(psVol->computeSlicedTetRanges(glm::vec3{0., 0., 1.}, 10.).empty());
+
+  // inspect while moving a plane around
+  polyscope::SlicePlane* p = polyscope::addSceneSlicePlane();
+  p->setVolumeMeshToInspect("vol");
+  std::vector<float> vals(verts.size(), 0.44);
+  psVol->addVertexScalarQuantity("vals", vals)->setEnabled(true);
+  p->setPose(glm::vec3{0., 0., 0.5}, glm::vec3{0., 0., 1.});
+  polyscope::show(3);
+  p->setPose(glm::vec3{0., 0., 1.5}, glm::vec3{0., 0., 1.});
+  polyscope::show(3);
+  p->setPose(glm::vec3{0., 0., 10.}, glm::vec3{0., 0., 1.});
+  polyscope::show(3);
+  psVol->updateVertexPositions(verts);
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+  polyscope::removeLastSceneSlicePlane();
+}
+
+TEST_F(PolyscopeTest, VolumeMeshSliceIndex) {
+  // a grid of hexes, large enough for the index to have several levels
+  const int n = 24;
+  std::vector<glm::vec3> verts;
+  for (int i = 0; i <= n; i++)
+    for (int j = 0; j <= n; j++)
+      for (int k = 0; k <= n; k++) verts.push_back(glm::vec3{i, j, k} / static_cast<float>(n));
+  auto vInd = [&](int i, int j, int k) { return (i * (n + 1) + j) * (n + 1) + k; };
+  std::vector<std::array<int, 8>> cells;
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      for (int k = 0; k < n; k++) {
+        cells.push_back({vInd(i, j, k), vInd(i + 1, j, k), vInd(i + 1, j + 1, k), vInd(i, j + 1, k),
+                         vInd(i, j, k + 1), vInd(i + 1, j, k + 1), vInd(i + 1, j + 1, k + 1), vInd(i, j + 1, k + 1)});
+      }
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+  const std::vector<std::array<uint32_t, 4>>& tets = psVol->getTets();
+  const std::vector<uint32_t>& order = psVol->getSliceTetOrder();
+
+  // the order is a permutation
+  std::vector<uint32_t> sortedOrder = order;
+  std::sort(sortedOrder.begin(), sortedOrder.end());
+  for (size_t i = 0; i < sortedOrder.size(); i++) ASSERT_EQ(sortedOrder[i], i);
+
+  // the index finds exactly the tets a brute force search does, including after the vertices move
+  auto checkPlane = [&](glm::vec3 normal, float point) {
+    normal = glm::normalize(normal);
+    std::vector<bool> isCut(tets.size(), false);
+    for (const std::array<size_t, 2>& r : psVol->computeSlicedTetRanges(normal, point)) {
+      for (size_t i = r[0]; i < r[0] + r[1]; i++) isCut[order[i]] = true;
+    }
+    for (size_t iT = 0; iT < tets.size(); iT++) {
+      float dMin = std::numeric_limits<float>::infinity();
+      float dMax = -std::numeric_limits<float>::infinity();
+      for (uint32_t v : tets[iT]) {
+        float d = glm::dot(normal, psVol->vertexPositions.data[v]) - point;
+        dMin = std::min(dMin, d);
+        dMax = std::max(dMax, d);
+      }
+      if (dMin < -1e-4 && dMax > 1e-4) EXPECT_TRUE(isCut[iT]);
+      if (dMin > 1e-4 || dMax < -1e-4) EXPECT_FALSE(isCut[iT]);
+    }
+  };
+  checkPlane(glm::vec3{1., 0., 0.}, 0.51);
+  checkPlane(glm::vec3{1., 2., 3.}, 1.3);
+  checkPlane(glm::vec3{-1., 1., 0.}, 0.);
+  for (glm::vec3& v : verts) v.y += 0.5f * v.x;
+  psVol->updateVertexPositions(verts);
+  checkPlane(glm::vec3{0., 1., 0.}, 0.75);
+
+  polyscope::removeAllStructures();
+}
+
+TEST_F(PolyscopeTest, VolumeMeshLevelSetCached) {
+  std::vector<glm::vec3> verts;
+  std::vector<std::array<int, 8>> cells;
+  std::tie(verts, cells) = getVolumeMeshData();
+  polyscope::VolumeMesh* psVol = polyscope::registerVolumeMesh("vol", verts, cells);
+
+  std::vector<float> vals;
+  for (glm::vec3 v : verts) vals.push_back(v.z);
+  auto q1 = psVol->addVertexScalarQuantity("vals", vals);
+  q1->setEnabledLevelSet(true);
+  q1->setLevelSetValue(0.5);
+  polyscope::show(3);
+
+  q1->setLevelSetCaching(true);
+  polyscope::show(3);
+  q1->setLevelSetValue(0.7);
+  polyscope::show(3);
+
+  // the exported level set is a welded mesh lying on the level
+  polyscope::SurfaceMesh* psLevelSet = q1->registerLevelSetAsSurfaceMesh("level set");
+  EXPECT_GT(psLevelSet->nFaces(), 0u);
+  EXPECT_LT(psLevelSet->nVertices(), 3 * psLevelSet->nFaces());
+  for (glm::vec3 p : psLevelSet->vertexPositions.data) {
+    EXPECT_NEAR(p.z, 0.7, 1e-5);
+  }
+  polyscope::show(3);
+
+  polyscope::removeAllStructures();
+}